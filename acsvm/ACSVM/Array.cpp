@@ -122,9 +122,11 @@ namespace ACSVM
 namespace ACSVM
 {
    //
-   // Array::operator [Word]
+   // Array::alloc
    //
-   Word &Array::operator [] (Word idx)
+   // Slow path of operator [], allocating as needed.
+   //
+   Word &Array::alloc(Word idx)
    {
       if(!data) data = new Data[1]{};
       Bank *&bank = (*data)[idx / (BankSize * SegmSize * PageSize)];
@@ -136,13 +138,16 @@ namespace ACSVM
       Page *&page = (*segm)[idx / PageSize % SegmSize];
 
       if(!page) page = new Page[1]{};
+      if(idx < LowSize) low = segm;
       return (*page)[idx % PageSize];
    }
 
    //
-   // Array::find
+   // Array::findHigh
+   //
+   // Slow path of find, for indexes outside the first segment.
    //
-   Word Array::find(Word idx) const
+   Word Array::findHigh(Word idx) const
    {
       if(!data) return 0;
       Bank *&bank = (*data)[idx / (BankSize * SegmSize * PageSize)];
@@ -157,12 +162,24 @@ namespace ACSVM
       return (*page)[idx % PageSize];
    }
 
+   //
+   // Array::findLow
+   //
+   // Finds the first segment again after the tree has been rebuilt.
+   //
+   void Array::findLow()
+   {
+      Bank *bank = data ? (*data)[0] : nullptr;
+      low = bank ? (*bank)[0] : nullptr;
+   }
+
    //
    // Array::clear
    //
    void Array::clear()
    {
       FreeData(data);
+      low = nullptr;
    }
 
    //
@@ -172,6 +189,7 @@ namespace ACSVM
    {
       in.readSign(Signature::Array);
       ReadData(in, data);
+      findLow();
       in.readSign(~Signature::Array);
    }
 
@@ -191,6 +209,41 @@ namespace ACSVM
       RefStringsData(env, data, [](String *s){s->ref = true;});
    }
 
+   //
+   // Array::refStrings
+   //
+   bool Array::refStrings(Environment *env, std::size_t &page, std::size_t &work) const
+   {
+      constexpr std::size_t BankPages = BankSize * SegmSize;
+      constexpr std::size_t DataPages = DataSize * BankPages;
+
+      if(!data) return true;
+
+      while(page != DataPages)
+      {
+         if(!work) return false;
+         --work;
+
+         Bank *bank = (*data)[page / BankPages];
+         if(!bank) {page = (page / BankPages + 1) * BankPages; continue;}
+
+         Segm *segm = (*bank)[page / SegmSize % BankSize];
+         if(!segm) {page = (page / SegmSize + 1) * SegmSize; continue;}
+
+         if(Page *p = (*segm)[page % SegmSize])
+         {
+            for(auto &itr : *p)
+               env->getString(itr)->ref = true;
+
+            if(work > PageSize) work -= PageSize; else work = 0;
+         }
+
+         ++page;
+      }
+
+      return true;
+   }
+
    //
    // Array::saveState
    //
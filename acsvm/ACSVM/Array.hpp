@@ -27,20 +27,40 @@ namespace ACSVM
    //
    // Sparse-allocation array of 2**32 Words.
    //
+   // The first segment, holding indexes below 2**16, is a flat table of
+   // pages and is kept at hand, so those indexes take one lookup inline.
+   //
    class Array
    {
    public:
-      Array() : data{nullptr} {}
+      Array() : data{nullptr}, low{nullptr} {}
       Array(Array const &) = delete;
-      Array(Array &&array) : data{array.data} {array.data = nullptr;}
+      Array(Array &&array) : data{array.data}, low{array.low}
+         {array.data = nullptr; array.low = nullptr;}
       ~Array() {clear();}
 
-      Word &operator [] (Word idx);
+      Word &operator [] (Word idx)
+      {
+         if(idx < LowSize && low)
+            if(Page *page = (*low)[idx / PageSize]) return (*page)[idx % PageSize];
+
+         return alloc(idx);
+      }
 
       void clear();
 
       // If idx is allocated, returns that Word. Otherwise, returns 0.
-      Word find(Word idx) const;
+      Word find(Word idx) const
+      {
+         if(idx < LowSize)
+         {
+            if(!low) return 0;
+            Page *page = (*low)[idx / PageSize];
+            return page ? (*page)[idx % PageSize] : 0;
+         }
+
+         return findHigh(idx);
+      }
 
       void loadState(Serial &in);
 
@@ -48,6 +68,11 @@ namespace ACSVM
 
       void refStrings(Environment *env) const;
 
+      // Marks strings a page at a time, starting from page and spending up to
+      // work, one per Word. Returns true once the rest of the array is done.
+      // Otherwise, page is where to resume.
+      bool refStrings(Environment *env, std::size_t &page, std::size_t &work) const;
+
       void saveState(Serial &out) const;
 
       void unlockStrings(Environment *env) const;
@@ -63,7 +88,14 @@ namespace ACSVM
       using Bank = Segm*[BankSize];
       using Data = Bank*[DataSize];
 
+      static constexpr std::size_t LowSize = SegmSize * PageSize;
+
+      Word &alloc(Word idx);
+      Word findHigh(Word idx) const;
+      void findLow();
+
       Data *data;
+      Segm *low; // first segment of the first bank, if allocated
    };
 }
 
@@ -126,6 +126,27 @@ ACSVM_CodeList(InvU,         0)
 ACSVM_CodeList(NegI,         0)
 ACSVM_CodeList(NotU,         0)
 
+// Fused codes. Only generated by Module::fuseCodes, each in place of the first
+// code of the sequence it stands for, with that sequence's words as its
+// arguments.
+#define ACSVM_CodeList_FusedCmpSet(name) \
+   ACSVM_CodeList(Fuse_##name##_Jcnd_Nil,        2) \
+   ACSVM_CodeList(Fuse_LocLit_##name##_Jcnd_Nil, 6)
+ACSVM_CodeList_FusedCmpSet(CmpI_GE)
+ACSVM_CodeList_FusedCmpSet(CmpI_GT)
+ACSVM_CodeList_FusedCmpSet(CmpI_LE)
+ACSVM_CodeList_FusedCmpSet(CmpI_LT)
+ACSVM_CodeList_FusedCmpSet(CmpU_EQ)
+ACSVM_CodeList_FusedCmpSet(CmpU_NE)
+#undef ACSVM_CodeList_FusedCmpSet
+ACSVM_CodeList(Fuse_AddU_LitLoc,    3)
+ACSVM_CodeList(Fuse_Drop_LitLoc,    3)
+ACSVM_CodeList(Fuse_IncU_LocJump,   3)
+ACSVM_CodeList(Fuse_Push_LocLit,    3)
+ACSVM_CodeList(Fuse_Push_LocLoc,    3)
+ACSVM_CodeList(Fuse_Push_LocModArr, 3)
+ACSVM_CodeList(Fuse_SubU_LitLoc,    3)
+
 #undef ACSVM_CodeList
 #endif
 
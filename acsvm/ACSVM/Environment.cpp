@@ -96,6 +96,16 @@ namespace ACSVM
             {func, {FuncACS0::name, Func::transFunc, __VA_ARGS__}},
          #include "CodeList.hpp"
       };
+
+      // Incremental string collection. Scope arrays are marked a few pages
+      // at a time, with stores to them marking the stored string; everything
+      // else is marked at once after the last array.
+      enum class Collect {Idle, Clear, Mark, Sweep};
+
+      Collect                    collect = Collect::Idle;
+      std::vector<Array const *> collectArrV;
+      std::size_t                collectArr  = 0;
+      std::size_t                collectPage = 0;
    };
 }
 
@@ -234,11 +244,74 @@ namespace ACSVM
    //
    void Environment::collectStrings()
    {
+      collectStringsAbort();
+
       stringTable.collectBegin();
       refStrings();
       stringTable.collectEnd();
    }
 
+   //
+   // Environment::collectStringsAbort
+   //
+   void Environment::collectStringsAbort()
+   {
+      if(pd->collect == PrivData::Collect::Idle) return;
+
+      pd->collect = PrivData::Collect::Idle;
+      pd->collectArrV.clear();
+      stringTable.collectAbort();
+   }
+
+   //
+   // Environment::collectStringsStep
+   //
+   bool Environment::collectStringsStep(std::size_t work)
+   {
+      using Collect = PrivData::Collect;
+
+      if(pd->collect == Collect::Idle)
+      {
+         pd->collect = Collect::Clear;
+         stringTable.collectAbort();
+      }
+
+      if(pd->collect == Collect::Clear)
+      {
+         if(!stringTable.collectClear(work)) return false;
+
+         for(auto &scope : pd->scopes)
+            scope.listArrays(pd->collectArrV);
+
+         pd->collect     = Collect::Mark;
+         pd->collectArr  = 0;
+         pd->collectPage = 0;
+         stringTable.collectMark();
+      }
+
+      if(pd->collect == Collect::Mark)
+      {
+         auto &arrV = pd->collectArrV;
+         for(; pd->collectArr != arrV.size(); ++pd->collectArr, pd->collectPage = 0)
+         {
+            if(!arrV[pd->collectArr]->refStrings(this, pd->collectPage, work))
+               return false;
+         }
+
+         // Threads and registers are not covered by the store barrier, so
+         // they are only marked now that the arrays are done.
+         refStringsRoots();
+
+         pd->collect = Collect::Sweep;
+         pd->collectArrV.clear();
+      }
+
+      if(!stringTable.collectSweep(work)) return false;
+
+      pd->collect = Collect::Idle;
+      return true;
+   }
+
    //
    // Environment::countActiveThread
    //
@@ -492,6 +565,14 @@ namespace ACSVM
       return false;
    }
 
+   //
+   // Environment::isCollectingStrings
+   //
+   bool Environment::isCollectingStrings() const
+   {
+      return pd->collect != PrivData::Collect::Idle;
+   }
+
    //
    // Environment::loadFunctions
    //
@@ -553,6 +634,8 @@ namespace ACSVM
    //
    void Environment::loadState(Serial &in)
    {
+      collectStringsAbort();
+
       in.readSign(Signature::Environment);
 
       loadStringTable(in);
@@ -687,6 +770,27 @@ namespace ACSVM
          scope.refStrings();
    }
 
+   //
+   // Environment::refStringsRoots
+   //
+   void Environment::refStringsRoots()
+   {
+      for(auto &action : scriptAction)
+         action.refStrings(this);
+
+      for(auto &funcIdx : pd->functionByName)
+      {
+         funcIdx.key.first.s->ref = true;
+         funcIdx.key.second->ref  = true;
+      }
+
+      for(auto &module : pd->modules)
+         module.refStrings();
+
+      for(auto &scope : pd->scopes)
+         scope.refStringsRoots();
+   }
+
    //
    // Environment::resetStrings
    //
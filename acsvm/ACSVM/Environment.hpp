@@ -52,6 +52,14 @@ namespace ACSVM
 
       void collectStrings();
 
+      // Cancels an incremental collection. Called when a scope is created or
+      // destroyed, since its arrays may be listed to be marked.
+      void collectStringsAbort();
+
+      // Does up to work units of an incremental collection, one per string or
+      // Word looked at. Returns true if this finished a collection.
+      bool collectStringsStep(std::size_t work);
+
       std::size_t countActiveThread() const;
 
       void deferAction(ScriptAction &&action);
@@ -114,6 +122,9 @@ namespace ACSVM
       // Returns true if any contained scope is active and has an active thread.
       bool hasActiveThread() const;
 
+      // Returns true if an incremental collection is under way.
+      bool isCollectingStrings() const;
+
       virtual void loadState(Serial &in);
 
       // Prints an array to a print buffer. Default behavior is PrintArrayChar.
@@ -134,6 +145,9 @@ namespace ACSVM
 
       virtual void refStrings();
 
+      // Marks strings like refStrings, except those in scope arrays.
+      virtual void refStringsRoots();
+
       virtual void resetStrings();
 
       virtual void saveState(Serial &out) const;
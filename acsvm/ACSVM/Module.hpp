@@ -155,6 +155,8 @@ namespace ACSVM
 
       void readCodeACS0(Byte const *data, std::size_t size, bool compressed);
 
+      void fuseCodes();
+
       String *readStringACS0(Byte const *data, std::size_t size, std::size_t iter);
 
       void setScriptNameTypeACSE(Script *scr, Word nameInt, Word type);
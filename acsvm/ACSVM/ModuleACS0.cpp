@@ -13,6 +13,8 @@
 #include "Module.hpp"
 
 #include "BinaryIO.hpp"
+#include "Code.hpp"
+#include "CodeData.hpp"
 #include "Environment.hpp"
 #include "Error.hpp"
 #include "Jump.hpp"
@@ -20,6 +22,88 @@
 #include "Tracer.hpp"
 
 
+//----------------------------------------------------------------------------|
+// Macros                                                                     |
+//
+
+//
+// ACSVM_FuseCodes
+//
+// If nonzero, common sequences of codes are replaced by fused codes after
+// translation. Disabling allows comparing against unfused execution.
+//
+#ifndef ACSVM_FuseCodes
+#define ACSVM_FuseCodes 1
+#endif
+
+
+//----------------------------------------------------------------------------|
+// Static Functions                                                           |
+//
+
+namespace ACSVM
+{
+   //
+   // CodeSize
+   //
+   // Returns the number of words taken by the code at itr, or 0 if it does
+   // not fit before end.
+   //
+   static std::size_t CodeSize(Environment *env, Word const *itr, Word const *end)
+   {
+      std::size_t size;
+
+      if(*itr >= static_cast<Word>(Code::None))
+         return 0;
+
+      switch(static_cast<Code>(*itr))
+      {
+      case Code::CallFunc_Lit:
+      case Code::CallSpec_Lit:
+         size = end - itr < 2 ? 0 : 3 + itr[1];
+         break;
+
+      case Code::Push_LitArr:
+         size = end - itr < 2 ? 0 : 2 + itr[1];
+         break;
+
+      default:
+         size = 1 + env->getCodeData(static_cast<Code>(*itr))->argc;
+         break;
+      }
+
+      return size <= static_cast<std::size_t>(end - itr) ? size : 0;
+   }
+
+   //
+   // IsCode
+   //
+   static inline bool IsCode(Word word, Code code)
+   {
+      return word == static_cast<Word>(code);
+   }
+
+   //
+   // FuseCmp
+   //
+   // Returns the fused code for a compare followed by Jcnd_Nil.
+   //
+   static Code FuseCmp(Word code, bool locLit)
+   {
+      switch(static_cast<Code>(code))
+      {
+      case Code::CmpI_GE: return locLit ? Code::Fuse_LocLit_CmpI_GE_Jcnd_Nil : Code::Fuse_CmpI_GE_Jcnd_Nil;
+      case Code::CmpI_GT: return locLit ? Code::Fuse_LocLit_CmpI_GT_Jcnd_Nil : Code::Fuse_CmpI_GT_Jcnd_Nil;
+      case Code::CmpI_LE: return locLit ? Code::Fuse_LocLit_CmpI_LE_Jcnd_Nil : Code::Fuse_CmpI_LE_Jcnd_Nil;
+      case Code::CmpI_LT: return locLit ? Code::Fuse_LocLit_CmpI_LT_Jcnd_Nil : Code::Fuse_CmpI_LT_Jcnd_Nil;
+      case Code::CmpU_EQ: return locLit ? Code::Fuse_LocLit_CmpU_EQ_Jcnd_Nil : Code::Fuse_CmpU_EQ_Jcnd_Nil;
+      case Code::CmpU_NE: return locLit ? Code::Fuse_LocLit_CmpU_NE_Jcnd_Nil : Code::Fuse_CmpU_NE_Jcnd_Nil;
+      default:            return Code::None;
+      }
+   }
+}
+
+
 //----------------------------------------------------------------------------|
 // Extern Functions                                                           |
 //
@@ -138,6 +222,73 @@ namespace ACSVM
       jumpMapV.alloc(tracer.jumpMapC);
 
       tracer.translate(this);
+
+      fuseCodes();
+   }
+
+   //
+   // Module::fuseCodes
+   //
+   // Only the opcode word of a sequence's first code is replaced, so jumps
+   // into the middle of a sequence still find its original codes, and code
+   // indexes (including those in saved threads) are unaffected.
+   //
+   void Module::fuseCodes()
+   {
+      #if ACSVM_FuseCodes
+      Word *const begin = codeV.data();
+      Word *const end   = begin + codeV.size();
+      std::size_t size;
+
+      // Make sure the code can be walked to its end first.
+      for(Word *itr = begin; itr != end; itr += size)
+      {
+         if(!(size = CodeSize(env, itr, end)))
+            return;
+      }
+
+      for(Word *itr = begin; itr != end; itr += size)
+      {
+         std::size_t left = end - itr;
+         Code        fuse = Code::None;
+
+         size = CodeSize(env, itr, end);
+
+         if(IsCode(itr[0], Code::Push_LocReg) && left >= 4)
+         {
+            if(IsCode(itr[2], Code::Push_Lit))
+            {
+               if(left >= 7 && IsCode(itr[5], Code::Jcnd_Nil))
+                  fuse = FuseCmp(itr[4], true);
+               if(fuse == Code::None)
+                  fuse = Code::Fuse_Push_LocLit;
+            }
+            else if(IsCode(itr[2], Code::Push_LocReg))
+               fuse = Code::Fuse_Push_LocLoc;
+            else if(IsCode(itr[2], Code::Push_ModArr))
+               fuse = Code::Fuse_Push_LocModArr;
+         }
+         else if(IsCode(itr[0], Code::Push_Lit) && left >= 4)
+         {
+            if(IsCode(itr[2], Code::Drop_LocReg))
+               fuse = Code::Fuse_Drop_LitLoc;
+            else if(IsCode(itr[2], Code::AddU_LocReg))
+               fuse = Code::Fuse_AddU_LitLoc;
+            else if(IsCode(itr[2], Code::SubU_LocReg))
+               fuse = Code::Fuse_SubU_LitLoc;
+         }
+         else if(IsCode(itr[0], Code::IncU_LocReg) && left >= 4)
+         {
+            if(IsCode(itr[2], Code::Jump_Lit))
+               fuse = Code::Fuse_IncU_LocJump;
+         }
+         else if(left >= 3 && IsCode(itr[1], Code::Jcnd_Nil))
+            fuse = FuseCmp(itr[0], false);
+
+         if(fuse != Code::None)
+            itr[0] = static_cast<Word>(fuse);
+      }
+      #endif
    }
 
    //
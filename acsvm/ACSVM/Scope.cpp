@@ -61,6 +61,44 @@ namespace ACSVM
       HashMapFixed<String *, Script *> scriptStr;
 
       HashMapFixed<Script *, Thread *> scriptThread;
+
+      //
+      // forParked
+      //
+      template<typename Fn>
+      void forParked(Fn const &fn)
+      {
+         forParkedList([&](ListLink<Thread> &list)
+            {for(auto &thread : list) fn(thread);});
+      }
+
+      //
+      // forParkedList
+      //
+      template<typename Fn>
+      void forParkedList(Fn const &fn)
+      {
+         for(auto &level : wheel) for(auto &slot : level)
+            fn(slot);
+
+         fn(wheelFar);
+      }
+
+      static constexpr std::size_t WheelBits   = 8;
+      static constexpr std::size_t WheelLevels = 4;
+      static constexpr std::size_t WheelSlots  = 1 << WheelBits;
+
+      // Hierarchical timer wheel of delayed threads. Each slot on level N
+      // spans WheelSlots^N passes, so a thread is only touched when it wakes
+      // or when its slot on a higher level is redistributed downward.
+      ListLink<Thread> wheel[WheelLevels][WheelSlots];
+      ListLink<Thread> wheelFar; // Beyond the current 2^32 pass block.
+
+      std::vector<Thread *> wake;
+
+      std::size_t parked = 0;
+      std::size_t seq    = 0; // Last assigned Thread::execSeq.
+      DWord       tic    = 0; // Number of exec passes.
    };
 }
 
@@ -98,6 +136,7 @@ namespace ACSVM
 
       pd{new PrivData}
    {
+      env->collectStringsAbort();
    }
 
    //
@@ -105,6 +144,7 @@ namespace ACSVM
    //
    GlobalScope::~GlobalScope()
    {
+      env->collectStringsAbort();
       reset();
       delete pd;
    }
@@ -183,6 +223,17 @@ namespace ACSVM
       return false;
    }
 
+   //
+   // GlobalScope::listArrays
+   //
+   void GlobalScope::listArrays(std::vector<Array const *> &out) const
+   {
+      for(auto &arr : arrV) out.push_back(&arr);
+
+      for(auto &scope : pd->scopes)
+         scope.listArrays(out);
+   }
+
    //
    // GlobalScope::loadState
    //
@@ -238,6 +289,20 @@ namespace ACSVM
          scope.refStrings();
    }
 
+   //
+   // GlobalScope::refStringsRoots
+   //
+   void GlobalScope::refStringsRoots() const
+   {
+      for(auto &reg : regV) env->getString(reg)->ref = true;
+
+      for(auto &action : scriptAction)
+         action.refStrings(env);
+
+      for(auto &scope : pd->scopes)
+         scope.refStringsRoots();
+   }
+
    //
    // GlobalScope::reset
    //
@@ -308,6 +373,7 @@ namespace ACSVM
 
       pd{new PrivData}
    {
+      env->collectStringsAbort();
    }
 
    //
@@ -315,6 +381,7 @@ namespace ACSVM
    //
    HubScope::~HubScope()
    {
+      env->collectStringsAbort();
       reset();
       delete pd;
    }
@@ -393,6 +460,17 @@ namespace ACSVM
       return false;
    }
 
+   //
+   // HubScope::listArrays
+   //
+   void HubScope::listArrays(std::vector<Array const *> &out) const
+   {
+      for(auto &arr : arrV) out.push_back(&arr);
+
+      for(auto &scope : pd->scopes)
+         scope.listArrays(out);
+   }
+
    //
    // HubScope::loadState
    //
@@ -448,6 +526,20 @@ namespace ACSVM
          scope.refStrings();
    }
 
+   //
+   // HubScope::refStringsRoots
+   //
+   void HubScope::refStringsRoots() const
+   {
+      for(auto &reg : regV) env->getString(reg)->ref = true;
+
+      for(auto &action : scriptAction)
+         action.refStrings(env);
+
+      for(auto &scope : pd->scopes)
+         scope.refStringsRoots();
+   }
+
    //
    // HubScope::reset
    //
@@ -621,7 +713,7 @@ namespace ACSVM
    //
    std::size_t MapScope::countActiveThread() const
    {
-      return threadActive.size();
+      return threadActive.size() + pd->parked;
    }
 
    //
@@ -657,12 +749,23 @@ namespace ACSVM
          delete action;
       }
 
+      wakeThreads();
+
       // Execute running threads.
       for(auto itr = threadActive.begin(), end = threadActive.end(); itr != end;)
       {
          itr->exec();
          if(itr->state == ThreadState::Inactive)
             freeThread(&*itr++);
+         else if(itr->delay > 1)
+         {
+            // The thread would only count down until it resumes on pass
+            // tic + delay, so park it until then.
+            Thread *thread = &*itr++;
+            thread->wakeTic = pd->tic + thread->delay;
+            parkThread(thread);
+            ++pd->parked;
+         }
          else
             ++itr;
       }
@@ -743,7 +846,11 @@ namespace ACSVM
             return true;
       }
 
-      return false;
+      bool parked = false;
+      pd->forParked([&](Thread &thread)
+         {parked = parked || thread.state != ThreadState::Inactive;});
+
+      return parked;
    }
 
    //
@@ -763,6 +870,15 @@ namespace ACSVM
       return itr && *itr && (*itr)->state != ThreadState::Inactive;
    }
 
+   //
+   // MapScope::linkThread
+   //
+   void MapScope::linkThread(Thread *thread)
+   {
+      thread->link.insert(&threadActive);
+      thread->execSeq = ++pd->seq;
+   }
+
    //
    // MapScope::loadModules
    //
@@ -781,6 +897,15 @@ namespace ACSVM
          pd->scopes.find(module)->loadState(in);
    }
 
+   //
+   // MapScope::listArrays
+   //
+   void MapScope::listArrays(std::vector<Array const *> &out) const
+   {
+      for(auto &scope : pd->scopes)
+         scope.val.listArrays(out);
+   }
+
    //
    // MapScope::loadState
    //
@@ -806,7 +931,7 @@ namespace ACSVM
       for(auto n = ReadVLN<std::size_t>(in); n--;)
       {
          Thread *thread = env->getFreeThread();
-         thread->link.insert(&threadActive);
+         linkThread(thread);
          thread->loadState(in);
 
          if(in.in->get())
@@ -831,6 +956,33 @@ namespace ACSVM
 
       for(auto &thread : threadActive)
          thread.lockStrings();
+
+      pd->forParked([](Thread &thread) {thread.lockStrings();});
+   }
+
+   //
+   // MapScope::parkThread
+   //
+   // Files a thread under the lowest wheel level that its wakeTic shares all
+   // higher digits with the current pass on.
+   //
+   void MapScope::parkThread(Thread *thread)
+   {
+      DWord wake = thread->wakeTic;
+
+      for(std::size_t lvl = 0; lvl != PrivData::WheelLevels; ++lvl)
+      {
+         std::size_t shift = PrivData::WheelBits * (lvl + 1);
+         if((wake >> shift) == (pd->tic >> shift))
+         {
+            std::size_t slot = (wake >> (shift - PrivData::WheelBits)) &
+               (PrivData::WheelSlots - 1);
+            thread->link.relink(&pd->wheel[lvl][slot]);
+            return;
+         }
+      }
+
+      thread->link.relink(&pd->wheelFar);
    }
 
    //
@@ -846,6 +998,25 @@ namespace ACSVM
 
       for(auto &thread : threadActive)
          thread.refStrings();
+
+      pd->forParked([](Thread &thread) {thread.refStrings();});
+   }
+
+   //
+   // MapScope::refStringsRoots
+   //
+   void MapScope::refStringsRoots() const
+   {
+      for(auto &action : scriptAction)
+         action.refStrings(env);
+
+      for(auto &scope : pd->scopes)
+         scope.val.refStringsRoots();
+
+      for(auto &thread : threadActive)
+         thread.refStrings();
+
+      pd->forParked([](Thread &thread) {thread.refStrings();});
    }
 
    //
@@ -860,6 +1031,20 @@ namespace ACSVM
          env->freeThread(threadActive.next->obj);
       }
 
+      pd->forParkedList([&](ListLink<Thread> &list)
+      {
+         while(list.next->obj)
+         {
+            list.next->obj->stop();
+            env->freeThread(list.next->obj);
+         }
+      });
+
+      pd->parked = 0;
+
+      pd->seq = 0;
+      pd->tic = 0;
+
       while(scriptAction.next->obj)
          delete scriptAction.next->obj;
 
@@ -906,13 +1091,31 @@ namespace ACSVM
    //
    void MapScope::saveThreads(Serial &out) const
    {
-      WriteVLN(out, threadActive.size());
+      // Write parked threads back in start order with the delay they would
+      // have counted down to by now, so the saved state does not depend on
+      // the timer wheel.
+      std::vector<Thread const *> threads;
+      threads.reserve(countActiveThread());
+
       for(auto &thread : threadActive)
+         threads.push_back(&thread);
+
+      pd->forParked([&](Thread &thread)
       {
-         thread.saveState(out);
+         thread.delay = static_cast<Word>(thread.wakeTic - pd->tic);
+         threads.push_back(&thread);
+      });
 
-         auto scrThread = pd->scriptThread.find(thread.script);
-         out.out->put(scrThread && *scrThread == &thread ? '\1' : '\0');
+      std::sort(threads.begin(), threads.end(),
+         [](Thread const *l, Thread const *r) {return l->execSeq < r->execSeq;});
+
+      WriteVLN(out, threads.size());
+      for(auto thread : threads)
+      {
+         thread->saveState(out);
+
+         auto scrThread = pd->scriptThread.find(thread->script);
+         out.out->put(scrThread && *scrThread == thread ? '\1' : '\0');
       }
    }
 
@@ -1146,6 +1349,64 @@ namespace ACSVM
 
       for(auto &thread : threadActive)
          thread.unlockStrings();
+
+      pd->forParked([](Thread &thread) {thread.unlockStrings();});
+   }
+
+   //
+   // MapScope::wakeThreads
+   //
+   // Advances the pass counter and merges threads due on it back into
+   // threadActive, keeping it in start order.
+   //
+   void MapScope::wakeThreads()
+   {
+      DWord tic = ++pd->tic;
+
+      if(!pd->parked)
+         return;
+
+      // Redistribute higher level slots that the pass has just entered.
+      auto cascade = [&](ListLink<Thread> &list)
+      {
+         while(list.next->obj)
+            parkThread(list.next->obj);
+      };
+
+      if(!(tic & 0xFFFFFFFF))
+         cascade(pd->wheelFar);
+
+      for(std::size_t lvl = PrivData::WheelLevels; --lvl;)
+      {
+         std::size_t shift = PrivData::WheelBits * lvl;
+         if(!(tic & ((DWord(1) << shift) - 1)))
+            cascade(pd->wheel[lvl][(tic >> shift) & (PrivData::WheelSlots - 1)]);
+      }
+
+      // Everything left in the current level 0 slot is due now.
+      auto &slot = pd->wheel[0][tic & (PrivData::WheelSlots - 1)];
+      if(!slot.next->obj)
+         return;
+
+      for(auto &thread : slot)
+         pd->wake.push_back(&thread);
+
+      std::sort(pd->wake.begin(), pd->wake.end(),
+         [](Thread const *l, Thread const *r) {return l->execSeq < r->execSeq;});
+
+      ListLink<Thread> *pos = threadActive.next;
+      for(auto thread : pd->wake)
+      {
+         while(pos != &threadActive && pos->obj->execSeq < thread->execSeq)
+            pos = pos->next;
+
+         // Exec counts the final tic down, exactly as an unparked thread.
+         thread->delay = 1;
+         thread->link.relink(pos);
+      }
+
+      pd->parked -= pd->wake.size();
+      pd->wake.clear();
    }
 
    //
@@ -1159,6 +1420,8 @@ namespace ACSVM
       selfArrV{},
       selfRegV{}
    {
+      env->collectStringsAbort();
+
       // Set arrays and registers to refer to this scope's by default.
       for(std::size_t i = 0; i != ArrC; ++i) arrV[i] = &selfArrV[i];
       for(std::size_t i = 0; i != RegC; ++i) regV[i] = &selfRegV[i];
@@ -1183,6 +1446,7 @@ namespace ACSVM
    //
    ModuleScope::~ModuleScope()
    {
+      env->collectStringsAbort();
    }
 
    //
@@ -1235,6 +1499,14 @@ namespace ACSVM
       }
    }
 
+   //
+   // ModuleScope::listArrays
+   //
+   void ModuleScope::listArrays(std::vector<Array const *> &out) const
+   {
+      for(auto &arr : selfArrV) out.push_back(&arr);
+   }
+
    //
    // ModuleScope::loadState
    //
@@ -1269,6 +1541,14 @@ namespace ACSVM
       for(auto &reg : selfRegV) env->getString(reg)->ref = true;
    }
 
+   //
+   // ModuleScope::refStringsRoots
+   //
+   void ModuleScope::refStringsRoots() const
+   {
+      for(auto &reg : selfRegV) env->getString(reg)->ref = true;
+   }
+
    //
    // ModuleScope::saveState
    //
@@ -16,6 +16,8 @@
 #include "Array.hpp"
 #include "List.hpp"
 
+#include <vector>
+
 
 //----------------------------------------------------------------------------|
 // Types                                                                      |
@@ -49,12 +51,18 @@ namespace ACSVM
 
       bool hasActiveThread() const;
 
+      // Adds the contained arrays to out, for incremental collection.
+      void listArrays(std::vector<Array const *> &out) const;
+
       void lockStrings() const;
 
       void loadState(Serial &in);
 
       void refStrings() const;
 
+      // Marks strings like refStrings, except those in listArrays's arrays.
+      void refStringsRoots() const;
+
       void reset();
 
       void saveState(Serial &out) const;
@@ -102,12 +110,16 @@ namespace ACSVM
 
       bool hasActiveThread() const;
 
+      void listArrays(std::vector<Array const *> &out) const;
+
       void lockStrings() const;
 
       void loadState(Serial &in);
 
       void refStrings() const;
 
+      void refStringsRoots() const;
+
       void reset();
 
       void saveState(Serial &out) const;
@@ -188,12 +200,18 @@ namespace ACSVM
 
       bool isScriptActive(Script *script);
 
+      void linkThread(Thread *thread);
+
+      void listArrays(std::vector<Array const *> &out) const;
+
       void loadState(Serial &in);
 
       void lockStrings() const;
 
       void refStrings() const;
 
+      void refStringsRoots() const;
+
       void reset();
 
       void saveState(Serial &out) const;
@@ -219,6 +237,9 @@ namespace ACSVM
 
       ListLink<MapScope>     hashLink;
       ListLink<ScriptAction> scriptAction;
+
+      // Threads in start order. Threads with a delay of more than one tic are
+      // parked in a timer wheel instead and merged back in when they wake.
       ListLink<Thread>       threadActive;
 
       // Used for untagged string lookup.
@@ -236,9 +257,13 @@ namespace ACSVM
       void loadModules(Serial &in);
       void loadThreads(Serial &in);
 
+      void parkThread(Thread *thread);
+
       void saveModules(Serial &out) const;
       void saveThreads(Serial &out) const;
 
+      void wakeThreads();
+
       PrivData *pd;
    };
 
@@ -258,12 +283,16 @@ namespace ACSVM
 
       void import();
 
+      void listArrays(std::vector<Array const *> &out) const;
+
       void loadState(Serial &in);
 
       void lockStrings() const;
 
       void refStrings() const;
 
+      void refStringsRoots() const;
+
       void saveState(Serial &out) const;
 
       void unlockStrings() const;
@@ -48,7 +48,8 @@ namespace ACSVM
    // String constructor
    //
    String::String(StringData const &data, Word idx_) :
-      StringData{data}, lock{0}, idx{idx_}, len0(static_cast<const Word>(std::strlen(str))), link{this}
+      StringData{data}, lock{0}, idx{idx_}, len0(static_cast<const Word>(std::strlen(str))),
+      ref{false}, link{this}
    {
    }
 
@@ -111,12 +112,16 @@ namespace ACSVM
    // StringTable constructor
    //
    StringTable::StringTable() :
+      collecting{false},
+
       strV{nullptr},
       strC{0},
 
       strNone{String::New({"", 0, 0}, 0)},
 
-      pd{new PrivData}
+      pd{new PrivData},
+
+      collectIdx{0}
    {
    }
 
@@ -124,12 +129,16 @@ namespace ACSVM
    // StringTable move constructor
    //
    StringTable::StringTable(StringTable &&table) :
+      collecting{table.collecting},
+
       strV{table.strV},
       strC{table.strC},
 
       strNone{table.strNone},
 
-      pd{table.pd}
+      pd{table.pd},
+
+      collectIdx{table.collectIdx}
    {
       table.strV = nullptr;
       table.strC = 0;
@@ -137,6 +146,8 @@ namespace ACSVM
       table.strNone = nullptr;
 
       table.pd = nullptr;
+
+      table.collectAbort();
    }
 
    //
@@ -158,7 +169,12 @@ namespace ACSVM
    //
    String &StringTable::operator [] (StringData const &data)
    {
-      if(auto str = pd->stringByData.find(data)) return *str;
+      if(auto str = pd->stringByData.find(data))
+      {
+         // May be about to be swept, so keep it.
+         if(collecting) str->ref = true;
+         return *str;
+      }
 
       Word idx;
       if(pd->freeIdx.empty())
@@ -183,6 +199,7 @@ namespace ACSVM
       }
 
       String *str = String::New(data, idx);
+      str->ref = collecting;
       pd->stringByIdx[idx] = str;
       pd->stringByData.insert(str);
       return *str;
@@ -205,6 +222,17 @@ namespace ACSVM
 
       strV = nullptr;
       strC = 0;
+
+      collectAbort();
+   }
+
+   //
+   // StringTable::collectAbort
+   //
+   void StringTable::collectAbort()
+   {
+      collectIdx = 0;
+      collecting = false;
    }
 
    //
@@ -236,6 +264,55 @@ namespace ACSVM
       }
    }
 
+   //
+   // StringTable::collectClear
+   //
+   bool StringTable::collectClear(std::size_t &work)
+   {
+      for(std::size_t end = pd->stringByIdx.size(); collectIdx != end; ++collectIdx)
+      {
+         if(!work) return false;
+         --work;
+
+         pd->stringByIdx[collectIdx]->ref = false;
+      }
+
+      collectIdx = 0;
+      return true;
+   }
+
+   //
+   // StringTable::collectMark
+   //
+   void StringTable::collectMark()
+   {
+      collectIdx = 0;
+      collecting = true;
+   }
+
+   //
+   // StringTable::collectSweep
+   //
+   bool StringTable::collectSweep(std::size_t &work)
+   {
+      for(std::size_t end = pd->stringByIdx.size(); collectIdx != end; ++collectIdx)
+      {
+         if(!work) return false;
+         --work;
+
+         String *str = pd->stringByIdx[collectIdx];
+         if(str == strNone || str->ref || str->lock) continue;
+
+         pd->stringByIdx[collectIdx] = strNone;
+         pd->freeIdx.push_back(str->idx);
+         pd->stringByData.unlink(str);
+         String::Delete(str);
+      }
+
+      collectAbort();
+      return true;
+   }
+
    //
    // StringTable::loadState
    //
@@ -108,6 +108,15 @@ namespace ACSVM
       void collectBegin();
       void collectEnd();
 
+      // Incremental collection. collectClear and collectSweep each process up
+      // to work strings and return true once they reach the end of the table.
+      // From collectMark until the sweep finishes, new strings and strings
+      // found by lookup are marked as referenced.
+      void collectAbort();
+      bool collectClear(std::size_t &work);
+      void collectMark();
+      bool collectSweep(std::size_t &work);
+
       String &getNone() {return *strNone;}
 
       void loadState(std::istream &in);
@@ -116,6 +125,9 @@ namespace ACSVM
 
       std::size_t size() const;
 
+      // True while an incremental collection is marking or sweeping.
+      bool collecting;
+
    private:
       struct PrivData;
 
@@ -125,6 +137,8 @@ namespace ACSVM
       String *strNone;
 
       PrivData *pd;
+
+      std::size_t collectIdx;
    };
 }
 
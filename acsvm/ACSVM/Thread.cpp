@@ -45,7 +45,12 @@ namespace ACSVM
       scopeMod{nullptr},
       script  {nullptr},
       delay   {0},
-      result  {0}
+      result  {0},
+
+      codeCount{0},
+
+      execSeq{0},
+      wakeTic{0}
    {
    }
 
@@ -219,7 +224,7 @@ namespace ACSVM
    void Thread::start(Script *script_, MapScope *map, ThreadInfo const *,
       Word const *argV, Word argC)
    {
-      link.insert(&map->threadActive);
+      map->linkThread(this);
 
       script  = script_;
       module  = script->module;
@@ -102,7 +102,7 @@ namespace ACSVM
       Thread(Environment *env);
       virtual ~Thread();
 
-      void exec();
+      virtual void exec();
 
       virtual ThreadInfo const *getInfo() const;
 
@@ -142,6 +142,11 @@ namespace ACSVM
       Word         delay;   // Execution delay tics.
       Word         result;  // Code-defined thread result.
 
+      std::size_t  codeCount; // Codes executed over the thread's lifetime.
+
+      std::size_t  execSeq; // Order in MapScope::threadActive.
+      DWord        wakeTic; // MapScope pass to resume on while parked.
+
 
       static constexpr std::size_t CallStkSize =   8;
       static constexpr std::size_t DataStkSize = 256;
@@ -78,7 +78,7 @@
 // NextCase
 //
 #if ACSVM_DynamicGoto
-#define NextCase() goto *cases[*codePtr++]
+#define NextCase() do {++codes; goto *cases[*codePtr++];} while(0)
 #else
 #define NextCase() goto next_case
 #endif
@@ -117,12 +117,14 @@
 #define OpSet(op) \
    DeclCase(op##_GblArr): \
       Op_##op(scopeGbl->arrV[*codePtr++][dataStk[1]]); dataStk.drop(); \
+      StrBarrier(scopeGbl->arrV[codePtr[-1]]); \
       NextCase(); \
    DeclCase(op##_GblReg): \
       Op_##op(scopeGbl->regV[*codePtr++]); \
       NextCase(); \
    DeclCase(op##_HubArr): \
       Op_##op(scopeHub->arrV[*codePtr++][dataStk[1]]); dataStk.drop(); \
+      StrBarrier(scopeHub->arrV[codePtr[-1]]); \
       NextCase(); \
    DeclCase(op##_HubReg): \
       Op_##op(scopeHub->regV[*codePtr++]); \
@@ -135,11 +137,44 @@
       NextCase(); \
    DeclCase(op##_ModArr): \
       Op_##op((*scopeMod->arrV[*codePtr++])[dataStk[1]]); dataStk.drop(); \
+      StrBarrier(*scopeMod->arrV[codePtr[-1]]); \
       NextCase(); \
    DeclCase(op##_ModReg): \
       Op_##op(*scopeMod->regV[*codePtr++]); \
       NextCase()
 
+//
+// StrBarrier
+//
+// While strings are being collected, marks what an OpSet case just stored to
+// a scope array, which may already have been marked. The index is left just
+// above the top of the stack.
+//
+#define StrBarrier(arr) \
+   if(env->stringTable.collecting) \
+      env->getString((arr).find(dataStk[0]))->ref = true; \
+   else \
+      ((void)0)
+
+//
+// FuseCmpSet
+//
+// Fused compare and Jcnd_Nil, optionally of a LocReg against a literal.
+//
+#define FuseCmpSet(cmp) \
+   DeclCase(Fuse_##cmp##_Jcnd_Nil): \
+      { \
+         Word lop = dataStk[2]; OpFunc_##cmp(lop, dataStk[1]); dataStk.drop(2); \
+         if(lop) codePtr += 2; else BranchTo(codePtr[1]); \
+      } \
+      NextCase(); \
+   DeclCase(Fuse_LocLit_##cmp##_Jcnd_Nil): \
+      { \
+         Word lop = localReg[codePtr[0]]; OpFunc_##cmp(lop, codePtr[2]); \
+         if(lop) codePtr += 6; else BranchTo(codePtr[5]); \
+      } \
+      NextCase()
+
 
 //----------------------------------------------------------------------------|
 // Static Functions                                                           |
@@ -271,9 +306,13 @@ namespace ACSVM
       if(delay && --delay)
          return;
 
-      auto branches = env->branchLimit;
+      auto        branches = env->branchLimit;
+      std::size_t codes    = 0;
 
    exec_intr:
+      codeCount += codes;
+      codes      = 0;
+
       switch(state.state)
       {
       case ThreadState::Inactive: return;
@@ -315,7 +354,7 @@ namespace ACSVM
       #if ACSVM_DynamicGoto
       NextCase();
       #else
-      next_case: switch(*codePtr++)
+      next_case: ++codes; switch(*codePtr++)
       #endif
       {
       DeclCase(Nop):
@@ -632,9 +671,61 @@ namespace ACSVM
       DeclCase(NotU):
          dataStk[1] = !dataStk[1];
          NextCase();
+
+         //================================================
+         // Fused codes.
+         //
+         // Each reads the words of the codes it replaced, so it skips the
+         // intermediate opcodes between its arguments.
+         //
+
+         FuseCmpSet(CmpI_GE);
+         FuseCmpSet(CmpI_GT);
+         FuseCmpSet(CmpI_LE);
+         FuseCmpSet(CmpI_LT);
+         FuseCmpSet(CmpU_EQ);
+         FuseCmpSet(CmpU_NE);
+
+      DeclCase(Fuse_AddU_LitLoc):
+         localReg[codePtr[2]] += codePtr[0];
+         codePtr += 3;
+         NextCase();
+
+      DeclCase(Fuse_Drop_LitLoc):
+         localReg[codePtr[2]] = codePtr[0];
+         codePtr += 3;
+         NextCase();
+
+      DeclCase(Fuse_IncU_LocJump):
+         ++localReg[codePtr[0]];
+         BranchTo(codePtr[2]);
+         NextCase();
+
+      DeclCase(Fuse_Push_LocLit):
+         dataStk.push(localReg[codePtr[0]]);
+         dataStk.push(codePtr[2]);
+         codePtr += 3;
+         NextCase();
+
+      DeclCase(Fuse_Push_LocLoc):
+         dataStk.push(localReg[codePtr[0]]);
+         dataStk.push(localReg[codePtr[2]]);
+         codePtr += 3;
+         NextCase();
+
+      DeclCase(Fuse_Push_LocModArr):
+         dataStk.push(scopeMod->arrV[codePtr[2]]->find(localReg[codePtr[0]]));
+         codePtr += 3;
+         NextCase();
+
+      DeclCase(Fuse_SubU_LitLoc):
+         localReg[codePtr[2]] -= codePtr[0];
+         codePtr += 3;
+         NextCase();
       }
 
    thread_stop:
+      codeCount += codes;
       stop();
    }
 }
@@ -18,9 +18,11 @@
  * along with this program.  If not, see http://www.gnu.org/licenses/
  */
 
+#include <ctype.h>
 #include <limits.h>
 #include <errno.h>
 #include <sys/types.h>
+#include <unordered_map>
 
 // haleyjd: Use zone memory and other assets such as wad/file io
 // emulation, since this is now being made Eternity-specific by
@@ -100,6 +102,184 @@ static char *cfg_strndup(const char *s, size_t n)
    return r;
 }
 
+//=============================================================================
+//
+// Option Name Index
+//
+// Every section built from the same option table has an identical opts array,
+// copied by cfg_dupopts, so one open-addressed hash of option names per table
+// serves all of them. The hash folds case so that it works whether or not the
+// section is CFGF_NOCASE; candidates are still compared by the section's rules.
+//
+
+struct cfg_optindex_t
+{
+   unsigned int  mask;  // number of slots - 1
+   int          *slots; // option position + 1, or 0 for an empty slot
+};
+
+static unsigned int cfg_hashname(const char *name, size_t len)
+{
+   unsigned int h = 2166136261u;
+
+   while(len--)
+      h = (h ^ static_cast<unsigned char>(tolower(*name++))) * 16777619u;
+
+   return h;
+}
+
+//
+// cfg_getoptindex
+//
+// Returns the index for an option table, building it the first time.
+//
+static const cfg_optindex_t *cfg_getoptindex(const cfg_opt_t *opts)
+{
+   static std::unordered_map<const cfg_opt_t *, cfg_optindex_t *> indices;
+
+   if(!opts)
+      return nullptr;
+
+   cfg_optindex_t *&index = indices[opts];
+   if(index)
+      return index;
+
+   int numopts = 0;
+   while(opts[numopts].name)
+      ++numopts;
+
+   // keep the load factor at or below one half
+   unsigned int numslots = 8;
+   while(numslots < static_cast<unsigned int>(numopts) * 2)
+      numslots *= 2;
+
+   index        = estructalloc(cfg_optindex_t, 1);
+   index->mask  = numslots - 1;
+   index->slots = ecalloc(int *, numslots, sizeof(int));
+
+   for(int i = 0; i < numopts; i++)
+   {
+      unsigned int slot = cfg_hashname(opts[i].name, strlen(opts[i].name)) & index->mask;
+
+      while(index->slots[slot])
+         slot = (slot + 1) & index->mask;
+
+      index->slots[slot] = i + 1;
+   }
+
+   return index;
+}
+
+//
+// cfg_findopt
+//
+// Looks up an option in a single section by a name that need not be
+// terminated. Does not report errors.
+//
+static cfg_opt_t *cfg_findopt(const cfg_t *sec, const char *name, size_t len)
+{
+   const bool nocase = is_set(CFGF_NOCASE, sec->flags);
+   auto matches = [=](const char *optname)
+   {
+      return (nocase ? strncasecmp(optname, name, len) : strncmp(optname, name, len)) == 0 &&
+         optname[len] == '\0';
+   };
+
+   if(const cfg_optindex_t *index = sec->optindex)
+   {
+      unsigned int slot = cfg_hashname(name, len) & index->mask;
+
+      for(int pos; (pos = index->slots[slot]); slot = (slot + 1) & index->mask)
+      {
+         if(matches(sec->opts[pos - 1].name))
+            return &sec->opts[pos - 1];
+      }
+      return nullptr;
+   }
+
+   for(int i = 0; sec->opts[i].name; i++)
+   {
+      if(matches(sec->opts[i].name))
+         return &sec->opts[i];
+   }
+   return nullptr;
+}
+
+//=============================================================================
+//
+// Section Title Index
+//
+// Titled sections are looked up by title whenever one is defined (to replace
+// an earlier definition) and by cfg_gettsec, which with thousands of frames
+// or thingtypes made both quadratic. Each such option keeps a hash of value
+// positions by title, extended lazily with values added since the last search
+// so that nothing needs to hook the point where a new section gets its title.
+//
+
+struct cfg_titleindex_t
+{
+   unsigned int  mask;  // number of slots - 1
+   unsigned int  count; // number of leading values indexed
+   unsigned int *slots; // value position + 1, or 0 for an empty slot
+};
+
+static void cfg_titleinsert(cfg_titleindex_t *ti, const char *title, unsigned int pos)
+{
+   unsigned int slot = cfg_hashname(title, strlen(title)) & ti->mask;
+
+   while(ti->slots[slot])
+      slot = (slot + 1) & ti->mask;
+
+   ti->slots[slot] = pos + 1;
+}
+
+//
+// cfg_findtitle
+//
+// Returns the value of a titled section option with the given title.
+//
+static cfg_value_t *cfg_findtitle(const cfg_t *cfg, cfg_opt_t *opt, const char *title)
+{
+   cfg_titleindex_t *ti = opt->titles;
+
+   // keep the load factor at or below one half, rebuilding when it grows
+   if(!ti || opt->nvalues * 2 > ti->mask + 1)
+   {
+      unsigned int numslots = 16;
+      while(numslots < opt->nvalues * 2)
+         numslots *= 2;
+
+      if(!ti)
+         ti = opt->titles = estructalloc(cfg_titleindex_t, 1);
+      else
+         efree(ti->slots);
+
+      ti->mask  = numslots - 1;
+      ti->count = 0;
+      ti->slots = ecalloc(unsigned int *, numslots, sizeof(unsigned int));
+   }
+
+   // index sections defined since the last search
+   for(; ti->count < opt->nvalues; ti->count++)
+   {
+      if(const char *sectitle = opt->values[ti->count]->section->title)
+         cfg_titleinsert(ti, sectitle, ti->count);
+   }
+
+   const bool   nocase = is_set(CFGF_NOCASE, cfg->flags);
+   unsigned int slot   = cfg_hashname(title, strlen(title)) & ti->mask;
+
+   for(unsigned int pos; (pos = ti->slots[slot]); slot = (slot + 1) & ti->mask)
+   {
+      cfg_value_t *val = opt->values[pos - 1];
+
+      if((nocase ? strcasecmp(title, val->section->title) : strcmp(title, val->section->title)) == 0)
+         return val;
+   }
+
+   return nullptr;
+}
+
 //=============================================================================
 //
 // Option Retrieval
@@ -107,28 +287,31 @@ static char *cfg_strndup(const char *s, size_t n)
 
 cfg_opt_t *cfg_getopt(const cfg_t *const cfg, const char *name)
 {
-   int i;
    const cfg_t *sec = cfg;
+   cfg_opt_t   *opt;
    
    cfg_assert(cfg && cfg->name && name);
 
    // haleyjd 07/11/03: from CVS, traverses subsections
    while(name && *name)
    {
-      char *secname;
       size_t len = strcspn(name, "|");
 
       if(name[len] == 0) /* no more subsections */
          break;
       if(len)
       {
-         secname = cfg_strndup(name, len);
-         sec = cfg_getsec(sec, secname);
-         if(sec == nullptr)
-            cfg_error(cfg, "no such option '%s'\n", secname);
-         efree(secname);
-         if(sec == nullptr)
+         // look the subsection up in place rather than copying its name
+         if((opt = cfg_findopt(sec, name, len)) && opt->type == CFGT_SEC)
+         {
+            cfg_assert(opt->values);
+            sec = opt->values[0]->section;
+         }
+         else
+         {
+            cfg_error(cfg, "no such option '%.*s'\n", (int)len, name);
             return nullptr;
+         }
       }
       name += len;
       name += strspn(name, "|");
@@ -138,21 +321,40 @@ cfg_opt_t *cfg_getopt(const cfg_t *const cfg, const char *name)
    if(name[0] == '+' || name[0] == '-')
       ++name; // skip past it for lookup
    
-   for(i = 0; sec->opts[i].name; i++)
+   if((opt = cfg_findopt(sec, name, strlen(name))))
+      return opt;
+
+   cfg_error(cfg, "no such option '%s'\n", name);
+   return nullptr;
+}
+
+//
+// cfg_getopt
+//
+// Handle version. The handle caches the position of its option for the last
+// option table it was used with, so only switching between sections built
+// from different tables costs a lookup.
+//
+cfg_opt_t *cfg_getopt(const cfg_t *const cfg, cfg_opthandle_t &handle)
+{
+   cfg_assert(cfg && cfg->name && handle.name);
+
+   if(handle.index != cfg->optindex || !cfg->optindex)
    {
-      if(is_set(CFGF_NOCASE, sec->flags))
-      {
-         if(strcasecmp(sec->opts[i].name, name) == 0)
-            return &sec->opts[i];
-      } 
-      else 
+      cfg_opt_t *opt = cfg_findopt(cfg, handle.name, strlen(handle.name));
+
+      if(!opt)
       {
-         if(strcmp(sec->opts[i].name, name) == 0)
-            return &sec->opts[i];
+         cfg_error(cfg, "no such option '%s'\n", handle.name);
+         return nullptr;
       }
+
+      handle.index = cfg->optindex;
+      handle.pos   = static_cast<int>(opt - cfg->opts);
+      return opt;
    }
-   cfg_error(cfg, "no such option '%s'\n", name);
-   return nullptr;
+
+   return &cfg->opts[handle.pos];
 }
 
 //
@@ -187,16 +389,22 @@ unsigned int cfg_size(const cfg_t *const cfg, const char *name)
    return 0;
 }
 
+unsigned int cfg_size(const cfg_t *const cfg, cfg_opthandle_t &handle)
+{
+   cfg_opt_t *opt = cfg_getopt(cfg, handle);
+   if(opt)
+      return opt->nvalues;
+   return 0;
+}
+
 cfg_t *cfg_displaced(cfg_t *cfg)
 {
    // haleyjd 01/02/12: for getting the displaced cfg_t
    return cfg->displaced;
 }
 
-signed int cfg_getnint(cfg_t *cfg, const char *name, unsigned int index)
+static signed int cfg_opt_getnint(cfg_opt_t *opt, unsigned int index)
 {
-   cfg_opt_t *opt = cfg_getopt(cfg, name);
-   
    if(opt)
    {
       cfg_assert(opt->type == CFGT_INT);
@@ -212,15 +420,28 @@ signed int cfg_getnint(cfg_t *cfg, const char *name, unsigned int index)
       return 0;
 }
 
+signed int cfg_getnint(cfg_t *cfg, const char *name, unsigned int index)
+{
+   return cfg_opt_getnint(cfg_getopt(cfg, name), index);
+}
+
+signed int cfg_getnint(cfg_t *cfg, cfg_opthandle_t &handle, unsigned int index)
+{
+   return cfg_opt_getnint(cfg_getopt(cfg, handle), index);
+}
+
 signed int cfg_getint(cfg_t *cfg, const char *name)
 {
    return cfg_getnint(cfg, name, 0);
 }
 
-double cfg_getnfloat(cfg_t *cfg, const char *name, unsigned int index)
+signed int cfg_getint(cfg_t *cfg, cfg_opthandle_t &handle)
+{
+   return cfg_getnint(cfg, handle, 0);
+}
+
+static double cfg_opt_getnfloat(cfg_opt_t *opt, unsigned int index)
 {
-   cfg_opt_t *opt = cfg_getopt(cfg, name);
-   
    if(opt) 
    {
       cfg_assert(opt->type == CFGT_FLOAT);
@@ -236,15 +457,23 @@ double cfg_getnfloat(cfg_t *cfg, const char *name, unsigned int index)
       return 0;
 }
 
+double cfg_getnfloat(cfg_t *cfg, const char *name, unsigned int index)
+{
+   return cfg_opt_getnfloat(cfg_getopt(cfg, name), index);
+}
+
 double cfg_getfloat(cfg_t *cfg, const char *name)
 {
    return cfg_getnfloat(cfg, name, 0);
 }
 
-bool cfg_getnbool(cfg_t *cfg, const char *name, unsigned int index)
+double cfg_getfloat(cfg_t *cfg, cfg_opthandle_t &handle)
+{
+   return cfg_opt_getnfloat(cfg_getopt(cfg, handle), 0);
+}
+
+static bool cfg_opt_getnbool(cfg_opt_t *opt, unsigned int index)
 {
-   cfg_opt_t *opt = cfg_getopt(cfg, name);
-   
    if(opt)
    {
       cfg_assert(opt->type == CFGT_BOOL);
@@ -260,17 +489,25 @@ bool cfg_getnbool(cfg_t *cfg, const char *name, unsigned int index)
       return false;
 }
 
+bool cfg_getnbool(cfg_t *cfg, const char *name, unsigned int index)
+{
+   return cfg_opt_getnbool(cfg_getopt(cfg, name), index);
+}
+
 bool cfg_getbool(cfg_t *cfg, const char *name)
 {
    return cfg_getnbool(cfg, name, 0);
 }
 
+bool cfg_getbool(cfg_t *cfg, cfg_opthandle_t &handle)
+{
+   return cfg_opt_getnbool(cfg_getopt(cfg, handle), 0);
+}
+
 // haleyjd 12/27/10: return value must be explicitly const (was implicitly
 // considered that way anyway)
-const char *cfg_getnstr(cfg_t *cfg, const char *name, unsigned int index)
+static const char *cfg_opt_getnstr(cfg_opt_t *opt, unsigned int index)
 {
-   cfg_opt_t *opt = cfg_getopt(cfg, name);
-   
    if(opt)
    {
       cfg_assert(opt->type == CFGT_STR || opt->type == CFGT_STRFUNC); // haleyjd
@@ -285,11 +522,26 @@ const char *cfg_getnstr(cfg_t *cfg, const char *name, unsigned int index)
    return nullptr;
 }
 
+const char *cfg_getnstr(cfg_t *cfg, const char *name, unsigned int index)
+{
+   return cfg_opt_getnstr(cfg_getopt(cfg, name), index);
+}
+
+const char *cfg_getnstr(cfg_t *cfg, cfg_opthandle_t &handle, unsigned int index)
+{
+   return cfg_opt_getnstr(cfg_getopt(cfg, handle), index);
+}
+
 const char *cfg_getstr(cfg_t *cfg, const char *name)
 {
    return cfg_getnstr(cfg, name, 0);
 }
 
+const char *cfg_getstr(cfg_t *cfg, cfg_opthandle_t &handle)
+{
+   return cfg_getnstr(cfg, handle, 0);
+}
+
 char *cfg_getstrdup(cfg_t *cfg, const char *name)
 {
    // haleyjd 12/31/11: get a dynamic copy of a string
@@ -298,10 +550,8 @@ char *cfg_getstrdup(cfg_t *cfg, const char *name)
    return value ? estrdup(value) : nullptr;
 }
 
-cfg_t *cfg_getnsec(const cfg_t *const cfg, const char *name, unsigned int index)
+static cfg_t *cfg_opt_getnsec(cfg_opt_t *opt, unsigned int index)
 {
-   cfg_opt_t *opt = cfg_getopt(cfg, name);
-   
    if(opt) 
    {
       cfg_assert(opt->type == CFGT_SEC);
@@ -312,29 +562,27 @@ cfg_t *cfg_getnsec(const cfg_t *const cfg, const char *name, unsigned int index)
    return nullptr;
 }
 
+cfg_t *cfg_getnsec(const cfg_t *const cfg, const char *name, unsigned int index)
+{
+   return cfg_opt_getnsec(cfg_getopt(cfg, name), index);
+}
+
+cfg_t *cfg_getnsec(const cfg_t *const cfg, cfg_opthandle_t &handle, unsigned int index)
+{
+   return cfg_opt_getnsec(cfg_getopt(cfg, handle), index);
+}
+
 cfg_t *cfg_gettsec(cfg_t *cfg, const char *name, const char *title)
 {
-   unsigned int i, n;
-   
-   n = cfg_size(cfg, name);
-   
-   for(i = 0; i < n; i++) 
-   {
-      cfg_t *sec = cfg_getnsec(cfg, name, i);
-      cfg_assert(sec && sec->title);
-      
-      if(is_set(CFGF_NOCASE, cfg->flags))
-      {
-         if(strcasecmp(title, sec->title) == 0)
-            return sec;
-      } 
-      else 
-      {
-         if(strcmp(title, sec->title) == 0)
-            return sec;
-      }
-   }
-   return nullptr;
+   cfg_opt_t *opt = cfg_getopt(cfg, name);
+
+   if(!opt || !opt->nvalues)
+      return nullptr;
+
+   cfg_assert(opt->type == CFGT_SEC);
+
+   cfg_value_t *val = cfg_findtitle(cfg, opt, title);
+   return val ? val->section : nullptr;
 }
 
 cfg_t *cfg_getsec(const cfg_t *const cfg, const char *name)
@@ -377,10 +625,8 @@ cfg_t *cfg_getmvprop(cfg_t *cfg, const char *name)
 //
 // haleyjd 05/25/10
 //
-signed int cfg_getnflag(cfg_t *cfg, const char *name, unsigned int index)
+static signed int cfg_opt_getnflag(cfg_opt_t *opt, unsigned int index)
 {
-   cfg_opt_t *opt = cfg_getopt(cfg, name);
-   
    if(opt)
    {
       cfg_assert(opt->type == CFGT_FLAG);
@@ -401,11 +647,21 @@ signed int cfg_getnflag(cfg_t *cfg, const char *name, unsigned int index)
 //
 // haleyjd 05/25/10
 //
+signed int cfg_getnflag(cfg_t *cfg, const char *name, unsigned int index)
+{
+   return cfg_opt_getnflag(cfg_getopt(cfg, name), index);
+}
+
 signed int cfg_getflag(cfg_t *cfg, const char *name)
 {
    return cfg_getnflag(cfg, name, 0);
 }
 
+signed int cfg_getflag(cfg_t *cfg, cfg_opthandle_t &handle)
+{
+   return cfg_opt_getnflag(cfg_getopt(cfg, handle), 0);
+}
+
 //
 // cfg_gettitleprops
 //
@@ -455,6 +711,10 @@ static cfg_opt_t *cfg_dupopts(cfg_opt_t *opts)
    ++n;
    dupopts = estructalloc(cfg_opt_t, n);
    memcpy(dupopts, opts, n * sizeof(cfg_opt_t));
+
+   // title indices belong to the values, which are not copied
+   for(int i = 0; i < n; i++)
+      dupopts[i].titles = nullptr;
    return dupopts;
 }
 
@@ -498,24 +758,10 @@ cfg_value_t *cfg_setopt(cfg_t *cfg, cfg_opt_t *opt, const char *value)
          val = nullptr;
          if(opt->type == CFGT_SEC && is_set(CFGF_TITLE, opt->flags))
          {
-            unsigned int ii;
-
             /* check if there is already a section with the same title */
             cfg_assert(value);
-            for(ii = 0; ii < opt->nvalues; ii++)
-            {
-               cfg_t *sec = opt->values[ii]->section;
-               if(is_set(CFGF_NOCASE, cfg->flags))
-               {
-                  if(strcasecmp(value, sec->title) == 0)
-                     val = opt->values[ii];
-               }
-               else
-               {
-                  if(strcmp(value, sec->title) == 0)
-                     val = opt->values[ii];
-               }
-            }
+            if(opt->nvalues)
+               val = cfg_findtitle(cfg, opt, value);
          }
          if(val == nullptr)
             val = cfg_addval(opt);
@@ -599,6 +845,7 @@ cfg_value_t *cfg_setopt(cfg_t *cfg, cfg_opt_t *opt, const char *value)
       val->section->namealloc = estrdup(opt->name); // haleyjd 04/14/11
       val->section->name      = val->section->namealloc;
       val->section->opts      = cfg_dupopts(opt->subopts);
+      val->section->optindex  = cfg_getoptindex(opt->subopts);
       val->section->flags     = cfg->flags;
       val->section->flags    |= CFGF_ALLOCATED;
       val->section->filename  = cfg->filename;
@@ -674,6 +921,13 @@ void cfg_free_value(cfg_opt_t *opt)
    efree(opt->values);
    opt->values = nullptr;
    opt->nvalues = 0;
+
+   if(opt->titles)
+   {
+      efree(opt->titles->slots);
+      efree(opt->titles);
+      opt->titles = nullptr;
+   }
 }
 
 //=============================================================================
@@ -1404,6 +1658,7 @@ cfg_t *cfg_init(cfg_opt_t *opts, cfg_flag_t flags)
 
    cfg->name     = "root";
    cfg->opts     = opts;
+   cfg->optindex = cfg_getoptindex(opts);
    cfg->flags    = flags;
    cfg->filename = nullptr;
    cfg->line     = 0;
@@ -91,6 +91,8 @@ enum cfg_dialect_t
 
 union  cfg_value_t;
 struct cfg_opt_t;
+struct cfg_optindex_t;
+struct cfg_titleindex_t;
 struct cfg_t;
 
 typedef int cfg_flag_t;
@@ -180,6 +182,26 @@ struct cfg_t
                                 * when initially opening a file. */
    const char *lookfor;    /**< Name of a function to look for. */
    cfg_t *displaced;       /**< haleyjd: pointer to a displaced section */
+   const cfg_optindex_t *optindex; /**< Name hash for opts, shared by every
+                                     * section built from the same table */
+};
+
+/**
+ * Pre-resolved option handle. Construct one (usually static) from an option
+ * name and pass it to the cfg_t accessors in place of the name; the position
+ * of the option is looked up once per option table and then reused, rather
+ * than being hashed again on every call. Handles cannot name subsections.
+ */
+struct cfg_opthandle_t
+{
+   explicit constexpr cfg_opthandle_t(const char *name_)
+      : name(name_), index(nullptr), pos(0)
+   {
+   }
+
+   const char           *name;  /**< The name of the option */
+   const cfg_optindex_t *index; /**< Option table pos is resolved for */
+   int                   pos;   /**< Position of the option in that table */
 };
 
 /** 
@@ -217,6 +239,8 @@ struct cfg_opt_t
                                   * store simple values (created with the
                                   * CFG_SIMPLE_* initializers) */
    cfg_callback_t cb;          /**< Value parsing callback function */
+   cfg_titleindex_t *titles = nullptr; /**< Hash of section titles, built on
+                                         * demand for CFGF_TITLE sections */
 };
 
 /** 
@@ -703,6 +727,22 @@ int cfg_parse_boolean(const char *s);
  */
 cfg_opt_t *cfg_getopt(const cfg_t *const cfg, const char *name);
 
+/** Return an option given a pre-resolved handle.
+ */
+cfg_opt_t *cfg_getopt(const cfg_t *const cfg, cfg_opthandle_t &handle);
+
+/** Handle-taking versions of the accessors above.
+ */
+unsigned int cfg_size(const cfg_t *const cfg, cfg_opthandle_t &handle);
+int          cfg_getnint(cfg_t *cfg, cfg_opthandle_t &handle, unsigned int index);
+int          cfg_getint(cfg_t *cfg, cfg_opthandle_t &handle);
+double       cfg_getfloat(cfg_t *cfg, cfg_opthandle_t &handle);
+bool         cfg_getbool(cfg_t *cfg, cfg_opthandle_t &handle);
+const char * cfg_getnstr(cfg_t *cfg, cfg_opthandle_t &handle, unsigned int index);
+const char * cfg_getstr(cfg_t *cfg, cfg_opthandle_t &handle);
+int          cfg_getflag(cfg_t *cfg, cfg_opthandle_t &handle);
+cfg_t *      cfg_getnsec(const cfg_t *const cfg, cfg_opthandle_t &handle, unsigned int index);
+
 /** Set a value of an integer option.
  *
  * @param cfg The configuration file context.
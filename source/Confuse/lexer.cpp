@@ -231,6 +231,8 @@ static int lexer_state_slcomment(lexerstate_t *ls)
       ls->cfg->line++;
       ls->state = STATE_NONE;
    }
+   else
+      bufferpos += strcspn(bufferpos, "\n"); // skip the rest of the line at once
 
    return -1; // continue parsing
 }
@@ -251,9 +253,13 @@ static int lexer_state_mlcomment(lexerstate_t *ls)
       {
          ++bufferpos; // move past '/'
          ls->state = STATE_NONE;
+         return -1;
       }
    }
 
+   // nothing up to the next '*' or line break can matter
+   bufferpos += strcspn(bufferpos, "*\n");
+
    return -1; // continue parsing
 }
 
@@ -291,6 +297,11 @@ static int lexer_state_string(lexerstate_t *ls)
       break;
    default:
       qstr += ls->c;
+
+      // copy the rest of a run of ordinary characters without going back
+      // through mylex for each one; \r is left for mylex to discard.
+      for(char c; (c = *bufferpos) && !strchr("\n\"'\\\r", c); ++bufferpos)
+         qstr += c;
       break;
    }
 
@@ -450,24 +461,29 @@ static int lexer_state_unquotedstring(lexerstate_t *ls)
 {
    char c = ls->c;
 
-   if((!unquoted_spaces && (c == ' ' || c == '\t'))       || 
-      (currentDialect >= CFG_DIALECT_ALFHEIM && c == ':') ||
-      c == '"'  || c == '\'' || c == '\n' || c == '='     || 
-      c == '{'  || c == '}'  || c == '('  || c == ')'     || 
-      c == '+'  || c == ','  || c == '#'  || c == '/'     || 
-      c == ';')
-   {
-      // any special character ends an unquoted string
-      --bufferpos; // put it back
-      mytext = qstr.constPtr();
-      
-      return CFGT_STR; // return a string token
-   }
-   else // normal characters
+   // consume characters here until the string ends, rather than returning
+   // to mylex for each one
+   for(;;)
    {
-      qstr += c;
-      
-      return -1; // continue parsing
+      if((!unquoted_spaces && (c == ' ' || c == '\t'))       || 
+         (currentDialect >= CFG_DIALECT_ALFHEIM && c == ':') ||
+         c == '"'  || c == '\'' || c == '\n' || c == '='     || 
+         c == '{'  || c == '}'  || c == '('  || c == ')'     || 
+         c == '+'  || c == ','  || c == '#'  || c == '/'     || 
+         c == ';')
+      {
+         // any special character ends an unquoted string
+         --bufferpos; // put it back
+         mytext = qstr.constPtr();
+
+         return CFGT_STR; // return a string token
+      }
+      else if(c != '\r') // normal characters; \r is discarded as in mylex
+         qstr += c;
+
+      if(!(c = *bufferpos))
+         return -1; // let mylex handle EOF
+      ++bufferpos;
    }
 }
 
@@ -768,10 +768,10 @@ void A_StartScriptNamed(actionargs_t *actionargs)
 {
    Mobj      *actor = actionargs->actor;
    arglist_t *args  = actionargs->args;
-   const char *scriptname = E_ArgAsString(args, 0, "");
+   ACSVM::String *scriptname = E_ArgAsACSString(args, 0);
    int selectvm = E_ArgAsKwd(args, 1, &sscriptkwds, 0);
 
-   if(selectvm < 2)
+   if(selectvm < 2 || !scriptname)
    {
       /* nothing */ ;
    }
@@ -36,6 +36,7 @@
 
 #include "acs_intr.h"
 #include "c_runcmd.h"
+#include "cam_sight.h"
 #include "d_event.h"
 #include "d_gi.h"
 #include "e_args.h"
@@ -50,6 +51,7 @@
 #include "g_game.h"
 #include "hu_stuff.h"
 #include "m_random.h"
+#include "p_enemy.h"
 #include "p_info.h"
 #include "p_inter.h"
 #include "p_map.h"
@@ -1812,6 +1814,9 @@ static void ACS_setLineBlocking(const ACSThread *thread, int tag, int block)
          break;
       }
    }
+
+   CAM_InvalidateSightCache();
+   P_InvalidateSoundFloods(nullptr);
 }
 
 //
@@ -2143,7 +2148,8 @@ void ACS_SetThingProp(Mobj *thing, uint32_t var, uint32_t val)
    case ACS_TP_TargetTID:    P_SetTarget(&thing->target, P_FindMobjFromTID(val, nullptr, nullptr)); break;
    case ACS_TP_TracerTID:    P_SetTarget(&thing->tracer, P_FindMobjFromTID(val, nullptr, nullptr)); break;
    case ACS_TP_WaterLevel:   break;
-   case ACS_TP_ScaleX:       thing->xscale = M_FixedToFloat(val); break;
+   case ACS_TP_ScaleX:       thing->xscale = M_FixedToFloat(val);
+                             P_AddThingToSectorBox(thing, true); break;
    case ACS_TP_ScaleY:       thing->yscale = M_FixedToFloat(val); break;
    case ACS_TP_Dormant:      if(val) thing->flags2 |=  MF2_DORMANT;
                              else    thing->flags2 &= ~MF2_DORMANT; break;
@@ -29,17 +29,23 @@
 //
 //----------------------------------------------------------------------------
 
+#include <chrono>
+
 #include "z_zone.h"
 
 #include "acs_intr.h"
+#include "acs_profile.h"
+#include "c_io.h"
 #include "c_runcmd.h"
 #include "doomstat.h"
+#include "e_args.h"
 #include "e_hash.h"
 #include "ev_specials.h"
 #include "g_game.h"
 #include "hu_stuff.h"
 #include "m_buffer.h"
 #include "m_collection.h"
+#include "m_compare.h"
 #include "m_qstr.h"
 #include "m_swap.h"
 #include "m_utils.h"
@@ -100,279 +106,295 @@ ACSEnvironment::ACSEnvironment() :
    // Add code translations.
 
    // 0-56: ACSVM internal codes.
-   addCodeDataACS0( 57, {"",        2, addCallFunc(ACS_CF_Random)});
-   addCodeDataACS0( 58, {"WW",      0, addCallFunc(ACS_CF_Random)});
-   addCodeDataACS0( 59, {"",        2, addCallFunc(ACS_CF_ThingCount)});
-   addCodeDataACS0( 60, {"WW",      0, addCallFunc(ACS_CF_ThingCount)});
-   addCodeDataACS0( 61, {"",        1, addCallFunc(ACS_CF_TagWait)});
-   addCodeDataACS0( 62, {"W",       0, addCallFunc(ACS_CF_TagWait)});
-   addCodeDataACS0( 63, {"",        1, addCallFunc(ACS_CF_PolyWait)});
-   addCodeDataACS0( 64, {"W",       0, addCallFunc(ACS_CF_PolyWait)});
-   addCodeDataACS0( 65, {"",        2, addCallFunc(ACS_CF_ChangeFloor)});
-   addCodeDataACS0( 66, {"WWS",     0, addCallFunc(ACS_CF_ChangeFloor)});
-   addCodeDataACS0( 67, {"",        2, addCallFunc(ACS_CF_ChangeCeiling)});
-   addCodeDataACS0( 68, {"WWS",     0, addCallFunc(ACS_CF_ChangeCeiling)});
+   addCodeDataACS0( 57, {"",        2, addCallFunc(ACS_CF_Random, "Random")});
+   addCodeDataACS0( 58, {"WW",      0, addCallFunc(ACS_CF_Random, "Random")});
+   addCodeDataACS0( 59, {"",        2, addCallFunc(ACS_CF_ThingCount, "ThingCount")});
+   addCodeDataACS0( 60, {"WW",      0, addCallFunc(ACS_CF_ThingCount, "ThingCount")});
+   addCodeDataACS0( 61, {"",        1, addCallFunc(ACS_CF_TagWait, "TagWait")});
+   addCodeDataACS0( 62, {"W",       0, addCallFunc(ACS_CF_TagWait, "TagWait")});
+   addCodeDataACS0( 63, {"",        1, addCallFunc(ACS_CF_PolyWait, "PolyWait")});
+   addCodeDataACS0( 64, {"W",       0, addCallFunc(ACS_CF_PolyWait, "PolyWait")});
+   addCodeDataACS0( 65, {"",        2, addCallFunc(ACS_CF_ChangeFloor, "ChangeFloor")});
+   addCodeDataACS0( 66, {"WWS",     0, addCallFunc(ACS_CF_ChangeFloor, "ChangeFloor")});
+   addCodeDataACS0( 67, {"",        2, addCallFunc(ACS_CF_ChangeCeiling, "ChangeCeiling")});
+   addCodeDataACS0( 68, {"WWS",     0, addCallFunc(ACS_CF_ChangeCeiling, "ChangeCeiling")});
    // 69-79: ACSVM internal codes.
-   addCodeDataACS0( 80, {"",        0, addCallFunc(ACS_CF_LineSide)});
+   addCodeDataACS0( 80, {"",        0, addCallFunc(ACS_CF_LineSide, "LineSide")});
    // 81-82: ACSVM internal codes.
-   addCodeDataACS0( 83, {"",        0, addCallFunc(ACS_CF_ClearLineSpecial)});
+   addCodeDataACS0( 83, {"",        0, addCallFunc(ACS_CF_ClearLineSpecial, "ClearLineSpecial")});
    // 84-85: ACSVM internal codes.
-   addCodeDataACS0( 86, {"",        0, addCallFunc(ACS_CF_EndPrint)});
+   addCodeDataACS0( 86, {"",        0, addCallFunc(ACS_CF_EndPrint, "EndPrint")});
    // 87-89: ACSVM internal codes.
-   addCodeDataACS0( 90, {"",        0, addCallFunc(ACS_CF_PlayerCount)});
-   addCodeDataACS0( 91, {"",        0, addCallFunc(ACS_CF_GameType)});
-   addCodeDataACS0( 92, {"",        0, addCallFunc(ACS_CF_GameSkill)});
-   addCodeDataACS0( 93, {"",        0, addCallFunc(ACS_CF_Timer)});
-   addCodeDataACS0( 94, {"",        2, addCallFunc(ACS_CF_SectorSound)});
-   addCodeDataACS0( 95, {"",        2, addCallFunc(ACS_CF_AmbientSound)});
-   addCodeDataACS0( 96, {"",        1, addCallFunc(ACS_CF_SoundSequence)});
-   addCodeDataACS0( 97, {"",        4, addCallFunc(ACS_CF_SetLineTexture)});
-   addCodeDataACS0( 98, {"",        2, addCallFunc(ACS_CF_SetLineBlocking)});
-   addCodeDataACS0( 99, {"",        7, addCallFunc(ACS_CF_SetLineSpecial)});
-   addCodeDataACS0(100, {"",        3, addCallFunc(ACS_CF_ThingSound)});
-   addCodeDataACS0(101, {"",        0, addCallFunc(ACS_CF_EndPrintBold)});
-   addCodeDataACS0(102, {"",        2, addCallFunc(ACS_CF_ActivatorSound)});
-   addCodeDataACS0(103, {"",        2, addCallFunc(ACS_CF_LocalAmbientSound)});
-   addCodeDataACS0(104, {"",        2, addCallFunc(ACS_CF_SetLineMonsterBlocking)});
+   addCodeDataACS0( 90, {"",        0, addCallFunc(ACS_CF_PlayerCount, "PlayerCount")});
+   addCodeDataACS0( 91, {"",        0, addCallFunc(ACS_CF_GameType, "GameType")});
+   addCodeDataACS0( 92, {"",        0, addCallFunc(ACS_CF_GameSkill, "GameSkill")});
+   addCodeDataACS0( 93, {"",        0, addCallFunc(ACS_CF_Timer, "Timer")});
+   addCodeDataACS0( 94, {"",        2, addCallFunc(ACS_CF_SectorSound, "SectorSound")});
+   addCodeDataACS0( 95, {"",        2, addCallFunc(ACS_CF_AmbientSound, "AmbientSound")});
+   addCodeDataACS0( 96, {"",        1, addCallFunc(ACS_CF_SoundSequence, "SoundSequence")});
+   addCodeDataACS0( 97, {"",        4, addCallFunc(ACS_CF_SetLineTexture, "SetLineTexture")});
+   addCodeDataACS0( 98, {"",        2, addCallFunc(ACS_CF_SetLineBlocking, "SetLineBlocking")});
+   addCodeDataACS0( 99, {"",        7, addCallFunc(ACS_CF_SetLineSpecial, "SetLineSpecial")});
+   addCodeDataACS0(100, {"",        3, addCallFunc(ACS_CF_ThingSound, "ThingSound")});
+   addCodeDataACS0(101, {"",        0, addCallFunc(ACS_CF_EndPrintBold, "EndPrintBold")});
+   addCodeDataACS0(102, {"",        2, addCallFunc(ACS_CF_ActivatorSound, "ActivatorSound")});
+   addCodeDataACS0(103, {"",        2, addCallFunc(ACS_CF_LocalAmbientSound, "LocalAmbientSound")});
+   addCodeDataACS0(104, {"",        2, addCallFunc(ACS_CF_SetLineMonsterBlocking, "SetLineMonsterBlocking")});
    // 105-118: Unused codes.
- //addCodeDATAACS0(119, {"",        0, addCallFunc(ACS_CF_ActivatorTream)});
-   addCodeDataACS0(120, {"",        0, addCallFunc(ACS_CF_PlayerHealth)});
-   addCodeDataACS0(121, {"",        0, addCallFunc(ACS_CF_PlayerArmorPoints)});
-   addCodeDataACS0(122, {"",        0, addCallFunc(ACS_CF_PlayerFrags)});
+ //addCodeDATAACS0(119, {"",        0, addCallFunc(ACS_CF_ActivatorTream, "ActivatorTream")});
+   addCodeDataACS0(120, {"",        0, addCallFunc(ACS_CF_PlayerHealth, "PlayerHealth")});
+   addCodeDataACS0(121, {"",        0, addCallFunc(ACS_CF_PlayerArmorPoints, "PlayerArmorPoints")});
+   addCodeDataACS0(122, {"",        0, addCallFunc(ACS_CF_PlayerFrags, "PlayerFrags")});
    // 123-123: Unused codes.
- //addCodeDataACS0(124, {"",        0, addCallFunc(ACS_CF_BlueTeamCount)});
- //addCodeDataACS0(125, {"",        0, addCallFunc(ACS_CF_RedTeamCount)});
- //addCodeDataACS0(126, {"",        0, addCallFunc(ACS_CF_BlueTeamScore)});
- //addCodeDataACS0(127, {"",        0, addCallFunc(ACS_CF_RedTeamScore)});
- //addCodeDataACS0(128, {"",        0, addCallFunc(ACS_CF_OneFlagCTF)});
- //addCodeDataACS0(129, {"",        0, addCallFunc(ACS_CF_GetInvasionWave)});
- //addCodeDataACS0(130, {"",        0, addCallFunc(ACS_CF_GetInvasionState)});
-   addCodeDataACS0(131, {"",        0, addCallFunc(ACS_CF_PrintName)});
-   addCodeDataACS0(132, {"",        2, addCallFunc(ACS_CF_SetMusic)});
- //addCodeDataACS0(133, {"WSWW",    0, addCallFunc(ACS_CF_ConsoleCommand)});
- //addCodeDataACS0(134, {"",        3, addCallFunc(ACS_CF_ConsoleCommand)});
-   addCodeDataACS0(135, {"",        0, addCallFunc(ACS_CF_SinglePlayer)});
+ //addCodeDataACS0(124, {"",        0, addCallFunc(ACS_CF_BlueTeamCount, "BlueTeamCount")});
+ //addCodeDataACS0(125, {"",        0, addCallFunc(ACS_CF_RedTeamCount, "RedTeamCount")});
+ //addCodeDataACS0(126, {"",        0, addCallFunc(ACS_CF_BlueTeamScore, "BlueTeamScore")});
+ //addCodeDataACS0(127, {"",        0, addCallFunc(ACS_CF_RedTeamScore, "RedTeamScore")});
+ //addCodeDataACS0(128, {"",        0, addCallFunc(ACS_CF_OneFlagCTF, "OneFlagCTF")});
+ //addCodeDataACS0(129, {"",        0, addCallFunc(ACS_CF_GetInvasionWave, "GetInvasionWave")});
+ //addCodeDataACS0(130, {"",        0, addCallFunc(ACS_CF_GetInvasionState, "GetInvasionState")});
+   addCodeDataACS0(131, {"",        0, addCallFunc(ACS_CF_PrintName, "PrintName")});
+   addCodeDataACS0(132, {"",        2, addCallFunc(ACS_CF_SetMusic, "SetMusic")});
+ //addCodeDataACS0(133, {"WSWW",    0, addCallFunc(ACS_CF_ConsoleCommand, "ConsoleCommand")});
+ //addCodeDataACS0(134, {"",        3, addCallFunc(ACS_CF_ConsoleCommand, "ConsoleCommand")});
+   addCodeDataACS0(135, {"",        0, addCallFunc(ACS_CF_SinglePlayer, "SinglePlayer")});
    // 136-137: ACSVM internal codes.
-   addCodeDataACS0(138, {"",        1, addCallFunc(ACS_CF_SetGravity)});
-   addCodeDataACS0(139, {"W",       0, addCallFunc(ACS_CF_SetGravity)});
-   addCodeDataACS0(140, {"",        1, addCallFunc(ACS_CF_SetAirControl)});
-   addCodeDataACS0(141, {"W",       0, addCallFunc(ACS_CF_SetAirControl)});
- //addCodeDataACS0(142, {"",        0, addCallFunc(ACS_CF_ClrInventory)});
- //addCodeDataACS0(143, {"",        2, addCallFunc(ACS_CF_AddInventory)});
- //addCodeDataACS0(144, {"WSW",     0, addCallFunc(ACS_CF_AddInventory)});
-   addCodeDataACS0(145, {"",        2, addCallFunc(ACS_CF_TakeInventory)});
-   addCodeDataACS0(146, {"WSW",     0, addCallFunc(ACS_CF_TakeInventory)});
-   addCodeDataACS0(147, {"",        1, addCallFunc(ACS_CF_CheckInventory)});
-   addCodeDataACS0(148, {"WS",      0, addCallFunc(ACS_CF_CheckInventory)});
-   addCodeDataACS0(149, {"",        6, addCallFunc(ACS_CF_Spawn)});
-   addCodeDataACS0(150, {"WSWWWWW", 0, addCallFunc(ACS_CF_Spawn)});
-   addCodeDataACS0(151, {"",        4, addCallFunc(ACS_CF_SpawnSpot)});
-   addCodeDataACS0(152, {"WSWWW",   0, addCallFunc(ACS_CF_SpawnSpot)});
-   addCodeDataACS0(153, {"",        3, addCallFunc(ACS_CF_SetMusic)});
-   addCodeDataACS0(154, {"WSWW",    0, addCallFunc(ACS_CF_SetMusic)});
-   addCodeDataACS0(155, {"",        3, addCallFunc(ACS_CF_LocalSetMusic)});
-   addCodeDataACS0(156, {"WSWW",    0, addCallFunc(ACS_CF_LocalSetMusic)});
+   addCodeDataACS0(138, {"",        1, addCallFunc(ACS_CF_SetGravity, "SetGravity")});
+   addCodeDataACS0(139, {"W",       0, addCallFunc(ACS_CF_SetGravity, "SetGravity")});
+   addCodeDataACS0(140, {"",        1, addCallFunc(ACS_CF_SetAirControl, "SetAirControl")});
+   addCodeDataACS0(141, {"W",       0, addCallFunc(ACS_CF_SetAirControl, "SetAirControl")});
+ //addCodeDataACS0(142, {"",        0, addCallFunc(ACS_CF_ClrInventory, "ClrInventory")});
+ //addCodeDataACS0(143, {"",        2, addCallFunc(ACS_CF_AddInventory, "AddInventory")});
+ //addCodeDataACS0(144, {"WSW",     0, addCallFunc(ACS_CF_AddInventory, "AddInventory")});
+   addCodeDataACS0(145, {"",        2, addCallFunc(ACS_CF_TakeInventory, "TakeInventory")});
+   addCodeDataACS0(146, {"WSW",     0, addCallFunc(ACS_CF_TakeInventory, "TakeInventory")});
+   addCodeDataACS0(147, {"",        1, addCallFunc(ACS_CF_CheckInventory, "CheckInventory")});
+   addCodeDataACS0(148, {"WS",      0, addCallFunc(ACS_CF_CheckInventory, "CheckInventory")});
+   addCodeDataACS0(149, {"",        6, addCallFunc(ACS_CF_Spawn, "Spawn")});
+   addCodeDataACS0(150, {"WSWWWWW", 0, addCallFunc(ACS_CF_Spawn, "Spawn")});
+   addCodeDataACS0(151, {"",        4, addCallFunc(ACS_CF_SpawnSpot, "SpawnSpot")});
+   addCodeDataACS0(152, {"WSWWW",   0, addCallFunc(ACS_CF_SpawnSpot, "SpawnSpot")});
+   addCodeDataACS0(153, {"",        3, addCallFunc(ACS_CF_SetMusic, "SetMusic")});
+   addCodeDataACS0(154, {"WSWW",    0, addCallFunc(ACS_CF_SetMusic, "SetMusic")});
+   addCodeDataACS0(155, {"",        3, addCallFunc(ACS_CF_LocalSetMusic, "LocalSetMusic")});
+   addCodeDataACS0(156, {"WSWW",    0, addCallFunc(ACS_CF_LocalSetMusic, "LocalSetMusic")});
    // 157-157: ACSVM internal codes.
- //addCodeDataACS0(158, {"",        1, addCallFunc(ACS_CF_PrintLocale)});
- //addCodeDataACS0(159, {"",        0, addCallFunc(ACS_CF_PrintHudMore)});
- //addCodeDataACS0(160, {"",        0, addCallFunc(ACS_CF_PrintHudOpt)});
- //addCodeDataACS0(161, {"",        0, addCallFunc(ACS_CF_PrintHudEnd)});
- //addCodeDataACS0(162, {"",        0, addCallFunc(ACS_CF_PrintHudEndB)});
+ //addCodeDataACS0(158, {"",        1, addCallFunc(ACS_CF_PrintLocale, "PrintLocale")});
+ //addCodeDataACS0(159, {"",        0, addCallFunc(ACS_CF_PrintHudMore, "PrintHudMore")});
+ //addCodeDataACS0(160, {"",        0, addCallFunc(ACS_CF_PrintHudOpt, "PrintHudOpt")});
+ //addCodeDataACS0(161, {"",        0, addCallFunc(ACS_CF_PrintHudEnd, "PrintHudEnd")});
+ //addCodeDataACS0(162, {"",        0, addCallFunc(ACS_CF_PrintHudEndB, "PrintHudEndB")});
    // 163-164: Unused codes.
- //addCodeDataACS0(165, {"",        1, addCallFunc(ACS_CF_SetFont)});
- //addCodeDataACS0(166, {"WS",      0, addCallFunc(ACS_CF_SetFont)});
+ //addCodeDataACS0(165, {"",        1, addCallFunc(ACS_CF_SetFont, "SetFont")});
+ //addCodeDataACS0(166, {"WS",      0, addCallFunc(ACS_CF_SetFont, "SetFont")});
    // 167-173: ACSVM internal codes.
-   addCodeDataACS0(174, {"BB",      0, addCallFunc(ACS_CF_Random)});
+   addCodeDataACS0(174, {"BB",      0, addCallFunc(ACS_CF_Random, "Random")});
    // 175-179: ACSVM internal codes.
-   addCodeDataACS0(180, {"",        7, addCallFunc(ACS_CF_SetThingSpecial)});
+   addCodeDataACS0(180, {"",        7, addCallFunc(ACS_CF_SetThingSpecial, "SetThingSpecial")});
    // 181-189: ACSVM internal codes.
- //addCodeDataACS0(190, {"",        5, addCallFunc(ACS_CF_FadeTo)});
- //addCodeDataACS0(191, {"",        9, addCallFunc(ACS_CF_FadeRange)});
- //addCodeDataACS0(192, {"",        0, addCallFunc(ACS_CF_FadeCancel)});
- //addCodeDataACS0(193, {"",        1, addCallFunc(ACS_CF_PlayMovie)});
- //addCodeDataACS0(194, {"",        8, addCallFunc(ACS_CF_SetFloorTrig)});
- //addCodeDataACS0(195, {"",        8, addCallFunc(ACS_CF_SetCeilTrig)});
-   addCodeDataACS0(196, {"",        1, addCallFunc(ACS_CF_GetActorX)});
-   addCodeDataACS0(197, {"",        1, addCallFunc(ACS_CF_GetActorY)});
-   addCodeDataACS0(198, {"",        1, addCallFunc(ACS_CF_GetActorZ)});
- //addCodeDataACS0(199, {"",        1, addCallFunc(ACS_CF_transStart)});
- //addCodeDataACS0(200, {"",        4, addCallFunc(ACS_CF_TransPalette)});
- //addCodeDataACS0(201, {"",        8, addCallFunc(ACS_CF_TransRGB)});
- //addCodeDataACS0(202, {"",        0, addCallFunc(ACS_CF_TransEnd)});
+ //addCodeDataACS0(190, {"",        5, addCallFunc(ACS_CF_FadeTo, "FadeTo")});
+ //addCodeDataACS0(191, {"",        9, addCallFunc(ACS_CF_FadeRange, "FadeRange")});
+ //addCodeDataACS0(192, {"",        0, addCallFunc(ACS_CF_FadeCancel, "FadeCancel")});
+ //addCodeDataACS0(193, {"",        1, addCallFunc(ACS_CF_PlayMovie, "PlayMovie")});
+ //addCodeDataACS0(194, {"",        8, addCallFunc(ACS_CF_SetFloorTrig, "SetFloorTrig")});
+ //addCodeDataACS0(195, {"",        8, addCallFunc(ACS_CF_SetCeilTrig, "SetCeilTrig")});
+   addCodeDataACS0(196, {"",        1, addCallFunc(ACS_CF_GetActorX, "GetActorX")});
+   addCodeDataACS0(197, {"",        1, addCallFunc(ACS_CF_GetActorY, "GetActorY")});
+   addCodeDataACS0(198, {"",        1, addCallFunc(ACS_CF_GetActorZ, "GetActorZ")});
+ //addCodeDataACS0(199, {"",        1, addCallFunc(ACS_CF_transStart, "transStart")});
+ //addCodeDataACS0(200, {"",        4, addCallFunc(ACS_CF_TransPalette, "TransPalette")});
+ //addCodeDataACS0(201, {"",        8, addCallFunc(ACS_CF_TransRGB, "TransRGB")});
+ //addCodeDataACS0(202, {"",        0, addCallFunc(ACS_CF_TransEnd, "TransEnd")});
    // 203-217: ACSVM internal codes.
    // 218-219: Unused codes.
-   addCodeDataACS0(220, {"",        1, addCallFunc(ACS_CF_Sin)});
-   addCodeDataACS0(221, {"",        1, addCallFunc(ACS_CF_Cos)});
-   addCodeDataACS0(222, {"",        2, addCallFunc(ACS_CF_VectorAngle)});
-   addCodeDataACS0(223, {"",        1, addCallFunc(ACS_CF_CheckWeapon)});
-   addCodeDataACS0(224, {"",        1, addCallFunc(ACS_CF_SetWeapon)});
+   addCodeDataACS0(220, {"",        1, addCallFunc(ACS_CF_Sin, "Sin")});
+   addCodeDataACS0(221, {"",        1, addCallFunc(ACS_CF_Cos, "Cos")});
+   addCodeDataACS0(222, {"",        2, addCallFunc(ACS_CF_VectorAngle, "VectorAngle")});
+   addCodeDataACS0(223, {"",        1, addCallFunc(ACS_CF_CheckWeapon, "CheckWeapon")});
+   addCodeDataACS0(224, {"",        1, addCallFunc(ACS_CF_SetWeapon, "SetWeapon")});
    // 225-243: ACSVM internal codes.
- //addCodeDataACS0(244, {"",        2, addCallFunc(ACS_CF_SetMarineWeapon)});
-   addCodeDataACS0(245, {"",        3, addCallFunc(ACS_CF_SetActorProperty)});
-   addCodeDataACS0(246, {"",        2, addCallFunc(ACS_CF_GetActorProperty)});
-   addCodeDataACS0(247, {"",        0, addCallFunc(ACS_CF_PlayerNumber)});
-   addCodeDataACS0(248, {"",        0, addCallFunc(ACS_CF_ActivatorTID)});
- //addCodeDataACS0(249, {"",        2, addCallFunc(ACS_CF_SetMarineSprite)});
-   addCodeDataACS0(250, {"",        0, addCallFunc(ACS_CF_GetScreenW)});
-   addCodeDataACS0(251, {"",        0, addCallFunc(ACS_CF_GetScreenH)});
-   addCodeDataACS0(252, {"",        7, addCallFunc(ACS_CF_Thing_Projectile2)});
+ //addCodeDataACS0(244, {"",        2, addCallFunc(ACS_CF_SetMarineWeapon, "SetMarineWeapon")});
+   addCodeDataACS0(245, {"",        3, addCallFunc(ACS_CF_SetActorProperty, "SetActorProperty")});
+   addCodeDataACS0(246, {"",        2, addCallFunc(ACS_CF_GetActorProperty, "GetActorProperty")});
+   addCodeDataACS0(247, {"",        0, addCallFunc(ACS_CF_PlayerNumber, "PlayerNumber")});
+   addCodeDataACS0(248, {"",        0, addCallFunc(ACS_CF_ActivatorTID, "ActivatorTID")});
+ //addCodeDataACS0(249, {"",        2, addCallFunc(ACS_CF_SetMarineSprite, "SetMarineSprite")});
+   addCodeDataACS0(250, {"",        0, addCallFunc(ACS_CF_GetScreenW, "GetScreenW")});
+   addCodeDataACS0(251, {"",        0, addCallFunc(ACS_CF_GetScreenH, "GetScreenH")});
+   addCodeDataACS0(252, {"",        7, addCallFunc(ACS_CF_Thing_Projectile2, "Thing_Projectile2")});
    // 253-253: ACSVM internal codes.
- //addCodeDataACS0(254, {"",        3, addCallFunc(ACS_CF_SetHudSize)});
-   addCodeDataACS0(255, {"",        1, addCallFunc(ACS_CF_GetCVar)});
+ //addCodeDataACS0(254, {"",        3, addCallFunc(ACS_CF_SetHudSize, "SetHudSize")});
+   addCodeDataACS0(255, {"",        1, addCallFunc(ACS_CF_GetCVar, "GetCVar")});
    // 256-257: ACSVM internal codes.
-   addCodeDataACS0(258, {"",        0, addCallFunc(ACS_CF_GetLineRowOffset)});
-   addCodeDataACS0(259, {"",        1, addCallFunc(ACS_CF_GetActorFloorZ)});
-   addCodeDataACS0(260, {"",        1, addCallFunc(ACS_CF_GetActorAngle)});
-   addCodeDataACS0(261, {"",        3, addCallFunc(ACS_CF_GetSectorFloorZ)});
-   addCodeDataACS0(262, {"",        3, addCallFunc(ACS_CF_GetSectorCeilingZ)});
+   addCodeDataACS0(258, {"",        0, addCallFunc(ACS_CF_GetLineRowOffset, "GetLineRowOffset")});
+   addCodeDataACS0(259, {"",        1, addCallFunc(ACS_CF_GetActorFloorZ, "GetActorFloorZ")});
+   addCodeDataACS0(260, {"",        1, addCallFunc(ACS_CF_GetActorAngle, "GetActorAngle")});
+   addCodeDataACS0(261, {"",        3, addCallFunc(ACS_CF_GetSectorFloorZ, "GetSectorFloorZ")});
+   addCodeDataACS0(262, {"",        3, addCallFunc(ACS_CF_GetSectorCeilingZ, "GetSectorCeilingZ")});
    // 263-263: ACSVM internal codes.
-   addCodeDataACS0(264, {"",        0, addCallFunc(ACS_CF_GetSigilPieces)});
-   addCodeDataACS0(265, {"",        1, addCallFunc(ACS_CF_GetLevelInfo)});
- //addCodeDataACS0(266, {"",        2, addCallFunc(ACS_CF_ChangeSky)});
- //addCodeDataACS0(267, {"",        1, addCallFunc(ACS_CF_PlayerInGame)});
- //addCodeDataACS0(268, {"",        1, addCallFunc(ACS_CF_PlayerIsBot)});
- //addCodeDataACS0(269, {"",        0, addCallFunc(ACS_CF_SetCameraTex)});
-   addCodeDataACS0(270, {"",        0, addCallFunc(ACS_CF_EndLog)});
- //addCodeDataACS0(271, {"",        1, addCallFunc(ACS_CF_GetAmmoCap)});
- //addCodeDataACS0(272, {"",        2, addCallFunc(ACS_CF_SetAmmoCap)});
+   addCodeDataACS0(264, {"",        0, addCallFunc(ACS_CF_GetSigilPieces, "GetSigilPieces")});
+   addCodeDataACS0(265, {"",        1, addCallFunc(ACS_CF_GetLevelInfo, "GetLevelInfo")});
+ //addCodeDataACS0(266, {"",        2, addCallFunc(ACS_CF_ChangeSky, "ChangeSky")});
+ //addCodeDataACS0(267, {"",        1, addCallFunc(ACS_CF_PlayerInGame, "PlayerInGame")});
+ //addCodeDataACS0(268, {"",        1, addCallFunc(ACS_CF_PlayerIsBot, "PlayerIsBot")});
+ //addCodeDataACS0(269, {"",        0, addCallFunc(ACS_CF_SetCameraTex, "SetCameraTex")});
+   addCodeDataACS0(270, {"",        0, addCallFunc(ACS_CF_EndLog, "EndLog")});
+ //addCodeDataACS0(271, {"",        1, addCallFunc(ACS_CF_GetAmmoCap, "GetAmmoCap")});
+ //addCodeDataACS0(272, {"",        2, addCallFunc(ACS_CF_SetAmmoCap, "SetAmmoCap")});
    // 273-275: ACSVM internal codes.
-   addCodeDataACS0(276, {"",        2, addCallFunc(ACS_CF_SetActorAngle)});
+   addCodeDataACS0(276, {"",        2, addCallFunc(ACS_CF_SetActorAngle, "SetActorAngle")});
    // 277-279: Unused codes.
-   addCodeDataACS0(280, {"",        7, addCallFunc(ACS_CF_SpawnProjectile)});
-   addCodeDataACS0(281, {"",        1, addCallFunc(ACS_CF_GetSectorLightLevel)});
-   addCodeDataACS0(282, {"",        1, addCallFunc(ACS_CF_GetActorCeilingZ)});
-   addCodeDataACS0(283, {"",        5, addCallFunc(ACS_CF_SetActorPosition)});
- //addCodeDataACS0(284, {"",        1, addCallFunc(ACS_CF_ClrThingInv)});
- //addCodeDataACS0(285, {"",        3, addCallFunc(ACS_CF_AddThingInv)});
- //addCodeDataACS0(286, {"",        3, addCallFunc(ACS_CF_SubThingInv)});
- //addCodeDataACS0(287, {"",        2, addCallFunc(ACS_CF_GetThingInv)});
-   addCodeDataACS0(288, {"",        2, addCallFunc(ACS_CF_ThingCountName)});
-   addCodeDataACS0(289, {"",        3, addCallFunc(ACS_CF_SpawnSpotFacing)});
- //addCodeDataACS0(290, {"",        1, addCallFunc(ACS_CF_PlayerClass)});
+   addCodeDataACS0(280, {"",        7, addCallFunc(ACS_CF_SpawnProjectile, "SpawnProjectile")});
+   addCodeDataACS0(281, {"",        1, addCallFunc(ACS_CF_GetSectorLightLevel, "GetSectorLightLevel")});
+   addCodeDataACS0(282, {"",        1, addCallFunc(ACS_CF_GetActorCeilingZ, "GetActorCeilingZ")});
+   addCodeDataACS0(283, {"",        5, addCallFunc(ACS_CF_SetActorPosition, "SetActorPosition")});
+ //addCodeDataACS0(284, {"",        1, addCallFunc(ACS_CF_ClrThingInv, "ClrThingInv")});
+ //addCodeDataACS0(285, {"",        3, addCallFunc(ACS_CF_AddThingInv, "AddThingInv")});
+ //addCodeDataACS0(286, {"",        3, addCallFunc(ACS_CF_SubThingInv, "SubThingInv")});
+ //addCodeDataACS0(287, {"",        2, addCallFunc(ACS_CF_GetThingInv, "GetThingInv")});
+   addCodeDataACS0(288, {"",        2, addCallFunc(ACS_CF_ThingCountName, "ThingCountName")});
+   addCodeDataACS0(289, {"",        3, addCallFunc(ACS_CF_SpawnSpotFacing, "SpawnSpotFacing")});
+ //addCodeDataACS0(290, {"",        1, addCallFunc(ACS_CF_PlayerClass, "PlayerClass")});
    // 291-325: ACSVM internal codes.
- //addCodeDataACS0(326, {"",        2, addCallFunc(ACS_CF_GetPlayerProp)});
- //addCodeDataACS0(327, {"",        4, addCallFunc(ACS_CF_ChangeLevel)});
-   addCodeDataACS0(328, {"",        5, addCallFunc(ACS_CF_SectorDamage)});
-   addCodeDataACS0(329, {"",        3, addCallFunc(ACS_CF_ReplaceTextures)});
+ //addCodeDataACS0(326, {"",        2, addCallFunc(ACS_CF_GetPlayerProp, "GetPlayerProp")});
+ //addCodeDataACS0(327, {"",        4, addCallFunc(ACS_CF_ChangeLevel, "ChangeLevel")});
+   addCodeDataACS0(328, {"",        5, addCallFunc(ACS_CF_SectorDamage, "SectorDamage")});
+   addCodeDataACS0(329, {"",        3, addCallFunc(ACS_CF_ReplaceTextures, "ReplaceTextures")});
    // 330-330: ACSVM internal codes.
-   addCodeDataACS0(331, {"",        1, addCallFunc(ACS_CF_GetActorPitch)});
-   addCodeDataACS0(332, {"",        2, addCallFunc(ACS_CF_SetActorPitch)});
- //addCodeDataACS0(333, {"",        1, addCallFunc(ACS_CF_PrintBind)});
-   addCodeDataACS0(334, {"",        3, addCallFunc(ACS_CF_SetActorState)});
-   addCodeDataACS0(335, {"",        3, addCallFunc(ACS_CF_Thing_Damage2)});
- //addCodeDataACS0(336, {"",        1, addCallFunc(ACS_CF_UseInventory)});
- //addCodeDataACS0(337, {"",        2, addCallFunc(ACS_CF_UseThingInv)});
-   addCodeDataACS0(338, {"",        2, addCallFunc(ACS_CF_CheckActorCeilingTexture)});
-   addCodeDataACS0(339, {"",        2, addCallFunc(ACS_CF_CheckActorFloorTexture)});
-   addCodeDataACS0(340, {"",        1, addCallFunc(ACS_CF_GetActorLightLevel)});
- //addCodeDataACS0(341, {"",        1, addCallFunc(ACS_CF_SetMugState)});
-   addCodeDataACS0(342, {"",        3, addCallFunc(ACS_CF_ThingCountSector)});
-   addCodeDataACS0(343, {"",        3, addCallFunc(ACS_CF_ThingCountNameSector)});
- //addCodeDataACS0(344, {"",        1, addCallFunc(ACS_CF_GetPlayerCam)});
- //addCodeDataACS0(345, {"",        7, addCallFunc(ACS_CF_MorphThing)});
- //addCodeDataACS0(346, {"",        2, addCallFunc(ACS_CF_UnmorphThing)});
-   addCodeDataACS0(347, {"",        2, addCallFunc(ACS_CF_GetPlayerInput)});
-   addCodeDataACS0(348, {"",        1, addCallFunc(ACS_CF_ClassifyActor)});
+   addCodeDataACS0(331, {"",        1, addCallFunc(ACS_CF_GetActorPitch, "GetActorPitch")});
+   addCodeDataACS0(332, {"",        2, addCallFunc(ACS_CF_SetActorPitch, "SetActorPitch")});
+ //addCodeDataACS0(333, {"",        1, addCallFunc(ACS_CF_PrintBind, "PrintBind")});
+   addCodeDataACS0(334, {"",        3, addCallFunc(ACS_CF_SetActorState, "SetActorState")});
+   addCodeDataACS0(335, {"",        3, addCallFunc(ACS_CF_Thing_Damage2, "Thing_Damage2")});
+ //addCodeDataACS0(336, {"",        1, addCallFunc(ACS_CF_UseInventory, "UseInventory")});
+ //addCodeDataACS0(337, {"",        2, addCallFunc(ACS_CF_UseThingInv, "UseThingInv")});
+   addCodeDataACS0(338, {"",        2, addCallFunc(ACS_CF_CheckActorCeilingTexture, "CheckActorCeilingTexture")});
+   addCodeDataACS0(339, {"",        2, addCallFunc(ACS_CF_CheckActorFloorTexture, "CheckActorFloorTexture")});
+   addCodeDataACS0(340, {"",        1, addCallFunc(ACS_CF_GetActorLightLevel, "GetActorLightLevel")});
+ //addCodeDataACS0(341, {"",        1, addCallFunc(ACS_CF_SetMugState, "SetMugState")});
+   addCodeDataACS0(342, {"",        3, addCallFunc(ACS_CF_ThingCountSector, "ThingCountSector")});
+   addCodeDataACS0(343, {"",        3, addCallFunc(ACS_CF_ThingCountNameSector, "ThingCountNameSector")});
+ //addCodeDataACS0(344, {"",        1, addCallFunc(ACS_CF_GetPlayerCam, "GetPlayerCam")});
+ //addCodeDataACS0(345, {"",        7, addCallFunc(ACS_CF_MorphThing, "MorphThing")});
+ //addCodeDataACS0(346, {"",        2, addCallFunc(ACS_CF_UnmorphThing, "UnmorphThing")});
+   addCodeDataACS0(347, {"",        2, addCallFunc(ACS_CF_GetPlayerInput, "GetPlayerInput")});
+   addCodeDataACS0(348, {"",        1, addCallFunc(ACS_CF_ClassifyActor, "ClassifyActor")});
    // 349-361: ACSVM internal codes.
- //addCodeDataACS0(362, {"",        8, addCallFunc(ACS_CF_TransDesat)});
+ //addCodeDataACS0(362, {"",        8, addCallFunc(ACS_CF_TransDesat, "TransDesat")});
    // 363-380: ACSVM internal codes.
 
    // Add func translations.
 
    // 0-0: ACSVM interal funcs.
- //addFuncDataACS0(  1, addCallFunc(ACS_CF_GetLineUDMFInt));
- //addFuncDataACS0(  2, addCallFunc(ACS_CF_GetLineUDMFFixed));
- //addFuncDataACS0(  3, addCallFunc(ACS_CF_GetThingUDMFInt));
- //addFuncDataACS0(  4, addCallFunc(ACS_CF_GetThingUDMFFixed));
- //addFuncDataACS0(  5, addCallFunc(ACS_CF_GetSectorUDMFInt));
- //addFuncDataACS0(  6, addCallFunc(ACS_CF_GetSectorUDMFFixed));
- //addFuncDataACS0(  7, addCallFunc(ACS_CF_GetSideUDMFInt));
- //addFuncDataACS0(  8, addCallFunc(ACS_CF_GetSideUDMFFixed));
-   addFuncDataACS0(  9, addCallFunc(ACS_CF_GetActorVelX));
-   addFuncDataACS0( 10, addCallFunc(ACS_CF_GetActorVelY));
-   addFuncDataACS0( 11, addCallFunc(ACS_CF_GetActorVelZ));
-   addFuncDataACS0( 12, addCallFunc(ACS_CF_SetActivator));
-   addFuncDataACS0( 13, addCallFunc(ACS_CF_SetActivatorToTarget));
- //addFuncDataACS0( 14, addCallFunc(ACS_CF_GetThingViewHeight));
+ //addFuncDataACS0(  1, addCallFunc(ACS_CF_GetLineUDMFInt, "GetLineUDMFInt"));
+ //addFuncDataACS0(  2, addCallFunc(ACS_CF_GetLineUDMFFixed, "GetLineUDMFFixed"));
+ //addFuncDataACS0(  3, addCallFunc(ACS_CF_GetThingUDMFInt, "GetThingUDMFInt"));
+ //addFuncDataACS0(  4, addCallFunc(ACS_CF_GetThingUDMFFixed, "GetThingUDMFFixed"));
+ //addFuncDataACS0(  5, addCallFunc(ACS_CF_GetSectorUDMFInt, "GetSectorUDMFInt"));
+ //addFuncDataACS0(  6, addCallFunc(ACS_CF_GetSectorUDMFFixed, "GetSectorUDMFFixed"));
+ //addFuncDataACS0(  7, addCallFunc(ACS_CF_GetSideUDMFInt, "GetSideUDMFInt"));
+ //addFuncDataACS0(  8, addCallFunc(ACS_CF_GetSideUDMFFixed, "GetSideUDMFFixed"));
+   addFuncDataACS0(  9, addCallFunc(ACS_CF_GetActorVelX, "GetActorVelX"));
+   addFuncDataACS0( 10, addCallFunc(ACS_CF_GetActorVelY, "GetActorVelY"));
+   addFuncDataACS0( 11, addCallFunc(ACS_CF_GetActorVelZ, "GetActorVelZ"));
+   addFuncDataACS0( 12, addCallFunc(ACS_CF_SetActivator, "SetActivator"));
+   addFuncDataACS0( 13, addCallFunc(ACS_CF_SetActivatorToTarget, "SetActivatorToTarget"));
+ //addFuncDataACS0( 14, addCallFunc(ACS_CF_GetThingViewHeight, "GetThingViewHeight"));
    // 15-15: ACSVM internal funcs.
- //addFuncDataACS0( 16, addCallFunc(ACS_CF_GetPlayerAir));
- //addFuncDataACS0( 17, addCallFunc(ACS_CF_SetPlayerAir));
-   addFuncDataACS0( 18, addCallFunc(ACS_CF_SetSkyScrollSpeed));
- //addFuncDataACS0( 19, addCallFunc(ACS_CF_GetPlayerArmor));
-   addFuncDataACS0( 20, addCallFunc(ACS_CF_SpawnSpotForced));
-   addFuncDataACS0( 21, addCallFunc(ACS_CF_SpawnSpotFacingForced));
-   addFuncDataACS0( 22, addCallFunc(ACS_CF_CheckActorProperty));
-   addFuncDataACS0( 23, addCallFunc(ACS_CF_SetActorVelocity));
- //addFuncDataACS0( 24, addCallFunc(ACS_CF_SetThingUserVar));
- //addFuncDataACS0( 25, addCallFunc(ACS_CF_GetThingUserVar));
-   addFuncDataACS0( 26, addCallFunc(ACS_CF_Radius_Quake2));
-   addFuncDataACS0( 27, addCallFunc(ACS_CF_CheckActorClass));
- //addFuncDataACS0( 28, addCallFunc(ACS_CF_SetThingUserArr));
- //addFuncDataACS0( 29, addCallFunc(ACS_CF_GetThingUserArr));
-   addFuncDataACS0( 30, addCallFunc(ACS_CF_SoundSequenceOnActor));
- //addFuncDataACS0( 31, addCallFunc(ACS_CF_SectorSoundSeq));
- //addFuncDataACS0( 32, addCallFunc(ACS_CF_PolyojbSoundSeq));
-   addFuncDataACS0( 33, addCallFunc(ACS_CF_GetPolyobjX));
-   addFuncDataACS0( 34, addCallFunc(ACS_CF_GetPolyobjY));
-   addFuncDataACS0( 35, addCallFunc(ACS_CF_CheckSight));
-   addFuncDataACS0( 36, addCallFunc(ACS_CF_SpawnForced));
- //addFuncDataACS0( 37, addCallFunc(ACS_CF_AnnouncerSound));
- //addFuncDataACS0( 38, addCallFunc(ACS_CF_SetPointer));
+ //addFuncDataACS0( 16, addCallFunc(ACS_CF_GetPlayerAir, "GetPlayerAir"));
+ //addFuncDataACS0( 17, addCallFunc(ACS_CF_SetPlayerAir, "SetPlayerAir"));
+   addFuncDataACS0( 18, addCallFunc(ACS_CF_SetSkyScrollSpeed, "SetSkyScrollSpeed"));
+ //addFuncDataACS0( 19, addCallFunc(ACS_CF_GetPlayerArmor, "GetPlayerArmor"));
+   addFuncDataACS0( 20, addCallFunc(ACS_CF_SpawnSpotForced, "SpawnSpotForced"));
+   addFuncDataACS0( 21, addCallFunc(ACS_CF_SpawnSpotFacingForced, "SpawnSpotFacingForced"));
+   addFuncDataACS0( 22, addCallFunc(ACS_CF_CheckActorProperty, "CheckActorProperty"));
+   addFuncDataACS0( 23, addCallFunc(ACS_CF_SetActorVelocity, "SetActorVelocity"));
+ //addFuncDataACS0( 24, addCallFunc(ACS_CF_SetThingUserVar, "SetThingUserVar"));
+ //addFuncDataACS0( 25, addCallFunc(ACS_CF_GetThingUserVar, "GetThingUserVar"));
+   addFuncDataACS0( 26, addCallFunc(ACS_CF_Radius_Quake2, "Radius_Quake2"));
+   addFuncDataACS0( 27, addCallFunc(ACS_CF_CheckActorClass, "CheckActorClass"));
+ //addFuncDataACS0( 28, addCallFunc(ACS_CF_SetThingUserArr, "SetThingUserArr"));
+ //addFuncDataACS0( 29, addCallFunc(ACS_CF_GetThingUserArr, "GetThingUserArr"));
+   addFuncDataACS0( 30, addCallFunc(ACS_CF_SoundSequenceOnActor, "SoundSequenceOnActor"));
+ //addFuncDataACS0( 31, addCallFunc(ACS_CF_SectorSoundSeq, "SectorSoundSeq"));
+ //addFuncDataACS0( 32, addCallFunc(ACS_CF_PolyojbSoundSeq, "PolyojbSoundSeq"));
+   addFuncDataACS0( 33, addCallFunc(ACS_CF_GetPolyobjX, "GetPolyobjX"));
+   addFuncDataACS0( 34, addCallFunc(ACS_CF_GetPolyobjY, "GetPolyobjY"));
+   addFuncDataACS0( 35, addCallFunc(ACS_CF_CheckSight, "CheckSight"));
+   addFuncDataACS0( 36, addCallFunc(ACS_CF_SpawnForced, "SpawnForced"));
+ //addFuncDataACS0( 37, addCallFunc(ACS_CF_AnnouncerSound, "AnnouncerSound"));
+ //addFuncDataACS0( 38, addCallFunc(ACS_CF_SetPointer, "SetPointer"));
    // 39-45: ACSVM internal funcs.
-   addFuncDataACS0( 46, addCallFunc(ACS_CF_UniqueTID));
-   addFuncDataACS0( 47, addCallFunc(ACS_CF_IsTIDUsed));
-   addFuncDataACS0( 48, addCallFunc(ACS_CF_Sqrt));
-   addFuncDataACS0( 49, addCallFunc(ACS_CF_FixedSqrt));
-   addFuncDataACS0( 50, addCallFunc(ACS_CF_VectorLength));
- //addFuncDataACS0( 51, addCallFunc(ACS_CF_SetHudClipRect));
- //addFuncDataACS0( 52, addCallFunc(ACS_CF_SetHudWrapWidth));
- //addFuncDataACS0( 53, addCallFunc(ACS_CF_SetCVar));
- //addFuncDataACS0( 54, addCallFunc(ACS_CF_GetUserCVar));
- //addFuncDataACS0( 55, addCallFunc(ACS_CF_SetUserCVar));
-   addFuncDataACS0( 56, addCallFunc(ACS_CF_GetCVarString));
- //addFuncDataACS0( 57, addCallFunc(ACS_CF_SetCVarString));
- //addFuncDataACS0( 58, addCallFunc(ACS_CF_GetUserCVarString));
- //addFuncDataACS0( 59, addCallFunc(ACS_CF_SetUserCVarString));
- //addFuncDataACS0( 60, addCallFunc(ACS_CF_LineAttack));
-   addFuncDataACS0( 61, addCallFunc(ACS_CF_PlaySound));
-   addFuncDataACS0( 62, addCallFunc(ACS_CF_StopSound));
+   addFuncDataACS0( 46, addCallFunc(ACS_CF_UniqueTID, "UniqueTID"));
+   addFuncDataACS0( 47, addCallFunc(ACS_CF_IsTIDUsed, "IsTIDUsed"));
+   addFuncDataACS0( 48, addCallFunc(ACS_CF_Sqrt, "Sqrt"));
+   addFuncDataACS0( 49, addCallFunc(ACS_CF_FixedSqrt, "FixedSqrt"));
+   addFuncDataACS0( 50, addCallFunc(ACS_CF_VectorLength, "VectorLength"));
+ //addFuncDataACS0( 51, addCallFunc(ACS_CF_SetHudClipRect, "SetHudClipRect"));
+ //addFuncDataACS0( 52, addCallFunc(ACS_CF_SetHudWrapWidth, "SetHudWrapWidth"));
+ //addFuncDataACS0( 53, addCallFunc(ACS_CF_SetCVar, "SetCVar"));
+ //addFuncDataACS0( 54, addCallFunc(ACS_CF_GetUserCVar, "GetUserCVar"));
+ //addFuncDataACS0( 55, addCallFunc(ACS_CF_SetUserCVar, "SetUserCVar"));
+   addFuncDataACS0( 56, addCallFunc(ACS_CF_GetCVarString, "GetCVarString"));
+ //addFuncDataACS0( 57, addCallFunc(ACS_CF_SetCVarString, "SetCVarString"));
+ //addFuncDataACS0( 58, addCallFunc(ACS_CF_GetUserCVarString, "GetUserCVarString"));
+ //addFuncDataACS0( 59, addCallFunc(ACS_CF_SetUserCVarString, "SetUserCVarString"));
+ //addFuncDataACS0( 60, addCallFunc(ACS_CF_LineAttack, "LineAttack"));
+   addFuncDataACS0( 61, addCallFunc(ACS_CF_PlaySound, "PlaySound"));
+   addFuncDataACS0( 62, addCallFunc(ACS_CF_StopSound, "StopSound"));
    // 63-67: ACSVM internal funcs.
- //addFuncDataACS0( 68, addCallFunc(ACS_CF_GetThingType));
-   addFuncDataACS0( 69, addCallFunc(ACS_CF_GetWeapon));
- //addFuncDataACS0( 70, addCallFunc(ACS_CF_SoundVolume));
-   addFuncDataACS0( 71, addCallFunc(ACS_CF_PlayActorSound));
- //addFuncDataACS0( 72, addCallFunc(ACS_CF_SpawnDecal));
- //addFuncDataACS0( 73, addCallFunc(ACS_CF_CheckFont));
- //addFuncDataACS0( 74, addCallFunc(ACS_CF_DropItem));
-   addFuncDataACS0( 75, addCallFunc(ACS_CF_CheckFlag));
- //addFuncDataACS0( 76, addCallFunc(ACS_CF_SetLineActivation));
- //addFuncDataACS0( 77, addCallFunc(ACS_CF_GetLineActivation));
- //addFuncDataACS0( 78, addCallFunc(ACS_CF_GetThingPowerupTics));
-   addFuncDataACS0( 79, addCallFunc(ACS_CF_ChangeActorAngle));
-   addFuncDataACS0( 80, addCallFunc(ACS_CF_ChangeActorPitch));
- //addFuncDataACS0( 81, addCallFunc(ACS_CF_GetArmorInfo));
- //addFuncDataACS0( 82, addCallFunc(ACS_CF_DropInventory));
- //addFuncDataACS0( 83, addCallFunc(ACS_CF_PickThing));
- //addFuncDataACS0( 84, addCallFunc(ACS_CF_IsPointerEqual));
- //addFuncDataACS0( 85, addCallFunc(ACS_CF_CanRaiseThing));
- //addFuncDataACS0( 86, addCallFunc(ACS_CF_SetThingTeleFog));
- //addFuncDataACS0( 87, addCallFunc(ACS_CF_SwapThingTeleFog));
- //addFuncDataACS0( 88, addCallFunc(ACS_CF_SetThingRoll));
- //addFuncDataACS0( 89, addCallFunc(ACS_CF_SetThingRoll));
- //addFuncDataACS0( 90, addCallFunc(ACS_CF_GetThingRoll));
- //addFuncDataACS0( 91, addCallFunc(ACS_CF_QuakeEx));
- //addFuncDataACS0( 92, addCallFunc(ACS_CF_Warp));
- //addFuncDataACS0( 93, addCallFunc(ACS_CF_GetMaxInventory));
-   addFuncDataACS0( 94, addCallFunc(ACS_CF_SetSectorDamage));
- //addFuncDataACS0( 95, addCallFunc(ACS_CF_SetSectorTerrain));
- //addFuncDataACS0( 96, addCallFunc(ACS_CF_SpawnParticle));
- //addFuncDataACS0( 97, addCallFunc(ACS_CF_SetMusicVolume));
-   addFuncDataACS0( 98, addCallFunc(ACS_CF_CheckProximity));
- //addFuncDataACS0( 99, addCallFunc(ACS_CF_CheckActorState));
-
-   addFuncDataACS0(300, addCallFunc(ACS_CF_GetLineX));
-   addFuncDataACS0(301, addCallFunc(ACS_CF_GetLineY));
-   addFuncDataACS0(302, addCallFunc(ACS_CF_SetAirFriction));
+ //addFuncDataACS0( 68, addCallFunc(ACS_CF_GetThingType, "GetThingType"));
+   addFuncDataACS0( 69, addCallFunc(ACS_CF_GetWeapon, "GetWeapon"));
+ //addFuncDataACS0( 70, addCallFunc(ACS_CF_SoundVolume, "SoundVolume"));
+   addFuncDataACS0( 71, addCallFunc(ACS_CF_PlayActorSound, "PlayActorSound"));
+ //addFuncDataACS0( 72, addCallFunc(ACS_CF_SpawnDecal, "SpawnDecal"));
+ //addFuncDataACS0( 73, addCallFunc(ACS_CF_CheckFont, "CheckFont"));
+ //addFuncDataACS0( 74, addCallFunc(ACS_CF_DropItem, "DropItem"));
+   addFuncDataACS0( 75, addCallFunc(ACS_CF_CheckFlag, "CheckFlag"));
+ //addFuncDataACS0( 76, addCallFunc(ACS_CF_SetLineActivation, "SetLineActivation"));
+ //addFuncDataACS0( 77, addCallFunc(ACS_CF_GetLineActivation, "GetLineActivation"));
+ //addFuncDataACS0( 78, addCallFunc(ACS_CF_GetThingPowerupTics, "GetThingPowerupTics"));
+   addFuncDataACS0( 79, addCallFunc(ACS_CF_ChangeActorAngle, "ChangeActorAngle"));
+   addFuncDataACS0( 80, addCallFunc(ACS_CF_ChangeActorPitch, "ChangeActorPitch"));
+ //addFuncDataACS0( 81, addCallFunc(ACS_CF_GetArmorInfo, "GetArmorInfo"));
+ //addFuncDataACS0( 82, addCallFunc(ACS_CF_DropInventory, "DropInventory"));
+ //addFuncDataACS0( 83, addCallFunc(ACS_CF_PickThing, "PickThing"));
+ //addFuncDataACS0( 84, addCallFunc(ACS_CF_IsPointerEqual, "IsPointerEqual"));
+ //addFuncDataACS0( 85, addCallFunc(ACS_CF_CanRaiseThing, "CanRaiseThing"));
+ //addFuncDataACS0( 86, addCallFunc(ACS_CF_SetThingTeleFog, "SetThingTeleFog"));
+ //addFuncDataACS0( 87, addCallFunc(ACS_CF_SwapThingTeleFog, "SwapThingTeleFog"));
+ //addFuncDataACS0( 88, addCallFunc(ACS_CF_SetThingRoll, "SetThingRoll"));
+ //addFuncDataACS0( 89, addCallFunc(ACS_CF_SetThingRoll, "SetThingRoll"));
+ //addFuncDataACS0( 90, addCallFunc(ACS_CF_GetThingRoll, "GetThingRoll"));
+ //addFuncDataACS0( 91, addCallFunc(ACS_CF_QuakeEx, "QuakeEx"));
+ //addFuncDataACS0( 92, addCallFunc(ACS_CF_Warp, "Warp"));
+ //addFuncDataACS0( 93, addCallFunc(ACS_CF_GetMaxInventory, "GetMaxInventory"));
+   addFuncDataACS0( 94, addCallFunc(ACS_CF_SetSectorDamage, "SetSectorDamage"));
+ //addFuncDataACS0( 95, addCallFunc(ACS_CF_SetSectorTerrain, "SetSectorTerrain"));
+ //addFuncDataACS0( 96, addCallFunc(ACS_CF_SpawnParticle, "SpawnParticle"));
+ //addFuncDataACS0( 97, addCallFunc(ACS_CF_SetMusicVolume, "SetMusicVolume"));
+   addFuncDataACS0( 98, addCallFunc(ACS_CF_CheckProximity, "CheckProximity"));
+ //addFuncDataACS0( 99, addCallFunc(ACS_CF_CheckActorState, "CheckActorState"));
+
+   addFuncDataACS0(300, addCallFunc(ACS_CF_GetLineX, "GetLineX"));
+   addFuncDataACS0(301, addCallFunc(ACS_CF_GetLineY, "GetLineY"));
+   addFuncDataACS0(302, addCallFunc(ACS_CF_SetAirFriction, "SetAirFriction"));
+}
+
+//
+// ACSEnvironment::addCallFunc
+//
+// Registers a CallFunc under the name the profiler reports it by.
+//
+ACSVM::Word ACSEnvironment::addCallFunc(ACSVM::CallFunc func, const char *name)
+{
+   const ACSVM::Word idx = ACSVM::Environment::addCallFunc(func);
+
+   if(callFuncNames.size() <= idx)
+      callFuncNames.resize(idx + 1);
+   callFuncNames[idx] = name;
+
+   return idx;
 }
 
 //
@@ -383,6 +405,18 @@ ACSVM::Thread *ACSEnvironment::allocThread()
    return new ACSThread(this);
 }
 
+//
+// ACSEnvironment::callFunc
+//
+bool ACSEnvironment::callFunc(ACSVM::Thread *thread, ACSVM::Word func,
+                              const ACSVM::Word *argV, ACSVM::Word argC)
+{
+   if(acs_profiling)
+      return ACS_ProfileCallFunc(thread, func, argV, argC);
+
+   return ACSVM::Environment::callFunc(thread, func, argV, argC);
+}
+
 //
 // ACSEnvironment::callSpecImpl
 //
@@ -522,6 +556,17 @@ void ACSEnvironment::refStrings()
    ACSVM::Environment::refStrings();
 }
 
+//
+// ACSThread::exec
+//
+void ACSThread::exec()
+{
+   if(acs_profiling)
+      ACS_ProfileExec(this);
+   else
+      ACSVM::Thread::exec();
+}
+
 //
 // ACSThread::loadState
 //
@@ -529,6 +574,8 @@ void ACSThread::loadState(ACSVM::Serial &in)
 {
    ACSVM::Thread::loadState(in);
 
+   profscript = nullptr;
+
    info.mo = static_cast<Mobj *>(P_ThinkerForNum(static_cast<unsigned>(ACSVM::ReadVLN<size_t>(in))));
 
    size_t linenum = ACSVM::ReadVLN<size_t>(in);
@@ -565,7 +612,8 @@ void ACSThread::start(ACSVM::Script *script, ACSVM::MapScope *map,
 {
    ACSVM::Thread::start(script, map, infoPtr, argV, argC);
 
-   result = 1;
+   result     = 1;
+   profscript = nullptr;
 
    if(infoPtr)
       info = *static_cast<const ACSThreadInfo *>(infoPtr);
@@ -692,6 +740,10 @@ void ACS_LoadLevelScript(WadDirectory *dir, int lump)
    ACSenv.map->active = true;
 
    // Load modules for map.
+   // Modules stay resident in ACSenv keyed by their ModuleName (lump name,
+   // directory and lump number), already translated and linked, so a library
+   // shared by every map is only read the first time. What is rebuilt here is
+   // the per-map state: the MapScope and its ModuleScopes.
    // TODO: Only do this if not revisiting the map.
 
    ACSenv.errors = 0;
@@ -750,12 +802,115 @@ void ACS_LoadLevelScript(WadDirectory *dir, int lump)
    }
 }
 
+//
+// String collection
+//
+// Strings built at run time (StrParam and the like) stay in the table until
+// collected. A collection starts once the table has doubled since the last
+// one finished, and is then run acs_stringbudget units a tic: one unit per
+// string cleared or swept, or per array element marked.
+//
+
+int acs_stringbudget = 16384;
+
+static size_t acs_stringthreshold = 1024; // table size that starts a collection
+
+static struct
+{
+   uint64_t cycles;
+   uint64_t steps;
+   uint64_t freed;
+   int64_t  ns;        // total time spent collecting
+   int64_t  maxstepns; // slowest single step
+   int64_t  cyclens;   // time spent on the collection under way
+   int64_t  lastns;    // time spent on the last finished collection
+   size_t   live;      // table size after the last collection
+   size_t   startsize; // table size when the current collection started
+} acsstringstats;
+
+//
+// Does this tic's share of string collection.
+//
+static void ACS_collectStrings()
+{
+   auto &stats = acsstringstats;
+   const size_t size = ACSenv.stringTable.size();
+
+   if(!acs_stringbudget)
+      return;
+
+   if(!ACSenv.isCollectingStrings())
+   {
+      if(size < acs_stringthreshold)
+         return;
+
+      stats.startsize = size;
+      stats.cyclens   = 0;
+   }
+
+   const auto start = std::chrono::steady_clock::now();
+   const bool done  = ACSenv.collectStringsStep(static_cast<size_t>(acs_stringbudget));
+   const int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - start).count();
+
+   ++stats.steps;
+   stats.ns        += ns;
+   stats.cyclens   += ns;
+   stats.maxstepns  = emax(stats.maxstepns, ns);
+
+   if(done)
+   {
+      const size_t live = ACSenv.stringTable.size();
+
+      ++stats.cycles;
+      // Strings made during the collection are counted as well, so this can
+      // fall short but never overshoot.
+      stats.freed  += stats.startsize > live ? stats.startsize - live : 0;
+      stats.lastns  = stats.cyclens;
+      stats.live    = live;
+
+      acs_stringthreshold = emax<size_t>(live * 2, 1024);
+   }
+}
+
+VARIABLE_INT(acs_stringbudget, nullptr, 0, 1 << 20, nullptr);
+CONSOLE_VARIABLE(acs_stringbudget, acs_stringbudget, 0) {}
+
+CONSOLE_COMMAND(acs_stringstats, 0)
+{
+   auto &stats = acsstringstats;
+
+   if(Console.argc >= 1 && !Console.argv[0]->strCaseCmp("reset"))
+   {
+      const size_t live = stats.live;
+
+      stats = {};
+      stats.live = live;
+      C_Printf("ACS string stats reset.\n");
+      return;
+   }
+
+   C_Printf(FC_HI "ACS strings:" FC_NORMAL " %zu in table, %zu after last collection, "
+            "next collection at %zu%s\n", ACSenv.stringTable.size(), stats.live,
+            acs_stringthreshold, ACSenv.isCollectingStrings() ? " (collecting)" : "");
+   C_Printf(FC_HI "Collections:" FC_NORMAL " %llu in %llu steps, %llu strings freed\n",
+            static_cast<unsigned long long>(stats.cycles),
+            static_cast<unsigned long long>(stats.steps),
+            static_cast<unsigned long long>(stats.freed));
+   C_Printf(FC_HI "Time:" FC_NORMAL " %.2f ms total, %.2f ms last collection, "
+            "%.1f us per step, %.1f us slowest step\n", stats.ns / 1e6, stats.lastns / 1e6,
+            stats.steps ? stats.ns / 1e3 / stats.steps : 0.0, stats.maxstepns / 1e3);
+   C_Printf(FC_HI "Budget:" FC_NORMAL " %d units per tic%s\n", acs_stringbudget,
+            acs_stringbudget ? "" : " (collection off)");
+}
+
 //
 // ACS_Exec
 //
 void ACS_Exec()
 {
    ACSenv.exec();
+   ACS_collectStrings();
 }
 
 //
@@ -796,7 +951,16 @@ uint32_t ACS_ExecuteScriptIResult(uint32_t name, const uint32_t *argv,
 bool ACS_ExecuteScriptS(const char *str, uint32_t mapnum, const uint32_t *argv,
                         uint32_t argc, Mobj *mo, line_t *line, int side, polyobj_t *po)
 {
-   ACSVM::String *name = ACSenv.getString(str, strlen(str));
+   return ACS_ExecuteScriptS(ACSenv.getString(str, strlen(str)), mapnum, argv, argc,
+                             mo, line, side, po);
+}
+
+//
+// ACS_ExecuteScriptS
+//
+bool ACS_ExecuteScriptS(ACSVM::String *name, uint32_t mapnum, const uint32_t *argv,
+                        uint32_t argc, Mobj *mo, line_t *line, int side, polyobj_t *po)
+{
    ACSVM::ScopeID scope{ACSenv.global->id, ACSenv.hub->id, mapnum ? mapnum : gamemap};
    ACSThreadInfo  info{mo, line, side, po};
    return ACSenv.map->scriptStart(name, scope, {argv, argc, &info});
@@ -808,7 +972,16 @@ bool ACS_ExecuteScriptS(const char *str, uint32_t mapnum, const uint32_t *argv,
 bool ACS_ExecuteScriptSAlways(const char *str, uint32_t mapnum, const uint32_t *argv,
                               uint32_t argc, Mobj *mo, line_t *line, int side, polyobj_t *po)
 {
-   ACSVM::String *name = ACSenv.getString(str, strlen(str));
+   return ACS_ExecuteScriptSAlways(ACSenv.getString(str, strlen(str)), mapnum, argv, argc,
+                                   mo, line, side, po);
+}
+
+//
+// ACS_ExecuteScriptSAlways
+//
+bool ACS_ExecuteScriptSAlways(ACSVM::String *name, uint32_t mapnum, const uint32_t *argv,
+                              uint32_t argc, Mobj *mo, line_t *line, int side, polyobj_t *po)
+{
    ACSVM::ScopeID scope{ACSenv.global->id, ACSenv.hub->id, mapnum ? mapnum : gamemap};
    ACSThreadInfo  info{mo, line, side, po};
    return ACSenv.map->scriptStartForced(name, scope, {argv, argc, &info});
@@ -820,8 +993,17 @@ bool ACS_ExecuteScriptSAlways(const char *str, uint32_t mapnum, const uint32_t *
 uint32_t ACS_ExecuteScriptSResult(const char *str, const uint32_t *argv,
                                  uint32_t argc, Mobj *mo, line_t *line, int side, polyobj_t *po)
 {
-   ACSVM::String *name = ACSenv.getString(str, strlen(str));
-   ACSThreadInfo  info{mo, line, side, po};
+   return ACS_ExecuteScriptSResult(ACSenv.getString(str, strlen(str)), argv, argc,
+                                   mo, line, side, po);
+}
+
+//
+// ACS_ExecuteScriptSResult
+//
+uint32_t ACS_ExecuteScriptSResult(ACSVM::String *name, const uint32_t *argv,
+                                 uint32_t argc, Mobj *mo, line_t *line, int side, polyobj_t *po)
+{
+   ACSThreadInfo info{mo, line, side, po};
    return ACSenv.map->scriptStartResult(name, {argv, argc, &info});
 }
 
@@ -839,7 +1021,14 @@ bool ACS_SuspendScriptI(uint32_t name, uint32_t mapnum)
 //
 bool ACS_SuspendScriptS(const char *str, uint32_t mapnum)
 {
-   ACSVM::String *name = ACSenv.getString(str, strlen(str));
+   return ACS_SuspendScriptS(ACSenv.getString(str, strlen(str)), mapnum);
+}
+
+//
+// ACS_SuspendScriptS
+//
+bool ACS_SuspendScriptS(ACSVM::String *name, uint32_t mapnum)
+{
    ACSVM::ScopeID scope{ACSenv.global->id, ACSenv.hub->id, mapnum ? mapnum : gamemap};
    return ACSenv.map->scriptPause(name, scope);
 }
@@ -858,11 +1047,33 @@ bool ACS_TerminateScriptI(uint32_t name, uint32_t mapnum)
 //
 bool ACS_TerminateScriptS(const char *str, uint32_t mapnum)
 {
-   ACSVM::String *name = ACSenv.getString(str, strlen(str));
+   return ACS_TerminateScriptS(ACSenv.getString(str, strlen(str)), mapnum);
+}
+
+//
+// ACS_TerminateScriptS
+//
+bool ACS_TerminateScriptS(ACSVM::String *name, uint32_t mapnum)
+{
    ACSVM::ScopeID scope{ACSenv.global->id, ACSenv.hub->id, mapnum ? mapnum : gamemap};
    return ACSenv.map->scriptStop(name, scope);
 }
 
+//
+// ACS_InternString
+//
+// Returns a handle for str that callers may keep and pass to the ACSVM::String
+// overloads above instead of rehashing the name on every call. The string is
+// locked so it is never collected; handles only need to be dropped when the
+// string table is replaced by loading a save (see ACS_Archive).
+//
+ACSVM::String *ACS_InternString(const char *str)
+{
+   ACSVM::String *name = ACSenv.getString(str, strlen(str));
+   ++name->lock;
+   return name;
+}
+
 //=============================================================================
 //
 // Save/Load Code
@@ -920,6 +1131,10 @@ void ACS_Archive(SaveArchive &arc)
          in.loadHead();
          ACSenv.loadState(in);
          in.loadTail();
+
+         // The string table was rebuilt, so cached script name handles are
+         // stale.
+         E_ResetArgEvalsOfType(EVALTYPE_ACSSTRING);
       }
       catch(ACSVM::SerialError const &e)
       {
@@ -30,6 +30,8 @@
 #ifndef ACS_INTR_H__
 #define ACS_INTR_H__
 
+#include <vector>
+
 #include "m_dllist.h"
 #include "p_tick.h"
 #include "r_defs.h"
@@ -197,6 +199,11 @@ public:
 
    ACSEnvironment();
 
+   ACSVM::Word addCallFunc(ACSVM::CallFunc func, const char *name);
+
+   virtual bool callFunc(ACSVM::Thread *thread, ACSVM::Word func,
+                         const ACSVM::Word *argV, ACSVM::Word argC);
+
    virtual bool checkTag(ACSVM::Word type, ACSVM::Word tag);
 
    virtual ACSVM::ModuleName getModuleName(char const *str, size_t len);
@@ -219,6 +226,8 @@ public:
    ACSVM::MapScope    *map;
 
    size_t errors;
+
+   std::vector<const char *> callFuncNames; // by CallFunc index, for profiling
 };
 
 //
@@ -268,7 +277,10 @@ public:
 class ACSThread : public ACSVM::Thread
 {
 public:
-   explicit ACSThread(ACSVM::Environment *env_) : ACSVM::Thread{env_} {}
+   explicit ACSThread(ACSVM::Environment *env_) :
+      ACSVM::Thread{env_}, profslot{-1}, profscript{nullptr} {}
+
+   virtual void exec();
 
    virtual ACSVM::ThreadInfo const *getInfo() const {return &info;}
 
@@ -283,6 +295,10 @@ public:
 
    ACSThreadInfo info;
 
+   // Profiler entry of the script last timed on this thread
+   int                  profslot;
+   const ACSVM::Script *profscript;
+
    static int saveLoadVersion;   // context information stored when saving and loading
 };
 
@@ -307,14 +323,25 @@ uint32_t ACS_ExecuteScriptIResult(uint32_t name, const uint32_t *argv,
                                  uint32_t argc, Mobj *mo, line_t *line, int side, polyobj_t *po);
 bool ACS_ExecuteScriptS(const char *name, uint32_t mapnum, const uint32_t *argv,
                         uint32_t argc, Mobj *mo, line_t *line, int side, polyobj_t *po);
+bool ACS_ExecuteScriptS(ACSVM::String *name, uint32_t mapnum, const uint32_t *argv,
+                        uint32_t argc, Mobj *mo, line_t *line, int side, polyobj_t *po);
 bool ACS_ExecuteScriptSAlways(const char *name, uint32_t mapnum, const uint32_t *argv,
                               uint32_t argc, Mobj *mo, line_t *line, int side, polyobj_t *po);
+bool ACS_ExecuteScriptSAlways(ACSVM::String *name, uint32_t mapnum, const uint32_t *argv,
+                              uint32_t argc, Mobj *mo, line_t *line, int side, polyobj_t *po);
 uint32_t ACS_ExecuteScriptSResult(const char *name, const uint32_t *argv,
                                  uint32_t argc, Mobj *mo, line_t *line, int side, polyobj_t *po);
+uint32_t ACS_ExecuteScriptSResult(ACSVM::String *name, const uint32_t *argv,
+                                 uint32_t argc, Mobj *mo, line_t *line, int side, polyobj_t *po);
 bool ACS_SuspendScriptI(uint32_t name, uint32_t mapnum);
 bool ACS_SuspendScriptS(const char *name, uint32_t mapnum);
+bool ACS_SuspendScriptS(ACSVM::String *name, uint32_t mapnum);
 bool ACS_TerminateScriptI(uint32_t name, uint32_t mapnum);
 bool ACS_TerminateScriptS(const char *name, uint32_t mapnum);
+bool ACS_TerminateScriptS(ACSVM::String *name, uint32_t mapnum);
+
+// Script name handles.
+ACSVM::String *ACS_InternString(const char *str);
 
 // Utilities.
 uint32_t ACS_GetLevelProp(uint32_t prop);
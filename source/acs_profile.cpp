@@ -0,0 +1,322 @@
+//
+// The Eternity Engine
+// Copyright(C) 2026 James Haley, Max Waine, et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+// Additional terms and conditions compatible with the GPLv3 apply. See the
+// file COPYING-EE for details.
+//
+// Purpose: ACS profiler.
+//  Scripts are told apart by name, so a profile can span levels. Entries are
+//  never removed, only zeroed, which keeps the entry cached by each thread
+//  valid across restarts of the profile.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include "z_zone.h"
+
+#include "acs_intr.h"
+#include "acs_profile.h"
+#include "c_io.h"
+#include "c_runcmd.h"
+#include "doomstat.h"
+#include "m_perfstats.h"
+#include "m_qstr.h"
+#include "v_misc.h"
+
+#include "ACSVM/Script.hpp"
+#include "ACSVM/String.hpp"
+
+using acsprofclock_t = std::chrono::steady_clock;
+
+// Rows of each table printed to the console; CSV output has all of them
+static constexpr size_t ACSPROFILESHOWN = 20;
+
+struct acsscriptprof_t
+{
+   qstring  name;
+   uint64_t runs;  // executions that ran any code
+   uint64_t codes; // codes executed
+   uint64_t wakes; // executions that resumed from a Delay
+   int64_t  ns;
+};
+
+struct acsfuncprof_t
+{
+   uint64_t calls;
+   int64_t  ns;
+};
+
+bool acs_profiling;
+
+static std::vector<acsscriptprof_t> scriptprofs;
+static std::vector<acsfuncprof_t>   funcprofs; // by CallFunc index
+
+// script time while profiling, for the stats registry
+static PerfCounter scripttimestat("acs.profiled_time", "ns");
+
+static int profilestarttic;
+static int profilestoptic;
+
+//
+// Nanoseconds elapsed since start.
+//
+static int64_t ACS_profileElapsed(acsprofclock_t::time_point start)
+{
+   return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      acsprofclock_t::now() - start).count();
+}
+
+//
+// Finds or adds the entry of a script.
+//
+static int ACS_scriptProfSlot(const ACSVM::Script *script)
+{
+   qstring name;
+
+   if(script->name.s)
+      name << '"' << script->name.s->str << '"';
+   else
+      name << static_cast<int>(script->name.i);
+
+   for(size_t i = 0; i < scriptprofs.size(); i++)
+   {
+      if(scriptprofs[i].name == name)
+         return static_cast<int>(i);
+   }
+
+   acsscriptprof_t prof;
+   prof.name = name;
+   prof.runs = prof.codes = prof.wakes = 0;
+   prof.ns   = 0;
+   scriptprofs.push_back(prof);
+   return static_cast<int>(scriptprofs.size() - 1);
+}
+
+//
+// Executes a thread, charging it to its script.
+//
+void ACS_ProfileExec(ACSThread *thread)
+{
+   const ACSVM::Script *script = thread->script;
+   const bool           waking = thread->delay == 1;
+   const size_t         codes  = thread->codeCount;
+   const acsprofclock_t::time_point start = acsprofclock_t::now();
+
+   thread->ACSVM::Thread::exec();
+
+   const int64_t ns = ACS_profileElapsed(start);
+
+   // nothing ran if the thread is still delayed or waiting
+   if(!script || (thread->codeCount == codes && !waking))
+      return;
+
+   if(thread->profscript != script)
+   {
+      thread->profslot   = ACS_scriptProfSlot(script);
+      thread->profscript = script;
+   }
+
+   acsscriptprof_t &prof = scriptprofs[thread->profslot];
+   prof.runs++;
+   prof.codes += thread->codeCount - codes;
+   prof.wakes += waking;
+   prof.ns    += ns;
+
+   scripttimestat.add(uint64_t(ns));
+}
+
+//
+// Calls and times a CallFunc.
+//
+bool ACS_ProfileCallFunc(ACSVM::Thread *thread, ACSVM::Word func,
+                         const ACSVM::Word *argV, ACSVM::Word argC)
+{
+   const acsprofclock_t::time_point start = acsprofclock_t::now();
+   const bool result = thread->env->ACSVM::Environment::callFunc(thread, func, argV, argC);
+
+   if(funcprofs.size() <= func)
+      funcprofs.resize(func + 1);
+   funcprofs[func].calls++;
+   funcprofs[func].ns += ACS_profileElapsed(start);
+
+   return result;
+}
+
+//
+// CallFunc totals, merging the several indexes a function can be added under
+//
+struct acsfuncrow_t
+{
+   const char *name;
+   uint64_t    calls;
+   int64_t     ns;
+};
+
+static std::vector<acsfuncrow_t> ACS_funcProfRows()
+{
+   std::vector<acsfuncrow_t> rows;
+
+   for(size_t i = 0; i < funcprofs.size(); i++)
+   {
+      if(!funcprofs[i].calls)
+         continue;
+
+      const char *name = i < ACSenv.callFuncNames.size() ? ACSenv.callFuncNames[i] : nullptr;
+      auto row = std::find_if(rows.begin(), rows.end(), [name](const acsfuncrow_t &r) {
+         return name && r.name && !strcmp(r.name, name);
+      });
+
+      if(row == rows.end())
+         rows.push_back({ name, funcprofs[i].calls, funcprofs[i].ns });
+      else
+      {
+         row->calls += funcprofs[i].calls;
+         row->ns    += funcprofs[i].ns;
+      }
+   }
+
+   std::sort(rows.begin(), rows.end(), [](const acsfuncrow_t &a, const acsfuncrow_t &b) {
+      return a.ns > b.ns;
+   });
+   return rows;
+}
+
+//
+// Script entries that ran, slowest first.
+//
+static std::vector<const acsscriptprof_t *> ACS_scriptProfRows()
+{
+   std::vector<const acsscriptprof_t *> rows;
+
+   for(const acsscriptprof_t &prof : scriptprofs)
+   {
+      if(prof.runs)
+         rows.push_back(&prof);
+   }
+
+   std::sort(rows.begin(), rows.end(), [](const acsscriptprof_t *a, const acsscriptprof_t *b) {
+      return a->ns > b->ns;
+   });
+   return rows;
+}
+
+//
+// Prints the slowest scripts and CallFuncs to the console.
+//
+static void ACS_printProfile(int tics)
+{
+   const auto scripts = ACS_scriptProfRows();
+   const auto funcs   = ACS_funcProfRows();
+
+   C_Printf(FC_HI "ACS profile over %d tics\n", tics);
+
+   C_Printf(FC_HI "script        runs      codes   wakes    total ms  ms/tic\n");
+   for(size_t i = 0; i < scripts.size() && i < ACSPROFILESHOWN; i++)
+   {
+      const acsscriptprof_t &prof = *scripts[i];
+
+      C_Printf("%-12s %6llu %10llu %7llu %11.2f %7.3f\n", prof.name.constPtr(),
+               static_cast<unsigned long long>(prof.runs),
+               static_cast<unsigned long long>(prof.codes),
+               static_cast<unsigned long long>(prof.wakes),
+               prof.ns / 1e6, tics ? prof.ns / 1e6 / tics : 0.0);
+   }
+
+   C_Printf(FC_HI "callfunc                  calls    total ms  us/call\n");
+   for(size_t i = 0; i < funcs.size() && i < ACSPROFILESHOWN; i++)
+   {
+      const acsfuncrow_t &row = funcs[i];
+
+      C_Printf("%-22s %8llu %11.2f %8.2f\n", row.name ? row.name : "?",
+               static_cast<unsigned long long>(row.calls), row.ns / 1e6,
+               row.ns / 1e3 / row.calls);
+   }
+
+   if(scripts.size() > ACSPROFILESHOWN || funcs.size() > ACSPROFILESHOWN)
+      C_Printf("(more rows in CSV output)\n");
+}
+
+//
+// Writes every script and CallFunc entry to a CSV file.
+//
+static void ACS_writeProfileCSV(const char *filename, int tics)
+{
+   FILE *f;
+
+   if(!(f = fopen(filename, "w")))
+   {
+      C_Printf(FC_ERROR "Couldn't open %s for ACS profile output\n", filename);
+      return;
+   }
+
+   fprintf(f, "kind,name,count,codes,wakes,total_us,tics\n");
+   for(const acsscriptprof_t *prof : ACS_scriptProfRows())
+   {
+      // script names are quoted already when they are strings
+      fprintf(f, "script,%s,%llu,%llu,%llu,%.1f,%d\n", prof->name.constPtr(),
+              static_cast<unsigned long long>(prof->runs),
+              static_cast<unsigned long long>(prof->codes),
+              static_cast<unsigned long long>(prof->wakes), prof->ns / 1e3, tics);
+   }
+   for(const acsfuncrow_t &row : ACS_funcProfRows())
+   {
+      fprintf(f, "callfunc,%s,%llu,,,%.1f,%d\n", row.name ? row.name : "?",
+              static_cast<unsigned long long>(row.calls), row.ns / 1e3, tics);
+   }
+
+   fclose(f);
+   C_Printf("Wrote ACS profile to %s\n", filename);
+}
+
+CONSOLE_COMMAND(acs_profile, 0)
+{
+   if(Console.argc >= 1 && !Console.argv[0]->strCaseCmp("start"))
+   {
+      for(acsscriptprof_t &prof : scriptprofs)
+      {
+         prof.runs = prof.codes = prof.wakes = 0;
+         prof.ns   = 0;
+      }
+      funcprofs.clear();
+
+      profilestarttic = gametic;
+      acs_profiling   = true;
+      C_Printf("ACS profiling started.\n");
+   }
+   else if(Console.argc >= 1 && !Console.argv[0]->strCaseCmp("stop"))
+   {
+      if(acs_profiling)
+         profilestoptic = gametic;
+      acs_profiling = false;
+      C_Printf("ACS profiling stopped.\n");
+   }
+   else if(Console.argc >= 1 && !Console.argv[0]->strCaseCmp("dump"))
+   {
+      const int tics = (acs_profiling ? gametic : profilestoptic) - profilestarttic;
+
+      ACS_printProfile(tics);
+      if(Console.argc >= 2)
+         ACS_writeProfileCSV(Console.argv[1]->constPtr(), tics);
+   }
+   else
+      C_Printf("usage: acs_profile [start | stop | dump [file.csv]]\n");
+}
+
+// EOF
+
@@ -0,0 +1,43 @@
+//
+// The Eternity Engine
+// Copyright(C) 2026 James Haley, Max Waine, et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+// Additional terms and conditions compatible with the GPLv3 apply. See the
+// file COPYING-EE for details.
+//
+// Purpose: ACS profiler.
+//  While running, every thread execution is charged to its script along with
+//  the codes it ran and whether it woke from a Delay, and every CallFunc is
+//  timed. Script times include the CallFuncs they make.
+//
+
+#ifndef ACS_PROFILE_H__
+#define ACS_PROFILE_H__
+
+#include "ACSVM/Types.hpp"
+
+class ACSThread;
+
+extern bool acs_profiling;
+
+void ACS_ProfileExec(ACSThread *thread);
+bool ACS_ProfileCallFunc(ACSVM::Thread *thread, ACSVM::Word func,
+                         const ACSVM::Word *argV, ACSVM::Word argC);
+
+#endif
+
+// EOF
+
@@ -41,6 +41,8 @@
 #include "e_inventory.h"
 #include "ev_specials.h"
 #include "g_bind.h"
+#include "m_bbox.h"
+#include "m_compare.h"
 #include "p_maputl.h"
 #include "p_portal.h"
 #include "p_setup.h"
@@ -1292,11 +1294,10 @@ static bool AM_clipMline(mline_t *ml, fline_t *fl)
 //
 static void AM_drawFline(fline_t *fl, int color )
 {
-   int x,  y;
    int dx, dy;
    int sx, sy;
    int ax, ay;
-   int d;
+   int d, count;
 
 #ifdef RANGECHECK         // killough 2/22/98    
    //static int fuck = 0;
@@ -1321,38 +1322,42 @@ static void AM_drawFline(fline_t *fl, int color )
    ay = 2 * (dy < 0 ? -dy : dy);
    sy = dy < 0 ? -1 : 1;
 
-   x = fl->a.x;
-   y = fl->a.y;
-   
+   // step through the buffer rather than working out every dot's address
+   byte *dest = VBADDRESS(&vbscreen, fl->a.x, fl->a.y);
+   const int xstep = sx * vbscreen.pitch;
+   const int ystep = sy * vbscreen.pixelsize;
+
    if(ax > ay)
    {
+      count = ax / 2;
       d = ay - ax/2;
       while(1)
       {
-         PUTDOT(x, y, color);
-         if(x == fl->b.x) return;
+         *dest = color;
+         if(!count--) return;
          if(d >= 0)
          {
-            y += sy;
+            dest += ystep;
             d -= ax;
          }
-         x += sx;
+         dest += xstep;
          d += ay;
       }
    }
    else
    {
+      count = ay / 2;
       d = ax - ay/2;
       while(1)
       {
-         PUTDOT(x, y, color);
-         if(y == fl->b.y) return;
+         *dest = color;
+         if(!count--) return;
          if(d >= 0)
          {
-            x += sx;
+            dest += xstep;
             d -= ay;
          }
-         y += sy;
+         dest += ystep;
          d += ax;
       }
    }
@@ -1363,9 +1368,8 @@ static void AM_drawFline(fline_t *fl, int color )
 //
 // haleyjd 06/13/09: Pixel plotter for Wu line drawing.
 //
-static void AM_putWuDot(int x, int y, int color, int weight)
+static void AM_putWuDot(byte *dest, int color, int weight)
 {
-   byte *dest = VBADDRESS(&vbscreen, x, y);
    unsigned int *fg2rgb = Col2RGB8[weight];
    unsigned int *bg2rgb = Col2RGB8[64 - weight];
    unsigned int fg, bg;
@@ -1395,7 +1399,6 @@ static void AM_putWuDot(int x, int y, int color, int weight)
 static void AM_drawFlineWu(fline_t *fl, int color)
 {
    int dx, dy, xdir = 1;
-   int x, y;   
 
    // swap end points if necessary
    if(fl->a.y > fl->b.y)
@@ -1427,8 +1430,9 @@ static void AM_drawFlineWu(fline_t *fl, int color)
    // draw first pixel
    PUTDOT(fl->a.x, fl->a.y, color);
 
-   x = fl->a.x;
-   y = fl->a.y;
+   byte *dest = VBADDRESS(&vbscreen, fl->a.x, fl->a.y);
+   const int xstep = xdir * vbscreen.pitch;
+   const int ystep = vbscreen.pixelsize;
 
    if(dy > dx)
    {
@@ -1444,14 +1448,14 @@ static void AM_drawFlineWu(fline_t *fl, int color)
 
          // if error has overflown, advance x coordinate
          if(erroracc <= erroracctmp)
-            x += xdir;
+            dest += xstep;
          
-         y += 1; // advance y
+         dest += ystep; // advance y
 
          // the trick is in the trig!
-         AM_putWuDot(x, y, color, 
+         AM_putWuDot(dest, color, 
                      finecosine[erroracc >> wu_fineshift] >> wu_fixedshift);
-         AM_putWuDot(x + xdir, y, color, 
+         AM_putWuDot(dest + xstep, color, 
                      finesine[erroracc >> wu_fineshift] >> wu_fixedshift);
       }
    }
@@ -1469,14 +1473,14 @@ static void AM_drawFlineWu(fline_t *fl, int color)
 
          // if error has overflown, advance y coordinate
          if(erroracc <= erroracctmp)
-            y += 1;
+            dest += ystep;
          
-         x += xdir; // advance x
+         dest += xstep; // advance x
 
          // the trick is in the trig!
-         AM_putWuDot(x, y, color, 
+         AM_putWuDot(dest, color, 
                      finecosine[erroracc >> wu_fineshift] >> wu_fixedshift);
-         AM_putWuDot(x, y + 1, color, 
+         AM_putWuDot(dest + ystep, color, 
                      finesine[erroracc >> wu_fineshift] >> wu_fixedshift);
       }
    }
@@ -1719,205 +1723,331 @@ inline static bool AM_dontDraw(const line_t &line)
 }
 
 //
-// Determines visible lines, draws them.
-// This is LineDef based, not LineSeg based.
+// Lines in view are found through the blockmap rather than by going through
+// every line in the level. Polyobject lines are found where the polyobjects
+// are now through their own block links. With the portal overlay, each
+// portal group is looked up with the window moved back by the group's link
+// offset, since that is where its lines get drawn from.
 //
-// jff 1/5/98 many changes in this routine
-// backward compatibility not needed, so just changes, no ifs
-// addition of clauses for:
-//    doors opening, keyed door id, secret sectors,
-//    teleports, exit lines, key things
-// ability to suppress any of added features or lines with no height changes
+
+typedef void (*amlinefunc_t)(const line_t *line, int plrgroup);
+
+static int *am_linemarks;    // am_linestamp for lines already visited
+static int  am_numlinemarks;
+static int  am_linestamp;
+
 //
-// support for gamma correction in automap abandoned
+// Gets the range of blocks covered by the automap window, moved back by a
+// link offset and widened by margin map units. Returns false if the window
+// is clear of the blockmap.
 //
-// jff 4/3/98 changed mapcolor_xxxx=0 as control to disable feature
-// jff 4/3/98 changed mapcolor_xxxx=-1 to disable drawing line completely
+static bool AM_windowBlocks(const linkoffset_t &link, double margin, int box[4])
+{
+   const double orgx = M_FixedToDouble(bmaporgx) + M_FixedToDouble(link.x);
+   const double orgy = M_FixedToDouble(bmaporgy) + M_FixedToDouble(link.y);
+
+   const double left   = floor((m_x  - margin - orgx) / MAPBLOCKUNITS);
+   const double right  = floor((m_x2 + margin - orgx) / MAPBLOCKUNITS);
+   const double bottom = floor((m_y  - margin - orgy) / MAPBLOCKUNITS);
+   const double top    = floor((m_y2 + margin - orgy) / MAPBLOCKUNITS);
+
+   if(right < 0 || left >= bmapwidth || top < 0 || bottom >= bmapheight)
+      return false;
+
+   box[BOXLEFT]   = int(emax(left, 0.0));
+   box[BOXRIGHT]  = int(emin(right, double(bmapwidth - 1)));
+   box[BOXBOTTOM] = int(emax(bottom, 0.0));
+   box[BOXTOP]    = int(emin(top, double(bmapheight - 1)));
+   return true;
+}
+
 //
-static void AM_drawWalls()
+// Calls func on a line the first time it is found this frame, if it is in
+// the group being looked up.
+//
+inline static void AM_visitLine(const line_t *line, amlinefunc_t func, int group,
+                                int plrgroup)
 {
-   int i;
-   static mline_t l;
-   
-   int plrgroup = plr->mo->groupid;
+   const int index = int(line - lines);
 
-   // Draw overlay lines first so they will not obscure the (more important)
-   // normal map lines
-   if(mapportal_overlay && useportalgroups)
+   if(am_linemarks[index] == am_linestamp)
+      return;
+
+   // left unmarked for its own group's lookup
+   if(group >= 0 && line->frontsector->groupid != group)
+      return;
+
+   am_linemarks[index] = am_linestamp;
+   func(line, plrgroup);
+}
+
+static void AM_visitBlockLines(const int box[4], amlinefunc_t func, int group,
+                               int plrgroup)
+{
+   for(int by = box[BOXBOTTOM]; by <= box[BOXTOP]; by++)
    {
-      for(i = 0; i < numlines; ++i)
+      for(int bx = box[BOXLEFT]; bx <= box[BOXRIGHT]; bx++)
       {
-         const line_t *line = &lines[i];
+         const int offset = by * bmapwidth + bx;
 
-         if(line->frontsector->groupid == plrgroup ||
-            P_PortalLayersByPoly(line->frontsector->groupid, plrgroup))
+         for(DLListItem<polymaplink_t> *plink = polyblocklinks[offset]; plink;
+             plink = plink->dllNext)
          {
-            continue;
+            const polyobj_t *po = (*plink)->po;
+
+            for(int i = 0; i < po->numLines; i++)
+               AM_visitLine(po->lines[i], func, group, plrgroup);
          }
 
-         l.a.x = line->v1->fx;
-         l.a.y = line->v1->fy;
-         l.b.x = line->v2->fx;
-         l.b.y = line->v2->fy;
+         for(const int *list = blockmaplump + blockmap[offset]; *list != -1; list++)
+         {
+            // haleyjd 04/06/10: invalid blockmap lumps
+            if(*list < numlines)
+               AM_visitLine(&lines[*list], func, group, plrgroup);
+         }
+      }
+   }
+}
 
-         auto link = P_GetLinkOffset(line->frontsector->groupid, plrgroup);
+//
+// Calls func once on every line that may be in the automap window.
+//
+static void AM_forVisibleLines(amlinefunc_t func, int plrgroup)
+{
+   int box[4];
 
-         l.a.x += M_FixedToDouble(link->x);
-         l.a.y += M_FixedToDouble(link->y);
-         l.b.x += M_FixedToDouble(link->x);
-         l.b.y += M_FixedToDouble(link->y);
+   if(am_numlinemarks < numlines)
+   {
+      efree(am_linemarks);
+      am_linemarks    = ecalloc(int *, numlines, sizeof(int));
+      am_numlinemarks = numlines;
+      am_linestamp    = 0;
+   }
 
-         // if line has been seen or IDDT has been used
-         if(ddt_cheating || (line->flags & ML_MAPPED))
-         {
-            // check for DONTDRAW flag; those lines are only visible
-            // if using the IDDT cheat.
-            if(AM_dontDraw(*line) && !ddt_cheating)
-               continue;
+   if(++am_linestamp <= 0)
+   {
+      memset(am_linemarks, 0, am_numlinemarks * sizeof(int));
+      am_linestamp = 1;
+   }
 
-            if(!line->backsector ||
-               AM_different<surf_floor>(*line) || AM_different<surf_ceil>(*line))
-            {
-               AM_drawMline(&l, mapcolor_prtl);
-            }
-         }
-         else if(plr->powers[pw_allmap].isActive()) // computermap visible lines
-         {
-            // now draw the lines only visible because the player has computermap
-            if(!AM_dontDraw(*line)) // invisible flag lines do not show
-            {
-               if(!line->backsector ||
-                  AM_different<surf_floor>(*line) || AM_different<surf_ceil>(*line))
-               {
-                  AM_drawMline(&l, mapcolor_prtl);
-               }
-            }
-         } // end else if      
-      }
+   if(!(mapportal_overlay && useportalgroups))
+   {
+      if(AM_windowBlocks(zerolink, 0.0, box))
+         AM_visitBlockLines(box, func, -1, plrgroup);
+      return;
    }
 
-   // draw the unclipped visible portions of all lines
-   for(i = 0; i < numlines; i++)
+   for(int group = 0; group < P_PortalGroupCount(); group++)
    {
-      const line_t *line = &lines[i];
+      if(AM_windowBlocks(*P_GetLinkOffset(group, plrgroup), 0.0, box))
+         AM_visitBlockLines(box, func, group, plrgroup);
+   }
+}
 
-      l.a.x = line->v1->fx;
-      l.a.y = line->v1->fy;
-      l.b.x = line->v2->fx;
-      l.b.y = line->v2->fy;
+//
+// Gets a line's map coordinates, moved by its group's link offset when
+// drawing the portal overlay.
+//
+static void AM_lineToMline(const line_t *line, int plrgroup, mline_t &l)
+{
+   l.a.x = line->v1->fx;
+   l.a.y = line->v1->fy;
+   l.b.x = line->v2->fx;
+   l.b.y = line->v2->fy;
 
-      if(mapportal_overlay && useportalgroups)
+   if(mapportal_overlay && useportalgroups && line->frontsector)
+   {
+      const linkoffset_t *link = P_GetLinkOffset(line->frontsector->groupid, plrgroup);
+
+      l.a.x += M_FixedToDouble(link->x);
+      l.a.y += M_FixedToDouble(link->y);
+      l.b.x += M_FixedToDouble(link->x);
+      l.b.y += M_FixedToDouble(link->y);
+   }
+}
+
+//
+// Draws a line of another portal group for the overlay.
+//
+static void AM_drawOverlayLine(const line_t *line, int plrgroup)
+{
+   mline_t l;
+
+   if(line->frontsector->groupid == plrgroup ||
+      P_PortalLayersByPoly(line->frontsector->groupid, plrgroup))
+   {
+      return;
+   }
+
+   // if line has been seen or IDDT has been used
+   if(ddt_cheating || (line->flags & ML_MAPPED))
+   {
+      // check for DONTDRAW flag; those lines are only visible
+      // if using the IDDT cheat.
+      if(AM_dontDraw(*line) && !ddt_cheating)
+         return;
+
+      if(!line->backsector ||
+         AM_different<surf_floor>(*line) || AM_different<surf_ceil>(*line))
       {
-         if(line->frontsector && (line->frontsector->groupid != plrgroup &&
-                                  !P_PortalLayersByPoly(line->frontsector->groupid, plrgroup)))
+         AM_lineToMline(line, plrgroup, l);
+         AM_drawMline(&l, mapcolor_prtl);
+      }
+   }
+   else if(plr->powers[pw_allmap].isActive()) // computermap visible lines
+   {
+      // now draw the lines only visible because the player has computermap
+      if(!AM_dontDraw(*line)) // invisible flag lines do not show
+      {
+         if(!line->backsector ||
+            AM_different<surf_floor>(*line) || AM_different<surf_ceil>(*line))
          {
-            continue;
+            AM_lineToMline(line, plrgroup, l);
+            AM_drawMline(&l, mapcolor_prtl);
          }
+      }
+   } // end else if      
+}
 
-         if(line->frontsector)
-         {
-            linkoffset_t *link = P_GetLinkOffset(line->frontsector->groupid, plrgroup);
+//
+// Determines a line's colour and draws it.
+// This is LineDef based, not LineSeg based.
+//
+// jff 1/5/98 many changes in this routine
+// backward compatibility not needed, so just changes, no ifs
+// addition of clauses for:
+//    doors opening, keyed door id, secret sectors,
+//    teleports, exit lines, key things
+// ability to suppress any of added features or lines with no height changes
+//
+// support for gamma correction in automap abandoned
+//
+// jff 4/3/98 changed mapcolor_xxxx=0 as control to disable feature
+// jff 4/3/98 changed mapcolor_xxxx=-1 to disable drawing line completely
+//
+static void AM_drawLine(const line_t *line, int plrgroup)
+{
+   mline_t l;
 
-            l.a.x += M_FixedToDouble(link->x);
-            l.a.y += M_FixedToDouble(link->y);
-            l.b.x += M_FixedToDouble(link->x);
-            l.b.y += M_FixedToDouble(link->y);
-         }
+   if(mapportal_overlay && useportalgroups)
+   {
+      if(line->frontsector && (line->frontsector->groupid != plrgroup &&
+                               !P_PortalLayersByPoly(line->frontsector->groupid, plrgroup)))
+      {
+         return;
       }
+   }
 
-      // if line has been seen or IDDT has been used
-      if(ddt_cheating || (line->flags & ML_MAPPED))
+   AM_lineToMline(line, plrgroup, l);
+
+   // if line has been seen or IDDT has been used
+   if(ddt_cheating || (line->flags & ML_MAPPED))
+   {
+      // check for DONTDRAW flag; those lines are only visible
+      // if using the IDDT cheat.
+      if(AM_dontDraw(*line) && !ddt_cheating)
+         return;
+
+      if(!line->backsector) // 1S lines
+      {            
+         if(AM_drawAsExitLine(line))
+         {
+            //jff 4/23/98 add exit lines to automap
+            AM_drawMline(&l, mapcolor_exit); // exit line
+         }            
+         else if(AM_drawAs1sSecret(line))
+         {
+            // jff 1/10/98 add new color for 1S secret sector boundary
+            AM_drawMline(&l, mapcolor_secr); // line bounding secret sector
+         }
+         else if(AM_drawAsLockedDoor(line))
+         {
+            int lockColor;
+            if((lockColor = AM_DoorColor(line)) >= 0)
+               AM_drawMline(&l, lockColor ? lockColor : mapcolor_cchg);
+         }
+         else                                //jff 2/16/98 fixed bug
+            AM_drawMline(&l, mapcolor_wall); // special was cleared
+      }
+      else // 2S lines
       {
-         // check for DONTDRAW flag; those lines are only visible
-         // if using the IDDT cheat.
-         if(AM_dontDraw(*line) && !ddt_cheating)
-            continue;
-
-         if(!line->backsector) // 1S lines
-         {            
-            if(AM_drawAsExitLine(line))
-            {
-               //jff 4/23/98 add exit lines to automap
-               AM_drawMline(&l, mapcolor_exit); // exit line
-            }            
-            else if(AM_drawAs1sSecret(line))
-            {
-               // jff 1/10/98 add new color for 1S secret sector boundary
-               AM_drawMline(&l, mapcolor_secr); // line bounding secret sector
-            }
-            else if(AM_drawAsLockedDoor(line))
+         // jff 1/10/98 add color change for all teleporter types
+         if(AM_drawAsTeleporter(line))
+         { 
+            // teleporters
+            AM_drawMline(&l, mapcolor_tele);
+         }
+         else if(AM_drawAsExitLine(line))
+         {
+            //jff 4/23/98 add exit lines to automap
+            AM_drawMline(&l, mapcolor_exit);
+         }
+         else if(AM_drawAsLockedDoor(line))
+         {
+            //jff 1/5/98 this clause implements showing keyed doors
+            if(AM_isDoorClosed(line))
             {
                int lockColor;
                if((lockColor = AM_DoorColor(line)) >= 0)
                   AM_drawMline(&l, lockColor ? lockColor : mapcolor_cchg);
             }
-            else                                //jff 2/16/98 fixed bug
-               AM_drawMline(&l, mapcolor_wall); // special was cleared
+            else
+               AM_drawMline(&l, mapcolor_cchg); // open keyed door
          }
-         else // 2S lines
+         else if(line->flags & ML_SECRET)    // secret door
          {
-            // jff 1/10/98 add color change for all teleporter types
-            if(AM_drawAsTeleporter(line))
-            { 
-               // teleporters
-               AM_drawMline(&l, mapcolor_tele);
-            }
-            else if(AM_drawAsExitLine(line))
-            {
-               //jff 4/23/98 add exit lines to automap
-               AM_drawMline(&l, mapcolor_exit);
-            }
-            else if(AM_drawAsLockedDoor(line))
-            {
-               //jff 1/5/98 this clause implements showing keyed doors
-               if(AM_isDoorClosed(line))
-               {
-                  int lockColor;
-                  if((lockColor = AM_DoorColor(line)) >= 0)
-                     AM_drawMline(&l, lockColor ? lockColor : mapcolor_cchg);
-               }
-               else
-                  AM_drawMline(&l, mapcolor_cchg); // open keyed door
-            }
-            else if(line->flags & ML_SECRET)    // secret door
-            {
-               AM_drawMline(&l, mapcolor_wall);      // wall color
-            }
-            else if(AM_drawAsClosedDoor(line))
-            {
-               AM_drawMline(&l, mapcolor_clsd); // non-secret closed door
-            } 
-            else if(AM_drawAs2sSecret(line))
-            {
-               AM_drawMline(&l, mapcolor_secr); // line bounding secret sector
-            } 
-            else if(AM_different<surf_floor>(*line))
-            {
-               AM_drawMline(&l, mapcolor_fchg); // floor level change
-            }
-            else if(AM_different<surf_ceil>(*line))
-            {
-               AM_drawMline(&l, mapcolor_cchg); // ceiling level change
-            }
-            else if(mapcolor_flat && ddt_cheating)
-            { 
-               AM_drawMline(&l, mapcolor_flat); // 2S lines that appear only in IDDT
-            }
+            AM_drawMline(&l, mapcolor_wall);      // wall color
          }
-      } 
-      else if(plr->powers[pw_allmap].isActive()) // computermap visible lines
+         else if(AM_drawAsClosedDoor(line))
+         {
+            AM_drawMline(&l, mapcolor_clsd); // non-secret closed door
+         } 
+         else if(AM_drawAs2sSecret(line))
+         {
+            AM_drawMline(&l, mapcolor_secr); // line bounding secret sector
+         } 
+         else if(AM_different<surf_floor>(*line))
+         {
+            AM_drawMline(&l, mapcolor_fchg); // floor level change
+         }
+         else if(AM_different<surf_ceil>(*line))
+         {
+            AM_drawMline(&l, mapcolor_cchg); // ceiling level change
+         }
+         else if(mapcolor_flat && ddt_cheating)
+         { 
+            AM_drawMline(&l, mapcolor_flat); // 2S lines that appear only in IDDT
+         }
+      }
+   } 
+   else if(plr->powers[pw_allmap].isActive()) // computermap visible lines
+   {
+      // now draw the lines only visible because the player has computermap
+      if(!AM_dontDraw(*line)) // invisible flag lines do not show
       {
-         // now draw the lines only visible because the player has computermap
-         if(!AM_dontDraw(*line)) // invisible flag lines do not show
+         if(mapcolor_flat || !line->backsector ||
+            AM_different<surf_floor>(*line) || AM_different<surf_ceil>(*line))
          {
-            if(mapcolor_flat || !line->backsector ||
-               AM_different<surf_floor>(*line) || AM_different<surf_ceil>(*line))
-            {
-               AM_drawMline(&l, mapcolor_unsn);
-            }
+            AM_drawMline(&l, mapcolor_unsn);
          }
-      } // end else if
-   } // end for
+      }
+   } // end else if
+}
+
+//
+// Determines visible lines, draws them.
+//
+static void AM_drawWalls()
+{
+   const int plrgroup = plr->mo->groupid;
+
+   // Draw overlay lines first so they will not obscure the (more important)
+   // normal map lines
+   if(mapportal_overlay && useportalgroups)
+      AM_forVisibleLines(AM_drawOverlayLine, plrgroup);
+
+   // draw the unclipped visible portions of all lines
+   AM_forVisibleLines(AM_drawLine, plrgroup);
 }
 
 
@@ -2227,11 +2357,33 @@ static void AM_drawPlayers()
 static void AM_drawThings(int colors, int colorrange)
 {
    fixed_t tx, ty; // SoM: Moved thing coords to variables for linked portals
+   int     viewbox[4], linkbox[4];
+
+   // things are drawn up to about 23 units out from their centre
+   const bool inview = AM_windowBlocks(zerolink, 32.0, viewbox);
    
    // for all sectors
    for(int i = 0; i < numsectors; i++)
    {
-      Mobj *t = sectors[i].thinglist;
+      const sector_t &sector = sectors[i];
+      const int      *box    = inview ? viewbox : nullptr;
+
+      // skip sectors out of the window; their block boxes take in every
+      // thing within them
+      if(mapportal_overlay && sector.groupid != plr->mo->groupid)
+      {
+         const linkoffset_t *link = P_GetLinkOffset(sector.groupid, plr->mo->groupid);
+         box = AM_windowBlocks(*link, 32.0, linkbox) ? linkbox : nullptr;
+      }
+
+      if(!box ||
+         sector.blockbox[BOXRIGHT] < box[BOXLEFT] || sector.blockbox[BOXLEFT] > box[BOXRIGHT] ||
+         sector.blockbox[BOXTOP] < box[BOXBOTTOM] || sector.blockbox[BOXBOTTOM] > box[BOXTOP])
+      {
+         continue;
+      }
+
+      Mobj *t = sector.thinglist;
 
       while(t) // for all things in that sector
       {
@@ -67,11 +67,15 @@
 extern const char *shiftxform;
 static void Egg();
 
-// the messages (what you see in the console window)
-static char  msgtext[MESSAGES*LINELENGTH];
-static char *messages[MESSAGES];
-static int   message_pos = 0;   // position in the history (last line in window)
-static int   message_last = 0;  // the last message
+// the messages (what you see in the console window), a ring of lines
+// starting at message_base; message indices count from the oldest kept
+static char         msgtext[MESSAGES*LINELENGTH];
+static int          message_base = 0;  // ring slot of the oldest line
+static int          message_pos = 0;   // position in the history (last line in window)
+static int          message_last = 0;  // the last message
+static int          message_len = 0;   // length of the last message
+static int          message_width = 0; // and its width in c_font
+static unsigned int message_gen = 0;   // bumped whenever any line changes
 
 // the command history(what you type in)
 static char history[HISTORY][LINELENGTH];
@@ -96,6 +100,13 @@ static FILE *console_log = nullptr;
 static VBuffer cback;
 static bool cbackneedfree = false;
 
+// The backdrop with the message lines drawn over it, redrawn only when the
+// lines or the scroll position change and otherwise blitted as it is.
+static VBuffer      ctext;
+static bool         ctextvalid = false;
+static unsigned int ctextgen;
+static int          ctextpos, ctextlift;
+
 vfont_t *c_font;
 char *c_fontname;
 
@@ -138,12 +149,16 @@ void C_InitBackdrop()
    if(cbackneedfree)
    {
       V_FreeVBuffer(&cback);
+      V_FreeVBuffer(&ctext);
    }
    else
       cbackneedfree = true;
 
    V_InitVBuffer(&cback, video.width, video.height, video.bitdepth);
    V_SetScaling(&cback, SCREENWIDTH, SCREENHEIGHT);
+   V_InitVBuffer(&ctext, video.width, video.height, video.bitdepth);
+   V_SetScaling(&ctext, SCREENWIDTH, SCREENHEIGHT);
+   ctextvalid = false;
    
    if((lumpnum = W_CheckNumForName(lumpname)) < 0)
       return;
@@ -173,15 +188,13 @@ static void C_updateInputPoint()
 // initialise the console
 
 //
-// C_initMessageBuffer
+// C_messageLine
 //
-// haleyjd 05/30/11: long overdue rewrite of the console message buffer.
-// Sets messages[] to point into the msgtext buffer.
+// Returns a message line by its index from the oldest kept.
 //
-static void C_initMessageBuffer()
+static char *C_messageLine(int message)
 {
-   for(int i = 0; i < MESSAGES; i++)
-      messages[i] = &msgtext[i * LINELENGTH];
+   return &msgtext[((message_base + message) % MESSAGES) * LINELENGTH];
 }
 
 void C_Init()
@@ -189,9 +202,6 @@ void C_Init()
    // haleyjd: initialize console qstrings
    inputtext.createSize(100);
 
-   // haleyjd: initialize console message buffer
-   C_initMessageBuffer();
-
    Console.enabled = true;
 
    if(!(c_font = E_FontForName(c_fontname)))
@@ -460,6 +470,46 @@ bool C_Responder(event_t *ev)
 }
 
 
+//
+// C_updateTextLayer
+//
+// Redraws the message lines over a copy of the backdrop, as they stand with
+// the console fully down, if anything about them changed. The drawer then
+// blits the bottom of it, so that lines are not laid out and drawn again
+// every frame while the console is open or moving.
+//
+static void C_updateTextLayer(int lift)
+{
+   if(ctextvalid && ctextgen == message_gen && ctextpos == message_pos &&
+      ctextlift == lift)
+      return;
+
+   ctextvalid = true;
+   ctextgen   = message_gen;
+   ctextpos   = message_pos;
+   ctextlift  = lift;
+
+   V_BlitVBuffer(&ctext, 0, 0, &cback, 0, 0, cback.width, cback.height);
+
+   int y = (ctext.scaled ? SCREENHEIGHT : ctext.height) - lift - 1;
+
+   // start at our position in the message history
+   int count = message_pos;
+
+   while(1)
+   {
+      // move up one line on the screen
+      // back one line in the history
+      y -= c_font->absh;
+
+      if(--count < 0) break;        // end of message history?
+      if(y <= -c_font->absh) break; // past top of screen?
+
+      // draw this line
+      V_FontWriteText(c_font, C_messageLine(count), 1, y, &ctext);
+   }
+}
+
 // draw the console
 
 //
@@ -470,8 +520,6 @@ bool C_Responder(event_t *ev)
 
 void C_Drawer(void)
 {
-   int y;
-   int count;
    int real_height;
    static int oldscreenheight = 0;
    static int oldscreenwidth = 0;
@@ -500,34 +548,13 @@ void C_Drawer(void)
    real_height = 
       cback.scaled ? cback.y2lookup[currentHeight - 1] + 1 :currentHeight;
 
-   // draw backdrop
-   // SoM: use the VBuffer
-   V_BlitVBuffer(&vbscreen, 0, 0, &cback, 0, 
-                 cback.height - real_height, cback.width, real_height);
-
-   //////////////////////////////////////////////////////////////////////
-   // draw text messages
-   
    // offset starting point up by 8 if we are showing input prompt
-   
-   y = currentHeight -
-         ((Console.showprompt && message_pos == message_last) ? c_font->absh : 0) - 1;
+   C_updateTextLayer((Console.showprompt && message_pos == message_last) ? c_font->absh : 0);
 
-   // start at our position in the message history
-   count = message_pos;
-        
-   while(1)
-   {
-      // move up one line on the screen
-      // back one line in the history
-      y -= c_font->absh;
-      
-      if(--count < 0) break;        // end of message history?
-      if(y <= -c_font->absh) break; // past top of screen?
-      
-      // draw this line
-      V_FontWriteText(c_font, messages[count], 1, y);
-   }
+   // draw backdrop and text messages
+   // SoM: use the VBuffer
+   V_BlitVBuffer(&vbscreen, 0, 0, &ctext, 0, 
+                 ctext.height - real_height, ctext.width, real_height);
 
    //////////////////////////////////
    // Draw input line
@@ -576,10 +603,6 @@ void C_Update(void)
 // I/O Functions
 //
 
-// haleyjd 05/30/11: Number of messages to cut from the history buffer when
-// the buffer is full.
-#define MESSAGECUT 64
-
 //
 // C_ScrollUp
 //
@@ -589,33 +612,40 @@ void C_Update(void)
 //
 static void C_ScrollUp(void)
 {
-   if(message_last == message_pos)
-      message_pos++;   
-   message_last++;
-
-   if(message_last >= MESSAGES) // past the end of the string
+   if(message_last == MESSAGES - 1)
    {
-      // cut off the oldest messages
-      int i, j;
-      char *tempptrs[MESSAGECUT];
-
-      for(i = 0; i < MESSAGECUT; i++) // save off the first MESSAGECUT pointers
-         tempptrs[i] = messages[i];
+      // the ring is full: the oldest line makes way, and a window scrolled
+      // back stays on the lines it shows
+      message_base = (message_base + 1) % MESSAGES;
+      if(message_pos < message_last && message_pos > 0)
+         message_pos--;
+   }
+   else
+   {
+      if(message_last == message_pos)
+         message_pos++;
+      message_last++;
+   }
 
-      for(i = MESSAGECUT; i < MESSAGES; i++) // shift down the message buffer
-         messages[i - MESSAGECUT] = messages[i];
+   *C_messageLine(message_last) = '\0'; // new line is empty
+   message_len   = 0;
+   message_width = 0;
+   ++message_gen;
+}
 
-      for(i = MESSAGES - MESSAGECUT, j = 0; i < MESSAGES; i++, j++) // fill end
-         messages[i] = tempptrs[j];
-      
-      message_last -= MESSAGECUT; // move the message boundary
+//
+// C_addMessageChar
+//
+// Appends a character to the last message, keeping its length and width.
+//
+static void C_addMessageChar(unsigned char c)
+{
+   char *line = C_messageLine(message_last);
 
-      // haleyjd 09/04/02: set message_pos to message_last
-      // to avoid problems with console flooding
-      message_pos = message_last;
-   }
-   
-   memset(messages[message_last], 0, LINELENGTH); // new line is empty
+   line[message_len++] = char(c);
+   line[message_len]   = '\0';
+   message_width += V_FontCharWidth(c_font, char(c));
+   ++message_gen;
 }
 
 // 
@@ -631,19 +661,13 @@ static void C_ScrollUp(void)
 static void C_AddMessage(const char *s)
 {
    const unsigned char *c;
-   unsigned char *end;
    unsigned char linecolor = GameModeInfo->colorNormal + 128;
    bool lastend = false;
 
    // haleyjd 09/04/02: set color to default at beginning
-   if(V_FontStringWidth(c_font, messages[message_last]) > SCREENWIDTH-9 ||
-      strlen(messages[message_last]) >= LINELENGTH - 1)
-   {
+   if(message_width > SCREENWIDTH-9 || message_len >= LINELENGTH - 1)
       C_ScrollUp();
-   }
-   end = (unsigned char *)(messages[message_last] + strlen(messages[message_last]));
-   *end++ = linecolor;
-   *end = '\0';
+   C_addMessageChar(linecolor);
 
    for(c = (const unsigned char *)s; *c; c++)
    {
@@ -656,19 +680,14 @@ static void C_AddMessage(const char *s)
             (*c >= TEXT_COLOR_NORMAL && *c <= TEXT_COLOR_ERROR))
             linecolor = *c;
 
-         if(V_FontStringWidth(c_font, messages[message_last]) > SCREENWIDTH-8 ||
-            strlen(messages[message_last]) >= LINELENGTH - 1)
+         if(message_width > SCREENWIDTH-8 || message_len >= LINELENGTH - 1)
          {
             // might possibly over-run, go onto next line
             C_ScrollUp();
-            end = (unsigned char *)(messages[message_last] + strlen(messages[message_last]));
-            *end++ = linecolor; // keep current color on next line
-            *end = '\0';
+            C_addMessageChar(linecolor); // keep current color on next line
          }
          
-         end = (unsigned char *)(messages[message_last] + strlen(messages[message_last]));
-         *end++ = *c;
-         *end = '\0';
+         C_addMessageChar(*c);
       }
       if(*c == '\a') // alert
       {
@@ -677,9 +696,7 @@ static void C_AddMessage(const char *s)
       if(*c == '\n')
       {
          C_ScrollUp();
-         end = (unsigned char *)(messages[message_last] + strlen(messages[message_last]));
-         *end++ = linecolor; // keep current color on next line
-         *end = '\0';
+         C_addMessageChar(linecolor); // keep current color on next line
          lastend = true;
       }
    }
@@ -836,9 +853,9 @@ void C_DumpMessages(qstring *filename)
    {
       // strip color codes from strings
       memset(tmpmessage, 0, LINELENGTH);
-      len = static_cast<int>(strlen(messages[i]));
+      len = static_cast<int>(strlen(C_messageLine(i)));
 
-      C_StripColorChars((unsigned char *)messages[i], tmpmessage, len);
+      C_StripColorChars((unsigned char *)C_messageLine(i), tmpmessage, len);
 
       fprintf(outfile, "%s\n", tmpmessage);
    }
@@ -1069,5 +1086,7 @@ static void Egg()
                    FC_BROWN "my hair looks much too\n"
                    "dark in this pic.\n"
                    "oh well, have fun!\n-- fraggle", 160, 168, &cback);
+
+   ctextvalid = false;
 }
 // EOF
@@ -46,6 +46,8 @@
 #include "doomstat.h"
 #include "g_game.h"
 #include "m_argv.h"
+#include "m_collection.h"
+#include "m_compare.h"
 #include "m_misc.h"
 #include "m_utils.h"
 #include "mn_engin.h"
@@ -57,6 +59,7 @@ static void C_SetVariable(command_t *command);
 static void C_RunAlias(alias_t *alias);
 static int  C_Sync(command_t *command);
 static void C_ArgvtoArgs();
+static void C_runArgv(command_t *command);
 static bool C_Strcmp(const char *pa, const char *pb);
 
 //=============================================================================
@@ -76,29 +79,38 @@ static int numtokens;
 static int numtokensalloc;
 
 //
-// C_nextCmdToken
+// C_growCmdTokens
 //
-// haleyjd 08/08/10: Used to remove SMMU limit on console command tokens.
+// Adds MAXTOKENS more tokens to both the tokenizer and Console.argv.
 //
-static void C_nextCmdToken()
+static void C_growCmdTokens()
 {
-   if(numtokens >= numtokensalloc)
-   {
-      int i;
+   const int oldalloc = numtokensalloc;
+   int i;
 
-      // grow by MAXTOKENS at a time (doubling is likely to waste memory)
-      numtokensalloc += MAXTOKENS;
-      cmdtokens = erealloc(qstring **, cmdtokens, numtokensalloc * sizeof(qstring *));
+   // grow by MAXTOKENS at a time (doubling is likely to waste memory)
+   numtokensalloc += MAXTOKENS;
+   cmdtokens = erealloc(qstring **, cmdtokens, numtokensalloc * sizeof(qstring *));
 
-      for(i = numtokens; i < numtokensalloc; i++)
-         cmdtokens[i] = new qstring(128);
+   for(i = oldalloc; i < numtokensalloc; i++)
+      cmdtokens[i] = new qstring(128);
 
-      Console.numargvsalloc += MAXTOKENS;
-      Console.argv = erealloc(qstring **, Console.argv, Console.numargvsalloc * sizeof(qstring *));
+   Console.numargvsalloc += MAXTOKENS;
+   Console.argv = erealloc(qstring **, Console.argv, Console.numargvsalloc * sizeof(qstring *));
 
-      for(i = numtokens; i < Console.numargvsalloc; i++)
-         Console.argv[i] = new qstring(128);
-   }
+   for(i = oldalloc; i < Console.numargvsalloc; i++)
+      Console.argv[i] = new qstring(128);
+}
+
+//
+// C_nextCmdToken
+//
+// haleyjd 08/08/10: Used to remove SMMU limit on console command tokens.
+//
+static void C_nextCmdToken()
+{
+   if(numtokens >= numtokensalloc)
+      C_growCmdTokens();
    numtokens++;
 }
 
@@ -337,15 +349,25 @@ void C_RunCommand(command_t *command, const char *options)
 //
 static void C_DoRunCommand(command_t *command, const char *options)
 {
-   int i;
-   const char *errormsg = nullptr;
-   
    C_GetTokens(options);
    
-   for(i = 0; i < numtokensalloc; i++)
+   for(int i = 0; i < numtokensalloc; i++)
       *(Console.argv[i]) = *cmdtokens[i];
 
    Console.argc = numtokens;
+   C_runArgv(command);
+}
+
+//
+// C_runArgv
+//
+// Runs a command on the arguments already in Console.argv.
+//
+static void C_runArgv(command_t *command)
+{
+   int i;
+   const char *errormsg = nullptr;
+
    Console.command = command;
    
    // perform checks
@@ -1176,6 +1198,7 @@ alias_t *C_NewAlias(const char *aliasname, const char *command)
    if((alias = C_GetAlias(aliasname)))
    {
       efree(alias->command);
+      C_FreeCommandLine(alias->cmdline);
       alias->command = estrdup(command);
    }
    else
@@ -1188,6 +1211,8 @@ alias_t *C_NewAlias(const char *aliasname, const char *command)
       aliases.next = alias;
    }
 
+   alias->cmdline = C_ParseCommandLine(command);
+
    return alias;
 }
 
@@ -1225,6 +1250,7 @@ void C_RemoveAlias(qstring *aliasname)
    // free alias data
    efree(alias->name);
    efree(alias->command);
+   C_FreeCommandLine(alias->cmdline);
 
    // unlink alias
    prev->next  = alias->next;
@@ -1242,7 +1268,7 @@ static void C_RunAlias(alias_t *alias)
    while(*cmdoptions == ' ')
       cmdoptions++;
 
-   C_RunTextCmd(alias->command);   // run the command
+   C_RunCommandLine(alias->cmdline);   // run the command
 }
 
 //=============================================================================
@@ -1412,6 +1438,189 @@ static bool C_Strcmp(const char *pa, const char *pb)
    return false;       // no difference in them
 }
 
+//
+// C_runsNow
+//
+// True if the command would be run straight away rather than buffered.
+//
+static bool C_runsNow(int cmtype, const command_t *command)
+{
+   return !(command->flags & cf_buffered) && buffers[cmtype].timer == 0;
+}
+
+//=============================================================================
+//
+// Pre-parsed Command Lines
+//
+// Command lines that are run over and over, such as those of key bindings
+// and aliases, are split into their commands, looked up and broken into
+// tokens once. Running one then only copies its tokens into Console.argv.
+// Whatever was not a command when the line was parsed, such as an alias or
+// a command added later, is run from its text as before.
+//
+
+struct cmdlinepart_t
+{
+   char       *text;      // the command as written, less leading spaces
+   command_t  *command;   // what it runs, if it was a command when parsed
+   const char *options;   // the text after the command name
+   qstring    *tokens;    // the options broken into tokens
+   int         numtokens;
+};
+
+struct cmdline_t
+{
+   PODCollection<cmdlinepart_t> parts;
+   int  running; // nesting depth of C_RunCommandLine calls on it
+   bool freed;   // C_FreeCommandLine was called while running
+};
+
+//
+// C_addCommandLinePart
+//
+// Parses one command of a command line, as C_RunIndivTextCmd would run it.
+//
+static void C_addCommandLinePart(cmdline_t *cmdline, const char *text, size_t len)
+{
+   qstring cmdtext;
+
+   cmdtext.copy(text, len);
+
+   const char *cmdname = cmdtext.constPtr();
+   while(*cmdname == ' ')
+      cmdname++;
+
+   C_GetTokens(cmdname);
+
+   if(!numtokens)
+      return; // no command
+
+   cmdlinepart_t &part = cmdline->parts.addNew();
+
+   part.text      = estrdup(cmdname);
+   part.command   = C_GetCmdForName(cmdtokens[0]->constPtr());
+   part.options   = part.text + cmdtokens[0]->length();
+   part.tokens    = nullptr;
+   part.numtokens = 0;
+
+   if(part.command)
+   {
+      C_GetTokens(part.options);
+
+      part.numtokens = numtokens;
+      part.tokens    = new qstring [emax(numtokens, 1)];
+      for(int i = 0; i < numtokens; i++)
+         part.tokens[i] = *cmdtokens[i];
+   }
+}
+
+//
+// C_ParseCommandLine
+//
+// Splits a compound command (with or without ;'s) into its commands, the
+// same way C_RunTextCmd does.
+//
+cmdline_t *C_ParseCommandLine(const char *command)
+{
+   cmdline_t *cmdline = new cmdline_t;
+   bool quotemark = false;
+   const char *start = command;
+
+   cmdline->running = 0;
+   cmdline->freed   = false;
+
+   for(const char *rover = command; *rover; rover++)
+   {
+      if(*rover == '\"')
+         quotemark = !quotemark;
+      else if(*rover == ';' && !quotemark)
+      {
+         C_addCommandLinePart(cmdline, start, rover - start);
+         start = rover + 1;
+      }
+   }
+   C_addCommandLinePart(cmdline, start, strlen(start));
+
+   return cmdline;
+}
+
+//
+// C_deleteCommandLine
+//
+static void C_deleteCommandLine(cmdline_t *cmdline)
+{
+   for(cmdlinepart_t &part : cmdline->parts)
+   {
+      efree(part.text);
+      delete [] part.tokens;
+   }
+   delete cmdline;
+}
+
+//
+// C_FreeCommandLine
+//
+// Frees a parsed command line. One that is running, such as an alias that
+// redefines itself, goes once it has finished.
+//
+void C_FreeCommandLine(cmdline_t *cmdline)
+{
+   if(!cmdline)
+      return;
+
+   if(cmdline->running)
+      cmdline->freed = true;
+   else
+      C_deleteCommandLine(cmdline);
+}
+
+//
+// C_RunCommandLine
+//
+// Runs a parsed command line, with the same effect as C_RunTextCmd on the
+// text it was parsed from.
+//
+void C_RunCommandLine(cmdline_t *cmdline)
+{
+   cmdline->running++;
+
+   for(const cmdlinepart_t &part : cmdline->parts)
+   {
+      command_t *command = part.command;
+
+      if(!command)
+      {
+         C_RunIndivTextCmd(part.text);
+         continue;
+      }
+
+      if(!C_runsNow(Console.cmdtype, command))
+      {
+         C_RunCommand(command, part.options);
+         continue;
+      }
+
+      // as C_RunCommand would, less tokenizing the options again
+      C_initCmdTokens();
+      while(Console.numargvsalloc < part.numtokens)
+         C_growCmdTokens();
+
+      for(int i = 0; i < Console.numargvsalloc; i++)
+      {
+         if(i < part.numtokens)
+            *Console.argv[i] = part.tokens[i];
+         else
+            Console.argv[i]->clear();
+      }
+
+      Console.argc = part.numtokens;
+      C_runArgv(command);
+   }
+
+   if(!--cmdline->running && cmdline->freed)
+      C_deleteCommandLine(cmdline);
+}
+
 //=============================================================================
 //
 // Command hashing
@@ -45,7 +45,7 @@ struct variable_t;
 //
 
 #define MAXTOKENS 64
-#define CMDCHAINS 16
+#define CMDCHAINS 257
 
 // zdoom _inspired_:
 
@@ -329,10 +329,13 @@ struct command_t
   command_t *next;       // for hashing
 };
 
+struct cmdline_t;
+
 struct alias_t
 {
   char *name;
   char *command;
+  cmdline_t *cmdline; // command, parsed
   
   alias_t *next; // haleyjd 04/14/03
 };
@@ -403,6 +406,11 @@ extern console_t Console; // the one and only Console object
 void C_RunCommand(command_t *command, const char *options);
 void C_RunTextCmd(const char *cmdname);
 
+// command lines parsed once to be run many times
+cmdline_t *C_ParseCommandLine(const char *command);
+void       C_RunCommandLine(cmdline_t *cmdline);
+void       C_FreeCommandLine(cmdline_t *cmdline);
+
 const char *C_VariableValue(variable_t *command);
 const char *C_VariableStringValue(variable_t *command);
 
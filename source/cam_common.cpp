@@ -25,6 +25,8 @@
 // Authors: James Haley, Ioan Chera, Max Waine
 //
 
+#include <memory>
+
 #include "z_zone.h"
 
 #include "cam_common.h"
@@ -43,14 +45,58 @@
 #define VALID_ISSET(set, i) ((set)[(i) >> 3] & (1 << ((i) & 7)))
 #define VALID_SET(set, i) ((set)[(i) >> 3] |= 1 << ((i) & 7))
 
+//
+// Scratch space of one traversal. Traversals nest, through portals and
+// through whatever their callbacks do, so each live one holds its own.
+//
+struct PathTraverser::Scratch
+{
+   std::vector<byte> validlines;
+   std::vector<byte> validpolys;
+   std::vector<intercept_t> intercepts;
+};
+
+// Scratch not in use by a live traversal on this thread
+static thread_local std::vector<std::unique_ptr<PathTraverser::Scratch>> freescratch;
+
+//
+// Takes scratch space from this thread's free list, or makes more. Keeping
+// the buffers' capacity means a traversal costs no allocations once warm.
+//
+PathTraverser::Scratch *PathTraverser::acquireScratch()
+{
+   Scratch *scratch;
+
+   if(freescratch.empty())
+      scratch = new Scratch;
+   else
+   {
+      scratch = freescratch.back().release();
+      freescratch.pop_back();
+   }
+
+   scratch->validlines.assign((::numlines + 7) / 8, 0);
+   scratch->validpolys.assign((::numPolyObjects + 7) / 8, 0);
+   scratch->intercepts.clear();
+   return scratch;
+}
+
 //
 // Constructor. Initializes dynamic structures
 //
 PathTraverser::PathTraverser(const PTDef &indef, void *incontext) :
-   trace(), def(indef), context(incontext), portalguard()
+   trace(), def(indef), context(incontext), scratch(acquireScratch()),
+   validlines(scratch->validlines), validpolys(scratch->validpolys),
+   portalguard(), intercepts(scratch->intercepts)
+{
+}
+
+//
+// Gives the scratch space back for the next traversal
+//
+PathTraverser::~PathTraverser()
 {
-   VALID_ALLOC(validlines, ::numlines);
-   VALID_ALLOC(validpolys, ::numPolyObjects);
+   freescratch.emplace_back(scratch);
 }
 
 
@@ -58,20 +104,21 @@ PathTraverser::PathTraverser(const PTDef &indef, void *incontext) :
 //
 // Handles intercepts in order
 //
-bool PathTraverser::traverseIntercepts() const
+bool PathTraverser::traverseIntercepts()
 {
    size_t    count;
    fixed_t   dist;
    divline_t dl;
-   PODCollection<intercept_t>::iterator scan, end, in;
+   const intercept_t *end;
+   intercept_t *scan, *in;
 
-   count = intercepts.getLength();
-   end = intercepts.end();
+   count = intercepts.size();
+   end = intercepts.data() + count;
 
    //
    // calculate intercept distance
    //
-   for(scan = intercepts.begin(); scan < end; scan++)
+   for(scan = intercepts.data(); scan < end; scan++)
    {
       if(!scan->isaline)
          continue;   // ioanch 20151230: only lines need this treatment
@@ -89,7 +136,7 @@ bool PathTraverser::traverseIntercepts() const
    {
       dist = D_MAXINT;
 
-      for(scan = intercepts.begin(); scan < end; scan++)
+      for(scan = intercepts.data(); scan < end; scan++)
       {
          if(scan->frac < dist)
          {
@@ -163,7 +210,7 @@ bool PathTraverser::blockThingsIterator(int x, int y)
       if(frac < 0)
          continue;                // behind source
 
-      intercept_t &inter = intercepts.addNew();
+      intercept_t &inter = intercepts.emplace_back();
       inter.frac = frac;
       inter.isaline = false;
       inter.d.thing = thing;
@@ -211,7 +258,7 @@ bool PathTraverser::checkLine(size_t linenum)
    }
 
    // store the line for later intersection testing
-   intercept_t &inter = intercepts.addNew();
+   intercept_t &inter = intercepts.emplace_back();
    inter.isaline = true;
    inter.d.line = ld;
 
@@ -22,13 +22,12 @@
 #ifndef CAM_COMMON_H_
 #define CAM_COMMON_H_
 
+#include <vector>
+
 #include "m_collection.h"
 #include "p_maputl.h"
 #include "r_defs.h"
 
-#define VALID_ALLOC(set, n) ((set) = ecalloc(byte *, 1, (((n) + 7) & ~7) / 8))
-#define VALID_FREE(set) efree(set)
-
 //
 // PathTraverser setup
 //
@@ -49,6 +48,10 @@ struct PTDef
 //
 // Reentrant path-traverse caller
 //
+// Scratch space comes from the C++ heap rather than the zone, so sight checks
+// can also run on worker threads. It is kept per thread and reused, since
+// hitscan attacks run one traversal per pellet.
+//
 class PathTraverser
 {
 public:
@@ -58,29 +61,33 @@ public:
       return traverse(c.x, c.y, t.x, t.y);
    }
    PathTraverser(const PTDef &indef, void *incontext);
-   ~PathTraverser()
-   {
-      VALID_FREE(validlines);
-      VALID_FREE(validpolys);
-   }
+   ~PathTraverser();
+
+   PathTraverser(const PathTraverser &) = delete;
+   PathTraverser &operator = (const PathTraverser &) = delete;
 
    divline_t trace;
+   struct Scratch;
+
 private:
+   static Scratch *acquireScratch();
+
    bool checkLine(size_t linenum);
    bool blockLinesIterator(int x, int y);
    bool blockThingsIterator(int x, int y);
-   bool traverseIntercepts() const;
+   bool traverseIntercepts();
 
    const PTDef def;
    void *const context;
-   byte *validlines;
-   byte *validpolys;
+   Scratch *const scratch;
+   std::vector<byte> &validlines;
+   std::vector<byte> &validpolys;
    struct
    {
       bool hitpblock;
       bool addedportal;
    } portalguard;
-   PODCollection<intercept_t> intercepts;
+   std::vector<intercept_t> &intercepts;
 };
 
 //
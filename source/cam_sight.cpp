@@ -24,12 +24,18 @@
 // Authors: James Haley, Ioan Chera
 //
 
+#include <atomic>
+#include <vector>
+
 #include "z_zone.h"
 
+#include "c_io.h"
+#include "c_runcmd.h"
 #include "cam_common.h"
 #include "cam_sight.h"
 #include "doomstat.h"   // ioanch 20160101: for bullet attacks
 #include "d_gi.h"       // ioanch 20160131: for use
+#include "d_jobs.h"
 #include "d_player.h"   // ioanch 20151230: for autoaim
 #include "m_compare.h"  // ioanch 20160103: refactor
 #include "e_exdata.h"
@@ -50,6 +56,7 @@
 #include "r_sky.h"      // ioanch 20160101: for bullets hitting sky
 #include "r_state.h"
 #include "s_sound.h"    // ioanch 20160131: for use
+#include "v_misc.h"
 
 #define RECURSION_LIMIT 64
 
@@ -76,8 +83,8 @@ public:
    fixed_t openbottom;  // bottom of linedef silhouette
    fixed_t openrange;   // height of opening
 
-   // Intercepts vector
-   PODCollection<intercept_t> intercepts;
+   // Intercepts vector; not zone-backed, as prefetched checks run on workers
+   std::vector<intercept_t> intercepts;
 
    // portal traversal information
    int  fromid;        // current source group id
@@ -441,6 +448,11 @@ bool CamContext::checkSight(const camsightparams_t &params,
       // is there a link between these groups?
       // if so, ignore reject
       link = P_GetLinkIfExists(params.cgroupid, params.tgroupid);
+
+      // The link table is closed over chains of portals, so without a link
+      // no recursion can ever reach the target's group: don't trace at all.
+      if(!link && useportalgroups)
+         return false;
    }
 
    const sector_t *csec, *tsec;
@@ -519,6 +531,84 @@ bool CamContext::checkSight(const camsightparams_t &params,
    return result;
 }
 
+//=============================================================================
+//
+// Sight cache
+//
+// Crowds of monsters check sight against the same player several times per
+// tic from unchanged positions. Results are remembered under the complete
+// set of parameters, so a hit returns exactly what a fresh check would. The
+// cache is emptied every tic and whenever something a check depends on may
+// have changed: sector heights, portal states, polyobjects, specials and ACS.
+//
+
+struct camsightentry_t
+{
+   fixed_t      cx, cy, cz, cheight;
+   fixed_t      tx, ty, tz, theight;
+   int          cgroupid, tgroupid;
+   unsigned int generation;
+   bool         result;
+};
+
+static constexpr int NUMSIGHTCACHE = 1024; // power of two
+
+static camsightentry_t camsightcache[NUMSIGHTCACHE];
+static unsigned int    camsightgeneration = 1;
+
+static uint64_t camsighthits, camsightmisses, camsightflushes, camsightprefetches;
+
+//
+// Forgets every cached result.
+//
+void CAM_InvalidateSightCache()
+{
+   if(++camsightgeneration == 0)
+   {
+      // wrapped; old entries could match again
+      memset(camsightcache, 0, sizeof(camsightcache));
+      camsightgeneration = 1;
+   }
+   ++camsightflushes;
+}
+
+static bool CAM_sightEntryMatches(const camsightentry_t &entry, const camsightparams_t &params)
+{
+   return entry.generation == camsightgeneration &&
+          entry.cx == params.cx && entry.cy == params.cy && entry.cz == params.cz &&
+          entry.cheight == params.cheight &&
+          entry.tx == params.tx && entry.ty == params.ty && entry.tz == params.tz &&
+          entry.theight == params.theight &&
+          entry.cgroupid == params.cgroupid && entry.tgroupid == params.tgroupid;
+}
+
+static camsightentry_t &CAM_sightEntry(const camsightparams_t &params)
+{
+   uint32_t hash = 2166136261u;
+   for(fixed_t value : { params.cx, params.cy, params.cz, params.cheight,
+                         params.tx, params.ty, params.tz, params.theight,
+                         fixed_t(params.cgroupid), fixed_t(params.tgroupid) })
+      hash = (hash ^ uint32_t(value)) * 16777619u;
+   return camsightcache[(hash ^ (hash >> 16)) & (NUMSIGHTCACHE - 1)];
+}
+
+static void CAM_storeSightEntry(camsightentry_t &entry, const camsightparams_t &params,
+                                bool result)
+{
+   entry.cx         = params.cx;
+   entry.cy         = params.cy;
+   entry.cz         = params.cz;
+   entry.cheight    = params.cheight;
+   entry.tx         = params.tx;
+   entry.ty         = params.ty;
+   entry.tz         = params.tz;
+   entry.theight    = params.theight;
+   entry.cgroupid   = params.cgroupid;
+   entry.tgroupid   = params.tgroupid;
+   entry.generation = camsightgeneration;
+   entry.result     = result;
+}
+
 //
 // CAM_CheckSight
 //
@@ -526,7 +616,103 @@ bool CamContext::checkSight(const camsightparams_t &params,
 //
 bool CAM_CheckSight(const camsightparams_t &params)
 {
-   return CamContext::checkSight(params, nullptr);
+   camsightentry_t &entry = CAM_sightEntry(params);
+
+   if(CAM_sightEntryMatches(entry, params))
+   {
+      ++camsighthits;
+      return entry.result;
+   }
+   ++camsightmisses;
+
+   const bool result = CamContext::checkSight(params, nullptr);
+   CAM_storeSightEntry(entry, params, result);
+
+   return result;
+}
+
+//
+// Sight prefetching
+//
+// The checks themselves only read the level, so a batch of them can be
+// worked out across threads while the main thread waits, and the results
+// filed in the cache in batch order. A later check returns a prefetched
+// result only if it asks exactly the same question before anything it
+// depends on changes, so nothing downstream can tell the difference.
+//
+
+static constexpr int SIGHTPREFETCH_MINCHECKS = 128; // not worth the threads below this
+static constexpr int SIGHTPREFETCH_MAXTHREADS = 8;
+
+struct camsightjob_t
+{
+   const camsightparams_t *params;
+   std::vector<char>       results;
+   std::atomic<int>        next;
+   int                     count;
+};
+
+static void CAM_sightJobThread(camsightjob_t *job)
+{
+   int i;
+   while((i = job->next.fetch_add(1)) < job->count)
+      job->results[i] = CamContext::checkSight(job->params[i], nullptr);
+}
+
+//
+// Works out a batch of sight checks ahead of time. Checks already cached
+// are skipped, and small batches are left to be checked as they come.
+//
+void CAM_PrefetchSight(const camsightparams_t *params, int count)
+{
+   const int numthreads = eclamp(D_NumJobWorkers() + 1, 1, SIGHTPREFETCH_MAXTHREADS);
+   if(numthreads < 2 || count < SIGHTPREFETCH_MINCHECKS)
+      return;
+
+   PODCollection<camsightparams_t> todo;
+   for(int i = 0; i < count; i++)
+   {
+      if(!CAM_sightEntryMatches(CAM_sightEntry(params[i]), params[i]))
+         todo.add(params[i]);
+   }
+
+   const int numchecks = int(todo.getLength());
+   if(numchecks < SIGHTPREFETCH_MINCHECKS)
+      return;
+
+   camsightjob_t job;
+   job.params = &todo[0];
+   job.results.resize(numchecks);
+   job.next  = 0;
+   job.count = numchecks;
+
+   D_RunParallel(numthreads, [&job] (int) { CAM_sightJobThread(&job); });
+
+   for(int i = 0; i < numchecks; i++)
+      CAM_storeSightEntry(CAM_sightEntry(todo[i]), todo[i], job.results[i] != 0);
+   camsightprefetches += numchecks;
+}
+
+//
+// Sight cache hit rate; "reset" clears the counters.
+//
+CONSOLE_COMMAND(cam_sightstats, 0)
+{
+   if(Console.argc >= 1 && !Console.argv[0]->strCaseCmp("reset"))
+   {
+      camsighthits = camsightmisses = camsightflushes = camsightprefetches = 0;
+      C_Printf("Sight cache counters reset\n");
+      return;
+   }
+
+   const uint64_t total = camsighthits + camsightmisses;
+   C_Printf(FC_HI "Sight cache:\n" FC_NORMAL
+            "checks %llu, hits %llu (%.1f%%), flushes %llu, prefetched %llu\n",
+            static_cast<unsigned long long>(total),
+            static_cast<unsigned long long>(camsighthits),
+            total ? 100.0 * double(camsighthits) / double(total) : 0.0,
+            static_cast<unsigned long long>(camsightflushes),
+            static_cast<unsigned long long>(camsightprefetches));
 }
 
 // EOF
@@ -62,6 +62,8 @@ struct camsightparams_t
 };
 
 bool CAM_CheckSight(const camsightparams_t &params);
+void CAM_InvalidateSightCache();
+void CAM_PrefetchSight(const camsightparams_t *params, int count);
 
 fixed_t CAM_AimLineAttack(const Mobj *t1, angle_t angle, fixed_t distance, 
                           bool mask, Mobj **outTarget);
@@ -141,6 +141,60 @@ static deh_block deh_blocks[] =
    /* 17 */ {"",          deh_procError} // dummy to handle anything else
 };
 
+//
+// Hashed lookup of the key names of a block, in place of a linear search
+// that compares the key against every name before it. The chains are made on
+// first use and keep the names in table order, so the first of two equal
+// names still wins.
+//
+class DehKeyTable
+{
+public:
+   constexpr DehKeyTable(const char *const *pKeys, int pNumKeys)
+      : keys(pKeys), numkeys(pNumKeys), chains(nullptr)
+   {
+   }
+
+   //
+   // Returns the index of a key, or the number of keys if it isn't in the
+   // table, like E_StrToNumLinear.
+   //
+   int find(const char *key)
+   {
+      if(!chains)
+         init();
+
+      for(int i = chains[D_HashTableKey(key) % numkeys]; i != -1; i = chains[numkeys + i])
+      {
+         if(!strcasecmp(keys[i], key))
+            return i;
+      }
+
+      return numkeys;
+   }
+
+private:
+   const char *const *keys;
+   int numkeys;
+   int *chains; // numkeys chain heads, then the next key for each key
+
+   void init()
+   {
+      chains = estructalloc(int, numkeys * 2);
+
+      for(int i = 0; i < numkeys; i++)
+         chains[i] = -1;
+
+      for(int i = numkeys; --i >= 0; )
+      {
+         const unsigned int key = D_HashTableKey(keys[i]) % numkeys;
+
+         chains[numkeys + i] = chains[key];
+         chains[key] = i;
+      }
+   }
+};
+
 // flag to skip included deh-style text, used with INCLUDE NOTEXT directive
 static bool includenotext = false;
 
@@ -232,6 +286,8 @@ static constexpr const char *deh_mobjinfo[DEH_MOBJINFOMAX] =
 
 };
 
+static DehKeyTable deh_mobjinfoKeys(deh_mobjinfo, DEH_MOBJINFOMAX);
+
 // Strings that are used to indicate flags ("Bits" in mobjinfo)
 // This is an array of bit masks that are related to p_mobj.h
 // values, using the same names without the MF_ in front.
@@ -404,6 +460,7 @@ static dehflags_t deh_mobjflags[] =
   {"NOTAUTOAIMED",       0x00000001, 4}, // can't be autoaimed (for real)
   {"FULLVOLSOUNDS",      0x00000002, 4}, // full-volume see/death sounds
   {"ACTLIKEBRIDGE",      0x00000004, 4}, // unmoved by sector actions, and pickups can sit atop
+  {"NEVERDORMANT",       0x00000008, 4}, // always thinks every tic, even with p_dormantmonsters
 
   { nullptr,             0 }             // nullptr terminator
 };
@@ -523,6 +580,8 @@ static constexpr const char *deh_state[NUMDEHSTATEIDS] =
   "MBF21 Bits",
 };
 
+static DehKeyTable deh_stateKeys(deh_state, NUMDEHSTATEIDS);
+
 static dehflags_t deh_mbf21stateflags[] =
 {
    { "SKILL5FAST", 0x00000001 },
@@ -576,6 +635,8 @@ static constexpr const char *deh_sfxinfo[] =
   "Neg. One 2"  // .lumpnum
 };
 
+static DehKeyTable deh_sfxinfoKeys(deh_sfxinfo, NUMDEHSFXINFOIDS);
+
 // MUSICINFO is not supported in Dehacked.  Ignored here.
 // * music entries are base zero but have a dummy #0
 
@@ -622,6 +683,8 @@ static constexpr const char *deh_weapon[NUMDEHWEAPONIDS] =
   "MBF21 Bits",     // .flags
 };
 
+static DehKeyTable deh_weaponKeys(deh_weapon, NUMDEHWEAPONIDS);
+
 static dehflags_t deh_mbf21weaponflags[] =
 {
    { "NOTHRUST",       0x00000001 },
@@ -964,6 +1027,49 @@ static void deh_procBexCodePointers(DWFILE *fpin, char *line, MetaTable &gathere
    return;
 }
 
+//
+// Hash chains over the names of a flag set. Each chain keeps the flags in
+// list order, so the first match for a mode is the same as in a linear search.
+//
+struct dehflaghash_t
+{
+   int  numchains;
+   int *chains; // first flag of each chain, or -1
+   int *next;   // next flag in the same chain, or -1
+};
+
+//
+// deh_hashFlagSet
+//
+// Chains the flags of a set by name, the first time one is looked up.
+//
+static dehflaghash_t *deh_hashFlagSet(const dehflagset_t *flagset)
+{
+   dehflaghash_t *hash = estructalloc(dehflaghash_t, 1);
+   int numflags = 0;
+
+   while(flagset->flaglist[numflags].name)
+      ++numflags;
+
+   hash->numchains = emax(numflags, 1);
+   hash->chains    = estructalloc(int, hash->numchains);
+   hash->next      = estructalloc(int, hash->numchains);
+
+   for(int i = 0; i < hash->numchains; i++)
+      hash->chains[i] = -1;
+
+   // prepend from the end of the list, so each chain runs in list order
+   for(int i = numflags; --i >= 0; )
+   {
+      const unsigned int key = D_HashTableKey(flagset->flaglist[i].name) % hash->numchains;
+
+      hash->next[i]     = hash->chains[key];
+      hash->chains[key] = i;
+   }
+
+   return hash;
+}
+
 //
 // deh_ParseFlag
 //
@@ -973,8 +1079,15 @@ dehflags_t *deh_ParseFlag(const dehflagset_t *flagset, const char *name)
 {
    int mode = flagset->mode;
 
-   for(dehflags_t *flag = flagset->flaglist; flag->name; ++flag)
+   if(!flagset->hash)
+      flagset->hash = deh_hashFlagSet(flagset);
+
+   const dehflaghash_t *hash = flagset->hash;
+
+   for(int i = hash->chains[D_HashTableKey(name) % hash->numchains]; i != -1; i = hash->next[i])
    {
+      dehflags_t *flag = &flagset->flaglist[i];
+
       if(!strcasecmp(name, flag->name) &&
          (flag->index == mode || mode == DEHFLAGS_MODE_ALL))
       {
@@ -1299,7 +1412,7 @@ static void deh_procThing(DWFILE *fpin, char *line, MetaTable &gatheredData)
          continue;
       }
 
-      const int dehmobjinfoid = E_StrToNumLinear(deh_mobjinfo, DEH_MOBJINFOMAX, key);
+      const int dehmobjinfoid = deh_mobjinfoKeys.find(key);
       if(dehmobjinfoid != DEH_MOBJINFOMAX)
       {
          if(dehmobjinfoid == dehmobjinfoid_flags)
@@ -1446,7 +1559,7 @@ static void deh_procFrame(DWFILE *fpin, char *line, MetaTable &gatheredData)
       // haleyjd 08/09/02: significant reformatting, added new
       // fields
 
-      const int dehstateid = E_StrToNumLinear(deh_state, NUMDEHSTATEIDS, key);
+      const int dehstateid = deh_stateKeys.find(key);
       switch(dehstateid)
       {
       case dehstateid_sprite:  // Sprite number
@@ -1648,7 +1761,7 @@ static void deh_procSounds(DWFILE *fpin, char *line, MetaTable &gatheredData)
          continue;
       }
 
-      const int dehsfxinfoid = E_StrToNumLinear(deh_sfxinfo, NUMDEHSFXINFOIDS, key);
+      const int dehsfxinfoid = deh_sfxinfoKeys.find(key);
       switch(dehsfxinfoid)
       {
       case dehsfxinfoid_offset:  // Offset
@@ -1863,7 +1976,7 @@ static void deh_procWeapon(DWFILE *fpin, char *line, MetaTable &gatheredData)
 
       weaponinfo_t &weaponinfo = *E_WeaponForDEHNum(indexnum);
       // haleyjd: resolution adjusted for EDF
-      const int dehweaponid = E_StrToNumLinear(deh_weapon, NUMDEHWEAPONIDS, key);
+      const int dehweaponid = deh_weaponKeys.find(key);
       switch(dehweaponid)
       {
       case dehweaponid_ammoType:
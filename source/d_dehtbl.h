@@ -81,11 +81,14 @@ enum
    DEHFLAGS_MODE_ALL
 };
 
+struct dehflaghash_t;
+
 struct dehflagset_t
 {
    dehflags_t *flaglist;
    int mode;
    unsigned int results[MAXFLAGFIELDS];
+   mutable dehflaghash_t *hash; // flag name chains, made on first lookup
 };
 
 dehflags_t   *deh_ParseFlag(const dehflagset_t *flagset, const char *name);
@@ -36,6 +36,13 @@ namespace fs = std::filesystem;
 #include <experimental/filesystem>
 namespace fs = std::experimental::filesystem;
 #endif
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
 #include "z_zone.h"
 
 #include "hal/i_directory.h"
@@ -55,6 +62,7 @@ namespace fs = std::experimental::filesystem;
 #include "g_gfs.h"
 #include "i_system.h"
 #include "m_argv.h"
+#include "m_loadtrace.h"
 #include "m_misc.h"
 #include "m_utils.h"
 #include "p_setup.h"
@@ -1272,5 +1280,118 @@ void D_CloseAutoloadDir()
    autoload_dirname.freeBuffer();
 }
 
+//=============================================================================
+//
+// Readahead
+//
+// Once the WAD directory is built, the rest of startup is a chain of steps
+// which each need what the one before set up, and which all allocate from
+// the zone heap, so they stay on the main thread. What can run beside them
+// is reading: a thread reads the loaded archives through from start to end,
+// so that the lumps are in the system's file cache when they are wanted. It
+// touches nothing but the files, and stops when startup is done with them.
+//
+
+// Most the readahead thread reads, so huge archives don't flush the cache
+static constexpr uint64_t MAXREADAHEAD = 256 * 1024 * 1024;
+
+static std::thread              readaheadthread;
+static std::atomic<bool>        readaheadstop;
+static std::vector<std::string> readaheadfiles;
+
+static std::chrono::steady_clock::time_point readaheadstart, readaheadend;
+
+static void D_readaheadThreadFunc()
+{
+   static constexpr size_t CHUNKSIZE = 1024 * 1024;
+   std::unique_ptr<byte[]> chunk(new byte[CHUNKSIZE]);
+   uint64_t total = 0;
+
+   for(const std::string &filename : readaheadfiles)
+   {
+      FILE *f;
+
+      if(!(f = fopen(filename.c_str(), "rb")))
+         continue;
+
+      size_t got;
+      while(!readaheadstop.load(std::memory_order_relaxed) && total < MAXREADAHEAD &&
+            (got = fread(chunk.get(), 1, CHUNKSIZE, f)) > 0)
+         total += got;
+
+      fclose(f);
+   }
+
+   readaheadend = std::chrono::steady_clock::now();
+}
+
+//
+// Stops the thread and waits for it; an error exit during startup needs it
+// gone before static destruction.
+//
+static void D_stopReadahead()
+{
+   if(!readaheadthread.joinable())
+      return;
+
+   readaheadstop.store(true, std::memory_order_relaxed);
+   readaheadthread.join();
+}
+
+//
+// Starts reading the physical files behind the global WAD directory in the
+// background. -noreadahead turns it off.
+//
+void D_StartReadahead()
+{
+   static bool atexitset = false;
+   const int numlumps = wGlobalDir.getNumLumps();
+
+   if(M_CheckParm("-noreadahead") || readaheadthread.joinable())
+      return;
+
+   // each archive once, in the order it was loaded
+   for(int i = 0; i < numlumps; i++)
+   {
+      const lumpinfo_t *lump = wGlobalDir.getLumpInfo()[i];
+      const char *filename;
+
+      if(lump->type != lumpinfo_t::lump_direct && lump->type != lumpinfo_t::lump_zip)
+         continue;
+      if(!(filename = wGlobalDir.getLumpFileName(i)))
+         continue;
+      if(std::find(readaheadfiles.begin(), readaheadfiles.end(), filename) ==
+         readaheadfiles.end())
+         readaheadfiles.push_back(filename);
+   }
+
+   if(readaheadfiles.empty())
+      return;
+
+   if(!atexitset)
+   {
+      atexit(D_stopReadahead);
+      atexitset = true;
+   }
+
+   readaheadstop.store(false, std::memory_order_relaxed);
+   readaheadstart  = std::chrono::steady_clock::now();
+   readaheadthread = std::thread(D_readaheadThreadFunc);
+}
+
+//
+// Stops the readahead if it is still going and adds it to the load trace.
+//
+void D_FinishReadahead()
+{
+   if(!readaheadthread.joinable())
+      return;
+
+   D_stopReadahead();
+   readaheadfiles.clear();
+
+   M_LoadTraceTask("D_Readahead", readaheadstart, readaheadend);
+}
+
 // EOF
 
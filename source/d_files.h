@@ -75,6 +75,10 @@ void D_GameAutoloadDEH();
 void D_GameAutoloadCSC();
 void D_CloseAutoloadDir();
 
+// Readahead
+void D_StartReadahead();
+void D_FinishReadahead();
+
 #endif
 
 // EOF
@@ -0,0 +1,137 @@
+//
+// The Eternity Engine
+// Copyright(C) 2026 James Haley, Max Waine, et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+// Additional terms and conditions compatible with the GPLv3 apply. See the
+// file COPYING-EE for details.
+//
+// Purpose: Frame pacing for uncapped framerates.
+//  Each frame has a slot of 1/d_maxfps seconds, and ends by presenting. The
+//  time from a frame's start to its present is tracked, and the next frame
+//  starts that long before its slot ends. Sleeps are only good to about a
+//  millisecond, so the last stretch of the wait is spun.
+//
+
+#include "z_zone.h"
+
+#include "hal/i_timer.h"
+
+#include "c_runcmd.h"
+#include "d_framepacer.h"
+#include "d_net.h"
+#include "doomstat.h"
+#include "m_compare.h"
+
+// waits shorter than this, in us, are spun rather than slept
+static constexpr uint64_t SPINMICROS = 1500;
+
+int d_maxfps; // 0 = no limit
+
+static bool     pacing;
+static uint64_t framestart;    // when the current frame began, in us
+static uint64_t nextpresent;   // when the current frame should present
+static uint64_t frameestimate; // how long a frame takes to present
+
+//
+// Frames are only paced when drawn as fast as possible, and never when
+// timing demos.
+//
+static bool D_shouldPace()
+{
+   return d_fastrefresh && d_maxfps > 0 && !timingdemo && !fastdemo;
+}
+
+//
+// Sleeps until just before target, then spins the rest of the way.
+//
+static void D_waitUntil(uint64_t target)
+{
+   uint64_t now;
+
+   while((now = i_haltimer.GetMicros()) + SPINMICROS < target)
+   {
+      const int ms = int((target - now - SPINMICROS) / 1000);
+      if(!ms)
+         break;
+      i_haltimer.Sleep(ms);
+   }
+
+   while(i_haltimer.GetMicros() < target)
+      ;
+}
+
+//
+// Called at the top of the main loop. Waits until the frame has to start
+// to be presented at the end of its slot.
+//
+void D_FramePacerWait()
+{
+   if(!D_shouldPace())
+   {
+      pacing = false;
+      return;
+   }
+
+   const uint64_t period = 1000000 / d_maxfps;
+
+   if(!pacing)
+   {
+      pacing        = true;
+      framestart    = i_haltimer.GetMicros();
+      nextpresent   = framestart + period;
+      frameestimate = 0;
+      return;
+   }
+
+   if(nextpresent > frameestimate)
+      D_waitUntil(nextpresent - frameestimate);
+   framestart = i_haltimer.GetMicros();
+}
+
+//
+// Called once the frame is presented, to learn how long frames take and
+// to place the next slot.
+//
+void D_FramePacerEndFrame()
+{
+   if(!pacing)
+      return;
+
+   const uint64_t period = 1000000 / d_maxfps;
+   const uint64_t now    = i_haltimer.GetMicros();
+   const uint64_t took   = now - framestart;
+
+   // a slow frame is taken at once; faster ones only bring it down slowly,
+   // as starting late shows while starting early only costs some latency
+   if(took > frameestimate)
+      frameestimate = took;
+   else
+      frameestimate -= (frameestimate - took) / 16;
+   frameestimate = emin(frameestimate, period);
+
+   // a frame that ran over starts the schedule again from now, rather than
+   // hurrying the ones after it
+   if(now > nextpresent)
+      nextpresent = now + period;
+   else
+      nextpresent += period;
+}
+
+VARIABLE_INT(d_maxfps, nullptr, 0, 1000, nullptr);
+CONSOLE_VARIABLE(d_maxfps, d_maxfps, 0) {}
+
+// EOF
+
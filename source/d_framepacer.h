@@ -0,0 +1,39 @@
+//
+// The Eternity Engine
+// Copyright(C) 2026 James Haley, Max Waine, et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+// Additional terms and conditions compatible with the GPLv3 apply. See the
+// file COPYING-EE for details.
+//
+// Purpose: Frame pacing for uncapped framerates.
+//  With d_fastrefresh on, d_maxfps caps how many frames are drawn per
+//  second. The wait comes before the frame's input is read, and it is as
+//  long as it can be while the frame still presents on time, so input is
+//  as fresh as it can be when drawn.
+//
+
+#ifndef D_FRAMEPACER_H__
+#define D_FRAMEPACER_H__
+
+extern int d_maxfps;
+
+void D_FramePacerWait();
+void D_FramePacerEndFrame();
+
+#endif
+
+// EOF
+
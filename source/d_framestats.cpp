@@ -0,0 +1,237 @@
+//
+// The Eternity Engine
+// Copyright(C) 2026 James Haley, Max Waine, et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+// Additional terms and conditions compatible with the GPLv3 apply. See the
+// file COPYING-EE for details.
+//
+// Purpose: Frame time statistics for timed and logged demos.
+//  A frame is one pass of the main loop and its time is measured from the
+//  end of the last one, so it takes in everything the loop does. Frame
+//  times are kept for the whole demo, since percentiles need every sample;
+//  at four bytes each that is small next to the demo itself.
+//
+
+#include <algorithm>
+
+#include "z_zone.h"
+
+#include "c_io.h"
+#include "d_framestats.h"
+#include "doomstat.h"
+#include "m_argv.h"
+#include "m_collection.h"
+#include "m_compare.h"
+#include "m_qstr.h"
+#include "v_misc.h"
+
+using frameclock_t = std::chrono::steady_clock;
+using framems_t    = std::chrono::duration<float, std::milli>;
+
+// Upper bounds of the histogram buckets, in ms; the last one is open
+static const float histogrambounds[] = { 4, 8, 12, 17, 25, 33, 50, 100 };
+static constexpr int NUMBUCKETS = earrlen(histogrambounds) + 1;
+
+bool d_framestats;
+
+static PODCollection<float>    frametimes;   // every frame's length, in ms
+static PODCollection<float>    framestalls;  // gap each tic-running frame closed
+static size_t                  levelframe;   // first frame of the current level
+static size_t                  levelstall;
+static frameclock_t::time_point firstframe;   // when timing began
+static frameclock_t::time_point lastframe;    // end of the last frame
+static frameclock_t::time_point lastadvance;  // end of the last frame to run tics
+static frameclock_t::duration  stages[FRAME_NUMSTAGES];
+static int                     lastgametic;
+
+static char *csvfilename;
+static FILE *csvfile;
+
+//
+// Starts timing frames, if it isn't already, and checks for -framecsv.
+//
+void D_FrameStatsStart()
+{
+   int p;
+
+   if(d_framestats)
+      return;
+
+   d_framestats = true;
+   firstframe   = lastframe = lastadvance = frameclock_t::now();
+   lastgametic  = gametic;
+
+   if((p = M_CheckParm("-framecsv")) && ++p < myargc)
+      csvfilename = estrdup(myargv[p]);
+}
+
+void D_FrameStatsAdd(framestage_e stage, frameclock_t::duration time)
+{
+   stages[stage] += time;
+}
+
+//
+// Writes the header with the first row and a row for every frame after.
+//
+static void D_writeFrameCSV(float framems)
+{
+   if(!csvfile)
+   {
+      if(!(csvfile = fopen(csvfilename, "w")))
+      {
+         C_Printf(FC_ERROR "Couldn't open %s for frame timing output\n", csvfilename);
+         efree(csvfilename);
+         csvfilename = nullptr;
+         return;
+      }
+
+      fputs("frame,gametic,time_ms,frame_ms,tics_ms,render_ms,blit_ms\n", csvfile);
+   }
+
+   // render time is reported without the blit inside it
+   fprintf(csvfile, "%u,%d,%.3f,%.3f,%.3f,%.3f,%.3f\n",
+           static_cast<unsigned int>(frametimes.getLength() - 1), gametic,
+           framems_t(lastframe - firstframe).count(), framems,
+           framems_t(stages[FRAME_TICS]).count(),
+           framems_t(stages[FRAME_RENDER] - stages[FRAME_BLIT]).count(),
+           framems_t(stages[FRAME_BLIT]).count());
+}
+
+//
+// Closes the CSV file, if one is being written.
+//
+void D_FrameStatsCloseCSV()
+{
+   if(csvfile)
+   {
+      fclose(csvfile);
+      csvfile = nullptr;
+   }
+}
+
+//
+// Ends a frame. Called once per pass of the main loop.
+//
+void D_FrameStatsEndFrame()
+{
+   if(!d_framestats)
+      return;
+
+   const frameclock_t::time_point now = frameclock_t::now();
+   const float framems = framems_t(now - lastframe).count();
+
+   frametimes.add(framems);
+   lastframe = now;
+
+   if(gametic != lastgametic)
+   {
+      framestalls.add(framems_t(now - lastadvance).count());
+      lastadvance = now;
+      lastgametic = gametic;
+   }
+
+   if(csvfilename)
+      D_writeFrameCSV(framems);
+
+   for(frameclock_t::duration &time : stages)
+      time = frameclock_t::duration::zero();
+}
+
+//
+// Marks the start of a level, for the demo log's per-level figures.
+//
+void D_FrameStatsLevelStart()
+{
+   levelframe = frametimes.getLength();
+   levelstall = framestalls.getLength();
+}
+
+//
+// Value below which the given fraction of the sorted samples fall
+//
+static float D_percentile(const PODCollection<float> &sorted, double fraction)
+{
+   if(sorted.isEmpty())
+      return 0.0f;
+
+   const size_t index = size_t(fraction * (sorted.getLength() - 1) + 0.5);
+   return sorted[index];
+}
+
+//
+// Works out the figures for the whole run, or for the current level only.
+//
+void D_FrameStatsSummary(bool level, framesummary_t &summary)
+{
+   PODCollection<float> sorted;
+   const size_t first = level ? levelframe : 0;
+
+   for(size_t i = first; i < frametimes.getLength(); i++)
+      sorted.add(frametimes[i]);
+   std::sort(sorted.begin(), sorted.end());
+
+   summary.frames = int(sorted.getLength());
+   summary.p50    = D_percentile(sorted, 0.50);
+   summary.p95    = D_percentile(sorted, 0.95);
+   summary.p99    = D_percentile(sorted, 0.99);
+   summary.max    = sorted.isEmpty() ? 0.0f : sorted.back();
+
+   summary.longeststall = 0.0f;
+   for(size_t i = level ? levelstall : 0; i < framestalls.getLength(); i++)
+      summary.longeststall = emax(summary.longeststall, framestalls[i]);
+}
+
+//
+// Appends the figures for the whole run and the frame time histogram to
+// report, for the end of a timed demo.
+//
+void D_FrameStatsReport(qstring &report)
+{
+   framesummary_t summary;
+   int            buckets[NUMBUCKETS] = {};
+   char           line[128];
+
+   D_FrameStatsSummary(false, summary);
+
+   for(const float ms : frametimes)
+   {
+      int bucket = 0;
+      while(bucket < NUMBUCKETS - 1 && ms >= histogrambounds[bucket])
+         bucket++;
+      buckets[bucket]++;
+   }
+
+   snprintf(line, sizeof(line),
+            "%d frames over %.1f s\n"
+            "frame time ms: p50 %.2f, p95 %.2f, p99 %.2f, max %.2f\n"
+            "longest stall %.2f ms\n",
+            summary.frames, framems_t(lastframe - firstframe).count() / 1000.0f,
+            summary.p50, summary.p95, summary.p99, summary.max,
+            summary.longeststall);
+   report << line;
+
+   for(int i = 0; i < NUMBUCKETS; i++)
+   {
+      if(i < NUMBUCKETS - 1)
+         snprintf(line, sizeof(line), "  < %3.0f ms: %d\n", histogrambounds[i], buckets[i]);
+      else
+         snprintf(line, sizeof(line), "  >= %2.0f ms: %d\n", histogrambounds[i - 1], buckets[i]);
+      report << line;
+   }
+}
+
+// EOF
+
@@ -0,0 +1,94 @@
+//
+// The Eternity Engine
+// Copyright(C) 2026 James Haley, Max Waine, et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+// Additional terms and conditions compatible with the GPLv3 apply. See the
+// file COPYING-EE for details.
+//
+// Purpose: Frame time statistics for timed and logged demos.
+//  Every pass of the main loop is timed, split into running tics, drawing
+//  and the blit, from the start of a -timedemo, -fastdemo or -demolog demo.
+//  The totals give frame time percentiles, the longest stall and a
+//  histogram; -framecsv writes each frame out as it ends.
+//
+
+#ifndef D_FRAMESTATS_H__
+#define D_FRAMESTATS_H__
+
+#include <chrono>
+
+class qstring;
+
+enum framestage_e
+{
+   FRAME_TICS,   // TryRunTics
+   FRAME_RENDER, // D_Display, less the blit
+   FRAME_BLIT,   // I_FinishUpdate
+   FRAME_NUMSTAGES
+};
+
+//
+// Frame time figures over a run of frames, in milliseconds
+//
+struct framesummary_t
+{
+   int   frames;
+   float p50, p95, p99, max;
+   float longeststall; // longest time with no game tic run
+};
+
+extern bool d_framestats;
+
+void D_FrameStatsStart();
+void D_FrameStatsAdd(framestage_e stage, std::chrono::steady_clock::duration time);
+void D_FrameStatsEndFrame();
+void D_FrameStatsLevelStart();
+void D_FrameStatsSummary(bool level, framesummary_t &summary);
+void D_FrameStatsReport(qstring &report);
+void D_FrameStatsCloseCSV();
+
+//
+// Charges the enclosing scope to a stage of the frame while timing.
+//
+class FrameStatsScope
+{
+public:
+   explicit FrameStatsScope(framestage_e pStage)
+      : active(d_framestats), stage(pStage)
+   {
+      if(active)
+         start = std::chrono::steady_clock::now();
+   }
+
+   ~FrameStatsScope()
+   {
+      if(active)
+         D_FrameStatsAdd(stage, std::chrono::steady_clock::now() - start);
+   }
+
+   FrameStatsScope(const FrameStatsScope &) = delete;
+   FrameStatsScope &operator = (const FrameStatsScope &) = delete;
+
+private:
+   bool                                  active; // latched, timing may start inside
+   framestage_e                          stage;
+   std::chrono::steady_clock::time_point start;
+};
+
+#endif
+
+// EOF
+
@@ -34,6 +34,7 @@
 #include "doomtype.h"
 #include "d_io.h"
 #include "d_dwfile.h"
+#include "m_compare.h"
 #include "m_utils.h"
 #include "w_wad.h"
 
@@ -76,11 +77,19 @@ char *DWFILE::getStr(char *buf, size_t n)
       *buf = *inp++;
    }
    else
-   {  // copy buffer
-      char *p = buf;
-      while(n > 1 && size && *inp && (n--, size--, *p++ = *inp++) != '\n')
-         ;
-      *p = 0;
+   {  // copy up to and including the next newline, stopping at a nul
+      size_t len = emin(n - 1, static_cast<size_t>(size));
+      const void *nl;
+
+      if((nl = memchr(inp, '\n', len)))
+         len = static_cast<const byte *>(nl) - inp + 1;
+      if((nl = memchr(inp, 0, len)))
+         len = static_cast<const byte *>(nl) - inp;
+
+      memcpy(buf, inp, len);
+      buf[len] = 0;
+      inp  += len;
+      size -= static_cast<int>(len);
    }
    return buf; // Return buffer pointer
 }
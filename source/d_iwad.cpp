@@ -63,6 +63,7 @@ void D_InitPaths();
 void D_CheckGameMusic();
 
 bool d_scaniwads;                     // haleyjd 11/15/12
+char *d_iwadcache;                    // what D_CheckIWAD found, by file
 
 //=============================================================================
 //
@@ -1020,16 +1021,204 @@ static void D_checkIWAD_ZIP(FILE *fp, const char *iwadname, iwadcheck_t &version
    version.gamemode    = indetermined;
 }
 
+//=============================================================================
+//
+// IWAD check cache
+//
+// Opening and reading through an IWAD can be slow on network drives, so what
+// D_CheckIWAD finds is kept in system.cfg along with the file's size and
+// modification time. Entries are fields separated by '|', which no Windows
+// path can hold: path, size, mtime, game mode, mission and the flags below.
+// While a stat of the file still matches, the entry is used instead.
+//
+
+enum
+{
+   IWADCACHE_SECRETS    = 0x01,
+   IWADCACHE_FREEDOOM   = 0x02,
+   IWADCACHE_FREEDM     = 0x04,
+   IWADCACHE_BFGEDITION = 0x08,
+   IWADCACHE_REKKR      = 0x10,
+};
+
+static constexpr int NUMIWADCACHEFIELDS  = 6;
+static constexpr int MAXIWADCACHEENTRIES = 32;
+
+struct iwadcacheentry_t
+{
+   qstring       path;
+   long long     size;
+   long long     mtime;
+   GameMode_t    gamemode;
+   GameMission_t gamemission;
+   int           flags;
+};
+
+static Collection<iwadcacheentry_t> iwadcache;
+static bool iwadcacheread;
+
+//
+// Reads the entries out of d_iwadcache the first time they are needed.
+// Anything malformed is dropped.
+//
+static void D_readIWADCache()
+{
+   qstring fields[NUMIWADCACHEFIELDS];
+   int     field = 0;
+
+   iwadcacheread = true;
+
+   if(estrempty(d_iwadcache))
+      return;
+
+   for(const char *rover = d_iwadcache; ; rover++)
+   {
+      if(*rover && *rover != '|')
+      {
+         fields[field] += *rover;
+         continue;
+      }
+
+      if(++field == NUMIWADCACHEFIELDS)
+      {
+         const int gamemode    = fields[3].toInt();
+         const int gamemission = fields[4].toInt();
+
+         if(gamemode >= 0 && gamemode < NumGameModes &&
+            gamemission >= 0 && gamemission < NumGameMissions)
+         {
+            iwadcacheentry_t entry;
+
+            entry.path        = fields[0];
+            entry.size        = strtoll(fields[1].constPtr(), nullptr, 10);
+            entry.mtime       = strtoll(fields[2].constPtr(), nullptr, 10);
+            entry.gamemode    = GameMode_t(gamemode);
+            entry.gamemission = GameMission_t(gamemission);
+            entry.flags       = fields[5].toInt();
+            iwadcache.add(std::move(entry));
+         }
+
+         for(qstring &f : fields)
+            f.clear();
+         field = 0;
+      }
+
+      if(!*rover)
+         break;
+   }
+}
+
+//
+// Writes the entries back to d_iwadcache, to be saved with system.cfg.
+//
+static void D_writeIWADCache()
+{
+   qstring cache;
+   char    numbers[80];
+
+   for(const iwadcacheentry_t &entry : iwadcache)
+   {
+      if(!cache.empty())
+         cache += '|';
+
+      snprintf(numbers, sizeof(numbers), "|%lld|%lld|%d|%d|%d", entry.size,
+               entry.mtime, int(entry.gamemode), int(entry.gamemission), entry.flags);
+      cache << entry.path << numbers;
+   }
+
+   if(d_iwadcache)
+      efree(d_iwadcache);
+   d_iwadcache = cache.duplicate();
+}
+
+//
+// Fills in version from the cache if the file hasn't changed since its entry
+// was made. Returns false if there is no such entry.
+//
+static bool D_checkIWADCache(const char *iwadname, const struct stat &sbuf,
+                             iwadcheck_t &version)
+{
+   if(!iwadcacheread)
+      D_readIWADCache();
+
+   for(const iwadcacheentry_t &entry : iwadcache)
+   {
+      if(entry.path != iwadname)
+         continue;
+
+      if(entry.size != (long long)sbuf.st_size || entry.mtime != (long long)sbuf.st_mtime)
+         return false;
+
+      version.gamemode    = entry.gamemode;
+      version.gamemission = entry.gamemission;
+      version.hassecrets  = !!(entry.flags & IWADCACHE_SECRETS);
+      version.freedoom    = !!(entry.flags & IWADCACHE_FREEDOOM);
+      version.freedm      = !!(entry.flags & IWADCACHE_FREEDM);
+      version.bfgedition  = !!(entry.flags & IWADCACHE_BFGEDITION);
+      version.rekkr       = !!(entry.flags & IWADCACHE_REKKR);
+      return true;
+   }
+
+   return false;
+}
+
+//
+// Records what was found in a file, replacing any older entry for it. The
+// oldest entries give way once the cache is full.
+//
+static void D_addIWADCache(const char *iwadname, const struct stat &sbuf,
+                           const iwadcheck_t &version)
+{
+   Collection<iwadcacheentry_t> kept;
+   iwadcacheentry_t entry;
+   size_t others = 0;
+
+   for(const iwadcacheentry_t &old : iwadcache)
+   {
+      if(old.path != iwadname)
+         others++;
+   }
+
+   for(const iwadcacheentry_t &old : iwadcache)
+   {
+      if(old.path == iwadname)
+         continue;
+      if(others-- < MAXIWADCACHEENTRIES)
+         kept.add(old);
+   }
+
+   entry.path        = iwadname;
+   entry.size        = (long long)sbuf.st_size;
+   entry.mtime       = (long long)sbuf.st_mtime;
+   entry.gamemode    = version.gamemode;
+   entry.gamemission = version.gamemission;
+   entry.flags       = (version.hassecrets ? IWADCACHE_SECRETS    : 0) |
+                       (version.freedoom   ? IWADCACHE_FREEDOOM   : 0) |
+                       (version.freedm     ? IWADCACHE_FREEDM     : 0) |
+                       (version.bfgedition ? IWADCACHE_BFGEDITION : 0) |
+                       (version.rekkr      ? IWADCACHE_REKKR      : 0);
+   kept.add(std::move(entry));
+
+   iwadcache = std::move(kept);
+   D_writeIWADCache();
+}
+
 //
 // D_CheckIWAD
 //
 // Check the format and contents of a candidate IWAD file and return the
 // detected game mode and mission properties in the iwadcheck_t structure.
-// Dispatches to subroutines above for supported archive formats.
+// Dispatches to subroutines above for supported archive formats, unless the
+// file is unchanged since it was last checked.
 //
 void D_CheckIWAD(const char *iwadname, iwadcheck_t &version)
 {
    FILE *fp;
+   struct stat sbuf;
+   const bool statted = !stat(iwadname, &sbuf) && !S_ISDIR(sbuf.st_mode);
+
+   if(statted && D_checkIWADCache(iwadname, sbuf, version))
+      return;
 
    if(!(fp = fopen(iwadname, "rb")))
    {
@@ -1058,6 +1247,9 @@ void D_CheckIWAD(const char *iwadname, iwadcheck_t &version)
       fclose(fp);
       break;
    }
+
+   if(statted && !version.error)
+      D_addIWADCache(iwadname, sbuf, version);
 }
 
 //
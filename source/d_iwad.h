@@ -32,6 +32,7 @@
 #include "d_gi.h" 
 
 extern bool d_scaniwads;
+extern char *d_iwadcache;
 
 extern bool freedoom;
 extern bool bfgedition;
@@ -0,0 +1,359 @@
+//
+// The Eternity Engine
+// Copyright(C) 2026 James Haley, Max Waine, et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+// Additional terms and conditions compatible with the GPLv3 apply. See the
+// file COPYING-EE for details.
+//
+// Purpose: Engine-wide job system.
+//  Each worker has a queue per priority. Jobs queued by a worker go on its
+//  own queues and others round robin. A worker takes from the front of its
+//  own queues, and when they run dry steals from the back of the others'.
+//  A thread joining a job runs queued jobs until it is done, so a job may
+//  wait on the jobs it queues without tying up a worker. Z_Alloca scratch
+//  taken by a job is rewound when it returns.
+//
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include "z_zone.h"
+
+#include "c_runcmd.h"
+#include "d_jobs.h"
+#include "m_compare.h"
+
+static constexpr int MAXJOBWORKERS = 32;
+
+int d_jobthreads; // workers, 0 for one less than the number of cores
+
+struct jobstate_t
+{
+   std::function<void()> func;
+   std::atomic_bool      done { false };
+};
+
+using jobptr_t = std::shared_ptr<jobstate_t>;
+
+struct jobworker_t
+{
+   std::mutex           lock;
+   std::deque<jobptr_t> queues[JOBPRI_NUM];
+   std::thread          thread;
+};
+
+static jobworker_t *jobworkers;
+static int          numjobworkers;
+static bool         jobsstarted;
+
+static std::atomic_int          pendingjobs;  // queued and not yet taken
+static std::atomic_uint         nextworker;   // round robin for other threads
+static std::mutex               jobsleeplock;
+static std::condition_variable  jobqueued;    // workers wait here
+static std::condition_variable  jobfinished;  // joining threads wait here
+static bool                     jobsquitting;
+
+static thread_local int jobworkerindex = -1;
+
+static std::mutex                        mainjoblock;
+static std::deque<std::function<void()>> mainjobs;
+
+//=============================================================================
+//
+// Workers
+//
+
+//
+// Takes the most urgent job, from the front of the given worker's own queues
+// or the back of anyone else's. self is -1 on threads that aren't workers.
+//
+static jobptr_t D_takeJob(int self)
+{
+   if(pendingjobs.load(std::memory_order_acquire) <= 0)
+      return nullptr;
+
+   for(int pri = 0; pri < JOBPRI_NUM; pri++)
+   {
+      for(int i = 0; i < numjobworkers; i++)
+      {
+         const int    w      = self < 0 ? i : (self + i) % numjobworkers;
+         jobworker_t &worker = jobworkers[w];
+         std::lock_guard<std::mutex> lock(worker.lock);
+         std::deque<jobptr_t> &queue = worker.queues[pri];
+
+         if(queue.empty())
+            continue;
+
+         jobptr_t job;
+         if(w == self)
+         {
+            job = std::move(queue.front());
+            queue.pop_front();
+         }
+         else
+         {
+            job = std::move(queue.back());
+            queue.pop_back();
+         }
+         pendingjobs.fetch_sub(1, std::memory_order_relaxed);
+         return job;
+      }
+   }
+
+   return nullptr;
+}
+
+static void D_runJob(jobstate_t &job)
+{
+   {
+      ScratchScope scope;
+      job.func();
+      job.func = nullptr;
+   }
+
+   {
+      std::lock_guard<std::mutex> lock(jobsleeplock);
+      job.done.store(true, std::memory_order_release);
+   }
+   jobfinished.notify_all();
+}
+
+static void D_jobWorkerThread(int index)
+{
+   jobworkerindex = index;
+
+   for(;;)
+   {
+      if(jobptr_t job = D_takeJob(index))
+      {
+         D_runJob(*job);
+         continue;
+      }
+
+      std::unique_lock<std::mutex> lock(jobsleeplock);
+      jobqueued.wait(lock, [] {
+         return jobsquitting || pendingjobs.load(std::memory_order_acquire) > 0;
+      });
+      if(jobsquitting && pendingjobs.load(std::memory_order_acquire) <= 0)
+         return;
+   }
+}
+
+//
+// Number of workers d_jobthreads asks for
+//
+static int D_wantedJobWorkers()
+{
+   if(d_jobthreads > 0)
+      return emin(d_jobthreads, MAXJOBWORKERS);
+
+   return eclamp(int(std::thread::hardware_concurrency()) - 1, 0, MAXJOBWORKERS);
+}
+
+static void D_startJobWorkers()
+{
+   numjobworkers = D_wantedJobWorkers();
+   jobsquitting  = false;
+
+   if(numjobworkers)
+   {
+      jobworkers = new jobworker_t[numjobworkers];
+      for(int i = 0; i < numjobworkers; i++)
+         jobworkers[i].thread = std::thread(D_jobWorkerThread, i);
+   }
+}
+
+//
+// Lets the workers finish everything queued, then stops them.
+//
+static void D_stopJobWorkers()
+{
+   {
+      std::lock_guard<std::mutex> lock(jobsleeplock);
+      jobsquitting = true;
+   }
+   jobqueued.notify_all();
+
+   for(int i = 0; i < numjobworkers; i++)
+      jobworkers[i].thread.join();
+
+   delete [] jobworkers;
+   jobworkers    = nullptr;
+   numjobworkers = 0;
+}
+
+//
+// Starts the workers. Called at startup once the system config is loaded.
+//
+void D_InitJobs()
+{
+   if(jobsstarted)
+      return;
+
+   D_startJobWorkers();
+   jobsstarted = true;
+   atexit(D_stopJobWorkers);
+}
+
+//
+// Number of worker threads; 0 means jobs run on the thread queuing them.
+//
+int D_NumJobWorkers()
+{
+   return numjobworkers;
+}
+
+//=============================================================================
+//
+// Jobs
+//
+
+bool JobHandle::done() const
+{
+   return !state || state->done.load(std::memory_order_acquire);
+}
+
+//
+// Waits for the job, running other queued jobs in the meantime.
+//
+void JobHandle::join()
+{
+   if(!state)
+      return;
+
+   while(!state->done.load(std::memory_order_acquire))
+   {
+      if(jobptr_t job = D_takeJob(jobworkerindex))
+      {
+         D_runJob(*job);
+         continue;
+      }
+
+      std::unique_lock<std::mutex> lock(jobsleeplock);
+      jobfinished.wait(lock, [this] { return state->done.load(std::memory_order_acquire); });
+   }
+
+   state.reset();
+}
+
+//
+// Queues a job. With no workers it is run before this returns.
+//
+JobHandle D_QueueJob(std::function<void()> func, jobpriority_e priority)
+{
+   JobHandle handle;
+
+   handle.state = std::make_shared<jobstate_t>();
+   handle.state->func = std::move(func);
+
+   if(!numjobworkers)
+   {
+      D_runJob(*handle.state);
+      return handle;
+   }
+
+   const int w = jobworkerindex >= 0 ? jobworkerindex :
+                 int(nextworker.fetch_add(1, std::memory_order_relaxed) % numjobworkers);
+   {
+      std::lock_guard<std::mutex> lock(jobworkers[w].lock);
+      jobworkers[w].queues[priority].push_back(handle.state);
+      pendingjobs.fetch_add(1, std::memory_order_release);
+   }
+
+   // taking the lock means a worker is either waiting or yet to check
+   {
+      std::lock_guard<std::mutex> lock(jobsleeplock);
+   }
+   jobqueued.notify_one();
+
+   return handle;
+}
+
+//
+// Calls func(0) to func(count - 1) side by side and returns once all are
+// done. The calling thread runs func(0) itself.
+//
+void D_RunParallel(int count, const std::function<void(int)> &func)
+{
+   if(count <= 1 || !numjobworkers)
+   {
+      for(int i = 0; i < count; i++)
+         func(i);
+      return;
+   }
+
+   JobHandle *handles = new JobHandle[count - 1];
+
+   for(int i = 1; i < count; i++)
+      handles[i - 1] = D_QueueJob([&func, i] { func(i); }, JOBPRI_HIGH);
+
+   {
+      ScratchScope scope;
+      func(0);
+   }
+
+   for(int i = 0; i < count - 1; i++)
+      handles[i].join();
+   delete [] handles;
+}
+
+//=============================================================================
+//
+// Main thread continuations
+//
+
+//
+// Has func run on the main thread at the start of the next frame.
+//
+void D_RunOnMainThread(std::function<void()> func)
+{
+   std::lock_guard<std::mutex> lock(mainjoblock);
+   mainjobs.push_back(std::move(func));
+}
+
+//
+// Runs what has been handed to the main thread. Called once per frame.
+//
+void D_RunMainThreadJobs()
+{
+   std::deque<std::function<void()>> torun;
+
+   {
+      std::lock_guard<std::mutex> lock(mainjoblock);
+      torun.swap(mainjobs);
+   }
+
+   for(std::function<void()> &func : torun)
+      func();
+}
+
+//
+// A new worker count takes effect once everything queued is done.
+//
+VARIABLE_INT(d_jobthreads, nullptr, 0, MAXJOBWORKERS, nullptr);
+CONSOLE_VARIABLE(d_jobthreads, d_jobthreads, 0)
+{
+   if(jobsstarted && D_wantedJobWorkers() != numjobworkers)
+   {
+      D_stopJobWorkers();
+      D_startJobWorkers();
+   }
+}
+
+// EOF
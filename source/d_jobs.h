@@ -0,0 +1,73 @@
+//
+// The Eternity Engine
+// Copyright(C) 2026 James Haley, Max Waine, et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+// Additional terms and conditions compatible with the GPLv3 apply. See the
+// file COPYING-EE for details.
+//
+// Purpose: Engine-wide job system.
+//  One set of worker threads, sized by d_jobthreads, runs jobs queued from
+//  anywhere in the engine, so parallel loops don't each start threads of
+//  their own. Work the main thread must do, such as anything touching the
+//  zone heap, can be handed back to it with D_RunOnMainThread. Jobs may
+//  take scratch memory with Z_Alloca; it is given back when the job returns.
+//
+
+#ifndef D_JOBS_H__
+#define D_JOBS_H__
+
+#include <functional>
+#include <memory>
+
+enum jobpriority_e
+{
+   JOBPRI_HIGH,   // something is waiting on it now
+   JOBPRI_NORMAL,
+   JOBPRI_LOW,    // background work with no deadline
+   JOBPRI_NUM
+};
+
+struct jobstate_t;
+
+//
+// Handle to a queued job. Dropping a handle doesn't cancel the job.
+//
+class JobHandle
+{
+public:
+   bool valid() const { return state != nullptr; }
+   bool done() const;
+   void join();
+
+private:
+   friend JobHandle D_QueueJob(std::function<void()> func, jobpriority_e priority);
+
+   std::shared_ptr<jobstate_t> state;
+};
+
+extern int d_jobthreads;
+
+void      D_InitJobs();
+int       D_NumJobWorkers();
+JobHandle D_QueueJob(std::function<void()> func, jobpriority_e priority = JOBPRI_NORMAL);
+void      D_RunParallel(int count, const std::function<void(int)> &func);
+
+void D_RunOnMainThread(std::function<void()> func);
+void D_RunMainThreadJobs();
+
+#endif
+
+// EOF
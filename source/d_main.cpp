@@ -42,10 +42,13 @@
 #include "d_deh.h"      // Ty 04/08/98 - Externalizations
 #include "d_dehtbl.h"
 #include "d_event.h"
+#include "d_framepacer.h"
+#include "d_framestats.h"
 #include "d_files.h"
 #include "d_gi.h"
 #include "d_io.h"
 #include "d_iwad.h"
+#include "d_jobs.h"
 #include "d_net.h"
 #include "doomstat.h"
 #include "dstrings.h"
@@ -56,9 +59,11 @@
 #include "f_wipe.h"
 #include "g_bind.h"
 #include "g_demolog.h"
+#include "g_demoverify.h"
 #include "g_dmflag.h"
 #include "g_game.h"
 #include "g_gfs.h"
+#include "g_statehash.h"
 #include "hal/i_timer.h"
 #include "hu_stuff.h"
 #include "i_sound.h"
@@ -67,16 +72,23 @@
 #include "in_lude.h"
 #include "m_argv.h"
 #include "m_compare.h"
+#include "m_loadtrace.h"
 #include "m_misc.h"
+#include "m_perfstats.h"
+#include "m_shots.h"
 #include "m_syscfg.h"
 #include "m_qstr.h"
 #include "m_utils.h"
 #include "mn_engin.h"
 #include "p_chase.h"
 #include "p_setup.h"
+#include "p_simbench.h"
 #include "r_draw.h"
+#include "r_dynres.h"
 #include "r_main.h"
 #include "r_patch.h"
+#include "r_profile.h"
+#include "r_renderbench.h"
 #include "s_sound.h"
 #include "st_stuff.h"
 #include "v_block.h"
@@ -164,6 +176,8 @@ void usermsg(E_FORMAT_STRING(const char *s), ...)
 //sf:
 void startupmsg(const char *func, const char *desc)
 {
+   M_LoadTracePhase(func);
+
    // add colours in console mode
    usermsg(in_textmode ? "%s: %s" : FC_HI "%s: " FC_NORMAL "%s",
            func, desc);
@@ -715,12 +729,23 @@ static void D_Display()
    if(d_drawfps)
       D_showDrawnFPS();
 
+   R_ProfileDrawer();
+   M_PerfStatsDrawer();
+
 #ifdef INSTRUMENTED
    if(printstats)
       D_showMemStats();
 #endif
    
-   I_FinishUpdate();              // page flip or blit buffer
+   // frame capture takes the frame as it is about to be shown
+   M_CaptureFrame();
+
+   {
+      RenderProfileScope profile(RPROF_BLIT);
+      FrameStatsScope    stats(FRAME_BLIT);
+      I_FinishUpdate();           // page flip or blit buffer
+   }
+   R_ProfileEndFrame();
 
    i_haltimer.EndDisplay();
 }
@@ -1261,6 +1286,7 @@ static void D_DoomInit()
    int dmtype = 0;          // haleyjd 04/14/03
    bool haveGFS = false;    // haleyjd 03/10/03
    gfs_t *gfs = nullptr;
+   LoadTraceSession loadtrace("startup");
 
    gamestate = GS_STARTUP; // haleyjd 01/01/10
 
@@ -1272,6 +1298,14 @@ static void D_DoomInit()
 
    FindResponseFile(); // Append response file arguments to command-line
 
+   // -statehashdiff only compares two logs, and quits
+   if((p = M_CheckParm("-statehashdiff")) && p < myargc - 2)
+      G_StateHashDiff(myargv[p + 1], myargv[p + 2]);
+
+   // -demoverify only runs other copies of the game, and quits
+   if((p = M_CheckParm("-demoverify")) && p < myargc - 1)
+      G_DemoVerify(myargv[p + 1]);
+
    // haleyjd 08/18/07: set base path and user path
    D_SetBasePath();
    D_SetUserPath();
@@ -1336,6 +1370,7 @@ static void D_DoomInit()
 
    devparm = !!M_CheckParm("-devparm");         //sf: move up here
 
+   M_LoadTracePhase("D_IdentifyVersion");
    D_IdentifyVersion();
    printf("\n"); // gap
 
@@ -1423,6 +1458,9 @@ static void D_DoomInit()
    if((p = M_CheckParm("-demolog")) && p < myargc - 1)
       G_DemoLogInit(myargv[p + 1]);
 
+   if((p = M_CheckParm("-statehash")) && p < myargc - 1)
+      G_StateHashInit(myargv[p + 1]);
+
    // haleyjd 01/17/11: allow -play also
    const char *playdemoparms[] = { "-playdemo", "-play", nullptr };
 
@@ -1430,6 +1468,11 @@ static void D_DoomInit()
    {
       if((p = M_CheckParm("-fastdemo")) && p < myargc-1)  // killough
          fastdemo = true;            // run at fastest speed possible
+      else if((p = M_CheckParm("-simbench")) && p < myargc-1)
+      {
+         fastdemo = true;            // headless playsim benchmark
+         P_SimBenchInit(myargv[p + 1]);
+      }
       else
          p = M_CheckParm("-timedemo");
    }
@@ -1525,6 +1568,14 @@ static void D_DoomInit()
       }
    }
 
+   // -renderbench <map> <pathfile> warps to the map and flies a camera
+   if((p = M_CheckParm("-renderbench")) && p < myargc - 2)
+   {
+      d_startlevel.mapname = myargv[p + 1];
+      autostart = true;
+      R_RenderBenchInit(myargv[p + 2]);
+   }
+
    //jff 1/22/98 add command line parms to disable sound and music
    {
       bool nosound = !!M_CheckParm("-nosound");
@@ -1538,12 +1589,23 @@ static void D_DoomInit()
    nodrawers = !!M_CheckParm("-nodraw");
    noblit    = !!M_CheckParm("-noblit");
 
+   // -simbench and -dedicated have no window or sound at all
+   d_dedicated = !!M_CheckParm("-dedicated");
+   if(simbench || d_dedicated)
+      nodrawers = noblit = nosfxparm = nomusicparm = true;
+
+   // -renderbench draws, but has nothing to hear
+   if(renderbench)
+      nosfxparm = nomusicparm = true;
+
    // haleyjd: need to do this before M_LoadDefaults
    C_InitPlayerName();
 
    startupmsg("M_LoadDefaults", "Load system defaults.");
    M_LoadDefaults();              // load before initing other systems
 
+   D_InitJobs();                  // worker count comes from the defaults
+
    bodyquesize = default_bodyquesize; // killough 10/98
 
    G_ReloadDefaults();    // killough 3/4/98: set defaults just loaded.
@@ -1561,6 +1623,9 @@ static void D_DoomInit()
    wGlobalDir.initMultipleFiles(wadfiles);
    usermsg("");  // gap
 
+   // warm the file cache for the lump reads the rest of startup makes
+   D_StartReadahead();
+
    // Check for -file in shareware
    //
    // haleyjd 03/22/03: there's no point in trying to detect fake IWADs,
@@ -1600,6 +1665,7 @@ static void D_DoomInit()
    // is processed here to parse all files/lumps at once.
 
    // Init bex hash chaining before EDF
+   M_LoadTracePhase("D_LoadEDF");
    D_BuildBEXHashChains();
 
    // Identify root EDF file and process EDF
@@ -1612,6 +1678,7 @@ static void D_DoomInit()
    D_BuildBEXTables();
 
    // Process the DeHackEd queue, then free it
+   M_LoadTracePhase("D_ProcessDEHQueue");
    D_ProcessDEHQueue();
    
    // haleyjd: moved down turbo to here for player class support
@@ -1740,6 +1807,9 @@ static void D_DoomInit()
    // haleyjd 08/20/07: done with base/game/autoload directory
    D_CloseAutoloadDir();
 
+   // startup is done with the bulk of the lumps
+   D_FinishReadahead();
+
    if(devparm) // we wait if in devparm so the user can see the messages
    {
       printf("devparm: press a key..\n");
@@ -1856,7 +1926,13 @@ static void D_DoomInit()
       }
    }
 
-   if((p = M_CheckParm("-fastdemo")) && ++p < myargc)
+   if(simbench && (p = M_CheckParm("-simbench")) && ++p < myargc)
+   {
+      timingdemo = true;              // report after the demo
+      G_DeferedPlayDemo(myargv[p]);
+      singledemo = true;
+   }
+   else if((p = M_CheckParm("-fastdemo")) && ++p < myargc)
    {                                 // killough
       fastdemo = true;                // run at fastest speed possible
       timingdemo = true;              // show stats after quit
@@ -1908,6 +1984,8 @@ static void D_DoomInit()
 
          if(demorecording)
             G_BeginRecording();
+         if(d_dedicated)
+            D_StartRelay();
       }
       else
          D_StartTitle();                 // start up intro loop
@@ -1951,16 +2029,35 @@ void D_DoomMain()
    // killough 12/98: inlined D_DoomLoop
    while(1)
    {
+      // hold the frame back if it would be early under d_maxfps
+      D_FramePacerWait();
+      R_DynResStartFrame();
+
+      // work finished on the job threads that the main thread must apply
+      D_RunMainThreadJobs();
+
       // frame synchronous IO operations
       I_StartFrame();
 
-      TryRunTics();
+      {
+         FrameStatsScope stats(FRAME_TICS);
+         TryRunTics();
+      }
+
+      // the render benchmark takes over once its level is up, so the
+      // world stays as it was on the first tic
+      if(renderbench && gamestate == GS_LEVEL && gameaction == ga_nothing)
+         R_RenderBenchRun();
 
       // killough 3/16/98: change consoleplayer to displayplayer
       S_UpdateSounds(players[displayplayer].mo); // move positional sounds
 
       // Update display, next frame, with current state.
-      D_Display();
+      {
+         FrameStatsScope stats(FRAME_RENDER);
+         D_Display();
+      }
+      D_FramePacerEndFrame();
 
       // Sound mixing for the buffer is synchronous.
       I_UpdateSound();
@@ -1969,8 +2066,14 @@ void D_DoomMain()
       // Update sound output.
       I_SubmitSound();
 
+      // report screenshots written in the background
+      M_ScreenShotTicker();
+
       // haleyjd 12/06/06: garbage-collect all alloca blocks
       Z_FreeAlloca();
+
+      D_FrameStatsEndFrame();
+      M_PerfStatsTicker();
    }
 }
 
@@ -40,8 +40,13 @@
 #include "e_things.h"
 #include "f_wipe.h"
 #include "g_dmflag.h"
+#include "g_demoseek.h"
 #include "g_game.h"
 #include "hal/i_timer.h"
+#include "m_argv.h"
+#include "m_collection.h"
+#include "m_compare.h"
+#include "m_perfstats.h"
 #include "m_random.h"
 #include "mn_engin.h"
 #include "i_net.h"
@@ -90,6 +95,332 @@ void D_DoAdvanceDemo();
 static bool       reboundpacket;
 static doomdata_t reboundstore;
 
+// players the key player said read delta tics, whose nodes aren't known yet
+static int netformatplayers;
+
+// -dedicated: this node hosts the game as the key node, without playing
+bool d_dedicated;
+
+// player 1's node is a dedicated host, so there is no player 1
+static bool dedicatedkey;
+
+// Input delay: how many tics ahead of the game every player builds its own.
+// Tics that arrive up to that late don't stall the game. The key player sets
+// it for the slowest link anyone reports, and the others follow it, so that
+// everyone leads by the same amount.
+#define MAXINPUTDELAY  2
+#define INPUTDELAYHOLD (2 * TICRATE) // tics a lower delay must hold before use
+
+static int inputdelay;
+static int wanteddelay[MAXPLAYERS]; // what each player's links need
+static int lowerdelaytics;          // how long a lower one has been wanted
+static int aheadtics;               // tics to build early for a raised delay
+
+netstats_t netstats;
+netstats_t netstatsrate;
+
+static netstats_t   lastnetstats;    // totals at the start of this second
+static unsigned int netstatstime;    // when this second began
+static int          netstatsseconds;
+static FILE        *netstatscsv;     // -netstatscsv log
+
+static PerfCounter packetssentstat("net.packets_sent", "", [] {
+   return double(netstats.packetssent);
+});
+static PerfCounter packetsreceivedstat("net.packets_received", "", [] {
+   return double(netstats.packetsreceived);
+});
+static PerfCounter bytessentstat("net.bytes_sent", "bytes", [] {
+   return double(netstats.bytessent);
+});
+static PerfCounter bytesreceivedstat("net.bytes_received", "bytes", [] {
+   return double(netstats.bytesreceived);
+});
+static PerfCounter retransmitsstat("net.retransmits_asked", "", [] {
+   return double(netstats.retransmitsasked);
+});
+static PerfCounter stallframesstat("net.stall_frames", "", [] {
+   return double(netstats.stallframes);
+});
+static PerfGauge readystat("net.ready", "tics", [] { return double(netstats.ready); });
+static bool         waitedfortics;   // this frame stalled on another node
+
+//
+// D_writeNetStatsCSV
+//
+// Writes the header when the log is opened, and one row a second after that.
+//
+static void D_writeNetStatsCSV(bool header)
+{
+   const netstats_t &r = netstatsrate;
+
+   if(header)
+   {
+      fputs("second,packetssent,packetsreceived,bytessent,bytesreceived,"
+            "badchecksums,retransmitsasked,retransmitsgiven,duplicates,gaps,"
+            "frames,stallframes,waitms,queued,ready\n", netstatscsv);
+      return;
+   }
+
+   fprintf(netstatscsv, "%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d\n",
+           netstatsseconds, r.packetssent, r.packetsreceived, r.bytessent,
+           r.bytesreceived, r.badchecksums, r.retransmitsasked,
+           r.retransmitsgiven, r.duplicates, r.gaps, r.frames, r.stallframes,
+           r.waitms, r.queued, r.ready);
+   fflush(netstatscsv);
+}
+
+//
+// D_netStatsTicker
+//
+// Works out the rates over each second as it ends. Called once a frame.
+//
+static void D_netStatsTicker()
+{
+   const unsigned int now = i_haltimer.GetTicks();
+
+   if(now - netstatstime < 1000)
+      return;
+
+   netstatsrate.packetssent      = netstats.packetssent      - lastnetstats.packetssent;
+   netstatsrate.packetsreceived  = netstats.packetsreceived  - lastnetstats.packetsreceived;
+   netstatsrate.bytessent        = netstats.bytessent        - lastnetstats.bytessent;
+   netstatsrate.bytesreceived    = netstats.bytesreceived    - lastnetstats.bytesreceived;
+   netstatsrate.badchecksums     = netstats.badchecksums     - lastnetstats.badchecksums;
+   netstatsrate.retransmitsasked = netstats.retransmitsasked - lastnetstats.retransmitsasked;
+   netstatsrate.retransmitsgiven = netstats.retransmitsgiven - lastnetstats.retransmitsgiven;
+   netstatsrate.duplicates       = netstats.duplicates       - lastnetstats.duplicates;
+   netstatsrate.gaps             = netstats.gaps             - lastnetstats.gaps;
+   netstatsrate.frames           = netstats.frames           - lastnetstats.frames;
+   netstatsrate.stallframes      = netstats.stallframes      - lastnetstats.stallframes;
+   netstatsrate.waitms           = netstats.waitms           - lastnetstats.waitms;
+   netstatsrate.queued           = netstats.queued;
+   netstatsrate.ready            = netstats.ready;
+
+   lastnetstats = netstats;
+   netstatstime = now;
+   ++netstatsseconds;
+
+   if(netstatscsv)
+      D_writeNetStatsCSV(false);
+}
+
+//
+// Spectator relay
+//
+// A dedicated host sends the game to spectators as a demo: the header that
+// G_BeginRecording writes, then every tic's ticcmds as G_WriteDemoTiccmd
+// records them. Only tics that every player has sent are run, so nothing
+// in it is ever taken back, and no player waits on a spectator. It runs
+// d_relaydelay seconds behind the game. The stream is kept whole, so that a
+// spectator can join at any time and still play it from the start.
+//
+// A spectator asks for the stream with how many of its bytes it holds,
+// whenever something arrives and at least once a second otherwise, which
+// also acknowledges what it was sent. It gets what it lacks, no more than
+// RELAYWINDOW bytes past what it acknowledged, sent again from there if
+// nothing is acknowledged for RELAYRESEND ms. One that stays silent for
+// RELAYTIMEOUT ms is dropped.
+//
+#define RELAYWINDOW  16384
+#define RELAYRESEND  1000
+#define RELAYTIMEOUT 10000
+
+int d_relaydelay;
+
+struct relayspectator_t
+{
+   uint32_t     acked;     // bytes it holds
+   uint32_t     sent;      // bytes sent to it
+   unsigned int heardat;   // when it last asked
+   unsigned int movedat;   // when acked last moved, or sent was last rewound
+   bool         inuse;
+};
+
+static bool                            relaying;
+static bool                            relayended;   // DEMOMARKER written
+static unsigned int                    relaydoneat;  // when all of it was sent
+static uint32_t                        relayheader;  // length of the header
+static PODCollection<byte>             relaystream;
+static PODCollection<uint32_t>         relayticends; // length after each tic
+static PODCollection<relayspectator_t> relayspectators;
+
+//
+// D_StartRelay
+//
+void D_StartRelay()
+{
+   byte header[MAXDEMOHEADER];
+   const size_t len = G_WriteDemoHeader(header, displayplayer);
+
+   relaystream.makeEmpty();
+   relayticends.makeEmpty();
+   for(size_t i = 0; i < len; i++)
+      relaystream.add(header[i]);
+
+   relayheader = static_cast<uint32_t>(len);
+   relaying    = true;
+   relayended  = false;
+
+   I_NetOpenRelay();
+   usermsg("Relaying the game to spectators %d seconds behind", d_relaydelay);
+}
+
+//
+// D_RelayTiccmd
+//
+void D_RelayTiccmd(const ticcmd_t *cmd)
+{
+   if(!relaying || relayended)
+      return;
+
+   byte tic[MAXDEMOTIC];
+   const size_t len = G_WriteDemoTic(tic, cmd);
+
+   for(size_t i = 0; i < len; i++)
+      relaystream.add(tic[i]);
+}
+
+//
+// D_relayEndTic
+//
+// Called after each tic, including those after the stream has ended, which
+// still count towards the delay on its last bytes.
+//
+static void D_relayEndTic()
+{
+   if(relaying)
+      relayticends.add(static_cast<uint32_t>(relaystream.getLength()));
+}
+
+//
+// D_endRelay
+//
+// A demo can't have a player leave part way through, so the stream ends when
+// one does.
+//
+static void D_endRelay()
+{
+   if(!relaying || relayended)
+      return;
+
+   relaystream.add(DEMOMARKER);
+   relayended = true;
+}
+
+//
+// D_relayAvailable
+//
+// How much of the stream spectators may have by now.
+//
+static uint32_t D_relayAvailable()
+{
+   const size_t delay = static_cast<size_t>(d_relaydelay) * TICRATE;
+   const size_t tics  = relayticends.getLength();
+
+   return tics > delay ? relayticends[tics - delay - 1] : relayheader;
+}
+
+//
+// D_relayTicker
+//
+// Reads what the spectators hold and sends them more. Once every player has
+// left, the host stays until the spectators have had the end of the stream,
+// or RELAYTIMEOUT after it was sent, then quits. Called once a frame.
+//
+static void D_relayTicker()
+{
+   if(!relaying)
+      return;
+
+   const unsigned int now = i_haltimer.GetTicks();
+   const uint32_t available = D_relayAvailable();
+   const uint32_t length = static_cast<uint32_t>(relaystream.getLength());
+   int      spectator;
+   uint32_t have;
+
+   while(I_NetGetRelayRequest(spectator, have))
+   {
+      if(static_cast<size_t>(spectator) >= relayspectators.getLength())
+         relayspectators.resize(spectator + 1);
+
+      relayspectator_t &rs = relayspectators[spectator];
+
+      if(!rs.inuse)
+      {
+         rs = {};
+         rs.inuse = true;
+      }
+
+      have = emin(have, length);
+      if(have != rs.acked)
+      {
+         if(have < rs.acked || have > rs.sent) // it started over, or got ahead
+            rs.sent = have;
+         rs.acked   = have;
+         rs.movedat = now;
+      }
+      rs.heardat = now;
+   }
+
+   bool pending = false;
+
+   for(size_t i = 0; i < relayspectators.getLength(); i++)
+   {
+      relayspectator_t &rs = relayspectators[i];
+
+      if(!rs.inuse)
+         continue;
+
+      if(now - rs.heardat > RELAYTIMEOUT)
+      {
+         rs.inuse = false;
+         I_NetDropSpectator(static_cast<int>(i));
+         continue;
+      }
+
+      if(rs.sent > rs.acked && now - rs.movedat > RELAYRESEND)
+      {
+         rs.sent    = rs.acked;
+         rs.movedat = now;
+      }
+
+      while(rs.sent < available && rs.sent - rs.acked < RELAYWINDOW)
+      {
+         if(rs.sent == rs.acked)
+            rs.movedat = now; // the resend timer starts with the first byte out
+
+         const uint32_t len = emin<uint32_t>(available - rs.sent,
+                                             RELAYWINDOW - (rs.sent - rs.acked));
+
+         rs.sent += I_NetSendRelay(static_cast<int>(i), rs.sent,
+                                   relaystream.begin() + rs.sent, static_cast<int>(len));
+         ++netstats.packetssent;
+      }
+
+      if(rs.acked < length)
+         pending = true;
+   }
+
+   I_NetFlush();
+
+   if(!d_dedicated)
+      return;
+
+   for(int i = 0; i < MAXPLAYERS; i++)
+   {
+      if(playeringame[i])
+         return;
+   }
+
+   D_endRelay();
+
+   if(D_relayAvailable() < relaystream.getLength())
+      relaydoneat = now;
+   else if(!pending || now - relaydoneat > RELAYTIMEOUT)
+      I_ExitWithMessage("Every player has left the game.\n");
+}
+
 //
 // ExpandTics
 //
@@ -131,6 +462,10 @@ static void HSendPacket(int node, int flags)
    if(!netgame)
       I_Error("Tried to transmit to another node\n");
 
+   ++netstats.packetssent;
+   if(flags & NCMD_RETRANSMIT)
+      ++netstats.retransmitsasked;
+
    doomcom->command    = CMD_SEND;
    doomcom->remotenode = node;
    
@@ -163,12 +498,101 @@ static bool HGetPacket()
    
    if(doomcom->remotenode == -1)
       return false;
+
+   ++netstats.packetsreceived;
    
    // haleyjd 08/25/11: length & checksum not handled here any more
    
    return true;
 }
 
+//
+// D_keyPlayer
+//
+// The key player is the lowest numbered one left in the game. A dedicated
+// host is key for as long as it stays, in player 1's slot.
+//
+static int D_keyPlayer()
+{
+   if(dedicatedkey && nodeingame[nodeforplayer[0]])
+      return 0;
+
+   for(int i = 0; i < MAXPLAYERS; i++)
+   {
+      if(playeringame[i])
+         return i;
+   }
+   return 0;
+}
+
+//
+// D_setInputDelay
+//
+// A raised delay is made up by building tics early, a lowered one by leaving
+// tics out.
+//
+static void D_setInputDelay(int delay)
+{
+   delay = eclamp(delay, 0, MAXINPUTDELAY);
+
+   if(delay > inputdelay)
+      aheadtics += delay - inputdelay;
+   else
+      skiptics += inputdelay - delay;
+
+   inputdelay = delay;
+}
+
+//
+// D_updateInputDelay
+//
+// Works out the input delay this player's links need, and puts it in the
+// outgoing packet. The key player takes the highest anyone wants, raising the
+// delay at once but lowering it only after the lower value held for
+// INPUTDELAYHOLD tics, and sends that instead.
+//
+static void D_updateInputDelay(int tics)
+{
+   const int ticms = 1000 * ticdup / TICRATE;
+   int want = 0;
+
+   for(int i = 1; i < doomcom->numnodes; i++)
+   {
+      int rtt, jitter;
+
+      // a tic must get there within half a round trip, give or take jitter
+      if(nodeingame[i] && I_NetNodeTiming(i, rtt, jitter))
+         want = emax(want, (rtt / 2 + 2 * jitter + ticms / 2) / ticms);
+   }
+   want = emin(want, MAXINPUTDELAY);
+
+   if(consoleplayer != D_keyPlayer())
+   {
+      netbuffer->inputdelay = static_cast<byte>(want);
+      return;
+   }
+
+   for(int i = 0; i < MAXPLAYERS; i++)
+   {
+      if(playeringame[i] && i != consoleplayer)
+         want = emax(want, wanteddelay[i]);
+   }
+
+   if(want >= inputdelay)
+   {
+      lowerdelaytics = 0;
+      if(want > inputdelay)
+         D_setInputDelay(want);
+   }
+   else if((lowerdelaytics += tics) >= INPUTDELAYHOLD)
+   {
+      lowerdelaytics = 0;
+      D_setInputDelay(inputdelay - 1);
+   }
+
+   netbuffer->inputdelay = static_cast<byte>(inputdelay);
+}
+
 //
 // GetPackets
 //
@@ -199,6 +623,14 @@ static void GetPackets()
          if(!nodeingame[netnode])
             continue;
          nodeingame[netnode] = false;
+
+         // the dedicated host has no player to take out
+         if(dedicatedkey && !netconsole)
+         {
+            doom_printf("The host left the game");
+            continue;
+         }
+
          playeringame[netconsole] = false;
          doom_printf("%s left the game", players[netconsole].name);
          
@@ -226,6 +658,7 @@ static void GetPackets()
          }
          if(demorecording)
             G_CheckDemoStatus();
+         D_endRelay();
 
          continue;
       }
@@ -235,31 +668,50 @@ static void GetPackets()
          I_Error("Killed by network driver\n");
       
       nodeforplayer[netconsole] = netnode;
+
+      if(netconsole < MAXNETNODES && (netformatplayers & (1 << netconsole)))
+      {
+         netformatplayers &= ~(1 << netconsole);
+         I_NetSetFormat(netnode, NETFORMAT_DELTA);
+      }
       
       // check for retransmit request
       if(resendcount[netnode] <= 0  && (netbuffer->checksum & NCMD_RETRANSMIT))
       {
          resendto[netnode] = ExpandTics(netbuffer->retransmitfrom);
          resendcount[netnode] = RESENDCOUNT;
+         ++netstats.retransmitsgiven;
       }
       else
          resendcount[netnode]--;
       
       // check for out of order / duplicated packet           
-      if(realend == nettics[netnode])
-         continue;
-      
-      if(realend < nettics[netnode])
+      if(realend <= nettics[netnode])
+      {
+         if(netnode)
+            ++netstats.duplicates;
          continue;
+      }
       
       // check for a missed packet
       if(realstart > nettics[netnode])
       {
          // stop processing until the other system resends the missed tics
          remoteresend[netnode] = true;
+         ++netstats.gaps;
          continue;
       }
       
+      // follow the key player's input delay, or note what another player wants
+      if(netnode && netconsole < MAXPLAYERS &&
+         netbuffer->inputdelay != NETDELAY_NONE)
+      {
+         if(netconsole != D_keyPlayer())
+            wanteddelay[netconsole] = netbuffer->inputdelay;
+         else if(consoleplayer != netconsole)
+            D_setInputDelay(netbuffer->inputdelay);
+      }
+
       // update command store from the packet
       int start;
          
@@ -298,11 +750,18 @@ void NetUpdate()
    newtics = nowtime - gametime;
    gametime = nowtime;
    
-   if(newtics <= 0)   // nothing new to update
+   if(newtics <= 0 && !aheadtics)   // nothing new to update
    {
       GetPackets();
       return;
    }
+
+   if(netgame && !demoplayback)
+      D_updateInputDelay(emax(newtics, 0));
+
+   // build early for a raised input delay
+   newtics = emax(newtics, 0) + aheadtics;
+   aheadtics = 0;
    
    if(skiptics <= newtics)
    {
@@ -327,7 +786,10 @@ void NetUpdate()
       if(maketic - gameticdiv >= BACKUPTICS / 2 - 1)
          break; // can't hold any more
       
-      G_BuildTiccmd(&localcmds[maketic%BACKUPTICS]);
+      if(d_dedicated)
+         localcmds[maketic%BACKUPTICS] = {}; // nobody plays on the host
+      else
+         G_BuildTiccmd(&localcmds[maketic%BACKUPTICS]);
       ++maketic;
    }
   
@@ -423,9 +885,55 @@ static void D_InitPlayers()
    }
 }
 
+//
+// D_sendNetStartInfo
+//
+// Sends the key player's setup packet to every node. ackmask holds the
+// players that have answered it so far.
+//
+static void D_sendNetStartInfo(int ackmask)
+{
+   for(int i = 0; i < doomcom->numnodes; i++)
+   {
+      netbuffer->retransmitfrom = startskill;
+      if(GameType == gt_dm)
+         netbuffer->retransmitfrom |= (1 << 6);
+      if(nomonsters)
+         netbuffer->retransmitfrom |= 0x20;
+      if(respawnparm)
+         netbuffer->retransmitfrom |= 0x10;
+      // FIXME: not large enough for Heretic!
+      netbuffer->starttic = (d_startlevel.episode - 1) * 64 + d_startlevel.map;
+      netbuffer->player = version;
+
+#ifdef RANGECHECK
+      if(SETUP_SIZE > sizeof(netbuffer->d.data))
+         I_Error("D_sendNetStartInfo: SETUP_SIZE"
+                 " too large w.r.t. BACKUPTICS\n");
+#endif
+
+      G_WriteOptions(netbuffer->d.data);    // killough 12/98
+      netbuffer->d.data[SETUP_FORMAT]  = NETFORMAT_CURRENT;
+      netbuffer->d.data[SETUP_ACKMASK] = static_cast<byte>(ackmask);
+      netbuffer->d.data[SETUP_FLAGS]   = d_dedicated ? SETUPF_DEDICATED : 0;
+
+      // killough 5/2/98: Always write the maximum number of tics.
+      netbuffer->numtics = BACKUPTICS;
+
+      HSendPacket(i, NCMD_SETUP);
+   }
+}
+
 //
 // D_ArbitrateNetStart
 //
+// Besides the game settings, the key player's setup packets negotiate the
+// ticcmd wire format. A peer that reads the format offered answers with a
+// setup packet of its own, and waits until the key player's ack mask shows
+// it was heard. If that doesn't come soon enough it goes ahead anyway;
+// peers that haven't been told about each other upgrade once they receive
+// delta tics, since only a peer that reads them sends them.
+//
 static void D_ArbitrateNetStart()
 {
    bool gotinfo[MAXNETNODES];
@@ -435,14 +943,24 @@ static void D_ArbitrateNetStart()
 
    if(doomcom->consoleplayer)
    {
+      int keynode = -1;
+      int answertime = 0;
+
       usermsg("Listening for network start info... (ESC to cancel)");
       while(1)
       {
          C_Update(); // haleyjd 01/14/12: update the screen
          CheckAbort();
          if(!HGetPacket())
+         {
+            if(keynode >= 0 && i_haltimer.GetTime() - answertime > 2 * TICRATE)
+               break;
+            continue;
+         }
+         if(!(netbuffer->checksum & NCMD_SETUP))
             continue;
-         if(netbuffer->checksum & NCMD_SETUP)
+
+         if(keynode < 0)
          {
             bool dm;
 
@@ -461,13 +979,39 @@ static void D_ArbitrateNetStart()
                DefaultGameType = GameType = gt_dm;
 
             G_ReadOptions(netbuffer->d.data);
-            break;
+
+            if(netbuffer->d.data[SETUP_FLAGS] & SETUPF_DEDICATED)
+            {
+               dedicatedkey = true;
+               nodeforplayer[0] = doomcom->remotenode;
+            }
+
+            // an older key player sends the legacy format only
+            if(netbuffer->d.data[SETUP_FORMAT] < NETFORMAT_DELTA)
+               break;
+
+            keynode = doomcom->remotenode;
+            I_NetSetFormat(keynode, emin<int>(netbuffer->d.data[SETUP_FORMAT],
+                                              NETFORMAT_CURRENT));
          }
+
+         const int ackmask = netbuffer->d.data[SETUP_ACKMASK];
+         netformatplayers = ackmask & ~(1 << consoleplayer);
+         if(ackmask & (1 << consoleplayer))
+            break;
+
+         // answer with the formats we read
+         netbuffer->player = consoleplayer;
+         netbuffer->numtics = 0;
+         netbuffer->d.data[SETUP_FORMAT] = NETFORMAT_CURRENT;
+         HSendPacket(keynode, NCMD_SETUP);
+         answertime = i_haltimer.GetTime();
       }
    }
    else
    {
       int numnodesgotten = 0;
+      int ackmask = 0;
       usermsg("Sending network start info...");
 
       G_ScrambleRand();
@@ -476,37 +1020,24 @@ static void D_ArbitrateNetStart()
       do
       {
          CheckAbort();
-         for(int i = 0; i < doomcom->numnodes; i++)
-         {
-            netbuffer->retransmitfrom = startskill;
-            if(GameType == gt_dm)
-               netbuffer->retransmitfrom |= (1 << 6);
-            if(nomonsters)
-               netbuffer->retransmitfrom |= 0x20;
-            if(respawnparm)
-               netbuffer->retransmitfrom |= 0x10;
-            // FIXME: not large enough for Heretic!
-            netbuffer->starttic = (d_startlevel.episode - 1) * 64 + d_startlevel.map;
-            netbuffer->player = version;
-
-#ifdef RANGECHECK
-            if(GAME_OPTION_SIZE > sizeof(netbuffer->d.data))
-               I_Error("D_ArbitrateNetStart: GAME_OPTION_SIZE"
-                       " too large w.r.t. BACKUPTICS\n");
-#endif
-
-            G_WriteOptions(netbuffer->d.data);    // killough 12/98
-            
-            // killough 5/2/98: Always write the maximum number of tics.
-            netbuffer->numtics = BACKUPTICS;
-            
-            HSendPacket(i, NCMD_SETUP);
-         }
+         D_sendNetStartInfo(ackmask);
 
          for(int i = 10; i && HGetPacket(); i--)
          {
-            if((netbuffer->player & 0x7f) < MAXNETNODES)
-               gotinfo[netbuffer->player & 0x7f] = true;
+            const int player = netbuffer->player & 0x7f;
+
+            if(player >= MAXNETNODES)
+               continue;
+            gotinfo[player] = true;
+
+            // a peer answering our setup packet
+            if((netbuffer->checksum & NCMD_SETUP) && doomcom->remotenode &&
+               netbuffer->d.data[SETUP_FORMAT] >= NETFORMAT_DELTA)
+            {
+               ackmask |= 1 << player;
+               I_NetSetFormat(doomcom->remotenode,
+                              emin<int>(netbuffer->d.data[SETUP_FORMAT], NETFORMAT_CURRENT));
+            }
          }
 
          numnodesgotten = 1;
@@ -517,6 +1048,9 @@ static void D_ArbitrateNetStart()
          }
       }
       while(numnodesgotten < doomcom->numnodes);
+
+      // let the last peers to answer see that they were heard
+      D_sendNetStartInfo(ackmask);
    }
    
    // NETCODE_FIXME: See note above about D_InitPlayers
@@ -543,6 +1077,16 @@ void D_CheckNetGame()
    // I_InitNetwork sets doomcom and netgame
    I_InitNetwork();
 
+   // log the network statistics every second
+   int p;
+   if((p = M_CheckParm("-netstatscsv")) && ++p < myargc)
+   {
+      if((netstatscsv = fopen(myargv[p], "w")))
+         D_writeNetStatsCSV(true);
+      else
+         usermsg("Couldn't open %s for network statistics", myargv[p]);
+   }
+
    D_InitNetGame();
    
    D_InitPlayers();      
@@ -558,6 +1102,11 @@ void D_InitNetGame()
    
    netbuffer = &doomcom->data;
    consoleplayer = displayplayer = doomcom->consoleplayer;
+
+   // the host goes first in everyone's -net list, as player 1
+   if(d_dedicated && (!netgame || consoleplayer))
+      I_Error("D_InitNetGame: -dedicated needs -net 1 <players...>\n");
+   dedicatedkey = d_dedicated;
    
    if(netgame)
       D_ArbitrateNetStart();
@@ -572,6 +1121,17 @@ void D_InitNetGame()
       playeringame[i] = true;
    for(int i = 0; i < doomcom->numnodes; i++)
       nodeingame[i] = true;
+
+   if(dedicatedkey)
+   {
+      playeringame[0] = false;
+      if(d_dedicated)
+      {
+         displayplayer = 1;
+         usermsg("dedicated host for %i players", doomcom->numplayers - 1);
+         return;
+      }
+   }
   
    usermsg("player %i of %i (%i nodes)",
            consoleplayer+1, doomcom->numplayers, doomcom->numnodes);
@@ -600,6 +1160,7 @@ void D_QuitNetGame()
          if(nodeingame[j])
             HSendPacket(j, NCMD_EXIT);
       }
+      I_NetFlush();
       i_haltimer.Sleep(15);
    }  
 }
@@ -630,6 +1191,8 @@ void D_QuitNetGame()
 // haleyjd 01/04/2010
 bool d_fastrefresh;
 bool d_interpolate;
+bool d_predict;      // turn the local view by tics not yet run
+int  d_maxframetics; // most game tics run between two frames; 0 = no limit
 
 int  frametics[4];
 int  frameon;
@@ -675,6 +1238,9 @@ static bool RunGameTics()
       }
    }
    availabletics = lowtic - gametic/ticdup;
+
+   netstats.queued = maketic - gametic/ticdup;
+   netstats.ready  = availabletics;
    
    // decide how many tics to run
    if(realtics < availabletics-1)
@@ -685,25 +1251,28 @@ static bool RunGameTics()
       counts = availabletics;
   
    // haleyjd 09/07/10: enhanced d_fastrefresh w/early return when no tics to run
-   if(counts <= 0 && d_fastrefresh && !timingdemo) // 10/03/10: not in timedemos!
+   // a dedicated host draws nothing, so it waits for tics instead
+   if(counts <= 0 && d_fastrefresh && !timingdemo && !d_dedicated) // 10/03/10: not in timedemos!
       return false;
 
    if(counts < 1)
       counts = 1;
+
+   // When the playsim falls behind, catching up runs several slow tics back to
+   // back without a frame in between, which makes the next frame later still.
+   // Spreading the backlog over several frames keeps presentation going; the
+   // tics themselves, and so demo sync, are the same either way.
+   if(d_fastrefresh && d_maxframetics > 0 && counts > d_maxframetics &&
+      !netgame && !timingdemo)
+      counts = d_maxframetics;
    
    frameon++;
    
    if(!demoplayback)
    {   
-      int pnum;
-
       // ideally nettics[0] should be 1 - 3 tics above lowtic
       // if we are consistantly slower, speed up time
-      for(pnum = 0; pnum < MAXPLAYERS; pnum++)
-      {
-         if(playeringame[pnum])
-            break;
-      }
+      const int pnum = D_keyPlayer();
 
       // the key player does not adapt
       if(consoleplayer != pnum)
@@ -716,7 +1285,7 @@ static bool RunGameTics()
          oldnettics = nettics[0];
          if(frameskip[0] && frameskip[1] && frameskip[2] && frameskip[3])
          {
-            skiptics = 1;
+            skiptics = emax(skiptics, 1); // keep any owed to the input delay
          }
       }
    }
@@ -761,8 +1330,16 @@ static bool RunGameTics()
       }
       
       // Sleep until a tic is available, so we don't hog the CPU.
+      const unsigned int sleepstart = i_haltimer.GetTicks();
       i_haltimer.Sleep(1);
 
+      // our own tics are paced by the clock; only count waiting on others
+      if(netgame && nettics[0] >= gametic/ticdup + counts)
+      {
+         waitedfortics = true;
+         netstats.waitms += i_haltimer.GetTicks() - sleepstart;
+      }
+
       return false;
    }
    
@@ -781,6 +1358,7 @@ static bool RunGameTics()
          i_haltimer.SaveMS();
          G_Ticker();
          gametic++;
+         D_relayEndTic();
          
          // modify command for duplicated tics
 
@@ -804,12 +1382,73 @@ static bool RunGameTics()
    return true;
 }
 
+//
+// D_PredictLocalView
+//
+// In a netgame the console player's ticcmds wait for every node before they
+// run, so turning and looking lag by the round trip. This applies the turns
+// of the tics built but not yet run to the view angle and pitch the renderer
+// is about to use. It only ever reads the game, so nothing has to be rolled
+// back: each frame starts again from the tics that have run.
+//
+void D_PredictLocalView(angle_t &angle, fixed_t &pitch)
+{
+   const player_t &player = players[consoleplayer];
+
+   if(!d_predict || !netgame || demoplayback || singletics ||
+      player.playerstate != PST_LIVE || !player.mo ||
+      player.mo->reactiontime || (player.mo->flags & MF_JUSTATTACKED))
+      return;
+
+   // the first pending ticcmd may have run for some of its duplicated tics
+   int runs = ticdup - gametic % ticdup;
+
+   for(int tic = gametic / ticdup; tic < maketic; tic++)
+   {
+      const ticcmd_t &cmd = localcmds[tic % BACKUPTICS];
+
+      angle += angle_t(cmd.angleturn << 16) * runs;
+
+      if(allowmlook && cmd.look)
+      {
+         if(cmd.look == -32768)
+            pitch = 0;
+         else
+         {
+            pitch -= (cmd.look << 16) * runs;
+            pitch = eclamp(pitch, -ANGLE_1 * GameModeInfo->lookPitchUp,
+                           ANGLE_1 * GameModeInfo->lookPitchDown);
+         }
+      }
+
+      runs = ticdup;
+   }
+}
+
+//
+// After a demo seek moves gametic, makes the built and received tics agree
+// with it again, so that no tics are owed or waited for.
+//
+static void D_resyncTics()
+{
+   maketic = gametic / ticdup;
+
+   for(int i = 0; i < doomcom->numnodes; i++)
+      nettics[i] = resendto[i] = maketic;
+
+   skiptics = aheadtics = 0;
+   gametime = i_haltimer.GetTime() / ticdup;
+}
+
 void TryRunTics()
 {
    static int oldentertic;
    int entertic, realtics;
    int game_advanced = 0;
 
+   ++netstats.frames;
+   waitedfortics = false;
+
    // Loop until we have done some kind of useful work.  If no
    // game tics are run, RunGameTics() will send the game to
    // sleep in 1ms increments until we advance.
@@ -841,10 +1480,20 @@ void TryRunTics()
             V_FPSTicker();
       }
 
+      // a demo seek runs its tics here, between those of the netcode
+      if(G_RunDemoSeek())
+         D_resyncTics();
+
       // run the game tickers
       game_advanced = RunGameTics();
    } 
-   while(!d_fastrefresh && realtics <= 0 && !game_advanced);
+   while((!d_fastrefresh || d_dedicated) && realtics <= 0 && !game_advanced);
+
+   if(waitedfortics)
+      ++netstats.stallframes;
+
+   D_netStatsTicker();
+   D_relayTicker();
 }
 
 /////////////////////////////////////////////////////
@@ -867,11 +1516,24 @@ CONSOLE_COMMAND(kick, cf_server)
 
 CONSOLE_COMMAND(playerinfo, 0)
 {
-   int i;
-   
-   for(i = 0; i < MAXPLAYERS; ++i)
-      if(playeringame[i])
+   for(int i = 0; i < MAXPLAYERS; ++i)
+   {
+      int rtt, jitter;
+
+      if(!playeringame[i])
+         continue;
+
+      if(i != consoleplayer && I_NetNodeTiming(nodeforplayer[i], rtt, jitter))
+      {
+         C_Printf("%i: %s (%i ms, jitter %i ms)\n",
+                  i, players[i].name, rtt, jitter);
+      }
+      else
          C_Printf("%i: %s\n",i, players[i].name);
+   }
+
+   if(netgame)
+      C_Printf("input delay: %i tic%s\n", inputdelay, inputdelay == 1 ? "" : "s");
 }
 
 /*
@@ -886,12 +1548,55 @@ CONSOLE_COMMAND(disconnect, cf_netonly)
 }
 */
  
+//
+// net_stats [reset]
+// Prints the network statistics, in total and over the last second.
+//
+CONSOLE_COMMAND(net_stats, 0)
+{
+   if(Console.argc >= 1 && !Console.argv[0]->strCaseCmp("reset"))
+   {
+      netstats     = {};
+      netstatsrate = {};
+      lastnetstats = {};
+      C_Printf("Network statistics reset.\n");
+      return;
+   }
+
+   const netstats_t &t = netstats;
+   const netstats_t &r = netstatsrate;
+
+   C_Printf(FC_HI "              total  last second\n" FC_NORMAL);
+   C_Printf("packets out %9d %9d\n", t.packetssent,      r.packetssent);
+   C_Printf("packets in  %9d %9d\n", t.packetsreceived,  r.packetsreceived);
+   C_Printf("bytes out   %9d %9d\n", t.bytessent,        r.bytessent);
+   C_Printf("bytes in    %9d %9d\n", t.bytesreceived,    r.bytesreceived);
+   C_Printf("bad sums    %9d %9d\n", t.badchecksums,     r.badchecksums);
+   C_Printf("resend asks %9d %9d\n", t.retransmitsasked, r.retransmitsasked);
+   C_Printf("resends     %9d %9d\n", t.retransmitsgiven, r.retransmitsgiven);
+   C_Printf("duplicates  %9d %9d\n", t.duplicates,       r.duplicates);
+   C_Printf("gaps        %9d %9d\n", t.gaps,             r.gaps);
+   C_Printf("frames      %9d %9d\n", t.frames,           r.frames);
+   C_Printf("stalled     %9d %9d\n", t.stallframes,      r.stallframes);
+   C_Printf("waited ms   %9d %9d\n", t.waitms,           r.waitms);
+   C_Printf("tics queued %d, ready %d\n", t.queued, t.ready);
+}
+
 VARIABLE_TOGGLE(d_fastrefresh, nullptr, onoff);
 CONSOLE_VARIABLE(d_fastrefresh, d_fastrefresh, 0) {}
 
 VARIABLE_TOGGLE(d_interpolate, nullptr, onoff);
 CONSOLE_VARIABLE(d_interpolate, d_interpolate, 0) {}
 
+VARIABLE_TOGGLE(d_predict, nullptr, onoff);
+CONSOLE_VARIABLE(d_predict, d_predict, 0) {}
+
+VARIABLE_INT(d_maxframetics, nullptr, 0, BACKUPTICS / 2, nullptr);
+CONSOLE_VARIABLE(d_maxframetics, d_maxframetics, 0) {}
+
+VARIABLE_INT(d_relaydelay, nullptr, 0, 600, nullptr);
+CONSOLE_VARIABLE(d_relaydelay, d_relaydelay, 0) {}
+
 //----------------------------------------------------------------------------
 //
 // $Log: d_net.c,v $
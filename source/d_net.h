@@ -27,6 +27,8 @@
 #define D_NET_H__
 
 #include "d_ticcmd.h"
+#include "m_fixed.h"
+#include "tables.h"
 
 //
 // Network play related stuff.
@@ -62,6 +64,30 @@ enum
 // killough 5/2/98: number of bytes reserved for saving options
 #define GAME_OPTION_SIZE 64
 
+// Ticcmd wire formats. The key player's setup packets name the highest one
+// it reads, and peers that understand that answer with theirs. Peers that
+// never answer are sent the legacy format.
+enum
+{
+   NETFORMAT_LEGACY,  // the non-zero fields of each tic
+   NETFORMAT_DELTA,   // the fields that changed since the previous tic
+   NETFORMAT_TIMED,   // delta tics after a timing and input delay header
+   NETFORMAT_CURRENT = NETFORMAT_TIMED
+};
+
+// inputdelay of a packet sent without one
+#define NETDELAY_NONE 0xff
+
+// Setup packets carry the format negotiation after the game options, padded
+// so that the packet checksum covers it. Older versions ignore it.
+#define SETUP_FORMAT  (GAME_OPTION_SIZE)     // highest format the sender reads
+#define SETUP_ACKMASK (GAME_OPTION_SIZE + 1) // players the key has heard answer
+#define SETUP_FLAGS   (GAME_OPTION_SIZE + 2) // SETUPF_* flags
+#define SETUP_SIZE    (GAME_OPTION_SIZE + 4)
+
+// the key node is a dedicated host, which has player 1's slot but no player
+#define SETUPF_DEDICATED 0x01
+
 // haleyjd 10/16/07: structures in this file must be packed
 #if defined(_MSC_VER) || defined(__GNUC__)
 #pragma pack(push, 1)
@@ -80,10 +106,13 @@ struct doomdata_t
     byte         starttic;
     byte         player;
     byte         numtics;
+    // The key player's input delay in tics, or the one another player wants
+    // for its own links. NETDELAY_NONE unless sent in NETFORMAT_TIMED.
+    byte         inputdelay;
 
     union packetdata_u
     {
-       byte      data[GAME_OPTION_SIZE];
+       byte      data[SETUP_SIZE];
        ticcmd_t  cmds[BACKUPTICS];
     } d;
 };
@@ -182,12 +211,49 @@ void D_QuitNetGame();
 // how many ticks to run?
 void TryRunTics();
 
+// Turns the console player's view by its tics that haven't run yet.
+void D_PredictLocalView(angle_t &angle, fixed_t &pitch);
+
+// Spectator relay of a dedicated host: begins the stream once the game is
+// set up, and adds each player's ticcmd to it as G_Ticker runs them.
+void D_StartRelay();
+void D_RelayTiccmd(const ticcmd_t *cmd);
+
 extern bool d_fastrefresh;
 extern bool d_interpolate;
+extern bool d_predict;
+extern int  d_maxframetics;
+extern bool d_dedicated;   // -dedicated: host the game without playing
+extern int  d_relaydelay;  // seconds the spectator relay runs behind
 extern bool opensocket;
 
 extern ticcmd_t netcmds[][BACKUPTICS];
 
+//
+// Network statistics. The counts run from the start of the game; the queue
+// depths are as of the last frame.
+//
+struct netstats_t
+{
+   int packetssent;
+   int packetsreceived;
+   int bytessent;
+   int bytesreceived;
+   int badchecksums;     // packets dropped by the driver for a bad checksum
+   int retransmitsasked; // packets sent asking a node to resend
+   int retransmitsgiven; // resends started for another node
+   int duplicates;       // packets with no tics that weren't already here
+   int gaps;             // packets that came after one that was lost
+   int frames;
+   int stallframes;      // frames that had to wait for another node's tics
+   int waitms;           // time spent waiting for them
+   int queued;           // local tics built but not yet run
+   int ready;            // tics every node has sent but not yet run
+};
+
+extern netstats_t netstats;     // totals
+extern netstats_t netstatsrate; // over the last whole second
+
 #endif
 
 //----------------------------------------------------------------------------
@@ -24,6 +24,7 @@
 
 #include "z_zone.h"
 
+#include "acs_intr.h"
 #include "d_items.h"
 #include "d_player.h"
 #include "e_args.h"
@@ -160,6 +161,28 @@ void E_ResetAllArgEvals()
    }
 }
 
+//
+// Reset only the state arguments that were evaluated to the given type, for
+// caches that are invalidated by something other than EDF, such as the ACS
+// string table being reloaded from a save.
+//
+void E_ResetArgEvalsOfType(evaltype_e type)
+{
+   for(int stnum = 0; stnum < NUMSTATES; stnum++)
+   {
+      arglist_t *args = states[stnum]->args;
+
+      if(args)
+      {
+         for(int argnum = 0; argnum < args->numargs; argnum++)
+         {
+            if(args->values[argnum].type == type)
+               args->values[argnum].type = EVALTYPE_NONE;
+         }
+      }
+   }
+}
+
 //
 // This is just a safe method to get the argument string at the given
 // index. If the argument doesn't exist, defvalue is returned.
@@ -379,6 +402,7 @@ int E_ArgAsThingNumG0(arglist_t *al, int index)
 //
 state_t *E_GetJumpInfo(const mobjinfo_t *mi, const char *arg)
 {
+   ScratchScope scope; // temparg is only needed in here
    char *temparg = Z_Strdupa(arg);
    char *colon   = strchr(temparg, ':');
 
@@ -422,6 +446,7 @@ state_t *E_GetJumpInfo(const mobjinfo_t *mi, const char *arg)
 //
 state_t *E_GetWpnJumpInfo(const weaponinfo_t *wi, const char *arg)
 {
+   ScratchScope scope; // temparg is only needed in here
    char *temparg = Z_Strdupa(arg);
    char *colon   = strchr(temparg, ':');
 
@@ -950,6 +975,28 @@ edf_string_t *E_ArgAsEDFString(arglist_t *al, int index)
    return eval.value.estr;
 }
 
+//
+// Gets the arg value at index i as an interned ACS string, such as a script
+// name, if such argument exists. The handle will be cached so that the name
+// does not need to be hashed again on subsequent calls. If the arg does not
+// exist, nullptr is returned.
+//
+ACSVM::String *E_ArgAsACSString(arglist_t *al, int index)
+{
+   if(!al || index >= al->numargs)
+      return nullptr;
+
+   evalcache_t &eval = al->values[index];
+
+   if(eval.type != EVALTYPE_ACSSTRING)
+   {
+      eval.type         = EVALTYPE_ACSSTRING;
+      eval.value.acsstr = ACS_InternString(al->args[index]);
+   }
+
+   return eval.value.acsstr;
+}
+
 //
 // Gets the arg value at index i as an EDF damage type, if such argument exists.
 // The evaluated value will be cached so that it can be returned on subsequent
@@ -35,6 +35,8 @@
 #include "m_fixed.h"
 #include "tables.h"
 
+namespace ACSVM { class String; }
+
 struct edf_string_t;
 struct emod_t;
 class  Mobj;
@@ -66,6 +68,7 @@ typedef enum
    EVALTYPE_EDFSTRING, // evaluated to an edf string
    EVALTYPE_KEYWORD,   // evaluated to a keyword enumeration value
    EVALTYPE_MOD,       // evaluated to a damagetype/means of damage
+   EVALTYPE_ACSSTRING, // evaluated to an ACS string handle
    EVALTYPE_NUMTYPES
 } evaltype_e;
 
@@ -81,6 +84,7 @@ struct evalcache_t
       sfxinfo_t    *s;
       edf_string_t *estr;
       emod_t       *mod;
+      ACSVM::String *acsstr;
       unsigned int  flags[MAXFLAGFIELDS];
    } value;
    bool dehacked;
@@ -112,6 +116,7 @@ bool          E_SetArgFromNumber(arglist_t *al, int index, int value, dehackedAr
 void          E_DisposeArgs(arglist_t *al);
 void          E_ResetArgEval(arglist_t *al, int index);
 void          E_ResetAllArgEvals();
+void          E_ResetArgEvalsOfType(evaltype_e type);
 
 const char   *E_ArgAsString(const arglist_t *al, int index, const char *defvalue);
 int           E_ArgAsInt(arglist_t *al, int index, int defvalue);
@@ -134,6 +139,7 @@ unsigned int  E_ArgAsFlags(arglist_t *al, int index, dehflagset_t *flagset);
 sfxinfo_t    *E_ArgAsSound(arglist_t *al, int index);
 int           E_ArgAsBexptr(arglist_t *al, int index);
 edf_string_t *E_ArgAsEDFString(arglist_t *al, int index);
+ACSVM::String *E_ArgAsACSString(arglist_t *al, int index);
 emod_t       *E_ArgAsDamageType(arglist_t *al, int index, int defvalue);
 int           E_ArgAsKwd(arglist_t *al, int index, const argkeywd_t *kw,
                          int defvalue);
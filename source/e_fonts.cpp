@@ -789,6 +789,9 @@ static void E_ProcessFont(cfg_t *const sec, bool delta)
 
    const char *title = delta ? cfg_getstr(sec, ITEM_DELTA_NAME) : cfg_title(sec);
 
+   // text drawn with the font's old settings must not be reused
+   V_FlushFontCache();
+
    // The fonts were already pre-created; retrieve the vfont_t structure for
    // this definition.
    font = E_FontForName(title);
@@ -1121,6 +1124,8 @@ void E_ReloadFonts()
 {
    vfont_t *font = nullptr;
 
+   V_FlushFontCache();
+
    // run down all hash chains
    // WARNING: do not use e_font_namehash here, because it's already iterated
    // inside the called function.
@@ -27,6 +27,7 @@
 
 #include "e_hashkeys.h"
 #include "m_dllist.h"
+#include "m_simd.h"
 
 //
 // This class replaces the ehash_t structure to provide a generic,
@@ -208,7 +209,7 @@ public:
    // unmodulated hash code, or nullptr if that hash chain is empty. The
    // object returned does not necessarily match the given hash code.
    //
-   item_type *chainForKey(param_key_type key, unsigned int unmodHC)
+   item_type *chainForKey(param_key_type key, unsigned int unmodHC) const
    {
       if(isInit)
       {
@@ -426,6 +427,356 @@ public:
    }
 };
 
+//
+// EFlatHashTable
+//
+// An EHashTable with an open-addressed index beside its chains, for tables
+// that are searched far more often than they change. The chains still hold
+// every object in the same order, so duplicate keys, keyIterator and table
+// iteration behave exactly as they do in EHashTable; only objectForKey goes
+// through the index.
+//
+// The index has one slot per distinct key, pointing at the object a chain
+// lookup would find first. Slots hold the unmodulated hash code next to the
+// object pointer, and a separate byte per slot holds seven bits of the hash
+// as a tag. Slots come in groups of sixteen, whose tags are compared in one
+// go with SSE2 or AArch64 NEON, so a lookup usually reads one group of tags and one
+// slot before it compares a key at all.
+//
+template<typename item_type, typename key_type,
+         typename key_type::basic_type const item_type::* hashKey,
+         DLListItem<item_type> item_type::* linkPtr>
+class EFlatHashTable : public EHashTable<item_type, key_type, hashKey, linkPtr>
+{
+   typedef EHashTable<item_type, key_type, hashKey, linkPtr> Super;
+
+public:
+   typedef typename Super::link_type      link_type;
+   typedef typename Super::param_key_type param_key_type;
+
+protected:
+   struct slot_t
+   {
+      unsigned int  hash;   // unmodulated hash code
+      item_type    *object;
+   };
+
+   static constexpr int     GROUPSIZE    = 16;
+   static constexpr uint8_t TAG_EMPTY    = 0x80;
+   static constexpr uint8_t TAG_DELETED  = 0xfe;
+
+   uint8_t      *tags;      // one per slot: TAG_EMPTY, TAG_DELETED or a hash tag
+   slot_t       *slots;
+   unsigned int  numGroups; // always a power of two
+   unsigned int  numUsed;   // slots holding a key or a deletion marker
+   unsigned int  numKeys;
+
+   // The hash codes of string keys are weak in their low bits, so they are
+   // mixed before choosing a group and a tag.
+   static unsigned int Mix(unsigned int hash) { return hash * 0x9E3779B1u; }
+
+   static uint8_t TagFor(unsigned int mixed) { return uint8_t(mixed >> 25); }
+
+   unsigned int groupFor(unsigned int mixed) const
+   {
+      return (mixed ^ (mixed >> 15)) & (numGroups - 1);
+   }
+
+   //
+   // Bit i is set if tag i of the group equals tag.
+   //
+   static unsigned int MatchGroup(const uint8_t *group, uint8_t tag)
+   {
+#if defined(EE_SIMD_SSE2)
+      const __m128i tagv = _mm_set1_epi8(char(tag));
+      const __m128i grp  = _mm_loadu_si128(reinterpret_cast<const __m128i *>(group));
+      return unsigned(_mm_movemask_epi8(_mm_cmpeq_epi8(grp, tagv)));
+#elif defined(EE_SIMD_NEON) && (defined(__aarch64__) || defined(_M_ARM64))
+      static const uint8_t bits[GROUPSIZE] =
+      {
+         1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128
+      };
+      const uint8x16_t eq = vandq_u8(vceqq_u8(vld1q_u8(group), vdupq_n_u8(tag)),
+                                     vld1q_u8(bits));
+      return unsigned(vaddv_u8(vget_low_u8(eq))) |
+             unsigned(vaddv_u8(vget_high_u8(eq))) << 8;
+#else
+      unsigned int mask = 0;
+      for(int i = 0; i < GROUPSIZE; i++)
+      {
+         if(group[i] == tag)
+            mask |= 1u << i;
+      }
+      return mask;
+#endif
+   }
+
+   static int LowestBit(unsigned int mask)
+   {
+      int bit = 0;
+      while(!(mask & 1))
+      {
+         mask >>= 1;
+         ++bit;
+      }
+      return bit;
+   }
+
+   //
+   // Returns the slot holding key, or -1.
+   //
+   int findSlot(param_key_type key, unsigned int unmodHC) const
+   {
+      if(!numGroups)
+         return -1;
+
+      const unsigned int mixed = Mix(unmodHC);
+      const uint8_t      tag   = TagFor(mixed);
+      unsigned int       group = groupFor(mixed);
+
+      // triangular probing visits every group once
+      for(unsigned int probe = 1; probe <= numGroups; probe++)
+      {
+         const uint8_t *grouptags = tags + group * GROUPSIZE;
+         unsigned int   mask     = MatchGroup(grouptags, tag);
+
+         while(mask)
+         {
+            const int     index = int(group * GROUPSIZE) + LowestBit(mask);
+            const slot_t &slot  = slots[index];
+
+            if(slot.hash == unmodHC && key_type::Compare(slot.object->*hashKey, key))
+               return index;
+            mask &= mask - 1;
+         }
+
+         if(MatchGroup(grouptags, TAG_EMPTY))
+            return -1;
+
+         group = (group + probe) & (numGroups - 1);
+      }
+
+      return -1;
+   }
+
+   //
+   // Puts a key known not to be in the index into the first free slot of its
+   // probe sequence. There is always one, as the index is never full.
+   //
+   void placeSlot(item_type *object, unsigned int unmodHC)
+   {
+      const unsigned int mixed = Mix(unmodHC);
+      unsigned int       group = groupFor(mixed);
+
+      for(unsigned int probe = 1; ; probe++)
+      {
+         uint8_t     *grouptags = tags + group * GROUPSIZE;
+         unsigned int mask      = MatchGroup(grouptags, TAG_EMPTY) |
+                                  MatchGroup(grouptags, TAG_DELETED);
+         if(mask)
+         {
+            const int index = LowestBit(mask);
+
+            if(grouptags[index] == TAG_EMPTY)
+               ++numUsed;
+            grouptags[index] = TagFor(mixed);
+            slots[group * GROUPSIZE + index].hash   = unmodHC;
+            slots[group * GROUPSIZE + index].object = object;
+            ++numKeys;
+            return;
+         }
+
+         group = (group + probe) & (numGroups - 1);
+      }
+   }
+
+   void allocIndex(unsigned int pNumGroups)
+   {
+      numGroups = pNumGroups;
+      numUsed   = numKeys = 0;
+      tags      = emalloc(uint8_t *, numGroups * GROUPSIZE);
+      slots     = ecalloc(slot_t *, numGroups * GROUPSIZE, sizeof(slot_t));
+      memset(tags, TAG_EMPTY, numGroups * GROUPSIZE);
+   }
+
+   void freeIndex()
+   {
+      if(tags)
+         efree(tags);
+      if(slots)
+         efree(slots);
+      tags      = nullptr;
+      slots     = nullptr;
+      numGroups = numUsed = numKeys = 0;
+   }
+
+   //
+   // Makes room for one more key, keeping the index at most 7/8 used.
+   // Deletion markers are cleared out rather than grown over.
+   //
+   void reserveSlot()
+   {
+      if(numGroups && (numUsed + 1) * 8 <= numGroups * GROUPSIZE * 7)
+         return;
+
+      uint8_t     *oldtags      = tags;
+      slot_t      *oldslots     = slots;
+      unsigned int oldNumSlots  = numGroups * GROUPSIZE;
+      unsigned int newNumGroups = numGroups ? numGroups : 1;
+
+      if((numKeys + 1) * 2 > oldNumSlots)
+         newNumGroups *= 2;
+
+      allocIndex(newNumGroups);
+
+      for(unsigned int i = 0; i < oldNumSlots; i++)
+      {
+         if(!(oldtags[i] & TAG_EMPTY))
+            placeSlot(oldslots[i].object, oldslots[i].hash);
+      }
+
+      if(oldtags)
+         efree(oldtags);
+      if(oldslots)
+         efree(oldslots);
+   }
+
+   //
+   // Indexes the first object on each chain for each key, for when the
+   // chains have been reordered.
+   //
+   void reindex()
+   {
+      freeIndex();
+
+      for(unsigned int i = 0; i < this->numChains; i++)
+      {
+         for(link_type *link = this->chains[i]; link; link = link->dllNext)
+         {
+            item_type *object = link->dllObject;
+
+            if(findSlot(object->*hashKey, link->dllData) < 0)
+            {
+               reserveSlot();
+               placeSlot(object, link->dllData);
+            }
+         }
+      }
+   }
+
+public:
+   EFlatHashTable()
+      : Super(), tags(nullptr), slots(nullptr), numGroups(0), numUsed(0),
+        numKeys(0)
+   {
+   }
+
+   explicit EFlatHashTable(unsigned int pNumChains)
+      : Super(pNumChains), tags(nullptr), slots(nullptr), numGroups(0),
+        numUsed(0), numKeys(0)
+   {
+   }
+
+   void destroy()
+   {
+      freeIndex();
+      Super::destroy();
+   }
+
+   //
+   // The newest object is put first on its chain, so it becomes the one the
+   // index holds for its key.
+   //
+   void addObject(item_type &object, unsigned int unmodHC)
+   {
+      Super::addObject(object, unmodHC);
+
+      const int index = findSlot(object.*hashKey, unmodHC);
+      if(index >= 0)
+         slots[index].object = &object;
+      else
+      {
+         reserveSlot();
+         placeSlot(&object, unmodHC);
+      }
+   }
+
+   void addObject(item_type &object)
+   {
+      addObject(object, key_type::HashCode(object.*hashKey));
+   }
+
+   void addObject(item_type *object) { addObject(*object); }
+   void addObject(item_type *object, unsigned int unmodHC)
+   {
+      addObject(*object, unmodHC);
+   }
+
+   //
+   // If the object was the one indexed for its key, the next object on the
+   // chain with the same key takes its place.
+   //
+   void removeObject(item_type &object)
+   {
+      if(!this->isInit)
+         return;
+
+      const unsigned int unmodHC = (object.*linkPtr).dllData;
+      const int          index   = findSlot(object.*hashKey, unmodHC);
+
+      Super::removeObject(object);
+
+      if(index < 0 || slots[index].object != &object)
+         return;
+
+      if(item_type *next = Super::objectForKey(object.*hashKey, unmodHC))
+         slots[index].object = next;
+      else
+      {
+         tags[index]  = TAG_DELETED;
+         slots[index] = slot_t();
+         --numKeys;
+      }
+   }
+
+   void removeObject(item_type *object) { removeObject(*object); }
+
+   item_type *objectForKey(param_key_type key, unsigned int unmodHC) const
+   {
+      const int index = findSlot(key, unmodHC);
+      return index >= 0 ? slots[index].object : nullptr;
+   }
+
+   item_type *objectForKey(param_key_type key) const
+   {
+      return objectForKey(key, key_type::HashCode(key));
+   }
+
+   item_type *keyIterator(const item_type *object, param_key_type key,
+                          unsigned int unmodHC) const
+   {
+      return object ? Super::keyIterator(object, key, unmodHC) :
+                      objectForKey(key, unmodHC);
+   }
+
+   item_type *keyIterator(const item_type *object, param_key_type key) const
+   {
+      return keyIterator(object, key, key_type::HashCode(key));
+   }
+
+   void rebuild(unsigned int newNumChains)
+   {
+      Super::rebuild(newNumChains);
+      reindex();
+   }
+
+   void reverseChains()
+   {
+      Super::reverseChains();
+      reindex();
+   }
+};
+
 #endif
 
 // EOF
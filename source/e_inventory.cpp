@@ -1644,6 +1644,10 @@ static void E_processPickupEffects(cfg_t *cfg)
 static PODCollection<itemeffect_t *> e_InventoryItemsByID;
 static inventoryitemid_t e_maxitemid;
 
+// For each player, the inventory index holding each item ID, or -1 where the
+// player doesn't have the item. Kept in step with every change to the slots.
+static inventoryindex_t *e_itemslots[MAXPLAYERS];
+
 inventoryindex_t e_maxvisiblesortorder = INT_MIN;
 
 //
@@ -1940,6 +1944,69 @@ static void E_allocatePlayerInventories()
 
       for(inventoryindex_t idx = 0; idx < e_maxitemid; idx++)
          players[i].inventory[idx].item = -1;
+
+      if(e_itemslots[i])
+         efree(e_itemslots[i]);
+
+      e_itemslots[i] = emalloc(inventoryindex_t *, e_maxitemid * sizeof(inventoryindex_t));
+
+      for(inventoryitemid_t id = 0; id < e_maxitemid; id++)
+         e_itemslots[i][id] = -1;
+   }
+}
+
+//
+// Item slot index for a player, or nullptr if it isn't one of players[].
+//
+static inventoryindex_t *E_itemSlotsFor(const player_t *player)
+{
+   for(int i = 0; i < MAXPLAYERS; i++)
+   {
+      if(player == &players[i])
+         return e_itemslots[i];
+   }
+
+   return nullptr;
+}
+
+//
+// Points the index at the slots from first up to the first empty one.
+//
+static void E_indexInventorySlots(const player_t *player, inventoryindex_t first)
+{
+   inventoryindex_t *itemslots = E_itemSlotsFor(player);
+   inventory_t       inventory = player->inventory;
+
+   if(!itemslots)
+      return;
+
+   for(inventoryindex_t idx = first; idx < e_maxitemid && inventory[idx].item != -1; idx++)
+   {
+      if(inventory[idx].item >= 0 && inventory[idx].item < e_maxitemid)
+         itemslots[inventory[idx].item] = idx;
+   }
+}
+
+//
+// Rebuilds a player's item slot index after the whole inventory has been
+// replaced, as when loading a savegame.
+//
+void E_ReindexInventory(const player_t *player)
+{
+   inventoryindex_t *itemslots = E_itemSlotsFor(player);
+
+   if(!itemslots)
+      return;
+
+   for(inventoryitemid_t id = 0; id < e_maxitemid; id++)
+      itemslots[id] = -1;
+
+   // unlike E_indexInventorySlots, don't trust the slots to be packed
+   for(inventoryindex_t idx = 0; idx < e_maxitemid; idx++)
+   {
+      const inventoryitemid_t id = player->inventory[idx].item;
+      if(id >= 0 && id < e_maxitemid && itemslots[id] < 0)
+         itemslots[id] = idx;
    }
 }
 
@@ -1976,6 +2043,13 @@ inventoryslot_t *E_InventorySlotForItemID(const player_t *player,
 {
    inventory_t inventory = player->inventory;
 
+   if(const inventoryindex_t *itemslots = E_itemSlotsFor(player))
+   {
+      if(id < 0 || id >= e_maxitemid || itemslots[id] < 0)
+         return nullptr;
+      return &inventory[itemslots[id]];
+   }
+
    for(inventoryindex_t idx = 0; idx < e_maxitemid; idx++)
    {
       if(inventory[idx].item == id)
@@ -2076,6 +2150,7 @@ static void E_sortInventory(const player_t *player, inventoryindex_t newIndex,
 
             // put the saved slot into its proper place
             inventory[idx] = tempSlot;
+            E_indexInventorySlots(player, idx);
             return;
          }
       }
@@ -2266,6 +2341,9 @@ bool E_GiveInventoryItem(player_t *player, const itemeffect_t *artifact, int amo
    if(slot->amount > maxAmount)
       slot->amount = maxAmount;
 
+   if(!initslot)
+      E_indexInventorySlots(player, newSlot);
+
    // sort if needed
    if(newSlot > 0)
       E_sortInventory(player, newSlot, artifact->getInt(keySortOrder, 0), artifact->getKey());
@@ -2286,6 +2364,12 @@ static void E_removeInventorySlot(const player_t *player, inventoryslot_t *slot)
    {
       if(slot == &inventory[idx])
       {
+         if(inventoryindex_t *itemslots = E_itemSlotsFor(player))
+         {
+            if(slot->item >= 0 && slot->item < e_maxitemid)
+               itemslots[slot->item] = -1;
+         }
+
          // shift everything down
          for(inventoryindex_t down = idx; down < e_maxitemid - 1; down++)
             inventory[down] = inventory[down + 1];
@@ -2294,6 +2378,8 @@ static void E_removeInventorySlot(const player_t *player, inventoryslot_t *slot)
          inventory[e_maxitemid - 1].item   = -1;
          inventory[e_maxitemid - 1].amount =  0;
 
+         E_indexInventorySlots(player, idx);
+
          E_MoveInventoryCursor(player, -1, const_cast<int &>(player->inv_ptr));
 
          return;
@@ -2390,6 +2476,12 @@ void E_ClearInventory(player_t *player)
       player->inventory[i].item   = -1;
    }
 
+   if(inventoryindex_t *itemslots = E_itemSlotsFor(player))
+   {
+      for(inventoryitemid_t id = 0; id < e_maxitemid; id++)
+         itemslots[id] = -1;
+   }
+
    player->inv_ptr = 0;
    invbarstate     = { false, 0 };
 }
@@ -281,6 +281,9 @@ void E_InventoryEndHub(const player_t *player);
 // Call to completely clear a player's inventory.
 void E_ClearInventory(player_t *player);
 
+// Call after replacing the contents of a player's inventory wholesale.
+void E_ReindexInventory(const player_t *player);
+
 // Get allocated size of player inventory arrays
 int E_GetInventoryAllocSize();
 
@@ -61,6 +61,7 @@
 #include "m_utils.h"
 #include "p_mobj.h"
 #include "p_skin.h"
+#include "s_formats.h"
 #include "s_sndseq.h"
 #include "s_sound.h"
 #include "w_wad.h"
@@ -94,6 +95,9 @@ constexpr const char ITEM_DELTA_NAME[] = "name";
 //
 constexpr int NUMSFXCHAINS = 307;
 static sfxinfo_t             *sfxchains[NUMSFXCHAINS];
+
+// bumped whenever a sound is added to the name hash
+static unsigned int sfxgeneration = 1;
 static DLListItem<sfxinfo_t> *sfx_dehchains[NUMSFXCHAINS];
 
 //
@@ -275,6 +279,19 @@ static void E_AddSoundToHash(sfxinfo_t *sfx)
    // link it in
    sfx->next = sfxchains[hash];
    sfxchains[hash] = sfx;
+
+   ++sfxgeneration;
+}
+
+//
+// E_SoundNameGeneration
+//
+// Returns a number that changes whenever a sound is added to the name hash,
+// so code remembering what a name resolved to knows when to look again.
+//
+unsigned int E_SoundNameGeneration()
+{
+   return sfxgeneration;
 }
 
 //
@@ -484,6 +501,9 @@ void E_UpdateSoundCache()
    // be sure all sounds are stopped
    S_StopSounds(true);
 
+   // and that none are still being converted
+   S_FinishSoundPrecache();
+
    for(sfxinfo_t *cursfx : sfxchains)
    {
       while(cursfx)
@@ -38,6 +38,7 @@ extern sfxinfo_t NullSound;
 
 sfxinfo_t *E_SoundForName(const char *);
 sfxinfo_t *E_EDFSoundForName(const char *name);
+unsigned int E_SoundNameGeneration();
 sfxinfo_t *E_SoundForDEHNum(int);
 sfxinfo_t *E_FindSoundForDEH(char *inbuffer, unsigned int fromlen);
 sfxinfo_t *E_NewWadSound(const char *);
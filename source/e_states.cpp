@@ -1206,11 +1206,25 @@ static void E_ProcessState(int i, cfg_t *const framesec, bool def)
    int tempint;
    const char *tempstr;
 
+   // This runs for every frame and frame delta, so the options are looked up
+   // through handles resolved once per option table.
+   static cfg_opthandle_t hDecorate {ITEM_FRAME_DECORATE};
+   static cfg_opthandle_t hCmp      {ITEM_FRAME_CMP};
+   static cfg_opthandle_t hSprite   {ITEM_FRAME_SPRITE};
+   static cfg_opthandle_t hSprFrame {ITEM_FRAME_SPRFRAME};
+   static cfg_opthandle_t hFullBrt  {ITEM_FRAME_FULLBRT};
+   static cfg_opthandle_t hTics     {ITEM_FRAME_TICS};
+   static cfg_opthandle_t hAction   {ITEM_FRAME_ACTION};
+   static cfg_opthandle_t hNextFrame{ITEM_FRAME_NEXTFRAME};
+   static cfg_opthandle_t hArgs     {ITEM_FRAME_ARGS};
+   static cfg_opthandle_t hMisc1    {ITEM_FRAME_MISC1};
+   static cfg_opthandle_t hMisc2    {ITEM_FRAME_MISC2};
+   static cfg_opthandle_t hPtclEvent{ITEM_FRAME_PTCLEVENT};
 
    // IS_SET: Tests whether or not a particular field should
    // be set. When applying deltas, we should not retrieve defaults.
-   const auto IS_SET = [framesec, &def](const char *const name) -> bool {
-      return def || cfg_size(framesec, (name)) > 0;
+   const auto IS_SET = [framesec, &def](cfg_opthandle_t &handle) -> bool {
+      return def || cfg_size(framesec, handle) > 0;
    };
 
    // 11/14/03:
@@ -1222,7 +1236,7 @@ static void E_ProcessState(int i, cfg_t *const framesec, bool def)
    // in a DECORATE state block by a thingtype.
    if(def)
    {
-      int decoratestate = cfg_getflag(framesec, ITEM_FRAME_DECORATE);
+      int decoratestate = cfg_getflag(framesec, hDecorate);
 
       if(decoratestate)
       {
@@ -1232,9 +1246,9 @@ static void E_ProcessState(int i, cfg_t *const framesec, bool def)
       else
          states[i]->flags &= ~STATEFI_DECORATE;
 
-      if(cfg_size(framesec, ITEM_FRAME_CMP) > 0)
+      if(cfg_size(framesec, hCmp) > 0)
       {
-         tempstr = cfg_getstr(framesec, ITEM_FRAME_CMP);
+         tempstr = cfg_getstr(framesec, hCmp);
          
          E_ProcessCmpState(tempstr, i);
          def = false; // process remainder as if a frame delta
@@ -1243,44 +1257,44 @@ static void E_ProcessState(int i, cfg_t *const framesec, bool def)
    }
 
    // process sprite
-   if(IS_SET(ITEM_FRAME_SPRITE))
+   if(IS_SET(hSprite))
    {
-      tempstr = cfg_getstr(framesec, ITEM_FRAME_SPRITE);
+      tempstr = cfg_getstr(framesec, hSprite);
 
       E_StateSprite(tempstr, i);
    }
 
    // process spriteframe
-   if(IS_SET(ITEM_FRAME_SPRFRAME))
-      states[i]->frame = cfg_getint(framesec, ITEM_FRAME_SPRFRAME);
+   if(IS_SET(hSprFrame))
+      states[i]->frame = cfg_getint(framesec, hSprFrame);
 
    // haleyjd 09/22/07: if sprite == blankSpriteNum, force to frame 0
    if(states[i]->sprite == blankSpriteNum)
       states[i]->frame = 0;
 
    // check for fullbright
-   if(IS_SET(ITEM_FRAME_FULLBRT))
+   if(IS_SET(hFullBrt))
    {
-      if(cfg_getbool(framesec, ITEM_FRAME_FULLBRT))
+      if(cfg_getbool(framesec, hFullBrt))
          states[i]->frame |= FF_FULLBRIGHT;
    }
 
    // process tics
-   if(IS_SET(ITEM_FRAME_TICS))
-      states[i]->tics = cfg_getint(framesec, ITEM_FRAME_TICS);
+   if(IS_SET(hTics))
+      states[i]->tics = cfg_getint(framesec, hTics);
 
    // resolve codepointer
-   if(IS_SET(ITEM_FRAME_ACTION))
+   if(IS_SET(hAction))
    {
-      tempstr = cfg_getstr(framesec, ITEM_FRAME_ACTION);
+      tempstr = cfg_getstr(framesec, hAction);
 
       E_StateAction(tempstr, i);
    }
 
    // process nextframe
-   if(IS_SET(ITEM_FRAME_NEXTFRAME))
+   if(IS_SET(hNextFrame))
    {
-      tempstr = cfg_getstr(framesec, ITEM_FRAME_NEXTFRAME);
+      tempstr = cfg_getstr(framesec, hNextFrame);
       
       E_StateNextFrame(tempstr, i);
    }
@@ -1290,16 +1304,16 @@ hitcmp:
    // args field parsing (even more complicated, but similar)
    // Note: deltas can only set the entire args list at once, not
    // just parts of it.
-   if(IS_SET(ITEM_FRAME_ARGS))
+   if(IS_SET(hArgs))
    {
-      tempint = cfg_size(framesec, ITEM_FRAME_ARGS);
+      tempint = cfg_size(framesec, hArgs);
 
       // create an arg list for the state, or clear out the existing one
       E_CreateArgList(states[i]);
 
       for(j = 0; j < tempint; ++j)
       {
-         tempstr = cfg_getnstr(framesec, ITEM_FRAME_ARGS, j);
+         tempstr = cfg_getnstr(framesec, hArgs, j);
          
          E_AddArgToList(states[i]->args, E_GetArgument(tempstr));
       }
@@ -1313,22 +1327,22 @@ hitcmp:
 hitdecorate:
    // misc field parsing (complicated)
 
-   if(IS_SET(ITEM_FRAME_MISC1))
+   if(IS_SET(hMisc1))
    {
-      tempstr = cfg_getstr(framesec, ITEM_FRAME_MISC1);
+      tempstr = cfg_getstr(framesec, hMisc1);
       E_ParseMiscField(tempstr, &(states[i]->misc1));
    }
 
-   if(IS_SET(ITEM_FRAME_MISC2))
+   if(IS_SET(hMisc2))
    {
-      tempstr = cfg_getstr(framesec, ITEM_FRAME_MISC2);
+      tempstr = cfg_getstr(framesec, hMisc2);
       E_ParseMiscField(tempstr, &(states[i]->misc2));
    }
 
    // process particle event
-   if(IS_SET(ITEM_FRAME_PTCLEVENT))
+   if(IS_SET(hPtclEvent))
    {
-      tempstr = cfg_getstr(framesec, ITEM_FRAME_PTCLEVENT);
+      tempstr = cfg_getstr(framesec, hPtclEvent);
 
       E_StatePtclEvt(tempstr, i);
    }
@@ -721,17 +721,17 @@ struct thinggrouppair_t
 // Number of chains
 constexpr int NUMTHINGCHAINS = 307;
 
-// hash by name
-static EHashTable<mobjinfo_t, ENCStringHashKey, 
-                  &mobjinfo_t::name, &mobjinfo_t::namelinks> thing_namehash(NUMTHINGCHAINS);
+// hash by name; looked up by name all through play, so flat
+static EFlatHashTable<mobjinfo_t, ENCStringHashKey,
+                      &mobjinfo_t::name, &mobjinfo_t::namelinks> thing_namehash(NUMTHINGCHAINS);
 
 // hash by compatname
 static EHashTable<mobjinfo_t, ENCStringHashKey,
                   &mobjinfo_t::compatname, &mobjinfo_t::cnamelinks> thing_cnamehash(NUMTHINGCHAINS);
 
 // hash by DeHackEd number
-static EHashTable<mobjinfo_t, EIntHashKey,
-                  &mobjinfo_t::dehnum, &mobjinfo_t::numlinks> thing_dehhash(NUMTHINGCHAINS);
+static EFlatHashTable<mobjinfo_t, EIntHashKey,
+                      &mobjinfo_t::dehnum, &mobjinfo_t::numlinks> thing_dehhash(NUMTHINGCHAINS);
 
 // Thing group
 static EHashTable<ThingGroup, ENCQStrHashKey,
@@ -29,13 +29,13 @@
 
 #include "doomstat.h"
 #include "e_exdata.h"
-#include "e_hash.h"
 #include "e_lib.h"
 #include "e_mod.h"
 #include "e_sound.h"
 #include "e_ttypes.h"
 #include "e_udmf.h"
 #include "m_compare.h"
+#include "m_perfecthash.h"
 #include "p_scroll.h"
 #include "p_setup.h"
 #include "p_spec.h"
@@ -726,13 +726,12 @@ enum token_e
 struct keytoken_t
 {
    const char *string;
-   DLListItem<keytoken_t> link;
    token_e token;
 };
 
-#define TOKEN(a) { #a, DLListItem<keytoken_t>(), t_##a }
+#define TOKEN(a) { #a, t_##a }
 
-static keytoken_t gTokenList[] =
+static constexpr keytoken_t gTokenList[] =
 {
    TOKEN(alpha),
    TOKEN(alphaceiling),
@@ -878,17 +877,8 @@ static keytoken_t gTokenList[] =
    TOKEN(zoneboundary),
 };
 
-static EHashTable<keytoken_t, ENCStringHashKey, &keytoken_t::string, &keytoken_t::link> gTokenTable;
-
-static void registerAllKeys()
-{
-   static bool called = false;
-   if(called)
-      return;
-   for(size_t i = 0; i < earrlen(gTokenList); ++i)
-      gTokenTable.addObject(gTokenList[i]);
-   called = true;
-}
+// every key is placed while compiling, so there is nothing to set up
+static constexpr MPerfectHash<earrlen(gTokenList)> gTokenTable(gTokenList, &keytoken_t::string);
 
 //
 // Looks for "ee_compat = true;" in the TEXTMAP in order to accept unknown name-
@@ -987,8 +977,6 @@ bool UDMFParser::parse(WadDirectory &setupwad, int lump)
    USector *sector = nullptr;
    uthing_t *thing = nullptr;
 
-   registerAllKeys();   // now it's the time
-
    while((result = readItem()) != result_Eof)
    {
       if(result == result_Error)
@@ -1031,7 +1019,8 @@ bool UDMFParser::parse(WadDirectory &setupwad, int lump)
 #define READ_FIXED(obj, field) case t_##field: readFixed(obj->field); break
 #define REQUIRE_FIXED(obj, field, flag) case t_##field: requireFixed(obj->field, obj->flag); break
 
-         const keytoken_t *kt = gTokenTable.objectForKey(mKey.constPtr());
+         const int         ktindex = gTokenTable.find(mKey.constPtr());
+         const keytoken_t *kt      = ktindex >= 0 ? &gTokenList[ktindex] : nullptr;
          if(kt)
          {
             if(linedef)
@@ -1592,26 +1581,28 @@ bool UDMFParser::next(Token &token)
 {
    // Skip all leading whitespace
    bool checkWhite = true;
-   size_t size = mData.length();
+   const size_t size = mData.length();
+   const char *data = mData.constPtr();
 
    while(checkWhite)
    {
       checkWhite = false;  // reset it unless someone else restores it
 
-      while(mPos != size && ectype::isSpace(mData[mPos]))
-         addPos(1);
+      skipSpaces();
       if(mPos == size)
          return false;
 
       // Skip comments
-      if(mData[mPos] == '/' && mPos + 1 < size && mData[mPos + 1] == '/')
+      if(data[mPos] == '/' && mPos + 1 < size && data[mPos + 1] == '/')
       {
-         addPos(2);
          // one line comment
-         while(mPos != size && mData[mPos] != '\n')
-            addPos(1);
-         if(mPos == size)
+         const char *eol = static_cast<const char *>(memchr(data + mPos, '\n', size - mPos));
+         if(!eol)
+         {
+            addColumns(size - mPos);
             return false;
+         }
+         addColumns(eol - data - mPos);
 
          // If here, we hit an "enter"
          addPos(1);
@@ -1621,17 +1612,17 @@ bool UDMFParser::next(Token &token)
          checkWhite = true;   // look again for whitespaces if reached here
       }
 
-      if(mData[mPos] == '/' && mPos + 1 < size && mData[mPos + 1] == '*')
+      if(data[mPos] == '/' && mPos + 1 < size && data[mPos + 1] == '*')
       {
          addPos(2);
-         while(mPos + 1 < size && (mData[mPos] != '*' || mData[mPos + 1] != '/'))
+         while(mPos + 1 < size && (data[mPos] != '*' || data[mPos + 1] != '/'))
             addPos(1);
          if(mPos + 1 >= size)
          {
             addPos(1);
             return false;
          }
-         if(mData[mPos] == '*' && mData[mPos + 1] == '/')
+         if(data[mPos] == '*' && data[mPos + 1] == '/')
             addPos(2);
          if(mPos == size)
             return false;
@@ -1640,21 +1631,27 @@ bool UDMFParser::next(Token &token)
    }
 
    // now we're clear from whitespaces and comments
+   const char c = data[mPos];
 
-   // Check for number
-   char *result = nullptr;
-   double number = strtod(&mData[mPos], &result);
-   if(result > &mData[mPos])  // we have something
+   // Check for number. Only try those characters strtod could start one with,
+   // which also covers its "inf" and "nan" spellings.
+   if(ectype::isDigit(c) || c == '-' || c == '+' || c == '.' ||
+      c == 'i' || c == 'I' || c == 'n' || c == 'N')
    {
-      // copy it
-      token.type = Token::type_Number;
-      token.number = number;
-      addPos(result - mData.constPtr() - mPos);
-      return true;
+      char *result = nullptr;
+      double number = strtod(data + mPos, &result);
+      if(result > data + mPos)  // we have something
+      {
+         // copy it
+         token.type = Token::type_Number;
+         token.number = number;
+         addColumns(result - data - mPos);
+         return true;
+      }
    }
 
    // Check for string
-   if(mData[mPos] == '"')
+   if(c == '"')
    {
       addPos(1);
 
@@ -1662,6 +1659,17 @@ bool UDMFParser::next(Token &token)
       // find the next string
       token.type = Token::type_String;
 
+      // most strings have no escapes and can be copied whole
+      size_t end = mPos;
+      while(end != size && data[end] != '"' && data[end] != '\\')
+         ++end;
+      if(end != size && data[end] == '"')
+      {
+         token.text.copy(data + mPos, end - mPos);
+         addPos(end - mPos + 1);  // skip the quote too
+         return true;
+      }
+
       // we must escape things here
       token.text.clear();
       bool escape = false;
@@ -1669,19 +1677,19 @@ bool UDMFParser::next(Token &token)
       {
          if(!escape)
          {
-            if(mData[mPos] == '\\')
+            if(data[mPos] == '\\')
                escape = true;
-            else if(mData[mPos] == '"')
+            else if(data[mPos] == '"')
             {
                addPos(1);     // skip the quote
                return true;   // we're done
             }
             else
-               token.text.Putc(mData[mPos]);
+               token.text.Putc(data[mPos]);
          }
          else
          {
-            token.text.Putc(mData[mPos]);
+            token.text.Putc(data[mPos]);
             escape = false;
          }
          addPos(1);
@@ -1690,27 +1698,56 @@ bool UDMFParser::next(Token &token)
    }
 
    // keyword: start with a letter or _
-   if(ectype::isAlpha(mData[mPos]) || mData[mPos] == '_')
+   if(ectype::isAlpha(c) || c == '_')
    {
       token.type = Token::type_Keyword;
-      token.text.clear();
-      while(mPos != size &&
-            (ectype::isAlnum(mData[mPos]) || mData[mPos] == '_'))
-      {
-         token.text.Putc(mData[mPos]);
-         addPos(1);
-      }
+
+      size_t end = mPos + 1;
+      while(end != size && (ectype::isAlnum(data[end]) || data[end] == '_'))
+         ++end;
+      token.text.copy(data + mPos, end - mPos);
+      addColumns(end - mPos);
       return true;
    }
 
    // symbol. Just put one character
    token.type = Token::type_Symbol;
-   token.symbol = mData[mPos];
+   token.symbol = c;
    addPos(1);
 
    return true;
 }
 
+//
+// Skips whitespace, keeping count of lines and columns on the way.
+//
+void UDMFParser::skipSpaces()
+{
+   const size_t size = mData.length();
+   const char *data = mData.constPtr();
+
+   while(mPos != size && ectype::isSpace(data[mPos]))
+   {
+      if(data[mPos] == '\n')
+      {
+         mColumn = 1;
+         mLine++;
+      }
+      else
+         mColumn++;
+      mPos++;
+   }
+}
+
+//
+// Advances over characters known not to hold a line break.
+//
+void UDMFParser::addColumns(size_t amount)
+{
+   mPos += amount;
+   mColumn += static_cast<int>(amount);
+}
+
 //
 // Increases position by given amount. Updates line and column accordingly.
 //
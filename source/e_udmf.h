@@ -453,7 +453,9 @@ private:
    readresult_e readItem();
 
    bool next(Token &token);
+   void skipSpaces();
    void addPos(size_t amount);
+   void addColumns(size_t amount);
 
    bool eof() const { return mPos == mData.length(); }
 
@@ -31,6 +31,7 @@
 #include "acs_intr.h"
 #include "c_io.h"
 #include "c_runcmd.h"
+#include "cam_sight.h"
 #include "d_dehtbl.h"
 #include "d_gi.h"
 #include "doomstat.h"
@@ -42,6 +43,7 @@
 #include "ev_specials.h"
 #include "ev_bindings.h"
 #include "g_game.h"
+#include "p_enemy.h"
 #include "p_info.h"
 #include "p_mobj.h"
 #include "p_setup.h"
@@ -778,9 +780,9 @@ ev_actiontype_t ParamActionType =
 // Lookup an action by number.
 //
 
-// Special hash table type
-typedef EHashTable<ev_binding_t, EIntHashKey, &ev_binding_t::actionNumber,
-                   &ev_binding_t::links> EV_SpecHash;
+// Special hash table type; searched for every line special activated
+typedef EFlatHashTable<ev_binding_t, EIntHashKey, &ev_binding_t::actionNumber,
+                       &ev_binding_t::links> EV_SpecHash;
 
 // By-name hash table type
 typedef EHashTable<ev_binding_t, ENCStringHashKey, &ev_binding_t::name,
@@ -1524,6 +1526,10 @@ static int EV_ActivateSpecial(ev_action_t *action, ev_instance_t *instance)
    // execute the action
    int result = action->action(action, instance);
 
+   // whatever it changed may affect line of sight or sound
+   CAM_InvalidateSightCache();
+   P_InvalidateSoundFloods(nullptr);
+
    // execute the post-action routine
    return action->type->post(action, result, instance);
 }
@@ -47,6 +47,7 @@
 #include "r_draw.h"
 #include "r_patch.h"
 #include "r_state.h"
+#include "r_things.h"
 #include "s_sound.h"
 #include "sounds.h"
 #include "v_font.h"
@@ -621,18 +622,18 @@ static void F_CastDrawer()
       F_CastPrint(cast->name);
    
    // draw the current frame in the middle of the screen
-   sprdef = sprites + caststate->sprite;
+   sprdef = R_SpriteDef(caststate->sprite);
    
    // override for alternate monster sprite?
    if(mi->altsprite != -1)
-      sprdef = &sprites[mi->altsprite];
+      sprdef = R_SpriteDef(mi->altsprite);
    
    // override for player skin?
    if(cast->type == cplayer->pclass->type)
    {
       int colormap = cplayer->colormap;
       
-      sprdef    = &sprites[cplayer->skin->sprite];
+      sprdef    = R_SpriteDef(cplayer->skin->sprite);
       translate = colormap ? translationtables[colormap - 1] : nullptr;
    }
    
@@ -33,9 +33,11 @@
 
 #include "c_runcmd.h"
 #include "doomdef.h"
+#include "d_jobs.h"
 #include "d_main.h"
 #include "f_wipe.h"
 #include "i_video.h"
+#include "m_compare.h"
 #include "m_random.h"
 #include "v_alloc.h"
 #include "v_misc.h"
@@ -49,6 +51,25 @@ int wipetype;
 static int current_wipetype;
 static byte *wipe_buffer = nullptr;
 
+// At high resolutions the drawers split the screen's columns between threads
+static constexpr int WIPE_MAXTHREADS      = 4;
+static constexpr int WIPE_PIXELSPERTHREAD = 1024 * 1024;
+
+//
+// Runs a column drawer over the whole screen. The drawers only read the
+// wipe's state and write their own columns, so they can run side by side.
+//
+static void Wipe_drawColumns(void (*drawer)(int x1, int x2))
+{
+   const int numthreads = eclamp(emin(D_NumJobWorkers() + 1,
+                                      video.width * video.height / WIPE_PIXELSPERTHREAD),
+                                 1, WIPE_MAXTHREADS);
+
+   D_RunParallel(numthreads, [drawer, numthreads] (int t) {
+      drawer(video.width * t / numthreads, video.width * (t + 1) / numthreads);
+   });
+}
+
 //==============================================================================
 //
 // haleyjd 10/12/08: melt wipe
@@ -70,8 +91,7 @@ static int starting_height;
 
 static void Wipe_meltStartScreen(void)
 {
-   int x, y;
-   byte *dest, *src;
+   int x;
 
    // SoM 2-4-04: ANYRES
    // use console height
@@ -101,21 +121,14 @@ static void Wipe_meltStartScreen(void)
       int wormx = (x << FRACBITS) / video.xscale;
       int wormy = video.y1lookup[worms[wormx] > 0 ? worms[wormx] : 0];
       
-      src = vbscreen.data + x * video.pitch;
-      dest = start_screen[x];
-      
-      for(y = 0; y < video.height - wormy; y++)
-         *dest++ = *src++;
+      memcpy(start_screen[x], vbscreen.data + x * video.pitch, video.height - wormy);
    }
 }
 
-static void Wipe_meltDrawer(void)
+static void Wipe_meltColumns(int x1, int x2)
 {
-   int x, y;
-   byte *dest, *src;
-
    // SoM 2-4-04: ANYRES
-   for(x = 0; x < video.width; ++x)
+   for(int x = x1; x < x2; ++x)
    {
       int wormy, wormx;
       
@@ -124,14 +137,16 @@ static void Wipe_meltDrawer(void)
 
       wormy = video.y1lookup[wormy];
 
-      src = start_screen[x];
-      dest = vbscreen.data + vbscreen.pitch * x + wormy;
-      
-      for(y = video.height - wormy; y--;)
-         *dest++ = *src++;
+      memcpy(vbscreen.data + vbscreen.pitch * x + wormy, start_screen[x],
+             video.height - wormy);
    }
 }
 
+static void Wipe_meltDrawer(void)
+{
+   Wipe_drawColumns(Wipe_meltColumns);
+}
+
 static bool Wipe_meltTicker(void)
 {
    bool done;
@@ -179,37 +194,57 @@ static bool Wipe_meltTicker(void)
 #define MAXFADE 64 // there are 64 levels in the Col2RGB8 table
 static int fadelvl;
 
+// Every blend of a new frame colour (high byte) over an old one (low byte) at
+// the current fade level, so each pixel takes one lookup. The table is only
+// rebuilt when the level moves on, which is far less often than a frame at
+// high resolutions.
+static byte fadetable[256 * 256];
+static int  fadetablelvl = -1;
+
+static void Wipe_buildFadeTable()
+{
+   unsigned int *fg2rgb = Col2RGB8[fadelvl];
+   unsigned int *bg2rgb = Col2RGB8[MAXFADE - fadelvl];
+
+   for(int fgc = 0; fgc < 256; fgc++)
+   {
+      for(int bgc = 0; bgc < 256; bgc++)
+      {
+         unsigned int fg = (fg2rgb[fgc] + bg2rgb[bgc]) | 0x1f07c1f;
+         fadetable[(fgc << 8) | bgc] = RGB32k[0][0][fg & (fg >> 15)];
+      }
+   }
+
+   fadetablelvl = fadelvl;
+}
+
 static void Wipe_fadeStartScreen(void)
 {
    fadelvl = 0;
+   fadetablelvl = -1;
    I_ReadScreen(wipe_buffer);
 }
 
+static void Wipe_fadeColumns(int x1, int x2)
+{
+   for(int x = x1; x < x2; ++x)
+   {
+      const byte *src  = wipe_buffer + x * vbscreen.height;
+      byte       *dest = vbscreen.data + x * vbscreen.pitch;
+
+      for(int y = 0; y < vbscreen.height; ++y)
+         dest[y] = fadetable[(dest[y] << 8) | src[y]];
+   }
+}
+
 static void Wipe_fadeDrawer(void)
 {
    if(fadelvl <= MAXFADE)
    {
-      byte *src, *dest;
-      unsigned int *fg2rgb = Col2RGB8[fadelvl];
-      unsigned int *bg2rgb = Col2RGB8[MAXFADE - fadelvl];
-      int x, y;
-
-      src = wipe_buffer;
+      if(fadetablelvl != fadelvl)
+         Wipe_buildFadeTable();
 
-      for(x = 0; x < vbscreen.width; ++x)
-      {
-         dest = vbscreen.data + x * vbscreen.pitch;
-
-         for(y = 0; y < vbscreen.height; ++y)
-         {
-            unsigned int fg, bg;
-            
-            fg = fg2rgb[*dest];
-            bg = bg2rgb[*src++];
-            fg = (fg + bg) | 0x1f07c1f;
-            *dest++ = RGB32k[0][0][fg & (fg >> 15)];
-         }
-      }
+      Wipe_drawColumns(Wipe_fadeColumns);
    }
 }
 
@@ -80,6 +80,7 @@ struct keyaction_t
    int type;          // type of action (at_variable or at_conscmd)
    int num;           // unique ID number (for at_variable, index into keyactions)
    keyaction_t *next; // haleyjd: used for console bindings
+   cmdline_t *cmdline; // at_conscmd command, parsed on first use
 };
 
 keyaction_t keyactions[NUMKEYACTIONS] =
@@ -581,7 +582,11 @@ int G_KeyResponder(const event_t *ev, int bclass, bool *allreleased)
          {
          case at_conscmd:
             if(!consoleactive) // haleyjd: not in console.
-               C_RunTextCmd(keybindings[key].bindings[bclass]->name);
+            {
+               if(!action->cmdline)
+                  action->cmdline = C_ParseCommandLine(action->name);
+               C_RunCommandLine(action->cmdline);
+            }
             break;
 
          default:
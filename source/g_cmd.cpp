@@ -451,6 +451,9 @@ extern int smooth_turning;
 VARIABLE_BOOLEAN(smooth_turning, nullptr,       onoff);
 CONSOLE_VARIABLE(smooth_turning, smooth_turning, 0) {}
 
+VARIABLE_BOOLEAN(mouse_lookahead, nullptr,      onoff);
+CONSOLE_VARIABLE(mouse_lookahead, mouse_lookahead, 0) {}
+
 // SoM: mouse accel
 acceltype_e default_mouse_accel_type = ACCELTYPE_NONE;
 const char *accel_options[]={ "off", "linear", "choco", "custom" };
@@ -23,6 +23,7 @@
 //
 
 #include "z_zone.h"
+#include "d_framestats.h"
 #include "d_main.h"
 #include "doomstat.h"
 #include "g_demolog.h"
@@ -96,6 +97,24 @@ void G_DemoLogStats()
              totalsecret ? 100 * allSecret / totalsecret : 0);
 }
 
+//
+// Logs the frame times over the level being left, so performance can be
+// read next to the sync data.
+//
+void G_DemoLogPerf()
+{
+   framesummary_t summary;
+
+   if(!demoLogFile || !d_framestats)
+      return;
+
+   D_FrameStatsSummary(true, summary);
+   G_DemoLog("\t(frames: %d, p50: %.2f ms, p95: %.2f ms, p99: %.2f ms, "
+             "max: %.2f ms, stall: %.2f ms)",
+             summary.frames, summary.p50, summary.p95, summary.p99,
+             summary.max, summary.longeststall);
+}
+
 //
 // Sets the flag
 //
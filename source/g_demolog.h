@@ -30,6 +30,7 @@
 void G_DemoLogInit(const char *path);
 void G_DemoLog(E_FORMAT_STRING(const char *format), ...) E_PRINTF(1, 2);
 void G_DemoLogStats();
+void G_DemoLogPerf();
 bool G_DemoLogEnabled();
 void G_DemoLogSetExited(bool value);
 
@@ -0,0 +1,304 @@
+//
+// The Eternity Engine
+// Copyright(C) 2026 James Haley, Max Waine, et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+// Additional terms and conditions compatible with the GPLv3 apply. See the
+// file COPYING-EE for details.
+//
+// Purpose: Demo seeking.
+//  Snapshots are written by the savegame code into memory blocks, together
+//  with the tic counters and the read position in the demo that go with
+//  them. A seek restores the last snapshot at or before the target tic and
+//  runs the game tickers, without drawing or sound, up to the target. When
+//  the snapshots outgrow their memory budget every other one is dropped and
+//  new ones are spaced twice as far apart.
+//
+
+#include "z_zone.h"
+
+#include "c_io.h"
+#include "c_runcmd.h"
+#include "d_main.h"
+#include "doomstat.h"
+#include "g_demoseek.h"
+#include "g_game.h"
+#include "hu_stuff.h"
+#include "m_collection.h"
+#include "m_compare.h"
+#include "p_chase.h"
+#include "p_saveg.h"
+#include "s_sound.h"
+#include "st_stuff.h"
+#include "v_misc.h"
+
+int demo_snapshotinterval = 10;
+int demo_snapshotmemory   = 32;
+
+struct demosnapshot_t
+{
+   int    gametic;       // tic about to run when it was taken
+   int    basetic;
+   int    levelstarttic;
+   size_t demopos;       // demo read position at that tic
+   byte  *data;          // the archived level
+   size_t size;
+};
+
+static PODCollection<demosnapshot_t> snapshots;
+static size_t snapshotbytes;   // total size of the snapshot data
+static int    snapshotspacing; // multiple of the interval, doubled on trimming
+static int    demostarttic;    // gametic of the first demo tic
+static int    seektarget = -1; // gametic a pending seek runs to
+
+//
+// Frees every snapshot; called whenever a demo starts or stops.
+//
+void G_ClearDemoSnapshots()
+{
+   for(demosnapshot_t &snap : snapshots)
+      efree(snap.data);
+
+   snapshots.clear();
+   snapshotbytes   = 0;
+   snapshotspacing = 1;
+   demostarttic    = gametic;
+   seektarget      = -1;
+}
+
+//
+// Keeps the first snapshot and every other one after it, until the rest fit
+// in the memory budget again.
+//
+static void G_trimDemoSnapshots()
+{
+   const size_t budget = size_t(demo_snapshotmemory) * 1024 * 1024;
+
+   while(snapshotbytes > budget && snapshots.getLength() > 1)
+   {
+      size_t kept = 1;
+
+      for(size_t i = 1; i < snapshots.getLength(); i++)
+      {
+         if(i & 1)
+         {
+            snapshotbytes -= snapshots[i].size;
+            efree(snapshots[i].data);
+         }
+         else
+            snapshots[kept++] = snapshots[i];
+      }
+
+      snapshots.resize(kept);
+      snapshotspacing *= 2;
+   }
+}
+
+//
+// Called from G_Ticker during playback, before the tic's commands are read.
+// Takes a snapshot when the level has run an interval past the latest one.
+//
+void G_DemoSnapshotTicker()
+{
+   if(gamestate != GS_LEVEL || paused || timingdemo)
+      return;
+
+   if(!snapshots.isEmpty())
+   {
+      const int spacing = demo_snapshotinterval * snapshotspacing * TICRATE;
+
+      // nothing is taken between older snapshots after a seek back
+      if(gametic - snapshots.back().gametic < spacing)
+         return;
+   }
+
+   demosnapshot_t &snap = snapshots.addNew();
+
+   snap.gametic       = gametic;
+   snap.basetic       = basetic;
+   snap.levelstarttic = levelstarttic;
+   snap.demopos       = G_DemoPosition();
+   P_SaveSnapshot(snap.data, snap.size);
+
+   snapshotbytes += snap.size;
+   G_trimDemoSnapshots();
+}
+
+//
+// Sets the level back to a snapshot. Loading a level takes the game out of
+// demo playback and resets the tic counters, so that state is put back.
+//
+static void G_restoreSnapshot(const demosnapshot_t &snap)
+{
+   const bool oldnetgame       = netgame;
+   const bool oldsingledemo    = singledemo;
+   const int  oldconsoleplayer = consoleplayer;
+   const int  olddisplayplayer = displayplayer;
+   const int  oldversion       = demo_version;
+   const int  oldsubversion    = demo_subversion;
+
+   P_LoadSnapshot(snap.data, snap.size);
+
+   demoplayback    = true;
+   usergame        = false;
+   netgame         = oldnetgame;
+   singledemo      = oldsingledemo;
+   demo_version    = oldversion;
+   demo_subversion = oldsubversion;
+   consoleplayer   = oldconsoleplayer;
+
+   if(displayplayer != olddisplayplayer)
+   {
+      displayplayer = olddisplayplayer;
+      ST_Start();
+      HU_Start();
+      P_ResetChasecam();
+   }
+
+   gametic       = snap.gametic;
+   basetic       = snap.basetic;
+   levelstarttic = snap.levelstarttic;
+   G_SetDemoPosition(snap.demopos);
+
+   wipegamestate = GS_LEVEL; // no wipe into the restored level
+}
+
+//
+// Runs a seek asked for by demo_seek. It is called between game tics, never
+// from inside one; returns true if the game tic moved, so the caller can
+// bring its own tic counting up to date.
+//
+bool G_RunDemoSeek()
+{
+   if(seektarget < 0)
+      return false;
+
+   const int target = seektarget;
+   seektarget = -1;
+
+   if(!demoplayback || target == gametic)
+      return false;
+
+   // the last snapshot at or before the target
+   const demosnapshot_t *snap = nullptr;
+   for(const demosnapshot_t &s : snapshots)
+   {
+      if(s.gametic > target)
+         break;
+      snap = &s;
+   }
+
+   // going back needs a snapshot, going forward only uses one to skip ahead
+   if(snap && (target < gametic || snap->gametic > gametic))
+      G_restoreSnapshot(*snap);
+   else if(target < gametic)
+   {
+      C_Printf(FC_ERROR "demo_seek: no snapshot before tic %d\n",
+               target - demostarttic);
+      return false;
+   }
+
+   // a paused demo would not move on
+   if(paused)
+   {
+      paused = 0;
+      S_ResumeSound();
+   }
+
+   // sounds may be tied to things the run is about to remove
+   S_StopSounds(true);
+
+   const bool oldnosfxparm = nosfxparm;
+   nosfxparm = true;
+
+   while(demoplayback && gametic < target)
+   {
+      G_Ticker();
+      gametic++;
+   }
+
+   nosfxparm = oldnosfxparm;
+
+   return true;
+}
+
+//
+// Console commands
+//
+
+VARIABLE_INT(demo_snapshotinterval, nullptr, 1, 600, nullptr);
+CONSOLE_VARIABLE(demo_snapshotinterval, demo_snapshotinterval, 0) {}
+
+VARIABLE_INT(demo_snapshotmemory, nullptr, 1, 4096, nullptr);
+CONSOLE_VARIABLE(demo_snapshotmemory, demo_snapshotmemory, 0)
+{
+   G_trimDemoSnapshots();
+}
+
+CONSOLE_COMMAND(demo_seek, 0)
+{
+   if(!demoplayback)
+   {
+      C_Printf(FC_ERROR "not playing a demo\n");
+      return;
+   }
+
+   if(Console.argc < 1)
+   {
+      C_Printf("usage: demo_seek <tic>\n"
+               " now at tic %d\n", gametic - demostarttic);
+      return;
+   }
+
+   seektarget = demostarttic + emax(Console.argv[0]->toInt(), 0);
+}
+
+CONSOLE_COMMAND(demo_rewind, 0)
+{
+   if(!demoplayback)
+   {
+      C_Printf(FC_ERROR "not playing a demo\n");
+      return;
+   }
+
+   const int seconds = Console.argc >= 1 ? Console.argv[0]->toInt() : 10;
+
+   seektarget = emax(gametic - seconds * TICRATE, demostarttic);
+}
+
+CONSOLE_COMMAND(demo_snapshots, 0)
+{
+   if(!demoplayback)
+   {
+      C_Printf(FC_ERROR "not playing a demo\n");
+      return;
+   }
+
+   C_Printf("%d snapshot%s, %.1f of %d MB, every %d s\n",
+            int(snapshots.getLength()), snapshots.getLength() == 1 ? "" : "s",
+            snapshotbytes / (1024.0 * 1024.0), demo_snapshotmemory,
+            demo_snapshotinterval * snapshotspacing);
+
+   for(const demosnapshot_t &snap : snapshots)
+   {
+      C_Printf(" tic %d: %zu KB\n", snap.gametic - demostarttic,
+               snap.size / 1024);
+   }
+
+   C_Printf("now at tic %d\n", gametic - demostarttic);
+}
+
+// EOF
+
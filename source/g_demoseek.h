@@ -0,0 +1,40 @@
+//
+// The Eternity Engine
+// Copyright(C) 2026 James Haley, Max Waine, et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+// Additional terms and conditions compatible with the GPLv3 apply. See the
+// file COPYING-EE for details.
+//
+// Purpose: Demo seeking.
+//  During playback the level is archived to memory every few seconds, so
+//  that seeking back restores the nearest snapshot and runs the demo on from
+//  there instead of from the start.
+//
+
+#ifndef G_DEMOSEEK_H__
+#define G_DEMOSEEK_H__
+
+extern int demo_snapshotinterval; // seconds between snapshots
+extern int demo_snapshotmemory;   // most memory they may use, in MB
+
+void G_ClearDemoSnapshots();
+void G_DemoSnapshotTicker();
+bool G_RunDemoSeek();
+
+#endif
+
+// EOF
+
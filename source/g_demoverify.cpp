@@ -0,0 +1,478 @@
+//
+// The Eternity Engine
+// Copyright(C) 2026 James Haley, Max Waine, et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+// Additional terms and conditions compatible with the GPLv3 apply. See the
+// file COPYING-EE for details.
+//
+// Purpose: Batch demo verification.
+//  Each line of the list names a demo, then optionally the state hash it is
+//  expected to end on, then any arguments of its own; "#" starts a comment.
+//  Every demo is played by a copy of the program with the same arguments as
+//  this one plus -simbench and -demolog, up to -demoverifyjobs of them at
+//  once. The worker's -simbench report gives the speed and the hash of the
+//  state it ended on, and its -demolog lines show where each level was left.
+//  A demo is "synced" if the hash matches, "desynced" if it doesn't,
+//  "unverified" if there was nothing to match it against, and "failed" if
+//  the worker didn't finish. The summary goes to -demoverifyjson, or stdout.
+//
+
+#include <thread>
+#include <vector>
+
+#include "z_zone.h"
+#include "i_system.h"
+
+#include "g_demoverify.h"
+#include "hal/i_process.h"
+#include "m_argv.h"
+#include "m_compare.h"
+#include "m_qstr.h"
+
+enum verifystatus_e
+{
+   VERIFY_SYNCED,
+   VERIFY_DESYNCED,
+   VERIFY_UNVERIFIED,
+   VERIFY_FAILED,
+   VERIFY_NUMSTATUS
+};
+
+static const char *const statusnames[VERIFY_NUMSTATUS] =
+{
+   "synced", "desynced", "unverified", "failed",
+};
+
+struct verifyjob_t
+{
+   qstring              demo;
+   qstring              expected; // state hash from the list, if any
+   std::vector<qstring> args;     // the line's own arguments
+
+   qstring jsonpath;
+   qstring logpath;
+   qstring outpath;
+
+   int    pid      = 0;
+   int    exitcode = -1;
+   size_t peakkb   = 0;
+
+   int                  status = VERIFY_FAILED; // until shown otherwise
+   int                  tics   = 0;
+   double               tps    = 0.0;
+   qstring              statehash;
+   std::vector<qstring> log;
+};
+
+// parameters of the parent which the workers mustn't inherit, and how many
+// arguments each takes
+static const struct
+{
+   const char *parm;
+   int         numargs;
+} ownparms[] =
+{
+   { "-demoverify",     1 },
+   { "-demoverifyjson", 1 },
+   { "-demoverifyjobs", 1 },
+   { "-simbench",       1 },
+   { "-simbenchjson",   1 },
+   { "-demolog",        1 },
+   { "-statehash",      1 },
+   { "-timedemo",       1 },
+   { "-playdemo",       1 },
+   { "-fastdemo",       1 },
+};
+
+//
+// Splits a line of the list into words. Words may be put in double quotes to
+// hold spaces.
+//
+static void G_splitListLine(const char *line, std::vector<qstring> &words)
+{
+   const char *c = line;
+
+   while(*c)
+   {
+      qstring word;
+
+      while(*c == ' ' || *c == '\t' || *c == '\r' || *c == '\n')
+         ++c;
+      if(!*c || *c == '#')
+         break;
+
+      if(*c == '"')
+      {
+         for(++c; *c && *c != '"'; c++)
+            word += *c;
+         if(*c)
+            ++c;
+      }
+      else
+      {
+         for(; *c && *c != ' ' && *c != '\t' && *c != '\r' && *c != '\n'; c++)
+            word += *c;
+      }
+
+      words.push_back(word);
+   }
+}
+
+//
+// Reads the list of demos.
+//
+static void G_readVerifyList(const char *path, std::vector<verifyjob_t> &jobs)
+{
+   FILE *f;
+   char  line[1024];
+
+   if(!(f = fopen(path, "r")))
+      I_Error("G_DemoVerify: couldn't open %s\n", path);
+
+   while(fgets(line, sizeof(line), f))
+   {
+      std::vector<qstring> words;
+      size_t               w = 1;
+
+      G_splitListLine(line, words);
+      if(words.empty())
+         continue;
+
+      verifyjob_t job;
+
+      job.demo = words[0];
+      if(w < words.size() && words[w][0] != '-')
+         job.expected = words[w++];
+      for(; w < words.size(); w++)
+         job.args.push_back(words[w]);
+
+      jobs.push_back(job);
+   }
+
+   fclose(f);
+
+   if(jobs.empty())
+      I_Error("G_DemoVerify: %s lists no demos\n", path);
+}
+
+//
+// Where the workers' files go.
+//
+static const char *G_verifyTempDir()
+{
+   static const char *const vars[] = { "TMPDIR", "TEMP", "TMP" };
+
+   for(const char *var : vars)
+   {
+      const char *dir = getenv(var);
+
+      if(dir && *dir)
+         return dir;
+   }
+
+   return ".";
+}
+
+//
+// Starts the worker for one demo.
+//
+static void G_startVerifyJob(verifyjob_t &job, int index)
+{
+   std::vector<const char *> argv;
+   const char               *tmpdir = G_verifyTempDir();
+   const int                 self   = I_CurrentProcessID();
+
+   job.jsonpath.Printf(0, "%s/eedv%d_%d.json", tmpdir, self, index);
+   job.logpath .Printf(0, "%s/eedv%d_%d.log",  tmpdir, self, index);
+   job.outpath .Printf(0, "%s/eedv%d_%d.txt",  tmpdir, self, index);
+
+   // the demolog is opened for appending
+   remove(job.logpath.constPtr());
+
+   for(int i = 1; i < myargc; i++)
+   {
+      bool skip = false;
+
+      for(const auto &own : ownparms)
+      {
+         if(!strcasecmp(myargv[i], own.parm))
+         {
+            i += own.numargs;
+            skip = true;
+            break;
+         }
+      }
+
+      if(!skip)
+         argv.push_back(myargv[i]);
+   }
+
+   for(const qstring &arg : job.args)
+      argv.push_back(arg.constPtr());
+
+   argv.push_back("-simbench");
+   argv.push_back(job.demo.constPtr());
+   argv.push_back("-simbenchjson");
+   argv.push_back(job.jsonpath.constPtr());
+   argv.push_back("-demolog");
+   argv.push_back(job.logpath.constPtr());
+   argv.push_back(nullptr);
+
+   job.pid = I_SpawnSelf(argv.data(), job.outpath.constPtr());
+}
+
+//
+// Reads back what a finished worker wrote.
+//
+static void G_readVerifyResults(verifyjob_t &job)
+{
+   FILE *f;
+   char  line[1024];
+
+   job.status = VERIFY_FAILED;
+
+   // the -simbench report
+   if(!job.exitcode && (f = fopen(job.jsonpath.constPtr(), "r")))
+   {
+      bool havetics = false;
+      char hash[9];
+
+      while(fgets(line, sizeof(line), f))
+      {
+         const char *value;
+
+         if((value = strstr(line, "\"tics\":")))
+            havetics = (sscanf(value, "\"tics\": %d", &job.tics) == 1);
+         else if((value = strstr(line, "\"tics_per_second\":")))
+            sscanf(value, "\"tics_per_second\": %lf", &job.tps);
+         else if((value = strstr(line, "\"state_hash\":")) &&
+                 sscanf(value, "\"state_hash\": \"%8[0-9a-fA-F]\"", hash) == 1)
+            job.statehash = hash;
+      }
+
+      fclose(f);
+
+      if(havetics && !job.statehash.empty())
+      {
+         if(job.expected.empty())
+            job.status = VERIFY_UNVERIFIED;
+         else if(!job.expected.strCaseCmp(job.statehash.constPtr()))
+            job.status = VERIFY_SYNCED;
+         else
+            job.status = VERIFY_DESYNCED;
+      }
+   }
+
+   // the -demolog lines, past the blank line and the arguments it starts with
+   if((f = fopen(job.logpath.constPtr(), "r")))
+   {
+      for(int n = 0; fgets(line, sizeof(line), f); n++)
+      {
+         qstring entry(line);
+
+         if(n < 2)
+            continue;
+
+         while(!entry.empty() &&
+               (entry[entry.length() - 1] == '\n' || entry[entry.length() - 1] == '\r'))
+            entry.truncate(entry.length() - 1);
+
+         if(!entry.empty())
+            job.log.push_back(entry);
+      }
+
+      fclose(f);
+   }
+
+   remove(job.jsonpath.constPtr());
+   remove(job.logpath.constPtr());
+
+   // the worker's own output is only worth keeping if it went wrong
+   if(job.status != VERIFY_FAILED)
+      remove(job.outpath.constPtr());
+}
+
+//
+// Writes a string as a JSON string literal.
+//
+static void G_writeJSONString(FILE *f, const char *s)
+{
+   fputc('"', f);
+
+   for(; *s; s++)
+   {
+      const unsigned char c = static_cast<unsigned char>(*s);
+
+      if(c == '"' || c == '\\')
+         fprintf(f, "\\%c", c);
+      else if(c == '\t')
+         fputs("\\t", f);
+      else if(c < 0x20)
+         fprintf(f, "\\u%04x", c);
+      else
+         fputc(c, f);
+   }
+
+   fputc('"', f);
+}
+
+//
+// Writes the summary of all the demos.
+//
+static void G_writeVerifyReport(FILE *f, const std::vector<verifyjob_t> &jobs,
+                                const int (&counts)[VERIFY_NUMSTATUS])
+{
+   fprintf(f, "{\n");
+   fprintf(f, "  \"demos\": [\n");
+
+   for(size_t i = 0; i < jobs.size(); i++)
+   {
+      const verifyjob_t &job = jobs[i];
+
+      fprintf(f, "    {\n");
+      fprintf(f, "      \"demo\": ");
+      G_writeJSONString(f, job.demo.constPtr());
+      fprintf(f, ",\n      \"status\": \"%s\",\n", statusnames[job.status]);
+      fprintf(f, "      \"expected_hash\": ");
+      if(job.expected.empty())
+         fprintf(f, "null");
+      else
+         G_writeJSONString(f, job.expected.constPtr());
+      fprintf(f, ",\n      \"state_hash\": ");
+      if(job.statehash.empty())
+         fprintf(f, "null");
+      else
+         G_writeJSONString(f, job.statehash.constPtr());
+      fprintf(f, ",\n");
+      fprintf(f, "      \"tics\": %d,\n", job.tics);
+      fprintf(f, "      \"tics_per_second\": %.1f,\n", job.tps);
+      fprintf(f, "      \"peak_memory_kb\": %zu,\n", job.peakkb);
+      fprintf(f, "      \"exit_code\": %d,\n", job.exitcode);
+      if(job.status == VERIFY_FAILED)
+      {
+         fprintf(f, "      \"output\": ");
+         G_writeJSONString(f, job.outpath.constPtr());
+         fprintf(f, ",\n");
+      }
+      fprintf(f, "      \"log\": [");
+      for(size_t l = 0; l < job.log.size(); l++)
+      {
+         fprintf(f, l ? ",\n        " : "\n        ");
+         G_writeJSONString(f, job.log[l].constPtr());
+      }
+      fprintf(f, job.log.empty() ? "]\n" : "\n      ]\n");
+      fprintf(f, "    }%s\n", i + 1 < jobs.size() ? "," : "");
+   }
+
+   fprintf(f, "  ],\n");
+   for(int i = 0; i < VERIFY_NUMSTATUS; i++)
+   {
+      fprintf(f, "  \"%s\": %d%s\n", statusnames[i], counts[i],
+              i + 1 < VERIFY_NUMSTATUS ? "," : "");
+   }
+   fprintf(f, "}\n");
+}
+
+//
+// Plays every demo in the list and reports on them, then quits.
+//
+void G_DemoVerify(const char *listpath)
+{
+   std::vector<verifyjob_t> jobs;
+   int                      counts[VERIFY_NUMSTATUS] = {};
+   int                      maxjobs = int(std::thread::hardware_concurrency());
+   int                      p;
+
+   if(!I_CanSpawnProcesses())
+      I_Error("G_DemoVerify: not supported on this platform\n");
+
+   if((p = M_CheckParm("-demoverifyjobs")) && ++p < myargc)
+      maxjobs = atoi(myargv[p]);
+   maxjobs = emax(maxjobs, 1);
+
+   G_readVerifyList(listpath, jobs);
+
+   // keep up to maxjobs workers going until every demo has had one
+   size_t next    = 0;
+   int    running = 0;
+
+   while(next < jobs.size() || running)
+   {
+      for(; next < jobs.size() && running < maxjobs; next++)
+      {
+         G_startVerifyJob(jobs[next], int(next));
+
+         if(jobs[next].pid < 0)
+            fprintf(stderr, "G_DemoVerify: couldn't start %s\n", jobs[next].demo.constPtr());
+         else
+            ++running;
+      }
+
+      if(!running)
+         continue;
+
+      int    exitcode;
+      size_t peakkb;
+      int    pid = I_WaitProcess(exitcode, peakkb);
+
+      if(pid < 0)
+         break;
+
+      for(verifyjob_t &job : jobs)
+      {
+         if(job.pid != pid)
+            continue;
+
+         job.exitcode = exitcode;
+         job.peakkb   = peakkb;
+         G_readVerifyResults(job);
+         --running;
+
+         fprintf(stderr, "%s: %s\n", job.demo.constPtr(), statusnames[job.status]);
+         break;
+      }
+   }
+
+   // any that never started, or were lost track of, are still failed
+   for(const verifyjob_t &job : jobs)
+      ++counts[job.status];
+
+   FILE *f = stdout;
+
+   if((p = M_CheckParm("-demoverifyjson")) && ++p < myargc)
+   {
+      if(!(f = fopen(myargv[p], "w")))
+         I_Error("G_DemoVerify: couldn't open %s\n", myargv[p]);
+   }
+
+   G_writeVerifyReport(f, jobs, counts);
+
+   if(f != stdout)
+      fclose(f);
+
+   if(counts[VERIFY_DESYNCED] || counts[VERIFY_FAILED])
+   {
+      I_Error("G_DemoVerify: %d of %d demos desynced, %d failed\n",
+              counts[VERIFY_DESYNCED], int(jobs.size()), counts[VERIFY_FAILED]);
+   }
+
+   I_ExitWithMessage("G_DemoVerify: %d of %d demos synced, %d unverified\n",
+                     counts[VERIFY_SYNCED], int(jobs.size()),
+                     counts[VERIFY_UNVERIFIED]);
+}
+
+// EOF
+
@@ -0,0 +1,34 @@
+//
+// The Eternity Engine
+// Copyright(C) 2026 James Haley, Max Waine, et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+// Additional terms and conditions compatible with the GPLv3 apply. See the
+// file COPYING-EE for details.
+//
+// Purpose: Batch demo verification.
+//  -demoverify <list> plays every demo in the list with -simbench, several at
+//  a time in their own processes, and reports whether each one still syncs.
+//
+
+#ifndef G_DEMOVERIFY_H__
+#define G_DEMOVERIFY_H__
+
+void G_DemoVerify(const char *listpath);
+
+#endif
+
+// EOF
+
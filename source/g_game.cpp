@@ -41,6 +41,7 @@
 #include "c_runcmd.h"
 #include "d_deh.h"              // Ty 3/27/98 deh declarations
 #include "d_event.h"
+#include "d_framestats.h"
 #include "d_gi.h"
 #include "d_io.h"
 #include "d_main.h"
@@ -56,8 +57,10 @@
 #include "f_wipe.h"
 #include "g_bind.h"
 #include "g_demolog.h"
+#include "g_demoseek.h"
 #include "g_dmflag.h"
 #include "g_game.h"
+#include "g_statehash.h"
 #include "in_lude.h"
 #include "m_argv.h"
 #include "m_buffer.h"
@@ -67,6 +70,7 @@
 #include "m_random.h"
 #include "m_shots.h"
 #include "m_utils.h"
+#include "m_zonestats.h"
 #include "metaapi.h"
 #include "mn_engin.h"
 #include "mn_menus.h"
@@ -78,6 +82,7 @@
 #include "p_maputl.h"
 #include "p_saveg.h"
 #include "p_setup.h"
+#include "p_simbench.h"
 #include "p_tick.h"
 #include "p_user.h"
 #include "hu_stuff.h"
@@ -85,6 +90,7 @@
 #include "r_data.h"
 #include "r_draw.h"
 #include "r_main.h"
+#include "r_profile.h"
 #include "r_sky.h"
 #include "r_things.h" // haleyjd
 #include "s_sndseq.h"
@@ -101,6 +107,9 @@
 static constexpr const char eedemosig[] = "ETERN";
 static constexpr const char prdemosig[] = "PR+UM";
 
+// Recording passes its tics to the file this often, so a crash loses no more than that
+static constexpr int DEMOFLUSHTICS = TICRATE;
+
 //static size_t   savegamesize = SAVEGAMESIZE; // killough
 static char    *demoname;
 static bool     netdemo;
@@ -108,6 +117,7 @@ static byte    *demobuffer;      // only for playback
 static OutBuffer demofp;         // only for recording
 static byte    *demo_p;          // used for both playing and recording
 static byte    *demo_continue_p; // only for rerecording
+static bool     longtics_demo;   // if true, demo playing is longtics format
 static size_t   demolength;
 static int16_t  consistency[MAXPLAYERS][BACKUPTICS];
 static int      g_destmap;
@@ -153,6 +163,7 @@ int             autorun = false;      // always running?          // phares
 int             runiswalk = false;    // haleyjd 08/23/09
 int             automlook = false;
 int             smooth_turning = 0;   // sf
+int             mouse_lookahead = 1;  // turn the view by mouse not yet in a ticcmd
 int             mouse_vert;               // haleyjd
 
 // sf: moved sensitivity here
@@ -698,6 +709,48 @@ void G_BuildTiccmd(ticcmd_t *cmd)
    mousex = mousey = 0.0;
 }
 
+//
+// G_MouseLookAhead
+//
+// Mouse movement only goes into a ticcmd once a tic, so at high framerates
+// the view turns in steps that trail the mouse. With mouse_lookahead on, the
+// movement gathered since the last ticcmd is added to the console player's
+// interpolated view, the way G_BuildTiccmd will add it, rounded as a short
+// tics demo being recorded will round it. Turning by keys or joystick is
+// left to the interpolation. Only the view changes; the ticcmds, and so
+// demos, are the same either way.
+//
+void G_MouseLookAhead(const player_t &player, angle_t &angle, fixed_t &pitch)
+{
+   if(!mouse_lookahead || (!mousex && !mousey) || !d_interpolate ||
+      smooth_turning || demoplayback || paused || menuactive || consoleactive ||
+      player.playerstate != PST_LIVE || !player.mo ||
+      player.mo->reactiontime || (player.mo->flags & MF_JUSTATTACKED))
+      return;
+
+   // each ticcmd runs for ticdup tics
+   if(!gameactions[ka_strafe])
+   {
+      int turn = int(mousex * 8.0);
+      if(demorecording && !longtics_demo)
+         turn = ((turn + 128) >> 8) << 8;
+
+      angle -= (angle_t(turn) << 16) * ticdup;
+   }
+
+   if(allowmlook && (gameactions[ka_mlook] || automlook))
+   {
+      int look = int(mousey * 16.0 / double(ticdup));
+      if(invert_mouse)
+         look = -look;
+      look = eclamp(look, -32767, 32767);
+
+      pitch -= (look << 16) * ticdup;
+      pitch = eclamp(pitch, -ANGLE_1 * GameModeInfo->lookPitchUp,
+                     ANGLE_1 * GameModeInfo->lookPitchDown);
+   }
+}
+
 //
 // G_SetGameMap
 //
@@ -962,8 +1015,6 @@ bool G_Responder(const event_t* ev)
 // version field of its demos (because it's one more than v1.10 I guess).
 #define DOOM_191_VERSION 111
 
-static bool longtics_demo; // if true, demo playing is longtics format
-
 static char *defdemoname;
 
 //
@@ -1320,13 +1371,11 @@ static byte *G_ReadDemoHeader(byte *demo_p)
    }
    deathmatch = !!dmtype; // ioanch: fix this now
    
-   // don't spend a lot of time in loadlevel
-
    if(gameaction != ga_loadgame)      // killough 12/98: support -loadgame
    {
-      // killough 2/22/98:
-      // Do it anyway for timing demos, to reduce timing noise
-      precache = timingdemo;
+      // Precaching composes textures in the background and no longer holds up
+      // the level load, so demos always precache.
+      precache = true;
       
       // haleyjd: choose appropriate G_InitNew based on version
       if(full_demo_version >= make_full_version(329, 5))
@@ -1394,6 +1443,8 @@ void G_DoPlayDemo(void)
    
    gameaction = ga_nothing;
 
+   G_ClearDemoSnapshots();
+
    G_DemoStartMessage(basename);
    
    if(timingdemo)
@@ -1404,8 +1455,14 @@ void G_DoPlayDemo(void)
          starttime = i_haltimer.GetRealTime();
          startgametic = gametic;
          first = 0;
+         if(simbench)
+            P_SimBenchStart();
       }
    }
+
+   // frame times are kept for timed and logged demos
+   if(timingdemo || G_DemoLogEnabled())
+      D_FrameStatsStart();
 }
 
 //
@@ -1433,8 +1490,6 @@ static void G_convertButtonsToWeaponID(ticcmd_t &cmd)
       }
 }
 
-#define DEMOMARKER    0x80
-
 //
 // NETCODE_FIXME -- DEMO_FIXME
 //
@@ -1590,8 +1645,26 @@ static void G_ReadDemoContinueTiccmd(ticcmd_t *cmd)
 //
 static void G_WriteDemoTiccmd(ticcmd_t *cmd)
 {
-   byte start[32], *p = start;
-   memset(start, 0, sizeof start);
+   byte start[MAXDEMOTIC];
+   const size_t len = G_WriteDemoTic(start, cmd);
+
+   if(!demofp.write(start, len))
+      I_Error("G_WriteDemoTiccmd: error writing demo\n");
+
+   demo_p = start; // alias demo_p so it can be read back
+   G_ReadDemoTiccmd(cmd); // make SURE it is exactly the same
+}
+
+//
+// G_WriteDemoTic
+//
+// Encodes a ticcmd as G_WriteDemoTiccmd records it, for the demo last begun
+// with G_WriteDemoHeader. Returns the length, at most MAXDEMOTIC.
+//
+size_t G_WriteDemoTic(byte *buf, const ticcmd_t *cmd)
+{
+   byte *p = buf;
+   memset(buf, 0, MAXDEMOTIC);
 
    *p++ = cmd->forwardmove;
    *p++ = cmd->sidemove;
@@ -1629,11 +1702,7 @@ static void G_WriteDemoTiccmd(ticcmd_t *cmd)
       *p++ =  cmd->slotIndex;
    }
 
-   if(!demofp.write(start, p - start))
-      I_Error("G_WriteDemoTiccmd: error writing demo\n");
-
-   demo_p = start; // alias demo_p so it can be read back
-   G_ReadDemoTiccmd(cmd); // make SURE it is exactly the same
+   return p - buf;
 }
 
 static bool secretexit;
@@ -1646,6 +1715,7 @@ void G_ExitLevel(int destmap)
    // double tabs to be easily visible against deaths
    G_DemoLog("%d\tExit normal\t\t", gametic);
    G_DemoLogStats();
+   G_DemoLogPerf();
    G_DemoLog("\n");
    G_DemoLogSetExited(true);
    if(players[0].mo)
@@ -1668,6 +1738,7 @@ void G_SecretExitLevel(int destmap)
 {
    G_DemoLog("%d\tExit secret\t\t", gametic);
    G_DemoLogStats();
+   G_DemoLogPerf();
    G_DemoLog("\n");
    G_DemoLogSetExited(true);
    secretexit = !(GameModeInfo->flags & GIF_WOLFHACK) || haswolflevels || scriptSecret;
@@ -1925,6 +1996,12 @@ static void G_DoCompleted()
       memcpy(statcopy, &wminfo, sizeof(wminfo));
 
    G_setupMapInfoWMInfo(secretexit ? lk_secret : lk_overt);
+
+   M_ZoneStatsLevelEnd(gamemapname);
+
+   // let the next map's lumps be read in while the intermission runs
+   P_PrefetchLevel(g_dir, G_getNextLevelName(secretexit ? lk_secret : lk_overt,
+                                             wminfo.nextEpisode + 1, wminfo.next + 1));
    
    IN_Start(&wminfo);
 }
@@ -2007,7 +2084,9 @@ void G_ForceFinale()
    gameaction = ga_victory;
 }
 
-static char *savename;
+static char  *savename;
+static byte  *savedata; // savegame held in memory instead of a file
+static size_t savesize;
 
 //
 // killough 5/15/98: add forced loadgames, which allow user to override checks
@@ -2030,6 +2109,11 @@ void G_LoadGame(const char *name, int slot, bool command)
    if(savename)
       efree(savename);
    savename = estrdup(name);
+   if(savedata)
+   {
+      efree(savedata);
+      savedata = nullptr;
+   }
    savegameslot = slot;
    gameaction = ga_loadgame;
    forced_loadgame = false;
@@ -2037,6 +2121,28 @@ void G_LoadGame(const char *name, int slot, bool command)
    hub_changelevel = false;
 }
 
+//
+// Loads a savegame from a block of memory, which is taken over and freed
+// by the next load.
+//
+void G_LoadGameFromMemory(byte *data, size_t size)
+{
+   if(savename)
+   {
+      efree(savename);
+      savename = nullptr;
+   }
+   if(savedata)
+      efree(savedata);
+   savedata = data;
+   savesize = size;
+   savegameslot = 0;
+   gameaction = ga_loadgame;
+   forced_loadgame = false;
+   command_loadgame = false;
+   hub_changelevel = false;
+}
+
 // killough 5/15/98:
 // Consistency Error when attempting to load savegame.
 
@@ -2154,7 +2260,10 @@ WadDirectory *d_dir;
 static void G_DoLoadGame(void)
 {
    gameaction = ga_nothing;
-   P_LoadGame(savename);
+   if(savedata)
+      P_LoadGameFromMemory(savedata, savesize);
+   else
+      P_LoadGame(savename);
 }
 
 //
@@ -2257,6 +2366,10 @@ void G_Ticker()
       }
    }
 
+   // keep snapshots of the level so playback can seek back to it
+   if(demoplayback)
+      G_DemoSnapshotTicker();
+
    // killough 10/6/98: allow games to be saved during demo
    // playback, by the playback user (not by demo itself)
    
@@ -2302,6 +2415,9 @@ void G_Ticker()
             
             if(demorecording)
                G_WriteDemoTiccmd(cmd);
+
+            if(d_dedicated)
+               D_RelayTiccmd(cmd);
             
             // check for turbo cheats
             // killough 2/14/98, 2/20/98 -- only warn in netgames and demos
@@ -2366,6 +2482,9 @@ void G_Ticker()
       }
    }
 
+   if(demorecording && !(gametic % DEMOFLUSHTICS))
+      demofp.flush();
+
    if(InventoryCanClose())
    {
       // turn inventory off after a certain amount of time
@@ -2409,6 +2528,8 @@ void G_Ticker()
          break;
       }
    }
+
+   G_StateHashTicker();
 }
 
 //
@@ -3608,14 +3729,14 @@ void G_SetOldDemoOptions()
 //
 // haleyjd 02/21/10: Support recording of vanilla demos.
 //
-static void G_BeginRecordingOld()
+static size_t G_BeginRecordingOld(byte *start, int viewplayer)
 {
    int i;
 
    // haleyjd 01/16/11: set again to ensure consistency
    G_SetOldDemoOptions();
 
-   byte start[13], *demo_p = start; // vanilla header is always 13 bytes long
+   byte *demo_p = start; // vanilla header is always 13 bytes long
 
    *demo_p++ = demo_version;    
    *demo_p++ = gameskill;
@@ -3633,13 +3754,12 @@ static void G_BeginRecordingOld()
    *demo_p++ = respawnparm;
    *demo_p++ = fastparm;
    *demo_p++ = nomonsters;
-   *demo_p++ = consoleplayer;
+   *demo_p++ = viewplayer;
 
    for(i = 0; i < MAXPLAYERS; i++)
       *demo_p++ = playeringame[i];
 
-   if(!demofp.write(start, 13))
-      I_Error("G_BeginRecordingOld: error writing demo header\n");
+   return demo_p - start;
 }
 
 /*
@@ -3662,17 +3782,29 @@ static void G_BeginRecordingOld()
 // NETCODE_FIXME -- DEMO_FIXME: Yet more demo writing.
 
 void G_BeginRecording()
+{
+   byte start[MAXDEMOHEADER];
+   const size_t len = G_WriteDemoHeader(start, consoleplayer);
+
+   if(!demofp.write(start, len))
+      I_Error("G_BeginRecording: error writing demo header\n");
+}
+
+//
+// G_WriteDemoHeader
+//
+// Writes the header of a demo seen from viewplayer, and sets up to record
+// in that format. Returns the length, at most MAXDEMOHEADER.
+//
+size_t G_WriteDemoHeader(byte *start, int viewplayer)
 {
    int i;
 
    // haleyjd 02/21/10: -vanilla will record v1.9-format demos
    if(M_CheckParm("-vanilla") || demo_version < 200)
-   {
-      G_BeginRecordingOld();
-      return;
-   }
+      return G_BeginRecordingOld(start, viewplayer);
    
-   byte start[256], *demo_p = start;
+   byte *demo_p = start;
 
    longtics_demo = true;
    
@@ -3710,7 +3842,7 @@ void G_BeginRecording()
    *demo_p++ = gameepisode;
    *demo_p++ = gamemap;
    *demo_p++ = GameType; // haleyjd 04/10/03
-   *demo_p++ = consoleplayer;
+   *demo_p++ = viewplayer;
 
    // haleyjd 04/14/03: save dmflags
    *demo_p++ = (unsigned char)(dmflags & 255);
@@ -3735,8 +3867,7 @@ void G_BeginRecording()
    for(; i < MIN_MAXPLAYERS; i++)
       *demo_p++ = 0;
 
-   if(!demofp.write(start, demo_p - start))
-      I_Error("G_BeginRecording: error writing demo header\n");
+   return demo_p - start;
 }
 
 //
@@ -3803,11 +3934,20 @@ bool G_CheckDemoStatus()
    {
       int endtime = i_haltimer.GetRealTime();
 
+      if(simbench)
+         P_SimBenchReport(gametic - startgametic);
+
       // killough -- added fps information and made it work for longer demos:
       unsigned int realtics = endtime - starttime;
-      I_Error("Timed %u gametics in %u realtics = %-.1f frames per second\n",
+      qstring framereport;
+
+      R_ProfileCloseCSV();
+      D_FrameStatsCloseCSV();
+      D_FrameStatsReport(framereport);
+      I_Error("Timed %u gametics in %u realtics = %-.1f frames per second\n%s",
               (unsigned int)(gametic), realtics,
-              (unsigned int)(gametic) * (double) TICRATE / realtics);
+              (unsigned int)(gametic) * (double) TICRATE / realtics,
+              framereport.constPtr());
    }              
 
    if(demoplayback)
@@ -3816,6 +3956,7 @@ bool G_CheckDemoStatus()
 
       // haleyjd 01/08/11: refactored so that stopping netdemos doesn't cause
       // access violations by leaving the game in "netgame" mode.
+      G_ClearDemoSnapshots();
       Z_ChangeTag(demobuffer, PU_CACHE);
       G_ReloadDefaults();    // killough 3/1/98
       netgame = false;       // killough 3/29/98
@@ -3831,6 +3972,20 @@ bool G_CheckDemoStatus()
    return false;
 }
 
+//
+// Where playback has read up to in the demo, for snapshots to return to.
+//
+size_t G_DemoPosition()
+{
+   return demoplayback ? size_t(demo_p - demobuffer) : 0;
+}
+
+void G_SetDemoPosition(size_t pos)
+{
+   if(demoplayback && pos <= demolength)
+      demo_p = demobuffer + pos;
+}
+
 void G_StopDemo()
 {
    extern bool advancedemo;
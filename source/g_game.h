@@ -24,9 +24,12 @@
 // Required for byte
 #include "doomdef.h"
 #include "doomtype.h"
+#include "m_fixed.h"
+#include "tables.h"
 
 struct event_t;
 struct player_t;
+struct ticcmd_t;
 class  Mobj;
 class  WadDirectory;
 
@@ -48,6 +51,7 @@ void G_DeferedInitNewFromDir(skill_t skill, const char *levelname, WadDirectory
 void G_DeferedPlayDemo(const char *demo);
 void G_TimeDemo(const char *name, bool showmenu);
 void G_LoadGame(const char *name, int slot, bool is_command); // killough 5/15/98
+void G_LoadGameFromMemory(byte *data, size_t size);
 void G_ForcedLoadGame();                      // killough 5/15/98: forced loadgames
 void G_LoadGameErr(const char *msg);
 void G_SaveGame(int slot, const char *description); // Called by M_Responder.
@@ -55,7 +59,11 @@ void G_RecordDemo(const char *name);                // Only called by startup co
 void G_RecordDemoContinue(const char *in, const char *name);
 void G_SetOldDemoOptions();
 void G_BeginRecording();
+size_t G_WriteDemoHeader(byte *start, int viewplayer);
+size_t G_WriteDemoTic(byte *buf, const ticcmd_t *cmd);
 void G_StopDemo();
+size_t G_DemoPosition();             // offset of playback into the demo
+void G_SetDemoPosition(size_t pos);
 void G_ScrambleRand();
 void G_ExitLevel(int destmap = 0);
 void G_SecretExitLevel(int destmap = 0);
@@ -79,6 +87,7 @@ void G_SetGameMap();
 void G_SpeedSetAddThing(int thingtype, int nspeed, int fspeed); // haleyjd
 uint64_t G_Signature(const WadDirectory *dir);
 void G_DoPlayDemo();
+void G_MouseLookAhead(const player_t &player, angle_t &angle, fixed_t &pitch);
 
 void R_InitPortals();
 
@@ -139,6 +148,7 @@ extern bool sendpause;
 
 extern int mouse_vert; // haleyjd
 extern int smooth_turning;
+extern int mouse_lookahead;
 
 #define VERSIONSIZE   16
 
@@ -155,6 +165,13 @@ extern WadDirectory *d_dir;
 
 #define MIN_MAXPLAYERS 32
 
+// ends the tics of a demo
+#define DEMOMARKER    0x80
+
+// room G_WriteDemoHeader and G_WriteDemoTic may need
+#define MAXDEMOHEADER 256
+#define MAXDEMOTIC    32
+
 #endif
 
 //----------------------------------------------------------------------------
@@ -0,0 +1,322 @@
+//
+// The Eternity Engine
+// Copyright(C) 2026 James Haley, Max Waine, et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+// Additional terms and conditions compatible with the GPLv3 apply. See the
+// file COPYING-EE for details.
+//
+// Purpose: Per-tic game state hashing, for finding desyncs.
+//  The log starts with a header of "EEHS", a format version and the number
+//  of parts hashed. Each tic spent in a level then adds a record of the
+//  gametic and a CRC32 for every part, all little endian. Only state that
+//  decides how the game plays out is hashed, never pointers or anything
+//  kept for the renderer, so that any two builds playing the same demo the
+//  same way write the same log.
+//
+
+#include "z_zone.h"
+#include "i_system.h"
+
+#include "d_items.h"
+#include "d_main.h"
+#include "d_player.h"
+#include "doomstat.h"
+#include "g_statehash.h"
+#include "info.h"
+#include "m_buffer.h"
+#include "m_hash.h"
+#include "m_qstr.h"
+#include "m_random.h"
+#include "p_mobj.h"
+#include "r_defs.h"
+#include "r_state.h"
+
+static constexpr char    STATEHASH_MAGIC[4] = { 'E', 'E', 'H', 'S' };
+static constexpr uint8_t STATEHASH_VERSION  = 1;
+
+enum statehashpart_e
+{
+   SHASH_MOBJS,
+   SHASH_SECTORS,
+   SHASH_RNG,
+   SHASH_PLAYERS,
+   SHASH_NUMPARTS
+};
+
+static const char *const partnames[SHASH_NUMPARTS] =
+{
+   "mobjs", "sectors", "rng", "players",
+};
+
+static OutBuffer statehashlog;
+static bool      statehashing;
+
+static void G_stateHashAtExit()
+{
+   statehashlog.close();
+}
+
+//
+// Opens the log for -statehash.
+//
+void G_StateHashInit(const char *path)
+{
+   if(!statehashlog.createFile(path, 64 * 1024, OutBuffer::LENDIAN))
+   {
+      usermsg("G_StateHashInit: failed opening '%s'\n", path);
+      return;
+   }
+
+   statehashlog.write(STATEHASH_MAGIC, sizeof(STATEHASH_MAGIC));
+   statehashlog.writeUint8(STATEHASH_VERSION);
+   statehashlog.writeUint8(SHASH_NUMPARTS);
+
+   statehashing = true;
+   atexit(G_stateHashAtExit);
+}
+
+//
+// Adds a value to a hash as little endian bytes, the same on every platform.
+//
+static void G_hashInt(HashData &hash, int32_t value)
+{
+   const uint32_t u = uint32_t(value);
+   const uint8_t  bytes[4] =
+   {
+      uint8_t(u), uint8_t(u >> 8), uint8_t(u >> 16), uint8_t(u >> 24)
+   };
+
+   hash.addData(bytes, sizeof(bytes));
+}
+
+static void G_hashMobjs(HashData &hash)
+{
+   for(Thinker *th = thinkercap.next; th != &thinkercap; th = th->next)
+   {
+      const Mobj *mo;
+
+      if(!(mo = thinker_cast<Mobj *>(th)))
+         continue;
+
+      G_hashInt(hash, mo->type);
+      G_hashInt(hash, mo->x);
+      G_hashInt(hash, mo->y);
+      G_hashInt(hash, mo->z);
+      G_hashInt(hash, mo->momx);
+      G_hashInt(hash, mo->momy);
+      G_hashInt(hash, mo->momz);
+      G_hashInt(hash, int32_t(mo->angle));
+      G_hashInt(hash, mo->state ? mo->state->index : -1);
+      G_hashInt(hash, mo->tics);
+      G_hashInt(hash, int32_t(mo->flags));
+      G_hashInt(hash, int32_t(mo->flags2));
+      G_hashInt(hash, int32_t(mo->flags3));
+      G_hashInt(hash, int32_t(mo->flags4));
+      G_hashInt(hash, int32_t(mo->flags5));
+      G_hashInt(hash, mo->health);
+      G_hashInt(hash, mo->movedir);
+      G_hashInt(hash, mo->movecount);
+      G_hashInt(hash, mo->reactiontime);
+      G_hashInt(hash, mo->threshold);
+   }
+}
+
+static void G_hashSectors(HashData &hash)
+{
+   for(int i = 0; i < numsectors; i++)
+   {
+      const sector_t &sec = sectors[i];
+
+      G_hashInt(hash, sec.srf.floor.height);
+      G_hashInt(hash, sec.srf.ceiling.height);
+      G_hashInt(hash, sec.lightlevel);
+      G_hashInt(hash, sec.special);
+   }
+}
+
+static void G_hashRNG(HashData &hash)
+{
+   for(unsigned int seed : rng.seed)
+      G_hashInt(hash, int32_t(seed));
+
+   G_hashInt(hash, rng.rndindex);
+   G_hashInt(hash, rng.prndindex);
+}
+
+static void G_hashPlayers(HashData &hash)
+{
+   for(int i = 0; i < MAXPLAYERS; i++)
+   {
+      if(!playeringame[i])
+         continue;
+
+      const player_t &p = players[i];
+
+      G_hashInt(hash, i);
+      G_hashInt(hash, p.playerstate);
+      G_hashInt(hash, p.viewz);
+      G_hashInt(hash, p.viewheight);
+      G_hashInt(hash, p.deltaviewheight);
+      G_hashInt(hash, p.momx);
+      G_hashInt(hash, p.momy);
+      G_hashInt(hash, p.health);
+      G_hashInt(hash, p.armorpoints);
+      G_hashInt(hash, p.readyweapon ? p.readyweapon->id : -1);
+      G_hashInt(hash, p.pendingweapon ? p.pendingweapon->id : -1);
+      G_hashInt(hash, p.refire);
+      G_hashInt(hash, p.killcount);
+      G_hashInt(hash, p.itemcount);
+      G_hashInt(hash, p.secretcount);
+
+      for(const powerduration_t &power : p.powers)
+         G_hashInt(hash, power.infinite ? -1 : power.tics);
+   }
+}
+
+static void (*const hashers[SHASH_NUMPARTS])(HashData &) =
+{
+   G_hashMobjs, G_hashSectors, G_hashRNG, G_hashPlayers,
+};
+
+//
+// Logs the state hashes at the end of a tic. Called from G_Ticker.
+//
+void G_StateHashTicker()
+{
+   if(!statehashing || gamestate != GS_LEVEL)
+      return;
+
+   statehashlog.writeSint32(gametic);
+
+   for(auto hasher : hashers)
+   {
+      HashData hash(HashData::CRC32);
+
+      hasher(hash);
+      hash.wrapUp();
+      statehashlog.writeUint32(hash.getDigestPart(0));
+   }
+}
+
+//
+// One hash of every part of the game state together, so that whole runs can
+// be compared at a glance.
+//
+uint32_t G_StateHash()
+{
+   HashData hash(HashData::CRC32);
+
+   for(auto hasher : hashers)
+      hasher(hash);
+   hash.wrapUp();
+
+   return hash.getDigestPart(0);
+}
+
+//
+// Opens a log for -statehashdiff and checks its header.
+//
+static void G_openStateHashLog(InBuffer &log, const char *path)
+{
+   char    magic[sizeof(STATEHASH_MAGIC)];
+   uint8_t version, numparts;
+
+   if(!log.openFile(path, InBuffer::LENDIAN))
+      I_Error("G_StateHashDiff: couldn't open %s\n", path);
+
+   if(log.read(magic, sizeof(magic)) != sizeof(magic) ||
+      memcmp(magic, STATEHASH_MAGIC, sizeof(magic)) ||
+      !log.readUint8(version) || version != STATEHASH_VERSION ||
+      !log.readUint8(numparts) || numparts != SHASH_NUMPARTS)
+   {
+      I_Error("G_StateHashDiff: %s is not a version %d state hash log\n", path,
+              STATEHASH_VERSION);
+   }
+}
+
+//
+// Reads one tic's record; returns false at the end of the log.
+//
+static bool G_readStateHashRecord(InBuffer &log, int32_t &tic, uint32_t *hashes)
+{
+   if(!log.readSint32(tic))
+      return false;
+
+   for(int i = 0; i < SHASH_NUMPARTS; i++)
+   {
+      if(!log.readUint32(hashes[i]))
+         return false;
+   }
+
+   return true;
+}
+
+//
+// Compares two logs for -statehashdiff and quits with the result.
+//
+void G_StateHashDiff(const char *patha, const char *pathb)
+{
+   InBuffer logs[2];
+   int32_t  tics[2];
+   uint32_t hashes[2][SHASH_NUMPARTS];
+   int      records = 0;
+
+   G_openStateHashLog(logs[0], patha);
+   G_openStateHashLog(logs[1], pathb);
+
+   while(true)
+   {
+      const bool more0 = G_readStateHashRecord(logs[0], tics[0], hashes[0]);
+      const bool more1 = G_readStateHashRecord(logs[1], tics[1], hashes[1]);
+
+      if(!more0 || !more1)
+      {
+         if(more0 == more1)
+            I_ExitWithMessage("State hash logs match over %d tics\n", records);
+
+         I_ExitWithMessage("State hash logs match over %d tics, then %s ends\n",
+                           records, more0 ? pathb : patha);
+      }
+
+      if(tics[0] != tics[1])
+      {
+         I_ExitWithMessage("State hash logs go out of step after %d tics: "
+                           "gametic %d against %d\n", records, tics[0], tics[1]);
+      }
+
+      qstring parts;
+      for(int i = 0; i < SHASH_NUMPARTS; i++)
+      {
+         if(hashes[0][i] != hashes[1][i])
+         {
+            if(!parts.empty())
+               parts << ", ";
+            parts << partnames[i];
+         }
+      }
+
+      if(!parts.empty())
+      {
+         I_ExitWithMessage("State hashes first differ at gametic %d (record %d): %s\n",
+                           tics[0], records, parts.constPtr());
+      }
+
+      ++records;
+   }
+}
+
+// EOF
+
@@ -0,0 +1,38 @@
+//
+// The Eternity Engine
+// Copyright(C) 2026 James Haley, Max Waine, et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+// Additional terms and conditions compatible with the GPLv3 apply. See the
+// file COPYING-EE for details.
+//
+// Purpose: Per-tic game state hashing, for finding desyncs.
+//  -statehash <file> logs a hash of each part of the game state after every
+//  tic. -statehashdiff <a> <b> compares two such logs and reports the first
+//  tic, and the parts, where they differ.
+//
+
+#ifndef G_STATEHASH_H__
+#define G_STATEHASH_H__
+
+void G_StateHashInit(const char *path);
+void G_StateHashTicker();
+uint32_t G_StateHash();
+void G_StateHashDiff(const char *patha, const char *pathb);
+
+#endif
+
+// EOF
+
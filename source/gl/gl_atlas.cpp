@@ -0,0 +1,675 @@
+//
+// The Eternity Engine
+// Copyright(C) 2026 James Haley, Max Waine, et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+// Additional terms and conditions compatible with the GPLv3 apply. See the
+// file COPYING-EE for details.
+//
+// Purpose: Texture and sprite atlas for GL rendering.
+//  Pages are filled shelf by shelf. Every image sits in a cell aligned to
+//  the smallest mip level, with its edge pixels repeated out to the cell's
+//  border, so neither filtering nor the mips bleed one image into the next.
+//  The pixels of each page are kept in memory; rows written since the last
+//  upload are mipped and sent in bands, and an image can't be looked up
+//  until all of its rows have gone. When every page is full the one least
+//  recently looked up is emptied and reused. A band goes through the
+//  driver's staging memory when it has some, so the GPU takes it in its
+//  own time rather than while glTexSubImage2D waits.
+//
+
+#ifdef EE_FEATURE_OPENGL
+
+#include "../z_zone.h"
+#include "../doomtype.h"
+
+#include "gl_includes.h"
+#include "gl_atlas.h"
+#include "gl_texture.h"
+#include "gl_vars.h"
+
+#include "../m_compare.h"
+#include "../r_data.h"
+#include "../r_defs.h"
+#include "../r_patch.h"
+#include "../r_state.h"
+#include "../v_patchfmt.h"
+#include "../w_wad.h"
+
+#ifndef GL_CLAMP_TO_EDGE
+#define GL_CLAMP_TO_EDGE 0x812F
+#endif
+#ifndef GL_TEXTURE_MAX_LEVEL
+#define GL_TEXTURE_MAX_LEVEL 0x813D
+#endif
+
+static constexpr int ATLAS_MIPLEVELS    = 4;                    // levels below the base
+static constexpr int ATLAS_ALIGN        = 1 << ATLAS_MIPLEVELS; // one pixel of the last level
+static constexpr int ATLAS_GUTTER       = ATLAS_ALIGN / 2;      // edge pixels repeated around an image
+static constexpr int ATLAS_UPLOADBUDGET = 4 * 1024 * 1024;      // base level bytes sent per frame
+
+struct glatlaspage_t
+{
+   GLuint    texture;
+   byte     *levels[ATLAS_MIPLEVELS + 1]; // RGBA pixels of each level
+   int       shelfx, shelfy;              // next free cell on the current shelf
+   int       shelfheight;
+   int       dirtyy1, dirtyy2;            // base level rows waiting to be sent
+   uint32_t  gen;                         // images written
+   uint32_t  readygen;                    // images sent in full
+   uint32_t  usedframe;                   // frame of the last lookup
+};
+
+struct glatlasslot_t
+{
+   int16_t  page;                  // ATLAS_NOPAGE if not in the atlas
+   uint16_t x, y;                  // image origin in the page, inside the gutter
+   int16_t  width, height;
+   int16_t  leftoffset, topoffset;
+   uint32_t gen;                   // page generation it was written in
+};
+
+enum
+{
+   ATLAS_NOPAGE   = -1,
+   ATLAS_TOOLARGE = -2, // never fits a page, so isn't tried again
+};
+
+static glatlaspage_t *atlaspages;
+static int            numatlaspages;
+static int            maxatlaspages;
+static int            atlaspagesize;
+static int            atlascurrent = -1; // page being filled
+static uint32_t       atlasframe;
+static byte           atlaspalette[256][4];
+
+static glatlasslot_t *texslots;    // by texture number
+static int            numtexslots;
+static glatlasslot_t *spriteslots; // by sprite lump, less firstspritelump
+static int            numspriteslots;
+
+static byte *atlasimage;           // an image being added, RGBA
+static int   atlasimagesize;
+
+static const glatlasstaging_t *atlasstaging;
+static unsigned                atlasdatagen; // r_datagen the lookups were sized for
+
+//
+// Makes room for an RGBA image of the given size in atlasimage and clears
+// it to transparent.
+//
+static byte *GL_atlasImage(int width, int height)
+{
+   const int size = width * height * 4;
+
+   if(size > atlasimagesize)
+   {
+      efree(atlasimage);
+      atlasimage     = emalloc(byte *, size);
+      atlasimagesize = size;
+   }
+
+   memset(atlasimage, 0, size);
+   return atlasimage;
+}
+
+//
+// Forgets every image on a page, so it can be filled again
+//
+static void GL_atlasClearPage(int pagenum)
+{
+   glatlaspage_t &page = atlaspages[pagenum];
+
+   page.shelfx = page.shelfy = page.shelfheight = 0;
+   page.dirtyy1  = atlaspagesize;
+   page.dirtyy2  = 0;
+   page.readygen = page.gen;
+
+   for(int i = 0; i < numtexslots; i++)
+   {
+      if(texslots[i].page == pagenum)
+         texslots[i].page = ATLAS_NOPAGE;
+   }
+   for(int i = 0; i < numspriteslots; i++)
+   {
+      if(spriteslots[i].page == pagenum)
+         spriteslots[i].page = ATLAS_NOPAGE;
+   }
+}
+
+//
+// Gets an empty page: a new one while under the limit, otherwise the one
+// least recently looked up, unless every page has been used this frame.
+//
+static int GL_atlasNewPage()
+{
+   if(numatlaspages < maxatlaspages)
+   {
+      const int      pagenum = numatlaspages++;
+      glatlaspage_t &page    = atlaspages[pagenum];
+      const bool     linear  = (cfg_gl_filter_type == CFG_GL_LINEAR);
+
+      glGenTextures(1, &page.texture);
+      GL_BindTextureAndRemember(page.texture);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER,
+                      linear ? GL_LINEAR : GL_NEAREST);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                      linear ? GL_LINEAR_MIPMAP_LINEAR : GL_NEAREST_MIPMAP_NEAREST);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, ATLAS_MIPLEVELS);
+
+      for(int level = 0; level <= ATLAS_MIPLEVELS; level++)
+      {
+         const int size = atlaspagesize >> level;
+
+         page.levels[level] = ecalloc(byte *, size * size, 4);
+         glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, size, size, 0, GL_RGBA,
+                      GL_UNSIGNED_BYTE, page.levels[level]);
+      }
+
+      page.gen = 0;
+      GL_atlasClearPage(pagenum);
+      return pagenum;
+   }
+
+   int oldest = -1;
+   for(int i = 0; i < numatlaspages; i++)
+   {
+      if(atlaspages[i].usedframe != atlasframe &&
+         (oldest < 0 || atlaspages[i].usedframe < atlaspages[oldest].usedframe))
+         oldest = i;
+   }
+
+   if(oldest >= 0)
+      GL_atlasClearPage(oldest);
+
+   return oldest;
+}
+
+//
+// Copies an RGBA image into a free cell, repeating its edges out to the
+// cell's border, and fills in the slot. Returns false if no page has room.
+//
+static bool GL_atlasAdd(const byte *image, glatlasslot_t &slot)
+{
+   const int w  = slot.width;
+   const int h  = slot.height;
+   const int cw = (w + 2 * ATLAS_GUTTER + ATLAS_ALIGN - 1) & ~(ATLAS_ALIGN - 1);
+   const int ch = (h + 2 * ATLAS_GUTTER + ATLAS_ALIGN - 1) & ~(ATLAS_ALIGN - 1);
+
+   if(cw > atlaspagesize || ch > atlaspagesize)
+   {
+      slot.page = ATLAS_TOOLARGE;
+      return false;
+   }
+
+   for(int tries = 0; tries < 2; tries++)
+   {
+      if(atlascurrent >= 0)
+      {
+         glatlaspage_t &page = atlaspages[atlascurrent];
+
+         if(page.shelfx + cw > atlaspagesize)
+         {
+            page.shelfy     += page.shelfheight;
+            page.shelfx      = 0;
+            page.shelfheight = 0;
+         }
+
+         if(page.shelfy + ch <= atlaspagesize)
+         {
+            const int x = page.shelfx;
+            const int y = page.shelfy;
+
+            for(int cy = 0; cy < ch; cy++)
+            {
+               const byte *src  = image + eclamp(cy - ATLAS_GUTTER, 0, h - 1) * w * 4;
+               byte       *dest = page.levels[0] + ((y + cy) * atlaspagesize + x) * 4;
+
+               for(int cx = 0; cx < cw; cx++, dest += 4)
+                  memcpy(dest, src + eclamp(cx - ATLAS_GUTTER, 0, w - 1) * 4, 4);
+            }
+
+            page.shelfx     += cw;
+            page.shelfheight = emax(page.shelfheight, ch);
+            page.dirtyy1     = emin(page.dirtyy1, y);
+            page.dirtyy2     = emax(page.dirtyy2, y + ch);
+
+            slot.page = int16_t(atlascurrent);
+            slot.x    = uint16_t(x + ATLAS_GUTTER);
+            slot.y    = uint16_t(y + ATLAS_GUTTER);
+            slot.gen  = ++page.gen;
+            return true;
+         }
+      }
+
+      if((atlascurrent = GL_atlasNewPage()) < 0)
+         return false;
+   }
+
+   return false;
+}
+
+//
+// Fills in a region for an image that's in the atlas, if it has been sent.
+//
+static bool GL_atlasRegion(const glatlasslot_t &slot, bool flipped,
+                           glatlasregion_t &region)
+{
+   glatlaspage_t &page = atlaspages[slot.page];
+   const GLfloat  size = GLfloat(atlaspagesize);
+
+   page.usedframe = atlasframe;
+
+   if(slot.gen > page.readygen)
+      return false;
+
+   region.texture    = page.texture;
+   region.s1         = slot.x / size;
+   region.t1         = slot.y / size;
+   region.s2         = (slot.x + slot.width) / size;
+   region.t2         = (slot.y + slot.height) / size;
+   region.width      = slot.width;
+   region.height     = slot.height;
+   region.leftoffset = slot.leftoffset;
+   region.topoffset  = slot.topoffset;
+
+   if(flipped)
+   {
+      const GLfloat s1 = region.s1;
+      region.s1 = region.s2;
+      region.s2 = s1;
+   }
+
+   return true;
+}
+
+//
+// Composes a texture or flat into an RGBA image, taking the transparency of
+// masked textures from their column posts, and adds it.
+//
+static bool GL_atlasAddTexture(int texnum, glatlasslot_t &slot)
+{
+   const texture_t *tex = R_CacheTexture(texnum);
+   const int        w   = tex->width;
+   const int        h   = tex->height;
+   byte            *image;
+
+   slot.width      = tex->width;
+   slot.height     = tex->height;
+   slot.leftoffset = slot.topoffset = 0;
+
+   image = GL_atlasImage(w, h);
+
+   for(int x = 0; x < w; x++)
+   {
+      if(tex->flags & TF_MASKED)
+      {
+         for(const texcol_t *col = tex->columns[x]; col; col = col->next)
+         {
+            for(int i = 0; i < col->len; i++)
+            {
+               byte *dest = image + ((col->yoff + i) * w + x) * 4;
+
+               memcpy(dest, atlaspalette[tex->bufferdata[col->ptroff + i]], 4);
+            }
+         }
+      }
+      else
+      {
+         const byte *source = tex->bufferdata + x * h;
+
+         for(int y = 0; y < h; y++)
+            memcpy(image + (y * w + x) * 4, atlaspalette[source[y]], 4);
+      }
+   }
+
+   return GL_atlasAdd(image, slot);
+}
+
+//
+// Draws a sprite patch's posts into an RGBA image and adds it.
+//
+static bool GL_atlasAddSprite(int lump, glatlasslot_t &slot)
+{
+   const patch_t *patch = PatchLoader::CacheNum(wGlobalDir, firstspritelump + lump, PU_CACHE);
+   byte          *image;
+
+   slot.width      = patch->width;
+   slot.height     = patch->height;
+   slot.leftoffset = patch->leftoffset;
+   slot.topoffset  = patch->topoffset;
+
+   // the patch is only cached, so get it again after the image is allocated
+   image = GL_atlasImage(slot.width, slot.height);
+   patch = PatchLoader::CacheNum(wGlobalDir, firstspritelump + lump, PU_CACHE);
+
+   const int w = slot.width;
+   const int h = slot.height;
+
+   for(int x = 0; x < w; x++)
+   {
+      const column_t *column =
+         reinterpret_cast<const column_t *>(reinterpret_cast<const byte *>(patch) +
+                                            patch->columnofs[x]);
+
+      for(; column->topdelta != 0xff;
+          column = reinterpret_cast<const column_t *>(reinterpret_cast<const byte *>(column) +
+                                                      column->length + 4))
+      {
+         const byte *source = reinterpret_cast<const byte *>(column) + 3;
+         const int   count  = emin(int(column->length), h - column->topdelta);
+
+         for(int i = 0; i < count; i++)
+            memcpy(image + ((column->topdelta + i) * w + x) * 4, atlaspalette[source[i]], 4);
+      }
+   }
+
+   return GL_atlasAdd(image, slot);
+}
+
+//
+// Looks up a texture or flat, adding it to the atlas the first time. Returns
+// false if it isn't ready to draw from yet.
+//
+bool GL_AtlasTexture(int texnum, glatlasregion_t &region)
+{
+   if(texnum < 0 || texnum >= numtexslots)
+      return false;
+
+   glatlasslot_t &slot = texslots[texnum];
+
+   if(slot.page == ATLAS_TOOLARGE)
+      return false;
+   if(slot.page == ATLAS_NOPAGE && !GL_atlasAddTexture(texnum, slot))
+      return false;
+
+   return GL_atlasRegion(slot, false, region);
+}
+
+//
+// Looks up one rotation of a sprite frame, as GL_AtlasTexture does.
+//
+bool GL_AtlasSprite(int sprite, int frame, int rotation, glatlasregion_t &region)
+{
+   if(sprite < 0 || sprite >= numsprites || frame < 0 ||
+      frame >= sprites[sprite].numframes || rotation < 0 || rotation > 7)
+      return false;
+
+   const spriteframe_t &sprframe = sprites[sprite].spriteframes[frame];
+
+   if(!sprframe.rotate)
+      rotation = 0;
+
+   const int lump = sprframe.lump[rotation];
+
+   if(lump < 0 || lump >= numspriteslots)
+      return false;
+
+   glatlasslot_t &slot = spriteslots[lump];
+
+   if(slot.page == ATLAS_TOOLARGE)
+      return false;
+   if(slot.page == ATLAS_NOPAGE && !GL_atlasAddSprite(lump, slot))
+      return false;
+
+   return GL_atlasRegion(slot, !!sprframe.flip[rotation], region);
+}
+
+//
+// Box filters rows of one level into the next, weighting colours by their
+// alpha so transparent pixels don't darken the edges of an image.
+//
+static void GL_atlasMipRows(const byte *src, byte *dest, int size, int y1, int y2)
+{
+   const int srcpitch = size * 2 * 4;
+
+   for(int y = y1; y < y2; y++)
+   {
+      const byte *row0 = src + 2 * y * srcpitch;
+      const byte *row1 = row0 + srcpitch;
+      byte       *out  = dest + y * size * 4;
+
+      for(int x = 0; x < size; x++, row0 += 8, row1 += 8, out += 4)
+      {
+         const byte *p[4] = { row0, row0 + 4, row1, row1 + 4 };
+         const int   a    = p[0][3] + p[1][3] + p[2][3] + p[3][3];
+
+         if(!a)
+         {
+            memset(out, 0, 4);
+            continue;
+         }
+
+         for(int c = 0; c < 3; c++)
+         {
+            out[c] = byte((p[0][c] * p[0][3] + p[1][c] * p[1][3] +
+                           p[2][c] * p[2][3] + p[3][c] * p[3][3] + a / 2) / a);
+         }
+         out[3] = byte((a + 2) / 4);
+      }
+   }
+}
+
+//
+// Mips a band of base level rows and sends it at every level, all levels
+// packed one after another in staging memory if there is any to be had.
+//
+static void GL_atlasUploadBand(glatlaspage_t &page, int y1, int y2)
+{
+   size_t bandsize = 0;
+   byte  *staged   = nullptr;
+
+   for(int level = 1; level <= ATLAS_MIPLEVELS; level++)
+   {
+      GL_atlasMipRows(page.levels[level - 1], page.levels[level],
+                      atlaspagesize >> level, y1 >> level, y2 >> level);
+   }
+
+   for(int level = 0; level <= ATLAS_MIPLEVELS; level++)
+      bandsize += size_t(atlaspagesize >> level) * ((y2 - y1) >> level) * 4;
+
+   GL_BindTextureAndRemember(page.texture);
+
+   if(atlasstaging && (staged = static_cast<byte *>(atlasstaging->map(bandsize))))
+   {
+      size_t offset = 0;
+
+      for(int level = 0; level <= ATLAS_MIPLEVELS; level++)
+      {
+         const int    size      = atlaspagesize >> level;
+         const size_t levelsize = size_t(size) * ((y2 - y1) >> level) * 4;
+
+         memcpy(staged + offset, page.levels[level] + (y1 >> level) * size * 4, levelsize);
+         offset += levelsize;
+      }
+
+      atlasstaging->unmap();
+   }
+
+   size_t offset = 0;
+
+   for(int level = 0; level <= ATLAS_MIPLEVELS; level++)
+   {
+      const int     size   = atlaspagesize >> level;
+      const GLvoid *pixels = staged ? reinterpret_cast<const GLvoid *>(offset)
+                                    : page.levels[level] + (y1 >> level) * size * 4;
+
+      glTexSubImage2D(GL_TEXTURE_2D, level, 0, y1 >> level, size,
+                      (y2 - y1) >> level, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+      offset += size_t(size) * ((y2 - y1) >> level) * 4;
+   }
+
+   if(staged)
+      atlasstaging->release();
+}
+
+//
+// Sends rows written since the last call, up to the per frame budget, and
+// starts a new frame for the pages' recency. Call once per frame, before
+// any lookups. Empties the atlas first if textures have been reloaded.
+//
+void GL_AtlasUpload()
+{
+   const int rowbytes = atlaspagesize * 4;
+   int       budget   = ATLAS_UPLOADBUDGET;
+
+   if(!atlaspages)
+      return;
+
+   if(atlasdatagen != r_datagen)
+      GL_AtlasFlush();
+
+   atlasframe++;
+
+   glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+
+   for(int i = 0; i < numatlaspages && budget > 0; i++)
+   {
+      glatlaspage_t &page = atlaspages[i];
+
+      if(page.dirtyy1 >= page.dirtyy2)
+         continue;
+
+      // whole cells at a time, and at least one row of them
+      const int rows = emin(page.dirtyy2 - page.dirtyy1,
+                            emax((budget / rowbytes) & ~(ATLAS_ALIGN - 1), ATLAS_ALIGN));
+
+      GL_atlasUploadBand(page, page.dirtyy1, page.dirtyy1 + rows);
+      budget       -= rows * rowbytes;
+      page.dirtyy1 += rows;
+
+      if(page.dirtyy1 >= page.dirtyy2)
+      {
+         page.dirtyy1  = atlaspagesize;
+         page.dirtyy2  = 0;
+         page.readygen = page.gen;
+      }
+   }
+}
+
+//
+// Empties the atlas and sizes its lookups to the current textures and
+// sprites.
+//
+void GL_AtlasFlush()
+{
+   efree(texslots);
+   efree(spriteslots);
+
+   atlasdatagen = r_datagen;
+
+   numtexslots    = texturecount;
+   numspriteslots = numspritelumps;
+   texslots       = estructalloc(glatlasslot_t, emax(numtexslots, 1));
+   spriteslots    = estructalloc(glatlasslot_t, emax(numspriteslots, 1));
+
+   for(int i = 0; i < numtexslots; i++)
+      texslots[i].page = ATLAS_NOPAGE;
+   for(int i = 0; i < numspriteslots; i++)
+      spriteslots[i].page = ATLAS_NOPAGE;
+
+   for(int i = 0; i < numatlaspages; i++)
+      GL_atlasClearPage(i);
+
+   atlascurrent = numatlaspages ? 0 : -1;
+}
+
+//
+// Sets up an atlas of at most maxpages pages, each pagesize pixels square
+// or the largest texture GL allows, with colours from the given PLAYPAL.
+//
+void GL_AtlasInit(int pagesize, int maxpages, const byte *palette)
+{
+   GLint maxsize = 0;
+
+   GL_AtlasShutdown();
+
+   glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxsize);
+
+   atlaspagesize = int(GL_MakeTextureDimension(emax(pagesize, 256)));
+   if(maxsize > 0)
+      atlaspagesize = emin(atlaspagesize, int(maxsize));
+
+   maxatlaspages = emax(maxpages, 1);
+   atlaspages    = estructalloc(glatlaspage_t, maxatlaspages);
+
+   for(int i = 0; i < 256; i++)
+   {
+      atlaspalette[i][0] = palette[i * 3 + 0];
+      atlaspalette[i][1] = palette[i * 3 + 1];
+      atlaspalette[i][2] = palette[i * 3 + 2];
+      atlaspalette[i][3] = 255;
+   }
+
+   GL_AtlasFlush();
+}
+
+//
+// Has bands go through the given staging memory, or client memory if null.
+//
+void GL_AtlasSetStaging(const glatlasstaging_t *staging)
+{
+   atlasstaging = staging;
+}
+
+//
+// Gets the most staging memory one band can need: the rows of the per
+// frame budget, or at least one row of cells, and their mip levels.
+//
+size_t GL_AtlasMaxUploadSize()
+{
+   const size_t rowbytes = size_t(atlaspagesize) * 4;
+   const size_t rows     = emax((ATLAS_UPLOADBUDGET / rowbytes) & ~size_t(ATLAS_ALIGN - 1),
+                                size_t(ATLAS_ALIGN));
+
+   // each level is a quarter of the one above, so they add up to under a third more
+   return rows * rowbytes + rows * rowbytes / 3;
+}
+
+//
+// Frees the pages and their GL textures
+//
+void GL_AtlasShutdown()
+{
+   for(int i = 0; i < numatlaspages; i++)
+   {
+      glDeleteTextures(1, &atlaspages[i].texture);
+      for(byte *&level : atlaspages[i].levels)
+         efree(level);
+   }
+
+   efree(atlaspages);
+   efree(texslots);
+   efree(spriteslots);
+   efree(atlasimage);
+
+   atlaspages     = nullptr;
+   texslots       = spriteslots = nullptr;
+   atlasimage     = nullptr;
+   numatlaspages  = maxatlaspages = 0;
+   numtexslots    = numspriteslots = 0;
+   atlasimagesize = 0;
+   atlascurrent   = -1;
+   atlasstaging   = nullptr;
+
+   GL_ClearBoundTexture();
+}
+
+#endif
+
+// EOF
+
@@ -0,0 +1,75 @@
+//
+// The Eternity Engine
+// Copyright(C) 2026 James Haley, Max Waine, et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+// Additional terms and conditions compatible with the GPLv3 apply. See the
+// file COPYING-EE for details.
+//
+// Purpose: Texture and sprite atlas for GL rendering.
+//  Composed textures, flats and sprite frames are packed into a few large
+//  RGBA pages with mipmaps, so a GL renderer binds a handful of textures
+//  per frame instead of one per image. Images are added on first lookup
+//  and sent to the GPU a budgeted amount per frame.
+//
+
+#ifndef GL_ATLAS_H__
+#define GL_ATLAS_H__
+
+#ifdef EE_FEATURE_OPENGL
+
+//
+// Where an image lies in the atlas
+//
+struct glatlasregion_t
+{
+   GLuint  texture;               // GL texture of the page
+   GLfloat s1, t1, s2, t2;        // top left and bottom right; s1 > s2 if flipped
+   int     width, height;         // size in pixels
+   int     leftoffset, topoffset; // sprites only
+};
+
+//
+// Staging memory a driver can lend the atlas for its uploads, such as a ring
+// of pixel buffer objects. map returns somewhere to write size bytes, with
+// the buffer bound for unpacking, or nullptr to send from client memory.
+// Once the data is in, unmap is called, the texture is updated from offsets
+// into the bound buffer, and release is called.
+//
+struct glatlasstaging_t
+{
+   void *(*map)(size_t size);
+   void  (*unmap)();
+   void  (*release)();
+};
+
+void GL_AtlasInit(int pagesize, int maxpages, const byte *palette);
+void GL_AtlasShutdown();
+void GL_AtlasFlush();
+
+void   GL_AtlasSetStaging(const glatlasstaging_t *staging);
+size_t GL_AtlasMaxUploadSize();
+
+bool GL_AtlasTexture(int texnum, glatlasregion_t &region);
+bool GL_AtlasSprite(int sprite, int frame, int rotation, glatlasregion_t &region);
+
+void GL_AtlasUpload();
+
+#endif
+
+#endif
+
+// EOF
+
@@ -41,6 +41,7 @@ int  cfg_gl_filter_type;     // texture filtering type
 int  cfg_gl_texture_format;  // texture internal format
 bool cfg_gl_use_extensions;  // must be true for extensions to be used
 bool cfg_gl_arb_pixelbuffer; // enable ARB PBO extension
+bool cfg_gl_palette_shader;  // convert the palette in a fragment shader
 
 VARIABLE_INT(cfg_gl_colordepth, nullptr, 16, 32, nullptr);
 CONSOLE_VARIABLE(gl_colordepth, cfg_gl_colordepth, 0) {}
@@ -56,5 +57,8 @@ CONSOLE_VARIABLE(gl_use_extensions, cfg_gl_use_extensions, 0) {}
 VARIABLE_TOGGLE(cfg_gl_arb_pixelbuffer, nullptr, yesno);
 CONSOLE_VARIABLE(gl_arb_pixelbuffer, cfg_gl_arb_pixelbuffer, 0) {}
 
+VARIABLE_TOGGLE(cfg_gl_palette_shader, nullptr, yesno);
+CONSOLE_VARIABLE(gl_palette_shader, cfg_gl_palette_shader, 0) {}
+
 // EOF
 
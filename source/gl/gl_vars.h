@@ -43,6 +43,7 @@ extern int  cfg_gl_colordepth;
 extern int  cfg_gl_filter_type;
 extern bool cfg_gl_use_extensions;
 extern bool cfg_gl_arb_pixelbuffer;
+extern bool cfg_gl_palette_shader;
 
 void GL_AddCommands();
 
@@ -0,0 +1,177 @@
+// Emacs style mode select   -*- C++ -*- 
+//-----------------------------------------------------------------------------
+//
+// Copyright(C) 2026 James Haley et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+// Additional terms and conditions compatible with the GPLv3 apply. See the
+// file COPYING-EE for details.
+//
+//-----------------------------------------------------------------------------
+//
+// DESCRIPTION:
+//    Read-only file mapping
+//
+//    Archives which stay open for the whole session are mapped so that lump
+//    reads become a copy out of the page cache instead of a seek and read
+//    system call pair each. Mapping is only an optimization; callers fall
+//    back to stdio whenever it fails or is unavailable.
+//
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+
+#include "../z_zone.h"
+
+#include "i_filemap.h"
+#include "i_platform.h"
+
+#if EE_CURRENT_PLATFORM == EE_PLATFORM_LINUX \
+ || EE_CURRENT_PLATFORM == EE_PLATFORM_MACOSX \
+ || EE_CURRENT_PLATFORM == EE_PLATFORM_FREEBSD
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define EE_HAVE_MMAP
+#elif EE_CURRENT_PLATFORM == EE_PLATFORM_WINDOWS
+#include <io.h>
+#include <windows.h>
+#endif
+
+//=============================================================================
+//
+// Global Functions
+//
+
+//
+// I_MapFile
+//
+// Map the entire file behind an open handle. Returns false, leaving map
+// empty, if the platform cannot do so.
+//
+bool I_MapFile(FILE *f, filemap_t &map)
+{
+   map.data = nullptr;
+   map.size = 0;
+
+#if defined(EE_HAVE_MMAP)
+   struct stat sbuf;
+   int fd = fileno(f);
+
+   if(fstat(fd, &sbuf) || !S_ISREG(sbuf.st_mode) || sbuf.st_size <= 0 ||
+      static_cast<unsigned long long>(sbuf.st_size) > SIZE_MAX)
+      return false;
+
+   void *data = mmap(nullptr, static_cast<size_t>(sbuf.st_size), PROT_READ,
+                     MAP_PRIVATE, fd, 0);
+   if(data == MAP_FAILED)
+      return false;
+
+   map.data = static_cast<const unsigned char *>(data);
+   map.size = static_cast<size_t>(sbuf.st_size);
+   return true;
+#elif EE_CURRENT_PLATFORM == EE_PLATFORM_WINDOWS
+   HANDLE        file = reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(f)));
+   LARGE_INTEGER size;
+
+   if(file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &size) ||
+      size.QuadPart <= 0 || static_cast<unsigned long long>(size.QuadPart) > SIZE_MAX)
+      return false;
+
+   HANDLE mapping = CreateFileMapping(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+   if(!mapping)
+      return false;
+
+   // the view holds its own reference to the mapping object
+   void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+   CloseHandle(mapping);
+   if(!data)
+      return false;
+
+   map.data = static_cast<const unsigned char *>(data);
+   map.size = static_cast<size_t>(size.QuadPart);
+   return true;
+#else
+   return false;
+#endif
+}
+
+//
+// I_UnmapFile
+//
+void I_UnmapFile(filemap_t &map)
+{
+   if(!map.data)
+      return;
+
+#if defined(EE_HAVE_MMAP)
+   munmap(const_cast<unsigned char *>(map.data), map.size);
+#elif EE_CURRENT_PLATFORM == EE_PLATFORM_WINDOWS
+   UnmapViewOfFile(map.data);
+#endif
+
+   map.data = nullptr;
+   map.size = 0;
+}
+
+//
+// I_ReadMappedFile
+//
+// Copy len bytes at offset out of a mapped file. Returns false if the file is
+// not mapped or the range does not lie wholly within it.
+//
+bool I_ReadMappedFile(const filemap_t &map, size_t offset, void *dest, size_t len)
+{
+   if(!map.data || offset > map.size || len > map.size - offset)
+      return false;
+
+   memcpy(dest, map.data + offset, len);
+   return true;
+}
+
+//
+// I_PrefetchMappedFile
+//
+// Ask the OS to start reading a range of a mapped file into memory in the
+// background. This is purely a hint and does nothing if the file isn't
+// mapped or the platform has no way of doing it.
+//
+void I_PrefetchMappedFile(const filemap_t &map, size_t offset, size_t len)
+{
+   if(!map.data || !len || offset >= map.size)
+      return;
+
+   if(len > map.size - offset)
+      len = map.size - offset;
+
+#if defined(EE_HAVE_MMAP)
+   // the advice has to start on a page boundary
+   const size_t pagesize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+   const size_t start    = offset - (offset % pagesize);
+
+   posix_madvise(const_cast<unsigned char *>(map.data) + start,
+                 len + (offset - start), POSIX_MADV_WILLNEED);
+#elif EE_CURRENT_PLATFORM == EE_PLATFORM_WINDOWS && defined(_WIN32_WINNT) && \
+      _WIN32_WINNT >= 0x0602
+   WIN32_MEMORY_RANGE_ENTRY range;
+
+   range.VirtualAddress = const_cast<unsigned char *>(map.data) + offset;
+   range.NumberOfBytes  = len;
+   PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#endif
+}
+
+// EOF
+
@@ -0,0 +1,54 @@
+// Emacs style mode select   -*- C++ -*- 
+//-----------------------------------------------------------------------------
+//
+// Copyright(C) 2026 James Haley et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+// Additional terms and conditions compatible with the GPLv3 apply. See the
+// file COPYING-EE for details.
+//
+//-----------------------------------------------------------------------------
+//
+// DESCRIPTION:
+//    Read-only file mapping
+//
+//-----------------------------------------------------------------------------
+
+#ifndef I_FILEMAP_H__
+#define I_FILEMAP_H__
+
+#include <stddef.h>
+#include <stdio.h>
+
+//
+// filemap_t
+//
+// A read-only view of the whole of an open disk file.
+//
+struct filemap_t
+{
+   const unsigned char *data;
+   size_t               size;
+};
+
+bool I_MapFile(FILE *f, filemap_t &map);
+void I_UnmapFile(filemap_t &map);
+bool I_ReadMappedFile(const filemap_t &map, size_t offset, void *dest, size_t len);
+void I_PrefetchMappedFile(const filemap_t &map, size_t offset, size_t len);
+
+#endif
+
+// EOF
+
@@ -0,0 +1,323 @@
+// Emacs style mode select   -*- C++ -*-
+//-----------------------------------------------------------------------------
+//
+// Copyright(C) 2026 James Haley et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+// Additional terms and conditions compatible with the GPLv3 apply. See the
+// file COPYING-EE for details.
+//
+//-----------------------------------------------------------------------------
+//
+// DESCRIPTION:
+//    Child processes
+//
+//    Tools such as -demoverify run copies of the program side by side and
+//    wait for them to finish. Each child's standard output and error go to a
+//    file, and when it ends its exit code and peak memory use are collected.
+//
+//-----------------------------------------------------------------------------
+
+#include "../z_zone.h"
+
+#include "i_platform.h"
+#include "i_process.h"
+#include "../m_argv.h"
+#include "../m_qstr.h"
+
+#if EE_CURRENT_PLATFORM == EE_PLATFORM_LINUX \
+ || EE_CURRENT_PLATFORM == EE_PLATFORM_MACOSX \
+ || EE_CURRENT_PLATFORM == EE_PLATFORM_FREEBSD
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#define EE_HAVE_FORK
+#elif EE_CURRENT_PLATFORM == EE_PLATFORM_WINDOWS
+#include <process.h>
+#include <windows.h>
+#endif
+
+#if defined(EE_HAVE_FORK)
+
+//
+// I_selfPath
+//
+// The program to run again. Linux can name the running binary itself; on
+// other systems it is looked for the way the shell found it.
+//
+static const char *I_selfPath(bool &search)
+{
+#if EE_CURRENT_PLATFORM == EE_PLATFORM_LINUX
+   static char path[PATH_MAX];
+
+   if(!*path)
+   {
+      const ssize_t len = readlink("/proc/self/exe", path, sizeof(path) - 1);
+      path[len > 0 ? len : 0] = '\0';
+   }
+
+   if(*path)
+   {
+      search = false;
+      return path;
+   }
+#endif
+
+   search = true;
+   return myargv[0];
+}
+
+#elif EE_CURRENT_PLATFORM == EE_PLATFORM_WINDOWS
+
+#define MAXCHILDREN MAXIMUM_WAIT_OBJECTS
+
+static HANDLE childhandles[MAXCHILDREN];
+static int    childids[MAXCHILDREN];
+static int    numchildren;
+static int    nextchildid = 1;
+
+//
+// I_quoteArgument
+//
+// Adds an argument to a command line the way the C runtime splits it up.
+//
+static void I_quoteArgument(qstring &cmdline, const char *arg)
+{
+   int backslashes = 0;
+
+   if(!cmdline.empty())
+      cmdline += ' ';
+   cmdline += '"';
+
+   for(const char *c = arg; *c; c++)
+   {
+      if(*c == '\\')
+      {
+         ++backslashes;
+         continue;
+      }
+
+      // backslashes before a quote are doubled, and the quote escaped
+      for(; backslashes; backslashes--)
+         cmdline += (*c == '"') ? "\\\\" : "\\";
+      if(*c == '"')
+         cmdline += '\\';
+      cmdline += *c;
+   }
+
+   // and so are those before the closing quote
+   for(; backslashes; backslashes--)
+      cmdline += "\\\\";
+   cmdline += '"';
+}
+
+#endif
+
+//=============================================================================
+//
+// Global Functions
+//
+
+//
+// I_CanSpawnProcesses
+//
+bool I_CanSpawnProcesses()
+{
+#if defined(EE_HAVE_FORK) || EE_CURRENT_PLATFORM == EE_PLATFORM_WINDOWS
+   return true;
+#else
+   return false;
+#endif
+}
+
+//
+// I_SpawnSelf
+//
+// Starts this program again with the given null-terminated arguments, not
+// counting the program name, its output going to outpath. Returns an ID to
+// match with I_WaitProcess, or -1 if it couldn't be started.
+//
+int I_SpawnSelf(const char *const *args, const char *outpath)
+{
+#if defined(EE_HAVE_FORK)
+   bool        search;
+   const char *path = I_selfPath(search);
+   size_t      numargs = 0;
+
+   while(args[numargs])
+      ++numargs;
+
+   // exec wants them all in one array, program name first
+   const char **argv = ecalloc(const char **, numargs + 2, sizeof(const char *));
+   argv[0] = myargv[0];
+   for(size_t i = 0; i < numargs; i++)
+      argv[i + 1] = args[i];
+
+   const int outfd = open(outpath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+   if(outfd < 0)
+   {
+      efree(argv);
+      return -1;
+   }
+
+   fflush(stdout);
+   fflush(stderr);
+
+   const pid_t pid = fork();
+   if(!pid)
+   {
+      dup2(outfd, STDOUT_FILENO);
+      dup2(outfd, STDERR_FILENO);
+      close(outfd);
+
+      if(search)
+         execvp(path, const_cast<char *const *>(argv));
+      else
+         execv(path, const_cast<char *const *>(argv));
+      _exit(127);
+   }
+
+   close(outfd);
+   efree(argv);
+
+   return pid > 0 ? static_cast<int>(pid) : -1;
+#elif EE_CURRENT_PLATFORM == EE_PLATFORM_WINDOWS
+   char    path[MAX_PATH];
+   qstring cmdline;
+
+   if(numchildren == MAXCHILDREN ||
+      !GetModuleFileNameA(nullptr, path, sizeof(path)))
+      return -1;
+
+   I_quoteArgument(cmdline, path);
+   for(const char *const *arg = args; *arg; arg++)
+      I_quoteArgument(cmdline, *arg);
+
+   SECURITY_ATTRIBUTES sa = {};
+   sa.nLength        = sizeof(sa);
+   sa.bInheritHandle = TRUE;
+
+   HANDLE out = CreateFileA(outpath, GENERIC_WRITE, FILE_SHARE_READ, &sa,
+                            CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+   if(out == INVALID_HANDLE_VALUE)
+      return -1;
+
+   STARTUPINFOA        si = {};
+   PROCESS_INFORMATION pi = {};
+
+   si.cb         = sizeof(si);
+   si.dwFlags    = STARTF_USESTDHANDLES;
+   si.hStdInput  = GetStdHandle(STD_INPUT_HANDLE);
+   si.hStdOutput = out;
+   si.hStdError  = out;
+
+   const BOOL started = CreateProcessA(path, cmdline.getBuffer(), nullptr,
+                                       nullptr, TRUE, CREATE_NO_WINDOW,
+                                       nullptr, nullptr, &si, &pi);
+   CloseHandle(out);
+
+   if(!started)
+      return -1;
+
+   CloseHandle(pi.hThread);
+
+   childhandles[numchildren] = pi.hProcess;
+   childids[numchildren]     = nextchildid++;
+   return childids[numchildren++];
+#else
+   return -1;
+#endif
+}
+
+//
+// I_WaitProcess
+//
+// Waits for one of the programs I_SpawnSelf started to end. Returns its ID,
+// or -1 if none are left, and gives its exit code and the most memory it
+// had in use, in kilobytes, or 0 where that can't be told.
+//
+int I_WaitProcess(int &exitcode, size_t &peakkb)
+{
+   exitcode = -1;
+   peakkb   = 0;
+
+#if defined(EE_HAVE_FORK)
+   int     status;
+   rusage  usage;
+   pid_t   pid;
+
+   while((pid = wait4(-1, &status, 0, &usage)) < 0 && errno == EINTR);
+
+   if(pid < 0)
+      return -1;
+
+   if(WIFEXITED(status))
+      exitcode = WEXITSTATUS(status);
+   else if(WIFSIGNALED(status))
+      exitcode = 128 + WTERMSIG(status);
+
+#if EE_CURRENT_PLATFORM == EE_PLATFORM_MACOSX
+   peakkb = static_cast<size_t>(usage.ru_maxrss) / 1024; // in bytes there
+#else
+   peakkb = static_cast<size_t>(usage.ru_maxrss);
+#endif
+
+   return static_cast<int>(pid);
+#elif EE_CURRENT_PLATFORM == EE_PLATFORM_WINDOWS
+   if(!numchildren)
+      return -1;
+
+   const DWORD result = WaitForMultipleObjects(numchildren, childhandles, FALSE,
+                                               INFINITE);
+   if(result >= WAIT_OBJECT_0 + numchildren)
+      return -1;
+
+   const int slot = static_cast<int>(result - WAIT_OBJECT_0);
+   const int id   = childids[slot];
+   DWORD     code;
+
+   if(GetExitCodeProcess(childhandles[slot], &code))
+      exitcode = static_cast<int>(code);
+   CloseHandle(childhandles[slot]);
+
+   --numchildren;
+   childhandles[slot] = childhandles[numchildren];
+   childids[slot]     = childids[numchildren];
+
+   return id;
+#else
+   return -1;
+#endif
+}
+
+//
+// I_CurrentProcessID
+//
+int I_CurrentProcessID()
+{
+#if defined(EE_HAVE_FORK)
+   return static_cast<int>(getpid());
+#elif EE_CURRENT_PLATFORM == EE_PLATFORM_WINDOWS
+   return _getpid();
+#else
+   return 0;
+#endif
+}
+
+// EOF
+
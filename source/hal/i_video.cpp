@@ -53,6 +53,7 @@
 #include "../sdl/i_sdlvideo.h"
 #ifdef EE_FEATURE_OPENGL
 #include "../sdl/i_sdlgl2d.h"
+#include "../sdl/i_sdlglworld.h"
 #endif
 #endif
 
@@ -84,7 +85,7 @@ const char *const i_videohelpstr =
 #ifdef _SDL_VER
   ", 0 = SDL Default"
 #ifdef EE_FEATURE_OPENGL
-  ", 1 = SDL GL2D"
+  ", 1 = SDL GL2D, 2 = SDL GL World"
 #endif
 #endif
   ")";
@@ -111,6 +112,17 @@ static haldriveritem_t halVideoDriverTable[VDR_MAXDRIVERS] =
       &i_sdlvideodriver
 #else
       nullptr
+#endif
+   },
+
+   // SDL GL World Driver
+   {
+      VDR_SDLGLWORLD,
+      "SDL GL World",
+#if defined(_SDL_VER) && defined(EE_FEATURE_OPENGL)
+      &i_sdlglworldvideodriver
+#else
+      nullptr
 #endif
    }
 };
@@ -764,7 +776,8 @@ static const char *i_videodrivernames[] =
 {
    "default",
    "SDL Default",
-   "SDL GL2D"
+   "SDL GL2D",
+   "SDL GL World"
 };
 
 VARIABLE_INT(i_videodriverid, nullptr, -1, VDR_MAXDRIVERS-1, i_videodrivernames);
@@ -209,6 +209,7 @@ static void HU_InitLevelName();
 static void HU_InitChat();
 static void HU_InitCoords();
 static void HU_InitStats();
+static void HU_InitNetStats();
 
 //
 // HU_InitNativeWidgets
@@ -226,6 +227,7 @@ static void HU_InitNativeWidgets()
    HU_InitChat();
    HU_InitCoords();
    HU_InitStats();
+   HU_InitNetStats();
 
    // HUD_FIXME: generalize?
    HU_FragsInit();
@@ -978,7 +980,7 @@ void HUDCrossHairWidget::drawer()
    if(!crosshair_scale)
    {
       drawx  = (video.width  + 1 - w) / 2;
-      drawy  = viewwindow.y + (viewwindow.height + 1 - h) / 2;
+      drawy  = presentwindow.y + (presentwindow.height + 1 - h) / 2;
       buffer = &vbscreenfullres;
    }
    else
@@ -1557,6 +1559,69 @@ static void HU_InitStats()
    statsecr_widget.initProps(HUDStatWidget::STATTYPE_SECRETS);
 }
 
+//==============================================================================
+//
+// Network statistics widget
+//
+
+class HUDNetStatsWidget : public HUDTextWidget
+{
+public:
+   virtual void drawer();
+
+   void initProps()
+   {
+      x        = 4;
+      y        = 40;
+      message  = nullptr;
+      font     = hud_font;
+      cleartic = 0;
+      flags    = TW_BOXED;
+   }
+};
+
+static HUDNetStatsWidget netstats_widget;
+
+bool hu_shownetstats;
+
+//
+// HUDNetStatsWidget::drawer
+//
+// Like the open socket warning, this is formatted in the drawer rather than a
+// ticker, since stalls are exactly when the game tickers stop.
+//
+void HUDNetStatsWidget::drawer()
+{
+   static char netstatsstr[192];
+
+   if(!hu_shownetstats || !netgame)
+      return;
+
+   const netstats_t &r = netstatsrate;
+
+   snprintf(netstatsstr, sizeof(netstatsstr),
+            "out %d/s %d B/s\nin %d/s %d B/s\n"
+            "resend %d/%d bad %d dup %d gap %d\n"
+            "queued %d ready %d\nstalled %d/%d frames %d ms",
+            r.packetssent, r.bytessent, r.packetsreceived, r.bytesreceived,
+            r.retransmitsasked, r.retransmitsgiven, r.badchecksums,
+            r.duplicates, r.gaps, netstats.queued, netstats.ready,
+            r.stallframes, r.frames, r.waitms);
+   message = netstatsstr;
+
+   HUDTextWidget::drawer();
+}
+
+static void HU_InitNetStats()
+{
+   netstats_widget.setName("_HU_NetStatsWidget");
+   netstats_widget.setType(WIDGET_TEXT);
+
+   HUDWidget::AddWidgetToHash(&netstats_widget);
+
+   netstats_widget.initProps();
+}
+
 ////////////////////////////////////////////////////////////////////////
 //
 // Tables
@@ -1626,6 +1691,7 @@ VARIABLE_INT(message_timer,     nullptr, 0, 100000,        nullptr);
 VARIABLE_TOGGLE(hu_showtime,         nullptr,                yesno);
 VARIABLE_TOGGLE(hu_showcoords,       nullptr,                yesno);
 VARIABLE_TOGGLE(hu_alwaysshowcoords, nullptr,                yesno);
+VARIABLE_TOGGLE(hu_shownetstats,     nullptr,                yesno);
 VARIABLE_INT(hu_timecolor,           nullptr, 0, CR_BUILTIN,    textcolours);
 VARIABLE_INT(hu_levelnamecolor,      nullptr, 0, CR_BUILTIN,    textcolours);
 VARIABLE_INT(hu_coordscolor,         nullptr, 0, CR_BUILTIN,    textcolours);
@@ -1660,6 +1726,7 @@ CONSOLE_VARIABLE(hu_messagetime, message_timer, 0) {}
 CONSOLE_VARIABLE(hu_showtime, hu_showtime, 0) {}
 CONSOLE_VARIABLE(hu_showcoords, hu_showcoords, 0) {}
 CONSOLE_VARIABLE(hu_alwaysshowcoords, hu_alwaysshowcoords, 0) {}
+CONSOLE_VARIABLE(hu_shownetstats, hu_shownetstats, 0) {}
 CONSOLE_VARIABLE(hu_timecolor, hu_timecolor, 0) {}
 CONSOLE_VARIABLE(hu_levelnamecolor, hu_levelnamecolor, 0) {}
 CONSOLE_VARIABLE(hu_coordscolor, hu_coordscolor, 0) {}
@@ -1975,7 +2042,7 @@ static cell AMX_NATIVE_CALL sm_gethudmode(AMX *amx, cell *params)
 {
    if(hud_enabled && hud_overlaylayout > 0) // Boom HUD enabled, return style
       return (cell)hud_overlaylayout + 1;
-   else if(viewwindow.height == video.height)         // Fullscreen (no HUD)
+   else if(presentwindow.height == video.height)         // Fullscreen (no HUD)
       return 0;			
    else                                    // Vanilla style status bar
       return 1;
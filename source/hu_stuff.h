@@ -103,6 +103,7 @@ extern bool crosshair_scale;
 extern bool hu_showtime;
 extern bool hu_showcoords;
 extern bool hu_alwaysshowcoords;
+extern bool hu_shownetstats;
 extern int  hu_timecolor;
 extern int  hu_levelnamecolor;
 extern int  hu_coordscolor;
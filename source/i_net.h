@@ -31,6 +31,32 @@
 void I_InitNetwork(void);
 bool I_NetCmd(void);
 
+// Sends any packets the driver is holding back to send together.
+void I_NetFlush();
+
+// Sets the ticcmd wire format (NETFORMAT_*) used for packets to a node.
+void I_NetSetFormat(int node, int format);
+
+// Gets the smoothed round trip time to a node and its mean deviation, in
+// milliseconds. False until a NETFORMAT_TIMED packet has measured them.
+bool I_NetNodeTiming(int node, int &rtt, int &jitter);
+
+// Spectator relay. Once it is open, requests for the relay stream are read
+// from any address, not just the nodes of the game. Spectators are numbered
+// as they first ask, and keep their number until they are dropped.
+void I_NetOpenRelay();
+
+// Gets the next request read: from which spectator, and how many bytes of
+// the stream it holds. False when there are no more.
+bool I_NetGetRelayRequest(int &spectator, uint32_t &have);
+
+// Sends a spectator as much of the stream from offset as one packet holds,
+// and returns how many bytes that was.
+int I_NetSendRelay(int spectator, uint32_t offset, const byte *data, int len);
+
+// Forgets a spectator. Its number may go to the next new one.
+void I_NetDropSpectator(int spectator);
+
 #endif
 
 //----------------------------------------------------------------------------
@@ -27,11 +27,22 @@
 #define I_SOUND_H__
 
 struct sfxinfo_t;
+class  WadLumpStream;
+
+// New parameters for a playing sound channel
+struct sndupdate_t
+{
+   int handle;
+   int vol;
+   int sep;
+   int pitch;
+};
 
 struct i_sounddriver_t
 {
    int  (*InitSound)(void);
    void (*CacheSound)(sfxinfo_t *);
+   void (*PrecacheSounds)(sfxinfo_t *const *, int);
    void (*UpdateSound)(void);
    void (*SubmitSound)(void);
    void (*ShutdownSound)(void);
@@ -40,7 +51,9 @@ struct i_sounddriver_t
    void (*StopSound)(int, int);
    int  (*SoundIsPlaying)(int);
    void (*UpdateSoundParams)(int, int, int, int);
+   void (*UpdateSoundParamsBatch)(const sndupdate_t *, int);
    void (*UpdateEQParams)(void);
+   void (*HoldSoundCommands)(bool);
 };
 
 // Init at program start...
@@ -56,6 +69,9 @@ void I_ShutdownSound();
 // Cache sound data
 void I_CacheSound(sfxinfo_t *sound);
 
+// Prepare sounds for playing ahead of time
+void I_PrecacheSounds(sfxinfo_t *const *sounds, int count);
+
 //
 //  SFX I/O
 //
@@ -79,6 +95,13 @@ int I_SoundIsPlaying(int handle);
 //  and pitch of a sound channel.
 void I_UpdateSoundParams(int handle, int vol, int sep, int pitch);
 
+// Updates several channels at once.
+void I_UpdateSoundParamsBatch(const sndupdate_t *updates, int count);
+
+// While held, sounds started, stopped, and updated reach the mixer together
+// once released.
+void I_HoldSoundCommands(bool hold);
+
 //
 //  MUSIC I/O
 //
@@ -91,6 +114,7 @@ struct i_musicdriver_t
    void (*PauseSong)(int);
    void (*ResumeSong)(int);
    int  (*RegisterSong)(void *, int);
+   int  (*RegisterSongStream)(WadLumpStream *); // may be nullptr
    void (*PlaySong)(int, int);
    void (*StopSong)(int);
    void (*UnRegisterSong)(int);
@@ -111,6 +135,11 @@ void I_ResumeSong(int handle);
 // julian: added length parameter for SDL's RWops
 int I_RegisterSong(void *data, int length);
 
+// Registers a song that is read from its lump as it plays. The stream
+// belongs to the music driver from here on, whether or not it took the
+// song; 0 means the lump has to be loaded and given to I_RegisterSong.
+int I_RegisterSongStream(WadLumpStream *stream);
+
 // Called by anything that wishes to start music.
 //  plays a song, and when the song is done,
 //  starts playing it again in an endless loop.
@@ -136,6 +165,8 @@ extern double  s_lowgain;   // low band gain
 extern double  s_midgain;   // mid band gain
 extern double  s_highgain;  // high band gain
 
+extern int     s_interpolation; // sound effect resampling: 0 = none, 1 = linear
+
 extern bool    s_reverbactive;
 
 static inline bool I_IsSoundBufferSizePowerOf2(int i)
@@ -147,6 +147,7 @@ enum halvdr_e
 {
    VDR_SDLDEFAULT,
    VDR_SDLGL2D,
+   VDR_SDLGLWORLD,
    VDR_MAXDRIVERS
 };
 
@@ -22,9 +22,13 @@
 // Authors: James Haley
 //
 
+#include <memory>
+
 #include "z_zone.h"
 #include "i_system.h"
+#include "../zlib/zlib.h"
 #include "m_buffer.h"
+#include "m_compare.h"
 #include "m_swap.h"
 
 //=============================================================================
@@ -52,7 +56,7 @@ void BufferedFileBase::initBuffer(size_t pLen, int pEndian)
 //
 long BufferedFileBase::tell()
 {
-   return ftell(f);
+   return f ? ftell(f) : static_cast<long>(idx);
 }
 
 //
@@ -173,16 +177,54 @@ bool OutBuffer::createFile(const char *filename, size_t pLen, int pEndian)
    return true;
 }
 
+//
+// Sets up output to a buffer in memory instead of a file. The buffer starts at
+// pLen bytes and doubles whenever it fills; take it with detachMemory.
+//
+void OutBuffer::createMemory(size_t pLen, int pEndian)
+{
+   initBuffer(pLen, pEndian);
+   f       = nullptr;
+   ownFile = false;
+}
+
+//
+// Hands over the memory written since createMemory, which the caller must
+// efree, and closes the buffer.
+//
+byte *OutBuffer::detachMemory(size_t &size)
+{
+   byte *data = buffer;
+
+   size   = idx;
+   buffer = nullptr;
+   close();
+
+   return data;
+}
+
 //
 // Call to flush the contents of the buffer to the output file. This will be
 // called automatically before the file is closed, but must be called explicitly
-// if a current file offset is needed. Returns false if an IO error occurs.
+// if a current file offset is needed. The data is passed on to the system, so
+// it survives the program crashing. Returns false if an IO error occurs.
+// In memory, a full buffer grows instead.
 //
 bool OutBuffer::flush()
 {
+   if(!f)
+   {
+      if(idx == len)
+      {
+         len   *= 2;
+         buffer = erealloc(byte *, buffer, len);
+      }
+      return true;
+   }
+
    if(idx)
    {
-      if(fwrite(buffer, sizeof(byte), idx, f) < idx)
+      if(fwrite(buffer, sizeof(byte), idx, f) < idx || fflush(f))
       {
          if(throwing)
             throw BufferedIOException("fwrite did not write the requested amount");
@@ -230,7 +272,7 @@ bool OutBuffer::write(const void *data, size_t size)
       {
          if(!flush())
             return false;
-         lWriteAmt = len;
+         lWriteAmt = len - idx;
       }
 
       if(lBytesToWrite < lWriteAmt)
@@ -362,11 +404,43 @@ bool InBuffer::openExisting(FILE *pf, int pEndian)
    return true;
 }
 
+//
+// Reads from data, which must stay valid until the buffer is closed, instead
+// of a file.
+//
+void InBuffer::openMemory(const byte *data, size_t size, int pEndian)
+{
+   f       = nullptr;
+   memory  = data;
+   len     = size;
+   idx     = 0;
+   endian  = pEndian;
+   ownFile = false;
+}
+
+//
+// Overrides BufferedFileBase::close() to let go of any memory being read.
+//
+void InBuffer::close()
+{
+   memory = nullptr;
+   BufferedFileBase::close();
+}
+
 //
 // Seeks inside the file via fseek, and then clears the internal buffer.
 //
 int InBuffer::seek(long offset, int origin)
 {
+   if(memory)
+   {
+      long base = origin == SEEK_CUR ? long(idx) : origin == SEEK_END ? long(len) : 0;
+      if(base + offset < 0 || size_t(base + offset) > len)
+         return -1;
+      idx = size_t(base + offset);
+      return 0;
+   }
+
    return fseek(f, offset, origin);
 }
 
@@ -376,6 +450,14 @@ int InBuffer::seek(long offset, int origin)
 //
 size_t InBuffer::read(void *dest, size_t size)
 {
+   if(memory)
+   {
+      size = emin(size, len - idx);
+      memcpy(dest, memory + idx, size);
+      idx += size;
+      return size;
+   }
+
    return fread(dest, 1, size, f);
 }
 
@@ -384,6 +466,9 @@ size_t InBuffer::read(void *dest, size_t size)
 //
 int InBuffer::skip(size_t skipAmt)
 {
+   if(memory)
+      return seek(static_cast<long>(skipAmt), SEEK_CUR);
+
    return fseek(f, static_cast<long>(skipAmt), SEEK_CUR);
 }
 
@@ -500,5 +585,123 @@ bool InBuffer::readSint8(int8_t &num)
    return true;
 }
 
+//=============================================================================
+//
+// Deflated files
+//
+// A file written by M_WriteDeflatedFile starts with a magic number and the
+// inflated size as a little-endian uint32, followed by a zlib stream.
+//
+
+static const byte deflatedMagic[4] = { 'E', 'E', 'Z', 'B' };
+
+static constexpr size_t DEFLATED_HEADER_SIZE = 8;
+static constexpr size_t INFLATE_BUFF_SIZE    = 16384;
+
+//
+// Deflates data into a new file. Nothing here touches the zone heap or any
+// other engine state, so it may be called from any thread. Returns false if
+// the file could not be written.
+//
+bool M_WriteDeflatedFile(const char *filename, const byte *data, size_t size)
+{
+   uLongf packedSize = compressBound(uLong(size));
+   std::unique_ptr<byte[]> packed(new byte[packedSize]);
+   byte header[DEFLATED_HEADER_SIZE];
+   FILE *outf;
+
+   // saving is waited on more often than loading
+   if(compress2(packed.get(), &packedSize, data, uLong(size), Z_BEST_SPEED) != Z_OK)
+      return false;
+
+   memcpy(header, deflatedMagic, sizeof(deflatedMagic));
+   header[4] = byte(size);
+   header[5] = byte(size >> 8);
+   header[6] = byte(size >> 16);
+   header[7] = byte(size >> 24);
+
+   if(!(outf = fopen(filename, "wb")))
+      return false;
+
+   bool written = fwrite(header, 1, sizeof(header), outf) == sizeof(header) &&
+                  fwrite(packed.get(), 1, packedSize, outf) == packedSize;
+
+   if(fclose(outf))
+      written = false;
+
+   return written;
+}
+
+//
+// Opens a file for binary input which may have been written by
+// M_WriteDeflatedFile, in which case it is inflated into memory and read from
+// there. At most maxSize bytes are inflated, for callers only after the start
+// of the file. Returns false if the file can't be opened or is corrupt.
+//
+bool InBuffer::openInflated(const char *filename, int pEndian, size_t maxSize)
+{
+   byte header[DEFLATED_HEADER_SIZE];
+
+   if(!openFile(filename, pEndian))
+      return false;
+
+   if(fread(header, 1, sizeof(header), f) != sizeof(header) ||
+      memcmp(header, deflatedMagic, sizeof(deflatedMagic)))
+   {
+      // an ordinary file
+      rewind(f);
+      return true;
+   }
+
+   const size_t fullSize = size_t(header[4])       | size_t(header[5]) << 8 |
+                           size_t(header[6]) << 16 | size_t(header[7]) << 24;
+   const size_t outSize  = emin(fullSize, maxSize);
+
+   byte     *data = emalloc(byte *, emax(outSize, size_t(1)));
+   byte      inBuffer[INFLATE_BUFF_SIZE];
+   z_stream  zlStream = {};
+   int       code;
+
+   if(inflateInit(&zlStream) != Z_OK)
+   {
+      efree(data);
+      BufferedFileBase::close();
+      return false;
+   }
+
+   zlStream.next_out  = data;
+   zlStream.avail_out = uInt(outSize);
+
+   // the file is read a piece at a time, so a short read stops early
+   do
+   {
+      if(!zlStream.avail_in)
+      {
+         zlStream.next_in  = inBuffer;
+         zlStream.avail_in = uInt(fread(inBuffer, 1, sizeof(inBuffer), f));
+         if(!zlStream.avail_in)
+            break;
+      }
+      code = inflate(&zlStream, Z_NO_FLUSH);
+   }
+   while(code == Z_OK && zlStream.avail_out);
+
+   const bool complete = !zlStream.avail_out;
+   inflateEnd(&zlStream);
+   BufferedFileBase::close();
+
+   if(!complete)
+   {
+      efree(data);
+      return false;
+   }
+
+   // the base class frees the buffer when closed
+   openMemory(data, outSize, pEndian);
+   buffer = data;
+
+   return true;
+}
+
 // EOF
 
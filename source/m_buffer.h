@@ -113,6 +113,8 @@ class OutBuffer : public BufferedFileBase
 {
 public:
    bool createFile(const char *filename, size_t pLen, int pEndian);
+   void createMemory(size_t pLen, int pEndian);
+   byte *detachMemory(size_t &size);
    bool flush();
    void close();
 
@@ -134,13 +136,19 @@ public:
 //
 class InBuffer : public BufferedFileBase
 {
+protected:
+   const byte *memory; // data read by openMemory, if not a file
+
 public:
-   InBuffer() : BufferedFileBase()
+   InBuffer() : BufferedFileBase(), memory(nullptr)
    {
    }
 
    bool openFile(const char *filename, int pEndian);
    bool openExisting(FILE *f, int pEndian);
+   void openMemory(const byte *data, size_t size, int pEndian);
+   bool openInflated(const char *filename, int pEndian, size_t maxSize = SIZE_MAX);
+   virtual void close();
 
    int    seek(long offset, int origin);
    size_t read(void *dest, size_t size);
@@ -155,6 +163,8 @@ public:
    bool   readUint8 (uint8_t  &num);
 };
 
+bool M_WriteDeflatedFile(const char *filename, const byte *data, size_t size);
+
 #endif
 
 // EOF
@@ -43,12 +43,17 @@ protected:
    size_t length;
    size_t numalloc;
    size_t wrapiterator;
+   T *inlineArray; // storage inside a derived object, never reallocated or freed
 
    BaseCollection()
-      : ZoneObject(), ptrArray(nullptr), length(0), numalloc(0), wrapiterator(0)
+      : ZoneObject(), ptrArray(nullptr), length(0), numalloc(0), wrapiterator(0),
+        inlineArray(nullptr)
    {
    }
 
+   // True if the items currently live in a derived class's inline storage
+   bool usingInline() const { return ptrArray && ptrArray == inlineArray; }
+
    //
    // Resizes the internal array by the amount provided
    //
@@ -57,7 +62,15 @@ protected:
       size_t newnumalloc = numalloc + amtToAdd;
       if(newnumalloc > numalloc)
       {
-         ptrArray = erealloc(T *, ptrArray, newnumalloc * sizeof(T));
+         if(usingInline())
+         {
+            // outgrew the inline storage; move onto the heap
+            T *heapArray = emalloc(T *, newnumalloc * sizeof(T));
+            memcpy(static_cast<void *>(heapArray), ptrArray, numalloc * sizeof(T));
+            ptrArray = heapArray;
+         }
+         else
+            ptrArray = erealloc(T *, ptrArray, newnumalloc * sizeof(T));
          memset(static_cast<void *>(ptrArray + numalloc), 0, 
                 (newnumalloc - numalloc) * sizeof(T));
          numalloc = newnumalloc;
@@ -69,7 +82,7 @@ protected:
    //
    void baseClear()
    {
-      if(ptrArray)
+      if(ptrArray && !usingInline())
          efree(ptrArray);
       ptrArray = nullptr;
       length = 0;
@@ -182,6 +195,14 @@ protected:
       if(this->ptrArray == other.ptrArray) // same object?
          return;
 
+      // inline storage can't change hands, so its contents are copied
+      if(other.usingInline())
+      {
+         this->assign(other);
+         other.length = other.wrapiterator = 0;
+         return;
+      }
+
       this->clear();
       this->ptrArray     = other.ptrArray;
       this->length       = other.length;
@@ -219,7 +240,8 @@ public:
       if(this->length > this->numalloc)
          this->baseResize(this->length - oldlength);
 
-      memcpy(this->ptrArray, other.ptrArray, this->length * sizeof(T));
+      if(this->length)
+         memcpy(this->ptrArray, other.ptrArray, this->length * sizeof(T));
    }
 
    // Copy constructor
@@ -334,6 +356,35 @@ public:
    }
 };
 
+//
+// A PODCollection with room for N items inside the object itself, so that
+// short-lived collections which rarely hold more than a few items never
+// touch the heap. Past N items it moves its contents to the heap as usual.
+// It can be passed anywhere a PODCollection is expected.
+//
+template<typename T, size_t N>
+class SmallPODCollection : public PODCollection<T>
+{
+protected:
+   T inlineStore[N];
+
+public:
+   SmallPODCollection() : PODCollection<T>()
+   {
+      this->ptrArray = this->inlineArray = inlineStore;
+      this->numalloc = N;
+   }
+
+   // the inline storage can't be shared or handed over
+   SmallPODCollection(const SmallPODCollection<T, N> &) = delete;
+   SmallPODCollection<T, N> &operator = (const SmallPODCollection<T, N> &) = delete;
+
+   //
+   // Empties the collection but keeps its storage, heap or inline, for reuse.
+   //
+   void clear() { this->length = this->wrapiterator = 0; }
+};
+
 //
 // This class can store any type of data, including objects that require 
 // constructor/destructor calls and contain virtual methods.
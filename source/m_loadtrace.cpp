@@ -0,0 +1,323 @@
+//
+// The Eternity Engine
+// Copyright(C) 2026 James Haley, Max Waine, et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+// Additional terms and conditions compatible with the GPLv3 apply. See the
+// file COPYING-EE for details.
+//
+// Purpose: Load phase timing.
+//  A session is split into consecutive phases, each lasting until the next
+//  one starts. Sessions may nest, so a level set up during startup times
+//  its own phases; the enclosing phase's time includes them. Tasks run on
+//  other threads overlap the phases, so each gets a track of its own.
+//
+
+#include <chrono>
+#include <vector>
+
+#include "z_zone.h"
+
+#include "c_io.h"
+#include "c_runcmd.h"
+#include "doomstat.h"
+#include "m_argv.h"
+#include "m_compare.h"
+#include "m_loadtrace.h"
+#include "m_qstr.h"
+#include "v_misc.h"
+#include "w_wad.h"
+
+using loadclock_t = std::chrono::steady_clock;
+
+// Most recent sessions the loadtimes command lists
+static constexpr size_t LOADTIMESHOWN = 16;
+
+struct loadphase_t
+{
+   const char *name;
+   int64_t     start, dur; // us since the first session
+   int         session;
+   int         track;      // 0 for phases, from 1 for background tasks
+};
+
+struct loadsession_t
+{
+   qstring name;
+   int64_t start, dur;
+   size_t  firstphase, endphase; // range in loadphases, ended sessions only
+   uint64_t cachedbytes, readbytes; // lump data found cached or read in
+   bool    finished;
+};
+
+static std::vector<loadsession_t> loadsessions;
+static std::vector<loadphase_t>   loadphases;
+
+// Sessions still running, innermost last, and their current phases
+static std::vector<int>    activesessions;
+static std::vector<size_t> activephases;
+
+static loadclock_t::time_point loadorigin;
+static int                     loadtasktracks; // tracks used by tasks so far
+
+static const char *loadtracefile;
+static bool        loadtracechecked;
+
+//
+// Microseconds since the first session began.
+//
+static int64_t M_loadTraceNow()
+{
+   if(loadsessions.empty())
+      loadorigin = loadclock_t::now();
+   return std::chrono::duration_cast<std::chrono::microseconds>(
+      loadclock_t::now() - loadorigin).count();
+}
+
+//
+// Finishes the innermost session's current phase, if it has one.
+//
+static void M_closeLoadPhase(int64_t now)
+{
+   size_t &phase = activephases.back();
+
+   if(phase != SIZE_MAX)
+   {
+      loadphases[phase].dur = now - loadphases[phase].start;
+      phase = SIZE_MAX;
+   }
+}
+
+//
+// Starts timing a session. Anything before its first phase is not itemized.
+//
+void M_LoadTraceBegin(const char *session)
+{
+   const int64_t now = M_loadTraceNow();
+   loadsession_t ls;
+
+   ls.name       = session;
+   ls.start      = now;
+   ls.dur        = 0;
+   ls.firstphase = loadphases.size();
+   ls.endphase   = loadphases.size();
+   ls.cachedbytes = w_cachedbytes; // made relative when the session ends
+   ls.readbytes   = w_readbytes;
+   ls.finished   = false;
+   loadsessions.push_back(ls);
+
+   activesessions.push_back(int(loadsessions.size() - 1));
+   activephases.push_back(SIZE_MAX);
+}
+
+//
+// Ends the innermost session's current phase and starts the next one. Does
+// nothing outside a session.
+//
+void M_LoadTracePhase(const char *phase)
+{
+   if(activesessions.empty())
+      return;
+
+   const int64_t now = M_loadTraceNow();
+
+   M_closeLoadPhase(now);
+   activephases.back() = loadphases.size();
+   loadphases.push_back({ phase, now, 0, activesessions.back(), 0 });
+}
+
+//
+// Adds work that ran on another thread, once it has been joined, to the
+// innermost session. Does nothing outside a session.
+//
+void M_LoadTraceTask(const char *task, loadclock_t::time_point start,
+                     loadclock_t::time_point end)
+{
+   using us_t = std::chrono::microseconds;
+
+   if(activesessions.empty())
+      return;
+
+   const int64_t taskstart = std::chrono::duration_cast<us_t>(start - loadorigin).count();
+   const int64_t taskdur   = std::chrono::duration_cast<us_t>(end - start).count();
+
+   loadphases.push_back({ task, taskstart, emax(taskdur, int64_t(1)),
+                          activesessions.back(), ++loadtasktracks });
+}
+
+//
+// Prints the total time of a session and of each phase of it that took at
+// least a millisecond, in the order they ran.
+//
+static void M_printLoadSession(const loadsession_t &ls)
+{
+   qstring line;
+
+   line.Printf(0, "%s: %d ms", ls.name.constPtr(), int(ls.dur / 1000));
+
+   bool first = true;
+   for(size_t i = ls.firstphase; i < ls.endphase; i++)
+   {
+      const loadphase_t &lp = loadphases[i];
+
+      if(&loadsessions[lp.session] != &ls || lp.dur < 1000)
+         continue;
+      line << (first ? " (" : ", ") << lp.name << ' ' << int(lp.dur / 1000);
+      if(lp.track)
+         line << " in background";
+      first = false;
+   }
+   if(!first)
+      line << ')';
+
+   if(ls.cachedbytes || ls.readbytes)
+   {
+      line << " [lumps: " << int(ls.cachedbytes / 1024) << " KB cached, "
+           << int(ls.readbytes / 1024) << " KB read]";
+   }
+
+   C_Printf("%s\n", line.constPtr());
+}
+
+//
+// Appends str to out as a JSON string.
+//
+static void M_jsonString(qstring &out, const char *str)
+{
+   out << '"';
+   for(; *str; str++)
+   {
+      if(*str == '"' || *str == '\\')
+         out << '\\' << *str;
+      else if(static_cast<unsigned char>(*str) >= ' ')
+         out << *str;
+   }
+   out << '"';
+}
+
+//
+// Formats a time in microseconds, which can outgrow an int.
+//
+static const char *M_jsonTime(int64_t us)
+{
+   static char buf[24];
+   snprintf(buf, sizeof(buf), "%lld", static_cast<long long>(us));
+   return buf;
+}
+
+//
+// Rewrites the trace file with every finished session, so that it is
+// complete whenever the engine stops.
+//
+static void M_writeLoadTrace()
+{
+   qstring json;
+   FILE   *f;
+
+   json = "{\"traceEvents\":[";
+   for(size_t i = 0; i < loadsessions.size(); i++)
+   {
+      const loadsession_t &ls = loadsessions[i];
+
+      if(!ls.finished)
+         continue;
+      json << (i ? ",\n" : "\n") << "{\"name\":";
+      M_jsonString(json, ls.name.constPtr());
+      json << ",\"cat\":\"session\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":"
+           << M_jsonTime(ls.start) << ",\"dur\":" << M_jsonTime(ls.dur) << '}';
+   }
+   for(const loadphase_t &lp : loadphases)
+   {
+      if(!lp.dur)
+         continue;
+      json << ",\n{\"name\":";
+      M_jsonString(json, lp.name);
+      json << ",\"cat\":\"" << (lp.track ? "task" : "phase")
+           << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << lp.track + 1 << ",\"ts\":"
+           << M_jsonTime(lp.start) << ",\"dur\":" << M_jsonTime(lp.dur) << ",\"args\":{\"session\":";
+      M_jsonString(json, loadsessions[lp.session].name.constPtr());
+      json << "}}";
+   }
+   json << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+   if(!(f = fopen(loadtracefile, "w")))
+   {
+      C_Printf(FC_ERROR "Couldn't open %s for load trace output\n", loadtracefile);
+      loadtracefile = nullptr;
+      return;
+   }
+   fputs(json.constPtr(), f);
+   fclose(f);
+}
+
+//
+// Ends the innermost session, printing its summary when developing or
+// tracing and updating the trace file.
+//
+void M_LoadTraceEnd()
+{
+   if(activesessions.empty())
+      return;
+
+   const int64_t now = M_loadTraceNow();
+   loadsession_t &ls = loadsessions[activesessions.back()];
+
+   M_closeLoadPhase(now);
+   ls.dur      = now - ls.start;
+   ls.endphase = loadphases.size();
+   ls.cachedbytes = w_cachedbytes - ls.cachedbytes;
+   ls.readbytes   = w_readbytes   - ls.readbytes;
+   ls.finished = true;
+   activesessions.pop_back();
+   activephases.pop_back();
+
+   if(!loadtracechecked)
+   {
+      int p;
+
+      if((p = M_CheckParm("-loadtrace")) && ++p < myargc)
+         loadtracefile = myargv[p];
+      loadtracechecked = true;
+   }
+
+   if(devparm || loadtracefile)
+      M_printLoadSession(ls);
+   if(loadtracefile && activesessions.empty())
+      M_writeLoadTrace();
+}
+
+CONSOLE_COMMAND(loadtimes, 0)
+{
+   size_t shown = 0;
+
+   for(size_t i = 0; i < loadsessions.size(); i++)
+   {
+      const loadsession_t &ls = loadsessions[i];
+
+      if(!ls.finished)
+         continue;
+      if(loadsessions.size() - i <= LOADTIMESHOWN)
+      {
+         M_printLoadSession(ls);
+         shown++;
+      }
+   }
+
+   if(!shown)
+      C_Printf("Nothing has been loaded yet.\n");
+}
+
+// EOF
+
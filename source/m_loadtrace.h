@@ -0,0 +1,56 @@
+//
+// The Eternity Engine
+// Copyright(C) 2026 James Haley, Max Waine, et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+// Additional terms and conditions compatible with the GPLv3 apply. See the
+// file COPYING-EE for details.
+//
+// Purpose: Load phase timing.
+//  Engine startup and level setup mark the start of each of their phases.
+//  Work done on other threads alongside them is added as a task once it
+//  finishes. Every finished session gets a one-line summary, and
+//  -loadtrace <file> writes all sessions out as Chrome trace-event JSON.
+//
+
+#ifndef M_LOADTRACE_H__
+#define M_LOADTRACE_H__
+
+#include <chrono>
+
+void M_LoadTraceBegin(const char *session);
+void M_LoadTracePhase(const char *phase);
+void M_LoadTraceTask(const char *task, std::chrono::steady_clock::time_point start,
+                     std::chrono::steady_clock::time_point end);
+void M_LoadTraceEnd();
+
+//
+// Times the enclosing scope as a load session, so early returns still
+// finish it. Phase names must be string literals or otherwise outlive it.
+//
+class LoadTraceSession
+{
+public:
+   explicit LoadTraceSession(const char *session) { M_LoadTraceBegin(session); }
+   ~LoadTraceSession() { M_LoadTraceEnd(); }
+
+   LoadTraceSession(const LoadTraceSession &) = delete;
+   LoadTraceSession &operator = (const LoadTraceSession &) = delete;
+};
+
+#endif
+
+// EOF
+
@@ -45,6 +45,7 @@
 #include "d_main.h"
 #include "doomstat.h"
 #include "f_wipe.h"
+#include "g_demoseek.h"
 #include "g_game.h"
 #include "hu_over.h"
 #include "hu_stuff.h"
@@ -56,15 +57,24 @@
 #include "mn_menus.h"
 #include "p_chase.h"
 #include "p_enemy.h"
+#include "p_hubs.h"
 #include "p_map.h"
+#include "p_mobj.h"
 #include "p_partcl.h"
+#include "p_setup.h"
+#include "p_tick.h"
 #include "p_user.h"
+#include "r_data.h"
 #include "r_draw.h"
+#include "r_dynres.h"
 #include "r_main.h"
+#include "r_pvs.h"
 #include "r_sky.h"
 #include "r_things.h"
+#include "r_voxels.h"
 #include "s_sound.h"
 #include "st_stuff.h"
+#include "v_patchcache.h"
 #include "v_video.h"
 
 #ifdef HAVE_ADLMIDILIB
@@ -94,6 +104,7 @@ extern int hud_msg_lines;   // number of message lines in window up to 16
 extern int hud_msg_scrollup;// killough 11/98: whether message list scrolls up
 extern int message_timer;   // killough 11/98: timer used for normal messages
 extern int show_scores;
+extern int acs_stringbudget;
 
 extern bool secret_notification_enabled;
 
@@ -113,6 +124,7 @@ extern int midi_device;
 extern int adlmidi_numchips;
 extern int adlmidi_bank;
 extern int adlmidi_emulator;
+extern int adlmidi_threads;
 
 const int BANKS_MAX = (adl_getBanksCount() - 1);
 #endif
@@ -185,6 +197,15 @@ default_t defaults[] =
    // killough 3/31/98
    DEFAULT_INT("demo_insurance", &default_demo_insurance, nullptr, 2, 0, 2, default_t::wad_no,
                "1=take special steps ensuring demo sync, 2=only during recordings"),
+
+   DEFAULT_INT("demo_snapshotinterval", &demo_snapshotinterval, nullptr, 10, 1, 600,
+               default_t::wad_no, "seconds between snapshots kept for demo seeking"),
+
+   DEFAULT_INT("demo_snapshotmemory", &demo_snapshotmemory, nullptr, 32, 1, 4096,
+               default_t::wad_no, "most memory demo seeking snapshots may use, in MB"),
+
+   DEFAULT_INT("hub_memory", &hub_memory, nullptr, 64, 0, 4096, default_t::wad_no,
+               "most memory saved hub levels may use, in MB, before going to disk"),
    
    // phares
    DEFAULT_INT("weapon_recoil", &default_weapon_recoil, &weapon_recoil, 0, 0, 1, default_t::wad_game,
@@ -278,6 +299,18 @@ default_t defaults[] =
 
    DEFAULT_BOOL("p_pitchedflight", &default_pitchedflight, &pitchedflight, true, default_t::wad_game, 
                 "1 to enable flying in the direction you are looking"),
+
+   DEFAULT_BOOL("p_autoreject", &p_autoreject, nullptr, true, default_t::wad_no,
+                "work out a sight reject table for maps that come with an empty one"),
+
+   DEFAULT_BOOL("p_groupthinkers", &p_groupthinkers, nullptr, false, default_t::wad_no,
+                "1 to run thinkers grouped by class outside of demos and netgames"),
+
+   DEFAULT_BOOL("p_aiprefetch", &p_aiprefetch, nullptr, true, default_t::wad_no,
+                "work out monster sight checks across threads at the start of a tic"),
+
+   DEFAULT_BOOL("p_dormantmonsters", &p_dormantmonsters, nullptr, false, default_t::wad_no,
+                "1 to let sleeping monsters out of every player's reach think less often"),
    
    // no color changes on status bar
    DEFAULT_INT("sts_always_red", &sts_always_red, nullptr, 1, 0, 1, default_t::wad_game,
@@ -324,6 +357,9 @@ default_t defaults[] =
    DEFAULT_INT("smooth_turning", &smooth_turning, nullptr, 0, 0, 1, default_t::wad_no,
                "average mouse input when turning player"),
 
+   DEFAULT_INT("mouse_lookahead", &mouse_lookahead, nullptr, 1, 0, 1, default_t::wad_no,
+               "turn the view by mouse movement not yet run in a tic"),
+
    DEFAULT_INT("sfx_volume", &snd_SfxVolume, nullptr, 8, 0, SND_MAXVOLUME, default_t::wad_no,
                "adjust sound effects volume"),
 
@@ -715,6 +751,9 @@ default_t defaults[] =
    
    DEFAULT_BOOL("hu_showcoords", &hu_showcoords, nullptr, true, default_t::wad_game,
                 "display player/pointer coordinates on automap"),
+
+   DEFAULT_BOOL("hu_shownetstats", &hu_shownetstats, nullptr, false, default_t::wad_no,
+                "display network statistics in netgames"),
    
    DEFAULT_INT("hu_timecolor",&hu_timecolor, nullptr, CR_RED, 0, CR_BUILTIN, default_t::wad_game,
                "color of automap level time widget"),
@@ -842,14 +881,47 @@ default_t defaults[] =
    
    DEFAULT_INT("r_columnengine",&r_column_engine_num, nullptr, 
                0, 0, NUMCOLUMNENGINES - 1, default_t::wad_no, 
-               "0 = normal"),
+               "0 = normal, 1 = quad, 2 = truecolor"),
    
    DEFAULT_INT("r_spanengine",&r_span_engine_num, nullptr,
                0, 0, NUMSPANENGINES - 1, default_t::wad_no, 
-               "0 = high precision"),
+               "0 = high precision, 1 = vectorized"),
 
    DEFAULT_INT("r_tlstyle", &r_tlstyle, nullptr, 1, 0, R_TLSTYLE_NUM - 1, default_t::wad_game,
                "Doom object translucency style (0 = none, 1 = Boom, 2 = new)"),
+
+   DEFAULT_BOOL("r_voxels", &r_drawvoxels, nullptr, true, default_t::wad_no,
+                "draw voxel models in place of sprite frames that have one"),
+
+   DEFAULT_BOOL("r_pvs", &r_pvs, nullptr, false, default_t::wad_no,
+                "build visibility sets at level load and skip BSP subtrees the view can't see"),
+
+   DEFAULT_INT("r_texturebudget", &r_texturebudget, nullptr, 0, 0, 4096, default_t::wad_no,
+               "Memory in MiB for composed textures before unused ones are freed (0 = no limit)"),
+
+   DEFAULT_BOOL("r_mipmap", &r_mipmap, nullptr, false, default_t::wad_no,
+                "draw distant walls and flats from smaller copies of their textures"),
+
+   DEFAULT_BOOL("r_spritemip", &r_spritemip, nullptr, false, default_t::wad_no,
+                "draw distant sprites from smaller copies of their frames"),
+
+   DEFAULT_INT("acs_stringbudget", &acs_stringbudget, nullptr, 16384, 0, 1 << 20, default_t::wad_no,
+               "ACS string collection work per tic (0 = never collect strings)"),
+
+   DEFAULT_BOOL("r_dynres", &r_dynres, nullptr, false, default_t::wad_no,
+                "draw the view at a lower resolution when frames run over r_dynres_fps"),
+
+   DEFAULT_INT("r_dynres_fps", &r_dynresfps, nullptr, 60, 20, 500, default_t::wad_no,
+               "Framerate that dynamic resolution aims for"),
+
+   DEFAULT_INT("r_dynres_min", &r_dynresmin, nullptr, 50, 25, 100, default_t::wad_no,
+               "Lowest dynamic resolution, as a percentage of the view size"),
+
+   DEFAULT_INT("v_patchcache", &v_patchcache, nullptr, 4, 0, 256, default_t::wad_no,
+               "Memory in MiB for keeping PNG lumps converted to patches (0 = none)"),
+
+   DEFAULT_BOOL("v_patchdiskcache", &v_patchdiskcache, nullptr, false, default_t::wad_no,
+                "keep PNG lumps converted to patches in the user cache directory"),
    
    DEFAULT_INT("spechits_emulation", &spechits_emulation, nullptr, 0, 0, 2, default_t::wad_no,
                "0 = off, 1 = emulate like Chocolate Doom, 2 = emulate like PrBoom+"),
@@ -879,9 +951,12 @@ default_t defaults[] =
    DEFAULT_INT("snd_oplemulator", &adlmidi_emulator, nullptr, ADLMIDI_EMU_DOSBOX, 0, ADLMIDI_EMU_end - 1, default_t::wad_no,
                "OPL3 emulator used for ADLMIDI"),
 
-   DEFAULT_INT("snd_numchips", &adlmidi_numchips, nullptr, 2, 1, 8, default_t::wad_startup,
+   DEFAULT_INT("snd_numchips", &adlmidi_numchips, nullptr, 2, 1, 16, default_t::wad_startup,
                "OPL3 chips to emulate for ADLMIDI"),
 
+   DEFAULT_INT("snd_oplthreads", &adlmidi_threads, nullptr, 1, 1, 8, default_t::wad_startup,
+               "threads to split ADLMIDI's OPL3 chips between (1 = no splitting)"),
+
    DEFAULT_INT("snd_bank", &adlmidi_bank, nullptr, 72, 0, BANKS_MAX, default_t::wad_startup,
                "sound bank used for ADLMIDI"),
 #endif
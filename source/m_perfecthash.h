@@ -0,0 +1,206 @@
+//
+// The Eternity Engine
+// Copyright(C) 2026 James Haley, Max Waine, et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+// Additional terms and conditions compatible with the GPLv3 apply. See the
+// file COPYING-EE for details.
+//
+// Purpose: Perfect hashing of fixed keyword tables, built at compile time.
+//  MPerfectHash takes a constexpr array of items with a string key and
+//  works out, while compiling, where each key goes in a table with no
+//  collisions. A lookup is then one pass over the string to hash it, one
+//  table read and one string compare. Keys are matched case-insensitively.
+//
+
+#ifndef M_PERFECTHASH_H__
+#define M_PERFECTHASH_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+//
+// Hash-and-displace: each key falls in a bucket by its hash, and each bucket
+// gets a displacement which, mixed into the hashes of its keys, sends them
+// all to free slots. Buckets are placed largest first, while the table is
+// emptiest. With twice as many slots as keys this finishes quickly; a table
+// of a few hundred keys stays well inside compilers' default constexpr
+// evaluation limits.
+//
+template<size_t N>
+class MPerfectHash
+{
+   static_assert(N > 0 && N < 32768, "MPerfectHash: bad number of keys");
+
+   static constexpr size_t Pow2AtLeast(size_t n)
+   {
+      size_t p = 1;
+      while(p < n)
+         p <<= 1;
+      return p;
+   }
+
+public:
+   static constexpr size_t NUMSLOTS   = Pow2AtLeast(N * 2);
+   static constexpr size_t NUMBUCKETS = Pow2AtLeast((N + 1) / 2);
+
+   //
+   // Case-insensitive FNV-1a.
+   //
+   static constexpr uint32_t HashKey(const char *key)
+   {
+      uint32_t hash = 2166136261u;
+      for(; *key; key++)
+      {
+         char c = *key;
+         if(c >= 'A' && c <= 'Z')
+            c += 'a' - 'A';
+         hash = (hash ^ uint8_t(c)) * 16777619u;
+      }
+      return hash;
+   }
+
+   //
+   // Builds the table for the key member of every item.
+   //
+   template<typename T>
+   constexpr MPerfectHash(const T (&items)[N], const char *const T::*key)
+      : keys(), displacement(), slots()
+   {
+      uint32_t hashes[N] = {};
+      size_t   bucketstart[NUMBUCKETS + 1] = {};
+      size_t   bucketkeys[N] = {};          // key indices, grouped by bucket
+      size_t   order[NUMBUCKETS] = {};
+
+      for(size_t i = 0; i < N; i++)
+      {
+         keys[i]   = items[i].*key;
+         hashes[i] = HashKey(keys[i]);
+         ++bucketstart[BucketFor(hashes[i]) + 1];
+      }
+      for(size_t b = 0; b < NUMBUCKETS; b++)
+         bucketstart[b + 1] += bucketstart[b];
+      {
+         size_t fill[NUMBUCKETS] = {};
+         for(size_t i = 0; i < N; i++)
+         {
+            const size_t b = BucketFor(hashes[i]);
+            bucketkeys[bucketstart[b] + fill[b]++] = i;
+         }
+      }
+
+      for(size_t i = 0; i < NUMSLOTS; i++)
+         slots[i] = -1;
+
+      // largest buckets first
+      {
+         size_t maxsize = 0, numordered = 0;
+         for(size_t b = 0; b < NUMBUCKETS; b++)
+         {
+            if(BucketSize(bucketstart, b) > maxsize)
+               maxsize = BucketSize(bucketstart, b);
+         }
+         for(size_t size = maxsize; size > 0; size--)
+         {
+            for(size_t b = 0; b < NUMBUCKETS; b++)
+            {
+               if(BucketSize(bucketstart, b) == size)
+                  order[numordered++] = b;
+            }
+         }
+      }
+
+      for(size_t b = 0; b < NUMBUCKETS && BucketSize(bucketstart, order[b]); b++)
+      {
+         const size_t bucket = order[b];
+         const size_t first  = bucketstart[bucket];
+         const size_t last   = bucketstart[bucket + 1];
+
+         for(uint32_t d = 1; ; d++)
+         {
+            // a duplicate key can never be placed; stop compilation instead
+            // of searching forever
+            if(d > 1000000)
+               throw "MPerfectHash: duplicate key";
+
+            size_t placed = first;
+            for(; placed < last; placed++)
+            {
+               const size_t slot = SlotFor(hashes[bucketkeys[placed]], d);
+               if(slots[slot] != -1)
+                  break;
+               slots[slot] = int16_t(bucketkeys[placed]);
+            }
+
+            if(placed == last)
+            {
+               displacement[bucket] = d;
+               break;
+            }
+
+            // take back the keys placed on this try
+            while(placed-- > first)
+               slots[SlotFor(hashes[bucketkeys[placed]], d)] = -1;
+         }
+      }
+   }
+
+   //
+   // Returns the index of the item with the key, or -1 if there is none.
+   //
+   int find(const char *key) const
+   {
+      const uint32_t hash  = HashKey(key);
+      const int      index = slots[SlotFor(hash, displacement[BucketFor(hash)])];
+
+      return index >= 0 && !strcasecmp(keys[index], key) ? index : -1;
+   }
+
+private:
+   const char *keys[N];
+   uint32_t    displacement[NUMBUCKETS];
+   int16_t     slots[NUMSLOTS];
+
+   static constexpr uint32_t Mix(uint32_t h)
+   {
+      h ^= h >> 16;
+      h *= 0x85ebca6bu;
+      h ^= h >> 13;
+      h *= 0xc2b2ae35u;
+      h ^= h >> 16;
+      return h;
+   }
+
+   static constexpr size_t BucketSize(const size_t (&bucketstart)[NUMBUCKETS + 1],
+                                      size_t bucket)
+   {
+      return bucketstart[bucket + 1] - bucketstart[bucket];
+   }
+
+   static constexpr size_t BucketFor(uint32_t hash)
+   {
+      return Mix(hash) & (NUMBUCKETS - 1);
+   }
+
+   static constexpr size_t SlotFor(uint32_t hash, uint32_t d)
+   {
+      return Mix(hash + d * 0x9E3779B9u) & (NUMSLOTS - 1);
+   }
+};
+
+#endif
+
+// EOF
+
@@ -0,0 +1,366 @@
+//
+// The Eternity Engine
+// Copyright(C) 2026 James Haley, Max Waine, et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+// Additional terms and conditions compatible with the GPLv3 apply. See the
+// file COPYING-EE for details.
+//
+// Purpose: Registry of named performance statistics.
+//  Nothing is gathered here but the frame time; the rest belongs to the
+//  modules that declare them. The export is timed by the main loop, so a
+//  server that is only running tics still writes its log.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <time.h>
+#include <vector>
+
+#include "z_zone.h"
+
+#include "c_io.h"
+#include "c_runcmd.h"
+#include "doomstat.h"
+#include "e_fonts.h"
+#include "m_argv.h"
+#include "m_compare.h"
+#include "m_perfstats.h"
+#include "m_qstr.h"
+#include "v_font.h"
+#include "v_misc.h"
+
+DLListItem<PerfStat> *PerfStat::stats;
+
+static bool  stats_hud;
+static char *stats_hudfilter;
+
+int stats_interval = 10; // seconds between lines of the -statsfile log
+
+static const char *statsfile;
+static bool        statsfilechecked;
+
+using statsclock_t = std::chrono::steady_clock;
+
+static statsclock_t::time_point statsstart = statsclock_t::now();
+static statsclock_t::time_point lastframe;
+static statsclock_t::time_point lastexport;
+
+static PerfHistogram framestat("frame.time", "ms");
+
+//=============================================================================
+//
+// Statistic Kinds
+//
+
+//
+// Appends the units, if there are any, after a value.
+//
+static void M_appendUnits(qstring &out, const char *units)
+{
+   if(*units)
+      out << ' ' << units;
+}
+
+void PerfCounter::describe(qstring &out) const
+{
+   char buf[24];
+
+   snprintf(buf, sizeof(buf), "%llu", static_cast<unsigned long long>(value()));
+   out << buf;
+   M_appendUnits(out, units);
+}
+
+void PerfCounter::writeJSON(qstring &out) const
+{
+   char buf[24];
+
+   snprintf(buf, sizeof(buf), "%llu", static_cast<unsigned long long>(value()));
+   out << buf;
+}
+
+void PerfGauge::describe(qstring &out) const
+{
+   char buf[32];
+
+   snprintf(buf, sizeof(buf), "%g", value());
+   out << buf;
+   M_appendUnits(out, units);
+}
+
+void PerfGauge::writeJSON(qstring &out) const
+{
+   char buf[32];
+
+   snprintf(buf, sizeof(buf), "%.6g", value());
+   out << buf;
+}
+
+//
+// Adds a sample. Lock-free; figures read during a record may be a sample
+// apart, which is of no matter.
+//
+void PerfHistogram::record(double v)
+{
+   int exponent = FIRSTBUCKET;
+
+   if(v > 0)
+      frexp(v, &exponent);
+
+   const int bucket = eclamp(exponent - FIRSTBUCKET, 0, NUMBUCKETS - 1);
+
+   buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+   samples.fetch_add(1, std::memory_order_relaxed);
+
+   double old = sum.load(std::memory_order_relaxed);
+   while(!sum.compare_exchange_weak(old, old + v, std::memory_order_relaxed));
+
+   old = maximum.load(std::memory_order_relaxed);
+   while(old < v && !maximum.compare_exchange_weak(old, v, std::memory_order_relaxed));
+}
+
+//
+// The top of the bucket holding the given fraction of the samples, or the
+// largest sample if that is lower.
+//
+double PerfHistogram::percentile(double fraction) const
+{
+   const uint64_t count  = samples.load(std::memory_order_relaxed);
+   const uint64_t rank   = uint64_t(ceil(count * fraction));
+   const double   maxval = maximum.load(std::memory_order_relaxed);
+   uint64_t       seen   = 0;
+
+   if(!count)
+      return 0.0;
+
+   for(int i = 0; i < NUMBUCKETS; i++)
+   {
+      seen += buckets[i].load(std::memory_order_relaxed);
+      if(seen >= rank)
+         return emin(ldexp(1.0, FIRSTBUCKET + i), maxval);
+   }
+
+   return maxval;
+}
+
+void PerfHistogram::describe(qstring &out) const
+{
+   const uint64_t count = samples.load(std::memory_order_relaxed);
+   char           buf[128];
+
+   snprintf(buf, sizeof(buf), "n %llu, mean %.3g, p50 %.3g, p95 %.3g, max %.3g",
+            static_cast<unsigned long long>(count),
+            count ? sum.load(std::memory_order_relaxed) / count : 0.0,
+            percentile(0.50), percentile(0.95),
+            maximum.load(std::memory_order_relaxed));
+   out << buf;
+   M_appendUnits(out, units);
+}
+
+void PerfHistogram::writeJSON(qstring &out) const
+{
+   const uint64_t count = samples.load(std::memory_order_relaxed);
+   char           buf[192];
+
+   snprintf(buf, sizeof(buf),
+            "{\"count\":%llu,\"mean\":%.6g,\"p50\":%.6g,\"p95\":%.6g,\"p99\":%.6g,"
+            "\"max\":%.6g}",
+            static_cast<unsigned long long>(count),
+            count ? sum.load(std::memory_order_relaxed) / count : 0.0,
+            percentile(0.50), percentile(0.95), percentile(0.99),
+            maximum.load(std::memory_order_relaxed));
+   out << buf;
+}
+
+void PerfHistogram::reset()
+{
+   for(auto &bucket : buckets)
+      bucket.store(0, std::memory_order_relaxed);
+   samples.store(0, std::memory_order_relaxed);
+   sum.store(0.0, std::memory_order_relaxed);
+   maximum.store(0.0, std::memory_order_relaxed);
+}
+
+//=============================================================================
+//
+// Listing and Export
+//
+
+//
+// Every statistic whose name starts with prefix, in order of name.
+//
+static void M_sortedStats(std::vector<PerfStat *> &list, const char *prefix)
+{
+   const size_t len = prefix ? strlen(prefix) : 0;
+
+   for(DLListItem<PerfStat> *item = PerfStat::GetStats(); item; item = item->dllNext)
+   {
+      if(!len || !strncasecmp(item->dllObject->getName(), prefix, len))
+         list.push_back(item->dllObject);
+   }
+
+   std::sort(list.begin(), list.end(), [](const PerfStat *a, const PerfStat *b) {
+      return strcmp(a->getName(), b->getName()) < 0;
+   });
+}
+
+//
+// Appends every statistic to the -statsfile log as one line of JSON.
+//
+static void M_writeStats()
+{
+   using seconds_t = std::chrono::duration<double>;
+
+   std::vector<PerfStat *> list;
+   qstring                 json;
+   char                    buf[64];
+   FILE                   *f;
+
+   M_sortedStats(list, nullptr);
+
+   snprintf(buf, sizeof(buf), "{\"time\":%lld,\"uptime\":%.3f,",
+            static_cast<long long>(time(nullptr)),
+            seconds_t(statsclock_t::now() - statsstart).count());
+   json << buf << "\"gametic\":" << gametic << ",\"stats\":{";
+   for(size_t i = 0; i < list.size(); i++)
+   {
+      json << (i ? "," : "") << '"' << list[i]->getName() << "\":";
+      list[i]->writeJSON(json);
+   }
+   json << "}}\n";
+
+   if(!(f = fopen(statsfile, "a")))
+   {
+      C_Printf(FC_ERROR "Couldn't open %s for stats output\n", statsfile);
+      statsfile = nullptr;
+      return;
+   }
+   fputs(json.constPtr(), f);
+   fclose(f);
+}
+
+//
+// Called once per pass of the main loop. Times the frame, and writes the
+// log when stats_interval has gone by.
+//
+void M_PerfStatsTicker()
+{
+   using ms_t = std::chrono::duration<double, std::milli>;
+
+   const statsclock_t::time_point now = statsclock_t::now();
+
+   if(lastframe != statsclock_t::time_point())
+      framestat.record(ms_t(now - lastframe).count());
+   lastframe = now;
+
+   if(!statsfilechecked)
+   {
+      int p;
+
+      if((p = M_CheckParm("-statsfile")) && ++p < myargc)
+         statsfile = myargv[p];
+      statsfilechecked = true;
+      lastexport = now;
+   }
+
+   if(statsfile && stats_interval &&
+      now - lastexport >= std::chrono::seconds(stats_interval))
+   {
+      lastexport = now;
+      M_writeStats();
+   }
+}
+
+//
+// Draws the statistics over the game view while stats_hud is on.
+//
+void M_PerfStatsDrawer()
+{
+   if(!stats_hud)
+      return;
+
+   std::vector<PerfStat *> list;
+   qstring                 msg;
+
+   M_sortedStats(list, stats_hudfilter);
+   for(const PerfStat *stat : list)
+   {
+      msg << stat->getName() << ": ";
+      stat->describe(msg);
+      msg << '\n';
+   }
+   V_FontWriteText(E_FontForName("ee_smallfont"), msg.constPtr(), 5, 40);
+}
+
+VARIABLE_TOGGLE(stats_hud, nullptr, onoff);
+CONSOLE_VARIABLE(stats_hud, stats_hud, 0) {}
+
+VARIABLE_STRING(stats_hudfilter, nullptr, 32);
+CONSOLE_VARIABLE(stats_hudfilter, stats_hudfilter, 0) {}
+
+VARIABLE_INT(stats_interval, nullptr, 0, 3600, nullptr);
+CONSOLE_VARIABLE(stats_interval, stats_interval, 0) {}
+
+//
+// stats [reset | export | <prefix>]
+// Lists the statistics, or those whose names start with prefix. reset
+// zeroes those that keep their own figures, and export writes the log now.
+//
+CONSOLE_COMMAND(stats, 0)
+{
+   const char *prefix = nullptr;
+
+   if(Console.argc >= 1)
+   {
+      if(!Console.argv[0]->strCaseCmp("reset"))
+      {
+         for(DLListItem<PerfStat> *item = PerfStat::GetStats(); item; item = item->dllNext)
+            item->dllObject->reset();
+         C_Printf("Statistics reset.\n");
+         return;
+      }
+      if(!Console.argv[0]->strCaseCmp("export"))
+      {
+         if(statsfile)
+            M_writeStats();
+         else
+            C_Printf("No -statsfile to export to.\n");
+         return;
+      }
+      prefix = Console.argv[0]->constPtr();
+   }
+
+   std::vector<PerfStat *> list;
+
+   M_sortedStats(list, prefix);
+   if(list.empty())
+   {
+      C_Printf("No statistics match.\n");
+      return;
+   }
+
+   // one at a time, to stay within what C_Printf can format
+   for(const PerfStat *stat : list)
+   {
+      qstring msg;
+
+      stat->describe(msg);
+      C_Printf("%-24s %s\n", stat->getName(), msg.constPtr());
+   }
+}
+
+// EOF
+
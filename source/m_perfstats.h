@@ -0,0 +1,179 @@
+//
+// The Eternity Engine
+// Copyright(C) 2026 James Haley, Max Waine, et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+// Additional terms and conditions compatible with the GPLv3 apply. See the
+// file COPYING-EE for details.
+//
+// Purpose: Registry of named performance statistics.
+//  Any module can declare a counter, gauge or histogram at file scope, and
+//  it is listed by the stats console command, drawn by stats_hud, and
+//  written to the -statsfile log every stats_interval seconds as one JSON
+//  object per line. Counters and gauges may instead be given a function
+//  that reads a figure the module already keeps.
+//
+
+#ifndef M_PERFSTATS_H__
+#define M_PERFSTATS_H__
+
+#include <atomic>
+#include <stdint.h>
+
+#include "m_dllist.h"
+
+class qstring;
+
+//
+// Base class of all statistics. An instance adds itself to the registry
+// when constructed, like console commands, so it must live as long as the
+// program does.
+//
+class PerfStat
+{
+public:
+   enum kind_e
+   {
+      COUNTER,   // a running total, only ever going up
+      GAUGE,     // a figure as it stands now
+      HISTOGRAM, // the spread of many measured values
+   };
+
+   using reader_t = double (*)();
+
+protected:
+   DLListItem<PerfStat> links;
+   const char *name;
+   const char *units; // shown after the value; may be empty
+   kind_e      kind;
+
+   static DLListItem<PerfStat> *stats;
+
+   PerfStat(const char *pName, const char *pUnits, kind_e pKind)
+      : links(), name(pName), units(pUnits), kind(pKind)
+   {
+      links.insert(this, &stats);
+   }
+
+public:
+   const char *getName()  const { return name;  }
+   const char *getUnits() const { return units; }
+   kind_e      getKind()  const { return kind;  }
+
+   // Short text of the value, for the console and HUD
+   virtual void describe(qstring &out) const = 0;
+   // The value as JSON
+   virtual void writeJSON(qstring &out) const = 0;
+   // Starts over from nothing, if the statistic owns its figures
+   virtual void reset() {}
+
+   static DLListItem<PerfStat> *GetStats() { return stats; }
+};
+
+//
+// A running total. add may be called from any thread.
+//
+class PerfCounter : public PerfStat
+{
+protected:
+   std::atomic<uint64_t> count;
+   reader_t              reader;
+
+public:
+   PerfCounter(const char *pName, const char *pUnits, reader_t pReader = nullptr)
+      : PerfStat(pName, pUnits, COUNTER), count(0), reader(pReader)
+   {
+   }
+
+   void add(uint64_t n = 1) { count.fetch_add(n, std::memory_order_relaxed); }
+
+   uint64_t value() const
+   {
+      return reader ? uint64_t(reader()) : count.load(std::memory_order_relaxed);
+   }
+
+   virtual void describe(qstring &out) const override;
+   virtual void writeJSON(qstring &out) const override;
+   virtual void reset() override { count.store(0, std::memory_order_relaxed); }
+};
+
+//
+// A figure as it stands now. set may be called from any thread.
+//
+class PerfGauge : public PerfStat
+{
+protected:
+   std::atomic<double> current;
+   reader_t            reader;
+
+public:
+   PerfGauge(const char *pName, const char *pUnits, reader_t pReader = nullptr)
+      : PerfStat(pName, pUnits, GAUGE), current(0.0), reader(pReader)
+   {
+   }
+
+   void set(double v) { current.store(v, std::memory_order_relaxed); }
+
+   double value() const
+   {
+      return reader ? reader() : current.load(std::memory_order_relaxed);
+   }
+
+   virtual void describe(qstring &out) const override;
+   virtual void writeJSON(qstring &out) const override;
+};
+
+//
+// The spread of measured values, in buckets a power of two wide from 1/256
+// up, so percentiles come out within a factor of two. record may be called
+// from any thread.
+//
+class PerfHistogram : public PerfStat
+{
+public:
+   static constexpr int NUMBUCKETS  = 40;
+   static constexpr int FIRSTBUCKET = -8; // log2 of the first bucket's top
+
+protected:
+   std::atomic<uint64_t> buckets[NUMBUCKETS];
+   std::atomic<uint64_t> samples;
+   std::atomic<double>   sum;
+   std::atomic<double>   maximum;
+
+   double percentile(double fraction) const;
+
+public:
+   PerfHistogram(const char *pName, const char *pUnits)
+      : PerfStat(pName, pUnits, HISTOGRAM), buckets(), samples(0), sum(0.0),
+        maximum(0.0)
+   {
+   }
+
+   void record(double v);
+
+   virtual void describe(qstring &out) const override;
+   virtual void writeJSON(qstring &out) const override;
+   virtual void reset() override;
+};
+
+extern int stats_interval;
+
+void M_PerfStatsTicker();
+void M_PerfStatsDrawer();
+
+#endif
+
+// EOF
+
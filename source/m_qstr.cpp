@@ -366,6 +366,26 @@ qstring &qstring::concat(const char *str)
    return *this;
 }
 
+//
+// qstring::concat
+//
+// Concatenates count characters of str, which must not contain a \0 among
+// them, in one copy. For callers that already know where a run ends.
+//
+qstring &qstring::concat(const char *str, size_t count)
+{
+   size_t newsize = index + count + 1;
+
+   if(newsize > size)
+      grow(newsize - size);
+
+   memcpy(buffer + index, str, count);
+   index += count;
+   buffer[index] = '\0';
+
+   return *this;
+}
+
 //
 // qstring::concat
 //
@@ -151,6 +151,7 @@ public:
    qstring &Putc(char ch);
    qstring &Delc();
    qstring &concat(const char *str);
+   qstring &concat(const char *str, size_t count);
    qstring &concat(const qstring &src);
    qstring &insert(const char *insertstr, size_t pos);
 
@@ -29,6 +29,8 @@
 //
 //-----------------------------------------------------------------------------
 
+#include <atomic>
+
 #include "z_zone.h"
 #include "d_gi.h"
 #include "doomstat.h"
@@ -234,6 +236,30 @@ void M_ClearRandom()
    rng.prndindex = rng.rndindex = 0;     // clear two compatibility indices
 }
 
+//
+// Seeds each thread's effect stream differently, with splitmix64 over a
+// shared counter. xoshiro's state must never be all zero.
+//
+effectrng_t::effectrng_t()
+{
+   static std::atomic<uint64_t> streams;
+   uint64_t x = streams.fetch_add(1) * 0x9E3779B97F4A7C15ull + rngseed;
+
+   for(int i = 0; i < 4; i += 2)
+   {
+      uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+      z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+      z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+      z ^= z >> 31;
+      s[i]     = uint32_t(z);
+      s[i + 1] = uint32_t(z >> 32);
+   }
+   if(!(s[0] | s[1] | s[2] | s[3]))
+      s[0] = 1;
+}
+
+thread_local effectrng_t effectrng;
+
 // [XA] Common random formulas used by codepointers
 
 // Outputs a random angle between (-spread, spread), as an int ('cause it can be negative).
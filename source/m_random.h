@@ -304,6 +304,49 @@ int P_SubRandomEx(pr_class_t pr_class, unsigned max);
 // Fix randoms for demos.
 void M_ClearRandom(void);
 
+//
+// Cosmetic random numbers, for particles and other effects the game never
+// reads back. Each thread has its own xoshiro128** stream outside the rng
+// state, so effects neither disturb demo sync nor tie themselves to one
+// thread. Never use these for anything the play simulation depends on.
+//
+struct effectrng_t
+{
+   uint32_t s[4];
+
+   effectrng_t();
+
+   uint32_t next()
+   {
+      const uint32_t result = rotl(s[1] * 5, 7) * 9;
+      const uint32_t t = s[1] << 9;
+
+      s[2] ^= s[0];
+      s[3] ^= s[1];
+      s[1] ^= s[2];
+      s[0] ^= s[3];
+      s[2] ^= t;
+      s[3] = rotl(s[3], 11);
+      return result;
+   }
+
+private:
+   static uint32_t rotl(uint32_t x, int k) { return (x << k) | (x >> (32 - k)); }
+};
+
+extern thread_local effectrng_t effectrng;
+
+// Returns a number from 0 to 255, as M_Random does
+inline int M_EffectRandom()
+{
+   return int(effectrng.next() >> 24);
+}
+
+inline int M_EffectRangeRandom(int min, int max)
+{
+   return M_EffectRandom() % (max - min + 1) + min;
+}
+
 // [XA] Common random formulas used by codepointers
 int P_RandomHitscanAngle(pr_class_t pr_class, fixed_t spread);
 int P_RandomHitscanSlope(pr_class_t pr_class, fixed_t spread);
@@ -23,14 +23,24 @@
 //
 //-----------------------------------------------------------------------------
 
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 #include "z_zone.h"
 
 #include "autopalette.h"
 #include "c_io.h"
+#include "c_runcmd.h"
 #include "d_gi.h"
 #include "d_io.h"
 #include "doomstat.h"
 #include "m_buffer.h"
+#include "m_collection.h"
+#include "m_compare.h"
 #include "m_qstr.h"
 #include "m_utils.h"
 #include "p_skin.h"
@@ -97,9 +107,7 @@ struct pcx_t
 static bool pcx_Writer(OutBuffer *ob, byte *data, 
                        uint32_t width, uint32_t height, byte *palette)
 {
-   unsigned int i;
-   pcx_t   pcx;
-   byte    temppal[768], *palptr;
+   pcx_t pcx;
 
    // Setup PCX Header
    // haleyjd 09/27/07: Changed pcx.palette_type from 2 to 1.
@@ -159,22 +167,7 @@ static bool pcx_Writer(OutBuffer *ob, byte *data,
 
    // Write the palette   
    SafeWrite8(ob, 0x0c); // palette ID byte
-
-   // haleyjd 11/16/04: make gamma correction optional
-   if(screenshot_gamma)
-   {
-      for(i = 0; i < 768; i += 3)
-      {
-         temppal[i+0] = gammatable[usegamma][palette[i+0]]; // killough
-         temppal[i+1] = gammatable[usegamma][palette[i+1]];
-         temppal[i+2] = gammatable[usegamma][palette[i+2]];
-      }
-      palptr = temppal;
-   }
-   else
-      palptr = palette;
-
-   SafeWrite(ob, palptr, 768);
+   SafeWrite(ob, palette, 768);
      
    // Done!
    return true;
@@ -275,27 +268,13 @@ static bool bmp_Writer(OutBuffer *ob, byte *data,
    SafeWrite32(ob, bmih.biClrUsed);
    SafeWrite32(ob, bmih.biClrImportant);
 
-   // haleyjd 11/16/04: make gamma correction optional
-   if(screenshot_gamma)
-   {
-      // write the palette, in blue-green-red order, gamma corrected
-      for(i = j = 0; i < 768; i += 3, j += 4)
-      {
-         temppal[j+0] = gammatable[usegamma][palette[i+2]];
-         temppal[j+1] = gammatable[usegamma][palette[i+1]];
-         temppal[j+2] = gammatable[usegamma][palette[i+0]];
-         temppal[j+3] = 0;
-      }
-   }
-   else
+   // write the palette, in blue-green-red order
+   for(i = j = 0; i < 768; i += 3, j += 4)
    {
-      for(i = j = 0; i < 768; i += 3, j += 4)
-      {
-         temppal[j+0] = palette[i+2];
-         temppal[j+1] = palette[i+1];
-         temppal[j+2] = palette[i+0];
-         temppal[j+3] = 0;
-      }
+      temppal[j+0] = palette[i+2];
+      temppal[j+1] = palette[i+1];
+      temppal[j+2] = palette[i+0];
+      temppal[j+3] = 0;
    }
    SafeWrite(ob, temppal, 1024);
 
@@ -372,23 +351,11 @@ static bool tga_Writer(OutBuffer *ob, byte *data,
    SafeWrite8( ob, tga.imagedescriptor);
 
    // Write colormap
-   if(screenshot_gamma)
-   {
-      for(i = 0; i < 768; i += 3)
-      {
-         temppal[i+0] = gammatable[usegamma][palette[i+2]];
-         temppal[i+1] = gammatable[usegamma][palette[i+1]];
-         temppal[i+2] = gammatable[usegamma][palette[i+0]];
-      }
-   }
-   else
+   for(i = 0; i < 768; i += 3)
    {
-      for(i = 0; i < 768; i += 3)
-      {
-         temppal[i+0] = palette[i+2];
-         temppal[i+1] = palette[i+1];
-         temppal[i+2] = palette[i+0];
-      }
+      temppal[i+0] = palette[i+2];
+      temppal[i+1] = palette[i+1];
+      temppal[i+2] = palette[i+0];
    }
    SafeWrite(ob, temppal, 768);
 
@@ -415,6 +382,10 @@ struct pngiodata_t
    bool       writeOK; // Tracks if a write error has occurred.
 };
 
+// libpng's complaints, kept for the game thread to print since the writer
+// runs on a worker
+static thread_local char pngmessage[128];
+
 //
 // PNG_dataWrite
 //
@@ -444,7 +415,7 @@ static void PNG_dataFlush(png_structp png_ptr)
 //
 static void PNG_handleError(png_structp png_ptr, png_const_charp error_msg)
 {
-   C_Printf(FC_ERROR "libpng error: %s\a", error_msg);
+   psnprintf(pngmessage, sizeof(pngmessage), "libpng error: %s", error_msg);
 
    throw 0;
 }
@@ -456,7 +427,8 @@ static void PNG_handleError(png_structp png_ptr, png_const_charp error_msg)
 //
 static void PNG_handleWarning(png_structp png_ptr, png_const_charp error_msg)
 {
-   C_Printf(FC_ERROR "libpng warning: %s", error_msg);
+   if(!pngmessage[0])
+      psnprintf(pngmessage, sizeof(pngmessage), "libpng warning: %s", error_msg);
 }
 
 //
@@ -472,13 +444,14 @@ static bool png_Writer(OutBuffer *ob, byte *data,
 {
    png_structp pngStruct;
    png_infop   pngInfo;
-   png_colorp  pngPalette;
+   png_color   pngPalette[256];
    pngiodata_t pngIoData;
 
    pngIoData.ob      = ob;
    pngIoData.writeOK = true;
 
-   byte *row_pointer;
+   // not from the zone heap, which only the game thread may use
+   std::unique_ptr<byte[]> row_pointer(new byte[width]);
 
    // setup png structure pointer
    if(!(pngStruct = png_create_write_struct(PNG_LIBPNG_VER_STRING, &pngIoData, 
@@ -493,9 +466,6 @@ static bool png_Writer(OutBuffer *ob, byte *data,
       png_destroy_write_struct(&pngStruct, nullptr);
       return false;
    }
-   
-   row_pointer = ecalloc(byte *, width, sizeof(byte));
-   pngPalette  = ecalloc(png_colorp, 256, sizeof(png_color));
 
    try
    {
@@ -508,23 +478,11 @@ static bool png_Writer(OutBuffer *ob, byte *data,
                    PNG_FILTER_TYPE_DEFAULT);      
 
       // setup palette
-      if(screenshot_gamma)
-      {
-         for(int i = 0; i < 256; i++)
-         {
-            pngPalette[i].red   = gammatable[usegamma][palette[i*3+0]];
-            pngPalette[i].green = gammatable[usegamma][palette[i*3+1]];
-            pngPalette[i].blue  = gammatable[usegamma][palette[i*3+2]];
-         }
-      }
-      else
+      for(int i = 0; i < 256; i++)
       {
-         for(int i = 0; i < 256; i++)
-         {
-            pngPalette[i].red   = palette[i*3+0];
-            pngPalette[i].green = palette[i*3+1];
-            pngPalette[i].blue  = palette[i*3+2];
-         }
+         pngPalette[i].red   = palette[i*3+0];
+         pngPalette[i].green = palette[i*3+1];
+         pngPalette[i].blue  = palette[i*3+2];
       }
       // add palette to png
       png_set_PLTE(pngStruct, pngInfo, pngPalette, 256);
@@ -543,7 +501,7 @@ static bool png_Writer(OutBuffer *ob, byte *data,
             row_pointer[x] = data[((height * x) + y)];
 
          // copy data over
-         png_write_row(pngStruct, row_pointer);
+         png_write_row(pngStruct, row_pointer.get());
       }
 
       // end
@@ -556,8 +514,6 @@ static bool png_Writer(OutBuffer *ob, byte *data,
    
    // cleanup
    png_destroy_write_struct(&pngStruct, &pngInfo);
-   efree(row_pointer);
-   efree(pngPalette);
 
    return pngIoData.writeOK;
 }
@@ -593,6 +549,300 @@ static shotformat_t shotFormats[SHOT_NUMSHOTFORMATS] =
    { "png", OutBuffer::NENDIAN, png_Writer }, // Portable Network Graphics
 };
 
+//
+// Screenshots are copied off the screen on the game thread and encoded by a
+// small pool of worker threads. Opening and closing the file and everything
+// else that touches the zone heap stays on the game thread; the workers only
+// run the writer, which is given the palette with any gamma correction
+// already applied. Finished shots are reported by M_ScreenShotTicker.
+//
+
+static constexpr int MAXSHOTWORKERS = 4;
+
+struct shotjob_t
+{
+   OutBuffer    ob;
+   qstring      filename;
+   ShotWriter_t writer;
+   byte        *data;          // copy of the screen, from the buffer pool
+   size_t       size;
+   uint32_t     width;
+   uint32_t     height;
+   byte         palette[768];
+   int          capture;       // number of the frame capture, or -1
+   bool         done;          // set by the worker, under shotlock
+   bool         success;
+   int          error;         // errno after a failed write
+   char         message[128];  // anything libpng had to say
+};
+
+static std::vector<std::thread>  shotworkers;
+static std::mutex                shotlock;
+static std::condition_variable   shotqueued;  // a job is waiting, or quitting
+static std::condition_variable   shotdone;    // a job is finished
+static std::deque<shotjob_t *>   shotqueue;   // jobs waiting for a worker
+static bool                      shotquit;
+
+// game thread only
+static PODCollection<shotjob_t *> shotjobs;      // outstanding, oldest first
+static PODCollection<byte *>      shotbuffers;   // free screen copies
+static size_t                     shotbuffersize;
+
+// frame capture
+int capture_interval = 1;
+
+static bool capturing;
+static int  capturenum;    // numbers the files of each capture apart
+static int  captureframe;  // frames drawn since the capture started
+static int  capturecount;  // frames written
+
+//
+// Takes a screen-sized buffer from the pool. The pool is emptied whenever
+// the screen changes size.
+//
+static byte *M_getShotBuffer(size_t size)
+{
+   if(size != shotbuffersize)
+   {
+      for(byte *buffer : shotbuffers)
+         Z_SysFree(buffer);
+      shotbuffers.clear();
+      shotbuffersize = size;
+   }
+
+   if(!shotbuffers.isEmpty())
+      return shotbuffers.pop();
+
+   return static_cast<byte *>(Z_SysMalloc(size));
+}
+
+static void M_releaseShotBuffer(byte *buffer, size_t size)
+{
+   if(size == shotbuffersize)
+      shotbuffers.add(buffer);
+   else
+      Z_SysFree(buffer);
+}
+
+//
+// Runs the writer and writes out whatever it left in the buffer.
+//
+static void M_encodeShot(shotjob_t &job)
+{
+   pngmessage[0] = '\0';
+   errno = 0;
+
+   job.success = job.writer(&job.ob, job.data, job.width, job.height, job.palette) &&
+                 job.ob.flush();
+   job.error   = job.success ? 0 : errno;
+
+   psnprintf(job.message, sizeof(job.message), "%s", pngmessage);
+}
+
+static void M_shotWorker()
+{
+   std::unique_lock<std::mutex> lock(shotlock);
+
+   for(;;)
+   {
+      shotqueued.wait(lock, [] { return shotquit || !shotqueue.empty(); });
+      if(shotqueue.empty())
+         return;
+
+      shotjob_t *job = shotqueue.front();
+      shotqueue.pop_front();
+
+      lock.unlock();
+      M_encodeShot(*job);
+      lock.lock();
+
+      job->done = true;
+      shotdone.notify_all();
+   }
+}
+
+//
+// Waits for the given job's worker to be done with it.
+//
+static void M_waitForShot(shotjob_t *job)
+{
+   std::unique_lock<std::mutex> lock(shotlock);
+   shotdone.wait(lock, [job] { return job->done; });
+}
+
+static bool M_shotDone(shotjob_t *job)
+{
+   std::lock_guard<std::mutex> lock(shotlock);
+   return job->done;
+}
+
+//
+// Closes a finished job's file and frees it, without reporting it.
+//
+static void M_closeShot(shotjob_t *job)
+{
+   job->ob.close();
+
+   // killough 10/98: detect failure and remove file if error
+   if(!job->success)
+      remove(job->filename.constPtr());
+
+   M_releaseShotBuffer(job->data, job->size);
+   delete job;
+}
+
+//
+// Finishes every job and stops the workers; they must be done with before
+// static destruction.
+//
+static void M_shutdownShots()
+{
+   for(shotjob_t *job : shotjobs)
+   {
+      M_waitForShot(job);
+      M_closeShot(job);
+   }
+   shotjobs.clear();
+
+   {
+      std::lock_guard<std::mutex> lock(shotlock);
+      shotquit = true;
+   }
+   shotqueued.notify_all();
+
+   for(std::thread &worker : shotworkers)
+      worker.join();
+   shotworkers.clear();
+}
+
+//
+// Prints libpng's message, if it had one, and acknowledges a shot.
+//
+static void M_reportShot(bool success, int error, const char *message)
+{
+   if(*message)
+      C_Printf(FC_ERROR "%s\n", message);
+
+   // 1/18/98 killough: replace "SCREEN SHOT" acknowledgement with sfx
+   // players[consoleplayer].message = "screen shot"
+
+   // killough 10/98: print error message and change sound effect if error
+   if(!success)
+   {
+      doom_printf("%s", error ? strerror(error) : FC_ERROR "Could not take screenshot");
+      S_StartInterfaceSound(GameModeInfo->playerSounds[sk_oof]);
+   }
+   else
+      S_StartInterfaceSound(GameModeInfo->c_BellSound);
+}
+
+//
+// Reports a finished job and closes it. A frame capture only reports a
+// failure, which also ends it.
+//
+static void M_finishShot(shotjob_t *job)
+{
+   if(job->capture < 0)
+      M_reportShot(job->success, job->error, job->message);
+   else if(!job->success && capturing && job->capture == capturenum)
+   {
+      capturing = false;
+      M_reportShot(false, job->error, job->message);
+   }
+
+   M_closeShot(job);
+}
+
+//
+// Called once a frame to report finished shots.
+//
+void M_ScreenShotTicker()
+{
+   size_t kept = 0;
+
+   for(size_t i = 0; i < shotjobs.getLength(); i++)
+   {
+      shotjob_t *job = shotjobs[i];
+
+      if(M_shotDone(job))
+         M_finishShot(job);
+      else
+         shotjobs[kept++] = job;
+   }
+
+   shotjobs.resize(kept);
+}
+
+//
+// Copies the screen and hands it to a worker to be written to the given
+// file. Shots are never dropped: with too many in flight, this waits for the
+// oldest. Returns false if the file can't be created.
+//
+static bool M_queueShot(const char *filename, const shotformat_t &format, int capture)
+{
+   if(shotworkers.empty())
+   {
+      static bool atexitset = false;
+
+      if(!atexitset)
+      {
+         atexit(M_shutdownShots);
+         atexitset = true;
+      }
+
+      const int numworkers = eclamp(int(std::thread::hardware_concurrency()) - 1,
+                                    1, MAXSHOTWORKERS);
+      shotquit = false;
+      for(int i = 0; i < numworkers; i++)
+         shotworkers.emplace_back(M_shotWorker);
+   }
+
+   while(shotjobs.getLength() >= 2 * shotworkers.size())
+   {
+      M_waitForShot(shotjobs[0]);
+      M_ScreenShotTicker();
+   }
+
+   auto job = new shotjob_t;
+
+   if(!job->ob.createFile(filename, 512*1024, format.endian))
+   {
+      delete job;
+      return false;
+   }
+
+   job->filename = filename;
+   job->writer   = format.writer;
+   job->width    = uint32_t(vbscreen.width);
+   job->height   = uint32_t(vbscreen.height);
+   job->size     = size_t(job->width) * job->height;
+   job->data     = M_getShotBuffer(job->size);
+   job->capture  = capture;
+   job->done     = false;
+
+   // get screen graphics; the copy is column-major like the screen buffers
+   VBuffer copy;
+   V_InitVBufferFrom(&copy, vbscreen.width, vbscreen.height, vbscreen.height,
+                     video.bitdepth, job->data);
+   V_BlitVBuffer(&copy, 0, 0, &vbscreen, 0, 0, vbscreen.width, vbscreen.height);
+
+   // haleyjd 11/16/04: make gamma correction optional
+   AutoPalette pal(wGlobalDir);
+   const byte *playpal = pal.get();
+
+   for(int i = 0; i < 768; i++)
+      job->palette[i] = screenshot_gamma ? gammatable[usegamma][playpal[i]] : playpal[i];
+
+   shotjobs.add(job);
+   {
+      std::lock_guard<std::mutex> lock(shotlock);
+      shotqueue.push_back(job);
+   }
+   shotqueued.notify_one();
+
+   return true;
+}
+
 //
 // M_ScreenShot
 //
@@ -603,9 +853,7 @@ static shotformat_t shotFormats[SHOT_NUMSHOTFORMATS] =
 //
 void M_ScreenShot()
 {
-   bool success = false;
    qstring path;
-   OutBuffer ob;
    shotformat_t *format = &shotFormats[screenshot_pcx];
    
    errno = 0;
@@ -634,52 +882,110 @@ void M_ScreenShot()
       }
       while(!access(lbmname, F_OK) && --tries);
 
-      if(tries && ob.createFile(lbmname, 512*1024, format->endian))
-      {
-         // killough 4/18/98: make palette stay around
-         // (PU_CACHE could cause crash)         
-         //byte *pal = (byte *)wGlobalDir.cacheLumpName("PLAYPAL", PU_STATIC);
-         AutoPalette pal(wGlobalDir);
-
-         // get screen graphics
-         V_BlitVBuffer(&backscreen2, 0, 0, &vbscreen, 0, 0, 
-                       vbscreen.width, vbscreen.height);
-         
-         // killough 10/98: detect failure and remove file if error
-         success = format->writer(&ob, backscreen2.data, 
-                                  (uint32_t)(backscreen2.width), 
-                                  (uint32_t)(backscreen2.height),
-                                  pal.get());
-
-         // haleyjd: close the buffer
-         ob.close();
-
-         // if not successful, remove the file now
-         if(!success)
-         {
-            int t = errno;
-            remove(lbmname);
-            errno = t;
-         }
+      // the worker reports how it went
+      if(tries && M_queueShot(lbmname, *format, -1))
+         return;
+   }
 
-         // killough 4/18/98: now you can mark it PU_CACHE
-         // Z_ChangeTag(pal, PU_CACHE); - haleyjd 9/30/12: not needed now.
+   M_reportShot(false, errno, "");
+}
+
+//
+// Frame capture writes every capture_interval'th frame drawn to a numbered
+// file in the screenshot format, for putting together into a video.
+//
+
+static void M_captureFileName(qstring &filename, int frame)
+{
+   qstring path(userpath);
+
+   path.pathConcatenate("shots");
+   filename.Printf(path.length() + 32, "%s/cap%03d_%06d.%s", path.constPtr(),
+                   capturenum, frame, shotFormats[screenshot_pcx].extension);
+}
+
+//
+// Starts a frame capture under the first capture number not in use.
+//
+static void M_startCapture()
+{
+   qstring filename;
+
+   for(int tries = 0; tries < 1000; tries++, capturenum = (capturenum + 1) % 1000)
+   {
+      M_captureFileName(filename, 0);
+
+      if(access(filename.constPtr(), F_OK))
+      {
+         capturing    = true;
+         captureframe = 0;
+         capturecount = 0;
+         return;
       }
    }
 
-   // 1/18/98 killough: replace "SCREEN SHOT" acknowledgement with sfx
-   // players[consoleplayer].message = "screen shot"
-   
-   // killough 10/98: print error message and change sound effect if error
-   if(!success)
+   C_Printf(FC_ERROR "no free capture number in shots\n");
+}
+
+static void M_stopCapture()
+{
+   capturing = false;
+
+   C_Printf("captured %d frame%s to shots/cap%03d_*.%s\n", capturecount,
+            capturecount == 1 ? "" : "s", capturenum,
+            shotFormats[screenshot_pcx].extension);
+   capturenum = (capturenum + 1) % 1000;
+}
+
+//
+// Called once the frame is drawn, before it is shown.
+//
+void M_CaptureFrame()
+{
+   if(!capturing || captureframe++ % capture_interval)
+      return;
+
+   qstring filename;
+   M_captureFileName(filename, capturecount);
+
+   errno = 0;
+   if(!M_queueShot(filename.constPtr(), shotFormats[screenshot_pcx], capturenum))
    {
-      doom_printf("%s",
-         errno ? strerror(errno) : FC_ERROR "Could not take screenshot");
-      S_StartInterfaceSound(GameModeInfo->playerSounds[sk_oof]);
+      capturing = false;
+      M_reportShot(false, errno, "");
+      return;
    }
-   else
-      S_StartInterfaceSound(GameModeInfo->c_BellSound);
+
+   capturecount++;
 }
 
-// EOF
+//
+// Console commands
+//
+
+VARIABLE_INT(capture_interval, nullptr, 1, 35, nullptr);
+CONSOLE_VARIABLE(capture_interval, capture_interval, 0) {}
 
+CONSOLE_COMMAND(capture_start, 0)
+{
+   if(capturing)
+   {
+      C_Printf(FC_ERROR "already capturing\n");
+      return;
+   }
+
+   M_startCapture();
+}
+
+CONSOLE_COMMAND(capture_stop, 0)
+{
+   if(!capturing)
+   {
+      C_Printf(FC_ERROR "not capturing\n");
+      return;
+   }
+
+   M_stopCapture();
+}
+
+// EOF
@@ -28,8 +28,11 @@
 
 extern int screenshot_pcx;                                   // killough 10/98
 extern int screenshot_gamma;                                 // haleyjd  03/06
+extern int capture_interval;
 
 void M_ScreenShot(void);
+void M_ScreenShotTicker();
+void M_CaptureFrame();
 
 #endif
 
@@ -0,0 +1,62 @@
+//
+// The Eternity Engine
+// Copyright(C) 2026 James Haley, Max Waine, et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+// Additional terms and conditions compatible with the GPLv3 apply. See the
+// file COPYING-EE for details.
+//
+// Purpose: Runtime CPU feature detection.
+//
+
+#include "m_simd.h"
+
+#if defined(EE_SIMD_AVX2) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+//
+// Returns true if the CPU and OS both support AVX2. The result is cached.
+//
+bool M_CPUHasAVX2()
+{
+#if defined(EE_SIMD_AVX2) && defined(_MSC_VER)
+   static const bool hasavx2 = [] {
+      int regs[4];
+
+      __cpuid(regs, 0);
+      if(regs[0] < 7)
+         return false;
+
+      // OSXSAVE and AVX, then check the OS saves YMM state
+      __cpuid(regs, 1);
+      if((regs[2] & (1 << 27 | 1 << 28)) != (1 << 27 | 1 << 28))
+         return false;
+      if((_xgetbv(0) & 6) != 6)
+         return false;
+
+      __cpuidex(regs, 7, 0);
+      return (regs[1] & (1 << 5)) != 0;
+   }();
+   return hasavx2;
+#elif defined(EE_SIMD_AVX2)
+   static const bool hasavx2 = __builtin_cpu_supports("avx2");
+   return hasavx2;
+#else
+   return false;
+#endif
+}
+
+// EOF
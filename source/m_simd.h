@@ -0,0 +1,96 @@
+//
+// The Eternity Engine
+// Copyright(C) 2026 James Haley, Max Waine, et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+// Additional terms and conditions compatible with the GPLv3 apply. See the
+// file COPYING-EE for details.
+//
+// Purpose: SIMD instruction set detection.
+//  Code using intrinsics should test EE_SIMD_SSE2 or EE_SIMD_NEON and always
+//  provide a plain C++ fallback. Instruction sets beyond the compile target
+//  (EE_SIMD_AVX2) are only usable from functions marked EE_TARGET_AVX2 and
+//  only once M_CPUHasAVX2 has returned true.
+//
+
+#ifndef M_SIMD_H__
+#define M_SIMD_H__
+
+#include <stdint.h>
+
+// SSE2 is part of the x86-64 baseline, and is opt-in on 32-bit x86
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define EE_SIMD_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#define EE_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+// AVX2 can be compiled per-function and selected at runtime on x86
+#if defined(EE_SIMD_SSE2) && (defined(__GNUC__) || defined(__clang__))
+#define EE_SIMD_AVX2
+#define EE_TARGET_AVX2 __attribute__((target("avx2")))
+#include <immintrin.h>
+#elif defined(EE_SIMD_SSE2) && defined(_MSC_VER)
+#define EE_SIMD_AVX2
+#define EE_TARGET_AVX2
+#include <immintrin.h>
+#endif
+
+bool M_CPUHasAVX2();
+
+//
+// Stores a row-major 4x4 block of 32-bit values transposed: element j of row
+// i lands at dest[j * pitch + i].
+//
+inline void M_StoreTransposed4x4(uint32_t *dest, int pitch, const uint32_t in[16])
+{
+#if defined(EE_SIMD_SSE2)
+   const __m128i r0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in));
+   const __m128i r1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + 4));
+   const __m128i r2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + 8));
+   const __m128i r3 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + 12));
+
+   const __m128i t0 = _mm_unpacklo_epi32(r0, r1);
+   const __m128i t1 = _mm_unpacklo_epi32(r2, r3);
+   const __m128i t2 = _mm_unpackhi_epi32(r0, r1);
+   const __m128i t3 = _mm_unpackhi_epi32(r2, r3);
+
+   _mm_storeu_si128(reinterpret_cast<__m128i *>(dest),             _mm_unpacklo_epi64(t0, t1));
+   _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + pitch),     _mm_unpackhi_epi64(t0, t1));
+   _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + 2 * pitch), _mm_unpacklo_epi64(t2, t3));
+   _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + 3 * pitch), _mm_unpackhi_epi64(t2, t3));
+#elif defined(EE_SIMD_NEON)
+   // the de-interleaving load is exactly a transpose
+   const uint32x4x4_t cols = vld4q_u32(in);
+
+   vst1q_u32(dest,             cols.val[0]);
+   vst1q_u32(dest + pitch,     cols.val[1]);
+   vst1q_u32(dest + 2 * pitch, cols.val[2]);
+   vst1q_u32(dest + 3 * pitch, cols.val[3]);
+#else
+   for(int j = 0; j < 4; j++)
+   {
+      for(int i = 0; i < 4; i++)
+         dest[j * pitch + i] = in[i * 4 + j];
+   }
+#endif
+}
+
+#endif
+
+// EOF
+
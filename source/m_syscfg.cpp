@@ -28,7 +28,9 @@
 #include "z_zone.h"
 
 #include "doomstat.h"
+#include "d_framepacer.h"
 #include "d_iwad.h"
+#include "d_jobs.h"
 #include "d_main.h"
 #include "d_net.h"
 #include "d_gi.h"
@@ -39,6 +41,7 @@
 #include "i_sound.h"
 #include "i_video.h"
 #include "m_misc.h"
+#include "m_perfstats.h"
 #include "m_shots.h"
 #include "mn_menus.h"
 #include "r_context.h"
@@ -102,6 +105,9 @@ static default_t sysdefaults[] =
    DEFAULT_BOOL("d_scaniwads", &d_scaniwads, nullptr, true, default_t::wad_no,
                 "1 to scan common locations for IWADs"),
 
+   DEFAULT_STR("d_iwadcache", &d_iwadcache, nullptr, "", default_t::wad_no,
+               "IWADs already identified, with their size and time (do not edit)"),
+
    DEFAULT_STR(ITEM_IWAD_DOOM_SW, &gi_path_doomsw, nullptr, "", default_t::wad_no,
                "IWAD path for DOOM Shareware"),
 
@@ -165,7 +171,7 @@ static default_t sysdefaults[] =
                "Percentage of normal speed (35 fps) realtic clock runs at"),
 
    // killough
-   DEFAULT_INT("snd_channels", &default_numChannels, nullptr, 32, 1, 32, default_t::wad_no,
+   DEFAULT_INT("snd_channels", &default_numChannels, nullptr, 32, 1, SND_MAXCHANNELS, default_t::wad_no,
                "number of sound effects handled simultaneously"),
 
    // haleyjd 12/08/01
@@ -191,6 +197,9 @@ static default_t sysdefaults[] =
    DEFAULT_FLOAT("s_highgain", &s_highgain, nullptr, 0.8, 0, 300, default_t::wad_no,
                  "High pass gain"),  
 
+   DEFAULT_INT("s_interpolation", &s_interpolation, nullptr, 1, 0, 1, default_t::wad_no,
+               "Sound effect resampling (0 = none, 1 = linear)"),
+
    DEFAULT_INT("s_enviro_volume", &s_enviro_volume, nullptr, 4, 0, 16, default_t::wad_no,
                "Volume of environmental sound sequences"),
 
@@ -232,6 +241,9 @@ static default_t sysdefaults[] =
    DEFAULT_BOOL("gl_arb_pixelbuffer", &cfg_gl_arb_pixelbuffer, nullptr, false, default_t::wad_no,
                 "1 to enable use of GL ARB pixelbuffer object extension"),
 
+   DEFAULT_BOOL("gl_palette_shader", &cfg_gl_palette_shader, nullptr, true, default_t::wad_no,
+                "1 to convert the 8-bit screen to color in a GL shader"),
+
    DEFAULT_INT("gl_colordepth", &cfg_gl_colordepth, nullptr, 32, 16, 32, default_t::wad_no,
                "GL backend screen bitdepth (16, 24, or 32)"),
 
@@ -245,6 +257,24 @@ static default_t sysdefaults[] =
    DEFAULT_BOOL("d_interpolate", &d_interpolate, nullptr, true, default_t::wad_no,
                 "1 to activate frame interpolation (smooth rendering)"),
 
+   DEFAULT_BOOL("d_predict", &d_predict, nullptr, true, default_t::wad_no,
+                "1 to turn the view by local input not yet run in netgames"),
+
+   DEFAULT_INT("d_maxframetics", &d_maxframetics, nullptr, 0, 0, BACKUPTICS / 2, default_t::wad_no,
+               "Most game tics to run between frames when catching up (0 = no limit)"),
+
+   DEFAULT_INT("d_relaydelay", &d_relaydelay, nullptr, 0, 0, 600, default_t::wad_no,
+               "Seconds a dedicated host's spectator relay runs behind the game"),
+
+   DEFAULT_INT("stats_interval", &stats_interval, nullptr, 10, 0, 3600, default_t::wad_no,
+               "Seconds between lines of the -statsfile log (0 = never)"),
+
+   DEFAULT_INT("d_maxfps", &d_maxfps, nullptr, 0, 0, 1000, default_t::wad_no,
+               "Most frames drawn per second with d_fastrefresh (0 = no limit)"),
+
+   DEFAULT_INT("d_jobthreads", &d_jobthreads, nullptr, 0, 0, 32, default_t::wad_no,
+               "Worker threads for parallel jobs (0 = one less than the number of cores)"),
+
    DEFAULT_BOOL("i_forcefeedback", &i_forcefeedback, nullptr, true, default_t::wad_no,
                 "1 to enable force feedback through gamepads where supported"),
 
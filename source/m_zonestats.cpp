@@ -0,0 +1,190 @@
+//
+// The Eternity Engine
+// Copyright(C) 2026 James Haley, Max Waine, et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+// Additional terms and conditions compatible with the GPLv3 apply. See the
+// file COPYING-EE for details.
+//
+// Purpose: Zone heap telemetry.
+//  The counters themselves are kept by the heap; this only remembers where
+//  they stood when the level started, so rates and peaks are per level.
+//
+
+#include "z_zone.h"
+
+#include "c_io.h"
+#include "c_runcmd.h"
+#include "doomstat.h"
+#include "m_argv.h"
+#include "m_perfstats.h"
+#include "m_qstr.h"
+#include "m_zonestats.h"
+#include "v_misc.h"
+
+// Call sites listed by the zonestats command and logged per level
+static constexpr int ZONESTATSITES = 10;
+
+static const char *zonetagnames[PU_MAX] =
+{
+   "PU_FREE",
+   "PU_STATIC",
+   "PU_PERMANENT",
+   "PU_SOUND",
+   "PU_MUSIC",
+   "PU_RENDERER",
+   "PU_VALLOC",
+   "PU_AUTO",
+   "PU_LEVEL",
+   "PU_CACHE",
+};
+
+static uint64_t levelstartallocs;  // zonestats.allocs when the level started
+static size_t   levelstartbytes;   // and zonestats.totalbytes
+
+static const char *zonestatsfile;
+static bool        zonestatschecked;
+
+static PerfGauge zonebytesstat("zone.bytes", "KiB", [] {
+   return double(zonestats.totalbytes) / 1024;
+});
+static PerfGauge zonepeakstat("zone.peak", "KiB", [] {
+   return double(zonestats.peakbytes) / 1024;
+});
+static PerfCounter zoneallocsstat("zone.allocs", "", [] {
+   return double(zonestats.allocs);
+});
+
+//
+// Called once the previous level's memory is gone, to start measuring anew.
+//
+void M_ZoneStatsLevelStart()
+{
+   levelstartallocs = zonestats.allocs;
+   levelstartbytes  = zonestats.totalbytes;
+   Z_ResetPeakBytes();
+}
+
+//
+// Allocations made per tic of the current level.
+//
+static double M_zoneAllocRate()
+{
+   return double(zonestats.allocs - levelstartallocs) / (leveltime > 0 ? leveltime : 1);
+}
+
+//
+// Formats a count that can outgrow an int.
+//
+static const char *M_zoneNum(uint64_t n)
+{
+   static char buf[24];
+   snprintf(buf, sizeof(buf), "%llu", static_cast<unsigned long long>(n));
+   return buf;
+}
+
+//
+// Appends the level's figures to the -zonestats file as one line of JSON.
+//
+static void M_writeZoneStats(const char *mapname)
+{
+   zonesite_t sites[ZONESTATSITES];
+   int        numsites = Z_GetAllocSites(sites, ZONESTATSITES);
+   qstring    json;
+   FILE      *f;
+
+   json << "{\"map\":\"" << mapname << "\",\"tics\":" << leveltime
+        << ",\"totalBytes\":" << M_zoneNum(zonestats.totalbytes)
+        << ",\"levelStartBytes\":" << M_zoneNum(levelstartbytes)
+        << ",\"peakBytes\":" << M_zoneNum(zonestats.peakbytes)
+        << ",\"allocsPerTic\":" << M_zoneAllocRate() << ",\"tags\":{";
+   for(int tag = PU_FREE + 1; tag < PU_MAX; tag++)
+   {
+      json << (tag > PU_FREE + 1 ? "," : "") << '"' << zonetagnames[tag]
+           << "\":{\"bytes\":" << M_zoneNum(zonestats.bytesbytag[tag])
+           << ",\"blocks\":" << M_zoneNum(zonestats.blocksbytag[tag]) << '}';
+   }
+   json << "},\"sites\":[";
+   for(int i = 0; i < numsites; i++)
+   {
+      json << (i ? "," : "") << "{\"site\":\"" << sites[i].file << ':' << sites[i].line
+           << "\",\"allocs\":" << M_zoneNum(sites[i].allocs)
+           << ",\"bytes\":" << M_zoneNum(sites[i].bytes) << '}';
+   }
+   json << "]}\n";
+
+   if(!(f = fopen(zonestatsfile, "a")))
+   {
+      C_Printf(FC_ERROR "Couldn't open %s for zone stats output\n", zonestatsfile);
+      zonestatsfile = nullptr;
+      return;
+   }
+   json.replace("\\", '/'); // file names from __FILE__ may use backslashes
+   fputs(json.constPtr(), f);
+   fclose(f);
+}
+
+//
+// Called on leaving a level. Reports its figures when developing, and logs
+// them if -zonestats was given, so growth across a long session shows up.
+//
+void M_ZoneStatsLevelEnd(const char *mapname)
+{
+   if(!zonestatschecked)
+   {
+      int p;
+
+      if((p = M_CheckParm("-zonestats")) && ++p < myargc)
+         zonestatsfile = myargv[p];
+      zonestatschecked = true;
+   }
+
+   if(devparm)
+   {
+      C_Printf("%s: zone %u KB, level peak %u KB, %.1f allocs/tic\n", mapname,
+               unsigned(zonestats.totalbytes / 1024), unsigned(zonestats.peakbytes / 1024),
+               M_zoneAllocRate());
+   }
+   if(zonestatsfile)
+      M_writeZoneStats(mapname);
+}
+
+CONSOLE_COMMAND(zonestats, 0)
+{
+   zonesite_t sites[ZONESTATSITES];
+   int        numsites = Z_GetAllocSites(sites, ZONESTATSITES);
+
+   for(int tag = PU_FREE + 1; tag < PU_MAX; tag++)
+   {
+      C_Printf("%-13s %8u KB in %u blocks\n", zonetagnames[tag],
+               unsigned(zonestats.bytesbytag[tag] / 1024),
+               unsigned(zonestats.blocksbytag[tag]));
+   }
+   C_Printf("Total %u KB, %u KB at level start, peak %u KB since\n"
+            "%.1f allocations per tic this level\n",
+            unsigned(zonestats.totalbytes / 1024), unsigned(levelstartbytes / 1024),
+            unsigned(zonestats.peakbytes / 1024), M_zoneAllocRate());
+
+   if(numsites)
+      C_Printf(FC_HI "Top allocation sites by bytes:\n");
+   for(int i = 0; i < numsites; i++)
+   {
+      C_Printf("%s:%d: %u KB in %u allocations\n", sites[i].file, sites[i].line,
+               unsigned(sites[i].bytes / 1024), unsigned(sites[i].allocs));
+   }
+}
+
+// EOF
+
@@ -0,0 +1,36 @@
+//
+// The Eternity Engine
+// Copyright(C) 2026 James Haley, Max Waine, et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+// Additional terms and conditions compatible with the GPLv3 apply. See the
+// file COPYING-EE for details.
+//
+// Purpose: Zone heap telemetry.
+//  Reports the zone heap's always-on counters through the zonestats
+//  console command, and at every level exit, where -zonestats <file>
+//  appends them as one JSON object per line.
+//
+
+#ifndef M_ZONESTATS_H__
+#define M_ZONESTATS_H__
+
+void M_ZoneStatsLevelStart();
+void M_ZoneStatsLevelEnd(const char *mapname);
+
+#endif
+
+// EOF
+
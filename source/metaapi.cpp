@@ -528,6 +528,40 @@ public:
       keyhash.reverseChains();
       typehash.reverseChains();
    }
+
+   //
+   // Walk the key hash chain for an interned key, starting after object if it
+   // is not null. Since interning folds case, two keys are equal exactly when
+   // their indices are, so this avoids the string comparisons done by the
+   // generic EHashTable key iterator.
+   //
+   MetaObject *nextForKey(const MetaObject *object, const metakey_t &keyObj) const
+   {
+      MetaObject *obj = object ? keyhash.nextOnChain(const_cast<MetaObject *>(object))
+                               : keyhash.chainForKey(keyObj.key, keyObj.unmodHC);
+
+      while(obj && obj->keyIdx != keyObj.index)
+         obj = keyhash.nextOnChain(obj);
+
+      return obj;
+   }
+
+   //
+   // As above, but also requiring the object's actual type to match.
+   //
+   MetaObject *nextForKeyAndType(const MetaObject *object, const metakey_t &keyObj,
+                                 const MetaObject::Type *type) const
+   {
+      MetaObject *obj = const_cast<MetaObject *>(object);
+
+      while((obj = nextForKey(obj, keyObj)))
+      {
+         if(obj->isInstanceOf(type))
+            break;
+      }
+
+      return obj;
+   }
 };
 
 IMPLEMENT_RTTI_TYPE(MetaTable)
@@ -814,8 +848,7 @@ MetaObject *MetaTable::getObject(const char *key) const
 //
 MetaObject *MetaTable::getObject(size_t keyIndex) const
 {
-   metakey_t &keyObj = MetaKeyForIndex(keyIndex);
-   return pImpl->keyhash.objectForKey(keyObj.key, keyObj.unmodHC);
+   return pImpl->nextForKey(nullptr, MetaKeyForIndex(keyIndex));
 }
 
 //
@@ -878,16 +911,7 @@ MetaObject *MetaTable::getObjectKeyAndType(const char *key, const char *type) co
 //
 MetaObject *MetaTable::getObjectKeyAndType(size_t keyIndex, const MetaObject::Type *type) const
 {
-   metakey_t  &keyObj = MetaKeyForIndex(keyIndex);
-   MetaObject *obj    = nullptr;
-
-   while((obj = pImpl->keyhash.keyIterator(obj, keyObj.key, keyObj.unmodHC)))
-   {
-      if(obj->isInstanceOf(type))
-         break;
-   }
-   
-   return obj;
+   return pImpl->nextForKeyAndType(nullptr, MetaKeyForIndex(keyIndex), type);
 }
 
 //
@@ -931,9 +955,7 @@ MetaObject *MetaTable::getNextObject(MetaObject *object, const char *key) const
 //
 MetaObject *MetaTable::getNextObject(MetaObject *object, size_t keyIndex) const
 {
-   metakey_t &keyObj = MetaKeyForIndex(keyIndex);
-
-   return pImpl->keyhash.keyIterator(object, keyObj.key, keyObj.unmodHC);
+   return pImpl->nextForKey(object, MetaKeyForIndex(keyIndex));
 }
 
 //
@@ -1126,9 +1148,6 @@ const MetaObject *MetaTable::getNextKeyAndType(const MetaObject *object, const c
 MetaObject *MetaTable::getNextKeyAndType(MetaObject *object, size_t keyIdx, 
                                          const MetaObject::Type *type) const
 {
-   MetaObject *obj    = object;
-   metakey_t  &keyObj = MetaKeyForIndex(keyIdx);
-
    if(object)
    {
       // As above, allow null in type to mean "same as current"
@@ -1136,20 +1155,11 @@ MetaObject *MetaTable::getNextKeyAndType(MetaObject *object, size_t keyIdx,
          type = object->getDynamicType();
    }
 
-   while((obj = pImpl->keyhash.keyIterator(obj, keyObj.key, keyObj.unmodHC)))
-   {
-      if(obj->isInstanceOf(type))
-         break;
-   }
-
-   return obj;
+   return pImpl->nextForKeyAndType(object, MetaKeyForIndex(keyIdx), type);
 }
 const MetaObject *MetaTable::getNextKeyAndType(const MetaObject *object, size_t keyIdx,
                                                const MetaObject::Type *type) const
 {
-   const MetaObject *obj    = object;
-   metakey_t  &keyObj = MetaKeyForIndex(keyIdx);
-
    if(object)
    {
       // As above, allow null in type to mean "same as current"
@@ -1157,13 +1167,7 @@ const MetaObject *MetaTable::getNextKeyAndType(const MetaObject *object, size_t
          type = object->getDynamicType();
    }
 
-   while((obj = pImpl->keyhash.keyIterator(obj, keyObj.key, keyObj.unmodHC)))
-   {
-      if(obj->isInstanceOf(type))
-         break;
-   }
-
-   return obj;
+   return pImpl->nextForKeyAndType(object, MetaKeyForIndex(keyIdx), type);
 }
 
 //
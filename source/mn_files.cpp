@@ -34,6 +34,13 @@ namespace fs = std::filesystem;
 #include <experimental/filesystem>
 namespace fs = std::experimental::filesystem;
 #endif
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
 #include "z_zone.h"
 
 #include "c_io.h"
@@ -75,107 +82,52 @@ extern int adlmidi_bank;
 //
 
 //
-// filecmp
-//
-// Compares a filename with a wildcard string.
+// Matches one part of a filename, the name or the extension, against the
+// same part of a wildcard. A '*' matches the rest of the name; a wildcard
+// that runs out first matches as well.
 //
-static bool filecmp(const char *filename, const char *wildcard)
+static bool MN_wildcardMatch(const char *name, const char *nameend,
+                             const char *wild, const char *wildend)
 {
-   static char no_ext[] = "";
-
-   char *filename_main, *wildcard_main; // filename
-   char *filename_ext, *wildcard_ext;   // extension
-   bool res = true;
-   int i = 0;
-  
-   // haleyjd: must be case insensitive
-   filename_main = M_Strupr(estrdup(filename));
-   wildcard_main = M_Strupr(estrdup(wildcard));
-   
-   // find separator -- haleyjd: use strrchr, not strchr
-   filename_ext = strrchr(filename_main, '.');
-   
-   if(!filename_ext) 
-      filename_ext = no_ext; // no extension
-   else
+   for(; wild != wildend; ++wild, ++name)
    {
-      // break into 2 strings; replace . with \0
-      *filename_ext++ = '\0';
+      if(*wild == '*')
+         return true;
+      if(name == nameend)
+         return false;
+
+      // haleyjd: must be case insensitive
+      if(*wild != '?' && ectype::toUpper(*wild) != ectype::toUpper(*name))
+         return false;
    }
-   
-   // do the same with the wildcard -- haleyjd: strrchr again  
-   wildcard_ext = strrchr(wildcard_main, '.');
 
-   if(!wildcard_ext)
-      wildcard_ext = no_ext;
-   else
-      *wildcard_ext++ = '\0';
-
-   // compare main part of filename with wildcard
-   while(wildcard_main[i])
-   {
-      bool exitloop = false;
+   return true;
+}
 
-      switch(wildcard_main[i])
-      {
-      case '?':
-         continue;
-      case '*':
-         exitloop = true;
-         break;
-      default:
-         if(wildcard_main[i] != filename_main[i])
-         {
-            res = false;
-            exitloop = true;
-         }
-         break;
-      }
+//
+// filecmp
+//
+// Compares a filename with a wildcard string. Doesn't allocate, so it can be
+// used by the directory scanning thread.
+//
+static bool filecmp(const char *filename, const char *wildcard)
+{
+   const char *fileend = filename + strlen(filename);
+   const char *wildend = wildcard + strlen(wildcard);
 
-      if(exitloop)
-         break;
+   // find separator -- haleyjd: use strrchr, not strchr
+   const char *filedot = strrchr(filename, '.');
+   const char *wilddot = strrchr(wildcard, '.');
 
-      ++i;
-   }
+   // no separator means no extension
+   const char *filemainend = filedot ? filedot : fileend;
+   const char *wildmainend = wilddot ? wilddot : wildend;
+   const char *fileext     = filedot ? filedot + 1 : fileend;
+   const char *wildext     = wilddot ? wilddot + 1 : wildend;
 
    // if first part of comparison fails, don't do 2nd part
-   if(res)
-   {
-      i = 0;
-
-      // compare extension
-      while(wildcard_ext[i])
-      {
-         bool exitloop = false;
-         
-         switch(wildcard_ext[i])
-         {
-         case '?':
-            continue;
-         case '*':
-            exitloop = true;
-            break;
-         default:
-            if(wildcard_ext[i] != filename_ext[i])
-            {
-               res = false;
-               exitloop = true;
-            }
-            break;
-         }
-         
-         if(exitloop)
-            break;
-         
-         ++i;
-      }
-   }
-
-   // done with temporary strings
-   efree(filename_main);
-   efree(wildcard_main);
-
-   return res;
+   return MN_wildcardMatch(filename, filemainend, wildcard, wildmainend) &&
+          MN_wildcardMatch(fileext, fileend, wildext, wildend);
 }
 
 //
@@ -235,16 +187,11 @@ void MN_ClearDirectory(mndir_t *dir)
 }
 
 //
-// MN_qFileCompare
+// Order of the directory listings
 //
-// qsort callback to compare file names
-//
-static int MN_qFileCompare(const void *si1, const void *si2)
+static bool MN_fileLess(const char *str1, const char *str2)
 {
-   const char *str1 = *((const char **)si1);
-   const char *str2 = *((const char **)si2);
-
-   return strcasecmp(str1, str2);
+   return strcasecmp(str1, str2) < 0;
 }
 
 //
@@ -254,8 +201,56 @@ static int MN_qFileCompare(const void *si1, const void *si2)
 //
 static void MN_sortFiles(mndir_t *dir)
 {
-   if(dir->numfiles >= 2)
-      qsort(dir->filenames, dir->numfiles, sizeof(char *), MN_qFileCompare);
+   std::sort(dir->filenames, dir->filenames + dir->numfiles, MN_fileLess);
+}
+
+//
+// Index of the first file name in a sorted listing starting with prefix,
+// ignoring case and the slash in front of subdirectories, or -1.
+// Subdirectories sort together, ahead of the files.
+//
+static int MN_findPrefix(const mndir_t *dir, const char *prefix)
+{
+   char **const begin = dir->filenames;
+   char **const end   = dir->filenames + dir->numfiles;
+   const size_t len   = strlen(prefix);
+   qstring      dirprefix("/");
+
+   dirprefix += prefix;
+
+   for(const char *key : { dirprefix.constPtr(), prefix })
+   {
+      char **const itr = std::lower_bound(begin, end, key, MN_fileLess);
+
+      if(itr != end && !strncasecmp(*itr + (key != prefix), prefix, len))
+         return int(itr - begin);
+   }
+
+   return -1;
+}
+
+//
+// Calls add with each name the entry goes into the listing under: a
+// subdirectory goes in with a slash in front, a file once for every
+// wildcard it matches.
+//
+template<typename F>
+static void MN_matchEntry(const fs::directory_entry &ent,
+                          const char *const *wildcards, size_t numwildcards,
+                          bool allowsubdirs, F &&add)
+{
+   const std::string filename(ent.path().filename().generic_u8string());
+   std::error_code   ec;
+
+   // "." and ".." are explicitly skipped by fs::directory_entry
+   if(allowsubdirs && ent.is_directory(ec))
+      add(("/" + filename).c_str());
+
+   for(size_t i = 0; i < numwildcards; i++)
+   {
+      if(filecmp(filename.c_str(), wildcards[i]))
+         add(filename.c_str()); // add file to list
+   }
 }
 
 //
@@ -283,26 +278,8 @@ int MN_ReadDirectory(mndir_t *dir, const char *read_dir,
    const fs::directory_iterator itr(dir->dirpath);
    for(const fs::directory_entry &ent : itr)
    {
-      qstring filename(ent.path().filename().generic_u8string().c_str());
-      if(allowsubdirs)
-      {
-         qstring path(read_dir);
-
-         path.pathConcatenate(filename);
-
-         // "." and ".." are explicitly skipped by fs::directory_entry
-         if(ent.is_directory())
-         {
-            path = "/";
-            path += filename.constPtr();
-            MN_addFile(dir, path.constPtr());
-         }
-      }
-      for(size_t i = 0; i < numwildcards; i++)
-      {
-         if(filecmp(filename.constPtr(), read_wildcards[i]))
-            MN_addFile(dir, filename.constPtr()); // add file to list
-      }
+      MN_matchEntry(ent, read_wildcards, numwildcards, allowsubdirs,
+                    [dir](const char *name) { MN_addFile(dir, name); });
    }
 
    // If there's a parent directory then add it
@@ -315,6 +292,162 @@ int MN_ReadDirectory(mndir_t *dir, const char *read_dir,
    return 0;
 }
 
+//=============================================================================
+//
+// Background Directory Scanning
+//
+// The wad selector's directory is read by a thread of its own, which hands
+// names over in batches. The menu ticker merges them into the sorted listing
+// as they come, so the selector opens at once on a huge directory. The
+// thread doesn't touch the zone heap; names are only copied into the
+// listing on the game thread. A finished listing is kept and shown again as
+// long as the directory's modification time hasn't changed.
+//
+
+static constexpr size_t DIRSCAN_BATCH = 256;
+
+struct mndirscan_t
+{
+   std::thread              thread;
+   std::mutex               lock;
+   std::vector<std::string> found;    // names the ticker hasn't taken yet
+   bool                     finished; // the thread has nothing more to add
+   std::atomic_bool         cancel;
+};
+
+static mndirscan_t        mn_wadscan;
+static mndir_t            mn_waddir;         // the wad selector's listing
+static qstring            mn_waddirpath;     // directory it lists
+static fs::file_time_type mn_waddirtime;     // modification time when read
+static bool               mn_waddircomplete; // the scan has been merged in full
+
+static const char *const mn_wadexts[] = { "*.wad", "*.pke", "*.pk3" };
+
+static void MN_scanThreadFunc(std::string path)
+{
+   std::vector<std::string> batch;
+   std::error_code          ec;
+
+   auto handOver = [&batch]() {
+      std::lock_guard<std::mutex> lock(mn_wadscan.lock);
+      for(std::string &name : batch)
+         mn_wadscan.found.push_back(std::move(name));
+      batch.clear();
+   };
+
+   for(fs::directory_iterator itr(path, ec), end; !ec && itr != end; itr.increment(ec))
+   {
+      if(mn_wadscan.cancel.load(std::memory_order_relaxed))
+         break;
+
+      MN_matchEntry(*itr, mn_wadexts, earrlen(mn_wadexts), true,
+                    [&batch](const char *name) { batch.emplace_back(name); });
+
+      if(batch.size() >= DIRSCAN_BATCH)
+         handOver();
+   }
+
+   // If there's a parent directory then add it
+   if(fs::exists(fs::path(path) / "..", ec))
+      batch.emplace_back("..");
+
+   handOver();
+
+   std::lock_guard<std::mutex> lock(mn_wadscan.lock);
+   mn_wadscan.finished = true;
+}
+
+//
+// Stops the scan, if one is running, and drops whatever it found.
+//
+static void MN_stopWadScan()
+{
+   if(!mn_wadscan.thread.joinable())
+      return;
+
+   mn_wadscan.cancel = true;
+   mn_wadscan.thread.join();
+   mn_wadscan.found.clear();
+}
+
+//
+// Empties the wad listing and starts reading the given directory into it.
+//
+static void MN_startWadScan(const char *path, fs::file_time_type mtime)
+{
+   static bool atexitset = false;
+
+   MN_stopWadScan();
+
+   // the thread must be done with before static destruction
+   if(!atexitset)
+   {
+      atexit(MN_stopWadScan);
+      atexitset = true;
+   }
+
+   mn_waddirpath = path;
+   mn_waddirtime = mtime;
+   mn_waddircomplete = false;
+
+   MN_ClearDirectory(&mn_waddir);
+   mn_waddir.dirpath = mn_waddirpath.constPtr();
+
+   mn_wadscan.finished = false;
+   mn_wadscan.cancel   = false;
+   mn_wadscan.thread   = std::thread(MN_scanThreadFunc, std::string(path));
+}
+
+//
+// Merges what the scan has found since the last call into the listing,
+// keeping the same name at the selection.
+//
+static void MN_pollWadScan(int &selection)
+{
+   std::vector<std::string> found;
+   bool finished;
+
+   if(!mn_wadscan.thread.joinable())
+      return;
+
+   {
+      std::lock_guard<std::mutex> lock(mn_wadscan.lock);
+      found.swap(mn_wadscan.found);
+      finished = mn_wadscan.finished;
+   }
+
+   if(!found.empty())
+   {
+      const char *selected = nullptr;
+      const int   oldnum   = mn_waddir.numfiles;
+
+      if(selection < oldnum)
+         selected = mn_waddir.filenames[selection];
+
+      for(const std::string &name : found)
+         MN_addFile(&mn_waddir, name.c_str());
+
+      char **const files = mn_waddir.filenames;
+      std::sort(files + oldnum, files + mn_waddir.numfiles, MN_fileLess);
+      std::inplace_merge(files, files + oldnum, files + mn_waddir.numfiles, MN_fileLess);
+
+      if(selected)
+      {
+         char **itr = std::lower_bound(files, files + mn_waddir.numfiles, selected,
+                                       MN_fileLess);
+         while(*itr != selected)
+            ++itr;
+         selection = int(itr - files);
+      }
+   }
+
+   if(finished)
+   {
+      mn_wadscan.thread.join();
+      mn_waddircomplete = true;
+   }
+}
+
 //=============================================================================
 //
 // File Selector
@@ -327,10 +460,11 @@ static mndir_t *mn_currentdir;
 
 static void MN_FileDrawer();
 static bool MN_FileResponder(event_t *ev, int action);
+static void MN_FileTicker();
 
 // file selector is handled using a menu widget
 
-static menuwidget_t file_selector = { MN_FileDrawer, MN_FileResponder, nullptr, true };
+static menuwidget_t file_selector = { MN_FileDrawer, MN_FileResponder, MN_FileTicker, true };
 static int selected_item;
 static const char *variable_name;
 static const char *help_description;
@@ -338,6 +472,12 @@ static int numfileboxlines;
 static bool select_dismiss;
 static bool allow_exit = true;
 
+// names typed in quick succession are searched for together
+static constexpr int FILESEARCH_TIME = TICRATE;
+
+static qstring file_search;
+static int     file_searchtime;
+
 //
 // MN_FileDrawer
 //
@@ -383,6 +523,15 @@ static void MN_FileDrawer()
    if(help_description)
       MN_WriteTextColored(help_description, CR_GOLD, 16 + 8, 16 + 8);
 
+   // the wad listing may still be coming in
+   const bool scanning = mn_currentdir == &mn_waddir && !mn_waddircomplete;
+   if(scanning)
+   {
+      const char *msg = "scanning...";
+      MN_WriteTextColored(msg, CR_GRAY,
+                          bright - V_FontStringWidth(menu_font, msg), 16 + 8);
+   }
+
    // add one to the line height for the remaining lines to leave a gap
    lheight += 1;
    
@@ -412,6 +561,9 @@ static void MN_FileDrawer()
    x = bleft + 1;
    y = btop + 1;
 
+   if(mn_currentdir->numfiles < 1 && !scanning)
+      MN_WriteTextColored("no files found", GameModeInfo->unselectColor, x + 11, y);
+
    // draw the file names starting from min and going to max
    for(i = min; i <= max; ++i)
    {
@@ -443,6 +595,33 @@ static void MN_FileDrawer()
    }
 }
 
+//
+// MN_FileTicker
+//
+// Brings the wad listing up to date while it is being read.
+//
+static void MN_FileTicker()
+{
+   if(mn_currentdir == &mn_waddir)
+      MN_pollWadScan(selected_item);
+}
+
+//
+// Moves the selection to a file name found by the search.
+//
+static bool MN_selectFile(int n)
+{
+   if(n < 0)
+      return false;
+
+   if(n != selected_item) // only make sound if actually moving
+   {
+      selected_item = n;
+      S_StartInterfaceSound(GameModeInfo->menuSounds[MN_SND_KEYUPDOWN]);
+   }
+   return true; // eat key
+}
+
 //
 // MN_doExitFileWidget
 //
@@ -529,6 +708,10 @@ static bool MN_FileResponder(event_t *ev, int action)
   
    if(action == ka_menu_confirm)
    {
+      // nothing to pick while the listing is empty
+      if(mn_currentdir->numfiles < 1)
+         return true;
+
       if(select_dismiss)
          MN_PopWidget(); // cancel widget
 
@@ -549,32 +732,38 @@ static bool MN_FileResponder(event_t *ev, int action)
    if(ev->type == ev_text)
       ch = ectype::toLower(ev->data1);
 
-   if(ectype::isGraph(ch))
+   if(ectype::isGraph(ch) && mn_currentdir->numfiles > 0)
    {  
-      int n = selected_item;
-      
-      do
+      if(menutime - file_searchtime > FILESEARCH_TIME)
+         file_search.clear();
+      file_searchtime = menutime;
+
+      // typing the same letter again steps through the names starting with it
+      if(file_search.length() == 1 && file_search[0] == char(ch))
       {
-         n++;
-         if(n >= mn_currentdir->numfiles) 
-            n = 0; // loop round
-         
-         const char *fn = mn_currentdir->filenames[n];
-         if(strlen(fn) > 1 && fn[0] == '/')
-            ++fn;
+         int n = selected_item;
 
-         if(ectype::toLower(*fn) == ch)
+         do
          {
-            // found a matching item!
-            if(n != selected_item) // only make sound if actually moving
-            {
-               selected_item = n;
-               S_StartInterfaceSound(GameModeInfo->menuSounds[MN_SND_KEYUPDOWN]);
-            }
-            return true; // eat key
-         }
-      } 
-      while(n != selected_item);
+            n++;
+            if(n >= mn_currentdir->numfiles) 
+               n = 0; // loop round
+
+            const char *fn = mn_currentdir->filenames[n];
+            if(strlen(fn) > 1 && fn[0] == '/')
+               ++fn;
+
+            if(ectype::toLower(*fn) == ch)
+               return MN_selectFile(n); // found a matching item!
+         } 
+         while(n != selected_item);
+
+         return false;
+      }
+
+      // the listings are sorted, so look the typed name up
+      file_search += char(ch);
+      return MN_selectFile(MN_findPrefix(mn_currentdir, file_search.constPtr()));
    }
    
    return false; // not interested
@@ -597,34 +786,38 @@ static mndir_t mn_diskdir;
 // MN_doSelectWad
 //
 // Implements logic for bringing up a listing of the current directory
-// being viewed for wad file selection.
+// being viewed for wad file selection. The listing is read in the
+// background unless the last one read is still good.
 //
 static void MN_doSelectWad(const char *path)
 {
-   static const char *exts[] = { "*.wad", "*.pke", "*.pk3" };
+   std::error_code ec;
 
    if(path)
       wad_cur_directory = path;
 
-   int ret = MN_ReadDirectory(&mn_diskdir, wad_cur_directory.constPtr(),
-                              exts, earrlen(exts), true);
+   const char *dirpath = wad_cur_directory.constPtr();
 
    // check for standard errors
-   if(ret)
+   if(!fs::is_directory(dirpath, ec))
    {
-      MN_ErrorMsg("Failed to open directory %s: errno %d", wad_cur_directory.constPtr(), ret);
+      if(ec)
+         MN_ErrorMsg("Failed to open directory %s: errno %d", dirpath, ec.value());
+      else
+         MN_ErrorMsg("no files found");
       return;
    }
 
-   // empty directory?
-   if(mn_diskdir.numfiles < 1)
+   const fs::file_time_type mtime = fs::last_write_time(dirpath, ec);
+
+   if(ec || mn_waddirpath != dirpath || mn_waddirtime != mtime ||
+      !(mn_waddircomplete || mn_wadscan.thread.joinable()))
    {
-      MN_ErrorMsg("no files found");
-      return;
+      MN_startWadScan(dirpath, mtime);
    }
 
    selected_item      = 0;
-   mn_currentdir      = &mn_diskdir;
+   mn_currentdir      = &mn_waddir;
    help_description   = "select wad file:";
    variable_name      = "mn_wadname";
    select_dismiss     = true;
@@ -66,6 +66,7 @@
 #include "r_main.h"
 #include "r_patch.h"
 #include "r_state.h"
+#include "r_things.h"
 #include "s_sound.h"
 #include "v_font.h"
 #include "v_misc.h"
@@ -1185,7 +1186,7 @@ void MN_PlayerDrawer()
    if(!(menu_player.menuitems[7].flags & MENUITEM_POSINIT))
       return;
 
-   sprdef = &sprites[players[consoleplayer].skin->sprite];
+   sprdef = R_SpriteDef(players[consoleplayer].skin->sprite);
 
    // haleyjd 08/15/02
    if(!(sprdef->spriteframes))
@@ -1696,6 +1697,7 @@ static menuitem_t mn_sysvideo_items[] =
    { it_gap },
    { it_info,     "Rendering"                                    },
    { it_slider,   "Screen size",              "screensize"       },
+   { it_toggle,   "Dynamic resolution",       "r_dynres"         },
    { it_toggle,   "HOM detector flashes",     "r_homflash"       },
    { it_toggle,   "Translucency",             "r_trans"          },
    { it_variable, "Opacity percentage",       "r_tranpct"        },
@@ -1703,6 +1705,7 @@ static menuitem_t mn_sysvideo_items[] =
    { it_gap },
    { it_info,     "Framerate"   },
    { it_toggle,   "Uncapped framerate",       "d_fastrefresh"    },
+   { it_variable, "Framerate limit",          "d_maxfps"         },
    { it_toggle,   "Interpolation",            "d_interpolate"    },
    { it_gap },
    { it_info,     "Screen Wipe" },
@@ -1742,7 +1745,7 @@ static void MN_SysVideoModeDrawer()
    if(!(menu_sysvideo.menuitems[5].flags & MENUITEM_POSINIT))
       return;
 
-   sprdef = &sprites[states[frame]->sprite];
+   sprdef = R_SpriteDef(states[frame]->sprite);
    // haleyjd 08/15/02
    if(!(sprdef->spriteframes))
       return;
@@ -1850,6 +1853,7 @@ static menuitem_t mn_vidadv_items[] =
    { it_toggle,   "Texture filtering",        "gl_filter_type"     },
    { it_toggle,   "Use extensions",           "gl_use_extensions"  },
    { it_toggle,   "Use ARB pixelbuffers",     "gl_arb_pixelbuffer" },
+   { it_toggle,   "Convert palette on GPU",   "gl_palette_shader"  },
    { it_end }
 };
 
@@ -1908,6 +1912,7 @@ static menuitem_t mn_sound_items[] =
    {it_toggle,     "Force reverse stereo",         "s_flippan"},
    {it_toggle,     "OPL3 Emulator",                "snd_oplemulator"},
    {it_toggle,     "OPL3 Chip Count",              "snd_numchips"},
+   {it_toggle,     "OPL3 Threads",                 "snd_oplthreads"},
    {it_runcmd,     "Set OPL3 Bank...",             "snd_selectbank"},
    {it_gap},
    {it_info,       "Misc"},
@@ -2005,6 +2010,7 @@ static menuitem_t mn_mouse_items[] =
    {it_info,       "Miscellaneous"},
    {it_toggle,     "Invert mouse",                  "invertmouse"    },
    {it_toggle,     "Smooth turning",                "smooth_turning" },
+   {it_toggle,     "Mouse look-ahead",              "mouse_lookahead" },
    {it_toggle,     "Vertical mouse movement",       "mouse_vert"   },
 #ifdef _SDL_VER
    {it_toggle,     "Window grabs mouse",            "i_grabmouse"    },
@@ -2625,6 +2631,7 @@ static menuitem_t mn_hud_pg2_items[] =
    {it_gap},
    {it_info,       "Miscellaneous"},
    {it_toggle,     "Show frags in deathmatch",     "show_scores"},
+   {it_toggle,     "Show network statistics",      "hu_shownetstats"},
    {it_end}
 };
 
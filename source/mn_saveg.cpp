@@ -81,6 +81,9 @@ static constexpr int SAVEBOXUNIT        = 8;
 static constexpr int SAVEBOXWIDTH       = (SAVESTRINGSIZE - 1) * SAVEBOXUNIT;
 static constexpr int MAXSAVESTRINGWIDTH = SAVEBOXWIDTH - SAVEBOXUNIT;
 
+// How much of a deflated savegame is inflated to read its slot details
+static constexpr size_t SAVEHEADERSIZE = 64 * 1024;
+
 struct saveID_t
 {
    int slot;
@@ -246,6 +249,9 @@ static void MN_readSaveStrings()
 
    e_saveSlots.clear();
 
+   // a save still being written would be missed or half read
+   P_FinishSaveGame();
+
    // test for failure
    if(std::error_code ec; !fs::is_directory(basesavegame, ec))
       return;
@@ -264,7 +270,9 @@ static void MN_readSaveStrings()
          continue;
 
       START_UTF8();
-      const bool fileLoaded = !loadFile.openFile(pathStr.constPtr(), InBuffer::NENDIAN);
+      // only the header is read, which comes well within the first part
+      const bool fileLoaded = !loadFile.openInflated(pathStr.constPtr(), InBuffer::NENDIAN,
+                                                     SAVEHEADERSIZE);
       END_UTF8();
       if(fileLoaded)
          continue;
@@ -56,6 +56,7 @@
 #include "r_defs.h"
 #include "r_draw.h"
 #include "r_state.h"
+#include "r_things.h"
 #include "s_sound.h"
 #include "sounds.h"
 #include "v_font.h"
@@ -384,9 +385,9 @@ static void MN_SkinDrawer()
 
    // get the player skin sprite definition
    if(skview_state->sprite == mobjinfo[pctype]->defsprite)
-      sprdef = &sprites[players[consoleplayer].skin->sprite];
+      sprdef = R_SpriteDef(players[consoleplayer].skin->sprite);
    else
-      sprdef = &sprites[skview_state->sprite];
+      sprdef = R_SpriteDef(skview_state->sprite);
 
    if(!(sprdef->spriteframes))
       return;
@@ -82,6 +82,70 @@ static Mobj *current_actor;
 // but some can be made preaware
 //
 
+//
+// Noise flood cache
+//
+// A player holding down the trigger floods the same sectors from the same
+// place over and over. Each flood is recorded as the sequence of sector
+// visits it made, together with every sector whose heights it looked at, so
+// that it can be replayed with exactly the same effect on the sectors: the
+// same soundtraversed values, validcount marks and sound targets. Moving a
+// sector drops the floods that looked at it; anything else that can change
+// how sound gets through (specials, ACS, portals, polyobjects) drops them all.
+//
+
+static constexpr int NUMSOUNDFLOODS = 16; // power of two
+
+struct soundflood_t
+{
+   int                origin;    // sector index, -1 if unused or invalid
+   PODCollection<int> visits;    // sector * 2 + soundblocks of each visit
+   byte              *examined;  // sectors the flood depends on
+   const line_t      *lastline;  // the last line it took an opening of
+   bool               cacheable;
+};
+
+static soundflood_t  soundfloods[NUMSOUNDFLOODS];
+static soundflood_t *recordflood;
+
+//
+// Forgets every flood. With a sector, only the floods that depend on it.
+//
+void P_InvalidateSoundFloods(const sector_t *sec)
+{
+   const int secnum = sec ? eindex(sec - sectors) : -1;
+
+   for(soundflood_t &flood : soundfloods)
+   {
+      if(flood.origin < 0)
+         continue;
+      if(secnum < 0 || (flood.examined[secnum >> 3] & (1 << (secnum & 7))))
+         flood.origin = -1;
+   }
+}
+
+//
+// Called when a level is set up, before any noise is made.
+//
+void P_ClearSoundFloods()
+{
+   for(soundflood_t &flood : soundfloods)
+   {
+      flood.origin   = -1;
+      flood.examined = nullptr; // PU_LEVEL, already freed
+      flood.visits.makeEmpty();
+   }
+}
+
+inline static void P_markSoundExamined(const sector_t *sec)
+{
+   if(recordflood && sec)
+   {
+      const int secnum = eindex(sec - sectors);
+      recordflood->examined[secnum >> 3] |= 1 << (secnum & 7);
+   }
+}
+
 //
 // P_RecursiveSound
 //
@@ -103,6 +167,12 @@ static void P_RecursiveSound(sector_t *sec, const int soundblocks,
    sec->soundtraversed = soundblocks+1;
    P_SetTarget<Mobj>(&sec->soundtarget, soundtarget);    // killough 11/98
 
+   if(recordflood)
+   {
+      recordflood->visits.add(eindex(sec - sectors) * 2 + soundblocks);
+      P_markSoundExamined(sec);
+   }
+
    // Check the floor and ceiling portals
    for(surf_e surf : SURFS)
    {
@@ -122,6 +192,19 @@ static void P_RecursiveSound(sector_t *sec, const int soundblocks,
       if(!(check->flags & ML_TWOSIDED))
          continue;
 
+      if(recordflood)
+      {
+         // a one-sided line flagged two-sided leaves more of clip.open as
+         // it was than a replay can account for
+         if(check->sidenum[1] == -1)
+            recordflood->cacheable = false;
+         P_markSoundExamined(check->frontsector);
+         P_markSoundExamined(check->backsector);
+         if(check->intflags & MLI_1SPORTALLINE && check->beyondportalline)
+            P_markSoundExamined(check->beyondportalline->frontsector);
+         recordflood->lastline = check;
+      }
+
       clip.open = P_LineOpening(check, nullptr);
 
       if(clip.open.range <= 0)
@@ -139,6 +222,7 @@ static void P_RecursiveSound(sector_t *sec, const int soundblocks,
 
          sector_t *iother = R_PointInSubsector(mid - nudge +
                                                v2fixed_t(check->portal->data.link.delta))->sector;
+         P_markSoundExamined(iother);
 
          P_RecursiveSound(iother, soundblocks, soundtarget);
       }
@@ -161,7 +245,38 @@ static void P_RecursiveSound(sector_t *sec, const int soundblocks,
 void P_NoiseAlert(Mobj *target, Mobj *emitter)
 {
    validcount++;
+
+   const int origin = eindex(emitter->subsector->sector - sectors);
+   soundflood_t &flood = soundfloods[origin & (NUMSOUNDFLOODS - 1)];
+
+   if(flood.origin == origin)
+   {
+      // replay it
+      for(int visit : flood.visits)
+      {
+         sector_t *sec = &sectors[visit >> 1];
+         sec->validcount = validcount;
+         sec->soundtraversed = (visit & 1) + 1;
+         P_SetTarget<Mobj>(&sec->soundtarget, target);
+      }
+      if(flood.lastline)
+         clip.open = P_LineOpening(flood.lastline, nullptr);
+      return;
+   }
+
+   if(!flood.examined)
+      flood.examined = ecalloctag(byte *, 1, (numsectors + 7) / 8, PU_LEVEL, nullptr);
+   else
+      memset(flood.examined, 0, (numsectors + 7) / 8);
+   flood.visits.makeEmpty();
+   flood.lastline  = nullptr;
+   flood.cacheable = true;
+
+   recordflood = &flood;
    P_RecursiveSound(emitter->subsector->sector, 0, target);
+   recordflood = nullptr;
+
+   flood.origin = flood.cacheable ? origin : -1;
 }
 
 //
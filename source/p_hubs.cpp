@@ -37,12 +37,16 @@
 //----------------------------------------------------------------------------
 
 #include "z_zone.h"
+#include "i_system.h"
+#include "../zlib/zlib.h"
 
 #include "c_io.h"
+#include "c_runcmd.h"
 #include "d_event.h"
 #include "doomstat.h"
 #include "d_io.h"       // SoM 3/14/2002: strncasecmp
 #include "g_game.h"
+#include "p_hubs.h"
 #include "p_maputl.h"
 #include "p_mobj.h"
 #include "p_saveg.h"
@@ -57,8 +61,16 @@ struct hublevel_t
 {
    char levelname[8];
    char *tmpfile;        // temporary file holding the saved level
+   byte *data;           // or the saved level, deflated, in memory
+   size_t size;          // deflated size
+   size_t fullsize;      // size once inflated
 };
 
+// most memory saved hub levels may use, in MB, before going to disk
+int hub_memory = 64;
+
+static size_t hubmemorybytes; // total deflated size held in memory
+
 extern char gamemapname[9];
 
 // sf: set when we are changing to
@@ -90,9 +102,15 @@ void P_ClearHubs(void)
    {
       if(hub_levels[i].tmpfile)
          remove(hub_levels[i].tmpfile);
+      if(hub_levels[i].data)
+      {
+         efree(hub_levels[i].data);
+         hub_levels[i].data = nullptr;
+      }
    }
    
    num_hub_levels = 0;
+   hubmemorybytes = 0;
 
 #if 0
    // clear the hub_script
@@ -137,10 +155,46 @@ static hublevel_t *AddHublevel(char *levelname)
 {
    strncpy(hub_levels[num_hub_levels].levelname, levelname, 8);
    hub_levels[num_hub_levels].tmpfile = nullptr;
+   hub_levels[num_hub_levels].data    = nullptr;
    
    return &hub_levels[num_hub_levels++];
 }
 
+//
+// Keeps a saved level in memory, deflated, if it fits under hub_memory.
+// Returns false if it doesn't, and the level must go to disk.
+//
+static bool SaveHubLevelToMemory(hublevel_t *hublevel)
+{
+   const size_t budget = size_t(hub_memory) * 1024 * 1024;
+   byte  *data;
+   size_t size;
+   uLongf packedsize;
+
+   P_SaveSnapshot(data, size);
+
+   packedsize = compressBound(uLong(size));
+   byte *packed = emalloc(byte *, packedsize);
+
+   // speed matters more than size on a level change
+   if(compress2(packed, &packedsize, data, uLong(size), Z_BEST_SPEED) != Z_OK ||
+      hubmemorybytes + packedsize > budget)
+   {
+      efree(packed);
+      efree(data);
+      return false;
+   }
+
+   efree(data);
+
+   hublevel->data     = erealloc(byte *, packed, packedsize);
+   hublevel->size     = packedsize;
+   hublevel->fullsize = size;
+   hubmemorybytes    += packedsize;
+
+   return true;
+}
+
 // save the current level in the hub
 
 static void SaveHubLevel(void)
@@ -153,6 +207,21 @@ static void SaveHubLevel(void)
    // create new hublevel if not been there yet
    if(!hublevel)
       hublevel = AddHublevel(levelmapname);
+
+   // drop the last save of this level, wherever it was kept
+   if(hublevel->data)
+   {
+      hubmemorybytes -= hublevel->size;
+      efree(hublevel->data);
+      hublevel->data = nullptr;
+   }
+
+   if(SaveHubLevelToMemory(hublevel))
+   {
+      if(hublevel->tmpfile)
+         remove(hublevel->tmpfile);
+      return;
+   }
    
    // allocate a temp. filename for save
    if(!hublevel->tmpfile)
@@ -173,6 +242,19 @@ static void LoadHubLevel(char *levelname)
       G_SetGameMapName(levelname);
       gameaction = ga_loadlevel;
    }
+   else if(hublevel->data)
+   {
+      // found saved level in memory: inflate it and reload
+      byte  *data = emalloc(byte *, hublevel->fullsize);
+      uLongf size = uLongf(hublevel->fullsize);
+
+      if(uncompress(data, &size, hublevel->data, uLong(hublevel->size)) != Z_OK ||
+         size != hublevel->fullsize)
+         I_Error("LoadHubLevel: saved level %.8s is corrupt\n", levelname);
+
+      G_LoadGameFromMemory(data, size);
+      hub_changelevel = true;
+   }
    else
    {
       // found saved level: reload
@@ -210,6 +292,9 @@ void P_DumpHubs(void)
    */
 }
 
+VARIABLE_INT(hub_memory, nullptr, 0, 4096, nullptr);
+CONSOLE_VARIABLE(hub_memory, hub_memory, 0) {}
+
 static fixed_t  save_xoffset;
 static fixed_t  save_yoffset;
 static Mobj   save_mobj;
@@ -0,0 +1,228 @@
+//
+// The Eternity Engine
+// Copyright(C) 2026 James Haley, Max Waine, et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+// Additional terms and conditions compatible with the GPLv3 apply. See the
+// file COPYING-EE for details.
+//
+// Purpose: On-disk cache for data derived from a level's geometry.
+//  Each entry is a file in <userpath>/cache named after its kind and an MD5
+//  of the vertices, segs, subsectors and nodes of the current level. The
+//  file starts with a header repeating the digest, the engine version and
+//  the size, so anything built from other geometry, or by another build of
+//  the engine, is never handed back; it is rebuilt and saved again instead.
+//
+
+#include "z_zone.h"
+
+#include "c_runcmd.h"
+#include "doomstat.h"
+#include "hal/i_directory.h"
+#include "m_hash.h"
+#include "m_qstr.h"
+#include "p_levelcache.h"
+#include "r_defs.h"
+#include "r_state.h"
+#include "version.h"
+
+// Bump whenever the layout of the file changes
+static constexpr uint32_t LEVELCACHE_VERSION = 1;
+
+static constexpr size_t LEVELHEADER_SIZE = 4 + 4 + 4 + 4 + 4 + 16;
+
+// Set to false to always rebuild level data, and never write it out
+static bool p_levelcache = true;
+
+static void P_hashInt(HashData &hash, int32_t value)
+{
+   const uint8_t bytes[4] =
+   {
+      uint8_t(value), uint8_t(value >> 8), uint8_t(value >> 16), uint8_t(value >> 24)
+   };
+   hash.addData(bytes, 4);
+}
+
+//
+// Digest of everything the cached tables can depend on.
+//
+static HashData P_levelGeometryHash()
+{
+   HashData hash(HashData::MD5);
+
+   P_hashInt(hash, numvertexes);
+   for(int i = 0; i < numvertexes; i++)
+   {
+      P_hashInt(hash, vertexes[i].x);
+      P_hashInt(hash, vertexes[i].y);
+   }
+
+   P_hashInt(hash, numsegs);
+   for(int i = 0; i < numsegs; i++)
+   {
+      const seg_t &seg = segs[i];
+      P_hashInt(hash, seg.v1->x);
+      P_hashInt(hash, seg.v1->y);
+      P_hashInt(hash, seg.v2->x);
+      P_hashInt(hash, seg.v2->y);
+      P_hashInt(hash, seg.linedef ? int32_t(seg.linedef - lines) : -1);
+      P_hashInt(hash, seg.frontsector ? int32_t(seg.frontsector - sectors) : -1);
+      P_hashInt(hash, seg.backsector ? int32_t(seg.backsector - sectors) : -1);
+   }
+
+   P_hashInt(hash, numsubsectors);
+   for(int i = 0; i < numsubsectors; i++)
+   {
+      P_hashInt(hash, subsectors[i].firstline);
+      P_hashInt(hash, subsectors[i].numlines);
+      P_hashInt(hash, int32_t(subsectors[i].sector - sectors));
+   }
+
+   P_hashInt(hash, numnodes);
+   for(int i = 0; i < numnodes; i++)
+   {
+      const node_t &node = nodes[i];
+      P_hashInt(hash, node.x);
+      P_hashInt(hash, node.y);
+      P_hashInt(hash, node.dx);
+      P_hashInt(hash, node.dy);
+      P_hashInt(hash, node.children[0]);
+      P_hashInt(hash, node.children[1]);
+   }
+
+   hash.wrapUp();
+   return hash;
+}
+
+//
+// Path of the cache file for a kind of data, creating the cache directory if
+// asked.
+//
+static qstring P_levelCachePath(const char *kind, const HashData &hash, bool create)
+{
+   qstring dir(userpath);
+   dir /= "cache";
+
+   if(create)
+      I_CreateDirectory(dir);
+
+   char *digest = hash.digestToString();
+   qstring name;
+   name.Printf(0, "%s_%s.lvl", kind, digest);
+   efree(digest);
+
+   return dir / name;
+}
+
+//
+// Builds the header every cache file starts with. Integers are stored
+// little-endian so files don't depend on the host.
+//
+static void P_levelHeader(byte *header, const HashData &hash, size_t size)
+{
+   const uint32_t fields[4] =
+   {
+      LEVELCACHE_VERSION, uint32_t(version), uint32_t(subversion), uint32_t(size)
+   };
+
+   memcpy(header, "EELC", 4);
+   for(int i = 0; i < 4; i++)
+   {
+      for(int b = 0; b < 4; b++)
+         header[4 + i * 4 + b] = byte(fields[i] >> (b * 8));
+   }
+   for(int i = 0; i < 4; i++)
+   {
+      for(int b = 0; b < 4; b++)
+         header[20 + i * 4 + b] = byte(hash.getDigestPart(i) >> (b * 8));
+   }
+}
+
+//
+// Fills dest with data of the given kind saved earlier for the current
+// level's geometry. Unless it returns loaded, dest is left untouched.
+//
+levelcache_e P_LoadLevelCache(const char *kind, void *dest, size_t size)
+{
+   if(!p_levelcache || !userpath)
+      return levelcache_e::missing;
+
+   const HashData hash = P_levelGeometryHash();
+   const qstring  path = P_levelCachePath(kind, hash, false);
+   FILE *f;
+
+   if(!(f = fopen(path.constPtr(), "rb")))
+      return levelcache_e::missing;
+
+   byte header[LEVELHEADER_SIZE], expected[LEVELHEADER_SIZE], empty[LEVELHEADER_SIZE];
+   P_levelHeader(expected, hash, size);
+   P_levelHeader(empty, hash, 0);
+
+   levelcache_e result = levelcache_e::missing;
+   if(fread(header, 1, LEVELHEADER_SIZE, f) == LEVELHEADER_SIZE)
+   {
+      if(!memcmp(header, empty, LEVELHEADER_SIZE))
+      {
+         if(fgetc(f) == EOF)
+            result = levelcache_e::empty;
+      }
+      else if(!memcmp(header, expected, LEVELHEADER_SIZE))
+      {
+         byte *data = emalloc(byte *, size);
+         if(fread(data, 1, size, f) == size && fgetc(f) == EOF)
+         {
+            memcpy(dest, data, size);
+            result = levelcache_e::loaded;
+         }
+         efree(data);
+      }
+   }
+   fclose(f);
+
+   return result;
+}
+
+//
+// Saves freshly built data for the current level's geometry. A size of 0
+// records that nothing could be built. Failure just means it is built again
+// next time.
+//
+void P_SaveLevelCache(const char *kind, const void *src, size_t size)
+{
+   if(!p_levelcache || !userpath)
+      return;
+
+   const HashData hash = P_levelGeometryHash();
+   const qstring  path = P_levelCachePath(kind, hash, true);
+   FILE *f;
+
+   if(!(f = fopen(path.constPtr(), "wb")))
+      return;
+
+   byte header[LEVELHEADER_SIZE];
+   P_levelHeader(header, hash, size);
+
+   const bool written = fwrite(header, 1, LEVELHEADER_SIZE, f) == LEVELHEADER_SIZE &&
+                        (!size || fwrite(src, 1, size, f) == size);
+
+   // Don't leave a truncated file behind
+   if(fclose(f) || !written)
+      remove(path.constPtr());
+}
+
+VARIABLE_TOGGLE(p_levelcache, nullptr, onoff);
+CONSOLE_VARIABLE(p_levelcache, p_levelcache, 0) {}
+
+// EOF
@@ -0,0 +1,45 @@
+//
+// The Eternity Engine
+// Copyright(C) 2026 James Haley, Max Waine, et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+// Additional terms and conditions compatible with the GPLv3 apply. See the
+// file COPYING-EE for details.
+//
+// Purpose: On-disk cache for data derived from a level's geometry.
+//  Some tables worked out when a level loads, such as the subsector
+//  visibility behind the PVS and the built reject, take far longer to make
+//  than to read. They are kept under the user directory, keyed by a digest
+//  of exactly the geometry they are made from, and read back on revisits.
+//
+
+#ifndef P_LEVELCACHE_H__
+#define P_LEVELCACHE_H__
+
+#include "doomtype.h"
+
+enum class levelcache_e
+{
+   missing, // nothing was saved for this geometry
+   empty,   // it was saved that nothing could be built
+   loaded   // dest holds the saved data
+};
+
+levelcache_e P_LoadLevelCache(const char *kind, void *dest, size_t size);
+void P_SaveLevelCache(const char *kind, const void *src, size_t size);
+
+#endif
+
+// EOF
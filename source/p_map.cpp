@@ -48,6 +48,7 @@
 #include "p_setup.h"
 #include "p_skin.h"
 #include "p_spec.h"
+#include "polyobj.h"
 #include "r_main.h"
 #include "r_portal.h"
 #include "r_state.h"
@@ -675,13 +676,14 @@ bool P_BlockedAsMonster(const Mobj &mo)
 bool PIT_CheckLine(line_t *ld, polyobj_t *po, void *context)
 {
    auto pushhit = static_cast<PODCollection<line_t *> *>(context);
-   if(clip.bbox[BOXRIGHT]  <= ld->bbox[BOXLEFT]   || 
-      clip.bbox[BOXLEFT]   >= ld->bbox[BOXRIGHT]  || 
-      clip.bbox[BOXTOP]    <= ld->bbox[BOXBOTTOM] || 
-      clip.bbox[BOXBOTTOM] >= ld->bbox[BOXTOP])
+   const linehot_t &lh = linehot[ld - lines];
+   if(clip.bbox[BOXRIGHT]  <= lh.bbox[BOXLEFT]   || 
+      clip.bbox[BOXLEFT]   >= lh.bbox[BOXRIGHT]  || 
+      clip.bbox[BOXTOP]    <= lh.bbox[BOXBOTTOM] || 
+      clip.bbox[BOXBOTTOM] >= lh.bbox[BOXTOP])
       return true; // didn't hit it
 
-   if(P_BoxOnLineSide(clip.bbox, ld) != -1)
+   if(P_BoxOnLineSide(clip.bbox, lh) != -1)
       return true; // didn't hit it
 
    // A line has been hit
@@ -696,7 +698,7 @@ bool PIT_CheckLine(line_t *ld, polyobj_t *po, void *context)
 
    // killough 7/24/98: allow player to move out of 1s wall, to prevent sticking
    // haleyjd 04/30/11: treat block-everything lines like they're 1S
-   if(!ld->backsector || (ld->extflags & EX_ML_BLOCKALL)) // one sided line
+   if(!lh.backsector || (ld->extflags & EX_ML_BLOCKALL)) // one sided line
    {
       clip.blockline = ld;
       bool result = clip.unstuck && !untouched(ld) &&
@@ -1172,6 +1174,120 @@ bool Check_Sides(Mobj *actor, int x, int y, mobjtype_t type)
    return false;                                                  //   |
 }                                                                 // phares
 
+//
+// P_NothingInReach
+//
+// True if no thing or line that P_CheckPosition would look at for the thing at
+// (x, y) is close enough to touch it, so the clipping callbacks would all
+// reject on distance. Fast missiles in open space mostly find nothing. This
+// only ever says no when unsure: things or lines in other portal groups, or
+// linked portals in the blocks, always send the caller down the full check.
+//
+bool P_NothingInReach(const Mobj *thing, fixed_t x, fixed_t y)
+{
+   fixed_t bbox[4];
+
+   bbox[BOXTOP]    = y + thing->radius;
+   bbox[BOXBOTTOM] = y - thing->radius;
+   bbox[BOXRIGHT]  = x + thing->radius;
+   bbox[BOXLEFT]   = x - thing->radius;
+
+   // things, over the same MAXRADIUS-extended blocks
+   int xl = emax((bbox[BOXLEFT]   - bmaporgx - MAXRADIUS) >> MAPBLOCKSHIFT, 0);
+   int xh = emin((bbox[BOXRIGHT]  - bmaporgx + MAXRADIUS) >> MAPBLOCKSHIFT, bmapwidth - 1);
+   int yl = emax((bbox[BOXBOTTOM] - bmaporgy - MAXRADIUS) >> MAPBLOCKSHIFT, 0);
+   int yh = emin((bbox[BOXTOP]    - bmaporgy + MAXRADIUS) >> MAPBLOCKSHIFT, bmapheight - 1);
+
+   for(int by = yl; by <= yh; by++)
+   {
+      for(int bx = xl; bx <= xh; bx++)
+      {
+         const int offset = by * bmapwidth + bx;
+
+         if(P_BlockHasLinkedPortals(offset, true) || !gPortalBlockmap[offset].isEmpty())
+            return false;
+
+         const blockthings_t &block = blockthings[offset];
+         for(int i = 0; i < block.numthings; i++)
+         {
+            const Mobj *mo = block.things[i];
+
+            if(mo == thing || !(mo->flags & (MF_SOLID|MF_SPECIAL|MF_SHOOTABLE|MF_TOUCHY)))
+               continue;
+            if(mo->groupid != thing->groupid)
+               return false;
+
+            const fixed_t blockdist = mo->radius + thing->radius;
+            if(D_abs(mo->x - x) < blockdist && D_abs(mo->y - y) < blockdist)
+               return false;
+         }
+      }
+   }
+
+   // lines, including polyobject lines
+   xl = emax((bbox[BOXLEFT]   - bmaporgx) >> MAPBLOCKSHIFT, 0);
+   xh = emin((bbox[BOXRIGHT]  - bmaporgx) >> MAPBLOCKSHIFT, bmapwidth - 1);
+   yl = emax((bbox[BOXBOTTOM] - bmaporgy) >> MAPBLOCKSHIFT, 0);
+   yh = emin((bbox[BOXTOP]    - bmaporgy) >> MAPBLOCKSHIFT, bmapheight - 1);
+
+   auto inreach = [&bbox, thing](const line_t *ld) -> bool {
+      if(ld->frontsector->groupid != thing->groupid)
+         return true;
+      return !(bbox[BOXRIGHT]  <= ld->bbox[BOXLEFT]   ||
+               bbox[BOXLEFT]   >= ld->bbox[BOXRIGHT]  ||
+               bbox[BOXTOP]    <= ld->bbox[BOXBOTTOM] ||
+               bbox[BOXBOTTOM] >= ld->bbox[BOXTOP]) &&
+             P_BoxOnLineSide(bbox, ld) == -1;
+   };
+
+   for(int by = yl; by <= yh; by++)
+   {
+      for(int bx = xl; bx <= xh; bx++)
+      {
+         const int offset = by * bmapwidth + bx;
+
+         for(const DLListItem<polymaplink_t> *plink = polyblocklinks[offset]; plink;
+             plink = plink->dllNext)
+         {
+            const polyobj_t *po = (*plink)->po;
+            for(int i = 0; i < po->numLines; i++)
+            {
+               if(inreach(po->lines[i]))
+                  return false;
+            }
+         }
+
+         // walk the list as P_BlockLinesIterator does, start delimiter and all
+         const int *list = blockmaplump + blockmap[offset];
+         if((!demo_compatibility && demo_version < 342) || (demo_version >= 342 && skipblstart))
+            list++;
+         if(blocklines && !(useportalgroups && P_PortalGroupCount() > 1))
+         {
+            // the boxes reject most lines without touching line_t, unless a
+            // line could be in another group, which must make us give up
+            const blocklines_t &block = blocklines[offset];
+            for(int i = int(list - block.lines); i < block.numlines; i++)
+            {
+               if(bbox[BOXRIGHT] > block.left[i] && bbox[BOXLEFT] < block.right[i] &&
+                  bbox[BOXTOP] > block.bottom[i] && bbox[BOXBOTTOM] < block.top[i] &&
+                  inreach(&lines[block.lines[i]]))
+               {
+                  return false;
+               }
+            }
+            continue;
+         }
+         for(; *list != -1; list++)
+         {
+            if(*list < numlines && inreach(&lines[*list]))
+               return false;
+         }
+      }
+   }
+
+   return true;
+}
+
 //
 // MOVEMENT CLIPPING
 //
@@ -1249,6 +1365,13 @@ bool P_CheckPosition(Mobj *thing, fixed_t x, fixed_t y, PODCollection<line_t *>
    if(clip.thing->flags & MF_NOCLIP)
       return true;
 
+   // the iterators below would only confirm there's nothing to hit
+   if(P_NothingInReach(thing, x, y))
+   {
+      clip.BlockingMobj = nullptr;
+      return true;
+   }
+
    // Check things first, possibly picking things up.
    // The bounding box is extended by MAXRADIUS
    // because Mobjs are grouped into mapblocks
@@ -1289,7 +1412,7 @@ bool P_CheckPosition(Mobj *thing, fixed_t x, fixed_t y, PODCollection<line_t *>
    {
       for(by = yl; by <= yh; by++)
       {
-         if(!P_BlockLinesIterator(bx, by, PIT_CheckLine, R_NOGROUP, pushhit))
+         if(!P_BlockLinesIteratorBox(bx, by, clip.bbox, PIT_CheckLine, R_NOGROUP, pushhit))
             return false; // doesn't fit
       }
    }
@@ -1493,7 +1616,7 @@ static bool P_checkCarryUp(Mobj &thing, fixed_t floorz)
    fixed_t orgz = thing.z;
    thing.z = floorz;
    MobjCollection coll;
-   PODCollection<fixed_t> orgzcoll;
+   SmallPODCollection<fixed_t, 8> orgzcoll;
    doom_mapinter_t clip;
    P_FindAboveIntersectors(&thing, clip, coll); // already aware of MF_SOLID
    auto resetcoll = [&coll, orgz, &orgzcoll, &thing](const Mobj *other) {
@@ -1567,7 +1690,7 @@ bool P_TryMove(Mobj *thing, fixed_t x, fixed_t y, int dropoff)
    bool groupidchange = false;
    fixed_t prex = x, prey = y;
 
-   PODCollection<line_t *> pushhit;
+   SmallPODCollection<line_t *, 8> pushhit;
    PODCollection<line_t *> *pPushHit = full_demo_version >= make_full_version(401, 0) ? &pushhit : 
       nullptr;
 
@@ -1832,6 +1955,7 @@ bool P_TryMove(Mobj *thing, fixed_t x, fixed_t y, int dropoff)
       {
          thing->prevpos.portalline = crossoutcome.lastpassed;
          thing->prevpos.ldata = &crossoutcome.lastpassed->portal->data.link;
+         P_AddThingToSectorBox(thing, true);
       }
       P_PortalDidTeleport(thing, x - prex, y - prey, 0, oldgroupid, crossoutcome.finalgroup);
    }
@@ -2449,6 +2573,7 @@ struct bombdata_t
    int   bombmod;      // haleyjd 07/13/03
 
    unsigned int bombflags; // haleyjd 12/22/12
+   int   cybertype;        // looked up once per explosion
 };
 
 #define MAXBOMBS 128               // a static limit to prevent stack faults.
@@ -2483,6 +2608,29 @@ static bool PIT_RadiusAttack(Mobj *thing, void *context)
    if(!(thing->flags & (MF_SHOOTABLE | MF_BOUNCES)))
       return true;
 
+   // Most things in the blocks walked are out of range, so reject on distance
+   // before the lookups below; none of these checks has any side effects, so
+   // their order cannot change the outcome.
+
+   // ioanch 20151225: portal-aware behaviour
+   dx   = D_abs(getThingX(bombspot, thing) - bombspot->x);
+   dy   = D_abs(getThingY(bombspot, thing) - bombspot->y);
+   dist = dx > dy ? dx : dy;
+   dist = (dist - thing->radius) >> FRACBITS;
+
+   if(dist < 0)
+      dist = 0;
+
+   if(dist >= bombdistance)
+      return true;  // out of range
+
+   // haleyjd: optional z check for Hexen-style explosions
+   if(theBomb->bombflags & RAF_CLIPHEIGHT)
+   {
+      if((D_abs(getThingZ(bombspot, thing) - bombspot->z) / FRACUNIT) > 2 * bombdistance)
+         return true;
+   }
+
    if(bombspot && P_splashImmune(thing, bombspot))
       return true;
 
@@ -2499,7 +2647,7 @@ static bool PIT_RadiusAttack(Mobj *thing, void *context)
 
    if(bombspot->flags & MF_BOUNCES && !(bombspot->flags4 & MF4_NORADIUSHACK))
    {
-      int cyberType = E_ThingNumForDEHNum(MT_CYBORG);
+      int cyberType = theBomb->cybertype;
 
       if(thing->type == cyberType && bombsource->type == cyberType)
          return true;
@@ -2513,25 +2661,6 @@ static bool PIT_RadiusAttack(Mobj *thing, void *context)
       return true;
    }
 
-   // ioanch 20151225: portal-aware behaviour
-   dx   = D_abs(getThingX(bombspot, thing) - bombspot->x);
-   dy   = D_abs(getThingY(bombspot, thing) - bombspot->y);
-   dist = dx > dy ? dx : dy;
-   dist = (dist - thing->radius) >> FRACBITS;
-
-   if(dist < 0)
-      dist = 0;
-
-   if(dist >= bombdistance)
-      return true;  // out of range
-
-   // haleyjd: optional z check for Hexen-style explosions
-   if(theBomb->bombflags & RAF_CLIPHEIGHT)
-   {
-      if((D_abs(getThingZ(bombspot, thing) - bombspot->z) / FRACUNIT) > 2 * bombdistance)
-         return true;
-   }
-
    if(P_CheckSight(thing, bombspot))      // must be in direct path
    {
       int damage;
@@ -2583,6 +2712,7 @@ void P_RadiusAttack(Mobj *spot, Mobj *source, int damage, int distance,
    theBomb->bombdistance = distance;
    theBomb->bombmod      = mod;
    theBomb->bombflags    = flags;
+   theBomb->cybertype    = E_ThingNumForDEHNum(MT_CYBORG);
 
    fixed_t bbox[4];
    bbox[BOXLEFT] = spot->x - dist;
@@ -2743,22 +2873,34 @@ bool P_CheckSector(sector_t *sector, int crunch, int amt, CheckSectorPlane plane
    // Mark all things invalid
    for(n = sector->touching_thinglist; n; n = n->m_snext)
       n->visited = false;
+   secnodechanges++;
+
+   // Starting over always finds everything before the last thing processed
+   // marked, so as long as no node came or went meanwhile the scan can carry
+   // on after it. Things skipped in portal-aware mode stay unmarked and have
+   // to be looked at again, so the full restart is kept there.
+   const bool portalaware = useportalgroups && full_demo_version >= make_full_version(340, 48);
+   msecnode_t *start = sector->touching_thinglist;
    
    do
    {
-      for(n = sector->touching_thinglist; n; n = n->m_snext) // go through list
+      for(n = start; n; n = n->m_snext) // go through list
       {
          // ioanch 20160115: portal aware
-         if(useportalgroups && full_demo_version >= make_full_version(340, 48) &&
-            !P_SectorTouchesThingVertically(sector, n->m_thing))
-         {
+         if(portalaware && !P_SectorTouchesThingVertically(sector, n->m_thing))
             continue;
-         }
          if(!n->visited)                     // unprocessed thing found
          {
+            const unsigned int changes = secnodechanges;
+
             n->visited  = true;              // mark thing as processed
             if(!(n->m_thing->flags & MF_NOBLOCKMAP)) //jff 4/7/98 don't do these
                PIT_ChangeSector(n->m_thing, nullptr); // process it
+
+            if(!portalaware && secnodechanges == changes)
+               start = n->m_snext;
+            else
+               start = sector->touching_thinglist;
             break;                           // exit and start over
          }
       }
@@ -2773,6 +2915,7 @@ bool P_CheckSector(sector_t *sector, int crunch, int amt, CheckSectorPlane plane
 // Maintain a freelist of msecnode_t's to reduce memory allocs and frees.
 
 msecnode_t *headsecnode = nullptr;
+unsigned int secnodechanges;
 
 // sf: fix annoying crash on restarting levels
 //
@@ -2811,13 +2954,27 @@ void P_FreeSecNodeList(void)
 //
 // killough 11/98: reformatted
 //
+// Nodes are allocated this many at a time, so that a thing's list tends to
+// come from one contiguous block instead of nodes scattered over the zone.
+#define SECNODESLAB 256
+
 static msecnode_t *P_GetSecnode(void)
 {
-   msecnode_t *node;
+   if(!headsecnode)
+   {
+      msecnode_t *slab = emalloctag(msecnode_t *, SECNODESLAB * sizeof(*slab), PU_LEVEL, nullptr);
+
+      // thread it so that nodes are handed out in address order
+      for(int i = SECNODESLAB - 1; i >= 0; i--)
+      {
+         slab[i].m_snext = headsecnode;
+         headsecnode = &slab[i];
+      }
+   }
 
-   return headsecnode ?
-   node = headsecnode, headsecnode = node->m_snext, node :
-      emalloctag(msecnode_t *, sizeof *node, PU_LEVEL, nullptr); 
+   msecnode_t *node = headsecnode;
+   headsecnode = node->m_snext;
+   return node;
 }
 
 //
@@ -2859,6 +3016,7 @@ static msecnode_t *P_AddSecnode(sector_t *s, Mobj *thing, msecnode_t *nextnode)
    // of the list.
    
    node = P_GetSecnode();
+   secnodechanges++;
    
    node->visited = 0;  // killough 4/4/98, 4/7/98: mark new nodes unvisited.
 
@@ -2922,6 +3080,7 @@ static msecnode_t *P_DelSecnode(msecnode_t *node)
       // Return this node to the freelist
       
       P_PutSecnode(node);
+      secnodechanges++;
       
       node = tn;
    }
@@ -3048,7 +3207,23 @@ msecnode_t *P_CreateSecNodeList(Mobj *thing, fixed_t x, fixed_t y)
 {
    msecnode_t *node, *list;
 
-   if(demo_version < 200 || demo_version >= 329)
+   // A thing relinked where its list was last built gets the same list back,
+   // node for node, as long as only static lines decide which sectors it
+   // touches: that rules out polyobjects and the portal-aware path below.
+   // Versions that build into the caller's clip state rather than a pushed
+   // one must still leave that state behind, so they always take the walk.
+   const bool portalaware = useportalgroups && full_demo_version >= make_full_version(340, 48);
+   const bool pushclip    = demo_version < 200 || demo_version >= 329;
+   if(pushclip && thing->old_sectorlist && !portalaware && !numPolyObjects &&
+      x == thing->secnodex && y == thing->secnodey && thing->radius == thing->secnoderadius)
+   {
+      return thing->old_sectorlist;
+   }
+   thing->secnodex      = x;
+   thing->secnodey      = y;
+   thing->secnoderadius = thing->radius;
+
+   if(pushclip)
       P_PushClipStack();
 
    // First, clear out the existing m_thing fields. As each node is
@@ -3076,7 +3251,7 @@ msecnode_t *P_CreateSecNodeList(Mobj *thing, fixed_t x, fixed_t y)
    // ioanch 20160115: use portal-aware gathering if there are portals. Sectors
    // may be touched both horizontally (like in Doom) or vertically (thing
    // touching portals
-   if(useportalgroups && full_demo_version >= make_full_version(340, 48))
+   if(portalaware)
    {
       // FIXME: unfortunately all sectors need to be added, because this function
       // is only called on XY coordinate change.
@@ -3161,7 +3336,7 @@ msecnode_t *P_CreateSecNodeList(Mobj *thing, fixed_t x, fixed_t y)
    *  Boom/MBF demo. -- haleyjd: add SMMU too :)
    */
 
-   if(demo_version < 200 || demo_version >= 329)
+   if(pushclip)
       P_PopClipStack();
 
    return list;
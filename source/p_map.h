@@ -76,6 +76,7 @@ extern bool donut_emulation;    // haleyjd 10/16/09
 bool P_TryMove(Mobj *thing, fixed_t x, fixed_t y, int dropoff);
 
 bool P_CheckPosition(Mobj *thing, fixed_t x, fixed_t y, PODCollection<line_t *> *pushhit = nullptr);
+bool P_NothingInReach(const Mobj *thing, fixed_t x, fixed_t y);
 
 bool PIT_CheckLine(line_t *ld, polyobj_t *po, void *context);  // ioanch: used in the code
 
@@ -120,6 +121,9 @@ bool P_TeleportMoveStrict(Mobj *thing, fixed_t x, fixed_t y, bool boss);
 //
 
 bool P_CheckSight(Mobj *t1, Mobj *t2);
+
+extern bool p_aiprefetch;
+void P_ResetSightPrefetch();
 void P_UseLines(player_t *player);
 
 // killough 8/2/98: add 'mask' argument to prevent friends autoaiming at others
@@ -183,6 +187,10 @@ void P_DelSeclist(msecnode_t *); // phares 3/16/98
 void P_FreeSecNodeList();        // sf
 msecnode_t *P_CreateSecNodeList(Mobj *, fixed_t, fixed_t);  // phares 3/14/98
 
+// Bumped whenever a sector node is created or destroyed, or a touch list has
+// its visited marks reset
+extern unsigned int secnodechanges;
+
 //=============================================================================
 //
 // MapInter Structure
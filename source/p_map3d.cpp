@@ -549,6 +549,16 @@ bool P_CheckPosition3D(Mobj *thing, fixed_t x, fixed_t y, PODCollection<line_t *
    if(clip.thing->flags & MF_NOCLIP && !(clip.thing->flags & MF_SKULLFLY))
       return true;
 
+   // Nothing near enough to touch: what's left of the full check below is the
+   // fit between floor and ceiling.
+   if(!(clip.thing->flags & MF_NOCLIP) && P_NothingInReach(thing, x, y))
+   {
+      clip.BlockingMobj = nullptr;
+      clip.numportalhit = 0;
+      stepthing = nullptr;
+      return clip.zref.ceiling - clip.zref.floor >= thing->height;
+   }
+
    // Check things first, possibly picking things up.
    // The bounding box is extended by MAXRADIUS
    // because Mobjs are grouped into mapblocks
@@ -664,8 +674,21 @@ bool P_CheckPosition3D(Mobj *thing, fixed_t x, fixed_t y, PODCollection<line_t *
    if(!P_TransPortalBlockWalker(bbox, thing->groupid, true, pushhit, 
       [](int x, int y, int groupid, void *data) -> bool
    {
+      // PIT_CheckLine3D moves the box by the link to the lines' group
+      fixed_t linebbox[4];
+      memcpy(linebbox, clip.bbox, sizeof(linebbox));
+      if(groupid != R_NOGROUP && useportalgroups &&
+         full_demo_version >= make_full_version(340, 48))
+      {
+         const linkoffset_t *link = P_GetLinkOffset(clip.thing->groupid, groupid);
+         linebbox[BOXLEFT]   += link->x;
+         linebbox[BOXRIGHT]  += link->x;
+         linebbox[BOXBOTTOM] += link->y;
+         linebbox[BOXTOP]    += link->y;
+      }
+
       // ioanch 20160112: try 3D portal check-line
-      if(!P_BlockLinesIterator(x, y, PIT_CheckLine3D, groupid, data))
+      if(!P_BlockLinesIteratorBox(x, y, linebbox, PIT_CheckLine3D, groupid, data))
          return false; // doesn't fit
       return true;
    }))
@@ -1298,19 +1321,23 @@ bool P_ChangeSector3D(sector_t *sector, int crunch, int amt, CheckSectorPlane pl
 
    for (n = sector->touching_thinglist; n; n = n->m_snext)
       n->visited = false;
+   secnodechanges++;
+
+   // as in P_CheckSector, carry on after the last thing unless nodes changed
+   const bool portalaware = useportalgroups && full_demo_version >= make_full_version(340, 48);
+   msecnode_t *start = sector->touching_thinglist;
 
    do
    {
-      for(n = sector->touching_thinglist; n; n = n->m_snext) // go through list
+      for(n = start; n; n = n->m_snext) // go through list
       {
          // ioanch 20160115: portal aware
-         if(useportalgroups && full_demo_version >= make_full_version(340, 48) &&
-            !P_SectorTouchesThingVertically(sector, n->m_thing))
-         {
+         if(portalaware && !P_SectorTouchesThingVertically(sector, n->m_thing))
             continue;
-         }
          if(!n->visited) // unprocessed thing found
          {
+            const unsigned int changes = secnodechanges;
+
             n->visited = true;                       // mark thing as processed
             if(!(n->m_thing->flags & MF_NOBLOCKMAP)) // jff 4/7/98 don't do these
             {
@@ -1318,6 +1345,11 @@ bool P_ChangeSector3D(sector_t *sector, int crunch, int amt, CheckSectorPlane pl
                if(iterator2)
                   iterator2(n->m_thing);
             }
+
+            if(!portalaware && secnodechanges == changes)
+               start = n->m_snext;
+            else
+               start = sector->touching_thinglist;
             break;                                   // exit and start over
          }
       }
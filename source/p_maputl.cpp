@@ -33,9 +33,11 @@
 #include "e_exdata.h"
 #include "ev_specials.h"
 #include "m_bbox.h"
+#include "m_compare.h"
 #include "p_map.h"
 #include "p_map3d.h"
 #include "p_maputl.h"
+#include "p_mobjtable.h"
 #include "p_portalclip.h"
 #include "p_setup.h"
 #include "p_spec.h"
@@ -82,6 +84,25 @@ int P_PointOnLineSidePrecise(fixed_t x, fixed_t y, const line_t *line)
 }
 int (*P_PointOnLineSide)(fixed_t x, fixed_t y, const line_t *line) = P_PointOnLineSideClassic;
 
+//
+// The same, from a line's linehot row
+//
+int P_PointOnLineHotSideClassic(fixed_t x, fixed_t y, const linehot_t &lh)
+{
+   return
+      !lh.dx ? x <= lh.x1 ? lh.dy > 0 : lh.dy < 0 :
+      !lh.dy ? y <= lh.y1 ? lh.dx < 0 : lh.dx > 0 :
+      FixedMul(y-lh.y1, lh.dx>>FRACBITS) >=
+      FixedMul(lh.dy>>FRACBITS, x-lh.x1);
+}
+int P_PointOnLineHotSidePrecise(fixed_t x, fixed_t y, const linehot_t &lh)
+{
+   return !lh.dx ? x <= lh.x1 ? lh.dy > 0 : lh.dy < 0 :
+   !lh.dy ? y <= lh.y1 ? lh.dx < 0 : lh.dx > 0 :
+   ((int64_t)y - lh.y1) * lh.dx >= lh.dy * ((int64_t)x - lh.x1);
+}
+int (*P_PointOnLineHotSide)(fixed_t x, fixed_t y, const linehot_t &lh) = P_PointOnLineHotSideClassic;
+
 //
 // P_BoxOnLineSide
 // Considers the line to be infinite
@@ -115,6 +136,35 @@ int P_BoxOnLineSide(const fixed_t *tmbox, const line_t *ld)
     }
 }
 
+//
+// The same, from a line's linehot row
+//
+int P_BoxOnLineSide(const fixed_t *tmbox, const linehot_t &lh)
+{
+   int p;
+
+   switch(lh.slopetype)
+   {
+   default:
+   case ST_HORIZONTAL:
+      return
+      (tmbox[BOXBOTTOM] > lh.y1) == (p = tmbox[BOXTOP] > lh.y1) ?
+        p ^ (lh.dx < 0) : -1;
+   case ST_VERTICAL:
+      return
+        (tmbox[BOXLEFT] < lh.x1) == (p = tmbox[BOXRIGHT] < lh.x1) ?
+        p ^ (lh.dy < 0) : -1;
+   case ST_POSITIVE:
+      return
+        P_PointOnLineHotSide(tmbox[BOXRIGHT], tmbox[BOXBOTTOM], lh) ==
+        (p = P_PointOnLineHotSide(tmbox[BOXLEFT], tmbox[BOXTOP], lh)) ? p : -1;
+   case ST_NEGATIVE:
+      return
+        (P_PointOnLineHotSide(tmbox[BOXLEFT], tmbox[BOXBOTTOM], lh)) ==
+        (p = P_PointOnLineHotSide(tmbox[BOXRIGHT], tmbox[BOXTOP], lh)) ? p : -1;
+   }
+}
+
 //
 // Floating-point version
 //
@@ -553,6 +603,50 @@ void P_LogThingPosition(Mobj *mo, const char *caller)
 #define P_LogThingPosition(a, b)
 #endif
 
+//
+// Appends a thing just linked at the head of a block's chain to the block's
+// contiguous list.
+//
+static void P_addBlockThing(Mobj *thing, int cell)
+{
+   blockthings_t &block = blockthings[cell];
+
+   if(block.numthings == block.numalloc)
+   {
+      block.numalloc = block.numalloc ? block.numalloc * 2 : 4;
+      block.things = erealloctag(Mobj **, block.things,
+                                 block.numalloc * sizeof(*block.things), PU_LEVEL, nullptr);
+   }
+   thing->bcell = cell;
+   thing->bslot = block.numthings;
+   block.things[block.numthings++] = thing;
+   ++block.changes;
+}
+
+//
+// Takes a thing out of its block's contiguous list, keeping the others in
+// chain order.
+//
+static void P_removeBlockThing(Mobj *thing)
+{
+   if(thing->bcell < 0 || thing->bcell >= bmapwidth * bmapheight)
+      return;
+   blockthings_t &block = blockthings[thing->bcell];
+   const int slot = thing->bslot;
+
+   if(slot < 0 || slot >= block.numthings || block.things[slot] != thing)
+      return;
+
+   for(int i = slot + 1; i < block.numthings; i++)
+   {
+      block.things[i - 1] = block.things[i];
+      block.things[i - 1]->bslot = i - 1;
+   }
+   --block.numthings;
+   ++block.changes;
+   thing->bcell = -1;
+}
+
 //
 // P_UnsetThingPosition
 // Unlinks a thing from block map and sectors.
@@ -608,7 +702,39 @@ void P_UnsetThingPosition(Mobj *thing)
       Mobj *bnext, **bprev = thing->bprev;
       if(bprev && (*bprev = bnext = thing->bnext))  // unlink from block map
          bnext->bprev = bprev;
+      if(bprev)
+         P_removeBlockThing(thing);
+   }
+}
+
+//
+// Grows the thing bounds of the sector the thing is linked in so that they
+// cover every position the renderer may interpolate it at. The bounds only
+// ever grow during a level; they let R_AddSprites skip whole sectors. Pass
+// withprev as false while prevpos is not valid yet.
+//
+void P_AddThingToSectorBox(const Mobj *thing, bool withprev)
+{
+   if(!pSectorBoxes || !thing->subsector || (thing->flags & MF_NOSECTOR))
+      return;
+
+   sectorbox_t &box = pSectorBoxes[thing->subsector->sector - sectors];
+
+   M_AddToBox2(box.thingbox, thing->x, thing->y);
+   if(withprev)
+   {
+      v2fixed_t prev = { thing->prevpos.x, thing->prevpos.y };
+      if(thing->prevpos.ldata)
+      {
+         prev.x += thing->prevpos.ldata->delta.x;
+         prev.y += thing->prevpos.ldata->delta.y;
+      }
+      M_AddToBox2(box.thingbox, prev.x, prev.y);
    }
+
+   const float xscale = fabsf(thing->xscale);
+   if(xscale > box.thingxscale)
+      box.thingxscale = xscale;
 }
 
 //
@@ -629,6 +755,8 @@ void P_SetThingPosition(Mobj *thing)
 
    thing->groupid = ss->sector->groupid;
 
+   P_UpdateMobjTableRow(thing);
+
    if(!(thing->flags & MF_NOSECTOR))
    {
       // invisible things don't go into the sector links
@@ -643,6 +771,9 @@ void P_SetThingPosition(Mobj *thing)
       thing->sprev = link;
       *link = thing;
 
+      // prevpos is only set up after the first link of a new thing
+      P_AddThingToSectorBox(thing, prevss != nullptr);
+
       // phares 3/16/98
       //
       // If sector_list isn't nullptr, it has a collection of sector
@@ -686,11 +817,14 @@ void P_SetThingPosition(Mobj *thing)
             bnext->bprev = &thing->bnext;
          thing->bprev = link;
          *link = thing;
+
+         P_addBlockThing(thing, blocky*bmapwidth+blockx);
       }
       else        // thing is off the map
       {
          thing->bnext = nullptr;
          thing->bprev = nullptr;
+         thing->bcell = -1;
       }
    }
 }
@@ -744,30 +878,14 @@ bool ThingIsOnLine(const Mobj *t, const line_t *l)
 //
 
 //
-// P_BlockLinesIterator
-// The validcount flags are used to avoid checking lines
-// that are marked in multiple mapblocks,
-// so increment validcount before the first call
-// to P_BlockLinesIterator, then make one or more calls
-// to it.
-//
-// killough 5/3/98: reformatted, cleaned up
-// ioanch 20160111: added groupid
-// ioanch 20160114: enhanced the callback
+// Calls func on the lines of the polyobjects linked into a block, once each
+// per validcount.
 //
-bool P_BlockLinesIterator(int x, int y, bool func(line_t*, polyobj_t*, void *), int groupid,
-   void *context)
+static bool P_blockPolyLinesIterator(int offset, bool func(line_t *, polyobj_t *, void *),
+                                     void *context)
 {
-   int        offset;
-   const int  *list;     // killough 3/1/98: for removal of blockmap limit
-   DLListItem<polymaplink_t> *plink; // haleyjd 02/22/06
-   
-   if(x < 0 || y < 0 || x >= bmapwidth || y >= bmapheight)
-      return true;
-   offset = y * bmapwidth + x;
-
    // haleyjd 02/22/06: consider polyobject lines
-   plink = polyblocklinks[offset];
+   DLListItem<polymaplink_t> *plink = polyblocklinks[offset];
 
    while(plink)
    {
@@ -790,6 +908,34 @@ bool P_BlockLinesIterator(int x, int y, bool func(line_t*, polyobj_t*, void *),
       plink = plink->dllNext;
    }
 
+   return true;
+}
+
+//
+// P_BlockLinesIterator
+// The validcount flags are used to avoid checking lines
+// that are marked in multiple mapblocks,
+// so increment validcount before the first call
+// to P_BlockLinesIterator, then make one or more calls
+// to it.
+//
+// killough 5/3/98: reformatted, cleaned up
+// ioanch 20160111: added groupid
+// ioanch 20160114: enhanced the callback
+//
+bool P_BlockLinesIterator(int x, int y, bool func(line_t*, polyobj_t*, void *), int groupid,
+   void *context)
+{
+   int        offset;
+   const int  *list;     // killough 3/1/98: for removal of blockmap limit
+   
+   if(x < 0 || y < 0 || x >= bmapwidth || y >= bmapheight)
+      return true;
+   offset = y * bmapwidth + x;
+
+   if(!P_blockPolyLinesIterator(offset, func, context))
+      return false;
+
    // original was reading delimiting 0 as linedef 0 -- phares
    offset = *(blockmap + offset);
    list = blockmaplump + offset;
@@ -828,6 +974,68 @@ bool P_BlockLinesIterator(int x, int y, bool func(line_t*, polyobj_t*, void *),
    return true;  // everything was checked
 }
 
+//
+// P_BlockLinesIteratorBox
+//
+// As P_BlockLinesIterator, for callbacks that reject every line whose bounding
+// box doesn't overlap bbox. The block's line boxes are tested in runs first,
+// a loop the compiler can vectorise, and only lines that pass are marked and
+// handed to func, in list order. A line failing here fails in every block, so
+// leaving it unmarked changes nothing.
+//
+bool P_BlockLinesIteratorBox(int x, int y, const fixed_t bbox[4],
+                             bool func(line_t *, polyobj_t *, void *), int groupid,
+                             void *context)
+{
+   if(!blocklines)
+      return P_BlockLinesIterator(x, y, func, groupid, context);
+
+   if(x < 0 || y < 0 || x >= bmapwidth || y >= bmapheight)
+      return true;
+   const int offset = y * bmapwidth + x;
+
+   if(!P_blockPolyLinesIterator(offset, func, context))
+      return false;
+
+   const blocklines_t &block = blocklines[offset];
+   const fixed_t bleft = bbox[BOXLEFT], bright = bbox[BOXRIGHT];
+   const fixed_t bbottom = bbox[BOXBOTTOM], btop = bbox[BOXTOP];
+   constexpr int RUN = 64;
+   byte touches[RUN];
+
+   // same start delimiter rule as P_BlockLinesIterator
+   int start = 0;
+   if((!demo_compatibility && demo_version < 342) || (demo_version >= 342 && skipblstart))
+      start = 1;
+
+   for(int run = start; run < block.numlines; run += RUN)
+   {
+      const int count = emin(block.numlines - run, RUN);
+
+      for(int i = 0; i < count; i++)
+      {
+         touches[i] = (bright > block.left[run + i]) & (bleft < block.right[run + i]) &
+                      (btop > block.bottom[run + i]) & (bbottom < block.top[run + i]);
+      }
+
+      for(int i = 0; i < count; i++)
+      {
+         if(!touches[i])
+            continue;
+
+         line_t *ld = &lines[block.lines[run + i]];
+         if(groupid != R_NOGROUP && groupid != ld->frontsector->groupid)
+            continue;
+         if(ld->validcount == validcount)
+            continue;       // line has already been checked
+         ld->validcount = validcount;
+         if(!func(ld, nullptr, context))
+            return false;
+      }
+   }
+   return true;  // everything was checked
+}
+
 //
 // P_BlockThingsIterator
 //
@@ -837,17 +1045,44 @@ bool P_BlockLinesIterator(int x, int y, bool func(line_t*, polyobj_t*, void *),
 bool P_BlockThingsIterator(int x, int y, int groupid, bool (*func)(Mobj *, void *),
                            void *context)
 {
-   if(!(x < 0 || y < 0 || x >= bmapwidth || y >= bmapheight))
+   if(x < 0 || y < 0 || x >= bmapwidth || y >= bmapheight)
+      return true;
+
+   // Walk the contiguous list while the block stays as it was; once func has
+   // linked or unlinked anything here, carry on down the chain from the last
+   // thing visited, exactly as the chain alone would have gone.
+   const blockthings_t &block = blockthings[y * bmapwidth + x];
+   Mobj *resume = nullptr;
+
+   for(int i = block.numthings - 1; i >= 0; i--)
    {
-      Mobj *mobj = blocklinks[y * bmapwidth + x];
+      Mobj *mobj = block.things[i];
 
-      for(; mobj; mobj = mobj->bnext)
+      // ioanch: if mismatching group id (in case it's declared), skip
+      if(groupid != R_NOGROUP && mobj->groupid != R_NOGROUP &&
+         groupid != mobj->groupid)
+      {
+         continue;   // ignore objects from wrong groupid
+      }
+
+      const unsigned int changes = block.changes;
+      if(!func(mobj, context))
+         return false;
+      if(block.changes != changes)
+      {
+         resume = mobj;
+         break;
+      }
+   }
+
+   if(resume)
+   {
+      for(Mobj *mobj = resume->bnext; mobj; mobj = mobj->bnext)
       {
-         // ioanch: if mismatching group id (in case it's declared), skip
-         if(groupid != R_NOGROUP && mobj->groupid != R_NOGROUP && 
+         if(groupid != R_NOGROUP && mobj->groupid != R_NOGROUP &&
             groupid != mobj->groupid)
          {
-            continue;   // ignore objects from wrong groupid
+            continue;
          }
          if(!func(mobj, context))
             return false;
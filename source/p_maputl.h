@@ -31,6 +31,7 @@
 #include "tables.h" // for angle_t
 
 struct line_t;
+struct linehot_t;
 struct lineopening_t;
 class  Mobj;
 struct mobjinfo_t;
@@ -114,6 +115,10 @@ int P_PointOnLineSideClassic(fixed_t x, fixed_t y, const line_t *line);
 int P_PointOnLineSidePrecise(fixed_t x, fixed_t y, const line_t *line);
 extern int (*P_PointOnLineSide)(fixed_t x, fixed_t y, const line_t *line);
 
+int P_PointOnLineHotSideClassic(fixed_t x, fixed_t y, const linehot_t &lh);
+int P_PointOnLineHotSidePrecise(fixed_t x, fixed_t y, const linehot_t &lh);
+extern int (*P_PointOnLineHotSide)(fixed_t x, fixed_t y, const linehot_t &lh);
+
 int P_PointOnDivlineSideClassic(fixed_t x, fixed_t y, const divline_t *line);
 int P_PointOnDivlineSidePrecise(fixed_t x, fixed_t y, const divline_t *line);
 extern int (*P_PointOnDivlineSide)(fixed_t x, fixed_t y, const divline_t *line);
@@ -121,6 +126,7 @@ extern int (*P_PointOnDivlineSide)(fixed_t x, fixed_t y, const divline_t *line);
 void    P_MakeDivline(const line_t *li, divline_t *dl);
 fixed_t P_InterceptVector(const divline_t *v2, const divline_t *v1);
 int     P_BoxOnLineSide(const fixed_t *tmbox, const line_t *ld);
+int     P_BoxOnLineSide(const fixed_t *tmbox, const linehot_t &lh);
 // ioanch 20160123: for linedef portal clipping.
 v2fixed_t P_BoxLinePoint(const fixed_t bbox[4], const line_t *ld);
 int P_LineIsCrossed(const line_t &line, const divline_t &dl);
@@ -137,8 +143,12 @@ lineopening_t P_LineOpening(const line_t *linedef, const Mobj *mo,
 
 void P_UnsetThingPosition(Mobj *thing);
 void P_SetThingPosition(Mobj *thing);
+void P_AddThingToSectorBox(const Mobj *thing, bool withprev);
 bool P_BlockLinesIterator (int x, int y, bool func(line_t *, polyobj_t *, void *),
                            int groupid = R_NOGROUP, void *context = nullptr);
+bool P_BlockLinesIteratorBox(int x, int y, const fixed_t bbox[4],
+                             bool func(line_t *, polyobj_t *, void *),
+                             int groupid = R_NOGROUP, void *context = nullptr);
 bool P_BlockThingsIterator(int x, int y, int groupid, bool (*func)(Mobj *, void *),
                            void *context = nullptr);
 inline static bool P_BlockThingsIterator(int x, int y, bool func(Mobj *, void *),
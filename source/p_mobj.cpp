@@ -27,6 +27,7 @@
 #include "a_args.h"
 #include "a_small.h"
 #include "c_io.h" // ioanch
+#include "c_runcmd.h"
 #include "d_dehtbl.h"
 #include "d_gi.h"
 #include "d_mod.h"
@@ -56,12 +57,15 @@
 #include "p_map.h"
 #include "p_maputl.h"
 #include "p_map3d.h"
+#include "p_mobjtable.h"
 #include "p_partcl.h"
 #include "p_portal.h"
+#include "p_profile.h"
 #include "p_portalcross.h"
 #include "p_saveg.h"
 #include "p_saveid.h"
 #include "p_sector.h"
+#include "p_setup.h"
 #include "p_skin.h"
 #include "p_tick.h"
 #include "p_spec.h"    // haleyjd 04/05/99: TerrainTypes
@@ -141,7 +145,8 @@ void PointThinker::serialize(SaveArchive &arc)
 {
    Super::serialize(arc);
 
-   arc << x << y << z << groupid;
+   arc.archivePosition(x, y, z);
+   arc << groupid;
 }
 
 //
@@ -162,110 +167,18 @@ void PointThinker::remove()
 // Mobj
 //
 
-// haleyjd 03/27/10: new solution for state cycle detection
-struct seenstate_t
-{
-   DLListItem<seenstate_t> link;
-   int statenum;
-};
-
-// haleyjd 03/27/10: freelist of seenstate objects
-static DLListItem<seenstate_t> *seenstate_freelist;
-
-//
-// P_InitSeenStates
-//
-// haleyjd 03/27/10: creates an initial pool of seenstate objects.
-//
-static void P_InitSeenStates(void)
-{
-   seenstate_t *newss;
-   int i;
-
-   newss = ecalloc(seenstate_t *, 32, sizeof(seenstate_t));
-
-   for(i = 0; i < 32; ++i)
-      newss[i].link.insert(&newss[i], &seenstate_freelist);
-}
-
-//
-// P_FreeSeenStates
-//
-// haleyjd 03/27/10: puts a set of seenstates back onto the freelist
-//
-static void P_FreeSeenStates(DLListItem<seenstate_t> *list)
-{
-   DLListItem<seenstate_t> *oldhead = seenstate_freelist;
-   DLListItem<seenstate_t> *newtail = list;
-
-   // find tail of list of objects to free
-   while(newtail->dllNext)
-      newtail = newtail->dllNext;
-
-   // attach current freelist to tail
-   newtail->dllNext = oldhead;
-   if(oldhead)
-      oldhead->dllPrev = &newtail->dllNext;
-
-   // attach new list to seenstate_freelist
-   seenstate_freelist = list;
-   list->dllPrev = &seenstate_freelist;
-}
-
-//
-// P_GetSeenState
-//
-// Gets a seenstate from the free list if one is available, or creates a
-// new one.
-//
-static seenstate_t *P_GetSeenState()
-{
-   seenstate_t *ret;
-
-   if(seenstate_freelist)
-   {
-      DLListItem<seenstate_t> *item = seenstate_freelist;
-
-      item->remove();
-
-      ret = *item;
-      memset(ret, 0, sizeof(seenstate_t));
-   }
-   else
-      ret = ecalloc(seenstate_t *, 1, sizeof(seenstate_t));
-
-   return ret;
-}
-
-//
-// P_AddSeenState
-//
-// Marks a new state as having been seen.
-//
-static void P_AddSeenState(int statenum, DLListItem<seenstate_t> **list)
-{
-   seenstate_t *newss = P_GetSeenState();
-
-   newss->statenum = statenum;
-
-   newss->link.insert(newss, list);
-}
-
 //
-// P_CheckSeenState
+// P_checkSeenState
 //
-// Checks if the given state has been seen
+// Checks if the given state has been seen. Zero-tic chains are short, so a
+// search of the few states in the inline storage is as fast as any lookup.
 //
-static bool P_CheckSeenState(int statenum, DLListItem<seenstate_t> *list)
+static bool P_checkSeenState(int statenum, const PODCollection<int> &seenstates)
 {
-   DLListItem<seenstate_t> *link = list;
-
-   while(link)
+   for(const int seen : seenstates)
    {
-      if(statenum == (*link)->statenum)
+      if(seen == statenum)
          return true;
-
-      link = link->dllNext;
    }
 
    return false;
@@ -320,16 +233,11 @@ bool P_SetMobjState(Mobj* mobj, statenum_t state)
    state_t *st;
 
    // haleyjd 03/27/10: new state cycle detection
-   static bool firsttime = true; // for initialization
-   DLListItem<seenstate_t> *seenstates  = nullptr; // list of seenstates for this instance
+   // States seen by this call; only a chain longer than the inline storage
+   // allocates.
+   SmallPODCollection<int, 32> seenstates;
    bool ret = true;                           // return value
 
-   if(firsttime)
-   {
-      P_InitSeenStates();
-      firsttime = false;
-   }
-
    do
    {
       if(state == NullStateNum)
@@ -366,26 +274,30 @@ bool P_SetMobjState(Mobj* mobj, statenum_t state)
          actionargs.args       = st->args;
          actionargs.pspr       = nullptr;
 
-         st->action(&actionargs);
+         if(p_profiling)
+         {
+            const int  type  = mobj->type; // the action may remove mobj
+            const auto start = std::chrono::steady_clock::now();
+            st->action(&actionargs);
+            P_ProfileAction(state, type, std::chrono::steady_clock::now() - start);
+         }
+         else
+            st->action(&actionargs);
       }
 
       // haleyjd 05/20/02: run particle events
       if(st->particle_evt)
          P_RunEvent(mobj);
 
-      P_AddSeenState(state, &seenstates);
+      seenstates.add(state);
 
       state = st->nextstate;
    }
-   while(!mobj->tics && !P_CheckSeenState(state, seenstates));
+   while(!mobj->tics && !P_checkSeenState(state, seenstates));
    
    if(ret && !mobj->tics)  // killough 4/9/98: detect state cycles
       doom_printf(FC_ERROR "Warning: State Cycle Detected");
 
-   // put seenstates onto freelist
-   if(seenstates)
-      P_FreeSeenStates(seenstates);
-
    --recursion;
    return ret;
 }
@@ -1426,6 +1338,60 @@ inline static void P_checkMobjProjections(Mobj &mobj)
    }
 }
 
+//
+// Dormant monsters
+//
+// Outside demos and netgames, p_dormantmonsters lets sleeping monsters that
+// no player could hear or see think only one tic in DORMANTPERIOD. A monster
+// is dormant while it sits at rest in its spawn state with no target, no
+// sound has reached its sector, and REJECT rules out sight between its
+// sector and that of every player. Any noise or a player coming within sight
+// range puts it back on every tic before A_Look would have noticed anything.
+// Things flagged NEVERDORMANT, or given a TID, always think.
+//
+
+bool p_dormantmonsters;
+
+VARIABLE_TOGGLE(p_dormantmonsters, nullptr, onoff);
+CONSOLE_VARIABLE(p_dormantmonsters, p_dormantmonsters, 0) {}
+
+static constexpr int DORMANTPERIOD = 8; // power of two
+
+static bool P_mobjIsDormant(const Mobj &mo)
+{
+   // things with a TID belong to scripts, which may expect them awake
+   if(!(mo.flags & MF_COUNTKILL) || (mo.flags5 & MF5_NEVERDORMANT) || mo.tid || mo.player ||
+      mo.target || mo.health <= 0 || mo.state != states[mo.info->spawnstate])
+      return false;
+
+   // must be entirely at rest
+   if(mo.momx | mo.momy | mo.momz || (mo.flags & MF_SKULLFLY) || (mo.flags2 & MF2_FLOATBOB) ||
+      (mo.z != mo.zref.floor && !(mo.flags & MF_NOGRAVITY)))
+      return false;
+
+   const sector_t *sector = mo.subsector->sector;
+   if(sector->soundtarget)
+      return false;
+
+   const int snum = eindex(sector - sectors);
+   for(int i = 0; i < MAXPLAYERS; i++)
+   {
+      const Mobj *pmo = players[i].mo;
+      if(!playeringame[i] || !pmo)
+         continue;
+
+      // reject says nothing across portal groups
+      if(pmo->groupid != mo.groupid)
+         return false;
+
+      const int pnum = eindex(pmo->subsector->sector - sectors) * numsectors + snum;
+      if(!(rejectmatrix[pnum >> 3] & (1 << (pnum & 7))))
+         return false;
+   }
+
+   return true;
+}
+
 //
 // P_MobjThinker
 //
@@ -1445,6 +1411,10 @@ void Mobj::Think()
    if(!player || player->mo != this)
       backupPosition();
 
+   if(p_dormantmonsters && ((leveltime + tablerow) & (DORMANTPERIOD - 1)) &&
+      !demoplayback && !demorecording && !netgame && P_mobjIsDormant(*this))
+      return;
+
    // killough 11/98:
    // removed old code which looked at target references
    // (we use pointer reference counting now)
@@ -1679,8 +1649,14 @@ void Mobj::serialize(SaveArchive &arc)
    arc 
       << tid
       // Position
-      << angle                                             // Angles
-      << momx << momy << momz                              // Momenta
+      << angle;                                            // Angles
+
+   // Momenta
+   arc.archiveVarInt(momx);
+   arc.archiveVarInt(momy);
+   arc.archiveVarInt(momz);
+
+   arc
       << zref                                              // Basic and advanced z coords
       << spawnpoint                                        // Spawn info
       << friction << movefactor                            // BOOM 202 friction
@@ -1697,14 +1673,20 @@ void Mobj::serialize(SaveArchive &arc)
    // sprite
    Archive_SpriteNum(arc, sprite);
 
-   arc
-      << frame << tics
-      // Movement logic and clipping
-      << validcount                                        // Traversals
-      << movedir << movecount << strafecount               // Movement
-      << reactiontime << threshold << pursuecount          // Attack AI
-      << lastlook                                          // More AI
-      << gear;                                             // Lee's torque
+   arc << frame;
+   arc.archiveVarInt(tics);
+
+   // Movement logic and clipping
+   arc << validcount;                                      // Traversals
+
+   arc.archiveVarInt(movedir);                             // Movement
+   arc.archiveVarInt(movecount);
+   arc.archiveVarInt(strafecount);
+   arc.archiveVarInt(reactiontime);                        // Attack AI
+   arc.archiveVarInt(threshold);
+   arc.archiveVarInt(pursuecount);
+   arc.archiveVarInt(lastlook);                            // More AI
+   arc.archiveVarInt(gear);                                // Lee's torque
 
    // Appearance
    // Translations
@@ -1737,20 +1719,22 @@ void Mobj::serialize(SaveArchive &arc)
       Archive_MobjState_Save(arc, *state);
       
       temp = static_cast<unsigned>(player ? player - players + 1 : 0);
-      arc << temp;
+      arc.archiveVarUint(temp);
 
       // Pointers to other mobjs
       targetNum = P_NumForThinker(target);
       tracerNum = P_NumForThinker(tracer);
       enemyNum  = P_NumForThinker(lastenemy);
 
-      arc << targetNum << tracerNum << enemyNum;
+      arc.archiveVarUint(targetNum);
+      arc.archiveVarUint(tracerNum);
+      arc.archiveVarUint(enemyNum);
 
    }
    else // Loading
    {
       // Restore basic pointers
-      int temp;
+      unsigned int temp;
 
       state = &Archive_MobjState_Load(arc);
 
@@ -1763,7 +1747,7 @@ void Mobj::serialize(SaveArchive &arc)
       }
       info = mobjinfo[type];
 
-      arc << temp; // Player number
+      arc.archiveVarUint(temp); // Player number
       if(temp)
       {
          // Mobj is a player body
@@ -1797,7 +1781,9 @@ void Mobj::serialize(SaveArchive &arc)
       dsInfo = estructalloctag(deswizzle_info, 1, PU_LEVEL);
 
       // Get the swizzled pointers
-      arc << dsInfo->target << dsInfo->tracer << dsInfo->lastenemy;
+      arc.archiveVarUint(dsInfo->target);
+      arc.archiveVarUint(dsInfo->tracer);
+      arc.archiveVarUint(dsInfo->lastenemy);
    }
 }
 
@@ -2110,6 +2096,7 @@ void Mobj::remove()
 
    // unlink from sector and block lists
    P_UnsetThingPosition(this);
+   P_RemoveMobjTableRow(this);
 
    // ioanch 20160109: remove portal sprite projections
    R_RemoveMobjProjections(this);
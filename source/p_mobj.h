@@ -177,6 +177,8 @@ struct sprojlast_t
    uint32_t sprite;  // holds both sprite num and frame num
    float yscale;     // if scale changes, sprojheight may also do
    float xscale;
+   int blockbox[4];  // blockmap cells swept at the last line portal check
+   bool nolines;     // and none of them had portal lines
 };
 
 //
@@ -254,6 +256,9 @@ public:
    // Links in blocks (if needed).
    Mobj  *bnext;
    Mobj **bprev; // killough 8/11/98: change to ptr-to-ptr
+   int    bcell; // block and slot in blockthings while linked
+   int    bslot;
+   int    tablerow; // row in mobjtable plus one, or 0
 
    subsector_t *subsector;
 
@@ -342,6 +347,7 @@ public:
    // a linked list of sectors where this object appears
    msecnode_t *touching_sectorlist;                 // phares 3/14/98
    msecnode_t *old_sectorlist;                      // haleyjd 04/16/10
+   fixed_t secnodex, secnodey, secnoderadius;       // where the list was built
 
    // SEE WARNING ABOVE ABOUT POINTER FIELDS!!!
 
@@ -413,6 +419,8 @@ void P_StartMobjFade(Mobj *mo, int alphavelocity);
 // Whether an object is "sentient" or not. Used for environmental influences.
 #define sentient(mobj) ((mobj)->health > 0 && (mobj)->info->seestate != NullStateNum)
 
+extern bool p_dormantmonsters;
+
 extern int iquehead;
 extern int iquetail;
 
@@ -751,6 +759,7 @@ enum mobjflags5_e : unsigned int
    MF5_NOTAUTOAIMED       = 0x00000001, // can't be autoaimed (for real)
    MF5_FULLVOLSOUNDS      = 0x00000002, // full-volume see/death sounds
    MF5_ACTLIKEBRIDGE      = 0x00000004, // unmoved by sector actions, and pickups can sit atop
+   MF5_NEVERDORMANT       = 0x00000008, // always thinks every tic, even with p_dormantmonsters
 };
 
 // killough 9/15/98: Same, but internal flags, not intended for .deh
@@ -0,0 +1,144 @@
+//
+// The Eternity Engine
+// Copyright(C) 2026 James Haley, Max Waine, et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+// Additional terms and conditions compatible with the GPLv3 apply. See the
+// file COPYING-EE for details.
+//
+// Purpose: Structure-of-arrays mirror of the hot Mobj fields.
+//  Every thing in the level owns one row, given out when it is first
+//  positioned and reused after it is removed. A row is refreshed whenever
+//  its thing is relinked, and the whole table once per tic after the
+//  thinkers have run, so that passes over every thing can stream through a
+//  few packed columns instead of the thinker list.
+//
+
+#include "z_zone.h"
+
+#include "m_collection.h"
+#include "p_mobj.h"
+#include "p_mobjtable.h"
+#include "r_defs.h"
+#include "r_state.h"
+
+mobjtable_t mobjtable;
+
+// rows given back by removed things
+static PODCollection<int> freerows;
+
+//
+// Empties the table. Called whenever the thinker list is reset, which is
+// when every thing of the old level is discarded at once.
+//
+void P_ClearMobjTable()
+{
+   mobjtable.numrows = 0;
+   freerows.makeEmpty();
+}
+
+//
+// Grows every column to hold at least one more row.
+//
+static void P_growMobjTable()
+{
+   mobjtable_t &t = mobjtable;
+
+   t.numalloc = t.numalloc ? t.numalloc * 2 : 1024;
+   const size_t n = t.numalloc;
+
+   t.mobj   = erealloc(Mobj **,        t.mobj,   n * sizeof(*t.mobj));
+   t.x      = erealloc(fixed_t *,      t.x,      n * sizeof(*t.x));
+   t.y      = erealloc(fixed_t *,      t.y,      n * sizeof(*t.y));
+   t.z      = erealloc(fixed_t *,      t.z,      n * sizeof(*t.z));
+   t.radius = erealloc(fixed_t *,      t.radius, n * sizeof(*t.radius));
+   t.height = erealloc(fixed_t *,      t.height, n * sizeof(*t.height));
+   t.flags  = erealloc(unsigned int *, t.flags,  n * sizeof(*t.flags));
+   t.sector = erealloc(int *,          t.sector, n * sizeof(*t.sector));
+}
+
+//
+// Copies a thing's fields into its row.
+//
+inline static void P_writeMobjRow(int row, const Mobj *mo)
+{
+   mobjtable_t &t = mobjtable;
+
+   t.x[row]      = mo->x;
+   t.y[row]      = mo->y;
+   t.z[row]      = mo->z;
+   t.radius[row] = mo->radius;
+   t.height[row] = mo->height;
+   t.flags[row]  = mo->flags;
+   t.sector[row] = mo->subsector ? eindex(mo->subsector->sector - sectors) : 0;
+}
+
+//
+// Refreshes a thing's row, giving it one first if it has none yet.
+//
+void P_UpdateMobjTableRow(Mobj *mo)
+{
+   mobjtable_t &t = mobjtable;
+   int row = mo->tablerow - 1;
+
+   if(row < 0 || row >= t.numrows || t.mobj[row] != mo)
+   {
+      if(freerows.getLength())
+         row = freerows.pop();
+      else
+      {
+         if(t.numrows == t.numalloc)
+            P_growMobjTable();
+         row = t.numrows++;
+      }
+      t.mobj[row] = mo;
+      mo->tablerow = row + 1;
+   }
+
+   P_writeMobjRow(row, mo);
+}
+
+//
+// Gives a removed thing's row back.
+//
+void P_RemoveMobjTableRow(Mobj *mo)
+{
+   mobjtable_t &t = mobjtable;
+   const int row = mo->tablerow - 1;
+
+   if(row < 0 || row >= t.numrows || t.mobj[row] != mo)
+      return;
+
+   t.mobj[row] = nullptr;
+   mo->tablerow = 0;
+   freerows.add(row);
+}
+
+//
+// Refreshes every row, catching fields changed without a relink.
+//
+void P_SyncMobjTable()
+{
+   const mobjtable_t &t = mobjtable;
+
+   for(int row = 0; row < t.numrows; row++)
+   {
+      if(const Mobj *mo = t.mobj[row])
+         P_writeMobjRow(row, mo);
+   }
+}
+
+// EOF
+
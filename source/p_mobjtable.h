@@ -0,0 +1,57 @@
+//
+// The Eternity Engine
+// Copyright(C) 2026 James Haley, Max Waine, et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+// Additional terms and conditions compatible with the GPLv3 apply. See the
+// file COPYING-EE for details.
+//
+// Purpose: Structure-of-arrays mirror of the hot Mobj fields.
+//  Every thing in the level owns one row, given out when it is first
+//  positioned and reused after it is removed. A row is refreshed whenever
+//  its thing is relinked, and the whole table once per tic after the
+//  thinkers have run, so that passes over every thing can stream through a
+//  few packed columns instead of the thinker list.
+//
+
+#ifndef P_MOBJTABLE_H__
+#define P_MOBJTABLE_H__
+
+#include "m_fixed.h"
+
+class Mobj;
+
+struct mobjtable_t
+{
+   Mobj        **mobj;    // nullptr in free rows
+   fixed_t      *x, *y, *z;
+   fixed_t      *radius, *height;
+   unsigned int *flags;
+   int          *sector;  // index into sectors
+   int           numrows;
+   int           numalloc;
+};
+
+extern mobjtable_t mobjtable;
+
+void P_ClearMobjTable();
+void P_UpdateMobjTableRow(Mobj *mo);
+void P_RemoveMobjTableRow(Mobj *mo);
+void P_SyncMobjTable();
+
+#endif
+
+// EOF
+
@@ -40,6 +40,7 @@
 #include "p_info.h"
 #include "p_maputl.h"
 #include "p_mobj.h"
+#include "p_mobjtable.h"
 #include "p_partcl.h"
 #include "p_portal.h"
 #include "p_portalcross.h"
@@ -297,7 +298,7 @@ static void P_BFGExplosion(Mobj *actor);
 static void P_GenVelocities(void)
 {
    for(vec3_t &avelocity : avelocities) for(float &component : avelocity)
-      component = M_Random() * 0.01f;
+      component = M_EffectRandom() * 0.01f;
 }
 
 void P_InitParticleEffects(void)
@@ -344,6 +345,27 @@ static void P_SetParticlePosition(particle_t *ptcl)
    ptcl->subsector = ss;
 }
 
+//
+// Brings a particle's links up to date after it has moved. Most particles
+// stay within one sector from tic to tic, and only need their subsector
+// updated rather than being unlinked and relinked.
+//
+static void P_RelinkParticle(particle_t *ptcl)
+{
+   subsector_t *ss = R_PointInSubsector(ptcl->x, ptcl->y);
+
+   if(ptcl->subsector && ptcl->subsector->sector == ss->sector)
+   {
+      ptcl->subsector = ss;
+      return;
+   }
+
+   if(ptcl->subsector)
+      P_UnsetParticlePosition(ptcl);
+   ptcl->seclinks.insert(ptcl, &(ss->sector->ptcllist));
+   ptcl->subsector = ss;
+}
+
 void P_ParticleThinker(void)
 {
    int i;
@@ -358,9 +380,6 @@ void P_ParticleThinker(void)
       particle = Particles + i;
       i = particle->next;
 
-      // haleyjd: unlink the particle from the world
-      P_UnsetParticlePosition(particle);
-
       // haleyjd: particles with fall to ground style don't start
       // fading or counting down their TTL until they hit the floor
       if(!(particle->styleflags & PS_FALLTOGROUND))
@@ -372,6 +391,9 @@ void P_ParticleThinker(void)
          // is it time to kill this particle?
          if(oldtrans < particle->trans || --particle->ttl == 0)
          {
+            // haleyjd: unlink the particle from the world
+            if(particle->subsector)
+               P_UnsetParticlePosition(particle);
             memset(particle, 0, sizeof(particle_t));
             if(prev)
                prev->next = i;
@@ -398,7 +420,7 @@ void P_ParticleThinker(void)
          particle->y += particle->vely;
       }
       particle->z += particle->velz;
-      P_SetParticlePosition(particle);
+      P_RelinkParticle(particle);
       if(P_IsInVoid(particle->x, particle->y, *particle->subsector))
       {
          particle->ttl = 1;
@@ -431,11 +453,10 @@ void P_ParticleThinker(void)
       {
          const linkdata_t *ldata = R_FPLink(psec);
 
-         P_UnsetParticlePosition(particle);
          particle->x += ldata->delta.x;
          particle->y += ldata->delta.y;
          particle->z += ldata->delta.z;
-         P_SetParticlePosition(particle);
+         P_RelinkParticle(particle);
       }
       else if(particle->z < floorheight)
       {
@@ -459,11 +480,10 @@ void P_ParticleThinker(void)
       {
          const linkdata_t *ldata = R_CPLink(psec);
 
-         P_UnsetParticlePosition(particle);
          particle->x += ldata->delta.x;
          particle->y += ldata->delta.y;
          particle->z += ldata->delta.z;
-         P_SetParticlePosition(particle);
+         P_RelinkParticle(particle);
       }
       
       prev = particle;
@@ -516,7 +536,6 @@ static void P_stopParticleAmbientSounds(Mobj *actor, particlesound_e psoundid)
 void P_RunEffects(void)
 {
    int snum = 0;
-   Thinker *th = &thinkercap;
 
    if(camera)
    {
@@ -529,23 +548,25 @@ void P_RunEffects(void)
       snum = eindex(ss->sector - sectors) * numsectors;
    }
 
-   while((th = th->next) != &thinkercap)
+   // the table was synced after the thinkers ran, so it holds every live thing
+   const mobjtable_t &t = mobjtable;
+   for(int row = 0; row < t.numrows; row++)
    {
-      Mobj *mobj;
-      if((mobj = thinker_cast<Mobj *>(th)))
+      Mobj *mobj = t.mobj[row];
+      if(!mobj)
+         continue;
+
+      int rnum = snum + t.sector[row];
+      if(mobj->effects)
       {
-         int rnum = snum + eindex(mobj->subsector->sector - sectors);
-         if(mobj->effects)
-         {
-            // run only if possibly visible
-            if(!(rejectmatrix[rnum >> 3] & (1 << (rnum & 7))))
-               P_RunEffect(mobj, mobj->effects);
-            else
-               P_stopParticleAmbientSounds(mobj, particlesound_MAX);
-         }
+         // run only if possibly visible
+         if(!(rejectmatrix[rnum >> 3] & (1 << (rnum & 7))))
+            P_RunEffect(mobj, mobj->effects);
          else
             P_stopParticleAmbientSounds(mobj, particlesound_MAX);
       }
+      else
+         P_stopParticleAmbientSounds(mobj, particlesound_MAX);
    }
 }
 
@@ -556,8 +577,8 @@ void P_RunEffects(void)
 
 #define FADEFROMTTL(a) (FRACUNIT/(a))
 
-#define PARTICLE_VELRND ((FRACUNIT / 4096)  * (M_Random() - 128))
-#define PARTICLE_ACCRND ((FRACUNIT / 16384) * (M_Random() - 128))
+#define PARTICLE_VELRND ((FRACUNIT / 4096)  * (M_EffectRandom() - 128))
+#define PARTICLE_ACCRND ((FRACUNIT / 16384) * (M_EffectRandom() - 128))
 
 static particle_t *JitterParticle(int ttl)
 {
@@ -593,8 +614,8 @@ static void MakeFountain(Mobj *actor, byte color1, byte color2)
    
    if(particle)
    {
-      angle_t an  = M_Random()<<(24-ANGLETOFINESHIFT);
-      fixed_t out = FixedMul(actor->radius, M_Random()<<8);
+      angle_t an  = M_EffectRandom()<<(24-ANGLETOFINESHIFT);
+      fixed_t out = FixedMul(actor->radius, M_EffectRandom()<<8);
       
       particle->x = actor->x + FixedMul(out, finecosine[an]);
       particle->y = actor->y + FixedMul(out, finesine[an]);
@@ -607,7 +628,7 @@ static void MakeFountain(Mobj *actor, byte color1, byte color2)
          particle->velz += FRACUNIT*3;
       
       particle->accz -= FRACUNIT/11;
-      if(M_Random() < 30)
+      if(M_EffectRandom() < 30)
       {
          particle->size = 4;
          particle->color = color2;
@@ -653,16 +674,16 @@ static void P_RunEffect(Mobj *actor, unsigned int effects)
       
       angle_t an = (moveangle + ANG90) >> ANGLETOFINESHIFT;
 
-      particle_t *particle = JitterParticle(3 + (M_Random() & 31));
+      particle_t *particle = JitterParticle(3 + (M_EffectRandom() & 31));
       if(particle)
       {
-         fixed_t pathdist = M_Random()<<8;
+         fixed_t pathdist = M_EffectRandom()<<8;
          particle->x = backx - FixedMul(actor->momx, pathdist);
          particle->y = backy - FixedMul(actor->momy, pathdist);
          particle->z = backz - FixedMul(actor->momz, pathdist);
          P_SetParticlePosition(particle);
 
-         speed = (M_Random () - 128) * (FRACUNIT/200);
+         speed = (M_EffectRandom() - 128) * (FRACUNIT/200);
          particle->velx += FixedMul(speed, finecosine[an]);
          particle->vely += FixedMul(speed, finesine[an]);
          particle->velz -= FRACUNIT/36;
@@ -674,22 +695,22 @@ static void P_RunEffect(Mobj *actor, unsigned int effects)
       
       for(i = 6; i; --i)
       {
-         particle_t *iparticle = JitterParticle(3 + (M_Random() & 31));
+         particle_t *iparticle = JitterParticle(3 + (M_EffectRandom() & 31));
          if(iparticle)
          {
-            fixed_t pathdist = M_Random() << 8;
+            fixed_t pathdist = M_EffectRandom() << 8;
             iparticle->x = backx - FixedMul(actor->momx, pathdist);
             iparticle->y = backy - FixedMul(actor->momy, pathdist);
             iparticle->z = backz - FixedMul(actor->momz, pathdist) + 
-                             (M_Random() << 10);
+                             (M_EffectRandom() << 10);
             P_SetParticlePosition(iparticle);
 
-            speed = (M_Random() - 128) * (FRACUNIT/200);
+            speed = (M_EffectRandom() - 128) * (FRACUNIT/200);
             iparticle->velx += FixedMul(speed, finecosine[an]);
             iparticle->vely += FixedMul(speed, finesine[an]);
             iparticle->velz += FRACUNIT/80;
             iparticle->accz += FRACUNIT/40;
-            iparticle->color = (M_Random() & 7) ? grey2 : grey1;            
+            iparticle->color = (M_EffectRandom() & 7) ? grey2 : grey1;            
             iparticle->size = 3;
             iparticle->styleflags = 0;
          } 
@@ -760,16 +781,16 @@ void P_DrawSplash(int count, fixed_t x, fixed_t y, fixed_t z,
          break;
       
       p->size = 2;
-      p->color = M_Random() & 0x80 ? color1 : color2;
+      p->color = M_EffectRandom() & 0x80 ? color1 : color2;
       p->styleflags = PS_FULLBRIGHT;
-      p->velz -= M_Random() * 512;
+      p->velz -= M_EffectRandom() * 512;
       p->accz -= FRACUNIT/8;
-      p->accx += (M_Random() - 128) * 8;
-      p->accy += (M_Random() - 128) * 8;
-      p->z = z - M_Random() * 1024;
-      an = (angle + (M_Random() << 21)) >> ANGLETOFINESHIFT;
-      p->x = x + (M_Random() & 15)*finecosine[an];
-      p->y = y + (M_Random() & 15)*finesine[an];
+      p->accx += (M_EffectRandom() - 128) * 8;
+      p->accy += (M_EffectRandom() - 128) * 8;
+      p->z = z - M_EffectRandom() * 1024;
+      an = (angle + (M_EffectRandom() << 21)) >> ANGLETOFINESHIFT;
+      p->x = x + (M_EffectRandom() & 15)*finecosine[an];
+      p->y = y + (M_EffectRandom() & 15)*finesine[an];
       P_SetParticlePosition(p);
    }
 }
@@ -797,14 +818,14 @@ static void P_BloodDrop(int count, fixed_t x, fixed_t y, fixed_t z,
       p->fade = FADEFROMTTL(96);
       p->trans = FRACUNIT;
       p->size = 4;
-      p->color = M_Random() & 0x80 ? color1 : color2;
-      p->velz = 128 * -3000 + M_Random();
+      p->color = M_EffectRandom() & 0x80 ? color1 : color2;
+      p->velz = 128 * -3000 + M_EffectRandom();
       p->accz = -(LevelInfo.gravity*100/256);
       p->styleflags = PS_FLOORCLIP | PS_FALLTOGROUND;
-      p->z = z + (M_Random() - 128) * -2400;
-      an = (angle + ((M_Random() - 128) << 22)) >> ANGLETOFINESHIFT;
-      p->x = x + (M_Random() & 10) * finecosine[an];
-      p->y = y + (M_Random() & 10) * finesine[an];
+      p->z = z + (M_EffectRandom() - 128) * -2400;
+      an = (angle + ((M_EffectRandom() - 128) << 22)) >> ANGLETOFINESHIFT;
+      p->x = x + (M_EffectRandom() & 10) * finecosine[an];
+      p->y = y + (M_EffectRandom() & 10) * finesine[an];
       P_SetParticlePosition(p);
    }
 }
@@ -847,7 +868,7 @@ void P_SmokePuff(int count, fixed_t x, fixed_t y, fixed_t z, angle_t angle,
          hitwater = true;
    }
 
-   count += M_Random() & 15; // MOARRRR!
+   count += M_EffectRandom() & 15; // MOARRRR!
 
    // handle shooting liquids: make it spray up like in the movies
    if(!updown && hitwater)
@@ -870,40 +891,40 @@ void P_SmokePuff(int count, fixed_t x, fixed_t y, fixed_t z, angle_t angle,
       p->ttl = ttl;
       p->fade = FADEFROMTTL(ttl);
       p->trans = FRACUNIT;
-      p->size = 2 + M_Random() % 5;
-      p->color = M_Random() & 0x80 ? color1 : color2;      
-      p->velz = M_Random() * 512;
+      p->size = 2 + M_EffectRandom() % 5;
+      p->color = M_EffectRandom() & 0x80 ? color1 : color2;      
+      p->velz = M_EffectRandom() * 512;
       if(updown == 1) // ceiling shot?
          p->velz = -(p->velz / 4);
       p->accz = accz;
       p->styleflags = 0;
       
-      an = (angle + ((M_Random() - 128) << 23)) >> ANGLETOFINESHIFT;
-      p->velx = (M_Random() * finecosine[an]) >> 11;
-      p->vely = (M_Random() * finesine[an]) >> 11;
+      an = (angle + ((M_EffectRandom() - 128) << 23)) >> ANGLETOFINESHIFT;
+      p->velx = (M_EffectRandom() * finecosine[an]) >> 11;
+      p->vely = (M_EffectRandom() * finesine[an]) >> 11;
       p->accx = p->velx >> 4;
       p->accy = p->vely >> 4;
       
       if(updown == 1) // ceiling shot?
-         p->z = z - (M_Random() + 72) * 2000;
+         p->z = z - (M_EffectRandom() + 72) * 2000;
       else
-         p->z = z + (M_Random() + 72) * 2000;
-      an = (angle + ((M_Random() - 128) << 22)) >> ANGLETOFINESHIFT;
-      p->x = x + (M_Random() & 14) * finecosine[an];
-      p->y = y + (M_Random() & 14) * finesine[an];
+         p->z = z + (M_EffectRandom() + 72) * 2000;
+      an = (angle + ((M_EffectRandom() - 128) << 22)) >> ANGLETOFINESHIFT;
+      p->x = x + (M_EffectRandom() & 14) * finecosine[an];
+      p->y = y + (M_EffectRandom() & 14) * finesine[an];
       P_SetParticlePosition(p);
    }
 
    if(!hitwater) // no sparks on liquids
    {
-      count = M_Random() & 3;
+      count = M_EffectRandom() & 3;
 
       for(; count; --count)
       {
-         fixed_t pathdist = M_Random() << 8;
+         fixed_t pathdist = M_EffectRandom() << 8;
          fixed_t speed;
          
-         if(!(p = JitterParticle(3 + (M_Random() % 24))))
+         if(!(p = JitterParticle(3 + (M_EffectRandom() % 24))))
             break;
          
          p->x = x - pathdist;
@@ -911,7 +932,7 @@ void P_SmokePuff(int count, fixed_t x, fixed_t y, fixed_t z, angle_t angle,
          p->z = z - pathdist;
          P_SetParticlePosition(p);
          
-         speed = (M_Random() - 128) * (FRACUNIT / 200);
+         speed = (M_EffectRandom() - 128) * (FRACUNIT / 200);
          an = angle >> ANGLETOFINESHIFT;
          p->velx += FixedMul(speed, finecosine[an]);
          p->vely += FixedMul(speed, finesine[an]);
@@ -963,7 +984,7 @@ void P_BloodSpray(Mobj *mo, int count, fixed_t x, fixed_t y, fixed_t z,
 
    // haleyjd 04/01/05: at random, throw out drops
    // haleyjd 09/10/07: even if a drop is thrown, do the rest of the effect
-   if(M_Random() < 72)
+   if(M_EffectRandom() < 72)
       P_BloodDrop(count, x, y, z, angle, color1, color2);
 
    // swap colors if reversed
@@ -974,10 +995,10 @@ void P_BloodSpray(Mobj *mo, int count, fixed_t x, fixed_t y, fixed_t z,
       color2  = tempcol;
    }
 
-   count += 3*((M_Random() & 31) + 1)/2; // a LOT more blood.
+   count += 3*((M_EffectRandom() & 31) + 1)/2; // a LOT more blood.
 
    // haleyjd 07/04/09: randomize z coordinate a bit (128/32 == 4 units)
-   z += 3*FRACUNIT + (M_Random() - 128) * FRACUNIT/32;
+   z += 3*FRACUNIT + (M_EffectRandom() - 128) * FRACUNIT/32;
 
 
    for(; count; --count)
@@ -985,28 +1006,28 @@ void P_BloodSpray(Mobj *mo, int count, fixed_t x, fixed_t y, fixed_t z,
       if(!(p = newParticle()))
          break;
       
-      p->ttl = 25 + M_Random() % 6;
+      p->ttl = 25 + M_EffectRandom() % 6;
       p->fade = FADEFROMTTL(p->ttl);
       p->trans = FRACUNIT;
-      p->size = 1 + M_Random() % 4;
+      p->size = 1 + M_EffectRandom() % 4;
       
       // if colors are part of same ramp, use all in between
       if(color1 != color2 && abs(color2 - color1) <= 16)
-         p->color = M_RangeRandom(color1, color2);
+         p->color = M_EffectRangeRandom(color1, color2);
       else
-         p->color = M_Random() & 0x80 ? color1 : color2;
+         p->color = M_EffectRandom() & 0x80 ? color1 : color2;
       
       p->styleflags = 0;
       
-      an      = (angle + ((M_Random() - 128) << 23)) >> ANGLETOFINESHIFT;
-      p->velx = (M_Random() * finecosine[an]) / 768;
-      p->vely = (M_Random() * finesine[an]) / 768;
-
-      an      = (angle + ((M_Random() - 128) << 22)) >> ANGLETOFINESHIFT;      
-      p->x    = x + (M_Random() % 15) * finecosine[an];
-      p->y    = y + (M_Random() % 15) * finesine[an];
-      p->z    = z + (M_Random() - 128) * -3500;
-      p->velz = (M_Random() < 32) ? M_Random() * 140 : M_Random() * -128;
+      an      = (angle + ((M_EffectRandom() - 128) << 23)) >> ANGLETOFINESHIFT;
+      p->velx = (M_EffectRandom() * finecosine[an]) / 768;
+      p->vely = (M_EffectRandom() * finesine[an]) / 768;
+
+      an      = (angle + ((M_EffectRandom() - 128) << 22)) >> ANGLETOFINESHIFT;      
+      p->x    = x + (M_EffectRandom() % 15) * finecosine[an];
+      p->y    = y + (M_EffectRandom() % 15) * finesine[an];
+      p->z    = z + (M_EffectRandom() - 128) * -3500;
+      p->velz = (M_EffectRandom() < 32) ? M_EffectRandom() * 140 : M_EffectRandom() * -128;
       p->accz = -FRACUNIT/16;
       
       P_SetParticlePosition(p);
@@ -1045,22 +1066,22 @@ void P_DrawSplash2(int count, fixed_t x, fixed_t y, fixed_t z,
       p->fade = FADEFROMTTL(12);
       p->trans = FRACUNIT;
       p->styleflags = 0;
-      p->size = 2 + M_Random() % 5;
-      p->color = M_Random() & 0x80 ? color1 : color2;
-      p->velz = M_Random() * zvel;
+      p->size = 2 + M_EffectRandom() % 5;
+      p->color = M_EffectRandom() & 0x80 ? color1 : color2;
+      p->velz = M_EffectRandom() * zvel;
       p->accz = -FRACUNIT/22;
       if(kind)
       {
-         an = (angle + ((M_Random() - 128) << 23)) >> ANGLETOFINESHIFT;
-         p->velx = (M_Random() * finecosine[an]) >> 11;
-         p->vely = (M_Random() * finesine[an]) >> 11;
+         an = (angle + ((M_EffectRandom() - 128) << 23)) >> ANGLETOFINESHIFT;
+         p->velx = (M_EffectRandom() * finecosine[an]) >> 11;
+         p->vely = (M_EffectRandom() * finesine[an]) >> 11;
          p->accx = p->velx >> 4;
          p->accy = p->vely >> 4;
       }
-      p->z = z + (M_Random() + zadd) * zspread;
-      an = (angle + ((M_Random() - 128) << 22)) >> ANGLETOFINESHIFT;
-      p->x = x + (M_Random() & 31) * finecosine[an];
-      p->y = y + (M_Random() & 31) * finesine[an];
+      p->z = z + (M_EffectRandom() + zadd) * zspread;
+      an = (angle + ((M_EffectRandom() - 128) << 22)) >> ANGLETOFINESHIFT;
+      p->x = x + (M_EffectRandom() & 31) * finecosine[an];
+      p->y = y + (M_EffectRandom() & 31) * finesine[an];
       P_SetParticlePosition(p);
    }
 }
@@ -1077,14 +1098,14 @@ void P_DisconnectEffect(Mobj *actor)
          break;
       
       p->x = actor->x + 
-             ((M_Random()-128)<<9) * (actor->radius>>FRACBITS);
+             ((M_EffectRandom()-128)<<9) * (actor->radius>>FRACBITS);
       p->y = actor->y + 
-             ((M_Random()-128)<<9) * (actor->radius>>FRACBITS);
-      p->z = actor->z + (M_Random()<<8) * (actor->height>>FRACBITS);
+             ((M_EffectRandom()-128)<<9) * (actor->radius>>FRACBITS);
+      p->z = actor->z + (M_EffectRandom()<<8) * (actor->height>>FRACBITS);
       P_SetParticlePosition(p);
 
       p->accz -= FRACUNIT/4096;
-      p->color = M_Random() < 128 ? maroon1 : maroon2;
+      p->color = M_EffectRandom() < 128 ? maroon1 : maroon2;
       p->size = 4;
       p->styleflags = PS_FULLBRIGHT;
    }
@@ -1325,27 +1346,27 @@ static void P_ExplosionParticles(fixed_t x, fixed_t y, fixed_t z,
       p->trans = FRACUNIT;
 
       // 2^11 = 2048, 2^12 = 4096
-      p->x = x + (((M_Random() % 32) - 16)*4096);
-      p->y = y + (((M_Random() % 32) - 16)*4096);
-      p->z = z + (((M_Random() % 32) - 16)*4096);
+      p->x = x + (((M_EffectRandom() % 32) - 16)*4096);
+      p->y = y + (((M_EffectRandom() % 32) - 16)*4096);
+      p->z = z + (((M_EffectRandom() % 32) - 16)*4096);
       P_SetParticlePosition(p);
 
       // note: was (rand() % 384) - 192 in Q2, but DOOM's RNG
       // only outputs numbers from 0 to 255, so it has to be
       // corrected to unbias it and get output from approx.
       // -192 to 191
-      rnd = M_Random();
+      rnd = M_EffectRandom();
       p->velx = (rnd - 192 + (rnd/2))*2048;
-      rnd = M_Random();
+      rnd = M_EffectRandom();
       p->vely = (rnd - 192 + (rnd/2))*2048;
-      rnd = M_Random();
+      rnd = M_EffectRandom();
       p->velz = (rnd - 192 + (rnd/2))*2048;
 
       p->accx = p->accy = p->accz = 0;
 
-      p->size = (M_Random() < 48) ? 6 : 4;
+      p->size = (M_EffectRandom() < 48) ? 6 : 4;
 
-      p->color = (M_Random() & 0x80) ? color2 : color1;
+      p->color = (M_EffectRandom() & 0x80) ? color2 : color1;
 
       p->styleflags = PS_FULLBRIGHT;
    }
@@ -27,6 +27,7 @@
 #include "z_zone.h"
 
 #include "c_io.h"
+#include "cam_sight.h"
 #include "doomstat.h"
 #include "e_exdata.h"
 #include "ev_specials.h"
@@ -34,8 +35,10 @@
 #include "m_intmap.h"
 #include "p_chase.h"
 #include "polyobj.h"
+#include "p_enemy.h"
 #include "p_portal.h"
 #include "p_portalblockmap.h"
+#include "p_sector.h"
 #include "p_setup.h"
 #include "p_user.h"
 #include "r_main.h"
@@ -1181,6 +1184,9 @@ static int P_GetPortalState(const portal_t *portal, int sflags, bool obscured)
 
 void P_CheckSectorPortalState(sector_t &sector, surf_e type)
 {
+   CAM_InvalidateSightCache();
+   P_InvalidateSoundFloods(&sector);
+
    surface_t &surface = sector.srf[type];
    if(!surface.portal)
    {
@@ -1195,6 +1201,9 @@ void P_CheckSectorPortalState(sector_t &sector, surf_e type)
 
 void P_CheckLPortalState(line_t *line)
 {
+   CAM_InvalidateSightCache();
+   P_InvalidateSoundFloods(nullptr);
+
    if(!line->portal)
    {
       line->pflags = 0;
@@ -1214,6 +1223,9 @@ void P_SetSectorHeight(sector_t &sec, surf_e surf, fixed_t h)
    surface.height = h;
    surface.heightf = M_FixedToFloat(surface.height);
 
+   // interpolate it this tic
+   P_MarkSectorMoved(sec);
+
    // Update slope origin
    if(surface.slope)
    {
@@ -36,10 +36,12 @@
 #include "p_portal.h"
 #include "p_portalclip.h"
 #include "p_portalcross.h"
+#include "p_setup.h"
 #include "p_spec.h"
 #include "r_defs.h"
 #include "r_main.h"
 #include "r_portal.h"
+#include "r_state.h"
 
 //
 // untouchedViaPortals
@@ -213,13 +215,14 @@ bool PIT_CheckLine3D(line_t *ld, polyobj_t *po, void *context)
    bbox[BOXRIGHT] = clip.bbox[BOXRIGHT] + link->x;
    bbox[BOXTOP] = clip.bbox[BOXTOP] + link->y;
 
-   if(bbox[BOXRIGHT]  <= ld->bbox[BOXLEFT]   ||
-      bbox[BOXLEFT]   >= ld->bbox[BOXRIGHT]  ||
-      bbox[BOXTOP]    <= ld->bbox[BOXBOTTOM] ||
-      bbox[BOXBOTTOM] >= ld->bbox[BOXTOP])
+   const linehot_t &lh = linehot[ld - lines];
+   if(bbox[BOXRIGHT]  <= lh.bbox[BOXLEFT]   ||
+      bbox[BOXLEFT]   >= lh.bbox[BOXRIGHT]  ||
+      bbox[BOXTOP]    <= lh.bbox[BOXBOTTOM] ||
+      bbox[BOXBOTTOM] >= lh.bbox[BOXTOP])
       return true; // didn't hit it
 
-   if(P_BoxOnLineSide(bbox, ld) != -1)
+   if(P_BoxOnLineSide(bbox, lh) != -1)
       return true; // didn't hit it
 
    fixed_t linetop, linebottom;
@@ -26,6 +26,7 @@
 #include "z_zone.h"
 
 #include "c_io.h"
+#include "c_runcmd.h"
 #include "cam_sight.h"
 #include "doomstat.h"
 #include "i_system.h"
@@ -40,6 +41,7 @@
 #include "r_main.h"
 #include "r_portal.h"
 #include "r_state.h"
+#include "v_misc.h"
 
 //==============================================================================
 //
@@ -467,6 +469,43 @@ static bool P_boxTouchesBlockPortal(const portalblockentry_t &entry, const fixed
    return false;
 }
 
+//
+// Scratch space for P_TransPortalBlockWalker. There is one set for each level
+// of nesting, since the block functions can start walks of their own, such as
+// an explosion setting off a barrel.
+//
+struct portalwalkscratch_t
+{
+   bool *accessedgroupids;
+   const portalblockentry_t **portalqueue;
+   int numalloc;
+};
+
+static PODCollection<portalwalkscratch_t> portalwalkscratch;
+static int portalwalkdepth;
+
+// how often walks take the portal-aware path, and how many of those actually
+// pass through a portal
+static uint64_t portalwalksimple, portalwalkportal, portalwalkcrossed;
+
+static portalwalkscratch_t &P_portalWalkScratch(int gcount)
+{
+   while(portalwalkscratch.getLength() <= size_t(portalwalkdepth))
+      portalwalkscratch.add(portalwalkscratch_t{ nullptr, nullptr, 0 });
+
+   portalwalkscratch_t &scratch = portalwalkscratch[portalwalkdepth];
+   if(scratch.numalloc < gcount)
+   {
+      scratch.numalloc = gcount;
+      scratch.accessedgroupids = erealloc(bool *, scratch.accessedgroupids,
+                                          gcount * sizeof(*scratch.accessedgroupids));
+      scratch.portalqueue = erealloc(const portalblockentry_t **, scratch.portalqueue,
+                                     gcount * sizeof(*scratch.portalqueue));
+   }
+   memset(scratch.accessedgroupids, 0, gcount * sizeof(*scratch.accessedgroupids));
+   return scratch;
+}
+
 //
 // P_TransPortalBlockWalker
 //
@@ -480,13 +519,16 @@ bool P_TransPortalBlockWalker(const fixed_t bbox[4], int groupid, bool xfirst, v
    int gcount = P_PortalGroupCount();
    if(gcount <= 1 || groupid == R_NOGROUP || full_demo_version < make_full_version(340, 48))
    {
+      ++portalwalksimple;
       return P_simpleBlockWalker(bbox, xfirst, data, func);
    }
+   ++portalwalkportal;
 
-   // OPTIMIZE: if needed, use some global store instead of malloc
-   bool *accessedgroupids = ecalloc(bool *, gcount, sizeof(*accessedgroupids));
+   portalwalkscratch_t &scratch = P_portalWalkScratch(gcount);
+   bool *accessedgroupids = scratch.accessedgroupids;
    accessedgroupids[groupid] = true;
-   auto portalqueue = ecalloc(const portalblockentry_t **, gcount, sizeof(portalblockentry_t *));
+   const portalblockentry_t **portalqueue = scratch.portalqueue;
+   ++portalwalkdepth;
    int queuehead = 0;
    int queueback = 0;
 
@@ -557,8 +599,7 @@ bool P_TransPortalBlockWalker(const fixed_t bbox[4], int groupid, bool xfirst, v
             for(y = yl; y <= yh; ++y)
                if(!operate(x, y))
                {
-                  efree(portalqueue);
-                  efree(accessedgroupids);
+                  --portalwalkdepth;
                   return false;
                }
       }
@@ -567,8 +608,7 @@ bool P_TransPortalBlockWalker(const fixed_t bbox[4], int groupid, bool xfirst, v
             for(x = xl; x <= xh; ++x)
                if(!operate(x, y))
                {
-                  efree(portalqueue);
-                  efree(accessedgroupids);
+                  --portalwalkdepth;
                   return false;
                }
 
@@ -595,11 +635,32 @@ bool P_TransPortalBlockWalker(const fixed_t bbox[4], int groupid, bool xfirst, v
 
    // we now have the list of accessedgroupids
    
-   efree(portalqueue);
-   efree(accessedgroupids);
+   if(queueback)
+      ++portalwalkcrossed;
+   --portalwalkdepth;
    return true;
 }
 
+//
+// How often portal block walks run; "reset" clears the counters.
+//
+CONSOLE_COMMAND(p_portalwalkstats, 0)
+{
+   if(Console.argc >= 1 && !Console.argv[0]->strCaseCmp("reset"))
+   {
+      portalwalksimple = portalwalkportal = portalwalkcrossed = 0;
+      C_Printf("Portal walk counters reset\n");
+      return;
+   }
+
+   C_Printf(FC_HI "Portal block walks:\n" FC_NORMAL
+            "plain %llu, portal-aware %llu, through a portal %llu (%.1f%%)\n",
+            static_cast<unsigned long long>(portalwalksimple),
+            static_cast<unsigned long long>(portalwalkportal),
+            static_cast<unsigned long long>(portalwalkcrossed),
+            portalwalkportal ? 100.0 * double(portalwalkcrossed) / double(portalwalkportal) : 0.0);
+}
+
 //==============================================================================
 
 //
@@ -0,0 +1,296 @@
+//
+// The Eternity Engine
+// Copyright(C) 2026 James Haley, Max Waine, et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+// Additional terms and conditions compatible with the GPLv3 apply. See the
+// file COPYING-EE for details.
+//
+// Purpose: Action function and thinker profiler.
+//  Actions are counted per state, since a state's action can't change while
+//  the game runs, and gathered by function only for reports. That keeps the
+//  cost per call to an array index beside the two clock reads.
+//
+
+#include <algorithm>
+
+#include "z_zone.h"
+
+#include "c_io.h"
+#include "c_runcmd.h"
+#include "d_dehtbl.h"
+#include "info.h"
+#include "m_collection.h"
+#include "m_qstr.h"
+#include "p_profile.h"
+#include "v_misc.h"
+
+using profclock_t = std::chrono::steady_clock;
+using profms_t    = std::chrono::duration<double, std::milli>;
+
+struct profrecord_t
+{
+   const void           *key;   // action, thing type name or thinker class
+   uint64_t              calls;
+   profclock_t::duration time;
+};
+
+bool p_profiling;
+
+static PODCollection<profrecord_t> statestats;   // by state number
+static PODCollection<profrecord_t> typestats;    // by thing type
+static PODCollection<profrecord_t> thinkerstats; // by thinker class, unsorted
+static profclock_t::duration       profiletime;  // time profiled before the last start
+static profclock_t::time_point     profilestart;
+
+//
+// Grows a by-number table to cover index; EDF can add states and types
+// while the game runs.
+//
+static profrecord_t &P_profileEntry(PODCollection<profrecord_t> &table, int index)
+{
+   while(table.getLength() <= size_t(index))
+      table.add(profrecord_t{ nullptr, 0, profclock_t::duration::zero() });
+   return table[index];
+}
+
+void P_ProfileAction(int statenum, int mobjtype, profclock_t::duration time)
+{
+   profrecord_t &state = P_profileEntry(statestats, statenum);
+   state.calls++;
+   state.time += time;
+
+   profrecord_t &type = P_profileEntry(typestats, mobjtype);
+   type.calls++;
+   type.time += time;
+}
+
+void P_ProfileThinker(const RTTIObject::Type *type, size_t count, profclock_t::duration time)
+{
+   profrecord_t *record = nullptr;
+
+   for(profrecord_t &r : thinkerstats)
+   {
+      if(r.key == type)
+      {
+         record = &r;
+         break;
+      }
+   }
+   if(!record)
+   {
+      thinkerstats.add(profrecord_t{ type, 0, profclock_t::duration::zero() });
+      record = &thinkerstats.back();
+   }
+
+   record->calls += count;
+   record->time  += time;
+}
+
+//
+// Name of an action function, from the codepointer table
+//
+static const char *P_actionName(const void *action)
+{
+   for(int i = 0; i < num_bexptrs; i++)
+   {
+      if(reinterpret_cast<const void *>(deh_bexptrs[i].cptr) == action)
+         return deh_bexptrs[i].lookup;
+   }
+   return "(unknown)";
+}
+
+//
+// Per-state figures summed by action function, heaviest first
+//
+static void P_actionTotals(PODCollection<profrecord_t> &totals)
+{
+   for(size_t i = 0; i < statestats.getLength(); i++)
+   {
+      const profrecord_t &s = statestats[i];
+      if(!s.calls || int(i) >= NUMSTATES)
+         continue;
+
+      const void *action = reinterpret_cast<const void *>(states[i]->action);
+      profrecord_t *total = nullptr;
+      for(profrecord_t &t : totals)
+      {
+         if(t.key == action)
+         {
+            total = &t;
+            break;
+         }
+      }
+      if(!total)
+      {
+         totals.add(profrecord_t{ action, 0, profclock_t::duration::zero() });
+         total = &totals.back();
+      }
+      total->calls += s.calls;
+      total->time  += s.time;
+   }
+}
+
+//
+// Non-empty entries of a table, heaviest first, with their names as keys
+//
+static void P_sortedTypes(PODCollection<profrecord_t> &sorted)
+{
+   for(size_t i = 0; i < typestats.getLength() && int(i) < NUMMOBJTYPES; i++)
+   {
+      if(typestats[i].calls)
+         sorted.add(profrecord_t{ mobjinfo[i]->name, typestats[i].calls, typestats[i].time });
+   }
+}
+
+static void P_sortByTime(PODCollection<profrecord_t> &records)
+{
+   std::sort(records.begin(), records.end(),
+             [](const profrecord_t &a, const profrecord_t &b) { return a.time > b.time; });
+}
+
+static const char *P_thinkerName(const void *key)
+{
+   return key ? static_cast<const RTTIObject::Type *>(key)->getName() : "(mixed)";
+}
+
+static double P_profiledMs()
+{
+   profclock_t::duration total = profiletime;
+   if(p_profiling)
+      total += profclock_t::now() - profilestart;
+   return profms_t(total).count();
+}
+
+//
+// Prints one table to the console, at most limit rows
+//
+static void P_printTable(const char *title, const PODCollection<profrecord_t> &records,
+                         const char *(*name)(const void *), size_t limit)
+{
+   C_Printf(FC_HI "%s\n", title);
+   for(size_t i = 0; i < records.getLength() && i < limit; i++)
+   {
+      const profrecord_t &r = records[i];
+      C_Printf("%-24.24s %10llu %10.2f ms %8.2f us\n", name(r.key),
+               static_cast<unsigned long long>(r.calls), profms_t(r.time).count(),
+               profms_t(r.time).count() * 1000.0 / double(r.calls));
+   }
+}
+
+static const char *P_stringName(const void *key)
+{
+   return static_cast<const char *>(key);
+}
+
+CONSOLE_COMMAND(p_profile_start, 0)
+{
+   if(p_profiling)
+      return;
+   p_profiling  = true;
+   profilestart = profclock_t::now();
+   C_Puts("Profiling actions and thinkers");
+}
+
+CONSOLE_COMMAND(p_profile_stop, 0)
+{
+   if(!p_profiling)
+      return;
+   profiletime += profclock_t::now() - profilestart;
+   p_profiling = false;
+}
+
+CONSOLE_COMMAND(p_profile_clear, 0)
+{
+   statestats.makeEmpty();
+   typestats.makeEmpty();
+   thinkerstats.makeEmpty();
+   profiletime  = profclock_t::duration::zero();
+   profilestart = profclock_t::now();
+}
+
+CONSOLE_COMMAND(p_profile_report, 0)
+{
+   PODCollection<profrecord_t> actions, types, thinkers(thinkerstats);
+
+   P_actionTotals(actions);
+   P_sortByTime(actions);
+   P_sortedTypes(types);
+   P_sortByTime(types);
+   P_sortByTime(thinkers);
+
+   C_Printf("%.1f ms profiled\n", P_profiledMs());
+   P_printTable("Actions", actions, P_actionName, 20);
+   P_printTable("Thing types", types, P_stringName, 10);
+   P_printTable("Thinker classes", thinkers, P_thinkerName, 10);
+}
+
+//
+// Writes every row of every table, for a spreadsheet
+//
+CONSOLE_COMMAND(p_profile_csv, 0)
+{
+   if(Console.argc < 1)
+   {
+      C_Puts("Usage: p_profile_csv filename");
+      return;
+   }
+
+   FILE *f = fopen(Console.argv[0]->constPtr(), "w");
+   if(!f)
+   {
+      C_Printf(FC_ERROR "Couldn't open %s\n", Console.argv[0]->constPtr());
+      return;
+   }
+
+   PODCollection<profrecord_t> actions, types;
+   P_actionTotals(actions);
+   P_sortByTime(actions);
+   P_sortedTypes(types);
+   P_sortByTime(types);
+
+   fputs("kind,name,calls,total_ms\n", f);
+   for(const profrecord_t &r : actions)
+   {
+      fprintf(f, "action,%s,%llu,%.4f\n", P_actionName(r.key),
+              static_cast<unsigned long long>(r.calls), profms_t(r.time).count());
+   }
+   for(size_t i = 0; i < statestats.getLength() && int(i) < NUMSTATES; i++)
+   {
+      const profrecord_t &r = statestats[i];
+      if(r.calls)
+      {
+         fprintf(f, "state,%s,%llu,%.4f\n", states[i]->name,
+                 static_cast<unsigned long long>(r.calls), profms_t(r.time).count());
+      }
+   }
+   for(const profrecord_t &r : types)
+   {
+      fprintf(f, "thingtype,%s,%llu,%.4f\n", P_stringName(r.key),
+              static_cast<unsigned long long>(r.calls), profms_t(r.time).count());
+   }
+   for(const profrecord_t &r : thinkerstats)
+   {
+      fprintf(f, "thinker,%s,%llu,%.4f\n", P_thinkerName(r.key),
+              static_cast<unsigned long long>(r.calls), profms_t(r.time).count());
+   }
+   fprintf(f, "total,,,%.4f\n", P_profiledMs());
+
+   fclose(f);
+   C_Printf("Wrote %s\n", Console.argv[0]->constPtr());
+}
+
+// EOF
+
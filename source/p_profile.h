@@ -0,0 +1,45 @@
+//
+// The Eternity Engine
+// Copyright(C) 2026 James Haley, Max Waine, et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+// Additional terms and conditions compatible with the GPLv3 apply. See the
+// file COPYING-EE for details.
+//
+// Purpose: Action function and thinker profiler.
+//  While running, each action called from P_SetMobjState is timed and
+//  charged to its state and to the type of thing that ran it, and each
+//  thinker's Think to its class. Times are inclusive: whatever a call sets
+//  off, nested actions too, counts towards it. The p_profile console
+//  commands start, stop, report and write the figures out as CSV.
+//
+
+#ifndef P_PROFILE_H__
+#define P_PROFILE_H__
+
+#include <chrono>
+
+#include "e_rtti.h"
+
+extern bool p_profiling;
+
+void P_ProfileAction(int statenum, int mobjtype, std::chrono::steady_clock::duration time);
+void P_ProfileThinker(const RTTIObject::Type *type, size_t count,
+                      std::chrono::steady_clock::duration time);
+
+#endif
+
+// EOF
+
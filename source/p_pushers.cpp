@@ -31,6 +31,7 @@
 #include "e_things.h"
 #include "ev_specials.h"
 #include "m_bbox.h"
+#include "m_compare.h"
 #include "p_map.h"
 #include "p_maputl.h"
 #include "p_mobj.h"
@@ -232,10 +233,11 @@ void PushThinker::Think()
       clip.bbox[BOXRIGHT]  = this->x + radius;
       clip.bbox[BOXLEFT]   = this->x - radius;
       
-      xl = (clip.bbox[BOXLEFT]   - bmaporgx - MAXRADIUS) >> MAPBLOCKSHIFT;
-      xh = (clip.bbox[BOXRIGHT]  - bmaporgx + MAXRADIUS) >> MAPBLOCKSHIFT;
-      yl = (clip.bbox[BOXBOTTOM] - bmaporgy - MAXRADIUS) >> MAPBLOCKSHIFT;
-      yh = (clip.bbox[BOXTOP]    - bmaporgy + MAXRADIUS) >> MAPBLOCKSHIFT;
+      // the blocks off the map hold nothing, so don't visit them
+      xl = emax((clip.bbox[BOXLEFT]   - bmaporgx - MAXRADIUS) >> MAPBLOCKSHIFT, 0);
+      xh = emin((clip.bbox[BOXRIGHT]  - bmaporgx + MAXRADIUS) >> MAPBLOCKSHIFT, bmapwidth - 1);
+      yl = emax((clip.bbox[BOXBOTTOM] - bmaporgy - MAXRADIUS) >> MAPBLOCKSHIFT, 0);
+      yh = emin((clip.bbox[BOXTOP]    - bmaporgy + MAXRADIUS) >> MAPBLOCKSHIFT, bmapheight - 1);
 
       for (bx = xl; bx <= xh; bx++)
       {
@@ -252,21 +254,23 @@ void PushThinker::Think()
 
    node = sec->touching_thinglist; // things touching this sector
 
-   for( ; node; node = node->m_snext)
-    {
-      // ioanch 20160115: portal aware
-      if(useportalgroups && full_demo_version >= make_full_version(340, 48) &&
-         !P_SectorTouchesThingVertically(sec, node->m_thing))
-      {
-         continue;
-      }
+   // Only players are pushed, so on a sector full of other things most of
+   // the list is passed over: the flag tests go before the portal one.
+   const bool vertical = useportalgroups &&
+      full_demo_version >= make_full_version(340, 48);
 
+   for( ; node; node = node->m_snext)
+   {
       thing = node->m_thing;
       if(!thing->player || 
          (thing->flags2 & MF2_NOTHRUST) ||                // haleyjd
          (thing->flags & (MF_NOGRAVITY | MF_NOCLIP)))
          continue;
 
+      // ioanch 20160115: portal aware
+      if(vertical && !P_SectorTouchesThingVertically(sec, thing))
+         continue;
+
       if(this->type == PushThinker::p_wind)
       {
          if(sec->heightsec == -1) // NOT special water sector
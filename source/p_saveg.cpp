@@ -34,6 +34,7 @@
 #include "d_event.h"
 #include "d_files.h"
 #include "d_gi.h"
+#include "d_jobs.h"
 #include "d_main.h"
 #include "d_net.h"
 #include "doomstat.h"
@@ -45,6 +46,7 @@
 #include "g_game.h"
 #include "m_argv.h"
 #include "m_buffer.h"
+#include "m_qstr.h"
 #include "m_random.h"
 #include "p_info.h"
 #include "p_maputl.h"
@@ -231,7 +233,7 @@ void SaveArchive::archiveCachedString(qstring &string)
 
          // Write both the new ID and the content
          auto localID = static_cast<int32_t>(cache->identifier);
-         *this << localID;
+         archiveVarInt(localID);
          qstring localString = string;
          localString.archive(*this);
       }
@@ -239,14 +241,14 @@ void SaveArchive::archiveCachedString(qstring &string)
       {
          // We have it cached already
          auto localID = static_cast<int32_t>(cache->identifier);
-         *this << localID;
+         archiveVarInt(localID);
       }
    }
    else
    {
       // Loading
       int32_t id;
-      *this << id;
+      archiveVarInt(id);
       CachedString *cache = mIdTable.objectForKey(id);   // look up strings by ID
       if(!cache)
       {
@@ -291,6 +293,101 @@ void SaveArchive::archiveSize(size_t &value)
    }
 }
 
+//
+// Archives an unsigned integer seven bits to a byte, low bits first, with the
+// top bit set on every byte but the last. Small values take one byte.
+//
+void SaveArchive::archiveVarUint(uint32_t &value)
+{
+   if(saveVersion() < 15)
+   {
+      *this << value;
+      return;
+   }
+
+   if(savefile)
+   {
+      uint32_t rest = value;
+
+      while(rest >= 0x80)
+      {
+         savefile->writeUint8(uint8_t(rest | 0x80));
+         rest >>= 7;
+      }
+      savefile->writeUint8(uint8_t(rest));
+   }
+   else
+   {
+      uint8_t part;
+
+      value = 0;
+      for(int shift = 0; shift < 35; shift += 7)
+      {
+         if(!loadfile->readUint8(part))
+            part = 0;
+         value |= uint32_t(part & 0x7f) << shift;
+         if(!(part & 0x80))
+            break;
+      }
+   }
+}
+
+//
+// Archives a signed integer, zigzag-mapped so that values near zero of either
+// sign come out small: 0, -1, 1, -2... become 0, 1, 2, 3...
+//
+void SaveArchive::archiveVarInt(int32_t &value)
+{
+   if(saveVersion() < 15)
+   {
+      *this << value;
+      return;
+   }
+
+   uint32_t zigzag = (uint32_t(value) << 1) ^ uint32_t(value >> 31);
+   archiveVarUint(zigzag);
+   if(loadfile)
+      value = int32_t(zigzag >> 1) ^ -int32_t(zigzag & 1);
+}
+
+void SaveArchive::archiveVarInt(int16_t &value)
+{
+   if(saveVersion() < 15)
+   {
+      *this << value;
+      return;
+   }
+
+   int32_t wide = value;
+   archiveVarInt(wide);
+   value = int16_t(wide);
+}
+
+//
+// Archives a point as its distance from the last one, which is usually near
+// for things archived in thinker order. Both saving and loading go through
+// the same points in the same order, so the last point is known to both.
+//
+void SaveArchive::archivePosition(int32_t &x, int32_t &y, int32_t &z)
+{
+   int32_t *const coords[3] = { &x, &y, &z };
+
+   if(saveVersion() < 15)
+   {
+      *this << x << y << z;
+      return;
+   }
+
+   for(int i = 0; i < 3; i++)
+   {
+      int32_t delta = int32_t(uint32_t(*coords[i]) - uint32_t(mLastPosition[i]));
+      archiveVarInt(delta);
+      if(loadfile)
+         *coords[i] = int32_t(uint32_t(mLastPosition[i]) + uint32_t(delta));
+      mLastPosition[i] = *coords[i];
+   }
+}
+
 //
 // IO operators
 //
@@ -727,6 +824,8 @@ static void P_ArchivePlayers(SaveArchive &arc)
             P_loadWeaponCounters(arc, p);
          }
          P_ArchiveArray<inventoryslot_t>(arc, p.inventory, inventorySize);
+         if(arc.isLoading())
+            E_ReindexInventory(&p);
 
          for(powerduration_t &power : p.powers)
          {
@@ -1043,12 +1142,17 @@ static void P_ArchiveThinkers(SaveArchive &arc)
       }
 
       // add a terminating marker
-      arc.writeLString(tc_end);
+      if(arc.saveVersion() >= 15)
+      {
+         qstring endName(tc_end);
+         arc.archiveCachedString(endName);
+      }
+      else
+         arc.writeLString(tc_end);
    }
    else
    {
-      char *className = nullptr;
-      size_t len;
+      qstring className;
       unsigned int idx = 1; // Start at index 1, as 0 means nullptr
       Thinker::Type *thinkerType;
       Thinker     *newThinker;
@@ -1061,19 +1165,28 @@ static void P_ArchiveThinkers(SaveArchive &arc)
 
       while(1)
       {
-         if(className)
-            efree(className);
+         // Get the next class name; from version 15 each name is written
+         // in full only the first time
+         if(arc.saveVersion() >= 15)
+            arc.archiveCachedString(className);
+         else
+         {
+            char  *name = nullptr;
+            size_t len;
 
-         // Get the next class name
-         arc.archiveLString(className, len);
+            arc.archiveLString(name, len);
+            className = name ? name : "";
+            if(name)
+               efree(name);
+         }
 
          // Find the ThinkerType matching this name
-         if(!(thinkerType = RTTIObject::FindTypeCls<Thinker>(className)))
+         if(!(thinkerType = RTTIObject::FindTypeCls<Thinker>(className.constPtr())))
          {
-            if(!strcmp(className, tc_end))
+            if(className == tc_end)
                break; // Reached end of thinker list
             else 
-               I_Error("Unknown tclass %s in savegame\n", className);
+               I_Error("Unknown tclass %s in savegame\n", className.constPtr());
          }
 
          // Too many thinkers?!
@@ -1379,6 +1492,9 @@ static void P_ArchiveSoundSequences(SaveArchive &arc)
    DLListItem<SndSeq_t> *item = SoundSequences;
    int count = 0;
 
+   // queued sequences don't count their delays down as they wait
+   S_SyncSequenceDelays();
+
    // count active sound sequences (+1 if there's a running enviroseq)
    while(item)
    {
@@ -1478,149 +1594,218 @@ static void P_ArchiveACS(SaveArchive &arc)
 
 #define SAVESTRINGSIZE 24
 
-void P_SaveCurrentLevel(char *filename, char *description)
+//
+// Writes the current level to the archive. Shared by savegames and demo
+// snapshots; IO errors are thrown as BufferedIOException.
+//
+static void P_saveLevelArchive(SaveArchive &arc, OutBuffer &savefile, char *description)
 {
    int i;
    char name2[VERSIONSIZE];
    const char *fn;
-   OutBuffer savefile;
-   SaveArchive arc(&savefile);
 
-   if(!savefile.createFile(filename, 512*1024, OutBuffer::NENDIAN))
+   arc.archiveCString(description, SAVESTRINGSIZE);
+   
+   // killough 2/22/98: "proprietary" version string :-)
+   memset(name2, 0, sizeof(name2));
+   sprintf(name2, VERSIONID);
+
+   arc.archiveCString(name2, VERSIONSIZE);
+
+   arc.writeSaveVersion();
+
+   // killough 2/14/98: save old compatibility flag:
+   // haleyjd 06/16/10: save "inmasterlevels" state
+   int tempskill = (int)gameskill;
+   
+   arc << compatibility << tempskill << inmanageddir;
+   arc << vanilla_mode;
+
+   // sf: use string rather than episode, map
+   for(i = 0; i < 8; i++)
    {
-      const char *str =
-         errno ? strerror(errno) : FC_ERROR "Could not save game: Error unknown";
-      doom_printf("%s", str);
-      return;
+      int8_t lvc = levelmapname[i];
+      arc << lvc;
    }
 
-   // Enable buffered IO exceptions
-   savefile.setThrowing(true);
+   // haleyjd 06/16/10: support for saving/loading levels in managed wad
+   // directories.
 
-   try
+   if((fn = W_GetManagedDirFN(g_dir))) // returns null if g_dir == &w_GlobalDir
    {
-      arc.archiveCString(description, SAVESTRINGSIZE);
-      
-      // killough 2/22/98: "proprietary" version string :-)
-      memset(name2, 0, sizeof(name2));
-      sprintf(name2, VERSIONID);
-   
-      arc.archiveCString(name2, VERSIONSIZE);
+      // save length of managed directory filename string and
+      // managed directory filename string
+      arc.writeLString(fn);
+   }
+   else
+   {
+      // just save 0; there is no name to save
+      size_t len = 0;
+      arc.archiveSize(len);
+   }
 
-      arc.writeSaveVersion();
-   
-      // killough 2/14/98: save old compatibility flag:
-      // haleyjd 06/16/10: save "inmasterlevels" state
-      int tempskill = (int)gameskill;
-      
-      arc << compatibility << tempskill << inmanageddir;
-      arc << vanilla_mode;
-   
-      // sf: use string rather than episode, map
-      for(i = 0; i < 8; i++)
-      {
-         int8_t lvc = levelmapname[i];
-         arc << lvc;
-      }
+   // killough 3/16/98, 12/98: store lump name checksum
+   uint64_t checksum    = G_Signature(g_dir);
+   int      numwadfiles = D_GetNumWadFiles();
 
-      // haleyjd 06/16/10: support for saving/loading levels in managed wad
-      // directories.
+   arc << checksum;
+   arc << numwadfiles;
+   // killough 3/16/98: store pwad filenames in savegame
+   for(wfileadd_t *file = wadfiles; file->filename; ++file)
+   {
+      const char *fn = file->filename;
+      arc.writeLString(fn, 0);
+   }
 
-      if((fn = W_GetManagedDirFN(g_dir))) // returns null if g_dir == &w_GlobalDir
-      {
-         // save length of managed directory filename string and
-         // managed directory filename string
-         arc.writeLString(fn);
-      }
-      else
-      {
-         // just save 0; there is no name to save
-         size_t len = 0;
-         arc.archiveSize(len);
-      }
+   for(i = 0; i < MAXPLAYERS; i++)
+      arc << playeringame[i];
 
-      // killough 3/16/98, 12/98: store lump name checksum
-      uint64_t checksum    = G_Signature(g_dir);
-      int      numwadfiles = D_GetNumWadFiles();
+   for(; i < MIN_MAXPLAYERS; i++)         // killough 2/28/98
+   {
+      bool dummy = 0;
+      arc << dummy;
+   }
 
-      arc << checksum;
-      arc << numwadfiles;
-      // killough 3/16/98: store pwad filenames in savegame
-      for(wfileadd_t *file = wadfiles; file->filename; ++file)
-      {
-         const char *fn = file->filename;
-         arc.writeLString(fn, 0);
-      }
+   // jff 3/17/98 save idmus state
+   int tempGameType = (int)GameType;
+   arc << idmusnum << tempGameType;
 
-      for(i = 0; i < MAXPLAYERS; i++)
-         arc << playeringame[i];
+   byte options[GAME_OPTION_SIZE];
+   G_WriteOptions(options);    // killough 3/1/98: save game options
+   savefile.write(options, sizeof(options));
 
-      for(; i < MIN_MAXPLAYERS; i++)         // killough 2/28/98
-      {
-         bool dummy = 0;
-         arc << dummy;
-      }
+   //killough 11/98: save entire word
+   arc << leveltime;
 
-      // jff 3/17/98 save idmus state
-      int tempGameType = (int)GameType;
-      arc << idmusnum << tempGameType;
+   // killough 11/98: save revenant tracer state
+   uint8_t tracerState = (uint8_t)((gametic-basetic) & 255);
+   arc << tracerState;
 
-      byte options[GAME_OPTION_SIZE];
-      G_WriteOptions(options);    // killough 3/1/98: save game options
-      savefile.write(options, sizeof(options));
-   
-      //killough 11/98: save entire word
-      arc << leveltime;
-   
-      // killough 11/98: save revenant tracer state
-      uint8_t tracerState = (uint8_t)((gametic-basetic) & 255);
-      arc << tracerState;
+   arc << dmflags;
 
-      arc << dmflags;
-   
-      // killough 3/22/98: add Z_CheckHeap after each call to ensure consistency
-      // haleyjd 07/06/09: just Z_CheckHeap after the end. This stuff works by now.
-   
-      P_NumberThinkers();    // turn ptrs to numbers
-
-      P_ArchivePlayers(arc);
-      P_ArchiveWorld(arc);
-      P_ArchiveLevelInfo(arc);
-      P_ArchivePolyObjects(arc); // haleyjd 03/27/06
-      P_ArchiveThinkers(arc);
-      P_ArchiveRNG(arc);    // killough 1/18/98: save RNG information
-      P_ArchiveMap(arc);    // killough 1/22/98: save automap information
-      P_ArchiveSoundSequences(arc);
-      P_ArchiveButtons(arc);
-      P_ArchiveACS(arc);            // davidph 05/30/12
-
-      P_DeNumberThinkers();
-
-      uint8_t cmarker = 0xE6; // consistency marker
-      arc << cmarker; 
-   }
-   catch(BufferedIOException)
-   {
-      // An IO error occurred while trying to save.
-      const char *str =
-         errno ? strerror(errno) : FC_ERROR "Could not save game: Error unknown";
-      doom_printf("%s", str);
-
-      // Close the file and remove it
-      savefile.setThrowing(false);
-      savefile.close();
-      remove(filename);
+   // killough 3/22/98: add Z_CheckHeap after each call to ensure consistency
+   // haleyjd 07/06/09: just Z_CheckHeap after the end. This stuff works by now.
+
+   P_NumberThinkers();    // turn ptrs to numbers
+
+   P_ArchivePlayers(arc);
+   P_ArchiveWorld(arc);
+   P_ArchiveLevelInfo(arc);
+   P_ArchivePolyObjects(arc); // haleyjd 03/27/06
+   P_ArchiveThinkers(arc);
+   P_ArchiveRNG(arc);    // killough 1/18/98: save RNG information
+   P_ArchiveMap(arc);    // killough 1/22/98: save automap information
+   P_ArchiveSoundSequences(arc);
+   P_ArchiveButtons(arc);
+   P_ArchiveACS(arc);            // davidph 05/30/12
+
+   P_DeNumberThinkers();
+
+   uint8_t cmarker = 0xE6; // consistency marker
+   arc << cmarker; 
+}
+
+//
+// Savegames are archived to memory on the game thread, then deflated and
+// written out by a low priority job, which hands the result back to the main
+// thread to report. The file is written under a temporary name and renamed
+// over the old save only once it is complete.
+//
+
+static JobHandle         savejob;
+static unsigned          savegeneration; // tells one save's handback from the next
+static bool              savefailed;   // set by the job before it is done
+static byte             *savedata;     // the archived level being written
+static size_t            savesize;
+static qstring           savefilename;
+static qstring           savetempname;
+static bool              saveannounce; // print the 'game saved' message
+
+//
+// Deflates and writes the save, then moves it into place.
+//
+static void P_saveJob(unsigned generation)
+{
+   bool written = M_WriteDeflatedFile(savetempname.constPtr(), savedata, savesize);
+
+   if(written && rename(savetempname.constPtr(), savefilename.constPtr()))
+   {
+      // rename won't replace a file on Windows
+      remove(savefilename.constPtr());
+      written = !rename(savetempname.constPtr(), savefilename.constPtr());
+   }
+
+   if(!written)
+      remove(savetempname.constPtr());
+
+   savefailed = !written;
+
+   D_RunOnMainThread([generation] {
+      if(generation == savegeneration)
+         P_FinishSaveGame();
+   });
+}
+
+//
+// Waits for the save being written, if there is one, without reporting it.
+//
+static void P_joinSaveJob()
+{
+   if(!savejob.valid())
       return;
+
+   savejob.join();
+   efree(savedata);
+   savedata = nullptr;
+}
+
+//
+// Waits for the save being written, if there is one, and reports how it
+// went. Anything about to read or write a savegame calls this first.
+//
+void P_FinishSaveGame()
+{
+   if(!savejob.valid())
+      return;
+
+   P_joinSaveJob();
+
+   if(savefailed)
+      doom_printf(FC_ERROR "Could not save game to %s", savefilename.constPtr());
+   else if(saveannounce)
+      doom_printf("%s", DEH_String("GGSAVED"));  // Ty 03/27/98 - externalized
+}
+
+void P_SaveCurrentLevel(char *filename, char *description)
+{
+   static bool atexitset = false;
+   OutBuffer savefile;
+   SaveArchive arc(&savefile);
+
+   P_FinishSaveGame();
+
+   // the job must be done with before static destruction
+   if(!atexitset)
+   {
+      atexit(P_joinSaveJob);
+      atexitset = true;
    }
 
-   // Close the save file
-   savefile.close();
+   // memory output only grows, so there is nothing to fail
+   savefile.createMemory(512*1024, OutBuffer::NENDIAN);
+   P_saveLevelArchive(arc, savefile, description);
+   savedata = savefile.detachMemory(savesize);
 
    // Check the heap.
    Z_CheckHeap();
 
-   if(!hub_changelevel) // sf: no 'game saved' message for hubs
-      doom_printf("%s", DEH_String("GGSAVED"));  // Ty 03/27/98 - externalized
+   savefilename = filename;
+   savetempname = filename;
+   savetempname += ".tmp";
+   saveannounce = !hub_changelevel; // sf: no 'game saved' message for hubs
+
+   const unsigned generation = ++savegeneration;
+   savejob = D_QueueJob([generation] { P_saveJob(generation); }, JOBPRI_LOW);
 }
 
 //============================================================================
@@ -1628,232 +1813,260 @@ void P_SaveCurrentLevel(char *filename, char *description)
 // Loading -- Main Routine
 //
 
-void P_LoadGame(const char *filename)
+//
+// Reads a level written by P_saveLevelArchive and sets up the game from it.
+// Returns false if the archive was turned down; read errors are thrown.
+//
+static bool P_loadLevelArchive(SaveArchive &arc, InBuffer &loadfile, bool snapshot)
 {
    int i;
-   InBuffer loadfile;
-   SaveArchive arc(&loadfile);
-
-   if(!loadfile.openFile(filename, InBuffer::NENDIAN))
-   {
-      C_Printf(FC_ERROR "Failed to load savegame %s\n", filename);
-      C_SetConsole();
-      return;
-   }
 
-   // Enable buffered IO exceptions
-   loadfile.setThrowing(true);
+   WadDirectory *tmp_g_dir = g_dir;
+   WadDirectory *tmp_d_dir = d_dir;
 
-   try
-   {
-      WadDirectory *tmp_g_dir = g_dir;
-      WadDirectory *tmp_d_dir = d_dir;
+   int     tmp_gamemap         = gamemap;
+   int     tmp_gameepisode     = gameepisode;
+   int     tmp_compatibility   = compatibility;
+   skill_t tmp_gameskill       = gameskill;
+   int     tmp_inmanageddir    = inmanageddir;
+   bool    tmp_vanilla_mode    = vanilla_mode;
+   int     tmp_demo_version    = demo_version;
+   int     tmp_demo_subversion = demo_subversion;
+   char    tmp_gamemapname[9]  = {};
+   strncpy(tmp_gamemapname, gamemapname, 9);
 
-      int     tmp_gamemap         = gamemap;
-      int     tmp_gameepisode     = gameepisode;
-      int     tmp_compatibility   = compatibility;
-      skill_t tmp_gameskill       = gameskill;
-      int     tmp_inmanageddir    = inmanageddir;
-      bool    tmp_vanilla_mode    = vanilla_mode;
-      int     tmp_demo_version    = demo_version;
-      int     tmp_demo_subversion = demo_subversion;
-      char    tmp_gamemapname[9]  = {};
-      strncpy(tmp_gamemapname, gamemapname, 9);
+   // skip description
+   char throwaway[SAVESTRINGSIZE];
 
-      // skip description
-      char throwaway[SAVESTRINGSIZE];
+   arc.archiveCString(throwaway, SAVESTRINGSIZE);
 
-      arc.archiveCString(throwaway, SAVESTRINGSIZE);
+   if(!arc.readSaveVersion())
+      return false;
 
-      if(!arc.readSaveVersion())
-         return;
+   // killough 2/14/98: load compatibility mode
+   // haleyjd 06/16/10: reload "inmasterlevels" state
+   int tempskill;
+   arc << compatibility << tempskill << inmanageddir;
+   gameskill = (skill_t)tempskill;
 
-      // killough 2/14/98: load compatibility mode
-      // haleyjd 06/16/10: reload "inmasterlevels" state
-      int tempskill;
-      arc << compatibility << tempskill << inmanageddir;
-      gameskill = (skill_t)tempskill;
+   arc << vanilla_mode;  // -vanilla setting
+   if(snapshot)          // a demo snapshot stays in the demo's version
+   {
+      demo_version    = tmp_demo_version;
+      demo_subversion = tmp_demo_subversion;
+   }
+   else if(vanilla_mode) // use UDoom version (no point for longtics now).
+   {
+      // All the other settings (save longtics) are stored in the save
+      demo_version    = 109;
+      demo_subversion = 0;
+   }
+   else
+   {
+      demo_version    = version;    // killough 7/19/98: use this version's id
+      demo_subversion = subversion; // haleyjd 06/17/01
+   }
 
-      arc << vanilla_mode;  // -vanilla setting
-      if(vanilla_mode)      // use UDoom version (no point for longtics now).
-      {
-         // All the other settings (save longtics) are stored in the save
-         demo_version    = 109;
-         demo_subversion = 0;
-      }
-      else
-      {
-         demo_version    = version;    // killough 7/19/98: use this version's id
-         demo_subversion = subversion; // haleyjd 06/17/01
-      }
+   // sf: use string rather than episode, map
+   for(i = 0; i < 8; i++)
+   {
+      int8_t lvc;
+      arc << lvc;
+      gamemapname[i] = (char)lvc;
+   }
+   gamemapname[8] = '\0'; // ending nullptr
 
-      // sf: use string rather than episode, map
-      for(i = 0; i < 8; i++)
-      {
-         int8_t lvc;
-         arc << lvc;
-         gamemapname[i] = (char)lvc;
-      }
-      gamemapname[8] = '\0'; // ending nullptr
+   G_SetGameMap(); // get gameepisode, map
 
-      G_SetGameMap(); // get gameepisode, map
+   // start out g_dir pointing at wGlobalDir again
+   g_dir = &wGlobalDir;
 
-      // start out g_dir pointing at wGlobalDir again
-      g_dir = &wGlobalDir;
+   // haleyjd 06/16/10: if the level was saved in a map loaded under a managed
+   // directory, we need to restore the managed directory to g_dir when loading
+   // the game here. When this is the case, the file name of the managed directory
+   // has been saved into the save game.
+   size_t len;
+   arc.archiveSize(len);
 
-      // haleyjd 06/16/10: if the level was saved in a map loaded under a managed
-      // directory, we need to restore the managed directory to g_dir when loading
-      // the game here. When this is the case, the file name of the managed directory
-      // has been saved into the save game.
-      size_t len;
-      arc.archiveSize(len);
+   if(len)
+   {
+      WadDirectory *dir;
+
+      // read a name of len bytes 
+      char *fn = ecalloc(char *, 1, len);
+      arc.archiveCString(fn, len);
+
+      // Try to get an existing managed wad first. If none such exists, try
+      // adding it now. If that doesn't work, the normal error message appears
+      // for a missing wad.
+      // Note: set d_dir as well, so G_InitNew won't overwrite with wGlobalDir!
+      if((dir = W_GetManagedWad(fn)) || (dir = W_AddManagedWad(fn)))
+         g_dir = d_dir = dir;
+
+      // done with temporary file name
+      efree(fn);
+
+      // 11/04/12: Since we loaded a managed directory wad, initialize the
+      // mission. This will take care of any special data loading 
+      // requirements, such as metadata for NR4TL.
+      W_InitManagedMission(inmanageddir);
+   }
 
-      if(len)
-      {
-         WadDirectory *dir;
-
-         // read a name of len bytes 
-         char *fn = ecalloc(char *, 1, len);
-         arc.archiveCString(fn, len);
-
-         // Try to get an existing managed wad first. If none such exists, try
-         // adding it now. If that doesn't work, the normal error message appears
-         // for a missing wad.
-         // Note: set d_dir as well, so G_InitNew won't overwrite with wGlobalDir!
-         if((dir = W_GetManagedWad(fn)) || (dir = W_AddManagedWad(fn)))
-            g_dir = d_dir = dir;
-
-         // done with temporary file name
-         efree(fn);
-
-         // 11/04/12: Since we loaded a managed directory wad, initialize the
-         // mission. This will take care of any special data loading 
-         // requirements, such as metadata for NR4TL.
-         W_InitManagedMission(inmanageddir);
-      }
+   // killough 3/16/98, 12/98: check lump name checksum
+   if(arc.saveVersion() >= 4)
+   {
+      uint64_t checksum, rchecksum;
+      int      numwadfiles;
+      qstring  msg{ "Possibly Incompatible Savegame.\nWads expected:\n\n" };
 
-      // killough 3/16/98, 12/98: check lump name checksum
-      if(arc.saveVersion() >= 4)
-      {
-         uint64_t checksum, rchecksum;
-         int      numwadfiles;
-         qstring  msg{ "Possibly Incompatible Savegame.\nWads expected:\n\n" };
+      checksum = G_Signature(g_dir);
 
-         checksum = G_Signature(g_dir);
+      arc << rchecksum;
+      arc << numwadfiles;
 
-         arc << rchecksum;
-         arc << numwadfiles;
+      for(int i = 0; i < numwadfiles; i++)
+      {
+         qstring fn;
+         char   *wad = nullptr;
+         size_t  len = 0;
 
-         for(int i = 0; i < numwadfiles; i++)
-         {
-            qstring fn;
-            char   *wad = nullptr;
-            size_t  len = 0;
+         arc.archiveLString(wad, len);
+         qstring(wad).extractFileBase(fn);
+         msg << fn.constPtr() << '\n';
 
-            arc.archiveLString(wad, len);
-            qstring(wad).extractFileBase(fn);
-            msg << fn.constPtr() << '\n';
+         efree(wad);
+      }
 
-            efree(wad);
-         }
+      msg << "\nAre you sure?";
 
-         msg << "\nAre you sure?";
+      if(checksum != rchecksum && !forced_loadgame)
+      {
+         // If we don't restore some state things will go very awry
+         g_dir           = tmp_g_dir;
+         d_dir           = tmp_d_dir;
+         gamemap         = tmp_gamemap;
+         gameepisode     = tmp_gameepisode;
+         compatibility   = tmp_compatibility;
+         gameskill       = tmp_gameskill;
+         inmanageddir    = tmp_inmanageddir;
+         vanilla_mode    = tmp_vanilla_mode;
+         demo_version    = tmp_demo_version;
+         demo_subversion = tmp_demo_subversion;
+         strncpy(gamemapname, tmp_gamemapname, 9);
+
+         C_Puts(msg.constPtr());
+         G_LoadGameErr(msg.constPtr());
+         loadfile.close();
 
-         if(checksum != rchecksum && !forced_loadgame)
-         {
-            // If we don't restore some state things will go very awry
-            g_dir           = tmp_g_dir;
-            d_dir           = tmp_d_dir;
-            gamemap         = tmp_gamemap;
-            gameepisode     = tmp_gameepisode;
-            compatibility   = tmp_compatibility;
-            gameskill       = tmp_gameskill;
-            inmanageddir    = tmp_inmanageddir;
-            vanilla_mode    = tmp_vanilla_mode;
-            demo_version    = tmp_demo_version;
-            demo_subversion = tmp_demo_subversion;
-            strncpy(gamemapname, tmp_gamemapname, 9);
-
-            C_Puts(msg.constPtr());
-            G_LoadGameErr(msg.constPtr());
-            loadfile.close();
-
-            return;
-         }
+         return false;
       }
+   }
 
-      for(i = 0; i < MAXPLAYERS; ++i)
-         arc << playeringame[i];
+   for(i = 0; i < MAXPLAYERS; ++i)
+      arc << playeringame[i];
 
-      for(; i < MIN_MAXPLAYERS; i++) // killough 2/28/98
-      {
-         bool dummy = 0;
-         arc << dummy;
-      }
+   for(; i < MIN_MAXPLAYERS; i++) // killough 2/28/98
+   {
+      bool dummy = 0;
+      arc << dummy;
+   }
 
-      // jff 3/17/98 restore idmus music
-      // jff 3/18/98 account for unsigned byte
-      // killough 11/98: simplify
-      // haleyjd 04/14/03: game type
-      // note: don't set DefaultGameType from save games
-      int tempGameType;
-      arc << idmusnum << tempGameType;
+   // jff 3/17/98 restore idmus music
+   // jff 3/18/98 account for unsigned byte
+   // killough 11/98: simplify
+   // haleyjd 04/14/03: game type
+   // note: don't set DefaultGameType from save games
+   int tempGameType;
+   arc << idmusnum << tempGameType;
 
-      GameType = (gametype_t)tempGameType;
+   GameType = (gametype_t)tempGameType;
 
-      /* cph 2001/05/23 - Must read options before we set up the level */
-      byte options[GAME_OPTION_SIZE];
-      loadfile.read(options, sizeof(options));
+   /* cph 2001/05/23 - Must read options before we set up the level */
+   byte options[GAME_OPTION_SIZE];
+   loadfile.read(options, sizeof(options));
 
-      G_ReadOptions(options);
+   G_ReadOptions(options);
  
-      // load a base level
-      // sf: in hubs, use g_doloadlevel instead of g_initnew
-      if(hub_changelevel)
-         G_DoLoadLevel();
-      else
-         G_InitNew(gameskill, gamemapname);
+   // load a base level
+   // sf: in hubs, use g_doloadlevel instead of g_initnew
+   if(hub_changelevel)
+      G_DoLoadLevel();
+   else
+      G_InitNew(gameskill, gamemapname);
+
+   // killough 3/1/98: Read game options
+   // killough 11/98: move down to here
+
+   // cph - MBF needs to reread the savegame options because 
+   // G_InitNew rereads the WAD options. The demo playback code does 
+   // this too.
+   G_ReadOptions(options);
+
+   // get the times
+   arc << leveltime;
+
+   // killough 11/98: load revenant tracer state
+   uint8_t tracerState;
+   arc << tracerState;
+   basetic = gametic - tracerState;
+
+   // haleyjd 04/14/03: load dmflags
+   arc << dmflags;
+
+   // dearchive all the modifications
+   P_ArchivePlayers(arc);
+   P_ArchiveWorld(arc);
+   P_ArchiveLevelInfo(arc);
+   P_ArchivePolyObjects(arc);    // haleyjd 03/27/06
+   P_ArchiveThinkers(arc);
+   P_ArchiveRNG(arc);            // killough 1/18/98: load RNG information
+   P_ArchiveMap(arc);            // killough 1/22/98: load automap information
+   P_UnArchiveSoundSequences(arc);
+   P_ArchiveButtons(arc);
+   P_ArchiveACS(arc);            // davidph 05/30/12
+
+   P_FreeThinkerTable();
+
+   uint8_t cmarker;
+   arc << cmarker;
+   if(cmarker != 0xE6)
+      I_Error("Bad savegame: last byte is 0x%x\n", cmarker);
+
+   // haleyjd: move up Z_CheckHeap to before Z_Free (safer)
+   Z_CheckHeap();
 
-      // killough 3/1/98: Read game options
-      // killough 11/98: move down to here
+   return true;
+}
+
+//
+// Restores what a level load leaves behind to the screen and status bar.
+//
+static void P_finishLoad()
+{
+   if(setsizeneeded)
+      R_ExecuteSetViewSize();
    
-      // cph - MBF needs to reread the savegame options because 
-      // G_InitNew rereads the WAD options. The demo playback code does 
-      // this too.
-      G_ReadOptions(options);
-
-      // get the times
-      arc << leveltime;
-
-      // killough 11/98: load revenant tracer state
-      uint8_t tracerState;
-      arc << tracerState;
-      basetic = gametic - tracerState;
-
-      // haleyjd 04/14/03: load dmflags
-      arc << dmflags;
-
-      // dearchive all the modifications
-      P_ArchivePlayers(arc);
-      P_ArchiveWorld(arc);
-      P_ArchiveLevelInfo(arc);
-      P_ArchivePolyObjects(arc);    // haleyjd 03/27/06
-      P_ArchiveThinkers(arc);
-      P_ArchiveRNG(arc);            // killough 1/18/98: load RNG information
-      P_ArchiveMap(arc);            // killough 1/22/98: load automap information
-      P_UnArchiveSoundSequences(arc);
-      P_ArchiveButtons(arc);
-      P_ArchiveACS(arc);            // davidph 05/30/12
-
-      P_FreeThinkerTable();
-
-      uint8_t cmarker;
-      arc << cmarker;
-      if(cmarker != 0xE6)
-         I_Error("Bad savegame: last byte is 0x%x\n", cmarker);
-
-      // haleyjd: move up Z_CheckHeap to before Z_Free (safer)
-      Z_CheckHeap(); 
+   // draw the pattern into the back screen
+   R_FillBackScreen(scaledwindow);
+
+   // haleyjd 02/09/10: wake up status bar again
+   ST_Start();
+}
+
+//
+// Loads a savegame from an opened buffer and sets the game going from it.
+//
+static void P_loadGameFrom(InBuffer &loadfile)
+{
+   SaveArchive arc(&loadfile);
+
+   // Enable buffered IO exceptions
+   loadfile.setThrowing(true);
+
+   try
+   {
+      if(!P_loadLevelArchive(arc, loadfile, false))
+         return;
    }
    catch(...)
    {
@@ -1863,14 +2076,7 @@ void P_LoadGame(const char *filename)
 
    loadfile.close();
 
-   if (setsizeneeded)
-      R_ExecuteSetViewSize();
-   
-   // draw the pattern into the back screen
-   R_FillBackScreen(scaledwindow);
-
-   // haleyjd 02/09/10: wake up status bar again
-   ST_Start();
+   P_finishLoad();
 
    // killough 12/98: support -recordfrom and -loadgame -playdemo
    if(!command_loadgame)
@@ -1890,6 +2096,83 @@ void P_LoadGame(const char *filename)
       P_RestorePlayerPosition();
 }
 
+void P_LoadGame(const char *filename)
+{
+   InBuffer loadfile;
+
+   P_FinishSaveGame();
+
+   if(!loadfile.openInflated(filename, InBuffer::NENDIAN))
+   {
+      C_Printf(FC_ERROR "Failed to load savegame %s\n", filename);
+      C_SetConsole();
+      return;
+   }
+
+   P_loadGameFrom(loadfile);
+}
+
+//
+// Loads a savegame held in memory, such as a level left behind in a hub.
+//
+void P_LoadGameFromMemory(const byte *data, size_t size)
+{
+   InBuffer loadfile;
+
+   loadfile.openMemory(data, size, InBuffer::NENDIAN);
+   P_loadGameFrom(loadfile);
+}
+
+//============================================================================
+//
+// Demo snapshots
+//
+// The level archived to memory, so demo playback can seek back to it.
+//
+
+//
+// Archives the current level into a new block, which the caller must efree.
+//
+void P_SaveSnapshot(byte *&data, size_t &size)
+{
+   OutBuffer snapfile;
+   SaveArchive arc(&snapfile);
+   char description[SAVESTRINGSIZE] = "snapshot";
+
+   // memory output only grows, so there is nothing to fail
+   snapfile.createMemory(256*1024, OutBuffer::NENDIAN);
+   P_saveLevelArchive(arc, snapfile, description);
+
+   data = snapfile.detachMemory(size);
+}
+
+//
+// Sets up the level from a block written by P_SaveSnapshot. The caller
+// restores the demo and tic state that loading a game resets.
+//
+void P_LoadSnapshot(const byte *data, size_t size)
+{
+   InBuffer snapfile;
+   SaveArchive arc(&snapfile);
+
+   snapfile.openMemory(data, size, InBuffer::NENDIAN);
+   snapfile.setThrowing(true);
+
+   try
+   {
+      if(!P_loadLevelArchive(arc, snapfile, true))
+         I_Error("P_LoadSnapshot: snapshot was not accepted\n");
+   }
+   catch(...)
+   {
+      I_Error("P_LoadSnapshot: snapshot read error\n");
+   }
+
+   snapfile.close();
+
+   P_finishLoad();
+}
+
 //----------------------------------------------------------------------------
 //
 // $Log: p_saveg.c,v $
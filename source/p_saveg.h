@@ -69,11 +69,13 @@ private:
    int mNextCachedStringID = 0;
    PODCollection<CachedString *> mCacheStringHolder;  // to be cleared on destruction
 
+   int32_t mLastPosition[3] = {}; // last point archived by archivePosition
+
 protected:
    OutBuffer *savefile;        // valid when saving
    InBuffer  *loadfile;        // valid when loading
 
-   static constexpr int WRITE_SAVE_VERSION = 14; // Version of saves that EE writes
+   static constexpr int WRITE_SAVE_VERSION = 15; // Version of saves that EE writes
    int read_save_version;                       // Version of currently-read save
 
 
@@ -115,6 +117,15 @@ public:
    // archive a size_t
    void archiveSize(size_t &value);
 
+   // archive an integer which is usually small, in fewer bytes from save
+   // version 15 on
+   void archiveVarInt(int32_t &value);
+   void archiveVarInt(int16_t &value);
+   void archiveVarUint(uint32_t &value);
+
+   // archive a point as its distance from the last one archived
+   void archivePosition(int32_t &x, int32_t &y, int32_t &z);
+
    // read in the version number
    bool readSaveVersion();
    // write out the version number
@@ -176,7 +187,11 @@ Thinker *P_ThinkerForNum(unsigned int n);
 void P_SetNewTarget(Mobj **mop, Mobj *targ);
 
 void P_SaveCurrentLevel(char *filename, char *description);
+void P_FinishSaveGame();
 void P_LoadGame(const char *filename);
+void P_LoadGameFromMemory(const byte *data, size_t size);
+void P_SaveSnapshot(byte *&data, size_t &size);
+void P_LoadSnapshot(const byte *data, size_t size);
 
 #endif
 
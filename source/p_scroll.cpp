@@ -31,6 +31,7 @@
 #include "p_mobj.h"
 #include "p_portal.h"   // ioanch 20160115: portal aware
 #include "p_portalcross.h"
+#include "p_profile.h"
 #include "p_saveg.h"
 #include "p_scroll.h"
 #include "p_spec.h"
@@ -70,6 +71,38 @@ static scrollerlist_t *scrollers;
 static PODCollection<sidelerpinfo_t> pScrolledSides;
 static PODCollection<seclerpinfo_t> pScrolledSectors;
 
+//
+// Static scrollers
+//
+// A scroller with no control sector and no acceleration moves its surface
+// by the same amount every tic, so those scrolling walls, floors and
+// ceilings are kept in flat arrays and moved in one pass per tic instead of
+// one virtual Think call each. They stay on the thinker list, so savegames
+// and thinker numbering are unchanged; their Think just returns. Carriers
+// push things and always run in list order.
+//
+struct staticsidescroll_t
+{
+   side_t        *side;
+   v2fixed_t      offset;
+   ScrollThinker *owner;
+};
+
+struct staticflatscroll_t
+{
+   sector_t      *sector;
+   bool           isceiling;
+   v2fixed_t      offset;
+   ScrollThinker *owner;
+};
+
+static PODCollection<staticsidescroll_t> staticSides;
+static PODCollection<staticflatscroll_t> staticFlats;
+
+// Sides of 3DMidTex lines, built on first use each level. Things stand on
+// those middle textures, so moving their rows must stay in thinker order.
+static PODCollection<byte> midTexSides;
+
 IMPLEMENT_THINKER_TYPE(ScrollThinker)
 
 // killough 2/28/98:
@@ -93,6 +126,9 @@ IMPLEMENT_THINKER_TYPE(ScrollThinker)
 //
 void ScrollThinker::Think()
 {
+   if(batchindex >= 0) // moved by P_RunStaticScrollers
+      return;
+
    fixed_t dx = this->dx, dy = this->dy;
    
    if(this->control != -1)
@@ -175,21 +211,24 @@ void ScrollThinker::Think()
       // haleyjd: added much-needed MF2_NOTHRUST flag to make some
       //   objects unmoveable by sector effects
 
-      for(node = sec->touching_thinglist; node; node = node->m_snext)
+      // the flag and height tests are cheaper than the portal one, so
+      // things that wouldn't be carried anyway are passed over first
       {
-         // ioanch 20160115: portal aware
-         if(useportalgroups && full_demo_version >= make_full_version(340, 48) &&
-            !P_SectorTouchesThingVertically(sec, node->m_thing))
-         {
-            continue;
-         }
-         if(!((thing = node->m_thing)->flags & MF_NOCLIP) &&
-            !(thing->flags2 & MF2_NOTHRUST) &&
-            (!(thing->flags & MF_NOGRAVITY || thing->z > height) ||
-             thing->z < waterheight))
+         const bool vertical = useportalgroups &&
+            full_demo_version >= make_full_version(340, 48);
+
+         for(node = sec->touching_thinglist; node; node = node->m_snext)
          {
-            thing->momx += dx;
-            thing->momy += dy;
+            if(!((thing = node->m_thing)->flags & MF_NOCLIP) &&
+               !(thing->flags2 & MF2_NOTHRUST) &&
+               (!(thing->flags & MF_NOGRAVITY || thing->z > height) ||
+                thing->z < waterheight) &&
+               // ioanch 20160115: portal aware
+               (!vertical || P_SectorTouchesThingVertically(sec, thing)))
+            {
+               thing->momx += dx;
+               thing->momy += dy;
+            }
          }
       }
       break;
@@ -212,7 +251,113 @@ void ScrollThinker::serialize(SaveArchive &arc)
        << accel << type;
 
    if(arc.isLoading())
+   {
       addScroller();
+      addStatic();
+   }
+}
+
+//
+// Is the side on a line with a 3DMidTex?
+//
+static bool P_isMidTexSide(int sidenum)
+{
+   if(midTexSides.isEmpty() && numsides)
+   {
+      midTexSides.resize(numsides);
+
+      for(int i = 0; i < numlines; i++)
+      {
+         if(!(lines[i].flags & ML_3DMIDTEX))
+            continue;
+         for(int sidenum : lines[i].sidenum)
+         {
+            if(sidenum != -1)
+               midTexSides[sidenum] = 1;
+         }
+      }
+   }
+
+   return sidenum >= 0 && size_t(sidenum) < midTexSides.getLength() &&
+      midTexSides[sidenum];
+}
+
+//
+// Moves the scroller into the static arrays if it never changes speed.
+//
+void ScrollThinker::addStatic()
+{
+   batchindex = -1;
+
+   if(control != -1 || accel || !(dx | dy))
+      return;
+
+   if(type == sc_side)
+   {
+      if(dy && P_isMidTexSide(affectee))
+         return;
+
+      staticsidescroll_t &entry = staticSides.addNew();
+      entry.side     = sides + affectee;
+      entry.offset.x = dx;
+      entry.offset.y = dy;
+      entry.owner    = this;
+      batchindex = int(staticSides.getLength() - 1);
+   }
+   else if(type == sc_floor || type == sc_ceiling)
+   {
+      staticflatscroll_t &entry = staticFlats.addNew();
+      entry.sector    = sectors + affectee;
+      entry.isceiling = (type == sc_ceiling);
+      entry.offset.x  = dx;
+      entry.offset.y  = dy;
+      entry.owner     = this;
+      batchindex = int(staticFlats.getLength() - 1);
+   }
+}
+
+//
+// Takes the scroller out of the static arrays, moving the last entry into
+// its place.
+//
+void ScrollThinker::removeStatic()
+{
+   if(batchindex < 0)
+      return;
+
+   if(type == sc_side)
+   {
+      staticsidescroll_t &last = staticSides.back();
+      last.owner->batchindex = batchindex;
+      staticSides[batchindex] = last;
+      staticSides.pop();
+   }
+   else
+   {
+      staticflatscroll_t &last = staticFlats.back();
+      last.owner->batchindex = batchindex;
+      staticFlats[batchindex] = last;
+      staticFlats.pop();
+   }
+
+   batchindex = -1;
+}
+
+//
+// Stops a static scroller moving its surface as soon as it is removed.
+//
+void ScrollThinker::remove()
+{
+   removeStatic();
+   Super::remove();
+}
+
+//
+// Savegame loading deletes thinkers without removing them first.
+//
+ScrollThinker::~ScrollThinker()
+{
+   removeStatic();
 }
 
 //
@@ -252,6 +397,10 @@ void ScrollThinker::RemoveAllScrollers()
       efree(scrollers);
       scrollers = next;
    }
+
+   staticSides.makeEmpty();
+   staticFlats.makeEmpty();
+   midTexSides.makeEmpty();
 }
 
 //
@@ -319,6 +468,7 @@ void Add_Scroller(int type, fixed_t dx, fixed_t dy,
       sides[affectee].intflags |= SDI_VERTICALLYSCROLLING;
 
    s->addThinker();
+   s->addStatic();
 }
 
 // Adds wall scroller. Scroll amount is rotated with respect to wall's
@@ -935,6 +1085,62 @@ void P_ForEachScrolledSector(void (*func)(sector_t *sector, bool isceiling, v2fi
       func(info.sector, info.isceiling, info.offset);
 }
 
+//
+// Moves every static scroller's surface for this tic and records it for
+// interpolation. Called once per tic, ahead of the thinkers.
+//
+void P_RunStaticScrollers()
+{
+   const size_t numwalls = staticSides.getLength();
+   const size_t numflats = staticFlats.getLength();
+
+   if(!(numwalls | numflats))
+      return;
+
+   const auto start = std::chrono::steady_clock::now();
+
+   if(numwalls)
+   {
+      const size_t first = pScrolledSides.getLength();
+      pScrolledSides.resize(first + numwalls);
+      sidelerpinfo_t *info = &pScrolledSides[first];
+
+      for(const staticsidescroll_t &entry : staticSides)
+      {
+         entry.side->textureoffset += entry.offset.x;
+         entry.side->rowoffset     += entry.offset.y;
+         info->side   = entry.side;
+         info->offset = entry.offset;
+         ++info;
+      }
+   }
+
+   if(numflats)
+   {
+      const size_t first = pScrolledSectors.getLength();
+      pScrolledSectors.resize(first + numflats);
+      seclerpinfo_t *info = &pScrolledSectors[first];
+
+      for(const staticflatscroll_t &entry : staticFlats)
+      {
+         surface_t &surface = entry.isceiling ? entry.sector->srf.ceiling :
+                                                entry.sector->srf.floor;
+         surface.offset.x += entry.offset.x;
+         surface.offset.y += entry.offset.y;
+         info->sector    = entry.sector;
+         info->isceiling = entry.isceiling;
+         info->offset    = entry.offset;
+         ++info;
+      }
+   }
+
+   if(p_profiling)
+   {
+      P_ProfileThinker(RTTI(ScrollThinker), numwalls + numflats,
+                       std::chrono::steady_clock::now() - start);
+   }
+}
+
 // killough 3/7/98 -- end generalized scroll effects
 
 // EOF
@@ -38,16 +38,23 @@ class ScrollThinker : public Thinker
 {
    DECLARE_THINKER_TYPE(ScrollThinker, Thinker)
 
+   friend class Thinker; // batched by RunGroupedThinkers
+
 protected:
    void Think() override;
 
 public:
+   ~ScrollThinker();
+
    // Overridden Methods
    virtual void serialize(SaveArchive &arc) override;
+   virtual void remove() override;
 
    // Methods
    void addScroller();
    void removeScroller();
+   void addStatic();
+   void removeStatic();
 
    // Static Methods
    static void RemoveAllScrollers();
@@ -69,6 +76,7 @@ public:
    };
    int type;              // Type of scroll effect
    struct scrollerlist_t *list;
+   int batchindex = -1;   // index in the static scroller arrays, or -1
 };
 
 void Add_Scroller(int type, fixed_t dx, fixed_t dy,
@@ -90,6 +98,7 @@ enum udmfscrolltype_e : int
 void P_SpawnFloorUDMF(int s, int type, double scrollx, double scrolly);
 void P_SpawnCeilingUDMF(int s, int type, double scrollx, double scrolly);
 
+void P_RunStaticScrollers();
 void P_TicResetLerpScrolledSides();
 void P_AddScrolledSide(side_t *side, fixed_t dx, fixed_t dy);
 void P_ForEachScrolledSide(void (*func)(side_t *side, v2fixed_t offset));
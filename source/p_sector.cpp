@@ -250,19 +250,41 @@ int EV_SectorSoundChange(int tag, int sndSeqID)
 // P_SaveSectorPositions
 //
 // Backup current sector floor and ceiling heights to the sector interpolation
-// structures at the beginning of a frame.
+// structures at the beginning of a frame. Only sectors that moved since the
+// last call can differ from their saved heights, so only those are visited.
 //
 void P_SaveSectorPositions()
 {
-   for(int i = 0; i < numsectors; i++)
+   for(int i = 0; i < nummovedsectors; i++)
    {
-      auto &si  = sectorinterps[i];
-      auto &sec = sectors[i];
+      auto &si  = sectorinterps[movedsectors[i]];
+      auto &sec = sectors[movedsectors[i]];
 
       si.prevfloorheight    = sec.srf.floor.height;
       si.prevfloorheightf   = sec.srf.floor.heightf;
       si.prevceilingheight  = sec.srf.ceiling.height;
       si.prevceilingheightf = sec.srf.ceiling.heightf;
+      si.moved = false;
+   }
+   nummovedsectors = 0;
+}
+
+//
+// Lists a sector whose floor or ceiling height changed this tic, for
+// interpolation. Copies of sectors made by the renderer are ignored.
+//
+void P_MarkSectorMoved(const sector_t &sec)
+{
+   const auto index = &sec - sectors;
+
+   if(!sectorinterps || index < 0 || index >= numsectors)
+      return;
+
+   auto &si = sectorinterps[index];
+   if(!si.moved)
+   {
+      si.moved = true;
+      movedsectors[nummovedsectors++] = int(index);
    }
 }
 
@@ -38,6 +38,7 @@ enum ssurftype_e
 void P_SaveSectorPositions();
 void P_SaveSectorPosition(const sector_t &sec);
 void P_SaveSectorPosition(const sector_t &sec, ssurftype_e surf);
+void P_MarkSectorMoved(const sector_t &sec);
 void P_NewSectorActionFromMobj(Mobj *actor);
 void P_SetSectorZoneFromMobj(Mobj *actor);
 
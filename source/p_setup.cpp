@@ -23,7 +23,9 @@
 //
 
 
+#include <algorithm>
 #include <memory>
+#include <vector>
 #include "z_zone.h"
 
 #include "a_small.h"
@@ -31,8 +33,10 @@
 #include "am_map.h"
 #include "c_io.h"
 #include "c_runcmd.h"
+#include "d_framestats.h"
 #include "d_gi.h"
 #include "d_io.h" // SoM 3/14/2002: strncasecmp
+#include "d_jobs.h"
 #include "d_main.h"
 #include "d_mod.h"
 #include "doomstat.h"
@@ -50,7 +54,10 @@
 #include "m_argv.h"
 #include "m_bbox.h"
 #include "m_binary.h"
+#include "m_compare.h"
 #include "m_hash.h"
+#include "m_loadtrace.h"
+#include "m_zonestats.h"
 #include "p_anim.h"  // haleyjd: lightning
 #include "p_chase.h"
 #include "p_enemy.h"
@@ -73,6 +80,7 @@
 #include "r_defs.h"
 #include "r_dynseg.h"
 #include "r_main.h"
+#include "r_pvs.h"
 #include "r_sky.h"
 #include "r_things.h"
 #include "s_musinfo.h"
@@ -83,6 +91,7 @@
 #include "w_levels.h"
 #include "w_wad.h"
 #include "z_auto.h"
+#include "../zlib/zlib.h"
 
 extern const char *level_error;
 
@@ -134,6 +143,8 @@ sector_t *sectors;
 
 // haleyjd 01/05/14: sector interpolation data
 sectorinterp_t *sectorinterps;
+int            *movedsectors;
+int             nummovedsectors;
 
 // ioanch: list of sector bounding boxes for sector portal seg rejection (coarse)
 // length: numsectors * 4
@@ -149,6 +160,7 @@ subsector_t *subsectors;
 int      numnodes;
 node_t   *nodes;
 fnode_t  *fnodes;
+bspnode_t *bspnodes;
 
 int      numlines;
 int      numlinesPlusExtra;
@@ -179,6 +191,9 @@ int       *blockmaplump;          // was short -- killough
 fixed_t   bmaporgx, bmaporgy;     // origin of block map
 
 Mobj    **blocklinks;             // for thing chains
+blockthings_t *blockthings;       // same, contiguous per block
+blocklines_t  *blocklines;        // blockmap lists with line boxes
+linehot_t     *linehot;           // hot line fields, indexed like lines
 
 byte     *portalmap;              // haleyjd: for portals
 
@@ -195,6 +210,12 @@ bool      skipblstart;            // MaxW: Skip initial blocklist short
 
 byte *rejectmatrix;
 
+// Whether to work out a reject for maps that come with an empty one
+bool p_autoreject;
+
+// True if the level's REJECT rejected nothing when loaded
+static bool rejectempty;
+
 static int gTotalLinesForRejectOverflow;  // ioanch 20160309: for REJECT fix
 
 // Maintain single and multi player starting spots.
@@ -730,7 +751,9 @@ static void P_LoadSectors(int lumpnum)
 //
 static void P_CreateSectorInterps()
 {
-   sectorinterps = estructalloctag(sectorinterp_t, numsectors, PU_LEVEL);
+   sectorinterps   = estructalloctag(sectorinterp_t, numsectors, PU_LEVEL);
+   movedsectors    = emalloctag(int *, numsectors * sizeof(int), PU_LEVEL, nullptr);
+   nummovedsectors = 0;
 
    for(int i = 0; i < numsectors; i++)
    {
@@ -755,6 +778,8 @@ static void P_createSectorBoundingBoxes()
       float *fbox = pSectorBoxes[i].fbox;
       M_ClearBox(box);
       M_ClearBox(fbox);
+      M_ClearBox(pSectorBoxes[i].thingbox);
+      pSectorBoxes[i].thingxscale = 0;
       for(int j = 0; j < sector.linecount; ++j)
       {
          const line_t &line = *sector.lines[j];
@@ -1031,8 +1056,6 @@ static bool P_CheckForDeePBSPv4Nodes(int lumpnum)
 //
 static ZNodeType P_checkForZDoomNodes(int nodelumpnum, int *actualNodeLump, bool udmf)
 {
-   const void *data;
-   
    *actualNodeLump = nodelumpnum;
    bool glNodesFallback = false;
 
@@ -1051,8 +1074,17 @@ static ZNodeType P_checkForZDoomNodes(int nodelumpnum, int *actualNodeLump, bool
          return ZNodeType_Invalid;
    }
 
-   // haleyjd: load at PU_CACHE and it may stick around for later.
-   data = setupwad->cacheLumpNum(*actualNodeLump, PU_CACHE);
+   // only the signature is needed; the loader streams the rest
+   char data[4];
+   if(WadLumpStream *stream = setupwad->openLumpStream(*actualNodeLump))
+   {
+      const size_t got = stream->read(data, sizeof(data));
+      delete stream;
+      if(got != sizeof(data))
+         return ZNodeType_Invalid;
+   }
+   else
+      memcpy(data, setupwad->cacheLumpNum(*actualNodeLump, PU_CACHE), sizeof(data));
 
    if(!udmf && !glNodesFallback)
    {
@@ -1064,9 +1096,8 @@ static ZNodeType P_checkForZDoomNodes(int nodelumpnum, int *actualNodeLump, bool
       }
       if(!memcmp(data, "ZNOD", 4))
       {
-         // Warn but don't quit (ZNOD may be accidental)
-         C_Printf("Warning: ZNOD header detected; ZDBSP compressed nodes are not supported\n");
-         return ZNodeType_Invalid;
+         C_Printf("ZDoom compressed normal nodes detected\n");
+         return ZNodeType_Compressed_Normal;
       }
    }
 
@@ -1088,11 +1119,20 @@ static ZNodeType P_checkForZDoomNodes(int nodelumpnum, int *actualNodeLump, bool
          C_Printf("ZDoom uncompressed GL nodes version 3 detected\n");
          return ZNodeType_Uncompressed_GL3;
       }
-      if(!memcmp(data, "ZGLN", 4) || !memcmp(data, "ZGL2", 4) || !memcmp(data, "ZGL3", 4))
+      if(!memcmp(data, "ZGLN", 4))
       {
-         // Warn but don't quit (ZGL* may be accidental)
-         C_Printf("Warning: ZGL* header detected; ZDBSP compressed nodes are not supported\n");
-         return ZNodeType_Invalid;
+         C_Printf("ZDoom compressed GL nodes version 1 detected\n");
+         return ZNodeType_Compressed_GL;
+      }
+      if(!memcmp(data, "ZGL2", 4))
+      {
+         C_Printf("ZDoom compressed GL nodes version 2 detected\n");
+         return ZNodeType_Compressed_GL2;
+      }
+      if(!memcmp(data, "ZGL3", 4))
+      {
+         C_Printf("ZDoom compressed GL nodes version 3 detected\n");
+         return ZNodeType_Compressed_GL3;
       }
    }
 
@@ -1100,19 +1140,6 @@ static ZNodeType P_checkForZDoomNodes(int nodelumpnum, int *actualNodeLump, bool
    return ZNodeType_Invalid;
 }
 
-//
-// CheckZNodesOverflow
-//
-// For safe reading of ZDoom nodes lump.
-//
-static void CheckZNodesOverflowFN(int *size, int count)
-{
-   (*size) -= count;
-
-   if((*size) < 0)
-      level_error = "Overflow in ZDoom XNOD lump";
-}
-
 // IOANCH 20151217: updated for XGLN and XGL2
 struct mapseg_znod_t
 {
@@ -1126,32 +1153,6 @@ struct mapseg_znod_t
    byte     side;
 };
 
-// IOANCH: modified to support XGL3 nodes
-struct mapnode_znod_t
-{
-  union
-  {
-     struct
-     {
-        int16_t x;  // Partition line from (x,y) to x+dx,y+dy)
-        int16_t y;
-        int16_t dx;
-        int16_t dy;             
-     };
-     struct
-     {
-        int32_t x32;  // Partition line from (x,y) to x+dx,y+dy)
-        int32_t y32;
-        int32_t dx32;
-        int32_t dy32;             
-     };
-  };
-  // Bounding box for each child, clip against view frustum.
-  int16_t bbox[2][4];
-  // If NF_SUBSECTOR its a subsector, else it's a node of another subtree.
-  int32_t children[2];
-};
-
 //
 // R_DynaSegOffset
 //
@@ -1171,13 +1172,182 @@ static void R_calcSegOffset(seg_t *lseg, const line_t *line, int side)
    lseg->offset = sqrtf(dx * dx + dy * dy);
 }
 
+//
+// ZNodeReader
+//
+// Reads ZDoom node data in order through a small buffer, straight from the
+// lump and inflating it on the way for the compressed formats, so the loader
+// can build the level's arrays without the lump ever being loaded whole.
+//
+class ZNodeReader
+{
+public:
+   ZNodeReader(int lump, bool compressed);
+   ~ZNodeReader();
+
+   bool reserve(uint64_t len);
+
+   byte     getByte()   { return *take(1); }
+   int16_t  getWord()   { byte *p = take(2); return GetBinaryWord(p);   }
+   uint16_t getUWord()  { byte *p = take(2); return GetBinaryUWord(p);  }
+   int32_t  getDWord()  { byte *p = take(4); return GetBinaryDWord(p);  }
+   uint32_t getUDWord() { byte *p = take(4); return GetBinaryUDWord(p); }
+
+private:
+   static constexpr size_t BUFFERSIZE = 64 * 1024;
+
+   // Worst case growth of deflated data, for bounding what's left of it
+   static constexpr uint64_t MAXINFLATERATIO = 1032;
+
+   WadLumpStream *stream;
+   void          *cached;      // whole lump, if it can't be streamed
+   bool           compressed;
+   bool           finished;    // end of the deflated data reached
+   z_stream       zs;
+   byte          *inbuf, *outbuf;
+   size_t         outpos, outend;
+   byte           failbytes[4];
+
+   byte *take(size_t len);
+   void  fill();
+};
+
+ZNodeReader::ZNodeReader(int lump, bool pCompressed)
+   : stream(setupwad->openLumpStream(lump)), cached(nullptr),
+     compressed(pCompressed), finished(false), zs(), inbuf(nullptr),
+     outpos(0), outend(0), failbytes()
+{
+   if(!stream)
+   {
+      cached = setupwad->cacheLumpNum(lump, PU_STATIC);
+      stream = new WadMemoryStream(cached, setupwad->lumpLength(lump));
+   }
+
+   outbuf = emalloc(byte *, BUFFERSIZE);
+
+   // skip the signature; only what follows it is compressed
+   stream->seek(4);
+
+   if(compressed)
+   {
+      inbuf = emalloc(byte *, BUFFERSIZE);
+      if(inflateInit(&zs) != Z_OK)
+         level_error = "Could not inflate ZDoom nodes";
+   }
+}
+
+ZNodeReader::~ZNodeReader()
+{
+   if(compressed)
+   {
+      inflateEnd(&zs);
+      efree(inbuf);
+   }
+   efree(outbuf);
+   delete stream;
+   if(cached)
+      Z_ChangeTag(cached, PU_CACHE);
+}
+
+//
+// Moves on to more of the node data, keeping what's left of the buffer.
+//
+void ZNodeReader::fill()
+{
+   memmove(outbuf, outbuf + outpos, outend - outpos);
+   outend -= outpos;
+   outpos  = 0;
+
+   if(!compressed)
+   {
+      outend += stream->read(outbuf + outend, BUFFERSIZE - outend);
+      return;
+   }
+
+   while(!finished && !level_error && outend < BUFFERSIZE)
+   {
+      if(!zs.avail_in)
+      {
+         zs.next_in  = inbuf;
+         zs.avail_in = uInt(stream->read(inbuf, BUFFERSIZE));
+      }
+
+      zs.next_out  = outbuf + outend;
+      zs.avail_out = uInt(BUFFERSIZE - outend);
+
+      const int code = inflate(&zs, Z_NO_FLUSH);
+      outend = BUFFERSIZE - zs.avail_out;
+
+      if(code == Z_STREAM_END)
+         finished = true;
+      else if(code != Z_OK)
+         level_error = "Bad compressed ZDoom nodes";
+   }
+}
+
+//
+// Returns the next len bytes of node data. If there aren't that many, an
+// error is raised and zeroes are returned, so parsing can finish safely.
+//
+byte *ZNodeReader::take(size_t len)
+{
+   if(outend - outpos < len)
+   {
+      fill();
+      if(outend - outpos < len)
+      {
+         if(!level_error)
+            level_error = "Overflow in ZDoom XNOD lump";
+         return failbytes;
+      }
+   }
+
+   byte *data = outbuf + outpos;
+   outpos += len;
+   return data;
+}
+
+//
+// Makes sure the data could still have len more bytes before arrays are made
+// for them. Compressed data can only be bounded by how far it could inflate.
+//
+bool ZNodeReader::reserve(uint64_t len)
+{
+   uint64_t left = outend - outpos;
+
+   if(!compressed)
+      left += stream->size() - stream->tell();
+   else if(!finished)
+      left += (uint64_t(stream->size() - stream->tell()) + zs.avail_in) * MAXINFLATERATIO;
+
+   if(left < len && !level_error)
+      level_error = "Overflow in ZDoom XNOD lump";
+
+   return !level_error;
+}
+
+//
+// Runs func over contiguous ranges of [0, count), in parallel when there is
+// enough to go round.
+//
+static void P_runRangesParallel(int count, const std::function<void(int, int)> &func)
+{
+   static constexpr int ITEMSPERRANGE = 16384;
+
+   const int numranges = eclamp(emin(D_NumJobWorkers() + 1, count / ITEMSPERRANGE), 1, 64);
+
+   D_RunParallel(numranges, [count, numranges, &func] (int r) {
+      func(int(int64_t(count) * r / numranges), int(int64_t(count) * (r + 1) / numranges));
+   });
+}
+
 //
 // P_LoadZSegs
 //
 // Loads segs from ZDoom uncompressed nodes
 // IOANCH 20151217: use signature
 //
-static void P_LoadZSegs(byte *data, ZNodeType signature)
+static void P_LoadZSegs(ZNodeReader &reader, ZNodeType signature)
 {
    // IOANCH TODO: read the segs according to signature
    int i;
@@ -1211,9 +1381,9 @@ static void P_LoadZSegs(byte *data, ZNodeType signature)
       }
 
       // haleyjd: FIXME - see no verification of vertex indices
-      v1 = ml.v1 = GetBinaryUDWord(data);
+      v1 = ml.v1 = reader.getUDWord();
       if(signature == ZNodeType_Uncompressed_Normal)   // IOANCH: only set directly for nonGL
-         v2 = ml.v2 = GetBinaryUDWord(data);
+         v2 = ml.v2 = reader.getUDWord();
       else
       {
          if(actualSegIndex == ss->firstline && !firstV1) // only set it once
@@ -1222,19 +1392,18 @@ static void P_LoadZSegs(byte *data, ZNodeType signature)
          {
             // set the second vertex of previous
             prevSegToSet->v2 = ::vertexes + v1;   
-            P_CalcSegLength(prevSegToSet);
             prevSegToSet = nullptr;   // consume it
          }
          
-         ml.partner = GetBinaryUDWord(data);   // IOANCH: not used in EE
+         ml.partner = reader.getUDWord();   // IOANCH: not used in EE
       }
       
       // IOANCH
       if(signature == ZNodeType_Uncompressed_Normal || signature == ZNodeType_Uncompressed_GL)
-         ml.linedef = GetBinaryUWord(data);
+         ml.linedef = reader.getUWord();
       else
-         ml.linedef = GetBinaryUDWord(data);
-      ml.side    = *data++;
+         ml.linedef = reader.getUDWord();
+      ml.side    = reader.getByte();
       
       if((signature == ZNodeType_Uncompressed_GL && ml.linedef == 0xffff)
          || ((signature == ZNodeType_Uncompressed_GL2 || signature == ZNodeType_Uncompressed_GL3) 
@@ -1274,10 +1443,7 @@ static void P_LoadZSegs(byte *data, ZNodeType signature)
          {
             li->v2 = firstV1;
             if(firstV1) // firstV1 can be null because of malformed subsectors
-            {
-               P_CalcSegLength(li);
                firstV1 = nullptr;
-            }
             else
                level_error = "Bad ZDBSP nodes; can't start level.";
          }
@@ -1287,36 +1453,34 @@ static void P_LoadZSegs(byte *data, ZNodeType signature)
          }
       }
 
-      if(li->v2)  // IOANCH: only count if v2 is available.
-         P_CalcSegLength(li);
       R_calcSegOffset(li, ldef, side);
    }
    
    // IOANCH: update the seg count
    ::numsegs = actualSegIndex;
-}
 
-#define CheckZNodesOverflow(size, count) \
-   CheckZNodesOverflowFN(&(size), (count)); \
-   if(level_error) \
-   { \
-      Z_Free(lumpptr); \
-      return; \
-   }
+   // lengths once every seg has both its vertices
+   P_runRangesParallel(numsegs, [] (int first, int last) {
+      for(int s = first; s < last; s++)
+      {
+         if(segs[s].v2)  // IOANCH: only count if v2 is available.
+            P_CalcSegLength(&segs[s]);
+      }
+   });
+}
 
 //
 // P_LoadZNodes
 //
-// Loads ZDoom uncompressed nodes.
+// Loads ZDoom nodes, compressed or not, streaming them from the lump into
+// the level's arrays.
 // IOANCH 20151217: check signature and use different gl nodes if needed
 // ioanch: 20151221: fixed some memory leaks. Also moved the bounds checks 
 // before attempting to allocate memory, so the app won't terminate.
 //
 static void P_LoadZNodes(int lump, ZNodeType signature)
 {
-   byte *data, *lumpptr;
    unsigned int i;
-   int len;
 
    uint32_t orgVerts, newVerts;
    uint32_t numSubs, currSeg;
@@ -1324,22 +1488,25 @@ static void P_LoadZNodes(int lump, ZNodeType signature)
    uint32_t numNodes;
    vertex_t *newvertarray = nullptr;
 
-   data = lumpptr = (byte *)(setupwad->cacheLumpNum(lump, PU_STATIC));
-   len  = setupwad->lumpLength(lump);
+   // the compressed formats are the uncompressed ones deflated
+   const bool compressed = signature >= ZNodeType_Compressed_Normal;
+   if(compressed)
+   {
+      signature = static_cast<ZNodeType>(signature - ZNodeType_Compressed_Normal +
+                                         ZNodeType_Uncompressed_Normal);
+   }
 
-   // skip header
-   CheckZNodesOverflow(len, 4);
-   data += 4;
+   ZNodeReader reader(lump, compressed);
 
    // Read extra vertices added during node building
-   CheckZNodesOverflow(len, sizeof(orgVerts));  
-   orgVerts = GetBinaryUDWord(data);
-
-   CheckZNodesOverflow(len, sizeof(newVerts));
-   newVerts = GetBinaryUDWord(data);
+   if(!reader.reserve(2 * sizeof(uint32_t)))
+      return;
+   orgVerts = reader.getUDWord();
+   newVerts = reader.getUDWord();
 
    // ioanch: moved before the potential allocation
-   CheckZNodesOverflow(len, newVerts * 2 * sizeof(int32_t));
+   if(!reader.reserve(uint64_t(newVerts) * 2 * sizeof(int32_t)))
+      return;
    if(orgVerts + newVerts == (unsigned int)numvertexes)
    {
       newvertarray = vertexes;
@@ -1355,8 +1522,8 @@ static void P_LoadZNodes(int lump, ZNodeType signature)
    {
       int vindex = i + orgVerts;
 
-      newvertarray[vindex].x = (fixed_t)GetBinaryDWord(data);
-      newvertarray[vindex].y = (fixed_t)GetBinaryDWord(data);
+      newvertarray[vindex].x = (fixed_t)reader.getDWord();
+      newvertarray[vindex].y = (fixed_t)reader.getDWord();
 
       // SoM: Cardboard stores float versions of vertices.
       newvertarray[vindex].fx = M_FixedToFloat(newvertarray[vindex].x);
@@ -1377,61 +1544,65 @@ static void P_LoadZNodes(int lump, ZNodeType signature)
    }
 
    // Read the subsectors
-   CheckZNodesOverflow(len, sizeof(numSubs));
-   numSubs = GetBinaryUDWord(data);
+   if(!reader.reserve(sizeof(numSubs)))
+      return;
+   numSubs = reader.getUDWord();
 
    numsubsectors = (int)numSubs;
    if(numsubsectors <= 0)
    {
       level_error = "no subsectors in level";
-      Z_Free(lumpptr);
       return;
    }
 
-   CheckZNodesOverflow(len, numSubs * sizeof(uint32_t));
+   if(!reader.reserve(uint64_t(numSubs) * sizeof(uint32_t)))
+      return;
    subsectors = estructalloctag(subsector_t, numsubsectors, PU_LEVEL);
 
    for(i = currSeg = 0; i < numSubs; i++)
    {
       subsectors[i].firstline = (int)currSeg;
-      subsectors[i].numlines  = (int)(GetBinaryUDWord(data));
+      subsectors[i].numlines  = (int)(reader.getUDWord());
       currSeg += subsectors[i].numlines;
    }
 
    // Read the segs
-   CheckZNodesOverflow(len, sizeof(numSegs));
-   numSegs = GetBinaryUDWord(data);
+   if(!reader.reserve(sizeof(numSegs)))
+      return;
+   numSegs = reader.getUDWord();
 
    // The number of segs stored should match the number of
    // segs used by subsectors.
    if(numSegs != currSeg)
    {
       level_error = "incorrect number of segs in nodes";
-      Z_Free(lumpptr);
       return;
    }
 
    numsegs = (int)numSegs;
 
    // IOANCH 20151217: set reading size
-   int totalSegSize;
+   uint64_t totalSegSize;
    if(signature == ZNodeType_Uncompressed_Normal || signature == ZNodeType_Uncompressed_GL)
-      totalSegSize = numsegs * 11; // haleyjd: hardcoded original structure size
+      totalSegSize = uint64_t(numsegs) * 11; // haleyjd: hardcoded original structure size
    else
-      totalSegSize = numsegs * 13; // IOANCH: DWORD linedef
+      totalSegSize = uint64_t(numsegs) * 13; // IOANCH: DWORD linedef
    
-   CheckZNodesOverflow(len, totalSegSize);
+   if(!reader.reserve(totalSegSize))
+      return;
    segs = estructalloctag(seg_t, numsegs, PU_LEVEL);
-   P_LoadZSegs(data, signature);
-   
-   data += totalSegSize;
+   P_LoadZSegs(reader, signature);
+   if(level_error)
+      return;
    
    // Read nodes
-   CheckZNodesOverflow(len, sizeof(numNodes));
-   numNodes = GetBinaryUDWord(data);
+   if(!reader.reserve(sizeof(numNodes)))
+      return;
+   numNodes = reader.getUDWord();
 
    numnodes = numNodes;
-   CheckZNodesOverflow(len, numNodes * 32);
+   if(!reader.reserve(uint64_t(numNodes) * (signature == ZNodeType_Uncompressed_GL3 ? 40 : 32)))
+      return;
    nodes  = estructalloctag(node_t,  numNodes, PU_LEVEL);
    fnodes = estructalloctag(fnode_t, numNodes, PU_LEVEL);
 
@@ -1439,64 +1610,37 @@ static void P_LoadZNodes(int lump, ZNodeType signature)
    {
       int j, k;
       node_t *no = nodes + i;
-      mapnode_znod_t mn;
 
+      // IOANCH: XGL3 partitions are fixed point, the others whole units
       if(signature == ZNodeType_Uncompressed_GL3)
       {
-         mn.x32  = GetBinaryDWord(data);
-         mn.y32  = GetBinaryDWord(data);
-         mn.dx32 = GetBinaryDWord(data);
-         mn.dy32 = GetBinaryDWord(data);
+         no->x  = reader.getDWord();
+         no->y  = reader.getDWord();
+         no->dx = reader.getDWord();
+         no->dy = reader.getDWord();
       }
       else
       {
-         mn.x  = GetBinaryWord(data);
-         mn.y  = GetBinaryWord(data);
-         mn.dx = GetBinaryWord(data);
-         mn.dy = GetBinaryWord(data);
+         no->x  = reader.getWord() * FRACUNIT;
+         no->y  = reader.getWord() * FRACUNIT;
+         no->dx = reader.getWord() * FRACUNIT;
+         no->dy = reader.getWord() * FRACUNIT;
       }
 
       for(j = 0; j < 2; j++)
          for(k = 0; k < 4; k++)
-            mn.bbox[j][k] = GetBinaryWord(data);
+            no->bbox[j][k] = (fixed_t)reader.getWord() * FRACUNIT;
 
       for(j = 0; j < 2; j++)
-         mn.children[j] = GetBinaryDWord(data);
-
-      if(signature == ZNodeType_Uncompressed_GL3)
-      {
-         no->x = mn.x32;
-         no->y = mn.y32;
-         no->dx = mn.dx32;
-         no->dy = mn.dy32;
-         
-         P_CalcNodeCoefficients2(*no, fnodes[i]);
-      }
-      else
-      {
-         no->x  = mn.x; 
-         no->y  = mn.y; 
-         no->dx = mn.dx;
-         no->dy = mn.dy;
-
-         P_CalcNodeCoefficients(no, &fnodes[i]);
-
-         no->x  <<= FRACBITS;
-         no->y  <<= FRACBITS;
-         no->dx <<= FRACBITS;
-         no->dy <<= FRACBITS;
-      }
-
-      for(j = 0; j < 2; j++)
-      {
-         no->children[j] = (unsigned int)(mn.children[j]);
-
-         for(k = 0; k < 4; k++)
-            no->bbox[j][k] = (fixed_t)mn.bbox[j][k] << FRACBITS;
-      }
+         no->children[j] = (unsigned int)reader.getDWord();
    }
 
-   Z_Free(lumpptr);
+   // Whole-unit partitions convert to exactly what P_CalcNodeCoefficients
+   // would have made of them before shifting
+   P_runRangesParallel(numnodes, [] (int first, int last) {
+      for(int n = first; n < last; n++)
+         P_CalcNodeCoefficients2(nodes[n], fnodes[n]);
+   });
 }
 
 //
@@ -2135,9 +2279,6 @@ static void P_LoadSideDefs2(int lumpnum)
    Z_Free(lump);
 }
 
-// haleyjd 10/10/11: externalized structure due to pre-C++11 template limitations
-struct bmap_t { int n, nalloc, *list; }; // blocklist structure
-
 //
 // Boom variant of blockmap creation, which will fix PrBoom+ demos recorded with -complevel 9. Not
 // a solution for MBF -complevel however.
@@ -2442,6 +2583,92 @@ static void P_createBlockMapBoom()
    efree(blockdone);
 }
 
+// One block of one line, as found by P_walkBlockLines
+struct blockline_t
+{
+   unsigned int block;
+   int          line;
+};
+
+// A run of lines whose blocks are found together
+struct blocklinerun_t
+{
+   int first, last;   // lines [first, last)
+   int minx, miny;    // blockmap origin in map units
+   std::vector<blockline_t> out;
+};
+
+// Lines per thread below which more threads aren't worth starting
+static constexpr int BLOCKMAP_LINESPERTHREAD = 2048;
+static constexpr int BLOCKMAP_MAXTHREADS     = 8;
+
+//
+// Finds every block each line of a run passes through, in line order and in
+// order along each line. Runs on worker threads, so it must stay clear of
+// the zone.
+//
+static void P_walkBlockLines(blocklinerun_t *run)
+{
+   const unsigned int tot = bmapwidth * bmapheight;
+   const int minx = run->minx, miny = run->miny;
+
+   for(int i = run->first; i < run->last; i++)
+   {
+      // starting coordinates
+      int x = (lines[i].v1->x >> FRACBITS) - minx;
+      int y = (lines[i].v1->y >> FRACBITS) - miny;
+      
+      // x-y deltas
+      int adx = lines[i].dx >> FRACBITS, dx = adx < 0 ? -1 : 1;
+      int ady = lines[i].dy >> FRACBITS, dy = ady < 0 ? -1 : 1; 
+
+      // difference in preferring to move across y (>0) 
+      // instead of x (<0)
+      int diff = !adx ? 1 : !ady ? -1 :
+       (((x >> MAPBTOFRAC) << MAPBTOFRAC) + 
+        (dx > 0 ? MAPBLOCKUNITS-1 : 0) - x) * (ady = D_abs(ady)) * dx -
+       (((y >> MAPBTOFRAC) << MAPBTOFRAC) + 
+        (dy > 0 ? MAPBLOCKUNITS-1 : 0) - y) * (adx = D_abs(adx)) * dy;
+
+      // starting block, and pointer to its blocklist structure
+      int b = (y >> MAPBTOFRAC) * bmapwidth + (x >> MAPBTOFRAC);
+
+      // ending block
+      int bend = (((lines[i].v2->y >> FRACBITS) - miny) >> MAPBTOFRAC) *
+         bmapwidth + (((lines[i].v2->x >> FRACBITS) - minx) >> MAPBTOFRAC);
+
+      // delta for pointer when moving across y
+      dy *= bmapwidth;
+
+      // deltas for diff inside the loop
+      adx <<= MAPBTOFRAC;
+      ady <<= MAPBTOFRAC;
+
+      // Now we simply iterate block-by-block until we reach the end block.
+      while((unsigned int) b < tot)    // failsafe -- should ALWAYS be true
+      {
+         // Add linedef to end of list
+         run->out.push_back({ unsigned(b), i });
+
+         // If we have reached the last block, exit
+         if(b == bend)
+            break;
+
+         // Move in either the x or y direction to the next block
+         if(diff < 0)
+         {
+            diff += ady;
+            b += dx;
+         }
+         else
+         {
+            diff -= adx;
+            b += dy;
+         }
+      }
+   }
+}
+
 //
 // P_CreateBlockMap
 //
@@ -2517,71 +2744,31 @@ static void P_CreateBlockMap()
    //     the linedef.
 
    {
-      unsigned tot = bmapwidth * bmapheight;                  // size of blockmap
-      bmap_t *bmap = ecalloc(bmap_t *, sizeof *bmap, tot);    // array of blocklists
+      const unsigned int tot = bmapwidth * bmapheight;   // size of blockmap
 
-      for(i = 0; i < (unsigned int)numlines; i++)
-      {
-         // starting coordinates
-         int x = (lines[i].v1->x >> FRACBITS) - minx;
-         int y = (lines[i].v1->y >> FRACBITS) - miny;
-         
-         // x-y deltas
-         int adx = lines[i].dx >> FRACBITS, dx = adx < 0 ? -1 : 1;
-         int ady = lines[i].dy >> FRACBITS, dy = ady < 0 ? -1 : 1; 
-
-         // difference in preferring to move across y (>0) 
-         // instead of x (<0)
-         int diff = !adx ? 1 : !ady ? -1 :
-          (((x >> MAPBTOFRAC) << MAPBTOFRAC) + 
-           (dx > 0 ? MAPBLOCKUNITS-1 : 0) - x) * (ady = D_abs(ady)) * dx -
-          (((y >> MAPBTOFRAC) << MAPBTOFRAC) + 
-           (dy > 0 ? MAPBLOCKUNITS-1 : 0) - y) * (adx = D_abs(adx)) * dy;
-
-         // starting block, and pointer to its blocklist structure
-         int b = (y >> MAPBTOFRAC) * bmapwidth + (x >> MAPBTOFRAC);
-
-         // ending block
-         int bend = (((lines[i].v2->y >> FRACBITS) - miny) >> MAPBTOFRAC) *
-            bmapwidth + (((lines[i].v2->x >> FRACBITS) - minx) >> MAPBTOFRAC);
-
-         // delta for pointer when moving across y
-         dy *= bmapwidth;
-
-         // deltas for diff inside the loop
-         adx <<= MAPBTOFRAC;
-         ady <<= MAPBTOFRAC;
-
-         // Now we simply iterate block-by-block until we reach the end block.
-         while((unsigned int) b < tot)    // failsafe -- should ALWAYS be true
-         {
-            // Increase size of allocated list if necessary
-            if(bmap[b].n >= bmap[b].nalloc)
-            {
-               bmap[b].nalloc = bmap[b].nalloc ? bmap[b].nalloc * 2 : 8;
-               bmap[b].list = erealloc(int *, bmap[b].list,
-                                       bmap[b].nalloc*sizeof*bmap->list);
-            }
-
-            // Add linedef to end of list
-            bmap[b].list[bmap[b].n++] = i;
+      // Lines are split into contiguous runs walked in parallel; each run's
+      // blocks come back in line order, so putting the runs back together in
+      // order gives every block its lines in exactly the serial order.
+      const int numthreads = eclamp(emin(D_NumJobWorkers() + 1,
+                                         numlines / BLOCKMAP_LINESPERTHREAD),
+                                    1, BLOCKMAP_MAXTHREADS);
 
-            // If we have reached the last block, exit
-            if(b == bend)
-               break;
+      std::vector<blocklinerun_t> runs(numthreads);
+      for(int t = 0; t < numthreads; t++)
+      {
+         blocklinerun_t &run = runs[t];
+         run.first = int(int64_t(numlines) * t / numthreads);
+         run.last  = int(int64_t(numlines) * (t + 1) / numthreads);
+         run.minx  = minx;
+         run.miny  = miny;
+      }
+      D_RunParallel(numthreads, [&runs] (int t) { P_walkBlockLines(&runs[t]); });
 
-            // Move in either the x or y direction to the next block
-            if(diff < 0)
-            {
-               diff += ady;
-               b += dx;
-            }
-            else
-            {
-               diff -= adx;
-               b += dy;
-            }
-         }
+      int *counts = ecalloc(int *, tot, sizeof(int));
+      for(const blocklinerun_t &run : runs)
+      {
+         for(const blockline_t &bl : run.out)
+            counts[bl.block]++;
       }
 
       // Compute the total size of the blockmap.
@@ -2599,8 +2786,8 @@ static void P_CreateBlockMap()
          for(i = 0; i < tot; i++)
          {
             // 1 header word + 1 trailer word + blocklist
-            if(bmap[i].n)
-               count += bmap[i].n + 2; 
+            if(counts[i])
+               count += counts[i] + 2; 
          }
 
          // Allocate blockmap lump with computed count
@@ -2609,28 +2796,33 @@ static void P_CreateBlockMap()
 
       // Now compress the blockmap.
       {
-         int ndx = tot += 4;      // Advance index to start of linedef lists
-         bmap_t *bp = bmap;       // Start of uncompressed blockmap
+         int ndx = tot + 4;        // Advance index to start of linedef lists
 
          blockmaplump[ndx++] = 0;  // Store an empty blockmap list at start
          blockmaplump[ndx++] = -1; // (Used for compression)
 
-         for(i = 4; i < tot; i++, bp++)
+         // counts become the index just past each block's list, which is
+         // filled from the back as the lines stored last come first
+         for(i = 0; i < tot; i++)
          {
-            if(bp->n)                          // Non-empty blocklist
+            if(counts[i])                            // Non-empty blocklist
             {
-               blockmaplump[blockmaplump[i] = ndx++] = 0;  // Store index & header
-               do
-                  blockmaplump[ndx++] = bp->list[--bp->n]; // Copy linedef list
-               while (bp->n);
-               blockmaplump[ndx++] = -1;                   // Store trailer
-               efree(bp->list);                             // Free linedef list
+               blockmaplump[blockmaplump[4 + i] = ndx++] = 0; // Store index & header
+               ndx += counts[i];
+               counts[i] = ndx;
+               blockmaplump[ndx++] = -1;                      // Store trailer
             }
             else     // Empty blocklist: point to reserved empty blocklist
-               blockmaplump[i] = tot;
+               blockmaplump[4 + i] = tot + 4;
          }
-         
-         efree(bmap);    // Free uncompressed blockmap
+
+         for(const blocklinerun_t &run : runs)
+         {
+            for(const blockline_t &bl : run.out)
+               blockmaplump[--counts[bl.block]] = bl.line; // Copy linedef list
+         }
+
+         efree(counts);
       }
    }
 
@@ -2717,6 +2909,237 @@ static bool P_VerifyBlockMap(int count)
    return isvalid;
 }
 
+//
+// P_UpdateLineHot
+//
+// Copies a line's hot fields into its row of linehot.
+//
+void P_UpdateLineHot(const line_t &line)
+{
+   if(!linehot)
+      return;
+
+   linehot_t &lh = linehot[&line - lines];
+
+   lh.x1          = line.v1->x;
+   lh.y1          = line.v1->y;
+   lh.x2          = line.v2->x;
+   lh.y2          = line.v2->y;
+   lh.dx          = line.dx;
+   lh.dy          = line.dy;
+   lh.frontsector = line.frontsector;
+   lh.backsector  = line.backsector;
+   lh.slopetype   = line.slopetype;
+   memcpy(lh.bbox, line.bbox, sizeof(lh.bbox));
+}
+
+//
+// P_InitLineHot
+//
+// Fills linehot from the lines, junk line included.
+//
+static void P_InitLineHot()
+{
+   linehot = emalloctag(linehot_t *, numlinesPlusExtra * sizeof(*linehot), PU_LEVEL,
+                        reinterpret_cast<void **>(&linehot));
+
+   for(int i = 0; i < numlinesPlusExtra; i++)
+      P_UpdateLineHot(lines[i]);
+}
+
+//
+// P_layoutBSPSubtree
+//
+// Appends the nodes within depth levels of root to order, in van Emde Boas
+// order. placed marks the nodes already in order, so that a broken tree
+// can't put a node in twice.
+//
+static void P_layoutBSPSubtree(int root, int depth, byte *placed, PODCollection<int> &order)
+{
+   if(depth <= 1)
+   {
+      if(!placed[root])
+      {
+         placed[root] = 1;
+         order.add(root);
+      }
+      return;
+   }
+
+   const int top = depth / 2;
+   P_layoutBSPSubtree(root, top, placed, order);
+
+   // find the nodes hanging just below the top levels, left to right
+   PODCollection<int> level;
+   level.add(root);
+   for(int d = 0; d < top && level.getLength(); d++)
+   {
+      PODCollection<int> next;
+      for(size_t i = 0; i < level.getLength(); i++)
+      {
+         for(const int child : nodes[level[i]].children)
+         {
+            if(!(child & NF_SUBSECTOR) && child < numnodes)
+               next.add(child);
+         }
+      }
+      level = next;
+   }
+
+   for(size_t i = 0; i < level.getLength(); i++)
+      P_layoutBSPSubtree(level[i], depth - top, placed, order);
+}
+
+//
+// P_InitBSPNodes
+//
+// Builds bspnodes from the loaded nodes.
+//
+static void P_InitBSPNodes()
+{
+   bspnodes = nullptr;
+   if(numnodes <= 0)
+      return;
+
+   const int root = numnodes - 1;
+
+   // height of every subtree in nodes, without recursing; -1 while a node
+   // is being visited, so a loop in a broken tree counts as a leaf
+   int *height = ecalloc(int *, numnodes, sizeof(int));
+   PODCollection<int> stack;
+   stack.add(root);
+   height[root] = -1;
+   while(stack.getLength())
+   {
+      const int node = stack.back();
+      bool ready = true;
+      for(const int child : nodes[node].children)
+      {
+         if(!(child & NF_SUBSECTOR) && child < numnodes && !height[child])
+         {
+            height[child] = -1;
+            stack.add(child);
+            ready = false;
+         }
+      }
+      if(!ready)
+         continue;
+
+      int h = 0;
+      for(const int child : nodes[node].children)
+      {
+         if(!(child & NF_SUBSECTOR) && child < numnodes)
+            h = emax(h, height[child]);
+      }
+      height[node] = h + 1;
+      stack.pop();
+   }
+
+   byte *placed = ecalloc(byte *, numnodes, 1);
+   PODCollection<int> order;
+   P_layoutBSPSubtree(root, height[root], placed, order);
+
+   // done with the heights; the array takes the new indices instead
+   int *newindex = height;
+   for(size_t i = 0; i < order.getLength(); i++)
+      newindex[order[i]] = int(i);
+
+   bspnodes = emalloctag(bspnode_t *, order.getLength() * sizeof(*bspnodes), PU_LEVEL, nullptr);
+   for(size_t i = 0; i < order.getLength(); i++)
+   {
+      const node_t &node = nodes[order[i]];
+      bspnode_t    &bsp  = bspnodes[i];
+
+      bsp.x  = node.x;
+      bsp.y  = node.y;
+      bsp.dx = node.dx;
+      bsp.dy = node.dy;
+      for(int side = 0; side < 2; side++)
+      {
+         const int child = node.children[side];
+         bsp.children[side] = (child & NF_SUBSECTOR) || child >= numnodes ? child :
+                              newindex[child];
+      }
+   }
+
+   efree(placed);
+   efree(height);
+}
+
+//
+// P_InitBlockLines
+//
+// Lays out every block's line list with the lines' bounding boxes beside it.
+// Must run after polyobjects are spawned, since their lines can move.
+//
+static void P_InitBlockLines()
+{
+   const int numblocks = bmapwidth * bmapheight;
+   int total = 0;
+
+   for(int i = 0; i < numblocks; i++)
+   {
+      const int *list = blockmaplump + blockmap[i];
+      while(*list++ != -1)
+         total++;
+   }
+
+   blocklines = emalloctag(blocklines_t *, numblocks * sizeof(*blocklines), PU_LEVEL, nullptr);
+   fixed_t *boxes = emalloctag(fixed_t *, 4 * emax(total, 1) * sizeof(*boxes), PU_LEVEL, nullptr);
+   fixed_t *left   = boxes;
+   fixed_t *right  = left  + total;
+   fixed_t *bottom = right + total;
+   fixed_t *top    = bottom + total;
+
+   // polyobject lines may still sit in the lists at their spawn spots
+   byte *polyline = ecalloc(byte *, emax(numlines, 1), 1);
+   for(int i = 0; i < numPolyObjects; i++)
+   {
+      for(int j = 0; j < PolyObjects[i].numLines; j++)
+         polyline[PolyObjects[i].lines[j] - lines] = 1;
+   }
+
+   int n = 0;
+   for(int i = 0; i < numblocks; i++)
+   {
+      blocklines_t &block = blocklines[i];
+      const int *list = blockmaplump + blockmap[i];
+
+      block.lines    = list;
+      block.left     = left + n;
+      block.right    = right + n;
+      block.bottom   = bottom + n;
+      block.top      = top + n;
+      block.numlines = 0;
+
+      for(; *list != -1; list++, n++, block.numlines++)
+      {
+         const int linenum = *list;
+
+         if(linenum >= numlines)
+         {
+            left[n] = bottom[n] = D_MAXINT;
+            right[n] = top[n] = D_MININT;
+         }
+         else if(polyline[linenum])
+         {
+            left[n] = bottom[n] = D_MININT;
+            right[n] = top[n] = D_MAXINT;
+         }
+         else
+         {
+            const line_t &line = lines[linenum];
+            left[n]   = line.bbox[BOXLEFT];
+            right[n]  = line.bbox[BOXRIGHT];
+            bottom[n] = line.bbox[BOXBOTTOM];
+            top[n]    = line.bbox[BOXTOP];
+         }
+      }
+   }
+
+   efree(polyline);
+}
+
 //
 // P_LoadBlockMap
 //
@@ -2780,7 +3203,10 @@ static void P_LoadBlockMap(int lump)
    // clear out mobj chains
    count      = sizeof(*blocklinks) * bmapwidth * bmapheight;
    blocklinks = ecalloctag(Mobj **, 1, count, PU_LEVEL, nullptr);
+   count       = sizeof(*blockthings) * bmapwidth * bmapheight;
+   blockthings = ecalloctag(blockthings_t *, 1, count, PU_LEVEL, nullptr);
    blockmap   = blockmaplump + 4;
+   blocklines = nullptr; // built once polyobjects are known
 
    // haleyjd 2/22/06: setup polyobject blockmap
    count = sizeof(*polyblocklinks) * bmapwidth * bmapheight;
@@ -2792,6 +3218,124 @@ static void P_LoadBlockMap(int lump)
 }
 
 
+// Lines touching each vertex position, vertices at equal coordinates shared
+static int     *vertexlinegroups;  // per vertex, its position's group
+static int     *vertexlinestarts;  // per group, plus one to end the last
+static line_t **vertexlinelist;
+
+//
+// Returns the lines, in ascending order, having an endpoint at v's position.
+// v must belong to vertexes.
+//
+line_t *const *P_LinesAtVertex(const vertex_t *v, int &count)
+{
+   const int group = vertexlinegroups[v - vertexes];
+
+   count = vertexlinestarts[group + 1] - vertexlinestarts[group];
+   return vertexlinelist + vertexlinestarts[group];
+}
+
+//
+// Builds the lists of sectors adjoining each sector. Must follow the line
+// lists.
+//
+static void P_groupSectorNeighbors()
+{
+   std::vector<int>       seen(numsectors, -1);
+   std::vector<sector_t *> found;
+   sector_t **buffer;
+
+   found.reserve(gTotalLinesForRejectOverflow);
+   for(int i = 0; i < numsectors; i++)
+   {
+      sector_t *sec = &sectors[i];
+
+      // same as getNextSector without comp_model
+      for(int j = 0; j < sec->linecount; j++)
+      {
+         const line_t *line = sec->lines[j];
+         sector_t *other = line->frontsector == sec ?
+            line->backsector != sec ? line->backsector : nullptr :
+            line->frontsector;
+
+         if(other && seen[other - sectors] != i)
+         {
+            seen[other - sectors] = i;
+            found.push_back(other);
+         }
+      }
+      sec->neighborcount = int(found.size());
+   }
+
+   buffer = emalloctag(sector_t **, emax<size_t>(found.size(), 1) * sizeof(*buffer),
+                       PU_LEVEL, nullptr);
+   if(!found.empty())
+      memcpy(buffer, &found[0], found.size() * sizeof(*buffer));
+
+   for(int i = numsectors - 1; i >= 0; i--)
+   {
+      const int first = i ? sectors[i - 1].neighborcount : 0;
+
+      sectors[i].neighbors      = buffer + first;
+      sectors[i].neighborcount -= first;
+   }
+}
+
+//
+// Builds the lists of lines touching each vertex position.
+//
+static void P_groupVertexLines()
+{
+   std::vector<int> order(numvertexes);
+   int numgroups = 0;
+
+   // vertices sharing coordinates are neighbors once sorted
+   for(int i = 0; i < numvertexes; i++)
+      order[i] = i;
+   std::sort(order.begin(), order.end(), [](int a, int b) {
+      return vertexes[a].x != vertexes[b].x ? vertexes[a].x < vertexes[b].x :
+             vertexes[a].y != vertexes[b].y ? vertexes[a].y < vertexes[b].y : a < b;
+   });
+
+   vertexlinegroups = emalloctag(int *, emax(numvertexes, 1) * sizeof(int), PU_LEVEL, nullptr);
+   for(int i = 0; i < numvertexes; i++)
+   {
+      const vertex_t &v = vertexes[order[i]];
+
+      if(i && (v.x != vertexes[order[i - 1]].x || v.y != vertexes[order[i - 1]].y))
+         numgroups++;
+      vertexlinegroups[order[i]] = numgroups;
+   }
+   numgroups += numvertexes ? 1 : 0;
+
+   vertexlinestarts = ecalloctag(int *, numgroups + 1, sizeof(int), PU_LEVEL, nullptr);
+   for(int i = 0; i < numlines; i++)
+   {
+      const int g1 = vertexlinegroups[lines[i].v1 - vertexes];
+      const int g2 = vertexlinegroups[lines[i].v2 - vertexes];
+
+      vertexlinestarts[g1 + 1]++;
+      if(g2 != g1)
+         vertexlinestarts[g2 + 1]++;
+   }
+   for(int i = 0; i < numgroups; i++)
+      vertexlinestarts[i + 1] += vertexlinestarts[i];
+
+   // fill in line order, so every list ascends
+   std::vector<int> fill(vertexlinestarts, vertexlinestarts + numgroups);
+   vertexlinelist = emalloctag(line_t **, emax(vertexlinestarts[numgroups], 1) * sizeof(line_t *),
+                               PU_LEVEL, nullptr);
+   for(int i = 0; i < numlines; i++)
+   {
+      const int g1 = vertexlinegroups[lines[i].v1 - vertexes];
+      const int g2 = vertexlinegroups[lines[i].v2 - vertexes];
+
+      vertexlinelist[fill[g1]++] = &lines[i];
+      if(g2 != g1)
+         vertexlinelist[fill[g2]++] = &lines[i];
+   }
+}
+
 //
 // AddLineToSector
 //
@@ -2905,6 +3449,9 @@ static void P_GroupLines()
       block = block < 0 ? 0 : block;
       sector->blockbox[BOXLEFT]=block;
    }
+
+   P_groupSectorNeighbors();
+   P_groupVertexLines();
 }
 
 //
@@ -3090,8 +3637,13 @@ static void P_LoadReject(int lump)
    // 1. if size >= expectedsize, all is good.
    // 2. if size <  expectedsize, allocate a zero-filled buffer and copy
    //    in whatever exists from the actual lump.
+   // Either way the matrix is a private copy, since P_buildReject may write
+   // into it and the cached lump is shared with anything else reading it.
    if(size >= expectedsize)
-      rejectmatrix = (byte *)(setupwad->cacheLumpNum(lump, PU_LEVEL));
+   {
+      rejectmatrix = ecalloctag(byte *, 1, expectedsize, PU_LEVEL, nullptr);
+      memcpy(rejectmatrix, setupwad->cacheLumpNum(lump, PU_CACHE), expectedsize);
+   }
    else
    {
       // set to all zeroes so that the reject has no effect
@@ -3117,6 +3669,73 @@ static void P_LoadReject(int lump)
    // warn on too-large rejects, but do nothing special.
    if(size > expectedsize)
       C_Printf(FC_ERROR "P_LoadReject: warning - reject is too large\a\n");
+
+   rejectempty = true;
+   for(int i = 0; i < expectedsize && rejectempty; i++)
+      rejectempty = !rejectmatrix[i];
+}
+
+//
+// Fills in an empty REJECT from the subsector visibility the renderer can
+// work out: sectors are rejected when no subsector of either could possibly
+// see one of the other in 2D, treating every two-sided line as open. That is
+// conservative for the geometry, but sight checks have quirks of their own,
+// so it is kept out of demos and netgames, whose sync depends on checking
+// exactly as the map's own reject would. Maps with linked portals, where
+// sight can leave and re-enter a group, are left alone.
+//
+static void P_buildReject()
+{
+   if(!p_autoreject || !rejectempty || demoplayback || demorecording || netgame ||
+      useportalgroups || gMapHasLinePortals)
+      return;
+
+   int rowbytes;
+   byte *rows = R_BuildSubsectorVisibility(PU_STATIC, rowbytes, "P_BuildReject");
+   if(!rows)
+      return;
+
+   const int numpairs = numsectors * numsectors;
+   byte *seen = ecalloc(byte *, (numpairs + 7) >> 3, sizeof(byte));
+
+   for(int a = 0; a < numsubsectors; a++)
+   {
+      const int  sa  = eindex(subsectors[a].sector - sectors);
+      const byte *row = rows + a * rowbytes;
+
+      for(int i = 0; i < rowbytes; i++)
+      {
+         if(!row[i])
+            continue;
+         for(int bit = 0; bit < 8; bit++)
+         {
+            const int b = (i << 3) + bit;
+            if(b >= numsubsectors || !(row[i] & (1 << bit)))
+               continue;
+
+            // either way round, in case of rounding in the flow
+            const int sb = eindex(subsectors[b].sector - sectors);
+            const int p1 = sa * numsectors + sb;
+            const int p2 = sb * numsectors + sa;
+            seen[p1 >> 3] |= 1 << (p1 & 7);
+            seen[p2 >> 3] |= 1 << (p2 & 7);
+         }
+      }
+   }
+   efree(rows);
+
+   int rejected = 0;
+   for(int p = 0; p < numpairs; p++)
+   {
+      if(!(seen[p >> 3] & (1 << (p & 7))))
+      {
+         rejectmatrix[p >> 3] |= 1 << (p & 7);
+         ++rejected;
+      }
+   }
+   efree(seen);
+
+   C_Printf("P_BuildReject: %d of %d sector pairs can't see each other\n", rejected, numpairs);
 }
 
 //
@@ -3290,6 +3909,34 @@ void P_InitThingLists(); // haleyjd
 
 // P_SetupLevel subroutines
 
+//
+// P_PrefetchLevel
+//
+// Called when the next map is known ahead of loading it, such as at the start
+// of the intermission, to let the OS read its lumps in beforehand.
+//
+void P_PrefetchLevel(const WadDirectory *dir, const char *mapname)
+{
+   int  lumpnum;
+   bool isUdmf = false;
+
+   if(!mapname || (lumpnum = dir->checkNumForName(mapname)) == -1 ||
+      P_CheckLevel(dir, lumpnum, nullptr, &isUdmf) == LEVEL_FORMAT_INVALID)
+      return;
+
+   int count = ML_BEHAVIOR + 1;
+   if(isUdmf)
+   {
+      lumpinfo_t **lumpinfo = dir->getLumpInfo();
+
+      // P_CheckLevel made sure ENDMAP is there
+      for(count = 2; strncmp(lumpinfo[lumpnum + count]->name, "ENDMAP", 8); count++)
+         ;
+   }
+
+   dir->prefetchLumps(lumpnum, count);
+}
+
 //
 // P_SetupLevelError
 // 
@@ -3425,6 +4072,9 @@ static bool P_InitNewLevel(int lumpnum, WadDirectory *waddir)
    // haleyjd 02/02/04 -- clear the TID hash table
    P_InitTIDHash();     
 
+   // forget the last level's noise floods
+   P_ClearSoundFloods();
+
    // SoM: I can't believe I forgot to call this!
    P_InitPortals(); 
 
@@ -3579,6 +4229,9 @@ CONSOLE_COMMAND(mapchecksum, 0)
       C_Printf("Current map MD5: %s\n", p_currentLevelHashDigest.constPtr());
 }
 
+VARIABLE_TOGGLE(p_autoreject, nullptr, onoff);
+CONSOLE_VARIABLE(p_autoreject, p_autoreject, 0) {}
+
 //
 // CHECK_ERROR
 //
@@ -3606,7 +4259,10 @@ void P_SetupLevel(WadDirectory *dir, const char *mapname, int playermask,
    lumpinfo_t **lumpinfo;
    int lumpnum, acslumpnum = -1;
 
+   LoadTraceSession loadtrace(mapname);
+
    G_DemoLog("%d\tSetup %s\n", gametic, mapname);
+   D_FrameStatsLevelStart();
    G_DemoLogSetExited(false);
 
    // haleyjd 07/28/10: we are no longer in GS_LEVEL during the execution of
@@ -3641,11 +4297,13 @@ void P_SetupLevel(WadDirectory *dir, const char *mapname, int playermask,
    if(isUdmf || demo_version >= 401)
    {
       P_PointOnLineSide = P_PointOnLineSidePrecise;
+      P_PointOnLineHotSide = P_PointOnLineHotSidePrecise;
       P_PointOnDivlineSide = P_PointOnDivlineSidePrecise;
    }
    else
    {
       P_PointOnLineSide = P_PointOnLineSideClassic;
+      P_PointOnLineHotSide = P_PointOnLineHotSideClassic;
       P_PointOnDivlineSide = P_PointOnDivlineSideClassic;
    }
 
@@ -3654,12 +4312,16 @@ void P_SetupLevel(WadDirectory *dir, const char *mapname, int playermask,
 
    strncpy(levelmapname, mapname, 8);
    leveltime = 0;
+   P_ResetSightPrefetch();
+
+   M_LoadTracePhase("P_InitNewLevel");
 
    // perform pre-Z_FreeTags actions
    P_PreZoneFreeLevel();
    
    // free the old level
    Z_FreeTags(PU_LEVEL, PU_LEVEL);
+   M_ZoneStatsLevelStart();
 
    // perform post-Z_FreeTags actions
    if(!P_InitNewLevel(lumpnum, dir))
@@ -3680,6 +4342,7 @@ void P_SetupLevel(WadDirectory *dir, const char *mapname, int playermask,
    UDMFSetupSettings setupSettings;
    if(isUdmf)
    {
+      M_LoadTracePhase("UDMFParser::parse");
       if(!udmf.parse(*setupwad, lumpnum + 1))
       {
          P_SetupLevelError(udmf.error().constPtr(), mapname);
@@ -3701,6 +4364,7 @@ void P_SetupLevel(WadDirectory *dir, const char *mapname, int playermask,
    }
    else
    {
+      M_LoadTracePhase("P_LoadVertexes");
       switch(LevelInfo.mapFormat)
       {
       case LEVEL_FORMAT_PSX:
@@ -3720,6 +4384,8 @@ void P_SetupLevel(WadDirectory *dir, const char *mapname, int playermask,
    // haleyjd 01/05/14: create sector interpolation data
    P_CreateSectorInterps();
 
+   M_LoadTracePhase("P_LoadLineDefs");
+
    // IOANCH 20151212: UDMF
    if(isUdmf)
       udmf.loadSidedefs();
@@ -3763,7 +4429,10 @@ void P_SetupLevel(WadDirectory *dir, const char *mapname, int playermask,
    
    // IOANCH 20151213: use mgla here and elsewhere
    
+   M_LoadTracePhase("P_LoadBlockMap");
    P_LoadBlockMap (mgla.blockmap); // killough 3/1/98
+
+   M_LoadTracePhase("P_LoadNodes");
    
    // If it's UDMF, vertices can have extra precision, requiring better geometry calculations.
    R_PointOnSide = R_PointOnSideClassic;  // set classic function unless otherwise set later
@@ -3774,8 +4443,10 @@ void P_SetupLevel(WadDirectory *dir, const char *mapname, int playermask,
    if((znodeSignature = P_checkForZDoomNodes(mgla.nodes, 
       &actualNodeLump, isUdmf)) != ZNodeType_Invalid && actualNodeLump >= 0)
    {
+      M_LoadTracePhase("P_LoadZNodes");
       P_LoadZNodes(actualNodeLump, znodeSignature);
-      if(znodeSignature == ZNodeType_Uncompressed_GL3)
+      if(znodeSignature == ZNodeType_Uncompressed_GL3 ||
+         znodeSignature == ZNodeType_Compressed_GL3)
          R_PointOnSide = R_PointOnSidePrecise;
 
       CHECK_ERROR();
@@ -3812,8 +4483,11 @@ void P_SetupLevel(WadDirectory *dir, const char *mapname, int playermask,
       CHECK_ERROR();
    }
 
+   P_InitBSPNodes();
+
    // ioanch 20160309: reversed P_GroupLines with P_LoadReject to fix the
    // overrun
+   M_LoadTracePhase("P_GroupLines");
    P_GroupLines();
    P_LoadReject(mgla.reject); // haleyjd 01/26/04
 
@@ -3821,6 +4495,8 @@ void P_SetupLevel(WadDirectory *dir, const char *mapname, int playermask,
             "lines not initialized\n");
    lines[numlines] = lines[0];   // use the first line as a base for the "junk" line
 
+   P_InitLineHot();
+
    // Create bounding boxes now
    P_createSectorBoundingBoxes();
 
@@ -3830,6 +4506,8 @@ void P_SetupLevel(WadDirectory *dir, const char *mapname, int playermask,
    // killough 10/98: remove slime trails from wad
    P_RemoveSlimeTrails(); 
 
+   M_LoadTracePhase("P_LoadThings");
+
    // haleyjd 08/19/13: call new function to handle bodyque
    G_ClearPlayerCorpseQueue();
    deathmatch_p = deathmatchstarts;
@@ -3868,18 +4546,29 @@ void P_SetupLevel(WadDirectory *dir, const char *mapname, int playermask,
    iquehead = iquetail = 0;
    
    // set up world state
+   M_LoadTracePhase("P_SpawnSpecials");
    P_SpawnSpecials(setupSettings);
 
    // SoM: Deferred specials that need to be spawned after P_SpawnSpecials
    P_SpawnDeferredSpecials(setupSettings);
 
+   P_InitBlockLines();
+
+   // now that portals are known, maybe fill in an empty reject
+   P_buildReject();
+
    // haleyjd
    P_InitLightning();
 
    // preload graphics
    if(precache)
+   {
+      M_LoadTracePhase("R_PrecacheLevel");
       R_PrecacheLevel();
+      S_PrecacheLevelSounds();
+   }
 
+   M_LoadTracePhase("R_InitPVS");
    R_SetViewSize(screenSize+3); //sf
 
    // haleyjd 07/28/2010: NOW we are in GS_LEVEL. Not before.
@@ -3895,6 +4584,7 @@ void P_SetupLevel(WadDirectory *dir, const char *mapname, int playermask,
       camera = nullptr;        // camera off
 
    R_RefreshContexts();
+   R_InitPVS();
 
    // haleyjd 01/07/07: initialize ACS for Hexen maps
    //         03/19/11: also allow for DOOM-format maps via MapInfo
@@ -3904,6 +4594,7 @@ void P_SetupLevel(WadDirectory *dir, const char *mapname, int playermask,
    else if(LevelInfo.acsScriptLump)
       acslumpnum = setupwad->checkNumForNameNSG(LevelInfo.acsScriptLump, lumpinfo_t::ns_acs);
 
+   M_LoadTracePhase("ACS_LoadLevelScript");
    ACS_LoadLevelScript(dir, acslumpnum);
 }
 
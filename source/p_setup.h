@@ -54,6 +54,8 @@ struct maplumpindex_t;
 int P_CheckLevel(const WadDirectory *dir, int lumpnum, 
                  maplumpindex_t *mgla = nullptr, bool *udmf = nullptr);
 
+void P_PrefetchLevel(const WadDirectory *dir, const char *mapname);
+
 void P_SetupLevel(WadDirectory *dir, const char *mapname, int playermask, skill_t skill);
 void P_Init();                   // Called by startup code.
 void P_InitThingLists();
@@ -64,6 +66,7 @@ struct linkdata_t;
 struct mapthing_t;
 struct sector_t;
 struct side_t;
+struct vertex_t;
 void P_SetupLevelError(const char *msg, const char *levelname);
 void P_InitSector(sector_t *ss);
 void P_InitLineDef(line_t *ld);
@@ -74,7 +77,10 @@ bool P_CheckThingDoomBan(int16_t type);
 void P_ConvertHereticThing(mapthing_t *mthing);
 void P_ConvertDoomExtendedSpawnNum(mapthing_t *mthing);
 
+line_t *const *P_LinesAtVertex(const vertex_t *v, int &count);
+
 extern byte     *rejectmatrix;   // for fast sight rejection
+extern bool      p_autoreject;   // build a reject for maps with an empty one
 
 // killough 3/1/98: change blockmap from "short" to "long" offsets:
 extern int     *blockmaplump;    // offsets in blockmap are from here
@@ -84,6 +90,60 @@ extern int      bmapheight;      // in mapblocks
 extern fixed_t  bmaporgx;
 extern fixed_t  bmaporgy;        // origin of block map
 extern Mobj   **blocklinks;      // for thing chains
+
+//
+// The things of one block laid out contiguously, in reverse chain order so
+// that linking at the head of the chain is an append. changes counts every
+// link and unlink so iterators can tell when the block moved under them.
+//
+struct blockthings_t
+{
+   Mobj **things;
+   int    numthings;
+   int    numalloc;
+   unsigned int changes;
+};
+
+extern blockthings_t *blockthings;
+
+//
+// The blockmap list of one block with the lines' bounding boxes pulled out
+// alongside, so move clipping can reject the lines a box can't touch without
+// loading each line_t. Polyobject lines, which move, get boxes that always
+// pass; list entries that aren't lines get boxes that never do.
+//
+struct blocklines_t
+{
+   const int     *lines;    // the block's blockmap list, start delimiter and all
+   const fixed_t *left;
+   const fixed_t *right;
+   const fixed_t *bottom;
+   const fixed_t *top;
+   int            numlines;
+};
+
+extern blocklines_t *blocklines;
+
+//
+// The fields of a line that move clipping and sight checks read for every
+// line they test, one row per line indexed like lines, so that rejecting a
+// line costs one cache line rather than a line_t and two vertices. Rows are
+// refreshed by P_UpdateLineHot wherever a line's geometry or sectors change
+// once the level is set up.
+//
+struct linehot_t
+{
+   fixed_t   x1, y1, x2, y2; // vertices
+   fixed_t   dx, dy;
+   fixed_t   bbox[4];
+   sector_t *frontsector;
+   sector_t *backsector;
+   int       slopetype;
+};
+
+extern linehot_t *linehot;
+
+void P_UpdateLineHot(const line_t &line);
 extern byte    *portalmap;       // haleyjd: for fast linked portal checks
 extern bool     skipblstart;     // MaxW: Skip initial blocklist short
 
@@ -26,12 +26,16 @@
 #include "z_zone.h"
 #include "i_system.h"
 
+#include "c_runcmd.h"
 #include "cam_sight.h"
 #include "d_gi.h"
 #include "doomstat.h"
 #include "e_exdata.h"
+#include "m_collection.h"
 #include "m_bbox.h"
+#include "p_map.h"
 #include "p_maputl.h"
+#include "p_mobjtable.h"
 #include "p_setup.h"
 #include "r_dynseg.h"
 #include "r_main.h"
@@ -133,7 +137,6 @@ static bool P_CrossSubsecPolyObj(polyobj_t *po, los_t *los)
    {
       line_t *line = po->lines[i];
       divline_t divl;
-      const vertex_t *v1,*v2;
       
       // already checked other side?
       if(line->validcount == validcount)
@@ -141,23 +144,22 @@ static bool P_CrossSubsecPolyObj(polyobj_t *po, los_t *los)
 
       line->validcount = validcount;
       
+      const linehot_t &lh = linehot[line - lines];
+
       // OPTIMIZE: killough 4/20/98: Added quick bounding-box rejection test
-      if(line->bbox[BOXLEFT  ] > los->bbox[BOXRIGHT ] ||
-         line->bbox[BOXRIGHT ] < los->bbox[BOXLEFT  ] ||
-         line->bbox[BOXBOTTOM] > los->bbox[BOXTOP   ] ||
-         line->bbox[BOXTOP]    < los->bbox[BOXBOTTOM])
+      if(lh.bbox[BOXLEFT  ] > los->bbox[BOXRIGHT ] ||
+         lh.bbox[BOXRIGHT ] < los->bbox[BOXLEFT  ] ||
+         lh.bbox[BOXBOTTOM] > los->bbox[BOXTOP   ] ||
+         lh.bbox[BOXTOP]    < los->bbox[BOXBOTTOM])
          continue;
 
-      v1 = line->v1;
-      v2 = line->v2;
-      
       // line isn't crossed?
-      if(P_DivlineSide(v1->x, v1->y, los->strace) ==
-         P_DivlineSide(v2->x, v2->y, los->strace))
+      if(P_DivlineSide(lh.x1, lh.y1, los->strace) ==
+         P_DivlineSide(lh.x2, lh.y2, los->strace))
          continue;
 
-      divl.dx = v2->x - (divl.x = v1->x);
-      divl.dy = v2->y - (divl.y = v1->y);
+      divl.dx = lh.x2 - (divl.x = lh.x1);
+      divl.dy = lh.y2 - (divl.y = lh.y1);
       
       // line isn't crossed?
       if(P_DivlineSide(los->strace.x, los->strace.y, divl) ==
@@ -215,7 +217,6 @@ static bool P_CrossSubsector(int num, los_t *los)
       divline_t divl;
       fixed_t opentop, openbottom;
       const sector_t *front, *back;
-      const vertex_t *v1,*v2;
       fixed_t frac;
       
       // already checked other side?
@@ -224,29 +225,28 @@ static bool P_CrossSubsector(int num, los_t *los)
 
       line->validcount = validcount;
       
+      const linehot_t &lh = linehot[line - lines];
+
       // OPTIMIZE: killough 4/20/98: Added quick bounding-box rejection test
       // haleyjd: another demo compatibility fix by cph -- who knows
       // why this is a problem, though
       // 11/11/02: see P_DivlineSide above to find out why
       if(!demo_compatibility)
       {
-         if(line->bbox[BOXLEFT  ] > los->bbox[BOXRIGHT ] ||
-            line->bbox[BOXRIGHT ] < los->bbox[BOXLEFT  ] ||
-            line->bbox[BOXBOTTOM] > los->bbox[BOXTOP   ] ||
-            line->bbox[BOXTOP   ] < los->bbox[BOXBOTTOM])
+         if(lh.bbox[BOXLEFT  ] > los->bbox[BOXRIGHT ] ||
+            lh.bbox[BOXRIGHT ] < los->bbox[BOXLEFT  ] ||
+            lh.bbox[BOXBOTTOM] > los->bbox[BOXTOP   ] ||
+            lh.bbox[BOXTOP   ] < los->bbox[BOXBOTTOM])
             continue;
       }
 
-      v1 = line->v1;
-      v2 = line->v2;
-      
       // line isn't crossed?
-      if(P_DivlineSide(v1->x, v1->y, los->strace) ==
-         P_DivlineSide(v2->x, v2->y, los->strace))
+      if(P_DivlineSide(lh.x1, lh.y1, los->strace) ==
+         P_DivlineSide(lh.x2, lh.y2, los->strace))
          continue;
 
-      divl.dx = v2->x - (divl.x = v1->x);
-      divl.dy = v2->y - (divl.y = v1->y);
+      divl.dx = lh.x2 - (divl.x = lh.x1);
+      divl.dy = lh.y2 - (divl.y = lh.y1);
       
       // line isn't crossed?
       if(P_DivlineSide(los->strace.x, los->strace.y, divl) ==
@@ -315,7 +315,7 @@ static bool P_CrossBSPNode(int bspnum, los_t *los)
 {
    while(!(bspnum & NF_SUBSECTOR))
    {
-      const node_t &bsp = nodes[bspnum];
+      const bspnode_t &bsp = bspnodes[bspnum];
       int side = P_DivlineSide(los->strace.x, los->strace.y, bsp)&1;
       if(side == P_DivlineSide(los->t2x,      los->t2y,      bsp))
          bspnum = bsp.children[side]; // doesn't touch the other side
@@ -331,6 +331,69 @@ static bool P_CrossBSPNode(int bspnum, los_t *los)
       P_CrossSubsector((bspnum == -1 ? 0 : bspnum & ~NF_SUBSECTOR), los);
 }
 
+//
+// Monster sight prefetching
+//
+// The first sight check of a tic queues up the checks the monsters about to
+// act are likely to make: each against its target, or against every player
+// if it has none. The whole batch is worked out across threads against the
+// level as it stands, and the cache hands the results back only to checks
+// that ask exactly the same thing before anything changes, so the tic plays
+// out identically with or without it.
+//
+
+bool p_aiprefetch;
+
+VARIABLE_TOGGLE(p_aiprefetch, nullptr, onoff);
+CONSOLE_VARIABLE(p_aiprefetch, p_aiprefetch, 0) {}
+
+static int sightprefetchtic = -1;
+
+//
+// Forgets the tic of the last prefetch, which a new level's leveltime could
+// otherwise match.
+//
+void P_ResetSightPrefetch()
+{
+   sightprefetchtic = -1;
+}
+
+static void P_prefetchMonsterSight()
+{
+   sightprefetchtic = leveltime;
+
+   PODCollection<camsightparams_t> checks;
+   const mobjtable_t &t = mobjtable;
+   for(int row = 0; row < t.numrows; row++)
+   {
+      const Mobj *mo = t.mobj[row];
+
+      // only things whose state runs out this tic will act on a check
+      if(!mo || mo->player || mo->tics != 1 || mo->health <= 0 ||
+         !(t.flags[row] & MF_COUNTKILL))
+         continue;
+
+      if(mo->target)
+      {
+         camsightparams_t &params = checks.addNew();
+         params.setLookerMobj(mo);
+         params.setTargetMobj(mo->target);
+         continue;
+      }
+      for(int i = 0; i < MAXPLAYERS; i++)
+      {
+         if(!playeringame[i] || !players[i].mo)
+            continue;
+         camsightparams_t &params = checks.addNew();
+         params.setLookerMobj(mo);
+         params.setTargetMobj(players[i].mo);
+      }
+   }
+
+   if(checks.getLength())
+      CAM_PrefetchSight(&checks[0], int(checks.getLength()));
+}
+
 //
 // P_CheckSight
 // Returns true
@@ -344,6 +407,9 @@ bool P_CheckSight(Mobj *t1, Mobj *t2)
    // VANILLA_HERETIC: both in modern and Heretic demo gameplay use CAM_CheckSight
    if(full_demo_version >= make_full_version(340, 24) || vanilla_heretic)
    {
+      if(p_aiprefetch && sightprefetchtic != leveltime)
+         P_prefetchMonsterSight();
+
       camsightparams_t camparams;
       camparams.prev = nullptr;
       camparams.setLookerMobj(t1);
@@ -423,7 +489,7 @@ bool P_CheckSight(Mobj *t1, Mobj *t2)
    }
    
    // the head node is the last node output
-   return P_CrossBSPNode(numnodes-1, &los);
+   return P_CrossBSPNode(numnodes ? 0 : -1, &los);
 }
 
 //----------------------------------------------------------------------------
@@ -0,0 +1,143 @@
+//
+// The Eternity Engine
+// Copyright(C) 2026 James Haley, Max Waine, et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+// Additional terms and conditions compatible with the GPLv3 apply. See the
+// file COPYING-EE for details.
+//
+// Purpose: Headless playsim benchmark.
+//  The stages are timed from the first tic of the demo until it ends. The
+//  report goes to the file named by -simbenchjson, or to stdout, and the
+//  game then quits. Whatever the stages don't cover, such as reading the
+//  demo and the rest of G_Ticker, is reported as "other".
+//
+
+#include "z_zone.h"
+#include "i_system.h"
+
+#include "g_statehash.h"
+#include "m_argv.h"
+#include "m_qstr.h"
+#include "p_simbench.h"
+#include "version.h"
+
+using simclock_t = std::chrono::steady_clock;
+
+static const char *const stagenames[SIMBENCH_NUMSTAGES] =
+{
+   "players", "thinkers", "acs", "specials", "sndseq", "particles",
+};
+
+bool simbench;
+
+static qstring            simdemoname;
+static simclock_t::time_point simstart;
+static simclock_t::duration   simstages[SIMBENCH_NUMSTAGES];
+
+//
+// Called at startup when -simbench is given, with the demo to be played.
+//
+void P_SimBenchInit(const char *demoname)
+{
+   simbench    = true;
+   simdemoname = demoname;
+}
+
+//
+// Starts the clock when the demo begins.
+//
+void P_SimBenchStart()
+{
+   for(simclock_t::duration &time : simstages)
+      time = simclock_t::duration::zero();
+
+   simstart = simclock_t::now();
+}
+
+void P_SimBenchAdd(simbenchstage_e stage, simclock_t::duration time)
+{
+   simstages[stage] += time;
+}
+
+//
+// Writes one stage's entry of the report
+//
+static void P_writeStage(FILE *f, const char *name, double seconds, int tics,
+                         bool last)
+{
+   fprintf(f, "    \"%s\": { \"seconds\": %.6f, \"usec_per_tic\": %.3f }%s\n",
+           name, seconds, tics ? seconds * 1000000.0 / tics : 0.0,
+           last ? "" : ",");
+}
+
+//
+// Writes the report for a demo of the given length and quits.
+//
+void P_SimBenchReport(int tics)
+{
+   using seconds_t = std::chrono::duration<double>;
+
+   const double total = seconds_t(simclock_t::now() - simstart).count();
+   double       other = total;
+   qstring      demo;
+   FILE        *f = stdout;
+   int          p;
+
+   if((p = M_CheckParm("-simbenchjson")) && ++p < myargc)
+   {
+      if(!(f = fopen(myargv[p], "w")))
+         I_Error("P_SimBenchReport: couldn't open %s\n", myargv[p]);
+   }
+
+   // the demo name is the only string that could need escaping
+   for(size_t i = 0; i < simdemoname.length(); i++)
+   {
+      if(simdemoname[i] == '"' || simdemoname[i] == '\\')
+         demo += '\\';
+      demo += simdemoname[i];
+   }
+
+   fprintf(f, "{\n");
+   fprintf(f, "  \"demo\": \"%s\",\n", demo.constPtr());
+   fprintf(f, "  \"version\": \"%d.%02d.%02d %s\",\n",
+           version / 100, version % 100, subversion, version_name);
+   fprintf(f, "  \"tics\": %d,\n", tics);
+   fprintf(f, "  \"seconds\": %.6f,\n", total);
+   fprintf(f, "  \"tics_per_second\": %.1f,\n", total > 0 ? tics / total : 0.0);
+   fprintf(f, "  \"state_hash\": \"%08x\",\n", G_StateHash());
+   fprintf(f, "  \"stages\": {\n");
+
+   for(int i = 0; i < SIMBENCH_NUMSTAGES; i++)
+   {
+      const double seconds = seconds_t(simstages[i]).count();
+
+      P_writeStage(f, stagenames[i], seconds, tics, false);
+      other -= seconds;
+   }
+   P_writeStage(f, "other", other, tics, true);
+
+   fprintf(f, "  }\n");
+   fprintf(f, "}\n");
+
+   if(f != stdout)
+      fclose(f);
+
+   I_ExitWithMessage("Simulated %d gametics in %.3f seconds = %.1f tics per second\n",
+                     tics, total, total > 0 ? tics / total : 0.0);
+}
+
+// EOF
+
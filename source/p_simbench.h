@@ -0,0 +1,79 @@
+//
+// The Eternity Engine
+// Copyright(C) 2026 James Haley, Max Waine, et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+// Additional terms and conditions compatible with the GPLv3 apply. See the
+// file COPYING-EE for details.
+//
+// Purpose: Headless playsim benchmark.
+//  -simbench <demo> plays a demo with no window, drawing or sound, as fast
+//  as the game tics run, and writes tics per second and the time taken by
+//  each part of P_Ticker out as JSON.
+//
+
+#ifndef P_SIMBENCH_H__
+#define P_SIMBENCH_H__
+
+#include <chrono>
+
+enum simbenchstage_e
+{
+   SIMBENCH_PLAYERS,   // P_PlayerThink
+   SIMBENCH_THINKERS,  // Thinker::RunThinkers
+   SIMBENCH_ACS,       // ACS_Exec
+   SIMBENCH_SPECIALS,  // P_UpdateSpecials, P_RespawnSpecials, P_AnimateSurfaces
+   SIMBENCH_SNDSEQ,    // S_RunSequences
+   SIMBENCH_PARTICLES, // P_ParticleThinker, P_RunEffects
+   SIMBENCH_NUMSTAGES
+};
+
+extern bool simbench;
+
+void P_SimBenchInit(const char *demoname);
+void P_SimBenchStart();
+void P_SimBenchAdd(simbenchstage_e stage, std::chrono::steady_clock::duration time);
+void P_SimBenchReport(int tics);
+
+//
+// Charges the enclosing scope to a stage while benchmarking.
+//
+class SimBenchScope
+{
+public:
+   explicit SimBenchScope(simbenchstage_e pStage) : stage(pStage)
+   {
+      if(simbench)
+         start = std::chrono::steady_clock::now();
+   }
+
+   ~SimBenchScope()
+   {
+      if(simbench)
+         P_SimBenchAdd(stage, std::chrono::steady_clock::now() - start);
+   }
+
+   SimBenchScope(const SimBenchScope &) = delete;
+   SimBenchScope &operator = (const SimBenchScope &) = delete;
+
+private:
+   simbenchstage_e                       stage;
+   std::chrono::steady_clock::time_point start;
+};
+
+#endif
+
+// EOF
+
@@ -62,12 +62,12 @@ static pslope_t *P_MakeSlope(const v3float_t &o, const v2float_t &d,
       v3float_t v2;
       v2.x = v1.x;
       v2.y = v1.y + 10.0f;
-      v2.z = P_GetZAtf(ret, v2.x, v2.y);
+      v2.z = ret->getZAtf(v2.x, v2.y);
 
       v3float_t v3;
       v3.x = v1.x + 10.0f;
       v3.y = v1.y;
-      v3.z = P_GetZAtf(ret, v3.x, v3.y);
+      v3.z = ret->getZAtf(v3.x, v3.y);
 
       v3float_t d1, d2;
       if(type == surf_ceil)
@@ -468,30 +468,6 @@ void P_CopySectorSlope(line_t *line, int staticFn)
 // Various utilities related to slopes
 //
 
-//
-// P_GetZAt
-//
-// Returns the height of the sloped plane at (x, y) as a fixed_t
-//
-fixed_t P_GetZAt(pslope_t *slope, fixed_t x, fixed_t y)
-{
-   fixed_t dist = FixedMul(x - slope->o.x, slope->d.x) +
-                  FixedMul(y - slope->o.y, slope->d.y);
-
-   return slope->o.z + FixedMul(dist, slope->zdelta);
-}
-
-//
-// P_GetZAtf
-//
-// Returns the height of the sloped plane at (x, y) as a float
-//
-float P_GetZAtf(pslope_t *slope, float x, float y)
-{
-   float dist = (x - slope->of.x) * slope->df.x + (y - slope->of.y) * slope->df.y;
-   return slope->of.z + (dist * slope->zdeltaf);
-}
-
 //
 // P_DistFromPlanef
 //
@@ -503,15 +479,5 @@ float P_DistFromPlanef(const v3float_t *point, const v3float_t *pori,
           (point->z - pori->z) * pnormal->z;
 }
 
-//
-// Get height of a potentially sloped surface
-//
-fixed_t surface_t::getZAt(fixed_t x, fixed_t y) const
-{
-   if(slope)
-      return P_GetZAt(slope, x, y);
-   return height;
-}
-
 // EOF
 
@@ -49,14 +49,6 @@ void P_SpawnSlope_Line(int linenum, int staticFn);
 //
 void P_CopySectorSlope(line_t *line, int staticFn);
 
-// Returns the height of the sloped plane at (x, y) as a fixed_t
-fixed_t P_GetZAt(pslope_t *slope, fixed_t x, fixed_t y);
-
-
-// Returns the height of the sloped plane at (x, y) as a float
-float P_GetZAtf(pslope_t *slope, float x, float y);
-
-
 // Returns the distance of the given point from the given origin and normal.
 float P_DistFromPlanef(const v3float_t *point, const v3float_t *pori, 
                        const v3float_t *pnormal);
@@ -100,8 +100,13 @@ struct anim_t
   int         basepic;
   int         numpics;
   int         speed;
+  int         phase;      // frame last written to texturetranslation
 };
 
+// phase of an animation that isn't cycling, or that hasn't been written yet
+static constexpr int ANIMPHASE_STILL = -1;
+static constexpr int ANIMPHASE_NONE  = -2;
+
 //
 //      source animation definition
 //
@@ -185,6 +190,7 @@ static void P_addPicAnim(const animdef_t &animdef)
    lastanim->istexture = !!animdef.istexture;
    lastanim->numpics = lastanim->picnum - lastanim->basepic + 1;
    lastanim->speed = SwapLong(animdef.speed); // killough 5/5/98: add LONG()
+   lastanim->phase = ANIMPHASE_NONE;
 
    if(!lastanim->speed)
    {
@@ -438,6 +444,28 @@ sector_t *getNextSector(const line_t *line, const sector_t *sec)
             line->frontsector;
 }
 
+//
+// Calls func with every sector getNextSector finds across sec's lines, in
+// line order. Outside of comp_model the sector's neighbor list already holds
+// them, each listed once.
+//
+template<typename F>
+static void P_forSurroundingSectors(const sector_t *sec, F &&func)
+{
+   if(!getComp(comp_model))
+   {
+      for(int i = 0; i < sec->neighborcount; i++)
+         func(sec->neighbors[i]);
+      return;
+   }
+
+   for(int i = 0; i < sec->linecount; i++)
+   {
+      if(const sector_t *other = getNextSector(sec->lines[i], sec))
+         func(other);
+   }
+}
+
 //
 // P_FindLowestFloorSurrounding()
 //
@@ -449,15 +477,11 @@ sector_t *getNextSector(const line_t *line, const sector_t *sec)
 fixed_t P_FindLowestFloorSurrounding(const sector_t* sec)
 {
    fixed_t floor = sec->srf.floor.height;
-   const sector_t *other;
-   int i;
 
-   for(i = 0; i < sec->linecount; i++)
-   {
-      if((other = getNextSector(sec->lines[i], sec)) &&
-         other->srf.floor.height < floor)
+   P_forSurroundingSectors(sec, [&](const sector_t *other) {
+      if(other->srf.floor.height < floor)
          floor = other->srf.floor.height;
-   }
+   });
 
    return floor;
 }
@@ -476,8 +500,6 @@ fixed_t P_FindLowestFloorSurrounding(const sector_t* sec)
 fixed_t P_FindHighestFloorSurrounding(const sector_t *sec)
 {
    fixed_t floor = -500*FRACUNIT;
-   const sector_t *other;
-   int i;
 
    //jff 1/26/98 Fix initial value for floor to not act differently
    //in sections of wad that are below -500 units
@@ -485,12 +507,10 @@ fixed_t P_FindHighestFloorSurrounding(const sector_t *sec)
    if(!getComp(comp_model))          //jff 3/12/98 avoid ovf
       floor = -32000*FRACUNIT;      // in height calculations
 
-   for(i = 0; i < sec->linecount; i++)
-   {
-      if((other = getNextSector(sec->lines[i],sec)) &&
-         other->srf.floor.height > floor)
+   P_forSurroundingSectors(sec, [&](const sector_t *other) {
+      if(other->srf.floor.height > floor)
          floor = other->srf.floor.height;
-   }
+   });
 
    return floor;
 }
@@ -507,26 +527,20 @@ fixed_t P_FindHighestFloorSurrounding(const sector_t *sec)
 //
 fixed_t P_FindNextHighestFloor(const sector_t *sec, int currentheight)
 {
-   sector_t *other;
-   int i;
+   int  height = currentheight;
+   bool found  = false;
 
-   for(i=0; i < sec->linecount; i++)
-   {
-      if((other = getNextSector(sec->lines[i],sec)) &&
-         other->srf.floor.height > currentheight)
+   P_forSurroundingSectors(sec, [&](const sector_t *other) {
+      const int otherheight = other->srf.floor.height;
+
+      if(otherheight > currentheight && (!found || otherheight < height))
       {
-         int height = other->srf.floor.height;
-         while (++i < sec->linecount)
-         {
-            if((other = getNextSector(sec->lines[i],sec)) &&
-               other->srf.floor.height < height &&
-               other->srf.floor.height > currentheight)
-               height = other->srf.floor.height;
-         }
-         return height;
+         height = otherheight;
+         found  = true;
       }
-   }
-   return currentheight;
+   });
+
+   return height;
 }
 
 //
@@ -541,26 +555,20 @@ fixed_t P_FindNextHighestFloor(const sector_t *sec, int currentheight)
 //
 fixed_t P_FindNextLowestFloor(const sector_t *sec, int currentheight)
 {
-   sector_t *other;
-   int i;
+   int  height = currentheight;
+   bool found  = false;
 
-   for(i=0; i < sec->linecount; i++)
-   {
-      if((other = getNextSector(sec->lines[i],sec)) &&
-         other->srf.floor.height < currentheight)
+   P_forSurroundingSectors(sec, [&](const sector_t *other) {
+      const int otherheight = other->srf.floor.height;
+
+      if(otherheight < currentheight && (!found || otherheight > height))
       {
-         int height = other->srf.floor.height;
-         while (++i < sec->linecount)
-         {
-            if((other = getNextSector(sec->lines[i],sec)) &&
-               other->srf.floor.height > height &&
-               other->srf.floor.height < currentheight)
-               height = other->srf.floor.height;
-         }
-         return height;
+         height = otherheight;
+         found  = true;
       }
-   }
-   return currentheight;
+   });
+
+   return height;
 }
 
 //
@@ -575,26 +583,20 @@ fixed_t P_FindNextLowestFloor(const sector_t *sec, int currentheight)
 //
 fixed_t P_FindNextLowestCeiling(const sector_t *sec, int currentheight)
 {
-   sector_t *other;
-   int i;
+   int  height = currentheight;
+   bool found  = false;
 
-   for(i=0 ;i < sec->linecount ; i++)
-   {
-      if((other = getNextSector(sec->lines[i],sec)) &&
-         other->srf.ceiling.height < currentheight)
+   P_forSurroundingSectors(sec, [&](const sector_t *other) {
+      const int otherheight = other->srf.ceiling.height;
+
+      if(otherheight < currentheight && (!found || otherheight > height))
       {
-         int height = other->srf.ceiling.height;
-         while (++i < sec->linecount)
-         {
-            if((other = getNextSector(sec->lines[i],sec)) &&
-               other->srf.ceiling.height > height &&
-               other->srf.ceiling.height < currentheight)
-               height = other->srf.ceiling.height;
-         }
-        return height;
+         height = otherheight;
+         found  = true;
       }
-   }
-   return currentheight;
+   });
+
+   return height;
 }
 
 //
@@ -609,26 +611,20 @@ fixed_t P_FindNextLowestCeiling(const sector_t *sec, int currentheight)
 //
 fixed_t P_FindNextHighestCeiling(const sector_t *sec, int currentheight)
 {
-   sector_t *other;
-   int i;
+   int  height = currentheight;
+   bool found  = false;
 
-   for(i=0; i < sec->linecount; i++)
-   {
-      if((other = getNextSector(sec->lines[i],sec)) &&
-         other->srf.ceiling.height > currentheight)
+   P_forSurroundingSectors(sec, [&](const sector_t *other) {
+      const int otherheight = other->srf.ceiling.height;
+
+      if(otherheight > currentheight && (!found || otherheight < height))
       {
-         int height = other->srf.ceiling.height;
-         while (++i < sec->linecount)
-         {
-            if((other = getNextSector(sec->lines[i],sec)) &&
-               other->srf.ceiling.height < height &&
-               other->srf.ceiling.height > currentheight)
-               height = other->srf.ceiling.height;
-         }
-         return height;
+         height = otherheight;
+         found  = true;
       }
-   }
-   return currentheight;
+   });
+
+   return height;
 }
 
 //
@@ -644,9 +640,7 @@ fixed_t P_FindNextHighestCeiling(const sector_t *sec, int currentheight)
 //
 fixed_t P_FindLowestCeilingSurrounding(const sector_t* sec)
 {
-   const sector_t *other;
    fixed_t height = D_MAXINT;
-   int i;
 
    if(!getComp(comp_model))
       height = 32000*FRACUNIT; //jff 3/12/98 avoid ovf in height calculations
@@ -654,10 +648,8 @@ fixed_t P_FindLowestCeilingSurrounding(const sector_t* sec)
    if(demo_version >= 333)
    {
       // SoM: ignore attached sectors.
-      for(i = 0; i < sec->linecount; i++)
-      {
-         if((other = getNextSector(sec->lines[i],sec)) &&
-            other->srf.ceiling.height < height)
+      P_forSurroundingSectors(sec, [&](const sector_t *other) {
+         if(other->srf.ceiling.height < height)
          {
             int j;
 
@@ -668,15 +660,14 @@ fixed_t P_FindLowestCeilingSurrounding(const sector_t* sec)
             if(j == sec->srf.ceiling.asurfacecount)
                height = other->srf.ceiling.height;
          }
-      }
+      });
    }
    else
    {
-      for(i = 0; i < sec->linecount; i++)
-      {
-         if((other = getNextSector(sec->lines[i],sec)) && other->srf.ceiling.height < height)
+      P_forSurroundingSectors(sec, [&](const sector_t *other) {
+         if(other->srf.ceiling.height < height)
             height = other->srf.ceiling.height;
-      }
+      });
    }
 
    return height;
@@ -695,9 +686,7 @@ fixed_t P_FindLowestCeilingSurrounding(const sector_t* sec)
 //
 fixed_t P_FindHighestCeilingSurrounding(const sector_t* sec)
 {
-   const sector_t *other;
    fixed_t height = 0;
-   int i;
 
    //jff 1/26/98 Fix initial value for floor to not act differently
    //in sections of wad that are below 0 units
@@ -706,10 +695,10 @@ fixed_t P_FindHighestCeilingSurrounding(const sector_t* sec)
       height = -32000*FRACUNIT; //jff 3/12/98 avoid ovf in
 
    // height calculations
-   for(i=0; i < sec->linecount; i++)
-      if((other = getNextSector(sec->lines[i],sec)) &&
-         other->srf.ceiling.height > height)
+   P_forSurroundingSectors(sec, [&](const sector_t *other) {
+      if(other->srf.ceiling.height > height)
          height = other->srf.ceiling.height;
+   });
 
    return height;
 }
@@ -1321,23 +1310,32 @@ void P_UpdateSpecials()
          G_ExitLevel();
    }
 
-   // Animate flats and textures globally
+   // Animate flats and textures globally. The pics of an animation only
+   // change when it moves on a frame, so the others are passed over.
    for(anim = anims; anim < lastanim; anim++)
    {
-      for(int i = anim->basepic; i < anim->basepic + anim->numpics; i++)
+      const bool still = (!anim->istexture && r_swirl) ||
+         anim->speed >= SWIRL_TICS || anim->numpics == 1;
+      const int  phase = still ? ANIMPHASE_STILL : leveltime / anim->speed;
+
+      if(phase == anim->phase)
+         continue;
+      anim->phase = phase;
+
+      if(still)
       {
-         if((i >= flatstart && i < flatstop && r_swirl) ||
-            anim->speed >= SWIRL_TICS || anim->numpics == 1)
-         {
+         for(int i = anim->basepic; i < anim->basepic + anim->numpics; i++)
             texturetranslation[i] = i;
-         }
-         else
-         {
-            pic = anim->basepic + 
-                  ((leveltime/anim->speed + i) % anim->numpics);
+         continue;
+      }
 
-            texturetranslation[i] = pic;
-         }
+      // each pic shows the one a frame along from it, wrapping to the start
+      pic = (phase + anim->basepic) % anim->numpics;
+      for(int i = anim->basepic; i < anim->basepic + anim->numpics; i++)
+      {
+         texturetranslation[i] = anim->basepic + pic;
+         if(++pic == anim->numpics)
+            pic = 0;
       }
    }
    
@@ -3164,6 +3162,7 @@ static void P_SpawnPortal(line_t *line, int staticFn)
       line->flags &= ~ML_BLOCKING;
       line->flags |= ML_TWOSIDED;
       line->intflags |= MLI_1SPORTALLINE;
+      P_UpdateLineHot(*line);
    };
 
    bool otherIsEdge = false;
@@ -702,6 +702,8 @@ class FireFlickerThinker : public SectorThinker
 {
    DECLARE_THINKER_TYPE(FireFlickerThinker, SectorThinker)
 
+   friend class Thinker; // batched by RunGroupedThinkers
+
 protected:
    void Think() override;
 
@@ -719,6 +721,8 @@ class LightFlashThinker : public SectorThinker
 {
    DECLARE_THINKER_TYPE(LightFlashThinker, SectorThinker)
 
+   friend class Thinker; // batched by RunGroupedThinkers
+
 protected:
    void Think() override;
 
@@ -739,6 +743,8 @@ class StrobeThinker : public SectorThinker
 {
    DECLARE_THINKER_TYPE(StrobeThinker, SectorThinker)
 
+   friend class Thinker; // batched by RunGroupedThinkers
+
 protected:
    void Think() override;
 
@@ -759,6 +765,8 @@ class GlowThinker : public SectorThinker
 {
    DECLARE_THINKER_TYPE(GlowThinker, SectorThinker)
 
+   friend class Thinker; // batched by RunGroupedThinkers
+
 protected:
    void Think() override;
 
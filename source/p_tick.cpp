@@ -28,20 +28,25 @@
 #include "acs_intr.h"
 #include "c_io.h"
 #include "c_runcmd.h"
+#include "cam_sight.h"
 #include "d_dehtbl.h"
 #include "d_gi.h"
 #include "d_main.h"
 #include "doomstat.h"
 #include "i_system.h"
+#include "m_collection.h"
 #include "p_anim.h"
 #include "p_chase.h"
+#include "p_mobjtable.h"
 #include "p_saveg.h"
 #include "p_scroll.h"
 #include "p_sector.h"
+#include "p_simbench.h"
 #include "p_spec.h"
 #include "p_tick.h"
 #include "p_user.h"
 #include "p_partcl.h"
+#include "p_profile.h"
 #include "polyobj.h"
 #include "r_dynseg.h"
 #include "s_musinfo.h"
@@ -73,15 +78,197 @@ Thinker thinkerclasscap[NUMTHCLASS];
 //
 IMPLEMENT_RTTI_TYPE(Thinker)
 
+//
+// Grouped thinker execution
+//
+// Outside of demos and netgames, p_groupthinkers runs the thinkers one class
+// at a time rather than in list order, so a tic goes through long runs of
+// the same Think method. The simplest and most numerous classes are run from
+// loops calling their Think directly. Each thinker still runs once per tic,
+// but thinkers of different classes interleave differently than they would
+// in the list, which is what keeps this away from anything that has to stay
+// in sync.
+//
+// The groups persist between tics. Thinkers are only ever added at the end
+// of the list, so each tic first files everything past the last thinker
+// already grouped, runs the groups, and then runs whatever was spawned
+// during the tic in list order just like RunThinkers does.
+//
+
+bool p_groupthinkers;
+
+struct thinkergroup_t
+{
+   const RTTIObject::Type *type;                        // nullptr for overflow
+   size_t (*run)(Thinker **things, size_t count);
+   PODCollection<Thinker *> things;
+};
+
+static constexpr int NUMTHINKERGROUPS = 64;
+
+static thinkergroup_t thinkergroups[NUMTHINKERGROUPS];
+static int            numthinkergroups;
+static Thinker       *lastgrouped;   // nullptr while the groups are invalid
+
+static void P_invalidateThinkerGroups()
+{
+   for(int i = 0; i < numthinkergroups; i++)
+      thinkergroups[i].things.makeEmpty();
+   numthinkergroups = 0;
+   lastgrouped = nullptr;
+}
+
+//
+// Runs a group of one class, deleting removed thinkers as RunThinkers would,
+// and packs the survivors down. Returns how many are left.
+//
+template<typename T> size_t Thinker::ThinkBatch(Thinker **things, size_t count)
+{
+   size_t numleft = 0;
+
+   for(size_t i = 0; i < count; i++)
+   {
+      Thinker *th = things[i];
+
+      currentthinker = th;
+      if(th->removed)
+      {
+         // the last grouped thinker anchors the next tic's new arrivals
+         if(!th->references && th != lastgrouped)
+         {
+            th->removeDelayed();
+            continue;
+         }
+      }
+      else if(std::is_same<T, Thinker>::value)
+         th->Think();
+      else
+         static_cast<T *>(th)->T::Think();
+
+      things[numleft++] = th;
+   }
+
+   return numleft;
+}
+
+//
+// Runs a thinker and charges the time to its class, for p_profile.
+//
+void Thinker::ThinkProfiled(Thinker *th)
+{
+   const RTTIObject::Type *type  = th->getDynamicType();
+   const auto              start = std::chrono::steady_clock::now();
+
+   th->Think();
+   P_ProfileThinker(type, 1, std::chrono::steady_clock::now() - start);
+}
+
+//
+// Finds or makes the group for a thinker's class.
+//
+static thinkergroup_t &P_thinkerGroup(const RTTIObject::Type *type,
+                                      size_t (*run)(Thinker **, size_t))
+{
+   for(int i = 0; i < numthinkergroups; i++)
+   {
+      if(thinkergroups[i].type == type)
+         return thinkergroups[i];
+   }
+
+   if(numthinkergroups < NUMTHINKERGROUPS - 1)
+   {
+      thinkergroup_t &group = thinkergroups[numthinkergroups++];
+      group.type = type;
+      group.run  = run;
+      return group;
+   }
+
+   // out of groups: everything else goes in one virtually dispatched group
+   thinkergroup_t &overflow = thinkergroups[NUMTHINKERGROUPS - 1];
+   if(numthinkergroups < NUMTHINKERGROUPS)
+   {
+      ++numthinkergroups;
+      overflow.type = nullptr;
+      overflow.run  = run;
+   }
+   return overflow;
+}
+
+void Thinker::RunGroupedThinkers()
+{
+   // file the thinkers added since the last tic
+   Thinker *th = lastgrouped ? lastgrouped->next : thinkercap.next;
+   for(; th != &thinkercap; th = th->next)
+   {
+      const RTTIObject::Type *type = th->getDynamicType();
+      size_t (*run)(Thinker **, size_t) = ThinkBatch<Thinker>;
+
+      if(type == RTTI(FireFlickerThinker))
+         run = ThinkBatch<FireFlickerThinker>;
+      else if(type == RTTI(LightFlashThinker))
+         run = ThinkBatch<LightFlashThinker>;
+      else if(type == RTTI(StrobeThinker))
+         run = ThinkBatch<StrobeThinker>;
+      else if(type == RTTI(GlowThinker))
+         run = ThinkBatch<GlowThinker>;
+      else if(type == RTTI(ScrollThinker))
+         run = ThinkBatch<ScrollThinker>;
+
+      thinkergroup_t &group = P_thinkerGroup(type, run);
+      if(!group.type)
+         group.run = ThinkBatch<Thinker>;
+      group.things.add(th);
+      lastgrouped = th;
+   }
+
+   for(int i = 0; i < numthinkergroups; i++)
+   {
+      PODCollection<Thinker *> &things = thinkergroups[i].things;
+      if(!things.getLength())
+         continue;
+
+      if(p_profiling)
+      {
+         const size_t count = things.getLength();
+         const auto   start = std::chrono::steady_clock::now();
+         things.resize(thinkergroups[i].run(&things[0], count));
+         P_ProfileThinker(thinkergroups[i].type, count,
+                          std::chrono::steady_clock::now() - start);
+      }
+      else
+         things.resize(thinkergroups[i].run(&things[0], things.getLength()));
+   }
+
+   // anything spawned meanwhile runs this tic, as it would in the list
+   if(lastgrouped)
+   {
+      for(currentthinker = lastgrouped->next;
+          currentthinker != &thinkercap;
+          currentthinker = currentthinker->next)
+      {
+         if(currentthinker->removed)
+            currentthinker->removeDelayed();
+         else if(p_profiling)
+            ThinkProfiled(currentthinker);
+         else
+            currentthinker->Think();
+      }
+   }
+}
+
 //
 // P_InitThinkers
 //
 void Thinker::InitThinkers(void)
 {
+   P_invalidateThinkerGroups();
+
    for(Thinker &thinker : thinkerclasscap)  // killough 8/29/98: initialize threaded lists
       thinker.cprev = thinker.cnext = &thinker;
 
    thinkercap.prev = thinkercap.next  = &thinkercap;
+
+   P_ClearMobjTable();
 }
 
 //
@@ -228,18 +415,31 @@ void Thinker::remove()
 //
 void Thinker::RunThinkers(void)
 {
-   for(currentthinker = thinkercap.next; 
-       currentthinker != &thinkercap;
-       currentthinker = currentthinker->next)
+   if(p_groupthinkers && !demoplayback && !demorecording && !netgame)
+      RunGroupedThinkers();
+   else
    {
-      if(currentthinker->removed)
-         currentthinker->removeDelayed();
-      else
-         currentthinker->Think();
+      // the plain walk may delete any thinker, so the groups must be redone
+      P_invalidateThinkerGroups();
+
+      for(currentthinker = thinkercap.next;
+          currentthinker != &thinkercap;
+          currentthinker = currentthinker->next)
+      {
+         if(currentthinker->removed)
+            currentthinker->removeDelayed();
+         else if(p_profiling)
+            ThinkProfiled(currentthinker);
+         else
+            currentthinker->Think();
+      }
    }
    S_MusInfoUpdate();
 }
 
+VARIABLE_TOGGLE(p_groupthinkers, nullptr, onoff);
+CONSOLE_VARIABLE(p_groupthinkers, p_groupthinkers, 0) {}
+
 //
 // Thinker::serialize
 //
@@ -253,7 +453,16 @@ void Thinker::RunThinkers(void)
 //
 void Thinker::serialize(SaveArchive &arc)
 {
-   if(arc.isSaving())
+   if(!arc.isSaving())
+      return;
+
+   // from version 15, a table of class names is built up as they are met
+   if(arc.saveVersion() >= 15)
+   {
+      qstring className(getClassName());
+      arc.archiveCachedString(className);
+   }
+   else
       arc.writeLString(getClassName());
 }
 
@@ -278,6 +487,9 @@ void P_Ticker()
    if(!leveltime)
       P_SpawnUnknownThings();
 
+   // sight results are only reused within a tic
+   CAM_InvalidateSightCache();
+
    // interpolation: save current sector heights
    P_SaveSectorPositions();
    // save dynaseg positions (or reset them to avoid shaking)
@@ -285,16 +497,24 @@ void P_Ticker()
    // Reset any interpolated scrolled sidedefs
    P_TicResetLerpScrolledSides();
    
-   P_ParticleThinker(); // haleyjd: think for particles
+   {
+      SimBenchScope profile(SIMBENCH_PARTICLES);
+      P_ParticleThinker(); // haleyjd: think for particles
+   }
 
    // VANILLA_HERETIC: it's critical to postpone S_RunSequences below
    if(!vanilla_heretic)
+   {
+      SimBenchScope profile(SIMBENCH_SNDSEQ);
       S_RunSequences(); // haleyjd 06/06/06
+   }
 
    // not if this is an intermission screen
    // haleyjd: players don't think during cinematic pauses
    if(gamestate == GS_LEVEL && !cinema_pause)
    {
+      SimBenchScope profile(SIMBENCH_PLAYERS);
+
       for(int i = 0; i < MAXPLAYERS; i++)
       {
          if(playeringame[i])
@@ -302,17 +522,36 @@ void P_Ticker()
       }
    }
 
-   Thinker::RunThinkers();
-   ACS_Exec();
-   P_UpdateSpecials();
+   {
+      SimBenchScope profile(SIMBENCH_THINKERS);
+      P_RunStaticScrollers();
+      Thinker::RunThinkers();
+   }
+   {
+      SimBenchScope profile(SIMBENCH_ACS);
+      ACS_Exec();
+   }
+   {
+      SimBenchScope profile(SIMBENCH_SPECIALS);
+      P_UpdateSpecials();
+   }
    if(vanilla_heretic)
+   {
+      SimBenchScope profile(SIMBENCH_SNDSEQ);
       S_RunSequences();
-   P_RespawnSpecials();
-   if(demo_version >= 329)
-      P_AnimateSurfaces(); // haleyjd 04/14/99
+   }
+   {
+      SimBenchScope profile(SIMBENCH_SPECIALS);
+      P_RespawnSpecials();
+      if(demo_version >= 329)
+         P_AnimateSurfaces(); // haleyjd 04/14/99
+   }
    
    leveltime++;                       // for par times
 
+   P_SyncMobjTable();
+
+   SimBenchScope profile(SIMBENCH_PARTICLES);
    P_RunEffects(); // haleyjd: run particle effects
 }
 
@@ -48,6 +48,11 @@ private:
    // Current position in list during RunThinkers
    static Thinker *currentthinker;
 
+   // Grouped execution
+   static void RunGroupedThinkers();
+   template<typename T> static size_t ThinkBatch(Thinker **things, size_t count);
+   static void ThinkProfiled(Thinker *th);
+
 protected:
    // Virtual methods (overridables)
    virtual void Think() {}
@@ -143,6 +148,8 @@ template<typename T> inline T thinker_cast(const Thinker *th)
 // Carries out all thinking of monsters and players.
 void P_Ticker(void);
 
+extern bool p_groupthinkers;
+
 extern Thinker thinkercap;  // Both the head and tail of the thinker list
 
 //
@@ -24,6 +24,7 @@
 //
 //-----------------------------------------------------------------------------
 
+#include <algorithm>
 #include "z_zone.h"
 
 #include "cam_sight.h"
@@ -886,11 +887,11 @@ void P_UseLines(player_t *player)
 
 // 1/11/98 killough: Intercept limit removed
 static intercept_t *intercepts, *intercept_p;
+static size_t num_intercepts;
 
 // Check for limit and double size if necessary -- killough
 static void check_intercept()
 {
-   static size_t num_intercepts;
    size_t offset = intercept_p - intercepts;
    if(offset >= num_intercepts)
    {
@@ -918,18 +919,19 @@ static bool PIT_AddLineIntercepts(line_t *ld, polyobj_t *po, void *context)
    int       s2;
    fixed_t   frac;
    divline_t dl;
+   const linehot_t &lh = linehot[ld - lines];
 
    // avoid precision problems with two routines
    if(trace.dl.dx >  FRACUNIT*16 || trace.dl.dy >  FRACUNIT*16 ||
       trace.dl.dx < -FRACUNIT*16 || trace.dl.dy < -FRACUNIT*16)
    {
-      s1 = P_PointOnDivlineSide(ld->v1->x, ld->v1->y, &trace.dl);
-      s2 = P_PointOnDivlineSide(ld->v2->x, ld->v2->y, &trace.dl);
+      s1 = P_PointOnDivlineSide(lh.x1, lh.y1, &trace.dl);
+      s2 = P_PointOnDivlineSide(lh.x2, lh.y2, &trace.dl);
    }
    else
    {
-      s1 = P_PointOnLineSide(trace.dl.x, trace.dl.y, ld);
-      s2 = P_PointOnLineSide(trace.dl.x+trace.dl.dx, trace.dl.y+trace.dl.dy, ld);
+      s1 = P_PointOnLineHotSide(trace.dl.x, trace.dl.y, lh);
+      s2 = P_PointOnLineHotSide(trace.dl.x+trace.dl.dx, trace.dl.y+trace.dl.dy, lh);
    }
 
    if(s1 == s2)
@@ -1039,6 +1041,52 @@ static bool P_TraverseIntercepts(traverser_t func, fixed_t maxfrac, void *contex
    return true;                  // everything was traversed
 }
 
+//
+// Sorts the intercepts once and walks them in order. A stable sort visits
+// exactly what the vanilla loop does, ties in the order they were added, but
+// a traverser that starts another trace reuses the vanilla buffer while it is
+// still being walked and so changes what the rest of the walk sees. This
+// detaches the sorted buffer for the duration instead, which is only safe to
+// use where no demo or peer expects the old behaviour.
+//
+static bool P_TraverseSortedIntercepts(traverser_t func, fixed_t maxfrac, void *context)
+{
+   intercept_t *const list = intercepts;
+   const size_t count = intercept_p - intercepts;
+   const size_t capacity = num_intercepts;
+   bool result = true;
+
+   std::stable_sort(list, list + count, [](const intercept_t &a, const intercept_t &b) {
+      return a.frac < b.frac;
+   });
+
+   // any trace started from a traverser gets a buffer of its own
+   intercepts = intercept_p = nullptr;
+   num_intercepts = 0;
+
+   for(size_t i = 0; i < count && list[i].frac <= maxfrac; i++)
+   {
+      if(!func(&list[i], context))
+      {
+         result = false; // don't bother going farther
+         break;
+      }
+   }
+
+   // keep whichever buffer is larger for the next trace
+   if(intercepts && num_intercepts > capacity)
+      efree(list);
+   else
+   {
+      efree(intercepts);
+      intercepts = list;
+      num_intercepts = capacity;
+   }
+   intercept_p = intercepts;
+
+   return result;
+}
+
 //
 // P_PathTraverse
 //
@@ -1164,6 +1212,8 @@ bool P_PathTraverse(fixed_t x1, fixed_t y1, fixed_t x2, fixed_t y2,
    }
 
    // go through the sorted list
+   if(!demoplayback && !demorecording && !netgame)
+      return P_TraverseSortedIntercepts(trav, FRACUNIT, context);
    return P_TraverseIntercepts(trav, FRACUNIT, context);
 }
 
@@ -41,6 +41,7 @@
 #include "m_compare.h"
 #include "m_collection.h"
 #include "m_queue.h"
+#include "p_enemy.h"
 #include "p_inter.h"
 #include "p_map.h"
 #include "p_maputl.h"
@@ -263,7 +264,7 @@ static void Polyobj_addLine(polyobj_t *po, line_t *l)
 static void Polyobj_findLines(polyobj_t *po, line_t *line)
 {
    int startx, starty;
-   int i;
+   int i, count;
 
    Polyobj_addLine(po, line);
 
@@ -271,11 +272,10 @@ static void Polyobj_findLines(polyobj_t *po, line_t *line)
    startx = line->v1->x;
    starty = line->v1->y;
 
-   // Loop around, starting a search through the lines array from scratch each
-   // time to find the next connecting linedef, until one of two things happens:
+   // Loop around, searching the lines touching the current line's end for
+   // the next connecting linedef, until one of two things happens:
    // A. We find a line that ends where the first line began.
-   // B. We search through the entire lines array and do not find a line to
-   //    continue the search process (this is an error condition).
+   // B. No line continues the search process (this is an error condition).
    do
    {
       // terminal case: we have reached a line where v2 is the same as v1 of the
@@ -283,19 +283,20 @@ static void Polyobj_findLines(polyobj_t *po, line_t *line)
       if(line->v2->x == startx && line->v2->y == starty)
          return;
       
-      // search the lines for one whose starting vertex is equal to the current
-      // line's ending vertex.
-      for(i = 0; i < numlines; ++i)
+      // find the first line whose starting vertex is equal to the current
+      // line's ending vertex; the list is in line order, like a full search.
+      line_t *const *touching = P_LinesAtVertex(line->v2, count);
+      for(i = 0; i < count; ++i)
       {
-         if(lines[i].v1->x == line->v2->x && lines[i].v1->y == line->v2->y)
+         if(touching[i]->v1->x == line->v2->x && touching[i]->v1->y == line->v2->y)
          {
-            Polyobj_addLine(po, &lines[i]); // add the new line
-            line = &lines[i];               // set new line as current line
+            line = touching[i];             // set new line as current line
+            Polyobj_addLine(po, line);      // add the new line
             break;                          // restart the search
          }
       }
    }
-   while(i < numlines); // if i >= numlines, an error has occured.
+   while(i < count); // if i >= count, an error has occured.
 
    // Error: if we reach here, the line search never found another line to
    // continue the loop, and thus the polyobject is open. This isn't allowed.
@@ -591,10 +592,13 @@ static void Polyobj_updateAnchoredPortals(const polyobj_t &po)
 }
 
 //
-// If linked portals exist, updats a line's portalmap position
+// If linked portals exist, updats a line's portalmap position. Also
+// refreshes the line's linehot row; every move and rotation ends up here.
 //
 static void Polyobj_relinkLine(const line_t &line)
 {
+   P_UpdateLineHot(line);
+
    if(line.portal && line.portal->type == R_LINKED && useportalgroups)
    {
       gPortalBlockmap.unlinkLine(line);
@@ -748,21 +752,19 @@ static void Polyobj_putLink(polymaplink_t *l)
 // bounding box intersects. This ensures the accurate level of clipping
 // which is present with linedefs but absent from most mobj interactions.
 //
-static void Polyobj_linkToBlockmap(polyobj_t *po)
+//
+// Polyobj_getBlockBox
+//
+// Finds the range of blockmap cells the polyobject's bounding box covers.
+//
+static void Polyobj_getBlockBox(const polyobj_t *po, fixed_t blockbox[4])
 {
-   fixed_t *blockbox = po->blockbox;
-   int i, x, y;
-   
-   // never link a bad polyobject or a polyobject already linked
-   if(po->flags & (POF_ISBAD | POF_LINKED))
-      return;
-   
    // 2/26/06: start line box with values of first vertex, not MININT/MAXINT
    blockbox[BOXLEFT]   = blockbox[BOXRIGHT] = po->vertices[0]->x;
    blockbox[BOXBOTTOM] = blockbox[BOXTOP]   = po->vertices[0]->y;
    
    // add all vertices to the bounding box
-   for(i = 1; i < po->numVertices; ++i)
+   for(int i = 1; i < po->numVertices; ++i)
       M_AddToBox(blockbox, po->vertices[i]->x, po->vertices[i]->y);
    
    // adjust bounding box relative to blockmap 
@@ -770,6 +772,18 @@ static void Polyobj_linkToBlockmap(polyobj_t *po)
    blockbox[BOXLEFT]   = (blockbox[BOXLEFT]   - bmaporgx) >> MAPBLOCKSHIFT;
    blockbox[BOXTOP]    = (blockbox[BOXTOP]    - bmaporgy) >> MAPBLOCKSHIFT;
    blockbox[BOXBOTTOM] = (blockbox[BOXBOTTOM] - bmaporgy) >> MAPBLOCKSHIFT;
+}
+
+static void Polyobj_linkToBlockmap(polyobj_t *po)
+{
+   fixed_t *blockbox = po->blockbox;
+   int x, y;
+   
+   // never link a bad polyobject or a polyobject already linked
+   if(po->flags & (POF_ISBAD | POF_LINKED))
+      return;
+   
+   Polyobj_getBlockBox(po, blockbox);
    
    // link polyobject to every block its bounding box intersects
    for(y = blockbox[BOXBOTTOM]; y <= blockbox[BOXTOP]; ++y)
@@ -826,6 +840,34 @@ static void Polyobj_removeFromBlockmap(polyobj_t *po)
    po->flags &= ~POF_LINKED;
 }
 
+//
+// Polyobj_relinkBlockmap
+//
+// Brings a moved polyobject's blockmap links up to date. Relinking puts the
+// polyobject at the head of every cell it covers, so when it still covers the
+// same cells and is already at the head of each, there is nothing to change.
+//
+static void Polyobj_relinkBlockmap(polyobj_t *po)
+{
+   if(po->flags & POF_LINKED)
+   {
+      fixed_t blockbox[4];
+      Polyobj_getBlockBox(po, blockbox);
+
+      bool unchanged = !memcmp(blockbox, po->blockbox, sizeof(blockbox));
+      const DLListItem<polymaplink_t> *const *first = polyblocklinks;
+      const DLListItem<polymaplink_t> *const *last  = polyblocklinks + bmapwidth * bmapheight;
+      for(const polymaplink_t *l = po->linkhead; l && unchanged; l = l->po_next)
+         unchanged = l->link.dllPrev >= first && l->link.dllPrev < last;
+
+      if(unchanged)
+         return;
+   }
+
+   Polyobj_removeFromBlockmap(po);
+   Polyobj_linkToBlockmap(po);
+}
+
 
 // Movement functions
 
@@ -1058,15 +1100,16 @@ static void Polyobj_moveObjectsInside(const polyobj_t &po, fixed_t dx, fixed_t d
 {
    if(!useportalgroups)
       return;
-   bool *groupvisit = ecalloc(bool *, P_PortalGroupCount(), sizeof(bool));
-   PODCollection<insideMobjMove_t> moved;
+   SmallPODCollection<bool, 64> groupvisit;
+   groupvisit.resize(P_PortalGroupCount()); // zero-filled
+   SmallPODCollection<insideMobjMove_t, 16> moved;
    for(size_t i = 0; i < po.numPortals; ++i)
    {
       const portal_t &portal = *po.portals[i];
       if(portal.type != R_LINKED || groupvisit[portal.data.link.toid])
          continue;
-      P_ForEachClusterGroup(portal.data.link.fromid, portal.data.link.toid, groupvisit,
-                            PolyobjIT_moveObjectsInside, &moved);
+      P_ForEachClusterGroup(portal.data.link.fromid, portal.data.link.toid,
+                            groupvisit.begin(), PolyobjIT_moveObjectsInside, &moved);
    }
    for(const insideMobjMove_t &imm : moved)
    {
@@ -1083,7 +1126,6 @@ static void Polyobj_moveObjectsInside(const polyobj_t &po, fixed_t dx, fixed_t d
       else
          imm.mobj->backupPosition();   // FIXME: do this until we can interpolate polys with portals
    }
-   efree(groupvisit);
 }
 
 //
@@ -1127,7 +1169,10 @@ static bool Polyobj_moveXY(polyobj_t *po, fixed_t x, fixed_t y, bool onload = fa
    if(po->flags & POF_ISBAD)
       return false;
 
-   PODCollection<portalthing_t> pts;
+   CAM_InvalidateSightCache();
+   P_InvalidateSoundFloods(nullptr);
+
+   SmallPODCollection<portalthing_t, 16> pts;
    if(po->numPortals)
       for(i = 0; i < po->numLines; ++i)
          if(po->lines[i]->pflags & PS_PASSABLE)
@@ -1191,14 +1236,12 @@ static bool Polyobj_moveXY(polyobj_t *po, fixed_t x, fixed_t y, bool onload = fa
          po->lines[i]->soundorg.y += vec.y;
       }
 
-      Polyobj_removeFromBlockmap(po); // unlink it from the blockmap
-      R_DetachPolyObject(po);
-      Polyobj_linkToBlockmap(po);     // relink to blockmap
+      Polyobj_relinkBlockmap(po);     // relink to blockmap
       v2fixed_t oldcentre = { po->centerPt.x, po->centerPt.y };
       Polyobj_setCenterPt(po);
       if(!onload)
          Polyobj_crossLines(po, oldcentre);
-      R_AttachPolyObject(po);
+      R_MovePolyObject(po, true);
 
       Polyobj_updateAnchoredPortals(*po);
 
@@ -1328,6 +1371,9 @@ static bool Polyobj_rotate(polyobj_t *po, angle_t delta, bool onload = false)
    if(po->flags & POF_ISBAD)
       return false;
 
+   CAM_InvalidateSightCache();
+   P_InvalidateSoundFloods(nullptr);
+
    angle = (po->angle + delta) >> ANGLETOFINESHIFT;
 
    // point about which to rotate is the spawn spot
@@ -1376,14 +1422,12 @@ static bool Polyobj_rotate(polyobj_t *po, angle_t delta, bool onload = false)
       // update polyobject's angle
       po->angle += delta;
 
-      Polyobj_removeFromBlockmap(po); // unlink it from the blockmap
-      R_DetachPolyObject(po);
-      Polyobj_linkToBlockmap(po);     // relink to blockmap
+      Polyobj_relinkBlockmap(po);     // relink to blockmap
       v2fixed_t oldcentre = { po->centerPt.x, po->centerPt.y };
       Polyobj_setCenterPt(po);
       if(!onload)
          Polyobj_crossLines(po, oldcentre);
-      R_AttachPolyObject(po);
+      R_MovePolyObject(po, false);
 
       Polyobj_updateAnchoredPortals(*po);
    }
@@ -42,6 +42,7 @@
 #include "r_dynseg.h"
 #include "r_dynabsp.h"
 #include "r_portal.h"
+#include "r_pvs.h"
 #include "r_segs.h"
 #include "r_sky.h"
 #include "r_state.h"
@@ -693,6 +694,65 @@ const sector_t *R_FakeFlat(const fixed_t viewz, const sector_t *sec, sector_t *t
    return sec;
 }
 
+//
+// A frame's memoized R_FakeFlat result. Lives in the frame arena, so its
+// address holds until the next reset.
+//
+struct fakeflat_t
+{
+   sector_t        tempsec;
+   const sector_t *result;
+   int             floorlightlevel, ceilinglightlevel;
+};
+
+//
+// R_FakeFlat for the BSP walk: the fake sector for each sector is built once
+// per frame for each side of its fake floor and ceiling the viewer can be on.
+// Sectors needing no copy are returned directly as before.
+//
+const sector_t *R_CachedFakeFlat(bspcontext_t &context, const fixed_t viewz,
+                                 const sector_t *sec, int *floorlightlevel,
+                                 int *ceilinglightlevel, bool back)
+{
+   if(!sec || (sec->heightsec == -1 && !sec->srf.floor.portal && !sec->srf.ceiling.portal))
+   {
+      // nothing to copy, so no temporary sector is touched
+      return R_FakeFlat(viewz, sec, nullptr, floorlightlevel, ceilinglightlevel, back);
+   }
+
+   // Mirror the viewer tests R_FakeFlat makes, so each key always builds
+   // the same copy. Front and back results are kept apart, as callers
+   // compare them by address.
+   int key = back ? 1 : 0;
+   if(sec->heightsec != -1)
+   {
+      const int heightsec = view.sector->heightsec;
+
+      if(heightsec != -1 && viewz <= sectors[heightsec].srf.floor.height)
+         key += 2;
+      else if(heightsec != -1 && viewz >= sectors[heightsec].srf.ceiling.height)
+         key += 4;
+   }
+
+   fakeflatslot_t &slot = context.fakeflats[(sec - sectors) * FAKEFLAT_KEYS + key];
+   if(slot.stamp != context.fakeflatstamp)
+   {
+      fakeflat_t *entry =
+         static_cast<fakeflat_t *>(R_FrameArenaAlloc(*context.arena, sizeof(fakeflat_t)));
+
+      entry->result = R_FakeFlat(viewz, sec, &entry->tempsec, &entry->floorlightlevel,
+                                 &entry->ceilinglightlevel, back);
+      slot.stamp = context.fakeflatstamp;
+      slot.entry = entry;
+   }
+
+   if(floorlightlevel)
+      *floorlightlevel = slot.entry->floorlightlevel;
+   if(ceilinglightlevel)
+      *ceilinglightlevel = slot.entry->ceilinglightlevel;
+   return slot.entry->result;
+}
+
 //
 // R_ClipSegToPortal
 //
@@ -1234,8 +1294,8 @@ static void R_2S_Sloped(cmapcontext_t &cmapcontext, planecontext_t &planecontext
    {
       float z1, z2, zstep;
 
-      z1 = P_GetZAtf(seg.backsec->srf.ceiling.slope, v1->fx, v1->fy);
-      z2 = P_GetZAtf(seg.backsec->srf.ceiling.slope, v2->fx, v2->fy);
+      z1 = seg.backsec->srf.ceiling.slope->getZAtf(v1->fx, v1->fy);
+      z2 = seg.backsec->srf.ceiling.slope->getZAtf(v2->fx, v2->fy);
       zstep = (z2 - z1) / seg.line->len;
 
       z1 += lclip1 * zstep;
@@ -1262,8 +1322,8 @@ static void R_2S_Sloped(cmapcontext_t &cmapcontext, planecontext_t &planecontext
    {
       float z1, z2, zstep;
 
-      z1 = P_GetZAtf(seg.backsec->srf.floor.slope, v1->fx, v1->fy);
-      z2 = P_GetZAtf(seg.backsec->srf.floor.slope, v2->fx, v2->fy);
+      z1 = seg.backsec->srf.floor.slope->getZAtf(v1->fx, v1->fy);
+      z2 = seg.backsec->srf.floor.slope->getZAtf(v2->fx, v2->fy);
       zstep = (z2 - z1) / seg.line->len;
 
       z1 += lclip1 * zstep;
@@ -2188,8 +2248,6 @@ static void R_addLine(bspcontext_t &bspcontext, cmapcontext_t &cmapcontext, plan
 {
    const portalrender_t &portalrender = portalcontext.portalrender;
 
-   sector_t tempsec;
-
    float x1, x2;
    float i1, i2, pstep;
    float lclip1, lclip2;
@@ -2198,8 +2256,6 @@ static void R_addLine(bspcontext_t &bspcontext, cmapcontext_t &cmapcontext, plan
    float floorx1, floorx2;
    const vertex_t *v1, *v2;
 
-   tempsec = {};
-
    // ioanch 20160125: reject segs in front of line when rendering line portal
    if(portalrender.active && portalrender.w->portal->type != R_SKYBOX)
    {
@@ -2226,7 +2282,7 @@ static void R_addLine(bspcontext_t &bspcontext, cmapcontext_t &cmapcontext, plan
    seg.clipsolid = false;
    seg.line = line;
 
-   seg.backsec = R_FakeFlat(viewpoint.z, line->backsector, &tempsec, nullptr, nullptr, true);
+   seg.backsec = R_CachedFakeFlat(bspcontext, viewpoint.z, line->backsector, nullptr, nullptr, true);
 
    // haleyjd: TEST
    // This seems to fix fiffy5, but smells like a hack to me.
@@ -2465,8 +2521,8 @@ static void R_addLine(bspcontext_t &bspcontext, cmapcontext_t &cmapcontext, plan
    {
       float z1, z2, zstep;
 
-      z1 = P_GetZAtf(seg.frontsec->srf.ceiling.slope, v1->fx, v1->fy);
-      z2 = P_GetZAtf(seg.frontsec->srf.ceiling.slope, v2->fx, v2->fy);
+      z1 = seg.frontsec->srf.ceiling.slope->getZAtf(v1->fx, v1->fy);
+      z2 = seg.frontsec->srf.ceiling.slope->getZAtf(v2->fx, v2->fy);
       zstep = (z2 - z1) / seg.line->len;
 
       z1 += lclip1 * zstep;
@@ -2489,8 +2545,8 @@ static void R_addLine(bspcontext_t &bspcontext, cmapcontext_t &cmapcontext, plan
    {
       float z1, z2, zstep;
 
-      z1 = P_GetZAtf(seg.frontsec->srf.floor.slope, v1->fx, v1->fy);
-      z2 = P_GetZAtf(seg.frontsec->srf.floor.slope, v2->fx, v2->fy);
+      z1 = seg.frontsec->srf.floor.slope->getZAtf(v1->fx, v1->fy);
+      z2 = seg.frontsec->srf.floor.slope->getZAtf(v2->fx, v2->fy);
       zstep = (z2 - z1) / seg.line->len;
 
       z1 += lclip1 * zstep;
@@ -2863,7 +2919,6 @@ static void R_subsector(rendercontext_t &context, const int num)
    int         count;
    const seg_t *line;
    subsector_t *sub;
-   sector_t    tempsec;              // killough 3/7/98: deep water hack
    int         floorlightlevel;      // killough 3/16/98: set floor lightlevel
    int         ceilinglightlevel;    // killough 4/11/98
    float       floorangle;           // haleyjd 01/05/08: plane angles
@@ -2900,8 +2955,8 @@ static void R_subsector(rendercontext_t &context, const int num)
    R_SectorColormap(cmapcontext, viewpoint.z, seg.frontsec);
 
    // killough 3/8/98, 4/4/98: Deep water / fake ceiling effect
-   seg.frontsec = R_FakeFlat(viewpoint. z, seg.frontsec, &tempsec,
-                             &floorlightlevel, &ceilinglightlevel, false);   // killough 4/11/98
+   seg.frontsec = R_CachedFakeFlat(bspcontext, viewpoint.z, seg.frontsec,
+                                   &floorlightlevel, &ceilinglightlevel, false);   // killough 4/11/98
 
    // ioanch: reject all sectors fully above or below a sector portal.
    if(portalrender.active && portalrender.w->portal->type != R_SKYBOX &&
@@ -3088,6 +3143,12 @@ static void R_subsector(rendercontext_t &context, const int num)
 //
 void R_RenderBSPNode(rendercontext_t &context, int bspnum)
 {
+   // Nothing below here can be seen from the main view's subsector. Portal
+   // views look from elsewhere, so are never culled.
+   const bool usepvs = r_pvsrow && !context.portalcontext.portalrender.active;
+   if(usepvs && !R_PVSChildVisible(bspnum))
+      return;
+
    while(!(bspnum & NF_SUBSECTOR))  // Found a subsector?
    {
       const node_t *bsp = &nodes[bspnum];
@@ -3099,8 +3160,11 @@ void R_RenderBSPNode(rendercontext_t &context, int bspnum)
       R_RenderBSPNode(context, bsp->children[side]);
 
       // Possibly divide back space.
+      side ^= 1;
+      if(usepvs && !R_PVSChildVisible(bsp->children[side]))
+         return;
       
-      if(!R_checkBBox(context.view, context.bounds, context.bspcontext.solidsegs, bsp->bbox[side^=1]))
+      if(!R_checkBBox(context.view, context.bounds, context.bspcontext.solidsegs, bsp->bbox[side]))
          return;
       
       bspnum = bsp->children[side];
@@ -26,34 +26,91 @@
 //
 
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
 #include <thread>
 
 #include "c_io.h"
 #include "c_runcmd.h"
 #include "doomstat.h"
+#include "m_compare.h"
 #include "m_misc.h"
 #include "hal/i_timer.h"
 #include "i_video.h"
 #include "r_context.h"
 #include "r_draw.h"
 #include "r_main.h"
+#include "r_profile.h"
+#include "r_segs.h"
 #include "r_state.h"
+#include "r_things.h"
 #include "v_misc.h"
 
+using renderclock_t = std::chrono::steady_clock;
+
+//
+// Wake-to-start latency statistics for a single context, in microseconds
+//
+struct contextstats_t
+{
+   int64_t  lastwake;
+   int64_t  maxwake;
+   int64_t  totalwake;
+   uint64_t numframes;
+   int64_t  rendertime; // time spent in R_RenderViewContext last frame
+   uint64_t numstrips;  // strips claimed in work-stealing mode
+};
+
 struct renderdata_t
 {
-   rendercontext_t  context;
-   std::thread      thread;
-   std::atomic_bool running;
-   std::atomic_bool shouldquit;
-   std::atomic_bool framewaiting;
-   std::atomic_bool framefinished;
+   rendercontext_t context;
+   std::thread     thread;
+   contextstats_t  stats;
+   float           colcost; // smoothed cost per column, used for rebalancing
 };
 
 static renderdata_t *renderdatas      = nullptr;
 static int           prev_numcontexts = 0;
 
-static bool          temp_dgafaboutyourcpu = true; // THREAD_FIXME: DELETE THIS
+//
+// Frame barrier shared by the main thread and all the context threads.
+// R_RunContexts bumps framenum and wakes every worker through framestart, then
+// sleeps on framefinish until contextsleft drops to zero. Workers sleep on
+// framestart between frames so idle contexts use no CPU.
+//
+static std::mutex              r_framelock;
+static std::condition_variable r_framestart;
+static std::condition_variable r_framefinish;
+static unsigned int            r_framenum;
+static int                     r_contextsleft;
+static bool                    r_shouldquit;
+static renderclock_t::time_point r_kicktime;
+
+// Work-stealing strip queue: the next unclaimed strip of the current frame.
+// Only valid while r_framestripwidth is non-zero.
+static std::atomic_int r_nextstrip;
+static int             r_framestripwidth;
+static int             r_framenumstrips;
+
+// Width in columns of work-stealing strips; 0 renders one slab per context
+static int r_stripwidth = 0;
+
+// Rebalance context column bounds each frame from measured render times
+static bool r_contextbalance = true;
+
+// Width of the strips used for frames dominated by portals; 0 disables
+static int r_portalstripwidth = 32;
+
+// A context with more than this multiple of the average portal columns is
+// doing portal work alone
+static constexpr int PORTAL_IMBALANCE = 2;
+
+// Weight of the most recent frame when smoothing per-column cost
+static constexpr float BALANCE_SMOOTHING = 0.25f;
+// No context may shrink below or grow beyond these multiples of an even split
+static constexpr float BALANCE_MINSHARE  = 0.25f;
+static constexpr float BALANCE_MAXSHARE  = 4.0f;
 
 //
 // Grabs a given render context
@@ -63,6 +120,119 @@ rendercontext_t &R_GetContext(int index)
    return renderdatas[index].context;
 }
 
+//=============================================================================
+//
+// Frame arenas
+//
+
+// Header of a heap block holding an allocation that didn't fit the arena
+struct rframespill_t
+{
+   rframespill_t *next;
+   size_t         size;
+};
+
+//
+// Bump-allocates from the arena, or from the heap once it is full.
+//
+void *R_FrameArenaAlloc(rframearena_t &arena, size_t bytes)
+{
+   bytes = R_FrameArenaBytes(bytes);
+
+   if(arena.used + bytes <= arena.size)
+   {
+      void *result = arena.base + arena.used;
+      arena.used += bytes;
+      return result;
+   }
+
+   // the header is a multiple of the alignment on common targets
+   auto spill = static_cast<rframespill_t *>(emalloc(void *, sizeof(rframespill_t) + bytes));
+   spill->next   = arena.spills;
+   spill->size   = bytes;
+   arena.spills  = spill;
+   arena.spilled += bytes;
+   arena.heapcalls++;
+   return spill + 1;
+}
+
+void *R_FrameArenaGrowBytes(rframearena_t &arena, const void *old, size_t oldbytes,
+                            size_t newbytes)
+{
+   void *result = R_FrameArenaAlloc(arena, newbytes);
+   if(old && oldbytes)
+      memcpy(result, old, oldbytes);
+   return result;
+}
+
+//
+// Starts a context's frame: frees last frame's spills, enlarges the block if
+// they were needed, and carves every per-frame array at its capacity.
+//
+void R_ResetFrameArena(rendercontext_t &context)
+{
+   rframearena_t   &arena  = context.arena;
+   bspcontext_t    &bsp    = context.bspcontext;
+   spritecontext_t &sprite = context.spritecontext;
+
+   bsp.arena    = &arena;
+   sprite.arena = &arena;
+
+   // entries from the last frame are about to be carved over
+   if(!++bsp.fakeflatstamp)
+   {
+      if(bsp.fakeflats)
+         memset(bsp.fakeflats, 0, sizeof(fakeflatslot_t) * numsectors * FAKEFLAT_KEYS);
+      bsp.fakeflatstamp = 1;
+   }
+
+   arena.lastframe = arena.used + arena.spilled;
+   arena.peak      = emax(arena.peak, arena.lastframe);
+
+   while(arena.spills)
+   {
+      rframespill_t *next = arena.spills->next;
+      efree(arena.spills);
+      arena.spills = next;
+   }
+
+   const size_t need = R_FrameArenaBytes(bsp.maxdrawsegs * sizeof(drawseg_t)) +
+                       R_SpriteFrameArenaBytes(sprite);
+
+   if(need > arena.size)
+   {
+      if(arena.base)
+         efree(arena.base);
+      arena.size = R_FrameArenaBytes(need + need / 4);
+      arena.base = emalloc(byte *, arena.size);
+      arena.heapcalls++;
+   }
+
+   arena.used    = 0;
+   arena.spilled = 0;
+
+   bsp.drawsegs = R_FrameArenaArray<drawseg_t>(arena, bsp.maxdrawsegs);
+   bsp.ds_p     = bsp.drawsegs;
+
+   R_CarveSpriteFrameArrays(sprite);
+}
+
+//
+// Releases an arena and everything carved from it.
+//
+static void R_freeFrameArena(rframearena_t &arena)
+{
+   while(arena.spills)
+   {
+      rframespill_t *next = arena.spills->next;
+      efree(arena.spills);
+      arena.spills = next;
+   }
+   if(arena.base)
+      efree(arena.base);
+   arena = {};
+}
+
 //
 // Frees up the dynamically allocated members of a context that aren't tagged PU_VALLOC
 // Also tidies up threads of that context's data
@@ -70,27 +240,33 @@ rendercontext_t &R_GetContext(int index)
 void R_freeContext(rendercontext_t &context)
 {
    // THREAD_FIXME: Verify this catches everything
-   if(context.spritecontext.drawsegs_xrange)
-      efree(context.spritecontext.drawsegs_xrange);
-   if(context.spritecontext.vissprites)
-      efree(context.spritecontext.vissprites);
-   if(context.spritecontext.vissprite_ptrs)
-      efree(context.spritecontext.vissprite_ptrs);
+   R_freeFrameArena(context.arena);
    if(context.spritecontext.sectorvisited)
       efree(context.spritecontext.sectorvisited);
+   if(context.bspcontext.fakeflats)
+      efree(context.bspcontext.fakeflats);
 }
 
 //
-// Frees up actual renderdatas, which need waiting on before we can safely free
+// Allocates a context's per-sector data for the current level
 //
-void R_freeData(renderdata_t &data)
+static void R_allocContextLevelData(rendercontext_t &context)
 {
-   data.shouldquit.store(true);
+   context.spritecontext.sectorvisited = ecalloctag(bool *, numsectors, sizeof(bool), PU_LEVEL, nullptr);
+   context.bspcontext.fakeflats = ecalloctag(fakeflatslot_t *, numsectors * FAKEFLAT_KEYS,
+                                             sizeof(fakeflatslot_t), PU_LEVEL, nullptr);
+}
 
-   while(data.running.load())
-      i_haltimer.Sleep(1);
+//
+// Frees up actual renderdatas, which need their threads joined before we can safely free
+//
+void R_freeData(renderdata_t &data)
+{
+   if(data.thread.joinable())
+      data.thread.join();
 
    R_freeContext(data.context);
+   data.~renderdata_t();
 }
 
 void R_FreeContexts()
@@ -99,36 +275,186 @@ void R_FreeContexts()
 
    if(renderdatas)
    {
+      {
+         std::lock_guard<std::mutex> lock(r_framelock);
+         r_shouldquit = true;
+      }
+      r_framestart.notify_all();
+
       for(int currentcontext = 0; currentcontext < prev_numcontexts; currentcontext++)
          R_freeData(renderdatas[currentcontext]);
       efree(renderdatas);
+      renderdatas = nullptr;
    }
 }
 
+//
+// Sets a context's bounds from floating-point start and end columns
+//
+static void R_setContextBounds(contextbounds_t &bounds, float fstart, float fend)
+{
+   bounds.fstartcolumn = fstart;
+   bounds.fendcolumn   = fend;
+   bounds.startcolumn  = int(roundf(fstart));
+   bounds.endcolumn    = int(roundf(fend));
+   bounds.numcolumns   = bounds.endcolumn - bounds.startcolumn;
+}
+
+//
+// Work-stealing strip mode: claims narrow column strips off the shared strip
+// counter and renders each one in turn with this context's state, until
+// every strip of the frame has been taken. Each strip gets its own visit ID
+// so sector barriers are re-evaluated for it.
+//
+static void R_renderContextStrips(renderdata_t *data, const int stripwidth, const int numstrips)
+{
+   rendercontext_t &context = data->context;
+   const int16_t   bufferindex = context.bufferindex;
+   const int       width = viewwindow.width;
+
+   int strip;
+   while((strip = r_nextstrip.fetch_add(1, std::memory_order_relaxed)) < numstrips)
+   {
+      const int startcolumn = strip * stripwidth;
+      const int endcolumn   = emin(startcolumn + stripwidth, width);
+
+      R_setContextBounds(context.bounds, float(startcolumn), float(endcolumn));
+      context.bufferindex = int16_t(strip);
+      R_RenderViewContext(context);
+      data->stats.numstrips++;
+   }
+
+   context.bufferindex = bufferindex;
+}
+
 //
 // This function is always going on in the background
 // so that threads don't need to constantly be spawned
 //
 static void R_contextThreadFunc(renderdata_t *data)
 {
-   data->running.exchange(true);
+   unsigned int lastframe = 0;
 
-   while(!data->shouldquit.load())
+   R_ProfileSetThreadSlot(int(data - renderdatas));
+
+   for(;;)
    {
-      if(data->framewaiting.exchange(false))
+      renderclock_t::time_point kicktime;
+      int stripwidth, numstrips;
+
       {
-         R_RenderViewContext(data->context);
-         data->framefinished.store(true);
-         // THREAD_TODO: Wait here an appropriate amount of time once FPS limiting is in
+         std::unique_lock<std::mutex> lock(r_framelock);
+         r_framestart.wait(lock, [&lastframe] { return r_shouldquit || r_framenum != lastframe; });
+
+         if(r_shouldquit)
+            break;
+
+         lastframe  = r_framenum;
+         kicktime   = r_kicktime;
+         stripwidth = r_framestripwidth;
+         numstrips  = r_framenumstrips;
       }
 
-      if(temp_dgafaboutyourcpu)
-         std::this_thread::yield(); // I YIELD MY TIME, FUCK YOU!
+      const int64_t wake = std::chrono::duration_cast<std::chrono::microseconds>(
+         renderclock_t::now() - kicktime
+      ).count();
+
+      contextstats_t &stats = data->stats;
+      stats.lastwake   = wake;
+      stats.maxwake    = emax(stats.maxwake, wake);
+      stats.totalwake += wake;
+      stats.numframes++;
+
+      const renderclock_t::time_point start = renderclock_t::now();
+      data->context.portalcontext.windowcolumns = 0;
+      if(stripwidth)
+         R_renderContextStrips(data, stripwidth, numstrips);
       else
-         i_haltimer.Sleep(1);
+         R_RenderViewContext(data->context);
+      stats.rendertime = std::chrono::duration_cast<std::chrono::microseconds>(
+         renderclock_t::now() - start
+      ).count();
+
+      bool lastcontext;
+      {
+         std::lock_guard<std::mutex> lock(r_framelock);
+         lastcontext = --r_contextsleft == 0;
+      }
+      if(lastcontext)
+         r_framefinish.notify_one();
    }
+}
 
-   data->running.exchange(false);
+//
+// Splits width evenly between all contexts and forgets any measured costs
+//
+static void R_evenContextBounds(const int width)
+{
+   const float contextwidth = float(width) / float(r_numcontexts);
+
+   for(int currentcontext = 0; currentcontext < r_numcontexts; currentcontext++)
+   {
+      R_setContextBounds(
+         renderdatas[currentcontext].context.bounds,
+         float(currentcontext) * contextwidth, float(currentcontext + 1) * contextwidth
+      );
+      renderdatas[currentcontext].colcost = 0.0f;
+   }
+}
+
+//
+// Relative share of the screen a context should get; a context that measured
+// no time at all is treated as very cheap
+//
+static inline float R_contextWeight(const renderdata_t &data)
+{
+   return 1.0f / emax(data.colcost, 0.001f);
+}
+
+//
+// Moves the column boundaries between contexts so that each one is expected
+// to take the same time, based on its smoothed per-column cost from previous
+// frames. Widths are clamped so no context is ever starved or overloaded.
+//
+static void R_balanceContextBounds()
+{
+   const float width     = float(viewwindow.width);
+   const float evenwidth = width / float(r_numcontexts);
+   const float minwidth  = emax(evenwidth * BALANCE_MINSHARE, 1.0f);
+   const float maxwidth  = emin(evenwidth * BALANCE_MAXSHARE, width);
+
+   float totalweight = 0.0f;
+
+   for(int currentcontext = 0; currentcontext < r_numcontexts; currentcontext++)
+   {
+      renderdata_t &data = renderdatas[currentcontext];
+      const int numcolumns = data.context.bounds.numcolumns;
+
+      if(numcolumns > 0)
+      {
+         const float cost = float(data.stats.rendertime) / float(numcolumns);
+         if(data.colcost <= 0.0f)
+            data.colcost = cost;
+         else
+            data.colcost += (cost - data.colcost) * BALANCE_SMOOTHING;
+      }
+
+      totalweight += R_contextWeight(data);
+   }
+
+   float start = 0.0f;
+   for(int currentcontext = 0; currentcontext < r_numcontexts; currentcontext++)
+   {
+      float share = width * R_contextWeight(renderdatas[currentcontext]) / totalweight;
+      share = eclamp(share, minwidth, maxwidth);
+
+      // Leave at least the minimum for every context still to come
+      const float remaining = width - start - minwidth * float(r_numcontexts - currentcontext - 1);
+      float end = currentcontext == r_numcontexts - 1 ? width : start + emin(share, remaining);
+
+      R_setContextBounds(renderdatas[currentcontext].context.bounds, start, end);
+      start = end;
+   }
 }
 
 //
@@ -151,12 +477,18 @@ void R_InitContexts(const int width)
       r_globalcontext.portalcontext.portalrender = { false, MAX_SCREENWIDTH, 0 };
 
       if(numsectors && gamestate == GS_LEVEL)
-         r_globalcontext.spritecontext.sectorvisited = ecalloctag(bool *, numsectors, sizeof(bool), PU_LEVEL, nullptr);
+         R_allocContextLevelData(r_globalcontext);
 
       return;
    }
 
    renderdatas = estructalloc(renderdata_t, r_numcontexts);
+   for(int currentcontext = 0; currentcontext < r_numcontexts; currentcontext++)
+      ::new(&renderdatas[currentcontext]) renderdata_t();
+
+   r_shouldquit   = false;
+   r_framenum     = 0;
+   r_contextsleft = 0;
 
    const float contextwidth = float(width) / float(r_numcontexts);
 
@@ -166,20 +498,15 @@ void R_InitContexts(const int width)
 
       context.bufferindex = currentcontext;
 
-      context.bounds.fstartcolumn = float(currentcontext)     * contextwidth;
-      context.bounds.fendcolumn   = float(currentcontext + 1) * contextwidth;
-      context.bounds.startcolumn  = int(roundf(context.bounds.fstartcolumn));
-      context.bounds.endcolumn    = int(roundf(context.bounds.fendcolumn));
-      context.bounds.numcolumns   = context.bounds.endcolumn - context.bounds.startcolumn;
+      R_setContextBounds(
+         context.bounds, float(currentcontext) * contextwidth, float(currentcontext + 1) * contextwidth
+      );
 
       context.portalcontext.portalrender = { false, MAX_SCREENWIDTH, 0 };
 
       if(numsectors && gamestate == GS_LEVEL)
-         context.spritecontext.sectorvisited = ecalloctag(bool *, numsectors, sizeof(bool), PU_LEVEL, nullptr);
+         R_allocContextLevelData(context);
 
-      // Wait until this context's thread is done running before creating a new one
-      while(renderdatas[currentcontext].running.load())
-         i_haltimer.Sleep(1);
       renderdatas[currentcontext].thread = std::thread(&R_contextThreadFunc, &renderdatas[currentcontext]);
    }
 }
@@ -188,7 +515,7 @@ void R_RefreshContexts()
 {
    if(r_numcontexts == 1)
    {
-      r_globalcontext.spritecontext.sectorvisited = ecalloctag(bool *, numsectors, sizeof(bool), PU_LEVEL, nullptr);
+      R_allocContextLevelData(r_globalcontext);
       return;
    }
 
@@ -196,7 +523,7 @@ void R_RefreshContexts()
    {
       rendercontext_t &context = renderdatas[currentcontext].context;
 
-      context.spritecontext.sectorvisited = ecalloctag(bool *, numsectors, sizeof(bool), PU_LEVEL, nullptr);
+      R_allocContextLevelData(context);
    }
 }
 
@@ -204,52 +531,160 @@ void R_UpdateContextBounds()
 {
    if(r_numcontexts == 1)
    {
-      r_globalcontext.bounds.startcolumn   = 0;
-      r_globalcontext.bounds.endcolumn     = viewwindow.width;
-      r_globalcontext.bounds.fstartcolumn = 0.0f;
-      r_globalcontext.bounds.fendcolumn   = float(viewwindow.width);
+      R_setContextBounds(r_globalcontext.bounds, 0.0f, float(viewwindow.width));
       return;
    }
 
-   const float contextwidth = float(viewwindow.width) / float(r_numcontexts);
+   R_evenContextBounds(viewwindow.width);
+}
+
+//
+// Decides from the last frame whether portal windows are concentrated in a
+// few contexts. A skybox or linked portal covering one context's slab leaves
+// it rendering the whole portal alone; strips let every context claim a share
+// of it instead. Once in strips, they stay while portals cover a good part of
+// the view, as the per-context split no longer says where they would land.
+//
+static bool R_portalsNeedStrips()
+{
+   if(!r_portalstripwidth)
+      return false;
+
+   int total = 0, busiest = 0;
    for(int currentcontext = 0; currentcontext < r_numcontexts; currentcontext++)
    {
-      rendercontext_t &context = renderdatas[currentcontext].context;
-
-      context.bounds.fstartcolumn = float(currentcontext)     * contextwidth;
-      context.bounds.fendcolumn   = float(currentcontext + 1) * contextwidth;
-      context.bounds.startcolumn  = int(roundf(context.bounds.fstartcolumn));
-      context.bounds.endcolumn    = int(roundf(context.bounds.fendcolumn));
-      context.bounds.numcolumns   = context.bounds.endcolumn - context.bounds.startcolumn;
+      const int columns = renderdatas[currentcontext].context.portalcontext.windowcolumns;
+      total  += columns;
+      busiest = emax(busiest, columns);
    }
+
+   if(total < viewwindow.width / 4)
+      return false;
+
+   return r_framestripwidth || busiest * r_numcontexts > total * PORTAL_IMBALANCE;
 }
 
 //
-// Runs all the contexts by setting the waiting-for-frame atomics bool to true,
-// then waits for the frame-finished-rendering atomic bools to be true
-// (setting them to false after)
+// Runs all the contexts by bumping the frame number and waking every context
+// thread, then sleeps until the last context to finish signals the main thread
 //
 void R_RunContexts()
 {
-   int finishedcontexts = 0;
+   int stripwidth = emin(r_stripwidth, viewwindow.width);
 
-   for(int currentcontext = 0; currentcontext < r_numcontexts; currentcontext++)
-      renderdatas[currentcontext].framewaiting.store(true);
+   if(!stripwidth && R_portalsNeedStrips())
+      stripwidth = emin(r_portalstripwidth, viewwindow.width);
 
-   while(finishedcontexts != r_numcontexts)
+   if(stripwidth)
+      r_nextstrip.store(0, std::memory_order_relaxed);
+   else if(r_framestripwidth)
+      R_UpdateContextBounds(); // leaving strip mode; restore the slabs
+   else if(r_contextbalance)
+      R_balanceContextBounds();
+
+   {
+      std::lock_guard<std::mutex> lock(r_framelock);
+      r_framestripwidth = stripwidth;
+      r_framenumstrips  = stripwidth ? (viewwindow.width + stripwidth - 1) / stripwidth : 0;
+      r_contextsleft    = r_numcontexts;
+      r_kicktime        = renderclock_t::now();
+      r_framenum++;
+   }
+   r_framestart.notify_all();
+
+   std::unique_lock<std::mutex> lock(r_framelock);
+   r_framefinish.wait(lock, [] { return r_contextsleft == 0; });
+}
+
+//
+// Prints out wake-to-start latency for each context thread
+//
+CONSOLE_COMMAND(r_contextstats, 0)
+{
+   if(r_numcontexts == 1 || !renderdatas)
+   {
+      C_Printf("Rendering is single-threaded; no context statistics.\n");
+      return;
+   }
+
+   if(Console.argc >= 1 && !Console.argv[0]->strCaseCmp("reset"))
    {
       for(int currentcontext = 0; currentcontext < r_numcontexts; currentcontext++)
+         renderdatas[currentcontext].stats = {};
+      C_Printf("Render context statistics reset.\n");
+      return;
+   }
+
+   C_Printf(FC_HI "Context columns, render time and wake-to-start latency (us):\n" FC_NORMAL);
+   for(int currentcontext = 0; currentcontext < r_numcontexts; currentcontext++)
+   {
+      const contextstats_t &stats = renderdatas[currentcontext].stats;
+      const int64_t avg = stats.numframes ? stats.totalwake / int64_t(stats.numframes) : 0;
+
+      const contextbounds_t &bounds = renderdatas[currentcontext].context.bounds;
+
+      if(r_framestripwidth)
+         C_Printf("%2d: strips %llu ", currentcontext, static_cast<unsigned long long>(stats.numstrips));
+      else
+         C_Printf("%2d: cols %4d-%4d ", currentcontext, bounds.startcolumn, bounds.endcolumn - 1);
+
+      C_Printf("render %6lld wake last %6lld avg %6lld max %6lld (%llu frames)\n",
+               static_cast<long long>(stats.rendertime), static_cast<long long>(stats.lastwake), static_cast<long long>(avg),
+               static_cast<long long>(stats.maxwake),
+               static_cast<unsigned long long>(stats.numframes));
+   }
+}
+
+//
+// Prints out each context's frame arena usage
+//
+CONSOLE_COMMAND(r_arenastats, 0)
+{
+   const bool reset = Console.argc >= 1 && !Console.argv[0]->strCaseCmp("reset");
+   int        index = -1;
+
+   if(!reset)
+      C_Printf(FC_HI "Context frame arena size, last frame, peak (KiB) and heap calls:\n" FC_NORMAL);
+
+   R_ForEachContext([reset, &index](rendercontext_t &context) {
+      rframearena_t &arena = context.arena;
+
+      if(reset)
       {
-         if(renderdatas[currentcontext].framefinished.exchange(false))
-            finishedcontexts++;
+         arena.peak      = 0;
+         arena.heapcalls = 0;
       }
-   }
+      else if(index < 0)
+      {
+         C_Printf("main: size %6zu last %6zu peak %6zu heap %u\n", arena.size / 1024,
+                  arena.lastframe / 1024, arena.peak / 1024, arena.heapcalls);
+      }
+      else
+      {
+         C_Printf("%4d: size %6zu last %6zu peak %6zu heap %u\n", index, arena.size / 1024,
+                  arena.lastframe / 1024, arena.peak / 1024, arena.heapcalls);
+      }
+      ++index;
+   });
+
+   if(reset)
+      C_Printf("Frame arena statistics reset.\n");
 }
 
-#if 0
-VARIABLE_BOOLEAN(temp_dgafaboutyourcpu, nullptr, yesno);
-CONSOLE_VARIABLE(r_gofast, temp_dgafaboutyourcpu, cf_buffered) {}
+VARIABLE_TOGGLE(r_contextbalance, nullptr, onoff);
+CONSOLE_VARIABLE(r_contextbalance, r_contextbalance, 0)
+{
+   if(!r_contextbalance && renderdatas)
+      R_UpdateContextBounds();
+}
+
+VARIABLE_INT(r_stripwidth, nullptr, 0, 1024, nullptr);
+CONSOLE_VARIABLE(r_stripwidth, r_stripwidth, 0) {}
 
+VARIABLE_INT(r_portalstripwidth, nullptr, 0, 1024, nullptr);
+CONSOLE_VARIABLE(r_portalstripwidth, r_portalstripwidth, 0) {}
+
+#if 0
 VARIABLE_INT(r_numcontexts, nullptr, 0, UL, nullptr);
 CONSOLE_VARIABLE(r_numcontexts, r_numcontexts, cf_buffered)
 {
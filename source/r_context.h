@@ -35,6 +35,7 @@
 struct cliprange_t;
 struct drawseg_t;
 struct drawsegs_xrange_t;
+struct fakeflat_t;
 struct maskedrange_t;
 struct poststack_t;
 struct pwindow_t;
@@ -47,8 +48,75 @@ struct contextbounds_t
    int   numcolumns; // cached endcolumn - startcolumn
 };
 
+//
+// Storage for a context's per-frame arrays. At the start of every rendered
+// view each array is carved from one block at the capacity it reached in
+// earlier frames. Growth past the block spills to the heap, and the next
+// reset enlarges the block to fit, so after warmup a frame allocates nothing.
+//
+struct rframespill_t;
+
+struct rframearena_t
+{
+   byte          *base;
+   size_t         size;      // bytes in base
+   size_t         used;      // bytes carved from base this frame
+   size_t         spilled;   // bytes spilled to the heap this frame
+   size_t         lastframe; // bytes carved and spilled by the last frame
+   size_t         peak;      // most bytes carved and spilled by one frame
+   rframespill_t *spills;    // this frame's heap blocks
+   unsigned int   heapcalls; // heap allocations made for base and spills
+};
+
+// Arena allocations are rounded to this, which also aligns every array
+static constexpr size_t FRAMEARENA_ALIGN = 16;
+
+inline size_t R_FrameArenaBytes(size_t bytes)
+{
+   return (bytes + FRAMEARENA_ALIGN - 1) & ~(FRAMEARENA_ALIGN - 1);
+}
+
+void *R_FrameArenaAlloc(rframearena_t &arena, size_t bytes);
+void *R_FrameArenaGrowBytes(rframearena_t &arena, const void *old, size_t oldbytes,
+                            size_t newbytes);
+
+//
+// Moves an array into a larger one carved from the arena, keeping its
+// contents. The old storage is reclaimed at the next reset.
+//
+template<typename T>
+inline T *R_FrameArenaGrow(rframearena_t &arena, T *old, size_t oldcount, size_t newcount)
+{
+   return static_cast<T *>(R_FrameArenaGrowBytes(arena, old, oldcount * sizeof(T),
+                                                 newcount * sizeof(T)));
+}
+
+//
+// Carves an array of count elements, or returns nullptr for none.
+//
+template<typename T>
+inline T *R_FrameArenaArray(rframearena_t &arena, size_t count)
+{
+   return count ? static_cast<T *>(R_FrameArenaAlloc(arena, count * sizeof(T))) : nullptr;
+}
+
+// R_CachedFakeFlat results are kept per sector for each way the viewer and
+// the line can face its fake floor, and are valid for one frame's stamp
+#define FAKEFLAT_KEYS 6
+
+struct fakeflatslot_t
+{
+   unsigned int  stamp;
+   fakeflat_t   *entry;
+};
+
 struct bspcontext_t
 {
+   rframearena_t *arena;
+
+   fakeflatslot_t *fakeflats;     // numsectors * FAKEFLAT_KEYS, PU_LEVEL
+   unsigned int    fakeflatstamp; // bumped by each frame arena reset
+
    drawseg_t   *drawsegs;
    unsigned int maxdrawsegs;
    drawseg_t   *ds_p;
@@ -78,12 +146,12 @@ struct cmapcontext_t
 struct planecontext_t
 {
    visplane_t  *floorplane, *ceilingplane;
-   visplane_t  *freetail;
-   visplane_t **freehead;
+
+   // Storage for every visplane drawn this frame
+   visplanearena_t arena;
 
    // SoM: New visplane hash
    // This is the main hash object used by the normal scene.
-   visplane_t **mainchains;
    planehash_t  mainhash;
 
    // Free list of overlay portals. Used by portal windows and the post-BSP stack.
@@ -111,16 +179,30 @@ struct portalcontext_t
    // in portals.
 
    portalrender_t portalrender;
+
+   // Columns covered by portal windows rendered since the context last started
+   // a frame, a cheap measure of how much of its work is portals
+   int windowcolumns;
 };
 
 struct spritecontext_t
 {
+   rframearena_t *arena;
+
    // haleyjd 04/25/10: drawsegs optimization
    drawsegs_xrange_t *drawsegs_xrange;
    unsigned int       drawsegs_xrange_size;
    int                drawsegs_xrange_count;
 
+   // drawsegs_xrange indices by column bucket, and where each bucket starts
+   int               *drawsegs_buckets;
+   unsigned int       drawsegs_buckets_size;
+   int               *drawsegs_bucketstart;
+   int                drawsegs_bucketsalloc;
+   int                drawsegs_numbuckets;
+
    vissprite_t *vissprites, **vissprite_ptrs;  // killough
+   uint32_t    *vissprite_keys; // sort keys, sized as vissprite_ptrs
    size_t num_vissprite, num_vissprite_alloc, num_vissprite_ptrs;
 
    // SoM 12/13/03: the post-BSP stack
@@ -130,6 +212,11 @@ struct spritecontext_t
    maskedrange_t *unusedmasked;
 
    bool *sectorvisited;
+
+   // one sector's particles while they are projected, as structure of arrays
+   particle_t **particle_list;
+   float       *particle_x, *particle_y; // positions, then rotated in place
+   unsigned int particle_alloc;
 };
 
 struct viewpoint_t
@@ -160,6 +247,8 @@ struct rendercontext_t
    contextbounds_t bounds;
    viewpoint_t     view;
    cbviewpoint_t   cb_view;
+
+   rframearena_t   arena;
 };
 
 // The global context is for single-threaded things that still require a context
@@ -175,6 +264,7 @@ void R_InitContexts(const int width);
 void R_RefreshContexts();
 void R_UpdateContextBounds();
 void R_RunContexts();
+void R_ResetFrameArena(rendercontext_t &context);
 
 template<typename F>
 void R_ForEachContext(F &&f)
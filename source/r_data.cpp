@@ -41,8 +41,11 @@
 #include "r_defs.h"
 #include "r_main.h"
 #include "r_patch.h"
+#include "r_ripple.h"
 #include "r_sky.h"
 #include "r_state.h"
+#include "r_tblcache.h"
+#include "r_things.h"
 #include "v_misc.h"
 #include "v_patchfmt.h"
 #include "v_video.h"
@@ -70,6 +73,7 @@ void R_InitTextures();
 // killough 4/17/98: make firstcolormaplump,lastcolormaplump external
 int         firstcolormaplump; // killough 4/17/98
 int         firstspritelump, lastspritelump, numspritelumps;
+unsigned    r_datagen;
 
 // needed for pre-rendering
 fixed_t     *spritewidth, *spriteoffset, *spritetopoffset;
@@ -77,6 +81,7 @@ fixed_t     *spritewidth, *spriteoffset, *spritetopoffset;
 float       *spriteheight;
 // ioanch: portal sprite copying cache info
 spritespan_t **r_spritespan;
+float          r_maxspriteside;
 
 //
 // R_InitSpriteLumps
@@ -121,54 +126,50 @@ static void R_InitSpriteLumps(void)
 }
 
 //
-// Init height cache for rendering across sector portals
+// How far a sprite lump reaches out sideways from its origin
 //
-void R_InitSpriteProjSpan()
+float R_SpriteLumpSide(int lump)
 {
-   r_spritespan = emalloctag(decltype(r_spritespan),
-                              numsprites * sizeof(*r_spritespan), PU_RENDERER,
-                              nullptr);
-   for(int i = 0; i < numsprites; ++i)
+   return M_FixedToFloat(emax(spritewidth[lump] - spriteoffset[lump],
+                              spriteoffset[lump]));
+}
+
+//
+// Works out a sprite's height cache for rendering across sector portals, one
+// span for each of its frames.
+//
+void R_InitSpriteProjSpan(const spritedef_t &sprite, spritespan_t *spans)
+{
+   for(int j = 0; j < sprite.numframes; ++j)
    {
-      const spritedef_t &sprite = sprites[i];
-      r_spritespan[i] = emalloctag(spritespan_t *,
-                                    sprite.numframes * sizeof(**r_spritespan),
-                                    PU_RENDERER, nullptr);
-      for(int j = 0; j < sprite.numframes; ++j)
+      const spriteframe_t &frame = sprite.spriteframes[j];
+      spritespan_t &span = spans[j];
+      if(frame.rotate)
       {
-         const spriteframe_t &frame = sprite.spriteframes[j];
-         spritespan_t &span = r_spritespan[i][j];
-         if(frame.rotate)
+         span.bottom = FLT_MAX;
+         span.top = -FLT_MAX;
+         span.side = 0;
+         for(int16_t lump : frame.lump)
          {
-            span.bottom = FLT_MAX;
-            span.top = -FLT_MAX;
-            span.side = 0;
-            for(int16_t lump : frame.lump)
-            {
-               float height = spriteheight[lump];
-               auto yofs = M_FixedToFloat(spritetopoffset[lump]);
-               float side = M_FixedToFloat(emax(spritewidth[lump] -
-                                                spriteoffset[lump],
-                                                spriteoffset[lump]));
-
-               if(yofs - height < span.bottom)
-                  span.bottom = yofs - height;
-               if(yofs > span.top)
-                  span.top = yofs;
-               if(side > span.side)
-                  span.side = side;
-            }
-         }
-         else
-         {
-            int16_t lump = frame.lump[0];
-            span.top = M_FixedToFloat(spritetopoffset[lump]);
-            span.bottom = span.top - spriteheight[lump];
-            span.side = M_FixedToFloat(emax(spritewidth[lump] -
-                                            spriteoffset[lump],
-                                            spriteoffset[lump]));
+            float height = spriteheight[lump];
+            auto yofs = M_FixedToFloat(spritetopoffset[lump]);
+            float side = R_SpriteLumpSide(lump);
+
+            if(yofs - height < span.bottom)
+               span.bottom = yofs - height;
+            if(yofs > span.top)
+               span.top = yofs;
+            if(side > span.side)
+               span.side = side;
          }
       }
+      else
+      {
+         int16_t lump = frame.lump[0];
+         span.top = M_FixedToFloat(spritetopoffset[lump]);
+         span.bottom = span.top - spriteheight[lump];
+         span.side = R_SpriteLumpSide(lump);
+      }
    }
 }
 
@@ -182,6 +183,10 @@ static int r_numglobalmaps;
 //
 // killough 4/4/98: Add support for C_START/C_END markers
 //
+// Only COLORMAP and FOGMAP are loaded here. The rest of the C_START/C_END
+// namespace is loaded by R_ColormapNumForName the first time a level names a
+// colormap, so mods with hundreds of them cost nothing for the ones unused.
+//
 static void R_InitColormaps()
 {
    const WadDirectory::namespace_t &ns =
@@ -197,26 +202,34 @@ static void R_InitColormaps()
    numcolormaps = ns.numLumps + r_numglobalmaps;
 
    // colormaps[0] is always the global COLORMAP lump
-   size_t numbytes = sizeof(*colormaps) * numcolormaps;
-   int    cmlump   = W_GetNumForName("COLORMAP");
+   int cmlump = W_GetNumForName("COLORMAP");
 
-   colormaps    = emalloctag(lighttable_t **, numbytes, PU_RENDERER, nullptr);
+   colormaps    = ecalloctag(lighttable_t **, numcolormaps, sizeof(*colormaps), PU_RENDERER, nullptr);
    colormaps[0] = (lighttable_t *)(wGlobalDir.cacheLumpNum(cmlump, PU_RENDERER));
 
    // colormaps[1] is FOGMAP, if it exists
    if(fogmap >= 0)
       colormaps[1] = (lighttable_t *)(wGlobalDir.cacheLumpNum(fogmap, PU_RENDERER));
 
-   // load other colormaps from the colormaps namespace
-   int i = r_numglobalmaps;
-   WadNamespaceIterator nsi(wGlobalDir, lumpinfo_t::ns_colormaps);
-  
-   for(nsi.begin(); nsi.current(); nsi.next(), i++)
-      colormaps[i] = (lighttable_t *)(wGlobalDir.cacheLumpNum((*nsi)->selfindex, PU_RENDERER));
-
    firstcolormaplump = ns.firstLump;
 }
 
+//
+// R_loadColormap
+//
+// Loads a colormap from the namespace along with its light tables, if it
+// isn't already.
+//
+static void R_loadColormap(int index)
+{
+   if(!colormaps || index < r_numglobalmaps || index >= numcolormaps || colormaps[index])
+      return;
+
+   const int lumpnum = index - r_numglobalmaps + firstcolormaplump;
+   colormaps[index] = (lighttable_t *)(wGlobalDir.cacheLumpNum(lumpnum, PU_RENDERER));
+   R_InitColormapLightTables(index);
+}
+
 // haleyjd: new global colormap system -- simply sets an index to
 //   the appropriate colormap and the rendering code checks this
 //   instead of assuming it should always use colormap 0 -- much
@@ -254,7 +267,10 @@ int R_ColormapNumForName(const char *name)
       return 1;
 
    if((i = W_CheckNumForNameNS(name, lumpinfo_t::ns_colormaps)) != -1)
+   {
       i = (i - firstcolormaplump) + r_numglobalmaps;
+      R_loadColormap(i);
+   }
 
    return i;
 }
@@ -284,6 +300,69 @@ int tran_filter_pct = 66;       // filter percent
 
 #define TSC 12        /* number of fixed point digits in filter percent */
 
+//
+// Composes a default transparent filter map based on PLAYPAL, for the current
+// tran_filter_pct.
+//
+static void R_buildTranMap(byte *tranmap, const byte *playpal, bool force)
+{
+   int pal[3][256], tot[256], pal_w1[3][256];
+   int w1 = ((unsigned int) tran_filter_pct<<TSC)/100;
+   int w2 = (1l<<TSC)-w1;
+
+   // First, convert playpal into long int type, and transpose array,
+   // for fast inner-loop calculations. Precompute tot array.
+   {
+      int i = 255;
+      const unsigned char *p = playpal + 255 * 3;
+      do
+      {
+         int t,d;
+         pal_w1[0][i] = (pal[0][i] = t = p[0]) * w1;
+         d = t*t;
+         pal_w1[1][i] = (pal[1][i] = t = p[1]) * w1;
+         d += t*t;
+         pal_w1[2][i] = (pal[2][i] = t = p[2]) * w1;
+         d += t*t;
+         p -= 3;
+         tot[i] = d << (TSC - 1);
+      }
+      while (--i >= 0);
+   }
+
+   // Next, compute all entries using minimum arithmetic.
+   byte *tp = tranmap;
+   for(int i = 0; i < 256; ++i)
+   {
+      int r1 = pal[0][i] * w2;
+      int g1 = pal[1][i] * w2;
+      int b1 = pal[2][i] * w2;
+
+      if(!(i & 31) && force)
+         V_LoadingIncrease();        //sf 
+
+      for(int j = 0; j < 256; j++, tp++)
+      {
+         int color = 255;
+         int err;
+         int r = pal_w1[0][j] + r1;
+         int g = pal_w1[1][j] + g1;
+         int b = pal_w1[2][j] + b1;
+         int best = INT_MAX;
+         do
+         {
+            if((err = tot[color] - pal[0][color]*r
+               - pal[1][color]*g - pal[2][color]*b) < best)
+            {
+               best = err;
+               *tp = color;
+            }
+         }
+         while(--color >= 0);
+      }
+   }
+}
+
 //
 // R_InitTranMap
 //
@@ -350,60 +429,76 @@ void R_InitTranMap(bool force)
       prev_tran_pct = tran_filter_pct;
       memcpy(prev_palette, playpal, 768);
       
-      int pal[3][256], tot[256], pal_w1[3][256];
-      int w1 = ((unsigned int) tran_filter_pct<<TSC)/100;
-      int w2 = (1l<<TSC)-w1;
-
-      // First, convert playpal into long int type, and transpose array,
-      // for fast inner-loop calculations. Precompute tot array.
+      if(R_LoadCachedTable("tranmap", playpal, uint32_t(tran_filter_pct), main_tranmap, 256*256))
       {
-         int i = 255;
-         const unsigned char *p = playpal + 255 * 3;
-         do
+         if(force)
          {
-            int t,d;
-            pal_w1[0][i] = (pal[0][i] = t = p[0]) * w1;
-            d = t*t;
-            pal_w1[1][i] = (pal[1][i] = t = p[1]) * w1;
-            d += t*t;
-            pal_w1[2][i] = (pal[2][i] = t = p[2]) * w1;
-            d += t*t;
-            p -= 3;
-            tot[i] = d << (TSC - 1);
+            for(int i = 0; i < 256; i += 32)
+               V_LoadingIncrease();    // keep the loading bar in step
          }
-         while (--i >= 0);
       }
+      else
+      {
+         R_buildTranMap(main_tranmap, playpal, force);
+         R_SaveCachedTable("tranmap", playpal, uint32_t(tran_filter_pct), main_tranmap, 256*256);
+      }
+   }
+}
+
+//
+// Composes a default subtractive filter map based on PLAYPAL.
+//
+static void R_buildSubMap(byte *submap, const byte *playpal)
+{
+   int pal[3][256], tot[256];
 
-      // Next, compute all entries using minimum arithmetic.
-      byte *tp = main_tranmap;
-      for(int i = 0; i < 256; ++i)
+   // First, convert playpal into long int type, and transpose array,
+   // for fast inner-loop calculations. Precompute tot array.
+   {
+      int i = 255;
+      const unsigned char *p = playpal + 255 * 3;
+      do
       {
-         int r1 = pal[0][i] * w2;
-         int g1 = pal[1][i] * w2;
-         int b1 = pal[2][i] * w2;
+         int t,d;
+         pal[0][i] = t = p[0];
+         d = t*t;
+         pal[1][i] = t = p[1];
+         d += t*t;
+         pal[2][i] = t = p[2];
+         d += t*t;
+         p -= 3;
+         tot[i] = d/2;
+      }
+      while (--i >= 0);
+   }
 
-         if(!(i & 31) && force)
-            V_LoadingIncrease();        //sf 
+   // Next, compute all entries using minimum arithmetic.
+   byte *tp = submap;
+   for(int i = 0; i < 256; i++)
+   {
+      int r1 = pal[0][i];
+      int g1 = pal[1][i];
+      int b1 = pal[2][i];
 
-         for(int j = 0; j < 256; j++, tp++)
+      for(int j = 0; j < 256; j++, tp++)
+      {
+         int color = 255;
+         int err;
+         // haleyjd: subtract and clamp to 0
+         int r = emax(r1 - pal[0][j], 0);
+         int g = emax(g1 - pal[1][j], 0);
+         int b = emax(b1 - pal[2][j], 0);
+         int best = INT_MAX;
+         do
          {
-            int color = 255;
-            int err;
-            int r = pal_w1[0][j] + r1;
-            int g = pal_w1[1][j] + g1;
-            int b = pal_w1[2][j] + b1;
-            int best = INT_MAX;
-            do
+            if((err = tot[color] - pal[0][color]*r
+               - pal[1][color]*g - pal[2][color]*b) < best)
             {
-               if((err = tot[color] - pal[0][color]*r
-                  - pal[1][color]*g - pal[2][color]*b) < best)
-               {
-                  best = err;
-                  *tp = color;
-               }
+               best = err;
+               *tp = color;
             }
-            while(--color >= 0);
          }
+         while(--color >= 0);
       }
    }
 }
@@ -466,56 +561,10 @@ void R_InitSubMap(bool force)
       prev_built    = true;
       memcpy(prev_palette, playpal, 768);
       
-      int pal[3][256], tot[256];
-
-      // First, convert playpal into long int type, and transpose array,
-      // for fast inner-loop calculations. Precompute tot array.
-      {
-         int i = 255;
-         const unsigned char *p = playpal + 255 * 3;
-         do
-         {
-            int t,d;
-            pal[0][i] = t = p[0];
-            d = t*t;
-            pal[1][i] = t = p[1];
-            d += t*t;
-            pal[2][i] = t = p[2];
-            d += t*t;
-            p -= 3;
-            tot[i] = d/2;
-         }
-         while (--i >= 0);
-      }
-
-      // Next, compute all entries using minimum arithmetic.
-      byte *tp = main_submap;
-      for(int i = 0; i < 256; i++)
+      if(!R_LoadCachedTable("submap", playpal, 0, main_submap, 256*256))
       {
-         int r1 = pal[0][i];
-         int g1 = pal[1][i];
-         int b1 = pal[2][i];
-
-         for(int j = 0; j < 256; j++, tp++)
-         {
-            int color = 255;
-            int err;
-            // haleyjd: subtract and clamp to 0
-            int r = emax(r1 - pal[0][j], 0);
-            int g = emax(g1 - pal[1][j], 0);
-            int b = emax(b1 - pal[2][j], 0);
-            int best = INT_MAX;
-            do
-            {
-               if((err = tot[color] - pal[0][color]*r
-                  - pal[1][color]*g - pal[2][color]*b) < best)
-               {
-                  best = err;
-                  *tp = color;
-               }
-            }
-            while(--color >= 0);
-         }
+         R_buildSubMap(main_submap, playpal);
+         R_SaveCachedTable("submap", playpal, 0, main_submap, 256*256);
       }
    }
 }
@@ -536,6 +585,7 @@ void R_InitData()
    R_ClearSkyTextures();                 // haleyjd  8/30/02
    R_InitTextures();
    R_InitSpriteLumps();
+   ++r_datagen;
 
    if(general_translucency)             // killough 3/1/98, 10/98
    {
@@ -587,9 +637,15 @@ void R_PrecacheLevel(void)
    byte *hitlist;
    int numalloc;
 
-   if(demoplayback)
-      return;
-   
+   // Sprite definitions are otherwise built on first use, which may be in a
+   // render context, so build those of the things present now.
+   for(Thinker *th = thinkercap.next; th != &thinkercap; th = th->next)
+   {
+      Mobj *mo;
+      if((mo = thinker_cast<Mobj *>(th)) && (unsigned int)mo->sprite < (unsigned int)numsprites)
+         R_SpriteDef(mo->sprite);
+   }
+
    if(!r_precache)
       return;
 
@@ -626,14 +682,16 @@ void R_PrecacheLevel(void)
       ++sky;
    }
 
-   // Precache textures.
-   for(i = texturecount; --i >= 0; )
+   // Precache textures. These are composed in the background, so unlike
+   // sprites they are precached for demos too.
+   R_PrecacheTextures(hitlist);
+
+   if(demoplayback)
    {
-      if(hitlist[i])
-         R_CacheTexture(i);
+      efree(hitlist);
+      return;
    }
 
-
    // Precache sprites.
    memset(hitlist, 0, numsprites);
 
@@ -651,11 +709,12 @@ void R_PrecacheLevel(void)
    {
       if (hitlist[i])
       {
-         int j = sprites[i].numframes;
+         const spritedef_t *sprdef = R_SpriteDef(i);
+         int j = sprdef->numframes;
          
          while (--j >= 0)
          {
-            int16_t *sflump = sprites[i].spriteframes[j].lump;
+            int16_t *sflump = sprdef->spriteframes[j].lump;
             int k = 7;
             do
                wGlobalDir.cacheLumpNum(firstspritelump + sflump[k], PU_CACHE);
@@ -674,6 +733,11 @@ void R_PrecacheLevel(void)
 //
 void R_FreeData(void)
 {
+   // Precache threads may still be writing into texture buffers
+   R_FinishPrecache();
+
+   R_FreeDistortedFlats();
+
    // haleyjd: let's harness the power of the zone heap and make this simple.
    Z_FreeTags(PU_RENDERER, PU_RENDERER);
 }
@@ -27,9 +27,10 @@
 #ifndef R_DATA_H__
 #define R_DATA_H__
 
-// Required for: DLListItem
+// Required for: DLListItem, fixed_t
 #include "doomtype.h"
 #include "m_dllist.h"
+#include "m_fixed.h"
 
 enum
 {
@@ -116,6 +117,16 @@ struct texture_t
    texcol_t   **columns;     // SoM: width length list of columns
    byte       *bufferalloc;   // ioanch: allocate this one with a leading padding for safety
    byte       *bufferdata;    // SoM: Linear buffer the texture occupies (ioanch: points to real data)
+
+   // Residency of the composed buffer, for eviction under r_texturebudget
+   DLListItem<texture_t> residentlink;
+   uint32_t   usedframe;     // texture frame of the last access
+   uint32_t   residentsize;  // bytes of buffer accounted while resident, 0 if not
+
+   // Mip levels, each half the size of the one before, packed one after
+   // another from mipdata + 8. Only solid power-of-two textures have them.
+   byte      *mipdata;
+   int        nummips;
    
    // New texture system can put either textures or flats (or anything, really)
    // into a texture, so the old patches idea has been scrapped for 'graphics'
@@ -133,6 +144,23 @@ struct texture_t
 const byte *R_GetRawColumn(int tex, int32_t col);
 const texcol_t *R_GetMaskedColumn(int tex, int32_t col);
 
+// Most mip levels kept for a texture, past the texture itself
+static constexpr int R_MAXMIPLEVELS = 4;
+
+// Column of a wall texture, from the mip level that fits texels step apart
+const byte *R_GetMipColumn(int tex, int32_t col, fixed_t step, int &level);
+
+// Linear buffer of a mip level of a texture, nullptr if it has no such level
+const byte *R_GetMipLevel(const texture_t *tex, int level);
+
+struct patch_t;
+
+// Most mip levels made for a sprite frame, halving it each time
+static constexpr int R_MAXSPRITEMIPS = 3;
+
+// Sprite patch shrunk by 2^level, nullptr if there's to be no such level
+const patch_t *R_GetSpriteMip(int lump, const patch_t *patch, int level);
+
 // SoM: This function returns the linear texture buffer (recache if needed)
 const byte *R_GetLinearBuffer(int tex);
 
@@ -140,6 +168,17 @@ const byte *R_GetLinearBuffer(int tex);
 // Returns the texture for chaining.
 texture_t *R_CacheTexture(int num);
 
+// Background composition of a level's textures
+void R_PrecacheTextures(const byte *hitlist);
+void R_FinishPrecache();
+
+// Per-frame texture upkeep: publishes precached textures and evicts cold ones
+void R_StartTextureFrame();
+
+extern int r_texturebudget; // MiB of composed textures to keep, 0 for no limit
+extern bool r_mipmap;       // draw distant walls and flats from mip levels
+extern bool r_spritemip;    // draw distant sprites from shrunk copies
+
 // SoM: all textures/flats are now stored in a single array (textures)
 // Walls start from wallstart to (wallstop - 1) and flats go from flatstart 
 // to (flatstop - 1)
@@ -152,6 +191,10 @@ extern int         badtex;
 extern int         texturecount;
 extern texture_t **textures;
 
+// Bumped each time R_InitData loads textures and sprites anew, so anything
+// keeping copies of them can tell when to throw those away
+extern unsigned    r_datagen;
+
 // SoM: Because all textures and flats are stored in the same array, the 
 // translation tables are now combined.
 extern int        *texturetranslation;
@@ -161,7 +204,11 @@ void R_InitData(void);
 void R_FreeData(void);
 void R_PrecacheLevel(void);
 
-void R_InitSpriteProjSpan();
+struct spritedef_t;
+struct spritespan_t;
+
+float R_SpriteLumpSide(int lump);
+void  R_InitSpriteProjSpan(const spritedef_t &sprite, spritespan_t *spans);
 
 // Retrieval.
 // Floor/ceiling opaque texture tiles,
@@ -182,7 +229,7 @@ const char *R_ColormapNameForNum(int index);
 // haleyjd: new global colormap method
 void R_SetGlobalLevelColormap(void);
 
-extern byte *main_tranmap, *main_submap, *tranmap;
+extern byte *main_tranmap, *main_submap;
 
 extern int r_precache;
 
@@ -181,6 +181,22 @@ struct pslope_t
    // Offset of this slope's origin from surface's height, set on sector assignment and kept constant
    fixed_t surfaceZOffset;
    float surfaceZOffsetF;  // floating-point variant
+
+   //
+   // Height of the plane at (x, y). Inline, since the playsim and renderer ask
+   // for surface heights everywhere; the arithmetic must stay as it is for
+   // demo sync.
+   //
+   fixed_t getZAt(fixed_t x, fixed_t y) const
+   {
+      const fixed_t dist = FixedMul(x - o.x, d.x) + FixedMul(y - o.y, d.y);
+      return o.z + FixedMul(dist, zdelta);
+   }
+   float getZAtf(float x, float y) const
+   {
+      const float dist = (x - of.x) * df.x + (y - of.y) * df.y;
+      return of.z + dist * zdeltaf;
+   }
 };
 
 //
@@ -212,6 +228,7 @@ struct sectoraction_t
 struct sectorinterp_t
 {
    bool    interpolated;       // if true, interpolated
+   bool    moved;              // if true, listed in movedsectors
 
    fixed_t prevfloorheight;    // previous values, stored for interpolation
    fixed_t prevceilingheight;
@@ -232,6 +249,8 @@ struct sectorbox_t
    fixed_t box[4];      // bounding box per sector
    float fbox[4];
    Surfaces<uint64_t> visitid;   // updated to avoid visiting more than once
+   fixed_t thingbox[4]; // every position a linked thing may be drawn at
+   float thingxscale;   // largest xscale of a thing linked here
 };
 
 //
@@ -301,7 +320,11 @@ struct surface_t
    // haleyjd 10/17/10: terrain type overrides
    ETerrain *terrain;
 
-   fixed_t getZAt(fixed_t x, fixed_t y) const;
+   // Get height of a potentially sloped surface
+   fixed_t getZAt(fixed_t x, fixed_t y) const
+   {
+      return slope ? slope->getZAt(x, y) : height;
+   }
    inline fixed_t getZAt(v2fixed_t v) const
    {
       return getZAt(v.x, v.y);
@@ -372,6 +395,10 @@ struct sector_t
    int linecount;
    line_t **lines;
 
+   // sectors getNextSector finds across lines, each once, outside comp_model
+   int neighborcount;
+   sector_t **neighbors;
+
    int groupid;
 
    // haleyjd 03/12/03: Heretic wind specials
@@ -572,6 +599,23 @@ struct fnode_t
    double len;              // length of partition line, for normalization
 };
 
+//
+// bspnode
+//
+// The partition lines and children of the nodes again, in a copy of the tree
+// laid out in van Emde Boas order for point location and sight checks: the
+// top half of the tree's levels first, then each subtree hanging below them,
+// laid out the same way. A walk from the root then keeps to a few short runs
+// of memory instead of hopping across the whole nodes lump. The root is
+// bspnodes[0], children index bspnodes, and subsector children are as in
+// node_t.
+//
+struct bspnode_t
+{
+   fixed_t x, y, dx, dy;
+   int     children[2];
+};
+
 //
 // OTHER TYPES
 //
@@ -647,7 +691,7 @@ struct rslope_t
 
 struct visplane_t
 {
-   visplane_t *next;        // Next visplane in hash chain -- killough
+   visplane_t *next;        // Next visplane in the table's plane list
    int picnum, lightlevel, minx, maxx;
    fixed_t height;
    lighttable_t *(*colormap)[MAXLIGHTZ];
@@ -684,13 +728,41 @@ struct visplane_t
    int                    bflags; 
    // Opacity of the overlay (255 - opaque, 0 - translucent)
    byte                   opacity;
+
+   // Planes R_DupPlane split off share the identity of the plane they came
+   // from, and opaque flat ones are drawn together with it
+   visplane_t *root;     // plane this one was duplicated from, if any
+   visplane_t *firstdup; // first duplicate, if this is a root
+   visplane_t *nextdup;  // next duplicate of the same root
+};
+
+// One slot of an open-addressed visplane table
+struct planehashslot_t
+{
+   unsigned int  key;   // hash of the plane identity
+   visplane_t   *plane; // nullptr if the slot is empty
 };
 
 struct planehash_t
 {
-   int          chaincount;
-   visplane_t   **chains;
-   planehash_t  *next;  // if this planehash is part of a reusable list
+   int              slotcount; // always a power of two
+   int              numslots;  // occupied slots
+   int              tag;       // zone tag slot storage is allocated with
+   planehashslot_t *slots;
+   visplane_t      *planes;    // every plane in the table, including duplicates
+   planehash_t     *next;      // if this planehash is part of a reusable list
+};
+
+// Visplanes and their silhouette arrays are carved out of blocks that are
+// kept between frames and reused when the arena is reset.
+struct visplaneblock_t;
+
+struct visplanearena_t
+{
+   visplaneblock_t *head;    // all blocks allocated so far
+   visplaneblock_t *current; // block being carved from
+   int              used;    // planes carved from current
+   size_t           stride;  // bytes per plane, including its arrays
 };
 
 #endif
@@ -33,6 +33,7 @@
 #include "e_lib.h"
 #include "mn_engin.h"
 #include "r_draw.h"
+#include "r_drawt.h"
 #include "r_main.h"
 #include "st_stuff.h"
 #include "v_alloc.h"
@@ -58,6 +59,7 @@
 //
 
 rrect_t viewwindow;   // haleyjd 05/02/13
+rrect_t presentwindow;
 rrect_t scaledwindow; // haleyjd 05/02/13
 
 int   linesize = SCREENWIDTH;  // killough 11/98
@@ -68,7 +70,6 @@ byte *renderscreen;            // haleyjd
 //  (color ramps used for  suit colors).
 //
  
-byte *tranmap;          // translucency filter maps 256x256   // phares 
 byte *main_tranmap;     // killough 4/11/98
 byte *main_submap;      // haleyjd 11/30/13
 
@@ -92,7 +93,7 @@ const int fuzzoffset[FUZZTABLE] =
   1,1,0,1,1,0,1 
 }; 
 
-int fuzzpos = 0; 
+int fuzzbase; // moved on every frame, for the shimmer
 
 //
 // A column is a vertical slice/span from a wall texture that,
@@ -100,9 +101,72 @@ int fuzzpos = 0;
 //  will always have constant z depth.
 // Thus a special case loop for very fast rendering can
 //  be used. It has also been used with Wolfenstein 3D.
-// 
+//
+// Every textured column drawer is generated from CB_drawColumn_8 below, from
+// one source policy (how the texel is remapped) and one blend policy (how it
+// is combined with what's already in the framebuffer). The 'translucent or
+// opaque' decision is still made outside the drawer, so no per-pixel branch
+// is added.
+//
+
+// Source policies
+
+// Lit only
+struct colsourcelit
+{
+   static remapone Make(const cb_column_t &column) { return remapone(column.colormap); }
+};
+
+// Translated, then lit. Used to draw player sprites with the green colorramp
+// mapped to others, or e.g. the lighter colored version of the BaronOfHell.
+struct colsourcetranslated
+{
+   static remaptwo Make(const cb_column_t &column)
+   {
+      return remaptwo(column.translation, column.colormap);
+   }
+};
+
+// Blend policies
+
+// Opaque
+struct colblendopaque
+{
+   static blendopaque Make(const cb_column_t &) { return blendopaque(); }
+};
+
+// phares: the existing color index and the new color index are mapped through
+// the TRANMAP lump filters to get a new color index whose RGB values are the
+// average of the existing and new colors.
+struct colblendtranmap
+{
+   static blendtranmap Make(const cb_column_t &column) { return blendtranmap(column.tranmap); }
+};
+
+// haleyjd 09/01/02: zdoom-style translucency
+struct colblendflex
+{
+   static blendflex Make(const cb_column_t &column)
+   {
+      const unsigned int fglevel = column.translevel & ~0x3ff;
+      const unsigned int bglevel = FRACUNIT - fglevel;
+      return blendflex(Col2RGB8[fglevel >> 10], Col2RGB8[bglevel >> 10]);
+   }
+};
+
+// haleyjd 02/08/05: additive translucency
+struct colblendadd
+{
+   static blendadd Make(const cb_column_t &column)
+   {
+      const unsigned int fglevel = column.translevel & ~0x3ff;
+      return blendadd(Col2RGB8_LessPrecision[fglevel >> 10],
+                      Col2RGB8_LessPrecision[FRACUNIT >> 10]);
+   }
+};
 
-void CB_DrawColumn_8(cb_column_t &column)
+template<typename S, typename B>
+static void CB_drawColumn_8(cb_column_t &column)
 {
    int count;
    byte *dest;
@@ -115,16 +179,17 @@ void CB_DrawColumn_8(cb_column_t &column)
 #ifdef RANGECHECK 
    if(column.x  < 0 || column.x  >= video.width || 
       column.y1 < 0 || column.y2 >= video.height)
-      I_Error("CB_DrawColumn_8: %i to %i at %i\n", column.y1, column.y2, column.x);
+      I_Error("CB_drawColumn_8: %i to %i at %i\n", column.y1, column.y2, column.x);
 #endif 
 
    dest = R_ADDRESS(column.x, column.y1);
    fracstep = column.step;
-   frac = column.texmid + (int)((column.y1 - view.ycenter + 1) * fracstep);
+   frac = column.texmid + (int)((column.y1 - (view.ycenter + column.ycenteroffset) + 1) * fracstep);
 
    {
       const byte *source = static_cast<const byte *>(column.source);
-      const lighttable_t *colormap = column.colormap;
+      const auto  remap  = S::Make(column);
+      const auto  blend  = B::Make(column);
       int heightmask = column.texheight - 1;
       
       if(column.texheight & heightmask)
@@ -138,32 +203,14 @@ void CB_DrawColumn_8(cb_column_t &column)
             while(frac >= heightmask)
                frac -= heightmask;
 
-         do
-         {
-            *dest = colormap[source[frac>>FRACBITS]];
-            dest += 1;                     // killough 11/98
-            if((frac += fracstep) >= heightmask)
-               frac -= heightmask;
-         } 
-         while(--count);
-      }
-      else
-      {
-         while((count -= 2) >= 0) // texture height is a power of 2 -- killough
-         {
-            *dest = colormap[source[(frac>>FRACBITS) & heightmask]];
-            dest += 1;   // killough 11/98
-            frac += fracstep;
-            *dest = colormap[source[(frac>>FRACBITS) & heightmask]];
-            dest += 1;   // killough 11/98
-            frac += fracstep;
-         }
-         if(count & 1)
-            *dest = colormap[source[(frac>>FRACBITS) & heightmask]];
+         R_DrawColumnRun(dest, count, frac, fracstep, source, wrapmodulo(heightmask), remap, blend);
       }
+      else // texture height is a power of 2 -- killough
+         R_DrawColumnRun(dest, count, frac, fracstep, source, wrapmask(heightmask), remap, blend);
    }
 }
 
+
 //
 // Sky drawing: for showing just a color above the texture
 //
@@ -185,7 +232,7 @@ void CB_DrawSkyColumn_8(cb_column_t &column)
 
    dest = R_ADDRESS(column.x, column.y1);
    fracstep = column.step;
-   frac = column.texmid + (int)((column.y1 - view.ycenter + 1) * fracstep);
+   frac = column.texmid + (int)((column.y1 - (view.ycenter + column.ycenteroffset) + 1) * fracstep);
 
    {
       const byte *source = static_cast<const byte *>(column.source);
@@ -295,7 +342,7 @@ static void CB_DrawNewSkyColumn_8(cb_column_t &column)
    // Determine scaling, which is the only mapping to be done.
 
    fracstep = column.step;
-   frac = column.texmid + (int)((column.y1 - view.ycenter + 1) * fracstep);
+   frac = column.texmid + (int)((column.y1 - (view.ycenter + column.ycenteroffset) + 1) * fracstep);
 
    // Inner loop that does the actual texture mapping,
    //  e.g. a DDA-lile scaling.
@@ -363,161 +410,6 @@ static void CB_DrawNewSkyColumn_8(cb_column_t &column)
    }
 }
 
-// Here is the version of R_DrawColumn that deals with translucent  // phares
-// textures and sprites. It's identical to R_DrawColumn except      //    |
-// for the spot where the color index is stuffed into *dest. At     //    V
-// that point, the existing color index and the new color index
-// are mapped through the TRANMAP lump filters to get a new color
-// index whose RGB values are the average of the existing and new
-// colors.
-//
-// Since we're concerned about performance, the 'translucent or
-// opaque' decision is made outside this routine, not down where the
-// actual code differences are.
-
-#define SRCPIXEL \
-   tranmap[(*dest<<8)+colormap[source[(frac>>FRACBITS) & heightmask]]]
-
-void CB_DrawTLColumn_8(cb_column_t &column)
-{
-   int count;
-   byte *dest;
-   fixed_t frac;
-   fixed_t fracstep;
-
-   count = column.y2 - column.y1 + 1;
-   if(count <= 0) return;
-
-#ifdef RANGECHECK 
-   if(column.x  < 0 || column.x  >= video.width || 
-      column.y1 < 0 || column.y2 >= video.height)
-      I_Error("CB_DrawTLColumn_8: %i to %i at %i\n", column.y1, column.y2, column.x);
-#endif 
-
-   dest = R_ADDRESS(column.x, column.y1);
-   fracstep = column.step;
-   frac = column.texmid + (int)((column.y1 - view.ycenter + 1) * fracstep);
-
-   // killough 2/1/98, 2/21/98: more performance tuning
-   {
-      const byte *source = static_cast<const byte *>(column.source);
-      const lighttable_t *colormap = column.colormap;
-      int heightmask = column.texheight - 1;
-      
-      if(column.texheight & heightmask)
-      {
-         heightmask++;
-         heightmask <<= FRACBITS;
-
-         if(frac < 0)
-            while((frac += heightmask) <  0);
-         else
-            while(frac >= heightmask)
-               frac -= heightmask;
-
-         do
-         {
-            *dest = tranmap[(*dest<<8) + colormap[source[frac>>FRACBITS]]]; // phares
-            dest += 1;          // killough 11/98
-            if((frac += fracstep) >= heightmask)
-               frac -= heightmask;
-         } 
-         while(--count);
-      }
-      else
-      {
-         while((count -= 2) >= 0) // texture height is a power of 2 -- killough
-         {
-            *dest = SRCPIXEL; // phares
-            dest += 1;   // killough 11/98
-            frac += fracstep;
-            *dest = SRCPIXEL; // phares
-            dest += 1;   // killough 11/98
-            frac += fracstep;
-         }
-         if(count & 1)
-            *dest = SRCPIXEL; // phares
-      }
-   }
-}
-
-#undef SRCPIXEL
-
-#define SRCPIXEL \
-   tranmap[(*dest<<8) + colormap[column.translation[source[frac>>FRACBITS]]]]
-
-#define SRCPIXEL_MASK \
-   tranmap[(*dest<<8) + \
-      colormap[column.translation[source[(frac>>FRACBITS) & heightmask]]]]
-
-//
-// haleyjd 02/08/05: BOOM TL/Tlated was neglected.
-//
-void CB_DrawTLTRColumn_8(cb_column_t &column)
-{
-   int count;
-   byte *dest;
-   fixed_t frac;
-   fixed_t fracstep;
-
-   count = column.y2 - column.y1 + 1;
-   if(count <= 0) return;
-
-#ifdef RANGECHECK 
-   if(column.x  < 0 || column.x  >= video.width || 
-      column.y1 < 0 || column.y2 >= video.height)
-      I_Error("CB_DrawTLTRColumn_8: %i to %i at %i\n", column.y1, column.y2, column.x);    
-#endif 
-
-   dest = R_ADDRESS(column.x, column.y1);
-   fracstep = column.step;
-   frac = column.texmid + (int)((column.y1 - view.ycenter + 1) * fracstep);
-
-   {
-      const byte *source = static_cast<const byte *>(column.source);
-      const lighttable_t *colormap = column.colormap;
-      int heightmask = column.texheight - 1;
-      
-      if(column.texheight & heightmask)
-      {
-         heightmask++;
-         heightmask <<= FRACBITS;
-
-         if(frac < 0)
-            while((frac += heightmask) <  0);
-         else
-            while(frac >= heightmask)
-               frac -= heightmask;
-
-         do
-         {
-            *dest = SRCPIXEL; // phares
-            dest += 1; // killough 11/98
-            if((frac += fracstep) >= heightmask)
-               frac -= heightmask;
-         } 
-         while(--count);
-      }
-      else
-      {
-         while((count -= 2) >= 0) // texture height is a power of 2 -- killough
-         {
-            *dest = SRCPIXEL_MASK; // phares
-            dest += 1;   // killough 11/98
-            frac += fracstep;
-            *dest = SRCPIXEL_MASK; // phares
-            dest += 1;   // killough 11/98
-            frac += fracstep;
-         }
-         if(count & 1)
-            *dest = SRCPIXEL_MASK; // phares
-      }
-   }
-}
-
-#undef SRCPIXEL
-#undef SRCPIXEL_MASK
-
 
 //
 // Spectre/Invisibility.
@@ -546,6 +438,7 @@ void CB_DrawFuzzColumn_8(cb_column_t &column)
 {
    int count;
    byte *dest;
+   int fuzzpos;
 
    // Adjust borders. Low...
    if(!column.x)
@@ -565,6 +458,7 @@ void CB_DrawFuzzColumn_8(cb_column_t &column)
 #endif
 
    dest = R_ADDRESS(column.x, column.y1);
+   fuzzpos = R_FuzzStart(column.x);
 
    {
       const lighttable_t *colormap = column.colormap;
@@ -589,16 +483,6 @@ void CB_DrawFuzzColumn_8(cb_column_t &column)
 
 #undef SRCPIXEL
 
-//
-// R_DrawTranslatedColumn
-// Used to draw player sprites
-//  with the green colorramp mapped to others.
-// Could be used with different translation
-//  tables, e.g. the lighter colored version
-//  of the BaronOfHell, the HellKnight, uses
-//  identical sprites, kinda brightened up.
-//
-
 // haleyjd: changed translationtables to byte **
 byte **translationtables = nullptr;
 
@@ -606,543 +490,15 @@ byte **translationtables = nullptr;
 static int firsttranslationlump;
 static int numtranslations = 0;
 
-#define SRCPIXEL \
-   colormap[column.translation[source[(frac>>FRACBITS) & heightmask]]]
-
-void CB_DrawTRColumn_8(cb_column_t &column)
-{
-   int count;
-   byte *dest;
-   fixed_t frac;
-   fixed_t fracstep;
-
-   count = column.y2 - column.y1 + 1;
-   if(count <= 0) return;
-
-#ifdef RANGECHECK 
-   if(column.x  < 0 || column.x  >= video.width || 
-      column.y1 < 0 || column.y2 >= video.height)
-      I_Error("CB_DrawTRColumn_8: %i to %i at %i\n", column.y1, column.y2, column.x);    
-#endif 
-
-   dest = R_ADDRESS(column.x, column.y1);
-   fracstep = column.step;
-   frac = column.texmid + (int)((column.y1 - view.ycenter + 1) * fracstep);
-
-   {
-      const byte *source = static_cast<const byte *>(column.source);
-      const lighttable_t *colormap = column.colormap;
-      int heightmask = column.texheight - 1;
-      
-      if(column.texheight & heightmask)
-      {
-         heightmask++;
-         heightmask <<= FRACBITS;
-
-         if(frac < 0)
-            while((frac += heightmask) <  0);
-         else
-            while(frac >= heightmask)
-               frac -= heightmask;
-
-         do
-         {
-            *dest = colormap[column.translation[source[frac>>FRACBITS]]]; // phares
-            dest += 1;                     // killough 11/98
-            if((frac += fracstep) >= heightmask)
-               frac -= heightmask;
-         } 
-         while(--count);
-      }
-      else
-      {
-         while((count -= 2) >= 0) // texture height is a power of 2 -- killough
-         {
-            *dest = SRCPIXEL; // phares
-            dest += 1;   // killough 11/98
-            frac += fracstep;
-            *dest = SRCPIXEL;
-            dest += 1;   // killough 11/98
-            frac += fracstep;
-         }
-         if(count & 1)
-            *dest = SRCPIXEL;
-      }
-   }
-}
-
-#undef SRCPIXEL
-
-//
-// R_DrawFlexColumn
-//
-// haleyjd 09/01/02: zdoom-style translucency
-//
-void CB_DrawFlexColumn_8(cb_column_t &column)
-{
-   int count;
-   byte *dest;
-   fixed_t frac;
-   fixed_t fracstep;
-   unsigned int *fg2rgb, *bg2rgb;
-   unsigned int fg, bg;
-
-   count = column.y2 - column.y1 + 1;
-   if(count <= 0) return;
-
-#ifdef RANGECHECK 
-   if(column.x  < 0 || column.x  >= video.width || 
-      column.y1 < 0 || column.y2 >= video.height)
-      I_Error("CB_DrawFlexColumn_8: %i to %i at %i\n", column.y1, column.y2, column.x);    
-#endif 
-
-   {
-      unsigned int fglevel, bglevel;
-      
-      fglevel = column.translevel & ~0x3ff;
-      bglevel = FRACUNIT - fglevel;
-      fg2rgb  = Col2RGB8[fglevel >> 10];
-      bg2rgb  = Col2RGB8[bglevel >> 10];
-   }
-
-   dest = R_ADDRESS(column.x, column.y1);
-   fracstep = column.step;
-   frac = column.texmid + (int)((column.y1 - view.ycenter + 1) * fracstep);
-
-   {
-      const byte *source = static_cast<const byte *>(column.source);
-      const lighttable_t *colormap = column.colormap;
-      int heightmask = column.texheight - 1;
-      
-      if (column.texheight & heightmask)   // not a power of 2 -- killough
-      {
-         heightmask++;
-         heightmask <<= FRACBITS;
-          
-         if (frac < 0)
-            while ((frac += heightmask) <  0);
-         else
-            while (frac >= (int)heightmask)
-               frac -= heightmask;          
-
-         do
-         {
-            fg = colormap[source[frac>>FRACBITS]];
-            bg = *dest;
-
-            fg = fg2rgb[fg];
-            bg = bg2rgb[bg];
-            fg = (fg+bg) | 0x1f07c1f;
-            *dest = RGB32k[0][0][fg & (fg>>15)];
-            
-            dest += 1;          // killough 11/98
-            if((frac += fracstep) >= heightmask)
-               frac -= heightmask;
-         } 
-         while(--count);
-      }
-      else
-      {
-         while((count -= 2) >= 0)   // texture height is a power of 2 -- killough
-         {
-            fg = colormap[source[(frac>>FRACBITS) & heightmask]];
-            bg = *dest;
-            fg = fg2rgb[fg];
-            bg = bg2rgb[bg];
-            fg = (fg+bg) | 0x1f07c1f;
-
-            *dest = RGB32k[0][0][fg & (fg>>15)];
-            dest += 1;   // killough 11/98
-            frac += fracstep;
-            
-            fg = colormap[source[(frac>>FRACBITS) & heightmask]];
-            bg = *dest;
-            fg = fg2rgb[fg];
-            bg = bg2rgb[bg];
-            fg = (fg+bg) | 0x1f07c1f;
-
-            *dest = RGB32k[0][0][fg & (fg>>15)];
-            dest += 1;   // killough 11/98
-            frac += fracstep;
-         }
-         if(count & 1)
-         {
-            fg = colormap[source[(frac>>FRACBITS) & heightmask]];
-            bg = *dest;
-            fg = fg2rgb[fg];
-            bg = bg2rgb[bg];
-            fg = (fg+bg) | 0x1f07c1f;
-
-            *dest = RGB32k[0][0][fg & (fg>>15)];
-         }
-      }
-   }
-}
-
-#define SRCPIXEL \
-   colormap[column.translation[source[(frac>>FRACBITS) & heightmask]]]
-
-//
-// R_DrawFlexTlatedColumn
-//
-// haleyjd 11/05/02: zdoom-style translucency w/translation, for
-// player sprites
-//
-void CB_DrawFlexTRColumn_8(cb_column_t &column)
-{
-   int count;
-   byte *dest;
-   fixed_t frac;
-   fixed_t fracstep;
-   const unsigned int *fg2rgb, *bg2rgb;
-   unsigned int fg, bg;
-
-   count = column.y2 - column.y1 + 1;
-   if(count <= 0) return;
-
-#ifdef RANGECHECK 
-   if(column.x  < 0 || column.x  >= video.width || 
-      column.y1 < 0 || column.y2 >= video.height)
-      I_Error("CB_DrawFlexTRColumn_8: %i to %i at %i\n", column.y1, column.y2, column.x);    
-#endif 
-
-   {
-      unsigned int fglevel, bglevel;
-      
-      fglevel = column.translevel & ~0x3ff;
-      bglevel = FRACUNIT - fglevel;
-      fg2rgb  = Col2RGB8[fglevel >> 10];
-      bg2rgb  = Col2RGB8[bglevel >> 10];
-   }
-
-   dest = R_ADDRESS(column.x, column.y1);
-   fracstep = column.step;
-   frac = column.texmid + (int)((column.y1 - view.ycenter + 1) * fracstep);
-
-   {
-      const byte *source = static_cast<const byte *>(column.source);
-      const lighttable_t *colormap = column.colormap;
-      int heightmask = column.texheight - 1;
-      
-      if(column.texheight & heightmask)
-      {
-         heightmask++;
-         heightmask <<= FRACBITS;
-          
-         if (frac < 0)
-            while ((frac += heightmask) <  0);
-         else
-            while (frac >= (int)heightmask)
-               frac -= heightmask;          
-
-         do
-         {
-            fg = colormap[column.translation[source[frac>>FRACBITS]]];
-            bg = *dest;
-
-            fg = fg2rgb[fg];
-            bg = bg2rgb[bg];
-            fg = (fg+bg) | 0x1f07c1f;
-            *dest = RGB32k[0][0][fg & (fg>>15)];
-            
-            dest += 1;          // killough 11/98
-            if((frac += fracstep) >= heightmask)
-               frac -= heightmask;
-         } 
-         while(--count);
-      }
-      else
-      {
-         while((count -= 2) >= 0) // texture height is a power of 2 -- killough
-         {
-            fg = SRCPIXEL;
-            bg = *dest;
-            fg = fg2rgb[fg];
-            bg = bg2rgb[bg];
-            fg = (fg+bg) | 0x1f07c1f;
-
-            *dest = RGB32k[0][0][fg & (fg>>15)];
-            dest += 1;   // killough 11/98
-            frac += fracstep;
-            
-            fg = SRCPIXEL;
-            bg = *dest;
-            fg = fg2rgb[fg];
-            bg = bg2rgb[bg];
-            fg = (fg+bg) | 0x1f07c1f;
-
-            *dest = RGB32k[0][0][fg & (fg>>15)];
-            dest += 1;   // killough 11/98
-            frac += fracstep;
-         }
-         if(count & 1)
-         {
-            fg = SRCPIXEL;
-            bg = *dest;
-            fg = fg2rgb[fg];
-            bg = bg2rgb[bg];
-            fg = (fg+bg) | 0x1f07c1f;
-
-            *dest = RGB32k[0][0][fg & (fg>>15)];
-         }
-      }
-   }
-}
-
-#undef SRCPIXEL
-
-#define SRCPIXEL \
-   fg2rgb[colormap[source[(frac>>FRACBITS) & heightmask]]]
-
-//
-// R_DrawAddColumn
-//
-// haleyjd 02/08/05: additive translucency
-//
-void CB_DrawAddColumn_8(cb_column_t &column)
-{
-   int count;
-   byte *dest;
-   fixed_t frac;
-   fixed_t fracstep;
-   const unsigned int *fg2rgb, *bg2rgb;
-   unsigned int a, b;
-
-   count = column.y2 - column.y1 + 1;
-   if(count <= 0) return;
-
-#ifdef RANGECHECK 
-   if(column.x  < 0 || column.x  >= video.width || 
-      column.y1 < 0 || column.y2 >= video.height)
-      I_Error("CB_DrawAddColumn_8: %i to %i at %i\n", column.y1, column.y2, column.x);    
-#endif 
-
-   {
-      unsigned int fglevel, bglevel;
-      
-      fglevel = column.translevel & ~0x3ff;
-      bglevel = FRACUNIT;
-      fg2rgb  = Col2RGB8_LessPrecision[fglevel >> 10];
-      bg2rgb  = Col2RGB8_LessPrecision[bglevel >> 10];
-   }
-
-   dest = R_ADDRESS(column.x, column.y1);
-   fracstep = column.step;
-   frac = column.texmid + (int)((column.y1 - view.ycenter + 1) * fracstep);
-
-   {
-      const byte *source = static_cast<const byte *>(column.source);
-      const lighttable_t *colormap = column.colormap;
-      int heightmask = column.texheight - 1;
-      
-      if(column.texheight & heightmask)
-      {
-         heightmask++;
-         heightmask <<= FRACBITS;
-          
-         if (frac < 0)
-            while ((frac += heightmask) <  0);
-         else
-            while (frac >= (int)heightmask)
-               frac -= heightmask;          
-
-         do
-         {
-            // mask out LSBs in green and red to allow overflow
-            a = fg2rgb[colormap[source[frac>>FRACBITS]]] + bg2rgb[*dest];
-            b = a;
-            
-            a |= 0x01f07c1f;
-            b &= 0x40100400;
-            a &= 0x3fffffff;
-            b  = b - (b >> 5);
-            a |= b;
-                        
-            *dest = RGB32k[0][0][a & (a >> 15)];
-            
-            dest += 1;          // killough 11/98
-            if((frac += fracstep) >= heightmask)
-               frac -= heightmask;
-         } 
-         while(--count);
-      }
-      else
-      {
-         while((count -= 2) >= 0)   // texture height is a power of 2 -- killough
-         {
-            a = SRCPIXEL + bg2rgb[*dest];
-            b = a;
-
-            a |= 0x01f07c1f;
-            b &= 0x40100400;
-            a &= 0x3fffffff;
-            b  = b - (b >> 5);
-            a |= b;            
-            
-            *dest = RGB32k[0][0][a & (a >> 15)];
-            dest += 1;   // killough 11/98
-            frac += fracstep;
-
-            a = SRCPIXEL + bg2rgb[*dest];
-            b = a;
-            
-            a |= 0x01f07c1f;
-            b &= 0x40100400;
-            a &= 0x3fffffff;
-            b  = b - (b >> 5);
-            a |= b;
-            
-            *dest = RGB32k[0][0][a & (a >> 15)];
-            dest += 1;   // killough 11/98
-            frac += fracstep;            
-         }
-         if(count & 1)
-         {
-            a = SRCPIXEL + bg2rgb[*dest];
-            b = a;
-            
-            a |= 0x01f07c1f;
-            b &= 0x40100400;
-            a &= 0x3fffffff;
-            b  = b - (b >> 5);
-            a |= b;
-            
-            *dest = RGB32k[0][0][a & (a >> 15)];
-         }
-      }
-   }
-}
-
-#undef SRCPIXEL
-
-#define SRCPIXEL \
-   fg2rgb[colormap[column.translation[source[frac>>FRACBITS]]]]
-
-#define SRCPIXEL_MASK \
-   fg2rgb[colormap[column.translation[source[(frac>>FRACBITS) & heightmask]]]]
-
-//
-// R_DrawAddTlatedColumn
-//
-// haleyjd 02/08/05: additive translucency + translation
-// The slowest of all column drawers!
-//
-void CB_DrawAddTRColumn_8(cb_column_t &column)
-{
-   int count;
-   byte *dest;
-   fixed_t frac;
-   fixed_t fracstep;
-   const unsigned int *fg2rgb, *bg2rgb;
-   unsigned int a, b;
-
-   count = column.y2 - column.y1 + 1;
-   if(count <= 0) return;
-
-#ifdef RANGECHECK 
-   if(column.x  < 0 || column.x  >= video.width || 
-      column.y1 < 0 || column.y2 >= video.height)
-      I_Error("CB_DrawAddTRColumn_8: %i to %i at %i\n", column.y1, column.y2, column.x);    
-#endif 
-
-   {
-      unsigned int fglevel, bglevel;
-      
-      fglevel = column.translevel & ~0x3ff;
-      bglevel = FRACUNIT;
-      fg2rgb  = Col2RGB8_LessPrecision[fglevel >> 10];
-      bg2rgb  = Col2RGB8_LessPrecision[bglevel >> 10];
-   }
-
-   dest = R_ADDRESS(column.x, column.y1);
-   fracstep = column.step;
-   frac = column.texmid + (int)((column.y1 - view.ycenter + 1) * fracstep);
-
-   {
-      const byte *source = static_cast<const byte *>(column.source);
-      const lighttable_t *colormap = column.colormap;
-      int heightmask = column.texheight - 1;
-      
-      if(column.texheight & heightmask)
-      {
-         heightmask++;
-         heightmask <<= FRACBITS;
-          
-         if (frac < 0)
-            while ((frac += heightmask) <  0);
-         else
-            while (frac >= (int)heightmask)
-               frac -= heightmask;          
-
-         do
-         {
-            // mask out LSBs in green and red to allow overflow
-            a = SRCPIXEL + bg2rgb[*dest];
-            b = a;
-            
-            a |= 0x01f07c1f;
-            b &= 0x40100400;
-            a &= 0x3fffffff;
-            b  = b - (b >> 5);
-            a |= b;
-            
-            *dest = RGB32k[0][0][a & (a >> 15)];
-            
-            dest += 1;          // killough 11/98
-            if((frac += fracstep) >= heightmask)
-               frac -= heightmask;
-         } 
-         while(--count);
-      }
-      else
-      {
-         while((count -= 2) >= 0) // texture height is a power of 2 -- killough
-         {
-            a = SRCPIXEL_MASK + bg2rgb[*dest];
-            b = a;
-            
-            a |= 0x01f07c1f;
-            b &= 0x40100400;
-            a &= 0x3fffffff;
-            b  = b - (b >> 5);
-            a |= b;
-            
-            *dest = RGB32k[0][0][a & (a >> 15)];
-            dest += 1;   // killough 11/98
-            frac += fracstep;
-
-            a = SRCPIXEL_MASK + bg2rgb[*dest];
-            b = a;
-            
-            a |= 0x01f07c1f;
-            b &= 0x40100400;
-            a &= 0x3fffffff;
-            b  = b - (b >> 5);
-            a |= b;
-            
-            *dest = RGB32k[0][0][a & (a >> 15)];
-            dest += 1;   // killough 11/98
-            frac += fracstep;            
-         }
-         if(count & 1)
-         {
-            a = SRCPIXEL_MASK + bg2rgb[*dest];
-            b = a;
-            
-            a |= 0x01f07c1f;
-            b &= 0x40100400;
-            a &= 0x3fffffff;
-            b  = b - (b >> 5);
-            a |= b;
-            
-            *dest = RGB32k[0][0][a & (a >> 15)];
-         }
-      }
-   }
-}
-
-#undef SRCPIXEL
-#undef SRCPIXEL_MASK
+// Textured column drawer specializations
+static constexpr R_ColumnFunc CB_DrawColumn_8       = CB_drawColumn_8<colsourcelit,        colblendopaque >;
+static constexpr R_ColumnFunc CB_DrawTRColumn_8     = CB_drawColumn_8<colsourcetranslated, colblendopaque >;
+static constexpr R_ColumnFunc CB_DrawTLColumn_8     = CB_drawColumn_8<colsourcelit,        colblendtranmap>;
+static constexpr R_ColumnFunc CB_DrawTLTRColumn_8   = CB_drawColumn_8<colsourcetranslated, colblendtranmap>;
+static constexpr R_ColumnFunc CB_DrawFlexColumn_8   = CB_drawColumn_8<colsourcelit,        colblendflex   >;
+static constexpr R_ColumnFunc CB_DrawFlexTRColumn_8 = CB_drawColumn_8<colsourcetranslated, colblendflex   >;
+static constexpr R_ColumnFunc CB_DrawAddColumn_8    = CB_drawColumn_8<colsourcelit,        colblendadd    >;
+static constexpr R_ColumnFunc CB_DrawAddTRColumn_8  = CB_drawColumn_8<colsourcetranslated, colblendadd    >;
 
 //
 // Normal Column Drawer Object
@@ -46,7 +46,8 @@ struct rrect_t
 };
 
 extern rrect_t scaledwindow;
-extern rrect_t viewwindow;
+extern rrect_t viewwindow;    // what the renderer draws
+extern rrect_t presentwindow; // where the view appears on the screen
 
 // haleyjd 01/22/11: vissprite drawstyles
 enum
@@ -87,6 +88,7 @@ struct columndrawer_t
 };
 
 extern columndrawer_t r_normal_drawer;
+extern columndrawer_t r_quad_drawer;
 
 #define TRANSLATIONCOLOURS 14
 
@@ -131,14 +133,22 @@ enum
 // multiple sets of span drawing functions (ie, low detail, low precision,
 // high precision, etc.)
 //
+using R_SlopeFunc = void (*)(const cb_slopespan_t &, const cb_span_t &);
+
 struct spandrawer_t
 {
    void (*DrawSpan [SPAN_NUMSTYLES][FLAT_NUMSIZES])(const cb_span_t &);
-   void (*DrawSlope[SPAN_NUMSTYLES][FLAT_NUMSIZES])(const cb_slopespan_t &, const cb_span_t &);
+   R_SlopeFunc DrawSlope[SPAN_NUMSTYLES][FLAT_NUMSIZES];
 };
 
 extern spandrawer_t r_lpspandrawer;  // low-precision
 extern spandrawer_t r_spandrawer;    // normal
+extern spandrawer_t r_vecspandrawer; // SIMD, chosen at runtime
+
+void R_InitVectorSpanDrawer();
+
+// per-pixel divide slope drawers, used instead of DrawSlope with r_slopeexact
+extern R_SlopeFunc r_exactslopes[SPAN_NUMSTYLES][FLAT_NUMSIZES];
 
 void R_InitBuffer(int width, int height);
 
@@ -158,7 +168,6 @@ void R_FillBackScreen(const rrect_t &window);
 // If the view size is not full screen, draws a border around it.
 void R_DrawViewBorder();
 
-extern byte  *tranmap;       // translucency filter maps 256x256  // phares 
 extern byte  *main_tranmap;  // killough 4/11/98
 extern byte  *main_submap;   // haleyjd 11/30/13
 
@@ -169,7 +178,17 @@ extern byte  *main_submap;   // haleyjd 11/30/13
 #define FUZZOFF (SCREENWIDTH)
 
 extern const int fuzzoffset[];
-extern int fuzzpos;
+extern int fuzzbase;
+
+//
+// Where a shadow column starts in fuzzoffset. It depends only on the column
+// and the frame, so every render context draws the same pattern without
+// sharing a position.
+//
+inline int R_FuzzStart(int x)
+{
+   return (x * 13 + fuzzbase) % FUZZTABLE;
+}
 
 // Cardboard
 struct cb_column_t
@@ -180,10 +199,12 @@ struct cb_column_t
    int texheight;
 
    int texmid;
+   float ycenteroffset; // moves the row texmid is measured from off view.ycenter
 
    // 8-bit lighting
    const lighttable_t *colormap;
    const byte *translation;
+   const byte *tranmap;  // BOOM translucency table for TL columns
    fixed_t translevel; // haleyjd: zdoom style trans level
    byte skycolor; // the sky color
 
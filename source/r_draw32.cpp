@@ -0,0 +1,960 @@
+//
+// The Eternity Engine
+// Copyright(C) 2026 James Haley, Max Waine, et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+// Additional terms and conditions compatible with the GPLv3 apply. See the
+// file COPYING-EE for details.
+//
+// Purpose: Truecolor column and span drawers.
+//  Texels are looked up through the colormaps only for anything other than
+//  plain diminished lighting; the standard light levels are applied as a
+//  multiply on the RGB value, which removes the banding of the 32 colormaps.
+//  Translucency is a true per-channel blend rather than a TRANMAP or RGB32k
+//  lookup.
+//
+
+#include "z_zone.h"
+#include "i_system.h"
+
+#include "doomstat.h"
+#include "m_compare.h"
+#include "m_simd.h"
+#include "r_draw.h"
+#include "r_draw32.h"
+#include "r_drawt.h"
+#include "r_lighting.h"
+#include "r_main.h"
+#include "r_plane.h"
+#include "r_state.h"
+#include "v_alloc.h"
+#include "v_misc.h"
+#include "v_video.h"
+
+uint32_t *renderscreen32;
+bool      r_truecolorview;
+
+// The part of the screen the last truecolor view covered, for composition
+static rrect_t truecolorwindow;
+static bool    truecolorframe;
+
+VALLOCATION(renderscreen32)
+{
+   // allocated on first use, once the video driver has settled the pitch
+   renderscreen32 = nullptr;
+   truecolorframe = false;
+}
+
+//=============================================================================
+//
+// Pixel operations on 0x00RRGGBB values
+//
+
+//
+// Scales each channel by scale in 0-256.
+//
+static inline uint32_t R_shadeTrueColor(uint32_t c, unsigned int scale)
+{
+   return ((((c & 0xff00ff) * scale) >> 8) & 0xff00ff) |
+          ((((c & 0x00ff00) * scale) >> 8) & 0x00ff00);
+}
+
+//
+// Adds fg scaled by alpha to bg, saturating each channel.
+//
+static inline uint32_t R_addTrueColor(uint32_t fg, uint32_t bg, unsigned int alpha)
+{
+   fg = R_shadeTrueColor(fg, alpha);
+
+   uint32_t rb = (fg & 0xff00ff) + (bg & 0xff00ff);
+   uint32_t g  = (fg & 0x00ff00) + (bg & 0x00ff00);
+   uint32_t over;
+
+   over = rb & 0x01000100;
+   rb   = (rb | (over - (over >> 8))) & 0xff00ff;
+   over = g & 0x010000;
+   g    = (g | (over - (over >> 8))) & 0x00ff00;
+
+   return rb | g;
+}
+
+//
+// Subtracts fg from bg, clamping each channel to 0.
+//
+static inline uint32_t R_subTrueColor(uint32_t fg, uint32_t bg)
+{
+   const int r = emax(int((bg >> 16) & 0xff) - int((fg >> 16) & 0xff), 0);
+   const int g = emax(int((bg >>  8) & 0xff) - int((fg >>  8) & 0xff), 0);
+   const int b = emax(int( bg        & 0xff) - int( fg        & 0xff), 0);
+
+   return uint32_t((r << 16) | (g << 8) | b);
+}
+
+//
+// Nearest palette index of a truecolor pixel.
+//
+static inline byte R_quantizeTrueColor(uint32_t c)
+{
+   return RGB32k[(c >> 19) & 31][(c >> 11) & 31][(c >> 3) & 31];
+}
+
+//=============================================================================
+//
+// Lighting
+//
+
+struct tclight_t
+{
+   const lighttable_t *map;   // colormap applied to the texel index
+   unsigned int        scale; // then 0-256 multiplier applied in RGB
+};
+
+//
+// Splits a colormap pointer into the level-0 map of its colormap set and a
+// brightness, when it is one of the diminished lighting levels. Anything else
+// (fixed colormaps, translations out of the normal range) is looked up as-is.
+//
+static tclight_t R_trueColorLight(const lighttable_t *colormap)
+{
+   const uintptr_t addr = uintptr_t(colormap);
+
+   for(int i = 0; i < numcolormaps; i++)
+   {
+      const uintptr_t base = uintptr_t(colormaps[i]);
+
+      if(base && addr >= base && addr < base + NUMCOLORMAPS * 256 && !((addr - base) & 255))
+      {
+         const unsigned int level = unsigned((addr - base) >> 8);
+         return { colormaps[i], 256 - level * (256 / NUMCOLORMAPS) };
+      }
+   }
+
+   return { colormap, 256 };
+}
+
+//
+// Per-pixel lighting for sloped spans, which usually repeat one colormap for
+// a long run.
+//
+class tclightcache_t
+{
+   const lighttable_t *last = nullptr;
+   tclight_t           light = { nullptr, 256 };
+
+public:
+   const tclight_t &get(const lighttable_t *colormap)
+   {
+      if(colormap != last)
+      {
+         last  = colormap;
+         light = R_trueColorLight(colormap);
+      }
+      return light;
+   }
+};
+
+//=============================================================================
+//
+// Column policies, for R_DrawColumnRun
+//
+
+// Lit only
+struct tcremaplit
+{
+   tclight_t light;
+
+   explicit tcremaplit(const cb_column_t &column) : light(R_trueColorLight(column.colormap)) {}
+   uint32_t Remap(byte c) const { return R_shadeTrueColor(Col2RGB32[light.map[c]], light.scale); }
+};
+
+// Translated, then lit
+struct tcremaptranslated
+{
+   const byte *translation;
+   tclight_t   light;
+
+   explicit tcremaptranslated(const cb_column_t &column)
+      : translation(column.translation), light(R_trueColorLight(column.colormap))
+   {
+   }
+   uint32_t Remap(byte c) const
+   {
+      return R_shadeTrueColor(Col2RGB32[light.map[translation[c]]], light.scale);
+   }
+};
+
+struct tcblendopaque
+{
+   uint32_t Blend(uint32_t fg, uint32_t) const { return fg; }
+};
+
+struct tcblendalpha
+{
+   unsigned int alpha;
+
+   explicit tcblendalpha(unsigned int a) : alpha(a) {}
+   uint32_t Blend(uint32_t fg, uint32_t bg) const { return R_BlendTrueColor(fg, bg, alpha); }
+};
+
+struct tcblendadd
+{
+   unsigned int alpha;
+
+   explicit tcblendadd(unsigned int a) : alpha(a) {}
+   uint32_t Blend(uint32_t fg, uint32_t bg) const { return R_addTrueColor(fg, bg, alpha); }
+};
+
+struct tcblendsub
+{
+   uint32_t Blend(uint32_t fg, uint32_t bg) const { return R_subTrueColor(fg, bg); }
+};
+
+// Makers from a column, mirroring the 8-bit colblend* policies
+
+struct tccolopaque
+{
+   static tcblendopaque Make(const cb_column_t &) { return tcblendopaque(); }
+};
+
+// BOOM translucency is the TRANMAP's percentage; custom TRANMAPs can't be
+// expressed as a blend so they get the same one
+struct tccoltranmap
+{
+   static tcblendalpha Make(const cb_column_t &)
+   {
+      return tcblendalpha(unsigned(tran_filter_pct * 256 / 100));
+   }
+};
+
+struct tccolsubmap
+{
+   static tcblendsub Make(const cb_column_t &) { return tcblendsub(); }
+};
+
+struct tccolflex
+{
+   static tcblendalpha Make(const cb_column_t &column)
+   {
+      return tcblendalpha(unsigned(column.translevel) >> 8);
+   }
+};
+
+struct tccoladd
+{
+   static tcblendadd Make(const cb_column_t &column)
+   {
+      return tcblendadd(unsigned(column.translevel) >> 8);
+   }
+};
+
+//=============================================================================
+//
+// Column drawers
+//
+
+template<typename S, typename B>
+static void CB_drawColumn_32(cb_column_t &column)
+{
+   const int count = column.y2 - column.y1 + 1;
+   if(count <= 0)
+      return;
+
+#ifdef RANGECHECK
+   if(column.x  < 0 || column.x  >= video.width ||
+      column.y1 < 0 || column.y2 >= video.height)
+      I_Error("CB_drawColumn_32: %i to %i at %i\n", column.y1, column.y2, column.x);
+#endif
+
+   uint32_t     *dest     = R_ADDRESS32(column.x, column.y1);
+   const fixed_t fracstep = column.step;
+   fixed_t       frac     = column.texmid + int((column.y1 - (view.ycenter + column.ycenteroffset) + 1) * fracstep);
+
+   const byte *source = static_cast<const byte *>(column.source);
+   const S     remap(column);
+   const auto  blend  = B::Make(column);
+   int heightmask = column.texheight - 1;
+
+   if(column.texheight & heightmask)
+   {
+      heightmask++;
+      heightmask <<= FRACBITS;
+
+      if(frac < 0)
+         while((frac += heightmask) <  0);
+      else
+         while(frac >= heightmask)
+            frac -= heightmask;
+
+      R_DrawColumnRun(dest, count, frac, fracstep, source, wrapmodulo(heightmask), remap, blend);
+   }
+   else
+      R_DrawColumnRun(dest, count, frac, fracstep, source, wrapmask(heightmask), remap, blend);
+}
+
+static constexpr R_ColumnFunc CB_DrawColumn_32       = CB_drawColumn_32<tcremaplit,        tccolopaque >;
+static constexpr R_ColumnFunc CB_DrawTRColumn_32     = CB_drawColumn_32<tcremaptranslated, tccolopaque >;
+static constexpr R_ColumnFunc CB_DrawFlexColumn_32   = CB_drawColumn_32<tcremaplit,        tccolflex   >;
+static constexpr R_ColumnFunc CB_DrawFlexTRColumn_32 = CB_drawColumn_32<tcremaptranslated, tccolflex   >;
+static constexpr R_ColumnFunc CB_DrawAddColumn_32    = CB_drawColumn_32<tcremaplit,        tccoladd    >;
+static constexpr R_ColumnFunc CB_DrawAddTRColumn_32  = CB_drawColumn_32<tcremaptranslated, tccoladd    >;
+
+//
+// TRANMAP and SUBMAP styles share one drawer, told apart by the table set up
+// for the sprite.
+//
+static void CB_DrawTLColumn_32(cb_column_t &column)
+{
+   if(column.tranmap == main_submap)
+      CB_drawColumn_32<tcremaplit, tccolsubmap>(column);
+   else
+      CB_drawColumn_32<tcremaplit, tccoltranmap>(column);
+}
+
+static void CB_DrawTLTRColumn_32(cb_column_t &column)
+{
+   if(column.tranmap == main_submap)
+      CB_drawColumn_32<tcremaptranslated, tccolsubmap>(column);
+   else
+      CB_drawColumn_32<tcremaptranslated, tccoltranmap>(column);
+}
+
+//
+// Fills n pixels with one color.
+//
+static inline uint32_t *R_fillTrueColor(uint32_t *dest, int n, uint32_t c)
+{
+   while(n-- > 0)
+      *dest++ = c;
+   return dest;
+}
+
+//
+// Sky columns: the median color above the texture, faded into its top edge
+// over two pixels, exactly like CB_DrawSkyColumn_8.
+//
+static void CB_DrawSkyColumn_32(cb_column_t &column)
+{
+   int count = column.y2 - column.y1 + 1;
+   if(count <= 0)
+      return;
+
+#ifdef RANGECHECK
+   if(column.x  < 0 || column.x  >= video.width ||
+      column.y1 < 0 || column.y2 >= video.height)
+      I_Error("CB_DrawSkyColumn_32: %i to %i at %i\n", column.y1, column.y2, column.x);
+#endif
+
+   uint32_t     *dest     = R_ADDRESS32(column.x, column.y1);
+   const fixed_t fracstep = column.step;
+   fixed_t       frac     = column.texmid + int((column.y1 - (view.ycenter + column.ycenteroffset) + 1) * fracstep);
+
+   const byte        *source = static_cast<const byte *>(column.source);
+   const tcremaplit   remap(column);
+   const unsigned int alpha  = unsigned(tran_filter_pct * 256 / 100);
+   const uint32_t     sky    = remap.Remap(column.skycolor);
+   const uint32_t     edge   = R_BlendTrueColor(sky, remap.Remap(source[0]), alpha);
+   int n;
+
+   if(frac < -2 * FRACUNIT)
+   {
+      n = emin((-frac - 2 * FRACUNIT + fracstep - 1) / fracstep, count);
+      dest = R_fillTrueColor(dest, n, sky);
+      if(!(count -= n))
+         return;
+      frac += fracstep * n;
+   }
+   if(frac < -FRACUNIT)
+   {
+      n = emin((-frac - FRACUNIT + fracstep - 1) / fracstep, count);
+      dest = R_fillTrueColor(dest, n, R_BlendTrueColor(sky, edge, alpha));
+      if(!(count -= n))
+         return;
+      frac += fracstep * n;
+   }
+   if(frac < 0)
+   {
+      n = emin((-frac + fracstep - 1) / fracstep, count);
+      dest = R_fillTrueColor(dest, n, edge);
+      if(!(count -= n))
+         return;
+      frac += fracstep * n;
+   }
+
+   int heightmask = column.texheight - 1;
+   if(column.texheight & heightmask)
+   {
+      heightmask++;
+      heightmask <<= FRACBITS;
+
+      while(frac >= heightmask)
+         frac -= heightmask;
+
+      R_DrawColumnRun(dest, count, frac, fracstep, source, wrapmodulo(heightmask), remap,
+                      tcblendopaque());
+   }
+   else
+      R_DrawColumnRun(dest, count, frac, fracstep, source, wrapmask(heightmask), remap,
+                      tcblendopaque());
+}
+
+//
+// Masked sky columns: index 0 is transparent.
+//
+template<typename W>
+static inline void R_drawNewSkyRun(uint32_t *dest, int count, fixed_t frac, const fixed_t fracstep,
+                                   const byte *source, const W &wrap, const tcremaplit &remap)
+{
+   do
+   {
+      const byte texel = source[wrap.Index(frac)];
+      if(texel)
+         *dest = remap.Remap(texel);
+      ++dest;
+      frac = wrap.Step(frac, fracstep);
+   }
+   while(--count);
+}
+
+static void CB_DrawNewSkyColumn_32(cb_column_t &column)
+{
+   int count = column.y2 - column.y1 + 1;
+   if(count <= 0)
+      return;
+
+#ifdef RANGECHECK
+   if(column.x  < 0 || column.x  >= video.width ||
+      column.y1 < 0 || column.y2 >= video.height)
+      I_Error("CB_DrawNewSkyColumn_32: %i to %i at %i\n", column.y1, column.y2, column.x);
+#endif
+
+   uint32_t     *dest     = R_ADDRESS32(column.x, column.y1);
+   const fixed_t fracstep = column.step;
+   fixed_t       frac     = column.texmid + int((column.y1 - (view.ycenter + column.ycenteroffset) + 1) * fracstep);
+
+   const byte      *source = static_cast<const byte *>(column.source);
+   const tcremaplit remap(column);
+
+   // Skip above-areas
+   if(frac < 0)
+   {
+      const int n = emin((-frac + fracstep - 1) / fracstep, count);
+      if(!(count -= n))
+         return;
+      dest += n;
+      frac += fracstep * n;
+   }
+
+   int heightmask = column.texheight - 1;
+   if(column.texheight & heightmask)
+   {
+      heightmask++;
+      heightmask <<= FRACBITS;
+
+      while(frac >= heightmask)
+         frac -= heightmask;
+
+      R_drawNewSkyRun(dest, count, frac, fracstep, source, wrapmodulo(heightmask), remap);
+   }
+   else
+      R_drawNewSkyRun(dest, count, frac, fracstep, source, wrapmask(heightmask), remap);
+}
+
+//
+// Spectre fuzz: darkens a neighboring pixel, six light levels down like the
+// 8-bit drawer's colormap offset.
+//
+static void CB_DrawFuzzColumn_32(cb_column_t &column)
+{
+   // Adjust borders. Low...
+   if(!column.x)
+      column.x = 1;
+
+   // .. and high.
+   if(column.x == viewwindow.width - 1)
+      column.x = viewwindow.width - 2;
+
+   int count = column.y2 - column.y1 + 1;
+   if(count <= 0)
+      return;
+
+#ifdef RANGECHECK
+   if(column.x  < 0 || column.x  >= video.width ||
+      column.y1 < 0 || column.y2 >= video.height)
+      I_Error("CB_DrawFuzzColumn_32: %i to %i at %i\n", column.y1, column.y2, column.x);
+#endif
+
+   uint32_t *dest    = R_ADDRESS32(column.x, column.y1);
+   int       fuzzpos = R_FuzzStart(column.x);
+
+   const tclight_t light = R_trueColorLight(column.colormap + 6 * 256);
+   const unsigned int scale = light.map == column.colormap + 6 * 256 ?
+      256 - 6 * (256 / NUMCOLORMAPS) : light.scale;
+
+   do
+   {
+      *dest = R_shadeTrueColor(dest[fuzzoffset[fuzzpos] ? linesize : -linesize], scale);
+      if(++fuzzpos == FUZZTABLE)
+         fuzzpos = 0;
+      ++dest;
+   }
+   while(--count);
+}
+
+//
+// Truecolor Column Drawer Object
+//
+columndrawer_t r_truecolor_drawer =
+{
+   CB_DrawColumn_32,
+   CB_DrawSkyColumn_32,
+   CB_DrawNewSkyColumn_32,
+   CB_DrawTLColumn_32,
+   CB_DrawTRColumn_32,
+   CB_DrawTLTRColumn_32,
+   CB_DrawFuzzColumn_32,
+   CB_DrawFlexColumn_32,
+   CB_DrawFlexTRColumn_32,
+   CB_DrawAddColumn_32,
+   CB_DrawAddTRColumn_32,
+
+   nullptr,
+
+   {
+      // Normal               Translated
+      { CB_DrawColumn_32,     CB_DrawTRColumn_32     }, // NORMAL
+      { CB_DrawFuzzColumn_32, CB_DrawFuzzColumn_32   }, // SHADOW
+      { CB_DrawFlexColumn_32, CB_DrawFlexTRColumn_32 }, // ALPHA
+      { CB_DrawAddColumn_32,  CB_DrawAddTRColumn_32  }, // ADD
+      { CB_DrawTLColumn_32,   CB_DrawTLTRColumn_32   }, // SUB
+      { CB_DrawTLColumn_32,   CB_DrawTLTRColumn_32   }, // TRANMAP
+   },
+};
+
+//=============================================================================
+//
+// Span drawers
+//
+
+#define MASK(alpham, i) ((alpham)[(i)>>3] & 1 << ((i) & 7))
+
+// Plane opacity 0-255 to a 0-256 alpha
+static inline unsigned int R_spanAlpha(const cb_span_t &span)
+{
+   return span.alpha + (span.alpha >> 7);
+}
+
+struct tcspanopaque
+{
+   static tcblendopaque Make(const cb_span_t &) { return tcblendopaque(); }
+};
+
+struct tcspantl
+{
+   static tcblendalpha Make(const cb_span_t &span) { return tcblendalpha(R_spanAlpha(span)); }
+};
+
+struct tcspanadd
+{
+   static tcblendadd Make(const cb_span_t &span) { return tcblendadd(R_spanAlpha(span)); }
+};
+
+//
+// Orthogonal spans, with the shift policies of the 8-bit drawers.
+//
+template<typename S, typename B, bool masked>
+static inline void R_drawSpan32(const cb_span_t &span)
+{
+   unsigned int xf = span.xfrac, xs = span.xstep;
+   unsigned int yf = span.yfrac, ys = span.ystep;
+   int count = span.x2 - span.x1 + 1;
+
+   const byte *source = static_cast<const byte *>(span.source);
+   uint32_t   *dest   = R_ADDRESS32(span.x1, span.y);
+
+   const S shift(span);
+   const unsigned int xshift = shift.XShift();
+   const unsigned int xmask  = shift.XMask();
+   const unsigned int yshift = shift.YShift();
+
+   const tclight_t light  = R_trueColorLight(span.colormap);
+   const auto      blend  = B::Make(span);
+   const byte     *alpham = static_cast<const byte *>(span.alphamask);
+
+   while(count-- > 0)
+   {
+      const unsigned int i = ((xf >> xshift) & xmask) | (yf >> yshift);
+      if(!masked || MASK(alpham, i))
+      {
+         *dest = blend.Blend(R_shadeTrueColor(Col2RGB32[light.map[source[i]]], light.scale),
+                             *dest);
+      }
+      dest += linesize;
+      xf   += xs;
+      yf   += ys;
+   }
+}
+
+template<typename B, bool masked, int xshift, int yshift, int xmask>
+static void R_drawSpan_32(const cb_span_t &span)
+{
+   R_drawSpan32<spanconsts<xshift, yshift, xmask>, B, masked>(span);
+}
+
+template<typename B, bool masked>
+static void R_drawSpan_32_GEN(const cb_span_t &span)
+{
+   R_drawSpan32<spanvalues, B, masked>(span);
+}
+
+#define SPANJUMP 16
+
+//
+// Sloped spans, subdividing the perspective divide every SPANJUMP pixels
+// like the 8-bit drawers.
+//
+template<typename S, typename B, bool masked>
+static inline void R_drawSlope32(const cb_slopespan_t &slopespan, const cb_span_t &span)
+{
+   double iu  = slopespan.iufrac, iv  = slopespan.ivfrac;
+   double ius = slopespan.iustep, ivs = slopespan.ivstep;
+   double id  = slopespan.idfrac, ids = slopespan.idstep;
+
+   int count = slopespan.x2 - slopespan.x1 + 1;
+   if(count <= 0)
+      return;
+
+   const byte *src  = static_cast<const byte *>(slopespan.source);
+   uint32_t   *dest = R_ADDRESS32(slopespan.x1, slopespan.y);
+
+   const S shift(span);
+   const unsigned int xshift = shift.XShift();
+   const unsigned int xmask  = shift.XMask();
+   const unsigned int ymask  = shift.YMask();
+
+   const auto  blend  = B::Make(span);
+   const byte *alpham = static_cast<const byte *>(span.alphamask);
+
+   tclightcache_t lights;
+   int mapindex = 0;
+
+   while(count > 0)
+   {
+      const int run = emin(count, SPANJUMP);
+
+      const double mulstart = 65536.0 / id;
+      id += ids * run;
+      const double mulend = 65536.0 / id;
+
+      const double ustart = iu * mulstart, vstart = iv * mulstart;
+      iu += ius * run;
+      iv += ivs * run;
+      const double uend = iu * mulend, vend = iv * mulend;
+
+      unsigned int ufrac = static_cast<unsigned int>(ustart);
+      unsigned int vfrac = static_cast<unsigned int>(vstart);
+      const unsigned int ustep = static_cast<unsigned int>((uend - ustart) / run);
+      const unsigned int vstep = static_cast<unsigned int>((vend - vstart) / run);
+
+      for(int i = 0; i < run; i++)
+      {
+         const tclight_t   &light = lights.get(cb_slopespan_t::colormap[mapindex++]);
+         const unsigned int texel = ((vfrac >> xshift) & xmask) | ((ufrac >> 16) & ymask);
+
+         if(!masked || MASK(alpham, texel))
+         {
+            *dest = blend.Blend(R_shadeTrueColor(Col2RGB32[light.map[src[texel]]], light.scale),
+                                *dest);
+         }
+         dest  += linesize;
+         ufrac += ustep;
+         vfrac += vstep;
+      }
+
+      count -= run;
+   }
+}
+
+template<typename B, bool masked, int xshift, int xmask, int ymask>
+static void R_drawSlope_32(const cb_slopespan_t &slopespan, const cb_span_t &span)
+{
+   R_drawSlope32<slopeconsts<xshift, xmask, ymask>, B, masked>(slopespan, span);
+}
+
+template<typename B, bool masked>
+static void R_drawSlope_32_GEN(const cb_slopespan_t &slopespan, const cb_span_t &span)
+{
+   R_drawSlope32<slopevalues, B, masked>(slopespan, span);
+}
+
+#undef SPANJUMP
+#undef MASK
+
+#define SPANSIZES(blend, masked)                      \
+   {                                                  \
+      R_drawSpan_32<blend, masked, 20, 26, 0x00FC0>,  \
+      R_drawSpan_32<blend, masked, 18, 25, 0x03F80>,  \
+      R_drawSpan_32<blend, masked, 16, 24, 0x0FF00>,  \
+      R_drawSpan_32<blend, masked, 14, 23, 0x3FE00>,  \
+      R_drawSpan_32_GEN<blend, masked>                \
+   }
+
+#define SLOPESIZES(blend, masked)                     \
+   {                                                  \
+      R_drawSlope_32<blend, masked, 10, 0x00FC0, 0x03F>, \
+      R_drawSlope_32<blend, masked,  9, 0x03F80, 0x07F>, \
+      R_drawSlope_32<blend, masked,  8, 0x0FF00, 0x0FF>, \
+      R_drawSlope_32<blend, masked,  7, 0x3FE00, 0x1FF>, \
+      R_drawSlope_32_GEN<blend, masked>               \
+   }
+
+//
+// Truecolor Span Drawer Object. Always paired with r_truecolor_drawer.
+//
+spandrawer_t r_truecolorspandrawer =
+{
+   {
+      SPANSIZES(tcspanopaque, false), // Solid
+      SPANSIZES(tcspantl,     false), // Translucent
+      SPANSIZES(tcspanadd,    false), // Additive
+      SPANSIZES(tcspanopaque, true),  // Solid masked
+      SPANSIZES(tcspantl,     true),  // Translucent masked
+      SPANSIZES(tcspanadd,    true)   // Additive masked
+   },
+   {
+      SLOPESIZES(tcspanopaque, false),
+      SLOPESIZES(tcspantl,     false),
+      SLOPESIZES(tcspanadd,    false),
+      SLOPESIZES(tcspanopaque, true),
+      SLOPESIZES(tcspantl,     true),
+      SLOPESIZES(tcspanadd,    true)
+   }
+};
+
+#undef SLOPESIZES
+#undef SPANSIZES
+
+//=============================================================================
+//
+// View begin and end
+//
+
+//
+// Called before a view is rendered with the truecolor engine.
+//
+void R_BeginTrueColorView()
+{
+   if(!renderscreen32)
+   {
+      renderscreen32 = ecalloctag(uint32_t *, size_t(linesize) * video.width, sizeof(uint32_t),
+                                  PU_VALLOC, nullptr);
+   }
+
+   r_truecolorview = true;
+}
+
+//
+// Resolves the finished view into the paletted screen, so that the HUD,
+// wipes, screenshots and drivers without truecolor output see the same image.
+//
+void R_EndTrueColorView()
+{
+   for(int x = 0; x < viewwindow.width; x++)
+   {
+      const uint32_t *src  = R_ADDRESS32(x, 0);
+      byte           *dest = R_ADDRESS(x, 0);
+
+      for(int y = 0; y < viewwindow.height; y++)
+         dest[y] = R_quantizeTrueColor(src[y]);
+   }
+
+   truecolorwindow = viewwindow;
+   truecolorframe  = true;
+   r_truecolorview = false;
+}
+
+//=============================================================================
+//
+// Video driver output
+//
+
+//
+// Builds the output lookups for a palette, already including any damage or
+// pickup tint, and a gamma table. The view is rendered against the base
+// palette, so the tint is carried over to it as the per-channel linear fit
+// from the base palette to this one; for palettes made the usual way, as a
+// blend towards a color, the fit is exact.
+//
+void R_SetTrueColorOutput(truecolorout_t &out, const byte *palette, const byte *gamma,
+                          int rshift, int gshift, int bshift, uint32_t amask)
+{
+   const int shifts[3] = { rshift, gshift, bshift };
+   uint32_t *luts[3]   = { out.red, out.green, out.blue };
+
+   for(int i = 0; i < 256; i++)
+   {
+      out.palette[i] = amask |
+                       uint32_t(gamma[palette[i * 3    ]]) << rshift |
+                       uint32_t(gamma[palette[i * 3 + 1]]) << gshift |
+                       uint32_t(gamma[palette[i * 3 + 2]]) << bshift;
+   }
+
+   for(int ch = 0; ch < 3; ch++)
+   {
+      const int basebit = 16 - ch * 8;
+      double sx = 0.0, sy = 0.0, sxx = 0.0, sxy = 0.0;
+
+      for(int i = 0; i < 256; i++)
+      {
+         const double x = double((Col2RGB32[i] >> basebit) & 0xff);
+         const double y = double(palette[i * 3 + ch]);
+
+         sx  += x;
+         sy  += y;
+         sxx += x * x;
+         sxy += x * y;
+      }
+
+      const double denom = 256.0 * sxx - sx * sx;
+      const double slope = denom != 0.0 ? (256.0 * sxy - sx * sy) / denom : 1.0;
+      const double icept = (sy - slope * sx) / 256.0;
+
+      for(int v = 0; v < 256; v++)
+      {
+         const int level = emin(emax(int(slope * v + icept + 0.5), 0), 255);
+         luts[ch][v] = uint32_t(gamma[level]) << shifts[ch];
+      }
+   }
+
+   for(uint32_t &red : out.red)
+      red |= amask;
+}
+
+//
+// True if the frame about to be presented has a truecolor view. Consumes the
+// flag, so that frames without a 3D view go back to the paletted path.
+//
+bool R_TrueColorFrame()
+{
+   const bool ret = truecolorframe && renderscreen32;
+
+   truecolorframe = false;
+   return ret;
+}
+
+//
+// Displayed color of one screen pixel. The view is taken from the truecolor
+// buffer wherever the paletted screen still holds its resolved value; anything
+// drawn over it since, such as the HUD or the automap, differs there and
+// comes from the palette.
+//
+static inline uint32_t R_composePixel(const truecolorout_t &out, byte s, uint32_t c)
+{
+   return s == R_quantizeTrueColor(c) ?
+      out.red[(c >> 16) & 0xff] | out.green[(c >> 8) & 0xff] | out.blue[c & 0xff] :
+      out.palette[s];
+}
+
+static constexpr int COMPOSETILE = 32;
+
+//
+// Expands the column-major paletted screen into an upright 32-bit surface in
+// one pass, with the truecolor view on top if withview is set. Work goes in
+// square tiles so that both the columns read and the rows written stay in
+// cache, and each 4x4 block is transposed in registers.
+//
+void R_ComposeTrueColor(const truecolorout_t &out, bool withview, const byte *src, int srcpitch,
+                        uint32_t *dest, int destpitch, int width, int height)
+{
+   // an empty window when there is no view to compose
+   const rrect_t window = withview && renderscreen32 ? truecolorwindow : rrect_t{ 0, 0, 0, 0 };
+   const int     wx2    = window.x + window.width;
+   const int     wy2    = window.y + window.height;
+
+   const auto pixel = [&](int x, int y) -> uint32_t {
+      const byte s = src[size_t(srcpitch) * x + y];
+
+      if(x >= window.x && x < wx2 && y >= window.y && y < wy2)
+         return R_composePixel(out, s, renderscreen32[size_t(linesize) * x + y]);
+      return out.palette[s];
+   };
+
+   for(int ty = 0; ty < height; ty += COMPOSETILE)
+   {
+      const int ey = emin(ty + COMPOSETILE, height);
+
+      for(int tx = 0; tx < width; tx += COMPOSETILE)
+      {
+         const int ex = emin(tx + COMPOSETILE, width);
+         int y = ty;
+
+         for(; y + 4 <= ey; y += 4)
+         {
+            int x = tx;
+
+            for(; x + 4 <= ex; x += 4)
+            {
+               uint32_t block[16];
+
+               if(x + 4 <= window.x || x >= wx2 || y + 4 <= window.y || y >= wy2)
+               {
+                  for(int i = 0; i < 4; i++)
+                  {
+                     const byte *s = src + size_t(srcpitch) * (x + i) + y;
+                     for(int j = 0; j < 4; j++)
+                        block[i * 4 + j] = out.palette[s[j]];
+                  }
+               }
+               else if(x >= window.x && x + 4 <= wx2 && y >= window.y && y + 4 <= wy2)
+               {
+                  for(int i = 0; i < 4; i++)
+                  {
+                     const byte     *s = src + size_t(srcpitch) * (x + i) + y;
+                     const uint32_t *v = renderscreen32 + size_t(linesize) * (x + i) + y;
+                     for(int j = 0; j < 4; j++)
+                        block[i * 4 + j] = R_composePixel(out, s[j], v[j]);
+                  }
+               }
+               else
+               {
+                  for(int i = 0; i < 4; i++)
+                  {
+                     for(int j = 0; j < 4; j++)
+                        block[i * 4 + j] = pixel(x + i, y + j);
+                  }
+               }
+
+               M_StoreTransposed4x4(dest + size_t(destpitch) * y + x, destpitch, block);
+            }
+
+            // leftover columns of a width that isn't a multiple of 4
+            for(; x < ex; x++)
+            {
+               for(int j = 0; j < 4; j++)
+                  dest[size_t(destpitch) * (y + j) + x] = pixel(x, y + j);
+            }
+         }
+
+         // leftover rows
+         for(; y < ey; y++)
+         {
+            for(int x = tx; x < ex; x++)
+               dest[size_t(destpitch) * y + x] = pixel(x, y);
+         }
+      }
+   }
+}
+
+// EOF
+
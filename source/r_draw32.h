@@ -0,0 +1,82 @@
+//
+// The Eternity Engine
+// Copyright(C) 2026 James Haley, Max Waine, et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+// Additional terms and conditions compatible with the GPLv3 apply. See the
+// file COPYING-EE for details.
+//
+// Purpose: Truecolor view rendering.
+//  Selected as a column engine, the truecolor drawers render the 3D view into
+//  a 32-bit buffer, shading and blending in RGB. The finished view is resolved
+//  back into the paletted screen so that everything drawn afterwards keeps
+//  working, and a video driver that can present truecolor composes the two.
+//
+
+#ifndef R_DRAW32_H__
+#define R_DRAW32_H__
+
+#include "doomtype.h"
+
+struct columndrawer_t;
+struct spandrawer_t;
+
+extern columndrawer_t r_truecolor_drawer;
+extern spandrawer_t   r_truecolorspandrawer;
+
+// 0x00RRGGBB pixels laid out exactly like renderscreen, or nullptr
+extern uint32_t *renderscreen32;
+
+#define R_ADDRESS32(px, py) \
+   (renderscreen32 + (viewwindow.y + (py)) + linesize * (viewwindow.x + (px)))
+
+// True while the view is being drawn by the truecolor engine
+extern bool r_truecolorview;
+
+//
+// Blends fg over bg with alpha in 0-256.
+//
+inline uint32_t R_BlendTrueColor(uint32_t fg, uint32_t bg, unsigned int alpha)
+{
+   const unsigned int inv = 256 - alpha;
+
+   return ((((fg & 0xff00ff) * alpha + (bg & 0xff00ff) * inv) >> 8) & 0xff00ff) |
+          ((((fg & 0x00ff00) * alpha + (bg & 0x00ff00) * inv) >> 8) & 0x00ff00);
+}
+
+void R_BeginTrueColorView();
+void R_EndTrueColorView();
+
+//
+// Video driver interface. The driver describes its 32-bit pixel format and
+// gets back lookups from paletted and truecolor pixels to displayed ones,
+// which R_ComposeTrueColor uses to expand every frame, truecolor or not.
+//
+struct truecolorout_t
+{
+   uint32_t palette[256];               // each palette index as displayed
+   uint32_t red[256], green[256], blue[256]; // each channel level as displayed
+};
+
+void R_SetTrueColorOutput(truecolorout_t &out, const byte *palette, const byte *gamma,
+                          int rshift, int gshift, int bshift, uint32_t amask);
+bool R_TrueColorFrame();
+void R_ComposeTrueColor(const truecolorout_t &out, bool withview, const byte *src, int srcpitch,
+                        uint32_t *dest, int destpitch, int width, int height);
+
+#endif
+
+// EOF
+
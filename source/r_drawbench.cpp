@@ -0,0 +1,532 @@
+//
+// The Eternity Engine
+// Copyright(C) 2026 James Haley, Max Waine, et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+// Additional terms and conditions compatible with the GPLv3 apply. See the
+// file COPYING-EE for details.
+//
+// Purpose: Renderer kernel benchmark, built as eternity-bench.
+//  Every kernel draws into an offscreen buffer laid out like the real one,
+//  from inputs made by a fixed-seed generator: columns of random heights,
+//  steps and texture offsets, spans and sloped spans of random lengths and
+//  steps, and a patch at random positions, each under one of a set of random
+//  colormaps. A kernel's inputs are made once and drawn -benchreps times;
+//  the figure given is time per pixel written. With -benchghz, the nominal
+//  clock in GHz, it is also given in cycles, since there is no cycle counter
+//  that means the same thing on every CPU this runs on.
+//
+//  The vector span drawers must match r_spandrawer exactly, so each one is
+//  run from the same starting screen as its scalar counterpart and the
+//  results compared. Any difference is reported and fails the run.
+//
+
+#include <chrono>
+
+#include "z_zone.h"
+
+#include "m_argv.h"
+#include "m_compare.h"
+#include "m_qstr.h"
+#include "r_draw.h"
+#include "r_drawbench.h"
+#include "r_main.h"
+#include "r_patch.h"
+#include "r_plane.h"
+#include "v_misc.h"
+#include "v_patch.h"
+#include "v_video.h"
+
+using benchclock_t = std::chrono::steady_clock;
+using benchns_t    = std::chrono::duration<double, std::nano>;
+
+static constexpr int BENCHWIDTH   = 640;
+static constexpr int BENCHHEIGHT  = 400;
+static constexpr int NUMBENCHMAPS = 32;   // the last 7 are only reached by fuzz
+static constexpr int NUMCOLUMNS   = 4096;
+static constexpr int NUMSPANS     = 2048;
+static constexpr int NUMPATCHES   = 256;
+static constexpr int BENCHFLAT    = 512;  // the texture buffer is the largest flat
+
+// Screen buffers are transposed: each column is contiguous
+static byte         benchscreen[BENCHWIDTH * BENCHHEIGHT];
+static byte         referencescreen[BENCHWIDTH * BENCHHEIGHT];
+static byte         benchtexture[BENCHFLAT * BENCHFLAT];
+static byte         benchalpha[BENCHFLAT * BENCHFLAT / 8];
+static lighttable_t benchmaps[NUMBENCHMAPS][256];
+static lighttable_t *benchslopemaps[BENCHWIDTH];
+static byte         benchtranslation[256];
+static byte         benchtranmap[256 * 256];
+static byte         benchpalette[768];
+
+static cb_column_t    benchcolumns[NUMCOLUMNS];
+static cb_span_t      benchspans[NUMSPANS];
+static cb_span_t      benchslopespans[NUMSPANS]; // same, with sloped shifts
+static cb_slopespan_t benchslopes[NUMSPANS];
+
+static uint32_t benchseed;
+static int      benchreps = 64;
+static double   benchghz;
+static int      benchfailures;
+
+static uint32_t R_benchRandom()
+{
+   benchseed = benchseed * 1664525u + 1013904223u;
+   return benchseed >> 8;
+}
+
+static int R_benchRange(int min, int max)
+{
+   return min + int(R_benchRandom() % unsigned(max - min + 1));
+}
+
+static void R_benchFill(byte *data, size_t size)
+{
+   for(size_t i = 0; i < size; i++)
+      data[i] = byte(R_benchRandom());
+}
+
+//
+// Sets up the tables and globals the drawers read, in place of R_Init.
+//
+static void R_benchSetup()
+{
+   int p;
+
+   if((p = M_CheckParm("-benchreps")) && ++p < myargc)
+      benchreps = emax(1, atoi(myargv[p]));
+   if((p = M_CheckParm("-benchghz")) && ++p < myargc)
+      benchghz = atof(myargv[p]);
+
+   benchseed = 1;
+   R_benchFill(benchpalette, sizeof(benchpalette));
+   R_benchFill(&benchmaps[0][0], sizeof(benchmaps));
+   R_benchFill(benchtexture, sizeof(benchtexture));
+   R_benchFill(benchalpha, sizeof(benchalpha));
+   R_benchFill(benchtranslation, sizeof(benchtranslation));
+   R_benchFill(benchtranmap, sizeof(benchtranmap));
+
+   V_InitFlexTranTable(benchpalette);
+   main_tranmap = benchtranmap;
+
+   renderscreen = benchscreen;
+   linesize     = BENCHHEIGHT;
+   viewwindow   = { 0, 0, BENCHWIDTH, BENCHHEIGHT };
+   video.width  = BENCHWIDTH;
+   video.height = BENCHHEIGHT;
+   view.ycenter = BENCHHEIGHT / 2.0f;
+
+   for(int x = 0; x < BENCHWIDTH; x++)
+      benchslopemaps[x] = benchmaps[x % (NUMBENCHMAPS - 7)];
+   cb_slopespan_t::colormap = benchslopemaps;
+
+   R_InitVectorSpanDrawer();
+}
+
+//
+// Gives the screen the same contents before every run, for the blending
+// drawers to read.
+//
+static void R_benchClearScreen()
+{
+   for(size_t i = 0; i < sizeof(benchscreen); i++)
+      benchscreen[i] = byte(i * 31 + (i >> 9));
+}
+
+//
+// Times a kernel. draw makes one pass over its inputs and returns how many
+// pixels it wrote; a first pass warms the caches.
+//
+template<typename F>
+static void R_benchKernel(const char *group, const char *name, F &&draw)
+{
+   R_benchClearScreen();
+
+   const int64_t pixels = draw();
+   const auto    start  = benchclock_t::now();
+
+   for(int i = 0; i < benchreps; i++)
+      draw();
+
+   const double ns = benchns_t(benchclock_t::now() - start).count() /
+                     (double(pixels) * benchreps);
+
+   if(benchghz > 0.0)
+      printf("%-8s %-24s %8.3f ns/px %8.3f cycles/px\n", group, name, ns, ns * benchghz);
+   else
+      printf("%-8s %-24s %8.3f ns/px\n", group, name, ns);
+}
+
+//
+// Draws one pass with a kernel and one with its reference from the same
+// starting screen, and reports how many pixels came out differently.
+//
+template<typename F, typename G>
+static void R_benchCompare(const char *group, const char *name, F &&draw, G &&reference)
+{
+   int differ = 0;
+
+   R_benchClearScreen();
+   reference();
+   memcpy(referencescreen, benchscreen, sizeof(benchscreen));
+
+   R_benchClearScreen();
+   draw();
+
+   for(size_t i = 0; i < sizeof(benchscreen); i++)
+   {
+      if(benchscreen[i] != referencescreen[i])
+         differ++;
+   }
+
+   if(differ)
+   {
+      printf("%-8s %-24s %d pixels differ from the scalar drawer\n", group, name, differ);
+      benchfailures++;
+   }
+}
+
+//=============================================================================
+//
+// Columns
+//
+
+static void R_benchMakeColumns(int texheight)
+{
+   benchseed = uint32_t(texheight);
+
+   for(cb_column_t &column : benchcolumns)
+   {
+      // fuzz reads a pixel above and below, so the edge rows stay clear
+      const int length = R_benchRange(1, BENCHHEIGHT - 2);
+
+      column = {};
+      column.x          = R_benchRange(0, BENCHWIDTH - 1);
+      column.y1         = R_benchRange(1, BENCHHEIGHT - 1 - length);
+      column.y2         = column.y1 + length - 1;
+      column.step       = R_benchRange(FRACUNIT / 4, FRACUNIT * 2);
+      column.texheight  = texheight;
+      column.texmid     = R_benchRange(0, texheight - 1) << FRACBITS;
+      column.colormap   = benchmaps[R_benchRange(0, NUMBENCHMAPS - 8)];
+      column.translation = benchtranslation;
+      column.tranmap    = benchtranmap;
+      column.translevel = R_benchRange(0, FRACUNIT);
+      column.skycolor   = byte(R_benchRandom());
+      column.source     = benchtexture + R_benchRange(0, BENCHFLAT * (BENCHFLAT - 1));
+   }
+}
+
+static int64_t R_benchColumns(R_ColumnFunc func)
+{
+   int64_t pixels = 0;
+
+   for(cb_column_t column : benchcolumns) // copied; some drawers adjust it
+   {
+      pixels += column.y2 - column.y1 + 1;
+      func(column);
+   }
+   return pixels;
+}
+
+static void R_benchAllColumns()
+{
+   static const struct
+   {
+      const char  *name;
+      R_ColumnFunc columndrawer_t::*func;
+   } kernels[] =
+   {
+      { "column",     &columndrawer_t::DrawColumn       },
+      { "sky",        &columndrawer_t::DrawSkyColumn    },
+      { "newsky",     &columndrawer_t::DrawNewSkyColumn },
+      { "tl",         &columndrawer_t::DrawTLColumn     },
+      { "tr",         &columndrawer_t::DrawTRColumn     },
+      { "tltr",       &columndrawer_t::DrawTLTRColumn   },
+      { "fuzz",       &columndrawer_t::DrawFuzzColumn   },
+      { "flex",       &columndrawer_t::DrawFlexColumn   },
+      { "flextr",     &columndrawer_t::DrawFlexTRColumn },
+      { "add",        &columndrawer_t::DrawAddColumn    },
+      { "addtr",      &columndrawer_t::DrawAddTRColumn  },
+   };
+
+   // a power of two height wraps by mask, any other by modulo
+   for(const int texheight : { 128, 72 })
+   {
+      R_benchMakeColumns(texheight);
+
+      for(const auto &kernel : kernels)
+      {
+         qstring name;
+         name.Printf(0, "%s_%d", kernel.name, texheight);
+
+         const R_ColumnFunc func = r_normal_drawer.*kernel.func;
+         R_benchKernel("column", name.constPtr(), [func] { return R_benchColumns(func); });
+      }
+   }
+}
+
+//=============================================================================
+//
+// Spans and sloped spans
+//
+
+static const char *const stylenames[SPAN_NUMSTYLES] =
+{
+   "solid", "tl", "add", "solid_masked", "tl_masked", "add_masked"
+};
+
+static const char *const sizenames[FLAT_NUMSIZES] = { "64", "128", "256", "512", "gen" };
+
+//
+// Makes spans for one style and flat size. The generalized flat is 128x32.
+//
+static void R_benchMakeSpans(int style, int size)
+{
+   static const int flatbits[FLAT_NUMSIZES][2] =
+   {
+      { 6, 6 }, { 7, 7 }, { 8, 8 }, { 9, 9 }, { 7, 5 },
+   };
+   const int rw = flatbits[size][0], rh = flatbits[size][1];
+
+   benchseed = uint32_t(style * FLAT_NUMSIZES + size + 1);
+
+   const int level = R_benchRange(8, 56);
+
+   for(int i = 0; i < NUMSPANS; i++)
+   {
+      cb_span_t      &span  = benchspans[i];
+      cb_slopespan_t &slope = benchslopes[i];
+
+      span = {};
+      span.y         = R_benchRange(0, BENCHHEIGHT - 1);
+      span.x1        = R_benchRange(0, BENCHWIDTH - 1);
+      span.x2        = R_benchRange(span.x1, BENCHWIDTH - 1);
+      span.xfrac     = R_benchRandom() << 8;
+      span.yfrac     = R_benchRandom() << 8;
+      span.xstep     = R_benchRandom() << 2;
+      span.ystep     = R_benchRandom() << 2;
+      span.source    = benchtexture;
+      span.colormap  = benchmaps[R_benchRange(0, NUMBENCHMAPS - 8)];
+      span.alphamask = benchalpha;
+      span.alpha     = unsigned(level << 2);
+
+      // as R_DrawPlane sets them for an unsloped plane
+      span.yshift = 32 - rh;
+      span.xshift = span.yshift - rw;
+      span.xmask  = ((1u << rw) - 1) << (32 - rw - span.xshift);
+
+      if(style == SPAN_STYLE_ADD || style == SPAN_STYLE_ADD_MASKED)
+      {
+         span.fg2rgb = Col2RGB8_LessPrecision[level];
+         span.bg2rgb = Col2RGB8_LessPrecision[64];
+      }
+      else
+      {
+         span.fg2rgb = Col2RGB8[level];
+         span.bg2rgb = Col2RGB8[64 - level];
+      }
+
+      // and for a sloped one
+      benchslopespans[i] = span;
+      benchslopespans[i].xshift = 16 - rh;
+      benchslopespans[i].xmask  = ((1u << rw) - 1) << rh;
+      benchslopespans[i].ymask  = (1u << rh) - 1;
+
+      slope.y       = span.y;
+      slope.x1      = span.x1;
+      slope.x2      = span.x2;
+      slope.source  = benchtexture;
+      slope.idfrac  = 1.0 + R_benchRange(0, 1024) / 1024.0;
+      slope.idstep  = R_benchRange(1, 64) / 65536.0;
+      slope.iufrac  = R_benchRange(0, 1 << 16) / 1024.0 * slope.idfrac;
+      slope.ivfrac  = R_benchRange(0, 1 << 16) / 1024.0 * slope.idfrac;
+      slope.iustep  = R_benchRange(1, 1024) / 1024.0;
+      slope.ivstep  = R_benchRange(1, 1024) / 1024.0;
+   }
+}
+
+static int64_t R_benchFlats(R_FlatFunc func)
+{
+   int64_t pixels = 0;
+
+   for(const cb_span_t &span : benchspans)
+   {
+      pixels += span.x2 - span.x1 + 1;
+      func(span);
+   }
+   return pixels;
+}
+
+static int64_t R_benchSlopes(R_SlopeFunc func)
+{
+   int64_t pixels = 0;
+
+   for(int i = 0; i < NUMSPANS; i++)
+   {
+      pixels += benchslopes[i].x2 - benchslopes[i].x1 + 1;
+      func(benchslopes[i], benchslopespans[i]);
+   }
+   return pixels;
+}
+
+static void R_benchAllSpans()
+{
+   static const struct
+   {
+      const char         *name;
+      const char         *slopename;
+      const spandrawer_t *drawer;
+   } engines[] =
+   {
+      { "span",    "slope",    &r_spandrawer    },
+      { "lpspan",  "lpslope",  &r_lpspandrawer  },
+      { "vecspan", "vecslope", &r_vecspandrawer },
+   };
+
+   for(int style = 0; style < SPAN_NUMSTYLES; style++)
+   {
+      for(int size = 0; size < FLAT_NUMSIZES; size++)
+      {
+         qstring name;
+         name.Printf(0, "%s_%s", stylenames[style], sizenames[size]);
+         R_benchMakeSpans(style, size);
+
+         for(const auto &engine : engines)
+         {
+            const R_FlatFunc  flat  = engine.drawer->DrawSpan[style][size];
+            const R_SlopeFunc slope = engine.drawer->DrawSlope[style][size];
+
+            R_benchKernel(engine.name, name.constPtr(), [flat] { return R_benchFlats(flat); });
+            R_benchKernel(engine.slopename, name.constPtr(), [slope] { return R_benchSlopes(slope); });
+         }
+
+         const R_SlopeFunc exact = r_exactslopes[style][size];
+         R_benchKernel("exact", name.constPtr(), [exact] { return R_benchSlopes(exact); });
+
+         // the vector drawers must match the scalar ones they stand in for
+         const R_FlatFunc  vecflat  = r_vecspandrawer.DrawSpan[style][size];
+         const R_FlatFunc  flat     = r_spandrawer.DrawSpan[style][size];
+         const R_SlopeFunc vecslope = r_vecspandrawer.DrawSlope[style][size];
+         const R_SlopeFunc slope    = r_spandrawer.DrawSlope[style][size];
+
+         if(vecflat != flat)
+         {
+            R_benchCompare("vecspan", name.constPtr(),
+                           [vecflat] { R_benchFlats(vecflat); }, [flat] { R_benchFlats(flat); });
+         }
+         if(vecslope != slope)
+         {
+            R_benchCompare("vecslope", name.constPtr(),
+                           [vecslope] { R_benchSlopes(vecslope); }, [slope] { R_benchSlopes(slope); });
+         }
+      }
+   }
+}
+
+//=============================================================================
+//
+// Patches
+//
+
+static void R_benchAllPatches()
+{
+   static const struct
+   {
+      const char *name;
+      int         drawstyle;
+   } kernels[] =
+   {
+      { "normal",   PSTYLE_NORMAL      },
+      { "tlated",   PSTYLE_TLATED      },
+      { "transluc", PSTYLE_TRANSLUC    },
+      { "add",      PSTYLE_ADD         },
+      { "tlatedlit", PSTYLE_TLATEDLIT  },
+   };
+   static constexpr int PATCHW = 64, PATCHH = 128;
+
+   // texel 0 is transparent, which breaks the patch into posts
+   int64_t opaque = 0;
+   for(int i = 0; i < PATCHW * PATCHH; i++)
+   {
+      if(benchtexture[i])
+         opaque++;
+   }
+
+   patch_t *patch = V_LinearToTransPatch(benchtexture, PATCHW, PATCHH, nullptr, 0, PU_STATIC);
+
+   VBuffer buffer;
+   V_InitVBufferFrom(&buffer, BENCHWIDTH, BENCHHEIGHT, BENCHHEIGHT, 8, benchscreen);
+
+   int positions[NUMPATCHES][2];
+   benchseed = 1;
+   for(auto &position : positions)
+   {
+      position[0] = R_benchRange(0, BENCHWIDTH - PATCHW);
+      position[1] = R_benchRange(0, BENCHHEIGHT - PATCHH);
+   }
+
+   for(const auto &kernel : kernels)
+   {
+      R_benchKernel("patch", kernel.name, [&] {
+         for(const auto &position : positions)
+         {
+            PatchInfo         pi = { patch, position[0], position[1], false, kernel.drawstyle };
+            cb_patch_column_t patchcol = {};
+
+            patchcol.translation = benchtranslation;
+            patchcol.light       = benchmaps[1];
+            if(kernel.drawstyle == PSTYLE_ADD)
+            {
+               patchcol.fg2rgb = Col2RGB8_LessPrecision[40];
+               patchcol.bg2rgb = Col2RGB8_LessPrecision[64];
+            }
+            else
+            {
+               patchcol.fg2rgb = Col2RGB8[40];
+               patchcol.bg2rgb = Col2RGB8[24];
+            }
+            V_DrawPatchInt(patchcol, &pi, &buffer);
+         }
+         return opaque * NUMPATCHES;
+      });
+   }
+
+   V_FreeVBuffer(&buffer);
+   Z_Free(patch);
+}
+
+//
+// Entry point of eternity-bench. Returns the exit status: nonzero if a
+// vector drawer disagreed with the scalar one.
+//
+int R_DrawBenchMain()
+{
+   R_benchSetup();
+
+   printf("eternity-bench: %dx%d buffer, %d passes per kernel\n",
+          BENCHWIDTH, BENCHHEIGHT, benchreps);
+
+   R_benchAllColumns();
+   R_benchAllSpans();
+   R_benchAllPatches();
+
+   if(benchfailures)
+      printf("%d vector drawers differ from the scalar ones\n", benchfailures);
+
+   return benchfailures ? 1 : 0;
+}
+
+// EOF
+
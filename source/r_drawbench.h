@@ -0,0 +1,35 @@
+//
+// The Eternity Engine
+// Copyright(C) 2026 James Haley, Max Waine, et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+// Additional terms and conditions compatible with the GPLv3 apply. See the
+// file COPYING-EE for details.
+//
+// Purpose: Renderer kernel benchmark, built as eternity-bench.
+//  The 8-bit column, span, slope and patch drawers are timed on synthetic
+//  inputs, with no WAD loaded and no video mode set, and the vector span
+//  drawers are checked against the scalar ones.
+//
+
+#ifndef R_DRAWBENCH_H__
+#define R_DRAWBENCH_H__
+
+int R_DrawBenchMain();
+
+#endif
+
+// EOF
+
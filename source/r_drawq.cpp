@@ -0,0 +1,310 @@
+//
+// The Eternity Engine
+// Copyright(C) 2026 James Haley, Max Waine, et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+// Additional terms and conditions compatible with the GPLv3 apply. See the
+// file COPYING-EE for details.
+//
+// Purpose: Quad column drawer.
+//  Buffers up to four horizontally adjacent columns that share a colormap and
+//  a power-of-two texture height, then draws the rows they have in common in
+//  one pass, stepping all four texture coordinates together in a vector
+//  register. Anything that can't be buffered flushes the queue first and
+//  falls through to the normal drawer, so draw order is always preserved.
+//
+
+#include "z_zone.h"
+#include "i_system.h"
+
+#include "m_compare.h"
+#include "m_simd.h"
+#include "r_draw.h"
+#include "r_main.h"
+#include "v_misc.h"
+
+static constexpr int QUADCOLUMNS = 4;
+
+//
+// Columns waiting to be drawn. Each render context thread has its own queue.
+//
+struct quadqueue_t
+{
+   cb_column_t columns[QUADCOLUMNS];
+   int         numcolumns;
+};
+
+static thread_local quadqueue_t quadqueue;
+
+//
+// Draws count pixels of a single column starting at dest, leaving frac at the
+// value for the next pixel. Texture height must be a power of two.
+//
+static inline void R_drawQuadRun(byte *dest, fixed_t &frac, const fixed_t fracstep, int count,
+                                 const byte *source, const lighttable_t *colormap,
+                                 const int heightmask)
+{
+   while(count-- > 0)
+   {
+      *dest++ = colormap[source[(frac >> FRACBITS) & heightmask]];
+      frac += fracstep;
+   }
+}
+
+//
+// Draws count rows of four adjacent columns at once. dest is the top of the
+// leftmost column; the other three follow at linesize intervals.
+//
+static void R_drawQuadRows(byte *dest, fixed_t fracs[QUADCOLUMNS],
+                           const fixed_t steps[QUADCOLUMNS], int count,
+                           const byte *const sources[QUADCOLUMNS],
+                           const lighttable_t *colormap, const int heightmask)
+{
+   byte *const dest0 = dest;
+   byte *const dest1 = dest0 + linesize;
+   byte *const dest2 = dest1 + linesize;
+   byte *const dest3 = dest2 + linesize;
+
+   const byte *const src0 = sources[0];
+   const byte *const src1 = sources[1];
+   const byte *const src2 = sources[2];
+   const byte *const src3 = sources[3];
+
+#if defined(EE_SIMD_SSE2)
+   __m128i vfrac = _mm_loadu_si128(reinterpret_cast<const __m128i *>(fracs));
+   const __m128i vstep = _mm_loadu_si128(reinterpret_cast<const __m128i *>(steps));
+   const __m128i vmask = _mm_set1_epi32(heightmask);
+   alignas(16) int32_t index[QUADCOLUMNS];
+
+   for(int y = 0; y < count; y++)
+   {
+      _mm_store_si128(reinterpret_cast<__m128i *>(index),
+                      _mm_and_si128(_mm_srli_epi32(vfrac, FRACBITS), vmask));
+      vfrac = _mm_add_epi32(vfrac, vstep);
+
+      dest0[y] = colormap[src0[index[0]]];
+      dest1[y] = colormap[src1[index[1]]];
+      dest2[y] = colormap[src2[index[2]]];
+      dest3[y] = colormap[src3[index[3]]];
+   }
+
+   _mm_storeu_si128(reinterpret_cast<__m128i *>(fracs), vfrac);
+#elif defined(EE_SIMD_NEON)
+   int32x4_t       vfrac = vld1q_s32(fracs);
+   const int32x4_t vstep = vld1q_s32(steps);
+   const int32x4_t vmask = vdupq_n_s32(heightmask);
+   int32_t index[QUADCOLUMNS];
+
+   for(int y = 0; y < count; y++)
+   {
+      vst1q_s32(index, vandq_s32(vshrq_n_s32(vfrac, FRACBITS), vmask));
+      vfrac = vaddq_s32(vfrac, vstep);
+
+      dest0[y] = colormap[src0[index[0]]];
+      dest1[y] = colormap[src1[index[1]]];
+      dest2[y] = colormap[src2[index[2]]];
+      dest3[y] = colormap[src3[index[3]]];
+   }
+
+   vst1q_s32(fracs, vfrac);
+#else
+   // Four independent chains still pipeline far better than one
+   fixed_t frac0 = fracs[0], frac1 = fracs[1], frac2 = fracs[2], frac3 = fracs[3];
+
+   for(int y = 0; y < count; y++)
+   {
+      dest0[y] = colormap[src0[(frac0 >> FRACBITS) & heightmask]];
+      dest1[y] = colormap[src1[(frac1 >> FRACBITS) & heightmask]];
+      dest2[y] = colormap[src2[(frac2 >> FRACBITS) & heightmask]];
+      dest3[y] = colormap[src3[(frac3 >> FRACBITS) & heightmask]];
+      frac0 += steps[0];
+      frac1 += steps[1];
+      frac2 += steps[2];
+      frac3 += steps[3];
+   }
+
+   fracs[0] = frac0;
+   fracs[1] = frac1;
+   fracs[2] = frac2;
+   fracs[3] = frac3;
+#endif
+}
+
+//
+// Draws a full queue of four columns: the rows above and below the span they
+// all share are drawn per column, the shared rows are drawn together.
+// Texture coordinates are derived exactly as CB_DrawColumn_8 does, so output
+// is identical to drawing the columns one by one.
+//
+static void R_drawQuadQueue(quadqueue_t &queue)
+{
+   const cb_column_t *const columns = queue.columns;
+   const lighttable_t *colormap     = columns[0].colormap;
+   const int           heightmask   = columns[0].texheight - 1;
+
+   int top    = columns[0].y1;
+   int bottom = columns[0].y2;
+   for(int i = 1; i < QUADCOLUMNS; i++)
+   {
+      top    = emax(top,    columns[i].y1);
+      bottom = emin(bottom, columns[i].y2);
+   }
+
+   fixed_t     fracs[QUADCOLUMNS];
+   fixed_t     steps[QUADCOLUMNS];
+   const byte *sources[QUADCOLUMNS];
+
+   for(int i = 0; i < QUADCOLUMNS; i++)
+   {
+      const cb_column_t &column = columns[i];
+
+      steps[i]   = column.step;
+      sources[i] = static_cast<const byte *>(column.source);
+      fracs[i]   = column.texmid + int((column.y1 - (view.ycenter + column.ycenteroffset) + 1) * column.step);
+
+      // Rows above the shared span (everything, if there is no shared span)
+      const int headend = top <= bottom ? top : column.y2 + 1;
+      R_drawQuadRun(R_ADDRESS(column.x, column.y1), fracs[i], steps[i], headend - column.y1,
+                    sources[i], colormap, heightmask);
+   }
+
+   if(top > bottom)
+      return;
+
+   R_drawQuadRows(R_ADDRESS(columns[0].x, top), fracs, steps, bottom - top + 1, sources,
+                  colormap, heightmask);
+
+   // Rows below the shared span
+   for(int i = 0; i < QUADCOLUMNS; i++)
+   {
+      const cb_column_t &column = columns[i];
+
+      R_drawQuadRun(R_ADDRESS(column.x, bottom + 1), fracs[i], steps[i], column.y2 - bottom,
+                    sources[i], colormap, heightmask);
+   }
+}
+
+//
+// Draws whatever is in the calling thread's queue and empties it.
+//
+static void R_flushQuadColumns()
+{
+   quadqueue_t &queue = quadqueue;
+
+   if(queue.numcolumns == QUADCOLUMNS)
+      R_drawQuadQueue(queue);
+   else
+   {
+      for(int i = 0; i < queue.numcolumns; i++)
+         r_normal_drawer.DrawColumn(queue.columns[i]);
+   }
+
+   queue.numcolumns = 0;
+}
+
+//
+// Buffered equivalent of CB_DrawColumn_8.
+//
+static void CB_DrawQuadColumn_8(cb_column_t &column)
+{
+   if(column.y2 < column.y1)
+      return;
+
+#ifdef RANGECHECK
+   if(column.x  < 0 || column.x  >= video.width ||
+      column.y1 < 0 || column.y2 >= video.height)
+      I_Error("CB_DrawQuadColumn_8: %i to %i at %i\n", column.y1, column.y2, column.x);
+#endif
+
+   quadqueue_t &queue = quadqueue;
+
+   // Non-power-of-two textures need the modulo loop; don't buffer them
+   if(column.texheight & (column.texheight - 1))
+   {
+      R_flushQuadColumns();
+      r_normal_drawer.DrawColumn(column);
+      return;
+   }
+
+   if(queue.numcolumns)
+   {
+      const cb_column_t &last = queue.columns[queue.numcolumns - 1];
+
+      if(column.x != last.x + 1 || column.colormap != last.colormap ||
+         column.texheight != last.texheight)
+         R_flushQuadColumns();
+   }
+
+   queue.columns[queue.numcolumns++] = column;
+
+   if(queue.numcolumns == QUADCOLUMNS)
+      R_flushQuadColumns();
+}
+
+//
+// Everything other than plain columns is drawn immediately after a flush.
+//
+#define QUAD_FLUSHED(func)                               \
+   static void CB_Quad ## func(cb_column_t &column)      \
+   {                                                     \
+      R_flushQuadColumns();                              \
+      r_normal_drawer.func(column);                      \
+   }
+
+QUAD_FLUSHED(DrawSkyColumn)
+QUAD_FLUSHED(DrawNewSkyColumn)
+QUAD_FLUSHED(DrawTLColumn)
+QUAD_FLUSHED(DrawTRColumn)
+QUAD_FLUSHED(DrawTLTRColumn)
+QUAD_FLUSHED(DrawFuzzColumn)
+QUAD_FLUSHED(DrawFlexColumn)
+QUAD_FLUSHED(DrawFlexTRColumn)
+QUAD_FLUSHED(DrawAddColumn)
+QUAD_FLUSHED(DrawAddTRColumn)
+
+#undef QUAD_FLUSHED
+
+//
+// Quad Column Drawer Object
+//
+columndrawer_t r_quad_drawer =
+{
+   CB_DrawQuadColumn_8,
+   CB_QuadDrawSkyColumn,
+   CB_QuadDrawNewSkyColumn,
+   CB_QuadDrawTLColumn,
+   CB_QuadDrawTRColumn,
+   CB_QuadDrawTLTRColumn,
+   CB_QuadDrawFuzzColumn,
+   CB_QuadDrawFlexColumn,
+   CB_QuadDrawFlexTRColumn,
+   CB_QuadDrawAddColumn,
+   CB_QuadDrawAddTRColumn,
+
+   R_flushQuadColumns,
+
+   {
+      // Normal                Translated
+      { CB_DrawQuadColumn_8,     CB_QuadDrawTRColumn     }, // NORMAL
+      { CB_QuadDrawFuzzColumn,   CB_QuadDrawFuzzColumn   }, // SHADOW
+      { CB_QuadDrawFlexColumn,   CB_QuadDrawFlexTRColumn }, // ALPHA
+      { CB_QuadDrawAddColumn,    CB_QuadDrawAddTRColumn  }, // ADD
+      { CB_QuadDrawTLColumn,     CB_QuadDrawTLTRColumn   }, // SUB
+      { CB_QuadDrawTLColumn,     CB_QuadDrawTLTRColumn   }, // TRANMAP
+   },
+};
+
+// EOF
+
@@ -0,0 +1,246 @@
+//
+// The Eternity Engine
+// Copyright(C) 2026 James Haley, Max Waine, et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+// Additional terms and conditions compatible with the GPLv3 apply. See the
+// file COPYING-EE for details.
+//
+// Purpose: Compile-time drawer policies.
+//  The column, span and patch drawers are generated from one inner loop each,
+//  parameterized on how a texel is remapped, how it is blended with the
+//  destination, how the texture coordinate wraps, and (for flats) how the
+//  texel address is formed. Every policy is a small value type so that the
+//  compiler can fold it away entirely.
+//
+
+#ifndef R_DRAWT_H__
+#define R_DRAWT_H__
+
+#include "m_fixed.h"
+#include "r_defs.h"
+#include "r_plane.h"
+#include "v_video.h"
+
+//==============================================================================
+//
+// Remap policies: palette index lookups applied to a source texel
+//
+
+// No remapping, for patches drawn as-is
+struct remapnone
+{
+   byte Remap(byte c) const { return c; }
+};
+
+// One table, usually a colormap or a translation
+struct remapone
+{
+   const byte *table;
+
+   explicit remapone(const byte *t) : table(t) {}
+   byte Remap(byte c) const { return table[c]; }
+};
+
+// A translation followed by a colormap
+struct remaptwo
+{
+   const byte *first, *second;
+
+   remaptwo(const byte *f, const byte *s) : first(f), second(s) {}
+   byte Remap(byte c) const { return second[first[c]]; }
+};
+
+//==============================================================================
+//
+// Blend policies: combine the remapped source color with the destination
+//
+
+// Source replaces destination
+struct blendopaque
+{
+   byte Blend(byte fg, byte) const { return fg; }
+};
+
+// BOOM TRANMAP lookup
+struct blendtranmap
+{
+   const byte *map;
+
+   explicit blendtranmap(const byte *m) : map(m) {}
+   byte Blend(byte fg, byte bg) const { return map[(bg << 8) + fg]; }
+};
+
+// zdoom-style flexible translucency
+struct blendflex
+{
+   const unsigned int *fg2rgb, *bg2rgb;
+
+   blendflex(const unsigned int *fg, const unsigned int *bg) : fg2rgb(fg), bg2rgb(bg) {}
+   byte Blend(byte fg, byte bg) const
+   {
+      unsigned int t = (fg2rgb[fg] + bg2rgb[bg]) | 0x1f07c1f;
+      return RGB32k[0][0][t & (t >> 15)];
+   }
+};
+
+// Additive translucency
+struct blendadd
+{
+   const unsigned int *fg2rgb, *bg2rgb;
+
+   blendadd(const unsigned int *fg, const unsigned int *bg) : fg2rgb(fg), bg2rgb(bg) {}
+   byte Blend(byte fg, byte bg) const
+   {
+      // mask out LSBs in green and red to allow overflow
+      unsigned int a = fg2rgb[fg] + bg2rgb[bg];
+      unsigned int b = a;
+
+      a |= 0x01f07c1f;
+      b &= 0x40100400;
+      a &= 0x3fffffff;
+      b  = b - (b >> 5);
+      a |= b;
+      return RGB32k[0][0][a & (a >> 15)];
+   }
+};
+
+// Span blend policies: flats carry their translucency lookups in the span
+
+struct spanblendsolid
+{
+   static blendopaque Make(const cb_span_t &) { return blendopaque(); }
+};
+
+struct spanblendtl
+{
+   static blendflex Make(const cb_span_t &span) { return blendflex(span.fg2rgb, span.bg2rgb); }
+};
+
+struct spanblendadd
+{
+   static blendadd Make(const cb_span_t &span) { return blendadd(span.fg2rgb, span.bg2rgb); }
+};
+
+//==============================================================================
+//
+// Wrap policies: texture coordinate to texel row for columns
+//
+
+// Coordinate never leaves the texture (patches)
+struct wrapnone
+{
+   int Index(fixed_t frac) const { return frac >> FRACBITS; }
+   fixed_t Step(fixed_t frac, fixed_t step) const { return frac + step; }
+};
+
+// Power-of-two texture height: mask the row
+struct wrapmask
+{
+   int mask;
+
+   explicit wrapmask(int m) : mask(m) {}
+   int Index(fixed_t frac) const { return (frac >> FRACBITS) & mask; }
+   fixed_t Step(fixed_t frac, fixed_t step) const { return frac + step; }
+};
+
+// Any other height: the Tutti-Frutti fix -- killough. frac must already be in
+// [0, fracheight) and the step smaller than fracheight.
+struct wrapmodulo
+{
+   fixed_t fracheight;
+
+   explicit wrapmodulo(fixed_t h) : fracheight(h) {}
+   int Index(fixed_t frac) const { return frac >> FRACBITS; }
+   fixed_t Step(fixed_t frac, fixed_t step) const
+   {
+      return (frac += step) >= fracheight ? frac - fracheight : frac;
+   }
+};
+
+//
+// The inner loop shared by every column-shaped drawer: count pixels down from
+// dest, which must be at least 1. P is the framebuffer pixel type.
+//
+template<typename P, typename W, typename R, typename B>
+inline void R_DrawColumnRun(P *dest, int count, fixed_t frac, const fixed_t fracstep,
+                            const byte *source, const W &wrap, const R &remap, const B &blend)
+{
+   do
+   {
+      *dest = blend.Blend(remap.Remap(source[wrap.Index(frac)]), *dest);
+      ++dest;
+      frac = wrap.Step(frac, fracstep);
+   }
+   while(--count);
+}
+
+//==============================================================================
+//
+// Shift policies: texel address for orthogonal and sloped flat spans
+//
+
+// Constant shifts and mask for a square power-of-two flat
+template<int xshift, int yshift, int xmask>
+struct spanconsts
+{
+   explicit spanconsts(const cb_span_t &) {}
+   int XShift() const { return xshift; }
+   int YShift() const { return yshift; }
+   int XMask()  const { return xmask;  }
+};
+
+// Shifts and mask read from the span, for generalized flats
+struct spanvalues
+{
+   int xshift, yshift, xmask;
+
+   explicit spanvalues(const cb_span_t &span)
+      : xshift(int(span.xshift)), yshift(int(span.yshift)), xmask(int(span.xmask))
+   {
+   }
+   int XShift() const { return xshift; }
+   int YShift() const { return yshift; }
+   int XMask()  const { return xmask;  }
+};
+
+// Constant shift and masks for a square power-of-two sloped flat
+template<int xshift, int xmask, int ymask>
+struct slopeconsts
+{
+   explicit slopeconsts(const cb_span_t &) {}
+   int XShift() const { return xshift; }
+   int XMask()  const { return xmask;  }
+   int YMask()  const { return ymask;  }
+};
+
+// Shift and masks read from the span, for generalized sloped flats
+struct slopevalues
+{
+   int xshift, xmask, ymask;
+
+   explicit slopevalues(const cb_span_t &span)
+      : xshift(int(span.xshift)), xmask(int(span.xmask)), ymask(int(span.ymask))
+   {
+   }
+   int XShift() const { return xshift; }
+   int XMask()  const { return xmask;  }
+   int YMask()  const { return ymask;  }
+};
+
+#endif
+
+// EOF
+
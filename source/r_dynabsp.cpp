@@ -31,9 +31,31 @@
 
 #include "z_zone.h"
 
+#include "c_io.h"
+#include "c_runcmd.h"
 #include "i_system.h"
+#include "m_compare.h"
 #include "p_setup.h"
 #include "r_dynabsp.h"
+#include "v_misc.h"
+
+//=============================================================================
+//
+// Statistics
+//
+
+struct dynabspstats_t
+{
+   int      builds;   // trees built
+   int      segs;     // dynasegs fed to them
+   int      sampled;  // partition searches that only tried a sample
+};
+
+static dynabspstats_t dynabspframe;   // current frame
+static dynabspstats_t dynabsplast;    // last complete frame
+static dynabspstats_t dynabsppeak;    // worst frame since reset
+static uint64_t       dynabsptotal;   // trees built since reset
+static uint64_t       dynabspframes;  // frames since reset
 
 //=============================================================================
 //
@@ -121,6 +143,11 @@ static inline bool nearzero(double d)
 // I have no idea why "17" is good, but let's stick with it.
 #define FACTOR 17
 
+// Past this many segs, only an evenly spread sample of about as many are tried
+// as partitions, each still checked against every seg. This keeps the search
+// linear in the seg count for subsectors crowded with polyobject fragments.
+#define MAXPARTITIONCANDIDATES 32
+
 //
 // R_selectPartition
 //
@@ -143,9 +170,18 @@ static dynaseg_t *R_selectPartition(dseglist_t segs)
    for(rover = segs; rover; rover = rover->dllNext)
       ++cnt;
 
-   // Try each seg as a partition line
+   int stride = (cnt + MAXPARTITIONCANDIDATES - 1) / MAXPARTITIONCANDIDATES;
+   if(stride > 1)
+      dynabspframe.sampled++;
+
+retry:
+   // Try each seg, or every stride'th one, as a partition line
+   int index = 0;
    for(rover = segs; rover; rover = rover->dllNext)
    {
+      if(index++ % stride)
+         continue;
+
       dynaseg_t  *part = *rover;
       dseglink_t *crover;
       int cost = 0, tot = 0, diff = cnt;
@@ -211,6 +247,13 @@ leftside:
 prune: ; // early exit and skip past the tests above
    } // end for
 
+   // If no sampled seg had segs on both sides, one that wasn't tried might
+   if(!best && stride > 1)
+   {
+      stride = 1;
+      goto retry;
+   }
+
    // haleyjd: failsafe. Maybe there's just one left in the list. I'm not
    // taking any chances that the above algorithm might freak out when that
    // becomes the case. I KNOW the list is not empty.
@@ -579,6 +622,7 @@ static bool R_collapseFragmentsToDSList(const subsector_t *subsec, dseglist_t *l
       {
          R_setupDSForBSP(*ds);
          ds->bsplink.insert(ds, list);
+         dynabspframe.segs++;
 
          // NB: fragment links are not disturbed by this process.
          ds = ds->subnext;
@@ -675,6 +719,8 @@ rpolybsp_t *R_BuildDynaBSP(const subsector_t *subsec)
       bsp->root = R_createNode(&segs);
    }
 
+   dynabspframe.builds++;
+
    return bsp;
 }
 
@@ -689,5 +735,42 @@ void R_FreeDynaBSP(rpolybsp_t *bsp)
    efree(bsp);
 }
 
+//
+// Closes the statistics for the frame just rendered.
+//
+void R_DynaBSPFrame()
+{
+   dynabsplast = dynabspframe;
+   dynabsppeak.builds  = emax(dynabsppeak.builds,  dynabspframe.builds);
+   dynabsppeak.segs    = emax(dynabsppeak.segs,    dynabspframe.segs);
+   dynabsppeak.sampled = emax(dynabsppeak.sampled, dynabspframe.sampled);
+   dynabsptotal += dynabspframe.builds;
+   dynabspframes++;
+   dynabspframe = {};
+}
+
+//
+// Reports how often polyobject subsectors had their trees rebuilt.
+//
+CONSOLE_COMMAND(r_dynabspstats, 0)
+{
+   if(Console.argc >= 1 && !Console.argv[0]->strCaseCmp("reset"))
+   {
+      dynabsplast = dynabsppeak = {};
+      dynabsptotal = dynabspframes = 0;
+      C_Printf("Dynamic BSP statistics reset.\n");
+      return;
+   }
+
+   C_Printf(FC_HI "Dynamic BSP rebuilds:\n" FC_NORMAL
+            "  last frame: %d trees, %d segs, %d sampled searches\n"
+            "  peak frame: %d trees, %d segs, %d sampled searches\n"
+            "  average:    %.2f trees per frame over %llu frames\n",
+            dynabsplast.builds, dynabsplast.segs, dynabsplast.sampled,
+            dynabsppeak.builds, dynabsppeak.segs, dynabsppeak.sampled,
+            dynabspframes ? double(dynabsptotal) / double(dynabspframes) : 0.0,
+            static_cast<unsigned long long>(dynabspframes));
+}
+
 // EOF
 
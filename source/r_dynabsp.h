@@ -44,6 +44,7 @@ struct rpolybsp_t
 
 rpolybsp_t *R_BuildDynaBSP(const subsector_t *subsec);
 void R_FreeDynaBSP(rpolybsp_t *bsp);
+void R_DynaBSPFrame();
 
 
 //
@@ -0,0 +1,243 @@
+//
+// The Eternity Engine
+// Copyright(C) 2026 James Haley, Max Waine, et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+// Additional terms and conditions compatible with the GPLv3 apply. See the
+// file COPYING-EE for details.
+//
+//
+// Purpose: Dynamic render resolution.
+//  The view is drawn in steps of 5% of its size, from r_dynres_min up to
+//  the whole. A smoothed frame time, from the end of the pacing wait to the
+//  end of the view, sets the next scale. Cost goes with the number of
+//  pixels, so the guess is the square root of how far the frame is from
+//  its budget. After every change the scale is held for a few frames, since
+//  each one redoes the view setup. A scaled view is drawn into its own
+//  buffer, in the same layout as the screen, and expanded by
+//  nearest-neighbour into the view's place on the screen.
+//
+
+#include <math.h>
+
+#include "z_zone.h"
+
+#include "hal/i_timer.h"
+
+#include "c_runcmd.h"
+#include "doomstat.h"
+#include "m_compare.h"
+#include "r_draw.h"
+#include "r_dynres.h"
+#include "r_main.h"
+#include "r_renderbench.h"
+#include "v_alloc.h"
+#include "v_misc.h"
+
+static constexpr int DYNRESSTEP     = 5;  // scales are multiples of this percentage
+static constexpr int DYNRESMAXSTEP  = 15; // most the scale moves at once
+static constexpr int DYNRESHOLD     = 12; // frames to hold a new scale
+static constexpr int DYNRESHEADROOM = 85; // percentage of the budget to grow under
+
+bool r_dynres;
+int  r_dynresfps = 60;
+int  r_dynresmin = 50;
+
+static int      wantedscale  = 100; // percentage of the view to draw
+static int      appliedscale = 100; // what the view setup was made for
+static int      holdframes;
+static uint64_t framestart;         // when the current frame began, in us
+static double   frametime;          // smoothed, in us; 0 until measured
+
+static rrect_t  fullwindow;         // presentwindow, as of the last setup
+static byte    *dynresbuffer;       // linesize * video.width, or nullptr
+static int     *dynresrows;         // source row of each row of the view
+static bool     dynresactive;       // the current view may be scaled
+static bool     dynresview;         // the view being drawn is scaled
+
+VALLOCATION(dynresbuffer)
+{
+   // allocated on first use, once the video driver has settled the pitch
+   dynresbuffer = nullptr;
+   dynresrows   = ecalloctag(int *, h, sizeof(int), PU_VALLOC, nullptr);
+}
+
+//
+// Called at the top of the main loop, once any pacing wait is over.
+//
+void R_DynResStartFrame()
+{
+   framestart = i_haltimer.GetMicros();
+}
+
+//
+// Works out the view window to draw for the view's place on the screen. A
+// scaled view sits at the top left of the scaling buffer.
+//
+rrect_t R_DynResViewWindow(const rrect_t &window)
+{
+   fullwindow   = window;
+   appliedscale = wantedscale;
+
+   if(appliedscale >= 100)
+      return window;
+
+   rrect_t scaled;
+   scaled.x      = 0;
+   scaled.y      = 0;
+   scaled.width  = emax(1, window.width  * appliedscale / 100);
+   scaled.height = emax(1, window.height * appliedscale / 100);
+
+   for(int y = 0; y < window.height; y++)
+      dynresrows[y] = y * scaled.height / window.height;
+
+   return scaled;
+}
+
+//
+// Dynamic resolution never applies to timed runs, or where the caller
+// can't have it.
+//
+static bool R_dynResActive(bool allowed)
+{
+   return r_dynres && allowed && !timingdemo && !fastdemo && !renderbench;
+}
+
+//
+// Moves the wanted scale towards what would bring the frame time within
+// its budget.
+//
+static void R_updateWantedScale()
+{
+   const double budget = 1000000.0 / r_dynresfps;
+
+   if(holdframes)
+   {
+      holdframes--;
+      return;
+   }
+
+   int target = wantedscale;
+   if(frametime > budget)
+      target = int(wantedscale * sqrt(budget / frametime));
+   else if(frametime < budget * DYNRESHEADROOM / 100)
+      target = int(wantedscale * sqrt(budget * DYNRESHEADROOM / 100 / frametime));
+
+   target = eclamp(target, wantedscale - DYNRESMAXSTEP, wantedscale + DYNRESMAXSTEP);
+   target = eclamp(target / DYNRESSTEP * DYNRESSTEP, r_dynresmin, 100);
+
+   if(target != wantedscale)
+   {
+      wantedscale = target;
+      holdframes  = DYNRESHOLD;
+   }
+}
+
+//
+// Called before the view is drawn. allowed is false for whatever can't be
+// scaled afterwards, such as the truecolor engine. Redoes the view setup
+// if the scale has changed, and points the drawers at the scaling buffer.
+//
+void R_DynResBeginView(bool allowed)
+{
+   dynresactive = R_dynResActive(allowed);
+
+   if(!dynresactive)
+   {
+      wantedscale = 100;
+      frametime   = 0.0;
+      holdframes  = 0;
+   }
+   else if(wantedscale < r_dynresmin)
+      wantedscale = r_dynresmin;
+
+   if(wantedscale != appliedscale)
+      R_ExecuteSetViewSize();
+
+   dynresview = (appliedscale < 100);
+
+   if(dynresview)
+   {
+      if(!dynresbuffer)
+      {
+         dynresbuffer = ecalloctag(byte *, size_t(linesize) * video.width, 1,
+                                   PU_VALLOC, nullptr);
+      }
+      renderscreen = dynresbuffer;
+   }
+}
+
+//
+// Expands the scaled view into its place on the screen. Screen columns are
+// contiguous, so a column that repeats the one before it is copied whole.
+//
+static void R_expandView()
+{
+   const byte *lastsrc  = nullptr;
+   const byte *lastdest = nullptr;
+
+   for(int x = 0; x < fullwindow.width; x++)
+   {
+      const int   sx   = x * viewwindow.width / fullwindow.width;
+      const byte *src  = dynresbuffer + size_t(linesize) * sx;
+      byte       *dest = video.screens[0] + fullwindow.y +
+                         size_t(linesize) * (fullwindow.x + x);
+
+      if(src == lastsrc)
+         memcpy(dest, lastdest, fullwindow.height);
+      else
+      {
+         for(int y = 0; y < fullwindow.height; y++)
+            dest[y] = src[dynresrows[y]];
+      }
+
+      lastsrc  = src;
+      lastdest = dest;
+   }
+}
+
+//
+// Called once the view is drawn. Puts a scaled view on the screen and
+// takes the frame time so far for the next scale.
+//
+void R_DynResEndView()
+{
+   if(dynresview)
+   {
+      R_expandView();
+      renderscreen = video.screens[0];
+      dynresview   = false;
+   }
+
+   if(!dynresactive || !framestart)
+      return;
+
+   const double took = double(i_haltimer.GetMicros() - framestart);
+
+   frametime = frametime > 0.0 ? frametime + (took - frametime) / 8 : took;
+   R_updateWantedScale();
+}
+
+VARIABLE_TOGGLE(r_dynres, nullptr, onoff);
+CONSOLE_VARIABLE(r_dynres, r_dynres, 0) {}
+
+VARIABLE_INT(r_dynresfps, nullptr, 20, 500, nullptr);
+CONSOLE_VARIABLE(r_dynres_fps, r_dynresfps, 0) {}
+
+VARIABLE_INT(r_dynresmin, nullptr, 25, 100, nullptr);
+CONSOLE_VARIABLE(r_dynres_min, r_dynresmin, 0) {}
+
+// EOF
+
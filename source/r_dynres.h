@@ -0,0 +1,46 @@
+//
+// The Eternity Engine
+// Copyright(C) 2026 James Haley, Max Waine, et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+// Additional terms and conditions compatible with the GPLv3 apply. See the
+// file COPYING-EE for details.
+//
+//
+// Purpose: Dynamic render resolution.
+//  With r_dynres on, the 3D view is drawn at a fraction of its size when
+//  frames run over the r_dynres_fps budget, and scaled up to fill its place
+//  on the screen. The HUD, status bar and console are drawn over it at full
+//  resolution.
+//
+
+#ifndef R_DYNRES_H__
+#define R_DYNRES_H__
+
+struct rrect_t;
+
+extern bool r_dynres;
+extern int  r_dynresfps;
+extern int  r_dynresmin;
+
+void    R_DynResStartFrame();
+rrect_t R_DynResViewWindow(const rrect_t &window);
+void    R_DynResBeginView(bool allowed);
+void    R_DynResEndView();
+
+#endif
+
+// EOF
+
@@ -27,6 +27,8 @@
 //-----------------------------------------------------------------------------
 
 #include "z_zone.h"
+#include "c_io.h"
+#include "c_runcmd.h"
 #include "i_system.h"
 #include "m_bbox.h"
 #include "m_collection.h"
@@ -35,6 +37,7 @@
 #include "r_dynseg.h"
 #include "r_dynabsp.h"
 #include "r_state.h"
+#include "v_misc.h"
 
 //
 // dynaseg free list
@@ -59,6 +62,12 @@ static rpolyobj_t *freePolyFragments;
 static PODCollection<dynavertex_t *> gTicDynavertices;
 static PODCollection<dynaseg_t *> gTicDynasegs;
 
+//
+// How often moved polyobjects had their lines split down the BSP again, and
+// how often their dynasegs could just be moved along with them.
+//
+static uint64_t polyfullsplits, polyincsplits;
+
 //
 // External interface
 //
@@ -502,6 +511,73 @@ static bool R_cutByWallSegs(dynaseg_t &dseg, dynaseg_t *backdseg, const subsecto
    return false;   // all are in front. So return.
 }
 
+//
+// Returns true if a seg from v1 to v2 would be in front of every wall seg of
+// the subsector, so R_cutByWallSegs would leave it whole.
+//
+static bool R_clearOfWallSegs(const vertex_t &v1, const vertex_t &v2, const subsector_t &ss)
+{
+   for(int i = 0; i < ss.numlines; ++i)
+   {
+      const seg_t &wall = segs[ss.firstline + i];
+      if(R_segIsOnPartition(wall, ss))
+         continue;
+      const divline_t walldl = { wall.v1->x, wall.v1->y,
+                                 wall.v2->x - wall.v1->x, wall.v2->y - wall.v1->y };
+      if(P_PointOnDivlineSidePrecise(v1.x, v1.y, &walldl) ||
+         P_PointOnDivlineSidePrecise(v2.x, v2.y, &walldl))
+      {
+         return false;
+      }
+   }
+   return true;
+}
+
+//
+// Classifies the ends of a seg against a node line, growing the node's
+// bounding boxes to take them in. Ends within epsilon of the partition go
+// with the other end, or with the polyobject's centre if both are.
+//
+static void R_classifySegEnds(const vertex_t &v1, const vertex_t &v2, const polyobj_t &po,
+                              int bspnum, int &side_v1, int &side_v2)
+{
+   node_t        *bsp   = &nodes[bspnum];
+   const fnode_t *fnode = &fnodes[bspnum];
+
+   // test vertices against node line
+   side_v1 = R_PointOnSide(v1.x, v1.y, bsp);
+   side_v2 = R_PointOnSide(v2.x, v2.y, bsp);
+
+   // ioanch 20160226: fix the polyobject visual clipping bug
+   M_AddToBox(bsp->bbox[side_v1], v1.x, v1.y);
+   M_AddToBox(bsp->bbox[side_v2], v2.x, v2.y);
+
+   // get distance of vertices from partition line
+   double dist_v1 = R_PartitionDistance(v1.fx, v1.fy, fnode);
+   double dist_v2 = R_PartitionDistance(v2.fx, v2.fy, fnode);
+
+   // If the distances are less than epsilon, consider the points as being
+   // on the same side as the polyobj origin. Why? People like to build
+   // polyobject doors flush with their door tracks. This breaks using the
+   // usual assumptions.
+
+   if(dist_v1 <= DS_EPSILON)
+   {
+      if(dist_v2 <= DS_EPSILON)
+      {
+         // both vertices are within epsilon distance; classify the seg
+         // with respect to the polyobject center point
+         side_v1 = side_v2 = R_PointOnSide(po.centerPt.x, po.centerPt.y, bsp);
+      }
+      else
+         side_v1 = side_v2; // v1 is very close; classify as v2 side
+   }
+   else if(dist_v2 <= DS_EPSILON)
+   {
+      side_v2 = side_v1; // v2 is very close; classify as v1 side
+   }
+}
+
 //
 // R_SplitLine
 //
@@ -514,43 +590,10 @@ static void R_SplitLine(dynaseg_t *dseg, dynaseg_t *backdseg, int bspnum)
    while(!(bspnum & NF_SUBSECTOR))
    {
       node_t  *bsp   = &nodes[bspnum];
-      const fnode_t *fnode = &fnodes[bspnum];
       seg_t   *lseg  = &dseg->seg;
+      int side_v1, side_v2;
 
-      // test vertices against node line
-      int side_v1 = R_PointOnSide(lseg->v1->x, lseg->v1->y, bsp);
-      int side_v2 = R_PointOnSide(lseg->v2->x, lseg->v2->y, bsp);
-
-      // ioanch 20160226: fix the polyobject visual clipping bug
-      M_AddToBox(bsp->bbox[side_v1], lseg->v1->x, lseg->v1->y);
-      M_AddToBox(bsp->bbox[side_v2], lseg->v2->x, lseg->v2->y);
-
-      // get distance of vertices from partition line
-      double dist_v1 = R_PartitionDistance(lseg->v1->fx, lseg->v1->fy, fnode);
-      double dist_v2 = R_PartitionDistance(lseg->v2->fx, lseg->v2->fy, fnode);
-
-      // If the distances are less than epsilon, consider the points as being
-      // on the same side as the polyobj origin. Why? People like to build
-      // polyobject doors flush with their door tracks. This breaks using the
-      // usual assumptions.
-
-      if(dist_v1 <= DS_EPSILON)
-      {
-         if(dist_v2 <= DS_EPSILON)
-         {
-            // both vertices are within epsilon distance; classify the seg
-            // with respect to the polyobject center point
-            side_v1 = side_v2 = R_PointOnSide(dseg->polyobj->centerPt.x,
-                                              dseg->polyobj->centerPt.y, 
-                                              bsp);
-         }
-         else
-            side_v1 = side_v2; // v1 is very close; classify as v2 side
-      }
-      else if(dist_v2 <= DS_EPSILON)
-      {         
-         side_v2 = side_v1; // v2 is very close; classify as v1 side
-      }
+      R_classifySegEnds(*lseg->v1, *lseg->v2, *dseg->polyobj, bspnum, side_v1, side_v2);
 
       if(side_v1 != side_v2)
       {
@@ -837,6 +880,134 @@ void R_DetachPolyObject(polyobj_t *poly)
    poly->flags &= ~POF_ATTACHED;
 }
 
+//
+// Checks whether a translated polyobject can keep its dynasegs. That takes
+// every line having been attached whole, in one dynaseg per side, and still
+// falling wholly inside the same subsector, clear of its walls.
+//
+static bool R_canTranslateDynaSegs(const polyobj_t *poly)
+{
+   int numfront = 0;
+
+   for(int i = 0; i < poly->numDSS; ++i)
+   {
+      const subsector_t *ss = poly->dynaSubsecs[i];
+
+      for(const DLListItem<rpolyobj_t> *link = ss->polyList; link; link = link->dllNext)
+      {
+         const rpolyobj_t *rpo = link->dllObject;
+         if(rpo->polyobj != poly)
+            continue;
+
+         for(const dynaseg_t *ds = rpo->dynaSegs; ds; ds = ds->subnext)
+         {
+            // split or cut by a wall when attached
+            if(ds->seg.dyv1 != ds->linev1 || ds->seg.dyv2 != ds->linev2)
+               return false;
+            if(ds->backside)
+               continue;
+
+            ++numfront;
+
+            // follow the line down the BSP as R_SplitLine would
+            const line_t &line = *ds->seg.linedef;
+            int bspnum = numnodes - 1;
+            while(!(bspnum & NF_SUBSECTOR))
+            {
+               int side_v1, side_v2;
+               R_classifySegEnds(*line.v1, *line.v2, *poly, bspnum, side_v1, side_v2);
+               if(side_v1 != side_v2)
+                  return false;
+               bspnum = nodes[bspnum].children[side_v1];
+            }
+
+            const int num = bspnum == -1 ? 0 : bspnum & ~NF_SUBSECTOR;
+            if(&subsectors[num] != ss || !R_clearOfWallSegs(*line.v1, *line.v2, *ss))
+               return false;
+         }
+      }
+   }
+
+   // a line was wholly hidden behind a wall
+   return numfront == poly->numLines;
+}
+
+//
+// Moves the dynasegs of a translated polyobject along with its lines,
+// keeping the fragments they are in.
+//
+static void R_translateDynaSegs(polyobj_t *poly)
+{
+   for(int i = 0; i < poly->numDSS; ++i)
+   {
+      subsector_t *ss = poly->dynaSubsecs[i];
+
+      if(ss->bsp)
+         ss->bsp->dirty = true;
+
+      for(DLListItem<rpolyobj_t> *link = ss->polyList; link; link = link->dllNext)
+      {
+         rpolyobj_t *rpo = link->dllObject;
+         if(rpo->polyobj != poly)
+            continue;
+
+         for(dynaseg_t *ds = rpo->dynaSegs; ds; ds = ds->subnext)
+         {
+            if(ds->backside)
+               continue;
+
+            // the back dynaseg shares these vertices
+            const line_t &line = *ds->seg.linedef;
+            dynavertex_t *ends[2]        = { ds->linev1, ds->linev2 };
+            const vertex_t *lineends[2]  = { line.v1, line.v2 };
+            for(int e = 0; e < 2; e++)
+            {
+               const vertex_t &prev = poly->tmpVerts[lineends[e]->polyindex];
+
+               *static_cast<vertex_t *>(ends[e]) = *lineends[e];
+               ends[e]->backup.x  = prev.x;
+               ends[e]->backup.y  = prev.y;
+               ends[e]->fbackup.x = prev.fx;
+               ends[e]->fbackup.y = prev.fy;
+               gTicDynavertices.add(ends[e]);
+            }
+
+            P_CalcDynaSegLength(ds);
+
+            if(dynaseg_t *backds = ds->subnext; backds && backds->backside)
+            {
+               backds->seg.len = ds->seg.len;
+               backds->prevlen = ds->prevlen;
+               if(backds->prevlen != backds->seg.len)
+                  R_AddTicDynaSeg(*backds);
+            }
+         }
+      }
+   }
+}
+
+//
+// Updates the dynasegs of a polyobject which has just been moved. A pure
+// translation that leaves every line within the subsector it was in moves
+// the dynasegs in place; anything else detaches the polyobject and splits
+// its lines down the BSP afresh.
+//
+void R_MovePolyObject(polyobj_t *poly, bool translated)
+{
+   // portal polyobjects aren't interpolated, so they keep no backups
+   if(translated && !poly->numPortals && poly->flags & POF_ATTACHED &&
+      !(poly->flags & POF_ISBAD) && R_canTranslateDynaSegs(poly))
+   {
+      R_translateDynaSegs(poly);
+      ++polyincsplits;
+      return;
+   }
+
+   R_DetachPolyObject(poly);
+   R_AttachPolyObject(poly);
+   ++polyfullsplits;
+}
+
 //
 // R_ClearDynaSegs
 //
@@ -862,5 +1033,26 @@ void R_ClearDynaSegs()
    }
 }
 
+//
+// Reports how moved polyobjects had their dynasegs updated.
+//
+CONSOLE_COMMAND(r_dynasegstats, 0)
+{
+   if(Console.argc >= 1 && !Console.argv[0]->strCaseCmp("reset"))
+   {
+      polyfullsplits = polyincsplits = 0;
+      C_Printf("Dynaseg statistics reset.\n");
+      return;
+   }
+
+   const uint64_t total = polyfullsplits + polyincsplits;
+   C_Printf(FC_HI "Polyobject moves:\n" FC_NORMAL
+            "  split again:  %llu\n"
+            "  moved whole:  %llu (%.1f%%)\n",
+            static_cast<unsigned long long>(polyfullsplits),
+            static_cast<unsigned long long>(polyincsplits),
+            total ? 100.0 * double(polyincsplits) / double(total) : 0.0);
+}
+
 // EOF
 
@@ -104,6 +104,7 @@ void R_SaveDynasegPositions();
 
 void R_AttachPolyObject(polyobj_t *poly);
 void R_DetachPolyObject(polyobj_t *poly);
+void R_MovePolyObject(polyobj_t *poly, bool translated);
 void R_ClearDynaSegs();
 
 //
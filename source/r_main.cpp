@@ -53,15 +53,21 @@
 #include "r_bsp.h"
 #include "r_context.h"
 #include "r_draw.h"
+#include "r_draw32.h"
+#include "r_dynabsp.h"
 #include "r_dynseg.h"
+#include "r_dynres.h"
 #include "r_interpolate.h"
 #include "r_main.h"
 #include "r_plane.h"
 #include "r_portal.h"
+#include "r_profile.h"
+#include "r_pvs.h"
 #include "r_ripple.h"
 #include "r_things.h"
 #include "r_sky.h"
 #include "r_state.h"
+#include "r_voxels.h"
 #include "s_sound.h"
 #include "st_stuff.h"
 #include "v_alloc.h"
@@ -132,9 +138,14 @@ VALLOCATION(xtoviewangle)
 // killough 3/20/98: Support dynamic colormaps, e.g. deep water
 // killough 4/4/98: support dynamic number of them as well
 
+// Light tables are made per colormap as it's loaded, and nullptr till then.
+typedef lighttable_t *scalelighttable_t[LIGHTLEVELS][MAXLIGHTSCALE];
+typedef lighttable_t *zlighttable_t[LIGHTLEVELS][MAXLIGHTZ];
+
 int numcolormaps;
-lighttable_t *(*c_scalelight)[LIGHTLEVELS][MAXLIGHTSCALE];
-lighttable_t *(*c_zlight)[LIGHTLEVELS][MAXLIGHTZ];
+static scalelighttable_t **c_scalelight;
+static zlighttable_t     **c_zlight;
+static int                 numlighttables; // numcolormaps they were made for
 lighttable_t **colormaps;
 
 // killough 3/20/98, 4/4/98: end dynamic colormaps
@@ -149,6 +160,8 @@ static columndrawer_t *r_column_engines[NUMCOLUMNENGINES] =
 {
    &r_normal_drawer, // normal engine
    // Here lies Quad Cache Engine: 2006/09/04 - 2020/10/31
+   &r_quad_drawer,   // quad column engine
+   &r_truecolor_drawer, // truecolor engine, which brings its own span drawers
 };
 
 //
@@ -164,10 +177,15 @@ void R_SetColumnEngine()
 // haleyjd 09/10/06: span drawing engines
 spandrawer_t *r_span_engine;
 int r_span_engine_num;
+bool r_slopeexact; // do the perspective divide at every pixel of sloped planes
+
+// set by a video driver drawing the world of the player's view itself
+hwviewrenderer_t *r_hwview;
 
 static spandrawer_t *r_span_engines[NUMSPANENGINES] =
 {
    &r_spandrawer,    // normal engine
+   &r_vecspandrawer, // vectorized engine
 };
 
 //
@@ -177,7 +195,24 @@ static spandrawer_t *r_span_engines[NUMSPANENGINES] =
 //
 void R_SetSpanEngine(void)
 {
+   static spandrawer_t exactslopeengine;
+
+   // The truecolor column engine can only be paired with truecolor spans
+   if(r_column_engine == &r_truecolor_drawer)
+   {
+      r_span_engine = &r_truecolorspandrawer;
+      return;
+   }
+
    r_span_engine = r_span_engines[r_span_engine_num];
+
+   // The exact slope drawers replace the subdivided ones of whichever engine
+   if(r_slopeexact)
+   {
+      exactslopeengine = *r_span_engine;
+      memcpy(exactslopeengine.DrawSlope, r_exactslopes, sizeof(r_exactslopes));
+      r_span_engine = &exactslopeengine;
+   }
 }
 
 //
@@ -501,45 +536,84 @@ static void R_InitTextureMapping()
 #define DISTMAP 2
 
 //
-// R_InitLightTables
-// Only inits the zlight table,
-//  because the scalelight table changes with view size.
+// R_InitColormapLightTables
 //
-void R_InitLightTables (void)
+// Makes the light tables of a colormap that has just been loaded. Neither
+// table depends on the view size, whatever the old comments say.
+//
+void R_InitColormapLightTables(int t)
 {
-   int i;
-   
-   // killough 4/4/98: dynamic colormaps
-   // haleyjd: FIXME - wtf kind of types ARE these anyway??
-   c_zlight     = emalloc(lighttable_t *(*)[LIGHTLEVELS][MAXLIGHTZ],     sizeof(*c_zlight) * numcolormaps);
-   c_scalelight = emalloc(lighttable_t *(*)[LIGHTLEVELS][MAXLIGHTSCALE], sizeof(*c_scalelight) * numcolormaps);
-   
+   if(!c_zlight || c_zlight[t])
+      return;
+
+   c_zlight[t]     = emalloc(zlighttable_t *,     sizeof(zlighttable_t));
+   c_scalelight[t] = emalloc(scalelighttable_t *, sizeof(scalelighttable_t));
+
    // Calculate the light levels to use
    //  for each level / distance combination.
-   for(i = 0; i < LIGHTLEVELS; ++i)
+   for(int i = 0; i < LIGHTLEVELS; ++i)
    {
       // SoM: the LIGHTBRIGHT constant must be used to scale the start offset of 
       // the colormaps, otherwise the levels are staggered and become slightly 
       // darker.
-      int j, startcmap = ((LIGHTLEVELS-LIGHTBRIGHT-i)*2)*NUMCOLORMAPS/LIGHTLEVELS;
-      for(j = 0; j < MAXLIGHTZ; ++j)
+      int startcmap = ((LIGHTLEVELS-LIGHTBRIGHT-i)*2)*NUMCOLORMAPS/LIGHTLEVELS;
+      for(int j = 0; j < MAXLIGHTZ; ++j)
       {
          int scale = FixedDiv((SCREENWIDTH/2*FRACUNIT), (j+1)<<LIGHTZSHIFT);
-         int t, level = startcmap - (scale >> LIGHTSCALESHIFT)/DISTMAP;
+         int level = startcmap - (scale >> LIGHTSCALESHIFT)/DISTMAP;
          
          if(level < 0)
             level = 0;
          else if(level >= NUMCOLORMAPS)
             level = NUMCOLORMAPS-1;
 
-         // killough 3/20/98: Initialize multiple colormaps
-         level *= 256;
-         for(t = 0; t < numcolormaps; ++t)         // killough 4/4/98
-            c_zlight[t][i][j] = colormaps[t] + level;
+         (*c_zlight[t])[i][j] = colormaps[t] + level * 256;
+      }
+
+      for(int j = 0; j < MAXLIGHTSCALE; ++j)
+      {                                       // killough 11/98:
+         int level = startcmap - j*1/DISTMAP;
+         
+         if(level < 0)
+            level = 0;
+         
+         if(level >= NUMCOLORMAPS)
+            level = NUMCOLORMAPS-1;
+
+         (*c_scalelight[t])[i][j] = colormaps[t] + level * 256;
       }
    }
 }
 
+//
+// R_InitLightTables
+//
+// killough 4/4/98: dynamic colormaps
+// Colormaps are loaded as levels first use them, so this only makes room
+// for every colormap's tables and fills those already loaded.
+//
+void R_InitLightTables()
+{
+   // on a reload the colormaps have all been replaced
+   for(int t = 0; t < numlighttables; t++)
+   {
+      efree(c_zlight[t]);
+      efree(c_scalelight[t]);
+   }
+   efree(c_zlight);
+   efree(c_scalelight);
+
+   numlighttables = numcolormaps;
+   c_zlight       = ecalloc(zlighttable_t **,     numcolormaps, sizeof(*c_zlight));
+   c_scalelight   = ecalloc(scalelighttable_t **, numcolormaps, sizeof(*c_scalelight));
+
+   for(int t = 0; t < numcolormaps; t++)
+   {
+      if(colormaps[t])
+         R_InitColormapLightTables(t);
+   }
+}
+
 bool setsizeneeded;
 int  setblocks;
 
@@ -624,7 +698,10 @@ void R_SetupViewScaling()
    scaledwindow.scaledFromScreenBlocks(setblocks);
 
    // haleyjd 05/02/13: set viewwindow properties
-   viewwindow.viewFromScaled(setblocks, video.width, video.height, scaledwindow);
+   presentwindow.viewFromScaled(setblocks, video.width, video.height, scaledwindow);
+
+   // the view may be drawn smaller and scaled up into place afterwards
+   viewwindow = R_DynResViewWindow(presentwindow);
 
    centerx     = viewwindow.width  / 2;
    centery     = viewwindow.height / 2;
@@ -662,9 +739,13 @@ static void R_calculateVisSpriteScales()
    if(setblocks < 10)
    {
       float sbheight = GameModeInfo->StatusBar->height * video.yscalef;
-      swxscale = (float)viewwindow.width / video.width;
-      swyscale = (float)viewwindow.height / (video.height - sbheight);
+      swxscale = (float)presentwindow.width / video.width;
+      swyscale = (float)presentwindow.height / (video.height - sbheight);
    }
+
+   // and for a view drawn at a lower resolution
+   swxscale *= (float)viewwindow.width  / presentwindow.width;
+   swyscale *= (float)viewwindow.height / presentwindow.height;
    
    view.pspritexscale = realxscale * swxscale;
    view.pspriteyscale = realyscale * swyscale;
@@ -683,33 +764,12 @@ void R_ExecuteSetViewSize()
    R_SetupViewScaling();
    
    R_InitTextureMapping();
+   R_InvalidateSkyCache();
     
    // thing clipping
    for(i = 0; i < viewwindow.width; i++)
       screenheightarray[i] = view.height - 1.0f;
 
-   // Calculate the light levels to use for each level / scale combination.
-   for(i = 0; i < LIGHTLEVELS; i++)
-   {
-      int startcmap = ((LIGHTLEVELS-LIGHTBRIGHT-i)*2)*NUMCOLORMAPS/LIGHTLEVELS;
-      for(int j = 0; j < MAXLIGHTSCALE; ++j)
-      {                                       // killough 11/98:
-         int level = startcmap - j*1/DISTMAP;
-         
-         if(level < 0)
-            level = 0;
-         
-         if(level >= NUMCOLORMAPS)
-            level = NUMCOLORMAPS-1;
-         
-         // killough 3/20/98: initialize multiple colormaps
-         level *= 256;
-         
-         for(int t = 0; t < numcolormaps; t++)     // killough 4/4/98
-            c_scalelight[t][i][j] = colormaps[t] + level;
-      }
-   }
-   
    R_calculateVisSpriteScales();
 }
 
@@ -719,10 +779,49 @@ void R_ExecuteSetViewSize()
 void R_Init()
 {
    R_InitData();
+   R_InitVectorSpanDrawer();
    R_SetViewSize(screenSize+3);
    R_InitLightTables();
    R_InitTranslationTables();
    R_InitParticles(); // haleyjd
+   R_ProfileInit();
+}
+
+//
+// R_PointOnSide for the bspnodes copy of the tree. Same results, with every
+// case worked out and one picked, so the walk doesn't mispredict its way down.
+//
+#if EE_CURRENT_PLATFORM == EE_PLATFORM_MACOSX && defined(__clang__)
+static inline int R_bspSideClassic(volatile fixed_t x, volatile fixed_t y, const bspnode_t &node)
+#else
+static inline int R_bspSideClassic(fixed_t x, fixed_t y, const bspnode_t &node)
+#endif
+{
+   const fixed_t lx = x - node.x;
+   const fixed_t ly = y - node.y;
+
+   const int vertical   = x <= node.x ? node.dy > 0 : node.dy < 0;
+   const int horizontal = y <= node.y ? node.dx < 0 : node.dx > 0;
+   const int signs      = (node.dy ^ node.dx ^ lx ^ ly) < 0 ? (node.dy ^ lx) < 0 :
+                          FixedMul(ly, node.dx >> FRACBITS) >= FixedMul(node.dy >> FRACBITS, lx);
+
+   return !node.dx ? vertical : !node.dy ? horizontal : signs;
+}
+
+//
+// Likewise for R_PointOnSidePrecise.
+//
+static inline int R_bspSidePrecise(fixed_t x, fixed_t y, const bspnode_t &node)
+{
+   const fixed_t lx = x - node.x;
+   const fixed_t ly = y - node.y;
+
+   const int vertical   = x <= node.x ? node.dy > 0 : node.dy < 0;
+   const int horizontal = y <= node.y ? node.dx < 0 : node.dx > 0;
+   const int signs      = (node.dy ^ node.dx ^ lx ^ ly) < 0 ? (node.dy ^ lx) < 0 :
+                          int64_t(ly) * node.dx >= int64_t(node.dy) * lx;
+
+   return !node.dx ? vertical : !node.dy ? horizontal : signs;
 }
 
 //
@@ -733,9 +832,18 @@ void R_Init()
 //
 subsector_t *R_PointInSubsector(fixed_t x, fixed_t y)
 {
-   int nodenum = numnodes - 1;
-   while(!(nodenum & NF_SUBSECTOR))
-      nodenum = nodes[nodenum].children[R_PointOnSide(x, y, nodes+nodenum)];
+   int nodenum = numnodes ? 0 : -1;
+
+   if(R_PointOnSide == R_PointOnSidePrecise)
+   {
+      while(!(nodenum & NF_SUBSECTOR))
+         nodenum = bspnodes[nodenum].children[R_bspSidePrecise(x, y, bspnodes[nodenum])];
+   }
+   else
+   {
+      while(!(nodenum & NF_SUBSECTOR))
+         nodenum = bspnodes[nodenum].children[R_bspSideClassic(x, y, bspnodes[nodenum])];
+   }
    return &subsectors[(nodenum == -1 ? 0 : nodenum & ~NF_SUBSECTOR)];
 }
 
@@ -893,13 +1001,14 @@ static void R_setSectorInterpolationState(secinterpstate_e state)
 {
    int i;
 
+   // only sectors that moved this tic can differ from their previous heights
    switch(state)
    {
    case SEC_INTERPOLATE:
-      for(i = 0; i < numsectors; i++)
+      for(i = 0; i < nummovedsectors; i++)
       {
-         auto &si  = sectorinterps[i];
-         auto &sec = sectors[i];
+         auto &si  = sectorinterps[movedsectors[i]];
+         auto &sec = sectors[movedsectors[i]];
 
          if(si.prevfloorheight   != sec.srf.floor.height ||
             si.prevceilingheight != sec.srf.ceiling.height)
@@ -923,10 +1032,10 @@ static void R_setSectorInterpolationState(secinterpstate_e state)
       }
       break;
    case SEC_NORMAL:
-      for(i = 0; i < numsectors; i++)
+      for(i = 0; i < nummovedsectors; i++)
       {
-         auto &si  = sectorinterps[i];
-         auto &sec = sectors[i];
+         auto &si  = sectorinterps[movedsectors[i]];
+         auto &sec = sectors[movedsectors[i]];
 
          // restore backed up heights
          if(si.interpolated)
@@ -935,6 +1044,7 @@ static void R_setSectorInterpolationState(secinterpstate_e state)
             sec.srf.floor.heightf = si.backfloorheightf;
             sec.srf.ceiling.height = si.backceilingheight;
             sec.srf.ceiling.heightf = si.backceilingheightf;
+            si.interpolated = false;
          }
       }
       break;
@@ -1024,6 +1134,12 @@ static void R_SetupFrame(player_t *player, camera_t *camera)
    {
       R_interpolateViewPoint(player, lerp);
 
+      if(player == &players[consoleplayer])
+      {
+         G_MouseLookAhead(*player, viewpoint.angle, viewpitch);
+         D_PredictLocalView(viewpoint.angle, viewpitch);
+      }
+
       // haleyjd 01/21/07: earthquakes
       if(player->quake &&
          !(((menuactive || consoleactive) && !demoplayback && !netgame) || paused))
@@ -1060,7 +1176,9 @@ static void R_SetupFrame(player_t *player, camera_t *camera)
    cb_viewpoint.cos    = cosf(cb_viewpoint.angle);
    view.pitch  = (ANG90 - viewpitch) * PI / ANG180;
    view.lerp   = lerp;
-   view.sector = R_PointInSubsector(viewpoint.x, viewpoint.y)->sector;
+   const subsector_t *viewsubsector = R_PointInSubsector(viewpoint.x, viewpoint.y);
+   view.sector = viewsubsector->sector;
+   R_SetPVSViewpoint(viewsubsector);
 
    // set interpolated sector heights
    if(view.lerp != FRACUNIT)
@@ -1207,9 +1325,13 @@ void R_SectorColormap(cmapcontext_t &context, const fixed_t viewz, const sector_
       colormapIndex &= ~COLORMAP_BOOMKIND;
    }
 
+   // anything not loaded yet was never referenced by name; shouldn't happen
+   if(!colormaps[colormapIndex])
+      colormapIndex = 0;
+
    context.fullcolormap = colormaps[colormapIndex];
-   context.zlight       = c_zlight[colormapIndex];
-   context.scalelight   = c_scalelight[colormapIndex];
+   context.zlight       = *c_zlight[colormapIndex];
+   context.scalelight   = *c_scalelight[colormapIndex];
 
    if(viewplayer->fixedcolormap)
    {
@@ -1240,18 +1362,24 @@ void R_RenderViewContext(rendercontext_t &context)
    memset(context.spritecontext.sectorvisited, 0, sizeof(bool) * numsectors);
    context.portalcontext.renderdepth = 0;
 
+   // Carve this view's arrays before anything is added to them
+   R_ResetFrameArena(context);
+
    // Clear buffers.
    R_ClearClipSegs(context.bspcontext);
    R_ClearDrawSegs(context.bspcontext);
    R_ClearPlanes(context.planecontext, context.bounds);
-   R_ClearPortals(context.planecontext.freehead);
+   R_ClearPortals();
    R_ClearSprites(context.spritecontext);
 
    // check for new console commands.
    //NetUpdate();
 
    // The head node is the last node output.
-   R_RenderBSPNode(context, numnodes - 1);
+   {
+      RenderProfileScope profile(RPROF_BSP);
+      R_RenderBSPNode(context, numnodes - 1);
+   }
 
    // Check for new console commands.
    //NetUpdate();
@@ -1264,6 +1392,10 @@ void R_RenderViewContext(rendercontext_t &context)
    // SoM 12/9/03: render the portals.
    R_RenderPortals(context);
 
+   // Buffered columns must land before anything else is drawn
+   if(r_column_engine->ResetBuffer)
+      r_column_engine->ResetBuffer();
+
    R_DrawPlanes(
       context.cmapcontext, context.planecontext.mainhash,
       context.planecontext.spanstart, context.view.angle, nullptr
@@ -1275,6 +1407,16 @@ void R_RenderViewContext(rendercontext_t &context)
    // Draw Post-BSP elements such as sprites, masked textures, and portal
    // overlays
    R_DrawPostBSP(context);
+
+   // draw the psprites on top of everything, in this context's columns
+   {
+      RenderProfileScope profile(RPROF_PSPRITES);
+      R_DrawPlayerSprites(context.bounds);
+   }
+
+   // Column engine buffers are per-thread, so flush this context's here
+   if(r_column_engine->ResetBuffer)
+      r_column_engine->ResetBuffer();
 }
 
 static int render_ticker = 0;
@@ -1282,6 +1424,21 @@ static int render_ticker = 0;
 // haleyjd: temporary debug
 extern void R_UntaintPortals();
 
+//
+// Leaves the world to the video driver, which draws it through the key
+// color, and draws the psprites over that.
+//
+static void R_renderHardwareView()
+{
+   V_ColorBlock(&vbscreen, r_hwview->keycolor, viewwindow.x, viewwindow.y,
+                viewwindow.width, viewwindow.height);
+
+   r_hwview->RenderView(viewwindow);
+
+   RenderProfileScope profile(RPROF_PSPRITES);
+   R_DrawPlayerSprites(r_globalcontext.bounds);
+}
+
 //
 // Primary renderer entry point.
 //
@@ -1290,14 +1447,34 @@ void R_RenderPlayerView(player_t* player, camera_t *camerapoint)
    bool quake = false;
    unsigned int savedflags = 0;
 
+   // the driver's world only goes under 8-bit psprites
+   const bool hwview = (r_hwview && r_column_engine != &r_truecolor_drawer);
+
+   // Neither the HOM flash, the truecolor buffer nor the driver's world can
+   // be scaled up
+   R_DynResBeginView(!hwview && !autodetect_hom && r_column_engine != &r_truecolor_drawer);
+
+   // Publish precached textures and evict any beyond the memory budget
+   R_StartTextureFrame();
+
+   // move the shadow pattern on; the step is coprime to the table's length
+   fuzzbase = (fuzzbase + 17) % FUZZTABLE;
+
    R_SetupFrame(player, camerapoint);
 
+   if(r_column_engine == &r_truecolor_drawer)
+      R_BeginTrueColorView();
+
    // haleyjd: untaint portals
    R_UntaintPortals();
 
-   if(autodetect_hom)
+   if(autodetect_hom && !hwview)
       R_HOMdrawer();
 
+   // set up the psprites for the contexts to draw last; done before the
+   // earthquake hides the player, which they should never be hidden by
+   R_PreparePlayerSprites();
+
    // haleyjd 01/21/07: earthquakes -- make player invisible to himself
    if(player->quake && !camerapoint)
    {
@@ -1310,7 +1487,9 @@ void R_RenderPlayerView(player_t* player, camera_t *camerapoint)
       player->mo->intflags &= ~MIF_HIDDENBYQUAKE;  // zero it otherwise
 
    // We don't need to multithread if we only have one context
-   if(r_numcontexts == 1)
+   if(hwview)
+      R_renderHardwareView();
+   else if(r_numcontexts == 1)
       R_RenderViewContext(r_globalcontext);
    else
       R_RunContexts();
@@ -1318,15 +1497,15 @@ void R_RenderPlayerView(player_t* player, camera_t *camerapoint)
    if(quake)
       player->mo->flags2 = savedflags;
 
-   // draw the psprites on top of everything
-   //  but does not draw on side views
-   if(!viewangleoffset)
-      R_DrawPlayerSprites();
-
    // haleyjd 09/04/06: handle through column engine
    if(r_column_engine->ResetBuffer)
       r_column_engine->ResetBuffer();
 
+   if(r_truecolorview)
+      R_EndTrueColorView();
+
+   R_DynResEndView();
+
    // haleyjd: remove sector interpolations
    if(view.lerp != FRACUNIT)
    {
@@ -1334,6 +1513,8 @@ void R_RenderPlayerView(player_t* player, camera_t *camerapoint)
       R_setScrollInterpolationState(SEC_NORMAL);
    }
    
+   R_DynaBSPFrame();
+
    // Check for new console commands.
    NetUpdate();
    
@@ -1354,6 +1535,16 @@ void R_HOMdrawer()
    V_ColorBlock(&vbscreen, (byte)colour, viewwindow.x, viewwindow.y, 
                 viewwindow.width,
                 viewwindow.height);
+
+   if(r_truecolorview)
+   {
+      for(int x = 0; x < viewwindow.width; x++)
+      {
+         uint32_t *dest = R_ADDRESS32(x, 0);
+         for(int y = 0; y < viewwindow.height; y++)
+            dest[y] = Col2RGB32[colour];
+      }
+   }
 }
 
 //
@@ -1369,6 +1560,9 @@ void R_ResetTrans()
       R_InitTranMap(false);
       R_InitSubMap(false);
    }
+
+   // cached skies have main_tranmap baked into their fade to the sky color
+   R_InvalidateSkyCache();
 }
 
 // action code flags for R_DoomTLStyle
@@ -1509,8 +1703,8 @@ void R_DoomTLStyle()
 
 static const char *handedstr[]  = { "right", "left" };
 static const char *ptranstr[]   = { "none", "smooth", "general" };
-static const char *coleng[]     = { "normal" };
-static const char *spaneng[]    = { "highprecision" };
+static const char *coleng[]     = { "normal", "quad", "truecolor" };
+static const char *spaneng[]    = { "highprecision", "vectorized" };
 static const char *tlstylestr[] = { "opaque", "boom", "additive" };
 
 VARIABLE_BOOLEAN(lefthanded, nullptr,               handedstr);
@@ -1637,6 +1831,18 @@ CONSOLE_VARIABLE(r_ptcltrans, particle_trans, 0) {}
 CONSOLE_VARIABLE(r_columnengine, r_column_engine_num, 0) {}
 CONSOLE_VARIABLE(r_spanengine,   r_span_engine_num,   0) {}
 
+VARIABLE_TOGGLE(r_slopeexact, nullptr, onoff);
+CONSOLE_VARIABLE(r_slopeexact, r_slopeexact, 0) {}
+
+VARIABLE_TOGGLE(r_drawvoxels, nullptr, onoff);
+CONSOLE_VARIABLE(r_voxels, r_drawvoxels, 0) {}
+
+VARIABLE_TOGGLE(r_skycache, nullptr, onoff);
+CONSOLE_VARIABLE(r_skycache, r_skycache, 0)
+{
+   R_InvalidateSkyCache();
+}
+
 CONSOLE_COMMAND(p_dumphubs, 0)
 {
    extern void P_DumpHubs();
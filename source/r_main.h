@@ -37,6 +37,7 @@
 #include "r_lighting.h"
 
 struct pwindow_t;
+struct rrect_t;
 struct columndrawer_t;
 struct spandrawer_t;
 struct rendercontext_t;
@@ -123,6 +124,7 @@ void R_Init();                           // Called by startup code.
 void R_SetViewSize(int blocks);          // Called by M_Responder.
 
 void R_InitLightTables();                // killough 8/9/98
+void R_InitColormapLightTables(int t);
 
 extern bool setsizeneeded;
 // SoM
@@ -133,8 +135,8 @@ angle_t R_WadToAngle(int wadangle);
 
 extern int viewdir;
 
-#define NUMCOLUMNENGINES 1
-#define NUMSPANENGINES 1
+#define NUMCOLUMNENGINES 3
+#define NUMSPANENGINES 2
 extern int r_column_engine_num;
 extern int r_span_engine_num;
 extern columndrawer_t *r_column_engine;
@@ -143,6 +145,20 @@ extern spandrawer_t *r_span_engine;
 void R_SetColumnEngine();
 void R_SetSpanEngine();
 
+//
+// A video driver that can draw the world itself points r_hwview at one of
+// these while it's able to. The player's view is then only filled with the
+// key color, for the driver to show its world through, and has the player's
+// weapon drawn over it.
+//
+struct hwviewrenderer_t
+{
+   byte keycolor;
+   void (*RenderView)(const rrect_t &window); // view set up by R_SetupFrame
+};
+
+extern hwviewrenderer_t *r_hwview;
+
 // haleyjd 09/19/07: missing extern!
 extern const float PI;
 
@@ -36,6 +36,8 @@
 //
 //-----------------------------------------------------------------------------
 
+#include <algorithm>
+
 #include "z_zone.h"    /* memory allocation wrappers -- killough */
 #include "i_system.h"
 
@@ -43,15 +45,19 @@
 #include "d_gi.h"
 #include "doomstat.h"
 #include "ev_specials.h"
+#include "m_collection.h"
+#include "m_compare.h"
 #include "p_anim.h"
 #include "p_info.h"
 #include "p_slopes.h"
 #include "p_user.h"
 #include "r_context.h"
 #include "r_draw.h"
+#include "r_draw32.h"
 #include "r_main.h"
 #include "r_plane.h"
 #include "r_portal.h"
+#include "r_profile.h"
 #include "r_ripple.h"
 #include "r_sky.h"
 #include "r_state.h"
@@ -61,7 +67,10 @@
 #include "v_video.h"
 #include "w_wad.h"
 
-#define MAINHASHCHAINS 1021 // prime numbers are good for hashes with modulo-based functions
+#define MAINHASHSLOTS     1024 // initial size of the main table; grows as needed
+#define VISPLANEBLOCKSIZE 128  // visplanes carved from each arena block
+
+static void R_initPlaneHash(planehash_t &table, int slotcount, int tag);
 
 //
 // VALLOCATION(mainhash)
@@ -76,23 +85,161 @@ VALLOCATION(mainhash)
    R_ForEachContext([](rendercontext_t &basecontext) {
       planecontext_t &context = basecontext.planecontext;
 
-      context.freetail = nullptr;
-      context.freehead = &context.freetail;
+      context.arena = {};
       context.floorplane = context.ceilingplane = nullptr;
 
-      context.mainchains = ecalloctag(
-         visplane_t **, MAINHASHCHAINS, sizeof(visplane_t *), PU_VALLOC, nullptr
-      );
-      context.mainhash = { MAINHASHCHAINS, context.mainchains, nullptr };
+      R_initPlaneHash(context.mainhash, MAINHASHSLOTS, PU_VALLOC);
    });
 }
 
-// killough -- hash function for visplanes
-// Empirically verified to be fairly uniform:
-constexpr unsigned int visplane_hash(const unsigned int picnum, const unsigned int lightlevel,
-                                     const unsigned int height, const int chains)
+//=============================================================================
+//
+// Visplane arena
+//
+// Every visplane is carved, together with its silhouette arrays, out of a
+// per-context arena that is reset at the start of each frame, so a frame's
+// planes sit next to each other in memory and nothing is freed piecemeal.
+//
+
+struct visplaneblock_t
+{
+   visplaneblock_t *next;
+   // VISPLANEBLOCKSIZE planes of arena.stride bytes follow
+};
+
+//
+// Returns every plane to the arena. Blocks are kept for the next frame.
+//
+static void R_resetPlaneArena(visplanearena_t &arena)
+{
+   arena.current = arena.head;
+   arena.used    = 0;
+}
+
+//
+// Carves a visplane and its silhouette arrays out of the arena.
+//
+static visplane_t *R_allocPlane(visplanearena_t &arena)
+{
+   if(!arena.stride)
+   {
+      // the plane, then top and bottom padded by one entry on either side
+      const size_t planesize = (sizeof(visplane_t) + alignof(visplane_t) - 1) &
+                               ~(alignof(visplane_t) - 1);
+      arena.stride = planesize + 2 * (video.width + 2) * sizeof(int);
+      arena.stride = (arena.stride + alignof(visplane_t) - 1) & ~(alignof(visplane_t) - 1);
+   }
+
+   if(!arena.current || arena.used == VISPLANEBLOCKSIZE)
+   {
+      visplaneblock_t *next = arena.current ? arena.current->next : arena.head;
+
+      if(!next)
+      {
+         next = static_cast<visplaneblock_t *>(
+            ecalloctag(void *, 1, sizeof(visplaneblock_t) + VISPLANEBLOCKSIZE * arena.stride,
+                       PU_VALLOC, nullptr)
+         );
+         if(arena.current)
+            arena.current->next = next;
+         else
+            arena.head = next;
+      }
+
+      arena.current = next;
+      arena.used    = 0;
+   }
+
+   byte *const mem = reinterpret_cast<byte *>(arena.current + 1) + arena.stride * arena.used++;
+
+   visplane_t *const pl = reinterpret_cast<visplane_t *>(mem);
+   int *const paddedTop = reinterpret_cast<int *>(mem + arena.stride) - 2 * (video.width + 2);
+
+   pl->max_width = static_cast<unsigned int>(video.width);
+   pl->top       = paddedTop + 1;
+   pl->bottom    = paddedTop + video.width + 2 + 1;
+
+   return pl;
+}
+
+//=============================================================================
+//
+// Visplane tables
+//
+// Open-addressed with linear probing, keyed on the full identity of a plane.
+// Only the first plane with a given identity is entered; duplicates made by
+// R_DupPlane are reachable only through the table's plane list.
+//
+
+static inline unsigned int R_mixPlaneKey(unsigned int h, unsigned int v)
+{
+   return (h ^ v) * 0x01000193u;
+}
+
+//
+// Hash of everything R_FindPlane compares, save for the float members (so
+// that -0 and 0 still match) and the slope, which is compared by value.
+//
+static unsigned int R_planeKey(fixed_t height, int picnum, int lightlevel, v2fixed_t offs,
+                               const void *colormap, const void *fixedcolormap,
+                               fixed_t viewx, fixed_t viewy, fixed_t viewz,
+                               int blendflags, byte opacity)
+{
+   const uintptr_t cmap  = reinterpret_cast<uintptr_t>(colormap);
+   const uintptr_t fcmap = reinterpret_cast<uintptr_t>(fixedcolormap);
+
+   unsigned int h = 0x811c9dc5u;
+   h = R_mixPlaneKey(h, unsigned(picnum));
+   h = R_mixPlaneKey(h, unsigned(lightlevel));
+   h = R_mixPlaneKey(h, unsigned(height));
+   h = R_mixPlaneKey(h, unsigned(offs.x));
+   h = R_mixPlaneKey(h, unsigned(offs.y));
+   h = R_mixPlaneKey(h, unsigned(cmap ^ (uint64_t(cmap) >> 32)));
+   h = R_mixPlaneKey(h, unsigned(fcmap ^ (uint64_t(fcmap) >> 32)));
+   h = R_mixPlaneKey(h, unsigned(viewx));
+   h = R_mixPlaneKey(h, unsigned(viewy));
+   h = R_mixPlaneKey(h, unsigned(viewz));
+   h = R_mixPlaneKey(h, unsigned(blendflags) | unsigned(opacity) << 16);
+
+   return h ^ (h >> 16);
+}
+
+static void R_initPlaneHash(planehash_t &table, int slotcount, int tag)
+{
+   table.slotcount = slotcount;
+   table.numslots  = 0;
+   table.tag       = tag;
+   table.slots     = ecalloctag(planehashslot_t *, slotcount, sizeof(planehashslot_t), tag,
+                                nullptr);
+   table.planes    = nullptr;
+   table.next      = nullptr;
+}
+
+//
+// Doubles the slot count of a table and re-enters its planes.
+//
+static void R_growPlaneHash(planehash_t &table)
 {
-   return ((picnum * 3) + lightlevel + (height * 7)) % chains;
+   planehashslot_t *const oldslots = table.slots;
+   const int              oldcount = table.slotcount;
+
+   table.slotcount *= 2;
+   table.slots = ecalloctag(planehashslot_t *, table.slotcount, sizeof(planehashslot_t),
+                            table.tag, nullptr);
+
+   const unsigned int mask = table.slotcount - 1;
+   for(int i = 0; i < oldcount; i++)
+   {
+      if(!oldslots[i].plane)
+         continue;
+
+      unsigned int slot = oldslots[i].key & mask;
+      while(table.slots[slot].plane)
+         slot = (slot + 1) & mask;
+      table.slots[slot] = oldslots[i];
+   }
+
+   efree(oldslots);
 }
 
 // killough 8/1/98: set static number of openings to be large enough
@@ -197,6 +344,7 @@ static void R_mapPlane(const R_FlatFunc flatfunc, const R_SlopeFunc, cb_span_t &
                        cb_slopespan_t &, const cb_plane_t &plane, int y, int x1, int x2)
 {
    float dy, xstep, ystep, realy, slope;
+   R_FlatFunc func = flatfunc;
 
 #ifdef RANGECHECK
    if(x2 < x1 || x1 < 0 || x2 >= viewwindow.width || y < 0 || y >= viewwindow.height)
@@ -250,9 +398,29 @@ static void R_mapPlane(const R_FlatFunc flatfunc, const R_SlopeFunc, cb_span_t &
    span.x1 = x1;
    span.x2 = x2;
    span.source = plane.source;
+
+   // Texels two or more pixels apart are drawn from a mip level instead.
+   // The fixed point units cover the whole flat at every level, so only
+   // the shifts need to change.
+   if(plane.mips)
+   {
+      const float texstep = emax(fabsf(xstep), fabsf(ystep));
+      int         level   = 0;
+
+      while(level < plane.nummips && texstep >= float(2 << level))
+         ++level;
+
+      const planemip_t &mip = plane.mips[level];
+
+      span.source = mip.source;
+      span.xshift = mip.xshift;
+      span.xmask  = mip.xmask;
+      span.yshift = mip.yshift;
+      func        = mip.flatfunc;
+   }
    
    // BIG FLATS
-   flatfunc(span);
+   func(span);
 }
 
 //
@@ -429,17 +597,17 @@ static void R_calcSlope(const cbviewpoint_t &cb_viewpoint, visplane_t *pl)
    v3double_t P;
    P.x = -xoffsf * tcos - yoffsf * tsin;
    P.z = -xoffsf * tsin + yoffsf * tcos;
-   P.y = P_GetZAtf(pl->pslope, (float)P.x, (float)P.z);
+   P.y = pl->pslope->getZAtf((float)P.x, (float)P.z);
 
    v3double_t M;
    M.x = P.x - xl * tsin;
    M.z = P.z + xl * tcos;
-   M.y = P_GetZAtf(pl->pslope, (float)M.x, (float)M.z);
+   M.y = pl->pslope->getZAtf((float)M.x, (float)M.z);
 
    v3double_t N;
    N.x = P.x + yl * tcos;
    N.z = P.z + yl * tsin;
-   N.y = P_GetZAtf(pl->pslope, (float)N.x, (float)N.z);
+   N.y = pl->pslope->getZAtf((float)N.x, (float)N.z);
 
    M_TranslateVec3(cb_viewpoint, &P);
    M_TranslateVec3(cb_viewpoint, &M);
@@ -466,7 +634,7 @@ static void R_calcSlope(const cbviewpoint_t &cb_viewpoint, visplane_t *pl)
    rslope->C.y *= 0.5f / view.focratio;
    rslope->C.z *= 0.5f;
 
-   rslope->zat = P_GetZAtf(pl->pslope, pl->viewxf, pl->viewyf);
+   rslope->zat = pl->pslope->getZAtf(pl->viewxf, pl->viewyf);
 
    // More help from randy. I was totally lost on this... 
    ixscale = view.tan / (float)xl;
@@ -482,43 +650,32 @@ static void R_calcSlope(const cbviewpoint_t &cb_viewpoint, visplane_t *pl)
 // Allocates and returns a new planehash_t object. The hash object is allocated
 // PU_LEVEL
 //
-planehash_t *R_NewPlaneHash(int chaincount)
+planehash_t *R_NewPlaneHash(int slotcount)
 {
-   planehash_t*  ret;
-   int           i;
-   
-   // Make sure chaincount is a power of 2
-   if((chaincount - 1) & chaincount)
+   // Make sure slotcount is a power of 2
+   if((slotcount - 1) & slotcount)
    {
       int c = 2;
-      while(c < chaincount)
+      while(c < slotcount)
          c <<= 1;
       
-      chaincount = c;
+      slotcount = c;
    }
    
-   ret = emalloctag(planehash_t *, sizeof(planehash_t), PU_LEVEL, nullptr);
-   ret->chaincount = chaincount;
-   ret->chains = emalloctag(visplane_t **, sizeof(visplane_t *) * chaincount, PU_LEVEL, nullptr);
-   ret->next = nullptr;
-   
-   for(i = 0; i < chaincount; i++)
-      ret->chains[i] = nullptr;
+   planehash_t *ret = emalloctag(planehash_t *, sizeof(planehash_t), PU_LEVEL, nullptr);
+   R_initPlaneHash(*ret, slotcount, PU_LEVEL);
       
    return ret;
 }
 
 //
-// Empties the chains of the given hash table and places the planes within 
-// in the free stack.
+// Empties the given hash table. The planes themselves belong to the arena.
 //
-void R_ClearPlaneHash(visplane_t **&freehead, planehash_t *table)
+void R_ClearPlaneHash(planehash_t *table)
 {
-   for(int i = 0; i < table->chaincount; i++)    // new code -- killough
-   {
-      for(*freehead = table->chains[i], table->chains[i] = nullptr; *freehead; )
-         freehead = &(*freehead)->next;
-   }
+   memset(table->slots, 0, table->slotcount * sizeof(planehashslot_t));
+   table->numslots = 0;
+   table->planes   = nullptr;
 }
 
 //
@@ -557,7 +714,8 @@ void R_ClearPlanes(planecontext_t &context, const contextbounds_t &bounds)
       context.ceilingclip[i] = overlaycclip[i] = a;
    }
 
-   R_ClearPlaneHash(context.freehead, &context.mainhash);
+   R_ClearPlaneHash(&context.mainhash);
+   R_resetPlaneArena(context.arena);
 
    context.lastopening = context.openings;
 }
@@ -566,39 +724,34 @@ void R_ClearPlanes(planecontext_t &context, const contextbounds_t &bounds)
 //
 // New function, by Lee Killough
 //
-static visplane_t *new_visplane(planecontext_t &context,
-                                unsigned hash, planehash_t *table)
+static visplane_t *new_visplane(planecontext_t &context, planehash_t *table)
 {
-   visplane_t *&freetail  = context.freetail;
-   visplane_t **&freehead = context.freehead;
+   visplane_t *check = R_allocPlane(context.arena);
 
-   visplane_t *check = freetail;
-
-   if(!check)
-      check = ecalloctag(visplane_t *, 1, sizeof *check, PU_VALLOC, nullptr);
-   else
-      if(!(freetail = freetail->next))
-         freehead = &freetail;
-
-   check->next = table->chains[hash];
-   table->chains[hash] = check;
+   check->next   = table->planes;
+   table->planes = check;
 
    check->table = table;
+   
+   return check;
+}
 
-   if(!check->top)
-   {
-      int *paddedTop, *paddedBottom;
+//
+// Enters a newly made plane into the lookup slots of its table.
+//
+static void R_enterPlane(planehash_t *table, unsigned int key, visplane_t *pl)
+{
+   // keep the load factor under 3/4
+   if((table->numslots + 1) * 4 > table->slotcount * 3)
+      R_growPlaneHash(*table);
 
-      // THREAD_TODO: Try make this use context.numcolumns again
-      check->max_width = static_cast<unsigned int>(video.width);
-      paddedTop        = ecalloctag(int *, 2 * (video.width + 2), sizeof(int), PU_VALLOC, nullptr);
-      paddedBottom     = paddedTop + video.width + 2;
+   const unsigned int mask = table->slotcount - 1;
+   unsigned int       slot = key & mask;
+   while(table->slots[slot].plane)
+      slot = (slot + 1) & mask;
 
-      check->top    = paddedTop    + 1;
-      check->bottom = paddedBottom + 1;
-   }
-   
-   return check;
+   table->slots[slot] = { key, pl };
+   table->numslots++;
 }
 
 //
@@ -615,7 +768,7 @@ visplane_t *R_FindPlane(cmapcontext_t &cmapcontext,
                         planehash_t *table)
 {
    visplane_t *check;
-   unsigned int hash;                      // killough
+   unsigned int key;
    float tsin, tcos;
 
    // SoM: table == nullptr means use main table
@@ -644,13 +797,17 @@ visplane_t *R_FindPlane(cmapcontext_t &cmapcontext,
    }
 
    // New visplane algorithm uses hash table -- killough
-   hash = visplane_hash(picnum, lightlevel, height >> 16, table->chaincount);
+   key = R_planeKey(height, picnum, lightlevel, offs, cmapcontext.zlight,
+                    cmapcontext.fixedcolormap, viewpoint.x, viewpoint.y, viewpoint.z,
+                    blendflags, opacity);
 
-   for(check = table->chains[hash]; check; check = check->next)  // killough
+   const unsigned int mask = table->slotcount - 1;
+   for(unsigned int slot = key & mask; table->slots[slot].plane; slot = (slot + 1) & mask)
    {
-      // FIXME: ok this has gotten out of hand now!
-      // We need a more intelligent hash function or something.
-      if(height == check->height &&
+      check = table->slots[slot].plane;
+
+      if(table->slots[slot].key == key &&
+         height == check->height &&
          picnum == check->picnum &&
          lightlevel == check->lightlevel &&
          offs == check->offs &&      // killough 2/28/98: Add offset checks
@@ -668,7 +825,8 @@ visplane_t *R_FindPlane(cmapcontext_t &cmapcontext,
         return check;
    }
 
-   check = new_visplane(planecontext, hash, table);         // killough
+   check = new_visplane(planecontext, table);         // killough
+   R_enterPlane(table, key, check);
 
    check->height = height;
    check->picnum = picnum;
@@ -719,25 +877,36 @@ visplane_t *R_FindPlane(cmapcontext_t &cmapcontext,
       check->viewzf =  cb_viewpoint.z;
    }
    
-   {
-      unsigned int i = 0;
-      int *p = check->top;
-      while(i < check->max_width) 
-         p[i++] = 0x7FFFFFFF;
-   }
-   
+   // the plane starts out empty; R_CheckPlane clears columns as it grows
+   check->root     = nullptr;
+   check->firstdup = nullptr;
+   check->nextdup  = nullptr;
+
    return check;
 }
 
+//
+// Marks columns x1 to x2 of a plane as holding nothing yet. Planes only clear
+// the columns they actually take in, rather than the whole screen width.
+//
+static void R_clearPlaneColumns(visplane_t *pl, int x1, int x2)
+{
+   int *p = pl->top + x1;
+   const int *const p_end = pl->top + x2 + 1;
+   // Unrolling this loop makes performance WORSE for optimised MSVC builds.
+   // Nothing makes sense any more.
+   while(p < p_end)
+      *(p++) = 0x7FFFFFFF;
+}
+
 //
 // From PrBoom+
 // cph 2003/04/18 - create duplicate of existing visplane and set initial range
 //
-visplane_t *R_DupPlane(planecontext_t &context, const visplane_t *pl, int start, int stop)
+visplane_t *R_DupPlane(planecontext_t &context, visplane_t *pl, int start, int stop)
 {
-   planehash_t *table = pl->table;
-   unsigned hash = visplane_hash(pl->picnum, pl->lightlevel, pl->height, table->chaincount);
-   visplane_t *new_pl = new_visplane(context, hash, table);
+   visplane_t *new_pl = new_visplane(context, pl->table);
+   visplane_t *root   = pl->root ? pl->root : pl;
 
    new_pl->height = pl->height;
    new_pl->picnum = pl->picnum;
@@ -771,17 +940,15 @@ visplane_t *R_DupPlane(planecontext_t &context, const visplane_t *pl, int start,
    memcpy(&new_pl->rslope, &pl->rslope, sizeof(rslope_t));
    new_pl->fullcolormap = pl->fullcolormap;
 
+   new_pl->root     = root;
+   new_pl->firstdup = nullptr;
+   new_pl->nextdup  = root->firstdup;
+   root->firstdup   = new_pl;
+
    visplane_t *retpl = new_pl;
    retpl->minx = start;
    retpl->maxx = stop;
-   {
-      int *p = retpl->top;
-      const int *const p_end  = p + retpl->max_width;
-      // Unrolling this loop makes performance WORSE for optimised MSVC builds.
-      // Nothing makes sense any more.
-      while(p < p_end)
-         *(p++) = 0x7FFFFFFF;
-   }
+   R_clearPlaneColumns(retpl, start, stop);
    return retpl;
 }
 
@@ -819,6 +986,14 @@ visplane_t *R_CheckPlane(planecontext_t &context, visplane_t *pl, int start, int
 
    if(x > intrh)
    {
+      // clear whatever columns the plane grows over
+      if(pl->minx > pl->maxx)
+         R_clearPlaneColumns(pl, unionl, unionh);
+      else
+      {
+         R_clearPlaneColumns(pl, unionl, pl->minx - 1);
+         R_clearPlaneColumns(pl, pl->maxx + 1, unionh);
+      }
       pl->minx = unionl;
       pl->maxx = unionh;
    }
@@ -851,6 +1026,90 @@ static void R_makeSpans(const R_FlatFunc flatfunc, const R_SlopeFunc slopefunc,
       spanstart[b2--] = x;
 }
 
+//
+// A span found while drawing a plane together with its duplicates
+//
+struct planespan_t
+{
+   int y, x1, x2;
+};
+
+static thread_local PODCollection<planespan_t> mergespans;
+
+//
+// As R_makeSpans, but saves the spans to be merged instead of drawing them
+//
+static void R_collectSpans(int *const spanstart, int x, int t1, int b1, int t2, int b2)
+{
+   for(; t2 > t1 && t1 <= b1; t1++)
+      mergespans.add({ t1, spanstart[t1], x - 1 });
+   for(; b2 < b1 && t1 <= b1; b1--)
+      mergespans.add({ b1, spanstart[b1], x - 1 });
+   while(t2 < t1 && t2 <= b2)
+      spanstart[t2++] = x;
+   while(b2 > b1 && t2 <= b2)
+      spanstart[b2--] = x;
+}
+
+//
+// True if a plane's duplicates are drawn along with it. Their spans can only
+// be joined when they map the same and don't blend, so slopes, whose light
+// is interpolated along the span, and any translucency are left alone.
+//
+static bool R_mergesDups(const visplane_t *pl)
+{
+   return pl->firstdup && !pl->pslope && !pl->bflags && pl->opacity == 255 &&
+          !(R_IsSkyFlat(pl->picnum) || pl->picnum & PL_SKYFLAT ||
+            R_SkyFlatForPicnum(pl->picnum));
+}
+
+//
+// Draws a plane and its duplicates as one. Their spans are gathered, sorted
+// by row, and spans that meet on a row are joined, so where a plane was only
+// split for R_CheckPlane's sake the rows come out whole.
+//
+static void R_drawMergedSpans(const R_FlatFunc flatfunc, const R_SlopeFunc slopefunc,
+                              cb_span_t &span, cb_slopespan_t &slopespan,
+                              const cb_plane_t &plane, int *const spanstart,
+                              visplane_t *root)
+{
+   mergespans.resize(0);
+
+   for(visplane_t *pl = root; pl; pl = (pl == root ? root->firstdup : pl->nextdup))
+   {
+      if(pl->minx > pl->maxx)
+         continue;
+
+      const int stop = pl->maxx + 1;
+      pl->top[pl->minx-1] = pl->top[stop] = 0x7FFFFFFF;
+
+      for(int x = pl->minx; x <= stop; x++)
+      {
+         R_collectSpans(
+            spanstart, x, pl->top[x - 1], pl->bottom[x - 1], pl->top[x], pl->bottom[x]
+         );
+      }
+   }
+
+   std::sort(mergespans.begin(), mergespans.end(),
+             [](const planespan_t &a, const planespan_t &b) {
+                return a.y < b.y || (a.y == b.y && a.x1 < b.x1);
+             });
+
+   const size_t numspans = mergespans.getLength();
+   for(size_t i = 0; i < numspans;)
+   {
+      const int y  = mergespans[i].y;
+      const int x1 = mergespans[i].x1;
+      int       x2 = mergespans[i].x2;
+
+      for(++i; i < numspans && mergespans[i].y == y && mergespans[i].x1 <= x2 + 1; ++i)
+         x2 = emax(x2, mergespans[i].x2);
+
+      plane.MapFunc(flatfunc, slopefunc, span, slopespan, plane, y, x1, x2);
+   }
+}
+
 //
 // Get the sky column from input parms. Shared by the sky drawers here.
 //
@@ -860,12 +1119,154 @@ inline static int32_t R_getSkyColum(angle_t an, int x, angle_t flip, int offset)
          / FRACUNIT;
 }
 
+//=============================================================================
+//
+// Sky cache
+//
+// A sky's pixels depend only on the view angle, never the view position, so
+// while the player doesn't turn every sky column comes out exactly as it did
+// last frame. The cache keeps the columns drawn for a few recent skies and
+// copies them back instead of drawing them again. Each cached column holds
+// one contiguous run of valid rows, grown as the sky is drawn over more of it.
+//
+
+bool r_skycache = true;
+
+#define NUMSKYCACHES 4
+
+//
+// Everything a sky column's pixels are computed from
+//
+struct skycachekey_t
+{
+   int                 texture, texture2; // texture2 is -1 for a single sky
+   int                 offset, offset2;
+   fixed_t             texmid, texmid2;
+   angle_t             angle, flip;
+   fixed_t             step;
+   float               ycenter;
+   const lighttable_t *colormap;
+   const columndrawer_t *engine;
+};
+
+struct skycache_t
+{
+   skycachekey_t key;
+   bool          valid;
+   unsigned int  lastuse;
+   byte         *pixels;     // video.height rows per column
+   int          *top, *bottom; // valid rows of each column; empty if top > bottom
+};
+
+static skycache_t   skycaches[NUMSKYCACHES];
+static unsigned int skycacheclock;
+
+VALLOCATION(skycaches)
+{
+   // the buffers were PU_VALLOC and are gone
+   for(skycache_t &cache : skycaches)
+      cache = {};
+}
+
+//
+// Forgets every cached sky, for when the view geometry or sky textures change.
+//
+void R_InvalidateSkyCache()
+{
+   for(skycache_t &cache : skycaches)
+      cache.valid = false;
+}
+
+static bool R_skyCacheKeysMatch(const skycachekey_t &a, const skycachekey_t &b)
+{
+   return a.texture == b.texture && a.texture2 == b.texture2 &&
+          a.offset == b.offset && a.offset2 == b.offset2 &&
+          a.texmid == b.texmid && a.texmid2 == b.texmid2 &&
+          a.angle == b.angle && a.flip == b.flip && a.step == b.step &&
+          a.ycenter == b.ycenter && a.colormap == b.colormap && a.engine == b.engine;
+}
+
+//
+// Finds the cache for a sky, taking over the least recently used one if it
+// isn't cached. Returns nullptr when the sky can't be cached this frame.
+//
+static skycache_t *R_getSkyCache(const skycachekey_t &key)
+{
+   // contexts share the caches, and the truecolor view isn't drawn in the
+   // paletted screen that they are filled from
+   if(!r_skycache || r_numcontexts > 1 || r_truecolorview)
+      return nullptr;
+
+   skycache_t *lru = &skycaches[0];
+   for(skycache_t &cache : skycaches)
+   {
+      if(cache.valid && R_skyCacheKeysMatch(cache.key, key))
+      {
+         cache.lastuse = ++skycacheclock;
+         return &cache;
+      }
+      if(!cache.valid || (lru->valid && cache.lastuse < lru->lastuse))
+         lru = &cache;
+   }
+
+   if(!lru->pixels)
+   {
+      lru->pixels = emalloctag(byte *, size_t(video.width) * video.height, PU_VALLOC, nullptr);
+      lru->top    = emalloctag(int *, 2 * video.width * sizeof(int), PU_VALLOC, nullptr);
+      lru->bottom = lru->top + video.width;
+   }
+   for(int x = 0; x < video.width; x++)
+   {
+      lru->top[x]    = video.height;
+      lru->bottom[x] = -1;
+   }
+
+   lru->key     = key;
+   lru->valid   = true;
+   lru->lastuse = ++skycacheclock;
+   return lru;
+}
+
+//
+// Copies rows y1 to y2 of a sky column from the cache, if they are all there.
+//
+static bool R_drawCachedSkyColumn(const skycache_t *cache, int x, int y1, int y2)
+{
+   if(!cache || y1 < cache->top[x] || y2 > cache->bottom[x])
+      return false;
+
+   memcpy(R_ADDRESS(x, y1), cache->pixels + x * video.height + y1, y2 - y1 + 1);
+   return true;
+}
+
+//
+// Records rows y1 to y2 of a freshly drawn sky column. If they neither touch
+// nor overlap the rows already held, they replace them.
+//
+static void R_storeSkyColumn(skycache_t *cache, int x, int y1, int y2)
+{
+   if(!cache)
+      return;
+
+   int &top = cache->top[x], &bottom = cache->bottom[x];
+   if(y1 > bottom + 1 || y2 < top - 1)
+   {
+      top    = y1;
+      bottom = y2;
+   }
+   else
+   {
+      top    = emin(top, y1);
+      bottom = emax(bottom, y2);
+   }
+
+   memcpy(cache->pixels + x * video.height + y1, R_ADDRESS(x, y1), y2 - y1 + 1);
+}
+
 // haleyjd: moved here from r_newsky.c
 static void do_draw_newsky(cmapcontext_t &context, const angle_t viewangle, visplane_t *pl)
 {
-   cb_column_t column = {};
-
-   R_ColumnFunc colfunc = r_column_engine->DrawColumn;
+   cb_column_t column = {}, column2;
 
    angle_t an = viewangle;
 
@@ -889,44 +1290,50 @@ static void do_draw_newsky(cmapcontext_t &context, const angle_t viewangle, visp
    if(getComp(comp_skymap) || !(column.colormap = context.fixedcolormap))
       column.colormap = context.fullcolormap;
       
-   // first draw sky 2 with R_DrawColumn (unmasked)
-   if(LevelInfo.sky2RowOffset != SKYROWOFFSET_DEFAULT)
-      column.texmid = LevelInfo.sky2RowOffset * FRACUNIT;
-   else
-      column.texmid = sky2->texturemid;
-   column.texheight = sky2->height;
-   column.skycolor = sky2->medianColor;
    column.step = M_FloatToFixed(view.pspriteystep);
+   column2 = column;
 
-   colfunc = r_column_engine->DrawSkyColumn;
-   for(int x = pl->minx; (column.x = x) <= pl->maxx; x++)
-   {
-      if((column.y1 = pl->top[x]) <= (column.y2 = pl->bottom[x]))
-      {
-         column.source = R_GetRawColumn(skyTexture2, R_getSkyColum(an, x, 0, offset2));
+   // sky 2 is drawn with R_DrawColumn (unmasked)
+   if(LevelInfo.sky2RowOffset != SKYROWOFFSET_DEFAULT)
+      column2.texmid = LevelInfo.sky2RowOffset * FRACUNIT;
+   else
+      column2.texmid = sky2->texturemid;
+   column2.texheight = sky2->height;
+   column2.skycolor = column.skycolor = sky2->medianColor;
 
-         colfunc(column);
-      }
-   }
-      
-   // now draw sky 1 with R_DrawNewSkyColumn (masked)
+   // sky 1 over it with R_DrawNewSkyColumn (masked)
    if(LevelInfo.skyRowOffset != SKYROWOFFSET_DEFAULT)
       column.texmid = LevelInfo.skyRowOffset * FRACUNIT;
    else
       column.texmid = sky1->texturemid;
    column.texheight = sky1->height;
 
-   column.step = M_FloatToFixed(view.pspriteystep);
-      
-   colfunc = r_column_engine->DrawNewSkyColumn;
-   for(int x = pl->minx; (column.x = x) <= pl->maxx; x++)
+   const skycachekey_t key =
    {
-      if((column.y1 = pl->top[x]) <= (column.y2 = pl->bottom[x]))
-      {
-         column.source = R_GetRawColumn(skyTexture, R_getSkyColum(an, x, 0, offset));
+      skyTexture, skyTexture2, offset, offset2, column.texmid, column2.texmid, an, 0,
+      column.step, view.ycenter, column.colormap, r_column_engine
+   };
+   skycache_t *cache = R_getSkyCache(key);
 
-         colfunc(column);
-      }
+   // columns don't overlap, so each can have both layers drawn in turn
+   for(int x = pl->minx; x <= pl->maxx; x++)
+   {
+      const int y1 = pl->top[x], y2 = pl->bottom[x];
+
+      if(y1 > y2 || R_drawCachedSkyColumn(cache, x, y1, y2))
+         continue;
+
+      column2.x  = column.x  = x;
+      column2.y1 = column.y1 = y1;
+      column2.y2 = column.y2 = y2;
+
+      column2.source = R_GetRawColumn(skyTexture2, R_getSkyColum(an, x, 0, offset2));
+      r_column_engine->DrawSkyColumn(column2);
+
+      column.source = R_GetRawColumn(skyTexture, R_getSkyColum(an, x, 0, offset));
+      r_column_engine->DrawNewSkyColumn(column);
+
+      R_storeSkyColumn(cache, x, y1, y2);
    }
 }
 
@@ -1040,6 +1447,19 @@ static void R_drawSky(angle_t viewangle, const visplane_t *pl, const skyflat_t *
    R_ColumnFunc colfunc = tilevert ? r_column_engine->DrawColumn :
                                      r_column_engine->DrawSkyColumn;
 
+   // Vertically scrolling skies change every tic, and are drawn by a column
+   // function that may buffer
+   skycache_t *cache = nullptr;
+   if(!tilevert)
+   {
+      const skycachekey_t key =
+      {
+         texture, -1, offset, 0, column.texmid, 0, an, flip, column.step, view.ycenter,
+         column.colormap, r_column_engine
+      };
+      cache = R_getSkyCache(key);
+   }
+
    // killough 10/98: Use sky scrolling offset, and possibly flip picture
    for(int x = pl->minx; x <= pl->maxx; x++)
    {
@@ -1048,12 +1468,33 @@ static void R_drawSky(angle_t viewangle, const visplane_t *pl, const skyflat_t *
       column.y1 = pl->top[x];
       column.y2 = pl->bottom[x];
 
-      if(column.y1 <= column.y2)
+      if(column.y1 <= column.y2 && !R_drawCachedSkyColumn(cache, x, column.y1, column.y2))
       {
          column.source = R_GetRawColumn(texture, R_getSkyColum(an, x, flip, offset));
          colfunc(column);
+         R_storeSkyColumn(cache, x, column.y1, column.y2);
+      }
+   }
+}
+
+//
+// Span drawer size for a flat, or a mip level of one, of the given size
+//
+static int R_flatSizeFor(int width, int height)
+{
+   if(width == height)
+   {
+      switch(width)
+      {
+      case 64:  return FLAT_64;
+      case 128: return FLAT_128;
+      case 256: return FLAT_256;
+      case 512: return FLAT_512;
+      default:  break;
       }
    }
+
+   return FLAT_GENERALIZED;
 }
 
 //
@@ -1061,7 +1502,7 @@ static void R_drawSky(angle_t viewangle, const visplane_t *pl, const skyflat_t *
 // haleyjd 08/30/02: slight restructuring to use hashed sky texture info cache.
 //
 static void do_draw_plane(cmapcontext_t &context, int *const spanstart,
-                          const angle_t viewangle, visplane_t *pl)
+                          const angle_t viewangle, visplane_t *pl, bool mergedups)
 {
    if(!(pl->minx <= pl->maxx))
       return;
@@ -1087,6 +1528,7 @@ static void do_draw_plane(cmapcontext_t &context, int *const spanstart,
       cb_span_t      span      = {};
       cb_slopespan_t slopespan = {};
       cb_plane_t     plane     = {};
+      planemip_t     mips[R_MAXMIPLEVELS + 1];
 
       R_FlatFunc  flatfunc  = R_Throw;
       R_SlopeFunc slopefunc = R_ThrowSlope;
@@ -1151,6 +1593,7 @@ static void do_draw_plane(cmapcontext_t &context, int *const spanstart,
       }
       else
          span.fg2rgb = span.bg2rgb = nullptr;
+      span.alpha = pl->opacity;
 
       if(pl->pslope)
          plane.slope = &pl->rslope;
@@ -1179,6 +1622,28 @@ static void do_draw_plane(cmapcontext_t &context, int *const spanstart,
             
             plane.fixedunitx = (float)(1 << (32 - rw));
             plane.fixedunity = (float)(1 << span.yshift);
+
+            if(r_mipmap && tex->mipdata && stylenum == SPAN_STYLE_NORMAL &&
+               plane.source == tex->bufferdata)
+            {
+               mips[0] = { plane.source, flatfunc, span.xshift, span.xmask, span.yshift };
+
+               for(int level = 1; level <= tex->nummips; level++)
+               {
+                  planemip_t &mip = mips[level];
+                  const int   w   = tex->width >> level;
+                  const int   h   = tex->height >> level;
+
+                  mip.source   = const_cast<byte *>(R_GetMipLevel(tex, level));
+                  mip.flatfunc = r_span_engine->DrawSpan[stylenum][R_flatSizeFor(w, h)];
+                  mip.yshift   = 32 - (rh - level);
+                  mip.xshift   = mip.yshift - (rw - level);
+                  mip.xmask    = (w - 1) << (32 - (rw - level) - mip.xshift);
+               }
+
+               plane.mips    = mips;
+               plane.nummips = tex->nummips;
+            }
          }
       }
        
@@ -1208,9 +1673,6 @@ static void do_draw_plane(cmapcontext_t &context, int *const spanstart,
       if(light < 0)
          light = 0;
 
-      stop = pl->maxx + 1;
-      pl->top[pl->minx-1] = pl->top[stop] = 0x7FFFFFFF;
-
       plane.planezlight   = pl->colormap[light]; //zlight[light];
       plane.colormap      = pl->fullcolormap;
       plane.fixedcolormap = pl->fixedcolormap; // haleyjd 10/16/06
@@ -1220,6 +1682,15 @@ static void do_draw_plane(cmapcontext_t &context, int *const spanstart,
 
       plane.MapFunc = (plane.slope == nullptr ? R_mapPlane : R_mapSlope);
 
+      if(mergedups)
+      {
+         R_drawMergedSpans(flatfunc, slopefunc, span, slopespan, plane, spanstart, pl);
+         return;
+      }
+
+      stop = pl->maxx + 1;
+      pl->top[pl->minx-1] = pl->top[stop] = 0x7FFFFFFF;
+
       for(int x = pl->minx; x <= stop; x++)
       {
          R_makeSpans(
@@ -1237,16 +1708,19 @@ static void do_draw_plane(cmapcontext_t &context, int *const spanstart,
 void R_DrawPlanes(cmapcontext_t &context, planehash_t &mainhash,
                   int *const spanstart, const angle_t viewangle, planehash_t *table)
 {
-   visplane_t *pl;
-   int i;
-   
+   RenderProfileScope profile(RPROF_PLANES);
+
    if(!table)
       table = &mainhash;
-   
-   for(i = 0; i < table->chaincount; ++i)
+
+   // overlays are left in their own order, as they may overlap and blend
+   const bool merge = (table == &mainhash);
+
+   for(visplane_t *pl = table->planes; pl; pl = pl->next)
    {
-      for(pl = table->chains[i]; pl; pl = pl->next)
-         do_draw_plane(context, spanstart, viewangle, pl);
+      if(merge && pl->root && R_mergesDups(pl->root))
+         continue; // drawn with its root
+      do_draw_plane(context, spanstart, viewangle, pl, merge && R_mergesDups(pl));
    }
 }
 
@@ -1254,7 +1728,7 @@ VALLOCATION(overlaySets)
 {
    R_ForEachContext([](rendercontext_t &basecontext) {
       for(planehash_t *set = basecontext.planecontext.r_overlayfreesets; set; set = set->next)
-         memset(set->chains, 0, set->chaincount * sizeof(*set->chains));
+         R_ClearPlaneHash(set);
    });
 }
 
@@ -1273,7 +1747,7 @@ planehash_t *R_NewOverlaySet(planecontext_t &context)
    }
    set = r_overlayfreesets;
    r_overlayfreesets = r_overlayfreesets->next;
-   R_ClearPlaneHash(context.freehead, set);
+   R_ClearPlaneHash(set);
    return set;
 }
 
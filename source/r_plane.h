@@ -47,14 +47,18 @@ extern float *floorcliparray, *ceilingcliparray;
 // SoM: We have to use secondary clipping arrays for portal overlays
 extern float *overlayfclip, *overlaycclip;
 
+extern bool r_skycache;
+
 void R_ClearPlanes(planecontext_t &context, const contextbounds_t &bounds);
 void R_ClearOverlayClips(const contextbounds_t &bounds);
 void R_DrawPlanes(cmapcontext_t &context, planehash_t &mainhash,
                   int *const spanstart, const angle_t viewangle, planehash_t *table);
 
+void R_InvalidateSkyCache();
+
 // Planehash stuff
-planehash_t *R_NewPlaneHash(int chaincount);
-void R_ClearPlaneHash(visplane_t **&freehead, planehash_t *table);
+planehash_t *R_NewPlaneHash(int slotcount);
+void R_ClearPlaneHash(planehash_t *table);
 
 
 visplane_t *R_FindPlane(cmapcontext_t &cmapcontext,
@@ -73,7 +77,7 @@ visplane_t *R_FindPlane(cmapcontext_t &cmapcontext,
                         byte opacity,        // SoM: Opacity for translucent planes
                         planehash_t *table); // SoM: Table. Can be nullptr
 
-visplane_t *R_DupPlane(planecontext_t &context, const visplane_t *pl, int start, int stop);
+visplane_t *R_DupPlane(planecontext_t &context, visplane_t *pl, int start, int stop);
 visplane_t *R_CheckPlane(planecontext_t &context, visplane_t *pl, int start, int stop);
 
 bool R_CompareSlopes(const pslope_t *s1, const pslope_t *s2);
@@ -92,6 +96,8 @@ struct cb_span_t
 
    // ioanch: more ptrs
    const void *alphamask;  // pointer to alphamask if applicable
+
+   unsigned int alpha;     // plane opacity (0-255), for the truecolor drawers
 };
 
 struct cb_slopespan_t
@@ -111,6 +117,14 @@ using R_SlopeFunc = void (*)(const cb_slopespan_t &, const cb_span_t &);
 using R_MapFunc   = void (*)(const R_FlatFunc, const R_SlopeFunc, cb_span_t &,
                              cb_slopespan_t &, const cb_plane_t &, int, int, int);
 
+// What changes between the mip levels a flat is drawn from
+struct planemip_t
+{
+   void        *source;
+   R_FlatFunc   flatfunc;
+   unsigned int xshift, xmask, yshift;
+};
+
 struct cb_plane_t
 {
    float xoffset, yoffset;
@@ -135,6 +149,10 @@ struct cb_plane_t
    // SoM: slopes.
    rslope_t *slope;
 
+   // Levels to draw from, the flat itself first, when it has mip levels
+   const planemip_t *mips;
+   int               nummips; // past the flat itself
+
    R_MapFunc MapFunc;
 };
 
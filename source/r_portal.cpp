@@ -41,14 +41,17 @@
 #include "r_bsp.h"
 #include "r_context.h"
 #include "r_draw.h"
+#include "r_draw32.h"
 #include "r_main.h"
 #include "r_plane.h"
 #include "r_portal.h"
+#include "r_profile.h"
 #include "r_sky.h"
 #include "r_state.h"
 #include "r_things.h"
 #include "v_alloc.h"
 #include "v_misc.h"
+#include "v_video.h"
 
 enum
 {
@@ -100,10 +103,7 @@ VALLOCATION(portals)
    {
       // clear portal overlay visplane hash tables
       if((hash = p->poverlay))
-      {
-         for(int i = 0; i < hash->chaincount; i++)
-            hash->chains[i] = nullptr;
-      }
+         R_ClearPlaneHash(hash);
    }
 
    R_ForEachContext([](rendercontext_t &basecontext) {
@@ -123,8 +123,7 @@ VALLOCATION(portals)
          {
             next = child->child;
             if((hash = child->poverlay))
-               for(int i = 0; i < hash->chaincount; ++i)
-                  hash->chains[i] = nullptr;
+               R_ClearPlaneHash(hash);
             efree(child->top);
             efree(child);
             child = next;
@@ -133,8 +132,7 @@ VALLOCATION(portals)
          // free this window
          next = rover->next;
          if((hash = rover->poverlay))
-            for(int i = 0; i < hash->chaincount; ++i)
-               hash->chains[i] = nullptr;
+            R_ClearPlaneHash(hash);
          efree(rover->top);
          efree(rover);
          rover = next;
@@ -146,8 +144,7 @@ VALLOCATION(portals)
       {
          pwindow_t *next = rover->next;
          if((hash = rover->poverlay))
-            for(int i = 0; i < hash->chaincount; ++i)
-               hash->chains[i] = nullptr;
+            R_ClearPlaneHash(hash);
          efree(rover->top);
          efree(rover);
          rover = next;
@@ -191,7 +188,7 @@ static void R_clearPortalWindow(planecontext_t &context, const contextbounds_t &
       if(!window->poverlay)
          window->poverlay = R_NewOverlaySet(context);
       else
-         R_ClearPlaneHash(context.freehead, window->poverlay);
+         R_ClearPlaneHash(window->poverlay);
    }
 }
 
@@ -1000,6 +997,13 @@ static void R_showTainted(cmapcontext_t &cmapcontext, planecontext_t &planeconte
       if(count <= 0)
          continue;
 
+      if(r_truecolorview)
+      {
+         uint32_t *dest32 = R_ADDRESS32(i, y1);
+         for(int y = 0; y < count; y++)
+            dest32[y] = Col2RGB32[GameModeInfo->blackIndex];
+      }
+
       dest = R_ADDRESS(i, y1);
 
       while(count > 0)
@@ -1141,7 +1145,10 @@ static void R_renderWorldPortal(rendercontext_t &context, pwindow_t *window)
    }
 
    R_incrementRenderDepth(portalcontext.renderdepth);
-   R_RenderBSPNode(context, numnodes - 1);
+   {
+      RenderProfileScope profile(RPROF_BSP);
+      R_RenderBSPNode(context, numnodes - 1);
+   }
 
    // Only push the overlay if this is the head window
    R_PushPost(bspcontext, spritecontext, bounds, true, window->head == window ? window : nullptr);
@@ -1350,13 +1357,13 @@ void R_MovePortalOverlayToWindow(cmapcontext_t &cmapcontext, planecontext_t &pla
 //
 // Called at the start of each frame
 //
-void R_ClearPortals(visplane_t **&freehead)
+void R_ClearPortals()
 {
    portal_t *r = portals;
    
    while(r)
    {
-      R_ClearPlaneHash(freehead, r->poverlay);
+      R_ClearPlaneHash(r->poverlay);
       r = r->next;
    }
 }
@@ -1371,6 +1378,8 @@ void R_RenderPortals(rendercontext_t &context)
    pwindow_t      *&unusedhead    = portalcontext.unusedhead;
    portalrender_t  &portalrender  = portalcontext.portalrender;
 
+   RenderProfileScope profile(RPROF_PORTALS);
+
    pwindow_t *w;
 
    while(windowhead)
@@ -1381,7 +1390,14 @@ void R_RenderPortals(rendercontext_t &context)
 //      portalrender.overlay = windowhead->portal->poverlay;
 
       if(windowhead->maxx >= windowhead->minx)
+      {
+         for(w = windowhead; w; w = w->child)
+         {
+            if(w->maxx >= w->minx)
+               portalcontext.windowcolumns += w->maxx - w->minx + 1;
+         }
          windowhead->func(context, windowhead);
+      }
 
       portalrender.active = false;
       portalrender.w = nullptr;
@@ -1549,6 +1565,7 @@ static void R_pairPortalLines(line_t &line, line_t &pline)
          line.sidenum[1] = line.sidenum[0];
          line.flags &= ~ML_BLOCKING;
          line.flags |= ML_TWOSIDED;
+         P_UpdateLineHot(line);
       }
    }
 
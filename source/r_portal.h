@@ -219,7 +219,7 @@ portal_t *R_GetPlanePortal(const sector_t *sector);
 void R_MovePortalOverlayToWindow(cmapcontext_t &cmapcontext, planecontext_t &context, const viewpoint_t &viewpoint,
                                  const cbviewpoint_t &cb_viewpoint, const contextbounds_t &bounds,
                                  cb_seg_t &seg, surf_e surf);
-void R_ClearPortals(visplane_t **&freehead);
+void R_ClearPortals();
 void R_RenderPortals(rendercontext_t &context);
 
 portal_t *R_GetLinkedPortal(int markerlinenum, int anchorlinenum, 
@@ -0,0 +1,426 @@
+//
+// The Eternity Engine
+// Copyright(C) 2026 James Haley, Max Waine, et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+// Additional terms and conditions compatible with the GPLv3 apply. See the
+// file COPYING-EE for details.
+//
+// Purpose: Render stage profiler.
+//  Per-frame stage times are kept in a ring of recent frames for every slot,
+//  from which the console report and HUD overlay derive average, 95th
+//  percentile and worst times. -profilecsv <file> additionally writes every
+//  frame of a -timedemo run out as one CSV row.
+//
+
+#include <algorithm>
+#include <chrono>
+
+#include "z_zone.h"
+#include "i_system.h"
+
+#include "c_io.h"
+#include "c_runcmd.h"
+#include "doomstat.h"
+#include "e_fonts.h"
+#include "m_argv.h"
+#include "m_compare.h"
+#include "m_qstr.h"
+#include "psnprntf.h"
+#include "r_context.h"
+#include "r_profile.h"
+#include "v_font.h"
+#include "v_misc.h"
+
+using profclock_t = std::chrono::steady_clock;
+
+// Number of recent frames statistics are taken over
+static constexpr int PROFILEHISTORY = 256;
+
+static const char *const stagenames[RPROF_NUMSTAGES] =
+{
+   "bsp", "walls", "planes", "portals", "postbsp", "psprites", "blit",
+};
+
+//
+// Timing state for one thread. Only the owning thread touches it mid-frame;
+// the main thread reads it once all contexts have finished.
+//
+struct profileslot_t
+{
+   profclock_t::time_point last;                   // time of the last stage change
+   int                     stage;                  // innermost running stage
+   int64_t                 frame[RPROF_NUMSTAGES]; // ns spent this frame
+   float history[PROFILEHISTORY][RPROF_NUMSTAGES]; // us, per recent frame
+};
+
+//
+// Average, 95th percentile and maximum of a stage, in microseconds
+//
+struct profilestats_t
+{
+   float avg, p95, max;
+};
+
+bool r_profiling;
+
+static profileslot_t *profileslots;
+static int            numprofileslots;
+static int            historypos;
+static int            numhistory;
+
+// Slot 0 is the main thread; context threads take the slots after it
+static thread_local int profileslot;
+
+static bool r_profilehud;
+
+static char    *csvfilename;
+static FILE    *csvfile;
+static uint64_t csvframe;
+
+//
+// Number of slots needed for the current context count
+//
+static int R_profileSlotsWanted()
+{
+   return r_numcontexts > 1 ? r_numcontexts + 1 : 1;
+}
+
+//
+// Forgets all history, sizing the slots for the current context count.
+// Must only be called between frames.
+//
+static void R_resetProfile()
+{
+   const int wanted = R_profileSlotsWanted();
+
+   if(wanted != numprofileslots)
+   {
+      efree(profileslots);
+      profileslots    = estructalloc(profileslot_t, wanted);
+      numprofileslots = wanted;
+   }
+
+   for(int i = 0; i < numprofileslots; i++)
+   {
+      profileslots[i] = profileslot_t();
+      profileslots[i].stage = RPROF_NONE;
+   }
+
+   historypos = numhistory = 0;
+}
+
+//
+// Starts charging time on this thread to stage. Returns the stage that was
+// running, to be passed back to R_ProfileLeave.
+//
+int R_ProfileEnter(rprofstage_e stage)
+{
+   profileslot_t &slot = profileslots[profileslot];
+   const profclock_t::time_point now = profclock_t::now();
+   const int prevstage = slot.stage;
+
+   if(prevstage != RPROF_NONE)
+      slot.frame[prevstage] += (now - slot.last).count();
+
+   slot.stage = stage;
+   slot.last  = now;
+   return prevstage;
+}
+
+//
+// Ends the innermost stage on this thread and resumes prevstage.
+//
+void R_ProfileLeave(int prevstage)
+{
+   profileslot_t &slot = profileslots[profileslot];
+   const profclock_t::time_point now = profclock_t::now();
+
+   slot.frame[slot.stage] += (now - slot.last).count();
+   slot.stage = prevstage;
+   slot.last  = now;
+}
+
+//
+// Called by each render context thread with the index of its context.
+//
+void R_ProfileSetThreadSlot(int context)
+{
+   profileslot = context + 1;
+}
+
+//
+// Checks for -profilecsv, which turns profiling on from startup.
+//
+void R_ProfileInit()
+{
+   int p;
+
+   static_assert(std::ratio_less_equal<profclock_t::period, std::micro>::value,
+                 "profiler clock is too coarse");
+
+   if((p = M_CheckParm("-profilecsv")) && ++p < myargc)
+   {
+      csvfilename = estrdup(myargv[p]);
+      r_profiling = true;
+      R_resetProfile();
+   }
+}
+
+//
+// Turns profiling on, with fresh history if it was off.
+//
+void R_ProfileStart()
+{
+   if(!r_profiling)
+      R_resetProfile();
+   r_profiling = true;
+}
+
+//
+// Writes the header on the first frame of a timed demo, and one row for every
+// frame after that.
+//
+static void R_writeProfileCSV()
+{
+   if(!csvfile)
+   {
+      if(!(csvfile = fopen(csvfilename, "w")))
+      {
+         C_Printf(FC_ERROR "Couldn't open %s for profiling output\n", csvfilename);
+         efree(csvfilename);
+         csvfilename = nullptr;
+         return;
+      }
+
+      fputs("frame,gametic", csvfile);
+      for(int i = 0; i < numprofileslots; i++)
+      {
+         for(int stage = 0; stage < RPROF_NUMSTAGES; stage++)
+         {
+            if(i)
+               fprintf(csvfile, ",ctx%d_%s", i - 1, stagenames[stage]);
+            else
+               fprintf(csvfile, ",main_%s", stagenames[stage]);
+         }
+      }
+      fputc('\n', csvfile);
+   }
+
+   fprintf(csvfile, "%llu,%d", static_cast<unsigned long long>(csvframe++), gametic);
+   for(int i = 0; i < numprofileslots; i++)
+   {
+      for(int stage = 0; stage < RPROF_NUMSTAGES; stage++)
+         fprintf(csvfile, ",%.1f", profileslots[i].history[historypos][stage]);
+   }
+   fputc('\n', csvfile);
+}
+
+//
+// Closes the CSV file, if one is being written.
+//
+void R_ProfileCloseCSV()
+{
+   if(csvfile)
+   {
+      fclose(csvfile);
+      csvfile = nullptr;
+   }
+}
+
+//
+// Moves this frame's times into the history. Call once per displayed frame,
+// after the blit.
+//
+void R_ProfileEndFrame()
+{
+   if(!r_profiling)
+      return;
+
+   if(numprofileslots != R_profileSlotsWanted())
+   {
+      R_resetProfile(); // the frame's samples belong to the old layout
+      return;
+   }
+
+   for(int i = 0; i < numprofileslots; i++)
+   {
+      profileslot_t &slot = profileslots[i];
+
+      for(int stage = 0; stage < RPROF_NUMSTAGES; stage++)
+      {
+         slot.history[historypos][stage] = float(slot.frame[stage]) *
+            (float(profclock_t::period::num) * 1000000.0f / float(profclock_t::period::den));
+         slot.frame[stage] = 0;
+      }
+   }
+
+   if(csvfilename && timingdemo)
+      R_writeProfileCSV();
+
+   historypos = (historypos + 1) % PROFILEHISTORY;
+   numhistory = emin(numhistory + 1, PROFILEHISTORY);
+}
+
+//
+// Stage times of the last frame to end, in microseconds, summed over the
+// main thread and every context.
+//
+void R_ProfileLastFrame(float (&us)[RPROF_NUMSTAGES])
+{
+   const int last = (historypos + PROFILEHISTORY - 1) % PROFILEHISTORY;
+
+   for(int stage = 0; stage < RPROF_NUMSTAGES; stage++)
+   {
+      us[stage] = 0.0f;
+      for(int i = 0; numhistory && i < numprofileslots; i++)
+         us[stage] += profileslots[i].history[last][stage];
+   }
+}
+
+const char *R_ProfileStageName(int stage)
+{
+   return stagenames[stage];
+}
+
+//
+// Derives the statistics for one stage of one slot from its history.
+//
+static profilestats_t R_profileStats(const profileslot_t &slot, int stage)
+{
+   float samples[PROFILEHISTORY];
+   profilestats_t stats = {};
+
+   if(!numhistory)
+      return stats;
+
+   float total = 0.0f;
+   for(int i = 0; i < numhistory; i++)
+   {
+      samples[i] = slot.history[i][stage];
+      total     += samples[i];
+      stats.max  = emax(stats.max, samples[i]);
+   }
+   stats.avg = total / float(numhistory);
+
+   // Nearest-rank percentile
+   const int rank = (numhistory * 95 + 99) / 100 - 1;
+   std::nth_element(samples, samples + rank, samples + numhistory);
+   stats.p95 = samples[rank];
+
+   return stats;
+}
+
+static const char *const PROFILEHEADER = "stage         avg     p95     max\n";
+
+//
+// Formats the statistics of one slot, one line per stage.
+//
+static void R_formatProfileSlot(qstring &out, int i, bool console)
+{
+   char line[64];
+
+   if(i)
+      psnprintf(line, sizeof(line), "context %d\n", i - 1);
+   else
+      psnprintf(line, sizeof(line), numprofileslots > 1 ? "main thread\n" : "renderer\n");
+
+   if(console)
+      out.concat(FC_HI).concat(line).concat(FC_NORMAL);
+   else
+      out.concat(line);
+
+   for(int stage = 0; stage < RPROF_NUMSTAGES; stage++)
+   {
+      // Context threads never run the main thread's stages
+      if(i && stage >= RPROF_BLIT)
+         continue;
+
+      const profilestats_t stats = R_profileStats(profileslots[i], stage);
+      psnprintf(line, sizeof(line), "%-9s %7.0f %7.0f %7.0f\n", stagenames[stage],
+                stats.avg, stats.p95, stats.max);
+      out.concat(line);
+   }
+}
+
+//
+// Draws the statistics over the game view while r_profilehud is on.
+//
+void R_ProfileDrawer()
+{
+   if(!r_profiling || !r_profilehud || !profileslots)
+      return;
+
+   qstring msg(PROFILEHEADER);
+
+   for(int i = 0; i < numprofileslots; i++)
+      R_formatProfileSlot(msg, i, false);
+   V_FontWriteText(E_FontForName("ee_smallfont"), msg.constPtr(), 5, 30);
+}
+
+VARIABLE_TOGGLE(r_profilehud, nullptr, onoff);
+CONSOLE_VARIABLE(r_profilehud, r_profilehud, 0) {}
+
+//
+// r_profile [on | off | reset]
+// Turns the profiler on or off, or prints per-stage times in microseconds over
+// the last few hundred frames.
+//
+CONSOLE_COMMAND(r_profile, 0)
+{
+   if(Console.argc >= 1)
+   {
+      if(!Console.argv[0]->strCaseCmp("on"))
+      {
+         R_ProfileStart();
+         C_Printf("Render profiling on.\n");
+      }
+      else if(!Console.argv[0]->strCaseCmp("off"))
+      {
+         r_profiling = false;
+         C_Printf("Render profiling off.\n");
+      }
+      else if(!Console.argv[0]->strCaseCmp("reset"))
+      {
+         if(r_profiling)
+            R_resetProfile();
+         C_Printf("Render profile reset.\n");
+      }
+      else
+         C_Printf("usage: r_profile [on | off | reset]\n");
+      return;
+   }
+
+   if(!r_profiling || !numhistory)
+   {
+      C_Printf("No render profile; start one with r_profile on.\n");
+      return;
+   }
+
+   C_Printf(FC_HI "Render stage times over %d frames (us):\n" FC_NORMAL "%s", numhistory,
+            PROFILEHEADER);
+
+   // One slot at a time, to stay within what C_Printf can format
+   for(int i = 0; i < numprofileslots; i++)
+   {
+      qstring msg;
+
+      R_formatProfileSlot(msg, i, true);
+      C_Printf("%s", msg.constPtr());
+   }
+}
+
+// EOF
+
@@ -0,0 +1,90 @@
+//
+// The Eternity Engine
+// Copyright(C) 2026 James Haley, Max Waine, et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+// Additional terms and conditions compatible with the GPLv3 apply. See the
+// file COPYING-EE for details.
+//
+// Purpose: Render stage profiler.
+//  Scoped timers charge elapsed time to the innermost active stage on the
+//  calling thread, so nested stages are exclusive and a frame's stages add up
+//  to the time spent inside any of them. Each render context thread has its
+//  own slot; the main thread has another for the work done outside contexts.
+//
+
+#ifndef R_PROFILE_H__
+#define R_PROFILE_H__
+
+enum rprofstage_e
+{
+   RPROF_BSP,      // R_RenderBSPNode
+   RPROF_WALLS,    // R_StoreWallRange
+   RPROF_PLANES,   // R_DrawPlanes
+   RPROF_PORTALS,  // R_RenderPortals
+   RPROF_POSTBSP,  // R_DrawPostBSP
+   RPROF_PSPRITES, // R_DrawPlayerSprites
+   RPROF_BLIT,     // I_FinishUpdate
+   RPROF_NUMSTAGES,
+
+   RPROF_NONE = RPROF_NUMSTAGES
+};
+
+extern bool r_profiling;
+
+int  R_ProfileEnter(rprofstage_e stage);
+void R_ProfileLeave(int prevstage);
+
+void R_ProfileSetThreadSlot(int slot);
+void R_ProfileInit();
+void R_ProfileStart();
+void R_ProfileEndFrame();
+void R_ProfileDrawer();
+void R_ProfileCloseCSV();
+
+const char *R_ProfileStageName(int stage);
+void R_ProfileLastFrame(float (&us)[RPROF_NUMSTAGES]);
+
+//
+// Times the enclosing scope as the given stage while profiling is enabled.
+//
+class RenderProfileScope
+{
+public:
+   explicit RenderProfileScope(rprofstage_e stage)
+      : active(r_profiling), prevstage(RPROF_NONE)
+   {
+      if(active)
+         prevstage = R_ProfileEnter(stage);
+   }
+
+   ~RenderProfileScope()
+   {
+      if(active)
+         R_ProfileLeave(prevstage);
+   }
+
+   RenderProfileScope(const RenderProfileScope &) = delete;
+   RenderProfileScope &operator = (const RenderProfileScope &) = delete;
+
+private:
+   bool active; // latched, so toggling mid-frame can't unbalance the stack
+   int  prevstage;
+};
+
+#endif
+
+// EOF
+
@@ -0,0 +1,808 @@
+//
+// The Eternity Engine
+// Copyright(C) 2026 James Haley, Max Waine, et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+// Additional terms and conditions compatible with the GPLv3 apply. See the
+// file COPYING-EE for details.
+//
+// Purpose: Potentially visible sets for BSP traversal.
+//  Every subsector is given the convex cell the nodes carve for it, trimmed
+//  behind its one-sided walls. Cells sharing a stretch of partition line are
+//  joined by a portal. Sight is then flowed from each portal of a cell
+//  through chains of portals, narrowing the window at each step to what can
+//  still be seen through both the source and the last portal passed.
+//
+
+#include <atomic>
+#include <math.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "z_zone.h"
+#include "c_io.h"
+#include "c_runcmd.h"
+#include "d_jobs.h"
+#include "doomstat.h"
+#include "m_collection.h"
+#include "m_compare.h"
+#include "p_levelcache.h"
+#include "r_defs.h"
+#include "r_main.h"
+#include "r_pvs.h"
+#include "r_state.h"
+#include "v_misc.h"
+
+bool r_pvs;
+
+const byte *r_pvsrow;
+const byte *r_pvsnodes;
+
+// The table grows with the square of the subsector count, so bigger maps go
+// without
+static constexpr int PVS_MAXSUBSECTORS = 16384;
+
+// Flow steps allowed for the whole level before the build is abandoned
+static constexpr int64_t PVS_MAXSTEPS = int64_t(1) << 26;
+
+// Points this close to a clipping line count as on it
+static constexpr double PVS_EPSILON = 1.0 / 16;
+
+// Map units by which sight windows are widened, to cover the difference
+// between these cells and the fixed-point tests that pick the view subsector
+static constexpr double PVS_SLACK = 1.0;
+
+// Edge label of cell sides nothing can be seen through
+static constexpr int PVS_SOLID = -1;
+
+// Name of the saved visibility in the level cache; change it whenever the
+// build could come out differently for the same geometry
+static const char *const PVS_CACHEKIND = "pvs1";
+
+static byte *pvsrows;      // numsubsectors rows of pvsrowbytes, PU_LEVEL
+static int   pvsrowbytes;
+static byte *pvsnodevis;   // per node, for the subsector in pvsviewsub
+static int  *pvsnodeorder; // nodes, children before parents
+static int   pvsviewsub;
+
+struct pvspoint_t
+{
+   double x, y;
+};
+
+// a * x + b * y + c is the distance from the line, positive on its left
+struct pvsline_t
+{
+   double a, b, c;
+};
+
+// A cell corner, and the label of the side running to the next corner:
+// (node << 1 | child side) for partition lines, or PVS_SOLID
+struct pvsvert_t
+{
+   pvspoint_t p;
+   int        label;
+};
+
+using pvspoly_t = PODCollection<pvsvert_t>;
+
+// A cell side lying on a partition line, as an interval along it
+struct pvsedge_t
+{
+   int    label;
+   int    cell;
+   double t0, t1;
+};
+
+// One way through a shared stretch of partition line. The cell it leads to
+// is on the left of p0 -> p1, the positive side of line.
+struct pvsportal_t
+{
+   pvspoint_t p0, p1;
+   pvsline_t  line;
+   int        from, to;
+};
+
+// A window still to be looked through: part of a portal, between u0 and u1
+struct pvswork_t
+{
+   int    portal;
+   double u0, u1;
+};
+
+// Memo of the widest window each portal was entered by, for one source
+struct pvsmemo_t
+{
+   int    source;
+   double u0, u1;
+};
+
+static pvsline_t R_pvsLineThrough(const pvspoint_t &p0, const pvspoint_t &p1)
+{
+   const double dx  = p1.x - p0.x;
+   const double dy  = p1.y - p0.y;
+   const double len = sqrt(dx * dx + dy * dy);
+
+   return { -dy / len, dx / len, (dy * p0.x - dx * p0.y) / len };
+}
+
+static inline double R_pvsDist(const pvsline_t &line, const pvspoint_t &p)
+{
+   return line.a * p.x + line.b * p.y + line.c;
+}
+
+static inline pvsline_t R_pvsFlip(const pvsline_t &line)
+{
+   return { -line.a, -line.b, -line.c };
+}
+
+//
+// Clips a convex polygon to the positive side of a line. The side added along
+// the line gets the given label.
+//
+static void R_pvsClipPoly(const pvspoly_t &in, pvspoly_t &out, const pvsline_t &line,
+                          int label)
+{
+   const size_t n = in.getLength();
+
+   out.makeEmpty();
+   for(size_t i = 0; i < n; i++)
+   {
+      const pvsvert_t &cur = in[i];
+      const pvsvert_t &nxt = in[(i + 1) % n];
+      const double     dc  = R_pvsDist(line, cur.p);
+      const double     dn  = R_pvsDist(line, nxt.p);
+
+      if(dc >= -PVS_EPSILON)
+      {
+         if(dn >= -PVS_EPSILON)
+            out.add(cur);
+         else if(dc > PVS_EPSILON)
+         {
+            const double frac = dc / (dc - dn);
+            out.add(cur);
+            out.add({ { cur.p.x + (nxt.p.x - cur.p.x) * frac,
+                        cur.p.y + (nxt.p.y - cur.p.y) * frac }, label });
+         }
+         else
+            out.add({ cur.p, label }); // leaves right here, along the line
+      }
+      else if(dn > PVS_EPSILON)
+      {
+         const double frac = dc / (dc - dn);
+         out.add({ { cur.p.x + (nxt.p.x - cur.p.x) * frac,
+                     cur.p.y + (nxt.p.y - cur.p.y) * frac }, cur.label });
+      }
+   }
+
+   if(out.getLength() < 3)
+      out.makeEmpty();
+}
+
+//
+// Line a node partitions along, positive on the side of the given child.
+//
+static pvsline_t R_pvsNodeLine(const node_t &node, int side)
+{
+   const pvspoint_t o = { M_FixedToDouble(node.x), M_FixedToDouble(node.y) };
+   const pvspoint_t d = { o.x + M_FixedToDouble(node.dx), o.y + M_FixedToDouble(node.dy) };
+
+   // R_PointOnSide puts the left of the partition on side 1
+   const pvsline_t line = R_pvsLineThrough(o, d);
+   return side ? line : R_pvsFlip(line);
+}
+
+//
+// Carves the cell of every subsector below a node out of poly.
+//
+static void R_pvsBuildCells(int bspnum, const pvspoly_t &poly, pvspoly_t *cells)
+{
+   if(bspnum & NF_SUBSECTOR)
+   {
+      const int          num = bspnum == -1 ? 0 : bspnum & ~NF_SUBSECTOR;
+      const subsector_t &ss  = subsectors[num];
+      pvspoly_t          clipped;
+
+      cells[num].assign(poly);
+
+      // Anything behind a one-sided wall of the subsector is the void. The
+      // subsector is convex, so it is all in front of each of them.
+      for(int i = 0; i < ss.numlines && cells[num].getLength(); i++)
+      {
+         const seg_t &seg = segs[ss.firstline + i];
+         if(!seg.linedef || seg.backsector)
+            continue;
+
+         const pvspoint_t v1 = { M_FixedToDouble(seg.v1->x), M_FixedToDouble(seg.v1->y) };
+         const pvspoint_t v2 = { M_FixedToDouble(seg.v2->x), M_FixedToDouble(seg.v2->y) };
+         if(fabs(v1.x - v2.x) + fabs(v1.y - v2.y) < PVS_EPSILON)
+            continue;
+
+         // segs face right
+         R_pvsClipPoly(cells[num], clipped, R_pvsLineThrough(v2, v1), PVS_SOLID);
+         cells[num].assign(clipped);
+      }
+      return;
+   }
+
+   const node_t &node = nodes[bspnum];
+   pvspoly_t     half;
+
+   for(int side = 0; side < 2; side++)
+   {
+      R_pvsClipPoly(poly, half, R_pvsNodeLine(node, side), bspnum << 1 | side);
+      R_pvsBuildCells(node.children[side], half, cells);
+   }
+}
+
+static int R_pvsCompareEdges(const void *a, const void *b)
+{
+   const pvsedge_t &ea = *static_cast<const pvsedge_t *>(a);
+   const pvsedge_t &eb = *static_cast<const pvsedge_t *>(b);
+
+   if(ea.label != eb.label)
+      return ea.label < eb.label ? -1 : 1;
+   if(ea.t0 != eb.t0)
+      return ea.t0 < eb.t0 ? -1 : 1;
+   return 0;
+}
+
+//
+// Joins cells across every stretch of partition line that both sides border.
+//
+static void R_pvsBuildPortals(const pvspoly_t *cells, PODCollection<pvsportal_t> &portals)
+{
+   PODCollection<pvsedge_t> edges;
+   PODCollection<pvsedge_t> pieces;
+
+   for(int c = 0; c < numsubsectors; c++)
+   {
+      const pvspoly_t   &cell = cells[c];
+      const size_t       n    = cell.getLength();
+      const subsector_t &ss   = subsectors[c];
+
+      for(size_t i = 0; i < n; i++)
+      {
+         if(cell[i].label == PVS_SOLID)
+            continue;
+
+         const node_t    &node = nodes[cell[i].label >> 1];
+         const double     ox   = M_FixedToDouble(node.x);
+         const double     oy   = M_FixedToDouble(node.y);
+         const double     dx   = M_FixedToDouble(node.dx);
+         const double     dy   = M_FixedToDouble(node.dy);
+         const double     len  = sqrt(dx * dx + dy * dy);
+         const pvsline_t  line = R_pvsNodeLine(node, 1);
+         const pvspoint_t &p   = cell[i].p;
+         const pvspoint_t &q   = cell[(i + 1) % n].p;
+         const double     tp   = ((p.x - ox) * dx + (p.y - oy) * dy) / len;
+         const double     tq   = ((q.x - ox) * dx + (q.y - oy) * dy) / len;
+
+         pieces.makeEmpty();
+         pieces.add({ cell[i].label, c, emin(tp, tq), emax(tp, tq) });
+
+         // Nodebuilders mostly partition along walls, so this side may be
+         // one. Cut away every one-sided seg of the cell lying along it.
+         for(int s = 0; s < ss.numlines && pieces.getLength(); s++)
+         {
+            const seg_t &seg = segs[ss.firstline + s];
+            if(!seg.linedef || seg.backsector)
+               continue;
+
+            const pvspoint_t v1 = { M_FixedToDouble(seg.v1->x), M_FixedToDouble(seg.v1->y) };
+            const pvspoint_t v2 = { M_FixedToDouble(seg.v2->x), M_FixedToDouble(seg.v2->y) };
+            if(fabs(R_pvsDist(line, v1)) > PVS_EPSILON || fabs(R_pvsDist(line, v2)) > PVS_EPSILON)
+               continue;
+
+            const double t1 = ((v1.x - ox) * dx + (v1.y - oy) * dy) / len;
+            const double t2 = ((v2.x - ox) * dx + (v2.y - oy) * dy) / len;
+            const double lo = emin(t1, t2), hi = emax(t1, t2);
+
+            for(size_t k = pieces.getLength(); k-- > 0; )
+            {
+               const pvsedge_t piece = pieces[k];
+               if(hi <= piece.t0 || lo >= piece.t1)
+                  continue;
+
+               pieces[k] = pieces.back();
+               pieces.pop();
+               if(lo - piece.t0 > PVS_EPSILON)
+                  pieces.add({ piece.label, c, piece.t0, lo });
+               if(piece.t1 - hi > PVS_EPSILON)
+                  pieces.add({ piece.label, c, hi, piece.t1 });
+            }
+         }
+
+         for(const pvsedge_t &piece : pieces)
+            edges.add(piece);
+      }
+   }
+
+   if(!edges.getLength())
+      return;
+
+   qsort(edges.begin(), edges.getLength(), sizeof(pvsedge_t), R_pvsCompareEdges);
+
+   // labels of a node's two sides are adjacent, so its edges are one run
+   // for side 0 followed by one for side 1
+   const size_t numedges = edges.getLength();
+   size_t       start    = 0;
+   while(start < numedges)
+   {
+      const int nodenum = edges[start].label >> 1;
+      size_t    mid     = start;
+      size_t    end;
+
+      while(mid < numedges && edges[mid].label == nodenum << 1)
+         ++mid;
+      end = mid;
+      while(end < numedges && edges[end].label == (nodenum << 1 | 1))
+         ++end;
+
+      const node_t &node = nodes[nodenum];
+      const double  ox   = M_FixedToDouble(node.x);
+      const double  oy   = M_FixedToDouble(node.y);
+      const double  dx   = M_FixedToDouble(node.dx);
+      const double  dy   = M_FixedToDouble(node.dy);
+      const double  len  = sqrt(dx * dx + dy * dy);
+
+      size_t i = start, j = mid;
+      while(i < mid && j < end)
+      {
+         const pvsedge_t &e0 = edges[i];
+         const pvsedge_t &e1 = edges[j];
+         const double     lo = emax(e0.t0, e1.t0);
+         const double     hi = emin(e0.t1, e1.t1);
+
+         if(hi - lo > PVS_EPSILON)
+         {
+            const pvspoint_t a = { ox + dx * lo / len, oy + dy * lo / len };
+            const pvspoint_t b = { ox + dx * hi / len, oy + dy * hi / len };
+
+            // the side 1 cell is on the left of a -> b
+            portals.add({ a, b, R_pvsLineThrough(a, b), e0.cell, e1.cell });
+            portals.add({ b, a, R_pvsLineThrough(b, a), e1.cell, e0.cell });
+         }
+
+         if(e0.t1 < e1.t1)
+            ++i;
+         else
+            ++j;
+      }
+
+      start = end;
+   }
+}
+
+//
+// Lines separating a source portal from a pass portal: sight through both
+// lies on the positive side of each.
+//
+static int R_pvsSeparators(const pvsportal_t &source, const pvspoint_t &pass0,
+                           const pvspoint_t &pass1, pvsline_t seps[4])
+{
+   const pvspoint_t s[2] = { source.p0, source.p1 };
+   const pvspoint_t p[2] = { pass0, pass1 };
+   int count = 0;
+
+   for(int i = 0; i < 2; i++)
+   {
+      for(int j = 0; j < 2; j++)
+      {
+         if(fabs(s[i].x - p[j].x) + fabs(s[i].y - p[j].y) < PVS_EPSILON)
+            continue;
+
+         const pvsline_t line = R_pvsLineThrough(s[i], p[j]);
+         const double    ds   = R_pvsDist(line, s[i ^ 1]);
+         const double    dp   = R_pvsDist(line, p[j ^ 1]);
+
+         // only lines with the portals on opposite sides bound the view
+         if(fabs(dp) > PVS_EPSILON)
+         {
+            if(fabs(ds) > PVS_EPSILON && (ds > 0) == (dp > 0))
+               continue;
+            seps[count++] = dp > 0 ? line : R_pvsFlip(line);
+         }
+         else if(fabs(ds) > PVS_EPSILON)
+            seps[count++] = ds > 0 ? R_pvsFlip(line) : line;
+      }
+   }
+
+   return count;
+}
+
+//
+// Narrows [u0, u1] along a portal to where it is on the positive side of
+// line, give or take the slack.
+//
+static bool R_pvsClipWindow(const pvsportal_t &portal, const pvsline_t &line,
+                            double &u0, double &u1)
+{
+   const double d0 = R_pvsDist(line, portal.p0) + PVS_SLACK;
+   const double d1 = R_pvsDist(line, portal.p1) + PVS_SLACK;
+
+   if(d0 >= 0 && d1 >= 0)
+      return u0 <= u1;
+   if(d0 < 0 && d1 < 0)
+      return false;
+
+   const double cross = d0 / (d0 - d1);
+   if(d0 < 0)
+      u0 = emax(u0, cross);
+   else
+      u1 = emin(u1, cross);
+
+   return u0 <= u1;
+}
+
+static inline pvspoint_t R_pvsLerp(const pvsportal_t &portal, double u)
+{
+   return { portal.p0.x + (portal.p1.x - portal.p0.x) * u,
+            portal.p0.y + (portal.p1.y - portal.p0.y) * u };
+}
+
+//
+// Flows sight from one portal, marking every cell seen in row. Returns false
+// if the steps run out first.
+//
+static bool R_pvsFlow(const PODCollection<pvsportal_t> &portals, const int *cellportals,
+                      int sourcenum, pvsmemo_t *memo, std::vector<pvswork_t> &stack,
+                      byte *row, int64_t &steps)
+{
+   const pvsportal_t &source = portals[sourcenum];
+
+   stack.clear();
+   stack.push_back({ sourcenum, 0.0, 1.0 });
+   row[source.to >> 3] |= 1 << (source.to & 7);
+
+   while(!stack.empty())
+   {
+      const pvswork_t    work = stack.back();
+      stack.pop_back();
+      const pvsportal_t &pass = portals[work.portal];
+      const pvspoint_t   pass0 = R_pvsLerp(pass, work.u0);
+      const pvspoint_t   pass1 = R_pvsLerp(pass, work.u1);
+
+      pvsline_t seps[4];
+      const int numseps = work.portal == sourcenum ? 0 :
+         R_pvsSeparators(source, pass0, pass1, seps);
+
+      if(--steps < 0)
+         return false;
+
+      for(int t = cellportals[pass.to]; t < cellportals[pass.to + 1]; t++)
+      {
+         const pvsportal_t &target = portals[t];
+         double u0 = 0.0, u1 = 1.0;
+
+         // must lead on past the pass, which also drops the way back
+         if(emax(R_pvsDist(pass.line, target.p0), R_pvsDist(pass.line, target.p1)) <= PVS_EPSILON)
+            continue;
+         if(!R_pvsClipWindow(target, source.line, u0, u1))
+            continue;
+
+         bool visible = true;
+         for(int i = 0; i < numseps && visible; i++)
+            visible = R_pvsClipWindow(target, seps[i], u0, u1);
+         if(!visible)
+            continue;
+
+         row[target.to >> 3] |= 1 << (target.to & 7);
+
+         // Sight beyond a window only grows with the window, so one already
+         // looked through for this source that covers it has seen it all
+         pvsmemo_t &m = memo[t];
+         if(m.source == sourcenum)
+         {
+            if(u0 >= m.u0 && u1 <= m.u1)
+               continue;
+            m.u0 = emin(m.u0, u0);
+            m.u1 = emax(m.u1, u1);
+         }
+         else
+            m = { sourcenum, u0, u1 };
+
+         stack.push_back({ t, m.u0, m.u1 });
+      }
+   }
+
+   return true;
+}
+
+// Most threads the flow is split across
+static constexpr int PVS_MAXTHREADS = 8;
+
+// What the flow threads share. Each takes the next unfinished cell and owns
+// that cell's row.
+struct pvsflowjob_t
+{
+   const PODCollection<pvsportal_t> *portals;
+   const int                        *cellportals;
+   const byte                       *lostcells;
+   byte                             *rows;
+   int                               rowbytes;
+
+   std::atomic_int     nextcell;
+   std::atomic<int64_t> steps;   // taken by all threads together
+   std::atomic_bool    failed;
+};
+
+//
+// Flow thread body. The zone is not thread-safe, so scratch space comes
+// from the C++ heap. Each source's flow takes the same steps whichever
+// thread runs it, so whether the budget suffices never depends on
+// scheduling.
+//
+static void R_pvsFlowCells(pvsflowjob_t *job)
+{
+   const int numportals = int(job->portals->getLength());
+   std::vector<pvsmemo_t> memo(emax(numportals, 1), pvsmemo_t{ -1, 0.0, 0.0 });
+   std::vector<pvswork_t> stack;
+
+   int c;
+   while(!job->failed.load(std::memory_order_relaxed) &&
+         (c = job->nextcell.fetch_add(1, std::memory_order_relaxed)) < numsubsectors)
+   {
+      byte *row = job->rows + c * job->rowbytes;
+
+      if(job->lostcells[c])
+      {
+         memset(row, 0xff, job->rowbytes);
+         continue;
+      }
+
+      row[c >> 3] |= 1 << (c & 7);
+      for(int s = job->cellportals[c]; s < job->cellportals[c + 1]; s++)
+      {
+         const int64_t left = PVS_MAXSTEPS - job->steps.load(std::memory_order_relaxed);
+         int64_t budget = left;
+         if(left < 0 ||
+            !R_pvsFlow(*job->portals, job->cellportals, s, memo.data(), stack, row, budget) ||
+            job->steps.fetch_add(left - budget, std::memory_order_relaxed) + (left - budget) >
+            PVS_MAXSTEPS)
+         {
+            job->failed.store(true, std::memory_order_relaxed);
+            return;
+         }
+      }
+   }
+}
+
+//
+// Nodes in an order that puts children before their parents.
+//
+static void R_pvsOrderNodes(int bspnum, int &count)
+{
+   if(bspnum & NF_SUBSECTOR)
+      return;
+
+   R_pvsOrderNodes(nodes[bspnum].children[0], count);
+   R_pvsOrderNodes(nodes[bspnum].children[1], count);
+   pvsnodeorder[count++] = bspnum;
+}
+
+//
+// Works out which subsectors could be seen from each subsector of the
+// current level. Returns numsubsectors rows of rowbytes bytes, one bit per
+// subsector, allocated with tag; or nullptr, having said why under caller's
+// name, when the map is too big or too open to finish.
+//
+byte *R_BuildSubsectorVisibility(int tag, int &rowbytes, const char *caller)
+{
+   if(!numnodes || !numsubsectors)
+      return nullptr;
+
+   if(numsubsectors > PVS_MAXSUBSECTORS)
+   {
+      C_Printf(FC_ERROR "%s: %d subsectors is too many\n", caller, numsubsectors);
+      return nullptr;
+   }
+
+   // a level seen before may have its visibility saved already
+   rowbytes = (numsubsectors + 7) >> 3;
+   byte *rows = ecalloctag(byte *, numsubsectors, rowbytes, tag, nullptr);
+
+   switch(P_LoadLevelCache(PVS_CACHEKIND, rows, size_t(numsubsectors) * rowbytes))
+   {
+   case levelcache_e::loaded:
+      return rows;
+   case levelcache_e::empty:
+      C_Printf(FC_ERROR "%s: map too open to finish\n", caller);
+      efree(rows);
+      return nullptr;
+   default:
+      break;
+   }
+
+   // start from the whole map, with room to spare
+   double minx = M_FixedToDouble(vertexes[0].x), maxx = minx;
+   double miny = M_FixedToDouble(vertexes[0].y), maxy = miny;
+   for(int i = 1; i < numvertexes; i++)
+   {
+      minx = emin(minx, M_FixedToDouble(vertexes[i].x));
+      maxx = emax(maxx, M_FixedToDouble(vertexes[i].x));
+      miny = emin(miny, M_FixedToDouble(vertexes[i].y));
+      maxy = emax(maxy, M_FixedToDouble(vertexes[i].y));
+   }
+
+   pvspoly_t bounds;
+   bounds.add({ { minx - 64.0, miny - 64.0 }, PVS_SOLID });
+   bounds.add({ { maxx + 64.0, miny - 64.0 }, PVS_SOLID });
+   bounds.add({ { maxx + 64.0, maxy + 64.0 }, PVS_SOLID });
+   bounds.add({ { minx - 64.0, maxy + 64.0 }, PVS_SOLID });
+
+   pvspoly_t *cells = new pvspoly_t[numsubsectors];
+   R_pvsBuildCells(numnodes - 1, bounds, cells);
+
+   PODCollection<pvsportal_t> portals;
+   R_pvsBuildPortals(cells, portals);
+
+   // a subsector that lost its whole cell to rounding can't be reasoned about
+   byte *lostcells = ecalloc(byte *, numsubsectors, sizeof(byte));
+   for(int c = 0; c < numsubsectors; c++)
+      lostcells[c] = !cells[c].getLength();
+   delete [] cells;
+
+   // group the portals by the cell they lead out of
+   const int   numportals = int(portals.getLength());
+   int        *cellportals = ecalloc(int *, numsubsectors + 1, sizeof(int));
+   pvsportal_t *sorted     = emalloc(pvsportal_t *, emax(numportals, 1) * sizeof(pvsportal_t));
+
+   for(const pvsportal_t &portal : portals)
+      cellportals[portal.from + 1]++;
+   for(int c = 0; c < numsubsectors; c++)
+      cellportals[c + 1] += cellportals[c];
+   {
+      int *cursor = emalloc(int *, (numsubsectors + 1) * sizeof(int));
+      memcpy(cursor, cellportals, (numsubsectors + 1) * sizeof(int));
+      for(const pvsportal_t &portal : portals)
+         sorted[cursor[portal.from]++] = portal;
+      efree(cursor);
+   }
+   portals.makeEmpty();
+   for(int i = 0; i < numportals; i++)
+      portals.add(sorted[i]);
+   efree(sorted);
+
+   pvsflowjob_t job;
+   job.portals     = &portals;
+   job.cellportals = cellportals;
+   job.lostcells   = lostcells;
+   job.rows        = rows;
+   job.rowbytes    = rowbytes;
+   job.nextcell    = 0;
+   job.steps       = 0;
+   job.failed      = false;
+
+   const int numthreads = eclamp(D_NumJobWorkers() + 1, 1, PVS_MAXTHREADS);
+   D_RunParallel(numthreads, [&job] (int) { R_pvsFlowCells(&job); });
+
+   efree(cellportals);
+   efree(lostcells);
+
+   if(job.failed)
+   {
+      C_Printf(FC_ERROR "%s: map too open to finish\n", caller);
+      P_SaveLevelCache(PVS_CACHEKIND, nullptr, 0);
+      efree(rows);
+      return nullptr;
+   }
+
+   P_SaveLevelCache(PVS_CACHEKIND, rows, size_t(numsubsectors) * rowbytes);
+   return rows;
+}
+
+//
+// Builds the sets for the current level.
+//
+static void R_buildPVS()
+{
+   pvsrows = R_BuildSubsectorVisibility(PU_LEVEL, pvsrowbytes, "R_InitPVS");
+   if(!pvsrows)
+   {
+      C_Printf(FC_ERROR "R_InitPVS: not culling\n");
+      return;
+   }
+
+   pvsnodevis   = ecalloctag(byte *, numnodes, sizeof(byte), PU_LEVEL, nullptr);
+   pvsnodeorder = emalloctag(int *, numnodes * sizeof(int), PU_LEVEL, nullptr);
+
+   int count = 0;
+   R_pvsOrderNodes(numnodes - 1, count);
+   pvsviewsub = -1;
+}
+
+//
+// Drops all reference to the sets, without freeing them.
+//
+static void R_forgetPVS()
+{
+   pvsrows      = nullptr;
+   pvsnodevis   = nullptr;
+   pvsnodeorder = nullptr;
+   pvsviewsub   = -1;
+   r_pvsrow     = nullptr;
+   r_pvsnodes   = nullptr;
+}
+
+//
+// Frees the sets of the current level.
+//
+static void R_freePVS()
+{
+   if(pvsrows)
+      efree(pvsrows);
+   if(pvsnodevis)
+      efree(pvsnodevis);
+   if(pvsnodeorder)
+      efree(pvsnodeorder);
+
+   R_forgetPVS();
+}
+
+//
+// Called when a level has been set up. The last level's sets went with its
+// PU_LEVEL memory.
+//
+void R_InitPVS()
+{
+   R_forgetPVS();
+
+   if(r_pvs)
+      R_buildPVS();
+}
+
+//
+// Selects the set for the main view, called before any context renders.
+//
+void R_SetPVSViewpoint(const subsector_t *ss)
+{
+   if(!pvsrows || !pvsnodevis)
+   {
+      r_pvsrow = r_pvsnodes = nullptr;
+      return;
+   }
+
+   const int num = int(ss - subsectors);
+
+   r_pvsrow   = pvsrows + num * pvsrowbytes;
+   r_pvsnodes = pvsnodevis;
+
+   if(num != pvsviewsub)
+   {
+      for(int i = 0; i < numnodes; i++)
+      {
+         const node_t &node = nodes[pvsnodeorder[i]];
+         pvsnodevis[pvsnodeorder[i]] =
+            R_PVSChildVisible(node.children[0]) || R_PVSChildVisible(node.children[1]);
+      }
+      pvsviewsub = num;
+   }
+}
+
+VARIABLE_TOGGLE(r_pvs, nullptr, onoff);
+CONSOLE_VARIABLE(r_pvs, r_pvs, 0)
+{
+   if(gamestate != GS_LEVEL)
+      return;
+
+   if(!r_pvs)
+      R_freePVS();
+   else if(!pvsrows)
+      R_buildPVS();
+}
+
+// EOF
+
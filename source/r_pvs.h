@@ -0,0 +1,62 @@
+//
+// The Eternity Engine
+// Copyright(C) 2026 James Haley, Max Waine, et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+// Additional terms and conditions compatible with the GPLv3 apply. See the
+// file COPYING-EE for details.
+//
+// Purpose: Potentially visible sets for BSP traversal.
+//  Built when a level loads, each subsector gets a bit for every subsector
+//  that any point in it could possibly see in 2D, ignoring sector heights and
+//  treating every two-sided line as open. The walk from the main view skips
+//  subtrees holding no such subsector; portal views are never culled.
+//
+
+#ifndef R_PVS_H__
+#define R_PVS_H__
+
+#include "doomtype.h"
+#include "doomdata.h"
+
+struct subsector_t;
+
+extern bool r_pvs;
+
+// Visibility of the view's subsector, or nullptr when nothing is culled
+extern const byte *r_pvsrow;
+extern const byte *r_pvsnodes;
+
+void R_InitPVS();
+byte *R_BuildSubsectorVisibility(int tag, int &rowbytes, const char *caller);
+void R_SetPVSViewpoint(const subsector_t *ss);
+
+//
+// True if the BSP child could hold anything visible from the view.
+//
+inline bool R_PVSChildVisible(int child)
+{
+   if(child & NF_SUBSECTOR)
+   {
+      const int num = child == -1 ? 0 : child & ~NF_SUBSECTOR;
+      return (r_pvsrow[num >> 3] & (1 << (num & 7))) != 0;
+   }
+   return r_pvsnodes[child] != 0;
+}
+
+#endif
+
+// EOF
+
@@ -0,0 +1,362 @@
+//
+// The Eternity Engine
+// Copyright(C) 2026 James Haley, Max Waine, et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+// Additional terms and conditions compatible with the GPLv3 apply. See the
+// file COPYING-EE for details.
+//
+// Purpose: Scripted camera render benchmark.
+//  A path file has one viewpoint per line, "x y z angle pitch" in map units
+//  and degrees; blank lines and lines starting with # are skipped. The
+//  camera follows a Catmull-Rom spline through the viewpoints, so it passes
+//  through each one, and draws -renderbenchframes frames (32 by default)
+//  on the way from each viewpoint to the next. Those frames are charged to
+//  the viewpoint they leave from; the last viewpoint's are drawn standing
+//  still. Nothing in the level moves, so a path gives the same frames every
+//  run.
+//
+//  Frame times include the blit. Stage times come from the render profiler
+//  and are summed over threads. -renderbenchcsv writes one row per viewpoint.
+//
+
+#include <algorithm>
+#include <chrono>
+
+#include "z_zone.h"
+#include "i_system.h"
+
+#include "c_io.h"
+#include "c_runcmd.h"
+#include "d_player.h"
+#include "doomstat.h"
+#include "g_game.h"
+#include "i_video.h"
+#include "m_argv.h"
+#include "m_collection.h"
+#include "m_compare.h"
+#include "m_qstr.h"
+#include "p_chase.h"
+#include "p_mobj.h"
+#include "r_context.h"
+#include "r_main.h"
+#include "r_profile.h"
+#include "r_renderbench.h"
+#include "r_state.h"
+#include "v_misc.h"
+
+using benchclock_t = std::chrono::steady_clock;
+using benchms_t    = std::chrono::duration<double, std::milli>;
+
+// Untimed frames drawn first, so the first viewpoint doesn't pay for
+// texture loading
+static constexpr int WARMUPFRAMES = 8;
+
+//
+// One viewpoint of the path; angle is unwrapped, so it turns the short way
+// to the next one
+//
+struct benchpoint_t
+{
+   double x, y, z;
+   double angle, pitch;
+};
+
+//
+// What the frames leaving one viewpoint took
+//
+struct benchresult_t
+{
+   double avg, p95, max;              // ms
+   double stages[RPROF_NUMSTAGES];    // average us
+};
+
+bool renderbench;
+
+static PODCollection<benchpoint_t> benchpath;
+static qstring                     benchpathname;
+
+//
+// Reads the path at startup. Errors here are fatal, since there is nothing
+// to run without a path.
+//
+void R_RenderBenchInit(const char *pathname)
+{
+   FILE *f;
+   char  line[256];
+   int   linenum = 0;
+
+   if(!(f = fopen(pathname, "r")))
+      I_Error("R_RenderBenchInit: couldn't open %s\n", pathname);
+
+   while(fgets(line, sizeof(line), f))
+   {
+      benchpoint_t point;
+      const char  *c = line;
+
+      ++linenum;
+      while(*c == ' ' || *c == '\t')
+         ++c;
+      if(*c == '#' || *c == '\n' || *c == '\r' || !*c)
+         continue;
+
+      if(sscanf(c, "%lf %lf %lf %lf %lf", &point.x, &point.y, &point.z,
+                &point.angle, &point.pitch) != 5)
+      {
+         fclose(f);
+         I_Error("R_RenderBenchInit: bad viewpoint on line %d of %s\n", linenum, pathname);
+      }
+
+      if(!benchpath.isEmpty())
+      {
+         const double prev = benchpath.back().angle;
+         while(point.angle - prev > 180.0)
+            point.angle -= 360.0;
+         while(point.angle - prev < -180.0)
+            point.angle += 360.0;
+      }
+      benchpath.add(point);
+   }
+   fclose(f);
+
+   if(benchpath.isEmpty())
+      I_Error("R_RenderBenchInit: no viewpoints in %s\n", pathname);
+
+   renderbench   = true;
+   benchpathname = pathname;
+}
+
+static double R_catmullRom(double p0, double p1, double p2, double p3, double t)
+{
+   return 0.5 * (2.0 * p1 + (p2 - p0) * t +
+                 (2.0 * p0 - 5.0 * p1 + 4.0 * p2 - p3) * t * t +
+                 (3.0 * p1 - p0 - 3.0 * p2 + p3) * t * t * t);
+}
+
+//
+// Puts the camera at position t along the path, where viewpoint i is at
+// t = i.
+//
+static void R_benchPlaceCamera(camera_t &camera, double t)
+{
+   const int last = int(benchpath.getLength()) - 1;
+   const int i    = eclamp(int(t), 0, last);
+   const double f = t - i;
+
+   const benchpoint_t &p0 = benchpath[emax(i - 1, 0)];
+   const benchpoint_t &p1 = benchpath[i];
+   const benchpoint_t &p2 = benchpath[emin(i + 1, last)];
+   const benchpoint_t &p3 = benchpath[emin(i + 2, last)];
+
+#define SPLINE(field) R_catmullRom(p0.field, p1.field, p2.field, p3.field, f)
+   const double angle = SPLINE(angle) / 360.0;
+
+   camera.x     = M_DoubleToFixed(SPLINE(x));
+   camera.y     = M_DoubleToFixed(SPLINE(y));
+   camera.z     = M_DoubleToFixed(SPLINE(z));
+   camera.angle = angle_t(int64_t((angle - floor(angle)) * 4294967296.0));
+   camera.pitch = fixed_t(SPLINE(pitch) * ANGLE_1);
+#undef SPLINE
+
+   camera.groupid = R_PointInSubsector(camera.x, camera.y)->sector->groupid;
+   camera.flying  = true;
+   camera.backupPosition(); // nothing to interpolate from
+}
+
+//
+// Draws and blits one frame from the camera. Returns its time in ms and
+// fills in its stage times.
+//
+static double R_benchFrame(camera_t &camera, float (&stages)[RPROF_NUMSTAGES])
+{
+   I_StartFrame();
+
+   const benchclock_t::time_point start = benchclock_t::now();
+
+   R_RenderPlayerView(&players[displayplayer], &camera);
+   {
+      RenderProfileScope profile(RPROF_BLIT);
+      I_FinishUpdate();
+   }
+
+   const double ms = benchms_t(benchclock_t::now() - start).count();
+
+   R_ProfileEndFrame();
+   R_ProfileLastFrame(stages);
+   Z_FreeAlloca();
+
+   return ms;
+}
+
+//
+// Writes one row per viewpoint to the file named by -renderbenchcsv.
+//
+static void R_benchWriteCSV(const PODCollection<benchresult_t> &results, int frames)
+{
+   FILE *f;
+   int   p;
+
+   if(!(p = M_CheckParm("-renderbenchcsv")) || ++p >= myargc)
+      return;
+
+   if(!(f = fopen(myargv[p], "w")))
+   {
+      printf("Couldn't open %s for render benchmark output\n", myargv[p]);
+      return;
+   }
+
+   fputs("viewpoint,x,y,z,angle,pitch,frames,contexts,avg_ms,p95_ms,max_ms", f);
+   for(int stage = 0; stage < RPROF_NUMSTAGES; stage++)
+      fprintf(f, ",%s_us", R_ProfileStageName(stage));
+   fputc('\n', f);
+
+   for(size_t i = 0; i < results.getLength(); i++)
+   {
+      const benchpoint_t  &point  = benchpath[i];
+      const benchresult_t &result = results[i];
+
+      fprintf(f, "%d,%.2f,%.2f,%.2f,%.2f,%.2f,%d,%d,%.3f,%.3f,%.3f", int(i),
+              point.x, point.y, point.z, point.angle, point.pitch, frames,
+              r_numcontexts, result.avg, result.p95, result.max);
+      for(const double us : result.stages)
+         fprintf(f, ",%.1f", us);
+      fputc('\n', f);
+   }
+
+   fclose(f);
+}
+
+//
+// Runs the whole benchmark once the level is up, reports and quits.
+//
+void R_RenderBenchRun()
+{
+   PODCollection<benchresult_t> results;
+   PODCollection<double>        times;
+   camera_t camera = {};
+   float    stages[RPROF_NUMSTAGES];
+   int      frames = 32;
+   int      p;
+
+   if((p = M_CheckParm("-renderbenchframes")) && ++p < myargc)
+      frames = emax(1, atoi(myargv[p]));
+
+   R_ProfileStart();
+
+   R_benchPlaceCamera(camera, 0.0);
+   for(int i = 0; i < WARMUPFRAMES; i++)
+      R_benchFrame(camera, stages);
+
+   const benchclock_t::time_point start = benchclock_t::now();
+
+   for(size_t i = 0; i < benchpath.getLength(); i++)
+   {
+      benchresult_t result = {};
+      times.makeEmpty();
+
+      for(int frame = 0; frame < frames; frame++)
+      {
+         R_benchPlaceCamera(camera, double(i) + double(frame) / frames);
+         times.add(R_benchFrame(camera, stages));
+
+         for(int stage = 0; stage < RPROF_NUMSTAGES; stage++)
+            result.stages[stage] += stages[stage] / frames;
+      }
+
+      std::sort(times.begin(), times.end());
+      for(const double ms : times)
+         result.avg += ms / frames;
+      result.p95 = times[(frames * 95 + 99) / 100 - 1];
+      result.max = times.back();
+      results.add(result);
+   }
+
+   const double seconds = benchms_t(benchclock_t::now() - start).count() / 1000.0;
+   const int    total   = frames * int(benchpath.getLength());
+
+   printf("Render benchmark: %s on %s, %d frames per viewpoint, %d context%s\n",
+          benchpathname.constPtr(), gamemapname, frames, r_numcontexts,
+          r_numcontexts == 1 ? "" : "s");
+   printf("view     avg ms   p95 ms   max ms");
+   for(int stage = 0; stage < RPROF_NUMSTAGES; stage++)
+      printf(" %8.8s", R_ProfileStageName(stage));
+   printf("\n");
+
+   for(size_t i = 0; i < results.getLength(); i++)
+   {
+      const benchresult_t &result = results[i];
+
+      printf("%4d %9.3f %8.3f %8.3f", int(i), result.avg, result.p95, result.max);
+      for(const double us : result.stages)
+         printf(" %8.0f", us);
+      printf("\n");
+   }
+
+   R_benchWriteCSV(results, frames);
+
+   I_ExitWithMessage("Rendered %d frames in %.3f seconds = %.1f frames per second\n",
+                     total, seconds, seconds > 0 ? total / seconds : 0.0);
+}
+
+//
+// r_benchpoint <file>
+// Adds the current view to a render benchmark path file.
+//
+CONSOLE_COMMAND(r_benchpoint, cf_level)
+{
+   fixed_t x, y, z, pitch;
+   angle_t angle;
+   FILE   *f;
+
+   if(Console.argc < 1)
+   {
+      C_Printf("usage: r_benchpoint pathfile\n");
+      return;
+   }
+
+   if(walkcam_active)
+   {
+      x     = walkcamera.x;
+      y     = walkcamera.y;
+      z     = walkcamera.z;
+      angle = walkcamera.angle;
+      pitch = walkcamera.pitch;
+   }
+   else
+   {
+      const player_t &player = players[displayplayer];
+
+      x     = player.mo->x;
+      y     = player.mo->y;
+      z     = player.viewz;
+      angle = player.mo->angle;
+      pitch = player.pitch;
+   }
+
+   if(!(f = fopen(Console.argv[0]->constPtr(), "a")))
+   {
+      C_Printf(FC_ERROR "Couldn't open %s\n", Console.argv[0]->constPtr());
+      return;
+   }
+
+   fprintf(f, "%.2f %.2f %.2f %.2f %.2f\n", M_FixedToDouble(x), M_FixedToDouble(y),
+           M_FixedToDouble(z), angle * (360.0 / 4294967296.0), double(pitch) / ANGLE_1);
+   fclose(f);
+
+   C_Printf("Added viewpoint to %s\n", Console.argv[0]->constPtr());
+}
+
+// EOF
+
@@ -0,0 +1,39 @@
+//
+// The Eternity Engine
+// Copyright(C) 2026 James Haley, Max Waine, et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+// Additional terms and conditions compatible with the GPLv3 apply. See the
+// file COPYING-EE for details.
+//
+// Purpose: Scripted camera render benchmark.
+//  -renderbench <map> <pathfile> loads the map, stops running tics once it
+//  is up, and flies a camera through the viewpoints in the path file,
+//  timing every frame and the render stages within it. Viewpoints are
+//  added to a path file with the r_benchpoint console command.
+//
+
+#ifndef R_RENDERBENCH_H__
+#define R_RENDERBENCH_H__
+
+extern bool renderbench;
+
+void R_RenderBenchInit(const char *pathname);
+void R_RenderBenchRun();
+
+#endif
+
+// EOF
+
@@ -27,6 +27,8 @@
 //
 //----------------------------------------------------------------------------
 
+#include <mutex>
+
 #include "z_zone.h"
 #include "doomdef.h"
 #include "doomstat.h"
@@ -47,7 +49,6 @@
 // 1 cycle per 32 units (2 in 64)
 #define SWIRLFACTOR2 (8192/32)
 
-static byte *normalflat;
 int r_swirl;       // hack
 
 #if 0
@@ -68,100 +69,162 @@ static void R_DrawLines(void)
 #define SPEED 40
 
 
+// The waves move 200, 160 and 120 fine angles a tic, and all three are back
+// where they started every 1024 tics, so that is all the frames there are.
+#define SWIRLPERIOD 1024
+
+// Bytes of frames kept for reuse, across all flats
+#define SWIRLCACHEBYTES (32 * 1024 * 1024)
+
 //
-// R_DistortedFlat
+// Distorted frames of one flat, made as each phase is first drawn. Once the
+// kept frames reach SWIRLCACHEBYTES, a flat without its phase is made again
+// into a single buffer each tic, as it was before.
+//
+struct swirlflat_t
+{
+   byte *frames[SWIRLPERIOD]; // flat followed by its mask, by phase; or null
+   byte *current;             // frame made when over the budget
+   int   currentphase;
+};
+
+// Render contexts draw flats at the same time, and frames are made on the
+// spot, so they come from the system heap and the lookup is locked.
+static std::mutex    swirllock;
+static swirlflat_t **swirlflats;  // by texture number
+static int           numswirlflats;
+static size_t        swirlbytes;  // total of the kept frames
+
 //
-// Generates a distorted flat from a normal one using a two-dimensional
-// sine wave pattern.
+// Warps a flat and its mask, if it has one, into dest using a
+// two-dimensional sine wave pattern.
 //
-byte *R_DistortedFlat(int texnum, bool usegametic)
+static void R_distortFlat(const texture_t *tex, int leveltic, byte *dest)
 {
-   static int lasttex = -1;
-   static int swirltic = -1;
-   static int *offset;
-   static int offsetSize;
-   static byte *distortedflat;
-   static int lastsize;
-
-   int i;
-   int reftime = usegametic ? gametic : leveltime;
-   int leveltic = reftime;
-   texture_t *tex = R_CacheTexture(texnum);
+   const byte *normalflat = tex->bufferdata;
    const byte *flatmask = tex->flags & TF_MASKED ?
-         tex->bufferdata + tex->width * tex->height : nullptr; // also change the trailing mask
+         tex->bufferdata + tex->width * tex->height : nullptr;
 
    // NOTE: these are transposed because of the swirling formula
-   int16_t h = tex->width;
-   int16_t w = tex->height;
-   int cursize = w*h;
+   const int h = tex->width;
+   const int w = tex->height;
+   const int cursize = w * h;
 
+   byte *distortedmask = dest + cursize;
+   if(flatmask)
+      memset(distortedmask, 0, (cursize + 7) / 8);
 
-   if(cursize * 2 > offsetSize)
+   for(int y = 0; y < h; ++y)
    {
-      offsetSize = cursize * 4;
-      offset = erealloc(int *, offset, offsetSize * sizeof(*offset));
-      distortedflat = erealloc(byte *, distortedflat, offsetSize * sizeof(*distortedflat));
+      for(int x = 0; x < w; ++x)
+      {
+         int x1, y1;
+         int sinvalue, sinvalue2;
+
+         sinvalue = (y * SWIRLFACTOR + leveltic*SPEED*5 + 900) & 8191;
+         sinvalue2 = (x * SWIRLFACTOR2 + leveltic*SPEED*4 + 300) & 8191;
+         x1 = x + 128
+              + ((finesine[sinvalue]*AMP) >> FRACBITS)
+              + ((finesine[sinvalue2]*AMP2) >> FRACBITS);
+
+         sinvalue = (x * SWIRLFACTOR + leveltic*SPEED*3 + 700) & 8191;
+         sinvalue2 = (y * SWIRLFACTOR2 + leveltic*SPEED*4 + 1200) & 8191;
+         y1 = y + 128
+              + ((finesine[sinvalue]*AMP) >> FRACBITS)
+              + ((finesine[sinvalue2]*AMP2) >> FRACBITS);
+
+         x1 %= w;
+         y1 %= h;
+
+         const int i      = (y*w) + x;
+         const int offset = (y1*w) + x1;
+
+         dest[i] = normalflat[offset];
+         if(flatmask && flatmask[offset >> 3] & 1 << (offset & 7))
+            distortedmask[i >> 3] |= 1 << (i & 7);
+      }
    }
-   // Already swirled this one?
-   if(reftime == swirltic && lasttex == texnum)
-      return distortedflat;
-      
-   lasttex = texnum;
-
-   // built this tic?
-   if(reftime != swirltic || cursize != lastsize)
+}
+
+//
+// R_DistortedFlat
+//
+// Returns a flat distorted for the current tic, followed by its mask for
+// masked flats. The frame stays valid until the tic changes.
+//
+byte *R_DistortedFlat(int texnum, bool usegametic)
+{
+   const int reftime = usegametic ? gametic : leveltime;
+   const int phase   = reftime & (SWIRLPERIOD - 1);
+
+   std::lock_guard<std::mutex> lock(swirllock);
+
+   texture_t *tex = R_CacheTexture(texnum);
+   const int cursize = tex->width * tex->height;
+   const size_t framesize = cursize + (tex->flags & TF_MASKED ? (cursize + 7) / 8 : 0);
+
+   if(!swirlflats)
    {
-      int x, y;
+      numswirlflats = texturecount;
+      swirlflats = static_cast<swirlflat_t **>(Z_SysCalloc(numswirlflats, sizeof(*swirlflats)));
+   }
 
-      if(offset)  // just to silence the static analyzer
-      {
-         for(x = 0; x < w; ++x)
-         {
-            for(y = 0; y < h; ++y)
-            {
-               int x1, y1;
-               int sinvalue, sinvalue2;
-
-               sinvalue = (y * SWIRLFACTOR + leveltic*SPEED*5 + 900) & 8191;
-               sinvalue2 = (x * SWIRLFACTOR2 + leveltic*SPEED*4 + 300) & 8191;
-               x1 = x + 128
-                    + ((finesine[sinvalue]*AMP) >> FRACBITS)
-                    + ((finesine[sinvalue2]*AMP2) >> FRACBITS);
-
-               sinvalue = (x * SWIRLFACTOR + leveltic*SPEED*3 + 700) & 8191;
-               sinvalue2 = (y * SWIRLFACTOR2 + leveltic*SPEED*4 + 1200) & 8191;
-               y1 = y + 128
-                    + ((finesine[sinvalue]*AMP) >> FRACBITS)
-                    + ((finesine[sinvalue2]*AMP2) >> FRACBITS);
-
-               x1 %= w;
-               y1 %= h;
-
-               offset[(y*w) + x] = (y1*w) + x1;
-            }
-         }
-      }
-      
-      swirltic = reftime;
-      lastsize = cursize;
+   swirlflat_t *&flat = swirlflats[texnum];
+   if(!flat)
+   {
+      flat = static_cast<swirlflat_t *>(Z_SysCalloc(1, sizeof(swirlflat_t)));
+      flat->currentphase = -1;
    }
-   
-   normalflat = tex->bufferdata;
-   
-   byte *distortedmask = distortedflat + cursize;
-   for(i = 0; i < cursize; ++i)
+
+   // Already swirled this phase?
+   if(flat->frames[phase])
+      return flat->frames[phase];
+   if(flat->currentphase == phase)
+      return flat->current;
+
+   if(swirlbytes + framesize <= SWIRLCACHEBYTES)
    {
-      distortedflat[i] = normalflat[offset[i]];
-      if(flatmask)
-      {
-         byte v = !!(flatmask[offset[i] >> 3] & 1 << (offset[i] & 7));
+      byte *frame = static_cast<byte *>(Z_SysMalloc(framesize));
 
-         // https://stackoverflow.com/a/47990
-         distortedmask[i >> 3] ^= (-v ^ distortedmask[i >> 3]) & 1 << (i & 7);
-      }
+      R_distortFlat(tex, phase, frame);
+      flat->frames[phase] = frame;
+      swirlbytes += framesize;
+      return frame;
    }
-   
-   return distortedflat;
+
+   if(!flat->current)
+      flat->current = static_cast<byte *>(Z_SysMalloc(framesize));
+
+   R_distortFlat(tex, phase, flat->current);
+   flat->currentphase = phase;
+   return flat->current;
+}
+
+//
+// Frees every distorted frame. Called when the textures are freed, since
+// the frames are kept by texture number.
+//
+void R_FreeDistortedFlats()
+{
+   std::lock_guard<std::mutex> lock(swirllock);
+
+   for(int i = 0; i < numswirlflats; i++)
+   {
+      swirlflat_t *flat = swirlflats[i];
+
+      if(!flat)
+         continue;
+
+      for(byte *frame : flat->frames)
+         Z_SysFree(frame);
+      Z_SysFree(flat->current);
+      Z_SysFree(flat);
+   }
+
+   Z_SysFree(swirlflats);
+   swirlflats    = nullptr;
+   numswirlflats = 0;
+   swirlbytes    = 0;
 }
 
 // EOF
@@ -28,6 +28,7 @@ enum
 };
 
 byte *R_DistortedFlat(int flatnum, bool usegametic = false);
+void R_FreeDistortedFlats();
 extern int r_swirl;
 
 #endif
@@ -40,11 +40,48 @@
 #include "r_main.h"
 #include "r_plane.h"
 #include "r_portal.h"
+#include "r_profile.h"
 #include "r_segs.h"
 #include "r_state.h"
 #include "r_things.h"
 #include "w_wad.h"
 
+//
+// Sets the colormap for a wall column from its distance and returns the last
+// column, up to x2, that shares it. The light index is linear in the column,
+// so it changes only a few times along a wall however long it is, and the
+// loops need only look it up again at the end of each run.
+//
+static int R_wallLightRun(lighttable_t *const *walllights, float dist, float diststep,
+                          int x, int x2, const lighttable_t *&colormap)
+{
+   // SoM: it took me about 5 solid minutes of looking at the old doom code
+   // and running test levels through it to do the math and get 2560 as the
+   // light distance factor.
+   int index = (int)(dist * 2560.0f);
+
+   if(index >= MAXLIGHTSCALE)
+      index = MAXLIGHTSCALE - 1;
+
+   colormap = walllights[index];
+
+   // columns from x until dist reaches the next index
+   float steps;
+   if(diststep > 0.0f && index < MAXLIGHTSCALE - 1)
+      steps = ((index + 1) / 2560.0f - dist) / diststep;
+   else if(diststep < 0.0f && index > 0)
+      steps = (index / 2560.0f - dist) / diststep;
+   else
+      return x2;
+
+   if(steps >= float(x2 - x))
+      return x2;
+
+   // rising, the index changes on reaching the edge; falling, on passing it
+   const int run = diststep > 0.0f ? int(ceilf(steps)) - 1 : int(steps);
+   return x + emax(run, 0);
+}
+
 //
 // R_RenderMaskedSegRange
 //
@@ -61,6 +98,7 @@ void R_RenderMaskedSegRange(cmapcontext_t &cmapcontext,
    line_t  *linedef;
    lighttable_t **wlight;
    float   *maskedtexturecol;
+   byte    *tranmap = nullptr;
 
    cb_column_t column  = {};
    cb_seg_t    segclip = {};
@@ -84,6 +122,7 @@ void R_RenderMaskedSegRange(cmapcontext_t &cmapcontext,
             tranmap = (byte *)(wGlobalDir.cacheLumpNum(linedef->tranlump-1, PU_STATIC));
          else
             tranmap = main_tranmap;
+         column.tranmap = tranmap;
       }
       else // haleyjd 11/11/10: flex/additive translucency for linedefs
       {
@@ -160,21 +199,16 @@ void R_RenderMaskedSegRange(cmapcontext_t &cmapcontext,
    scalestep = diststep * view.yfoc;
    texmidf   = M_FixedToFloat(column.texmid);
 
+   int lightend = x1 - 1; // last column of the current colormap
+
    // draw the columns
    for(column.x = x1; column.x <= x2; ++column.x, dist += diststep, scale += scalestep)
    {
       if(maskedtexturecol[column.x] != FLT_MAX)
       {
-         if(!ds->fixedcolormap)
-         {                             // killough 11/98:
-            // SoM: ANYRES
-            int index = (int)(dist * 2560.0f);
-            
-            if(index >=  MAXLIGHTSCALE )
-               index = MAXLIGHTSCALE - 1;
-            
-            column.colormap = wlight[index];
-         }
+         // killough 11/98, SoM: ANYRES
+         if(!ds->fixedcolormap && column.x > lightend)
+            lightend = R_wallLightRun(wlight, dist, diststep, column.x, x2, column.colormap);
 
 
          const cb_maskedcolumn_t maskedcolumn = { view.ycenter - (texmidf * scale), scale };
@@ -207,6 +241,21 @@ void R_RenderMaskedSegRange(cmapcontext_t &cmapcontext,
 
 
 
+//
+// Points column at a column of a wall texture, from a mip level when the
+// texels are far enough apart, with its coordinates scaled to match.
+//
+static void R_setWallColumn(cb_column_t &column, int tex, int texx, fixed_t texmid,
+                            int texheight, fixed_t step)
+{
+   int level;
+
+   column.source    = R_GetMipColumn(tex, texx, step, level);
+   column.texmid    = texmid / (1 << level);
+   column.step      = step >> level;
+   column.texheight = texheight >> level;
+}
+
 //
 // Draws zero, one, or two textures (and possibly a masked texture) for walls.
 // Can draw or mark the starting pixel of floor and ceiling textures.
@@ -226,6 +275,7 @@ static void R_renderSegLoop(cmapcontext_t &cmapcontext, planecontext_t &planecon
    int i;
    float texx;
    float basescale;
+   fixed_t texstep;
 
    cb_column_t column = {};
 
@@ -258,6 +308,8 @@ static void R_renderSegLoop(cmapcontext_t &cmapcontext, planecontext_t &planecon
    if(cmapcontext.fixedcolormap)
       column.colormap = cmapcontext.fixedcolormap;
 
+   int lightend = segclip.x1 - 1; // last column of the current colormap
+
    for(i = segclip.x1; i <= segclip.x2; i++)
    {
       cliptop = (int)ceilingclip[i];
@@ -348,11 +400,9 @@ static void R_renderSegLoop(cmapcontext_t &cmapcontext, planecontext_t &planecon
       
       if(segclip.segtextured)
       {
-         int index;
-
          basescale = 1.0f / (segclip.dist * view.yfoc);
 
-         column.step = M_FloatToFixed(basescale); // SCALE_TODO: Y scale-factor here
+         texstep = M_FloatToFixed(basescale); // SCALE_TODO: Y scale-factor here
          column.x = i;
 
          texx = segclip.len * basescale + segclip.toffsetx; // SCALE_TODO: X scale-factor here
@@ -362,17 +412,10 @@ static void R_renderSegLoop(cmapcontext_t &cmapcontext, planecontext_t &planecon
 
          // calculate lighting
          // SoM: ANYRES
-         if(!cmapcontext.fixedcolormap)
+         if(!cmapcontext.fixedcolormap && i > lightend)
          {
-            // SoM: it took me about 5 solid minutes of looking at the old doom code
-            // and running test levels through it to do the math and get 2560 as the
-            // light distance factor.
-            index = (int)(segclip.dist * 2560.0f);
-         
-            if(index >=  MAXLIGHTSCALE)
-               index = MAXLIGHTSCALE - 1;
-
-            column.colormap = segclip.walllights[index];
+            lightend = R_wallLightRun(segclip.walllights, segclip.dist, segclip.diststep,
+                                      i, segclip.x2, column.colormap);
          }
 
          if(!segclip.twosided)
@@ -389,9 +432,8 @@ static void R_renderSegLoop(cmapcontext_t &cmapcontext, planecontext_t &planecon
                      column.y2 = (int)(segclip.high > floorclip[i] ? floorclip[i] : segclip.high);
                      if(column.y2 >= column.y1)
                      {
-                        column.texmid = segclip.toptexmid;
-                        column.source = R_GetRawColumn(segclip.toptex, (int)texx);
-                        column.texheight = segclip.toptexh;
+                        R_setWallColumn(column, segclip.toptex, (int)texx, segclip.toptexmid,
+                                        segclip.toptexh, texstep);
                         colfunc(column);
                         ceilingclip[i] = (float)(column.y2 + 1);
                      }
@@ -408,9 +450,8 @@ static void R_renderSegLoop(cmapcontext_t &cmapcontext, planecontext_t &planecon
                      column.y2 = b;
                      if(column.y2 >= column.y1)
                      {
-                        column.texmid = segclip.bottomtexmid;
-                        column.source = R_GetRawColumn(segclip.bottomtex, (int)texx);
-                        column.texheight = segclip.bottomtexh;
+                        R_setWallColumn(column, segclip.bottomtex, (int)texx, segclip.bottomtexmid,
+                                        segclip.bottomtexh, texstep);
                         colfunc(column);
                         floorclip[i] = (float)(column.y1 - 1);
                      }
@@ -440,10 +481,8 @@ static void R_renderSegLoop(cmapcontext_t &cmapcontext, planecontext_t &planecon
                column.y1 = t;
                column.y2 = b;
 
-               column.texmid = segclip.midtexmid;
-
-               column.source = R_GetRawColumn(segclip.midtex, (int)texx);
-               column.texheight = segclip.midtexh;
+               R_setWallColumn(column, segclip.midtex, (int)texx, segclip.midtexmid,
+                               segclip.midtexh, texstep);
 
                colfunc(column);
 
@@ -477,10 +516,8 @@ static void R_renderSegLoop(cmapcontext_t &cmapcontext, planecontext_t &planecon
 
                if(column.y2 >= column.y1)
                {
-                  column.texmid = segclip.toptexmid;
-
-                  column.source = R_GetRawColumn(segclip.toptex, (int)texx);
-                  column.texheight = segclip.toptexh;
+                  R_setWallColumn(column, segclip.toptex, (int)texx, segclip.toptexmid,
+                                  segclip.toptexh, texstep);
 
                   colfunc(column);
 
@@ -519,10 +556,8 @@ static void R_renderSegLoop(cmapcontext_t &cmapcontext, planecontext_t &planecon
 
                if(column.y2 >= column.y1)
                {
-                  column.texmid = segclip.bottomtexmid;
-
-                  column.source = R_GetRawColumn(segclip.bottomtex, (int)texx);
-                  column.texheight = segclip.bottomtexh;
+                  R_setWallColumn(column, segclip.bottomtex, (int)texx, segclip.bottomtexmid,
+                                  segclip.bottomtexh, texstep);
 
                   colfunc(column);
 
@@ -606,7 +641,7 @@ static void R_checkDSAlloc(bspcontext_t &context)
    if(ds_p == drawsegs + maxdrawsegs)
    {
       unsigned int newmax = maxdrawsegs ? maxdrawsegs * 2 : 128;
-      drawsegs    = erealloc(drawseg_t *, drawsegs, sizeof(drawseg_t) * newmax);
+      drawsegs    = R_FrameArenaGrow(*context.arena, drawsegs, maxdrawsegs, newmax);
       ds_p        = drawsegs + maxdrawsegs;
       maxdrawsegs = newmax;
    }
@@ -792,6 +827,8 @@ void R_StoreWallRange(bspcontext_t &bspcontext, cmapcontext_t &cmapcontext, plan
 
    cb_seg_t segclip;
 
+   RenderProfileScope profile(RPROF_WALLS);
+
    // haleyjd 09/22/07: must be before use of segclip below
    memcpy(&segclip, &seg, sizeof(seg));
 
@@ -1059,6 +1096,25 @@ void R_StoreWallRange(bspcontext_t &bspcontext, cmapcontext_t &cmapcontext, plan
       ds_p->bsilheight = D_MAXINT;
    }
 
+   // Columns of a masked midtexture that nearer walls already close are
+   // marked drawn, and one with none open is not kept as masked at all. Its
+   // silhouette still clips sprites behind it.
+   if(ds_p->maskedtexturecol)
+   {
+      bool open = false;
+
+      for(int x = segclip.x1; x <= segclip.x2; x++)
+      {
+         if((int)ds_p->sprtopclip[x] > (int)ds_p->sprbottomclip[x])
+            ds_p->maskedtexturecol[x] = FLT_MAX;
+         else
+            open = true;
+      }
+
+      if(!open)
+         ds_p->maskedtexturecol = nullptr;
+   }
+
    // ioanch: also check for portalrender, and detect any columns shut by the
    // portal window, which would otherwise be ignored. Necessary for correct
    // sprite rendering.
@@ -36,6 +36,8 @@
 #include "doomstat.h"
 #include "r_sky.h"
 #include "r_data.h"
+#include "r_defs.h"
+#include "r_plane.h"
 #include "p_info.h"
 #include "v_video.h"
 #include "w_wad.h"
@@ -60,6 +62,9 @@ void R_StartSky()
   
    numskyflats = 0;
 
+   // a new level may bring different sky textures under the same numbers
+   R_InvalidateSkyCache();
+
    // Set the sky map.
    // First thing, we have a dummy sky texture name,
    //  a flat. The data is in the WAD only because
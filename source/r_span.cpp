@@ -29,48 +29,13 @@
 #include "doomstat.h"
 #include "w_wad.h"
 #include "r_draw.h"
+#include "r_drawt.h"
 #include "r_main.h"
 #include "v_video.h"
 #include "mn_engin.h"
 #include "d_gi.h"
 #include "r_plane.h"
 
-/*
-// Template structure for inlining constant values for orthogonal spans
-template<int xshift, int yshift, int xmask>
-struct spanconsts
-{
-   static inline int XShift() { return xshift; }
-   static inline int YShift() { return yshift; }
-   static inline int XMask()  { return xmask;  }
-};
-
-// Structure for inlining accesses to the cb_span_t structure for orthogonal spans
-struct spanvalues
-{
-   static inline int XShift() { return span.xshift; }
-   static inline int YShift() { return span.yshift; }
-   static inline int XMask()  { return span.xmask;  }
-};
-
-// Template structure for inlining constant values for slope spans
-template<int xshift, int xmask, int ymask>
-struct slopeconsts
-{
-   static inline int XShift() { return xshift; }
-   static inline int XMask()  { return xmask;  }
-   static inline int YMask()  { return ymask;  }
-};
-
-// Structure for inlining accesses to the cb_span_t structure for slope spans
-struct slopevalues
-{
-   static inline int XShift() { return span.xshift; }
-   static inline int XMask()  { return span.xmask;  }
-   static inline int YMask()  { return span.ymask;  }
-};
-*/
-
 //==============================================================================
 //
 // R_DrawSpan_*
@@ -97,51 +62,61 @@ struct slopevalues
 // but only by one bit per power of two (obviously)
 // Ok, because I was able to eliminate the variable spot below, this function
 // is now FASTER than doom's original span renderer. Whodathunkit?
+// Keep this a macro to easily change to a byte set if needed
+#define MASK(alpham, i) ((alpham)[(i)>>3] & 1 << ((i) & 7))
 
-template<int xshift, int yshift, int xmask>
-static void R_DrawSpanSolid_8(const cb_span_t &span)
+//
+// Every orthogonal span drawer is generated from this one loop. S is the
+// shift policy (constant for the square power-of-two sizes, read from the span
+// for the general case), B the blend policy.
+//
+// haleyjd 06/21/08: TL span drawers are needed for double flats and for portal
+// visplane layering.
+//
+// Additive doesn't strictly need a masked drawer because black is already
+// transparent there, but it costs nothing to generate one.
+//
+template<typename S, typename B, bool masked>
+static inline void R_drawSpan(const cb_span_t &span)
 {
-   unsigned int xf = span.xfrac, xs = span.xstep; 
-   unsigned int yf = span.yfrac, ys = span.ystep; 
-   lighttable_t *colormap = span.colormap; 
+   unsigned int xf = span.xfrac, xs = span.xstep;
+   unsigned int yf = span.yfrac, ys = span.ystep;
+   lighttable_t *colormap = span.colormap;
    int count = span.x2 - span.x1 + 1;
 
-   byte *source = (byte *)span.source;
-   byte *dest   = R_ADDRESS(span.x1, span.y);
+   const byte *source = (byte *)span.source;
+   byte       *dest   = R_ADDRESS(span.x1, span.y);
+
+   const S shift(span);
+   const unsigned int xshift = shift.XShift();
+   const unsigned int xmask  = shift.XMask();
+   const unsigned int yshift = shift.YShift();
+
+   const auto  blend  = B::Make(span);
+   const byte *alpham = (byte *)span.alphamask;
 
    while(count-- > 0)
    {
-      *dest = colormap[source[((xf >> xshift) & xmask) | (yf >> yshift)]];
+      const unsigned int i = ((xf >> xshift) & xmask) | (yf >> yshift);
+      if(!masked || MASK(alpham, i))
+         *dest = blend.Blend(colormap[source[i]], *dest);
       dest += linesize;
-      xf += xs;
-      yf += ys;
+      xf   += xs;
+      yf   += ys;
    }
 }
 
-static void R_DrawSpanSolid_8_GEN(const cb_span_t &span)
+template<typename B, bool masked, int xshift, int yshift, int xmask>
+static void R_drawSpan_8(const cb_span_t &span)
 {
-   unsigned int xf = span.xfrac, xs = span.xstep; 
-   unsigned int yf = span.yfrac, ys = span.ystep; 
-   lighttable_t *colormap = span.colormap; 
-   int count = span.x2 - span.x1 + 1;
-
-   byte *source = (byte *)span.source;
-   byte *dest   = R_ADDRESS(span.x1, span.y);
-
-   unsigned int xshift = span.xshift;
-   unsigned int xmask  = span.xmask;
-   unsigned int yshift = span.yshift;
-
-
-   while(count-- > 0)
-   {
-      *dest = colormap[source[((xf >> xshift) & xmask) | (yf >> yshift)]];
-      dest += linesize;
-      xf += xs;
-      yf += ys;
-   }
+   R_drawSpan<spanconsts<xshift, yshift, xmask>, B, masked>(span);
 }
 
+template<typename B, bool masked>
+static void R_drawSpan_8_GEN(const cb_span_t &span)
+{
+   R_drawSpan<spanvalues, B, masked>(span);
+}
 
 #if 0
 // SoM: Archive
@@ -202,412 +177,24 @@ static void R_DrawSpan_OLD()
 
 //==============================================================================
 //
-// TL Span Drawers
-//
-// haleyjd 06/21/08: TL span drawers are needed for double flats and for portal
-// visplane layering.
-//
-
-template<int xshift, int yshift, int xmask>
-static void R_DrawSpanTL_8(const cb_span_t &span)
-{
-   unsigned int t;
-   unsigned int xf = span.xfrac, xs = span.xstep;
-   unsigned int yf = span.yfrac, ys = span.ystep;
-   lighttable_t *colormap = span.colormap;
-   int count = span.x2 - span.x1 + 1;
-
-   byte *source = (byte *)span.source;
-   byte *dest   = R_ADDRESS(span.x1, span.y);
-
-   while(count-- > 0)
-   {
-      t = span.bg2rgb[*dest] +
-          span.fg2rgb[colormap[source[((xf >> xshift) & xmask) | (yf >> yshift)]]];
-      t |= 0x01f07c1f;
-      *dest = RGB32k[0][0][t & (t >> 15)];
-      dest += linesize;
-      xf   += xs;
-      yf   += ys;
-   }
-}
-
-static void R_DrawSpanTL_8_GEN(const cb_span_t &span)
-{
-   unsigned int t;
-   unsigned int xf = span.xfrac, xs = span.xstep;
-   unsigned int yf = span.yfrac, ys = span.ystep;
-   lighttable_t *colormap = span.colormap;
-   int count = span.x2 - span.x1 + 1;
-
-   byte *source = (byte *)span.source;
-   byte *dest   = R_ADDRESS(span.x1, span.y);
-
-   unsigned int xshift = span.xshift;
-   unsigned int xmask  = span.xmask;
-   unsigned int yshift = span.yshift;
-
-   while(count-- > 0)
-   {
-      t = span.bg2rgb[*dest] +
-          span.fg2rgb[colormap[source[((xf >> xshift) & xmask) | (yf >> yshift)]]];
-      t |= 0x01f07c1f;
-      *dest = RGB32k[0][0][t & (t >> 15)];
-      dest += linesize;
-      xf   += xs;
-      yf   += ys;
-   }
-}
-
-// Additive blending
-
-template<int xshift, int yshift, int xmask>
-static void R_DrawSpanAdd_8(const cb_span_t &span)
-{
-   unsigned int a, b;
-   unsigned int xf = span.xfrac, xs = span.xstep;
-   unsigned int yf = span.yfrac, ys = span.ystep;
-   lighttable_t *colormap = span.colormap;
-   int count = span.x2 - span.x1 + 1;
-
-   byte *source = (byte *)span.source;
-   byte *dest   = R_ADDRESS(span.x1, span.y);
-
-   while(count-- > 0)
-   {
-      a = span.bg2rgb[*dest] +
-          span.fg2rgb[colormap[source[((xf >> xshift) & xmask) | (yf >> yshift)]]];
-      b = a;
-      a |= 0x01f07c1f;
-      b &= 0x40100400;
-      a &= 0x3fffffff;
-      b  = b - (b >> 5);
-      a |= b;
-      *dest = RGB32k[0][0][a & (a >> 15)];
-      dest += linesize;
-      xf   += xs;
-      yf   += ys;
-   }
-}
-
-static void R_DrawSpanAdd_8_GEN(const cb_span_t &span)
-{
-   unsigned int a, b;
-   unsigned int xf = span.xfrac, xs = span.xstep;
-   unsigned int yf = span.yfrac, ys = span.ystep;
-   lighttable_t *colormap = span.colormap;
-   int count = span.x2 - span.x1 + 1;
-
-   byte *source = (byte *)span.source;
-   byte *dest   = R_ADDRESS(span.x1, span.y);
-
-   unsigned int xshift = span.xshift;
-   unsigned int xmask  = span.xmask;
-   unsigned int yshift = span.yshift;
-
-   while(count-- > 0)
-   {
-      a = span.bg2rgb[*dest] +
-          span.fg2rgb[colormap[source[((xf >> xshift) & xmask) | (yf >> yshift)]]];
-      b = a;
-      a |= 0x01f07c1f;
-      b &= 0x40100400;
-      a &= 0x3fffffff;
-      b  = b - (b >> 5);
-      a |= b;
-      *dest = RGB32k[0][0][a & (a >> 15)];
-      dest += linesize;
-      xf   += xs;
-      yf   += ys;
-   }
-}
-
-//==============================================================================
-//
-// Masked drawers (normal and TL -- additive doesn't need it because black is
-// already transparent there)
+// Slope span drawers
 //
 
-// Keep this a macro to easily change to a byte set if needed
-#define MASK(alpham, i) ((alpham)[(i)>>3] & 1 << ((i) & 7))
-
-template<int xshift, int yshift, int xmask>
-static void R_DrawSpanSolidMasked_8(const cb_span_t &span)
-{
-   unsigned int xf = span.xfrac, xs = span.xstep;
-   unsigned int yf = span.yfrac, ys = span.ystep;
-   lighttable_t *colormap = span.colormap;
-   int count = span.x2 - span.x1 + 1;
-
-   byte *source = (byte *)span.source;
-   byte *dest   = R_ADDRESS(span.x1, span.y);
-
-   const byte *alpham = (byte *)span.alphamask;
-   unsigned i;
-
-   while(count >= 4)
-   {
-      i = ((xf >> xshift) & xmask) | (yf >> yshift);
-      if(MASK(alpham, i))
-         dest[0] = colormap[source[i]];
-      xf += xs;
-      yf += ys;
-      i = ((xf >> xshift) & xmask) | (yf >> yshift);
-      if(MASK(alpham, i))
-         dest[linesize] = colormap[source[i]];
-      xf += xs;
-      yf += ys;
-      i = ((xf >> xshift) & xmask) | (yf >> yshift);
-      if(MASK(alpham, i))
-         dest[linesize * 2] = colormap[source[i]];
-      xf += xs;
-      yf += ys;
-      i = ((xf >> xshift) & xmask) | (yf >> yshift);
-      if(MASK(alpham, i))
-         dest[linesize * 3] = colormap[source[i]];
-      xf += xs;
-      yf += ys;
-      dest  += linesize * 4;
-      count -= 4;
-   }
-   while(count-- > 0)
-   {
-      i = ((xf >> xshift) & xmask) | (yf >> yshift);
-      if(MASK(alpham, i))
-         *dest = colormap[source[i]];
-      xf += xs;
-      yf += ys;
-      dest += linesize;
-   }
-}
-static void R_DrawSpanSolidMasked_8_GEN(const cb_span_t &span)
-{
-   unsigned int xf = span.xfrac, xs = span.xstep;
-   unsigned int yf = span.yfrac, ys = span.ystep;
-   lighttable_t *colormap = span.colormap;
-   int count = span.x2 - span.x1 + 1;
-
-   byte *source = (byte *)span.source;
-   byte *dest   = R_ADDRESS(span.x1, span.y);
-
-   unsigned int xshift = span.xshift;
-   unsigned int xmask  = span.xmask;
-   unsigned int yshift = span.yshift;
-
-   const byte *alpham = (byte *)span.alphamask;
-   unsigned i;
-
-   while(count >= 4)
-   {
-      i = ((xf >> xshift) & xmask) | (yf >> yshift);
-      if(MASK(alpham, i))
-         dest[0] = colormap[source[i]];
-      xf += xs;
-      yf += ys;
-      i = ((xf >> xshift) & xmask) | (yf >> yshift);
-      if(MASK(alpham, i))
-         dest[linesize] = colormap[source[i]];
-      xf += xs;
-      yf += ys;
-      i = ((xf >> xshift) & xmask) | (yf >> yshift);
-      if(MASK(alpham, i))
-         dest[linesize * 2] = colormap[source[i]];
-      xf += xs;
-      yf += ys;
-      i = ((xf >> xshift) & xmask) | (yf >> yshift);
-      if(MASK(alpham, i))
-         dest[linesize * 3] = colormap[source[i]];
-      xf += xs;
-      yf += ys;
-      dest  += linesize * 4;
-      count -= 4;
-   }
-   while(count-- > 0)
-   {
-      i = ((xf >> xshift) & xmask) | (yf >> yshift);
-      if(MASK(alpham, i))
-         *dest = colormap[source[i]];
-      xf += xs;
-      yf += ys;
-      dest += linesize;
-   }
-}
-template<int xshift, int yshift, int xmask>
-static void R_DrawSpanTLMasked_8(const cb_span_t &span)
+// Slope drawers blend one texel at a time through the span blend policies
+template<typename B>
+struct slopesampler
 {
-   unsigned int t;
-   unsigned int xf = span.xfrac, xs = span.xstep;
-   unsigned int yf = span.yfrac, ys = span.ystep;
-   lighttable_t *colormap = span.colormap;
-   int count = span.x2 - span.x1 + 1;
-
-   byte *source = (byte *)span.source;
-   byte *dest   = R_ADDRESS(span.x1, span.y);
-
-   const byte *alpham = (byte *)span.alphamask;
-   unsigned i;
-
-   while(count-- > 0)
+   static inline byte Sample(const byte fgColor, const byte bgColor, const cb_span_t &span)
    {
-      i = ((xf >> xshift) & xmask) | (yf >> yshift);
-      if(MASK(alpham, i))
-      {
-         t = span.bg2rgb[*dest] + span.fg2rgb[colormap[source[i]]];
-         t |= 0x01f07c1f;
-         *dest = RGB32k[0][0][t & (t >> 15)];
-      }
-      xf += xs;
-      yf += ys;
-      dest += linesize;
+      return B::Make(span).Blend(fgColor, bgColor);
    }
-}
-static void R_DrawSpanTLMasked_8_GEN(const cb_span_t &span)
-{
-   unsigned int t;
-   unsigned int xf = span.xfrac, xs = span.xstep;
-   unsigned int yf = span.yfrac, ys = span.ystep;
-   lighttable_t *colormap = span.colormap;
-   int count = span.x2 - span.x1 + 1;
-
-   byte *source = (byte *)span.source;
-   byte *dest   = R_ADDRESS(span.x1, span.y);
-
-   unsigned int xshift = span.xshift;
-   unsigned int xmask  = span.xmask;
-   unsigned int yshift = span.yshift;
-
-   const byte *alpham = (byte *)span.alphamask;
-   unsigned i;
-
-   while(count-- > 0)
-   {
-      i = ((xf >> xshift) & xmask) | (yf >> yshift);
-      if(MASK(alpham, i))
-      {
-         t = span.bg2rgb[*dest] + span.fg2rgb[colormap[source[i]]];
-         t |= 0x01f07c1f;
-         *dest = RGB32k[0][0][t & (t >> 15)];
-      }
-      xf += xs;
-      yf += ys;
-      dest += linesize;
-   }
-}
-template<int xshift, int yshift, int xmask>
-static void R_DrawSpanAddMasked_8(const cb_span_t &span)
-{
-   unsigned int a, b;
-   unsigned int xf = span.xfrac, xs = span.xstep;
-   unsigned int yf = span.yfrac, ys = span.ystep;
-   lighttable_t *colormap = span.colormap;
-   int count = span.x2 - span.x1 + 1;
-
-   byte *source = (byte *)span.source;
-   byte *dest   = R_ADDRESS(span.x1, span.y);
-
-   const byte *alpham = (byte *)span.alphamask;
-   unsigned i;
-
-   while(count-- > 0)
-   {
-      i = ((xf >> xshift) & xmask) | (yf >> yshift);
-      if(MASK(alpham, i))
-      {
-         a = span.bg2rgb[*dest] + span.fg2rgb[colormap[source[i]]];
-         b = a;
-         a |= 0x01f07c1f;
-         b &= 0x40100400;
-         a &= 0x3fffffff;
-         b  = b - (b >> 5);
-         a |= b;
-         *dest = RGB32k[0][0][a & (a >> 15)];
-      }
-      xf += xs;
-      yf += ys;
-      dest += linesize;
-   }
-}
-static void R_DrawSpanAddMasked_8_GEN(const cb_span_t &span)
-{
-   unsigned int a, b;
-   unsigned int xf = span.xfrac, xs = span.xstep;
-   unsigned int yf = span.yfrac, ys = span.ystep;
-   lighttable_t *colormap = span.colormap;
-   int count = span.x2 - span.x1 + 1;
-
-   byte *source = (byte *)span.source;
-   byte *dest   = R_ADDRESS(span.x1, span.y);
-
-   unsigned int xshift = span.xshift;
-   unsigned int xmask  = span.xmask;
-   unsigned int yshift = span.yshift;
-
-   const byte *alpham = (byte *)span.alphamask;
-   unsigned i;
-
-   while(count-- > 0)
-   {
-      i = ((xf >> xshift) & xmask) | (yf >> yshift);
-      if(MASK(alpham, i))
-      {
-         a = span.bg2rgb[*dest] + span.fg2rgb[colormap[source[i]]];
-         b = a;
-         a |= 0x01f07c1f;
-         b &= 0x40100400;
-         a &= 0x3fffffff;
-         b  = b - (b >> 5);
-         a |= b;
-         *dest = RGB32k[0][0][a & (a >> 15)];
-      }
-      xf += xs;
-      yf += ys;
-     dest += linesize;
-   }
-}
-
-//==============================================================================
-//
-// Slope span drawers
-//
+};
 
 struct Sampler
 {
-   struct Solid
-   {
-      static inline byte Sample(const byte fgColor, const byte bgColor, const cb_span_t &span)
-      {
-         return fgColor;
-      }
-   };
-
-   struct Translucent
-   {
-      static inline byte Sample(const byte fgColor, const byte bgColor, const cb_span_t &span)
-      {
-         int t;
-
-         t  = span.bg2rgb[bgColor] + span.fg2rgb[fgColor];
-         t |= 0x01f07c1f;
-         return RGB32k[0][0][t & (t >> 15)];
-      }
-   };
-
-   struct Additive
-   {
-      static inline byte Sample(const byte fgColor, const byte bgColor, const cb_span_t &span)
-      {
-         unsigned int a, b;
-
-         a = span.bg2rgb[bgColor] + span.fg2rgb[fgColor];
-         b = a;
-         a |= 0x01f07c1f;
-         b &= 0x40100400;
-         a &= 0x3fffffff;
-         b  = b - (b >> 5);
-         a |= b;
-         return RGB32k[0][0][a & (a >> 15)];
-      }
-   };
+   using Solid       = slopesampler<spanblendsolid>;
+   using Translucent = slopesampler<spanblendtl>;
+   using Additive    = slopesampler<spanblendadd>;
 };
 
 #if 0
@@ -1074,6 +661,86 @@ static void R_drawSlopeAddMasked_8_GEN(const cb_slopespan_t &slopespan, const cb
    R_drawSlopeMasked_8_GEN<Sampler::Additive>(slopespan, span);
 }
 
+//==============================================================================
+//
+// Exact slope drawers
+//
+// These do the perspective divide at every pixel instead of interpolating
+// across SPANJUMP-pixel blocks. Slow; selected with r_slopeexact for
+// comparison against the subdivided drawers.
+//
+
+template<typename Sampler, bool masked>
+static inline void R_drawSlopeExact(const cb_slopespan_t &slopespan, const cb_span_t &span,
+                                    const unsigned int xshift, const unsigned int xmask,
+                                    const unsigned int ymask)
+{
+   double iu  = slopespan.iufrac, iv  = slopespan.ivfrac;
+   double ius = slopespan.iustep, ivs = slopespan.ivstep;
+   double id  = slopespan.idfrac, ids = slopespan.idstep;
+
+   int count;
+   fixed_t mapindex = 0;
+
+   if((count = slopespan.x2 - slopespan.x1 + 1) < 0)
+      return;
+
+   byte *src  = (byte *)slopespan.source;
+   byte *dest = R_ADDRESS(slopespan.x1, slopespan.y);
+
+   const byte *alpham = (byte *)span.alphamask;
+
+   while(count-- > 0)
+   {
+      const double mul = 65536.0f / id;
+      const unsigned int ufrac = static_cast<unsigned int>(iu * mul);
+      const unsigned int vfrac = static_cast<unsigned int>(iv * mul);
+      const unsigned int i = ((vfrac >> xshift) & xmask) | ((ufrac >> 16) & ymask);
+      byte *colormap = cb_slopespan_t::colormap[mapindex++];
+
+      if(!masked || MASK(alpham, i))
+         *dest = Sampler::Sample(colormap[src[i]], *dest, span);
+
+      dest += linesize;
+      iu   += ius;
+      iv   += ivs;
+      id   += ids;
+   }
+}
+
+template<typename Sampler, bool masked, int xshift, int xmask, int ymask>
+static void R_drawSlopeExact_8(const cb_slopespan_t &slopespan, const cb_span_t &span)
+{
+   R_drawSlopeExact<Sampler, masked>(slopespan, span, xshift, xmask, ymask);
+}
+
+template<typename Sampler, bool masked>
+static void R_drawSlopeExact_8_GEN(const cb_slopespan_t &slopespan, const cb_span_t &span)
+{
+   R_drawSlopeExact<Sampler, masked>(slopespan, span, span.xshift, span.xmask, span.ymask);
+}
+
+#define EXACTSLOPES(sampler, masked)                                \
+   {                                                                \
+      R_drawSlopeExact_8<sampler, masked, 10, 0x00FC0, 0x03F>,      \
+      R_drawSlopeExact_8<sampler, masked,  9, 0x03F80, 0x07F>,      \
+      R_drawSlopeExact_8<sampler, masked,  8, 0x0FF00, 0x0FF>,      \
+      R_drawSlopeExact_8<sampler, masked,  7, 0x3FE00, 0x1FF>,      \
+      R_drawSlopeExact_8_GEN<sampler, masked>                       \
+   }
+
+// Per-pixel divide slope drawers, indexed like spandrawer_t::DrawSlope
+R_SlopeFunc r_exactslopes[SPAN_NUMSTYLES][FLAT_NUMSIZES] =
+{
+   EXACTSLOPES(Sampler::Solid,       false),
+   EXACTSLOPES(Sampler::Translucent, false),
+   EXACTSLOPES(Sampler::Additive,    false),
+   EXACTSLOPES(Sampler::Solid,       true),
+   EXACTSLOPES(Sampler::Translucent, true),
+   EXACTSLOPES(Sampler::Additive,    true),
+};
+
+#undef EXACTSLOPES
 
 #undef SPANJUMP
 #undef INTERPSTEP
@@ -1083,6 +750,15 @@ static void R_drawSlopeAddMasked_8_GEN(const cb_slopespan_t &slopespan, const cb
 // Span Engine Objects
 //
 
+#define SPANSIZES(blend, masked)                     \
+   {                                                 \
+      R_drawSpan_8<blend, masked, 20, 26, 0x00FC0>,  \
+      R_drawSpan_8<blend, masked, 18, 25, 0x03F80>,  \
+      R_drawSpan_8<blend, masked, 16, 24, 0x0FF00>,  \
+      R_drawSpan_8<blend, masked, 14, 23, 0x3FE00>,  \
+      R_drawSpan_8_GEN<blend, masked>                \
+   }
+
 // the normal, high-precision span drawer
 spandrawer_t r_spandrawer =
 {
@@ -1091,54 +767,12 @@ spandrawer_t r_spandrawer =
       // R_DrawSpan<32-2*n, 32-n, n 1s then n 0s> // 2^n x 2^n
       // NB: n 1s then n 0s can be represented as ((1 << n) - 1) << n
 
-      // Solid
-      {
-         R_DrawSpanSolid_8<20, 26, 0x00FC0>, // 64x64
-         R_DrawSpanSolid_8<18, 25, 0x03F80>, // 128x128
-         R_DrawSpanSolid_8<16, 24, 0x0FF00>, // 256x256
-         R_DrawSpanSolid_8<14, 23, 0x3FE00>, // 512x512
-         R_DrawSpanSolid_8_GEN               // General
-      },
-      // Translucent
-      {
-         R_DrawSpanTL_8<20, 26, 0x00FC0>,    // 64x64
-         R_DrawSpanTL_8<18, 25, 0x03F80>,    // 128x128
-         R_DrawSpanTL_8<16, 24, 0x0FF00>,    // 256x256
-         R_DrawSpanTL_8<14, 23, 0x3FE00>,    // 512x512
-         R_DrawSpanTL_8_GEN                  // General
-      },
-      // Additive
-      {
-         R_DrawSpanAdd_8<20, 26, 0x00FC0>,   // 64x64
-         R_DrawSpanAdd_8<18, 25, 0x03F80>,   // 128x128
-         R_DrawSpanAdd_8<16, 24, 0x0FF00>,   // 256x256
-         R_DrawSpanAdd_8<14, 23, 0x3FE00>,   // 512x512
-         R_DrawSpanAdd_8_GEN                 // General
-      },
-      // Solid masked
-      {
-         R_DrawSpanSolidMasked_8<20, 26, 0x00FC0>, // 64x64
-         R_DrawSpanSolidMasked_8<18, 25, 0x03F80>, // 128x128
-         R_DrawSpanSolidMasked_8<16, 24, 0x0FF00>, // 256x256
-         R_DrawSpanSolidMasked_8<14, 23, 0x3FE00>, // 512x512
-         R_DrawSpanSolidMasked_8_GEN               // General
-      },
-      // Translucent masked
-      {
-         R_DrawSpanTLMasked_8<20, 26, 0x00FC0>,    // 64x64
-         R_DrawSpanTLMasked_8<18, 25, 0x03F80>,    // 128x128
-         R_DrawSpanTLMasked_8<16, 24, 0x0FF00>,    // 256x256
-         R_DrawSpanTLMasked_8<14, 23, 0x3FE00>,    // 512x512
-         R_DrawSpanTLMasked_8_GEN                  // General
-      },
-      // Additive masked
-      {
-         R_DrawSpanAddMasked_8<20, 26, 0x00FC0>,   // 64x64
-         R_DrawSpanAddMasked_8<18, 25, 0x03F80>,   // 128x128
-         R_DrawSpanAddMasked_8<16, 24, 0x0FF00>,   // 256x256
-         R_DrawSpanAddMasked_8<14, 23, 0x3FE00>,   // 512x512
-         R_DrawSpanAddMasked_8_GEN                 // General
-      }
+      SPANSIZES(spanblendsolid, false), // Solid
+      SPANSIZES(spanblendtl,    false), // Translucent
+      SPANSIZES(spanblendadd,   false), // Additive
+      SPANSIZES(spanblendsolid, true),  // Solid masked
+      SPANSIZES(spanblendtl,    true),  // Translucent masked
+      SPANSIZES(spanblendadd,   true)   // Additive masked
    },
 
    // SoM: Sloped span drawers
@@ -1196,5 +830,7 @@ spandrawer_t r_spandrawer =
    }
 };
 
+#undef SPANSIZES
+
 // EOF
 
@@ -0,0 +1,518 @@
+//
+// The Eternity Engine
+// Copyright(C) 2026 James Haley, Max Waine, et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+// Additional terms and conditions compatible with the GPLv3 apply. See the
+// file COPYING-EE for details.
+//
+// Purpose: Vectorized span drawers.
+//  For unsloped planes the texel address of 8 (SSE2/NEON) or 16 (AVX2)
+//  consecutive pixels is computed per iteration. For sloped planes the
+//  perspective divide is done once per 16-pixel block as in r_span.cpp, and
+//  the interpolated addresses of the whole block are computed together.
+//  Pixels are then fetched, lit and blended as in r_span.cpp, so output is
+//  identical to the scalar drawers. The widest variant the CPU supports is
+//  picked when the engine is initialised.
+//
+
+#include "z_zone.h"
+#include "doomstat.h"
+#include "m_simd.h"
+#include "r_draw.h"
+#include "r_drawt.h"
+#include "r_main.h"
+#include "r_plane.h"
+#include "v_video.h"
+
+// the vectorized span drawer; masked slopes are shared with r_spandrawer
+spandrawer_t r_vecspandrawer;
+
+//
+// Writes one fetched texel to dest through blend policy B
+//
+template<typename B>
+static inline void R_drawTexel(const cb_span_t &span, const lighttable_t *colormap, byte *dest,
+                               byte texel)
+{
+   *dest = B::Make(span).Blend(colormap[texel], *dest);
+}
+
+//
+// Draws the pixels left over after the vector loop
+//
+template<typename B, typename S>
+static inline void R_drawSpanTail(const cb_span_t &span, const S &shift, byte *dest, int count,
+                                  unsigned int xf, unsigned int yf)
+{
+   const byte *source = static_cast<const byte *>(span.source);
+   const int   xshift = shift.XShift(), yshift = shift.YShift();
+   const unsigned int xmask = unsigned(shift.XMask());
+
+   while(count-- > 0)
+   {
+      R_drawTexel<B>(span, span.colormap, dest, source[((xf >> xshift) & xmask) | (yf >> yshift)]);
+      dest += linesize;
+      xf   += span.xstep;
+      yf   += span.ystep;
+   }
+}
+
+//
+// Writes out a block of pixels whose texel indices have been computed
+//
+template<typename B, int N>
+static inline void R_drawSpanBlock(const cb_span_t &span, byte *&dest, const uint32_t *index)
+{
+   const byte *source = static_cast<const byte *>(span.source);
+
+   for(int i = 0; i < N; i++)
+   {
+      R_drawTexel<B>(span, span.colormap, dest, source[index[i]]);
+      dest += linesize;
+   }
+}
+
+#if defined(EE_SIMD_SSE2)
+
+//
+// 8 texel addresses per iteration in two SSE2 registers
+//
+template<typename B, typename S>
+static void R_drawSpanSSE2(const cb_span_t &span)
+{
+   unsigned int xf = span.xfrac, xs = span.xstep;
+   unsigned int yf = span.yfrac, ys = span.ystep;
+   int count = span.x2 - span.x1 + 1;
+   byte *dest = R_ADDRESS(span.x1, span.y);
+   const S shift(span);
+
+   if(count >= 8)
+   {
+      const __m128i xshift = _mm_cvtsi32_si128(shift.XShift());
+      const __m128i yshift = _mm_cvtsi32_si128(shift.YShift());
+      const __m128i xmask  = _mm_set1_epi32(shift.XMask());
+      const __m128i xstep8 = _mm_set1_epi32(int(xs * 8));
+      const __m128i ystep8 = _mm_set1_epi32(int(ys * 8));
+      const __m128i xstep4 = _mm_set1_epi32(int(xs * 4));
+      const __m128i ystep4 = _mm_set1_epi32(int(ys * 4));
+
+      __m128i xlo = _mm_setr_epi32(int(xf), int(xf + xs), int(xf + xs * 2), int(xf + xs * 3));
+      __m128i ylo = _mm_setr_epi32(int(yf), int(yf + ys), int(yf + ys * 2), int(yf + ys * 3));
+      __m128i xhi = _mm_add_epi32(xlo, xstep4);
+      __m128i yhi = _mm_add_epi32(ylo, ystep4);
+
+      alignas(16) uint32_t index[8];
+
+      do
+      {
+         const __m128i ilo = _mm_or_si128(_mm_and_si128(_mm_srl_epi32(xlo, xshift), xmask),
+                                          _mm_srl_epi32(ylo, yshift));
+         const __m128i ihi = _mm_or_si128(_mm_and_si128(_mm_srl_epi32(xhi, xshift), xmask),
+                                          _mm_srl_epi32(yhi, yshift));
+         _mm_store_si128(reinterpret_cast<__m128i *>(index),     ilo);
+         _mm_store_si128(reinterpret_cast<__m128i *>(index + 4), ihi);
+
+         xlo = _mm_add_epi32(xlo, xstep8);
+         ylo = _mm_add_epi32(ylo, ystep8);
+         xhi = _mm_add_epi32(xhi, xstep8);
+         yhi = _mm_add_epi32(yhi, ystep8);
+
+         R_drawSpanBlock<B, 8>(span, dest, index);
+
+         xf    += xs * 8;
+         yf    += ys * 8;
+         count -= 8;
+      }
+      while(count >= 8);
+   }
+
+   R_drawSpanTail<B>(span, shift, dest, count, xf, yf);
+}
+
+#endif
+
+#if defined(EE_SIMD_AVX2)
+
+//
+// 16 texel addresses per iteration in two AVX2 registers
+//
+template<typename B, typename S>
+EE_TARGET_AVX2 static void R_drawSpanAVX2(const cb_span_t &span)
+{
+   unsigned int xf = span.xfrac, xs = span.xstep;
+   unsigned int yf = span.yfrac, ys = span.ystep;
+   int count = span.x2 - span.x1 + 1;
+   byte *dest = R_ADDRESS(span.x1, span.y);
+   const S shift(span);
+
+   if(count >= 16)
+   {
+      const __m128i xshift  = _mm_cvtsi32_si128(shift.XShift());
+      const __m128i yshift  = _mm_cvtsi32_si128(shift.YShift());
+      const __m256i xmask   = _mm256_set1_epi32(shift.XMask());
+      const __m256i xstep16 = _mm256_set1_epi32(int(xs * 16));
+      const __m256i ystep16 = _mm256_set1_epi32(int(ys * 16));
+      const __m256i xstep8  = _mm256_set1_epi32(int(xs * 8));
+      const __m256i ystep8  = _mm256_set1_epi32(int(ys * 8));
+      const __m256i lanes   = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+      __m256i xlo = _mm256_add_epi32(_mm256_set1_epi32(int(xf)),
+                                     _mm256_mullo_epi32(lanes, _mm256_set1_epi32(int(xs))));
+      __m256i ylo = _mm256_add_epi32(_mm256_set1_epi32(int(yf)),
+                                     _mm256_mullo_epi32(lanes, _mm256_set1_epi32(int(ys))));
+      __m256i xhi = _mm256_add_epi32(xlo, xstep8);
+      __m256i yhi = _mm256_add_epi32(ylo, ystep8);
+
+      alignas(32) uint32_t index[16];
+
+      do
+      {
+         const __m256i ilo = _mm256_or_si256(
+            _mm256_and_si256(_mm256_srl_epi32(xlo, xshift), xmask), _mm256_srl_epi32(ylo, yshift)
+         );
+         const __m256i ihi = _mm256_or_si256(
+            _mm256_and_si256(_mm256_srl_epi32(xhi, xshift), xmask), _mm256_srl_epi32(yhi, yshift)
+         );
+         _mm256_store_si256(reinterpret_cast<__m256i *>(index),     ilo);
+         _mm256_store_si256(reinterpret_cast<__m256i *>(index + 8), ihi);
+
+         xlo = _mm256_add_epi32(xlo, xstep16);
+         ylo = _mm256_add_epi32(ylo, ystep16);
+         xhi = _mm256_add_epi32(xhi, xstep16);
+         yhi = _mm256_add_epi32(yhi, ystep16);
+
+         R_drawSpanBlock<B, 16>(span, dest, index);
+
+         xf    += xs * 16;
+         yf    += ys * 16;
+         count -= 16;
+      }
+      while(count >= 16);
+   }
+
+   R_drawSpanTail<B>(span, shift, dest, count, xf, yf);
+}
+
+#endif
+
+#if defined(EE_SIMD_NEON)
+
+//
+// 8 texel addresses per iteration in two NEON registers
+//
+template<typename B, typename S>
+static void R_drawSpanNEON(const cb_span_t &span)
+{
+   unsigned int xf = span.xfrac, xs = span.xstep;
+   unsigned int yf = span.yfrac, ys = span.ystep;
+   int count = span.x2 - span.x1 + 1;
+   byte *dest = R_ADDRESS(span.x1, span.y);
+   const S shift(span);
+
+   if(count >= 8)
+   {
+      // NEON shifts right by shifting left a negative amount
+      const int32x4_t  xshift = vdupq_n_s32(-shift.XShift());
+      const int32x4_t  yshift = vdupq_n_s32(-shift.YShift());
+      const uint32x4_t xmask  = vdupq_n_u32(uint32_t(shift.XMask()));
+      const uint32x4_t xstep8 = vdupq_n_u32(xs * 8);
+      const uint32x4_t ystep8 = vdupq_n_u32(ys * 8);
+
+      const uint32_t xinit[4] = { xf, xf + xs, xf + xs * 2, xf + xs * 3 };
+      const uint32_t yinit[4] = { yf, yf + ys, yf + ys * 2, yf + ys * 3 };
+
+      uint32x4_t xlo = vld1q_u32(xinit);
+      uint32x4_t ylo = vld1q_u32(yinit);
+      uint32x4_t xhi = vaddq_u32(xlo, vdupq_n_u32(xs * 4));
+      uint32x4_t yhi = vaddq_u32(ylo, vdupq_n_u32(ys * 4));
+
+      uint32_t index[8];
+
+      do
+      {
+         vst1q_u32(index,     vorrq_u32(vandq_u32(vshlq_u32(xlo, xshift), xmask),
+                                        vshlq_u32(ylo, yshift)));
+         vst1q_u32(index + 4, vorrq_u32(vandq_u32(vshlq_u32(xhi, xshift), xmask),
+                                        vshlq_u32(yhi, yshift)));
+
+         xlo = vaddq_u32(xlo, xstep8);
+         ylo = vaddq_u32(ylo, ystep8);
+         xhi = vaddq_u32(xhi, xstep8);
+         yhi = vaddq_u32(yhi, ystep8);
+
+         R_drawSpanBlock<B, 8>(span, dest, index);
+
+         xf    += xs * 8;
+         yf    += ys * 8;
+         count -= 8;
+      }
+      while(count >= 8);
+   }
+
+   R_drawSpanTail<B>(span, shift, dest, count, xf, yf);
+}
+
+#endif
+
+//==============================================================================
+//
+// Sloped spans
+//
+
+#define SPANJUMP 16
+#define INTERPSTEP (0.0625f)
+
+#if defined(EE_SIMD_SSE2) || defined(EE_SIMD_NEON)
+
+//
+// Computes the texel indices of one SPANJUMP-pixel block of a sloped span,
+// four pixels per vector
+//
+template<typename S>
+static inline void R_slopeBlockIndices(const S &shift, unsigned int ufrac, unsigned int ustep,
+                                       unsigned int vfrac, unsigned int vstep, uint32_t *index)
+{
+#if defined(EE_SIMD_SSE2)
+   const __m128i xshift = _mm_cvtsi32_si128(shift.XShift());
+   const __m128i xmask  = _mm_set1_epi32(shift.XMask());
+   const __m128i ymask  = _mm_set1_epi32(shift.YMask());
+   const __m128i ustep4 = _mm_set1_epi32(int(ustep * 4));
+   const __m128i vstep4 = _mm_set1_epi32(int(vstep * 4));
+
+   __m128i u = _mm_setr_epi32(int(ufrac), int(ufrac + ustep), int(ufrac + ustep * 2),
+                              int(ufrac + ustep * 3));
+   __m128i v = _mm_setr_epi32(int(vfrac), int(vfrac + vstep), int(vfrac + vstep * 2),
+                              int(vfrac + vstep * 3));
+
+   for(int i = 0; i < SPANJUMP; i += 4)
+   {
+      const __m128i idx = _mm_or_si128(_mm_and_si128(_mm_srl_epi32(v, xshift), xmask),
+                                       _mm_and_si128(_mm_srli_epi32(u, 16), ymask));
+      _mm_store_si128(reinterpret_cast<__m128i *>(index + i), idx);
+      u = _mm_add_epi32(u, ustep4);
+      v = _mm_add_epi32(v, vstep4);
+   }
+#else
+   const int32x4_t  xshift = vdupq_n_s32(-shift.XShift());
+   const uint32x4_t xmask  = vdupq_n_u32(uint32_t(shift.XMask()));
+   const uint32x4_t ymask  = vdupq_n_u32(uint32_t(shift.YMask()));
+   const uint32x4_t ustep4 = vdupq_n_u32(ustep * 4);
+   const uint32x4_t vstep4 = vdupq_n_u32(vstep * 4);
+
+   const uint32_t uinit[4] = { ufrac, ufrac + ustep, ufrac + ustep * 2, ufrac + ustep * 3 };
+   const uint32_t vinit[4] = { vfrac, vfrac + vstep, vfrac + vstep * 2, vfrac + vstep * 3 };
+   uint32x4_t u = vld1q_u32(uinit);
+   uint32x4_t v = vld1q_u32(vinit);
+
+   for(int i = 0; i < SPANJUMP; i += 4)
+   {
+      vst1q_u32(index + i, vorrq_u32(vandq_u32(vshlq_u32(v, xshift), xmask),
+                                     vandq_u32(vshrq_n_u32(u, 16), ymask)));
+      u = vaddq_u32(u, ustep4);
+      v = vaddq_u32(v, vstep4);
+   }
+#endif
+}
+
+//
+// Unmasked sloped span. Full blocks reuse the previous block's end divide as
+// their start divide, so there is a single divide per block.
+//
+template<typename B, typename S>
+static void R_drawSlopeVec(const cb_slopespan_t &slopespan, const cb_span_t &span)
+{
+   double iu  = slopespan.iufrac, iv  = slopespan.ivfrac;
+   double ius = slopespan.iustep, ivs = slopespan.ivstep;
+   double id  = slopespan.idfrac, ids = slopespan.idstep;
+
+   int count;
+   fixed_t mapindex = 0;
+
+   if((count = slopespan.x2 - slopespan.x1 + 1) < 0)
+      return;
+
+   const byte *src  = static_cast<const byte *>(slopespan.source);
+   byte       *dest = R_ADDRESS(slopespan.x1, slopespan.y);
+   const S shift(span);
+
+   alignas(16) uint32_t index[SPANJUMP];
+   double mulend = 65536.0f / id;
+
+   while(count >= SPANJUMP)
+   {
+      const double mulstart = mulend;
+      id += ids * SPANJUMP;
+      mulend = 65536.0f / id;
+
+      const double ustart = iu * mulstart;
+      const double vstart = iv * mulstart;
+      iu += ius * SPANJUMP;
+      iv += ivs * SPANJUMP;
+      const double uend = iu * mulend;
+      const double vend = iv * mulend;
+
+      R_slopeBlockIndices(
+         shift,
+         static_cast<unsigned int>(ustart), static_cast<unsigned int>((uend - ustart) * INTERPSTEP),
+         static_cast<unsigned int>(vstart), static_cast<unsigned int>((vend - vstart) * INTERPSTEP),
+         index
+      );
+
+      for(int i = 0; i < SPANJUMP; i++)
+      {
+         R_drawTexel<B>(span, cb_slopespan_t::colormap[mapindex++], dest, src[index[i]]);
+         dest += linesize;
+      }
+
+      count -= SPANJUMP;
+   }
+   if(count > 0)
+   {
+      const double mulstart = mulend;
+      id += ids * count;
+      mulend = 65536.0f / id;
+
+      const double ustart = iu * mulstart;
+      const double vstart = iv * mulstart;
+      iu += ius * count;
+      iv += ivs * count;
+      const double uend = iu * mulend;
+      const double vend = iv * mulend;
+
+      unsigned int ufrac = static_cast<unsigned int>(ustart);
+      unsigned int vfrac = static_cast<unsigned int>(vstart);
+      const unsigned int ustep = static_cast<unsigned int>((uend - ustart) / count);
+      const unsigned int vstep = static_cast<unsigned int>((vend - vstart) / count);
+
+      const unsigned int xshift = shift.XShift();
+      const unsigned int xmask  = shift.XMask();
+      const unsigned int ymask  = shift.YMask();
+
+      while(count--)
+      {
+         R_drawTexel<B>(span, cb_slopespan_t::colormap[mapindex++], dest,
+                 src[((vfrac >> xshift) & xmask) | ((ufrac >> 16) & ymask)]);
+         dest  += linesize;
+         ufrac += ustep;
+         vfrac += vstep;
+      }
+   }
+}
+
+#endif
+
+#undef SPANJUMP
+#undef INTERPSTEP
+
+//==============================================================================
+//
+// Engine tables
+//
+
+using R_SpanFunc = void (*)(const cb_span_t &);
+
+// Same shift/mask parameters as r_spandrawer
+#define SPANVEC_SIZES(func, blend)                    \
+   {                                                  \
+      func<blend, spanconsts<20, 26, 0x00FC0>>,       \
+      func<blend, spanconsts<18, 25, 0x03F80>>,       \
+      func<blend, spanconsts<16, 24, 0x0FF00>>,       \
+      func<blend, spanconsts<14, 23, 0x3FE00>>,       \
+      func<blend, spanvalues>                         \
+   }
+
+#define SPANVEC_STYLES(func)                          \
+   {                                                  \
+      SPANVEC_SIZES(func, spanblendsolid),            \
+      SPANVEC_SIZES(func, spanblendtl),               \
+      SPANVEC_SIZES(func, spanblendadd)               \
+   }
+
+#if defined(EE_SIMD_SSE2)
+static const R_SpanFunc spansse2[3][FLAT_NUMSIZES] = SPANVEC_STYLES(R_drawSpanSSE2);
+#endif
+#if defined(EE_SIMD_AVX2)
+static const R_SpanFunc spanavx2[3][FLAT_NUMSIZES] = SPANVEC_STYLES(R_drawSpanAVX2);
+#endif
+#if defined(EE_SIMD_NEON)
+static const R_SpanFunc spanneon[3][FLAT_NUMSIZES] = SPANVEC_STYLES(R_drawSpanNEON);
+#endif
+
+// Sloped equivalents, again matching r_spandrawer
+#define SLOPEVEC_SIZES(blend)                                 \
+   {                                                          \
+      R_drawSlopeVec<blend, slopeconsts<10, 0x00FC0, 0x03F>>, \
+      R_drawSlopeVec<blend, slopeconsts< 9, 0x03F80, 0x07F>>, \
+      R_drawSlopeVec<blend, slopeconsts< 8, 0x0FF00, 0x0FF>>, \
+      R_drawSlopeVec<blend, slopeconsts< 7, 0x3FE00, 0x1FF>>, \
+      R_drawSlopeVec<blend, slopevalues>                      \
+   }
+
+#if defined(EE_SIMD_SSE2) || defined(EE_SIMD_NEON)
+static const R_SlopeFunc slopevec[3][FLAT_NUMSIZES] =
+{
+   SLOPEVEC_SIZES(spanblendsolid),
+   SLOPEVEC_SIZES(spanblendtl),
+   SLOPEVEC_SIZES(spanblendadd)
+};
+#endif
+
+#undef SLOPEVEC_SIZES
+#undef SPANVEC_STYLES
+#undef SPANVEC_SIZES
+
+//
+// R_InitVectorSpanDrawer
+//
+// Fills in r_vecspandrawer with the best drawers this CPU can run. Masked
+// spans, and anything without a vector version, use r_spandrawer's.
+//
+void R_InitVectorSpanDrawer()
+{
+   const R_SpanFunc (*table)[FLAT_NUMSIZES] = nullptr;
+
+   r_vecspandrawer = r_spandrawer;
+
+#if defined(EE_SIMD_AVX2)
+   if(M_CPUHasAVX2())
+      table = spanavx2;
+#endif
+#if defined(EE_SIMD_SSE2)
+   if(!table)
+      table = spansse2;
+#endif
+#if defined(EE_SIMD_NEON)
+   table = spanneon;
+#endif
+
+   if(!table)
+      return;
+
+   static const int styles[3] = { SPAN_STYLE_NORMAL, SPAN_STYLE_TL, SPAN_STYLE_ADD };
+   for(int i = 0; i < 3; i++)
+   {
+      for(int size = 0; size < FLAT_NUMSIZES; size++)
+      {
+         r_vecspandrawer.DrawSpan[styles[i]][size] = table[i][size];
+#if defined(EE_SIMD_SSE2) || defined(EE_SIMD_NEON)
+         r_vecspandrawer.DrawSlope[styles[i]][size] = slopevec[i][size];
+#endif
+      }
+   }
+}
+
+// EOF
+
@@ -66,6 +66,7 @@ struct spritespan_t
    float side;
 };
 extern spritespan_t **r_spritespan;
+extern float          r_maxspriteside; // largest side of any sprite frame
 
 extern lighttable_t **colormaps;         // killough 3/20/98, 4/4/98
 
@@ -95,6 +96,8 @@ extern seg_t            *segs;
 extern int              numsectors;
 extern sector_t         *sectors;
 extern sectorinterp_t   *sectorinterps;
+extern int              *movedsectors;    // sectors whose heights changed since
+extern int               nummovedsectors; // the last P_SaveSectorPositions
 extern sectorbox_t      *pSectorBoxes;
 
 extern int              numsoundzones;
@@ -106,6 +109,7 @@ extern subsector_t      *subsectors;
 extern int              numnodes;
 extern node_t           *nodes;
 extern fnode_t          *fnodes;
+extern bspnode_t        *bspnodes;
 
 extern int              numlines;
 extern int              numlinesPlusExtra;
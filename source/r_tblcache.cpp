@@ -0,0 +1,143 @@
+//
+// The Eternity Engine
+// Copyright(C) 2026 James Haley, Max Waine, et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+// Additional terms and conditions compatible with the GPLv3 apply. See the
+// file COPYING-EE for details.
+//
+// Purpose: On-disk cache for tables generated from the palette.
+//  Each table is a file in <userpath>/cache named after its kind, a CRC of
+//  the palette and its parameter. The file starts with a header that repeats
+//  the whole palette and parameter, so a CRC collision can never hand back
+//  the wrong table; anything that doesn't match exactly is rebuilt.
+//
+
+#include "z_zone.h"
+
+#include "c_runcmd.h"
+#include "doomstat.h"
+#include "hal/i_directory.h"
+#include "m_hash.h"
+#include "m_qstr.h"
+#include "r_tblcache.h"
+
+// Bump whenever the way any cached table is generated changes
+static constexpr uint32_t TABLECACHE_VERSION = 1;
+
+static constexpr size_t TABLEHEADER_SIZE = 4 + 4 + 4 + 4 + 768;
+
+// Set to false to always rebuild tables, and never write them out
+static bool r_tablecache = true;
+
+//
+// Path of the cache file for a table, creating the cache directory if asked.
+//
+static qstring R_tableCachePath(const char *kind, const byte *palette, uint32_t param,
+                                bool create)
+{
+   qstring dir(userpath);
+   dir /= "cache";
+
+   if(create)
+      I_CreateDirectory(dir);
+
+   const HashData hash(HashData::CRC32, palette, 768);
+   qstring name;
+   name.Printf(0, "%s_%08x_%u.tbl", kind, hash.getDigestPart(0), param);
+
+   return dir / name;
+}
+
+//
+// Builds the header every cache file starts with. Integers are stored
+// little-endian so files don't depend on the host.
+//
+static void R_tableHeader(byte *header, const byte *palette, uint32_t param, size_t size)
+{
+   const uint32_t fields[3] = { TABLECACHE_VERSION, param, uint32_t(size) };
+
+   memcpy(header, "EETC", 4);
+   for(int i = 0; i < 3; i++)
+   {
+      for(int b = 0; b < 4; b++)
+         header[4 + i * 4 + b] = byte(fields[i] >> (b * 8));
+   }
+   memcpy(header + 16, palette, 768);
+}
+
+//
+// Fills dest with a table saved earlier for this palette and parameter.
+// Returns false, leaving dest untouched, if there is no such table.
+//
+bool R_LoadCachedTable(const char *kind, const byte *palette, uint32_t param,
+                       void *dest, size_t size)
+{
+   if(!r_tablecache || !userpath)
+      return false;
+
+   const qstring path = R_tableCachePath(kind, palette, param, false);
+   FILE *f;
+
+   if(!(f = fopen(path.constPtr(), "rb")))
+      return false;
+
+   byte expected[TABLEHEADER_SIZE], header[TABLEHEADER_SIZE];
+   R_tableHeader(expected, palette, param, size);
+
+   byte *data  = emalloc(byte *, size);
+   bool  valid = fread(header, 1, TABLEHEADER_SIZE, f) == TABLEHEADER_SIZE &&
+                 !memcmp(header, expected, TABLEHEADER_SIZE) &&
+                 fread(data, 1, size, f) == size && fgetc(f) == EOF;
+   fclose(f);
+
+   if(valid)
+      memcpy(dest, data, size);
+   efree(data);
+
+   return valid;
+}
+
+//
+// Saves a freshly built table. Failure just means it is built again next time.
+//
+void R_SaveCachedTable(const char *kind, const byte *palette, uint32_t param,
+                       const void *src, size_t size)
+{
+   if(!r_tablecache || !userpath)
+      return;
+
+   const qstring path = R_tableCachePath(kind, palette, param, true);
+   FILE *f;
+
+   if(!(f = fopen(path.constPtr(), "wb")))
+      return;
+
+   byte header[TABLEHEADER_SIZE];
+   R_tableHeader(header, palette, param, size);
+
+   const bool written = fwrite(header, 1, TABLEHEADER_SIZE, f) == TABLEHEADER_SIZE &&
+                        fwrite(src, 1, size, f) == size;
+
+   // Don't leave a truncated table behind
+   if(fclose(f) || !written)
+      remove(path.constPtr());
+}
+
+VARIABLE_TOGGLE(r_tablecache, nullptr, onoff);
+CONSOLE_VARIABLE(r_tablecache, r_tablecache, 0) {}
+
+// EOF
+
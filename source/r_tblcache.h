@@ -0,0 +1,41 @@
+//
+// The Eternity Engine
+// Copyright(C) 2026 James Haley, Max Waine, et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+// Additional terms and conditions compatible with the GPLv3 apply. See the
+// file COPYING-EE for details.
+//
+// Purpose: On-disk cache for tables generated from the palette.
+//  The BOOM translucency maps and the flex translucency color table take
+//  tens of thousands of nearest-color searches to build. Once built they are
+//  kept under the user directory, keyed by the palette and any parameter
+//  that went into them, and read back on later starts.
+//
+
+#ifndef R_TBLCACHE_H__
+#define R_TBLCACHE_H__
+
+#include "doomtype.h"
+
+bool R_LoadCachedTable(const char *kind, const byte *palette, uint32_t param,
+                       void *dest, size_t size);
+void R_SaveCachedTable(const char *kind, const byte *palette, uint32_t param,
+                       const void *src, size_t size);
+
+#endif
+
+// EOF
+
@@ -23,16 +23,25 @@
 //
 //-----------------------------------------------------------------------------
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
 #include "z_zone.h"
 #include "i_system.h"
 
+#include "autopalette.h"
 #include "c_io.h"
+#include "c_runcmd.h"
 #include "doomstat.h"
 #include "d_gi.h"
 #include "d_io.h"
+#include "d_jobs.h"
 #include "d_main.h"
 #include "e_hash.h"
 #include "m_compare.h"
+#include "m_perfstats.h"
 #include "m_swap.h"
 #include "m_utils.h"
 #include "p_setup.h"
@@ -41,6 +50,7 @@
 #include "r_draw.h"
 #include "r_patch.h"
 #include "r_ripple.h"
+#include "r_state.h"
 #include "v_misc.h"
 #include "v_patchfmt.h"
 #include "v_video.h"
@@ -628,33 +638,60 @@ struct tempmask_s
    int        buffermax;  // size of allocated buffer
    byte      *buffer;     // mask buffer.
    texture_t *tex;
-   
-   texcol_t  *tempcols;
-} tempmask = { false, 0, nullptr, nullptr, nullptr };
+} tempmask = { false, 0, nullptr, nullptr };
+
+//
+// Where components are painted while a texture is being built: the pixel
+// buffer and, if the texture's columns are still to be built, the mask of
+// painted pixels. Composition never touches the zone heap or the WAD cache,
+// so it may run on any thread.
+//
+struct texcompose_t
+{
+   texture_t *tex;
+   byte      *data;      // texture pixels
+   byte      *mask;      // nullptr when only the pixels are being rebuilt
+   int        buffermax; // size of data and mask
+};
+
+//
+// Runs of painted pixels found in a mask, column by column. Storage comes from
+// the system heap so that the runs can be found off the main thread.
+//
+struct texruns_t
+{
+   texcol_t *runs;      // every column's runs, back to back
+   int      *colstarts; // index of each column's first run, and one past the last
+   int       maxruns;   // allocated size of runs
+   int       maxcols;   // allocated size of colstarts
+   bool      masked;    // true if the texture has holes
+};
+
+static texruns_t tempruns;
 
 //
 // AddTexColumn
 //
 // Copies from src to the tex buffer and optionally marks the temporary mask
 //
-static void AddTexColumn(texture_t *tex, const byte *src, int srcstep, 
+static void AddTexColumn(const texcompose_t &comp, const byte *src, int srcstep, 
                          int ptroff, int len)
 {
-   byte *dest = tex->bufferdata + ptroff;
+   byte *dest = comp.data + ptroff;
    
 #ifdef RANGECHECK
-   if(ptroff < 0 || ptroff + len > tex->width * tex->height ||
-      ptroff + len > tempmask.buffermax)
+   if(ptroff < 0 || ptroff + len > comp.tex->width * comp.tex->height ||
+      ptroff + len > comp.buffermax)
    {
       I_Error("AddTexColumn(%s) invalid ptroff: %i / (%i, %i)\n", 
-              (const char *)(tex->name), 
-              ptroff + len, tex->width * tex->height, tempmask.buffermax);
+              (const char *)(comp.tex->name), 
+              ptroff + len, comp.tex->width * comp.tex->height, comp.buffermax);
    }
 #endif
 
-   if(tempmask.mask && tex == tempmask.tex)
+   if(comp.mask)
    {
-      byte *mask = tempmask.buffer + ptroff;
+      byte *mask = comp.mask + ptroff;
       
       while(len > 0)
       {
@@ -681,9 +718,10 @@ static void AddTexColumn(texture_t *tex, const byte *src, int srcstep,
 // 
 // Paints the given flat-based component to the texture and marks mask info
 //
-static void AddTexFlat(texture_t *tex, tcomponent_t *component)
+static void AddTexFlat(const texcompose_t &comp, const tcomponent_t *component,
+                       const byte *src)
 {
-   byte      *src = (byte *)(wGlobalDir.cacheLumpNum(component->lump, PU_CACHE));
+   texture_t *tex = comp.tex;
    int       destoff, srcoff, deststep, srcxstep, srcystep;
    int       xstart, ystart, xstop, ystop;
    int       width, height, wcount, hcount;
@@ -743,7 +781,7 @@ static void AddTexFlat(texture_t *tex, tcomponent_t *component)
          I_Error("AddTexFlat(%s): Invalid srcoff %i / %i\n", 
                  (const char *)(tex->name), srcoff, tex->width * tex->height);
 #endif
-      AddTexColumn(tex, src + srcoff, srcystep, destoff, hcount);
+      AddTexColumn(comp, src + srcoff, srcystep, destoff, hcount);
       srcoff += srcxstep;
       destoff += deststep;
       wcount--;
@@ -755,9 +793,10 @@ static void AddTexFlat(texture_t *tex, tcomponent_t *component)
 // 
 // Paints the given flat-based component to the texture and marks mask info
 //
-static void AddTexPatch(texture_t *tex, tcomponent_t *component)
+static void AddTexPatch(const texcompose_t &comp, const tcomponent_t *component,
+                        const patch_t *patch)
 {
-   patch_t *patch = PatchLoader::CacheNum(wGlobalDir, component->lump, PU_CACHE);
+   texture_t *tex = comp.tex;
    int      destoff;
    int      xstart, ystart, xstop;
    int      colindex, colstep;
@@ -789,7 +828,7 @@ static void AddTexPatch(texture_t *tex, tcomponent_t *component)
    {
       int top, y1, y2, destbase;
       const column_t *column = 
-         (const column_t *)((byte *)patch + patch->columnofs[colindex]);
+         (const column_t *)((const byte *)patch + patch->columnofs[colindex]);
          
       destbase = x * tex->height;
       top = 0;
@@ -835,13 +874,56 @@ static void AddTexPatch(texture_t *tex, tcomponent_t *component)
 #endif
             
          if(y2 - y1 > 0)
-            AddTexColumn(tex, src + srcoff, 1, destoff, y2 - y1);
+            AddTexColumn(comp, src + srcoff, 1, destoff, y2 - y1);
             
          column = reinterpret_cast<const column_t *>(src + column->length + 1);
       }
    }
 }
 
+//
+// Paints every component of comp.tex. source(i) returns the cached lump data
+// of component i.
+//
+template<typename S>
+static void R_composeTexture(const texcompose_t &comp, S &&source)
+{
+   const texture_t *tex = comp.tex;
+
+   // Add the components to the buffer/mask
+   for(int i = 0; i < tex->ccount; i++)
+   {
+      const tcomponent_t *component = tex->components + i;
+      
+      // SoM: Do NOT add lumps with a -1 lumpnum
+      if(component->lump == -1)
+         continue;
+         
+      switch(component->type)
+      {
+      case TC_FLAT:
+         AddTexFlat(comp, component, static_cast<const byte *>(source(i)));
+         break;
+      case TC_PATCH:
+         AddTexPatch(comp, component, static_cast<const patch_t *>(source(i)));
+         break;
+      default:
+         break;
+      }
+   }
+}
+
+//
+// Caches the lump a component is painted from.
+//
+static const void *R_cacheComponent(const tcomponent_t &component, int tag)
+{
+   if(component.type == TC_PATCH)
+      return PatchLoader::CacheNum(wGlobalDir, component.lump, tag);
+   else
+      return wGlobalDir.cacheLumpNum(component.lump, tag);
+}
+
 //
 // StartTexture
 //
@@ -878,32 +960,81 @@ static void StartTexture(texture_t *tex, bool mask)
 }
 
 //
-// NextTempCol
-//
-// Returns either the next element in the chain or a new element which is
-// then added to the chain.
+// Finds the runs of painted pixels in every column of a texture's mask.
+// Safe to call from any thread.
 //
-static texcol_t *NextTempCol(texcol_t *current)
+static void R_findTextureRuns(const texture_t *tex, const byte *mask, texruns_t &out)
 {
-   if(!current)
+   const byte *maskp = mask;
+   int         numruns = 0;
+
+   if(tex->width + 1 > out.maxcols)
    {
-      if(!tempmask.tempcols)
-         return tempmask.tempcols = estructalloc(texcol_t, 1);
-      else
-         return tempmask.tempcols;
+      out.maxcols   = tex->width + 1;
+      out.colstarts = static_cast<int *>(Z_SysRealloc(out.colstarts, out.maxcols * sizeof(int)));
    }
-   
-   if(!current->next)
-      return current->next = estructalloc(texcol_t, 1);
-   
-   return current->next;
+
+   out.masked = false;
+
+   for(int x = 0; x < tex->width; x++)
+   {
+      int y = 0;
+
+      out.colstarts[x] = numruns;
+      
+      while(y < tex->height)
+      {
+         // Skip transparent pixels
+         while(y < tex->height && !*maskp)
+         {
+            maskp++;
+            y++;
+            out.masked = true;
+         }
+         
+         // Build a column
+         if(y < tex->height && *maskp > 0)
+         {
+            if(numruns == out.maxruns)
+            {
+               out.maxruns = out.maxruns ? out.maxruns * 2 : 256;
+               out.runs    = static_cast<texcol_t *>(Z_SysRealloc(out.runs,
+                                                      out.maxruns * sizeof(texcol_t)));
+            }
+
+            texcol_t *col = &out.runs[numruns++];
+            
+            col->yoff = y;
+            col->ptroff = uint32_t(maskp - mask);
+            
+            while(y < tex->height && *maskp > 0)
+            {
+               maskp++; y++;
+            }
+            
+            col->len = y - col->yoff;
+         }
+      }
+   }
+
+   out.colstarts[tex->width] = numruns;
+}
+
+//
+// Frees the storage of a set of runs.
+//
+static void R_freeTextureRuns(texruns_t &runs)
+{
+   Z_SysFree(runs.runs);
+   Z_SysFree(runs.colstarts);
+   runs = texruns_t();
 }
 
 //
 // Appends alpha mask to the buffer (by reallocating it as necessary). Needed for masked texture
 // portal overlays (visplanes)
 //
-static void R_appendAlphaMask(texture_t *tex)
+static void R_appendAlphaMask(texture_t *tex, const byte *mask)
 {
    int size = tex->width * tex->height;
    // Add space for the mask
@@ -911,7 +1042,7 @@ static void R_appendAlphaMask(texture_t *tex)
                                        (void**)&tex->bufferalloc);
    tex->bufferdata = tex->bufferalloc + 8;
 
-   const byte *tempmaskp = tempmask.buffer;
+   const byte *tempmaskp = mask;
    byte *maskplane = tex->bufferdata + size;
    memset(maskplane, 0, (size + 7) / 8);
 
@@ -929,68 +1060,19 @@ static void R_appendAlphaMask(texture_t *tex)
 }
 
 //
-// FinishTexture
-//
-// Called after R_CacheTexture is finished drawing a texture. This function
-// builds the columns (if needed) of a texture from the temporary mask buffer.
+// Allocates a texture's column structs from the runs found in its mask, and
+// appends the alpha mask if it has holes. Main thread only.
 //
-static void FinishTexture(texture_t *tex)
+static void R_buildTextureColumns(texture_t *tex, const texruns_t &runs, const byte *mask)
 {
-   int        x, y, i, colcount;
-   texcol_t   *col, *tcol;
-   const byte *maskp;
-
-   if(!tempmask.mask)
-      return;
-      
-   if(tempmask.tex != tex)
-   {
-      // SoM: ERROR?
-      return;
-   }
-   
    // Allocate column pointers
    tex->columns = ecalloctag(texcol_t **, sizeof(texcol_t *), tex->width, PU_RENDERER, nullptr);
-   
-   // Build the columns based on mask info
-   maskp = tempmask.buffer;
 
-   bool masked = false; // true if texture has holes (more processing needed for portal overlays)
-
-   for(x = 0; x < tex->width; x++)
+   for(int x = 0; x < tex->width; x++)
    {
-      y = 0;
-      col = nullptr;
-      colcount = 0;
-      
-      while(y < tex->height)
-      {
-         // Skip transparent pixels
-         while(y < tex->height && !*maskp)
-         {
-            maskp++;
-            y++;
-            masked = true;
-         }
-         
-         // Build a column
-         if(y < tex->height && *maskp > 0)
-         {
-            colcount++;
-            col = NextTempCol(col);
-            
-            col->yoff = y;
-            col->ptroff = uint32_t(maskp - tempmask.buffer);
-            
-            while(y < tex->height && *maskp > 0)
-            {
-               maskp++; y++;
-            }
-            
-            col->len = y - col->yoff;
-         }
-      }
-      
+      const int first    = runs.colstarts[x];
+      const int colcount = runs.colstarts[x + 1] - first;
+
       // No columns? No problem!
       if(!colcount)
       {
@@ -999,149 +1081,1094 @@ static void FinishTexture(texture_t *tex)
       }
          
       // Now allocate and build the actual column structs in the texture
-      tcol = tex->columns[x] = estructalloctag(texcol_t, colcount, PU_RENDERER);
+      texcol_t *tcol = tex->columns[x] = estructalloctag(texcol_t, colcount, PU_RENDERER);
            
-      col = nullptr;
-      for(i = 0; i < colcount; i++)
+      for(int i = 0; i < colcount; i++)
       {
-         col = NextTempCol(col);
-         memcpy(tcol, col, sizeof(texcol_t));
+         memcpy(tcol, &runs.runs[first + i], sizeof(texcol_t));
          
          tcol->next = i + 1 < colcount ? tcol + 1 : nullptr;
          tcol = tcol->next;
       }
    }
 
-   if(masked)
-      R_appendAlphaMask(tex);
+   if(runs.masked)
+      R_appendAlphaMask(tex, mask);
 }
 
 //
-// R_CacheTexture
-// 
-// Caches a texture in memory, building it from component parts.
+// FinishTexture
 //
-texture_t *R_CacheTexture(int num)
+// Called after R_CacheTexture is finished drawing a texture. This function
+// builds the columns (if needed) of a texture from the temporary mask buffer.
+//
+static void FinishTexture(texture_t *tex)
 {
-   texture_t  *tex;
-   int        i;
-   
-#ifdef RANGECHECK
-   if(num < 0 || num >= texturecount)
-      I_Error("R_CacheTexture: invalid texture num %i\n", num);
-#endif
-
-   tex = textures[num];
-   if(tex->bufferalloc)
-      return tex;
-   
-   // SoM: This situation would most certainly require an abort.
-   if(tex->ccount == 0)
+   if(!tempmask.mask)
+      return;
+      
+   if(tempmask.tex != tex)
    {
-      I_Error("R_CacheTexture: texture %s cached with no buffer and no components.\n",
-              (const char *)(tex->name));
+      // SoM: ERROR?
+      return;
    }
 
-   // This function has two primary branches:
-   // 1. There is no buffer, and there are no columns which means the texture
-   //    has never been built before and needs a full treatment
-   // 2. There is no buffer, but there are columns which means that the buffer
-   //    (PU_CACHE) has been freed but the columns (PU_RENDERER) have not. 
-   //    This case means we only have to rebuilt the buffer.
-
-   // Start the texture. Check the size of the mask buffer if needed.   
-   StartTexture(tex, tex->columns == nullptr);
-   
-   // Add the components to the buffer/mask
-   for(i = 0; i < tex->ccount; i++)
+   // Rebuilding a buffer whose columns already exist only needs the alpha mask
+   if(tex->columns)
    {
-      tcomponent_t *component = tex->components + i;
-      
-      // SoM: Do NOT add lumps with a -1 lumpnum
-      if(component->lump == -1)
-         continue;
-         
-      switch(component->type)
-      {
-      case TC_FLAT:
-         AddTexFlat(tex, component);
-         break;
-      case TC_PATCH:
-         AddTexPatch(tex, component);
-         break;
-      default:
-         break;
-      }
+      R_appendAlphaMask(tex, tempmask.buffer);
+      return;
    }
 
-   // Finish texture
-   FinishTexture(tex);
-   Z_ChangeTag(tex->bufferalloc, PU_CACHE);
-
-   return tex;
+   R_findTextureRuns(tex, tempmask.buffer, tempruns);
+   R_buildTextureColumns(tex, tempruns, tempmask.buffer);
 }
 
+//=============================================================================
 //
-// R_checkerBoardTexture
+// Mip levels
 //
-// Fill in a 64x64 texture with a checkerboard pattern.
+// With r_mipmap on, each solid power-of-two texture gets up to R_MAXMIPLEVELS
+// smaller copies when it is composed, each texel the palette colour nearest
+// the average of the 2x2 texels above it. Walls and flats far enough away
+// for their texels to land two or more pixels apart are drawn from the level
+// that brings them back to about one, which touches far less memory and
+// shimmers less. A texture composes the same every time, so its levels are
+// kept until the zone purges them or the texture is evicted.
 //
-static void R_checkerBoardTexture(texture_t *tex)
-{
-   // allocate buffer (also allow some slack space _after_ the buffer)
-   tex->bufferalloc = emalloctag(byte *, 64*64 + 16, PU_RENDERER, nullptr);
-   tex->bufferdata = tex->bufferalloc + 8;
-
-   // allocate column pointers
-   tex->columns = ecalloctag(texcol_t **, sizeof(texcol_t *), tex->width, 
-                             PU_RENDERER, nullptr);
 
-   // make columns
-   for(int i = 0; i < tex->width; i++)
-   {
-      tex->columns[i] = estructalloctag(texcol_t, 1, PU_RENDERER);
-      tex->columns[i]->next = nullptr;
-      tex->columns[i]->yoff = 0;
-      tex->columns[i]->len = tex->height;
-      tex->columns[i]->ptroff = i * tex->height;
-   }
-   
-   // fill pixels
-   byte c1 = GameModeInfo->whiteIndex;
-   byte c2 = GameModeInfo->blackIndex;
-   for(int i = 0; i < 4096; i++)
-      tex->bufferdata[i] = ((i & 8) == 8) != ((i & 512) == 512) ? c1 : c2;
-}
+bool r_mipmap;
 
 //
-// R_MakeDummyTexture
-//
-// haleyjd 06/20/14: creates a dummy texture in textures[0] if there are no
-// textures defined via TEXTURE1/2 lumps, to prevent problems with mods making
-// exclusive use of the ns_textures namespace.
+// Bytes allocated for the given number of levels, with padding either side.
 //
-static void R_MakeDummyTexture()
+static uint32_t R_mipLevelsSize(const texture_t *tex, int levels)
 {
-   textures[0] = R_AllocTexStruct("-BADTEX-", 64, 64, 0);
-   R_checkerBoardTexture(textures[0]);
+   uint32_t size = 16;
+
+   for(int level = 1; level <= levels; level++)
+      size += uint32_t(tex->width >> level) * uint32_t(tex->height >> level);
+
+   return size;
 }
 
 //
-// R_MakeMissingTexture
-//
-// Creates a checkerboard texture to fill in for unknown textures.
+// Builds the mip levels of a texture whose buffer has just been composed,
+// while the buffer is still PU_STATIC.
 //
-static void R_MakeMissingTexture(int count)
+static void R_buildMipLevels(texture_t *tex)
 {
-   if(count >= texturecount)
-   {
-      usermsg("R_MakeMissingTexture: count >= texturecount\n");
+   static VInversePalette inverse;
+
+   if(!r_mipmap || tex->mipdata || tex->flags & (TF_MASKED | TF_SWIRLY))
+      return;
+
+   // Column wrapping and the span drawers both need powers of two
+   if(tex->width & (tex->width - 1) || tex->height & (tex->height - 1))
       return;
+
+   int levels = 0;
+   while(levels < R_MAXMIPLEVELS && tex->width >> (levels + 1) >= 2 &&
+         tex->height >> (levels + 1) >= 2)
+      ++levels;
+
+   if(!levels)
+      return;
+
+   AutoPalette pal(wGlobalDir);
+   const byte *palette = pal.get();
+
+   inverse.setPalette(palette);
+   Z_Malloc(R_mipLevelsSize(tex, levels), PU_STATIC, (void **)&tex->mipdata);
+
+   const byte *src  = tex->bufferdata;
+   byte       *dest = tex->mipdata + 8;
+   int         w    = tex->width;
+   int         h    = tex->height;
+
+   for(int level = 1; level <= levels; level++)
+   {
+      const int mw = w / 2, mh = h / 2;
+
+      for(int x = 0; x < mw; x++)
+      {
+         const byte *col1 = src + 2 * x * h;
+         const byte *col2 = col1 + h;
+
+         for(int y = 0; y < mh; y++)
+         {
+            const byte *c1 = palette + col1[2 * y] * 3;
+            const byte *c2 = palette + col1[2 * y + 1] * 3;
+            const byte *c3 = palette + col2[2 * y] * 3;
+            const byte *c4 = palette + col2[2 * y + 1] * 3;
+
+            dest[x * mh + y] = inverse.nearest((c1[0] + c2[0] + c3[0] + c4[0] + 2) >> 2,
+                                               (c1[1] + c2[1] + c3[1] + c4[1] + 2) >> 2,
+                                               (c1[2] + c2[2] + c3[2] + c4[2] + 2) >> 2);
+         }
+      }
+
+      src   = dest;
+      dest += mw * mh;
+      w     = mw;
+      h     = mh;
    }
-   
-   badtex = count;
-   textures[badtex] = R_AllocTexStruct("BAADF00D", 64, 64, 0);
-   R_checkerBoardTexture(textures[badtex]);   
+
+   tex->nummips = levels;
+   Z_ChangeTag(tex->mipdata, PU_CACHE);
+}
+
+//
+// Linear buffer of mip level 1 or higher of a texture.
+//
+const byte *R_GetMipLevel(const texture_t *tex, int level)
+{
+   if(!tex->mipdata || level < 1 || level > tex->nummips)
+      return nullptr;
+
+   return tex->mipdata + R_mipLevelsSize(tex, level - 1) - 8;
+}
+
+//=============================================================================
+//
+// Texture residency
+//
+// Every composed buffer is kept on a resident list and its size accounted.
+// Accesses stamp the texture with the current texture frame. When the total
+// goes over r_texturebudget, R_StartTextureFrame frees the buffers that have
+// gone longest unused, never touching anything used in the current or
+// previous frame, so the budget is a target rather than a hard limit. Evicted
+// textures keep their columns and are recomposed on their next access.
+//
+
+int r_texturebudget = 0;
+
+static DLListItem<texture_t> *residenttextures;
+static size_t                 residentbytes;
+static int                    numresident;
+
+// Starts at 1 so that textures never accessed look older than any frame
+static uint32_t texframe = 1;
+
+static uint64_t texturehits, texturemisses, textureevictions;
+
+static PerfGauge   residentstat("texture.resident", "KiB", [] {
+   return double(residentbytes) / 1024;
+});
+static PerfCounter hitsstat("texture.hits", "", [] { return double(texturehits); });
+static PerfCounter missesstat("texture.misses", "", [] { return double(texturemisses); });
+static PerfCounter evictionsstat("texture.evictions", "", [] {
+   return double(textureevictions);
+});
+
+//
+// Records an access to a texture, counting a hit or a miss on its first
+// access each frame.
+//
+static inline void R_touchTexture(texture_t *tex)
+{
+   if(tex->usedframe != texframe)
+   {
+      tex->usedframe = texframe;
+      if(tex->bufferalloc)
+         ++texturehits;
+      else
+         ++texturemisses;
+   }
+}
+
+//
+// Accounts for a texture's freshly composed buffer.
+//
+static void R_markResident(texture_t *tex)
+{
+   // Matches the allocations of StartTexture and R_appendAlphaMask
+   const uint32_t texels = uint32_t(tex->width * tex->height);
+   uint32_t size = tex->flags & TF_MASKED ? 8 + texels + (texels + 7) / 8 + 4 :
+                                            texels + 12;
+
+   if(tex->mipdata)
+      size += R_mipLevelsSize(tex, tex->nummips);
+
+   if(tex->residentsize)
+      residentbytes -= tex->residentsize;
+   else
+   {
+      tex->residentlink.insert(tex, &residenttextures);
+      ++numresident;
+   }
+
+   tex->residentsize = size;
+   residentbytes    += size;
+}
+
+//
+// Stops accounting for a texture whose buffer is gone.
+//
+static void R_unmarkResident(texture_t *tex)
+{
+   tex->residentlink.remove();
+   residentbytes    -= tex->residentsize;
+   tex->residentsize = 0;
+   --numresident;
+}
+
+//
+// Sprite mip levels
+//
+// With r_spritemip on, a sprite frame drawn small enough for its texels to
+// land two or more pixels apart is drawn from a copy shrunk by the matching
+// power of two, so distant hi-res sprites read a fraction of the memory. Each
+// texel of a copy is opaque if at least half the texels it covers are, and
+// takes the palette colour nearest their average. Render contexts draw
+// sprites, so copies are built under a lock from the system heap the first
+// time they are wanted. They are accounted alongside the composed textures
+// and evicted by the same rule.
+//
+
+bool r_spritemip;
+
+struct spritemip_t
+{
+   DLListItem<spritemip_t> residentlink;
+   patch_t                *patch;
+   int                     slot;      // index into spritemips
+   uint32_t                size;
+   std::atomic<uint32_t>   usedframe;
+};
+
+static std::atomic<spritemip_t *> *spritemips;    // numspritemipslots * R_MAXSPRITEMIPS
+static int                         numspritemipslots;
+static std::mutex                  spritemiplock;
+static DLListItem<spritemip_t>    *residentspritemips;
+static size_t                      spritemipbytes;
+static int                         numspritemips;
+static uint64_t                    spritemipbuilds, spritemipevictions;
+
+// Palette the levels are made in, set up with the table
+static byte            spritemippal[768];
+static VInversePalette spritemipinverse;
+
+//
+// Frees a sprite mip level and stops accounting for it.
+//
+static void R_freeSpriteMip(spritemip_t *mip)
+{
+   mip->residentlink.remove();
+   spritemipbytes -= mip->size;
+   --numspritemips;
+   Z_SysFree(mip->patch);
+   delete mip;
+}
+
+//
+// Frees every sprite mip level and the table of them.
+//
+static void R_freeSpriteMips()
+{
+   std::lock_guard<std::mutex> lock(spritemiplock);
+
+   for(int i = 0; i < numspritemipslots * R_MAXSPRITEMIPS; i++)
+   {
+      if(spritemip_t *mip = spritemips[i].load(std::memory_order_relaxed))
+      {
+         spritemips[i].store(nullptr, std::memory_order_relaxed);
+         R_freeSpriteMip(mip);
+      }
+   }
+
+   delete [] spritemips;
+   spritemips        = nullptr;
+   numspritemipslots = 0;
+}
+
+//
+// Appends a post starting at the given row. Rows past 254 are reached with
+// DeePsea's offsets relative to the previous post, stepping there through
+// empty posts when one offset can't cover the distance.
+//
+static byte *R_putSpriteMipPost(byte *out, int row, int &top)
+{
+   while(row > 254 && row - top > emin(top, 254))
+   {
+      // 254 is absolute below row 254 and relative from there on
+      *out++ = 254;
+      *out++ = 0;
+      *out++ = 0;
+      *out++ = 0;
+      top = top < 254 ? 254 : top + 254;
+   }
+
+   *out++ = byte(row > 254 ? row - top : row);
+   top    = row;
+   return out;
+}
+
+//
+// Shrinks a sprite patch by 2^level into a new patch on the system heap.
+// Called with the sprite mip lock held.
+//
+static spritemip_t *R_buildSpriteMip(const patch_t *patch, int level)
+{
+   const int w = patch->width, h = patch->height;
+   const int f = 1 << level;
+   const int mw = (w + f - 1) >> level, mh = (h + f - 1) >> level;
+
+   const byte *palette = spritemippal;
+
+   // Unpack the source into sums of opaque texel colours per mip texel
+   const size_t mtexels = size_t(mw) * mh;
+   uint32_t *sums   = static_cast<uint32_t *>(Z_SysCalloc(mtexels * 4, sizeof(uint32_t)));
+   uint32_t *counts = sums + mtexels * 3;
+
+   for(int x = 0; x < w; x++)
+   {
+      const column_t *col = reinterpret_cast<const column_t *>(
+         reinterpret_cast<const byte *>(patch) + patch->columnofs[x]);
+      int top = 0;
+
+      while(col->topdelta != 0xff)
+      {
+         top = col->topdelta <= top ? col->topdelta + top : col->topdelta;
+
+         const byte *src = reinterpret_cast<const byte *>(col) + 3;
+         for(int y = top; y < top + col->length && y < h; y++)
+         {
+            const size_t  i = size_t(x >> level) * mh + (y >> level);
+            const byte   *c = palette + src[y - top] * 3;
+
+            sums[i * 3]     += c[0];
+            sums[i * 3 + 1] += c[1];
+            sums[i * 3 + 2] += c[2];
+            ++counts[i];
+         }
+
+         col = reinterpret_cast<const column_t *>(
+            reinterpret_cast<const byte *>(col) + col->length + 4);
+      }
+   }
+
+   // Every post costs four bytes over its texels, empty posts to reach tall
+   // rows included, and the runs of a column can't outnumber its texels
+   const size_t colmax = size_t(mh) * 5 + (mh / 254 + 2) * 4 + 1;
+   const size_t maxsize = 8 + 4 * size_t(mw) + colmax * mw;
+   byte *data = static_cast<byte *>(Z_SysMalloc(maxsize));
+
+   patch_t *mpatch    = reinterpret_cast<patch_t *>(data);
+   mpatch->width      = int16_t(mw);
+   mpatch->height     = int16_t(mh);
+   mpatch->leftoffset = int16_t(patch->leftoffset >> level);
+   mpatch->topoffset  = int16_t(patch->topoffset >> level);
+
+   byte *out = data + 8 + 4 * mw;
+   for(int x = 0; x < mw; x++)
+   {
+      mpatch->columnofs[x] = int32_t(out - data);
+
+      const uint32_t *csum   = sums + size_t(x) * mh * 3;
+      const uint32_t *ccount = counts + size_t(x) * mh;
+      const int       cw     = emin(f, w - (x << level));
+      int             top    = 0;
+
+      for(int y = 0; y < mh; )
+      {
+         // A mip texel is opaque if at least half of what it covers is
+         auto opaque = [&](int row) {
+            const int area = cw * emin(f, h - (row << level));
+            return ccount[row] * 2 >= uint32_t(area) && ccount[row];
+         };
+
+         if(!opaque(y))
+         {
+            y++;
+            continue;
+         }
+
+         int len = 1;
+         while(y + len < mh && len < 255 && opaque(y + len))
+            len++;
+
+         out = R_putSpriteMipPost(out, y, top);
+         *out++ = byte(len);
+         byte *pad = out++;
+         for(int i = y; i < y + len; i++)
+         {
+            const uint32_t n = ccount[i];
+            *out++ = spritemipinverse.nearest((csum[i * 3]     + n / 2) / n,
+                                     (csum[i * 3 + 1] + n / 2) / n,
+                                     (csum[i * 3 + 2] + n / 2) / n);
+         }
+         // The drawers may read a texel past either end of a post
+         *pad   = pad[1];
+         *out   = out[-1];
+         out++;
+
+         y += len;
+      }
+      *out++ = 0xff;
+   }
+
+   Z_SysFree(sums);
+
+   spritemip_t *mip = new spritemip_t;
+   mip->size  = uint32_t(out - data);
+   mip->patch = static_cast<patch_t *>(Z_SysRealloc(data, mip->size));
+   mip->usedframe.store(texframe, std::memory_order_relaxed);
+   return mip;
+}
+
+//
+// Returns the given level of a sprite patch, building it if need be, or
+// nullptr if it would be too small to be worth having. The lump is relative
+// to firstspritelump and the patch is its cached data.
+//
+const patch_t *R_GetSpriteMip(int lump, const patch_t *patch, int level)
+{
+   if(level < 1 || level > R_MAXSPRITEMIPS || lump < 0 || lump >= numspritemipslots ||
+      patch->width >> level < 2 || patch->height >> level < 2)
+      return nullptr;
+
+   const int index = lump * R_MAXSPRITEMIPS + level - 1;
+   std::atomic<spritemip_t *> &slot = spritemips[index];
+   spritemip_t *mip = slot.load(std::memory_order_acquire);
+
+   if(!mip)
+   {
+      std::lock_guard<std::mutex> lock(spritemiplock);
+
+      if(!(mip = slot.load(std::memory_order_relaxed)))
+      {
+         mip = R_buildSpriteMip(patch, level);
+         mip->slot = index;
+         mip->residentlink.insert(mip, &residentspritemips);
+         spritemipbytes += mip->size;
+         ++numspritemips;
+         ++spritemipbuilds;
+         slot.store(mip, std::memory_order_release);
+      }
+   }
+
+   if(mip->usedframe.load(std::memory_order_relaxed) != texframe)
+      mip->usedframe.store(texframe, std::memory_order_relaxed);
+
+   return mip->patch;
+}
+
+//
+// Makes the sprite mip table for the current sprite lumps, between frames.
+//
+static void R_initSpriteMips()
+{
+   if(!r_spritemip || numspritemipslots == numspritelumps)
+      return;
+
+   R_freeSpriteMips();
+
+   AutoPalette pal(wGlobalDir);
+   memcpy(spritemippal, pal.get(), sizeof(spritemippal));
+   spritemipinverse.setPalette(spritemippal);
+
+   spritemips        = new std::atomic<spritemip_t *>[numspritelumps * R_MAXSPRITEMIPS]();
+   numspritemipslots = numspritelumps;
+}
+
+//
+// Evicts a sprite mip level.
+//
+static void R_evictSpriteMip(spritemip_t *mip)
+{
+   spritemips[mip->slot].store(nullptr, std::memory_order_relaxed);
+   R_freeSpriteMip(mip);
+   ++spritemipevictions;
+}
+
+//
+// Orders eviction candidates from least to most recently used.
+//
+static bool R_usedEarlier(const texture_t *a, const texture_t *b)
+{
+   return a->usedframe != b->usedframe ? a->usedframe < b->usedframe : a->index < b->index;
+}
+
+//
+// Frees cold buffers until the resident total is back under budget.
+//
+static void R_evictTextures()
+{
+   static texture_t **candidates;
+   static int         maxcandidates;
+
+   static spritemip_t **mipcandidates;
+   static int           maxmipcandidates;
+
+   const size_t budget = size_t(r_texturebudget) << 20;
+
+   if(!budget || residentbytes + spritemipbytes <= budget)
+      return;
+
+   if(numresident > maxcandidates)
+   {
+      maxcandidates = numresident;
+      candidates    = erealloc(texture_t **, candidates, maxcandidates * sizeof(texture_t *));
+   }
+
+   int numcandidates = 0;
+   for(DLListItem<texture_t> *item = residenttextures; item; )
+   {
+      texture_t *tex = item->dllObject;
+      item = item->dllNext;
+
+      // The zone may have purged a PU_CACHE buffer by itself
+      if(!tex->bufferalloc)
+         R_unmarkResident(tex);
+      else if(tex->usedframe + 1 < texframe)
+         candidates[numcandidates++] = tex;
+   }
+
+   if(numspritemips > maxmipcandidates)
+   {
+      maxmipcandidates = numspritemips;
+      mipcandidates    = erealloc(spritemip_t **, mipcandidates,
+                                  maxmipcandidates * sizeof(spritemip_t *));
+   }
+
+   int nummipcandidates = 0;
+   for(DLListItem<spritemip_t> *item = residentspritemips; item; item = item->dllNext)
+   {
+      if(item->dllObject->usedframe.load(std::memory_order_relaxed) + 1 < texframe)
+         mipcandidates[nummipcandidates++] = item->dllObject;
+   }
+
+   std::sort(candidates, candidates + numcandidates, R_usedEarlier);
+   std::sort(mipcandidates, mipcandidates + nummipcandidates,
+             [](const spritemip_t *a, const spritemip_t *b) {
+      return a->usedframe.load(std::memory_order_relaxed) <
+             b->usedframe.load(std::memory_order_relaxed);
+   });
+
+   // Merge the two lists, oldest first, textures winning ties
+   int i = 0, j = 0;
+   while(residentbytes + spritemipbytes > budget && (i < numcandidates || j < nummipcandidates))
+   {
+      if(j < nummipcandidates &&
+         (i == numcandidates || mipcandidates[j]->usedframe.load(std::memory_order_relaxed) <
+                                candidates[i]->usedframe))
+      {
+         R_evictSpriteMip(mipcandidates[j++]);
+         continue;
+      }
+
+      texture_t *tex = candidates[i++];
+
+      R_unmarkResident(tex);
+      efree(tex->bufferalloc);
+      tex->bufferdata = nullptr;
+      if(tex->mipdata)
+         efree(tex->mipdata);
+      ++textureevictions;
+   }
+}
+
+VARIABLE_INT(r_texturebudget, nullptr, 0, 4096, nullptr);
+CONSOLE_VARIABLE(r_texturebudget, r_texturebudget, 0) {}
+
+CONSOLE_COMMAND(r_texturestats, 0)
+{
+   if(Console.argc >= 1 && !Console.argv[0]->strCaseCmp("reset"))
+   {
+      texturehits = texturemisses = textureevictions = 0;
+      spritemipbuilds = spritemipevictions = 0;
+      return;
+   }
+
+   C_Printf(FC_HI "Texture cache:\n" FC_NORMAL
+            "  resident:  %d textures, %u KiB\n"
+            "  budget:    %d MiB%s\n"
+            "  hits:      %llu\n"
+            "  misses:    %llu\n"
+            "  evictions: %llu\n"
+            "  sprite mips: %d, %u KiB, %llu built, %llu evicted\n",
+            numresident, unsigned(residentbytes >> 10),
+            r_texturebudget, r_texturebudget ? "" : " (unlimited)",
+            (unsigned long long)texturehits, (unsigned long long)texturemisses,
+            (unsigned long long)textureevictions,
+            numspritemips, unsigned(spritemipbytes >> 10),
+            (unsigned long long)spritemipbuilds, (unsigned long long)spritemipevictions);
+}
+
+//
+// Builds or drops the levels of every composed texture as r_mipmap changes.
+//
+static void R_updateMipLevels()
+{
+   for(int i = 0; i < texturecount; i++)
+   {
+      texture_t *tex = textures[i];
+
+      if(!tex)
+         continue;
+
+      if(!r_mipmap)
+      {
+         if(tex->mipdata)
+            Z_Free(tex->mipdata);
+      }
+      else if(tex->bufferalloc && !tex->mipdata)
+      {
+         const int tag = Z_CheckTag(tex->bufferalloc);
+
+         Z_ChangeTag(tex->bufferalloc, PU_STATIC);
+         R_buildMipLevels(tex);
+         Z_ChangeTag(tex->bufferalloc, tag);
+      }
+
+      if(tex->residentsize)
+         R_markResident(tex);
+   }
+}
+
+VARIABLE_TOGGLE(r_mipmap, nullptr, onoff);
+CONSOLE_VARIABLE(r_mipmap, r_mipmap, 0)
+{
+   R_updateMipLevels();
+}
+
+VARIABLE_TOGGLE(r_spritemip, nullptr, onoff);
+CONSOLE_VARIABLE(r_spritemip, r_spritemip, 0)
+{
+   if(!r_spritemip)
+      R_freeSpriteMips();
+}
+
+//=============================================================================
+//
+// Background precaching
+//
+// R_PrecacheTextures queues a low priority job per texture on the engine's
+// job workers, which paint it and find its column runs. Every lump they read
+// is locked PU_STATIC beforehand, and each texture's buffer belongs to its
+// job until the main thread publishes it, either when R_CacheTexture first
+// asks for the texture or when the job hands it back with D_RunOnMainThread.
+// Until then bufferalloc stays null, so the renderer can never see a
+// half-built texture.
+//
+
+enum
+{
+   JOB_QUEUED,   // waiting for a worker
+   JOB_RUNNING,  // being composed
+   JOB_DONE,     // composed, waiting to be published
+   JOB_FINISHED, // published
+};
+
+struct texturejob_t
+{
+   texture_t       *tex;
+   int              texnum;
+   byte            *bufferalloc; // zone block owned by the job until published
+   byte            *mask;        // system heap, if the columns are to be built
+   const void     **sources;     // locked lump of each component
+   texruns_t        runs;
+   std::atomic_int  state;
+   JobHandle        handle;
+};
+
+// A lump raised to PU_STATIC for the duration of the precache
+struct lockedlump_t
+{
+   void *data;
+   int   tag;
+};
+
+static texturejob_t *texturejobs;
+static int           numtexturejobs;
+static int           numunfinishedjobs;
+static int          *jobfortexture;    // index in texturejobs, or -1
+static unsigned      precachegeneration; // tells one precache's handbacks from the next
+
+static lockedlump_t *lockedlumps;
+static int           numlockedlumps;
+static int           maxlockedlumps;
+
+static std::mutex              precachelock;
+static std::condition_variable precachedone;
+
+//
+// Caches a component's lump for a job, keeping it resident until the whole
+// precache is over.
+//
+static const void *R_lockComponent(const tcomponent_t &component)
+{
+   void *data = const_cast<void *>(R_cacheComponent(component, PU_CACHE));
+   const int tag = Z_CheckTag(data);
+
+   if(tag >= PU_PURGELEVEL)
+   {
+      if(numlockedlumps == maxlockedlumps)
+      {
+         maxlockedlumps = maxlockedlumps ? maxlockedlumps * 2 : 256;
+         lockedlumps = erealloc(lockedlump_t *, lockedlumps, maxlockedlumps * sizeof(lockedlump_t));
+      }
+      lockedlumps[numlockedlumps++] = { data, tag };
+      Z_ChangeTag(data, PU_STATIC);
+   }
+
+   return data;
+}
+
+//
+// Paints a job's texture and finds its column runs. Safe on any thread.
+//
+static void R_runTextureJob(texturejob_t &job)
+{
+   texture_t *tex = job.tex;
+   const int bufferlen = tex->width * tex->height + 4;
+
+   if(job.mask)
+      memset(job.mask, 0, bufferlen);
+
+   const texcompose_t comp = { tex, job.bufferalloc + 8, job.mask, bufferlen };
+   R_composeTexture(comp, [&job](int i) { return job.sources[i]; });
+
+   if(job.mask && !tex->columns)
+      R_findTextureRuns(tex, job.mask, job.runs);
+}
+
+//
+// Marks a job done and wakes the main thread if it is waiting on it.
+//
+static void R_completeTextureJob(texturejob_t &job)
+{
+   {
+      std::lock_guard<std::mutex> lock(precachelock);
+      job.state.store(JOB_DONE, std::memory_order_release);
+   }
+   precachedone.notify_all();
+}
+
+static void R_publishFinishedJob(unsigned generation, int index);
+
+//
+// Composes one texture on a job worker and hands it back to the main thread.
+//
+static void R_precacheJob(unsigned generation, int index)
+{
+   texturejob_t &job = texturejobs[index];
+   int expected = JOB_QUEUED;
+
+   // The main thread may have claimed it first
+   if(!job.state.compare_exchange_strong(expected, JOB_RUNNING, std::memory_order_acquire))
+      return;
+
+   R_runTextureJob(job);
+   R_completeTextureJob(job);
+
+   D_RunOnMainThread([generation, index] { R_publishFinishedJob(generation, index); });
+}
+
+//
+// Hands a composed texture over to the renderer. Main thread only.
+//
+static void R_publishTextureJob(texturejob_t &job)
+{
+   texture_t *tex = job.tex;
+   const int bufferlen = tex->width * tex->height + 4;
+
+   // Reallocating in place moves ownership of the block to the texture
+   tex->bufferalloc = erealloctag(byte *, job.bufferalloc, bufferlen + 8, PU_STATIC,
+                                  (void **)&tex->bufferalloc);
+   tex->bufferdata = tex->bufferalloc + 8;
+
+   if(job.mask)
+   {
+      if(tex->columns)
+         R_appendAlphaMask(tex, job.mask);
+      else
+         R_buildTextureColumns(tex, job.runs, job.mask);
+      R_freeTextureRuns(job.runs);
+      Z_SysFree(job.mask);
+      job.mask = nullptr;
+   }
+
+   R_buildMipLevels(tex);
+   Z_ChangeTag(tex->bufferalloc, PU_CACHE);
+   R_markResident(tex);
+
+   efree(job.sources);
+   job.sources = nullptr;
+   job.state.store(JOB_FINISHED, std::memory_order_relaxed);
+   jobfortexture[job.texnum] = -1;
+   --numunfinishedjobs;
+}
+
+//
+// Makes sure a job is composed, doing it here if no thread has started it yet,
+// then publishes it.
+//
+static void R_finishTextureJob(texturejob_t &job)
+{
+   int expected = JOB_QUEUED;
+
+   if(job.state.compare_exchange_strong(expected, JOB_RUNNING, std::memory_order_acquire))
+      R_runTextureJob(job);
+   else if(expected == JOB_RUNNING)
+   {
+      std::unique_lock<std::mutex> lock(precachelock);
+      precachedone.wait(lock, [&job] {
+         return job.state.load(std::memory_order_acquire) == JOB_DONE;
+      });
+   }
+
+   R_publishTextureJob(job);
+}
+
+//
+// Joins the jobs and releases everything once every job is published.
+//
+static void R_endPrecache()
+{
+   for(int i = 0; i < numtexturejobs; i++)
+      texturejobs[i].handle.join();
+
+   for(int i = 0; i < numlockedlumps; i++)
+      Z_ChangeTag(lockedlumps[i].data, lockedlumps[i].tag);
+   numlockedlumps = 0;
+
+   delete [] texturejobs;
+   texturejobs    = nullptr;
+   numtexturejobs = 0;
+
+   efree(jobfortexture);
+   jobfortexture = nullptr;
+}
+
+//
+// Starts composing every texture marked in hitlist that isn't cached yet on
+// the job workers, and returns without waiting for them.
+//
+void R_PrecacheTextures(const byte *hitlist)
+{
+   R_FinishPrecache();
+
+   int count = 0;
+   for(int i = 0; i < texturecount; i++)
+   {
+      if(hitlist[i] && !textures[i]->bufferalloc && textures[i]->ccount)
+         ++count;
+   }
+
+   if(!count)
+      return;
+
+   texturejobs       = new texturejob_t[count];
+   numtexturejobs    = count;
+   numunfinishedjobs = count;
+   ++precachegeneration;
+
+   jobfortexture = emalloc(int *, texturecount * sizeof(int));
+
+   // Jobs go in the same order the synchronous precache used
+   for(int i = texturecount, j = 0; --i >= 0; )
+   {
+      texture_t *tex = textures[i];
+
+      jobfortexture[i] = -1;
+      if(!hitlist[i] || tex->bufferalloc || !tex->ccount)
+         continue;
+
+      texturejob_t &job = texturejobs[j];
+      const int bufferlen = tex->width * tex->height + 4;
+
+      job.tex    = tex;
+      job.texnum = i;
+      job.bufferalloc = ecalloctag(byte *, 1, bufferlen + 8, PU_STATIC,
+                                   (void **)&job.bufferalloc);
+      job.mask    = tex->columns && !(tex->flags & TF_MASKED) ? nullptr :
+                    static_cast<byte *>(Z_SysMalloc(bufferlen));
+      job.sources = ecalloc(const void **, tex->ccount, sizeof(const void *));
+      job.runs    = texruns_t();
+
+      for(int c = 0; c < tex->ccount; c++)
+      {
+         if(tex->components[c].lump != -1)
+            job.sources[c] = R_lockComponent(tex->components[c]);
+      }
+
+      job.state.store(JOB_QUEUED, std::memory_order_relaxed);
+      jobfortexture[i] = j++;
+   }
+
+   const unsigned generation = precachegeneration;
+   for(int i = 0; i < count; i++)
+      texturejobs[i].handle = D_QueueJob([generation, i] { R_precacheJob(generation, i); }, JOBPRI_LOW);
+}
+
+//
+// Publishes a texture a job has handed back, unless R_CacheTexture got to
+// it first or its precache is already over. Main thread only.
+//
+static void R_publishFinishedJob(unsigned generation, int index)
+{
+   if(generation != precachegeneration || !texturejobs)
+      return;
+
+   texturejob_t &job = texturejobs[index];
+   if(job.state.load(std::memory_order_acquire) == JOB_DONE)
+      R_publishTextureJob(job);
+
+   if(!numunfinishedjobs)
+      R_endPrecache();
+}
+
+//
+// Waits for and publishes every outstanding job.
+//
+void R_FinishPrecache()
+{
+   if(!texturejobs)
+      return;
+
+   for(int i = 0; i < numtexturejobs; i++)
+   {
+      if(texturejobs[i].state.load(std::memory_order_relaxed) != JOB_FINISHED)
+         R_finishTextureJob(texturejobs[i]);
+   }
+
+   R_endPrecache();
+}
+
+//
+// R_CacheTexture
+// 
+// Caches a texture in memory, building it from component parts.
+//
+texture_t *R_CacheTexture(int num)
+{
+   texture_t  *tex;
+   
+#ifdef RANGECHECK
+   if(num < 0 || num >= texturecount)
+      I_Error("R_CacheTexture: invalid texture num %i\n", num);
+#endif
+
+   tex = textures[num];
+   R_touchTexture(tex);
+   if(tex->bufferalloc)
+      return tex;
+
+   // Still with the precache jobs? Only this texture needs to be waited for.
+   if(jobfortexture && jobfortexture[num] >= 0)
+   {
+      R_finishTextureJob(texturejobs[jobfortexture[num]]);
+      return tex;
+   }
+   
+   // SoM: This situation would most certainly require an abort.
+   if(tex->ccount == 0)
+   {
+      I_Error("R_CacheTexture: texture %s cached with no buffer and no components.\n",
+              (const char *)(tex->name));
+   }
+
+   // This function has two primary branches:
+   // 1. There is no buffer, and there are no columns which means the texture
+   //    has never been built before and needs a full treatment
+   // 2. There is no buffer, but there are columns which means that the buffer
+   //    (PU_CACHE) has been freed but the columns (PU_RENDERER) have not. 
+   //    This case means we only have to rebuilt the buffer. A texture with
+   //    holes still needs its mask, to append the alpha mask again.
+
+   // Start the texture. Check the size of the mask buffer if needed.   
+   StartTexture(tex, tex->columns == nullptr || (tex->flags & TF_MASKED));
+   
+   const texcompose_t comp =
+   {
+      tex, tex->bufferdata, tempmask.mask ? tempmask.buffer : nullptr, tempmask.buffermax
+   };
+   R_composeTexture(comp, [tex](int i) {
+      return R_cacheComponent(tex->components[i], PU_CACHE);
+   });
+
+   // Finish texture
+   FinishTexture(tex);
+   R_buildMipLevels(tex);
+   Z_ChangeTag(tex->bufferalloc, PU_CACHE);
+   R_markResident(tex);
+
+   return tex;
+}
+
+//
+// Called at the start of every rendered frame.
+//
+void R_StartTextureFrame()
+{
+   ++texframe;
+   R_initSpriteMips();
+   R_evictTextures();
+}
+
+//
+// R_checkerBoardTexture
+//
+// Fill in a 64x64 texture with a checkerboard pattern.
+//
+static void R_checkerBoardTexture(texture_t *tex)
+{
+   // allocate buffer (also allow some slack space _after_ the buffer)
+   tex->bufferalloc = emalloctag(byte *, 64*64 + 16, PU_RENDERER, nullptr);
+   tex->bufferdata = tex->bufferalloc + 8;
+
+   // allocate column pointers
+   tex->columns = ecalloctag(texcol_t **, sizeof(texcol_t *), tex->width, 
+                             PU_RENDERER, nullptr);
+
+   // make columns
+   for(int i = 0; i < tex->width; i++)
+   {
+      tex->columns[i] = estructalloctag(texcol_t, 1, PU_RENDERER);
+      tex->columns[i]->next = nullptr;
+      tex->columns[i]->yoff = 0;
+      tex->columns[i]->len = tex->height;
+      tex->columns[i]->ptroff = i * tex->height;
+   }
+   
+   // fill pixels
+   byte c1 = GameModeInfo->whiteIndex;
+   byte c2 = GameModeInfo->blackIndex;
+   for(int i = 0; i < 4096; i++)
+      tex->bufferdata[i] = ((i & 8) == 8) != ((i & 512) == 512) ? c1 : c2;
+}
+
+//
+// R_MakeDummyTexture
+//
+// haleyjd 06/20/14: creates a dummy texture in textures[0] if there are no
+// textures defined via TEXTURE1/2 lumps, to prevent problems with mods making
+// exclusive use of the ns_textures namespace.
+//
+static void R_MakeDummyTexture()
+{
+   textures[0] = R_AllocTexStruct("-BADTEX-", 64, 64, 0);
+   R_checkerBoardTexture(textures[0]);
+}
+
+//
+// R_MakeMissingTexture
+//
+// Creates a checkerboard texture to fill in for unknown textures.
+//
+static void R_MakeMissingTexture(int count)
+{
+   if(count >= texturecount)
+   {
+      usermsg("R_MakeMissingTexture: count >= texturecount\n");
+      return;
+   }
+   
+   badtex = count;
+   textures[badtex] = R_AllocTexStruct("BAADF00D", 64, 64, 0);
+   R_checkerBoardTexture(textures[badtex]);   
 }
 
 //
@@ -1471,6 +2498,14 @@ void R_InitTextures()
    textures = emalloctag(texture_t **, sizeof(texture_t *) * texturecount, PU_RENDERER, nullptr);
    memset(textures, 0, sizeof(texture_t *) * texturecount);
 
+   // the old textures went with PU_RENDERER
+   residenttextures = nullptr;
+   residentbytes    = 0;
+   numresident      = 0;
+
+   // the sprite lumps and palette may have changed too
+   R_freeSpriteMips();
+
    // init lookup tables
    R_InitTranslationLUT();
 
@@ -1546,7 +2581,9 @@ const char *level_error = nullptr;
 //
 const byte *R_GetRawColumn(int tex, int32_t col)
 {
-   const texture_t *t = textures[tex];
+   texture_t *t = textures[tex];
+
+   R_touchTexture(t);
 
    // haleyjd 05/28/14: support non-power-of-two widths
    if(t->flags & TF_WIDTHNP2)
@@ -1561,13 +2598,38 @@ const byte *R_GetRawColumn(int tex, int32_t col)
           t->bufferdata + col;
 }
 
+//
+// Returns column col of a wall texture from the smallest level whose texels
+// are still under two pixels apart when drawn step (in texels per pixel) at
+// a time. The level is returned for scaling the other coordinates.
+//
+const byte *R_GetMipColumn(int tex, int32_t col, fixed_t step, int &level)
+{
+   texture_t *t = textures[tex];
+
+   level = 0;
+   if(r_mipmap && t->mipdata)
+   {
+      while(level < t->nummips && step >= FRACUNIT << (level + 1))
+         ++level;
+   }
+
+   if(!level)
+      return R_GetRawColumn(tex, col);
+
+   R_touchTexture(t);
+
+   return R_GetMipLevel(t, level) + ((col & t->widthmask) >> level) * (t->height >> level);
+}
+
 //
 // R_GetMaskedColumn
 //
 const texcol_t *R_GetMaskedColumn(int tex, int32_t col)
 {
-   const texture_t *t = textures[tex];
-   
+   texture_t *t = textures[tex];
+
+   R_touchTexture(t);
    if(!t->bufferalloc)
       R_CacheTexture(tex);
 
@@ -1581,8 +2643,9 @@ const texcol_t *R_GetMaskedColumn(int tex, int32_t col)
 //
 const byte *R_GetLinearBuffer(int tex)
 {
-   const texture_t *t = textures[tex];
-   
+   texture_t *t = textures[tex];
+
+   R_touchTexture(t);
    if(!t->bufferalloc)
       R_CacheTexture(tex);
 
@@ -22,6 +22,9 @@
 // Authors: Stephen McGranahan, James Haley, Ioan Chera, Max Waine
 //
 
+#include <atomic>
+#include <mutex>
+
 #include "z_zone.h"
 #include "i_system.h"
 
@@ -36,6 +39,7 @@
 #include "m_argv.h"
 #include "m_bbox.h"
 #include "m_compare.h"
+#include "m_simd.h"
 #include "m_swap.h"
 #include "p_chase.h"
 #include "p_info.h"
@@ -49,15 +53,18 @@
 #include "r_bsp.h"
 #include "r_context.h"
 #include "r_draw.h"
+#include "r_draw32.h"
 #include "r_interpolate.h"
 #include "r_main.h"
 #include "r_patch.h"
 #include "r_plane.h"
 #include "r_portal.h"
+#include "r_profile.h"
 #include "r_pcheck.h"   // ioanch 20160109: for sprite rendering through portals
 #include "r_segs.h"
 #include "r_state.h"
 #include "r_things.h"
+#include "r_voxels.h"
 #include "v_alloc.h"
 #include "v_misc.h"
 #include "v_patchfmt.h"
@@ -171,6 +178,7 @@ struct vissprite_t
 
   int    sector; // SoM: sector the sprite is in.
 
+  rvoxelview_t voxel; // model drawn instead of the patch, if it has one
 };
 
 // haleyjd 04/25/10: drawsegs optimization
@@ -178,8 +186,19 @@ struct drawsegs_xrange_t
 {
    int x1, x2;
    drawseg_t *user;
+   float maxdist; // nearest scale of the seg
+   bool  masked;  // has a masked mid texture, so matters even when behind
 };
 
+// The xrange entries overlapping each DSBUCKETWIDTH columns of the view are
+// listed per bucket, in xrange order, so a sprite only visits nearby segs.
+#define DSBUCKETSHIFT 5
+#define DSBUCKETWIDTH (1 << DSBUCKETSHIFT)
+
+// Sprites spanning more buckets than this merge nothing and just walk the
+// whole xrange list
+#define DSMAXMERGEBUCKETS 4
+
 //=============================================================================
 //
 // Statics
@@ -208,6 +227,10 @@ VALLOCATION(pscreenheightarray)
    pscreenheightarray = ecalloctag(float *, w, sizeof(float), PU_VALLOC, nullptr);
 }
 
+// Player gun sprites of the current view, set up for the contexts to draw
+static vissprite_t pspritevis[NUMPSPRITES];
+static int         numpspritevis;
+
 // Max number of particles
 static int numParticles;
 
@@ -233,8 +256,7 @@ VALLOCATION(pstack)
             }
          }
 
-         // free the pstack
-         efree(pstack);
+         // the pstack itself lives in the frame arena
       }
 
       // free the maskedrange freelist 
@@ -273,9 +295,9 @@ VALLOCATION(clipbot)
 // Forward declarations:
 static void R_drawParticle(const contextbounds_t &bounds, vissprite_t *vis,
                            const float *const mfloorclip, const float *const mceilingclip);
-static void R_projectParticle(cmapcontext_t &cmapcontext, spritecontext_t &spritecontext,
-                              const viewpoint_t &viewpoint, const cbviewpoint_t &cb_viewpoint,
-                              const contextbounds_t &bounds, particle_t *particle);
+static void R_projectParticles(cmapcontext_t &cmapcontext, spritecontext_t &spritecontext,
+                               const viewpoint_t &viewpoint, const cbviewpoint_t &cb_viewpoint,
+                               const contextbounds_t &bounds, sector_t *sec);
 
 //
 // R_SetMaskedSilhouette
@@ -358,19 +380,52 @@ static void R_installSpriteLump(const lumpinfo_t *lump, int lumpnum, unsigned fr
 // properties across standard Doom sprites:
 #define R_SpriteNameHash(s) ((unsigned int)((s)[0]-((s)[1]*3-(s)[3]*2-(s)[2])*2))
 
-// haleyjd 10/10/11: externalized structure due to template limitations with
-// local struct types in the pre-C++11 standard
-struct rsprhash_s { int index, next; };
+//
+// Sprite definitions are built the first time each sprite is referenced. At
+// startup only an index is made, which chains the lumps of the sprite
+// namespace together by their first four letters. Render contexts can be the
+// first to reference a sprite, so builds are made under a lock and all that
+// they allocate comes from the system heap.
+//
+
+static int              *spritechain;     // newest lump of each sprite, or -1
+static int              *spritelumpnext;  // next lump in a chain, newest first
+static std::atomic_bool *spritebuilt;
+static std::mutex        spritebuildlock;
+static int               numspritedefs;   // number of sprites the above were made for
+
+//
+// Frees the definitions built for the last set of sprite names.
+//
+static void R_freeSpriteDefs()
+{
+   for(int i = 0; i < numspritedefs; i++)
+   {
+      Z_SysFree(sprites[i].spriteframes);
+      Z_SysFree(r_spritespan[i]);
+   }
+
+   Z_SysFree(sprites);
+   Z_SysFree(r_spritespan);
+   Z_SysFree(spritechain);
+   Z_SysFree(spritelumpnext);
+   delete [] spritebuilt;
+
+   sprites        = nullptr;
+   r_spritespan   = nullptr;
+   spritechain    = nullptr;
+   spritelumpnext = nullptr;
+   spritebuilt    = nullptr;
+   numspritedefs  = 0;
+}
 
 //
 // Pass a null terminated list of sprite names
 // (4 chars exactly) to be used.
 //
-// Builds the sprite rotation matrixes to account
-// for horizontally flipped sprites.
-//
-// Will report an error if the lumps are inconsistent.
-// Only called at startup.
+// Indexes the sprite lumps by the sprite they belong to. Lumps are matched to
+// sprite names through a hash of the names, and a name listed more than once
+// shares the chain of its first entry.
 //
 // Sprite lump names are 4 characters for the actor,
 //  a letter for the frame, and a number for the rotation.
@@ -384,135 +439,187 @@ struct rsprhash_s { int index, next; };
 //
 static void R_initSpriteDefs(char **namelist)
 {
-   static spriteframe_t sprtemp[MAX_SPRITE_FRAMES];
-   static int maxframe;
-
-   size_t numentries = lastspritelump - firstspritelump + 1;
-   rsprhash_s *hash;
-   unsigned int i;
+   const int numentries = numspritelumps;
    lumpinfo_t **lumpinfo = wGlobalDir.getLumpInfo();
+   int *hash, *hashnext;
+   int i;
+
+   R_freeSpriteDefs();
+   r_maxspriteside = 0;
 
-   if(!numentries || !*namelist)
-      return;
-   
    // count the number of sprite names
    for(i = 0; namelist[i]; i++)
       ; // do nothing
-   
-   numsprites = (signed int)i;
 
-   sprites = estructalloctag(spritedef_t, numsprites, PU_RENDERER);
-   
-   // Create hash table based on just the first four letters of each sprite
-   // killough 1/31/98
-   
-   hash = estructalloc(rsprhash_s, numentries); // allocate hash table
+   numsprites    = i;
+   numspritedefs = i;
 
-   for(i = 0; i < numentries; i++) // initialize hash table as empty
-      hash[i].index = -1;
+   sprites      = static_cast<spritedef_t *>(Z_SysCalloc(numsprites + 1, sizeof(*sprites)));
+   r_spritespan = static_cast<spritespan_t **>(Z_SysCalloc(numsprites + 1, sizeof(*r_spritespan)));
+   spritechain  = static_cast<int *>(Z_SysMalloc((numsprites + 1) * sizeof(*spritechain)));
+   spritebuilt  = new std::atomic_bool[numsprites + 1];
 
-   for(i = 0; i < numentries; i++)  // Prepend each sprite to hash chain
-   {                                // prepend so that later ones win
-      int j = R_SpriteNameHash(lumpinfo[i+firstspritelump]->name) % numentries;
-      hash[i].next = hash[j].index;
-      hash[j].index = i;
-   }
+   spritelumpnext = static_cast<int *>(Z_SysMalloc((numentries + 1) * sizeof(*spritelumpnext)));
+
+   if(!numsprites)
+      return;
+
+   // hash the sprite names; the first entry of a name owns its lumps
+   hash     = estructalloc(int, numsprites);
+   hashnext = estructalloc(int, numsprites);
 
-   // scan all the lump names for each of the names,
-   //  noting the highest frame letter.
+   for(i = 0; i < numsprites; i++)
+      hash[i] = -1;
 
-   for(i = 0; i < (unsigned int)numsprites; i++)
+   for(i = numsprites; --i >= 0; )
    {
-      const char *spritename = namelist[i];
-      int j = hash[R_SpriteNameHash(spritename) % numentries].index;
-      
-      if(j >= 0)
+      const int j = R_SpriteNameHash(namelist[i]) % numsprites;
+      hashnext[i] = hash[j];
+      hash[j] = i;
+
+      spritechain[i] = -1;
+      spritebuilt[i].store(false, std::memory_order_relaxed);
+   }
+
+   for(i = 0; i < numsprites; i++)
+   {
+      for(int j = hash[R_SpriteNameHash(namelist[i]) % numsprites]; j >= 0 && j < i;
+          j = hashnext[j])
       {
-         memset(sprtemp, -1, sizeof(sprtemp));
-         maxframe = -1;
-         do
+         if(!strncmp(namelist[i], namelist[j], 4))
          {
-            lumpinfo_t *lump = lumpinfo[j + firstspritelump];
+            spritechain[i] = j;
+            break;
+         }
+      }
+      if(spritechain[i] == -1)
+         spritechain[i] = i;
+   }
 
-            // Fast portable comparison -- killough
-            // (using int pointer cast is nonportable):
+   // prepend each lump to its sprite's chain, so that later ones win
+   int *chainhead = estructalloc(int, numsprites);
 
-            if(!((lump->name[0] ^ spritename[0]) |
-                 (lump->name[1] ^ spritename[1]) |
-                 (lump->name[2] ^ spritename[2]) |
-                 (lump->name[3] ^ spritename[3])))
-            {
-               R_installSpriteLump(
-                  lump, j+firstspritelump,
-                  lump->name[4] - 'A', lump->name[5] - '0',
-                  false, // not flipped
-                  sprtemp, maxframe
-               );
-               if(lump->name[6])
-                  R_installSpriteLump(
-                     lump, j+firstspritelump,
-                     lump->name[6] - 'A', lump->name[7] - '0',
-                     true, // flipped
-                     sprtemp, maxframe
-                  );
-            }
-         }
-         while((j = hash[j].next) >= 0);
+   for(i = 0; i < numsprites; i++)
+      chainhead[i] = -1;
+
+   for(i = 0; i < numentries; i++)
+   {
+      const char *name = lumpinfo[i + firstspritelump]->name;
+      int j = hash[R_SpriteNameHash(name) % numsprites];
+
+      // Fast portable comparison -- killough
+      // (using int pointer cast is nonportable):
+      while(j >= 0 && ((name[0] ^ namelist[j][0]) | (name[1] ^ namelist[j][1]) |
+                       (name[2] ^ namelist[j][2]) | (name[3] ^ namelist[j][3])))
+         j = hashnext[j];
+
+      if(j < 0)
+         continue;
 
-         // check the frames that were found for completeness
-         if(++maxframe)  // killough 1/31/98
+      j = spritechain[j];
+      spritelumpnext[i] = chainhead[j];
+      chainhead[j] = i;
+
+      // portal clipping needs the widest frame before any sprite is built
+      r_maxspriteside = emax(r_maxspriteside, R_SpriteLumpSide(i));
+   }
+
+   // every entry of a name starts at the owner's newest lump
+   for(i = 0; i < numsprites; i++)
+      spritechain[i] = chainhead[spritechain[i]];
+
+   efree(chainhead);
+   efree(hashnext);
+   efree(hash);
+}
+
+//
+// Builds the rotation matrixes of a sprite from its indexed lumps, to account
+// for horizontally flipped sprites. Will report an error if the lumps are
+// inconsistent. Called with the build lock held.
+//
+static void R_buildSpriteDef(int sprite)
+{
+   spriteframe_t sprtemp[MAX_SPRITE_FRAMES];
+   int maxframe = -1;
+   lumpinfo_t **lumpinfo = wGlobalDir.getLumpInfo();
+   spritedef_t &def = sprites[sprite];
+
+   // haleyjd 08/15/02: a sprite with no lumps keeps numframes of 0 and
+   // spriteframes of nullptr. Check for these values before loading any sprite.
+   if(spritechain[sprite] < 0)
+      return;
+
+   memset(sprtemp, -1, sizeof(sprtemp));
+
+   for(int j = spritechain[sprite]; j >= 0; j = spritelumpnext[j])
+   {
+      const lumpinfo_t *lump = lumpinfo[j + firstspritelump];
+
+      R_installSpriteLump(
+         lump, j+firstspritelump,
+         lump->name[4] - 'A', lump->name[5] - '0',
+         false, // not flipped
+         sprtemp, maxframe
+      );
+      if(lump->name[6])
+         R_installSpriteLump(
+            lump, j+firstspritelump,
+            lump->name[6] - 'A', lump->name[7] - '0',
+            true, // flipped
+            sprtemp, maxframe
+         );
+   }
+
+   // check the frames that were found for completeness
+   if(!++maxframe)  // killough 1/31/98
+      return;
+
+   for(int frame = 0; frame < maxframe; frame++)
+   {
+      // frames that are missing or need only the first rotation are fine;
+      // a rotated frame must have all 8
+      if(sprtemp[frame].rotate != 1)
+         continue;
+
+      for(int rotation = 0; rotation < MAX_ROTATIONS; rotation++)
+      {
+         if(sprtemp[frame].lump[rotation] == -1)
          {
-            bool valid = true;
-            for(int frame = 0; frame < maxframe; frame++)
-            {
-               switch(sprtemp[frame].rotate)
-               {
-               case -1:
-                  // no rotations were found for that frame at all
-                  break;
-                  
-               case 0:
-                  // only the first rotation is needed
-                  break;
-                  
-               case 1:
-                  // must have all 8 frames
-                  for(int rotation = 0; rotation < MAX_ROTATIONS; rotation++)
-                  {
-                     if(sprtemp[frame].lump[rotation] == -1)
-                     {
-                        C_Printf(FC_ERROR "R_InitSprites: Sprite %.8s frame %c is missing rotations\n",
-                                 namelist[i], frame + 'A');
-                        valid = false;
-                        break;
-                     }
-                  }
-                  break;
-               }
-            }
-            if(valid)
-            {
-               // allocate space for the frames present and copy sprtemp to it
-               sprites[i].numframes = maxframe;
-               sprites[i].spriteframes = estructalloctag(spriteframe_t, maxframe, PU_RENDERER);
-               memcpy(sprites[i].spriteframes, sprtemp, maxframe*sizeof(spriteframe_t));
-            }
+            C_Printf(FC_ERROR "R_InitSprites: Sprite %.8s frame %c is missing rotations\n",
+                     spritelist[sprite], frame + 'A');
+            return;
          }
       }
-      else
+   }
+
+   // allocate space for the frames present and copy sprtemp to it
+   def.spriteframes = static_cast<spriteframe_t *>(Z_SysMalloc(maxframe * sizeof(spriteframe_t)));
+   memcpy(def.spriteframes, sprtemp, maxframe * sizeof(spriteframe_t));
+
+   r_spritespan[sprite] = static_cast<spritespan_t *>(Z_SysMalloc(maxframe * sizeof(spritespan_t)));
+   def.numframes = maxframe;
+   R_InitSpriteProjSpan(def, r_spritespan[sprite]);
+}
+
+//
+// Returns a sprite's definition, building it if this is the first time it
+// has been asked for. The sprite number must be in range.
+//
+spritedef_t *R_SpriteDef(int sprite)
+{
+   if(!spritebuilt[sprite].load(std::memory_order_acquire))
+   {
+      std::lock_guard<std::mutex> lock(spritebuildlock);
+
+      if(!spritebuilt[sprite].load(std::memory_order_relaxed))
       {
-         // haleyjd 08/15/02: problem here.
-         // If j was -1 above, meaning that there are no lumps for the sprite
-         // present, the sprite is left uninitialized. This creates major 
-         // problems in R_PrecacheLevel if a thing tries to subsequently use
-         // that sprite. Instead, set numframes to 0 and spriteframes to nullptr.
-         // Then, check for these values before loading any sprite.
-         
-         sprites[i].numframes = 0;
-         sprites[i].spriteframes = nullptr;
+         R_buildSpriteDef(sprite);
+         spritebuilt[sprite].store(true, std::memory_order_release);
       }
    }
-   efree(hash);             // free hash table
+
+   return &sprites[sprite];
 }
 
 //
@@ -527,7 +634,51 @@ static void R_initSpriteDefs(char **namelist)
 void R_InitSprites(char **namelist)
 {
    R_initSpriteDefs(namelist);
-   R_InitSpriteProjSpan();
+
+   // -nolazysprites builds every sprite now, as was always done before
+   if(M_CheckParm("-nolazysprites"))
+   {
+      for(int i = 0; i < numsprites; i++)
+         R_SpriteDef(i);
+   }
+
+   R_InitVoxels();
+}
+
+//
+// Bytes the sprite context's per-frame arrays take at their current capacities.
+//
+size_t R_SpriteFrameArenaBytes(const spritecontext_t &context)
+{
+   return R_FrameArenaBytes(context.num_vissprite_alloc * sizeof(vissprite_t))       +
+          R_FrameArenaBytes(context.num_vissprite_ptrs * sizeof(vissprite_t *))      +
+          R_FrameArenaBytes(context.num_vissprite_ptrs * sizeof(uint32_t))           +
+          R_FrameArenaBytes(context.drawsegs_xrange_size * sizeof(drawsegs_xrange_t)) +
+          R_FrameArenaBytes(context.drawsegs_buckets_size * sizeof(int))             +
+          R_FrameArenaBytes(2 * (context.drawsegs_bucketsalloc + 1) * sizeof(int))   +
+          R_FrameArenaBytes(context.pstackmax * sizeof(poststack_t))                 +
+          R_FrameArenaBytes(context.particle_alloc * sizeof(particle_t *))           +
+          R_FrameArenaBytes(context.particle_alloc * sizeof(float)) * 2;
+}
+
+//
+// Carves the sprite context's per-frame arrays from its freshly reset arena.
+//
+void R_CarveSpriteFrameArrays(spritecontext_t &context)
+{
+   rframearena_t &arena = *context.arena;
+
+   context.vissprites      = R_FrameArenaArray<vissprite_t>(arena, context.num_vissprite_alloc);
+   context.vissprite_ptrs  = R_FrameArenaArray<vissprite_t *>(arena, context.num_vissprite_ptrs);
+   context.vissprite_keys  = R_FrameArenaArray<uint32_t>(arena, context.num_vissprite_ptrs);
+   context.drawsegs_xrange = R_FrameArenaArray<drawsegs_xrange_t>(arena, context.drawsegs_xrange_size);
+   context.drawsegs_buckets = R_FrameArenaArray<int>(arena, context.drawsegs_buckets_size);
+   context.drawsegs_bucketstart = context.drawsegs_bucketsalloc ?
+      R_FrameArenaArray<int>(arena, 2 * (context.drawsegs_bucketsalloc + 1)) : nullptr;
+   context.pstack        = R_FrameArenaArray<poststack_t>(arena, context.pstackmax);
+   context.particle_list = R_FrameArenaArray<particle_t *>(arena, context.particle_alloc);
+   context.particle_x    = R_FrameArenaArray<float>(arena, context.particle_alloc);
+   context.particle_y    = R_FrameArenaArray<float>(arena, context.particle_alloc);
 }
 
 //
@@ -555,8 +706,8 @@ void R_PushPost(bspcontext_t &bspcontext, spritecontext_t &spritecontext,
    
    if(pstacksize == pstackmax)
    {
+      pstack = R_FrameArenaGrow(*spritecontext.arena, pstack, pstackmax, pstackmax + 10);
       pstackmax += 10;
-      pstack = erealloc(poststack_t *, pstack, sizeof(poststack_t) * pstackmax);
    }
    
    post = pstack + pstacksize;
@@ -587,9 +738,10 @@ void R_PushPost(bspcontext_t &bspcontext, spritecontext_t &spritecontext,
       {
          post->masked = estructalloc(maskedrange_t, 1);
 
-         float *buf = emalloc(float *, 2 * bounds.numcolumns * sizeof(float));
+         // Sized for the whole screen, as context bounds can move between frames
+         float *buf = emalloc(float *, 2 * video.width * sizeof(float));
          post->masked->ceilingclip = buf;
-         post->masked->floorclip   = buf + bounds.numcolumns;
+         post->masked->floorclip   = buf + video.width;
       }
 
       for(i = pstacksize - 1; i >= 0; i--)
@@ -629,11 +781,14 @@ static vissprite_t *R_newVisSprite(spritecontext_t &context)
 
    if(num_vissprite >= num_vissprite_alloc)             // killough
    {
-      num_vissprite_alloc = num_vissprite_alloc ? num_vissprite_alloc*2 : 128;
-      vissprites = erealloc(vissprite_t *, vissprites, num_vissprite_alloc*sizeof(*vissprites));
+      const size_t newalloc = num_vissprite_alloc ? num_vissprite_alloc*2 : 128;
+      vissprites = R_FrameArenaGrow(*context.arena, vissprites, num_vissprite_alloc, newalloc);
+      num_vissprite_alloc = newalloc;
    }
 
-   return vissprites + num_vissprite++;
+   vissprite_t *vis = vissprites + num_vissprite++;
+   vis->voxel.model = nullptr;
+   return vis;
 }
 
 //
@@ -738,7 +893,8 @@ void R_DrawNewMaskedColumn(const R_ColumnFunc colfunc,
 //  mfloorclip and mceilingclip should also be set.
 //
 static void R_drawVisSprite(const contextbounds_t &bounds, vissprite_t *vis,
-                            float *const mfloorclip, float *const mceilingclip)
+                            float *const mfloorclip, float *const mceilingclip,
+                            const float ycenteroffset = 0.0f)
 {
    column_t *tcolumn;
    int       texturecolumn;
@@ -750,6 +906,14 @@ static void R_drawVisSprite(const contextbounds_t &bounds, vissprite_t *vis,
 
    cb_column_t column = {};
 
+   if(vis->voxel.model)
+   {
+      R_DrawVoxel(vis->voxel, vis->colormap,
+                  vis->colour ? translationtables[vis->colour - 1] : nullptr,
+                  vis->x1, vis->x2, mfloorclip, mceilingclip);
+      return;
+   }
+
    if(vis->patch == -1)
    {
       // this vissprite belongs to a particle
@@ -759,7 +923,8 @@ static void R_drawVisSprite(const contextbounds_t &bounds, vissprite_t *vis,
   
    patch = PatchLoader::CacheNum(wGlobalDir, vis->patch+firstspritelump, PU_CACHE);
    
-   column.colormap = vis->colormap;
+   column.colormap      = vis->colormap;
+   column.ycenteroffset = ycenteroffset;
    
    // killough 4/11/98: rearrange and handle translucent sprites
    // mixed with translucent/non-translucent 2s normals
@@ -771,20 +936,42 @@ static void R_drawVisSprite(const contextbounds_t &bounds, vissprite_t *vis,
    column.translevel += 1;
    if(vis->tranmaplump >= 0)
    {
-      tranmap = static_cast<byte *>(wGlobalDir.cacheLumpNum(vis->tranmaplump,
-                                                            PU_CACHE));
+      column.tranmap = static_cast<byte *>(wGlobalDir.cacheLumpNum(vis->tranmaplump,
+                                                                   PU_CACHE));
    }
    else if(vis->drawstyle == VS_DRAWSTYLE_SUB)
-      tranmap = main_submap;
+      column.tranmap = main_submap;
    else
-      tranmap = main_tranmap; // killough 4/11/98   
+      column.tranmap = main_tranmap; // killough 4/11/98   
    
    // haleyjd: faster selection for drawstyles
    const R_ColumnFunc colfunc = r_column_engine->ByVisSpriteStyle[vis->drawstyle][!!vis->colour];
 
+   // Sprites whose texels land two or more pixels apart are drawn from the
+   // mip level that brings them back to about one. Columns are still picked
+   // in the texels of the full patch and shifted down to the level.
+   const patch_t *drawpatch = patch;
+   int            miplevel  = 0;
+   float          mipscale  = vis->scale;
+   if(r_spritemip)
+   {
+      const float step = emin(1.0f / vis->scale, fabsf(vis->xstep));
+      while(miplevel < R_MAXSPRITEMIPS && step >= float(2 << miplevel))
+         ++miplevel;
+
+      const patch_t *mip = miplevel ? R_GetSpriteMip(vis->patch, patch, miplevel) : nullptr;
+      if(mip)
+      {
+         drawpatch = mip;
+         mipscale *= float(1 << miplevel);
+      }
+      else
+         miplevel = 0;
+   }
+
    //column.step = M_FloatToFixed(vis->ystep);
-   column.step = M_FloatToFixed(1.0f / vis->scale);
-   column.texmid = vis->texturemid;
+   column.step = M_FloatToFixed(1.0f / mipscale);
+   column.texmid = vis->texturemid >> miplevel;
    frac = vis->startx;
    
    // haleyjd 10/10/02: foot clipping
@@ -799,7 +986,7 @@ static void R_drawVisSprite(const contextbounds_t &bounds, vissprite_t *vis,
    // haleyjd: use a separate loop for footclip things, to minimize
    // overhead for regular sprites and to require no separate loop
    // just to update mfloorclip
-   const cb_maskedcolumn_t maskedcolumn = { vis->ytop, vis->scale };
+   const cb_maskedcolumn_t maskedcolumn = { vis->ytop, mipscale };
    if(footclipon)
    {
       for(column.x=vis->x1 ; column.x<=vis->x2 ; column.x++, frac += vis->xstep)
@@ -815,7 +1002,7 @@ static void R_drawVisSprite(const contextbounds_t &bounds, vissprite_t *vis,
          if(texturecolumn < 0 || texturecolumn >= w)
             continue;
          
-         tcolumn = (column_t *)((byte *) patch + patch->columnofs[texturecolumn]);
+         tcolumn = (column_t *)((byte *) drawpatch + drawpatch->columnofs[texturecolumn >> miplevel]);
          R_drawMaskedColumn(colfunc, column, maskedcolumn, tcolumn, mfloorclip, mceilingclip);
       }
    }
@@ -829,7 +1016,7 @@ static void R_drawVisSprite(const contextbounds_t &bounds, vissprite_t *vis,
          if(texturecolumn < 0 || texturecolumn >= w)
             continue;
          
-         tcolumn = (column_t *)((byte *) patch + patch->columnofs[texturecolumn]);
+         tcolumn = (column_t *)((byte *) drawpatch + drawpatch->columnofs[texturecolumn >> miplevel]);
          R_drawMaskedColumn(colfunc, column, maskedcolumn, tcolumn, mfloorclip, mceilingclip);
       }
    }
@@ -875,6 +1062,177 @@ static void R_interpolatePSpritePosition(const pspdef_t &pspr, v2fixed_t &pos)
    }
 }
 
+//
+// killough 3/27/98: exclude things totally separated
+// from the viewer, by either water or fake ceilings
+// killough 4/11/98: improve sprite clipping for underwater/fake ceilings
+//
+static bool R_hiddenByHeightSec(const viewpoint_t &viewpoint, const Mobj *thing,
+                                int heightsec, fixed_t gzt)
+{
+   if(heightsec == -1) // only clip things which are in special sectors
+      return false;
+
+   auto &hsec = sectors[heightsec];
+   int   phs  = view.sector->heightsec;
+
+   if(phs != -1 && viewpoint.z < sectors[phs].srf.floor.height ?
+      thing->z >= hsec.srf.floor.height : gzt < hsec.srf.floor.height)
+      return true;
+   if(phs != -1 && viewpoint.z > sectors[phs].srf.ceiling.height ?
+      gzt < hsec.srf.ceiling.height && viewpoint.z >= hsec.srf.ceiling.height :
+      thing->z >= hsec.srf.ceiling.height)
+      return true;
+
+   return false;
+}
+
+//
+// Picks the colormap of a thing's vissprite.
+//
+static lighttable_t *R_thingColormap(const cmapcontext_t &cmapcontext, const Mobj *thing,
+                                     float idist, lighttable_t *const *const spritelights)
+{
+   if(thing->flags & MF_SHADOW)     // sf
+      return colormaps[global_cmap_index]; // haleyjd: NGCS -- was 0
+   else if(cmapcontext.fixedcolormap)
+      return cmapcontext.fixedcolormap;      // fixed map
+   else if(LevelInfo.useFullBright && IS_FULLBRIGHT(thing)) // haleyjd
+      return cmapcontext.fullcolormap;       // full bright  // killough 3/20/98
+   else
+   {     
+      // diminished light
+      // SoM: ANYRES
+      int index = (int)(idist * 2560.0f);
+      if(index >= MAXLIGHTSCALE)
+         index = MAXLIGHTSCALE-1;
+      return spritelights[index];
+   }
+}
+
+//
+// Voxel models are drawn solid; things that would get a translucent or
+// shadowed sprite keep it.
+//
+static bool R_thingDrawsOpaque(const Mobj *thing)
+{
+   if(thing->flags & MF_SHADOW || thing->flags3 & MF3_GHOST)
+      return false;
+
+   return !general_translucency ||
+      (thing->tranmap < 0 && !(thing->flags3 & MF3_TLSTYLEADD) &&
+       !(thing->flags4 & MF4_TLSTYLESUB) && !(thing->flags & MF_TRANSLUCENT) &&
+       thing->translucency >= FRACUNIT);
+}
+
+//
+// Generates the vissprite of a thing drawn as a voxel model, rotated with the
+// thing about the model's center. rotx and roty are the thing's position in
+// view space. The screen extent is a conservative bound of the model's
+// bounding cylinder.
+//
+static void R_projectVoxel(cmapcontext_t &cmapcontext, spritecontext_t &spritecontext,
+                           const viewpoint_t &viewpoint, const cbviewpoint_t &cb_viewpoint,
+                           const contextbounds_t &bounds, Mobj *thing,
+                           lighttable_t *const *const spritelights,
+                           const rvoxelmodel_t *model, const spritepos_t &spritepos,
+                           float rotx, float roty, bool offset)
+{
+   const float hscale = fabsf(thing->xscale);
+   const float vscale = fabsf(thing->yscale);
+   const float radius = 0.5f * sqrtf(float(model->xsize * model->xsize +
+                                           model->ysize * model->ysize)) * hscale;
+   const float nearz  = roty - radius;
+   const float farz   = roty + radius;
+
+   float x1 = bounds.fstartcolumn, x2 = bounds.fendcolumn;
+   if(nearz >= 1.0f)
+   {
+      const float left = rotx - radius, right = rotx + radius;
+      x1 = view.xcenter + left  * view.xfoc / (left  < 0.0f ? nearz : farz);
+      x2 = view.xcenter + right * view.xfoc / (right < 0.0f ? farz : nearz);
+      if(x1 >= bounds.fendcolumn || x2 < bounds.fstartcolumn)
+         return;
+   }
+
+   // SoM: forgot about footclipping
+   fixed_t floorclip = thing->floorclip;
+   if(vanilla_heretic && thing->z > thing->subsector->sector->srf.floor.height)
+   {
+      // prevent ugly visuals when emulating the Heretic foot clip bug
+      floorclip = 0;
+   }
+
+   const float zbottom = M_FixedToFloat(spritepos.z - floorclip) - cb_viewpoint.z;
+   const float ztop    = zbottom + model->zsize * vscale;
+   const float idist   = 1.0f / roty;
+   float y1 = 0.0f, y2 = view.height;
+   if(nearz >= 1.0f)
+   {
+      y1 = view.ycenter - ztop * view.yfoc / (ztop > 0.0f ? nearz : farz);
+      if(y1 >= view.height)
+         return;
+      y2 = view.ycenter - zbottom * view.yfoc / (zbottom > 0.0f ? farz : nearz);
+      if(y2 < 0.0f)
+         return;
+   }
+
+   const fixed_t gzt = spritepos.z + M_FloatToFixed(model->zsize * vscale);
+
+   // ioanch 20160109: offset sprites always use the R_PointInSubsector
+   const sector_t *sec = (view.lerp == FRACUNIT && !offset ? thing->subsector->sector :
+                          R_PointInSubsector(spritepos.x, spritepos.y)->sector);
+   const int heightsec = sec->heightsec;
+
+   if(R_hiddenByHeightSec(viewpoint, thing, heightsec, gzt))
+      return;
+
+   vissprite_t *vis = R_newVisSprite(spritecontext);
+
+   vis->heightsec = heightsec;
+   vis->colour    = thing->colour;
+   vis->gx        = spritepos.x;
+   vis->gy        = spritepos.y;
+   vis->gz        = spritepos.z;
+   vis->gzt       = gzt;
+
+   vis->x1 = x1 <  bounds.fstartcolumn ? bounds.startcolumn   : int(floorf(x1));
+   vis->x2 = x2 >= bounds.fendcolumn   ? bounds.endcolumn - 1 : int(ceilf(x2));
+   vis->x1 = emax(vis->x1, bounds.startcolumn);
+   vis->x2 = emin(vis->x2, bounds.endcolumn - 1);
+
+   vis->startx     = 0.0f;
+   vis->xstep      = 0.0f;
+   vis->dist       = idist;
+   vis->scale      = idist * view.yfoc;
+   vis->ytop       = y1;
+   vis->ybottom    = y2;
+   vis->sector     = int(sec - sectors);
+   vis->footclip   = floorclip;
+   vis->texturemid = gzt - viewpoint.z;
+   vis->patch      = -1;
+
+   vis->translucency = uint16_t(thing->translucency - 1);
+   vis->tranmaplump  = -1;
+   vis->drawstyle    = VS_DRAWSTYLE_NORMAL;
+   vis->colormap     = R_thingColormap(cmapcontext, thing, idist, spritelights);
+
+   // rotate the model's axes with the thing, then into view space
+   const double angle = thing->angle * PI / ANG180;
+   const float  dx = float(cos(angle)) * hscale, dy = float(sin(angle)) * hscale;
+
+   rvoxelview_t &voxel = vis->voxel;
+   voxel.model = model;
+   voxel.cx    = rotx;
+   voxel.cy    = roty;
+   voxel.axx   = dx * cb_viewpoint.cos - dy * cb_viewpoint.sin;
+   voxel.axy   = dy * cb_viewpoint.cos + dx * cb_viewpoint.sin;
+   voxel.ayx   = -dy * cb_viewpoint.cos - dx * cb_viewpoint.sin;
+   voxel.ayy   = dx * cb_viewpoint.cos - dy * cb_viewpoint.sin;
+   voxel.z     = zbottom;
+   voxel.zstep = vscale;
+}
+
 //
 // Generates a vissprite for a thing if it might be visible.
 // ioanch 20160109: added optional arguments for offsetting the sprite
@@ -990,7 +1348,7 @@ static void R_projectSprite(cmapcontext_t &cmapcontext,
       return;
    }
 
-   sprdef = &sprites[thing->sprite];
+   sprdef = R_SpriteDef(thing->sprite);
    
    if(((thing->frame&FF_FRAMEMASK) >= sprdef->numframes) ||
       !(sprdef->spriteframes) ||
@@ -1011,6 +1369,18 @@ static void R_projectSprite(cmapcontext_t &cmapcontext,
    }
 
    sprframe = &sprdef->spriteframes[thing->frame & FF_FRAMEMASK];
+
+   // a voxel model stands in for every rotation of its frame
+   if(R_thingDrawsOpaque(thing))
+   {
+      const rvoxelmodel_t *model = R_VoxelForFrame(thing->sprite, thing->frame & FF_FRAMEMASK);
+      if(model)
+      {
+         R_projectVoxel(cmapcontext, spritecontext, viewpoint, cb_viewpoint, bounds, thing,
+                        spritelights, model, spritepos, rotx, roty, delta != nullptr);
+         return;
+      }
+   }
    
    if(sprframe->rotate)
    {
@@ -1077,28 +1447,13 @@ static void R_projectSprite(cmapcontext_t &cmapcontext,
    // SoM: Block of old code that stays
    gzt = spritepos.z + (fixed_t)(spritetopoffset[lump] * thing->yscale);
 
-   // killough 3/27/98: exclude things totally separated
-   // from the viewer, by either water or fake ceilings
-   // killough 4/11/98: improve sprite clipping for underwater/fake ceilings
-
    // ioanch 20160109: offset sprites always use the R_PointInSubsector
    sec = (view.lerp == FRACUNIT && !delta ? thing->subsector->sector :
           R_PointInSubsector(spritepos.x, spritepos.y)->sector);
    heightsec = sec->heightsec;
 
-   if(heightsec != -1) // only clip things which are in special sectors
-   {
-      auto &hsec = sectors[heightsec];
-      int   phs  = view.sector->heightsec;
-
-      if(phs != -1 && viewpoint.z < sectors[phs].srf.floor.height ?
-         thing->z >= hsec.srf.floor.height : gzt < hsec.srf.floor.height)
-         return;
-      if(phs != -1 && viewpoint.z > sectors[phs].srf.ceiling.height ?
-         gzt < hsec.srf.ceiling.height && viewpoint.z >= hsec.srf.ceiling.height :
-         thing->z >= hsec.srf.ceiling.height)
-         return;
-   }
+   if(R_hiddenByHeightSec(viewpoint, thing, heightsec, gzt))
+      return;
 
    // store information in a vissprite
    vis = R_newVisSprite(spritecontext);
@@ -1147,21 +1502,7 @@ static void R_projectSprite(cmapcontext_t &cmapcontext,
    vis->patch = lump;
 
    // get light level
-   if(thing->flags & MF_SHADOW)     // sf
-      vis->colormap = colormaps[global_cmap_index]; // haleyjd: NGCS -- was 0
-   else if(cmapcontext.fixedcolormap)
-      vis->colormap = cmapcontext.fixedcolormap;      // fixed map
-   else if(LevelInfo.useFullBright && IS_FULLBRIGHT(thing)) // haleyjd
-      vis->colormap = cmapcontext.fullcolormap;       // full bright  // killough 3/20/98
-   else
-   {     
-      // diminished light
-      // SoM: ANYRES
-      int index = (int)(idist * 2560.0f);
-      if(index >= MAXLIGHTSCALE)
-         index = MAXLIGHTSCALE-1;
-      vis->colormap = spritelights[index];
-   }
+   vis->colormap = R_thingColormap(cmapcontext, thing, idist, spritelights);
 
    vis->drawstyle = VS_DRAWSTYLE_NORMAL;
 
@@ -1191,6 +1532,44 @@ static void R_projectSprite(cmapcontext_t &cmapcontext,
    }
 }
 
+//
+// Tests the bounds of every position the sector's things may be drawn at
+// against the view, with each side widened by the widest possible sprite.
+// R_projectSprite rejects a thing behind the view plane or wholly off either
+// side of the context; all three tests are linear in the thing's position, so
+// when every box corner fails one of them, every thing in the sector would.
+//
+static bool R_sectorThingsOutOfView(const cbviewpoint_t &cb_viewpoint,
+                                    const contextbounds_t &bounds,
+                                    const sectorbox_t &box)
+{
+   if(box.thingbox[BOXLEFT] > box.thingbox[BOXRIGHT])
+      return false;
+
+   const float reach = r_maxspriteside * box.thingxscale + 1.0f;
+   const float left   = M_FixedToFloat(box.thingbox[BOXLEFT])   - cb_viewpoint.x;
+   const float right  = M_FixedToFloat(box.thingbox[BOXRIGHT])  - cb_viewpoint.x;
+   const float bottom = M_FixedToFloat(box.thingbox[BOXBOTTOM]) - cb_viewpoint.y;
+   const float top    = M_FixedToFloat(box.thingbox[BOXTOP])    - cb_viewpoint.y;
+   const float cornerx[4] = { left, right, left, right };
+   const float cornery[4] = { bottom, bottom, top, top };
+   const float startx = bounds.fstartcolumn - view.xcenter;
+   const float endx   = bounds.fendcolumn - view.xcenter;
+
+   bool behind = true, offleft = true, offright = true;
+   for(int i = 0; i < 4; i++)
+   {
+      const float roty = cornery[i] * cb_viewpoint.cos + cornerx[i] * cb_viewpoint.sin;
+      const float rotx = cornerx[i] * cb_viewpoint.cos - cornery[i] * cb_viewpoint.sin;
+
+      behind   = behind   && roty < 1.0f;
+      offleft  = offleft  && (rotx + reach) * view.xfoc < startx * roty;
+      offright = offright && (rotx - reach) * view.xfoc > endx * roty;
+   }
+
+   return behind || offleft || offright;
+}
+
 //
 // During BSP traversal, this adds sprites by sector.
 // killough 9/18/98: add lightlevel as parameter, fixing underwater lighting
@@ -1226,14 +1605,20 @@ void R_AddSprites(cmapcontext_t &cmapcontext,
    else
       spritelights = cmapcontext.scalelight[lightnum];
    
-   // Handle all things in sector.
-   
-   for(thing = sec->thinglist; thing; thing = thing->snext)
+   // Handle all things in sector, unless none of them can be in view.
+   // Portal projections below sit outside the sector's box, so they are
+   // always tested one by one.
+
+   if(sec->thinglist &&
+      !R_sectorThingsOutOfView(cb_viewpoint, bounds, pSectorBoxes[sec - sectors]))
    {
-      R_projectSprite(
-         cmapcontext, spritecontext, viewpoint,
-         cb_viewpoint, bounds, portalrender, thing, spritelights
-      );
+      for(thing = sec->thinglist; thing; thing = thing->snext)
+      {
+         R_projectSprite(
+            cmapcontext, spritecontext, viewpoint,
+            cb_viewpoint, bounds, portalrender, thing, spritelights
+         );
+      }
    }
 
    // ioanch 20160109: handle partial sprite projections
@@ -1250,32 +1635,24 @@ void R_AddSprites(cmapcontext_t &cmapcontext,
 
    // haleyjd 02/20/04: Handle all particles in sector.
 
-   if(drawparticles)
-   {
-      DLListItem<particle_t> *link;
-
-      for(link = sec->ptcllist; link; link = link->dllNext)
-         R_projectParticle(cmapcontext, spritecontext, viewpoint, cb_viewpoint, bounds, *link);
-   }
+   if(drawparticles && sec->ptcllist)
+      R_projectParticles(cmapcontext, spritecontext, viewpoint, cb_viewpoint, bounds, sec);
 }
 
 //
-// Draws player gun sprites.
+// Sets up a player gun sprite for the contexts to draw.
 //
-static void R_drawPSprite(const pspdef_t *psp,
-                          lighttable_t *const *const spritelights,
-                          float *const mfloorclip, float *const mceilingclip)
+static void R_projectPSprite(const pspdef_t *psp, const cmapcontext_t &cmapcontext,
+                             lighttable_t *const *const spritelights)
 {
    float         tx;
    float         x1, x2, w;
-   float         oldycenter;
    
    spritedef_t   *sprdef;
    spriteframe_t *sprframe;
    int            lump;
    bool           flip;
    vissprite_t   *vis;
-   vissprite_t    avis;
    
    // haleyjd: total invis. psprite disable
    
@@ -1294,7 +1671,7 @@ static void R_drawPSprite(const pspdef_t *psp,
       psp->state->frame = 0;
    }
 
-   sprdef = &sprites[psp->state->sprite];
+   sprdef = R_SpriteDef(psp->state->sprite);
    
    if(((psp->state->frame&FF_FRAMEMASK) >= sprdef->numframes) ||
       !(sprdef->spriteframes))
@@ -1305,7 +1682,7 @@ static void R_drawPSprite(const pspdef_t *psp,
       psp->state->sprite = blankSpriteNum;
       psp->state->frame = 0;
       // reset sprdef
-      sprdef = &sprites[psp->state->sprite];
+      sprdef = R_SpriteDef(psp->state->sprite);
    }
 
    sprframe = &sprdef->spriteframes[psp->state->frame & FF_FRAMEMASK];
@@ -1345,7 +1722,8 @@ static void R_drawPSprite(const pspdef_t *psp,
    }
    
    // store information in a vissprite
-   vis = &avis;
+   vis  = &pspritevis[numpspritevis++];
+   *vis = {};
    
    // killough 12/98: fix psprite positioning problem
    vis->texturemid = (BASEYCENTER<<FRACBITS) /* + FRACUNIT/2 */ -
@@ -1409,39 +1787,40 @@ static void R_drawPSprite(const pspdef_t *psp,
       }
       vis->colormap     = spritelights[MAXLIGHTSCALE-1];
    }
-   else if(r_globalcontext.cmapcontext.fixedcolormap)
-      vis->colormap = r_globalcontext.cmapcontext.fixedcolormap; // fixed color
+   else if(cmapcontext.fixedcolormap)
+      vis->colormap = cmapcontext.fixedcolormap; // fixed color
    else if(psp->state->frame & FF_FULLBRIGHT)
-      vis->colormap = r_globalcontext.cmapcontext.fullcolormap; // full bright // killough 3/20/98
+      vis->colormap = cmapcontext.fullcolormap; // full bright // killough 3/20/98
    else
       vis->colormap = spritelights[MAXLIGHTSCALE-1];  // local light
    
    if(psp->trans && general_translucency) // translucent gunflash
       vis->drawstyle = VS_DRAWSTYLE_TRANMAP;
-
-   oldycenter = view.ycenter;
-   view.ycenter = (view.height * 0.5f);
-   
-   R_drawVisSprite(r_globalcontext.bounds, vis, mfloorclip, mceilingclip);
-   
-   view.ycenter = oldycenter;
 }
 
 //
-// R_DrawPlayerSprites
+// R_PreparePlayerSprites
+//
+// Sets up the player gun sprites of the coming view, on the main thread,
+// for R_DrawPlayerSprites to draw in each context. Anything that has to be
+// looked up or fixed up is done here, so the contexts only read.
 //
-void R_DrawPlayerSprites()
+void R_PreparePlayerSprites()
 {
    int i, lightnum;
    const pspdef_t *psp;
    sector_t tmpsec;
    int floorlightlevel, ceilinglightlevel;
    lighttable_t **spritelights;
-   
+   cmapcontext_t cmapcontext = {};
+
+   numpspritevis = 0;
+
    // sf: psprite switch
-   if(!showpsprites || viewcamera) return;
-   
-   R_SectorColormap(r_globalcontext.cmapcontext, r_globalcontext.view.z, view.sector);
+   // psprites are not drawn on side views either
+   if(!showpsprites || viewcamera || viewangleoffset) return;
+
+   R_SectorColormap(cmapcontext, r_globalcontext.view.z, view.sector);
 
    // get light level
    // killough 9/18/98: compute lightlevel from floor and ceiling lightlevels
@@ -1452,11 +1831,11 @@ void R_DrawPlayerSprites()
                  + (extralight * LIGHTBRIGHT);
 
    if(lightnum < 0)
-      spritelights = r_globalcontext.cmapcontext.scalelight[0];
+      spritelights = cmapcontext.scalelight[0];
    else if(lightnum >= LIGHTLEVELS)
-      spritelights = r_globalcontext.cmapcontext.scalelight[LIGHTLEVELS-1];
+      spritelights = cmapcontext.scalelight[LIGHTLEVELS-1];
    else
-      spritelights = r_globalcontext.cmapcontext.scalelight[lightnum];
+      spritelights = cmapcontext.scalelight[lightnum];
 
    for(i = 0; i < viewwindow.width; ++i)
       pscreenheightarray[i] = view.height - 1.0f;
@@ -1465,49 +1844,158 @@ void R_DrawPlayerSprites()
    for(i = 0, psp = viewplayer->psprites; i < NUMPSPRITES; i++, psp++)
    {
       if(psp->state)
-         R_drawPSprite(psp, spritelights, pscreenheightarray, zeroarray);
+         R_projectPSprite(psp, cmapcontext, spritelights);
    }
 }
 
-#define bcopyp(d, s, n) memcpy(d, s, (n) * sizeof(void *))
-
 //
-// killough 9/2/98: merge sort
+// R_DrawPlayerSprites
+//
+// Draws the part of the player gun sprites within a context's columns, over
+// everything else it drew.
 //
-static void msort(vissprite_t **s, vissprite_t **t, int n)
+void R_DrawPlayerSprites(const contextbounds_t &bounds)
 {
-   if(n >= 16)
+   // psprites are centred on the middle of the view, not the sheared horizon
+   const float ycenteroffset = view.height * 0.5f - view.ycenter;
+
+   for(int i = 0; i < numpspritevis; i++)
    {
-      int n1 = n/2, n2 = n - n1;
-      vissprite_t **s1 = s, **s2 = s + n1, **d = t;
+      vissprite_t vis = pspritevis[i];
 
-      msort(s1, t, n1);
-      msort(s2, t, n2);
-      
-      while((*s1)->dist > (*s2)->dist ?
-            (*d++ = *s1++, --n1) : (*d++ = *s2++, --n2));
+      if(vis.x1 >= bounds.endcolumn || vis.x2 < bounds.startcolumn)
+         continue;
 
-      if(n2)
-         bcopyp(d, s2, n2);
-      else
-         bcopyp(d, s1, n1);
-      
-      bcopyp(s, t, n);
+      // step frac to the first column one at a time, as drawing would, so
+      // every column picks the same texel however the view is split up
+      for(; vis.x1 < bounds.startcolumn; vis.x1++)
+         vis.startx += vis.xstep;
+      vis.x2 = emin(vis.x2, bounds.endcolumn - 1);
+
+      R_drawVisSprite(bounds, &vis, pscreenheightarray, zeroarray, ycenteroffset);
+   }
+}
+
+//
+// Sprite sorting
+//
+// Vissprites are drawn farthest first. The sort key is dist mapped to an
+// unsigned integer that orders the same way, so that it can be sorted with a
+// stable LSD radix sort, one byte per pass.
+//
+// Earlier versions used killough's merge sort, which on equal keys takes from
+// the right-hand run first. Overlapping sprites at exactly the same distance
+// are common (stacked items, particles), so to keep output identical the
+// pointers are first laid out in the order that merge sort's recursion settles
+// ties in: its leaves of fewer than 16 sprites, last leaf first, each in BSP
+// order. Sorting that stably on the key alone then yields the same sequence.
+//
+
+static constexpr int VISSPRITELEAF  = 16; // leaf size of the old merge sort
+static constexpr int VISSPRITERADIX = 256;
+
+//
+// Maps dist to a key that sorts ascending in the order vissprites are drawn.
+//
+static inline uint32_t R_visSpriteKey(float dist)
+{
+   uint32_t bits;
+
+   dist += 0.0f; // -0 becomes +0, so it ties with +0 as it compares
+   memcpy(&bits, &dist, sizeof(bits));
+
+   // Order-preserving float to unsigned mapping, then reversed for descending
+   bits = (bits & 0x80000000u) ? ~bits : bits | 0x80000000u;
+   return ~bits;
+}
+
+//
+// Writes the n sprites starting at base to out in merge sort tie order.
+//
+static void R_seedVisSprites(vissprite_t **&out, vissprite_t *base, int n)
+{
+   if(n >= VISSPRITELEAF)
+   {
+      const int n1 = n / 2;
+
+      R_seedVisSprites(out, base + n1, n - n1);
+      R_seedVisSprites(out, base, n1);
    }
    else
    {
-      int i;
-      for(i = 1; i < n; i++)
+      for(int i = 0; i < n; i++)
+         *out++ = base + i;
+   }
+}
+
+//
+// Stable insertion sort for short ranges, where it matches the old merge
+// sort exactly and beats setting up the radix passes.
+//
+static void R_insertionSortVisSprites(vissprite_t **s, int n)
+{
+   for(int i = 1; i < n; i++)
+   {
+      vissprite_t *temp = s[i];
+      if(s[i-1]->dist < temp->dist)
       {
-         vissprite_t *temp = s[i];
-         if(s[i-1]->dist < temp->dist)
-         {
-            int j = i;
-            while((s[j] = s[j-1])->dist < temp->dist && --j);
-            s[j] = temp;
-         }
+         int j = i;
+         while((s[j] = s[j-1])->dist < temp->dist && --j);
+         s[j] = temp;
+      }
+   }
+}
+
+//
+// Sorts the n pointers in s by key, using t as scratch space for n pointers, and
+// keys/tkeys as the matching key storage. The result is left in s.
+//
+static void R_radixSortVisSprites(vissprite_t **s, vissprite_t **t,
+                                  uint32_t *keys, uint32_t *tkeys, int n)
+{
+   unsigned int counts[4][VISSPRITERADIX] = {};
+
+   for(int i = 0; i < n; i++)
+   {
+      const uint32_t key = keys[i] = R_visSpriteKey(s[i]->dist);
+
+      ++counts[0][ key        & 0xff];
+      ++counts[1][(key >>  8) & 0xff];
+      ++counts[2][(key >> 16) & 0xff];
+      ++counts[3][ key >> 24        ];
+   }
+
+   for(int pass = 0; pass < 4; pass++)
+   {
+      unsigned int *count = counts[pass];
+      const int     shift = pass * 8;
+
+      // Every key has the same byte here, so the pass wouldn't move anything
+      if(count[(keys[0] >> shift) & 0xff] == unsigned(n))
+         continue;
+
+      unsigned int offset = 0;
+      for(int b = 0; b < VISSPRITERADIX; b++)
+      {
+         const unsigned int c = count[b];
+         count[b] = offset;
+         offset += c;
       }
+
+      for(int i = 0; i < n; i++)
+      {
+         const unsigned int dest = count[(keys[i] >> shift) & 0xff]++;
+         t[dest]     = s[i];
+         tkeys[dest] = keys[i];
+      }
+
+      std::swap(s, t);
+      std::swap(keys, tkeys);
    }
+
+   // An odd number of passes leaves the result in the scratch half
+   if(s > t)
+      memcpy(t, s, n * sizeof(*s));
 }
 
 #if 0
@@ -1554,33 +2042,92 @@ static void R_sortVisSpriteRange(spritecontext_t &context, int first, int last)
    vissprite_t  *&vissprites          = context.vissprites;
    vissprite_t **&vissprite_ptrs      = context.vissprite_ptrs;
    size_t        &num_vissprite_alloc = context.num_vissprite_alloc;
+   uint32_t     *&vissprite_keys      = context.vissprite_keys;
    size_t        &num_vissprite_ptrs  = context.num_vissprite_ptrs;
 
    unsigned int numsprites = last - first;
    
    if(numsprites > 0)
    {
-      int i = numsprites;
-      
       // If we need to allocate more pointers for the vissprites,
       // allocate as many as were allocated for sprites -- killough
       // killough 9/22/98: allocate twice as many
       
       if(num_vissprite_ptrs < numsprites*2)
       {
-         efree(vissprite_ptrs);  // better than realloc -- no preserving needed
+         // no preserving needed
          num_vissprite_ptrs = num_vissprite_alloc * 2;
-         vissprite_ptrs = emalloc(vissprite_t **, 
-                                  num_vissprite_ptrs * sizeof *vissprite_ptrs);
+         vissprite_ptrs = R_FrameArenaArray<vissprite_t *>(*context.arena, num_vissprite_ptrs);
+         vissprite_keys = R_FrameArenaArray<uint32_t>(*context.arena, num_vissprite_ptrs);
       }
 
-      while(--i >= 0)
-         vissprite_ptrs[i] = vissprites+i+first;
+      if(numsprites < VISSPRITELEAF)
+      {
+         for(unsigned int i = 0; i < numsprites; i++)
+            vissprite_ptrs[i] = vissprites + first + i;
 
-      // killough 9/22/98: replace qsort with merge sort, since the keys
-      // are roughly in order to begin with, due to BSP rendering.
-      
-      msort(vissprite_ptrs, vissprite_ptrs + numsprites, numsprites);
+         R_insertionSortVisSprites(vissprite_ptrs, numsprites);
+      }
+      else
+      {
+         vissprite_t **out = vissprite_ptrs;
+
+         R_seedVisSprites(out, vissprites + first, numsprites);
+         R_radixSortVisSprites(vissprite_ptrs, vissprite_ptrs + numsprites,
+                               vissprite_keys, vissprite_keys + numsprites, numsprites);
+      }
+   }
+}
+
+//
+// Indexes the xrange entries by the column buckets they overlap, with a
+// counting sort so each bucket's list keeps xrange order.
+//
+static void R_bucketDrawSegs(spritecontext_t &spritecontext)
+{
+   const drawsegs_xrange_t *xrange = spritecontext.drawsegs_xrange;
+   const int count      = spritecontext.drawsegs_xrange_count;
+   const int numbuckets = ((viewwindow.width - 1) >> DSBUCKETSHIFT) + 1;
+   const int lastbucket = numbuckets - 1;
+
+   if(spritecontext.drawsegs_bucketsalloc < numbuckets)
+   {
+      spritecontext.drawsegs_bucketsalloc = numbuckets;
+      spritecontext.drawsegs_bucketstart =
+         R_FrameArenaArray<int>(*spritecontext.arena, 2 * (numbuckets + 1));
+   }
+   spritecontext.drawsegs_numbuckets = numbuckets;
+
+   int *start  = spritecontext.drawsegs_bucketstart;
+   int *cursor = start + numbuckets + 1;
+
+   memset(start, 0, (numbuckets + 1) * sizeof(int));
+   for(int i = 0; i < count; i++)
+   {
+      const int b1 = eclamp(xrange[i].x1 >> DSBUCKETSHIFT, 0, lastbucket);
+      const int b2 = eclamp(xrange[i].x2 >> DSBUCKETSHIFT, 0, lastbucket);
+      for(int b = b1; b <= b2; b++)
+         start[b + 1]++;
+   }
+   for(int b = 0; b < numbuckets; b++)
+      start[b + 1] += start[b];
+
+   const unsigned int total = unsigned(start[numbuckets]);
+   if(spritecontext.drawsegs_buckets_size < total)
+   {
+      spritecontext.drawsegs_buckets_size = 2 * total;
+      spritecontext.drawsegs_buckets =
+         R_FrameArenaArray<int>(*spritecontext.arena, 2 * total);
+   }
+
+   int *buckets = spritecontext.drawsegs_buckets;
+   memcpy(cursor, start, numbuckets * sizeof(int));
+   for(int i = 0; i < count; i++)
+   {
+      const int b1 = eclamp(xrange[i].x1 >> DSBUCKETSHIFT, 0, lastbucket);
+      const int b2 = eclamp(xrange[i].x2 >> DSBUCKETSHIFT, 0, lastbucket);
+      for(int b = b1; b <= b2; b++)
+         buckets[cursor[b]++] = i;
    }
 }
 
@@ -1659,27 +2206,79 @@ static void R_drawSpriteInDSRange(cmapcontext_t &cmapcontext, spritecontext_t &s
       }
    };
 
+   //
+   // Clips against one xrange entry, unless it neither overlaps the sprite nor
+   // can affect it from behind
+   //
+   auto handleXRange = [&](const drawsegs_xrange_t &dsx) {
+      if(dsx.x1 > spr->x2 || dsx.x2 < spr->x1)
+         return; // does not cover sprite
+      if(dsx.maxdist < spr->dist && !dsx.masked)
+         return; // entirely behind sprite, with nothing to draw
+
+      handleOverlappingDrawSeg(cmapcontext, viewpoint, dsx.user, spr);
+   };
+
+   const int firstbucket = spr->x1 >> DSBUCKETSHIFT;
+   const int lastbucket  = spr->x2 >> DSBUCKETSHIFT;
+
    // haleyjd 04/25/10:
    // e6y: optimization
-   if(spritecontext.drawsegs_xrange_count)
+   if(spritecontext.drawsegs_xrange_count && lastbucket - firstbucket < DSMAXMERGEBUCKETS &&
+      lastbucket < spritecontext.drawsegs_numbuckets)
    {
-      drawsegs_xrange_t *dsx = spritecontext.drawsegs_xrange;
+      const drawsegs_xrange_t *xrange = spritecontext.drawsegs_xrange;
+      const int *buckets = spritecontext.drawsegs_buckets;
+      const int *start   = spritecontext.drawsegs_bucketstart;
 
-      // drawsegs_xrange is sorted by ::x1
-      // haleyjd: way faster to use a pointer here
-      while((ds = dsx->user))
+      if(firstbucket == lastbucket)
       {
-         // determine if the drawseg obscures the sprite
-         if(dsx->x1 > spr->x2 || dsx->x2 < spr->x1)
+         for(int i = start[firstbucket]; i < start[firstbucket + 1]; i++)
+            handleXRange(xrange[buckets[i]]);
+      }
+      else
+      {
+         // Merge the buckets' lists back into xrange order, visiting a seg
+         // listed in several of them only once
+         int pos[DSMAXMERGEBUCKETS], end[DSMAXMERGEBUCKETS];
+         const int numlists = lastbucket - firstbucket + 1;
+
+         for(int b = 0; b < numlists; b++)
          {
-            ++dsx;
-            continue;      // does not cover sprite
+            pos[b] = start[firstbucket + b];
+            end[b] = start[firstbucket + b + 1];
          }
-         ++dsx;
 
-         handleOverlappingDrawSeg(cmapcontext, viewpoint, ds, spr);
+         for(;;)
+         {
+            int next = INT_MAX;
+            for(int b = 0; b < numlists; b++)
+            {
+               if(pos[b] < end[b] && buckets[pos[b]] < next)
+                  next = buckets[pos[b]];
+            }
+            if(next == INT_MAX)
+               break;
+
+            for(int b = 0; b < numlists; b++)
+            {
+               if(pos[b] < end[b] && buckets[pos[b]] == next)
+                  pos[b]++;
+            }
+
+            handleXRange(xrange[next]);
+         }
       }
    }
+   else if(spritecontext.drawsegs_xrange_count)
+   {
+      const drawsegs_xrange_t *dsx = spritecontext.drawsegs_xrange;
+
+      // drawsegs_xrange is in reverse drawseg order
+      // haleyjd: way faster to use a pointer here
+      for(; dsx->user; ++dsx)
+         handleXRange(*dsx);
+   }
    else
    {
       // Scan drawsegs from end to start for obscuring segs.
@@ -1794,6 +2393,7 @@ static void R_drawSpriteInDSRange(cmapcontext_t &cmapcontext, spritecontext_t &s
    // check for unclipped columns
 
    // THREAD_FIXME: Verify correctness
+   bool open = false;
    for(x = spr->x1; x <= spr->x2; x++)
    {
       if(clipbot[x] == CLIP_UNDEF || clipbot[x] > pbottom[x - bounds.startcolumn])
@@ -1801,9 +2401,15 @@ static void R_drawSpriteInDSRange(cmapcontext_t &cmapcontext, spritecontext_t &s
 
       if(cliptop[x] == CLIP_UNDEF || cliptop[x] < ptop[x - bounds.startcolumn])
          cliptop[x] = ptop[x - bounds.startcolumn];
+
+      // the drawn rows are truncated from these, so test them the same way
+      if((int)cliptop[x] <= (int)clipbot[x])
+         open = true;
    }
 
-   R_drawVisSprite(bounds, spr, clipbot, cliptop);
+   // nothing to draw if walls close every column
+   if(open)
+      R_drawVisSprite(bounds, spr, clipbot, cliptop);
 }
 
 //
@@ -1824,6 +2430,8 @@ void R_DrawPostBSP(rendercontext_t &context)
    maskedrange_t *masked;
    drawseg_t     *ds;
    int           firstds, lastds, firstsprite, lastsprite;
+
+   RenderProfileScope profile(RPROF_POSTBSP);
  
    while(pstacksize > 0)
    {
@@ -1856,22 +2464,26 @@ void R_DrawPostBSP(rendercontext_t &context)
                {
                   // haleyjd: fix reallocation to track 2x size
                   drawsegs_xrange_size =  2 * (maxdrawsegs+1);
-                  drawsegs_xrange = 
-                     erealloc(drawsegs_xrange_t *, drawsegs_xrange, 
-                              drawsegs_xrange_size * sizeof(*drawsegs_xrange));
+                  drawsegs_xrange = R_FrameArenaArray<drawsegs_xrange_t>(*spritecontext.arena,
+                                                                         drawsegs_xrange_size);
                }
                for(ds = drawsegs + lastds; ds-- > drawsegs + firstds; )
                {
                   if (ds->silhouette || ds->maskedtexturecol)
                   {
-                     drawsegs_xrange[drawsegs_xrange_count].x1   = ds->x1;
-                     drawsegs_xrange[drawsegs_xrange_count].x2   = ds->x2;
-                     drawsegs_xrange[drawsegs_xrange_count].user = ds;
+                     drawsegs_xrange_t &dsx = drawsegs_xrange[drawsegs_xrange_count];
+                     dsx.x1      = ds->x1;
+                     dsx.x2      = ds->x2;
+                     dsx.user    = ds;
+                     dsx.maxdist = emax(ds->dist1, ds->dist2);
+                     dsx.masked  = ds->maskedtexturecol != nullptr;
                      drawsegs_xrange_count++;
                   }
                }
                // haleyjd: terminate with a nullptr user for faster loop - adds ~3 FPS
                drawsegs_xrange[drawsegs_xrange_count].user = nullptr;
+
+               R_bucketDrawSegs(spritecontext);
             }
 
             for(int i = lastsprite - firstsprite; --i >= 0; )
@@ -1965,17 +2577,23 @@ void R_RemoveMobjProjections(Mobj *mobj)
 //
 // R_newProjNode
 //
-// Allocates a new node or picks a free one
+// Picks a free node, first filling the bin with a new slab of them if it's
+// empty. Nodes are never given back to the heap, only recycled.
 //
 static spriteprojnode_t *R_newProjNode()
 {
-   if(spriteprojfree.head)
+   static constexpr int PROJNODE_SLAB = 128;
+
+   if(!spriteprojfree.head)
    {
-      auto ret = spriteprojfree.head;
-      ret->remove();
-      return ret->dllObject;
+      spriteprojnode_t *slab = estructalloc(spriteprojnode_t, PROJNODE_SLAB);
+      for(int i = 0; i < PROJNODE_SLAB; i++)
+         spriteprojfree.insert(&slab[i]);
    }
-   return estructalloc(spriteprojnode_t, 1);
+
+   auto ret = spriteprojfree.head;
+   ret->remove();
+   return ret->dllObject;
 }
 
 //
@@ -2031,6 +2649,7 @@ struct mobjprojinfo_t
    DLListItem<spriteprojnode_t> **item;
    DLListItem<spriteprojnode_t> ***tail;
    fixed_t scaledbottom, scaledtop;
+   bool sawlines; // some portal line was in the cells
 };
 
 //
@@ -2038,7 +2657,8 @@ struct mobjprojinfo_t
 //
 static bool RIT_checkMobjProjection(const line_t &line, void *vdata)
 {
-   const auto &mpi = *static_cast<mobjprojinfo_t *>(vdata);
+   auto &mpi = *static_cast<mobjprojinfo_t *>(vdata);
+   mpi.sawlines = true;
    if(line.bbox[BOXLEFT] >= mpi.bbox[BOXRIGHT] ||
       line.bbox[BOXBOTTOM] >= mpi.bbox[BOXTOP] ||
       line.bbox[BOXRIGHT] <= mpi.bbox[BOXLEFT] ||
@@ -2083,20 +2703,57 @@ static bool RIT_checkMobjProjection(const line_t &line, void *vdata)
 //
 // R_CheckMobjProjections
 //
-// Looks above and below for portals and prepares projection nodes
+// Looks above and below for portals and prepares projection nodes. Line
+// portals are only looked for again once the thing's box sweeps other
+// blockmap cells than last time, unless those had portal lines in them.
 //
 void R_CheckMobjProjections(Mobj *mobj, bool checklines)
 {
    sector_t *sector = mobj->subsector->sector;
 
    bool overflown = (unsigned)mobj->sprite >= (unsigned)numsprites ||
-   (mobj->frame & FF_FRAMEMASK) >= sprites[mobj->sprite].numframes;
+   (mobj->frame & FF_FRAMEMASK) >= R_SpriteDef(mobj->sprite)->numframes;
 
    DLListItem<spriteprojnode_t> *item = mobj->spriteproj;
 
-   if(mobj->flags & MF_NOSECTOR || overflown ||
-      (!(sector->srf.floor.pflags & PS_PASSABLE) && !(sector->srf.ceiling.pflags & PS_PASSABLE) &&
-       !checklines))
+   if(mobj->flags & MF_NOSECTOR || overflown)
+   {
+      if(item)
+         R_RemoveMobjProjections(mobj);
+      return;
+   }
+
+   const spritespan_t &span =
+   r_spritespan[mobj->sprite][mobj->frame & FF_FRAMEMASK];
+
+   mobjprojinfo_t mpi;
+   fixed_t xspan = M_FloatToFixed(span.side * mobj->xscale);
+   if(mobj->prevpos.ldata)
+   {
+      mpi.bbox[BOXLEFT] = mobj->x - xspan;
+      mpi.bbox[BOXRIGHT] = mobj->x + xspan;
+      mpi.bbox[BOXBOTTOM] = mobj->y - xspan;
+      mpi.bbox[BOXTOP] = mobj->y + xspan;
+   }
+   else
+   {
+      mpi.bbox[BOXLEFT] = emin(mobj->x, mobj->prevpos.x) - xspan;
+      mpi.bbox[BOXRIGHT] = emax(mobj->x, mobj->prevpos.x) + xspan;
+      mpi.bbox[BOXBOTTOM] = emin(mobj->y, mobj->prevpos.y) - xspan;
+      mpi.bbox[BOXTOP] = emax(mobj->y, mobj->prevpos.y) + xspan;
+   }
+   int blockbox[4];
+   blockbox[BOXLEFT] = (mpi.bbox[BOXLEFT] - bmaporgx) >> MAPBLOCKSHIFT;
+   blockbox[BOXRIGHT] = (mpi.bbox[BOXRIGHT] - bmaporgx) >> MAPBLOCKSHIFT;
+   blockbox[BOXBOTTOM] = (mpi.bbox[BOXBOTTOM] - bmaporgy) >> MAPBLOCKSHIFT;
+   blockbox[BOXTOP] = (mpi.bbox[BOXTOP] - bmaporgy) >> MAPBLOCKSHIFT;
+
+   // Same cells as last time, which had no portal lines: none can be reached
+   const bool nolines = mobj->sprojlast.nolines &&
+      !memcmp(blockbox, mobj->sprojlast.blockbox, sizeof(blockbox));
+
+   if(!(sector->srf.floor.pflags & PS_PASSABLE) && !(sector->srf.ceiling.pflags & PS_PASSABLE) &&
+      (!checklines || nolines))
    {
       if(item)
          R_RemoveMobjProjections(mobj);
@@ -2107,9 +2764,6 @@ void R_CheckMobjProjections(Mobj *mobj, bool checklines)
 
    DLListItem<spriteprojnode_t> **tail = &mobj->spriteproj;
 
-   const spritespan_t &span =
-   r_spritespan[mobj->sprite][mobj->frame & FF_FRAMEMASK];
-
    fixed_t scaledtop = M_FloatToFixed(span.top * mobj->yscale + 0.5f);
    fixed_t scaledbottom = M_FloatToFixed(span.bottom * mobj->yscale - 0.5f);
 
@@ -2137,36 +2791,23 @@ void R_CheckMobjProjections(Mobj *mobj, bool checklines)
    }
 
    // Now check line portals
-   pLPortalMap.newSession();
-   mobjprojinfo_t mpi;
-   fixed_t xspan = M_FloatToFixed(span.side * mobj->xscale);
-   mpi.mobj = mobj;
-   if(mobj->prevpos.ldata)
-   {
-      mpi.bbox[BOXLEFT] = mobj->x - xspan;
-      mpi.bbox[BOXRIGHT] = mobj->x + xspan;
-      mpi.bbox[BOXBOTTOM] = mobj->y - xspan;
-      mpi.bbox[BOXTOP] = mobj->y + xspan;
-   }
-   else
+   if(!nolines)
    {
-      mpi.bbox[BOXLEFT] = emin(mobj->x, mobj->prevpos.x) - xspan;
-      mpi.bbox[BOXRIGHT] = emax(mobj->x, mobj->prevpos.x) + xspan;
-      mpi.bbox[BOXBOTTOM] = emin(mobj->y, mobj->prevpos.y) - xspan;
-      mpi.bbox[BOXTOP] = emax(mobj->y, mobj->prevpos.y) + xspan;
-   }
-   mpi.scaledbottom = scaledbottom;
-   mpi.scaledtop = scaledtop;
-   mpi.item = &item;
-   mpi.tail = &tail;
-   int bx1 = (mpi.bbox[BOXLEFT] - bmaporgx) >> MAPBLOCKSHIFT;
-   int bx2 = (mpi.bbox[BOXRIGHT] - bmaporgx) >> MAPBLOCKSHIFT;
-   int by1 = (mpi.bbox[BOXBOTTOM] - bmaporgy) >> MAPBLOCKSHIFT;
-   int by2 = (mpi.bbox[BOXTOP] - bmaporgy) >> MAPBLOCKSHIFT;
+      pLPortalMap.newSession();
+      mpi.mobj = mobj;
+      mpi.scaledbottom = scaledbottom;
+      mpi.scaledtop = scaledtop;
+      mpi.item = &item;
+      mpi.tail = &tail;
+      mpi.sawlines = false;
+
+      for(int by = blockbox[BOXBOTTOM]; by <= blockbox[BOXTOP]; ++by)
+         for(int bx = blockbox[BOXLEFT]; bx <= blockbox[BOXRIGHT]; ++bx)
+            pLPortalMap.iterator(bx, by, &mpi, RIT_checkMobjProjection);
 
-   for(int by = by1; by <= by2; ++by)
-      for(int bx = bx1; bx <= bx2; ++bx)
-         pLPortalMap.iterator(bx, by, &mpi, RIT_checkMobjProjection);
+      memcpy(mobj->sprojlast.blockbox, blockbox, sizeof(blockbox));
+      mobj->sprojlast.nolines = !mpi.sawlines;
+   }
 
    // remove trailing items
    DLListItem<spriteprojnode_t> *next;
@@ -2250,12 +2891,27 @@ void R_ClearParticles()
    Particles[i].next = -1;
 }
 
+//
+// Lighting shared by all particles of a sector. R_SectorColormap and
+// R_FakeFlat give the same result for each of them, so they only run for the
+// first particle that needs them.
+//
+struct particlelight_t
+{
+   bool           ready;
+   lighttable_t **ltable;
+};
+
 //
 // R_projectParticle
 //
+// Takes the particle rotated into view space by R_projectParticles, already
+// known to lie past the front view plane.
+//
 static void R_projectParticle(cmapcontext_t &cmapcontext, spritecontext_t &spritecontext,
                               const viewpoint_t &viewpoint, const cbviewpoint_t &cb_viewpoint,
-                              const contextbounds_t &bounds, particle_t *particle)
+                              const contextbounds_t &bounds, particle_t *particle,
+                              const float tx1, const float ty1, particlelight_t &light)
 {
    fixed_t gzt;
    int x1, x2;
@@ -2263,25 +2919,10 @@ static void R_projectParticle(cmapcontext_t &cmapcontext, spritecontext_t &sprit
    sector_t    *sector = nullptr;
    int heightsec = -1;
    
-   float tempx, tempy, ty1, tx1, tx2, tz;
+   float tx2, tz;
    float idist, xscale, yscale;
    float y1, y2;
 
-   // SoM: Cardboard translate the mobj coords and just project the sprite.
-   tempx = M_FixedToFloat(particle->x) - cb_viewpoint.x;
-   tempy = M_FixedToFloat(particle->y) - cb_viewpoint.y;
-   ty1   = (tempy * cb_viewpoint.cos) + (tempx * cb_viewpoint.sin);
-
-   // lies in front of the front view plane
-   if(ty1 < 1.0f)
-      return;
-
-   // invisible?
-   if(!particle->trans)
-      return;
-
-   tx1 = (tempx * cb_viewpoint.cos) - (tempy * cb_viewpoint.sin);
-
    tx2 = tx1 + 1.0f;
 
    idist = 1.0f / ty1;
@@ -2371,39 +3012,121 @@ static void R_projectParticle(cmapcontext_t &cmapcontext, spritecontext_t &sprit
    } 
    else
    {
-      R_SectorColormap(cmapcontext, viewpoint.z, sector);
-
-      if(LevelInfo.useFullBright && (particle->styleflags & PS_FULLBRIGHT))
-      {
-         vis->colormap = cmapcontext.fullcolormap;
-      }
-      else
+      if(!light.ready)
       {
-         lighttable_t **ltable;
          sector_t tmpsec;
-         int floorlightlevel, ceilinglightlevel, lightnum, index;
+         int floorlightlevel, ceilinglightlevel, lightnum;
 
+         R_SectorColormap(cmapcontext, viewpoint.z, sector);
          R_FakeFlat(viewpoint.z, sector, &tmpsec, &floorlightlevel, &ceilinglightlevel, false);
 
          lightnum = (floorlightlevel + ceilinglightlevel) / 2;
          lightnum = (lightnum >> LIGHTSEGSHIFT) + (extralight * LIGHTBRIGHT);
-         
+
          if(lightnum >= LIGHTLEVELS || cmapcontext.fixedcolormap)
-            ltable = cmapcontext.scalelight[LIGHTLEVELS - 1];
+            light.ltable = cmapcontext.scalelight[LIGHTLEVELS - 1];
          else if(lightnum < 0)
-            ltable = cmapcontext.scalelight[0];
+            light.ltable = cmapcontext.scalelight[0];
          else
-            ltable = cmapcontext.scalelight[lightnum];
-         
-         index = (int)(idist * 2560.0f);
+            light.ltable = cmapcontext.scalelight[lightnum];
+         light.ready = true;
+      }
+
+      if(LevelInfo.useFullBright && (particle->styleflags & PS_FULLBRIGHT))
+      {
+         vis->colormap = cmapcontext.fullcolormap;
+      }
+      else
+      {
+         int index = (int)(idist * 2560.0f);
          if(index >= MAXLIGHTSCALE)
             index = MAXLIGHTSCALE - 1;
          
-         vis->colormap = ltable[index];
+         vis->colormap = light.ltable[index];
       }
    }
 }
 
+//
+// Projects every particle of a sector. Visible particles are gathered into
+// the context's position arrays and rotated into view space together, then
+// those past the front view plane are projected one by one.
+//
+static void R_projectParticles(cmapcontext_t &cmapcontext, spritecontext_t &spritecontext,
+                               const viewpoint_t &viewpoint, const cbviewpoint_t &cb_viewpoint,
+                               const contextbounds_t &bounds, sector_t *sec)
+{
+   unsigned int count = 0;
+
+   for(DLListItem<particle_t> *link = sec->ptcllist; link; link = link->dllNext)
+   {
+      particle_t *particle = *link;
+
+      // invisible?
+      if(!particle->trans)
+         continue;
+
+      if(count == spritecontext.particle_alloc)
+      {
+         rframearena_t &arena    = *spritecontext.arena;
+         const unsigned newalloc = count ? count * 2 : 128;
+
+         spritecontext.particle_list = R_FrameArenaGrow(arena, spritecontext.particle_list, count, newalloc);
+         spritecontext.particle_x    = R_FrameArenaGrow(arena, spritecontext.particle_x, count, newalloc);
+         spritecontext.particle_y    = R_FrameArenaGrow(arena, spritecontext.particle_y, count, newalloc);
+         spritecontext.particle_alloc = newalloc;
+      }
+
+      spritecontext.particle_list[count] = particle;
+      spritecontext.particle_x[count]    = M_FixedToFloat(particle->x);
+      spritecontext.particle_y[count]    = M_FixedToFloat(particle->y);
+      ++count;
+   }
+
+   // SoM: Cardboard translate the coords. x becomes the horizontal offset and
+   // y the depth.
+   float *const px = spritecontext.particle_x;
+   float *const py = spritecontext.particle_y;
+   unsigned int i = 0;
+
+#if defined(EE_SIMD_SSE2)
+   const __m128 vx   = _mm_set1_ps(cb_viewpoint.x);
+   const __m128 vy   = _mm_set1_ps(cb_viewpoint.y);
+   const __m128 vcos = _mm_set1_ps(cb_viewpoint.cos);
+   const __m128 vsin = _mm_set1_ps(cb_viewpoint.sin);
+
+   for(; i + 4 <= count; i += 4)
+   {
+      const __m128 tempx = _mm_sub_ps(_mm_loadu_ps(px + i), vx);
+      const __m128 tempy = _mm_sub_ps(_mm_loadu_ps(py + i), vy);
+
+      _mm_storeu_ps(py + i, _mm_add_ps(_mm_mul_ps(tempy, vcos), _mm_mul_ps(tempx, vsin)));
+      _mm_storeu_ps(px + i, _mm_sub_ps(_mm_mul_ps(tempx, vcos), _mm_mul_ps(tempy, vsin)));
+   }
+#endif
+
+   for(; i < count; i++)
+   {
+      const float tempx = px[i] - cb_viewpoint.x;
+      const float tempy = py[i] - cb_viewpoint.y;
+
+      py[i] = (tempy * cb_viewpoint.cos) + (tempx * cb_viewpoint.sin);
+      px[i] = (tempx * cb_viewpoint.cos) - (tempy * cb_viewpoint.sin);
+   }
+
+   particlelight_t light = { false, nullptr };
+
+   for(i = 0; i < count; i++)
+   {
+      // lies in front of the front view plane
+      if(py[i] < 1.0f)
+         continue;
+
+      R_projectParticle(cmapcontext, spritecontext, viewpoint, cb_viewpoint, bounds,
+                        spritecontext.particle_list[i], px[i], py[i], light);
+   }
+}
+
 //
 // haleyjd: this function had to be mostly rewritten
 //
@@ -2454,6 +3177,29 @@ static void R_drawParticle(const contextbounds_t &bounds, vissprite_t *vis,
       spacing = video.pitch - ycount;
       dest    = R_ADDRESS(x1, yl);
 
+      if(r_truecolorview)
+      {
+         const unsigned int alpha = general_translucency && particle_trans ?
+            ((unsigned int)(vis->translucency) + 1) >> 8 : 256;
+         const uint32_t fg = Col2RGB32[color];
+         uint32_t *dest32  = R_ADDRESS32(x1, yl);
+
+         do // step in y
+         {
+            int count = ycount;
+
+            do // step in x
+            {
+               *dest32 = R_BlendTrueColor(fg, *dest32, alpha);
+               ++dest32;
+            }
+            while(--count);
+            dest32 += spacing;
+         }
+         while(--xcount);
+         return;
+      }
+
       // haleyjd 02/08/05: rewritten to remove inner loop invariants
       if(general_translucency && particle_trans)
       {
@@ -42,6 +42,7 @@ struct cbviewpoint_t;
 struct bspcontext_t;
 struct cmapcontext_t;
 struct rendercontext_t;
+struct spritedef_t;
 
 using R_ColumnFunc = void (*)(cb_column_t &);
 
@@ -92,9 +93,13 @@ void R_AddSprites(cmapcontext_t &cmapcontext,
                   const portalrender_t &portalrender,
                   sector_t *sec, int); // killough 9/18/98
 void R_InitSprites(char **namelist);
+spritedef_t *R_SpriteDef(int sprite);
 void R_ClearSprites(spritecontext_t &context);
+size_t R_SpriteFrameArenaBytes(const spritecontext_t &context);
+void R_CarveSpriteFrameArrays(spritecontext_t &context);
 void R_DrawPostBSP(rendercontext_t &context);
-void R_DrawPlayerSprites();
+void R_PreparePlayerSprites();
+void R_DrawPlayerSprites(const contextbounds_t &bounds);
 void R_ClearParticles(void);
 void R_InitParticles(void);
 particle_t *newParticle(void);
@@ -25,12 +25,175 @@
 //-----------------------------------------------------------------------------
 
 #include "z_zone.h"
+#include "autopalette.h"
+#include "c_io.h"
+#include "d_io.h"
 #include "doomtype.h"
+#include "m_compare.h"
+#include "m_ctype.h"
 #include "m_swap.h"
+#include "p_skin.h"
+#include "r_defs.h"
+#include "r_draw.h"
+#include "r_draw32.h"
+#include "r_main.h"
+#include "r_state.h"
+#include "r_things.h"
+#include "v_misc.h"
+#include "v_video.h"
+#include "w_iterator.h"
 #include "w_wad.h"
 
 #include "r_voxels.h"
 
+// Voxel marking an empty cell in .vox data
+#define VOXEL_EMPTY 255
+
+// Largest dimension accepted, so that slab coordinates fit
+#define VOXEL_MAXSIZE 256
+
+bool r_drawvoxels = true;
+
+// Models bound to sprite frames, per sprite; nullptr for sprites without any
+static rvoxelmodel_t ***voxelframes;
+
+//
+// Turns one dense level, indexed [x][y][z] with z counting down from the top,
+// into slabs of game palette colors.
+//
+static void R_buildVoxelLevel(rvoxellevel_t &level, const byte *dense,
+                              int xsize, int ysize, int zsize, const byte *remap)
+{
+   const int numcolumns = xsize * ysize;
+   int numslabs = 0, numcolors = 0;
+
+   // count first so everything is allocated once
+   for(int c = 0; c < numcolumns; c++)
+   {
+      const byte *column = dense + c * zsize;
+      for(int z = 0; z < zsize; z++)
+      {
+         if(column[z] == VOXEL_EMPTY)
+            continue;
+         ++numcolors;
+         if(!z || column[z - 1] == VOXEL_EMPTY)
+            ++numslabs;
+      }
+   }
+
+   level.xsize   = xsize;
+   level.ysize   = ysize;
+   level.zsize   = zsize;
+   level.columns = emalloctag(int *, (numcolumns + 1) * sizeof(int), PU_RENDERER, nullptr);
+   level.slabs   = emalloctag(rvoxelslab_t *, emax(numslabs, 1) * sizeof(rvoxelslab_t),
+                              PU_RENDERER, nullptr);
+   level.colors  = emalloctag(byte *, emax(numcolors, 1), PU_RENDERER, nullptr);
+
+   int slab = 0, color = 0;
+   for(int c = 0; c < numcolumns; c++)
+   {
+      const byte *column = dense + c * zsize;
+
+      level.columns[c] = slab;
+      for(int z = 0; z < zsize; )
+      {
+         if(column[z] == VOXEL_EMPTY)
+         {
+            ++z;
+            continue;
+         }
+
+         rvoxelslab_t &run = level.slabs[slab++];
+         run.ztop  = int16_t(z);
+         run.color = color;
+         while(z < zsize && column[z] != VOXEL_EMPTY)
+            level.colors[color++] = remap[column[z++]];
+         run.zlen = int16_t(z - run.ztop);
+      }
+   }
+   level.columns[numcolumns] = slab;
+}
+
+//
+// Halves a dense level in every dimension. Each cell takes the color of the
+// topmost solid voxel it covers, since tops are what is usually seen.
+//
+static void R_halveVoxels(const byte *src, int xsize, int ysize, int zsize,
+                          byte *dest, int nxsize, int nysize, int nzsize)
+{
+   for(int x = 0; x < nxsize; x++)
+   {
+      for(int y = 0; y < nysize; y++)
+      {
+         for(int z = 0; z < nzsize; z++)
+         {
+            byte result = VOXEL_EMPTY;
+
+            for(int sz = z * 2; sz < emin(z * 2 + 2, zsize) && result == VOXEL_EMPTY; sz++)
+            {
+               for(int sx = x * 2; sx < emin(x * 2 + 2, xsize) && result == VOXEL_EMPTY; sx++)
+               {
+                  for(int sy = y * 2; sy < emin(y * 2 + 2, ysize); sy++)
+                  {
+                     const byte v = src[(sx * ysize + sy) * zsize + sz];
+                     if(v != VOXEL_EMPTY)
+                     {
+                        result = v;
+                        break;
+                     }
+                  }
+               }
+            }
+
+            dest[(x * nysize + y) * nzsize + z] = result;
+         }
+      }
+   }
+}
+
+//
+// Converts the model's palette to the game's and builds its mip levels.
+//
+static void R_buildVoxelLevels(rvoxelmodel_t *model)
+{
+   byte remap[256];
+
+   {
+      AutoPalette pal(wGlobalDir);
+      for(int i = 0; i < 256; i++)
+      {
+         remap[i] = V_FindBestColor(pal.get(), model->palette[i * 3],
+                                    model->palette[i * 3 + 1], model->palette[i * 3 + 2]);
+      }
+   }
+
+   int xsize = model->xsize, ysize = model->ysize, zsize = model->zsize;
+   const byte *dense = model->voxels;
+   byte *scratch = nullptr;
+
+   model->numlevels = 0;
+   for(;;)
+   {
+      R_buildVoxelLevel(model->levels[model->numlevels++], dense, xsize, ysize, zsize, remap);
+
+      if(model->numlevels == RVOXMAXLEVELS || (xsize <= 2 && ysize <= 2 && zsize <= 2))
+         break;
+
+      const int nxsize = (xsize + 1) / 2, nysize = (ysize + 1) / 2, nzsize = (zsize + 1) / 2;
+      byte *halved = emalloc(byte *, nxsize * nysize * nzsize);
+
+      R_halveVoxels(dense, xsize, ysize, zsize, halved, nxsize, nysize, nzsize);
+      if(scratch)
+         efree(scratch);
+      dense = scratch = halved;
+      xsize = nxsize;
+      ysize = nysize;
+      zsize = nzsize;
+   }
+   if(scratch)
+      efree(scratch);
+}
+
 //
 // R_LoadVoxelResource
 //
@@ -59,6 +222,13 @@ rvoxelmodel_t *R_LoadVoxelResource(int lumpnum)
    zsize = SwapLong(*(int32_t *)rover);
    rover += 4;
 
+   if(xsize <= 0 || ysize <= 0 || zsize <= 0 ||
+      xsize > VOXEL_MAXSIZE || ysize > VOXEL_MAXSIZE || zsize > VOXEL_MAXSIZE)
+   {
+      Z_ChangeTag(buffer, PU_CACHE);
+      return nullptr;
+   }
+
    voxsize = xsize*ysize*zsize;
 
    // true size test
@@ -88,14 +258,234 @@ rvoxelmodel_t *R_LoadVoxelResource(int lumpnum)
    for(i = 0; i < 768; i++)
       model->palette[i] <<= 2;
 
-   // TODO: run V_FindBestColor to create translated palette?
-
    // done with lump
    Z_ChangeTag(buffer, PU_CACHE);
 
+   R_buildVoxelLevels(model);
+
    return model;
 }
 
+//
+// R_InitVoxels
+//
+// Binds every model in the voxels namespace to the sprite frame it is named
+// after, as in POSSA. The model stands in for all rotations of that frame.
+//
+void R_InitVoxels()
+{
+   voxelframes = ecalloctag(rvoxelmodel_t ***, numsprites, sizeof(*voxelframes),
+                            PU_RENDERER, nullptr);
+
+   WadNamespaceIterator nsi(wGlobalDir, lumpinfo_t::ns_voxels);
+
+   for(nsi.begin(); nsi.current(); nsi.next())
+   {
+      const lumpinfo_t *lump = *nsi;
+      const char *name = lump->name;
+
+      if(strlen(name) != 5 && !(strlen(name) == 6 && name[5] == '0'))
+         continue;
+
+      const unsigned int frame = unsigned(ectype::toUpper(name[4]) - 'A');
+      int sprite;
+      for(sprite = 0; sprite < numsprites; sprite++)
+      {
+         if(!strncasecmp(name, spritelist[sprite], 4))
+            break;
+      }
+      if(sprite == numsprites || frame >= unsigned(R_SpriteDef(sprite)->numframes))
+         continue;
+
+      rvoxelmodel_t *model = R_LoadVoxelResource(lump->selfindex);
+      if(!model)
+      {
+         C_Printf(FC_ERROR "R_InitVoxels: invalid voxel model %.8s\n", name);
+         continue;
+      }
+
+      if(!voxelframes[sprite])
+      {
+         voxelframes[sprite] = ecalloctag(rvoxelmodel_t **, sprites[sprite].numframes,
+                                          sizeof(**voxelframes), PU_RENDERER, nullptr);
+      }
+      voxelframes[sprite][frame] = model;
+   }
+}
+
+//
+// R_VoxelForFrame
+//
+// Returns the model drawn in place of a valid sprite frame, if any.
+//
+const rvoxelmodel_t *R_VoxelForFrame(int sprite, int frame)
+{
+   if(!r_drawvoxels || !voxelframes || !voxelframes[sprite])
+      return nullptr;
+
+   return voxelframes[sprite][frame];
+}
+
+//
+// Fills [top, bottom) of one view column with a voxel's color, within the
+// sprite clipping.
+//
+static inline void R_drawVoxelRun(int x, float top, float bottom, byte color,
+                                  const float *const mfloorclip,
+                                  const float *const mceilingclip)
+{
+   if(top < mceilingclip[x])
+      top = mceilingclip[x];
+   bottom -= 1.0f;
+   if(bottom > mfloorclip[x])
+      bottom = mfloorclip[x];
+
+   const int yl = emax(int(top), 0);
+   const int yh = emin(int(bottom), viewwindow.height - 1);
+   if(yl > yh)
+      return;
+
+   int count = yh - yl + 1;
+   if(r_truecolorview)
+   {
+      const uint32_t fg = Col2RGB32[color];
+      uint32_t *dest = R_ADDRESS32(x, yl);
+      do
+         *dest++ = fg;
+      while(--count);
+   }
+   else
+   {
+      byte *dest = R_ADDRESS(x, yl);
+      do
+         *dest++ = color;
+      while(--count);
+   }
+}
+
+//
+// R_DrawVoxel
+//
+// Draws a model into columns x1 to x2, which must lie inside the current
+// context. The level is chosen so that a voxel covers at least about a
+// pixel. Columns are drawn back to front around the viewer's position in
+// model space, each as screen-aligned slabs spanning the column's near and far
+// depth so that tops and bottoms are filled in.
+//
+void R_DrawVoxel(const rvoxelview_t &voxel, const lighttable_t *colormap,
+                 const byte *translation, int x1, int x2,
+                 const float *const mfloorclip, const float *const mceilingclip)
+{
+   const rvoxelmodel_t &model = *voxel.model;
+   const float len2   = voxel.axx * voxel.axx + voxel.axy * voxel.axy;
+   const float pixels = sqrtf(len2) * view.xfoc / voxel.cy;
+
+   int lvl = 0;
+   while(lvl + 1 < model.numlevels && pixels * float(1 << lvl) < 1.0f)
+      ++lvl;
+
+   const rvoxellevel_t &level = model.levels[lvl];
+   const float span = float(1 << lvl);
+
+   // view space steps between columns of this level, and column (0, 0)
+   const float sxx = voxel.axx * span, sxy = voxel.axy * span;
+   const float syx = voxel.ayx * span, syy = voxel.ayy * span;
+   const float ofsx = 0.5f * (span - model.xsize), ofsy = 0.5f * (span - model.ysize);
+   const float ox = voxel.cx + voxel.axx * ofsx + voxel.ayx * ofsy;
+   const float oy = voxel.cy + voxel.axy * ofsx + voxel.ayy * ofsy;
+
+   // half the column footprint across and in depth
+   const float halfwidth = 0.5f * (fabsf(sxx) + fabsf(syx));
+   const float halfdepth = 0.5f * (fabsf(sxy) + fabsf(syy));
+
+   const float top   = voxel.z + model.zsize * voxel.zstep;
+   const float zstep = voxel.zstep * span;
+
+   // the viewer is at the view space origin; find its column
+   const float fi = (-(voxel.cx * voxel.axx + voxel.cy * voxel.axy) / len2 +
+                     0.5f * model.xsize) / span;
+   const float fj = (-(voxel.cx * voxel.ayx + voxel.cy * voxel.ayy) / len2 +
+                     0.5f * model.ysize) / span;
+   const int ci = int(eclamp(floorf(fi), -1.0f, float(level.xsize)));
+   const int cj = int(eclamp(floorf(fj), -1.0f, float(level.ysize)));
+
+   float bounds[VOXEL_MAXSIZE + 1];
+
+   auto drawColumn = [&](int i, int j) {
+      const int first = level.columns[i * level.ysize + j];
+      const int last  = level.columns[i * level.ysize + j + 1];
+      if(first == last)
+         return;
+
+      const float px = ox + i * sxx + j * syx;
+      const float py = oy + i * sxy + j * syy;
+      const float nearz = py - halfdepth, farz = py + halfdepth;
+      if(nearz < 1.0f)
+         return;
+
+      const float left  = px - halfwidth, right = px + halfwidth;
+      const float fx1   = view.xcenter + left  * view.xfoc / (left  < 0.0f ? nearz : farz);
+      const float fx2   = view.xcenter + right * view.xfoc / (right < 0.0f ? farz : nearz);
+      if(fx2 < x1 || fx1 > x2 + 1)
+         return;
+
+      int cx1 = int(ceilf(fx1 - 0.5f));
+      int cx2 = int(ceilf(fx2 - 0.5f)) - 1;
+      if(cx2 < cx1)
+         cx2 = cx1;
+      cx1 = emax(cx1, x1);
+      cx2 = emin(cx2, x2);
+
+      const float yfocnear = view.yfoc / nearz, yfocfar = view.yfoc / farz;
+      const float yfoc     = view.yfoc / py;
+
+      for(int s = first; s < last; s++)
+      {
+         const rvoxelslab_t &slab = level.slabs[s];
+         const byte *colors = level.colors + slab.color;
+         const float zt = top - slab.ztop * zstep;
+         const float zb = zt - slab.zlen * zstep;
+
+         // voxel boundaries at the column's depth, the ends out to its faces
+         bounds[0] = view.ycenter - zt * (zt > 0.0f ? yfocnear : yfocfar);
+         for(int k = 1; k < slab.zlen; k++)
+            bounds[k] = view.ycenter - (zt - k * zstep) * yfoc;
+         bounds[slab.zlen] = view.ycenter - zb * (zb > 0.0f ? yfocfar : yfocnear);
+
+         if(bounds[slab.zlen] < 0.0f || bounds[0] >= viewwindow.height)
+            continue;
+
+         for(int x = cx1; x <= cx2; x++)
+         {
+            for(int k = 0; k < slab.zlen; k++)
+            {
+               const byte c = translation ? translation[colors[k]] : colors[k];
+               R_drawVoxelRun(x, bounds[k], bounds[k + 1], colormap[c],
+                              mfloorclip, mceilingclip);
+            }
+         }
+      }
+   };
+
+   auto drawRow = [&](int i) {
+      int j;
+      for(j = 0; j < cj; j++)
+         drawColumn(i, j);
+      for(j = level.ysize - 1; j > cj; j--)
+         drawColumn(i, j);
+      if(cj >= 0 && cj < level.ysize)
+         drawColumn(i, cj);
+   };
+
+   int i;
+   for(i = 0; i < ci; i++)
+      drawRow(i);
+   for(i = level.xsize - 1; i > ci; i--)
+      drawRow(i);
+   if(ci >= 0 && ci < level.xsize)
+      drawRow(ci);
+}
+
 // EOF
 
 
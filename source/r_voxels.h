@@ -22,21 +22,76 @@
 //--------------------------------------------------------------------------
 //
 // DESCRIPTION:
+//   Voxel models, drawn in place of sprite frames.
 //
 //-----------------------------------------------------------------------------
 
 #ifndef R_VOXELS_H__
 #define R_VOXELS_H__
 
+#include "doomtype.h"
+#include "r_lighting.h"
+
+// Number of mip levels kept per model, each half the size of the last
+#define RVOXMAXLEVELS 4
+
+//
+// A vertical run of solid voxels in one column of a model
+//
+struct rvoxelslab_t
+{
+   int16_t ztop;  // first voxel, counting down from the top of the model
+   int16_t zlen;  // number of voxels
+   int32_t color; // offset of the run's colors in the level's color buffer
+};
+
+//
+// One mip level of a model, stored as slabs per (x, y) column
+//
+struct rvoxellevel_t
+{
+   int  xsize, ysize, zsize;
+   int *columns;        // xsize * ysize + 1 slab offsets, x major
+   rvoxelslab_t *slabs;
+   byte *colors;        // game palette indices
+};
+
 struct rvoxelmodel_t
 {
    int  xsize, ysize, zsize; // dimensions
    byte *voxels;             // three-dimensional voxel buffer
    byte palette[768];        // original palette
+
+   int numlevels;
+   rvoxellevel_t levels[RVOXMAXLEVELS];
 };
 
+//
+// Placement of a model in view space, as worked out for its vissprite. The
+// model's columns are laid out along the two axes from its center, and it
+// stands on z.
+//
+struct rvoxelview_t
+{
+   const rvoxelmodel_t *model;
+   float cx, cy;     // view space center
+   float axx, axy;   // view space step per voxel along the model's x
+   float ayx, ayy;   // view space step per voxel along the model's y
+   float z;          // bottom, relative to the view height
+   float zstep;      // height of a voxel
+};
+
+extern bool r_drawvoxels;
+
+rvoxelmodel_t *R_LoadVoxelResource(int lumpnum);
+void R_InitVoxels();
+const rvoxelmodel_t *R_VoxelForFrame(int sprite, int frame);
+
+void R_DrawVoxel(const rvoxelview_t &voxel, const lighttable_t *colormap,
+                 const byte *translation, int x1, int x2,
+                 const float *const mfloorclip, const float *const mceilingclip);
+
 #endif
 
 // EOF
 
-
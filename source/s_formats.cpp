@@ -26,13 +26,19 @@
 //
 //-----------------------------------------------------------------------------
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
 #include "z_zone.h"
 
 #include "doomtype.h"
 #include "d_gi.h"
+#include "d_jobs.h"
 #include "m_binary.h"
 #include "m_compare.h"
 #include "m_swap.h"
+#include "s_formats.h"
 #include "s_sound.h"
 #include "w_wad.h"
 
@@ -325,26 +331,23 @@ static unsigned int S_alenForSample(const sounddata_t &sd)
 //
 // S_convertPCMU8
 //
-// Convert unsigned 8-bit PCM to double precision floating point.
+// Convert unsigned 8-bit PCM to floating point at the output samplerate,
+// writing alen samples to dest.
 //
-static void S_convertPCMU8(sfxinfo_t *sfx, const sounddata_t &sd)
+static void S_convertPCMU8(float *dest, unsigned int alen, const sounddata_t &sd)
 {
-   sfx->alen = S_alenForSample(sd);
-   sfx->data = Z_Malloc(sfx->alen*sizeof(float), PU_STATIC, &sfx->data);
-
    // haleyjd 12/18/13: Convert sound to target samplerate and into floating
    // point samples.
-   if(sfx->alen != sd.samplecount)
+   if(alen != sd.samplecount)
    {
       unsigned int i;
-      float *dest = static_cast<float *>(sfx->data);
       byte  *src  = sd.samplestart;
 
       unsigned int step = (sd.samplerate << 16) / TARGETSAMPLERATE;
       unsigned int stepremainder = 0, j = 0;
 
       // do linear filtering operation
-      for(i = 0; i < sfx->alen && j < sd.samplecount - 1; i++)
+      for(i = 0; i < alen && j < sd.samplecount - 1; i++)
       {
          dest[i] = 0.0f;
          for(unsigned int k = 0; k < sd.channels; k++)
@@ -363,7 +366,7 @@ static void S_convertPCMU8(sfxinfo_t *sfx, const sounddata_t &sd)
          stepremainder &= 0xffff;
       }
       // fill remainder (if any) with final sample byte
-      for(; i < sfx->alen; i++)
+      for(; i < alen; i++)
       {
          dest[i] = 0.0f;
          for(unsigned int k = 0; k < sd.channels; k++)
@@ -375,10 +378,9 @@ static void S_convertPCMU8(sfxinfo_t *sfx, const sounddata_t &sd)
    else
    {
       // sound is already at target samplerate, just convert to doubles
-      float *dest = static_cast<float *>(sfx->data);
       byte  *src  = sd.samplestart;
 
-      for(unsigned int i = 0; i < sfx->alen; i++)
+      for(unsigned int i = 0; i < alen; i++)
       {
          dest[i] = 0.0f;
          for(unsigned int j = 0; j < sd.channels; j++)
@@ -392,26 +394,23 @@ static void S_convertPCMU8(sfxinfo_t *sfx, const sounddata_t &sd)
 //
 // S_convertPCM16
 //
-// Convert signed 16-bit PCM to double precision floating point.
+// Convert signed 16-bit PCM to floating point at the output samplerate,
+// writing alen samples to dest.
 //
-static void S_convertPCM16(sfxinfo_t *sfx, const sounddata_t &sd)
+static void S_convertPCM16(float *dest, unsigned int alen, const sounddata_t &sd)
 {
-   sfx->alen = S_alenForSample(sd);
-   sfx->data = Z_Malloc(sfx->alen*sizeof(float), PU_STATIC, &sfx->data);
-
    // haleyjd 12/18/13: Convert sound to target samplerate and into floating
    // point samples.
-   if(sfx->alen != sd.samplecount)
+   if(alen != sd.samplecount)
    {
       unsigned int i;
-      float   *dest = static_cast<float *>(sfx->data);
       int16_t *src  = reinterpret_cast<int16_t *>(sd.samplestart);
 
       unsigned int step = (sd.samplerate << 16) / TARGETSAMPLERATE;
       unsigned int stepremainder = 0, j = 0;
 
       // do linear filtering operation
-      for(i = 0; i < sfx->alen && j < sd.samplecount - 1; i++)
+      for(i = 0; i < alen && j < sd.samplecount - 1; i++)
       {
          dest[i] = 0.0f;
          for(unsigned int k = 0; k < sd.channels; k++)
@@ -431,7 +430,7 @@ static void S_convertPCM16(sfxinfo_t *sfx, const sounddata_t &sd)
          stepremainder &= 0xffff;
       }
       // fill remainder (if any) with final sample byte
-      for(; i < sfx->alen; i++)
+      for(; i < alen; i++)
       {
          dest[i] = 0.0f;
          for(unsigned int k = 0; k < sd.channels; k++)
@@ -446,10 +445,9 @@ static void S_convertPCM16(sfxinfo_t *sfx, const sounddata_t &sd)
    else
    {
       // sound is already at target samplerate, just convert to doubles
-      float   *dest = static_cast<float *>(sfx->data);
       int16_t *src  = reinterpret_cast<int16_t *>(sd.samplestart);
 
-      for(unsigned int i = 0; i < sfx->alen; i++)
+      for(unsigned int i = 0; i < alen; i++)
       {
          dest[i] = 0.0f;
          for(unsigned int j = 0; j < sd.channels; j++)
@@ -491,6 +489,287 @@ static int S_getSfxLumpNum(sfxinfo_t *sfx)
    return wGlobalDir.checkNumForNameNSG(namebuf, lumpinfo_t::ns_sounds);
 }
 
+//
+// S_getSfxLumpOrDefault
+//
+// As above, but replaces missing sounds with a reasonable default.
+//
+static int S_getSfxLumpOrDefault(sfxinfo_t *sfx)
+{
+   int lump = S_getSfxLumpNum(sfx);
+
+   if(lump == -1)
+      lump = wGlobalDir.getNumForNameNSG(GameModeInfo->defSoundName, lumpinfo_t::ns_sounds);
+
+   return lump;
+}
+
+//
+// S_isConvertible
+//
+// True if the detected sample format is one we can convert.
+//
+static bool S_isConvertible(const sounddata_t &sd)
+{
+   return sd.fmt == S_FMT_U8 || sd.fmt == S_FMT_16;
+}
+
+//
+// S_convertSound
+//
+// Dispatch to the converter for a sample's format. Safe on any thread.
+//
+static void S_convertSound(float *dest, unsigned int alen, const sounddata_t &sd)
+{
+   if(sd.fmt == S_FMT_U8)
+      S_convertPCMU8(dest, alen, sd);
+   else
+      S_convertPCM16(dest, alen, sd);
+}
+
+//=============================================================================
+//
+// Background precaching
+//
+// S_PrecacheSounds queues a low priority job per sound effect on the engine's
+// job workers for conversion. The main thread finds each sound's lump, locks
+// it PU_STATIC, detects its format and allocates the converted buffer
+// beforehand, so the jobs touch nothing but those two blocks. The buffer
+// belongs to its job until the main thread publishes it, either when
+// S_LoadDigitalSoundEffect first asks for the sound or when the job hands it
+// back with D_RunOnMainThread. Until then sfx->data stays null, so the mixer
+// can never see a half-converted sound.
+//
+
+enum
+{
+   JOB_QUEUED,   // waiting for a worker
+   JOB_RUNNING,  // being converted
+   JOB_DONE,     // converted, waiting to be published
+   JOB_FINISHED, // published
+};
+
+struct soundjob_t
+{
+   sfxinfo_t       *sfx;
+   float           *data;     // zone block owned by the job until published
+   unsigned int     alen;
+   void            *lumpdata; // locked until the whole precache is over
+   sounddata_t      sd;
+   std::atomic_int  state;
+   JobHandle        handle;
+};
+
+static soundjob_t     *soundjobs;
+static int             numsoundjobs;
+static int             numunfinishedsoundjobs;
+static unsigned        soundprecachegeneration; // tells one precache's handbacks from the next
+
+static std::mutex              soundjoblock;
+static std::condition_variable soundjobdone;
+
+//
+// Marks a job done and wakes the main thread if it is waiting on it.
+//
+static void S_completeSoundJob(soundjob_t &job)
+{
+   {
+      std::lock_guard<std::mutex> lock(soundjoblock);
+      job.state.store(JOB_DONE, std::memory_order_release);
+   }
+   soundjobdone.notify_all();
+}
+
+static void S_publishFinishedSoundJob(unsigned generation, int index);
+
+//
+// Converts one sound on a job worker and hands it back to the main thread.
+//
+static void S_soundJob(unsigned generation, int index)
+{
+   soundjob_t &job = soundjobs[index];
+   int expected = JOB_QUEUED;
+
+   // The main thread may have claimed it first
+   if(!job.state.compare_exchange_strong(expected, JOB_RUNNING, std::memory_order_acquire))
+      return;
+
+   S_convertSound(job.data, job.alen, job.sd);
+   S_completeSoundJob(job);
+
+   D_RunOnMainThread([generation, index] { S_publishFinishedSoundJob(generation, index); });
+}
+
+//
+// Hands a converted sound over to the sound code. Main thread only.
+//
+static void S_publishSoundJob(soundjob_t &job)
+{
+   sfxinfo_t *sfx = job.sfx;
+
+   // Reallocating in place moves ownership of the block to the sound
+   sfx->data = erealloctag(float *, job.data, job.alen * sizeof(float), PU_STATIC,
+                           &sfx->data);
+   sfx->alen = job.alen;
+
+   job.data = nullptr;
+   job.state.store(JOB_FINISHED, std::memory_order_relaxed);
+   --numunfinishedsoundjobs;
+}
+
+//
+// Makes sure a job is converted, doing it here if no thread has started it
+// yet, then publishes it.
+//
+static void S_finishSoundJob(soundjob_t &job)
+{
+   int expected = JOB_QUEUED;
+
+   if(job.state.compare_exchange_strong(expected, JOB_RUNNING, std::memory_order_acquire))
+      S_convertSound(job.data, job.alen, job.sd);
+   else if(expected == JOB_RUNNING)
+   {
+      std::unique_lock<std::mutex> lock(soundjoblock);
+      soundjobdone.wait(lock, [&job] {
+         return job.state.load(std::memory_order_acquire) == JOB_DONE;
+      });
+   }
+
+   S_publishSoundJob(job);
+}
+
+//
+// Finds the outstanding job for a sound, if there is one.
+//
+static soundjob_t *S_findSoundJob(const sfxinfo_t *sfx)
+{
+   for(int i = 0; i < numsoundjobs; i++)
+   {
+      if(soundjobs[i].sfx == sfx)
+         return &soundjobs[i];
+   }
+   return nullptr;
+}
+
+//
+// Joins the jobs and releases everything once every job is published.
+//
+static void S_endSoundPrecache()
+{
+   for(int i = 0; i < numsoundjobs; i++)
+      soundjobs[i].handle.join();
+
+   // don't need original lump data any more
+   for(int i = 0; i < numsoundjobs; i++)
+      Z_ChangeTag(soundjobs[i].lumpdata, PU_CACHE);
+
+   delete [] soundjobs;
+   soundjobs    = nullptr;
+   numsoundjobs = 0;
+}
+
+//
+// S_PrecacheSounds
+//
+// Starts converting every sound in the list that isn't loaded yet on the job
+// workers, and returns without waiting for them. Aliases, links and random
+// sounds must already have been resolved by the caller.
+//
+void S_PrecacheSounds(sfxinfo_t *const *sounds, int count)
+{
+   S_FinishSoundPrecache();
+
+   if(count <= 0)
+      return;
+
+   soundjobs    = new soundjob_t[count];
+   numsoundjobs = 0;
+
+   for(int i = 0; i < count; i++)
+   {
+      sfxinfo_t *sfx = sounds[i];
+
+      if(sfx->data || S_findSoundJob(sfx))
+         continue;
+
+      const int    lump    = S_getSfxLumpOrDefault(sfx);
+      const size_t lumplen = size_t(wGlobalDir.lumpLength(lump));
+      if(!lumplen)
+         continue;
+
+      soundjob_t &job = soundjobs[numsoundjobs];
+
+      edefstructvar(sounddata_t, sd);
+      job.lumpdata = wGlobalDir.cacheLumpNum(lump, PU_STATIC);
+
+      if(!S_detectSoundFormat(sd, static_cast<byte *>(job.lumpdata), lumplen) ||
+         !S_isConvertible(sd))
+      {
+         // leave it for S_LoadDigitalSoundEffect to reject
+         Z_ChangeTag(job.lumpdata, PU_CACHE);
+         continue;
+      }
+
+      job.sfx  = sfx;
+      job.sd   = sd;
+      job.alen = S_alenForSample(sd);
+      job.data = emalloctag(float *, job.alen * sizeof(float), PU_STATIC,
+                            reinterpret_cast<void **>(&job.data));
+      job.state.store(JOB_QUEUED, std::memory_order_relaxed);
+      ++numsoundjobs;
+   }
+
+   numunfinishedsoundjobs = numsoundjobs;
+   ++soundprecachegeneration;
+
+   if(!numsoundjobs)
+   {
+      S_endSoundPrecache();
+      return;
+   }
+
+   const unsigned generation = soundprecachegeneration;
+   for(int i = 0; i < numsoundjobs; i++)
+      soundjobs[i].handle = D_QueueJob([generation, i] { S_soundJob(generation, i); }, JOBPRI_LOW);
+}
+
+//
+// Publishes a sound a job has handed back, unless S_LoadDigitalSoundEffect
+// got to it first or its precache is already over. Main thread only.
+//
+static void S_publishFinishedSoundJob(unsigned generation, int index)
+{
+   if(generation != soundprecachegeneration || !soundjobs)
+      return;
+
+   soundjob_t &job = soundjobs[index];
+   if(job.state.load(std::memory_order_acquire) == JOB_DONE)
+      S_publishSoundJob(job);
+
+   if(!numunfinishedsoundjobs)
+      S_endSoundPrecache();
+}
+
+//
+// S_FinishSoundPrecache
+//
+// Waits for and publishes every outstanding job. Must be called before sound
+// data is freed or the sound system shuts down.
+//
+void S_FinishSoundPrecache()
+{
+   if(!soundjobs)
+      return;
+
+   for(int i = 0; i < numsoundjobs; i++)
+   {
+      if(soundjobs[i].state.load(std::memory_order_relaxed) != JOB_FINISHED)
+         S_finishSoundJob(soundjobs[i]);
+   }
+
+   S_endSoundPrecache();
+}
+
 //=============================================================================
 //
 // Interface
@@ -505,36 +784,30 @@ static int S_getSfxLumpNum(sfxinfo_t *sfx)
 bool S_LoadDigitalSoundEffect(sfxinfo_t *sfx)
 {
    bool  res = false;
-   int   lump = S_getSfxLumpNum(sfx);
-
-   // replace missing sounds with a reasonable default
-   if(lump == -1)
-      lump = wGlobalDir.getNumForNameNSG(GameModeInfo->defSoundName, lumpinfo_t::ns_sounds);
+   int   lump = S_getSfxLumpOrDefault(sfx);
 
    size_t lumplen = (size_t)wGlobalDir.lumpLength(lump);
    if(!lumplen)
       return false;
 
+   // if it's still being precached, finish it now rather than load it twice
+   if(!sfx->data && soundjobs)
+   {
+      if(soundjob_t *job = S_findSoundJob(sfx); job && job->data)
+         S_finishSoundJob(*job);
+   }
+
    if(!sfx->data)
    {
       edefstructvar(sounddata_t, sd);
       byte *lumpdata = (byte *)wGlobalDir.cacheLumpNum(lump, PU_STATIC);
 
-      if(S_detectSoundFormat(sd, lumpdata, lumplen))
+      if(S_detectSoundFormat(sd, lumpdata, lumplen) && S_isConvertible(sd))
       {
-         switch(sd.fmt)
-         {
-         case S_FMT_U8:
-            S_convertPCMU8(sfx, sd);
-            res = true;
-            break;
-         case S_FMT_16:
-            S_convertPCM16(sfx, sd);
-            res = true;
-            break;
-         default: // unsupported PCM format
-            break;
-         }
+         sfx->alen = S_alenForSample(sd);
+         sfx->data = Z_Malloc(sfx->alen*sizeof(float), PU_STATIC, &sfx->data);
+         S_convertSound(static_cast<float *>(sfx->data), sfx->alen, sd);
+         res = true;
       }
 
       // haleyjd 06/03/06: don't need original lump data any more if loaded
@@ -556,11 +829,7 @@ bool S_LoadDigitalSoundEffect(sfxinfo_t *sfx)
 //
 void S_CacheDigitalSoundLump(sfxinfo_t *sfx)
 {
-   int lump = S_getSfxLumpNum(sfx);
-
-   // replace missing sounds with a reasonable default
-   if(lump == -1)
-      lump = wGlobalDir.getNumForNameNSG(GameModeInfo->defSoundName, lumpinfo_t::ns_sounds);
+   const int lump = S_getSfxLumpOrDefault(sfx);
 
    wGlobalDir.cacheLumpNum(lump, PU_CACHE);
 }
@@ -34,6 +34,10 @@ struct sfxinfo_t;
 bool S_LoadDigitalSoundEffect(sfxinfo_t *sfx);
 void S_CacheDigitalSoundLump(sfxinfo_t *sfx);
 
+// Background conversion of sounds that are about to be needed
+void S_PrecacheSounds(sfxinfo_t *const *sounds, int count);
+void S_FinishSoundPrecache();
+
 #endif
 
 // EOF
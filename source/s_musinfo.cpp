@@ -65,8 +65,10 @@ void S_MusInfoClear()
 //
 void S_MusInfoThink(Mobj &thing)
 {
-   if(musinfo.mapthing != &thing &&
-      thing.subsector->sector == players[consoleplayer].mo->subsector->sector)
+   const Mobj *mo = players[consoleplayer].mo; // none on a dedicated host
+
+   if(musinfo.mapthing != &thing && mo &&
+      thing.subsector->sector == mo->subsector->sector)
    {
       P_SetTarget(&musinfo.lastmapthing, musinfo.mapthing);
       P_SetTarget(&musinfo.mapthing, &thing);
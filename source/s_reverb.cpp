@@ -26,6 +26,8 @@
 
 #include "e_reverbs.h"
 #include "i_sound.h"
+#include "m_compare.h"
+#include "m_simd.h"
 #include "s_reverb.h"
 
 //
@@ -77,17 +79,44 @@
 #define ALLPASSTUNINGL4 225
 #define ALLPASSTUNINGR4 225+STEREOSPREAD
 
+// Frames processed per block. No comb or allpass line is shorter than
+// this, so within a block every filter reads only samples written during
+// earlier blocks and each filter can run over the block on its own.
+#define REVERBBLOCK 128
+
+static_assert(REVERBBLOCK <= ALLPASSTUNINGL4, "reverb block exceeds shortest delay line");
+
 //=============================================================================
 //
 // denorms
 //
+// Feedback tails decay into the denormal range, where x87 and SSE arithmetic
+// slows to a crawl. On SSE the flush-to-zero and denormals-are-zero modes are
+// switched on while the reverb runs; elsewhere a tiny DC offset on the
+// network input keeps the filter states out of that range.
+//
 
-static inline void undenormalize(double &d)
+#if defined(EE_SIMD_SSE2)
+class DenormalGuard
 {
-   static const double anti_denormal = 1e-18;
-   d += anti_denormal;
-   d -= anti_denormal;
-}
+   unsigned int savedcsr;
+
+public:
+   static constexpr float dcoffset = 0.0f;
+
+   DenormalGuard() : savedcsr(_mm_getcsr())
+   {
+      _mm_setcsr(savedcsr | 0x8040); // FTZ | DAZ
+   }
+   ~DenormalGuard() { _mm_setcsr(savedcsr); }
+};
+#else
+class DenormalGuard
+{
+public:
+   static constexpr float dcoffset = 1e-18f;
+};
+#endif
 
 //=============================================================================
 //
@@ -97,7 +126,7 @@ static inline void undenormalize(double &d)
 #define MAXDELAY 250u
 #define MAXSR    44100u
 
-static double delayBuffer[MAXDELAY*MAXSR/1000];
+static float delayBuffer[MAXDELAY*MAXSR/1000];
 
 static size_t delaySize;
 static size_t readPos;
@@ -106,7 +135,7 @@ static size_t writePos;
 static void delay_clearBuffer()
 {
    for(size_t i = 0; i < delaySize; i++)
-      delayBuffer[i] = 0.0;
+      delayBuffer[i] = 0.0f;
 }
 
 static void delay_set(size_t delayms, size_t sr = MAXSR)
@@ -126,113 +155,212 @@ static void delay_set(size_t delayms, size_t sr = MAXSR)
    }
 }
 
-static void delay_writeSample(double sample)
+//
+// Run a block through the pre-delay line in place.
+//
+static void delay_process(float *block, int count)
 {
-   delayBuffer[writePos] = sample;
-   if(++writePos >= delaySize)
-      writePos = 0;
-}
+   for(int i = 0; i < count; i++)
+   {
+      delayBuffer[writePos] = block[i];
+      if(++writePos >= delaySize)
+         writePos = 0;
 
-static double delay_readSample()
-{
-   double ret = delayBuffer[readPos];
-   if(++readPos >= delaySize)
-      readPos = 0;
-   return ret;
+      block[i] = delayBuffer[readPos];
+      if(++readPos >= delaySize)
+         readPos = 0;
+   }
 }
 
 //=============================================================================
 //
 // comb
 //
+// Feedback and damping are the same for every comb, so they are kept by the
+// bank rather than per filter.
+//
 
-class comb
+struct comb
 {
-public:
-   double  feedback;
-   double  filterstore;
-   double  damp1;
-   double  damp2;
-   double *buffer;
-   int     bufsize;
-   int     bufidx;
-
-   void setbuffer(double *buf, int size)
+   float *buffer;
+   int    bufsize;
+   int    bufidx;
+
+   void setbuffer(float *buf, int size)
    {
       buffer  = buf;
       bufsize = size;
    }
 
-   double process(double input)
+   void mute()
    {
-      double output;
-      
-      output = buffer[bufidx];
-      undenormalize(output);
+      for(int i = 0; i < bufsize; i++)
+         buffer[i] = 0.0f;
+   }
+};
 
-      filterstore = (output * damp2) + (filterstore * damp1);
-      undenormalize(filterstore);
+#if defined(EE_SIMD_SSE2) || defined(EE_SIMD_NEON)
 
-      buffer[bufidx] = input + (filterstore * feedback);
+#if defined(EE_SIMD_SSE2)
+using combvec_t = __m128;
 
-      if(++bufidx >= bufsize)
-         bufidx = 0;
+static inline combvec_t comb_splat(float f)        { return _mm_set1_ps(f); }
+static inline combvec_t comb_load(const float *p)  { return _mm_load_ps(p); }
+static inline void comb_store(float *p, combvec_t v) { _mm_store_ps(p, v); }
+static inline combvec_t comb_add(combvec_t a, combvec_t b) { return _mm_add_ps(a, b); }
+static inline combvec_t comb_mul(combvec_t a, combvec_t b) { return _mm_mul_ps(a, b); }
+static inline float comb_sum(combvec_t v)
+{
+   const __m128 s = _mm_add_ps(v, _mm_movehl_ps(v, v));
+   return _mm_cvtss_f32(_mm_add_ss(s, _mm_shuffle_ps(s, s, 1)));
+}
+#else
+using combvec_t = float32x4_t;
+
+static inline combvec_t comb_splat(float f)        { return vdupq_n_f32(f); }
+static inline combvec_t comb_load(const float *p)  { return vld1q_f32(p); }
+static inline void comb_store(float *p, combvec_t v) { vst1q_f32(p, v); }
+static inline combvec_t comb_add(combvec_t a, combvec_t b) { return vaddq_f32(a, b); }
+static inline combvec_t comb_mul(combvec_t a, combvec_t b) { return vmulq_f32(a, b); }
+static inline float comb_sum(combvec_t v)
+{
+   const float32x2_t s = vadd_f32(vget_low_f32(v), vget_high_f32(v));
+   return vget_lane_f32(vpadd_f32(s, s), 0);
+}
+#endif
 
-      return output;
-   }
+//
+// Run a stretch of frames through the comb bank with no buffer wrapping
+// inside it. Four combs share a vector, so the damping recurrence of each
+// filter advances in its own lane; only the delay line taps are scalar.
+//
+static void comb_processSpan(float *const *taps, float *filterstore, const float *input,
+                             float *outL, float *outR, int count,
+                             float feedback, float damp1, float damp2)
+{
+   static_assert(NUMCOMBS == 8, "comb bank is laid out as 2x4 lanes per side");
 
-   void mute()
+   alignas(16) float outs[4];
+   const combvec_t fb = comb_splat(feedback);
+   const combvec_t d1 = comb_splat(damp1);
+   const combvec_t d2 = comb_splat(damp2);
+   combvec_t fs[4];
+
+   for(int g = 0; g < 4; g++)
+      fs[g] = comb_load(filterstore + 4 * g);
+
+   for(int i = 0; i < count; i++)
    {
-      for(int i = 0; i < bufsize; i++)
-         buffer[i] = 0;
+      const combvec_t in = comb_splat(input[i]);
+      combvec_t out[4];
+
+      for(int g = 0; g < 4; g++)
+      {
+         float *const *t = taps + 4 * g;
+
+         outs[0] = t[0][i];
+         outs[1] = t[1][i];
+         outs[2] = t[2][i];
+         outs[3] = t[3][i];
+         out[g]  = comb_load(outs);
+
+         fs[g] = comb_add(comb_mul(out[g], d2), comb_mul(fs[g], d1));
+
+         comb_store(outs, comb_add(in, comb_mul(fs[g], fb)));
+         t[0][i] = outs[0];
+         t[1][i] = outs[1];
+         t[2][i] = outs[2];
+         t[3][i] = outs[3];
+      }
+
+      outL[i] = comb_sum(comb_add(out[0], out[1]));
+      outR[i] = comb_sum(comb_add(out[2], out[3]));
    }
 
-   void setdamp(double val)
+   for(int g = 0; g < 4; g++)
+      comb_store(filterstore + 4 * g, fs[g]);
+}
+
+#else
+
+//
+// Portable version: each comb runs over the whole span in turn.
+//
+static void comb_processSpan(float *const *taps, float *filterstore, const float *input,
+                             float *outL, float *outR, int count,
+                             float feedback, float damp1, float damp2)
+{
+   for(int i = 0; i < count; i++)
+      outL[i] = outR[i] = 0.0f;
+
+   for(int c = 0; c < NUMCOMBS * 2; c++)
    {
-      damp1 = val;
-      damp2 = 1 - val;
+      float *const tap = taps[c];
+      float *const out = c < NUMCOMBS ? outL : outR;
+      float        fs  = filterstore[c];
+
+      for(int i = 0; i < count; i++)
+      {
+         const float output = tap[i];
+         fs      = (output * damp2) + (fs * damp1);
+         tap[i]  = input[i] + (fs * feedback);
+         out[i] += output;
+      }
+
+      filterstore[c] = fs;
    }
-};
+}
+
+#endif
 
 //=============================================================================
 //
 // allpass
 //
 
-class allpass
+struct allpass
 {
-public:
-   double  feedback;
-   double *buffer;
-   int     bufsize;
-   int     bufidx;
+   float  feedback;
+   float *buffer;
+   int    bufsize;
+   int    bufidx;
 
-   void setbuffer(double *buf, int size)
+   void setbuffer(float *buf, int size)
    {
       buffer  = buf;
       bufsize = size;
    }
 
-   double process(double input)
+   //
+   // Filter a block in place. The block is never longer than the delay line,
+   // so the loop has no dependency from one frame to the next.
+   //
+   void process(float *block, int count)
    {
-      double output, bufout;
-
-      bufout = buffer[bufidx];
-      undenormalize(bufout);
-
-      output = -input + bufout;
-      buffer[bufidx] = input + (bufout * feedback);
+      while(count > 0)
+      {
+         const int span = emin(count, bufsize - bufidx);
+         float *tap = buffer + bufidx;
 
-      if(++bufidx >= bufsize)
-         bufidx = 0;
+         for(int i = 0; i < span; i++)
+         {
+            const float bufout = tap[i];
+            const float input  = block[i];
+            block[i] = bufout - input;
+            tap[i]   = input + (bufout * feedback);
+         }
 
-      return output;
+         block += span;
+         count -= span;
+         if((bufidx += span) >= bufsize)
+            bufidx = 0;
+      }
    }
 
    void mute()
    {
       for(int i = 0; i < bufsize; i++)
-         buffer[i] = 0;
+         buffer[i] = 0.0f;
    }
 };
 
@@ -253,31 +381,31 @@ struct EQSTATE
 {
   // Filter #1 (Low band)
 
-  double  lf;       // Frequency
-  double  f1p0;     // Poles ...
-  double  f1p1;    
-  double  f1p2;
-  double  f1p3;
+  float  lf;       // Frequency
+  float  f1p0;     // Poles ...
+  float  f1p1;    
+  float  f1p2;
+  float  f1p3;
 
   // Filter #2 (High band)
 
-  double  hf;       // Frequency
-  double  f2p0;     // Poles ...
-  double  f2p1;
-  double  f2p2;
-  double  f2p3;
+  float  hf;       // Frequency
+  float  f2p0;     // Poles ...
+  float  f2p1;
+  float  f2p2;
+  float  f2p3;
 
   // Sample history buffer
 
-  double  sdm1;     // Sample data minus 1
-  double  sdm2;     //                   2
-  double  sdm3;     //                   3
+  float  sdm1;     // Sample data minus 1
+  float  sdm2;     //                   2
+  float  sdm3;     //                   3
 
   // Gain Controls
 
-  double  lg;       // low  gain
-  double  mg;       // mid  gain
-  double  hg;       // high gain
+  float  lg;       // low  gain
+  float  mg;       // mid  gain
+  float  hg;       // high gain
 };
 
 struct eqparams_t
@@ -289,43 +417,51 @@ struct eqparams_t
    double highgain;
 };
 
-static double do_3band(EQSTATE &es, double sample)
+//
+// Equalize a block in place. The filters are serial IIRs, so this stays a
+// per-frame loop.
+//
+static void do_3band(EQSTATE &es, float *block, int count)
 {
-   static double vsa = (1.0 / 4294967295.0);
+   static const float vsa = (1.0f / 4294967295.0f);
    
-   // Locals
-   double l, m, h;    // Low / Mid / High - Sample Values
+   for(int i = 0; i < count; i++)
+   {
+      // Locals
+      float l, m, h;    // Low / Mid / High - Sample Values
+      const float sample = block[i];
 
-   // Filter #1 (lowpass)
-   es.f1p0  += (es.lf * (sample  - es.f1p0)) + vsa;
-   es.f1p1  += (es.lf * (es.f1p0 - es.f1p1));
-   es.f1p2  += (es.lf * (es.f1p1 - es.f1p2));
-   es.f1p3  += (es.lf * (es.f1p2 - es.f1p3));
+      // Filter #1 (lowpass)
+      es.f1p0  += (es.lf * (sample  - es.f1p0)) + vsa;
+      es.f1p1  += (es.lf * (es.f1p0 - es.f1p1));
+      es.f1p2  += (es.lf * (es.f1p1 - es.f1p2));
+      es.f1p3  += (es.lf * (es.f1p2 - es.f1p3));
 
-   l         = es.f1p3;
+      l         = es.f1p3;
 
-   // Filter #2 (highpass)
-   es.f2p0  += (es.hf * (sample  - es.f2p0)) + vsa;
-   es.f2p1  += (es.hf * (es.f2p0 - es.f2p1));
-   es.f2p2  += (es.hf * (es.f2p1 - es.f2p2));
-   es.f2p3  += (es.hf * (es.f2p2 - es.f2p3));
+      // Filter #2 (highpass)
+      es.f2p0  += (es.hf * (sample  - es.f2p0)) + vsa;
+      es.f2p1  += (es.hf * (es.f2p0 - es.f2p1));
+      es.f2p2  += (es.hf * (es.f2p1 - es.f2p2));
+      es.f2p3  += (es.hf * (es.f2p2 - es.f2p3));
 
-   h         = es.sdm3 - es.f2p3;
+      h         = es.sdm3 - es.f2p3;
 
-   // Calculate midrange (signal - (low + high))
-   m         = es.sdm3 - (h + l); // haleyjd 07/05/10: which is right?
+      // Calculate midrange (signal - (low + high))
+      m         = es.sdm3 - (h + l); // haleyjd 07/05/10: which is right?
 
-   // Scale, Combine and store
-   l        *= es.lg;
-   m        *= es.mg;
-   h        *= es.hg;
+      // Scale, Combine and store
+      l        *= es.lg;
+      m        *= es.mg;
+      h        *= es.hg;
 
-   // Shuffle history buffer
-   es.sdm3   = es.sdm2;
-   es.sdm2   = es.sdm1;
-   es.sdm1   = sample;                
+      // Shuffle history buffer
+      es.sdm3   = es.sdm2;
+      es.sdm2   = es.sdm1;
+      es.sdm1   = sample;                
 
-   return (l + m + h);
+      block[i]  = (l + m + h);
+   }
 }
 
 static void init_3band(const eqparams_t &params, EQSTATE &eql, EQSTATE &eqr)
@@ -335,18 +471,18 @@ static void init_3band(const eqparams_t &params, EQSTATE &eql, EQSTATE &eqr)
    memset(&eqr, 0, sizeof(eqr));
 
    // Set Low/Mid/High gains 
-   eql.lg = eqr.lg = params.lowgain;
-   eql.mg = eqr.mg = params.midgain;
-   eql.hg = eqr.hg = params.highgain;
+   eql.lg = eqr.lg = static_cast<float>(params.lowgain);
+   eql.mg = eqr.mg = static_cast<float>(params.midgain);
+   eql.hg = eqr.hg = static_cast<float>(params.highgain);
 
    // Calculate filter cutoff frequencies
-   eql.lf = eqr.lf = 2 * sin(SND_PI * (params.lowfreq  / (double)MAXSR));
-   eql.hf = eqr.hf = 2 * sin(SND_PI * (params.highfreq / (double)MAXSR));
+   eql.lf = eqr.lf = static_cast<float>(2 * sin(SND_PI * (params.lowfreq  / (double)MAXSR)));
+   eql.hf = eqr.hf = static_cast<float>(2 * sin(SND_PI * (params.highfreq / (double)MAXSR)));
 }
 
 static void clear_3band(EQSTATE &eq)
 {
-   eq.sdm1 = eq.sdm2 = eq.sdm3 = 0.0;
+   eq.sdm1 = eq.sdm2 = eq.sdm3 = 0.0f;
 }
 
 //=============================================================================
@@ -371,60 +507,61 @@ public:
    EQSTATE eql, eqr;
    eqparams_t eqparams;
 
-   // comb filters
-   comb combL[NUMCOMBS];
-   comb combR[NUMCOMBS];
+   // comb filters, all left channel combs followed by all right channel ones;
+   // the damping state is kept apart so it can be loaded as vectors
+   comb combs[NUMCOMBS * 2];
+   alignas(16) float filterstore[NUMCOMBS * 2];
 
    // allpass filters
    allpass allpassL[NUMALLPASSES];
    allpass allpassR[NUMALLPASSES];
 
    // Buffers for the combs
-   double bufcombL1[COMBTUNINGL1];
-   double bufcombR1[COMBTUNINGR1];
-   double bufcombL2[COMBTUNINGL2];
-   double bufcombR2[COMBTUNINGR2];
-   double bufcombL3[COMBTUNINGL3];
-   double bufcombR3[COMBTUNINGR3];
-   double bufcombL4[COMBTUNINGL4];
-   double bufcombR4[COMBTUNINGR4];
-   double bufcombL5[COMBTUNINGL5];
-   double bufcombR5[COMBTUNINGR5];
-   double bufcombL6[COMBTUNINGL6];
-   double bufcombR6[COMBTUNINGR6];
-   double bufcombL7[COMBTUNINGL7];
-   double bufcombR7[COMBTUNINGR7];
-   double bufcombL8[COMBTUNINGL8];
-   double bufcombR8[COMBTUNINGR8];
+   float bufcombL1[COMBTUNINGL1];
+   float bufcombR1[COMBTUNINGR1];
+   float bufcombL2[COMBTUNINGL2];
+   float bufcombR2[COMBTUNINGR2];
+   float bufcombL3[COMBTUNINGL3];
+   float bufcombR3[COMBTUNINGR3];
+   float bufcombL4[COMBTUNINGL4];
+   float bufcombR4[COMBTUNINGR4];
+   float bufcombL5[COMBTUNINGL5];
+   float bufcombR5[COMBTUNINGR5];
+   float bufcombL6[COMBTUNINGL6];
+   float bufcombR6[COMBTUNINGR6];
+   float bufcombL7[COMBTUNINGL7];
+   float bufcombR7[COMBTUNINGR7];
+   float bufcombL8[COMBTUNINGL8];
+   float bufcombR8[COMBTUNINGR8];
 
    // Buffers for the allpasses
-   double bufallpassL1[ALLPASSTUNINGL1];
-   double bufallpassR1[ALLPASSTUNINGR1];
-   double bufallpassL2[ALLPASSTUNINGL2];
-   double bufallpassR2[ALLPASSTUNINGR2];
-   double bufallpassL3[ALLPASSTUNINGL3];
-   double bufallpassR3[ALLPASSTUNINGR3];
-   double bufallpassL4[ALLPASSTUNINGL4];
-   double bufallpassR4[ALLPASSTUNINGR4];
+   float bufallpassL1[ALLPASSTUNINGL1];
+   float bufallpassR1[ALLPASSTUNINGR1];
+   float bufallpassL2[ALLPASSTUNINGL2];
+   float bufallpassR2[ALLPASSTUNINGR2];
+   float bufallpassL3[ALLPASSTUNINGL3];
+   float bufallpassR3[ALLPASSTUNINGR3];
+   float bufallpassL4[ALLPASSTUNINGL4];
+   float bufallpassR4[ALLPASSTUNINGR4];
 
    revmodel()
    {
-      combL[0].setbuffer(bufcombL1, COMBTUNINGL1);
-      combR[0].setbuffer(bufcombR1, COMBTUNINGR1);
-      combL[1].setbuffer(bufcombL2, COMBTUNINGL2);
-      combR[1].setbuffer(bufcombR2, COMBTUNINGR2);
-      combL[2].setbuffer(bufcombL3, COMBTUNINGL3);
-      combR[2].setbuffer(bufcombR3, COMBTUNINGR3);
-      combL[3].setbuffer(bufcombL4, COMBTUNINGL4);
-      combR[3].setbuffer(bufcombR4, COMBTUNINGR4);
-      combL[4].setbuffer(bufcombL5, COMBTUNINGL5);
-      combR[4].setbuffer(bufcombR5, COMBTUNINGR5);
-      combL[5].setbuffer(bufcombL6, COMBTUNINGL6);
-      combR[5].setbuffer(bufcombR6, COMBTUNINGR6);
-      combL[6].setbuffer(bufcombL7, COMBTUNINGL7);
-      combR[6].setbuffer(bufcombR7, COMBTUNINGR7);
-      combL[7].setbuffer(bufcombL8, COMBTUNINGL8);
-      combR[7].setbuffer(bufcombR8, COMBTUNINGR8);
+      combs[0].setbuffer(bufcombL1, COMBTUNINGL1);
+      combs[1].setbuffer(bufcombL2, COMBTUNINGL2);
+      combs[2].setbuffer(bufcombL3, COMBTUNINGL3);
+      combs[3].setbuffer(bufcombL4, COMBTUNINGL4);
+      combs[4].setbuffer(bufcombL5, COMBTUNINGL5);
+      combs[5].setbuffer(bufcombL6, COMBTUNINGL6);
+      combs[6].setbuffer(bufcombL7, COMBTUNINGL7);
+      combs[7].setbuffer(bufcombL8, COMBTUNINGL8);
+      combs[NUMCOMBS + 0].setbuffer(bufcombR1, COMBTUNINGR1);
+      combs[NUMCOMBS + 1].setbuffer(bufcombR2, COMBTUNINGR2);
+      combs[NUMCOMBS + 2].setbuffer(bufcombR3, COMBTUNINGR3);
+      combs[NUMCOMBS + 3].setbuffer(bufcombR4, COMBTUNINGR4);
+      combs[NUMCOMBS + 4].setbuffer(bufcombR5, COMBTUNINGR5);
+      combs[NUMCOMBS + 5].setbuffer(bufcombR6, COMBTUNINGR6);
+      combs[NUMCOMBS + 6].setbuffer(bufcombR7, COMBTUNINGR7);
+      combs[NUMCOMBS + 7].setbuffer(bufcombR8, COMBTUNINGR8);
       allpassL[0].setbuffer(bufallpassL1, ALLPASSTUNINGL1);
       allpassR[0].setbuffer(bufallpassR1, ALLPASSTUNINGR1);
       allpassL[1].setbuffer(bufallpassL2, ALLPASSTUNINGL2);
@@ -435,14 +572,14 @@ public:
       allpassR[3].setbuffer(bufallpassR4, ALLPASSTUNINGR4);
 
       // Set default values
-      allpassL[0].feedback = 0.5;
-      allpassR[0].feedback = 0.5;
-      allpassL[1].feedback = 0.5;
-      allpassR[1].feedback = 0.5;
-      allpassL[2].feedback = 0.5;
-      allpassR[2].feedback = 0.5;
-      allpassL[3].feedback = 0.5;
-      allpassR[3].feedback = 0.5;
+      allpassL[0].feedback = 0.5f;
+      allpassR[0].feedback = 0.5f;
+      allpassL[1].feedback = 0.5f;
+      allpassR[1].feedback = 0.5f;
+      allpassL[2].feedback = 0.5f;
+      allpassR[2].feedback = 0.5f;
+      allpassL[3].feedback = 0.5f;
+      allpassR[3].feedback = 0.5f;
       
       // set initial parameters
       wet      = INITIALWET * SCALEWET;
@@ -475,10 +612,10 @@ public:
       if(getMode() >= FREEZEMODE)
          return;
 
-      for(int i = 0; i < NUMCOMBS; i++)
+      for(int i = 0; i < NUMCOMBS * 2; i++)
       {
-         combL[i].mute();
-         combR[i].mute();
+         combs[i].mute();
+         filterstore[i] = 0.0f;
       }
       for(int i = 0; i < NUMALLPASSES; i++)
       {
@@ -491,105 +628,116 @@ public:
       clear_3band(eqr);
    }
 
-   void processReplace(float *inputL, float *inputR, 
-                       float *outputL, float *outputR,
-                       int numsamples, int skip)
+   //
+   // Run one block of at most REVERBBLOCK frames through the network, leaving
+   // the wet left and right signals in outL and outR.
+   //
+   void processBlock(const float *inputL, const float *inputR, int skip,
+                     float *outL, float *outR, int count)
    {
-      double outL, outR, input;
+      float input[REVERBBLOCK];
+      const float fgain = static_cast<float>(gain);
 
-      while(numsamples-- > 0)
+      for(int i = 0; i < count; i++)
       {
-         outL = outR = 0;
-         input = (*inputL + *inputR) * gain;
+         input[i] = (*inputL + *inputR) * fgain + DenormalGuard::dcoffset;
+         inputL += skip;
+         inputR += skip;
+      }
 
-         // pre-delay
-         if(delay)
-         {
-            delay_writeSample(input);
-            input = delay_readSample();
-         }
+      // pre-delay
+      if(delay)
+         delay_process(input, count);
 
-         // accumulate comb filters in parallel
-         for(int i = 0; i < NUMCOMBS; i++)
-         {
-            outL += combL[i].process(input);
-            outR += combR[i].process(input);
-         }
+      // accumulate comb filters in parallel, splitting the block wherever
+      // one of the delay lines wraps
+      const float feedback = static_cast<float>(roomsize1);
+      const float cdamp1   = static_cast<float>(damp1);
+      const float cdamp2   = static_cast<float>(1 - damp1);
+
+      for(int done = 0; done < count; )
+      {
+         float *taps[NUMCOMBS * 2];
+         int span = count - done;
 
-         // feed through allpasses in series
-         for(int i = 0; i < NUMALLPASSES; i++)
+         for(int c = 0; c < NUMCOMBS * 2; c++)
          {
-            outL = allpassL[i].process(outL);
-            outR = allpassR[i].process(outR);
+            span    = emin(span, combs[c].bufsize - combs[c].bufidx);
+            taps[c] = combs[c].buffer + combs[c].bufidx;
          }
 
-         // equalization pass
-         if(doEQ)
+         comb_processSpan(taps, filterstore, input + done, outL + done, outR + done,
+                          span, feedback, cdamp1, cdamp2);
+
+         for(comb &c : combs)
          {
-            outL = do_3band(eql, outL);
-            outR = do_3band(eqr, outR);
+            if((c.bufidx += span) >= c.bufsize)
+               c.bufidx = 0;
          }
+         done += span;
+      }
 
-         // calculate output replacing anything already there
-         *outputL = (float)(outL * wet1 + outR * wet2 + *inputL * dry);
-         *outputR = (float)(outR * wet1 + outL * wet2 + *inputR * dry);
+      // feed through allpasses in series
+      for(int i = 0; i < NUMALLPASSES; i++)
+      {
+         allpassL[i].process(outL, count);
+         allpassR[i].process(outR, count);
+      }
 
-         // increment sample pointers
-         inputL  += skip;
-         inputR  += skip;
-         outputL += skip;
-         outputR += skip;
+      // equalization pass
+      if(doEQ)
+      {
+         do_3band(eql, outL, count);
+         do_3band(eqr, outR, count);
       }
    }
 
-   void processMix(float *inputL, float *inputR, 
-                   float *outputL, float *outputR,
-                   int numsamples, int skip)
+   //
+   // Process numsamples frames, either replacing the output or mixing into it.
+   //
+   template<bool mix>
+   void process(float *inputL, float *inputR,
+                float *outputL, float *outputR,
+                int numsamples, int skip)
    {
-      double outL, outR, input;
+      DenormalGuard guard;
+      const float fwet1 = static_cast<float>(wet1);
+      const float fwet2 = static_cast<float>(wet2);
+      const float fdry  = static_cast<float>(dry);
 
-      while(numsamples-- > 0)
+      while(numsamples > 0)
       {
-         outL = outR = 0;
-         input = (*inputL + *inputR) * gain;
+         float outL[REVERBBLOCK], outR[REVERBBLOCK];
+         const int count = emin(numsamples, REVERBBLOCK);
 
-         // pre-delay
-         if(delay)
-         {
-            delay_writeSample(input);
-            input = delay_readSample();
-         }
-
-         // accumulate comb filters in parallel
-         for(int i = 0; i < NUMCOMBS; i++)
-         {
-            outL += combL[i].process(input);
-            outR += combR[i].process(input);
-         }
-
-         // feed through allpasses in series
-         for(int i = 0; i < NUMALLPASSES; i++)
-         {
-            outL = allpassL[i].process(outL);
-            outR = allpassR[i].process(outR);
-         }
+         processBlock(inputL, inputR, skip, outL, outR, count);
 
-         // equalization pass
-         if(doEQ)
+         for(int i = 0; i < count; i++)
          {
-            outL = do_3band(eql, outL);
-            outR = do_3band(eqr, outR);
+            const float l = outL[i] * fwet1 + outR[i] * fwet2 + *inputL * fdry;
+            const float r = outR[i] * fwet1 + outL[i] * fwet2 + *inputR * fdry;
+
+            if constexpr(mix)
+            {
+               // calculate output mixing with anything already there
+               *outputL += l;
+               *outputR += r;
+            }
+            else
+            {
+               // calculate output replacing anything already there
+               *outputL = l;
+               *outputR = r;
+            }
+
+            // increment sample pointers
+            inputL  += skip;
+            inputR  += skip;
+            outputL += skip;
+            outputR += skip;
          }
 
-         // calculate output mixing with anything already there
-         *outputL += (float)(outL * wet1 + outR * wet2 + *inputL * dry);
-         *outputR += (float)(outR * wet1 + outL * wet2 + *inputR * dry);
-
-         // increment sample pointers
-         inputL  += skip;
-         inputR  += skip;
-         outputL += skip;
-         outputR += skip;
+         numsamples -= count;
       }
    }
 
@@ -611,14 +759,6 @@ public:
          gain      = FIXEDGAIN;
       }
 
-      for(int i = 0; i < NUMCOMBS; i++)
-      {
-         combL[i].feedback = roomsize1;
-         combL[i].setdamp(damp1);
-         combR[i].feedback = roomsize1;
-         combR[i].setdamp(damp1);
-      }
-
       init_3band(eqparams, eql, eqr);
    }
 
@@ -727,7 +867,7 @@ void S_ReverbSetState(ereverb_t *ereverb)
 //
 void S_ProcessReverb(float *stream, const int samples, const int skip)
 {
-   reverb.processMix(stream, stream+1, stream, stream+1, samples, skip);
+   reverb.process<true>(stream, stream+1, stream, stream+1, samples, skip);
 }
 
 //
@@ -737,7 +877,7 @@ void S_ProcessReverb(float *stream, const int samples, const int skip)
 //
 void S_ProcessReverbReplace(float *stream, int samples)
 {
-   reverb.processReplace(stream, stream+1, stream, stream+1, samples, 2);
+   reverb.process<false>(stream, stream+1, stream, stream+1, samples, 2);
 }
 
 // EOF
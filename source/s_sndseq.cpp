@@ -30,11 +30,16 @@
 //
 //-----------------------------------------------------------------------------
 
+#include <algorithm>
+
 #include "z_zone.h"
 #include "d_gi.h"
 #include "doomstat.h"
+#include "i_sound.h"
 #include "i_system.h"
 #include "c_runcmd.h"
+#include "m_collection.h"
+#include "m_compare.h"
 #include "p_mobjcol.h"
 #include "s_sndseq.h"
 #include "e_things.h"
@@ -53,6 +58,73 @@ int s_enviro_volume; // controls volume of sequences using randomplayvol, 0-16
 #define SECTOR_ORIGIN(s, b) \
    ((b) ? &((s)->csoundorg) : &((s)->soundorg))
 
+//
+// Delay queue
+//
+// Running sequences wait in a wheel of lists, bucketed by the tic they next
+// run on, so S_RunSequences only looks at the ones that are due instead of
+// counting down every delay. seqtic counts S_RunSequences passes, and due
+// sequences are run in SoundSequences order, newest first, as they always
+// have been.
+//
+
+#define SEQWHEELSLOTS 256 // must be a power of two
+
+static DLListItem<SndSeq_t> *seqwheel[SEQWHEELSLOTS];
+static unsigned int seqtic;   // number of the last S_RunSequences pass
+static unsigned int seqorder; // last SndSeq_t::order handed out
+
+static PODCollection<SndSeq_t *> dueseqs;
+
+//
+// Puts a sequence in the queue to be run on the given pass.
+//
+static void S_waitSequence(SndSeq_t *seq, unsigned int tic)
+{
+   seq->wakeTic = tic;
+   seq->waitlink.insert(seq, &seqwheel[tic & (SEQWHEELSLOTS - 1)]);
+}
+
+//
+// Queues a sequence according to its delayCounter, the way the old countdown
+// in S_RunSequence would have let it run again. Sequences sitting on an end
+// command with a stop sound do nothing until stopped, and aren't queued at
+// all; neither are ones with a broken negative delay, which would never have
+// counted down.
+//
+static void S_scheduleSequence(SndSeq_t *seq)
+{
+   const int delay = seq->delayCounter;
+
+   if(delay < 0 || (seq->cmdPtr->data == SEQ_CMD_END && seq->sequence->stopsound))
+      return;
+
+   if(vanilla_heretic)
+      S_waitSequence(seq, seqtic + emax(delay, 1));
+   else
+      S_waitSequence(seq, seqtic + unsigned(delay) + 1);
+}
+
+//
+// Links a new sequence in and queues it to run on the next pass.
+//
+static void S_linkSequence(SndSeq_t *seq)
+{
+   seq->link.insert(seq, &SoundSequences);
+   seq->order = ++seqorder;
+   S_scheduleSequence(seq);
+}
+
+//
+// Unlinks a sequence from everything and frees it.
+//
+static void S_freeSequence(SndSeq_t *seq)
+{
+   seq->link.remove();
+   seq->waitlink.remove();
+   Z_Free(seq);
+}
+
 //
 // S_CheckSequenceLoop
 //
@@ -122,8 +194,7 @@ void S_StopSequence(const PointThinker *mo)
          }
 
          // unlink and delete this object
-         curSeq->link.remove();
-         Z_Free(curSeq);
+         S_freeSequence(curSeq);
       }
 
       link = next;
@@ -148,8 +219,7 @@ void S_SquashSequence(const PointThinker *mo)
       if((*link)->origin == mo)
       {
          // unlink and delete this object
-         link->remove();
-         Z_Free(link->dllObject);
+         S_freeSequence(link->dllObject);
       }
 
       link = next;
@@ -177,8 +247,7 @@ void S_KillSequence(PointThinker *mo)
          S_StopSound((*link)->origin, CHAN_ALL);
 
          // unlink and delete this object
-         link->remove();
-         Z_Free(link->dllObject);
+         S_freeSequence(link->dllObject);
       }
 
       link = next;
@@ -263,8 +332,6 @@ void S_StartSequenceNum(PointThinker *mo, int seqnum, int seqtype, int seqOrigin
    // allocate a new SndSeq object and link it
    newSeq = estructalloctag(SndSeq_t, 1, PU_LEVEL);
 
-   newSeq->link.insert(newSeq, &SoundSequences);
-
    // set up all fields
    newSeq->origin       = mo;                  // set origin
    newSeq->sequence     = edfSeq;              // set sequence pointer
@@ -279,6 +346,8 @@ void S_StartSequenceNum(PointThinker *mo, int seqnum, int seqtype, int seqOrigin
    newSeq->volume = 
       edfSeq->randvol ? M_RangeRandom(edfSeq->minvolume, edfSeq->volume)
                       : edfSeq->volume;
+
+   S_linkSequence(newSeq);
 }
 
 //
@@ -356,8 +425,6 @@ void S_StartSequenceName(PointThinker *mo, const char *seqname, int seqOriginTyp
    // allocate a new SndSeq object and link it
    newSeq = estructalloctag(SndSeq_t, 1, PU_LEVEL);
 
-   newSeq->link.insert(newSeq, &SoundSequences);
-
    // set up all fields
    newSeq->origin       = mo;                  // set origin
    newSeq->sequence     = edfSeq;              // set sequence pointer
@@ -372,6 +439,8 @@ void S_StartSequenceName(PointThinker *mo, const char *seqname, int seqOriginTyp
    newSeq->volume = 
       edfSeq->randvol ? M_RangeRandom(edfSeq->minvolume, edfSeq->volume)
                       : edfSeq->volume;
+
+   S_linkSequence(newSeq);
 }
 
 //
@@ -442,8 +511,9 @@ static void S_clearEnviroSequence();
 //
 // Runs a single sound sequence. This is another one of those miniature
 // virtual machines, although this one's not so miniature really O_O
+// Returns false if the sequence ended and was freed.
 //
-static void S_RunSequence(SndSeq_t *curSeq)
+static bool S_RunSequence(SndSeq_t *curSeq)
 {
    bool isPlaying = false;
    
@@ -452,12 +522,12 @@ static void S_RunSequence(SndSeq_t *curSeq)
    {
       // Different, buggier way of counting down in vanilla Heretic compatibility mode
       if(curSeq->delayCounter && --curSeq->delayCounter)
-         return;
+         return true;
    }
    else if(curSeq->delayCounter)
    {
       curSeq->delayCounter--;
-      return;
+      return true;
    }
 
    // see if a sound is playing
@@ -563,14 +633,16 @@ static void S_RunSequence(SndSeq_t *curSeq)
             S_StopSound(curSeq->origin, CHAN_ALL);
          
          // unlink and delete this object
-         curSeq->link.remove();
-         Z_Free(curSeq);
+         S_freeSequence(curSeq);
+         return false;
       }
       break;
    default: // unknown command? (shouldn't happen)
       I_Error("S_RunSequence: internal error - unknown sequence command\n");
       break;
    }
+
+   return true;
 }
 
 // prototypes for enviro functions from below
@@ -580,23 +652,67 @@ static void S_StopEnviroSequence();
 //
 // S_RunSequences
 //
-// Updates all running sound sequences.
+// Updates all running sound sequences. Only those due this pass are run; the
+// sounds they start reach the mixer together.
 //
 void S_RunSequences()
 {
-   DLListItem<SndSeq_t> *link = SoundSequences;
+   DLListItem<SndSeq_t> *link = seqwheel[++seqtic & (SEQWHEELSLOTS - 1)];
+
+   dueseqs.makeEmpty();
 
    while(link)
    {
       DLListItem<SndSeq_t> *next = link->dllNext;
 
-      S_RunSequence(*link);
+      // the slot also holds sequences waiting a multiple of the wheel size
+      if(link->dllObject->wakeTic == seqtic)
+      {
+         link->remove();
+         dueseqs.add(link->dllObject);
+      }
 
       link = next;
    } // end while
 
+   std::sort(dueseqs.begin(), dueseqs.end(),
+             [](const SndSeq_t *a, const SndSeq_t *b) { return a->order > b->order; });
+
+   I_HoldSoundCommands(true);
+
+   for(SndSeq_t *seq : dueseqs)
+   {
+      // the wait is over; S_RunSequence only counts down the enviro sequence
+      seq->delayCounter = 0;
+
+      if(S_RunSequence(seq))
+         S_scheduleSequence(seq);
+   }
+
    // run the environmental sequence, if any exists
    S_RunEnviroSequence();
+
+   I_HoldSoundCommands(false);
+}
+
+//
+// S_SyncSequenceDelays
+//
+// Sets each queued sequence's delayCounter to what the countdown would have
+// left in it by now, for savegames.
+//
+void S_SyncSequenceDelays()
+{
+   for(DLListItem<SndSeq_t> *link = SoundSequences; link; link = link->dllNext)
+   {
+      SndSeq_t *seq = link->dllObject;
+
+      if(!seq->waitlink.dllPrev)
+         continue; // not queued; delayCounter is as it was left
+
+      const int left = int(seq->wakeTic - seqtic);
+      seq->delayCounter = vanilla_heretic ? left : left - 1;
+   }
 }
 
 //
@@ -610,6 +726,7 @@ void S_StopAllSequences()
    // head is all that is needed to stop all sequences from playing. The sndseq
    // nodes will all be destroyed by P_SetupLevel.
    SoundSequences = nullptr;
+   memset(seqwheel, 0, sizeof(seqwheel));
 
    // also stop any running environmental sequence
    S_StopEnviroSequence();
@@ -807,7 +924,7 @@ void S_SetSequenceStatus(SndSeq_t *seq)
    else
    {
       // link this sequence
-      seq->link.insert(seq, &SoundSequences);
+      S_linkSequence(seq);
    }
 }
 
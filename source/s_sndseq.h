@@ -112,6 +112,11 @@ struct SndSeq_t
    // 10/17/06: data needed for savegames
    int originType;               // type of origin (sector, polyobj, other)
    int originIdx;                // sector or polyobj number, (or -1)
+
+   // delay queue, see s_sndseq.cpp
+   DLListItem<SndSeq_t> waitlink; // link in the queue, if waiting to run
+   unsigned int wakeTic;          // S_RunSequences pass it runs on next
+   unsigned int order;            // sequences started later run first
 };
 
 // Sound sequence pointers, needed for savegame support
@@ -137,6 +142,7 @@ void S_StartPolySequence(polyobj_t *po);
 void S_StopPolySequence(polyobj_t *po);
 
 void S_RunSequences(void);
+void S_SyncSequenceDelays(void);
 void S_StopAllSequences(void);
 void S_SetSequenceStatus(SndSeq_t *seq);
 void S_SequenceGameLoad(void);
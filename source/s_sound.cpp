@@ -39,11 +39,15 @@
 #include "e_sound.h"
 #include "i_sound.h"
 #include "i_system.h"
+#include "info.h"
+#include "m_collection.h"
 #include "m_compare.h"
+#include "m_perfstats.h"
 #include "m_random.h"
 #include "m_queue.h"
 #include "p_chase.h"
 #include "p_info.h"
+#include "p_mobj.h"
 #include "p_portal.h"
 #include "p_skin.h"
 #include "p_spec.h"
@@ -66,6 +70,9 @@
 #define NORM_SEP 128
 #define S_STEREO_SWING (96<<FRACBITS)
 
+// music lumps at least this big are streamed rather than loaded whole
+static constexpr int S_MUSICSTREAMSIZE = 512 * 1024;
+
 // sf: sound/music hashing
 // use sound_hash for music hash too
 
@@ -94,11 +101,46 @@ struct channel_t
   int singularity;         // haleyjd 09/27/06: stored singularity value
   int idnum;               // haleyjd 09/30/06: unique id num for sound event
   bool looping;            // haleyjd 10/06/06: is this channel looping?
+
+  // sector the origin was last found in, and where, for sector sound killing
+  const sector_t *originsec;
+  fixed_t originx, originy;
+
+  int audibility;          // effective volume weighted by priority
+  int voiceslot;           // 1-based position in the voice heap; 0 if absent
 };
 
 // the set of channels available
 static channel_t *channels;
 
+//
+// Voice management
+//
+// Channels that are not playing are kept on a stack so starting a sound
+// doesn't have to search for one. Playing channels are kept in a min-heap on
+// their audibility, so when every channel is busy the least audible one is
+// at hand to be stolen, or to decide that the new sound isn't worth playing.
+//
+static int s_freechannels[SND_MAXCHANNELS];
+static int s_numfreechannels;
+static int s_voiceheap[SND_MAXCHANNELS];
+static int s_numvoices;
+
+// counts reported by s_voicestats
+static struct
+{
+   unsigned int started;  // sounds given a channel
+   unsigned int culled;   // sounds not started because they would be inaudible
+   unsigned int rejected; // sounds not started for want of a channel
+   unsigned int stolen;   // playing sounds cut off for a more audible one
+} s_voicestats;
+
+static PerfGauge   voicesstat("sound.voices", "", [] { return double(s_numvoices); });
+static PerfCounter startedstat("sound.started", "", [] { return double(s_voicestats.started); });
+static PerfCounter culledstat("sound.culled", "", [] { return double(s_voicestats.culled); });
+static PerfCounter rejectedstat("sound.rejected", "", [] { return double(s_voicestats.rejected); });
+static PerfCounter stolenstat("sound.stolen", "", [] { return double(s_voicestats.stolen); });
+
 // Maximum volume of a sound effect.
 // Internal default is max out of 0-SND_MAXVOLUME.
 int snd_SfxVolume = SND_MAXVOLUME;
@@ -138,6 +180,139 @@ bool s_hidefmusic;
 // Internals.
 //
 
+//
+// S_voiceAudibility
+//
+// How much a sound at the given volume and priority is worth keeping. A
+// lower priority number means a more important sound, as everywhere else.
+//
+static int S_voiceAudibility(int volume, int priority)
+{
+   return volume * (256 - eclamp(priority, 0, 255));
+}
+
+static void S_placeVoice(int slot, int cnum)
+{
+   s_voiceheap[slot] = cnum;
+   channels[cnum].voiceslot = slot + 1;
+}
+
+static void S_siftVoiceUp(int slot)
+{
+   const int cnum = s_voiceheap[slot];
+   const int aud  = channels[cnum].audibility;
+
+   while(slot > 0)
+   {
+      const int parent = (slot - 1) / 2;
+      if(channels[s_voiceheap[parent]].audibility <= aud)
+         break;
+      S_placeVoice(slot, s_voiceheap[parent]);
+      slot = parent;
+   }
+   S_placeVoice(slot, cnum);
+}
+
+static void S_siftVoiceDown(int slot)
+{
+   const int cnum = s_voiceheap[slot];
+   const int aud  = channels[cnum].audibility;
+
+   while(true)
+   {
+      int child = slot * 2 + 1;
+      if(child >= s_numvoices)
+         break;
+      if(child + 1 < s_numvoices &&
+         channels[s_voiceheap[child + 1]].audibility < channels[s_voiceheap[child]].audibility)
+         ++child;
+      if(aud <= channels[s_voiceheap[child]].audibility)
+         break;
+      S_placeVoice(slot, s_voiceheap[child]);
+      slot = child;
+   }
+   S_placeVoice(slot, cnum);
+}
+
+//
+// S_addVoice
+//
+// Puts a channel that has started playing into the voice heap.
+//
+static void S_addVoice(int cnum)
+{
+   s_voiceheap[s_numvoices] = cnum;
+   S_siftVoiceUp(s_numvoices++);
+}
+
+//
+// S_removeVoice
+//
+// Takes a channel out of the voice heap, if it is in it.
+//
+static void S_removeVoice(int cnum)
+{
+   const int slot = channels[cnum].voiceslot - 1;
+
+   if(slot < 0)
+      return;
+
+   channels[cnum].voiceslot = 0;
+   if(slot == --s_numvoices)
+      return;
+
+   S_placeVoice(slot, s_voiceheap[s_numvoices]);
+   S_siftVoiceUp(slot);
+   S_siftVoiceDown(channels[s_voiceheap[slot]].voiceslot - 1);
+}
+
+//
+// S_setVoiceAudibility
+//
+// Updates a playing channel's audibility and its place in the voice heap.
+//
+static void S_setVoiceAudibility(int cnum, int audibility)
+{
+   channel_t *c = &channels[cnum];
+   const int  old = c->audibility;
+
+   c->audibility = audibility;
+   if(!c->voiceslot || audibility == old)
+      return;
+
+   if(audibility < old)
+      S_siftVoiceUp(c->voiceslot - 1);
+   else
+      S_siftVoiceDown(c->voiceslot - 1);
+}
+
+//
+// S_releaseChannel
+//
+// Clears an allocated channel and returns it to the free stack.
+//
+static void S_releaseChannel(int cnum)
+{
+   S_removeVoice(cnum);
+
+   // haleyjd 09/27/06: clear the entire channel
+   memset(&channels[cnum], 0, sizeof(channel_t));
+   s_freechannels[s_numfreechannels++] = cnum;
+}
+
+//
+// S_resetVoices
+//
+// Marks every channel free. The lowest-numbered channels are handed out first.
+//
+static void S_resetVoices()
+{
+   s_numvoices       = 0;
+   s_numfreechannels = 0;
+   for(int cnum = numChannels - 1; cnum >= 0; cnum--)
+      s_freechannels[s_numfreechannels++] = cnum;
+}
+
 //
 // S_StopChannel
 //
@@ -155,9 +330,7 @@ static void S_StopChannel(int cnum)
    if(c->sfxinfo)
    {
       I_StopSound(c->handle, c->idnum); // stop the sound playing
-
-      // haleyjd 09/27/06: clear the entire channel
-      memset(c, 0, sizeof(channel_t));
+      S_releaseChannel(cnum);
    }
 }
 
@@ -185,6 +358,30 @@ static bool S_CheckSectorKill(const sector_t *earsec, const PointThinker *src)
    return false;
 }
 
+//
+// S_checkChannelKill
+//
+// S_CheckSectorKill for the source of a playing channel. Most sources move
+// rarely if at all, so the sector they are in is only looked up again when
+// they do.
+//
+static bool S_checkChannelKill(channel_t *c)
+{
+   const PointThinker *src = c->origin;
+
+   if(gamestate != GS_LEVEL || !src)
+      return false;
+
+   if(!c->originsec || src->x != c->originx || src->y != c->originy)
+   {
+      c->originsec = R_PointInSubsector(src->x, src->y)->sector;
+      c->originx   = src->x;
+      c->originy   = src->y;
+   }
+
+   return (c->originsec->flags & SECF_KILLSOUND) != 0;
+}
+
 //
 // S_AdjustSoundParams
 //
@@ -318,30 +515,26 @@ static int S_AdjustSoundParams(camera_t *listener, const PointThinker *source,
 //
 //   If none available, return -1.  Otherwise channel #.
 //   haleyjd 09/27/06: fixed priority/singularity bugs
-//   Note that a higher priority number means lower priority!
+//   When every channel is busy, the least audible sound playing is cut off
+//   if the new sound is at least as audible, and otherwise the new sound
+//   is dropped.
 //
 static int S_getChannel(const PointThinker *origin, sfxinfo_t *sfxinfo,
-                        int priority, int singularity, int schan,
+                        int audibility, int singularity, int schan,
                         bool nocutoff)
 {
-   // channel number to use
-   int cnum;
-   int lowestpriority = D_MININT; // haleyjd
-   int lpcnum = -1;
    bool origin_equivalent;
 
    // haleyjd 09/28/06: moved this here. If we kill a sound already
-   // being played, we can use that channel. There is no need to
-   // search for a free one again because we already know of one.
+   // being played, we can use that channel. It goes back on top of the
+   // free stack, so it is the one taken below.
 
    // kill old sound?
-   if(nocutoff)
-      cnum = numChannels;
-   else
+   if(!nocutoff)
    {
       // killough 12/98: replace is_pickup hack with singularity flag
       // haleyjd 06/12/08: only if subchannel matches
-      for(cnum = 0; cnum < numChannels; cnum++)
+      for(int cnum = 0; cnum < numChannels; cnum++)
       {
          // haleyjd 04/09/11: Allow different sounds played on nullptr
          // channel to not cut each other off
@@ -361,38 +554,26 @@ static int S_getChannel(const PointThinker *origin, sfxinfo_t *sfxinfo,
       }
    }
 
-   // Find an open channel
-   if(cnum == numChannels)
-   {
-      // haleyjd 09/28/06: it isn't necessary to look for playing sounds in
-      // the same singularity class again, as we just did that above. Here
-      // we are looking for an open channel. We will also keep track of the
-      // channel found with the lowest sound priority while doing this.
-      for(cnum = 0; cnum < numChannels && channels[cnum].sfxinfo; cnum++)
-      {
-         if(channels[cnum].priority > lowestpriority)
-         {
-            lowestpriority = channels[cnum].priority;
-            lpcnum = cnum;
-         }
-      }
-   }
-
    // None available?
-   if(cnum == numChannels)
+   if(!s_numfreechannels)
    {
-      // Look for lower priority
-      // haleyjd: we have stored the channel found with the lowest priority
-      // in the loop above
-      if(priority > lowestpriority)
-         return -1;                  // No lower priority.  Sorry, Charlie.
-      else
+      if(!s_numvoices)
+         return -1;
+
+      // Look for a less audible sound
+      const int victim = s_voiceheap[0];
+      if(channels[victim].audibility > audibility)
       {
-         S_StopChannel(lpcnum);      // Otherwise, kick out lowest priority.
-         cnum = lpcnum;
+         ++s_voicestats.rejected;
+         return -1;                  // None less audible.  Sorry, Charlie.
       }
+
+      S_StopChannel(victim);         // Otherwise, kick out the least audible.
+      ++s_voicestats.stolen;
    }
 
+   const int cnum = s_freechannels[--s_numfreechannels];
+
 #ifdef RANGECHECK
    if(cnum >= numChannels)
       I_Error("S_getChannel: handle %d out of range\n", cnum);
@@ -408,13 +589,7 @@ static int S_getChannel(const PointThinker *origin, sfxinfo_t *sfxinfo,
 //
 static int S_countChannels()
 {
-   int numchannels = 0;
-
-   for(int cnum = 0; cnum < numChannels; cnum++)
-      if(channels[cnum].sfxinfo)
-         ++numchannels;
-
-   return numchannels;
+   return numChannels - s_numfreechannels;
 }
 
 //
@@ -579,14 +754,20 @@ void S_StartSfxInfo(const soundparams_t &params)
       volume = (volume * volumeScale) / SND_MAXVOLUME; // haleyjd 05/29/06: scale volume
       volume = eclamp(volume, 0, 127);
       if(volume < 1) // clip due to inaudibility
+      {
+         ++s_voicestats.culled;
          return;
+      }
    }
    else
    {
       // use an external cam?
       if(!S_AdjustSoundParams(listener, origin, volumeScale, params.attenuation,
                               &volume, &sep, &pitch, &priority, sfx))
+      {
+         ++s_voicestats.culled;
          return;
+      }
       else if(origin->x == playercam.x && origin->y == playercam.y)
          sep = NORM_SEP;
    }
@@ -622,8 +803,10 @@ void S_StartSfxInfo(const soundparams_t &params)
    if(subchannel == CHAN_AUTO)
       subchannel = sfx->subchannel;
 
+   const int audibility = S_voiceAudibility(volume, o_priority);
+
    // try to find a channel
-   if((cnum = S_getChannel(origin, sfx, priority, singularity, subchannel, nocutoff)) < 0)
+   if((cnum = S_getChannel(origin, sfx, audibility, singularity, subchannel, nocutoff)) < 0)
       return;
 
 #ifdef RANGECHECK
@@ -634,6 +817,7 @@ void S_StartSfxInfo(const soundparams_t &params)
    channels[cnum].sfxinfo = sfx;
    channels[cnum].aliasinfo = aliasinfo;
    channels[cnum].origin  = origin;
+   channels[cnum].originsec = nullptr;
 
    while(sfx->link)
       sfx = sfx->link;     // sf: skip thru link(s)
@@ -659,10 +843,13 @@ void S_StartSfxInfo(const soundparams_t &params)
       channels[cnum].looping     = params.loop;
       channels[cnum].subchannel  = subchannel;
       channels[cnum].idnum       = I_SoundID(handle); // unique instance id
+      channels[cnum].audibility  = audibility;
+      S_addVoice(cnum);
+      ++s_voicestats.started;
    }
    else // haleyjd: the sound didn't start, so clear the channel info
    {
-      memset(&channels[cnum], 0, sizeof(channel_t));
+      S_releaseChannel(cnum);
    }
 }
 
@@ -951,6 +1138,13 @@ void S_UpdateSounds(const Mobj *listener)
    // update sound environment
    S_updateEnvironment(earsec);
 
+   // the listener's own sector only needs checking once
+   const bool earkilled = listener && S_CheckSectorKill(earsec, nullptr);
+
+   // changed parameters are gathered up and handed over together
+   sndupdate_t updates[SND_MAXCHANNELS];
+   int numupdates = 0;
+
    // now update each individual channel
    for(int cnum = 0; cnum < numChannels; cnum++)
    {
@@ -964,7 +1158,7 @@ void S_UpdateSounds(const Mobj *listener)
       if(c->idnum != I_SoundID(c->handle))
       {
          // clear the channel and keep going
-         memset(c, 0, sizeof(channel_t));
+         S_releaseChannel(cnum);
          continue;
       }
 
@@ -987,7 +1181,7 @@ void S_UpdateSounds(const Mobj *listener)
          // inappropriately. The only reason he changed this was to get to
          // the code in S_AdjustSoundParams that checks for sector sound
          // killing. We do that here now instead.
-         if(listener && S_CheckSectorKill(earsec, c->origin))
+         if(listener && (earkilled || S_checkChannelKill(c)))
             S_StopChannel(cnum);
          else if(c->origin && static_cast<const PointThinker *>(listener) != c->origin) // killough 3/20/98
          {
@@ -1003,14 +1197,18 @@ void S_UpdateSounds(const Mobj *listener)
             }
             else
             {
-               I_UpdateSoundParams(c->handle, volume, sep, pitch);
+               updates[numupdates++] = { c->handle, volume, sep, pitch };
                c->priority = pri; // haleyjd
+               S_setVoiceAudibility(cnum, S_voiceAudibility(volume, c->o_priority));
             }
          }
       }
       else   // if channel is allocated but sound has stopped, free it
          S_StopChannel(cnum);
    }
+
+   if(numupdates)
+      I_UpdateSoundParamsBatch(updates, numupdates);
 }
 
 //
@@ -1108,8 +1306,62 @@ void S_SetSfxVolume(int volume)
 // Sound Hashing
 //
 
-sfxinfo_t *S_SfxInfoForName(const char *name)
+//
+// Sound name cache
+//
+// Most sounds started by name come from strings that live as long as the
+// EDF definition or ACS string they belong to, so S_SfxInfoForName remembers
+// what each one resolved to, keyed on the string's address. A hit is checked
+// against a copy of the name in case the string was freed and another put in
+// its place, and is dropped when the sound hash or the WAD directory grows.
+// Names that don't resolve are cached too; they would otherwise cost a WAD
+// directory search every time.
+//
+static constexpr int    SFXNAMECACHESIZE = 256; // must be a power of two
+static constexpr size_t SFXNAMECACHELEN  = 32;  // longer names aren't cached
+
+struct sfxnamecache_t
+{
+   const char  *ptr;
+   unsigned int generation;
+   int          numlumps;
+   sfxinfo_t   *sfx;
+   char         name[SFXNAMECACHELEN];
+};
+
+static sfxnamecache_t sfxnamecache[SFXNAMECACHESIZE];
+
+// counts reported by s_namestats
+static struct
+{
+   unsigned int hits;
+   unsigned int lookups;     // names resolved through the sound hash
+   int          tic;         // gametic the per-tic count belongs to
+   unsigned int ticlookups;  // lookups made during that tic
+   unsigned int peaklookups; // most lookups seen in one tic
+   int          starttic;    // gametic of the last report
+} s_namestats;
+
+static void S_countNameLookup()
 {
+   if(s_namestats.tic != gametic)
+   {
+      s_namestats.tic        = gametic;
+      s_namestats.ticlookups = 0;
+   }
+   ++s_namestats.lookups;
+   s_namestats.peaklookups = emax(s_namestats.peaklookups, ++s_namestats.ticlookups);
+}
+
+//
+// S_lookupSfxName
+//
+// Resolves a sound name without the cache.
+//
+static sfxinfo_t *S_lookupSfxName(const char *name)
+{
+   S_countNameLookup();
+
    // haleyjd 09/03/03: now calls down to master EDF sound hash
    sfxinfo_t *sfx = E_SoundForName(name);
 
@@ -1129,6 +1381,36 @@ sfxinfo_t *S_SfxInfoForName(const char *name)
    return sfx;
 }
 
+sfxinfo_t *S_SfxInfoForName(const char *name)
+{
+   const auto      key   = reinterpret_cast<uintptr_t>(name);
+   sfxnamecache_t &entry = sfxnamecache[((key >> 3) ^ (key >> 11)) & (SFXNAMECACHESIZE - 1)];
+
+   const unsigned int generation = E_SoundNameGeneration();
+   const int          numlumps   = wGlobalDir.getNumLumps();
+
+   if(entry.ptr == name && entry.generation == generation && entry.numlumps == numlumps &&
+      !strcmp(entry.name, name))
+   {
+      ++s_namestats.hits;
+      return entry.sfx;
+   }
+
+   sfxinfo_t *sfx = S_lookupSfxName(name);
+
+   if(strlen(name) < SFXNAMECACHELEN)
+   {
+      // a new WAD sound bumps the generation while being looked up
+      entry.ptr        = name;
+      entry.generation = E_SoundNameGeneration();
+      entry.numlumps   = numlumps;
+      entry.sfx        = sfx;
+      strcpy(entry.name, name);
+   }
+
+   return sfx;
+}
+
 //
 // S_Chgun
 //
@@ -1213,6 +1495,21 @@ void S_ChangeMusic(musicinfo_t *music, int looping)
       return;
    }
 
+   // large tracks are read from the lump as they play, where the music
+   // driver and the lump's storage allow
+   if(W_LumpLength(lumpnum) >= S_MUSICSTREAMSIZE)
+   {
+      if(WadLumpStream *stream = wGlobalDir.openLumpStream(lumpnum))
+      {
+         if((music->handle = I_RegisterSongStream(stream)))
+         {
+            I_PlaySong(music->handle, looping);
+            mus_playing = music;
+            return;
+         }
+      }
+   }
+
    // load & register it
    // haleyjd: changed to PU_STATIC
    // julian: added lump length
@@ -1302,7 +1599,7 @@ void S_ChangeMusicName(const char *name, int looping)
 //
 void S_StopMusic()
 {
-   if(!mus_playing || !mus_playing->data)
+   if(!mus_playing)
       return;
 
    if(mus_paused)
@@ -1310,7 +1607,8 @@ void S_StopMusic()
 
    I_StopSong(mus_playing->handle);
    I_UnRegisterSong(mus_playing->handle);
-   Z_Free(mus_playing->data);
+   if(mus_playing->data) // streamed music has none
+      Z_Free(mus_playing->data);
 
    mus_playing->data = nullptr;
    mus_playing = nullptr;
@@ -1377,6 +1675,80 @@ int S_MusicForMapHtic()
    return H_Mus_Matrix[gep - 1][gmp - 1];
 }
 
+//
+// S_addPrecacheSound
+//
+// Resolves a sound the way S_StartSfxInfo would, adding every sound it could
+// end up playing to the list.
+//
+static void S_addPrecacheSound(PODCollection<sfxinfo_t *> &sounds, sfxinfo_t *sfx,
+                               int depth = 0)
+{
+   // guard against alias loops
+   if(!sfx || depth > 16)
+      return;
+
+   if(sfx->alias)
+      S_addPrecacheSound(sounds, sfx->alias, depth + 1);
+   else if(sfx->randomsounds)
+   {
+      for(int i = 0; i < sfx->numrandomsounds; i++)
+         S_addPrecacheSound(sounds, sfx->randomsounds[i], depth + 1);
+   }
+   else
+   {
+      while(sfx->link)
+         sfx = sfx->link;
+      if(!sfx->data)
+         sounds.add(sfx);
+   }
+}
+
+//
+// S_PrecacheLevelSounds
+//
+// Gathers the sounds of every thing type present in the level and lets the
+// sound driver prepare them before they are first heard.
+//
+void S_PrecacheLevelSounds()
+{
+   if(!snd_card || nosfxparm)
+      return;
+
+   PODCollection<sfxinfo_t *> sounds;
+   byte *typehit = ecalloc(byte *, NUMMOBJTYPES, 1);
+
+   for(Thinker *th = thinkercap.next; th != &thinkercap; th = th->next)
+   {
+      if(Mobj *mo = thinker_cast<Mobj *>(th))
+         typehit[mo->type] = 1;
+   }
+
+   for(int i = 0; i < NUMMOBJTYPES; i++)
+   {
+      if(!typehit[i])
+         continue;
+
+      const mobjinfo_t *mi = mobjinfo[i];
+      const int typesounds[] =
+      {
+         mi->seesound, mi->attacksound, mi->painsound, mi->deathsound,
+         mi->activesound, mi->activatesound, mi->deactivatesound, mi->ripsound
+      };
+
+      for(int num : typesounds)
+      {
+         if(num)
+            S_addPrecacheSound(sounds, E_SoundForDEHNum(num));
+      }
+   }
+
+   efree(typehit);
+
+   if(!sounds.isEmpty())
+      I_PrecacheSounds(&sounds[0], int(sounds.getLength()));
+}
+
 //
 // S_Start
 //
@@ -1491,6 +1863,7 @@ void S_Init(int sfxVolume, int musicVolume)
       // killough 10/98:
       numChannels = default_numChannels;
       channels = ecalloc(channel_t *, numChannels, sizeof(channel_t));
+      S_resetVoices();
    }
 
    if(s_precache)        // sf: option to precache sounds
@@ -1613,7 +1986,7 @@ musicinfo_t *S_MusicForName(const char *name)
 
 VARIABLE_BOOLEAN(s_precache,      nullptr, onoff);
 VARIABLE_BOOLEAN(pitched_sounds,  nullptr, onoff);
-VARIABLE_INT(default_numChannels, nullptr, 1, 32,                nullptr);
+VARIABLE_INT(default_numChannels, nullptr, 1, SND_MAXCHANNELS,   nullptr);
 VARIABLE_INT(snd_SfxVolume,       nullptr, 0, SND_MAXVOLUME,  nullptr);
 VARIABLE_INT(snd_MusicVolume,     nullptr, 0, SND_MAXVOLUME,  nullptr);
 VARIABLE_BOOLEAN(forceFlipPan,    nullptr, onoff);
@@ -1684,6 +2057,51 @@ CONSOLE_COMMAND(s_stopmusic, 0)
    S_StopMusic();
 }
 
+//
+// s_voicestats
+//
+// Print how sound starts have fared against the channel limit, then reset
+// the counts.
+//
+CONSOLE_COMMAND(s_voicestats, 0)
+{
+   if(!snd_card || nosfxparm)
+   {
+      C_Printf("Sound effects are disabled\n");
+      return;
+   }
+
+   C_Printf("Channels: %d of %d playing\n"
+            "Started:  %u\n"
+            "Culled:   %u (inaudible)\n"
+            "Rejected: %u (all channels more audible)\n"
+            "Stolen:   %u\n",
+            S_countChannels(), numChannels, s_voicestats.started,
+            s_voicestats.culled, s_voicestats.rejected, s_voicestats.stolen);
+
+   s_voicestats = {};
+}
+
+//
+// s_namestats
+//
+// Print how often sounds played by name still had to be looked up in the
+// sound hash, then reset the counts.
+//
+CONSOLE_COMMAND(s_namestats, 0)
+{
+   const int tics = emax(gametic - s_namestats.starttic, 1);
+
+   C_Printf("Cache hits: %u\n"
+            "Lookups:    %u (%.2f per tic, peak %u)\n",
+            s_namestats.hits, s_namestats.lookups,
+            double(s_namestats.lookups) / tics, s_namestats.peaklookups);
+
+   s_namestats = {};
+   s_namestats.tic      = gametic;
+   s_namestats.starttic = gametic;
+}
+
 #if 0
 //
 // Small native functions
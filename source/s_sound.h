@@ -63,6 +63,9 @@ void S_Init(int sfxVolume, int musicVolume);
 //
 void S_Start();
 
+// Prepare the sounds of the level's things ahead of their first use
+void S_PrecacheLevelSounds();
+
 // haleyjd 05/30/06: sound attenuation types
 enum
 {
@@ -154,6 +157,7 @@ bool S_CheckSoundPlaying(const PointThinker *, int sound_id);
 extern int s_precache;
 
 // machine-independent sound params
+constexpr int SND_MAXCHANNELS = 128; // upper limit for snd_channels
 extern int numChannels;
 extern int default_numChannels;  // killough 10/98
 
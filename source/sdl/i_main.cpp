@@ -30,6 +30,10 @@
 #include "../d_main.h"
 #include "../i_system.h"
 
+#ifdef EE_DRAWBENCH
+#include "../r_drawbench.h"
+#endif
+
 #if (EE_CURRENT_PLATFORM != EE_PLATFORM_WINDOWS)
 #if __has_include(<xlocale.h>)
 #include <xlocale.h>
@@ -74,6 +78,11 @@ int main(int argc, char **argv)
    myargc = argc;
    myargv = argv;
 
+#ifdef EE_DRAWBENCH
+   // eternity-bench: time the drawers and quit, without SDL or a game
+   return R_DrawBenchMain();
+#endif
+
 #if (EE_CURRENT_PLATFORM == EE_PLATFORM_WINDOWS)
    if(I_IsWindowsVistaOrHigher())
       SDL_setenv("SDL_AUDIODRIVER", "wasapi", true);
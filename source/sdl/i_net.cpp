@@ -34,6 +34,21 @@
 
 #include "SDL_net.h"
 
+// -nativenet: plain sockets, batched with sendmmsg/recvmmsg where there are
+// those calls
+#if defined(__unix__) || defined(__APPLE__)
+#define EE_HAVE_NATIVENET
+#if defined(__linux__) || defined(__FreeBSD__)
+#define EE_HAVE_MMSG
+#endif
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
 #include "../z_zone.h"  /* memory allocation wrappers -- killough */
 
 #include "../doomstat.h"
@@ -41,7 +56,10 @@
 #include "../i_system.h"
 #include "../d_event.h"
 #include "../d_net.h"
+#include "../hal/i_timer.h"
 #include "../m_argv.h"
+#include "../m_collection.h"
+#include "../m_compare.h"
 
 #include "../i_net.h"
 
@@ -59,6 +77,25 @@ static UDPpacket *packet;
 
 static IPaddress sendaddress[MAXNETNODES];
 
+// ticcmd wire format used with each node
+static int netformat[MAXNETNODES];
+
+// Round trip timing for NETFORMAT_TIMED. Each packet stamps the time it was
+// sent, and echoes the last stamp from the node it goes to, moved forward by
+// how long that was held. What the echo lags behind the clock when it comes
+// back is one round trip.
+struct nettiming_t
+{
+   Uint16       peerstamp; // last stamp the node sent
+   unsigned int peerat;    // when it came
+   bool         havepeer;
+   int          srtt;      // smoothed round trip, ms * 8
+   int          rttvar;    // its mean deviation, ms * 4
+   bool         measured;
+};
+
+static nettiming_t nettiming[MAXNETNODES];
+
 // haleyjd: new functions for anarkavre's WinMBF netcode
 
 // haleyjd 06/29/11: Default error-out funcs in case of high-level goofups, as
@@ -196,6 +233,104 @@ enum
    TCF_SLOTINDEX   = 0x00000400,
 };
 
+// NETFORMAT_DELTA: a tic's flags mark the fields that differ from the tic
+// before it in the packet (for the first tic, from an empty ticcmd). The
+// common fields fit the first byte; TDF_EXTENDED says a second one follows.
+enum
+{
+   TDF_FORWARDMOVE = 0x0001,
+   TDF_SIDEMOVE    = 0x0002,
+   TDF_ANGLETURN   = 0x0004,
+   TDF_CONSISTENCY = 0x0008,
+   TDF_BUTTONS     = 0x0010,
+   TDF_LOOK        = 0x0020,
+   TDF_ACTIONS     = 0x0040,
+   TDF_EXTENDED    = 0x0080,
+   TDF_CHATCHAR    = 0x0100,
+   TDF_FLY         = 0x0200,
+   TDF_ITEMID      = 0x0400,
+   TDF_WEAPONID    = 0x0800,
+   TDF_SLOTINDEX   = 0x1000,
+};
+
+// set in numtics on packets whose tics are delta encoded
+#define NUMTICS_DELTA 0x80
+
+// NETFORMAT_TIMED: also set in numtics, on delta packets whose tics follow
+// the input delay, a stamp and an echo (see nettiming_t). The input delay's
+// high bit says whether the echo is valid.
+#define NUMTICS_TIMED  0x40
+#define TIMEDSIZE      5
+#define TIMEDECHOVALID 0x80
+
+// most bytes a ticcmd takes on the wire with every field sent, in either
+// format, and the packet size that allows for a full set of tics
+#define MAXTICCMDSIZE 19
+#define MAXPACKETSIZE (8 + TIMEDSIZE + BACKUPTICS * MAXTICCMDSIZE)
+
+// Spectator relay packets: a request is RELAYREQUEST and how many bytes of
+// the stream the spectator holds; the answer is RELAYDATA, the offset of the
+// bytes that follow, and up to RELAYPACKETSIZE bytes in all.
+#define RELAYREQUEST    0x45455251 // "EERQ"
+#define RELAYDATA       0x45455244 // "EERD"
+#define RELAYHEADER     8
+#define RELAYPACKETSIZE 1200
+
+#define NETMAX(a, b) ((a) > (b) ? (a) : (b))
+
+// size of the packet buffers
+#define NETBUFSIZE \
+   ((NETMAX(NETMAX(sizeof(doomdata_t), MAXPACKETSIZE), RELAYPACKETSIZE) + 31) & ~31)
+
+// round trips longer than this are taken for stale echoes
+#define MAXRTTSAMPLE 5000
+
+#define TDFCHECK(field, flag) \
+   if(cmd.field != prev.field) \
+      ticcmdflags |= (flag)
+
+//
+// I_NetSetFormat
+//
+void I_NetSetFormat(int node, int format)
+{
+   if(node >= 0 && node < MAXNETNODES)
+      netformat[node] = format;
+}
+
+//
+// I_NetNodeTiming
+//
+bool I_NetNodeTiming(int node, int &rtt, int &jitter)
+{
+   if(node < 0 || node >= MAXNETNODES || !nettiming[node].measured)
+      return false;
+
+   rtt    = nettiming[node].srtt >> 3;
+   jitter = nettiming[node].rttvar >> 2;
+   return true;
+}
+
+//
+// I_netAddRTTSample
+//
+// Smooths round trip samples the same way TCP does.
+//
+static void I_netAddRTTSample(nettiming_t &timing, int sample)
+{
+   if(!timing.measured)
+   {
+      timing.srtt     = sample << 3;
+      timing.rttvar   = sample << 1;
+      timing.measured = true;
+      return;
+   }
+
+   const int err = sample - (timing.srtt >> 3);
+   timing.srtt   += err;
+   timing.rttvar += abs(err) - (timing.rttvar >> 2);
+}
+
 // DEBUG
 
 void writesendpacket(void *data, int len)
@@ -221,6 +356,251 @@ void writegetpacket(void *data, int len)
 }
 
 
+//=============================================================================
+//
+// Native socket backend
+//
+// SDL_net sends and receives one datagram per call. With -nativenet a plain
+// UDP socket is used instead: sends are queued until the game next reads
+// packets (or calls I_NetFlush), then all go out in one sendmmsg, and a read
+// drains everything waiting in one recvmmsg, handing it out a packet at a
+// time. Where those calls don't exist, the same batches are moved with a
+// loop of sendto and recvfrom.
+//
+
+#ifdef EE_HAVE_NATIVENET
+
+#define NATIVEBATCH (MAXNETNODES * 2)
+
+struct nativeslot_t
+{
+   byte        data[NETBUFSIZE];
+   int         len;
+   sockaddr_in addr;
+};
+
+static int          nativesocket = -1;
+static nativeslot_t nativesends[NATIVEBATCH];
+static int          numnativesends;
+static nativeslot_t nativerecvs[NATIVEBATCH];
+static int          numnativerecvs;
+static int          nextnativerecv;
+
+//
+// I_nativeOpen
+//
+static bool I_nativeOpen(Uint16 port)
+{
+   sockaddr_in addr = {};
+
+   if((nativesocket = socket(AF_INET, SOCK_DGRAM, 0)) < 0)
+      return false;
+
+   addr.sin_family      = AF_INET;
+   addr.sin_addr.s_addr = htonl(INADDR_ANY);
+   addr.sin_port        = htons(port);
+
+   if(fcntl(nativesocket, F_SETFL, fcntl(nativesocket, F_GETFL, 0) | O_NONBLOCK) < 0 ||
+      bind(nativesocket, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0)
+   {
+      close(nativesocket);
+      nativesocket = -1;
+      return false;
+   }
+
+   return true;
+}
+
+//
+// I_nativeFlush
+//
+// Sends every queued packet. A full socket buffer drops the rest, as it
+// would for a lost packet.
+//
+static void I_nativeFlush()
+{
+   int sent = 0;
+
+#ifdef EE_HAVE_MMSG
+   mmsghdr msgs[NATIVEBATCH] = {};
+   iovec   iovs[NATIVEBATCH];
+
+   for(int i = 0; i < numnativesends; i++)
+   {
+      iovs[i].iov_base = nativesends[i].data;
+      iovs[i].iov_len  = nativesends[i].len;
+      msgs[i].msg_hdr.msg_iov     = &iovs[i];
+      msgs[i].msg_hdr.msg_iovlen  = 1;
+      msgs[i].msg_hdr.msg_name    = &nativesends[i].addr;
+      msgs[i].msg_hdr.msg_namelen = sizeof(nativesends[i].addr);
+   }
+
+   while(sent < numnativesends)
+   {
+      const int result = sendmmsg(nativesocket, msgs + sent, numnativesends - sent, 0);
+#else
+   while(sent < numnativesends)
+   {
+      const nativeslot_t &slot = nativesends[sent];
+      const int result = sendto(nativesocket, slot.data, slot.len, 0,
+                                reinterpret_cast<const sockaddr *>(&slot.addr),
+                                sizeof(slot.addr)) < 0 ? -1 : 1;
+#endif
+      if(result < 0)
+      {
+         if(errno == EINTR)
+            continue;
+         if(errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS)
+            break;
+         I_Error("Error sending packet: %s\n", strerror(errno));
+      }
+      sent += result;
+   }
+
+   numnativesends = 0;
+}
+
+//
+// I_nativeSend
+//
+// Queues the packet.
+//
+static void I_nativeSend()
+{
+   if(numnativesends == NATIVEBATCH)
+      I_nativeFlush();
+
+   nativeslot_t &slot = nativesends[numnativesends++];
+
+   memcpy(slot.data, packet->data, packet->len);
+   slot.len = packet->len;
+   slot.addr = {};
+   slot.addr.sin_family      = AF_INET;
+   slot.addr.sin_addr.s_addr = packet->address.host; // SDL_net keeps these in
+   slot.addr.sin_port        = packet->address.port; // network order already
+}
+
+//
+// I_nativeRecv
+//
+// Reads the next packet into packet, draining the socket first if the last
+// batch has run out. Returns as SDLNet_UDP_Recv does.
+//
+static int I_nativeRecv()
+{
+   if(nextnativerecv == numnativerecvs)
+   {
+      numnativerecvs = nextnativerecv = 0;
+
+#ifdef EE_HAVE_MMSG
+      mmsghdr msgs[NATIVEBATCH] = {};
+      iovec   iovs[NATIVEBATCH];
+
+      for(int i = 0; i < NATIVEBATCH; i++)
+      {
+         iovs[i].iov_base = nativerecvs[i].data;
+         iovs[i].iov_len  = sizeof(nativerecvs[i].data);
+         msgs[i].msg_hdr.msg_iov     = &iovs[i];
+         msgs[i].msg_hdr.msg_iovlen  = 1;
+         msgs[i].msg_hdr.msg_name    = &nativerecvs[i].addr;
+         msgs[i].msg_hdr.msg_namelen = sizeof(nativerecvs[i].addr);
+      }
+
+      int result;
+      while((result = recvmmsg(nativesocket, msgs, NATIVEBATCH, MSG_DONTWAIT, nullptr)) < 0 &&
+            errno == EINTR);
+
+      if(result < 0)
+         return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+
+      for(int i = 0; i < result; i++)
+         nativerecvs[i].len = static_cast<int>(msgs[i].msg_len);
+      numnativerecvs = result;
+#else
+      while(numnativerecvs < NATIVEBATCH)
+      {
+         nativeslot_t &slot = nativerecvs[numnativerecvs];
+         socklen_t addrlen = sizeof(slot.addr);
+
+         const ssize_t result = recvfrom(nativesocket, slot.data, sizeof(slot.data), 0,
+                                         reinterpret_cast<sockaddr *>(&slot.addr),
+                                         &addrlen);
+         if(result < 0)
+         {
+            if(errno == EINTR)
+               continue;
+            if(errno == EAGAIN || errno == EWOULDBLOCK)
+               break;
+            return -1;
+         }
+         slot.len = static_cast<int>(result);
+         ++numnativerecvs;
+      }
+#endif
+      if(!numnativerecvs)
+         return 0;
+   }
+
+   const nativeslot_t &slot = nativerecvs[nextnativerecv++];
+
+   memcpy(packet->data, slot.data, slot.len);
+   packet->len          = slot.len;
+   packet->address.host = slot.addr.sin_addr.s_addr;
+   packet->address.port = slot.addr.sin_port;
+   return 1;
+}
+
+#endif
+
+//
+// I_NetFlush
+//
+void I_NetFlush()
+{
+#ifdef EE_HAVE_NATIVENET
+   if(nativesocket >= 0 && numnativesends)
+      I_nativeFlush();
+#endif
+}
+
+//
+// I_udpSend
+//
+static void I_udpSend()
+{
+#ifdef EE_HAVE_NATIVENET
+   if(nativesocket >= 0)
+   {
+      I_nativeSend();
+      return;
+   }
+#endif
+
+   if(!SDLNet_UDP_Send(udpsocket, -1, packet))
+      I_Error("Error sending packet: %s\n", SDLNet_GetError());
+}
+
+//
+// I_udpRecv
+//
+static int I_udpRecv()
+{
+#ifdef EE_HAVE_NATIVENET
+   if(nativesocket >= 0)
+   {
+      const int result = I_nativeRecv();
+      if(result < 0)
+         I_Error("Error reading packet: %s\n", strerror(errno));
+      return result;
+   }
+#endif
+
+   const int result = SDLNet_UDP_Recv(udpsocket, packet);
+   if(result < 0)
+      I_Error("Error reading packet: %s\n", SDLNet_GetError());
+   return result;
+}
+
 //
 // PacketSend
 //
@@ -234,12 +614,119 @@ bool PacketSend(void)
    // reserve 4 bytes for the checksum
    rover += 4;
 
+   const bool delta = !(netbuffer->checksum & NCMD_SETUP) &&
+                      netformat[doomcom->remotenode] >= NETFORMAT_DELTA;
+   const bool timed = delta && netformat[doomcom->remotenode] >= NETFORMAT_TIMED;
+
+   int numtics = netbuffer->numtics;
+   if(delta)
+      numtics |= NUMTICS_DELTA;
+   if(timed)
+      numtics |= NUMTICS_TIMED;
+
    NETWRITEBYTE(netbuffer->player);
    NETWRITEBYTE(netbuffer->retransmitfrom);
    NETWRITEBYTE(netbuffer->starttic);
-   NETWRITEBYTE(netbuffer->numtics);
+   NETWRITEBYTE(numtics);
+
+   if(timed)
+   {
+      const nettiming_t &timing = nettiming[doomcom->remotenode];
+      const unsigned int now = i_haltimer.GetTicks();
+      int inputdelay = netbuffer->inputdelay & ~TIMEDECHOVALID;
+
+      if(timing.havepeer)
+         inputdelay |= TIMEDECHOVALID;
+
+      NETWRITEBYTE(inputdelay);
+      NETWRITESHORT(static_cast<Sint16>(now));
+      NETWRITESHORT(static_cast<Sint16>(timing.peerstamp + (now - timing.peerat)));
+   }
+
+   if(delta)
+   {
+      ticcmd_t prev = {};
+
+      for(c = 0; c < netbuffer->numtics; ++c)
+      {
+         const ticcmd_t &cmd = netbuffer->d.cmds[c];
+         int ticcmdflags = 0;
+
+         TDFCHECK(forwardmove, TDF_FORWARDMOVE);
+         TDFCHECK(sidemove,    TDF_SIDEMOVE);
+         TDFCHECK(angleturn,   TDF_ANGLETURN);
+         TDFCHECK(consistency, TDF_CONSISTENCY);
+         TDFCHECK(buttons,     TDF_BUTTONS);
+         TDFCHECK(look,        TDF_LOOK);
+         TDFCHECK(actions,     TDF_ACTIONS);
+         TDFCHECK(chatchar,    TDF_CHATCHAR);
+         TDFCHECK(fly,         TDF_FLY);
+         TDFCHECK(itemID,      TDF_ITEMID);
+         TDFCHECK(weaponID,    TDF_WEAPONID);
+         TDFCHECK(slotIndex,   TDF_SLOTINDEX);
+
+         if(ticcmdflags & ~0xff)
+            ticcmdflags |= TDF_EXTENDED;
+
+         NETWRITEBYTE(ticcmdflags & 0xff);
+         if(ticcmdflags & TDF_EXTENDED)
+         {
+            NETWRITEBYTE(ticcmdflags >> 8);
+         }
+
+         if(ticcmdflags & TDF_FORWARDMOVE)
+         {
+            NETWRITEBYTE(cmd.forwardmove);
+         }
+         if(ticcmdflags & TDF_SIDEMOVE)
+         {
+            NETWRITEBYTE(cmd.sidemove);
+         }
+         if(ticcmdflags & TDF_ANGLETURN)
+         {
+            NETWRITESHORT(cmd.angleturn);
+         }
+         if(ticcmdflags & TDF_CONSISTENCY)
+         {
+            NETWRITESHORT(cmd.consistency);
+         }
+         if(ticcmdflags & TDF_BUTTONS)
+         {
+            NETWRITEBYTE(cmd.buttons);
+         }
+         if(ticcmdflags & TDF_LOOK)
+         {
+            NETWRITESHORT(cmd.look);
+         }
+         if(ticcmdflags & TDF_ACTIONS)
+         {
+            NETWRITEBYTE(cmd.actions);
+         }
+         if(ticcmdflags & TDF_CHATCHAR)
+         {
+            NETWRITEBYTE(cmd.chatchar);
+         }
+         if(ticcmdflags & TDF_FLY)
+         {
+            NETWRITEBYTE(cmd.fly);
+         }
+         if(ticcmdflags & TDF_ITEMID)
+         {
+            NETWRITESHORT(cmd.itemID);
+         }
+         if(ticcmdflags & TDF_WEAPONID)
+         {
+            NETWRITESHORT(cmd.weaponID);
+         }
+         if(ticcmdflags & TDF_SLOTINDEX)
+         {
+            NETWRITEBYTE(cmd.slotIndex);
+         }
 
-   if(!(netbuffer->checksum & NCMD_SETUP))
+         prev = cmd;
+      }
+   }
+   else if(!(netbuffer->checksum & NCMD_SETUP))
    {
       for(c = 0; c < netbuffer->numtics; ++c)
       {
@@ -262,7 +749,7 @@ bool PacketSend(void)
          NETWRITEBYTEIF(netbuffer->d.cmds[c].fly,       TCF_FLY);
          NETWRITESHORTIF(netbuffer->d.cmds[c].itemID,   TCF_ITEMID);
          NETWRITESHORTIF(netbuffer->d.cmds[c].weaponID, TCF_WEAPONID);
-         NETWRITEBYTEIF(netbuffer->d.cmds[c].chatchar,  TCF_CHATCHAR);
+         NETWRITEBYTEIF(netbuffer->d.cmds[c].slotIndex, TCF_SLOTINDEX);
 
          // go back to ticstart and write in the flags
          ticend = rover;
@@ -274,10 +761,10 @@ bool PacketSend(void)
    }
    else
    {
-      for(c = 0; c < GAME_OPTION_SIZE; ++c)
+      for(c = 0; c < SETUP_SIZE; ++c)
          *rover++ = netbuffer->d.data[c];
       
-      packetsize += GAME_OPTION_SIZE;
+      packetsize += SETUP_SIZE;
    }
 
    // Go back and write the checksum at the beginning
@@ -288,18 +775,132 @@ bool PacketSend(void)
    packet->len     = packetsize;
    packet->address = sendaddress[doomcom->remotenode];
 
+   netstats.bytessent += packetsize;
+
    // DEBUG
    writesendpacket(packet->data, packet->len);
 
-   if(!SDLNet_UDP_Send(udpsocket, -1, packet))
+   I_udpSend();
+
+   return true;
+}
+
+//=============================================================================
+//
+// Spectator relay
+//
+
+struct relayrequest_t
+{
+   int      spectator;
+   uint32_t have;
+};
+
+static bool                          relayopen;
+static PODCollection<IPaddress>      spectators;   // all zero when free
+static PODCollection<relayrequest_t> relayrequests;
+static size_t                        nextrelayrequest;
+
+//
+// I_NetOpenRelay
+//
+void I_NetOpenRelay()
+{
+   relayopen = true;
+}
+
+//
+// I_netReadRelayRequest
+//
+// Takes the packet for a relay request if it is one. Returns false if not.
+//
+static bool I_netReadRelayRequest()
+{
+   if(!relayopen || packet->len != RELAYHEADER ||
+      NetToHost32(packet->data) != RELAYREQUEST)
+      return false;
+
+   const size_t numspectators = spectators.getLength();
+   size_t slot, freeslot = numspectators;
+
+   for(slot = 0; slot < numspectators; slot++)
    {
-      I_Error("Error sending packet: %s\n", SDLNet_GetError());
+      const IPaddress &address = spectators[slot];
+
+      if(address.host == packet->address.host && address.port == packet->address.port)
+         break;
+      if(!address.host && !address.port && freeslot == numspectators)
+         freeslot = slot;
+   }
+
+   if(slot == numspectators)
+   {
+      if((slot = freeslot) == numspectators)
+         spectators.add(packet->address);
+      else
+         spectators[slot] = packet->address;
+   }
+
+   relayrequest_t &request = relayrequests.addNew();
+   request.spectator = static_cast<int>(slot);
+   request.have      = NetToHost32(packet->data + 4);
+
+   netstats.bytesreceived += packet->len;
+   return true;
+}
+
+//
+// I_NetGetRelayRequest
+//
+bool I_NetGetRelayRequest(int &spectator, uint32_t &have)
+{
+   if(nextrelayrequest == relayrequests.getLength())
+   {
+      relayrequests.resize(0);
+      nextrelayrequest = 0;
       return false;
    }
 
+   const relayrequest_t &request = relayrequests[nextrelayrequest++];
+   spectator = request.spectator;
+   have      = request.have;
    return true;
 }
 
+//
+// I_NetSendRelay
+//
+int I_NetSendRelay(int spectator, uint32_t offset, const byte *data, int len)
+{
+   if(spectator < 0 || static_cast<size_t>(spectator) >= spectators.getLength())
+      return 0;
+
+   byte *rover = static_cast<byte *>(packet->data);
+
+   len = emin(len, RELAYPACKETSIZE - RELAYHEADER);
+   HostToNet32(RELAYDATA, rover);
+   HostToNet32(offset, rover + 4);
+   memcpy(rover + RELAYHEADER, data, len);
+
+   packet->len     = RELAYHEADER + len;
+   packet->address = spectators[spectator];
+
+   netstats.bytessent += packet->len;
+
+   I_udpSend();
+
+   return len;
+}
+
+//
+// I_NetDropSpectator
+//
+void I_NetDropSpectator(int spectator)
+{
+   if(spectator >= 0 && static_cast<size_t>(spectator) < spectators.getLength())
+      spectators[spectator] = {};
+}
+
 //
 // PacketGet
 //
@@ -309,33 +910,38 @@ bool PacketGet(void)
    int i, c, packets_read;
    byte *rover;
    
-   packets_read = SDLNet_UDP_Recv(udpsocket, packet);
-   
-   if(packets_read < 0)
-      I_Error("Error reading packet: %s\n", SDLNet_GetError());
-   
-   if(packets_read == 0)
+   while(1)
    {
-      doomcom->remotenode = -1;
-      return true;
-   }
+      packets_read = I_udpRecv();
+   
+      if(packets_read == 0)
+      {
+         doomcom->remotenode = -1;
+         return true;
+      }
 
-   writegetpacket(packet->data, packet->len);
+      writegetpacket(packet->data, packet->len);
    
-   for(i = 0; i < doomcom->numnodes; ++i)
-   {
-      if(packet->address.host == sendaddress[i].host && 
-         packet->address.port == sendaddress[i].port)
+      for(i = 0; i < doomcom->numnodes; ++i)
+      {
+         if(packet->address.host == sendaddress[i].host && 
+            packet->address.port == sendaddress[i].port)
+            break;
+      }
+
+      if(i < doomcom->numnodes)
          break;
-   }
-   
-   if(i == doomcom->numnodes)
-   {
-      doomcom->remotenode = -1;
-      return true;
+
+      // from outside the game: read on past spectators, but stop at strays
+      if(!I_netReadRelayRequest())
+      {
+         doomcom->remotenode = -1;
+         return true;
+      }
    }
    
    doomcom->remotenode = i;
+   netstats.bytesreceived += packet->len;
 
    if(packet->len < 4)
       return false;
@@ -346,7 +952,10 @@ bool PacketGet(void)
    
    // haleyjd: verify checksum first; if fails, don't even read the rest
    if((checksum & NCMD_CHECKSUM) != NetChecksum((byte *)packet->data + 4, packet->len - 4))
+   {
+      ++netstats.badchecksums;
       return false;
+   }
    
    netbuffer->checksum = checksum;
    rover += 4;
@@ -355,8 +964,96 @@ bool PacketGet(void)
    netbuffer->retransmitfrom = *rover++;
    netbuffer->starttic       = *rover++;
    netbuffer->numtics        = *rover++;
-   
-   if(!(netbuffer->checksum & NCMD_SETUP))
+   netbuffer->inputdelay     = NETDELAY_NONE;
+
+   if(!(netbuffer->checksum & NCMD_SETUP) && (netbuffer->numtics & NUMTICS_DELTA))
+   {
+      ticcmd_t prev = {};
+
+      // only a peer that reads delta tics sends them
+      netformat[i] = emax<int>(netformat[i], NETFORMAT_DELTA);
+
+      if(netbuffer->numtics & NUMTICS_TIMED)
+      {
+         nettiming_t &timing = nettiming[i];
+         const unsigned int now = i_haltimer.GetTicks();
+         const int inputdelay = *rover++;
+         const Uint16 stamp = static_cast<Uint16>(NetToHost16(rover));
+         const Uint16 echo  = static_cast<Uint16>(NetToHost16(rover + 2));
+         rover += 4;
+
+         netformat[i] = NETFORMAT_TIMED;
+         netbuffer->inputdelay = static_cast<byte>(inputdelay & ~TIMEDECHOVALID);
+
+         if(inputdelay & TIMEDECHOVALID)
+         {
+            const int sample = static_cast<Uint16>(now - echo);
+            if(sample < MAXRTTSAMPLE)
+               I_netAddRTTSample(timing, sample);
+         }
+
+         timing.peerstamp = stamp;
+         timing.peerat    = now;
+         timing.havepeer  = true;
+      }
+
+      netbuffer->numtics &= ~(NUMTICS_DELTA | NUMTICS_TIMED);
+
+      for(c = 0; c < netbuffer->numtics; ++c)
+      {
+         ticcmd_t &cmd = netbuffer->d.cmds[c];
+         int ticcmdflags;
+
+         ticcmdflags = *rover++;
+         if(ticcmdflags & TDF_EXTENDED)
+            ticcmdflags |= *rover++ << 8;
+
+         cmd = prev;
+
+         if(ticcmdflags & TDF_FORWARDMOVE)
+            cmd.forwardmove = *rover++;
+         if(ticcmdflags & TDF_SIDEMOVE)
+            cmd.sidemove = *rover++;
+         if(ticcmdflags & TDF_ANGLETURN)
+         {
+            cmd.angleturn = NetToHost16(rover);
+            rover += 2;
+         }
+         if(ticcmdflags & TDF_CONSISTENCY)
+         {
+            cmd.consistency = NetToHost16(rover);
+            rover += 2;
+         }
+         if(ticcmdflags & TDF_BUTTONS)
+            cmd.buttons = *rover++;
+         if(ticcmdflags & TDF_LOOK)
+         {
+            cmd.look = NetToHost16(rover);
+            rover += 2;
+         }
+         if(ticcmdflags & TDF_ACTIONS)
+            cmd.actions = *rover++;
+         if(ticcmdflags & TDF_CHATCHAR)
+            cmd.chatchar = *rover++;
+         if(ticcmdflags & TDF_FLY)
+            cmd.fly = *rover++;
+         if(ticcmdflags & TDF_ITEMID)
+         {
+            cmd.itemID = NetToHost16(rover);
+            rover += 2;
+         }
+         if(ticcmdflags & TDF_WEAPONID)
+         {
+            cmd.weaponID = NetToHost16(rover);
+            rover += 2;
+         }
+         if(ticcmdflags & TDF_SLOTINDEX)
+            cmd.slotIndex = *rover++;
+
+         prev = cmd;
+      }
+   }
+   else if(!(netbuffer->checksum & NCMD_SETUP))
    {
       for(c = 0; c < netbuffer->numtics; ++c)
       {
@@ -411,8 +1108,13 @@ bool PacketGet(void)
    }
    else
    {
-      for(c = 0; c < GAME_OPTION_SIZE; ++c)
+      // older versions send only the game options
+      const int setupsize = emin(emax(packet->len - 8, 0), SETUP_SIZE);
+
+      for(c = 0; c < setupsize; ++c)
          netbuffer->d.data[c] = *rover++;
+      for(; c < SETUP_SIZE; ++c)
+         netbuffer->d.data[c] = 0;
    }
 
    return true;
@@ -425,6 +1127,15 @@ bool PacketGet(void)
 //
 void I_QuitNetwork(void)
 {
+#ifdef EE_HAVE_NATIVENET
+   if(nativesocket >= 0)
+   {
+      I_nativeFlush();
+      close(nativesocket);
+      nativesocket = -1;
+   }
+#endif
+
    if(packet)
    {
       SDLNet_FreePacket(packet);
@@ -518,9 +1229,24 @@ void I_InitNetwork(void)
    doomcom->id = DOOMCOM_ID;
    doomcom->numplayers = doomcom->numnodes;
    
-   udpsocket = SDLNet_UDP_Open(DOOMPORT);
+   if(M_CheckParm("-nativenet"))
+   {
+#ifdef EE_HAVE_NATIVENET
+      if(I_nativeOpen(DOOMPORT))
+         usermsg("Using native sockets\n");
+      else
+         usermsg("Couldn't open a native socket: %s; using SDL_net\n", strerror(errno));
+#else
+      usermsg("No native sockets on this platform; using SDL_net\n");
+#endif
+   }
+
+#ifdef EE_HAVE_NATIVENET
+   if(nativesocket < 0)
+#endif
+      udpsocket = SDLNet_UDP_Open(DOOMPORT);
 
-   packet = SDLNet_AllocPacket((int)((sizeof(doomdata_t) + 31) & ~31));
+   packet = SDLNet_AllocPacket(int(NETBUFSIZE));
 }
 
 bool I_NetCmd(void)
@@ -531,6 +1257,7 @@ bool I_NetCmd(void)
    }
    else if(doomcom->command == CMD_GET)
    {
+      I_NetFlush(); // anything queued goes out before we look for replies
       return netget();
    }
    else
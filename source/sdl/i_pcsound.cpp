@@ -478,6 +478,7 @@ i_sounddriver_t i_pcsound_driver =
 {
    I_PCSInitSound,         // InitSound
    I_PCSCacheSound,        // CacheSound
+   nullptr,                // PrecacheSounds
    I_PCSUpdateSound,       // UpdateSound
    I_PCSSubmitSound,       // SubmitSound
    I_PCSShutdownSound,     // ShutdownSound
@@ -486,7 +487,9 @@ i_sounddriver_t i_pcsound_driver =
    I_PCSStopSound,         // StopSound
    I_PCSSoundIsPlaying,    // SoundIsPlaying
    I_PCSUpdateSoundParams, // UpdateSoundParams
+   nullptr,                // UpdateSoundParamsBatch
    nullptr,                // UpdateEQParams
+   nullptr,                // HoldSoundCommands
 };
 
 // EOF
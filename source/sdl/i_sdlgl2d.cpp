@@ -30,8 +30,11 @@
 
 // DOOM headers
 #include "../z_zone.h"
+#include "../c_io.h"
+#include "../c_runcmd.h"
 #include "../d_main.h"
 #include "../i_system.h"
+#include "../m_compare.h"
 #include "../m_vector.h"
 #include "../v_misc.h"
 #include "../v_video.h"
@@ -42,6 +45,7 @@
 #include "i_sdlgl2d.h"
 
 // GL module headers
+#include "../gl/gl_atlas.h"
 #include "../gl/gl_primitives.h"
 #include "../gl/gl_projection.h"
 #include "../gl/gl_texture.h"
@@ -89,8 +93,29 @@ static Uint32 *framebuffer;
 static int bump;
 
 // Options
-static bool   use_arb_pbo; // If true, use ARB pixel buffer object extension
-static GLuint pboIDs[2];   // IDs of pixel buffer objects
+static bool   use_arb_pbo;        // If true, use ARB pixel buffer object extension
+static bool   use_persistent_pbo; // If true, PBOs can stay mapped and be fenced
+
+// Pixel buffer objects are used in a ring, so the CPU can fill one while the
+// GPU is still reading the others
+#define NUMPBOS 3
+
+struct pboring_t
+{
+   GLuint     ids[NUMPBOS];    // IDs of pixel buffer objects
+   GLvoid    *mapped[NUMPBOS]; // persistent mappings
+   GLsync     fences[NUMPBOS]; // signalled once the GPU is done with a PBO
+   int        index;
+   GLsizeiptr size;
+   bool       persistent;      // if false, mapped for each use
+};
+
+static pboring_t screenring; // frames of the screen
+static pboring_t atlasring;  // bands of the GL atlas
+
+// Texture atlas dimensions
+#define ATLASPAGESIZE 2048
+#define ATLASMAXPAGES 4
 
 // PBO extension function pointers
 static PFNGLGENBUFFERSARBPROC    pglGenBuffersARB    = nullptr;
@@ -100,6 +125,49 @@ static PFNGLBUFFERDATAARBPROC    pglBufferDataARB    = nullptr;
 static PFNGLMAPBUFFERARBPROC     pglMapBufferARB     = nullptr;
 static PFNGLUNMAPBUFFERARBPROC   pglUnmapBufferARB   = nullptr;
 
+// Persistent mapping and fence function pointers
+static PFNGLBUFFERSTORAGEPROC    pglBufferStorage    = nullptr;
+static PFNGLMAPBUFFERRANGEPROC   pglMapBufferRange   = nullptr;
+static PFNGLFENCESYNCPROC        pglFenceSync        = nullptr;
+static PFNGLCLIENTWAITSYNCPROC   pglClientWaitSync   = nullptr;
+static PFNGLDELETESYNCPROC       pglDeleteSync       = nullptr;
+
+// With the palette shader, the 8-bit screen is uploaded as it is and a
+// fragment shader looks every pixel up in a 256x1 palette texture, so no
+// conversion is done on the CPU and a quarter of the data is sent.
+static bool   use_palette_shader;
+static GLuint paletteTextureID;
+static GLuint paletteProgram;
+static GLint  keyLocation;     // uniforms for showing the back buffer through
+static GLint  keyRectLocation; // one color
+
+// Shader function pointers
+static PFNGLACTIVETEXTUREPROC      pglActiveTexture      = nullptr;
+static PFNGLCREATESHADERPROC       pglCreateShader       = nullptr;
+static PFNGLSHADERSOURCEPROC       pglShaderSource       = nullptr;
+static PFNGLCOMPILESHADERPROC      pglCompileShader      = nullptr;
+static PFNGLGETSHADERIVPROC        pglGetShaderiv        = nullptr;
+static PFNGLGETSHADERINFOLOGPROC   pglGetShaderInfoLog   = nullptr;
+static PFNGLDELETESHADERPROC       pglDeleteShader       = nullptr;
+static PFNGLCREATEPROGRAMPROC      pglCreateProgram      = nullptr;
+static PFNGLATTACHSHADERPROC       pglAttachShader       = nullptr;
+static PFNGLLINKPROGRAMPROC        pglLinkProgram        = nullptr;
+static PFNGLGETPROGRAMIVPROC       pglGetProgramiv       = nullptr;
+static PFNGLGETPROGRAMINFOLOGPROC  pglGetProgramInfoLog  = nullptr;
+static PFNGLDELETEPROGRAMPROC      pglDeleteProgram      = nullptr;
+static PFNGLUSEPROGRAMPROC         pglUseProgram         = nullptr;
+static PFNGLGETUNIFORMLOCATIONPROC pglGetUniformLocation = nullptr;
+static PFNGLUNIFORM1IPROC          pglUniform1i          = nullptr;
+static PFNGLUNIFORM1FPROC          pglUniform1f          = nullptr;
+static PFNGLUNIFORM2FPROC          pglUniform2f          = nullptr;
+static PFNGLUNIFORM4FPROC          pglUniform4f          = nullptr;
+
+// Time spent waiting for a PBO to become writable
+static Uint64 uploadStallTotal;
+static Uint64 uploadStallMax;
+static Uint64 uploadStallLast;
+static int    uploadFrames;
+
 // Data for vertex binding
 static GLfloat screenVertices[4*2];
 static GLfloat screenTexCoords[4*2];
@@ -148,6 +216,156 @@ static void GL2D_setupVertexArray(
    glVertexPointer  (2, GL_FLOAT, sizeof(GLfloat) * 2, screenVertices );
 }
 
+//
+// Accounts for the time one frame's upload had to wait on the GPU.
+//
+static void GL2D_recordUploadStall(Uint64 ticks)
+{
+   uploadStallLast   = ticks;
+   uploadStallTotal += ticks;
+   uploadStallMax    = emax(uploadStallMax, ticks);
+   ++uploadFrames;
+}
+
+//
+// Deletes a ring's pixel buffers, which also releases persistent mappings
+//
+static void GL2D_destroyPBORing(pboring_t &ring)
+{
+   for(GLsync &fence : ring.fences)
+   {
+      if(fence)
+      {
+         pglDeleteSync(fence);
+         fence = nullptr;
+      }
+   }
+   if(ring.ids[0])
+   {
+      pglDeleteBuffersARB(NUMPBOS, ring.ids);
+      memset(ring.ids, 0, sizeof(ring.ids));
+      memset(ring.mapped, 0, sizeof(ring.mapped));
+   }
+}
+
+//
+// Creates a ring of pixel buffers of the given size, persistently mapped
+// where supported. If any mapping fails, the ring is mapped for each use.
+//
+static void GL2D_createPBORing(pboring_t &ring, GLsizeiptr size, bool persistent)
+{
+   const GLbitfield mapflags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+   ring.size       = size;
+   ring.index      = 0;
+   ring.persistent = persistent;
+
+   pglGenBuffersARB(NUMPBOS, ring.ids);
+   for(int i = 0; i < NUMPBOS; i++)
+   {
+      pglBindBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB, ring.ids[i]);
+      if(persistent)
+      {
+         pglBufferStorage(GL_PIXEL_UNPACK_BUFFER_ARB, size, nullptr, mapflags);
+         ring.mapped[i] = pglMapBufferRange(GL_PIXEL_UNPACK_BUFFER_ARB, 0, size, mapflags);
+      }
+      else
+         pglBufferDataARB(GL_PIXEL_UNPACK_BUFFER_ARB, size, nullptr, GL_STREAM_DRAW_ARB);
+   }
+   pglBindBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB, 0);
+
+   for(int i = 0; i < NUMPBOS && persistent; i++)
+   {
+      if(!ring.mapped[i])
+      {
+         GL2D_destroyPBORing(ring);
+         GL2D_createPBORing(ring, size, false);
+         return;
+      }
+   }
+}
+
+//
+// Moves on to the next buffer of a ring and binds it for unpacking. Returns
+// where to write to it, once the GPU is done with it if it stays mapped, or
+// else after its old contents are orphaned. Returns nullptr, with nothing
+// bound, if it couldn't be mapped.
+//
+static GLvoid *GL2D_mapNextPBO(pboring_t &ring)
+{
+   ring.index = (ring.index + 1) % NUMPBOS;
+   pglBindBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB, ring.ids[ring.index]);
+
+   if(ring.persistent)
+   {
+      // wait until the GPU has finished uploading from this one, NUMPBOS - 1
+      // uses ago; normally it has long since
+      GLsync &fence = ring.fences[ring.index];
+      if(fence)
+      {
+         while(pglClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED)
+            ;
+         pglDeleteSync(fence);
+         fence = nullptr;
+      }
+      return ring.mapped[ring.index];
+   }
+
+   // map the PBO into client memory in such a way as to avoid stalls
+   pglBufferDataARB(GL_PIXEL_UNPACK_BUFFER_ARB, ring.size, nullptr, GL_STREAM_DRAW_ARB);
+
+   GLvoid *ptr = pglMapBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB, GL_WRITE_ONLY_ARB);
+   if(!ptr)
+      pglBindBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB, 0);
+
+   return ptr;
+}
+
+//
+// Finishes writing to the current buffer of a ring
+//
+static void GL2D_unmapPBO(const pboring_t &ring)
+{
+   if(!ring.persistent)
+      pglUnmapBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB);
+}
+
+//
+// Call once uploads from the current buffer of a ring have been issued.
+// Fences it if it stays mapped, and unbinds it.
+//
+static void GL2D_releasePBO(pboring_t &ring)
+{
+   if(ring.persistent)
+      ring.fences[ring.index] = pglFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+   pglBindBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB, 0);
+}
+
+//
+// GL atlas bands are staged in their own ring, when they fit
+//
+static void *GL2D_mapAtlasStaging(size_t size)
+{
+   return size <= size_t(atlasring.size) ? GL2D_mapNextPBO(atlasring) : nullptr;
+}
+
+static void GL2D_unmapAtlasStaging()
+{
+   GL2D_unmapPBO(atlasring);
+}
+
+static void GL2D_releaseAtlasStaging()
+{
+   GL2D_releasePBO(atlasring);
+}
+
+static const glatlasstaging_t atlasStaging =
+{
+   GL2D_mapAtlasStaging,
+   GL2D_unmapAtlasStaging,
+   GL2D_releaseAtlasStaging
+};
+
 //
 // SDLGL2DVideoDriver::DrawPixels
 //
@@ -203,7 +421,30 @@ void SDLGL2DVideoDriver::FinishUpdate()
 
    GL_RebindBoundTexture();
 
-   if(!use_arb_pbo)
+   // send what the GL atlas has taken in since last frame
+   GL_AtlasUpload();
+
+   if(use_palette_shader)
+   {
+      // bind the framebuffer texture if necessary
+      GL_BindTextureIfNeeded(textureid);
+
+      // upload the game's 8-bit output as it is; the shader converts it
+      glPixelStorei(GL_UNPACK_ROW_LENGTH, screen->pitch);
+      glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, static_cast<GLsizei>(screen->w),
+                      static_cast<GLsizei>(screen->h - bump), GL_LUMINANCE, GL_UNSIGNED_BYTE,
+                      screen->pixels);
+      glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+
+      // let anything drawn under the screen this frame show through
+      if(keycolor >= 0)
+      {
+         pglUniform1f(keyLocation, static_cast<GLfloat>(keycolor));
+         pglUniform4f(keyRectLocation, static_cast<GLfloat>(keyy), static_cast<GLfloat>(keyx),
+                      static_cast<GLfloat>(keyy + keyheight), static_cast<GLfloat>(keyx + keywidth));
+      }
+   }
+   else if(!use_arb_pbo)
    {
       // Convert the game's 8-bit output to the 32-bit texture buffer
       DrawPixels(framebuffer, static_cast<unsigned int>(video.height));
@@ -216,53 +457,78 @@ void SDLGL2DVideoDriver::FinishUpdate()
                       static_cast<GLsizei>(video.height), static_cast<GLsizei>(video.width),
                       GL_BGRA, GL_UNSIGNED_BYTE, static_cast<GLvoid *>(framebuffer));
    }
-   else
+   else if(screenring.persistent)
    {
-      static int pboindex  = 0;
-      int        nextindex = 0;
-      GLvoid    *ptr       = nullptr;
+      // use the pixel buffers in a rotation
+      const Uint64 waitstart = SDL_GetPerformanceCounter();
+      GLvoid      *ptr       = GL2D_mapNextPBO(screenring);
+      GL2D_recordUploadStall(SDL_GetPerformanceCounter() - waitstart);
 
-      // use the two pixel buffers in a rotation
-      pboindex  = (pboindex + 1) % 2;
-      nextindex = (pboindex + 1) % 2;
+      // draw directly into the mapped buffer
+      DrawPixels(ptr, framebuffer_vmax);
 
       // bind the framebuffer texture if necessary
       GL_BindTextureIfNeeded(textureid);
 
-      // bind the primary PBO
-      pglBindBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB, pboIDs[pboindex]);
+      // upload this frame from the buffer, then fence it
+      glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, static_cast<GLsizei>(framebuffer_vmax),
+                      static_cast<GLsizei>(framebuffer_umax), GL_BGRA, GL_UNSIGNED_BYTE,
+                      nullptr);
+      GL2D_releasePBO(screenring);
+   }
+   else
+   {
+      // bind the framebuffer texture if necessary
+      GL_BindTextureIfNeeded(textureid);
 
-      // copy primary PBO to texture, using offset
+      // copy the PBO filled last frame to texture, using offset
+      pglBindBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB, screenring.ids[screenring.index]);
       glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, static_cast<GLsizei>(framebuffer_vmax),
                    static_cast<GLsizei>(framebuffer_umax), 0, GL_BGRA, GL_UNSIGNED_BYTE,
                    nullptr);
 
-      // bind the secondary PBO
-      pglBindBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB, pboIDs[nextindex]);
-
-      // map the PBO into client memory in such a way as to avoid stalls
-      pglBufferDataARB(GL_PIXEL_UNPACK_BUFFER_ARB, texturesize, nullptr, GL_STREAM_DRAW_ARB);
+      // move on to the next PBO in the rotation
+      const Uint64 waitstart = SDL_GetPerformanceCounter();
+      GLvoid      *ptr       = GL2D_mapNextPBO(screenring);
+      GL2D_recordUploadStall(SDL_GetPerformanceCounter() - waitstart);
 
-      if((ptr = pglMapBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB, GL_WRITE_ONLY_ARB)))
+      if(ptr)
       {
          // draw directly into video memory
          DrawPixels(ptr, framebuffer_vmax);
 
          // release pointer
-         pglUnmapBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB);
+         GL2D_unmapPBO(screenring);
       }
 
       // Unbind all PBOs
-      pglBindBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB, 0);
+      GL2D_releasePBO(screenring);
    }
 
    // draw vertex array
    glDrawElements(GL_TRIANGLES, 3*2, GL_UNSIGNED_BYTE, screenVtxOrder);
 
+   if(keycolor >= 0)
+   {
+      if(use_palette_shader)
+         pglUniform1f(keyLocation, -1.0f);
+      keycolor = -1;
+   }
+
    // push the frame
    SDL_GL_SwapWindow(window);
 }
 
+//
+// SDLGL2DVideoDriver::CanKeyScreen
+//
+// Protected method.
+//
+bool SDLGL2DVideoDriver::CanKeyScreen() const
+{
+   return use_palette_shader;
+}
+
 //
 // SDLGL2DVideoDriver::ReadScreen
 //
@@ -311,6 +577,14 @@ void SDLGL2DVideoDriver::SetPalette(byte *pal)
       
       temppal += 3;
    }
+
+   // the palette shader looks colors up from a texture instead
+   if(use_palette_shader && paletteTextureID)
+   {
+      pglActiveTexture(GL_TEXTURE1);
+      glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 256, 1, GL_BGRA, GL_UNSIGNED_BYTE, RGB8to32);
+      pglActiveTexture(GL_TEXTURE0);
+   }
 }
 
 //
@@ -375,13 +649,25 @@ void SDLGL2DVideoDriver::ShutdownGraphicsPartway()
       glDeleteTextures(1, &textureid);
       textureid = 0;
    }
+   if(paletteTextureID)
+   {
+      glDeleteTextures(1, &paletteTextureID);
+      paletteTextureID = 0;
+   }
 
-   // Destroy any PBOs
-   if(pboIDs[0])
+   // Destroy the palette shader
+   if(paletteProgram)
    {
-      pglDeleteBuffersARB(2, pboIDs);
-      memset(pboIDs, 0, sizeof(pboIDs));
+      pglUseProgram(0);
+      pglDeleteProgram(paletteProgram);
+      paletteProgram = 0;
    }
+   use_palette_shader = false;
+
+   // Destroy the GL atlas and any PBOs
+   GL_AtlasShutdown();
+   GL2D_destroyPBORing(screenring);
+   GL2D_destroyPBORing(atlasring);
 
    // Destroy the allocated temporary framebuffer
    if(framebuffer)
@@ -447,6 +733,23 @@ void SDLGL2DVideoDriver::LoadPBOExtension()
    else
       use_arb_pbo = false;
 
+   // Persistently mapped, fenced PBOs are better still, where supported
+   use_persistent_pbo = false;
+   if(use_arb_pbo && strstr(extensions, "GL_ARB_buffer_storage") &&
+      strstr(extensions, "GL_ARB_sync"))
+   {
+      GETPROC(pglBufferStorage,  "glBufferStorage",  PFNGLBUFFERSTORAGEPROC);
+      GETPROC(pglMapBufferRange, "glMapBufferRange", PFNGLMAPBUFFERRANGEPROC);
+      GETPROC(pglFenceSync,      "glFenceSync",      PFNGLFENCESYNCPROC);
+      GETPROC(pglClientWaitSync, "glClientWaitSync", PFNGLCLIENTWAITSYNCPROC);
+      GETPROC(pglDeleteSync,     "glDeleteSync",     PFNGLDELETESYNCPROC);
+
+      use_persistent_pbo = extension_ok;
+
+      if(firsttime && use_persistent_pbo)
+         usermsg(" Loaded extensions GL_ARB_buffer_storage and GL_ARB_sync");
+   }
+
    // If wanted, but not enabled, warn
    if(firsttime && want_arb_pbo && !use_arb_pbo)
       usermsg(" Could not enable extension GL_ARB_pixel_buffer_object");
@@ -455,6 +758,154 @@ void SDLGL2DVideoDriver::LoadPBOExtension()
    firsttime = false;
 }
 
+// The vertex stage is left to the fixed-function transform
+static const char *const paletteVertexSource =
+   "void main()\n"
+   "{\n"
+   "   gl_TexCoord[0] = gl_MultiTexCoord0;\n"
+   "   gl_Position    = ftransform();\n"
+   "}\n";
+
+// Indices can't be filtered, so linear filtering blends four looked-up colors.
+// Pixels of the key index inside the key rectangle are dropped, leaving what
+// was drawn there before; the texture's s is the screen's y.
+static const char *const paletteFragmentSource =
+   "uniform sampler2D screen;\n"
+   "uniform sampler2D palette;\n"
+   "uniform vec2      texsize;\n"
+   "uniform float     key;\n"
+   "uniform vec4      keyrect;\n"
+   "\n"
+   "vec4 lookup(vec2 st)\n"
+   "{\n"
+   "   float index = texture2D(screen, st).r;\n"
+   "   return texture2D(palette, vec2(index * (255.0 / 256.0) + (0.5 / 256.0), 0.5));\n"
+   "}\n"
+   "\n"
+   "void main()\n"
+   "{\n"
+   "   vec2 pixel = gl_TexCoord[0].st * texsize;\n"
+   "   if(key >= 0.0 && all(greaterThanEqual(pixel, keyrect.xy)) &&\n"
+   "      all(lessThan(pixel, keyrect.zw)) &&\n"
+   "      abs(texture2D(screen, gl_TexCoord[0].st).r * 255.0 - key) < 0.5)\n"
+   "      discard;\n"
+   "\n"
+   "#ifdef LINEAR_FILTER\n"
+   "   vec2 texel = gl_TexCoord[0].st * texsize - 0.5;\n"
+   "   vec2 frac  = fract(texel);\n"
+   "   vec2 base  = (floor(texel) + 0.5) / texsize;\n"
+   "   vec2 dx    = vec2(1.0 / texsize.x, 0.0);\n"
+   "   vec2 dy    = vec2(0.0, 1.0 / texsize.y);\n"
+   "   gl_FragColor = mix(mix(lookup(base),      lookup(base + dx),      frac.x),\n"
+   "                      mix(lookup(base + dy), lookup(base + dx + dy), frac.x), frac.y);\n"
+   "#else\n"
+   "   gl_FragColor = lookup(gl_TexCoord[0].st);\n"
+   "#endif\n"
+   "}\n";
+
+//
+// Loads the GL 2.0 shader entry points, if the context has them.
+//
+static bool GL2D_loadShaderProcs()
+{
+   bool extension_ok = true;
+   const char *version = reinterpret_cast<const char *>(glGetString(GL_VERSION));
+
+   if(!version || atoi(version) < 2)
+      return false;
+
+   GETPROC(pglActiveTexture,      "glActiveTexture",      PFNGLACTIVETEXTUREPROC);
+   GETPROC(pglCreateShader,       "glCreateShader",       PFNGLCREATESHADERPROC);
+   GETPROC(pglShaderSource,       "glShaderSource",       PFNGLSHADERSOURCEPROC);
+   GETPROC(pglCompileShader,      "glCompileShader",      PFNGLCOMPILESHADERPROC);
+   GETPROC(pglGetShaderiv,        "glGetShaderiv",        PFNGLGETSHADERIVPROC);
+   GETPROC(pglGetShaderInfoLog,   "glGetShaderInfoLog",   PFNGLGETSHADERINFOLOGPROC);
+   GETPROC(pglDeleteShader,       "glDeleteShader",       PFNGLDELETESHADERPROC);
+   GETPROC(pglCreateProgram,      "glCreateProgram",      PFNGLCREATEPROGRAMPROC);
+   GETPROC(pglAttachShader,       "glAttachShader",       PFNGLATTACHSHADERPROC);
+   GETPROC(pglLinkProgram,        "glLinkProgram",        PFNGLLINKPROGRAMPROC);
+   GETPROC(pglGetProgramiv,       "glGetProgramiv",       PFNGLGETPROGRAMIVPROC);
+   GETPROC(pglGetProgramInfoLog,  "glGetProgramInfoLog",  PFNGLGETPROGRAMINFOLOGPROC);
+   GETPROC(pglDeleteProgram,      "glDeleteProgram",      PFNGLDELETEPROGRAMPROC);
+   GETPROC(pglUseProgram,         "glUseProgram",         PFNGLUSEPROGRAMPROC);
+   GETPROC(pglGetUniformLocation, "glGetUniformLocation", PFNGLGETUNIFORMLOCATIONPROC);
+   GETPROC(pglUniform1i,          "glUniform1i",          PFNGLUNIFORM1IPROC);
+   GETPROC(pglUniform1f,          "glUniform1f",          PFNGLUNIFORM1FPROC);
+   GETPROC(pglUniform2f,          "glUniform2f",          PFNGLUNIFORM2FPROC);
+   GETPROC(pglUniform4f,          "glUniform4f",          PFNGLUNIFORM4FPROC);
+
+   return extension_ok;
+}
+
+//
+// Compiles one stage of the palette shader. Returns 0 on failure.
+//
+static GLuint GL2D_compileShader(GLenum type, const char *const *sources, GLsizei count)
+{
+   GLuint shader   = pglCreateShader(type);
+   GLint  compiled = GL_FALSE;
+
+   pglShaderSource(shader, count, sources, nullptr);
+   pglCompileShader(shader);
+   pglGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+
+   if(!compiled)
+   {
+      char log[512] = "";
+      pglGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+      usermsg(" Could not compile the palette shader:\n%s", log);
+      pglDeleteShader(shader);
+      return 0;
+   }
+
+   return shader;
+}
+
+//
+// Builds the palette shader program, with or without its own linear
+// filtering. Returns false if it couldn't be built.
+//
+static bool GL2D_createPaletteProgram(bool linear)
+{
+   const char *const fragmentSources[] =
+   {
+      linear ? "#define LINEAR_FILTER\n" : "",
+      paletteFragmentSource
+   };
+   GLuint vertex, fragment;
+   GLint  linked = GL_FALSE;
+
+   if(!(vertex = GL2D_compileShader(GL_VERTEX_SHADER, &paletteVertexSource, 1)))
+      return false;
+   if(!(fragment = GL2D_compileShader(GL_FRAGMENT_SHADER, fragmentSources, 2)))
+   {
+      pglDeleteShader(vertex);
+      return false;
+   }
+
+   paletteProgram = pglCreateProgram();
+   pglAttachShader(paletteProgram, vertex);
+   pglAttachShader(paletteProgram, fragment);
+   pglLinkProgram(paletteProgram);
+
+   // the program keeps them for as long as it needs them
+   pglDeleteShader(vertex);
+   pglDeleteShader(fragment);
+
+   pglGetProgramiv(paletteProgram, GL_LINK_STATUS, &linked);
+   if(!linked)
+   {
+      char log[512] = "";
+      pglGetProgramInfoLog(paletteProgram, sizeof(log), nullptr, log);
+      usermsg(" Could not link the palette shader:\n%s", log);
+      pglDeleteProgram(paletteProgram);
+      paletteProgram = 0;
+      return false;
+   }
+
+   return true;
+}
+
 // Config-to-GL enumeration lookups
 
 // Configurable texture filtering parameters
@@ -543,6 +994,8 @@ bool SDLGL2DVideoDriver::InitGraphicsMode()
    SDL_GL_SetAttribute(SDL_GL_GREEN_SIZE, colordepth >= 24 ? 8 : 5);
    SDL_GL_SetAttribute(SDL_GL_BLUE_SIZE,  colordepth >= 24 ? 8 : 5);
    SDL_GL_SetAttribute(SDL_GL_ALPHA_SIZE, colordepth == 32 ? 8 : 0);
+   if(depthsize)
+      SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, depthsize);
 
    if(displaynum < SDL_GetNumVideoDisplays())
       v_displaynum = displaynum;
@@ -595,6 +1048,12 @@ bool SDLGL2DVideoDriver::InitGraphicsMode()
    // Try loading the ARB PBO extension
    LoadPBOExtension();
 
+   // Converting the palette in a shader leaves nothing for the screen's PBOs
+   // to do
+   if(cfg_gl_use_extensions && cfg_gl_palette_shader && GL2D_loadShaderProcs() &&
+      GL2D_createPaletteProgram(texfiltertype == GL_LINEAR))
+      use_palette_shader = true;
+
    // Enable two-dimensional texture mapping
    glEnable(GL_TEXTURE_2D);
 
@@ -647,6 +1106,13 @@ bool SDLGL2DVideoDriver::InitGraphicsMode()
    GL2D_setupVertexArray(0.0f, 0.0f, static_cast<float>(geom.width), static_cast<float>(geom.height),
                          texcoord_smax, texcoord_tmax, ymargin);
 
+   // the screen's quad in the drawable, letterbox and all
+   const int marginpixels = static_cast<int>(ymargin * drawableH / geom.height);
+   screenx      = static_cast<int>(floor(displacement.x));
+   screeny      = static_cast<int>(floor(displacement.y)) + marginpixels;
+   screenwidth  = drawableW;
+   screenheight = drawableH - 2 * marginpixels;
+
    // Create texture
    glGenTextures(1, &textureid);
 
@@ -656,28 +1122,70 @@ bool SDLGL2DVideoDriver::InitGraphicsMode()
    GL_BindTextureAndRemember(textureid);
 
    // villsa 05/29/11: set filtering otherwise texture won't render
-   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, texfiltertype);
-   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, texfiltertype);
+   // (palette indices are filtered by the shader, if at all)
+   const GLint screenfilter = use_palette_shader ? GL_NEAREST : texfiltertype;
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, screenfilter);
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, screenfilter);
 
    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
 
-   glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, static_cast<GLsizei>(framebuffer_vmax),
-                static_cast<GLsizei>(framebuffer_umax), 0, GL_BGRA, GL_UNSIGNED_BYTE, 
-                tempbuffer);
+   if(use_palette_shader)
+   {
+      glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+      glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE8, static_cast<GLsizei>(framebuffer_vmax),
+                   static_cast<GLsizei>(framebuffer_umax), 0, GL_LUMINANCE, GL_UNSIGNED_BYTE,
+                   tempbuffer);
+   }
+   else
+   {
+      glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, static_cast<GLsizei>(framebuffer_vmax),
+                   static_cast<GLsizei>(framebuffer_umax), 0, GL_BGRA, GL_UNSIGNED_BYTE, 
+                   tempbuffer);
+   }
    efree(tempbuffer);
 
-   // Allocate framebuffer data, or PBOs
-   if(!use_arb_pbo)
+   if(use_palette_shader)
+   {
+      // the palette goes on the second texture unit; SetPalette fills it in
+      pglActiveTexture(GL_TEXTURE1);
+      glGenTextures(1, &paletteTextureID);
+      glBindTexture(GL_TEXTURE_2D, paletteTextureID);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+      glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+      glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+      glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 256, 1, 0, GL_BGRA, GL_UNSIGNED_BYTE,
+                   RGB8to32);
+      pglActiveTexture(GL_TEXTURE0);
+
+      pglUseProgram(paletteProgram);
+      pglUniform1i(pglGetUniformLocation(paletteProgram, "screen"),  0);
+      pglUniform1i(pglGetUniformLocation(paletteProgram, "palette"), 1);
+      pglUniform2f(pglGetUniformLocation(paletteProgram, "texsize"),
+                   static_cast<GLfloat>(framebuffer_vmax), static_cast<GLfloat>(framebuffer_umax));
+
+      keyLocation     = pglGetUniformLocation(paletteProgram, "key");
+      keyRectLocation = pglGetUniformLocation(paletteProgram, "keyrect");
+      pglUniform1f(keyLocation, -1.0f);
+   }
+   keycolor = -1;
+
+   // Allocate framebuffer data, or PBOs; the palette shader needs neither
+   if(!use_arb_pbo && !use_palette_shader)
       framebuffer = ecalloc(Uint32 *, resolutionWidth * 4, resolutionHeight);
-   else
+   else if(!use_palette_shader)
+      GL2D_createPBORing(screenring, texturesize, use_persistent_pbo);
+
+   // Textures and sprites for GL drawing go in the atlas, which sends them
+   // through PBOs of its own where it can
+   GL_AtlasInit(ATLASPAGESIZE, ATLASMAXPAGES,
+                static_cast<byte *>(wGlobalDir.cacheLumpName("PLAYPAL", PU_CACHE)));
+   if(use_arb_pbo)
    {
-      pglGenBuffersARB(2, pboIDs);
-      pglBindBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB, pboIDs[0]);
-      pglBufferDataARB(GL_PIXEL_UNPACK_BUFFER_ARB, texturesize, nullptr, GL_STREAM_DRAW_ARB);
-      pglBindBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB, pboIDs[1]);
-      pglBufferDataARB(GL_PIXEL_UNPACK_BUFFER_ARB, texturesize, nullptr, GL_STREAM_DRAW_ARB);
-      pglBindBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB, 0);
+      GL2D_createPBORing(atlasring, static_cast<GLsizeiptr>(GL_AtlasMaxUploadSize()),
+                         use_persistent_pbo);
+      GL_AtlasSetStaging(&atlasStaging);
    }
 
    UpdateFocus(window);
@@ -705,6 +1213,39 @@ bool SDLGL2DVideoDriver::InitGraphicsMode()
    return false;
 }
 
+//
+// Reports how long frame uploads have waited for a free pixel buffer.
+//
+CONSOLE_COMMAND(gl_uploadstats, 0)
+{
+   if(Console.argc >= 1 && !Console.argv[0]->strCaseCmp("reset"))
+   {
+      uploadStallTotal = uploadStallMax = uploadStallLast = 0;
+      uploadFrames = 0;
+      return;
+   }
+
+   if(use_palette_shader)
+   {
+      C_Printf("Uploading 8-bit frames for the palette shader\n");
+      return;
+   }
+   if(!screenring.ids[0])
+   {
+      C_Printf("Not uploading through pixel buffers\n");
+      return;
+   }
+
+   const double usecs = 1000000.0 / double(SDL_GetPerformanceFrequency());
+
+   C_Printf(FC_HI "Upload stalls (%s, %d frames):\n" FC_NORMAL
+            "  last: %.1f us\n  avg:  %.1f us\n  max:  %.1f us\n",
+            screenring.persistent ? "persistent, fenced" : "mapped per frame", uploadFrames,
+            uploadStallLast * usecs,
+            uploadFrames ? uploadStallTotal * usecs / uploadFrames : 0.0,
+            uploadStallMax * usecs);
+}
+
 // The one and only global instance of the SDL GL 2D-in-3D video driver.
 SDLGL2DVideoDriver i_sdlgl2dvideodriver;
 
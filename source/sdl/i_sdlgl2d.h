@@ -40,9 +40,21 @@ class SDLGL2DVideoDriver : public HALVideoDriver
 {
 protected:
    int colordepth;
+   int depthsize = 0; // depth buffer bits to ask for, if any
+
+   // Where the screen is shown, in pixels up from the bottom left of the
+   // window's drawable
+   int screenx = 0, screeny = 0, screenwidth = 0, screenheight = 0;
+
+   // If keycolor is a palette index, the next FinishUpdate lets what's
+   // already in the back buffer show through pixels of that color within
+   // this rectangle of the screen. Only the palette shader can do this.
+   int keycolor = -1;
+   int keyx = 0, keyy = 0, keywidth = 0, keyheight = 0;
 
    void DrawPixels(void *buffer, unsigned int destheight);
    void LoadPBOExtension();
+   bool CanKeyScreen() const;
 
    virtual void SetPrimaryBuffer();
    virtual void UnsetPrimaryBuffer();
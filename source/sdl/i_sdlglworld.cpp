@@ -0,0 +1,924 @@
+//
+// The Eternity Engine
+// Copyright(C) 2026 James Haley, Max Waine, et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+// Additional terms and conditions compatible with the GPLv3 apply. See the
+// file COPYING-EE for details.
+//
+// Purpose: SDL-specific GL world video code.
+//  The world of the player's view is drawn straight into the back buffer,
+//  while the software renderer only fills the view window with a key color
+//  and draws the player's weapon over it; GL2D's palette shader then lets
+//  the world show through the key when the screen goes up.
+//
+//  So far this is a skeleton: walls, flats and things come from the GL atlas
+//  lit by their sector's light level, and everything is drawn every frame.
+//  Portals, slopes, polyobjects, 3D midtextures, skies, colormaps and
+//  translucency are not drawn.
+//
+
+#ifdef EE_FEATURE_OPENGL
+
+#include <stddef.h>
+
+// SDL headers
+#include "SDL.h"
+#include "SDL_opengl.h"
+
+// DOOM headers
+#include "../z_zone.h"
+#include "../d_main.h"
+#include "../doomdata.h"
+#include "../m_collection.h"
+#include "../m_compare.h"
+#include "../m_fixed.h"
+#include "../m_vector.h"
+#include "../p_mobj.h"
+#include "../p_pspr.h"
+#include "../r_context.h"
+#include "../r_data.h"
+#include "../r_defs.h"
+#include "../r_draw.h"
+#include "../r_interpolate.h"
+#include "../r_main.h"
+#include "../r_sky.h"
+#include "../r_state.h"
+#include "../v_misc.h"
+
+// Local driver header
+#include "i_sdlglworld.h"
+
+// GL module headers
+#include "../gl/gl_atlas.h"
+#include "../gl/gl_texture.h"
+
+//=============================================================================
+//
+// Static Data
+//
+
+// Palette index the view window is filled with. Any pixels of the player's
+// weapon in this color show the world instead.
+static constexpr byte WORLD_KEYCOLOR = 247;
+
+// Depth range of the view, in map units
+static constexpr float WORLD_NEAR = 4.0f;
+static constexpr float WORLD_FAR  = 131072.0f;
+
+struct glworldvertex_t
+{
+   GLfloat x, y, z;                // in the map
+   GLfloat u, v;                   // in repeats of the image
+   GLfloat s, t, swidth, theight;  // the image's place in its atlas page
+   GLfloat light;
+};
+
+struct glworldcorner_t
+{
+   float x, y, z, u, v;
+};
+
+// Vertices drawn from one atlas page
+struct glworldbatch_t
+{
+   GLuint                         texture;
+   PODCollection<glworldvertex_t> vertices;
+};
+
+#define MAXWORLDBATCHES 16
+
+static glworldbatch_t worldbatches[MAXWORLDBATCHES];
+static int            numworldbatches;
+
+// Outlines of the subsectors, carved out by the nodes and then the segs, so
+// there are flats to draw with regular nodes as well as GL nodes. They're
+// level memory, so are gone along with the level.
+struct glworldpoly_t
+{
+   int first, count; // in worldpolyverts; count is 0 if nothing was left
+};
+
+static glworldpoly_t *worldpolys;
+static v2float_t     *worldpolyverts;
+
+using glworldoutline_t = SmallPODCollection<v2double_t, 32>;
+
+// GL objects
+static GLuint worldProgram;
+static GLint  transformLocation;
+static GLuint worldVAO;
+static GLuint worldVBO;
+
+// GL 3.3 function pointers
+static PFNGLGENVERTEXARRAYSPROC         pglGenVertexArrays         = nullptr;
+static PFNGLBINDVERTEXARRAYPROC         pglBindVertexArray         = nullptr;
+static PFNGLDELETEVERTEXARRAYSPROC      pglDeleteVertexArrays      = nullptr;
+static PFNGLGENBUFFERSPROC              pglGenBuffers              = nullptr;
+static PFNGLBINDBUFFERPROC              pglBindBuffer              = nullptr;
+static PFNGLBUFFERDATAPROC              pglBufferData              = nullptr;
+static PFNGLDELETEBUFFERSPROC           pglDeleteBuffers           = nullptr;
+static PFNGLVERTEXATTRIBPOINTERPROC     pglVertexAttribPointer     = nullptr;
+static PFNGLENABLEVERTEXATTRIBARRAYPROC pglEnableVertexAttribArray = nullptr;
+static PFNGLCREATESHADERPROC            pglCreateShader            = nullptr;
+static PFNGLSHADERSOURCEPROC            pglShaderSource            = nullptr;
+static PFNGLCOMPILESHADERPROC           pglCompileShader           = nullptr;
+static PFNGLGETSHADERIVPROC             pglGetShaderiv             = nullptr;
+static PFNGLGETSHADERINFOLOGPROC        pglGetShaderInfoLog        = nullptr;
+static PFNGLDELETESHADERPROC            pglDeleteShader            = nullptr;
+static PFNGLCREATEPROGRAMPROC           pglCreateProgram           = nullptr;
+static PFNGLATTACHSHADERPROC            pglAttachShader            = nullptr;
+static PFNGLLINKPROGRAMPROC             pglLinkProgram             = nullptr;
+static PFNGLGETPROGRAMIVPROC            pglGetProgramiv            = nullptr;
+static PFNGLGETPROGRAMINFOLOGPROC       pglGetProgramInfoLog       = nullptr;
+static PFNGLDELETEPROGRAMPROC           pglDeleteProgram           = nullptr;
+static PFNGLUSEPROGRAMPROC              pglUseProgram              = nullptr;
+static PFNGLGETUNIFORMLOCATIONPROC      pglGetUniformLocation      = nullptr;
+static PFNGLUNIFORM1IPROC               pglUniform1i               = nullptr;
+static PFNGLUNIFORMMATRIX4FVPROC        pglUniformMatrix4fv        = nullptr;
+
+//=============================================================================
+//
+// Level Geometry
+//
+
+//
+// Cuts a convex outline down to the part on the right of a line, which is
+// the front of a node or seg.
+//
+static void GLWorld_clipOutline(const PODCollection<v2double_t> &in,
+                                PODCollection<v2double_t> &out,
+                                double x, double y, double dx, double dy)
+{
+   const double len   = sqrt(dx * dx + dy * dy);
+   const size_t count = in.getLength();
+
+   out.resize(0);
+
+   for(size_t i = 0; i < count; i++)
+   {
+      const v2double_t &a = in[i];
+      const v2double_t &b = in[(i + 1) % count];
+
+      if(len == 0.0)
+      {
+         out.add(a);
+         continue;
+      }
+
+      // distances to the right of the line, with a little slack
+      const double da = ((a.x - x) * dy - (a.y - y) * dx) / len;
+      const double db = ((b.x - x) * dy - (b.y - y) * dx) / len;
+      const bool   ina = (da >= -0.001);
+      const bool   inb = (db >= -0.001);
+
+      if(ina)
+         out.add(a);
+      if(ina != inb)
+      {
+         const double t = eclamp(da / (da - db), 0.0, 1.0);
+         out.add({ a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t });
+      }
+   }
+}
+
+//
+// Closes a subsector's outline off with its segs and keeps it
+//
+static void GLWorld_closeSubsector(int ssnum, const PODCollection<v2double_t> &outline,
+                                   PODCollection<v2float_t> &verts)
+{
+   const subsector_t &ss = subsectors[ssnum];
+   glworldoutline_t   a, b;
+   PODCollection<v2double_t> *cur = &a, *next = &b;
+
+   for(const v2double_t &point : outline)
+      a.add(point);
+
+   for(int i = 0; i < ss.numlines; i++)
+   {
+      const seg_t &seg = segs[ss.firstline + i];
+
+      GLWorld_clipOutline(*cur, *next, seg.v1->fx, seg.v1->fy,
+                          seg.v2->fx - seg.v1->fx, seg.v2->fy - seg.v1->fy);
+      std::swap(cur, next);
+   }
+
+   glworldpoly_t &poly = worldpolys[ssnum];
+
+   poly.first = int(verts.getLength());
+   poly.count = 0;
+
+   if(cur->getLength() >= 3)
+   {
+      poly.count = int(cur->getLength());
+      for(const v2double_t &point : *cur)
+         verts.add(v2float_t(point));
+   }
+}
+
+//
+// Splits an outline between the children of a node
+//
+static void GLWorld_carveNode(int nodenum, const PODCollection<v2double_t> &outline,
+                              PODCollection<v2float_t> &verts)
+{
+   if(nodenum & NF_SUBSECTOR)
+   {
+      GLWorld_closeSubsector(nodenum & ~NF_SUBSECTOR, outline, verts);
+      return;
+   }
+
+   const node_t    &node = nodes[nodenum];
+   const double     x    = M_FixedToDouble(node.x);
+   const double     y    = M_FixedToDouble(node.y);
+   const double     dx   = M_FixedToDouble(node.dx);
+   const double     dy   = M_FixedToDouble(node.dy);
+   glworldoutline_t front, back;
+
+   GLWorld_clipOutline(outline, front, x, y, dx, dy);
+   GLWorld_clipOutline(outline, back, x, y, -dx, -dy);
+
+   GLWorld_carveNode(node.children[0], front, verts);
+   GLWorld_carveNode(node.children[1], back, verts);
+}
+
+//
+// Builds the subsector outlines of a newly loaded level
+//
+static void GLWorld_buildLevel()
+{
+   PODCollection<v2float_t> verts;
+   glworldoutline_t         outline;
+   double x1 = 0.0, y1 = 0.0, x2 = 0.0, y2 = 0.0;
+
+   worldpolys = ecalloctag(glworldpoly_t *, emax(numsubsectors, 1), sizeof(glworldpoly_t),
+                           PU_LEVEL, reinterpret_cast<void **>(&worldpolys));
+
+   // start from a box around the whole map
+   for(int i = 0; i < numvertexes; i++)
+   {
+      x1 = i ? emin(x1, double(vertexes[i].fx)) : vertexes[i].fx;
+      y1 = i ? emin(y1, double(vertexes[i].fy)) : vertexes[i].fy;
+      x2 = i ? emax(x2, double(vertexes[i].fx)) : vertexes[i].fx;
+      y2 = i ? emax(y2, double(vertexes[i].fy)) : vertexes[i].fy;
+   }
+
+   outline.add({ x1 - 64.0, y1 - 64.0 });
+   outline.add({ x1 - 64.0, y2 + 64.0 });
+   outline.add({ x2 + 64.0, y2 + 64.0 });
+   outline.add({ x2 + 64.0, y1 - 64.0 });
+
+   if(numsubsectors)
+      GLWorld_carveNode(numnodes ? numnodes - 1 : int(NF_SUBSECTOR), outline, verts);
+
+   worldpolyverts = emalloctag(v2float_t *, emax(verts.getLength(), size_t(1)) * sizeof(v2float_t),
+                               PU_LEVEL, reinterpret_cast<void **>(&worldpolyverts));
+   if(verts.getLength())
+      memcpy(worldpolyverts, verts.begin(), verts.getLength() * sizeof(v2float_t));
+}
+
+//=============================================================================
+//
+// Drawing
+//
+
+//
+// Gets the batch of vertices drawn from an atlas page
+//
+static glworldbatch_t *GLWorld_batchFor(GLuint texture)
+{
+   for(int i = 0; i < numworldbatches; i++)
+   {
+      if(worldbatches[i].texture == texture)
+         return &worldbatches[i];
+   }
+
+   if(numworldbatches == MAXWORLDBATCHES)
+      return nullptr;
+
+   glworldbatch_t &batch = worldbatches[numworldbatches++];
+   batch.texture = texture;
+   batch.vertices.resize(0);
+   return &batch;
+}
+
+static void GLWorld_addVertex(glworldbatch_t &batch, const glworldcorner_t &corner,
+                              const glatlasregion_t &region, float light)
+{
+   glworldvertex_t &vert = batch.vertices.addNew();
+
+   vert.x       = corner.x;
+   vert.y       = corner.y;
+   vert.z       = corner.z;
+   vert.u       = corner.u;
+   vert.v       = corner.v;
+   vert.s       = region.s1;
+   vert.t       = region.t1;
+   vert.swidth  = region.s2 - region.s1;
+   vert.theight = region.t2 - region.t1;
+   vert.light   = light;
+}
+
+//
+// Adds a quad as two triangles
+//
+static void GLWorld_addQuad(const glworldcorner_t (&corners)[4], const glatlasregion_t &region,
+                            float light)
+{
+   static constexpr int order[6] = { 0, 1, 2, 0, 2, 3 };
+   glworldbatch_t *batch = GLWorld_batchFor(region.texture);
+
+   if(!batch)
+      return;
+
+   for(int i : order)
+      GLWorld_addVertex(*batch, corners[i], region, light);
+}
+
+static float GLWorld_light(const sector_t &sector)
+{
+   return eclamp(sector.lightlevel / 255.0f, 0.0f, 1.0f);
+}
+
+static float GLWorld_textureHeight(int texnum)
+{
+   return textures[texturetranslation[texnum]]->height;
+}
+
+//
+// Adds a wall between two heights, with the top of its texture at textop
+//
+static void GLWorld_addWall(const seg_t &seg, int texnum, float bottom, float top,
+                            float textop, float light)
+{
+   glatlasregion_t region;
+
+   if(top <= bottom || !texnum || !GL_AtlasTexture(texturetranslation[texnum], region))
+      return;
+
+   const float u1 = (seg.offset + M_FixedToFloat(seg.sidedef->textureoffset)) / region.width;
+   const float u2 = u1 + seg.len / region.width;
+   const float v1 = (textop - top) / region.height;
+   const float v2 = (textop - bottom) / region.height;
+
+   const glworldcorner_t corners[4] =
+   {
+      { seg.v1->fx, seg.v1->fy, top,    u1, v1 },
+      { seg.v2->fx, seg.v2->fy, top,    u2, v1 },
+      { seg.v2->fx, seg.v2->fy, bottom, u2, v2 },
+      { seg.v1->fx, seg.v1->fy, bottom, u1, v2 },
+   };
+
+   GLWorld_addQuad(corners, region, light);
+}
+
+//
+// Adds the walls of every seg, pegged as the software renderer pegs them
+//
+static void GLWorld_addWalls()
+{
+   for(int i = 0; i < numsegs; i++)
+   {
+      const seg_t    &seg   = segs[i];
+      const side_t   *side  = seg.sidedef;
+      const sector_t *front = seg.frontsector;
+      const sector_t *back  = seg.backsector;
+
+      if(!side || !front || !seg.linedef)
+         continue;
+
+      const int   flags   = seg.linedef->flags;
+      const float row     = M_FixedToFloat(side->rowoffset);
+      const float floor   = front->srf.floor.heightf;
+      const float ceiling = front->srf.ceiling.heightf;
+      const float light   = GLWorld_light(*front);
+
+      if(!back)
+      {
+         if(side->midtexture)
+         {
+            const float textop = (flags & ML_DONTPEGBOTTOM) ?
+               floor + GLWorld_textureHeight(side->midtexture) : ceiling;
+            GLWorld_addWall(seg, side->midtexture, floor, ceiling, textop + row, light);
+         }
+         continue;
+      }
+
+      const float backfloor   = back->srf.floor.heightf;
+      const float backceiling = back->srf.ceiling.heightf;
+
+      // no upper between two skies
+      if(side->toptexture && backceiling < ceiling &&
+         !(R_IsSkyFlat(front->srf.ceiling.pic) && R_IsSkyFlat(back->srf.ceiling.pic)))
+      {
+         const float textop = (flags & ML_DONTPEGTOP) ?
+            ceiling : backceiling + GLWorld_textureHeight(side->toptexture);
+         GLWorld_addWall(seg, side->toptexture, backceiling, ceiling, textop + row, light);
+      }
+
+      if(side->bottomtexture && backfloor > floor)
+      {
+         const float textop = (flags & ML_DONTPEGBOTTOM) ? ceiling : backfloor;
+         GLWorld_addWall(seg, side->bottomtexture, floor, backfloor, textop + row, light);
+      }
+
+      // masked midtextures don't repeat vertically
+      if(side->midtexture)
+      {
+         const float height = GLWorld_textureHeight(side->midtexture);
+         const float low    = emax(floor, backfloor);
+         const float high   = emin(ceiling, backceiling);
+         const float textop = ((flags & ML_DONTPEGBOTTOM) ? low + height : high) + row;
+
+         GLWorld_addWall(seg, side->midtexture, emax(low, textop - height),
+                         emin(high, textop), textop, light);
+      }
+   }
+}
+
+//
+// Adds a floor or ceiling over a subsector's outline
+//
+static void GLWorld_addFlat(const glworldpoly_t &poly, const surface_t &surface, float light)
+{
+   glatlasregion_t region;
+
+   if(poly.count < 3 || R_IsSkyFlat(surface.pic) ||
+      !GL_AtlasTexture(texturetranslation[surface.pic], region))
+      return;
+
+   glworldbatch_t *batch = GLWorld_batchFor(region.texture);
+
+   if(!batch)
+      return;
+
+   const float      xoffs = M_FixedToFloat(surface.offset.x);
+   const float      yoffs = M_FixedToFloat(surface.offset.y);
+   const v2float_t *verts = worldpolyverts + poly.first;
+
+   auto corner = [&](const v2float_t &vert) -> glworldcorner_t {
+      return { vert.x, vert.y, surface.heightf,
+               (vert.x + xoffs) / region.width, (yoffs - vert.y) / region.height };
+   };
+
+   for(int i = 1; i + 1 < poly.count; i++)
+   {
+      GLWorld_addVertex(*batch, corner(verts[0]),     region, light);
+      GLWorld_addVertex(*batch, corner(verts[i]),     region, light);
+      GLWorld_addVertex(*batch, corner(verts[i + 1]), region, light);
+   }
+}
+
+static void GLWorld_addFlats()
+{
+   for(int i = 0; i < numsubsectors; i++)
+   {
+      const sector_t &sector = *subsectors[i].sector;
+      const float     light  = GLWorld_light(sector);
+
+      GLWorld_addFlat(worldpolys[i], sector.srf.floor,   light);
+      GLWorld_addFlat(worldpolys[i], sector.srf.ceiling, light);
+   }
+}
+
+//
+// Adds every thing as a sprite facing the view
+//
+static void GLWorld_addThings(const viewpoint_t &viewpoint, const cbviewpoint_t &cbviewpoint,
+                              float sine, float cosine)
+{
+   for(int i = 0; i < numsectors; i++)
+   {
+      const float sectorlight = GLWorld_light(sectors[i]);
+
+      for(const Mobj *thing = sectors[i].thinglist; thing; thing = thing->snext)
+      {
+         glatlasregion_t region;
+
+         if((thing->flags2 & MF2_DONTDRAW) || !thing->translucency)
+            continue;
+
+         const fixed_t x = lerpCoord(view.lerp, thing->prevpos.x, thing->x);
+         const fixed_t y = lerpCoord(view.lerp, thing->prevpos.y, thing->y);
+         const fixed_t z = lerpCoord(view.lerp, thing->prevpos.z, thing->z);
+         const float   fx = M_FixedToFloat(x);
+         const float   fy = M_FixedToFloat(y);
+
+         // anything as close as the viewer, such as the viewer, isn't seen
+         if((fx - cbviewpoint.x) * cosine + (fy - cbviewpoint.y) * sine < WORLD_NEAR)
+            continue;
+
+         const angle_t  ang = R_PointToAngle2(viewpoint.x, viewpoint.y, x, y);
+         const unsigned rot = (ang - thing->angle + unsigned(ANG45 / 2) * 9) >> 29;
+
+         if(!GL_AtlasSprite(thing->sprite, thing->frame & FF_FRAMEMASK, int(rot), region))
+            continue;
+
+         // offsets run along the view's right, which is (sine, -cosine)
+         const float left   = -region.leftoffset * thing->xscale;
+         const float right  = left + region.width * thing->xscale;
+         const float top    = M_FixedToFloat(z - thing->floorclip) +
+                              region.topoffset * thing->yscale;
+         const float bottom = top - region.height * thing->yscale;
+         const float light  = (thing->frame & FF_FULLBRIGHT) ? 1.0f : sectorlight;
+
+         const glworldcorner_t corners[4] =
+         {
+            { fx + sine * left,  fy - cosine * left,  top,    0.0f, 0.0f },
+            { fx + sine * right, fy - cosine * right, top,    1.0f, 0.0f },
+            { fx + sine * right, fy - cosine * right, bottom, 1.0f, 1.0f },
+            { fx + sine * left,  fy - cosine * left,  bottom, 0.0f, 1.0f },
+         };
+
+         GLWorld_addQuad(corners, region, light);
+      }
+   }
+}
+
+//
+// Makes the matrix taking map coordinates to clip space, projecting the way
+// the software renderer does, so the world lines up with the psprites and
+// shears with the view pitch the same way.
+//
+static void GLWorld_setupTransform(GLfloat (&m)[16], const cbviewpoint_t &cbviewpoint,
+                                   float sine, float cosine)
+{
+   // eye coordinates: right, up and forward of the viewer
+   const float right[4]   = { sine,   -cosine, 0.0f,
+                              -(cbviewpoint.x * sine - cbviewpoint.y * cosine) };
+   const float up[4]      = { 0.0f,   0.0f,    1.0f, -cbviewpoint.z };
+   const float forward[4] = { cosine, sine,    0.0f,
+                              -(cbviewpoint.x * cosine + cbviewpoint.y * sine) };
+
+   // screen x = xcenter + xfoc * right / forward, and likewise for y
+   const float xscale = 2.0f * view.xfoc / view.width;
+   const float xshift = 2.0f * view.xcenter / view.width - 1.0f;
+   const float yscale = 2.0f * view.yfoc / view.height;
+   const float yshift = 1.0f - 2.0f * view.ycenter / view.height;
+   const float zscale = (WORLD_FAR + WORLD_NEAR) / (WORLD_FAR - WORLD_NEAR);
+   const float zshift = -2.0f * WORLD_FAR * WORLD_NEAR / (WORLD_FAR - WORLD_NEAR);
+
+   for(int col = 0; col < 4; col++)
+   {
+      m[col * 4 + 0] = xscale * right[col] + xshift * forward[col];
+      m[col * 4 + 1] = yscale * up[col] + yshift * forward[col];
+      m[col * 4 + 2] = zscale * forward[col] + (col == 3 ? zshift : 0.0f);
+      m[col * 4 + 3] = forward[col];
+   }
+}
+
+//
+// Has the video driver draw the world; r_hwview's callback
+//
+static void GLWorld_renderView(const rrect_t &window)
+{
+   i_sdlglworldvideodriver.DrawWorld(window);
+}
+
+static hwviewrenderer_t worldview = { WORLD_KEYCOLOR, GLWorld_renderView };
+
+//
+// SDLGLWorldVideoDriver::DrawWorld
+//
+// Draws the world of the view R_SetupFrame has just set up into the view
+// window's place in the back buffer, and keys the view window so it shows.
+//
+void SDLGLWorldVideoDriver::DrawWorld(const rrect_t &window)
+{
+   const viewpoint_t   &viewpoint   = r_globalcontext.view;
+   const cbviewpoint_t &cbviewpoint = r_globalcontext.cb_view;
+   const float          angle       = viewpoint.angle * (PI / ANG180);
+   const float          sine        = sinf(angle);
+   const float          cosine      = cosf(angle);
+   GLfloat              transform[16];
+   GLint                viewport[4];
+   GLint                program = 0;
+
+   if(!worldpolys || !worldpolyverts)
+      GLWorld_buildLevel();
+
+   numworldbatches = 0;
+   GLWorld_addWalls();
+   GLWorld_addFlats();
+   GLWorld_addThings(viewpoint, cbviewpoint, sine, cosine);
+
+   // the view window's place in the drawable, which GL counts from the bottom
+   const int x1 = screenx + window.x * screenwidth / video.width;
+   const int x2 = screenx + (window.x + window.width) * screenwidth / video.width;
+   const int y1 = screeny + (video.height - window.y - window.height) * screenheight / video.height;
+   const int y2 = screeny + (video.height - window.y) * screenheight / video.height;
+
+   glGetIntegerv(GL_VIEWPORT, viewport);
+   glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+
+   glViewport(x1, y1, x2 - x1, y2 - y1);
+   glScissor(x1, y1, x2 - x1, y2 - y1);
+   glEnable(GL_SCISSOR_TEST);
+   glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+   glDisable(GL_SCISSOR_TEST);
+   glEnable(GL_DEPTH_TEST);
+
+   GLWorld_setupTransform(transform, cbviewpoint, sine, cosine);
+   pglUseProgram(worldProgram);
+   pglUniformMatrix4fv(transformLocation, 1, GL_FALSE, transform);
+
+   pglBindVertexArray(worldVAO);
+   pglBindBuffer(GL_ARRAY_BUFFER, worldVBO);
+
+   for(int i = 0; i < numworldbatches; i++)
+   {
+      const glworldbatch_t &batch = worldbatches[i];
+      const size_t          count = batch.vertices.getLength();
+
+      GL_BindTextureAndRemember(batch.texture);
+      pglBufferData(GL_ARRAY_BUFFER, GLsizeiptr(count * sizeof(glworldvertex_t)),
+                    batch.vertices.begin(), GL_STREAM_DRAW);
+      glDrawArrays(GL_TRIANGLES, 0, GLsizei(count));
+   }
+
+   pglBindBuffer(GL_ARRAY_BUFFER, 0);
+   pglBindVertexArray(0);
+
+   glDisable(GL_DEPTH_TEST);
+   pglUseProgram(GLuint(program));
+   glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+
+   keycolor  = WORLD_KEYCOLOR;
+   keyx      = window.x;
+   keyy      = window.y;
+   keywidth  = window.width;
+   keyheight = window.height;
+}
+
+//=============================================================================
+//
+// Setup
+//
+
+// WARNING: SDL_GL_GetProcAddress is non-portable! See i_sdlgl2d.cpp.
+
+#define GETPROC(ptr, name, type) \
+   ptr = (type)SDL_GL_GetProcAddress(name); \
+   extension_ok = (extension_ok && ptr != nullptr)
+
+//
+// Loads the GL 3.3 entry points, if the context has them.
+//
+static bool GLWorld_loadProcs()
+{
+   bool extension_ok = true;
+   int  major = 0, minor = 0;
+   const char *version = reinterpret_cast<const char *>(glGetString(GL_VERSION));
+
+   if(!version || sscanf(version, "%d.%d", &major, &minor) != 2 ||
+      major * 10 + minor < 33)
+      return false;
+
+   GETPROC(pglGenVertexArrays,         "glGenVertexArrays",         PFNGLGENVERTEXARRAYSPROC);
+   GETPROC(pglBindVertexArray,         "glBindVertexArray",         PFNGLBINDVERTEXARRAYPROC);
+   GETPROC(pglDeleteVertexArrays,      "glDeleteVertexArrays",      PFNGLDELETEVERTEXARRAYSPROC);
+   GETPROC(pglGenBuffers,              "glGenBuffers",              PFNGLGENBUFFERSPROC);
+   GETPROC(pglBindBuffer,              "glBindBuffer",              PFNGLBINDBUFFERPROC);
+   GETPROC(pglBufferData,              "glBufferData",              PFNGLBUFFERDATAPROC);
+   GETPROC(pglDeleteBuffers,           "glDeleteBuffers",           PFNGLDELETEBUFFERSPROC);
+   GETPROC(pglVertexAttribPointer,     "glVertexAttribPointer",     PFNGLVERTEXATTRIBPOINTERPROC);
+   GETPROC(pglEnableVertexAttribArray, "glEnableVertexAttribArray", PFNGLENABLEVERTEXATTRIBARRAYPROC);
+   GETPROC(pglCreateShader,            "glCreateShader",            PFNGLCREATESHADERPROC);
+   GETPROC(pglShaderSource,            "glShaderSource",            PFNGLSHADERSOURCEPROC);
+   GETPROC(pglCompileShader,           "glCompileShader",           PFNGLCOMPILESHADERPROC);
+   GETPROC(pglGetShaderiv,             "glGetShaderiv",             PFNGLGETSHADERIVPROC);
+   GETPROC(pglGetShaderInfoLog,        "glGetShaderInfoLog",        PFNGLGETSHADERINFOLOGPROC);
+   GETPROC(pglDeleteShader,            "glDeleteShader",            PFNGLDELETESHADERPROC);
+   GETPROC(pglCreateProgram,           "glCreateProgram",           PFNGLCREATEPROGRAMPROC);
+   GETPROC(pglAttachShader,            "glAttachShader",            PFNGLATTACHSHADERPROC);
+   GETPROC(pglLinkProgram,             "glLinkProgram",             PFNGLLINKPROGRAMPROC);
+   GETPROC(pglGetProgramiv,            "glGetProgramiv",            PFNGLGETPROGRAMIVPROC);
+   GETPROC(pglGetProgramInfoLog,       "glGetProgramInfoLog",       PFNGLGETPROGRAMINFOLOGPROC);
+   GETPROC(pglDeleteProgram,           "glDeleteProgram",           PFNGLDELETEPROGRAMPROC);
+   GETPROC(pglUseProgram,              "glUseProgram",              PFNGLUSEPROGRAMPROC);
+   GETPROC(pglGetUniformLocation,      "glGetUniformLocation",      PFNGLGETUNIFORMLOCATIONPROC);
+   GETPROC(pglUniform1i,               "glUniform1i",               PFNGLUNIFORM1IPROC);
+   GETPROC(pglUniformMatrix4fv,        "glUniformMatrix4fv",        PFNGLUNIFORMMATRIX4FVPROC);
+
+   return extension_ok;
+}
+
+static const char *const worldVertexSource =
+   "#version 330\n"
+   "layout(location = 0) in vec3  position;\n"
+   "layout(location = 1) in vec2  tiling;\n"
+   "layout(location = 2) in vec4  rect;\n"
+   "layout(location = 3) in float light;\n"
+   "\n"
+   "uniform mat4 transform;\n"
+   "\n"
+   "out vec2      vtiling;\n"
+   "flat out vec4 vrect;\n"
+   "out float     vlight;\n"
+   "\n"
+   "void main()\n"
+   "{\n"
+   "   vtiling     = tiling;\n"
+   "   vrect       = rect;\n"
+   "   vlight      = light;\n"
+   "   gl_Position = transform * vec4(position, 1.0);\n"
+   "}\n";
+
+// Images repeat within their rectangle of the atlas page. The gradients are
+// taken before wrapping, so the mip level doesn't jump at the seams.
+static const char *const worldFragmentSource =
+   "#version 330\n"
+   "uniform sampler2D atlas;\n"
+   "\n"
+   "in vec2      vtiling;\n"
+   "flat in vec4 vrect;\n"
+   "in float     vlight;\n"
+   "\n"
+   "out vec4 color;\n"
+   "\n"
+   "void main()\n"
+   "{\n"
+   "   vec2 st    = vrect.xy + fract(vtiling) * vrect.zw;\n"
+   "   vec4 texel = textureGrad(atlas, st, dFdx(vtiling) * vrect.zw,\n"
+   "                            dFdy(vtiling) * vrect.zw);\n"
+   "   if(texel.a < 0.5)\n"
+   "      discard;\n"
+   "   color = vec4(texel.rgb * vlight, 1.0);\n"
+   "}\n";
+
+//
+// Compiles one stage of the world shader. Returns 0 on failure.
+//
+static GLuint GLWorld_compileShader(GLenum type, const char *source)
+{
+   GLuint shader   = pglCreateShader(type);
+   GLint  compiled = GL_FALSE;
+
+   pglShaderSource(shader, 1, &source, nullptr);
+   pglCompileShader(shader);
+   pglGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+
+   if(!compiled)
+   {
+      char log[512] = "";
+      pglGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+      usermsg(" Could not compile the world shader:\n%s", log);
+      pglDeleteShader(shader);
+      return 0;
+   }
+
+   return shader;
+}
+
+//
+// Builds the world shader program. Returns false if it couldn't be built.
+//
+static bool GLWorld_createProgram()
+{
+   GLuint vertex, fragment;
+   GLint  linked = GL_FALSE;
+
+   if(!(vertex = GLWorld_compileShader(GL_VERTEX_SHADER, worldVertexSource)))
+      return false;
+   if(!(fragment = GLWorld_compileShader(GL_FRAGMENT_SHADER, worldFragmentSource)))
+   {
+      pglDeleteShader(vertex);
+      return false;
+   }
+
+   worldProgram = pglCreateProgram();
+   pglAttachShader(worldProgram, vertex);
+   pglAttachShader(worldProgram, fragment);
+   pglLinkProgram(worldProgram);
+
+   pglDeleteShader(vertex);
+   pglDeleteShader(fragment);
+
+   pglGetProgramiv(worldProgram, GL_LINK_STATUS, &linked);
+   if(!linked)
+   {
+      char log[512] = "";
+      pglGetProgramInfoLog(worldProgram, sizeof(log), nullptr, log);
+      usermsg(" Could not link the world shader:\n%s", log);
+      pglDeleteProgram(worldProgram);
+      worldProgram = 0;
+      return false;
+   }
+
+   transformLocation = pglGetUniformLocation(worldProgram, "transform");
+   return true;
+}
+
+//
+// Sets up the shader and vertex arrays. Returns false if the context isn't
+// up to it.
+//
+static bool GLWorld_init()
+{
+   GLint program = 0;
+
+   if(!GLWorld_loadProcs() || !GLWorld_createProgram())
+      return false;
+
+   glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+   pglUseProgram(worldProgram);
+   pglUniform1i(pglGetUniformLocation(worldProgram, "atlas"), 0);
+   pglUseProgram(GLuint(program));
+
+   pglGenVertexArrays(1, &worldVAO);
+   pglGenBuffers(1, &worldVBO);
+   pglBindVertexArray(worldVAO);
+   pglBindBuffer(GL_ARRAY_BUFFER, worldVBO);
+
+   const GLsizei stride = sizeof(glworldvertex_t);
+   pglVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride,
+                          reinterpret_cast<const GLvoid *>(offsetof(glworldvertex_t, x)));
+   pglVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, stride,
+                          reinterpret_cast<const GLvoid *>(offsetof(glworldvertex_t, u)));
+   pglVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, stride,
+                          reinterpret_cast<const GLvoid *>(offsetof(glworldvertex_t, s)));
+   pglVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, stride,
+                          reinterpret_cast<const GLvoid *>(offsetof(glworldvertex_t, light)));
+   for(GLuint i = 0; i < 4; i++)
+      pglEnableVertexAttribArray(i);
+
+   pglBindVertexArray(0);
+   pglBindBuffer(GL_ARRAY_BUFFER, 0);
+
+   return true;
+}
+
+//
+// SDLGLWorldVideoDriver::ShutdownGraphicsPartway
+//
+void SDLGLWorldVideoDriver::ShutdownGraphicsPartway()
+{
+   r_hwview = nullptr;
+
+   if(worldVAO)
+   {
+      pglDeleteVertexArrays(1, &worldVAO);
+      worldVAO = 0;
+   }
+   if(worldVBO)
+   {
+      pglDeleteBuffers(1, &worldVBO);
+      worldVBO = 0;
+   }
+   if(worldProgram)
+   {
+      pglDeleteProgram(worldProgram);
+      worldProgram = 0;
+   }
+
+   SDLGL2DVideoDriver::ShutdownGraphicsPartway();
+}
+
+//
+// SDLGLWorldVideoDriver::InitGraphicsMode
+//
+bool SDLGLWorldVideoDriver::InitGraphicsMode()
+{
+   static bool firsttime = true;
+
+   // walls and sprites need depth testing
+   depthsize = 24;
+
+   const bool result = SDLGL2DVideoDriver::InitGraphicsMode();
+
+   if(CanKeyScreen() && GLWorld_init())
+   {
+      r_hwview = &worldview;
+      if(firsttime)
+         usermsg(" Drawing the world with GL");
+   }
+   else if(firsttime)
+      usermsg(" GL world drawing needs GL 3.3 and the palette shader; drawing in software");
+
+   // Don't print messages in this routine more than once
+   firsttime = false;
+
+   return result;
+}
+
+// The one and only global instance of the SDL GL world video driver.
+SDLGLWorldVideoDriver i_sdlglworldvideodriver;
+
+#endif
+
+// EOF
+
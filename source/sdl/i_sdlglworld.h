@@ -0,0 +1,52 @@
+//
+// The Eternity Engine
+// Copyright(C) 2026 James Haley, Max Waine, et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+// Additional terms and conditions compatible with the GPLv3 apply. See the
+// file COPYING-EE for details.
+//
+// Purpose: SDL-specific GL world video code
+//
+
+#ifndef I_SDLGLWORLD_H__
+#define I_SDLGLWORLD_H__
+
+#include "i_sdlgl2d.h"
+
+struct rrect_t;
+
+//
+// SDL GL World Video Driver
+//
+// Shows the screen as GL2D does, but draws the world of the player's view
+// itself. Falls back to being GL2D where it can't.
+//
+class SDLGLWorldVideoDriver : public SDLGL2DVideoDriver
+{
+public:
+   // Overrides
+   virtual void ShutdownGraphicsPartway();
+   virtual bool InitGraphicsMode();
+
+   void DrawWorld(const rrect_t &window);
+};
+
+extern SDLGLWorldVideoDriver i_sdlglworldvideodriver;
+
+#endif
+
+// EOF
+
@@ -26,7 +26,12 @@
 // haleyjd 11/22/08: I don't understand why this is needed here...
 #define USE_RWOPS
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
 #include <optional>
+#include <thread>
 
 #include "SDL.h"
 #include "SDL_mixer.h"
@@ -71,6 +76,177 @@ extern SDL_AudioSpec audio_spec;
 #define STEP 2
 #define STEPSHIFT 1
 
+#if defined(HAVE_SPCLIB) || defined(HAVE_ADLMIDILIB)
+
+//=============================================================================
+//
+// Music render thread
+//
+// Synthesized music (SPC and libADLMIDI) is rendered on its own thread into a
+// single-producer, single-consumer byte ring several callbacks ahead of the
+// mixer, so a heavy song can't hold up the audio callback. The callback only
+// copies out. The ring is a whole number of chunks, and the thread always
+// writes a whole chunk, so only reads can wrap.
+//
+
+using musicrender_t = void (*)(Uint8 *stream, int len);
+
+// Callbacks' worth of music rendered ahead
+static constexpr int MUSICRINGCHUNKS = 4;
+
+static Uint8              *musicring;
+static Uint8              *musicchunk;      // render thread's scratch buffer
+static size_t              musicringsize;   // in bytes
+static size_t              musicchunksize;  // bytes rendered per pass
+static std::atomic<size_t> musicringhead;   // total bytes written
+static std::atomic<size_t> musicringtail;   // total bytes read
+static std::atomic<bool>   musicrunning;
+
+// The thread is stopped if still running at exit, since destroying a
+// running std::thread terminates the program.
+static struct musicthread_t
+{
+   std::thread thread;
+
+   ~musicthread_t()
+   {
+      musicrunning.store(false, std::memory_order_release);
+      if(thread.joinable())
+         thread.join();
+   }
+} musicthread;
+
+static std::atomic<unsigned int> musicunderruns;
+
+//
+// Renders one chunk into the ring. Render thread, or the main thread before
+// the render thread starts.
+//
+static void I_renderMusicChunk(musicrender_t render)
+{
+   const size_t head = musicringhead.load(std::memory_order_relaxed);
+
+   // renderers mix into silence
+   memset(musicchunk, 0, musicchunksize);
+   render(musicchunk, int(musicchunksize));
+
+   memcpy(musicring + head % musicringsize, musicchunk, musicchunksize);
+   musicringhead.store(head + musicchunksize, std::memory_order_release);
+}
+
+//
+// Keeps the ring topped up until told to stop.
+//
+static void I_musicThreadFunc(musicrender_t render)
+{
+   while(musicrunning.load(std::memory_order_acquire))
+   {
+      const size_t used = musicringhead.load(std::memory_order_relaxed) -
+                          musicringtail.load(std::memory_order_acquire);
+
+      if(musicringsize - used >= musicchunksize)
+         I_renderMusicChunk(render);
+      else
+         std::this_thread::sleep_for(std::chrono::milliseconds(1));
+   }
+}
+
+//
+// Copies up to len bytes of rendered music out of the ring, counting an
+// underrun if there wasn't enough. Audio callback side.
+//
+static size_t I_readMusicRing(Uint8 *dest, size_t len)
+{
+   const size_t tail  = musicringtail.load(std::memory_order_relaxed);
+   const size_t avail = musicringhead.load(std::memory_order_acquire) - tail;
+
+   if(avail < len)
+   {
+      musicunderruns.fetch_add(1, std::memory_order_relaxed);
+      len = avail;
+   }
+
+   const size_t start = tail % musicringsize;
+   const size_t first = emin(len, musicringsize - start);
+
+   memcpy(dest, musicring + start, first);
+   memcpy(dest + first, musicring, len - first);
+   musicringtail.store(tail + len, std::memory_order_release);
+
+   return len;
+}
+
+//
+// I_stopMusicThread
+//
+// Unhooks the music callback and waits for the render thread to finish, so
+// that the song it was rendering can be freed or restarted.
+//
+static void I_stopMusicThread()
+{
+   Mix_HookMusic(nullptr, nullptr);
+
+   if(!musicthread.thread.joinable())
+      return;
+
+   musicrunning.store(false, std::memory_order_release);
+   musicthread.thread.join();
+}
+
+//
+// I_startMusicThread
+//
+// Primes the ring with a chunk of music, starts rendering the rest of it in
+// the background, and hooks the given callback to play it back.
+//
+static void I_startMusicThread(musicrender_t render,
+                               void (*callback)(void *, Uint8 *, int))
+{
+   I_stopMusicThread();
+
+   const size_t samplesize = float_samples ? sizeof(float) : sizeof(Sint16);
+
+   musicchunksize = size_t(audio_spec.samples) * audio_spec.channels * samplesize;
+   musicringsize  = musicchunksize * MUSICRINGCHUNKS;
+   musicring      = static_cast<Uint8 *>(Z_SysRealloc(musicring, musicringsize));
+   musicchunk     = static_cast<Uint8 *>(Z_SysRealloc(musicchunk, musicchunksize));
+   musicringhead.store(0, std::memory_order_relaxed);
+   musicringtail.store(0, std::memory_order_relaxed);
+
+   I_renderMusicChunk(render);
+
+   musicrunning.store(true, std::memory_order_release);
+   musicthread.thread = std::thread(I_musicThreadFunc, render);
+
+   Mix_HookMusic(callback, nullptr);
+}
+
+//
+// mus_bufferstats
+//
+// Reports how far ahead synthesized music is rendered and how often the
+// mixer has run dry.
+//
+CONSOLE_COMMAND(mus_bufferstats, 0)
+{
+   if(!musicthread.thread.joinable())
+   {
+      C_Printf("No synthesized music is playing\n");
+      return;
+   }
+
+   const size_t used = musicringhead.load(std::memory_order_relaxed) -
+                       musicringtail.load(std::memory_order_relaxed);
+   const size_t framesize = musicchunksize / audio_spec.samples;
+
+   C_Printf("Music buffer: %u of %u bytes (%u ms ahead), %u underruns\n",
+            unsigned(used), unsigned(musicringsize),
+            unsigned(used / framesize * 1000 / audio_spec.freq),
+            musicunderruns.load(std::memory_order_relaxed));
+}
+
+#endif
+
 #ifdef HAVE_SPCLIB
 // haleyjd 05/02/08: SPC support
 static SNES_SPC   *snes_spc   = nullptr;
@@ -85,10 +261,11 @@ void I_SDLMusicSetSPCBass(void)
       spc_filter_set_bass(spc_filter, spc_bass_boost);
 }
 //
-// SDL_mixer effect processor; mixes SPC data into the postmix stream.
+// Renders SPC data into a buffer at the output rate. Runs on the music
+// render thread.
 //
 template<typename T>
-static void I_effectSPC(void *udata, Uint8 *stream, int len)
+static void I_renderSPC(Uint8 *stream, int len)
 {
    static constexpr int SAMPLESIZE = sizeof(T);
 
@@ -152,7 +329,7 @@ static void I_effectSPC(void *udata, Uint8 *stream, int len)
          *rightout = eclamp(dr, -1.0f, 1.0f);
       }
       static_assert(std::is_same_v<T, Sint16> || std::is_same_v<T, float>,
-                    "I_effectSPC called with incompatible template parameter");
+                    "I_renderSPC called with incompatible template parameter");
 
       stepremainder += ((32000 << 16) / 44100);
 
@@ -169,6 +346,14 @@ static void I_effectSPC(void *udata, Uint8 *stream, int len)
       rightout += audio_spec.channels;
    }
 }
+
+//
+// SDL_mixer music hook; plays back the rendered SPC data.
+//
+static void I_effectSPC(void *udata, Uint8 *stream, int len)
+{
+   I_readMusicRing(stream, size_t(len));
+}
 #endif
 
 #ifdef HAVE_ADLMIDILIB
@@ -179,59 +364,264 @@ int midi_device      = 0;
 int adlmidi_numchips = 2;
 int adlmidi_bank     = 72;
 int adlmidi_emulator = 0;
+int adlmidi_threads  = 1;
 
 //
-// Play a MIDI via libADLMIDI
+// Multi-threaded OPL emulation
 //
-template<typename T>
-static void I_effectADLMIDI(void *udata, Uint8 *stream, int len)
+// libADLMIDI runs all of a player's chips one after the other. To spread a
+// many-chip song over several cores, snd_oplthreads > 1 loads it into that
+// many players, each emulating its share of the chips and playing only its
+// share of the sixteen MIDI channels. Player 0 (adlmidi_player) is rendered
+// by the music thread itself and the rest by a small pool, one thread per
+// player, and the outputs are summed once every part of the block is done.
+//
+
+static constexpr int ADLMIDI_MAXTHREADS = 8;
+static constexpr int ADLMIDI_CHANNELS   = 16;
+
+static ADL_MIDIPlayer *adlmidi_parts[ADLMIDI_MAXTHREADS];
+static int             adlmidi_numparts;
+
+struct adlmidipool_t
 {
-   static constexpr unsigned int ADLMIDISTEP = sizeof(T);
-   static T   *adlmidi_buffer     = nullptr;
-   static int  lastadlmidisamples = 0;
+   std::thread             threads[ADLMIDI_MAXTHREADS - 1];
+   std::mutex              lock;
+   std::condition_variable start;
+   std::condition_variable done;
+   unsigned int            generation; // bumped once per block
+   int                     pending;    // parts of the block still rendering
+   bool                    quit;
+
+   // the block being rendered
+   int                 numsamples;
+   ADLMIDI_AudioFormat fmt;
+   Uint8              *buffers[ADLMIDI_MAXTHREADS];
+   size_t              buffersize;
+};
 
-   adlplaying = true;
-   // TODO: Remove the exiting check once all atexit calls are erradicated
-   if(Mix_PausedMusic()) //if(exiting || Mix_PausedMusic())
+static adlmidipool_t adlmidi_pool;
+
+//
+// Pool thread: renders one player into its own buffer for every block.
+//
+static void I_adlmidiPoolThreadFunc(int part)
+{
+   adlmidipool_t &pool = adlmidi_pool;
+   unsigned int   seen = 0;
+
+   while(true)
    {
-      adlplaying = false;
-      return;
+      {
+         std::unique_lock<std::mutex> lock(pool.lock);
+         pool.start.wait(lock, [&] { return pool.quit || pool.generation != seen; });
+         if(pool.quit)
+            return;
+         seen = pool.generation;
+      }
+
+      adl_playFormat(adlmidi_parts[part], pool.numsamples, pool.buffers[part],
+                     pool.buffers[part] + pool.fmt.containerSize, &pool.fmt);
+
+      std::lock_guard<std::mutex> lock(pool.lock);
+      if(--pool.pending == 0)
+         pool.done.notify_one();
+   }
+}
+
+//
+// Stops the pool threads and frees every player. Music thread must be stopped.
+//
+static void I_closeADLMIDIParts()
+{
+   adlmidipool_t &pool = adlmidi_pool;
+
+   if(adlmidi_numparts > 1)
+   {
+      {
+         std::lock_guard<std::mutex> lock(pool.lock);
+         pool.quit = true;
+      }
+      pool.start.notify_all();
+
+      for(int i = 0; i < adlmidi_numparts - 1; i++)
+         pool.threads[i].join();
+   }
+
+   for(int i = 0; i < adlmidi_numparts; i++)
+   {
+      adl_close(adlmidi_parts[i]);
+      adlmidi_parts[i] = nullptr;
+      Z_SysFree(pool.buffers[i]);
+      pool.buffers[i] = nullptr;
+   }
+   pool.buffersize  = 0;
+   adlmidi_numparts = 0;
+   adlmidi_player   = nullptr;
+}
+
+//
+// Loads a song into snd_oplthreads players, splitting the chips and MIDI
+// channels between them, and starts the pool if there is more than one.
+// Returns false if the data couldn't be opened.
+//
+static bool I_openADLMIDIParts(void *data, int size)
+{
+   const int numparts = emin(emin(adlmidi_threads, adlmidi_numchips), ADLMIDI_MAXTHREADS);
+
+   for(int i = 0; i < numparts; i++)
+   {
+      // earlier parts get any chips left over
+      const int numchips = adlmidi_numchips / numparts + (i < adlmidi_numchips % numparts);
+
+      ADL_MIDIPlayer *player = adl_init(audio_spec.freq);
+      adlmidi_parts[adlmidi_numparts++] = player;
+
+      adl_setNumChips(player, numchips);
+      adl_setBank(player, adlmidi_bank);
+      adl_switchEmulator(player, adlmidi_emulator);
+      adl_setNumFourOpsChn(player, -1);
+      if(adl_openData(player, data, static_cast<unsigned long>(size)) != 0)
+      {
+         I_closeADLMIDIParts();
+         return false;
+      }
+
+      if(numparts > 1)
+      {
+         for(int channel = 0; channel < ADLMIDI_CHANNELS; channel++)
+            adl_setChannelEnabled(player, channel, channel % numparts == i);
+      }
+   }
+
+   adlmidi_player = adlmidi_parts[0];
+
+   if(numparts > 1)
+   {
+      adlmidipool_t &pool = adlmidi_pool;
+
+      pool.generation = 0;
+      pool.pending    = 0;
+      pool.quit       = false;
+      for(int i = 1; i < numparts; i++)
+         pool.threads[i - 1] = std::thread(I_adlmidiPoolThreadFunc, i);
    }
 
+   return true;
+}
+
+//
+// Sums a part's block into the output.
+//
+template<typename T>
+static void I_mixADLMIDIPart(T *dest, const T *src, int count)
+{
+   for(int i = 0; i < count; i++)
+   {
+      if constexpr(std::is_same_v<T, Sint16>)
+         dest[i] = static_cast<Sint16>(eclamp(dest[i] + src[i], SHRT_MIN, SHRT_MAX));
+      else
+         dest[i] += src[i];
+   }
+}
+
+//
+// Renders a MIDI via libADLMIDI. Runs on the music render thread.
+//
+template<typename T>
+static void I_renderADLMIDI(Uint8 *stream, int len)
+{
+   static constexpr unsigned int ADLMIDISTEP = sizeof(T);
+
    ADLMIDI_AudioFormat fmt = { ADLMIDI_SampleType_S16, ADLMIDISTEP, ADLMIDISTEP * audio_spec.channels };
    if constexpr(std::is_same_v<T, Sint16>)
       fmt.type = ADLMIDI_SampleType_S16;
    else if constexpr(std::is_same_v<T, float>)
       fmt.type = ADLMIDI_SampleType_F32;
    static_assert(std::is_same_v<T, Sint16> || std::is_same_v<T, float>,
-                 "I_effectADLMIDI called with incompatible template parameter");
+                 "I_renderADLMIDI called with incompatible template parameter");
 
    const int numsamples = (len * 2) / fmt.sampleOffset;
 
-   // realloc ADLMIDI buffer?
-   if(numsamples != lastadlmidisamples)
+   adlplaying = true;
+
+   if(adlmidi_numparts > 1)
    {
-      // add extra buffer samples at end for filtering safety; stereo channels
-      adlmidi_buffer = static_cast<T *>(Z_SysRealloc(adlmidi_buffer, len));
-      lastadlmidisamples = numsamples;
-   }
+      adlmidipool_t &pool = adlmidi_pool;
 
-   ADL_UInt8 *const l_out = reinterpret_cast<ADL_UInt8 *>(adlmidi_buffer);
-   ADL_UInt8 *const r_out = reinterpret_cast<ADL_UInt8 *>(adlmidi_buffer + 1);
-   const int gotlen = adl_playFormat(adlmidi_player, numsamples, l_out, r_out, &fmt) *
-                      fmt.sampleOffset / 2;
-   if(snd_MusicVolume == SND_MAXVOLUME)
-      memcpy(stream, reinterpret_cast<Uint8 *>(adlmidi_buffer), size_t(gotlen));
+      for(int i = 1; i < adlmidi_numparts; i++)
+      {
+         if(pool.buffersize != size_t(len))
+            pool.buffers[i] = static_cast<Uint8 *>(Z_SysRealloc(pool.buffers[i], len));
+         memset(pool.buffers[i], 0, len);
+      }
+      pool.buffersize = size_t(len);
+
+      // hand out the other parts, and do the first one here meanwhile
+      {
+         std::lock_guard<std::mutex> lock(pool.lock);
+         pool.numsamples = numsamples;
+         pool.fmt        = fmt;
+         pool.pending    = adlmidi_numparts - 1;
+         ++pool.generation;
+      }
+      pool.start.notify_all();
+
+      adl_playFormat(adlmidi_player, numsamples, stream, stream + ADLMIDISTEP, &fmt);
+
+      {
+         std::unique_lock<std::mutex> lock(pool.lock);
+         pool.done.wait(lock, [&pool] { return pool.pending == 0; });
+      }
+
+      for(int i = 1; i < adlmidi_numparts; i++)
+      {
+         I_mixADLMIDIPart(reinterpret_cast<T *>(stream),
+                          reinterpret_cast<const T *>(pool.buffers[i]), len / int(sizeof(T)));
+      }
+   }
    else
    {
-      SDL_MixAudioFormat(
-         stream, reinterpret_cast<Uint8 *>(adlmidi_buffer), audio_spec.format,
-         gotlen, (snd_MusicVolume * 128) / SND_MAXVOLUME
-      );
+      ADL_UInt8 *const l_out = stream;
+      ADL_UInt8 *const r_out = stream + ADLMIDISTEP;
+      adl_playFormat(adlmidi_player, numsamples, l_out, r_out, &fmt);
    }
+
    adlplaying = false;
 }
 
+//
+// SDL_mixer music hook; plays back the rendered MIDI at the music volume.
+//
+static void I_effectADLMIDI(void *udata, Uint8 *stream, int len)
+{
+   static Uint8 *adlmidi_buffer     = nullptr;
+   static int    lastadlmidilen     = 0;
+
+   // TODO: Remove the exiting check once all atexit calls are erradicated
+   if(Mix_PausedMusic()) //if(exiting || Mix_PausedMusic())
+      return;
+
+   if(snd_MusicVolume == SND_MAXVOLUME)
+   {
+      I_readMusicRing(stream, size_t(len));
+      return;
+   }
+
+   // realloc ADLMIDI buffer?
+   if(len != lastadlmidilen)
+   {
+      adlmidi_buffer = static_cast<Uint8 *>(Z_SysRealloc(adlmidi_buffer, len));
+      lastadlmidilen = len;
+   }
+
+   const int gotlen = int(I_readMusicRing(adlmidi_buffer, size_t(len)));
+   SDL_MixAudioFormat(
+      stream, adlmidi_buffer, audio_spec.format,
+      gotlen, (snd_MusicVolume * 128) / SND_MAXVOLUME
+   );
+}
+
 #endif
 
 //
@@ -359,14 +749,16 @@ static void I_SDLPlaySong(int handle, int looping)
 #ifdef HAVE_SPCLIB
    // if a SPC is set up, play it.
    if(snes_spc)
-      Mix_HookMusic(float_samples ? I_effectSPC<float> : I_effectSPC<Sint16>, nullptr);
+      I_startMusicThread(float_samples ? I_renderSPC<float> : I_renderSPC<Sint16>, I_effectSPC);
    else
 #endif
 #ifdef HAVE_ADLMIDILIB
       if(adlmidi_player)
       {
-         Mix_HookMusic(float_samples ? I_effectADLMIDI<float> : I_effectADLMIDI<Sint16>, nullptr);
-         adl_setLoopEnabled(adlmidi_player, looping);
+         for(int i = 0; i < adlmidi_numparts; i++)
+            adl_setLoopEnabled(adlmidi_parts[i], looping);
+         I_startMusicThread(float_samples ? I_renderADLMIDI<float> : I_renderADLMIDI<Sint16>,
+                            I_effectADLMIDI);
       }
       else
 #endif
@@ -479,12 +871,12 @@ static void I_SDLStopSong(int handle)
 
 #ifdef HAVE_SPCLIB
    if(snes_spc)
-      Mix_HookMusic(nullptr, nullptr);
+      I_stopMusicThread();
 #endif
 
 #ifdef HAVE_ADLMIDILIB
    if(adlmidi_player)
-      Mix_HookMusic(nullptr, nullptr);
+      I_stopMusicThread();
 #endif
 }
 
@@ -504,9 +896,8 @@ static void I_SDLUnRegisterSong(int handle)
 #ifdef HAVE_ADLMIDILIB
    if(adlmidi_player)
    {
-      Mix_HookMusic(nullptr, nullptr);
-      adl_close(adlmidi_player);
-      adlmidi_player = nullptr;
+      I_stopMusicThread();
+      I_closeADLMIDIParts();
    }
 #endif
 
@@ -531,8 +922,8 @@ static void I_SDLUnRegisterSong(int handle)
 #ifdef HAVE_SPCLIB
    if(snes_spc)
    {
-      // be certain the callback is unregistered first
-      Mix_HookMusic(nullptr, nullptr);
+      // be certain the callback is unregistered and rendering over first
+      I_stopMusicThread();
 
       // free the spc and filter objects
       spc_delete(snes_spc);
@@ -684,24 +1075,119 @@ static int I_SDLRegisterSong(void *data, int size)
 #endif
 
 #ifdef HAVE_ADLMIDILIB
-   if(isMIDI && midi_device == 0)
-   {
-      adlmidi_player = adl_init(audio_spec.freq);
-      adl_setNumChips(adlmidi_player, adlmidi_numchips);
-      adl_setBank(adlmidi_player, adlmidi_bank);
-      adl_switchEmulator(adlmidi_player, adlmidi_emulator);
-      adl_setNumFourOpsChn(adlmidi_player, -1);
-      if(adl_openData(adlmidi_player, data, static_cast<unsigned long>(size)) == 0)
-         return 1;
-      // Opening data went wrong
-      adl_close(adlmidi_player);
-      adlmidi_player = nullptr;
-   }
+   if(isMIDI && midi_device == 0 && I_openADLMIDIParts(data, size))
+      return 1;
 #endif
 
    return music != nullptr;
 }
 
+//
+// Lump stream RWops
+//
+// Lets SDL_mixer read music straight from its lump. SDL_mixer decodes on
+// the audio thread, which is why WadLumpStream keeps clear of the zone.
+//
+
+static WadLumpStream *I_lumpStreamForRW(SDL_RWops *context)
+{
+   return static_cast<WadLumpStream *>(context->hidden.unknown.data1);
+}
+
+static Sint64 SDLCALL I_lumpStreamSize(SDL_RWops *context)
+{
+   return static_cast<Sint64>(I_lumpStreamForRW(context)->size());
+}
+
+static Sint64 SDLCALL I_lumpStreamSeek(SDL_RWops *context, Sint64 offset, int whence)
+{
+   WadLumpStream *stream = I_lumpStreamForRW(context);
+
+   switch(whence)
+   {
+   case RW_SEEK_CUR:
+      offset += static_cast<Sint64>(stream->tell());
+      break;
+   case RW_SEEK_END:
+      offset += static_cast<Sint64>(stream->size());
+      break;
+   default:
+      break;
+   }
+
+   if(offset < 0 || !stream->seek(static_cast<size_t>(offset)))
+      return SDL_SetError("I_lumpStreamSeek: seek out of range");
+
+   return offset;
+}
+
+static size_t SDLCALL I_lumpStreamRead(SDL_RWops *context, void *ptr, size_t size,
+                                       size_t maxnum)
+{
+   if(!size)
+      return 0;
+
+   return I_lumpStreamForRW(context)->read(ptr, size * maxnum) / size;
+}
+
+static size_t SDLCALL I_lumpStreamWrite(SDL_RWops *context, const void *ptr, size_t size,
+                                        size_t num)
+{
+   SDL_SetError("I_lumpStreamWrite: music lumps are read-only");
+   return 0;
+}
+
+static int SDLCALL I_lumpStreamClose(SDL_RWops *context)
+{
+   delete I_lumpStreamForRW(context);
+   SDL_FreeRW(context);
+   return 0;
+}
+
+//
+// I_SDLRegisterSongStream
+//
+// Hands a lump stream to SDL_mixer. MIDI, MUS and SPC data are turned down,
+// since they are converted or played by something other than SDL_mixer and
+// need to be in memory for that.
+//
+static int I_SDLRegisterSongStream(WadLumpStream *stream)
+{
+   byte header[4];
+
+   if(stream->read(header, sizeof(header)) != sizeof(header) ||
+      !memcmp(header, "MThd", 4) || !memcmp(header, "MUS\x1a", 4) ||
+      !memcmp(header, "SNES", 4) || !stream->seek(0))
+   {
+      delete stream;
+      return 0;
+   }
+
+   if(music != nullptr)
+      I_UnRegisterSong(1);
+
+   SDL_RWops *streamrw = SDL_AllocRW();
+   if(!streamrw)
+   {
+      delete stream;
+      return 0;
+   }
+
+   streamrw->size  = I_lumpStreamSize;
+   streamrw->seek  = I_lumpStreamSeek;
+   streamrw->read  = I_lumpStreamRead;
+   streamrw->write = I_lumpStreamWrite;
+   streamrw->close = I_lumpStreamClose;
+   streamrw->type  = SDL_RWOPS_UNKNOWN;
+   streamrw->hidden.unknown.data1 = stream;
+
+   // SDL_mixer closes the RWops, and so the stream, even if it fails
+   rw    = nullptr;
+   music = Mix_LoadMUS_RW(streamrw, true);
+
+   return music != nullptr;
+}
+
 //
 // I_SDLQrySongPlaying
 //
@@ -730,6 +1216,7 @@ i_musicdriver_t i_sdlmusicdriver =
    I_SDLPauseSong,      // PauseSong
    I_SDLResumeSong,     // ResumeSong
    I_SDLRegisterSong,   // RegisterSong
+   I_SDLRegisterSongStream, // RegisterSongStream
    I_SDLPlaySong,       // PlaySong
    I_SDLStopSong,       // StopSong
    I_SDLUnRegisterSong, // UnRegisterSong
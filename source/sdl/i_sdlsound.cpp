@@ -19,6 +19,9 @@
 // Authors: James Haley, Stephen McGranahan, Julian Aubourg
 //
 
+#include <atomic>
+#include <chrono>
+
 #include "SDL.h"
 #include "SDL_mixer.h"
 
@@ -35,6 +38,7 @@
 #include "../i_system.h"
 #include "../m_argv.h"
 #include "../m_compare.h"
+#include "../m_simd.h"
 #include "../mn_engin.h"
 #include "../s_reverb.h"
 #include "../s_formats.h"
@@ -45,7 +49,7 @@
 extern bool snd_init;
 
 // Needed for calling the actual sound output.
-#define MAX_CHANNELS 32
+#define MAX_CHANNELS SND_MAXCHANNELS
 
 int audio_buffers;
 
@@ -90,110 +94,216 @@ struct channel_info_t
   unsigned int idnum;
   // if true, channel is affected by reverb
   bool reverb;
+};
 
-  // haleyjd 10/02/08: SDL semaphore to protect channel
-  SDL_sem *semaphore;
-  bool shouldstop; // haleyjd 05/16/11
+// Only the mixer touches channelinfo. The game thread sends it commands
+// through sndcmdqueue and keeps its own idea of each channel in channelstate.
+static channel_info_t channelinfo[MAX_CHANNELS+1];
 
+struct channel_state_t
+{
+   unsigned int idnum;   // instance id of the last sound started, 0 if none
+   bool         stopped; // a stop has been sent for it
+   float        leftvol, rightvol; // parameters last sent, to skip repeats
+   unsigned int step;
 };
 
-static channel_info_t channelinfo[MAX_CHANNELS+1];
+static channel_state_t channelstate[MAX_CHANNELS];
 
-// Pitch to stepping lookup, unused.
-static int steptable[256];
+// Instance id of the last sound the mixer finished or stopped on each channel
+static std::atomic<unsigned int> channeldone[MAX_CHANNELS];
 
-// Volume lookups.
-//static int vol_lookup[128*256];
+// Instance id the game thread wants stopped, for when the queue is full
+static std::atomic<unsigned int> channelstop[MAX_CHANNELS];
 
 //
-// addsfx
+// Channel command queue
 //
-// This function adds a sound to the
-//  list of currently active sounds,
-//  which is maintained as a given number
-//  (eight, usually) of internal channels.
-// Returns a handle.
-//
-// haleyjd: needs to take a sfxinfo_t ptr, not a sound id num
-// haleyjd 06/03/06: changed to return boolean for failure or success
+// A single-producer, single-consumer ring: the game thread adds commands and
+// the mixer drains them all at the top of each callback, so neither ever
+// waits for the other.
 //
-static bool addsfx(sfxinfo_t *sfx, int channel, int loop, unsigned int id, bool reverb)
+
+enum sndcmdtype_e
 {
-#ifdef RANGECHECK
-   if(channel < 0 || channel >= MAX_CHANNELS)
-      I_Error("addsfx: channel out of range!\n");
-#endif
+   SNDCMD_START,
+   SNDCMD_STOP,
+   SNDCMD_UPDATE
+};
 
-   // haleyjd 02/18/05: null ptr check
-   if(!snd_init || !sfx)
-      return false;
+struct sndcmd_t
+{
+   sndcmdtype_e type;
+   int          channel;
+   unsigned int idnum;
+
+   // SNDCMD_START
+   sfxinfo_t *sfx;
+   float     *data, *enddata;
+   int        loop;
+   bool       reverb;
+
+   // SNDCMD_START and SNDCMD_UPDATE
+   float        leftvol, rightvol;
+   unsigned int step;
+};
 
-   // haleyjd 12/23/13: invoke high-level PCM loader
-   if(!S_LoadDigitalSoundEffect(sfx))
-      return false;
+#define SNDCMDQUEUESIZE 1024 // must be a power of two
+
+static sndcmd_t sndcmdqueue[SNDCMDQUEUESIZE];
+static std::atomic<unsigned int> sndcmdhead; // next slot the game thread fills
+static std::atomic<unsigned int> sndcmdtail; // next slot the mixer reads
 
-   // haleyjd 10/02/08: critical section
-   if(SDL_SemWait(channelinfo[channel].semaphore) == 0)
+// Game thread only: commands filled in past sndcmdhead but not yet handed
+// over, while I_SDLHoldSoundCommands holds them back
+static unsigned int sndcmdheld;
+static bool         sndcmdholding;
+
+//
+// I_SDLCommandRoom
+//
+// Game thread side. Returns the first free slot and how many follow it.
+//
+static unsigned int I_SDLCommandRoom(unsigned int &head)
+{
+   head = sndcmdhead.load(std::memory_order_relaxed) + sndcmdheld;
+   return SNDCMDQUEUESIZE - (head - sndcmdtail.load(std::memory_order_acquire));
+}
+
+//
+// I_SDLFlushCommands
+//
+// Game thread side. Hands every command filled in so far to the mixer.
+//
+static void I_SDLFlushCommands()
+{
+   if(sndcmdheld)
    {
-      channelinfo[channel].data = static_cast<float *>(sfx->data);
+      sndcmdhead.store(sndcmdhead.load(std::memory_order_relaxed) + sndcmdheld,
+                       std::memory_order_release);
+      sndcmdheld = 0;
+   }
+}
 
-      // Set pointer to end of raw data.
-      channelinfo[channel].enddata = static_cast<float *>(sfx->data) + sfx->alen - 1;
+//
+// I_SDLCommitCommands
+//
+// Game thread side. Hands over count newly filled commands, unless held.
+//
+static void I_SDLCommitCommands(unsigned int count)
+{
+   sndcmdheld += count;
 
-      // haleyjd 06/03/06: keep track of start of sound
-      channelinfo[channel].startdata = channelinfo[channel].data;
+   if(!sndcmdholding)
+      I_SDLFlushCommands();
+}
 
-      channelinfo[channel].restartdata = nullptr;
+//
+// I_SDLQueueCommand
+//
+// Game thread side. Returns false if the queue is full, which only happens
+// if the mixer hasn't run for a good while.
+//
+static bool I_SDLQueueCommand(const sndcmd_t &cmd)
+{
+   unsigned int head;
 
-      channelinfo[channel].stepremainder = 0;
+   if(!I_SDLCommandRoom(head))
+      return false;
 
-      channelinfo[channel].restartstepremainder = 0;
+   sndcmdqueue[head & (SNDCMDQUEUESIZE - 1)] = cmd;
+   I_SDLCommitCommands(1);
 
-      // Preserve sound SFX id
-      channelinfo[channel].id = sfx;
+   return true;
+}
 
-      // Set looping
-      channelinfo[channel].loop = loop;
+//
+// I_SDLFinishChannel
+//
+// Mixer side. Lets the game thread know the channel's sound is over.
+//
+static void I_SDLFinishChannel(channel_info_t &chan)
+{
+   chan.data = nullptr;
+   channeldone[&chan - channelinfo].store(chan.idnum, std::memory_order_release);
+}
 
-      channelinfo[channel].loopcutoff = false;
+//
+// I_SDLRunCommands
+//
+// Mixer side. Applies every command queued since the last callback.
+//
+static void I_SDLRunCommands()
+{
+   const unsigned int head = sndcmdhead.load(std::memory_order_acquire);
+   unsigned int       tail = sndcmdtail.load(std::memory_order_relaxed);
 
-      // Set reverb
-      channelinfo[channel].reverb = reverb;
+   for(; tail != head; tail++)
+   {
+      const sndcmd_t &cmd  = sndcmdqueue[tail & (SNDCMDQUEUESIZE - 1)];
+      channel_info_t &chan = channelinfo[cmd.channel];
 
-      // Set instance ID
-      channelinfo[channel].idnum = id;
+      switch(cmd.type)
+      {
+      case SNDCMD_START:
+         chan.data    = cmd.data;
+         chan.enddata = cmd.enddata;
+         chan.startdata = chan.data;                      // haleyjd 06/03/06
+         chan.restartdata = nullptr;
+         chan.stepremainder = 0;
+         chan.restartstepremainder = 0;
+         chan.id         = cmd.sfx;    // Preserve sound SFX id
+         chan.loop       = cmd.loop;
+         chan.loopcutoff = false;
+         chan.reverb     = cmd.reverb;
+         chan.idnum      = cmd.idnum;
+         chan.leftvol    = cmd.leftvol;
+         chan.rightvol   = cmd.rightvol;
+         chan.step       = cmd.step;
+         break;
+      case SNDCMD_STOP:
+         if(chan.data && chan.idnum == cmd.idnum)
+            I_SDLFinishChannel(chan);
+         break;
+      case SNDCMD_UPDATE:
+         if(chan.idnum == cmd.idnum)
+         {
+            chan.leftvol  = cmd.leftvol;
+            chan.rightvol = cmd.rightvol;
+            chan.step     = cmd.step;
+         }
+         break;
+      }
+   }
 
-      // Shouldn't be stopped - haleyjd 05/16/11
-      channelinfo[channel].shouldstop = false;
+   sndcmdtail.store(tail, std::memory_order_release);
 
-      SDL_SemPost(channelinfo[channel].semaphore);
+   // stops that couldn't be queued
+   for(int i = 0; i < numChannels; i++)
+   {
+      channel_info_t &chan = channelinfo[i];
 
-      return true;
+      if(chan.data && channelstop[i].load(std::memory_order_acquire) == chan.idnum)
+         I_SDLFinishChannel(chan);
    }
-   else
-      return false; // acquisition failed
 }
 
+// Pitch to stepping lookup, unused.
+static int steptable[256];
+
+// Volume lookups.
+//static int vol_lookup[128*256];
+
 //
-// updateSoundParams
+// calcSoundParams
 //
-// Changes sound parameters in response to stereo panning and relative location
-// change.
+// Works out the channel volumes and step for a sound's volume, stereo
+// separation and pitch.
 //
-static void updateSoundParams(int handle, int volume, int separation, int pitch)
+static void calcSoundParams(int volume, int separation, int pitch, sndcmd_t &cmd)
 {
-   int slot = handle;
    int rightvol;
    int leftvol;
-   int step = steptable[pitch];
-   
-   if(!snd_init)
-      return;
-
-#ifdef RANGECHECK
-   if(handle < 0 || handle >= MAX_CHANNELS)
-      I_Error("I_UpdateSoundParams: handle out of range\n");
-#endif
    
    // Separation, that is, orientation/stereo.
    //  range is: 1 - 256
@@ -212,13 +322,8 @@ static void updateSoundParams(int handle, int volume, int separation, int pitch)
    rightvol   = volume - ((volume*separation*separation) >> 16);  
 
    // volume levels are softened slightly by dividing by 191 rather than ideal 127
-   channelinfo[slot].leftvol  = static_cast<float>(eclamp(static_cast<double>(leftvol)  / 191.0, 0.0, 1.0));
-   channelinfo[slot].rightvol = static_cast<float>(eclamp(static_cast<double>(rightvol) / 191.0, 0.0, 1.0));
-
-   // haleyjd 06/07/09: critical section is not needed here because this data
-   // can be out of sync without affecting the sound update loop. This may cause
-   // momentary out-of-sync volume between the left and right sound channels, but
-   // the impact would be practically unnoticeable.
+   cmd.leftvol  = static_cast<float>(eclamp(static_cast<double>(leftvol)  / 191.0, 0.0, 1.0));
+   cmd.rightvol = static_cast<float>(eclamp(static_cast<double>(rightvol) / 191.0, 0.0, 1.0));
 
    // Set stepping
    // MWM 2000-12-24: Calculates proportion of channel samplerate
@@ -226,9 +331,120 @@ static void updateSoundParams(int handle, int volume, int separation, int pitch)
    // Patched to shift left *then* divide, to minimize roundoff errors
    // as well as to use SAMPLERATE as defined above, not to assume 11025 Hz
    if(pitched_sounds)
-      channelinfo[slot].step = step;
+      cmd.step = steptable[pitch];
    else
-      channelinfo[slot].step = 1 << 16;   
+      cmd.step = 1 << 16;   
+}
+
+//
+// addsfx
+//
+// This function adds a sound to the
+//  list of currently active sounds,
+//  which is maintained as a given number
+//  (eight, usually) of internal channels.
+// Returns a handle.
+//
+// haleyjd: needs to take a sfxinfo_t ptr, not a sound id num
+// haleyjd 06/03/06: changed to return boolean for failure or success
+//
+static bool addsfx(sfxinfo_t *sfx, int channel, int loop, unsigned int id, bool reverb,
+                   int volume, int separation, int pitch)
+{
+#ifdef RANGECHECK
+   if(channel < 0 || channel >= MAX_CHANNELS)
+      I_Error("addsfx: channel out of range!\n");
+#endif
+
+   // haleyjd 02/18/05: null ptr check
+   if(!snd_init || !sfx)
+      return false;
+
+   // haleyjd 12/23/13: invoke high-level PCM loader
+   if(!S_LoadDigitalSoundEffect(sfx))
+      return false;
+
+   sndcmd_t cmd;
+
+   cmd.type    = SNDCMD_START;
+   cmd.channel = channel;
+   cmd.idnum   = id;
+   cmd.sfx     = sfx;
+   cmd.data    = static_cast<float *>(sfx->data);
+   cmd.enddata = cmd.data + sfx->alen - 1; // Set pointer to end of raw data.
+   cmd.loop    = loop;
+   cmd.reverb  = reverb;
+   calcSoundParams(volume, separation, pitch, cmd);
+
+   if(!I_SDLQueueCommand(cmd))
+      return false;
+
+   channel_state_t &state = channelstate[channel];
+
+   state.idnum    = id;
+   state.stopped  = false;
+   state.leftvol  = cmd.leftvol;
+   state.rightvol = cmd.rightvol;
+   state.step     = cmd.step;
+
+   return true;
+}
+
+//
+// buildUpdateCommand
+//
+// Fills in an update command for a channel. Returns false if it would change
+// nothing, which is the case for most sounds from one update to the next.
+//
+static bool buildUpdateCommand(int handle, int volume, int separation, int pitch,
+                               sndcmd_t &cmd)
+{
+#ifdef RANGECHECK
+   if(handle < 0 || handle >= MAX_CHANNELS)
+      I_Error("I_UpdateSoundParams: handle out of range\n");
+#endif
+
+   const channel_state_t &state = channelstate[handle];
+
+   cmd.type    = SNDCMD_UPDATE;
+   cmd.channel = handle;
+   cmd.idnum   = state.idnum;
+   calcSoundParams(volume, separation, pitch, cmd);
+
+   return cmd.leftvol != state.leftvol || cmd.rightvol != state.rightvol ||
+          cmd.step != state.step;
+}
+
+//
+// commitUpdateCommand
+//
+// Records the parameters of an update that made it into the queue.
+//
+static void commitUpdateCommand(const sndcmd_t &cmd)
+{
+   channel_state_t &state = channelstate[cmd.channel];
+
+   state.leftvol  = cmd.leftvol;
+   state.rightvol = cmd.rightvol;
+   state.step     = cmd.step;
+}
+
+//
+// updateSoundParams
+//
+// Changes sound parameters in response to stereo panning and relative location
+// change.
+//
+static void updateSoundParams(int handle, int volume, int separation, int pitch)
+{
+   if(!snd_init)
+      return;
+
+   sndcmd_t cmd;
+
+   // if the queue is full the update is dropped; a later one will catch up
+   if(buildUpdateCommand(handle, volume, separation, pitch, cmd) && I_SDLQueueCommand(cmd))
+      commitUpdateCommand(cmd);
 }
 
 //=============================================================================
@@ -448,15 +664,106 @@ static inline void I_SDLMixBuffers()
    }
 }
 
+//
+// Callback CPU time, published for snd_mixstats. Written only by the
+// mixer thread.
+//
+static std::atomic<unsigned int> mixlastusec;
+static std::atomic<unsigned int> mixavgusec;
+static std::atomic<unsigned int> mixmaxusec;
+static std::atomic<unsigned int> mixbufferusec;
+static std::atomic<int>          mixvoices;
+
+//
+// I_SDLFetchSample
+//
+// Read the sample at 16.16 position pos, linearly interpolated toward the
+// next one if requested. last is the final valid sample of the sound.
+//
+template<bool interp>
+static inline float I_SDLFetchSample(const float *data, const float *last, uint64_t pos)
+{
+   const float *src = data + (pos >> 16);
+   if constexpr(interp)
+   {
+      const float a = src[0];
+      const float b = src < last ? src[1] : a;
+      return a + (b - a) * (static_cast<float>(pos & 0xffff) * (1.0f / 65536.0f));
+   }
+   else
+      return *src;
+}
+
+//
+// I_SDLMixChannel
+//
+// Add count frames of one channel into a mix buffer, starting at 16.16
+// position pos relative to data. The caller guarantees every position
+// touched lies at or before last.
+//
+template<bool interp>
+static void I_SDLMixChannel(float *out, int count, const float *data, const float *last,
+                            uint64_t pos, unsigned int chanstep, float leftvol, float rightvol)
+{
+   int i = 0;
+
+#if defined(EE_SIMD_SSE2) || defined(EE_SIMD_NEON)
+   // Interleaved stereo output: four frames per pass. The source positions
+   // are irregular so the gather stays scalar; the panning and accumulation
+   // into the output are done four lanes at a time.
+   if(step == 2)
+   {
+      alignas(16) float s[4];
+#if defined(EE_SIMD_SSE2)
+      const __m128 vol = _mm_setr_ps(leftvol, rightvol, leftvol, rightvol);
+#else
+      const float volarr[4] = { leftvol, rightvol, leftvol, rightvol };
+      const float32x4_t vol = vld1q_f32(volarr);
+#endif
+      for(; i + 4 <= count; i += 4, out += 8)
+      {
+         s[0] = I_SDLFetchSample<interp>(data, last, pos);
+         s[1] = I_SDLFetchSample<interp>(data, last, pos + chanstep);
+         s[2] = I_SDLFetchSample<interp>(data, last, pos + 2 * chanstep);
+         s[3] = I_SDLFetchSample<interp>(data, last, pos + 3 * chanstep);
+         pos += 4 * chanstep;
+#if defined(EE_SIMD_SSE2)
+         const __m128 v  = _mm_load_ps(s);
+         const __m128 lo = _mm_unpacklo_ps(v, v); // s0 s0 s1 s1
+         const __m128 hi = _mm_unpackhi_ps(v, v); // s2 s2 s3 s3
+         _mm_storeu_ps(out,     _mm_add_ps(_mm_loadu_ps(out),     _mm_mul_ps(lo, vol)));
+         _mm_storeu_ps(out + 4, _mm_add_ps(_mm_loadu_ps(out + 4), _mm_mul_ps(hi, vol)));
+#else
+         const float32x4_t   v = vld1q_f32(s);
+         const float32x4x2_t z = vzipq_f32(v, v);
+         vst1q_f32(out,     vmlaq_f32(vld1q_f32(out),     z.val[0], vol));
+         vst1q_f32(out + 4, vmlaq_f32(vld1q_f32(out + 4), z.val[1], vol));
+#endif
+      }
+   }
+#endif
+
+   for(; i < count; i++, out += step)
+   {
+      const float sample = I_SDLFetchSample<interp>(data, last, pos);
+      out[0] += sample * leftvol;
+      out[1] += sample * rightvol;
+      pos += chanstep;
+   }
+}
+
 //
 // I_SDLUpdateSoundCB
 //
 // SDL_mixer postmix callback routine. Possibly dispatched asynchronously.
-// We do our own mixing on up to 32 digital sound channels.
+// We do our own mixing on up to SND_MAXCHANNELS digital sound channels.
 //
 template<typename T>
 static void I_SDLUpdateSoundCB(void *userdata, Uint8 *stream, int len)
 {
+   const auto starttime = std::chrono::steady_clock::now();
+   int voices = 0;
+
    // TODO: Figure out if this is required
    //memset(stream, 0, len);
 
@@ -470,12 +777,15 @@ static void I_SDLUpdateSoundCB(void *userdata, Uint8 *stream, int len)
    float *leftend;
 
    const bool loopsounds = !paused && ((!menuactive && !consoleactive) || demoplayback || netgame);
+   const bool interp     = s_interpolation != 0;
+
+   // pick up what the game thread has done since the last callback
+   I_SDLRunCommands();
 
    // Mix audio channels
    for(channel_info_t *chan = channelinfo; chan != &channelinfo[numChannels]; chan++)
    {
-      // fast rejection before semaphore lock
-      if(chan->shouldstop || !chan->data || (!loopsounds && chan->loopcutoff))
+      if(!chan->data || (!loopsounds && chan->loopcutoff))
          continue;
       else if(loopsounds && chan->loopcutoff)
       {
@@ -487,11 +797,6 @@ static void I_SDLUpdateSoundCB(void *userdata, Uint8 *stream, int len)
          chan->restartstepremainder = 0;
       }
 
-      // try to acquire semaphore, but do not block; if the main thread is using
-      // this channel we'll just skip it for now - safer and faster.
-      if(SDL_SemTryWait(chan->semaphore) != 0)
-         continue;
-
       // Left and right channel are in audio stream, alternating.
       if(chan->reverb)
       {
@@ -504,15 +809,6 @@ static void I_SDLUpdateSoundCB(void *userdata, Uint8 *stream, int len)
          leftend = leftend0;
       }
 
-      // Lost before semaphore acquired? (very unlikely, but must check for 
-      // safety). BTW, don't move this up or you'll chew major CPU whenever this
-      // does happen.
-      if(chan->shouldstop || !chan->data)
-      {
-         SDL_SemPost(chan->semaphore);
-         continue;
-      }
-
       // Save position of sound if we just paused
       if(!loopsounds && !chan->restartdata && chan->loop)
       {
@@ -520,24 +816,47 @@ static void I_SDLUpdateSoundCB(void *userdata, Uint8 *stream, int len)
          chan->restartstepremainder = chan->stepremainder;
       }
 
+      ++voices;
+
       while(leftout != leftend)
       {
-         float sample  = *(chan->data);         
-         *(leftout + 0) = *(leftout + 0) + sample * chan->leftvol;
-         *(leftout + 1) = *(leftout + 1) + sample * chan->rightvol;
-         
+         // Mix as many frames as fit before either the buffer or the sound
+         // runs out, then handle the end of the sound as before.
+         int count = static_cast<int>((leftend - leftout) / step);
+         const ptrdiff_t remaining = chan->enddata - chan->data;
+         if(remaining <= 0)
+            count = 1;
+         else if(chan->step)
+         {
+            const uint64_t untilend =
+               ((static_cast<uint64_t>(remaining) << 16) - chan->stepremainder +
+                chan->step - 1) / chan->step;
+            if(untilend < static_cast<uint64_t>(count))
+               count = static_cast<int>(untilend);
+         }
+
+         if(interp)
+         {
+            I_SDLMixChannel<true>(leftout, count, chan->data, chan->enddata,
+                                  chan->stepremainder, chan->step,
+                                  chan->leftvol, chan->rightvol);
+         }
+         else
+         {
+            I_SDLMixChannel<false>(leftout, count, chan->data, chan->enddata,
+                                   chan->stepremainder, chan->step,
+                                   chan->leftvol, chan->rightvol);
+         }
+
          // Increment current pointers in stream
-         leftout += step;
-         
-         // Increment index
-         chan->stepremainder += chan->step;
-         
-         // MSB is next sample
-         chan->data += chan->stepremainder >> 16;
-         
-         // Limit to LSB
-         chan->stepremainder &= 0xffff;
-         
+         leftout += count * step;
+
+         // MSB of the accumulated position is the sample advance, LSB the
+         // new remainder
+         const uint64_t pos = chan->stepremainder + static_cast<uint64_t>(count) * chan->step;
+         chan->data += pos >> 16;
+         chan->stepremainder = static_cast<unsigned int>(pos & 0xffff);
+
          // Check whether we are done
          if(chan->data >= chan->enddata)
          {
@@ -559,16 +878,13 @@ static void I_SDLUpdateSoundCB(void *userdata, Uint8 *stream, int len)
                }
                else
                {
-                  // flag the channel to be stopped by the main thread ASAP
-                  chan->data = nullptr;
+                  // done; let the main thread know the channel is free
+                  I_SDLFinishChannel(*chan);
                }
                break;
             }
          }
       }
-
-      // release semaphore and move on to the next channel
-      SDL_SemPost(chan->semaphore);
    }
 
    // do reverberation if an effect is active
@@ -580,6 +896,21 @@ static void I_SDLUpdateSoundCB(void *userdata, Uint8 *stream, int len)
 
    // haleyjd 04/21/10: equalization output pass
    do_3band(mixbuffer[0], leftend0, reinterpret_cast<T *>(stream));
+
+   // account the time spent against the length of audio produced
+   const auto usec = static_cast<unsigned int>(
+      std::chrono::duration_cast<std::chrono::microseconds>(
+         std::chrono::steady_clock::now() - starttime).count());
+   const unsigned int avg = mixavgusec.load(std::memory_order_relaxed);
+
+   mixlastusec.store(usec, std::memory_order_relaxed);
+   mixavgusec.store(avg ? (avg * 15 + usec) / 16 : usec, std::memory_order_relaxed);
+   if(usec > mixmaxusec.load(std::memory_order_relaxed))
+      mixmaxusec.store(usec, std::memory_order_relaxed);
+   mixbufferusec.store(static_cast<unsigned int>(
+      static_cast<uint64_t>(len / sample_size / step) * 1000000 / snd_samplerate),
+      std::memory_order_relaxed);
+   mixvoices.store(voices, std::memory_order_relaxed);
 }
 
 //
@@ -604,7 +935,12 @@ static void I_SetChannels()
    
    // Okay, reset internal mixing channels to zero.
    for(i = 0; i < MAX_CHANNELS; i++)
+   {
       memset(&channelinfo[i], 0, sizeof(channel_info_t));
+      memset(&channelstate[i], 0, sizeof(channel_state_t));
+      channeldone[i].store(0);
+      channelstop[i].store(0);
+   }
    
    // This table provides step widths for pitch parameters.
    for(i = -128; i < 128; i++)
@@ -615,15 +951,6 @@ static void I_SetChannels()
    mixbuffer[0] = buf;
    mixbuffer[1] = buf + mixbuffer_size;
 
-   // haleyjd 10/02/08: create semaphores
-   for(i = 0; i < MAX_CHANNELS; i++)
-   {
-      channelinfo[i].semaphore = SDL_CreateSemaphore(1);
-
-      if(!channelinfo[i].semaphore)
-         I_Error("I_SetChannels: failed to create semaphore for channel %d\n", i);
-   }
-
    // haleyjd 04/21/10: initialize equalizers
 
    // Set Low/Mid/High gains 
@@ -678,6 +1005,53 @@ static void I_SDLUpdateSoundParams(int handle, int vol, int sep, int pitch)
    updateSoundParams(handle, vol, sep, pitch);
 }
 
+//
+// I_SDLUpdateSoundParamsBatch
+//
+// Writes the updates that change anything straight into the free part of the
+// command queue and publishes them to the mixer with a single store. Updates
+// that don't fit are dropped, as for single ones.
+//
+static void I_SDLUpdateSoundParamsBatch(const sndupdate_t *updates, int count)
+{
+   if(!snd_init)
+      return;
+
+   unsigned int head;
+   const unsigned int room = I_SDLCommandRoom(head);
+   unsigned int queued = 0;
+
+   for(int i = 0; i < count && queued < room; i++)
+   {
+      const sndupdate_t &u   = updates[i];
+      sndcmd_t          &cmd = sndcmdqueue[(head + queued) & (SNDCMDQUEUESIZE - 1)];
+
+      if(buildUpdateCommand(u.handle, u.vol, u.sep, u.pitch, cmd))
+      {
+         commitUpdateCommand(cmd);
+         ++queued;
+      }
+   }
+
+   I_SDLCommitCommands(queued);
+}
+
+//
+// I_SDLHoldSoundCommands
+//
+// Holds back queued commands until released, so that the mixer picks up a
+// batch of them in the same callback.
+//
+static void I_SDLHoldSoundCommands(bool hold)
+{
+   sndcmdholding = hold;
+
+   if(!hold)
+      I_SDLFlushCommands();
+}
+
+static int I_SDLSoundIsPlaying(int handle);
+
 //
 // I_SDLStartSound
 //
@@ -690,7 +1064,7 @@ static int I_SDLStartSound(sfxinfo_t *sound, int cnum, int vol, int sep,
    // haleyjd 06/03/06: look for an unused hardware channel
    for(handle = 0; handle < numChannels; handle++)
    {
-      if(channelinfo[handle].data == nullptr || channelinfo[handle].shouldstop)
+      if(!I_SDLSoundIsPlaying(handle))
          break;
    }
 
@@ -699,10 +1073,10 @@ static int I_SDLStartSound(sfxinfo_t *sound, int cnum, int vol, int sep,
    if(handle == numChannels)
       return -1;
  
-   if(addsfx(sound, handle, loop, id, reverb))
+   if(addsfx(sound, handle, loop, id, reverb, vol, sep, pitch))
    {
-      updateSoundParams(handle, vol, sep, pitch);
-      ++id; // increment id to keep each sound instance unique
+      if(!++id) // increment id to keep each sound instance unique
+         id = 1; // 0 means no sound
    }
    else
       handle = -1;
@@ -723,8 +1097,25 @@ static void I_SDLStopSound(int handle, int id)
       I_Error("I_SDLStopSound: handle out of range\n");
 #endif
    
-   if(channelinfo[handle].idnum == static_cast<unsigned int>(id))
-      channelinfo[handle].shouldstop = true;
+   channel_state_t &state = channelstate[handle];
+
+   if(state.idnum != static_cast<unsigned int>(id) || state.stopped)
+      return;
+
+   sndcmd_t cmd;
+
+   cmd.type    = SNDCMD_STOP;
+   cmd.channel = handle;
+   cmd.idnum   = state.idnum;
+
+   if(!I_SDLQueueCommand(cmd))
+   {
+      // the mixer applies these after the queue, which must hold the start
+      I_SDLFlushCommands();
+      channelstop[handle].store(state.idnum, std::memory_order_release);
+   }
+
+   state.stopped = true;
 }
 
 //
@@ -739,7 +1130,10 @@ static int I_SDLSoundIsPlaying(int handle)
       I_Error("I_SDLSoundIsPlaying: handle out of range\n");
 #endif
  
-   return !channelinfo[handle].shouldstop && channelinfo[handle].data;
+   const channel_state_t &state = channelstate[handle];
+
+   return state.idnum && !state.stopped &&
+          channeldone[handle].load(std::memory_order_acquire) != state.idnum;
 }
 
 //
@@ -757,7 +1151,7 @@ static int I_SDLSoundID(int handle)
       I_Error("I_SDLSoundID: handle out of range\n");
 #endif
 
-   return channelinfo[handle].idnum;
+   return channelstate[handle].idnum;
 }
 
 //
@@ -790,6 +1184,7 @@ static void I_SDLSubmitSound()
 //
 static void I_SDLShutdownSound()
 {
+   S_FinishSoundPrecache();
    Mix_CloseAudio();
 }
 
@@ -804,6 +1199,16 @@ static void I_SDLCacheSound(sfxinfo_t *sound)
    S_CacheDigitalSoundLump(sound);
 }
 
+//
+// I_SDLPrecacheSounds
+//
+// Convert a level's sounds to the mixer's format in the background.
+//
+static void I_SDLPrecacheSounds(sfxinfo_t *const *sounds, int count)
+{
+   S_PrecacheSounds(sounds, count);
+}
+
 static void I_SDLDummyCallback(void *, Uint8 *, int) {}
 
 bool I_GenSDLAudioSpec(int samplerate, SDL_AudioFormat fmt, int channels, int samples)
@@ -884,6 +1289,7 @@ i_sounddriver_t i_sdlsound_driver =
 {
    I_SDLInitSound,         // InitSound
    I_SDLCacheSound,        // CacheSound
+   I_SDLPrecacheSounds,    // PrecacheSounds
    I_SDLUpdateSound,       // UpdateSound
    I_SDLSubmitSound,       // SubmitSound
    I_SDLShutdownSound,     // ShutdownSound
@@ -892,8 +1298,38 @@ i_sounddriver_t i_sdlsound_driver =
    I_SDLStopSound,         // StopSound
    I_SDLSoundIsPlaying,    // SoundIsPlaying
    I_SDLUpdateSoundParams, // UpdateSoundParams
+   I_SDLUpdateSoundParamsBatch, // UpdateSoundParamsBatch
    I_SDLUpdateEQParams,    // UpdateEQParams
+   I_SDLHoldSoundCommands, // HoldSoundCommands
 };
 
+//
+// snd_mixstats
+//
+// Print how long the mixer callback takes relative to the audio it produces.
+// The peak is reset after each report.
+//
+CONSOLE_COMMAND(snd_mixstats, 0)
+{
+   const unsigned int buffer = mixbufferusec.load(std::memory_order_relaxed);
+   const unsigned int avg    = mixavgusec.load(std::memory_order_relaxed);
+
+   if(!buffer)
+   {
+      C_Printf("The SDL sound mixer has not run\n");
+      return;
+   }
+
+   C_Printf("Mixed %d voices (%s interpolation)\n"
+            "last %u us, avg %u us, peak %u us per %u us buffer (%.1f%% CPU)\n",
+            mixvoices.load(std::memory_order_relaxed),
+            s_interpolation ? "linear" : "no",
+            mixlastusec.load(std::memory_order_relaxed), avg,
+            mixmaxusec.load(std::memory_order_relaxed), buffer,
+            100.0 * avg / buffer);
+
+   mixmaxusec.store(0, std::memory_order_relaxed);
+}
+
 // EOF
 
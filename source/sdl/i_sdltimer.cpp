@@ -84,6 +84,21 @@ static unsigned int I_SDLGetTicks()
    return SDL_GetTicks();
 }
 
+//
+// I_SDLGetMicros
+//
+// Time in microseconds from the performance counter, for pacing frames
+// closer than the millisecond tick count allows.
+//
+static uint64_t I_SDLGetMicros()
+{
+   static const Uint64 frequency = SDL_GetPerformanceFrequency();
+   const Uint64 counter = SDL_GetPerformanceCounter();
+
+   // split to keep counter * 1000000 from overflowing
+   return counter / frequency * 1000000 + counter % frequency * 1000000 / frequency;
+}
+
 //
 // I_SDLSleep
 //
@@ -198,6 +213,7 @@ void I_SDLInitTimer()
    // initialize constant methods
    i_haltimer.GetRealTime  = I_SDLGetTime_RealTime;
    i_haltimer.GetTicks     = I_SDLGetTicks;
+   i_haltimer.GetMicros    = I_SDLGetMicros;
    i_haltimer.Sleep        = I_SDLSleep;
    i_haltimer.StartDisplay = I_SDLStartDisplay;
    i_haltimer.EndDisplay   = I_SDLEndDisplay;
@@ -34,6 +34,7 @@
 #include "../m_argv.h"
 #include "../m_misc.h"
 #include "../m_vector.h"
+#include "../r_draw32.h"
 #include "../v_misc.h"
 #include "../v_video.h"
 #include "../version.h"
@@ -57,9 +58,9 @@ void UpdateFocus(SDL_Window *window);
 // Graphics Code
 //
 
-static SDL_Surface  *primary_surface;
-static SDL_Surface  *rgba_surface;
-static SDL_Texture  *sdltexture; // the texture to use for rendering
+static SDL_Surface     *primary_surface;
+static SDL_Texture     *sdltexture; // the texture to use for rendering, upright
+static SDL_PixelFormat *sdltextureformat;
 static SDL_Renderer *renderer;
 static SDL_Rect     *destrect;
 
@@ -72,6 +73,30 @@ extern bool noblit;
 static SDL_Color basepal[256], colors[256];
 static bool setpalette = false;
 
+// lookups for expanding frames into sdltexture
+static truecolorout_t truecolorout;
+static bool truecolorstale = true;
+
+//
+// Rebuilds the output lookups for the current palette, gamma and texture
+// format.
+//
+static void I_SDLUpdateTrueColorOutput(const SDL_PixelFormat *format)
+{
+   byte palette[768];
+
+   for(int i = 0; i < 256; i++)
+   {
+      palette[i * 3    ] = basepal[i].r;
+      palette[i * 3 + 1] = basepal[i].g;
+      palette[i * 3 + 2] = basepal[i].b;
+   }
+
+   R_SetTrueColorOutput(truecolorout, palette, gammatable[usegamma],
+                        format->Rshift, format->Gshift, format->Bshift, format->Amask);
+   truecolorstale = false;
+}
+
 extern char *i_resolution;
 extern char *i_videomode;
 
@@ -99,16 +124,32 @@ void SDLVideoDriver::FinishUpdate()
       if(primary_surface)
          SDL_SetPaletteColors(primary_surface->format->palette, colors, 0, 256);
 
-      setpalette = false;
+      setpalette     = false;
+      truecolorstale = true;
    }
 
    // haleyjd 11/12/09: blit *after* palette set improves behavior.
    if(primary_surface)
    {
+      const bool withview = R_TrueColorFrame();
+      void *pixels;
+      int   pitch;
+
+      if(truecolorstale)
+         I_SDLUpdateTrueColorOutput(sdltextureformat);
+
+      // The screen is column-major; transpose and expand it straight into
+      // the texture in one pass instead of blitting to a 32-bit surface,
+      // uploading that, and having the renderer rotate it back.
       // Don't bother checking for errors. It should just cancel itself in that case.
-      SDL_BlitSurface(primary_surface, nullptr, rgba_surface, nullptr);
-      SDL_UpdateTexture(sdltexture, nullptr, rgba_surface->pixels, rgba_surface->pitch);
-      SDL_RenderCopyEx(renderer, sdltexture, nullptr, destrect, 90.0, nullptr, SDL_FLIP_VERTICAL);
+      if(!SDL_LockTexture(sdltexture, nullptr, &pixels, &pitch))
+      {
+         R_ComposeTrueColor(truecolorout, withview, static_cast<const byte *>(primary_surface->pixels),
+                            primary_surface->pitch, static_cast<uint32_t *>(pixels), pitch / 4,
+                            primary_surface->h, primary_surface->w);
+         SDL_UnlockTexture(sdltexture);
+      }
+      SDL_RenderCopy(renderer, sdltexture, nullptr, destrect);
    }
 
    // haleyjd 11/12/09: ALWAYS update. Causes problems with some video surface
@@ -192,10 +233,10 @@ void SDLVideoDriver::UnsetPrimaryBuffer()
       SDL_DestroyTexture(sdltexture);
       sdltexture = nullptr;
    }
-   if(rgba_surface)
+   if(sdltextureformat)
    {
-      SDL_FreeSurface(rgba_surface);
-      rgba_surface = nullptr;
+      SDL_FreeFormat(sdltextureformat);
+      sdltextureformat = nullptr;
    }
    if(primary_surface)
    {
@@ -223,20 +264,22 @@ void SDLVideoDriver::SetPrimaryBuffer()
       if(!primary_surface)
          I_Error("SDLVideoDriver::SetPrimaryBuffer: failed to create screen temp buffer\n");
 
+      // Frames are expanded to 32-bit pixels, so use the window's format only
+      // if it is one
       Uint32 pixelformat = SDL_GetWindowPixelFormat(window);
-      if(pixelformat == SDL_PIXELFORMAT_UNKNOWN)
+      if(pixelformat == SDL_PIXELFORMAT_UNKNOWN || SDL_ISPIXELFORMAT_INDEXED(pixelformat) ||
+         SDL_BYTESPERPIXEL(pixelformat) != 4)
          pixelformat = SDL_PIXELFORMAT_RGBA32;
 
-      rgba_surface = SDL_CreateRGBSurfaceWithFormat(0, video.height, video.width + bump,
-                                                    0, pixelformat);
-      if(!rgba_surface)
+      sdltextureformat = SDL_AllocFormat(pixelformat);
+      if(!sdltextureformat)
       {
-         I_Error("SDLVideoDriver::SetPrimaryBuffer: failed to create true-colour buffer: %s\n",
+         I_Error("SDLVideoDriver::SetPrimaryBuffer: failed to create true-colour format: %s\n",
                  SDL_GetError());
       }
       sdltexture = SDL_CreateTexture(renderer, pixelformat,
                                      SDL_TEXTUREACCESS_STREAMING,
-                                     video.height, video.width + bump);
+                                     video.width + bump, video.height);
       if(!sdltexture)
       {
          I_Error("SDLVideoDriver::SetPrimaryBuffer: failed to create rendering texture: %s\n",
@@ -245,6 +288,7 @@ void SDLVideoDriver::SetPrimaryBuffer()
 
       video.screens[0] = static_cast<byte *>(primary_surface->pixels);
       video.pitch = primary_surface->pitch;
+      truecolorstale = true;
    }
 }
 
@@ -487,6 +531,14 @@ bool SDLVideoDriver::InitGraphicsMode()
       staticDestRect.w = int(floor(staticDestRect.w * scale));
       staticDestRect.h = int(floor(staticDestRect.h * scale));
    }
+   // The rectangle above is for a copy rotated about its center; the texture
+   // is upright, so turn it around
+   const SDL_Rect rotated = staticDestRect;
+   staticDestRect.x = rotated.x + (rotated.w - rotated.h) / 2;
+   staticDestRect.y = rotated.y + (rotated.h - rotated.w) / 2;
+   staticDestRect.w = rotated.h;
+   staticDestRect.h = rotated.w;
+
    video.bitdepth  = 8;
    video.pixelsize = 1;
 
@@ -36,6 +36,7 @@
 #include "../m_misc.h"
 #include "../mn_engin.h"
 #include "../s_sound.h"
+#include "../w_wad.h"
 
 #ifdef HAVE_ADLMIDILIB
 #include "adlmidi.h"
@@ -60,6 +61,8 @@ double  s_lowgain;   // low band gain
 double  s_midgain;   // mid band gain
 double  s_highgain;  // high band gain
 
+int     s_interpolation = 1; // sound effect resampling
+
 bool    s_reverbactive; // reverberation effects processing is active
 
 // haleyjd 11/07/08: driver objects
@@ -82,6 +85,41 @@ void I_UpdateSoundParams(int handle, int vol, int sep, int pitch)
       i_sounddriver->UpdateSoundParams(handle, vol, sep, pitch);
 }
 
+//
+// I_UpdateSoundParamsBatch
+//
+// Update the parameters of several channels in one go, for drivers that can
+// hand them over more cheaply together.
+//
+void I_UpdateSoundParamsBatch(const sndupdate_t *updates, int count)
+{
+   if(!snd_init)
+      return;
+
+   if(i_sounddriver->UpdateSoundParamsBatch)
+      i_sounddriver->UpdateSoundParamsBatch(updates, count);
+   else
+   {
+      for(int i = 0; i < count; i++)
+      {
+         const sndupdate_t &u = updates[i];
+         i_sounddriver->UpdateSoundParams(u.handle, u.vol, u.sep, u.pitch);
+      }
+   }
+}
+
+//
+// I_HoldSoundCommands
+//
+// Lets a run of sound starts reach the mixer in the same callback, for drivers
+// that queue their commands.
+//
+void I_HoldSoundCommands(bool hold)
+{
+   if(snd_init && i_sounddriver->HoldSoundCommands)
+      i_sounddriver->HoldSoundCommands(hold);
+}
+
 //
 // I_SetSfxVolume
 //
@@ -203,6 +241,19 @@ void I_CacheSound(sfxinfo_t *sound)
       i_sounddriver->CacheSound(sound);
 }
 
+//
+// I_PrecacheSounds
+//
+// Lets the driver prepare a list of sounds before they are first played, if
+// it has any use for that. Aliases, links, and random sounds must already be
+// resolved.
+//
+void I_PrecacheSounds(sfxinfo_t *const *sounds, int count)
+{
+   if(snd_init && i_sounddriver->PrecacheSounds)
+      i_sounddriver->PrecacheSounds(sounds, count);
+}
+
 // haleyjd 11/07/08: sound driver objects
 
 #ifdef _SDL_VER
@@ -373,6 +424,20 @@ int I_RegisterSong(void *data, int size)
    return mus_init ? i_musicdriver->RegisterSong(data, size) : 0;
 }
 
+//
+// I_RegisterSongStream
+//
+int I_RegisterSongStream(WadLumpStream *stream)
+{
+   if(!mus_init || !i_musicdriver->RegisterSongStream)
+   {
+      delete stream;
+      return 0;
+   }
+
+   return i_musicdriver->RegisterSongStream(stream);
+}
+
 //
 // I_QrySongPlaying
 //
@@ -413,9 +478,11 @@ extern int midi_device;
 extern int adlmidi_numchips;
 extern int adlmidi_bank;
 extern int adlmidi_emulator;
+extern int adlmidi_threads;
 
 VARIABLE_INT(midi_device, nullptr, -1, 0, mididevicestr);
-VARIABLE_INT(adlmidi_numchips, nullptr, 1, 8, nullptr);
+VARIABLE_INT(adlmidi_numchips, nullptr, 1, 16, nullptr);
+VARIABLE_INT(adlmidi_threads, nullptr, 1, 8, nullptr);
 VARIABLE_INT(adlmidi_bank, nullptr, 0, BANKS_MAX, adlbankstr);
 VARIABLE_INT(adlmidi_emulator, nullptr, 0, ADLMIDI_EMU_end - 1, adlemustr);
 #endif
@@ -429,6 +496,10 @@ VARIABLE_FLOAT(s_lowgain,  nullptr, 0.0, 3.0);
 VARIABLE_FLOAT(s_midgain,  nullptr, 0.0, 3.0);
 VARIABLE_FLOAT(s_highgain, nullptr, 0.0, 3.0);
 
+static const char *interpolationstr[] = { "none", "linear" };
+
+VARIABLE_INT(s_interpolation, nullptr, 0, 1, interpolationstr);
+
 CONSOLE_VARIABLE(snd_card, snd_card, 0) 
 {
    if(snd_card != 0 && menuactive)
@@ -461,6 +532,7 @@ CONSOLE_VARIABLE(snd_spcbassboost, spc_bass_boost, 0)
 #ifdef HAVE_ADLMIDILIB
 CONSOLE_VARIABLE(snd_mididevice, midi_device, 0) {}
 CONSOLE_VARIABLE(snd_numchips, adlmidi_numchips, 0) {}
+CONSOLE_VARIABLE(snd_oplthreads, adlmidi_threads, 0) {}
 CONSOLE_VARIABLE(snd_bank, adlmidi_bank, 0) {}
 CONSOLE_VARIABLE(snd_oplemulator, adlmidi_emulator, 0) {}
 #endif
@@ -485,6 +557,8 @@ CONSOLE_VARIABLE(s_lowgain,   s_lowgain,   0) { I_UpdateEQ(); }
 CONSOLE_VARIABLE(s_midgain,   s_midgain,   0) { I_UpdateEQ(); }
 CONSOLE_VARIABLE(s_highgain,  s_highgain,  0) { I_UpdateEQ(); }
 
+CONSOLE_VARIABLE(s_interpolation, s_interpolation, 0) {}
+
 //----------------------------------------------------------------------------
 //
 // $Log: i_sound.c,v $
@@ -51,6 +51,7 @@
 #include "st_lib.h"
 #include "st_stuff.h"
 #include "v_misc.h"
+#include "v_patch.h"
 #include "v_patchfmt.h"
 #include "v_video.h"
 #include "w_wad.h"
@@ -217,6 +218,12 @@ stbarfns_t DoomStatusBar =
 // haleyjd 04/16/11: no more status bar caching
 //static bool st_firsttime;
 
+// The status bar as last drawn, copied back while nothing on it changes
+static vpatchrecord_t st_barrecord;
+static byte          *st_barpixels;
+static size_t         st_barpixelsize;
+static bool           st_barvalid;
+
 // lump number for PLAYPAL
 static int lu_palette;
 
@@ -1033,6 +1040,44 @@ static void ST_moveWidgets(bool fs)
    }
 }
 
+//
+// Keeps a copy of the screen under the freshly drawn status bar.
+//
+static void ST_saveBar(const vpatchrecord_t &record)
+{
+   st_barvalid = false;
+   if(record.x1 > record.x2 || record.y1 > record.y2 ||
+      record.x2 >= vbscreen.width || record.y2 >= vbscreen.height)
+      return;
+
+   const size_t height = size_t(record.y2 - record.y1 + 1);
+   const size_t size   = size_t(record.x2 - record.x1 + 1) * height;
+   if(size > st_barpixelsize)
+   {
+      st_barpixels    = erealloc(byte *, st_barpixels, size);
+      st_barpixelsize = size;
+   }
+
+   byte *dest = st_barpixels;
+   for(int x = record.x1; x <= record.x2; x++, dest += height)
+      memcpy(dest, VBADDRESS(&vbscreen, x, record.y1), height);
+
+   st_barrecord = record;
+   st_barvalid  = true;
+}
+
+//
+// Puts the saved status bar back on the screen.
+//
+static void ST_restoreBar()
+{
+   const size_t height = size_t(st_barrecord.y2 - st_barrecord.y1 + 1);
+
+   const byte *src = st_barpixels;
+   for(int x = st_barrecord.x1; x <= st_barrecord.x2; x++, src += height)
+      memcpy(VBADDRESS(&vbscreen, x, st_barrecord.y1), src, height);
+}
+
 //
 // ST_DoomDrawer
 //
@@ -1043,7 +1088,22 @@ static void ST_DoomDrawer()
    // possibly update widget positions
    ST_moveWidgets(false);
 
-   ST_doRefresh();     // If just after ST_Start(), refresh all
+   // Find out what the bar would draw first; if all of it is the same as last
+   // time, copy the result back rather than drawing every patch again.
+   V_BeginPatchRecord();
+   ST_doRefresh();
+   const vpatchrecord_t record = V_EndPatchRecord();
+
+   if(st_barvalid && record.hash == st_barrecord.hash &&
+      record.x1 == st_barrecord.x1 && record.x2 == st_barrecord.x2 &&
+      record.y1 == st_barrecord.y1 && record.y2 == st_barrecord.y2)
+   {
+      ST_restoreBar();
+      return;
+   }
+
+   ST_doRefresh();
+   ST_saveBar(record);
 }
 
 #define ST_ALPHA (st_fsalpha * FRACUNIT / 100)
@@ -31,6 +31,7 @@
 #include "i_system.h"
 
 #include "v_buffer.h"
+#include "v_font.h"
 #include "v_misc.h"
 #include "v_patch.h"
 #include "r_state.h"
@@ -278,6 +279,10 @@ void V_UnsetScaling(VBuffer *buffer)
 
    buffer->scaled = false;
    buffer->unscaledw = buffer->unscaledh = 0;
+
+   // expansions made for the old scaling are no longer valid
+   V_FlushPatchCache();
+   V_FlushFontCache();
    buffer->ixscale = buffer->iyscale = 0;
 
    if(buffer->freelookups)
@@ -374,6 +379,8 @@ void V_SetScaling(VBuffer *buffer, int unscaledw, int unscaledh)
    buffer->y2lookup[unscaledh - 1] = buffer->height - 1;
    buffer->y1lookup[unscaledh] = buffer->y2lookup[unscaledh] = buffer->height;
 
+   V_FlushPatchCache();
+   V_FlushFontCache();
    V_SetupBufferFuncs(buffer, DRAWTYPE_GENSCALED);
 }
 
@@ -38,8 +38,10 @@
 #include "m_qstr.h"
 #include "m_swap.h"
 #include "r_patch.h"
+#include "v_alloc.h"
 #include "v_font.h"
 #include "v_misc.h"
+#include "v_patch.h"
 #include "v_patchfmt.h"
 #include "w_wad.h"
 
@@ -95,7 +97,7 @@ static int V_FontLineWidth(vfont_t *font, const unsigned char *s)
 }
 
 //
-// V_FontWriteTextEx
+// V_fontDrawText
 //
 // Generalized bitmapped font drawing code. A vfont_t object contains
 // all the information necessary to format the text. Support for
@@ -104,7 +106,7 @@ static int V_FontLineWidth(vfont_t *font, const unsigned char *s)
 // fonts which center their characters within uniformly spaced blocks
 // have been added or absorbed from other code.
 //
-void V_FontWriteTextEx(const vtextdraw_t &textdraw)
+static void V_fontDrawText(const vtextdraw_t &textdraw)
 {
    patch_t *patch = nullptr;   // patch for current character -OR-
    const byte *src   = nullptr;   // source char for linear font
@@ -272,6 +274,228 @@ void V_FontWriteTextEx(const vtextdraw_t &textdraw)
    }   
 }
 
+//=============================================================================
+//
+// Text run cache
+//
+// The console, HUD messages and status widgets draw the same strings at the
+// same places every frame. A string drawn a second time is captured as the
+// screen runs its glyphs wrote, and copied from then on without parsing,
+// measuring or drawing any glyph. Only opaque text can be kept this way, and
+// linear fonts, which are drawn as blocks, are left alone. Like the patch
+// cache, runs only hold for one buffer at one scaling, so they are keyed by
+// position and thrown away when a font or the video mode changes.
+//
+
+struct vtextrun_t
+{
+   vtextrun_t *next;
+
+   uint32_t       hash;   // of the text and everything below
+   char          *text;
+   const vfont_t *font;
+   const VBuffer *screen;
+   const byte    *data;   // screen's pixels, in case the buffer is reused
+   int            x, y;
+   unsigned int   flags;
+   int            fixedColNum;
+   const char    *altMap;
+
+   int          uses;   // times drawn, captured on the second
+   bool         built;
+   bool         uncacheable;
+   vpatchrun_t *runs;
+   int          numruns;
+   byte        *pixels;
+   size_t       bytes;
+};
+
+static constexpr int    NUMTEXTRUNCHAINS   = 257;
+static constexpr int    TEXTRUN_MAXENTRIES = 1024;
+static constexpr size_t TEXTRUN_MAXBYTES   = size_t(8) << 20;
+
+static vtextrun_t *textrunchains[NUMTEXTRUNCHAINS];
+static int         textrunentries;
+static size_t      textrunbytes;
+
+//
+// Frees every text run except keep, if given.
+//
+static void V_flushTextRuns(vtextrun_t *keep)
+{
+   for(vtextrun_t *&chain : textrunchains)
+   {
+      vtextrun_t *kept = nullptr;
+      while(chain)
+      {
+         vtextrun_t *next = chain->next;
+         if(chain == keep)
+         {
+            kept = chain;
+            kept->next = nullptr;
+         }
+         else
+         {
+            if(chain->runs)
+               efree(chain->runs);
+            efree(chain->text);
+            efree(chain);
+         }
+         chain = next;
+      }
+      chain = kept;
+   }
+   textrunentries = keep ? 1 : 0;
+   textrunbytes   = keep ? keep->bytes : 0;
+}
+
+//
+// Frees every cached text run. Called whenever a font or a buffer's scaling
+// changes.
+//
+void V_FlushFontCache()
+{
+   V_flushTextRuns(nullptr);
+}
+
+// a new video mode may put the screen's pixels anywhere
+VALLOCATION(textrunchains)
+{
+   V_FlushFontCache();
+}
+
+//
+// Finds the cache entry for a string drawn at this place, creating it if
+// need be.
+//
+static vtextrun_t *V_findTextRun(const vtextdraw_t &textdraw, const VBuffer *screen)
+{
+   const unsigned int flags = textdraw.flags;
+   const int fixedColNum    = (flags & VTXT_FIXEDCOLOR) ? textdraw.fixedColNum : 0;
+
+   uint32_t hash = 2166136261u;
+   for(const unsigned char *ch = (const unsigned char *)textdraw.s; *ch; ch++)
+      hash = (hash ^ *ch) * 16777619u;
+
+   const uintptr_t fields[] =
+   {
+      reinterpret_cast<uintptr_t>(textdraw.font), reinterpret_cast<uintptr_t>(screen),
+      reinterpret_cast<uintptr_t>(screen->data), reinterpret_cast<uintptr_t>(textdraw.altMap),
+      uintptr_t(textdraw.x), uintptr_t(textdraw.y), uintptr_t(flags), uintptr_t(fixedColNum),
+   };
+   const byte *data = reinterpret_cast<const byte *>(fields);
+   for(size_t i = 0; i < sizeof(fields); i++)
+      hash = (hash ^ data[i]) * 16777619u;
+
+   vtextrun_t *&chain = textrunchains[hash % NUMTEXTRUNCHAINS];
+
+   for(vtextrun_t *tr = chain; tr; tr = tr->next)
+   {
+      if(tr->hash != hash || tr->font != textdraw.font || tr->screen != screen ||
+         tr->data != screen->data || tr->x != textdraw.x || tr->y != textdraw.y ||
+         tr->flags != flags || tr->fixedColNum != fixedColNum ||
+         tr->altMap != textdraw.altMap || strcmp(tr->text, textdraw.s))
+         continue;
+
+      if(tr->uses < 2)
+         ++tr->uses;
+      return tr;
+   }
+
+   if(textrunentries >= TEXTRUN_MAXENTRIES)
+      V_FlushFontCache();
+
+   vtextrun_t *tr = estructalloc(vtextrun_t, 1);
+   tr->hash        = hash;
+   tr->text        = estrdup(textdraw.s);
+   tr->font        = textdraw.font;
+   tr->screen      = screen;
+   tr->data        = screen->data;
+   tr->x           = textdraw.x;
+   tr->y           = textdraw.y;
+   tr->flags       = flags;
+   tr->fixedColNum = fixedColNum;
+   tr->altMap      = textdraw.altMap;
+   tr->uses        = 1;
+   tr->next        = chain;
+   chain           = tr;
+   ++textrunentries;
+
+   return tr;
+}
+
+//
+// Keeps a capture in the entry, making room if need be. Text that wasn't all
+// opaque, or is too big for the whole cache, is marked so it never tries
+// again.
+//
+static void V_finishTextRun(vtextrun_t *tr, const vpatchcapture_t &capture)
+{
+   const size_t runbytes = capture.numruns * sizeof(vpatchrun_t);
+   const size_t bytes    = runbytes + capture.numpixels;
+
+   if(!capture.complete || bytes > TEXTRUN_MAXBYTES)
+   {
+      tr->uncacheable = true;
+      return;
+   }
+   if(textrunbytes + bytes > TEXTRUN_MAXBYTES)
+      V_flushTextRuns(tr);
+
+   byte *block = emalloc(byte *, bytes ? bytes : 1);
+   if(runbytes)
+      memcpy(block, capture.runs, runbytes);
+   if(capture.numpixels)
+      memcpy(block + runbytes, capture.pixels, capture.numpixels);
+
+   tr->runs    = reinterpret_cast<vpatchrun_t *>(block);
+   tr->numruns = capture.numruns;
+   tr->pixels  = block + runbytes;
+   tr->bytes   = bytes;
+   tr->built   = true;
+   textrunbytes += bytes;
+}
+
+//
+// V_FontWriteTextEx
+//
+// Draws text through the text run cache where it can be.
+//
+void V_FontWriteTextEx(const vtextdraw_t &textdraw)
+{
+   VBuffer *screen = textdraw.screen ? textdraw.screen : &vbscreen;
+
+   if(textdraw.font->linear || screen->pixelsize != 1 || !*textdraw.s ||
+      V_PatchDrawingHeld())
+   {
+      V_fontDrawText(textdraw);
+      return;
+   }
+
+   vtextrun_t *tr = V_findTextRun(textdraw, screen);
+   if(!tr->built && (tr->uses < 2 || tr->uncacheable))
+   {
+      V_fontDrawText(textdraw);
+      return;
+   }
+
+   if(!tr->built)
+   {
+      V_BeginPatchCapture();
+      V_fontDrawText(textdraw);
+      V_finishTextRun(tr, V_EndPatchCapture());
+
+      if(!tr->built)
+      {
+         // some of it wasn't opaque; draw it for real this once
+         V_fontDrawText(textdraw);
+         return;
+      }
+   }
+
+   V_DrawPatchRuns(screen, tr->runs, tr->numruns, tr->pixels);
+}
+
 //
 // V_FontWriteText
 //
@@ -131,6 +131,7 @@ struct vtextdraw_t
    unsigned int flags;
 };
 
+void    V_FlushFontCache();
 void    V_FontWriteTextEx(const vtextdraw_t &textdraw);
 void    V_FontWriteText(vfont_t *font, const char *s, int x, int y, VBuffer *screen = nullptr);
 void    V_FontWriteTextColored(vfont_t *font, const char *s, int color, int x, int y,
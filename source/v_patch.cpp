@@ -28,7 +28,9 @@
 
 #include "c_io.h"
 #include "m_collection.h"
+#include "m_compare.h"
 #include "m_swap.h"
+#include "r_drawt.h"
 #include "r_patch.h"
 #include "v_block.h"
 #include "v_misc.h"
@@ -40,354 +42,67 @@
 
 
 //
-// Draws a plain patch column with no remappings.
+// Patch column drawers are generated from V_drawPatchColumn_8 below, from a
+// source policy and a blend policy. The DosDoom/zdoom-style translucency
+// lookups must be set before getting to a translucent one.
 //
-static void V_drawPatchColumn(const cb_patch_column_t &patchcol)
-{ 
-   int      count;
-   byte    *dest;    // killough
-   fixed_t  frac;    // killough
-   fixed_t  fracstep;
-   
-   if((count = patchcol.y2 - patchcol.y1 + 1) <= 0)
-      return; // Zero length, column does not exceed a pixel.
-                                 
-#ifdef RANGECHECK 
-   if((unsigned int)patchcol.x  >= (unsigned int)patchcol.buffer->width || 
-      (unsigned int)patchcol.y1 >= (unsigned int)patchcol.buffer->height) 
-      I_Error("V_drawPatchColumn: %i to %i at %i\n", patchcol.y1, patchcol.y2, patchcol.x); 
-#endif 
-
-   dest = VBADDRESS(patchcol.buffer, patchcol.x, patchcol.y1);
-
-   // Determine scaling, which is the only mapping to be done.
-   fracstep = patchcol.step;
-   frac = patchcol.frac + ((patchcol.y1 * fracstep) & 0xFFFF);
-
-   // Inner loop that does the actual texture mapping,
-   //  e.g. a DDA-lile scaling.
-   // This is as fast as it gets.       (Yeah, right!!! -- killough)
-   //
-   // killough 2/1/98: more performance tuning
-   // haleyjd 06/21/06: rewrote and specialized for screen patches
-
-   {
-      const byte *source = patchcol.source;
-            
-      while((count -= 2) >= 0)
-      {
-         *dest = source[frac >> FRACBITS];
-         dest += 1;
-         frac += fracstep;
-         *dest = source[frac >> FRACBITS];
-         dest += 1;
-         frac += fracstep;
-      }
-      if(count & 1)
-         *dest = source[frac >> FRACBITS];
-   }
-} 
-
-//
-// Draws a plain patch column with color translation.
-//
-static void V_drawPatchColumnTR(const cb_patch_column_t &patchcol)
-{ 
-   int      count;
-   byte    *dest;    // killough
-   fixed_t  frac;    // killough
-   fixed_t  fracstep;
-   
-   if((count = patchcol.y2 - patchcol.y1 + 1) <= 0)
-      return; // Zero length, column does not exceed a pixel.
-                                 
-#ifdef RANGECHECK 
-   if((unsigned int)patchcol.x  >= (unsigned int)patchcol.buffer->width || 
-      (unsigned int)patchcol.y1 >= (unsigned int)patchcol.buffer->height) 
-      I_Error("V_drawPatchColumnTR: %i to %i at %i\n", patchcol.y1, patchcol.y2, patchcol.x); 
-#endif 
-
-   dest = VBADDRESS(patchcol.buffer, patchcol.x, patchcol.y1);
 
-   // Determine scaling, which is the only mapping to be done.
-   fracstep = patchcol.step;
-   frac = patchcol.frac + ((patchcol.y1 * fracstep) & 0xFFFF);
+// Source policies
 
-   // Inner loop that does the actual texture mapping,
-   //  e.g. a DDA-lile scaling.
-   // This is as fast as it gets.       (Yeah, right!!! -- killough)
-   //
-   // killough 2/1/98: more performance tuning
-   // haleyjd 06/21/06: rewrote and specialized for screen patches
-
-   {
-      const byte *source = patchcol.source;
-            
-      while((count -= 2) >= 0)
-      {
-         *dest = patchcol.translation[source[frac >> FRACBITS]];
-         dest += 1;
-         frac += fracstep;
-         *dest = patchcol.translation[source[frac >> FRACBITS]];
-         dest += 1;
-         frac += fracstep;
-      }
-      if(count & 1)
-         *dest = patchcol.translation[source[frac >> FRACBITS]];
-   }
-} 
-
-//
-// Draws a plain patch column with color translation and light remapping
-//
-static void V_drawPatchColumnTRLit(const cb_patch_column_t &patchcol)
-{ 
-   int      count;
-   byte    *dest;    // killough
-   fixed_t  frac;    // killough
-   fixed_t  fracstep;
-   
-   if((count = patchcol.y2 - patchcol.y1 + 1) <= 0)
-      return; // Zero length, column does not exceed a pixel.
-                                 
-#ifdef RANGECHECK 
-   if((unsigned int)patchcol.x  >= (unsigned int)patchcol.buffer->width || 
-      (unsigned int)patchcol.y1 >= (unsigned int)patchcol.buffer->height) 
-      I_Error("V_drawPatchColumnTR: %i to %i at %i\n", patchcol.y1, patchcol.y2, patchcol.x); 
-#endif 
-
-   dest = VBADDRESS(patchcol.buffer, patchcol.x, patchcol.y1);
-
-   // Determine scaling, which is the only mapping to be done.
-   fracstep = patchcol.step;
-   frac = patchcol.frac + ((patchcol.y1 * fracstep) & 0xFFFF);
-
-   // Inner loop that does the actual texture mapping,
-   //  e.g. a DDA-lile scaling.
-   // This is as fast as it gets.       (Yeah, right!!! -- killough)
-   //
-   // killough 2/1/98: more performance tuning
-   // haleyjd 06/21/06: rewrote and specialized for screen patches
+// Plain: no remappings
+struct patchsourceplain
+{
+   static remapnone Make(const cb_patch_column_t &) { return remapnone(); }
+};
 
+// Color translation
+struct patchsourcetranslated
+{
+   static remapone Make(const cb_patch_column_t &patchcol)
    {
-      const byte *source = patchcol.source;
-            
-      while((count -= 2) >= 0)
-      {
-         *dest = patchcol.light[patchcol.translation[source[frac >> FRACBITS]]];
-         dest += 1;
-         frac += fracstep;
-         *dest = patchcol.light[patchcol.translation[source[frac >> FRACBITS]]];
-         dest += 1;
-         frac += fracstep;
-      }
-      if(count & 1)
-         *dest = patchcol.light[patchcol.translation[source[frac >> FRACBITS]]];
+      return remapone(patchcol.translation);
    }
-} 
-
-
-#define DO_COLOR_BLEND()                       \
-   fg = patchcol.fg2rgb[source[frac >> FRACBITS]];    \
-   bg = patchcol.bg2rgb[*dest];                       \
-   fg = (fg + bg) | 0x1f07c1f;                 \
-   *dest = RGB32k[0][0][fg & (fg >> 15)]
-
-//
-// Draws a translucent patch column. The DosDoom/zdoom-style
-// translucency lookups must be set before getting here.
-//
-void V_drawPatchColumnTL(const cb_patch_column_t &patchcol)
-{ 
-   int      count; 
-   byte    *dest;           // killough
-   fixed_t  frac;           // killough
-   fixed_t  fracstep;
-   unsigned int fg, bg;
-   
-   if((count = patchcol.y2 - patchcol.y1 + 1) <= 0)
-      return; // Zero length, column does not exceed a pixel.
-                                 
-#ifdef RANGECHECK 
-   if((unsigned int)patchcol.x  >= (unsigned int)patchcol.buffer->width || 
-      (unsigned int)patchcol.y1 >= (unsigned int)patchcol.buffer->height) 
-      I_Error("V_drawPatchColumnTL: %i to %i at %i\n", patchcol.y1, patchcol.y2, patchcol.x); 
-#endif 
-
-   dest = VBADDRESS(patchcol.buffer, patchcol.x, patchcol.y1);
-
-   // Determine scaling, which is the only mapping to be done.
-   fracstep = patchcol.step;
-   frac = patchcol.frac + ((patchcol.y1 * fracstep) & 0xFFFF);
+};
 
-   // haleyjd 06/21/06: rewrote and specialized for screen patches
+// Color translation and light remapping
+struct patchsourcetranslatedlit
+{
+   static remaptwo Make(const cb_patch_column_t &patchcol)
    {
-      const byte *source = patchcol.source;
-            
-      while((count -= 2) >= 0)
-      {
-         DO_COLOR_BLEND();
-
-         dest += 1;
-         frac += fracstep;
-
-         DO_COLOR_BLEND();
-
-         dest += 1;
-         frac += fracstep;
-      }
-      if(count & 1)
-      {
-         DO_COLOR_BLEND();
-      }
+      return remaptwo(patchcol.translation, patchcol.light);
    }
-}
-
-#undef DO_COLOR_BLEND
-
-#define DO_COLOR_BLEND()          \
-   fg = patchcol.fg2rgb[patchcol.translation[source[frac >> FRACBITS]]]; \
-   bg = patchcol.bg2rgb[*dest];          \
-   fg = (fg + bg) | 0x1f07c1f;    \
-   *dest = RGB32k[0][0][fg & (fg >> 15)]
-
-//
-// Draws translated translucent patch columns.
-// Requires both translucency lookups and a translation table.
-//
-void V_drawPatchColumnTRTL(const cb_patch_column_t &patchcol)
-{ 
-   int      count; 
-   byte    *dest;           // killough
-   fixed_t  frac;           // killough
-   fixed_t  fracstep;
-   unsigned int fg, bg;
-   
-   if((count = patchcol.y2 - patchcol.y1 + 1) <= 0)
-      return; // Zero length, column does not exceed a pixel.
-                                 
-#ifdef RANGECHECK 
-   if((unsigned int)patchcol.x  >= (unsigned int)patchcol.buffer->width || 
-      (unsigned int)patchcol.y1 >= (unsigned int)patchcol.buffer->height) 
-      I_Error("V_drawPatchColumnTRTL: %i to %i at %i\n", patchcol.y1, patchcol.y2, patchcol.x); 
-#endif 
+};
 
-   dest = VBADDRESS(patchcol.buffer, patchcol.x, patchcol.y1);
+// Blend policies
 
-   // Determine scaling, which is the only mapping to be done.
-   fracstep = patchcol.step; 
-   frac = patchcol.frac + ((patchcol.y1 * fracstep) & 0xFFFF);
+struct patchblendopaque
+{
+   static blendopaque Make(const cb_patch_column_t &) { return blendopaque(); }
+};
 
-   // haleyjd 06/21/06: rewrote and specialized for screen patches
+struct patchblendtl
+{
+   static blendflex Make(const cb_patch_column_t &patchcol)
    {
-      const byte *source = patchcol.source;
-      
-      while((count -= 2) >= 0)
-      {
-         DO_COLOR_BLEND();
-
-         dest += 1;
-         frac += fracstep;
-
-         DO_COLOR_BLEND();
-
-         dest += 1;
-         frac += fracstep;
-      }
-      if(count & 1)
-      {
-         DO_COLOR_BLEND();
-      }
+      return blendflex(patchcol.fg2rgb, patchcol.bg2rgb);
    }
-}
-
-#undef DO_COLOR_BLEND
-
-#define DO_COLOR_BLEND() \
-   /* mask out LSBs in green and red to allow overflow */ \
-   a = patchcol.fg2rgb[source[frac >> FRACBITS]] + patchcol.bg2rgb[*dest]; \
-   b = a; \
-   a |= 0x01f07c1f; \
-   b &= 0x40100400; \
-   a &= 0x3fffffff; \
-   b  = b - (b >> 5); \
-   a |= b; \
-   *dest = RGB32k[0][0][a & (a >> 15)]
-
-
-//
-// Draws a patch column with additive translucency.
-//
-void V_drawPatchColumnAdd(const cb_patch_column_t &patchcol)
-{ 
-   int      count; 
-   byte    *dest;           // killough
-   fixed_t  frac;           // killough
-   fixed_t  fracstep;
-   unsigned int a, b;
-   
-   if((count = patchcol.y2 - patchcol.y1 + 1) <= 0)
-      return; // Zero length, column does not exceed a pixel.
-                                 
-#ifdef RANGECHECK 
-   if((unsigned int)patchcol.x  >= (unsigned int)patchcol.buffer->width || 
-      (unsigned int)patchcol.y1 >= (unsigned int)patchcol.buffer->height) 
-      I_Error("V_drawPatchColumnAdd: %i to %i at %i\n", patchcol.y1, patchcol.y2, patchcol.x); 
-#endif 
-
-   dest = VBADDRESS(patchcol.buffer, patchcol.x, patchcol.y1);
-
-   // Determine scaling, which is the only mapping to be done.
-   fracstep = patchcol.step; 
-   frac = patchcol.frac + ((patchcol.y1 * fracstep) & 0xFFFF);
+};
 
-   // haleyjd 06/21/06: rewrote and specialized for screen patches
+struct patchblendadd
+{
+   static blendadd Make(const cb_patch_column_t &patchcol)
    {
-      const byte *source = patchcol.source;
-      
-      while((count -= 2) >= 0)
-      {
-         DO_COLOR_BLEND();
-
-         dest += 1;
-         frac += fracstep;
-
-         DO_COLOR_BLEND();
-
-         dest += 1;
-         frac += fracstep;
-      }
-      if(count & 1)
-      {
-         DO_COLOR_BLEND();
-      }
+      return blendadd(patchcol.fg2rgb, patchcol.bg2rgb);
    }
-}
-
-#undef DO_COLOR_BLEND
-
-#define DO_COLOR_BLEND() \
-   /* mask out LSBs in green and red to allow overflow */ \
-   a = patchcol.fg2rgb[patchcol.translation[source[frac >> FRACBITS]]] + patchcol.bg2rgb[*dest]; \
-   b = a; \
-   a |= 0x01f07c1f; \
-   b &= 0x40100400; \
-   a &= 0x3fffffff; \
-   b  = b - (b >> 5); \
-   a |= b; \
-   *dest = RGB32k[0][0][a & (a >> 15)]
+};
 
-//
-// Draws a patch column with additive translucency and
-// translation.
-//
-void V_drawPatchColumnAddTR(const cb_patch_column_t &patchcol)
+template<typename S, typename B>
+static void V_drawPatchColumn_8(const cb_patch_column_t &patchcol)
 { 
-   int      count; 
-   byte    *dest;           // killough
-   fixed_t  frac;           // killough
+   int      count;
+   byte    *dest;    // killough
+   fixed_t  frac;    // killough
    fixed_t  fracstep;
-   unsigned int a, b;
    
    if((count = patchcol.y2 - patchcol.y1 + 1) <= 0)
       return; // Zero length, column does not exceed a pixel.
@@ -395,41 +110,20 @@ void V_drawPatchColumnAddTR(const cb_patch_column_t &patchcol)
 #ifdef RANGECHECK 
    if((unsigned int)patchcol.x  >= (unsigned int)patchcol.buffer->width || 
       (unsigned int)patchcol.y1 >= (unsigned int)patchcol.buffer->height) 
-      I_Error("V_drawPatchColumnAddTR: %i to %i at %i\n", patchcol.y1, patchcol.y2, patchcol.x); 
+      I_Error("V_drawPatchColumn_8: %i to %i at %i\n", patchcol.y1, patchcol.y2, patchcol.x); 
 #endif 
 
    dest = VBADDRESS(patchcol.buffer, patchcol.x, patchcol.y1);
 
    // Determine scaling, which is the only mapping to be done.
-   fracstep = patchcol.step; 
+   fracstep = patchcol.step;
    frac = patchcol.frac + ((patchcol.y1 * fracstep) & 0xFFFF);
 
    // haleyjd 06/21/06: rewrote and specialized for screen patches
-   {
-      const byte *source = patchcol.source;
-      
-      while((count -= 2) >= 0)
-      {
-         DO_COLOR_BLEND();
-
-         dest += 1;
-         frac += fracstep;
-         
-         DO_COLOR_BLEND();
-         
-         dest += 1;
-         frac += fracstep;
-      }
-      if(count & 1)
-      {
-         DO_COLOR_BLEND();
-      }
-   }
+   R_DrawColumnRun(dest, count, frac, fracstep, patchcol.source, wrapnone(),
+                   S::Make(patchcol), B::Make(patchcol));
 }
 
-#undef DO_COLOR_BLEND
-
-
 
 static void V_drawMaskedColumn(cb_patch_column_t &patchcol, const int ytop, column_t *column)
 {
@@ -513,15 +207,445 @@ typedef void (*patchcolfunc_t)(const cb_patch_column_t &);
 
 static patchcolfunc_t colfuncfordrawstyle[PSTYLE_NUMSTYLES] =
 {
-   V_drawPatchColumn,
-   V_drawPatchColumnTR,
-   V_drawPatchColumnTL,
-   V_drawPatchColumnTRTL,
-   V_drawPatchColumnAdd,
-   V_drawPatchColumnAddTR,
-   V_drawPatchColumnTRLit
+   V_drawPatchColumn_8<patchsourceplain,         patchblendopaque>, // PSTYLE_NORMAL
+   V_drawPatchColumn_8<patchsourcetranslated,    patchblendopaque>, // PSTYLE_TLATED
+   V_drawPatchColumn_8<patchsourceplain,         patchblendtl    >, // PSTYLE_TRANSLUC
+   V_drawPatchColumn_8<patchsourcetranslated,    patchblendtl    >, // PSTYLE_TLTRANSLUC
+   V_drawPatchColumn_8<patchsourceplain,         patchblendadd   >, // PSTYLE_ADD
+   V_drawPatchColumn_8<patchsourcetranslated,    patchblendadd   >, // PSTYLE_TLADD
+   V_drawPatchColumn_8<patchsourcetranslatedlit, patchblendopaque>, // PSTYLE_TLATEDLIT
+};
+
+//=============================================================================
+//
+// Pre-scaled patch cache
+//
+// Scaled patch drawing steps through the source for every screen pixel. A
+// patch drawn at the same place in the same buffer frame after frame, like
+// the status bar, HUD font glyphs and menu graphics, is instead expanded once
+// into the screen-space runs it covers and copied from then on. The buffer's
+// scaling lookups are not linear, so expansions are keyed by position as well
+// as by patch, and any change to a buffer's scaling throws them all away.
+//
+
+struct vpatchcache_t
+{
+   vpatchcache_t *next;
+
+   const patch_t *patch;
+   const VBuffer *buffer;
+   int            x, y;
+   bool           flipped;
+   uint32_t       fingerprint; // patch contents, as the lump may be purged
+
+   int          uses;   // times drawn, expanded on the second
+   bool         built;
+   bool         uncacheable;
+   vpatchrun_t *runs;
+   int          numruns;
+   byte        *pixels; // source indices, remapped and blended when copied
+   size_t       bytes;
 };
 
+static constexpr int    NUMPATCHCACHECHAINS = 257;
+static constexpr int    PATCHCACHE_MAXENTRIES = 4096;
+static constexpr size_t PATCHCACHE_MAXBYTES = size_t(32) << 20;
+
+static vpatchcache_t *patchcachechains[NUMPATCHCACHECHAINS];
+static int            patchcacheentries;
+static size_t         patchcachebytes;
+
+// Runs and pixels gathered while a patch is being expanded
+static PODCollection<vpatchrun_t> patchcaptureruns;
+static PODCollection<byte>        patchcapturepixels;
+
+//
+// Frees every cache entry except keep, if given.
+//
+static void V_flushPatchCache(vpatchcache_t *keep)
+{
+   for(vpatchcache_t *&chain : patchcachechains)
+   {
+      vpatchcache_t *kept = nullptr;
+      while(chain)
+      {
+         vpatchcache_t *next = chain->next;
+         if(chain == keep)
+         {
+            kept = chain;
+            kept->next = nullptr;
+         }
+         else
+         {
+            if(chain->runs)
+               efree(chain->runs);
+            efree(chain);
+         }
+         chain = next;
+      }
+      chain = kept;
+   }
+   patchcacheentries = keep ? 1 : 0;
+   patchcachebytes   = keep ? keep->bytes : 0;
+}
+
+//
+// Frees every expanded patch. Called whenever a buffer's scaling changes.
+//
+void V_FlushPatchCache()
+{
+   V_flushPatchCache(nullptr);
+}
+
+//
+// Hashes the patch's header, column offsets and posts, so that a different
+// patch later loaded at the same address is never drawn from another's
+// expansion. This reads only the unscaled source.
+//
+static uint32_t V_patchFingerprint(const patch_t *patch)
+{
+   uint32_t hash = 2166136261u;
+   auto mix = [&hash](const byte *data, size_t len) {
+      for(size_t i = 0; i < len; i++)
+         hash = (hash ^ data[i]) * 16777619u;
+   };
+
+   mix(reinterpret_cast<const byte *>(patch), 8 + sizeof(int32_t) * patch->width);
+   for(int i = 0; i < patch->width; i++)
+   {
+      const column_t *column =
+         reinterpret_cast<const column_t *>(reinterpret_cast<const byte *>(patch) +
+                                            patch->columnofs[i]);
+      for(; column->topdelta != 0xff;
+          column = reinterpret_cast<const column_t *>(reinterpret_cast<const byte *>(column) +
+                                                      column->length + 4))
+         mix(reinterpret_cast<const byte *>(column), column->length + 4);
+   }
+
+   return hash;
+}
+
+//
+// Finds the cache entry for a patch drawn at this place, creating it if need
+// be. Returns nullptr when the drawing should not be cached.
+//
+static vpatchcache_t *V_findCachedPatch(const PatchInfo *pi, const VBuffer *buffer)
+{
+   const uintptr_t key = (reinterpret_cast<uintptr_t>(pi->patch) >> 4) ^
+                         (reinterpret_cast<uintptr_t>(buffer) >> 4) ^
+                         uintptr_t(pi->x * 31) ^ uintptr_t(pi->y * 8191) ^ uintptr_t(pi->flipped);
+   vpatchcache_t *&chain = patchcachechains[key % NUMPATCHCACHECHAINS];
+   const uint32_t fingerprint = V_patchFingerprint(pi->patch);
+
+   for(vpatchcache_t *pc = chain; pc; pc = pc->next)
+   {
+      if(pc->patch != pi->patch || pc->buffer != buffer || pc->x != pi->x ||
+         pc->y != pi->y || pc->flipped != pi->flipped)
+         continue;
+
+      if(pc->fingerprint != fingerprint)
+      {
+         // the patch was replaced; start over with the new one
+         if(pc->runs)
+            efree(pc->runs);
+         patchcachebytes -= pc->bytes;
+         pc->fingerprint = fingerprint;
+         pc->uses        = 0;
+         pc->built       = false;
+         pc->uncacheable = false;
+         pc->runs        = nullptr;
+         pc->numruns     = 0;
+         pc->pixels      = nullptr;
+         pc->bytes       = 0;
+      }
+      if(pc->uses < 2)
+         ++pc->uses;
+      return pc;
+   }
+
+   if(patchcacheentries >= PATCHCACHE_MAXENTRIES)
+      V_FlushPatchCache();
+
+   vpatchcache_t *pc = estructalloc(vpatchcache_t, 1);
+   pc->patch       = pi->patch;
+   pc->buffer      = buffer;
+   pc->x           = pi->x;
+   pc->y           = pi->y;
+   pc->flipped     = pi->flipped;
+   pc->fingerprint = fingerprint;
+   pc->uses        = 1;
+   pc->next        = chain;
+   chain           = pc;
+   ++patchcacheentries;
+
+   return pc;
+}
+
+//
+// Column function used while expanding: records the run the column would
+// have drawn and the source index behind each of its pixels.
+//
+static void V_capturePatchColumn(const cb_patch_column_t &patchcol)
+{
+   const int count = patchcol.y2 - patchcol.y1 + 1;
+   if(count <= 0)
+      return;
+
+   vpatchrun_t &run = patchcaptureruns.addNew();
+   run.x      = patchcol.x;
+   run.y1     = patchcol.y1;
+   run.count  = count;
+   run.offset = patchcapturepixels.getLength();
+
+   patchcapturepixels.resize(run.offset + count);
+   byte *dest = patchcapturepixels.begin() + run.offset;
+
+   // same stepping as V_drawPatchColumn_8
+   const fixed_t fracstep = patchcol.step;
+   fixed_t       frac     = patchcol.frac + ((patchcol.y1 * fracstep) & 0xFFFF);
+   for(int i = 0; i < count; i++, frac += fracstep)
+      dest[i] = patchcol.source[frac >> FRACBITS];
+}
+
+//
+// Stores what V_capturePatchColumn gathered into the entry, making room if
+// need be. A patch too big for the whole cache is marked so it never tries
+// again.
+//
+static void V_finishCachedPatch(vpatchcache_t *pc)
+{
+   const size_t runbytes = patchcaptureruns.getLength() * sizeof(vpatchrun_t);
+   const size_t bytes    = runbytes + patchcapturepixels.getLength();
+
+   if(bytes > PATCHCACHE_MAXBYTES)
+   {
+      pc->uncacheable = true;
+      return;
+   }
+   if(patchcachebytes + bytes > PATCHCACHE_MAXBYTES)
+      V_flushPatchCache(pc);
+
+   byte *block = emalloc(byte *, bytes ? bytes : 1);
+   if(runbytes)
+      memcpy(block, patchcaptureruns.begin(), runbytes);
+   if(patchcapturepixels.getLength())
+      memcpy(block + runbytes, patchcapturepixels.begin(), patchcapturepixels.getLength());
+
+   pc->runs    = reinterpret_cast<vpatchrun_t *>(block);
+   pc->numruns = int(patchcaptureruns.getLength());
+   pc->pixels  = block + runbytes;
+   pc->bytes   = bytes;
+   pc->built   = true;
+   patchcachebytes += bytes;
+}
+
+//
+// Draws an expanded patch. Opaque untranslated runs are straight copies, as
+// screen columns are contiguous; other styles put the runs through their
+// usual column function at one source pixel per screen pixel.
+//
+static void V_drawCachedPatch(cb_patch_column_t &patchcol, const vpatchcache_t *pc,
+                              int drawstyle)
+{
+   const vpatchrun_t *run = pc->runs;
+   const vpatchrun_t *end = run + pc->numruns;
+
+   if(drawstyle == PSTYLE_NORMAL)
+   {
+      V_DrawPatchRuns(patchcol.buffer, pc->runs, pc->numruns, pc->pixels);
+      return;
+   }
+
+   patchcol.colfunc = colfuncfordrawstyle[drawstyle];
+   patchcol.frac    = 0;
+   patchcol.step    = FRACUNIT;
+   for(; run != end; ++run)
+   {
+      patchcol.x      = run->x;
+      patchcol.y1     = run->y1;
+      patchcol.y2     = run->y1 + run->count - 1;
+      patchcol.source = pc->pixels + run->offset;
+      patchcol.colfunc(patchcol);
+   }
+}
+
+//
+// Copies runs of finished pixels, in order, to the buffer they were taken from.
+//
+void V_DrawPatchRuns(VBuffer *buffer, const vpatchrun_t *runs, int numruns,
+                     const byte *pixels)
+{
+   for(const vpatchrun_t *run = runs, *end = runs + numruns; run != end; ++run)
+      memcpy(VBADDRESS(buffer, run->x, run->y1), pixels + run->offset, run->count);
+}
+
+//=============================================================================
+//
+// Patch capture
+//
+// While capturing, V_DrawPatchInt draws nothing; it keeps the runs it would
+// have written and their final pixels instead, which can be copied back with
+// V_DrawPatchRuns for as long as the buffer's scaling stays the same. Only
+// opaque drawings can be captured, as the rest depend on what is under them.
+//
+
+static bool                       patchcapturing;
+static bool                       patchcapturecomplete;
+static PODCollection<vpatchrun_t> patchcapturedruns;
+static PODCollection<byte>        patchcapturedpixels;
+
+//
+// Starts capturing. Until V_EndPatchCapture, patch drawing has no effect.
+//
+void V_BeginPatchCapture()
+{
+   patchcapturing       = true;
+   patchcapturecomplete = true;
+   patchcapturedruns.makeEmpty();
+   patchcapturedpixels.makeEmpty();
+}
+
+//
+// Stops capturing and returns what was captured. It stays valid until the
+// next capture begins.
+//
+vpatchcapture_t V_EndPatchCapture()
+{
+   vpatchcapture_t capture;
+
+   patchcapturing = false;
+
+   capture.runs      = patchcapturedruns.begin();
+   capture.numruns   = int(patchcapturedruns.getLength());
+   capture.pixels    = patchcapturedpixels.begin();
+   capture.numpixels = patchcapturedpixels.getLength();
+   capture.complete  = patchcapturecomplete;
+
+   return capture;
+}
+
+//
+// Column function used while capturing: keeps the run with its pixels as
+// the opaque drawer would have written them.
+//
+template<bool translated>
+static void V_captureFinalColumn(const cb_patch_column_t &patchcol)
+{
+   const int count = patchcol.y2 - patchcol.y1 + 1;
+   if(count <= 0)
+      return;
+
+   vpatchrun_t &run = patchcapturedruns.addNew();
+   run.x      = patchcol.x;
+   run.y1     = patchcol.y1;
+   run.count  = count;
+   run.offset = patchcapturedpixels.getLength();
+
+   patchcapturedpixels.resize(run.offset + count);
+   byte *dest = patchcapturedpixels.begin() + run.offset;
+
+   // same stepping as V_drawPatchColumn_8
+   const fixed_t fracstep = patchcol.step;
+   fixed_t       frac     = patchcol.frac + ((patchcol.y1 * fracstep) & 0xFFFF);
+   for(int i = 0; i < count; i++, frac += fracstep)
+   {
+      const byte src = patchcol.source[frac >> FRACBITS];
+      dest[i] = translated ? patchcol.translation[src] : src;
+   }
+}
+
+//=============================================================================
+//
+// Patch recording
+//
+// While recording, V_DrawPatchInt draws nothing; it hashes what it would
+// have drawn and grows a bounding box around it instead. Callers use this to
+// tell whether a group of patches would come out the same as last time.
+//
+
+static bool            patchrecording;
+static vpatchrecord_t  patchrecord;
+
+//
+// Starts recording. Until V_EndPatchRecord, patch drawing has no effect.
+//
+void V_BeginPatchRecord()
+{
+   patchrecording   = true;
+   patchrecord.hash = 2166136261u;
+   patchrecord.x1   = patchrecord.y1 = INT_MAX;
+   patchrecord.x2   = patchrecord.y2 = INT_MIN;
+}
+
+//
+// Stops recording and returns what was recorded. The box is in the
+// coordinates of the root buffer, and empty (x1 > x2) if nothing landed.
+//
+vpatchrecord_t V_EndPatchRecord()
+{
+   patchrecording = false;
+   return patchrecord;
+}
+
+//
+// True while patch drawing is being recorded or captured rather than drawn.
+//
+bool V_PatchDrawingHeld()
+{
+   return patchrecording || patchcapturing;
+}
+
+//
+// Adds one patch drawing to the record.
+//
+static void V_recordPatch(const cb_patch_column_t &patchcol, const PatchInfo *pi,
+                          const VBuffer *buffer)
+{
+   const patch_t *patch = pi->patch;
+   const uintptr_t fields[] =
+   {
+      reinterpret_cast<uintptr_t>(patch), V_patchFingerprint(patch),
+      reinterpret_cast<uintptr_t>(buffer), reinterpret_cast<uintptr_t>(buffer->data),
+      uintptr_t(buffer->width), uintptr_t(buffer->height),
+      uintptr_t(buffer->unscaledw), uintptr_t(buffer->unscaledh),
+      uintptr_t(pi->x), uintptr_t(pi->y), uintptr_t(pi->flipped), uintptr_t(pi->drawstyle),
+      reinterpret_cast<uintptr_t>(patchcol.translation), reinterpret_cast<uintptr_t>(patchcol.light),
+      reinterpret_cast<uintptr_t>(patchcol.fg2rgb), reinterpret_cast<uintptr_t>(patchcol.bg2rgb),
+   };
+   const byte *data = reinterpret_cast<const byte *>(fields);
+   for(size_t i = 0; i < sizeof(fields); i++)
+      patchrecord.hash = (patchrecord.hash ^ data[i]) * 16777619u;
+
+   // unscaled extent, then into buffer pixels
+   int x1 = pi->flipped ? pi->x + patch->leftoffset - (patch->width - 1)
+                        : pi->x - patch->leftoffset;
+   int x2 = x1 + patch->width - 1;
+   int y1 = pi->y - patch->topoffset;
+   int y2 = y1 + patch->height - 1;
+
+   const int maxw = buffer->scaled ? buffer->unscaledw : buffer->width;
+   const int maxh = buffer->scaled ? buffer->unscaledh : buffer->height;
+   x1 = emax(x1, 0);
+   y1 = emax(y1, 0);
+   x2 = emin(x2, maxw - 1);
+   y2 = emin(y2, maxh - 1);
+   if(x1 > x2 || y1 > y2)
+      return;
+
+   if(buffer->scaled)
+   {
+      x1 = buffer->x1lookup[x1];
+      x2 = buffer->x2lookup[x2];
+      y1 = buffer->y1lookup[y1];
+      y2 = buffer->y2lookup[y2];
+   }
+
+   patchrecord.x1 = emin(patchrecord.x1, x1 + buffer->subx);
+   patchrecord.x2 = emax(patchrecord.x2, x2 + buffer->subx);
+   patchrecord.y1 = emin(patchrecord.y1, y1 + buffer->suby);
+   patchrecord.y2 = emax(patchrecord.y2, y2 + buffer->suby);
+}
+
 //
 // Draws patches to the screen via the same vissprite-style scaling
 // and clipping used to draw player gun sprites. This results in
@@ -541,6 +665,39 @@ void V_DrawPatchInt(cb_patch_column_t &patchcol, PatchInfo *pi, VBuffer *buffer)
    
    patchcol.buffer = buffer;
 
+#ifdef RANGECHECK
+   if(pi->drawstyle < 0 || pi->drawstyle >= PSTYLE_NUMSTYLES)
+      I_Error("V_DrawPatchInt: unknown patch drawstyle %d\n", pi->drawstyle);
+#endif
+
+   if(patchrecording)
+   {
+      V_recordPatch(patchcol, pi, buffer);
+      return;
+   }
+
+   // scaled 8-bit drawing goes through the pre-scaled patch cache
+   vpatchcache_t *pc = nullptr;
+   if(patchcapturing)
+   {
+      if(pi->drawstyle != PSTYLE_NORMAL && pi->drawstyle != PSTYLE_TLATED)
+      {
+         patchcapturecomplete = false;
+         return;
+      }
+   }
+   else if(buffer->scaled && buffer->pixelsize == 1)
+   {
+      pc = V_findCachedPatch(pi, buffer);
+      if(pc->built)
+      {
+         V_drawCachedPatch(patchcol, pc, pi->drawstyle);
+         return;
+      }
+      if(pc->uses < 2 || pc->uncacheable)
+         pc = nullptr; // only expand patches drawn more than once
+   }
+
    // calculate edges of the shape
    if(pi->flipped)
    {
@@ -619,11 +776,13 @@ void V_DrawPatchInt(cb_patch_column_t &patchcol, PatchInfo *pi, VBuffer *buffer)
       column_t *column;
       int      texturecolumn;
 
-#ifdef RANGECHECK
-      if(pi->drawstyle < 0 || pi->drawstyle >= PSTYLE_NUMSTYLES)
-         I_Error("V_DrawPatchInt: unknown patch drawstyle %d\n", pi->drawstyle);
-#endif
-      patchcol.colfunc = colfuncfordrawstyle[pi->drawstyle];
+      if(patchcapturing)
+      {
+         patchcol.colfunc = pi->drawstyle == PSTYLE_TLATED ? V_captureFinalColumn<true>
+                                                           : V_captureFinalColumn<false>;
+      }
+      else
+         patchcol.colfunc = pc ? V_capturePatchColumn : colfuncfordrawstyle[pi->drawstyle];
 
       const int ytop = pi->y - patch->topoffset;
       for(; patchcol.x <= x2; patchcol.x++, startfrac += xiscale)
@@ -639,6 +798,24 @@ void V_DrawPatchInt(cb_patch_column_t &patchcol, PatchInfo *pi, VBuffer *buffer)
          maskcolfunc(patchcol, ytop, column);
       }
    }
+
+   if(pc)
+   {
+      V_finishCachedPatch(pc);
+      if(pc->built)
+         V_drawCachedPatch(patchcol, pc, pi->drawstyle);
+      else
+      {
+         // draw what was gathered without keeping it
+         vpatchcache_t captured = {};
+         captured.runs    = patchcaptureruns.begin();
+         captured.numruns = int(patchcaptureruns.getLength());
+         captured.pixels  = patchcapturepixels.begin();
+         V_drawCachedPatch(patchcol, &captured, pi->drawstyle);
+      }
+      patchcaptureruns.makeEmpty();
+      patchcapturepixels.makeEmpty();
+   }
 }
 
 //
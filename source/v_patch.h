@@ -57,6 +57,40 @@ enum
 };
 
 void V_DrawPatchInt(cb_patch_column_t &patchcol, PatchInfo *pi, VBuffer *buffer);
+void V_FlushPatchCache();
+
+// What a run of patch drawings would have drawn, and where
+struct vpatchrecord_t
+{
+   uint32_t hash;
+   int      x1, y1, x2, y2; // inclusive, in root buffer pixels
+};
+
+void V_BeginPatchRecord();
+vpatchrecord_t V_EndPatchRecord();
+
+// A run of screen pixels in one column, written by a patch drawing
+struct vpatchrun_t
+{
+   int    x, y1, count;
+   size_t offset; // into the pixels that go with it
+};
+
+// What a run of opaque patch drawings wrote to their buffer
+struct vpatchcapture_t
+{
+   const vpatchrun_t *runs;
+   int                numruns;
+   const byte        *pixels;
+   size_t             numpixels;
+   bool               complete; // false if a drawing wasn't opaque
+};
+
+void V_BeginPatchCapture();
+vpatchcapture_t V_EndPatchCapture();
+bool V_PatchDrawingHeld();
+void V_DrawPatchRuns(VBuffer *buffer, const vpatchrun_t *runs, int numruns,
+                     const byte *pixels);
 
 enum
 {
@@ -0,0 +1,326 @@
+//
+// The Eternity Engine
+// Copyright(C) 2026 James Haley, Max Waine, et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+// Additional terms and conditions compatible with the GPLv3 apply. See the
+// file COPYING-EE for details.
+//
+// Purpose: Cache of image lumps converted to patches.
+//  The memory cache holds copies outside the zone's purgable blocks, most
+//  recently used first, and drops the least recently used ones to stay in
+//  v_patchcache MiB. Files on disk hold the patch in lump byte order and
+//  are checked like any patch lump before they are used.
+//
+
+#include "z_zone.h"
+
+#include "autopalette.h"
+#include "c_runcmd.h"
+#include "doomstat.h"
+#include "e_hash.h"
+#include "hal/i_directory.h"
+#include "m_hash.h"
+#include "m_qstr.h"
+#include "m_swap.h"
+#include "r_patch.h"
+#include "v_patchcache.h"
+#include "v_patchfmt.h"
+
+// Bump whenever the way patches are converted changes
+static constexpr uint32_t PATCHCACHE_VERSION = 1;
+
+static constexpr size_t PATCHHEADER_SIZE = 4 + 4 + 4 + sizeof(patchcachekey_t);
+
+int  v_patchcache     = 4;     // MiB kept in memory, 0 for none
+bool v_patchdiskcache = false;
+
+struct convertedpatch_t
+{
+   int              key;  // first word of the digest
+   patchcachekey_t  fullkey;
+   size_t           size;
+   byte            *data; // in native byte order
+   convertedpatch_t *prev, *next;
+   DLListItem<convertedpatch_t> links;
+};
+
+static EHashTable<convertedpatch_t, EIntHashKey, &convertedpatch_t::key,
+                  &convertedpatch_t::links> patchhash;
+
+static convertedpatch_t *lruhead, *lrutail; // most and least recently used
+static size_t            patchbytes;
+
+//
+// Keys the conversion of a lump with the current palette.
+//
+void V_PatchCacheKey(const void *lumpdata, size_t lumpsize, patchcachekey_t &key)
+{
+   AutoPalette pal(wGlobalDir);
+   HashData    hash(HashData::SHA1, pal.get(), 768, false);
+
+   hash.addData(static_cast<const uint8_t *>(lumpdata), uint32_t(lumpsize));
+   hash.wrapUp();
+
+   for(int i = 0; i < 5; i++)
+      key.digest[i] = hash.getDigestPart(i);
+}
+
+static void V_unlinkPatch(convertedpatch_t *cp)
+{
+   if(cp->prev)
+      cp->prev->next = cp->next;
+   else
+      lruhead = cp->next;
+   if(cp->next)
+      cp->next->prev = cp->prev;
+   else
+      lrutail = cp->prev;
+}
+
+static void V_linkPatchFirst(convertedpatch_t *cp)
+{
+   cp->prev = nullptr;
+   cp->next = lruhead;
+   if(lruhead)
+      lruhead->prev = cp;
+   else
+      lrutail = cp;
+   lruhead = cp;
+}
+
+//
+// Drops the least recently used patches until the cache fits in budget bytes.
+//
+static void V_trimPatchCache(size_t budget)
+{
+   while(lrutail && patchbytes > budget)
+   {
+      convertedpatch_t *cp = lrutail;
+
+      V_unlinkPatch(cp);
+      patchhash.removeObject(cp);
+      patchbytes -= cp->size;
+      efree(cp->data);
+      efree(cp);
+   }
+}
+
+static convertedpatch_t *V_findInMemory(const patchcachekey_t &key)
+{
+   const int hashkey = int(key.digest[0]);
+   convertedpatch_t *cp = nullptr;
+
+   while((cp = patchhash.keyIterator(cp, hashkey)))
+   {
+      if(!memcmp(&cp->fullkey, &key, sizeof(key)))
+         return cp;
+   }
+
+   return nullptr;
+}
+
+static void V_addToMemory(const patchcachekey_t &key, const void *data, size_t size)
+{
+   const size_t budget = size_t(v_patchcache) << 20;
+
+   if(size > budget || V_findInMemory(key))
+      return;
+
+   V_trimPatchCache(budget - size);
+
+   convertedpatch_t *cp = estructalloc(convertedpatch_t, 1);
+   cp->key     = int(key.digest[0]);
+   cp->fullkey = key;
+   cp->size    = size;
+   cp->data    = emalloc(byte *, size);
+   memcpy(cp->data, data, size);
+
+   patchhash.addObject(cp);
+   V_linkPatchFirst(cp);
+   patchbytes += size;
+}
+
+//
+// Swaps a patch between lump and native byte order, either way round.
+//
+static void V_swapPatch(patch_t *patch, int width)
+{
+   patch->width      = SwapShort(patch->width);
+   patch->height     = SwapShort(patch->height);
+   patch->leftoffset = SwapShort(patch->leftoffset);
+   patch->topoffset  = SwapShort(patch->topoffset);
+
+   for(int i = 0; i < width; i++)
+      patch->columnofs[i] = SwapLong(patch->columnofs[i]);
+}
+
+static qstring V_patchCachePath(const patchcachekey_t &key, bool create)
+{
+   qstring dir(userpath);
+   dir /= "cache";
+
+   if(create)
+      I_CreateDirectory(dir);
+
+   qstring name;
+   name.Printf(0, "patch_%08x%08x%08x%08x%08x.pat", key.digest[0], key.digest[1],
+               key.digest[2], key.digest[3], key.digest[4]);
+
+   return dir / name;
+}
+
+//
+// Builds the header every cache file starts with, little-endian throughout.
+//
+static void V_patchHeader(byte *header, const patchcachekey_t &key, size_t size)
+{
+   const uint32_t fields[2] = { PATCHCACHE_VERSION, uint32_t(size) };
+
+   memcpy(header, "EEPC", 4);
+   for(int i = 0; i < 2; i++)
+   {
+      for(int b = 0; b < 4; b++)
+         header[4 + i * 4 + b] = byte(fields[i] >> (b * 8));
+   }
+   for(int i = 0; i < 5; i++)
+   {
+      for(int b = 0; b < 4; b++)
+         header[12 + i * 4 + b] = byte(key.digest[i] >> (b * 8));
+   }
+}
+
+//
+// Reads a patch saved earlier into a new emalloc'd block in native order.
+//
+static byte *V_loadFromDisk(const patchcachekey_t &key, size_t &size)
+{
+   const qstring path = V_patchCachePath(key, false);
+   FILE *f;
+
+   if(!(f = fopen(path.constPtr(), "rb")))
+      return nullptr;
+
+   byte header[PATCHHEADER_SIZE], expected[PATCHHEADER_SIZE];
+   byte *data = nullptr;
+
+   fseek(f, 0, SEEK_END);
+   const long length = ftell(f);
+   fseek(f, 0, SEEK_SET);
+
+   if(length > long(PATCHHEADER_SIZE) &&
+      fread(header, 1, PATCHHEADER_SIZE, f) == PATCHHEADER_SIZE)
+   {
+      size = size_t(length) - PATCHHEADER_SIZE;
+      V_patchHeader(expected, key, size);
+
+      if(!memcmp(header, expected, PATCHHEADER_SIZE))
+      {
+         data = emalloc(byte *, size);
+         if(fread(data, 1, size, f) != size || !PatchLoader::VerifyAndFormat(data, size))
+         {
+            efree(data);
+            data = nullptr;
+         }
+      }
+   }
+   fclose(f);
+
+   return data;
+}
+
+//
+// Writes a converted patch out. Failure just means converting it next time.
+//
+static void V_saveToDisk(const patchcachekey_t &key, const patch_t *patch, size_t size)
+{
+   const qstring path = V_patchCachePath(key, true);
+   FILE *f;
+
+   if(!(f = fopen(path.constPtr(), "wb")))
+      return;
+
+   byte header[PATCHHEADER_SIZE];
+   V_patchHeader(header, key, size);
+
+   byte *data = emalloc(byte *, size);
+   memcpy(data, patch, size);
+   V_swapPatch(reinterpret_cast<patch_t *>(data), patch->width);
+
+   const bool written = fwrite(header, 1, PATCHHEADER_SIZE, f) == PATCHHEADER_SIZE &&
+                        fwrite(data, 1, size, f) == size;
+   efree(data);
+
+   // Don't leave a truncated patch behind
+   if(fclose(f) || !written)
+      remove(path.constPtr());
+}
+
+//
+// Returns a copy of the converted patch in a new zone block with the given
+// tag and user, or nullptr if it has to be converted.
+//
+patch_t *V_FindConvertedPatch(const patchcachekey_t &key, int tag, void **user)
+{
+   convertedpatch_t *cp;
+   void *patch = nullptr;
+
+   if((cp = V_findInMemory(key)))
+   {
+      V_unlinkPatch(cp);
+      V_linkPatchFirst(cp);
+
+      patch = Z_Malloc(cp->size, tag, user);
+      memcpy(patch, cp->data, cp->size);
+   }
+   else if(v_patchdiskcache && userpath)
+   {
+      size_t size;
+      byte  *data;
+
+      if((data = V_loadFromDisk(key, size)))
+      {
+         V_addToMemory(key, data, size);
+
+         patch = Z_Malloc(size, tag, user);
+         memcpy(patch, data, size);
+         efree(data);
+      }
+   }
+
+   return static_cast<patch_t *>(patch);
+}
+
+//
+// Keeps a freshly converted patch of the given size in bytes.
+//
+void V_AddConvertedPatch(const patchcachekey_t &key, const patch_t *patch, size_t size)
+{
+   V_addToMemory(key, patch, size);
+
+   if(v_patchdiskcache && userpath)
+      V_saveToDisk(key, patch, size);
+}
+
+VARIABLE_INT(v_patchcache, nullptr, 0, 256, nullptr);
+CONSOLE_VARIABLE(v_patchcache, v_patchcache, 0)
+{
+   V_trimPatchCache(size_t(v_patchcache) << 20);
+}
+
+VARIABLE_TOGGLE(v_patchdiskcache, nullptr, onoff);
+CONSOLE_VARIABLE(v_patchdiskcache, v_patchdiskcache, 0) {}
+
+// EOF
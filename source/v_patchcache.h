@@ -0,0 +1,49 @@
+//
+// The Eternity Engine
+// Copyright(C) 2026 James Haley, Max Waine, et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+// Additional terms and conditions compatible with the GPLv3 apply. See the
+// file COPYING-EE for details.
+//
+// Purpose: Cache of image lumps converted to patches.
+//  Converting a PNG to a patch means decoding it and matching every pixel to
+//  the palette, and a purged patch goes through it all again the next time
+//  it is cached. Converted patches are kept here, keyed by a SHA-1 of the
+//  palette and the lump, in memory up to a budget and optionally on disk.
+//
+
+#ifndef V_PATCHCACHE_H__
+#define V_PATCHCACHE_H__
+
+#include "doomtype.h"
+
+struct patch_t;
+
+struct patchcachekey_t
+{
+   uint32_t digest[5];
+};
+
+extern int  v_patchcache;
+extern bool v_patchdiskcache;
+
+void     V_PatchCacheKey(const void *lumpdata, size_t lumpsize, patchcachekey_t &key);
+patch_t *V_FindConvertedPatch(const patchcachekey_t &key, int tag, void **user);
+void     V_AddConvertedPatch(const patchcachekey_t &key, const patch_t *patch, size_t size);
+
+#endif
+
+// EOF
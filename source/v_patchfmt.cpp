@@ -32,6 +32,7 @@
 #include "m_swap.h"
 #include "r_patch.h"
 #include "v_patch.h"
+#include "v_patchcache.h"
 #include "v_patchfmt.h"
 #include "v_png.h"
 #include "z_auto.h"
@@ -159,8 +160,17 @@ WadLumpLoader::Code PatchLoader::verifyData(lumpinfo_t *lump) const
       if(lump->size > 8 && VPNGImage::CheckPNGFormat(lump->cache[fmt]))
       {
          int curTag = Z_CheckTag(lump->cache[fmt]);
+         patchcachekey_t key;
+         V_PatchCacheKey(lump->cache[fmt], lump->size, key);
          Z_Free(lump->cache[fmt]);
-         VPNGImage::LoadAsPatch(lump->selfindex, curTag, &lump->cache[fmt]);
+         if(!V_FindConvertedPatch(key, curTag, &lump->cache[fmt]))
+         {
+            size_t size;
+            patch_t *patch = VPNGImage::LoadAsPatch(lump->selfindex, curTag,
+                                                    &lump->cache[fmt], &size);
+            if(patch)
+               V_AddConvertedPatch(key, patch, size);
+         }
          if(lump->cache[fmt])
             return CODE_NOFMT;
       }
@@ -33,7 +33,6 @@
 #include "autopalette.h"
 #include "c_io.h"
 #include "doomtype.h"
-#include "e_hash.h"
 #include "m_swap.h"
 #include "v_misc.h"
 #include "v_png.h"
@@ -408,19 +407,7 @@ byte *VPNGImagePimpl::buildTranslation(const byte *outpal) const
    return newpal;
 }
 
-struct rgbto8bit_t
-{
-   int key;
-   byte index;
-   DLListItem<rgbto8bit_t> links;
-};
-
-//
-// Colours are likely to be re-used, both within themselves and across multiple images,
-// so this hash table exists to caches RGB colours and the index they map to
-// TODO: Figure out if and when the contents of this hash should be disposed
-//
-static EHashTable<rgbto8bit_t, EIntHashKey, &rgbto8bit_t::key, &rgbto8bit_t::links> v_rgbto8bithash;
+static VInversePalette v_inversepal;
 
 //
 // VPNGImagePimpl::getAs8Bit
@@ -466,25 +453,12 @@ byte *VPNGImagePimpl::getAs8Bit(const byte *outpal) const
       byte *src  = surface;
       byte *dest = ecalloc(byte *, width, height);
 
-      for(png_uint_32 y = 0; y < height; y++)
-      {
-         for(png_uint_32 x = 0; x < width; x++)
-         {
-            // TODO: figure out if this is still extremely inefficient
-            const int col = ((*src) << 16) + (*(src+1) << 8) + *(src+2);
-            rgbto8bit_t *cached_entry = v_rgbto8bithash.objectForKey(col);
+      v_inversepal.setPalette(outpal);
 
-            if(cached_entry)
-               dest[y * width + x] = cached_entry->key;
-            else
-            {
-               cached_entry = estructalloc(rgbto8bit_t, 1);
-               cached_entry->key = col;
-               cached_entry->index = dest[y * width + x] = V_FindBestColor(outpal, *src, *(src+1), *(src+2));
-               v_rgbto8bithash.addObject(cached_entry);
-            }
-            src += channels;
-         }
+      for(png_uint_32 i = 0; i < width * height; i++)
+      {
+         dest[i] = v_inversepal.nearest(src[0], src[1], src[2]);
+         src += channels;
       }
 
       return dest;
@@ -33,8 +33,10 @@
 #include "doomstat.h"
 #include "i_video.h"
 #include "m_bbox.h"
+#include "m_compare.h"
 #include "r_draw.h"
 #include "r_main.h"
+#include "r_tblcache.h"
 #include "v_block.h"
 #include "v_misc.h"
 #include "v_patchfmt.h"
@@ -755,6 +757,101 @@ byte V_FindBestColor(const byte *palette, int r, int g, int b)
    return bestcolor;
 }
 
+//
+// Starts over if pal isn't the palette the cells were built for.
+//
+void VInversePalette::setPalette(const byte *pal)
+{
+   if(valid && !memcmp(palette, pal, sizeof(palette)))
+      return;
+
+   memcpy(palette, pal, sizeof(palette));
+   memset(cells, 0, sizeof(cells));
+   lists.resize(0);
+   valid = true;
+}
+
+//
+// Finds the entries that could be nearest to a colour in the cell.
+//
+uint32_t VInversePalette::buildCell(int cell)
+{
+   const int lo[3] =
+   {
+      (cell >> (2 * AXISBITS)) << CELLBITS,
+      ((cell >> AXISBITS) & ((1 << AXISBITS) - 1)) << CELLBITS,
+      (cell & ((1 << AXISBITS) - 1)) << CELLBITS
+   };
+   int mindist[256];
+   int bound = INT_MAX;
+
+   for(int i = 0; i < 256; i++)
+   {
+      int nearsum = 0, farsum = 0;
+
+      for(int ch = 0; ch < 3; ch++)
+      {
+         const int v  = palette[i * 3 + ch];
+         const int hi = lo[ch] + (1 << CELLBITS) - 1;
+         const int nd = v < lo[ch] ? lo[ch] - v : v > hi ? v - hi : 0;
+         const int fd = emax(abs(v - lo[ch]), abs(v - hi));
+
+         nearsum += nd * nd;
+         farsum  += fd * fd;
+      }
+
+      mindist[i] = nearsum;
+      bound = emin(bound, farsum);
+   }
+
+   const uint32_t offset = uint32_t(lists.getLength());
+   int count = 0;
+
+   lists.add(0);
+   for(int i = 0; i < 256; i++)
+   {
+      if(mindist[i] <= bound)
+      {
+         lists.add(byte(i));
+         count++;
+      }
+   }
+   lists[offset] = byte(count - 1);
+
+   return offset + 1;
+}
+
+//
+// Index of the palette entry nearest to r, g, b.
+//
+byte VInversePalette::nearest(int r, int g, int b)
+{
+   const int cell = (r >> CELLBITS) << (2 * AXISBITS) | (g >> CELLBITS) << AXISBITS |
+                    b >> CELLBITS;
+
+   if(!cells[cell])
+      cells[cell] = buildCell(cell);
+
+   const byte *list  = &lists[cells[cell] - 1];
+   const int   count = list[0] + 1;
+   int best = list[1], bestdist = INT_MAX;
+
+   for(int i = 1; i <= count; i++)
+   {
+      const byte *c  = palette + list[i] * 3;
+      const int   dr = r - c[0], dg = g - c[1], db = b - c[2];
+      const int   dist = dr * dr + dg * dg + db * db;
+
+      if(dist < bestdist)
+      {
+         bestdist = dist;
+         best     = list[i];
+      }
+   }
+
+   return byte(best);
+}
+
 // haleyjd: DOSDoom-style single translucency lookup-up table
 // generation code. This code has a 32k (plus a bit more) 
 // footprint but allows a much wider range of translucency effects
@@ -772,6 +869,7 @@ bool flexTranInit = false;
 unsigned int  Col2RGB8[65][256];
 unsigned int *Col2RGB8_LessPrecision[65];
 byte RGB32k[32][32][32];
+unsigned int Col2RGB32[256];
 
 static unsigned int Col2RGB8_2[63][256];
 
@@ -798,20 +896,25 @@ void V_InitFlexTranTable(const byte *palette)
       tempRGBpal[i].r = palRover[0];
       tempRGBpal[i].g = palRover[1];
       tempRGBpal[i].b = palRover[2];
+      Col2RGB32[i]    = (palRover[0] << 16) | (palRover[1] << 8) | palRover[2];
    }
 
-   // build RGB table
-   for(r = 0; r < 32; ++r)
+   // build RGB table, unless a previous run already did for this palette
+   if(!R_LoadCachedTable("rgb32k", palette, 0, RGB32k, sizeof(RGB32k)))
    {
-      for(g = 0; g < 32; ++g)
+      for(r = 0; r < 32; ++r)
       {
-         for(b = 0; b < 32; ++b)
+         for(g = 0; g < 32; ++g)
          {
-            RGB32k[r][g][b] = 
-               V_FindBestColor(palette, 
-                               MAKECOLOR(r), MAKECOLOR(g), MAKECOLOR(b));
+            for(b = 0; b < 32; ++b)
+            {
+               RGB32k[r][g][b] = 
+                  V_FindBestColor(palette, 
+                                  MAKECOLOR(r), MAKECOLOR(g), MAKECOLOR(b));
+            }
          }
       }
+      R_SaveCachedTable("rgb32k", palette, 0, RGB32k, sizeof(RGB32k));
    }
    
    // build lookup table
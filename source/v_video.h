@@ -35,6 +35,7 @@
 // Needed because we are refering to patches.
 #include "r_data.h"
 #include "v_buffer.h"
+#include "m_collection.h"
 
 //
 // VIDEO
@@ -99,6 +100,7 @@ extern bool flexTranInit;
 extern unsigned int Col2RGB8[65][256];
 extern unsigned int *Col2RGB8_LessPrecision[65];
 extern byte RGB32k[32][32][32];
+extern unsigned int Col2RGB32[256]; // palette as 0x00RRGGBB, for truecolor rendering
 
 
 // ----------------------------------------------------------------------------
@@ -200,6 +202,33 @@ void V_DrawFSBackground(VBuffer *dest, int lumpnum);
 // A function that requantizes a color into the default game palette
 byte V_FindBestColor(const byte *palette, int r, int g, int b);
 
+//
+// Nearest palette entries for requantizing many colours. The colour cube is
+// cut into cells of 8x8x8 colours. The first time a colour lands in a cell,
+// the cell is given every palette entry that could be nearest to some colour
+// inside it: those no farther from the cell than the smallest farthest
+// distance of any entry. A lookup only searches those, in palette order, so
+// it gives the same index as V_FindBestColor.
+//
+class VInversePalette
+{
+public:
+   void setPalette(const byte *pal);
+   byte nearest(int r, int g, int b);
+
+private:
+   static constexpr int CELLBITS = 3;
+   static constexpr int AXISBITS = 8 - CELLBITS;
+   static constexpr int NUMCELLS = 1 << (3 * AXISBITS);
+
+   byte     palette[768];
+   bool     valid = false;
+   uint32_t cells[NUMCELLS]; // 1 + offset of the cell's list, or 0 if not built
+   PODCollection<byte> lists; // for each cell, the count less one, then entries
+
+   uint32_t buildCell(int cell);
+};
+
 
 // V_CacheBlock
 // Copies a block of pixels from the source linear buffer into the destination
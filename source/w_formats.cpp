@@ -246,6 +246,7 @@ static namespace_matcher_t matchers[] =
    { "translations/", lumpinfo_t::ns_translations }, // EE extension
    { "gamepads/",     lumpinfo_t::ns_pads         }, // EE extension
    { "textures/",     lumpinfo_t::ns_textures     },
+   { "voxels/",       lumpinfo_t::ns_voxels       },
 
    { nullptr,         -1                          }  // keep this last
 
@@ -253,7 +254,6 @@ static namespace_matcher_t matchers[] =
    /*
    { "patches/",      lumpinfo_t::ns_patches      },
    { "voices/",       lumpinfo_t::ns_voices       },
-   { "voxels/",       lumpinfo_t::ns_voxels       },
    */
 };
 
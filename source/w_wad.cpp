@@ -46,8 +46,10 @@ namespace fs = std::experimental::filesystem;
 #include "d_files.h"
 #include "e_hash.h"
 #include "hal/i_directory.h"
+#include "hal/i_filemap.h"
 #include "m_argv.h"
 #include "m_collection.h"
+#include "m_compare.h"
 #include "m_dllist.h"
 #include "m_hash.h"
 #include "m_qstr.h"
@@ -73,6 +75,9 @@ int WadDirectory::source;            // haleyjd 03/18/10: next source ID# to use
 int WadDirectory::IWADSource   = -1; // sf: the handle of the main iwad
 int WadDirectory::ResWADSource = -1; // haleyjd: track handle of first wad added
 
+uint64_t w_cachedbytes; // lump bytes found cached by cacheLumpNum
+uint64_t w_readbytes;   // lump bytes read in by cacheLumpNum
+
 static EHashTable<lumpinfo_t, EStringHashKey, &lumpinfo_t::lfn,
                   &lumpinfo_t::lfnlinks> e_LFNHash;
 
@@ -89,6 +94,7 @@ lumpinfo_t *W_NextInLFNHash(lumpinfo_t *lumpinfo)
 struct lumptype_t
 {
    size_t (*readLump)(lumpinfo_t *, void *);
+   WadLumpStream *(*openStream)(lumpinfo_t *); // nullptr if it can't be streamed
 };
 
 static size_t W_DirectReadLump(lumpinfo_t *, void *);
@@ -96,26 +102,35 @@ static size_t W_MemoryReadLump(lumpinfo_t *, void *);
 static size_t W_FileReadLump  (lumpinfo_t *, void *);
 static size_t W_ZipReadLump   (lumpinfo_t *, void *);
 
+static WadLumpStream *W_DirectOpenStream(lumpinfo_t *);
+static WadLumpStream *W_MemoryOpenStream(lumpinfo_t *);
+static WadLumpStream *W_FileOpenStream  (lumpinfo_t *);
+static WadLumpStream *W_ZipOpenStream   (lumpinfo_t *);
+
 static lumptype_t LumpHandlers[lumpinfo_t::lump_numtypes] =
 {
    // direct lump
    {
       W_DirectReadLump,
+      W_DirectOpenStream,
    },
 
    // memory lump
    {
       W_MemoryReadLump,
+      W_MemoryOpenStream,
    },
 
    // directory file lump
    {
       W_FileReadLump,
+      W_FileOpenStream,
    },
 
    // zip file lump
    {
       W_ZipReadLump,
+      W_ZipOpenStream,
    },
 };
 
@@ -156,10 +171,44 @@ public:
 
    PODCollection<lumpinfo_t *>  infoptrs; // lumpinfo_t allocations
    DLListItem<ZipFile>         *zipFiles; // zip files attached to this waddir
+   PODCollection<filemap_t *>   fileMaps; // mapped wad files
 
    WadDirectoryPimpl()
-      : ZoneObject(), infoptrs(), zipFiles(nullptr)
+      : ZoneObject(), infoptrs(), zipFiles(nullptr), fileMaps()
+   {
+   }
+
+   virtual ~WadDirectoryPimpl()
+   {
+      freeFileMaps();
+   }
+
+   //
+   // Map a wad file for direct reads of its lumps. Returns nullptr if the
+   // file could not be mapped, in which case stdio is used as before.
+   //
+   filemap_t *addFileMap(FILE *f)
+   {
+      auto map = estructalloc(filemap_t, 1);
+
+      if(!I_MapFile(f, *map))
+      {
+         efree(map);
+         return nullptr;
+      }
+
+      fileMaps.add(map);
+      return map;
+   }
+
+   void freeFileMaps()
    {
+      for(filemap_t *map : fileMaps)
+      {
+         I_UnmapFile(*map);
+         efree(map);
+      }
+      fileMaps.clear();
    }
 };
 
@@ -536,6 +585,12 @@ bool WadDirectory::addWadFile(openwad_t &openData, const wfileadd_t &addInfo,
          IWADSource = source;
    }
 
+   // Map the file so that lump reads need not seek and read through stdio.
+   // Subfiles share their container's handle, so they are left unmapped.
+   const filemap_t *map = nullptr;
+   if(!(addInfo.flags & WFA_SUBFILE))
+      map = pImpl->addFileMap(openData.handle);
+
    // Add lumpinfo_t's for all lumps in the wad file
    lump_p = reAllocLumpInfo(header.numlumps, startlump);
 
@@ -549,6 +604,7 @@ bool WadDirectory::addWadFile(openwad_t &openData, const wfileadd_t &addInfo,
       // setup for direct IO
       lump_p->direct.file     = openData.handle;
       lump_p->direct.position = (size_t)(SwapLong(fileinfo->filepos));
+      lump_p->direct.map      = map;
 
       // for subfiles, add baseoffset to the lump offset
       if(addInfo.flags & WFA_SUBFILE)
@@ -1065,6 +1121,7 @@ static nsdata_t wadNameSpaces[lumpinfo_t::ns_max] =
    { nullptr,    nullptr,  lumpinfo_t::ns_graphics     },
    { nullptr,    nullptr,  lumpinfo_t::ns_sounds       },
    { "HI_START", "HI_END", lumpinfo_t::ns_hires        }, // TODO: Implement
+   { "VX_START", "VX_END", lumpinfo_t::ns_voxels       },
 };
 
 //
@@ -1213,31 +1270,41 @@ void WadDirectory::coalesceMarkedResources()
    }
 }
 
+//
+// WadDirectory::LumpNameKey
+//
+// Packs up to 8 characters of a lump name into a single word, uppercased and
+// zero-padded, so that two names compare equal case-insensitively exactly when
+// their keys are equal.
+//
+uint64_t WadDirectory::LumpNameKey(const char *s)
+{
+   using namespace ectype;
+   uint64_t key = 0;
+
+   for(int i = 0; i < 8 && s[i]; i++)
+      key |= static_cast<uint64_t>(static_cast<unsigned char>(toUpper(s[i]))) << (i * 8);
+
+   return key;
+}
+
 //
 // W_LumpNameHash
 //
 // Hash function used for lump names.
 // Must be mod'ed with table size.
 // Can be used for any 8-character names.
-// by Lee Killough
+// Originally by Lee Killough; now mixes the packed name key with a single
+// multiply instead of walking the characters.
 //
-unsigned int WadDirectory::LumpNameHash(const char *s)
+static inline unsigned int W_keyHash(uint64_t key)
 {
-   using namespace ectype;
-   unsigned int hash;
-   if(!*s)
-      return 0;
+   return static_cast<unsigned int>((key * 0x9E3779B97F4A7C15ull) >> 32);
+}
 
-   (void) ((hash =        toUpper(s[0]), s[1]) &&
-           (hash = hash*3+toUpper(s[1]), s[2]) &&
-           (hash = hash*2+toUpper(s[2]), s[3]) &&
-           (hash = hash*2+toUpper(s[3]), s[4]) &&
-           (hash = hash*2+toUpper(s[4]), s[5]) &&
-           (hash = hash*2+toUpper(s[5]), s[6]) &&
-           (hash = hash*2+toUpper(s[6]),
-            hash = hash*2+toUpper(s[7]))
-           );
-   return hash;
+unsigned int WadDirectory::LumpNameHash(const char *s)
+{
+   return W_keyHash(LumpNameKey(s));
 }
 
 //
@@ -1250,10 +1317,11 @@ unsigned int WadDirectory::LumpNameHash(const char *s)
 // lump name lookup is used so often, and the original Doom used a sequential
 // search. For large wads with > 1000 lumps this meant an average of over
 // 500 were probed during every search. Now the average is under 2 probes per
-// search. There is no significant benefit to packing the names into longwords
-// with this new hashing algorithm, because the work to do the packing is
-// just as much work as simply doing the string comparisons with the new
-// algorithm, which minimizes the expected number of comparisons to under 2.
+// search.
+//
+// Names are now packed into a word once, both when the hash is built and
+// per lookup, so each probe is a single integer compare rather than a
+// strncasecmp.
 //
 // killough 4/17/98: add namespace parameter to prevent collisions
 // between different resources such as flats, sprites, colormaps
@@ -1265,7 +1333,8 @@ int WadDirectory::checkNumForName(const char *name, int li_namespace) const
    // Hash function maps the name to one of possibly numlump chains.
    // It has been tuned so that the average chain length never exceeds 2.
 
-   unsigned int hashkey = LumpNameHash(name) % (unsigned int)numlumps;
+   const uint64_t namekey = LumpNameKey(name);
+   unsigned int hashkey = W_keyHash(namekey) % (unsigned int)numlumps;
    int i = lumpinfo[hashkey]->index;
 
    // We search along the chain until end, looking for case-insensitive
@@ -1274,7 +1343,7 @@ int WadDirectory::checkNumForName(const char *name, int li_namespace) const
    // worth the overhead, considering namespace collisions are rare in
    // Doom wads.
 
-   while(i >= 0 && (strncasecmp(lumpinfo[i]->name, name, 8) ||
+   while(i >= 0 && (lumpinfo[i]->namekey != namekey ||
          lumpinfo[i]->li_namespace != li_namespace))
       i = lumpinfo[i]->next;
 
@@ -1470,9 +1539,10 @@ void WadDirectory::initLumpHashes()
    for(i = 0; i < numlumps; i++)
    {                                           // hash function:
       // haleyjd 10/28/12: if lump name is empty, do not add it into the hash.
+      lumpinfo[i]->namekey = LumpNameKey(lumpinfo[i]->name);
       if(lumpinfo[i]->name[0])
       {
-         const unsigned int j = LumpNameHash(lumpinfo[i]->name) % (unsigned int)numlumps;
+         const unsigned int j = W_keyHash(lumpinfo[i]->namekey) % (unsigned int)numlumps;
          lumpinfo[i]->next    = lumpinfo[j]->index; // Prepend to list
          lumpinfo[j]->index   = i;
       }
@@ -1600,6 +1670,38 @@ int W_LumpLength(int lump)
    return wGlobalDir.lumpLength(lump);
 }
 
+//
+// WadDirectory::openLumpStream
+//
+// Opens a lump for reading a piece at a time. Returns nullptr if the lump's
+// storage doesn't allow that, in which case it has to be read whole. The
+// caller deletes the stream.
+//
+WadLumpStream *WadDirectory::openLumpStream(int lumpnum) const
+{
+   if(lumpnum < 0 || lumpnum >= numlumps)
+      I_Error("WadDirectory::openLumpStream: %d >= numlumps\n", lumpnum);
+
+   lumpinfo_t *lump = lumpinfo[lumpnum];
+   return LumpHandlers[lump->type].openStream(lump);
+}
+
+size_t WadMemoryStream::read(void *dest, size_t len)
+{
+   len = emin(len, lumpsize - position);
+   memcpy(dest, data + position, len);
+   position += len;
+   return len;
+}
+
+bool WadMemoryStream::seek(size_t pos)
+{
+   if(pos > lumpsize)
+      return false;
+   position = pos;
+   return true;
+}
+
 //
 // W_ReadLump
 //
@@ -1669,6 +1771,7 @@ void *WadDirectory::cacheLumpNum(int lump, int tag,
 
    if(!(lumpinfo[lump]->cache[fmt]))      // read the lump in
    {
+      w_readbytes += lumpinfo[lump]->size;
       readLump(lump,
                Z_Malloc(lumpLength(lump), tag, &(lumpinfo[lump]->cache[fmt])),
                lfmt);
@@ -1681,6 +1784,8 @@ void *WadDirectory::cacheLumpNum(int lump, int tag,
 
       int oldtag = Z_CheckTag(lumpinfo[lump]->cache[fmt]);
 
+      w_cachedbytes += lumpinfo[lump]->size;
+
       if(tag < oldtag)
          Z_ChangeTag(lumpinfo[lump]->cache[fmt], tag);
    }
@@ -1726,6 +1831,40 @@ void WadDirectory::cacheLumpAuto(const char *name, ZAutoBuffer &buffer) const
    cacheLumpAuto(getNumForName(name), buffer);
 }
 
+//
+// WadDirectory::prefetchLumps
+//
+// Hint that a run of lumps will be read soon, so that the OS can start
+// reading them from mapped archives in the background. Nothing is cached,
+// and lumps that aren't in a mapped archive are ignored.
+//
+void WadDirectory::prefetchLumps(int lumpnum, int count) const
+{
+   if(lumpnum < 0)
+      return;
+
+   for(int i = lumpnum; i < numlumps && i < lumpnum + count; i++)
+   {
+      const lumpinfo_t *lump = lumpinfo[i];
+
+      if(lump->cache[lumpinfo_t::fmt_default])
+         continue;
+
+      switch(lump->type)
+      {
+      case lumpinfo_t::lump_direct:
+         if(lump->direct.map)
+            I_PrefetchMappedFile(*lump->direct.map, lump->direct.position, lump->size);
+         break;
+      case lumpinfo_t::lump_zip:
+         lump->zip.zipLump->prefetch();
+         break;
+      default:
+         break;
+      }
+   }
+}
+
 //
 // WadDirectory::writeLump
 //
@@ -1828,6 +1967,8 @@ void WadDirectory::close()
       // free all resources loaded from the wad
       freeDirectoryLumps();
 
+      pImpl->freeFileMaps();
+
       if(lumpinfo[0]->type == lumpinfo_t::lump_direct && lumpinfo[0]->direct.file)
          fclose(lumpinfo[0]->direct.file);
 
@@ -1858,6 +1999,10 @@ static size_t W_DirectReadLump(lumpinfo_t *l, void *dest)
    size_t ret;
    directlump_t &direct = l->direct;
 
+   // copy straight out of the file mapping if there is one
+   if(direct.map && I_ReadMappedFile(*direct.map, direct.position, dest, size))
+      return size;
+
    // killough 10/98: Add flashing disk indicator
    fseek(direct.file, static_cast<long>(direct.position), SEEK_SET);
    ret = fread(dest, 1, size, direct.file);
@@ -1865,6 +2010,21 @@ static size_t W_DirectReadLump(lumpinfo_t *l, void *dest)
    return ret;
 }
 
+//
+// Only a mapped file can be streamed from; the FILE is shared with every
+// other read of the wad, so its position can't be left to a stream.
+//
+static WadLumpStream *W_DirectOpenStream(lumpinfo_t *l)
+{
+   const directlump_t &direct = l->direct;
+
+   if(!direct.map || !direct.map->data || direct.position > direct.map->size ||
+      l->size > direct.map->size - direct.position)
+      return nullptr;
+
+   return new WadMemoryStream(direct.map->data + direct.position, l->size);
+}
+
 //
 // Memory lumps -- lumps that are held in a static memory buffer
 //
@@ -1880,6 +2040,12 @@ static size_t W_MemoryReadLump(lumpinfo_t *l, void *dest)
    return size;
 }
 
+static WadLumpStream *W_MemoryOpenStream(lumpinfo_t *l)
+{
+   return new WadMemoryStream(static_cast<const byte *>(l->memory.data) + l->memory.position,
+                              l->size);
+}
+
 //
 // Directory file lumps -- lumps that are physical files on disk that are
 // not kept open except when being read.
@@ -1893,6 +2059,9 @@ static size_t W_FileReadLump(lumpinfo_t *l, void *dest)
 
    if((f = fopen(l->filepath, "rb")))
    {
+      // The whole file is read in one go, so stdio buffering would only add
+      // a buffer allocation and an extra copy per lump.
+      setvbuf(f, nullptr, _IONBF, 0);
       sizeread = fread(dest, 1, size, f);
       fclose(f);
    }
@@ -1900,6 +2069,41 @@ static size_t W_FileReadLump(lumpinfo_t *l, void *dest)
    return sizeread;
 }
 
+//
+// A directory file lump is streamed through a file of its own.
+//
+class WadFileStream : public WadLumpStream
+{
+protected:
+   FILE *f;
+
+public:
+   WadFileStream(FILE *pF, size_t size) : WadLumpStream(size), f(pF) {}
+   ~WadFileStream() { fclose(f); }
+
+   size_t read(void *dest, size_t len) override
+   {
+      len = fread(dest, 1, emin(len, lumpsize - position), f);
+      position += len;
+      return len;
+   }
+
+   bool seek(size_t pos) override
+   {
+      if(pos > lumpsize || fseek(f, static_cast<long>(pos), SEEK_SET))
+         return false;
+      position = pos;
+      return true;
+   }
+};
+
+static WadLumpStream *W_FileOpenStream(lumpinfo_t *l)
+{
+   FILE *f = fopen(l->filepath, "rb");
+
+   return f ? new WadFileStream(f, l->size) : nullptr;
+}
+
 //
 // ZIP lumps -- files embedded inside a ZIP archive. The ZipFile
 // and ZipLump classes take care of all the specifics.
@@ -1914,6 +2118,11 @@ static size_t W_ZipReadLump(lumpinfo_t *l, void *dest)
    return l->size;
 }
 
+static WadLumpStream *W_ZipOpenStream(lumpinfo_t *l)
+{
+   return l->zip.zipLump->openStream();
+}
+
 //----------------------------------------------------------------------------
 //
 // $Log: w_wad.c,v $
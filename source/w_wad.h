@@ -49,11 +49,14 @@ struct filelump_t
    char name[8];
 };
 
+struct filemap_t;
+
 // A direct lump can be read from its archive with C FILE IO facilities.
 struct directlump_t
 {
    FILE *file;       // for a direct lump, a pointer to the file it is in
    size_t position;  // for direct and memory lumps, offset into file/buffer
+   const filemap_t *map; // mapping of the file, if any, to read from instead
 };
 
 // A memory lump is loaded in a buffer in RAM and just needs to be memcpy'd.
@@ -85,6 +88,10 @@ struct lumpinfo_t
    // killough 1/31/98: hash table fields, used for ultra-fast hash table lookup
    int index, next;
 
+   // name uppercased and packed into one word by LumpNameKey, for hashing
+   // and comparing without going through the string
+   uint64_t namekey;
+
    // haleyjd 03/27/11: array index into lumpinfo in the parent wad directory,
    // for fast reverse lookup.
    int selfindex;
@@ -105,6 +112,7 @@ struct lumpinfo_t
       ns_graphics,
       ns_sounds,
       ns_hires,
+      ns_voxels,
       ns_max           // keep this last.
    };
    int li_namespace;
@@ -212,6 +220,56 @@ public:
    virtual lumpinfo_t::lumpformat formatIndex() const { return lumpinfo_t::fmt_default; }
 };
 
+//
+// WadLumpStream
+//
+// Reads a lump piece by piece, straight from wherever it is stored, instead
+// of loading it whole. Streams are opened by WadDirectory::openLumpStream and
+// need the file or archive the lump is in to stay loaded. They don't use the
+// zone and may be read from any one thread.
+//
+class WadLumpStream
+{
+protected:
+   size_t lumpsize;
+   size_t position;
+
+public:
+   explicit WadLumpStream(size_t size) : lumpsize(size), position(0) {}
+   virtual ~WadLumpStream() {}
+
+   size_t size() const { return lumpsize; }
+   size_t tell() const { return position; }
+
+   // Reads up to len bytes at the current position and returns how many
+   // were read.
+   virtual size_t read(void *dest, size_t len) = 0;
+
+   // Moves to a position no further than the end of the lump.
+   virtual bool seek(size_t pos) = 0;
+};
+
+//
+// WadMemoryStream
+//
+// Stream over lump data that is already addressable, such as a memory lump or
+// a lump in a mapped file.
+//
+class WadMemoryStream : public WadLumpStream
+{
+protected:
+   const unsigned char *data;
+
+public:
+   WadMemoryStream(const void *pData, size_t size)
+      : WadLumpStream(size), data(static_cast<const unsigned char *>(pData))
+   {
+   }
+
+   size_t read(void *dest, size_t len) override;
+   bool   seek(size_t pos) override;
+};
+
 class WadDirectoryPimpl;
 
 //
@@ -295,6 +353,7 @@ protected:
    void freeDirectoryAllocs(); // haleyjd 06/06/10
 
    // Utilities
+   static uint64_t     LumpNameKey(const char *s);
    static unsigned int LumpNameHash(const char *s);
 
 public:
@@ -327,6 +386,8 @@ public:
                        const WadLumpLoader *lfmt = nullptr) const;
    void  cacheLumpAuto(int lumpnum, ZAutoBuffer &buffer) const;
    void  cacheLumpAuto(const char *name, ZAutoBuffer &buffer) const;
+   void  prefetchLumps(int lumpnum, int count) const;
+   WadLumpStream *openLumpStream(int lumpnum) const;
    bool  writeLump(const char *lumpname, const char *destpath) const;
    void  close(); // haleyjd 03/09/11
 
@@ -352,6 +413,10 @@ public:
 
 extern WadDirectory wGlobalDir; // the global wad directory
 
+// Bytes of lump data cacheLumpNum found already cached, or had to read
+extern uint64_t w_cachedbytes;
+extern uint64_t w_readbytes;
+
 int      W_CheckNumForName(const char *name);   // killough 4/17/98
 int      W_CheckNumForNameNS(const char *name, int li_namespace);
 int      W_GetNumForName(const char* name);
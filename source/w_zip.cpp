@@ -288,7 +288,9 @@ ZipFile::~ZipFile()
       wads = nullptr;
    }
 
-   // close the disk file if it is open
+   // release the mapping and close the disk file if it is open
+   I_UnmapFile(map);
+
    if(file)
    {
       fclose(file);
@@ -491,6 +493,10 @@ bool ZipFile::readFromFile(FILE *f)
    if(numLumps > 1)
       qsort(lumps, numLumps, sizeof(ZipLump), ZIP_LumpSortCB);
 
+   // map the archive so stored lumps can be copied out without stdio; this
+   // is optional, so failure is not an error
+   I_MapFile(f, map);
+
    return true;
 }
 
@@ -714,6 +720,73 @@ void ZipLump::setAddress(InBuffer &fin)
    flags &= ~ZipFile::LF_CALCOFFSET;
 }
 
+//
+// ZipLump::readMapped
+//
+// Copy or inflate the lump directly from the mapped archive, so that neither
+// the stdio reads nor the chunked input buffer of ZIPDeflateReader are
+// needed. Returns false if the archive isn't mapped or the lump's data does
+// not lie within the mapping, in which case the caller reads through stdio.
+//
+bool ZipLump::readMapped(void *buffer) const
+{
+   const filemap_t &map = file->getMap();
+   const size_t     pos = static_cast<size_t>(offset);
+
+   switch(method)
+   {
+   case ZipFile::METHOD_STORED:
+      return I_ReadMappedFile(map, pos, buffer, size);
+   case ZipFile::METHOD_DEFLATE:
+      break;
+   default:
+      return false;
+   }
+
+   if(!map.data || pos > map.size || compressed > map.size - pos)
+      return false;
+
+   z_stream zlStream = {};
+   int      code;
+
+   zlStream.next_in   = const_cast<Bytef *>(map.data + pos);
+   zlStream.avail_in  = static_cast<uInt>(compressed);
+   zlStream.next_out  = static_cast<Bytef *>(buffer);
+   zlStream.avail_out = static_cast<uInt>(size);
+
+   if((code = inflateInit2(&zlStream, -MAX_WBITS)) != Z_OK)
+      I_Error("ZipLump::readMapped: inflateInit2 failed with code %d\n", code);
+
+   // all input and output are available, so inflate in a single call
+   code = inflate(&zlStream, Z_FINISH);
+   inflateEnd(&zlStream);
+
+   if(code != Z_OK && code != Z_STREAM_END && code != Z_BUF_ERROR)
+      I_Error("ZipLump::readMapped: invalid deflate stream\n");
+
+   if(zlStream.avail_out != 0)
+      I_Error("ZipLump::readMapped: truncated deflate stream\n");
+
+   return true;
+}
+
+//
+// ZipLump::prefetch
+//
+// Hint that the lump will be read soon. If its data offset hasn't been found
+// yet, the local header is included with some room for its name and extra
+// fields, which is usually enough.
+//
+void ZipLump::prefetch() const
+{
+   size_t len = compressed;
+
+   if(flags & ZipFile::LF_CALCOFFSET)
+      len += ZIP_LOCAL_FILE_SIZE + 512;
+
+   I_PrefetchMappedFile(file->getMap(), static_cast<size_t>(offset), len);
+}
+
 //
 // ZipLump::read(void *)
 //
@@ -728,14 +801,20 @@ void ZipLump::read(void *buffer)
    // Calculate an offset beyond the lump's local file header, if such hasn't
    // been done already. This will modify Lump::offset. Note if we call this,
    // we'll end up in reading position, so a seek is unnecessary then.
+   bool positioned = false;
    if(flags & ZipFile::LF_CALCOFFSET)
-      setAddress(reader);
-   else
    {
-      if(reader.seek(offset, SEEK_SET))
-         I_Error("ZipLump::read: could not seek to lump '%s'\n", name);
+      setAddress(reader);
+      positioned = true;
    }
 
+   // Work straight out of the archive's mapping if it has one.
+   if(readMapped(buffer))
+      return;
+
+   if(!positioned && reader.seek(offset, SEEK_SET))
+      I_Error("ZipLump::read: could not seek to lump '%s'\n", name);
+
    // Read the file according to its indicated storage method.
    switch(method)
    {
@@ -753,6 +832,117 @@ void ZipLump::read(void *buffer)
    }
 }
 
+//
+// ZIPInflateStream
+//
+// Inflates a deflated lump out of the mapped archive as it is read. Seeking
+// forward inflates and discards up to the new position; seeking backward
+// starts over from the beginning of the lump.
+//
+class ZIPInflateStream : public WadLumpStream
+{
+protected:
+   const Bytef *input;
+   uint32_t     inputsize;
+   z_stream     zlStream;
+
+   void restart()
+   {
+      inflateReset(&zlStream);
+      zlStream.next_in  = const_cast<Bytef *>(input);
+      zlStream.avail_in = static_cast<uInt>(inputsize);
+      position = 0;
+   }
+
+public:
+   ZIPInflateStream(const Bytef *pInput, uint32_t compressed, size_t size)
+      : WadLumpStream(size), input(pInput), inputsize(compressed), zlStream()
+   {
+      int code;
+
+      if((code = inflateInit2(&zlStream, -MAX_WBITS)) != Z_OK)
+         I_Error("ZIPInflateStream: inflateInit2 failed with code %d\n", code);
+      restart();
+   }
+
+   ~ZIPInflateStream()
+   {
+      inflateEnd(&zlStream);
+   }
+
+   size_t read(void *dest, size_t len) override
+   {
+      len = emin(len, lumpsize - position);
+
+      zlStream.next_out  = static_cast<Bytef *>(dest);
+      zlStream.avail_out = static_cast<uInt>(len);
+
+      // a bad stream just ends early; the reader sees a short read
+      int code;
+      do
+         code = inflate(&zlStream, Z_SYNC_FLUSH);
+      while(code == Z_OK && zlStream.avail_out);
+
+      len -= zlStream.avail_out;
+      position += len;
+      return len;
+   }
+
+   bool seek(size_t pos) override
+   {
+      if(pos > lumpsize)
+         return false;
+      if(pos < position)
+         restart();
+
+      byte discard[DEFLATE_BUFF_SIZE];
+      while(position < pos)
+      {
+         if(!read(discard, emin(pos - position, sizeof(discard))))
+            return false;
+      }
+      return true;
+   }
+};
+
+//
+// ZipLump::openStream
+//
+// Opens the lump for streaming, if its archive is mapped. Stored lumps are
+// read straight from the mapping.
+//
+WadLumpStream *ZipLump::openStream()
+{
+   const filemap_t &map = file->getMap();
+
+   if(!map.data)
+      return nullptr;
+
+   if(flags & ZipFile::LF_CALCOFFSET)
+   {
+      InBuffer reader;
+
+      reader.openExisting(file->getFile(), InBuffer::LENDIAN);
+      setAddress(reader);
+   }
+
+   const size_t pos = static_cast<size_t>(offset);
+
+   switch(method)
+   {
+   case ZipFile::METHOD_STORED:
+      if(pos > map.size || size > map.size - pos)
+         return nullptr;
+      return new WadMemoryStream(map.data + pos, size);
+   case ZipFile::METHOD_DEFLATE:
+      if(pos > map.size || compressed > map.size - pos)
+         return nullptr;
+      return new ZIPInflateStream(map.data + pos, compressed, size);
+   default:
+      return nullptr;
+   }
+}
+
 //
 // ZipLump::read(ZAutoBuffer &, bool)
 //
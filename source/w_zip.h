@@ -30,10 +30,12 @@
 #define W_ZIP_H__
 
 #include "z_zone.h"
+#include "hal/i_filemap.h"
 #include "m_dllist.h"
 
 class  InBuffer;
 class  WadDirectory;
+class  WadLumpStream;
 class  ZAutoBuffer;
 struct ZIPEndOfCentralDir;
 class  ZipFile;
@@ -50,8 +52,11 @@ struct ZipLump
    ZipFile  *file;       // parent zipfile
 
    void setAddress(InBuffer &fin);
+   bool readMapped(void *buffer) const;
+   void prefetch() const;
    void read(void *buffer);
    void read(ZAutoBuffer &buf, bool asString);
+   WadLumpStream *openStream();
 };
 
 struct ZipWad
@@ -88,6 +93,7 @@ protected:
    ZipLump *lumps;    // directory
    int      numLumps; // directory size
    FILE    *file;     // physical disk file
+   filemap_t map;     // mapping of the disk file, if it could be mapped
 
    DLListItem<ZipFile> links; // links for use by WadDirectory
 
@@ -99,7 +105,8 @@ protected:
 
 public:
    ZipFile() 
-      : ZoneObject(), lumps(nullptr), numLumps(0), file(nullptr), links(), wads(nullptr) 
+      : ZoneObject(), lumps(nullptr), numLumps(0), file(nullptr), map(), links(),
+        wads(nullptr)
    {
    }
    
@@ -114,6 +121,7 @@ public:
    int      findLump(const char *name) const;
    int      getNumLumps() const { return numLumps; }   
    FILE    *getFile()     const { return file;     }
+   const filemap_t &getMap() const { return map;      }
 };
 
 #endif
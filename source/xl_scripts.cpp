@@ -121,51 +121,88 @@ inline static bool XL_isIdentifierChar(char c)
    return ectype::isAlnum(c) || c == '_';
 }
 
+//
+// True if the character at input[i] ends an unquoted token. The token
+// always holds its first character by the time this is asked.
+//
+bool XLTokenizer::endsToken(int i) const
+{
+   const char c = input[i];
+
+   switch(c)
+   {
+   case '\0':
+   case '\n':
+   case ' ':
+   case '\t':
+   case '\r':
+   case ';':
+      return true;
+   case '#':
+      // hashes may conditionally be supported as comments
+      if(flags & TF_HASHCOMMENTS)
+         return true;
+      break;
+   case '/':
+      // double slashes may conditionally be supported as comments
+      if(input[i+1] == '/' && flags & TF_SLASHCOMMENTS)
+         return true;
+      break;
+   case '"':
+      // starting strings next to keywords should be detected
+      if(tokentype == TOKEN_KEYWORD)
+         return true;
+      break;
+   default:
+      break;
+   }
+
+   // operators and identifiers are separate
+   return (flags & TF_OPERATORS && !token.empty() &&
+           XL_isIdentifierChar(c) != XL_isIdentifierChar(token[0]));
+}
+
 // Scanning inside a token
 void XLTokenizer::doStateInToken() 
 {
-   char c = input[idx];
+   const int start = idx;
 
-   switch(c)
+   // take the whole run up to the end of the token in one copy
+   while(!endsToken(idx))
+      ++idx;
+   if(idx > start)
+      token.concat(input + start, idx - start);
+
+   switch(input[idx])
    {
    case '\n':
       if(flags & TF_LINEBREAKS) // if linebreaks are tokens, we need to back up
          --idx;
-      // fall through
+      break;
    case ' ':  // whitespace
    case '\t':
    case '\r':
-      // end of token
-      state = STATE_DONE;
-      break;
-   case '\0':  // end of input -OR- start of a comment
-   case ';':   
-      --idx;   // backup, next call will handle it in STATE_SCAN.
-      state = STATE_DONE;
       break;
    default:
-      if((c == '#' && flags & TF_HASHCOMMENTS) ||
-         (c == '/' && input[idx+1] == '/' && flags & TF_SLASHCOMMENTS) ||
-         (flags & TF_OPERATORS && !token.empty() &&
-          XL_isIdentifierChar(c) != XL_isIdentifierChar(token[0])) ||
-         (c == '"' && tokentype == TOKEN_KEYWORD))
-      {
-         // hashes may conditionally be supported as comments
-         // double slashes may conditionally be supported as comments
-         // operators and identifiers are separate
-         // starting strings next to keywords should be detected
-         --idx;
-         state = STATE_DONE;
-         break;
-      }
-      token += c;
+      // end of input, a comment, an operator or a string: back up, and the
+      // next call will handle it in STATE_SCAN.
+      --idx;
       break;
    }
+
+   state = STATE_DONE;
 }
 
 // Reading out a bracketed string token
 void XLTokenizer::doStateInBrackets()
 {
+   const int start = idx;
+
+   while(input[idx] != ']' && input[idx] != '\0')
+      ++idx;
+   if(idx > start)
+      token.concat(input + start, idx - start);
+
    switch(input[idx])
    {
    case ']':  // end of bracketed token
@@ -186,6 +223,13 @@ void XLTokenizer::doStateQuoted()
 {
    char c;
    int i;
+   const int start = idx;
+
+   // copy out everything up to the next quote or escape at once
+   while(input[idx] != '"' && input[idx] != '\0' && input[idx] != '\\')
+      ++idx;
+   if(idx > start)
+      token.concat(input + start, idx - start);
 
    switch(input[idx])
    {
@@ -294,6 +338,9 @@ void XLTokenizer::doStateQuoted()
 void XLTokenizer::doStateComment()
 {
    // consume all input to the end of the line
+   while(input[idx] != '\n' && input[idx] != '\0')
+      ++idx;
+
    if(input[idx] == '\n')
    {
       // if linebreak tokens are enabled, send one now
@@ -89,6 +89,8 @@ protected:
    qstring token;      // current token value
    unsigned int flags; // parser flags
 
+   bool endsToken(int i) const;
+
    void doStateScan();
    void doStateInToken();
    void doStateInBrackets();
@@ -80,6 +80,15 @@
 // signature for block header
 #define ZONEID  0x931d4a11
 
+// PU_LEVEL allocations up to this size are carved out of the level arena
+#define ARENA_MAXSIZE   1024
+
+// size of each chunk of memory the level arena grabs from the system
+#define ARENA_CHUNKSIZE (256*1024)
+
+// bytes of same-sized blocks carved at once when a size class runs dry
+#define ARENA_SLABSIZE  (8*1024)
+
 // End Tunables
 
 //=============================================================================
@@ -97,6 +106,7 @@ struct memblock_t
   size_t size;
   void **user;
   unsigned char tag;
+  bool arena;      // lives in the level arena rather than its own malloc
 
 #ifdef INSTRUMENTED
   const char *file;
@@ -215,6 +225,123 @@ INSTRUMENT(int printstats = 0);         // killough 8/23/98
 // haleyjd 04/02/11: Instrumentation output has been moved to d_main.cpp and
 // is now drawn directly to the screen instead of passing through doom_printf.
 
+//=============================================================================
+//
+// Zone Statistics
+//
+// Unlike instrumentation these are always kept. Call sites are counted in an
+// open-addressed table keyed on the file pointer and line, which costs a hash
+// and usually one probe per allocation. The same file name can show up under
+// more than one pointer, so Z_GetAllocSites merges those.
+//
+
+zonestats_t zonestats;
+
+#define ZONESITES      2048 // must be a power of two
+#define ZONESITEPROBES 8    // sites that can't find a slot in this many go uncounted
+
+static zonesite_t zonesites[ZONESITES];
+
+static inline void Z_statAdd(int tag, size_t size)
+{
+   zonestats.bytesbytag[tag] += size;
+   ++zonestats.blocksbytag[tag];
+   if((zonestats.totalbytes += size) > zonestats.peakbytes)
+      zonestats.peakbytes = zonestats.totalbytes;
+}
+
+static inline void Z_statRemove(int tag, size_t size)
+{
+   zonestats.bytesbytag[tag] -= size;
+   --zonestats.blocksbytag[tag];
+   zonestats.totalbytes -= size;
+}
+
+static void Z_statSite(const char *file, int line, size_t size)
+{
+   size_t slot = ((reinterpret_cast<uintptr_t>(file) >> 3) ^ (line * 2654435761u)) &
+                 (ZONESITES - 1);
+
+   ++zonestats.allocs;
+
+   for(int probe = 0; probe < ZONESITEPROBES; probe++)
+   {
+      zonesite_t &site = zonesites[(slot + probe) & (ZONESITES - 1)];
+
+      if(!site.file)
+      {
+         site.file = file;
+         site.line = line;
+      }
+      else if(site.file != file || site.line != line)
+         continue;
+
+      ++site.allocs;
+      site.bytes += size;
+      return;
+   }
+}
+
+//
+// Z_ResetPeakBytes
+//
+// Starts tracking the peak over again from the current total.
+//
+void Z_ResetPeakBytes()
+{
+   zonestats.peakbytes = zonestats.totalbytes;
+}
+
+//
+// Z_GetAllocSites
+//
+// Fills in up to maxsites call sites, the ones that have allocated the most
+// bytes first, and returns how many there were.
+//
+int Z_GetAllocSites(zonesite_t *sites, int maxsites)
+{
+   static zonesite_t merged[ZONESITES];
+   int nummerged = 0, numsites = 0;
+
+   // fold together places counted under more than one file pointer
+   for(const zonesite_t &site : zonesites)
+   {
+      if(!site.file)
+         continue;
+
+      int i;
+      for(i = 0; i < nummerged; i++)
+      {
+         if(merged[i].line == site.line && !strcmp(merged[i].file, site.file))
+            break;
+      }
+
+      if(i == nummerged)
+         merged[nummerged++] = site;
+      else
+      {
+         merged[i].allocs += site.allocs;
+         merged[i].bytes  += site.bytes;
+      }
+   }
+
+   // insertion sort the biggest ones into the output
+   for(int i = 0; i < nummerged && maxsites > 0; i++)
+   {
+      int pos = numsites < maxsites ? numsites : maxsites - 1;
+
+      if(numsites == maxsites && merged[i].bytes <= sites[pos].bytes)
+         continue;
+      for(; pos > 0 && sites[pos - 1].bytes < merged[i].bytes; pos--)
+         sites[pos] = sites[pos - 1];
+      sites[pos] = merged[i];
+      if(numsites < maxsites)
+         ++numsites;
+   }
+
+   return numsites;
+}
+
 // haleyjd 06/20/09: removed unused, crashy, and non-useful Z_DumpHistory
 
 //=============================================================================
@@ -298,6 +425,187 @@ void Z_Init(void)
    Z_LogPrintf("Initialized zone heap (using native implementation)\n");
 }
 
+//=============================================================================
+//
+// Level Arena
+//
+// Small PU_LEVEL blocks are bump-allocated out of large chunks instead of
+// each getting their own malloc. They keep a normal block header and sit in
+// the normal tag list, so every zone call works on them as usual, but freeing
+// one only puts it on a free list for its size class, where the next block of
+// that class (most often another thinker of the same type) will pick it up.
+// A class whose free list is empty gets a whole slab of blocks at once, so
+// that objects of one size spawned in a row, such as missiles and puffs,
+// end up next to each other in memory.
+// Once no arena block is left alive, as at the end of a level, the chunks are
+// released as a whole.
+//
+
+struct arenachunk_t
+{
+   arenachunk_t *next;
+   size_t        used; // bytes handed out from the start of data
+};
+
+static const size_t chunkheader_size = (sizeof(arenachunk_t) + 15) & ~15;
+
+#define ARENA_NUMCLASSES (ARENA_MAXSIZE / 16)
+
+static struct
+{
+   arenachunk_t *chunks;                       // current chunk is first
+   memblock_t   *freeblocks[ARENA_NUMCLASSES]; // freed blocks by size class
+   size_t        numchunks;
+   size_t        numlive;                      // arena blocks not yet freed
+   size_t        livebytes;                    // and their total size
+   size_t        freebytes;                    // bytes in the free lists
+} levelarena;
+
+//
+// Z_arenaClass
+//
+// Size classes are 16 bytes wide, and a block always takes up the whole of
+// its class so that any freed block of the class can be handed out again.
+//
+static inline size_t Z_arenaClass(size_t size)
+{
+   return (size - 1) / 16;
+}
+
+//
+// Z_arenaCarveSlab
+//
+// Cuts a run of blocks of one size class out of the current chunk, starting a
+// new chunk if it is full. The first block is returned and the rest go on the
+// class's free list in address order.
+//
+static memblock_t *Z_arenaCarveSlab(size_t cls)
+{
+   const size_t stride = header_size + (cls + 1) * 16;
+   const size_t space  = ARENA_CHUNKSIZE - chunkheader_size;
+   arenachunk_t *chunk = levelarena.chunks;
+
+   if(!chunk || chunk->used + stride > space)
+   {
+      if(!(chunk = (arenachunk_t *)(malloc(ARENA_CHUNKSIZE))))
+      {
+         if(blockbytag[PU_CACHE])
+         {
+            Z_FreeTags(PU_CACHE, PU_CACHE);
+            chunk = (arenachunk_t *)(malloc(ARENA_CHUNKSIZE));
+         }
+         if(!chunk)
+            return nullptr;
+      }
+      chunk->next = levelarena.chunks;
+      chunk->used = 0;
+      levelarena.chunks = chunk;
+      ++levelarena.numchunks;
+   }
+
+   size_t count = ARENA_SLABSIZE / stride;
+   if(count < 1)
+      count = 1;
+   if(count > (space - chunk->used) / stride)
+      count = (space - chunk->used) / stride;
+
+   byte *base = (byte *)chunk + chunkheader_size + chunk->used;
+   chunk->used += count * stride;
+
+   // push the spares last to first, so the lowest address comes off next
+   for(size_t i = count - 1; i > 0; i--)
+   {
+      memblock_t *spare = (memblock_t *)(base + i * stride);
+      spare->next = levelarena.freeblocks[cls];
+      levelarena.freeblocks[cls] = spare;
+   }
+   levelarena.freebytes += (count - 1) * (cls + 1) * 16;
+
+   return (memblock_t *)base;
+}
+
+//
+// Z_arenaAlloc
+//
+// Returns a block for size bytes from the level arena, or nullptr if the
+// allocation should go to the system heap instead.
+//
+static memblock_t *Z_arenaAlloc(size_t size, int tag)
+{
+   if(tag != PU_LEVEL || size > ARENA_MAXSIZE)
+      return nullptr;
+
+   const size_t cls = Z_arenaClass(size);
+   memblock_t *block;
+
+   if((block = levelarena.freeblocks[cls]))
+   {
+      levelarena.freeblocks[cls] = block->next;
+      levelarena.freebytes -= (cls + 1) * 16;
+   }
+   else
+      block = Z_arenaCarveSlab(cls);
+
+   if(!block)
+      return nullptr; // let the caller try the system heap
+
+   block->arena = true;
+   ++levelarena.numlive;
+   levelarena.livebytes += size;
+
+   return block;
+}
+
+
+//
+// Z_arenaRelease
+//
+// Called once nothing in the arena is alive any more. Everything but one
+// chunk goes back to the system, and that one is rewound for the next level.
+//
+static void Z_arenaRelease()
+{
+   arenachunk_t *chunk = levelarena.chunks;
+
+   if(!chunk)
+      return;
+
+   arenachunk_t *rest = chunk->next;
+   while(rest)
+   {
+      arenachunk_t *next = rest->next;
+      free(rest);
+      rest = next;
+   }
+
+   chunk->next = nullptr;
+   chunk->used = 0;
+   levelarena.numchunks = 1;
+   levelarena.freebytes = 0;
+   memset(levelarena.freeblocks, 0, sizeof(levelarena.freeblocks));
+
+   Z_LogPuts("* Released level arena\n");
+}
+
+//
+// Z_arenaFree
+//
+// Puts an arena block, already unlinked from its tag list, on its free list.
+//
+static void Z_arenaFree(memblock_t *block)
+{
+   const size_t cls = Z_arenaClass(block->size);
+
+   levelarena.livebytes -= block->size;
+   levelarena.freebytes += (cls + 1) * 16;
+
+   block->next = levelarena.freeblocks[cls];
+   levelarena.freeblocks[cls] = block;
+
+   if(!--levelarena.numlive)
+      Z_arenaRelease();
+}
+
 //=============================================================================
 //
 // Core Memory Management Routines
@@ -322,19 +630,24 @@ void *(Z_Malloc)(size_t size, int tag, void **user, const char *file, int line)
    if(!size)
       return user ? *user = nullptr : nullptr;          // malloc(0) returns nullptr
    
-   if(!(block = (memblock_t *)(malloc(size + header_size))))
+   if(!(block = Z_arenaAlloc(size, tag)))
    {
-      if(blockbytag[PU_CACHE])
+      if(!(block = (memblock_t *)(malloc(size + header_size))))
       {
-         Z_FreeTags(PU_CACHE, PU_CACHE);
-         block = (memblock_t *)(malloc(size + header_size));
+         if(blockbytag[PU_CACHE])
+         {
+            Z_FreeTags(PU_CACHE, PU_CACHE);
+            block = (memblock_t *)(malloc(size + header_size));
+         }
       }
-   }
 
-   if(!block)
-   {
-      I_FatalError(I_ERR_KILL, "Z_Malloc: Failure trying to allocate %u bytes\n"
-                               "Source: %s:%d\n", (unsigned int)size, file, line);
+      if(!block)
+      {
+         I_FatalError(I_ERR_KILL, "Z_Malloc: Failure trying to allocate %u bytes\n"
+                                  "Source: %s:%d\n", (unsigned int)size, file, line);
+      }
+
+      block->arena = false;
    }
    
    block->size = size;
@@ -347,6 +660,9 @@ void *(Z_Malloc)(size_t size, int tag, void **user, const char *file, int line)
    INSTRUMENT(memorybytag[tag] += block->size);
    INSTRUMENT(block->file = file);
    INSTRUMENT(block->line = line);
+
+   Z_statAdd(tag, size);
+   Z_statSite(file, line, size);
          
    IDCHECK(block->id = ZONEID); // signature required in block header
    
@@ -402,6 +718,7 @@ void (Z_Free)(void *p, const char *file, int line)
                      );
       }
       INSTRUMENT(memorybytag[block->tag] -= block->size);
+      Z_statRemove(block->tag, block->size);
       block->tag = PU_FREE;       // Mark block freed
 
       // scramble memory -- weed out any bugs
@@ -413,7 +730,10 @@ void (Z_Free)(void *p, const char *file, int line)
       if((*block->prev = block->next))
          block->next->prev = block->prev;
          
-      free(block);
+      if(block->arena)
+         Z_arenaFree(block);
+      else
+         free(block);
          
       Z_LogPrintf("* Z_Free(p=%p, file=%s:%d)\n", p, file, line);
    }
@@ -493,6 +813,9 @@ void (Z_ChangeTag)(void *ptr, int tag, const char *file, int line)
    INSTRUMENT(memorybytag[block->tag] -= block->size);
    INSTRUMENT(memorybytag[tag] += block->size);
 
+   Z_statRemove(block->tag, block->size);
+   Z_statAdd(tag, block->size);
+
    block->tag = tag;
 
    Z_LogPrintf("* Z_ChangeTag(p=%p, tag=%d, file=%s:%d)\n",
@@ -534,6 +857,20 @@ void *(Z_Realloc)(void *ptr, size_t n, int tag, void **user,
    if(block->tag == PU_PERMANENT)
       tag = PU_PERMANENT;
 
+   // arena blocks can't be handed to realloc; move the contents instead
+   if(block->arena)
+   {
+      if(block->user)
+         *(block->user) = nullptr;
+      block->user = nullptr;
+
+      p = (Z_Malloc)(n, tag, user, file, line);
+      memcpy(p, ptr, block->size < n ? block->size : n);
+      (Z_Free)(ptr, file, line);
+
+      return p;
+   }
+
    // nullify current user, if any
    if(block->user)
       *(block->user) = nullptr;
@@ -546,6 +883,7 @@ void *(Z_Realloc)(void *ptr, size_t n, int tag, void **user,
    block->prev = nullptr;
 
    INSTRUMENT(memorybytag[block->tag] -= block->size);
+   Z_statRemove(block->tag, block->size);
 
    if(!(newblock = (memblock_t *)(realloc(block, n + header_size))))
    {
@@ -592,6 +930,9 @@ void *(Z_Realloc)(void *ptr, size_t n, int tag, void **user,
    INSTRUMENT(block->file = file);
    INSTRUMENT(block->line = line);
 
+   Z_statAdd(tag, block->size);
+   Z_statSite(file, line, block->size);
+
    Z_LogPrintf("* %p = Z_Realloc(ptr=%p, n=%lu, tag=%d, user=%p, source=%s:%d)\n", 
                p, ptr, n, tag, user, file, line);
 
@@ -723,6 +1064,12 @@ void Z_PrintZoneHeap(void)
       }
    }
 
+   fprintf(outfile, "Level arena: %u chunks of %u bytes, %u live blocks "
+           "(%u bytes), %u bytes on free lists\n",
+           (unsigned int)levelarena.numchunks, (unsigned int)ARENA_CHUNKSIZE,
+           (unsigned int)levelarena.numlive, (unsigned int)levelarena.livebytes,
+           (unsigned int)levelarena.freebytes);
+
    fclose(outfile);
 }
 
@@ -885,51 +1232,157 @@ void Z_SysFree(void *p)
 //
 // haleyjd 12/06/06
 //
+// Automatic allocations come off a scratch stack of large chunks that each
+// thread keeps for itself, so they cost a pointer bump instead of a malloc.
+// Z_FreeAlloca rewinds the calling thread's stack once per main loop
+// iteration; a ScratchScope rewinds it sooner, when it goes out of scope.
+//
+
+// smallest chunk the scratch stack grabs from the system
+#define SCRATCHCHUNKSIZE (64*1024)
+
+struct scratchchunk_t
+{
+   scratchchunk_t *prev;
+   size_t          size; // bytes of data after the header
+   size_t          used;
+};
+
+// each allocation is preceded by its size, so Z_Realloca can copy it
+struct scratchblock_t
+{
+   size_t size;
+};
+
+static const size_t scratchheader_size = (sizeof(scratchchunk_t) + 15) & ~15;
+static const size_t scratchblock_size  = (sizeof(scratchblock_t) + 15) & ~15;
+
+static void Z_scratchPop();
+
+static thread_local struct scratchstack_t
+{
+   scratchchunk_t *top;   // chunk currently being allocated from
+   scratchchunk_t *spare; // most recently popped chunk, kept for reuse
+
+   // give everything back when the thread finishes
+   ~scratchstack_t()
+   {
+      while(top)
+         Z_scratchPop();
+      Z_SysFree(spare);
+   }
+} scratch;
 
 //
-// Z_FreeAlloca
+// Z_scratchPush
 //
-// haleyjd 12/06/06: Frees all blocks allocated with Z_Alloca.
+// Starts a new chunk with room for at least n bytes on top of the stack.
 //
-void Z_FreeAlloca(void)
+static void Z_scratchPush(size_t n)
 {
-   memblock_t *block = blockbytag[PU_AUTO];
+   scratchchunk_t *chunk = scratch.spare;
 
-   if(!block)
-      return;
-   
-   Z_LogPuts("* Freeing alloca blocks\n");
+   if(chunk && chunk->size >= n)
+      scratch.spare = nullptr;
+   else
+   {
+      size_t size = n > SCRATCHCHUNKSIZE ? n : SCRATCHCHUNKSIZE;
 
-   blockbytag[PU_AUTO] = nullptr;
+      chunk = static_cast<scratchchunk_t *>(Z_SysMalloc(scratchheader_size + size));
+      chunk->size = size;
+   }
 
-   while(block)
-   {
-      memblock_t *next = block->next;
+   chunk->prev = scratch.top;
+   chunk->used = 0;
+   scratch.top = chunk;
+}
+
+//
+// Z_scratchPop
+//
+// Drops the top chunk, keeping the larger of it and the spare for reuse.
+//
+static void Z_scratchPop()
+{
+   scratchchunk_t *chunk = scratch.top;
 
-      Z_IDCheckNB(IDBOOL(block->id != ZONEID),
-                  "Z_FreeAlloca: Freed a tag without ZONEID", 
-                  __FILE__, __LINE__);
+   scratch.top = chunk->prev;
 
-      Z_Free((byte *)block + header_size);
-      block = next;               // Advance to next block
+   if(scratch.spare && scratch.spare->size >= chunk->size)
+      Z_SysFree(chunk);
+   else
+   {
+      Z_SysFree(scratch.spare);
+      scratch.spare = chunk;
    }
 }
 
+//
+// Z_ScratchMark
+//
+// Returns the current top of the calling thread's scratch stack.
+//
+scratchmark_t Z_ScratchMark()
+{
+   scratchmark_t mark;
+
+   mark.chunk = scratch.top;
+   mark.used  = scratch.top ? scratch.top->used : 0;
+
+   return mark;
+}
+
+//
+// Z_ScratchRewind
+//
+// Frees every automatic allocation made since the mark was taken.
+//
+void Z_ScratchRewind(const scratchmark_t &mark)
+{
+   while(scratch.top && scratch.top != mark.chunk)
+      Z_scratchPop();
+
+   if(scratch.top)
+      scratch.top->used = mark.used;
+}
+
+//
+// Z_FreeAlloca
+//
+// haleyjd 12/06/06: Frees all blocks allocated with Z_Alloca.
+//
+void Z_FreeAlloca(void)
+{
+   if(!scratch.top)
+      return;
+
+   Z_LogPuts("* Freeing alloca blocks\n");
+
+   Z_ScratchRewind(scratchmark_t());
+}
+
 //
 // Z_Alloca
 //
 // haleyjd 12/06/06:
-// Implements a portable garbage-collected alloca on the zone heap.
+// Implements a portable garbage-collected alloca on the scratch stack.
 //
 void *(Z_Alloca)(size_t n, const char *file, int line)
 {
-   void *ptr;
-
    if(n == 0)
       return nullptr;
 
-   // allocate it
-   ptr = (Z_Calloc)(n, 1, PU_AUTO, nullptr, file, line);
+   const size_t need = scratchblock_size + ((n + 15) & ~15);
+
+   if(!scratch.top || scratch.top->used + need > scratch.top->size)
+      Z_scratchPush(need);
+
+   byte *base = (byte *)scratch.top + scratchheader_size + scratch.top->used;
+   scratch.top->used += need;
+
+   reinterpret_cast<scratchblock_t *>(base)->size = n;
+
+   void *ptr = memset(base + scratchblock_size, 0, n);
 
    Z_LogPrintf("* %p = Z_Alloca(n = %lu, file = %s, line = %d)\n", 
                ptr, n, file, line);
@@ -941,24 +1394,41 @@ void *(Z_Alloca)(size_t n, const char *file, int line)
 // Z_Realloca
 //
 // haleyjd 07/08/10: realloc for automatic allocations.
+// The most recent allocation on the stack can grow or shrink in place;
+// anything else is copied to a new one.
 //
 void *(Z_Realloca)(void *ptr, size_t n, const char *file, int line)
 {
    void *ret;
 
-   if(ptr)
+   if(!ptr)
+      ret = (Z_Alloca)(n, file, line);
+   else if(n == 0)
+      ret = nullptr; // reclaimed along with the rest by the next rewind
+   else
    {
-      // get zone block
-      memblock_t *block = (memblock_t *)((byte *)ptr - header_size);
-
-      Z_IDCheck(IDBOOL(block->id != ZONEID),
-         "Z_Realloca: block found without ZONEID", block, file, line);
-
-      if(block->tag != PU_AUTO)
-         I_FatalError(I_ERR_KILL, "Z_Realloca: strange block tag %d\n", block->tag);
+      byte  *base    = (byte *)ptr - scratchblock_size;
+      size_t oldsize = reinterpret_cast<scratchblock_t *>(base)->size;
+      byte  *top     = scratch.top ? 
+         (byte *)scratch.top + scratchheader_size + scratch.top->used : nullptr;
+      const size_t need = scratchblock_size + ((n + 15) & ~15);
+
+      if(base + scratchblock_size + ((oldsize + 15) & ~15) == top &&
+         base + need <= (byte *)scratch.top + scratchheader_size + scratch.top->size)
+      {
+         // on top of the stack, so just move the top
+         scratch.top->used = (base - ((byte *)scratch.top + scratchheader_size)) + need;
+         reinterpret_cast<scratchblock_t *>(base)->size = n;
+         if(n > oldsize)
+            memset((byte *)ptr + oldsize, 0, n - oldsize);
+         ret = ptr;
+      }
+      else
+      {
+         ret = (Z_Alloca)(n, file, line);
+         memcpy(ret, ptr, oldsize < n ? oldsize : n);
+      }
    }
-   
-   ret = (Z_Realloc)(ptr, n, PU_AUTO, nullptr, file, line);
 
    Z_LogPrintf("* %p = Z_Realloca(ptr = %p, n = %lu, file = %s, line = %d)\n", 
                ret, ptr, n, file, line);
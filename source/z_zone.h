@@ -186,8 +186,64 @@ extern size_t memorybytag[PU_MAX]; // haleyjd  04/01/11
 extern int printstats;             // killough 08/23/98
 #endif
 
+// Always-on heap counters, cheap enough to keep in release builds
+struct zonestats_t
+{
+   size_t   bytesbytag[PU_MAX];  // bytes currently allocated under each tag
+   size_t   blocksbytag[PU_MAX]; // and the number of blocks
+   size_t   totalbytes;          // bytes allocated under any tag
+   size_t   peakbytes;           // highest totalbytes since Z_ResetPeakBytes
+   uint64_t allocs;              // allocations and reallocations ever made
+};
+
+// Allocation counts by the file and line passed to Z_Malloc and friends
+struct zonesite_t
+{
+   const char *file;
+   int         line;
+   uint64_t    allocs;
+   uint64_t    bytes;
+};
+
+extern zonestats_t zonestats;
+
+void Z_ResetPeakBytes();
+int  Z_GetAllocSites(zonesite_t *sites, int maxsites);
+
 void Z_PrintZoneHeap();
 
+struct scratchchunk_t;
+
+// Position on the calling thread's Z_Alloca scratch stack
+struct scratchmark_t
+{
+   scratchchunk_t *chunk = nullptr;
+   size_t          used  = 0;
+};
+
+scratchmark_t Z_ScratchMark();
+void          Z_ScratchRewind(const scratchmark_t &mark);
+
+//
+// ScratchScope
+//
+// Frees the Z_Alloca allocations made while it is alive when it goes out of
+// scope, rather than waiting for Z_FreeAlloca. Handy in loops and on threads
+// other than the main one, whose stacks Z_FreeAlloca never sees.
+//
+class ScratchScope
+{
+public:
+   ScratchScope() : mark(Z_ScratchMark()) {}
+   ~ScratchScope() { Z_ScratchRewind(mark); }
+
+   ScratchScope(const ScratchScope &) = delete;
+   ScratchScope &operator = (const ScratchScope &) = delete;
+
+private:
+   scratchmark_t mark;
+};
+
 void Z_DumpCore();
 
 //